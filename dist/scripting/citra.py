@@ -6,10 +6,14 @@ import socket
 CURRENT_REQUEST_VERSION = 1
 MAX_REQUEST_DATA_SIZE = 32
 MAX_PACKET_SIZE = 48
+MAX_BATCH_DATA_SIZE = 0xF000
+MAX_BATCH_PACKET_SIZE = 16 + MAX_BATCH_DATA_SIZE
 
 class RequestType(enum.IntEnum):
     ReadMemory = 1,
-    WriteMemory = 2
+    WriteMemory = 2,
+    ReadMemoryBatch = 6,
+    WriteMemoryBatch = 7
 
 CITRA_PORT = 45987
 
@@ -90,6 +94,53 @@ class Citra:
                 return False
         return True
 
+    def read_memory_batch(self, ranges):
+        """
+        Reads several (address, size) ranges with a single request, their sizes may add up to
+        MAX_BATCH_DATA_SIZE.
+        >>> c.read_memory_batch([(0x100000, 4), (0x100000, 2)])
+        [b'\\x07\\x00\\x00\\xeb', b'\\x07\\x00']
+        """
+        request_data = struct.pack("I", len(ranges))
+        for address, size in ranges:
+            request_data += struct.pack("II", address, size)
+        request, request_id = self._generate_header(RequestType.ReadMemoryBatch, len(request_data))
+        request += request_data
+        self.socket.sendto(request, (self.address, CITRA_PORT))
+
+        raw_reply = self.socket.recv(MAX_BATCH_PACKET_SIZE)
+        reply_data = self._read_and_validate_header(raw_reply, request_id,
+                                                    RequestType.ReadMemoryBatch)
+        if not reply_data:
+            return None
+
+        result = []
+        for _, size in ranges:
+            result.append(reply_data[:size])
+            reply_data = reply_data[size:]
+        return result
+
+    def write_memory_batch(self, writes):
+        """
+        Writes several (address, contents) pairs with a single request.
+        >>> c.write_memory_batch([(0x100000, b"\\x07\\x00\\x00\\xeb")])
+        True
+        """
+        request_data = struct.pack("I", len(writes))
+        for address, contents in writes:
+            request_data += struct.pack("II", address, len(contents))
+        for _, contents in writes:
+            request_data += contents
+        request, request_id = self._generate_header(RequestType.WriteMemoryBatch,
+                                                    len(request_data))
+        request += request_data
+        self.socket.sendto(request, (self.address, CITRA_PORT))
+
+        raw_reply = self.socket.recv(MAX_BATCH_PACKET_SIZE)
+        reply_data = self._read_and_validate_header(raw_reply, request_id,
+                                                    RequestType.WriteMemoryBatch)
+        return reply_data is not None and len(reply_data) == 4
+
 if "__main__" == __name__:
     import doctest
     doctest.testmod(extraglobs={'c': Citra()})
@@ -6,7 +6,7 @@
 
 #include <array>
 #include <cstddef>
-#include <deque>
+#include <vector>
 #include "common/common_types.h"
 
 namespace AudioCore {
@@ -23,8 +23,62 @@ using StereoFrame16 = std::array<std::array<s16, 2>, samples_per_frame>;
 /// The DSP is quadraphonic internally.
 using QuadFrame32 = std::array<std::array<s32, 4>, samples_per_frame>;
 
-/// A variable length buffer of signed PCM16 stereo samples.
-using StereoBuffer16 = std::deque<std::array<s16, 2>>;
+/**
+ * A variable length buffer of signed PCM16 stereo samples. The samples are stored contiguously
+ * and the storage is kept when the buffer is refilled, so decoding into it and interpolating from
+ * it doesn't allocate once it has grown to the largest buffer of its source.
+ */
+class StereoBuffer16 {
+public:
+    using Sample = std::array<s16, 2>;
+
+    /// Number of already consumed samples kept in front of the unread ones, see PrependHistory
+    static constexpr std::size_t HISTORY_SIZE = 2;
+
+    StereoBuffer16() : storage(HISTORY_SIZE) {}
+
+    /// Discards all samples and returns the storage for count new ones, which must all be written
+    Sample* Reset(std::size_t count) {
+        if (storage.size() < HISTORY_SIZE + count)
+            storage.resize(HISTORY_SIZE + count);
+        head = HISTORY_SIZE;
+        tail = HISTORY_SIZE + count;
+        return storage.data() + head;
+    }
+
+    void Clear() {
+        head = tail = HISTORY_SIZE;
+    }
+
+    bool IsEmpty() const {
+        return head == tail;
+    }
+
+    /// Returns the number of unread samples
+    std::size_t Size() const {
+        return tail - head;
+    }
+
+    /// Marks the given number of samples as read
+    void Consume(std::size_t count) {
+        head += count;
+    }
+
+    /**
+     * Stores two earlier samples right before the unread ones and returns a pointer to the first,
+     * so that interpolators can step over Size() + 2 contiguous samples.
+     */
+    Sample* PrependHistory(const Sample& xn2, const Sample& xn1) {
+        storage[head - 2] = xn2;
+        storage[head - 1] = xn1;
+        return storage.data() + head - 2;
+    }
+
+private:
+    std::vector<Sample> storage;
+    std::size_t head = HISTORY_SIZE;
+    std::size_t tail = HISTORY_SIZE;
+};
 
 constexpr std::size_t num_dsp_pipe = 8;
 enum class DspPipe {
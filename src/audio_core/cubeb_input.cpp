@@ -2,15 +2,20 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <utility>
 #include <vector>
 #include <cubeb/cubeb.h>
 #include "audio_core/cubeb_input.h"
 #include "common/logging/log.h"
+#include "common/ring_buffer.h"
 
 namespace AudioCore {
 
-using SampleQueue = Common::SPSCQueue<Frontend::Mic::Samples>;
+/// Bytes of samples buffered between the cubeb callback and the MIC service, one second of 16 bit
+/// samples at the highest sample rate
+using SampleQueue = Common::RingBuffer<u8, 0x10000>;
 
 struct CubebInput::Impl {
     cubeb* ctx = nullptr;
@@ -114,13 +119,9 @@ void CubebInput::AdjustSampleRate(u32 sample_rate) {
     LOG_ERROR(Audio, "AdjustSampleRate unimplemented!");
 }
 
-Frontend::Mic::Samples CubebInput::Read() {
-    Frontend::Mic::Samples samples{};
-    Frontend::Mic::Samples queue;
-    while (impl->sample_queue->Pop(queue)) {
-        samples.insert(samples.end(), queue.begin(), queue.end());
-    }
-    return samples;
+void CubebInput::Read(Frontend::Mic::Samples& samples) {
+    samples.resize(impl->sample_queue->Size());
+    samples.resize(impl->sample_queue->Pop(samples.data(), samples.size()));
 }
 
 long CubebInput::Impl::DataCallback(cubeb_stream* stream, void* user_data, const void* input_buffer,
@@ -134,21 +135,31 @@ long CubebInput::Impl::DataCallback(cubeb_stream* stream, void* user_data, const
         return static_cast<u8>(static_cast<u16>(sample) >> 8);
     };
 
-    std::vector<u8> samples{};
-    samples.reserve(num_frames * impl->sample_size_in_bytes);
+    // Drop whole callbacks when the service falls behind, a partial push could split a sample
+    const std::size_t num_bytes = num_frames * impl->sample_size_in_bytes;
+    SampleQueue& queue = *impl->sample_queue;
+    if (queue.Capacity() - queue.Size() < num_bytes) {
+        return num_frames;
+    }
+
+    const u8* data = static_cast<const u8*>(input_buffer);
     if (impl->sample_size_in_bytes == 1) {
         // If the sample format is 8bit, then resample back to 8bit before passing back to core
-        for (std::size_t i = 0; i < static_cast<std::size_t>(num_frames); i++) {
-            s16 data;
-            std::memcpy(&data, static_cast<const u8*>(input_buffer) + i * 2, 2);
-            samples.push_back(resample_s16_s8(data));
+        std::array<u8, 256> converted;
+        for (std::size_t i = 0; i < static_cast<std::size_t>(num_frames);) {
+            const std::size_t count =
+                std::min(converted.size(), static_cast<std::size_t>(num_frames) - i);
+            for (std::size_t j = 0; j < count; ++j, ++i) {
+                s16 sample;
+                std::memcpy(&sample, data + i * 2, 2);
+                converted[j] = resample_s16_s8(sample);
+            }
+            queue.Push(converted.data(), count);
         }
     } else {
-        // Otherwise copy all of the samples to the buffer (which will be treated as s16 by core)
-        const u8* data = reinterpret_cast<const u8*>(input_buffer);
-        samples.insert(samples.begin(), data, data + num_frames * impl->sample_size_in_bytes);
+        // Otherwise queue the samples as they are (which will be treated as s16 by core)
+        queue.Push(data, num_bytes);
     }
-    impl->sample_queue->Push(samples);
 
     // returning less than num_frames here signals cubeb to stop sampling
     return num_frames;
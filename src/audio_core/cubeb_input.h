@@ -21,7 +21,7 @@ public:
 
     void AdjustSampleRate(u32 sample_rate) override;
 
-    Frontend::Mic::Samples Read() override;
+    void Read(Frontend::Mic::Samples& samples) override;
 
 private:
     struct Impl;
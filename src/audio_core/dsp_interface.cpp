@@ -2,17 +2,29 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cmath>
 #include <cstddef>
 #include "audio_core/dsp_interface.h"
 #include "audio_core/sink.h"
 #include "audio_core/sink_details.h"
 #include "common/assert.h"
+#include "common/logging/log.h"
 #include "core/core.h"
 #include "core/dumping/backend.h"
 #include "core/settings.h"
 
 namespace AudioCore {
 
+// FIFO depth the resampler keeps while it replaces the time stretcher, unless one is configured
+constexpr unsigned int STEADY_TARGET_LATENCY = 50; // milliseconds
+// Speed deviation from 100% above which the time stretcher takes over again
+constexpr double STRETCH_ENGAGE_DEVIATION = 0.02;
+// Speed deviation below which the speed counts as steady, this has to be well within the range
+// the resampler can correct
+constexpr double STRETCH_DISENGAGE_DEVIATION = 0.003;
+// Number of steady one second windows before the time stretcher is turned off
+constexpr unsigned int STEADY_WINDOWS = 3;
+
 DspInterface::DspInterface() = default;
 DspInterface::~DspInterface() = default;
 
@@ -21,6 +33,13 @@ void DspInterface::SetSink(const std::string& sink_id, const std::string& audio_
     sink->SetCallback(
         [this](s16* buffer, std::size_t num_frames) { OutputCallback(buffer, num_frames); });
     time_stretcher.SetOutputSampleRate(sink->GetNativeSampleRate());
+    latency_controller.SetTarget(static_cast<std::size_t>(Settings::values.audio_target_latency) *
+                                 sink->GetNativeSampleRate() / 1000);
+    const unsigned int steady_latency = Settings::values.audio_target_latency != 0
+                                            ? Settings::values.audio_target_latency
+                                            : STEADY_TARGET_LATENCY;
+    steady_resampler.SetTarget(std::size_t{steady_latency} * sink->GetNativeSampleRate() / 1000);
+    window_length = sink->GetNativeSampleRate();
 }
 
 Sink& DspInterface::GetSink() {
@@ -38,11 +57,22 @@ void DspInterface::EnableStretching(bool enable) {
     perform_time_stretching = enable;
 }
 
+DspInterface::BufferStats DspInterface::GetBufferStats() const {
+    return {underruns.load(), overruns.load(), fifo.Size()};
+}
+
 void DspInterface::OutputFrame(StereoFrame16& frame) {
     if (!sink)
         return;
 
-    fifo.Push(frame.data(), frame.size());
+    // Turbo mode produces audio much faster than it can be played, so it is muted instead
+    if (!Settings::values.turbo_mode) {
+        const std::size_t pushed = fifo.Push(frame.data(), frame.size());
+        frames_pushed += pushed;
+        if (pushed < frame.size()) {
+            ++overruns;
+        }
+    }
 
     if (Core::System::GetInstance().VideoDumper().IsDumping()) {
         Core::System::GetInstance().VideoDumper().AddAudioFrame(frame);
@@ -53,7 +83,13 @@ void DspInterface::OutputSample(std::array<s16, 2> sample) {
     if (!sink)
         return;
 
-    fifo.Push(&sample, 1);
+    if (!Settings::values.turbo_mode) {
+        if (fifo.Push(&sample, 1) < 1) {
+            ++overruns;
+        } else {
+            ++frames_pushed;
+        }
+    }
 
     if (Core::System::GetInstance().VideoDumper().IsDumping()) {
         Core::System::GetInstance().VideoDumper().AddAudioSample(sample);
@@ -61,8 +97,12 @@ void DspInterface::OutputSample(std::array<s16, 2> sample) {
 }
 
 void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
-    std::size_t frames_written;
     if (perform_time_stretching) {
+        UpdateStretchingMode(num_frames);
+    }
+
+    std::size_t frames_written;
+    if (perform_time_stretching && stretcher_engaged) {
         const std::vector<s16> in{fifo.Pop()};
         const std::size_t num_in{in.size() / 2};
         frames_written = time_stretcher.Process(in.data(), num_in, buffer, num_frames);
@@ -71,10 +111,20 @@ void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
         frames_written = time_stretcher.Process(nullptr, 0, buffer, num_frames);
         frames_written += fifo.Pop(buffer, num_frames - frames_written);
         flushing_time_stretcher = false;
+    } else if (perform_time_stretching) {
+        frames_written = steady_resampler.Process(fifo, buffer, num_frames);
+    } else if (latency_controller.IsEnabled()) {
+        frames_written = latency_controller.Process(fifo, buffer, num_frames);
     } else {
         frames_written = fifo.Pop(buffer, num_frames);
     }
 
+    // Only the first callback of a run without audio counts, pausing emulation shouldn't add up
+    if (frames_written < num_frames && !fifo_starved) {
+        ++underruns;
+    }
+    fifo_starved = frames_written < num_frames;
+
     if (frames_written > 0) {
         std::memcpy(&last_frame[0], buffer + 2 * (frames_written - 1), 2 * sizeof(s16));
     }
@@ -96,4 +146,34 @@ void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
     }
 }
 
+void DspInterface::UpdateStretchingMode(std::size_t num_frames) {
+    window_output_frames += num_frames;
+    if (window_output_frames < window_length)
+        return;
+
+    // The sinks run at the native sample rate, so input and output frames compare directly
+    const u64 pushed = frames_pushed.load();
+    const double speed = static_cast<double>(pushed - window_start_pushed) /
+                         static_cast<double>(window_output_frames);
+    window_start_pushed = pushed;
+    window_output_frames = 0;
+
+    const double deviation = std::abs(speed - 1.0);
+    if (!stretcher_engaged) {
+        if (deviation > STRETCH_ENGAGE_DEVIATION) {
+            LOG_DEBUG(Audio, "Engaging the time stretcher at {:.1f}% speed", speed * 100.0);
+            stretcher_engaged = true;
+            steady_windows = 0;
+        }
+    } else if (deviation < STRETCH_DISENGAGE_DEVIATION) {
+        if (++steady_windows == STEADY_WINDOWS) {
+            LOG_DEBUG(Audio, "Emulation runs at full speed, disengaging the time stretcher");
+            stretcher_engaged = false;
+            flushing_time_stretcher = true;
+        }
+    } else {
+        steady_windows = 0;
+    }
+}
+
 } // namespace AudioCore
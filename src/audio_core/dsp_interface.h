@@ -4,12 +4,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include "audio_core/audio_types.h"
+#include "audio_core/latency_controller.h"
 #include "audio_core/time_stretch.h"
 #include "common/common_types.h"
-#include "common/ring_buffer.h"
 #include "core/memory.h"
 
 namespace Service::DSP {
@@ -22,6 +23,15 @@ class Sink;
 
 class DspInterface {
 public:
+    struct BufferStats {
+        /// Number of times the sink found the FIFO empty
+        u64 underruns;
+        /// Number of times frames were dropped because the FIFO was full
+        u64 overruns;
+        /// Number of frames currently in the FIFO
+        std::size_t depth;
+    };
+
     DspInterface();
     virtual ~DspInterface();
 
@@ -98,6 +108,8 @@ public:
     Sink& GetSink();
     /// Enable/Disable audio stretching.
     void EnableStretching(bool enable);
+    /// Returns the counters of the FIFO between the DSP and the sink
+    BufferStats GetBufferStats() const;
 
 protected:
     void OutputFrame(StereoFrame16& frame);
@@ -106,13 +118,28 @@ protected:
 private:
     void FlushResidualStretcherAudio();
     void OutputCallback(s16* buffer, std::size_t num_frames);
+    /// Measures the emulation speed from the FIFO input and engages SoundTouch only when it
+    /// deviates from full speed, running the cheap resampler otherwise
+    void UpdateStretchingMode(std::size_t num_frames);
 
     std::unique_ptr<Sink> sink;
     std::atomic<bool> perform_time_stretching = false;
     std::atomic<bool> flushing_time_stretcher = false;
-    Common::RingBuffer<s16, 0x2000, 2> fifo;
+    AudioFifo fifo;
     std::array<s16, 2> last_frame{};
     TimeStretcher time_stretcher;
+    LatencyController latency_controller;
+    /// Takes the place of the time stretcher while emulation runs at full speed
+    LatencyController steady_resampler;
+    bool stretcher_engaged = true;
+    std::atomic<u64> frames_pushed = 0;
+    u64 window_start_pushed = 0;
+    std::size_t window_output_frames = 0;
+    std::size_t window_length = native_sample_rate;
+    unsigned int steady_windows = 0;
+    std::atomic<u64> underruns = 0;
+    std::atomic<u64> overruns = 0;
+    bool fifo_starved = false;
 };
 
 } // namespace AudioCore
@@ -2,10 +2,68 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
 #include "audio_core/hle/decoder.h"
+#include "common/assert.h"
 
 namespace AudioCore::HLE {
 
+PcmWriter::PcmWriter(Memory::MemorySystem& memory, const BinaryRequest& request)
+    : memory(memory), dst_addr{request.dst_addr_ch0, request.dst_addr_ch1} {}
+
+u8* PcmWriter::Reserve(std::size_t channel, std::size_t num_samples) {
+    const u64 start = u64{dst_addr[channel]} + written * sizeof(s16);
+    if (dst_addr[channel] < Memory::FCRAM_PADDR ||
+        start + num_samples * sizeof(s16) > Memory::FCRAM_PADDR + Memory::FCRAM_SIZE) {
+        LOG_ERROR(Audio_DSP, "Got out of bounds dst_addr_ch{} {:08x}", channel, dst_addr[channel]);
+        failed = true;
+        return nullptr;
+    }
+    return memory.GetFCRAMPointer(static_cast<std::size_t>(start - Memory::FCRAM_PADDR));
+}
+
+bool PcmWriter::Write(const f32* const* channels, std::size_t num_channels,
+                      std::size_t num_samples, std::size_t stride) {
+    ASSERT(num_channels <= dst_addr.size());
+    std::array<u8*, 2> dst{};
+    for (std::size_t channel = 0; channel < num_channels; ++channel) {
+        dst[channel] = Reserve(channel, num_samples);
+        if (dst[channel] == nullptr)
+            return false;
+    }
+
+    for (std::size_t channel = 0; channel < num_channels; ++channel) {
+        const f32* src = channels[channel];
+        for (std::size_t i = 0; i < num_samples; ++i) {
+            const f32 value = std::clamp(src[i * stride], -1.0f, 1.0f);
+            const s16_le sample = static_cast<s16>(0x7FFF * value);
+            std::memcpy(dst[channel] + i * sizeof(s16), &sample, sizeof(s16));
+        }
+    }
+    written += num_samples;
+    return true;
+}
+
+bool PcmWriter::Write(const s16* samples, std::size_t num_channels, std::size_t num_samples) {
+    ASSERT(num_channels <= dst_addr.size());
+    std::array<u8*, 2> dst{};
+    for (std::size_t channel = 0; channel < num_channels; ++channel) {
+        dst[channel] = Reserve(channel, num_samples);
+        if (dst[channel] == nullptr)
+            return false;
+    }
+
+    for (std::size_t channel = 0; channel < num_channels; ++channel) {
+        for (std::size_t i = 0; i < num_samples; ++i) {
+            const s16_le sample = samples[i * num_channels + channel];
+            std::memcpy(dst[channel] + i * sizeof(s16), &sample, sizeof(s16));
+        }
+    }
+    written += num_samples;
+    return true;
+}
+
 DecoderBase::~DecoderBase(){};
 
 NullDecoder::NullDecoder() = default;
@@ -4,12 +4,14 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <optional>
 #include <vector>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/core.h"
+#include "core/memory.h"
 
 namespace AudioCore::HLE {
 
@@ -52,6 +54,44 @@ struct BinaryResponse {
 };
 static_assert(sizeof(BinaryResponse) == 32, "Unexpected struct size for BinaryResponse");
 
+/**
+ * Writes the decoded PCM of a decode request straight into the guest buffers of its channels, one
+ * decoded frame at a time, so that no intermediate buffers are needed.
+ */
+class PcmWriter {
+public:
+    PcmWriter(Memory::MemorySystem& memory, const BinaryRequest& request);
+
+    /**
+     * Converts float samples to s16 and appends them to the channel buffers.
+     * @param channels     Pointers to the samples of each channel
+     * @param num_channels Number of channels, at most two
+     * @param num_samples  Number of samples per channel
+     * @param stride       Distance between two samples of a channel in floats
+     * @returns false if a channel buffer would leave FCRAM, nothing is written then
+     */
+    bool Write(const f32* const* channels, std::size_t num_channels, std::size_t num_samples,
+               std::size_t stride);
+
+    /// Appends interleaved s16 samples to the channel buffers, see Write for the parameters
+    bool Write(const s16* samples, std::size_t num_channels, std::size_t num_samples);
+
+    /// Returns true if a write was refused because it would have left FCRAM
+    bool HasFailed() const {
+        return failed;
+    }
+
+private:
+    /// Returns where the next `num_samples` samples of the channel go, nullptr if out of FCRAM
+    u8* Reserve(std::size_t channel, std::size_t num_samples);
+
+    Memory::MemorySystem& memory;
+    std::array<u32, 2> dst_addr;
+    /// Number of samples written to each channel so far
+    std::size_t written = 0;
+    bool failed = false;
+};
+
 class DecoderBase {
 public:
     virtual ~DecoderBase();
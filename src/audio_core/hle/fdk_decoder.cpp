@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <fdk-aac/aacdecoder_lib.h>
 #include "audio_core/hle/fdk_decoder.h"
 
@@ -145,7 +146,7 @@ std::optional<BinaryResponse> FDKDecoder::Impl::Decode(const BinaryRequest& requ
     }
     u8* data = memory.GetFCRAMPointer(request.src_addr - Memory::FCRAM_PADDR);
 
-    std::array<std::vector<s16>, 2> out_streams;
+    PcmWriter writer(memory, request);
 
     std::size_t data_size = request.size;
 
@@ -177,12 +178,12 @@ std::optional<BinaryResponse> FDKDecoder::Impl::Decode(const BinaryRequest& requ
             // fill the stream information for binary response
             response.num_channels = stream_info->aacNumChannels;
             response.num_samples = stream_info->frameSize;
-            // fill the output
-            // the sample size = frame_size * channel_counts
-            for (int sample = 0; sample < (stream_info->frameSize * 2); sample++) {
-                for (int ch = 0; ch < stream_info->aacNumChannels; ch++) {
-                    out_streams[ch].push_back(decoder_output[(sample * 2) + 1]);
-                }
+            // the output is interleaved and downmixed to at most two channels
+            const auto num_channels =
+                static_cast<std::size_t>(std::clamp(stream_info->numChannels, 0, 2));
+            if (!writer.Write(decoder_output, num_channels,
+                              static_cast<std::size_t>(stream_info->frameSize))) {
+                return {};
             }
         } else if (result == AAC_DEC_TRANSPORT_SYNC_ERROR) {
             // decoder has some synchronization problems, try again with new samples,
@@ -193,28 +194,6 @@ std::optional<BinaryResponse> FDKDecoder::Impl::Decode(const BinaryRequest& requ
             return std::nullopt;
         }
     }
-    // transfer the decoded buffer from vector to the FCRAM
-    if (out_streams[0].size() != 0) {
-        if (request.dst_addr_ch0 < Memory::FCRAM_PADDR ||
-            request.dst_addr_ch0 + out_streams[0].size() >
-                Memory::FCRAM_PADDR + Memory::FCRAM_SIZE) {
-            LOG_ERROR(Audio_DSP, "Got out of bounds dst_addr_ch0 {:08x}", request.dst_addr_ch0);
-            return {};
-        }
-        std::memcpy(memory.GetFCRAMPointer(request.dst_addr_ch0 - Memory::FCRAM_PADDR),
-                    out_streams[0].data(), out_streams[0].size());
-    }
-
-    if (out_streams[1].size() != 0) {
-        if (request.dst_addr_ch1 < Memory::FCRAM_PADDR ||
-            request.dst_addr_ch1 + out_streams[1].size() >
-                Memory::FCRAM_PADDR + Memory::FCRAM_SIZE) {
-            LOG_ERROR(Audio_DSP, "Got out of bounds dst_addr_ch1 {:08x}", request.dst_addr_ch1);
-            return {};
-        }
-        std::memcpy(memory.GetFCRAMPointer(request.dst_addr_ch1 - Memory::FCRAM_PADDR),
-                    out_streams[1].data(), out_streams[1].size());
-    }
     return response;
 }
 
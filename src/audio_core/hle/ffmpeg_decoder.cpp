@@ -91,10 +91,6 @@ std::optional<BinaryResponse> FFMPEGDecoder::Impl::ProcessRequest(const BinaryRe
 }
 
 std::optional<BinaryResponse> FFMPEGDecoder::Impl::Initalize(const BinaryRequest& request) {
-    if (initalized) {
-        Clear();
-    }
-
     BinaryResponse response;
     std::memcpy(&response, &request, sizeof(response));
     response.unknown1 = 0x0;
@@ -103,6 +99,18 @@ std::optional<BinaryResponse> FFMPEGDecoder::Impl::Initalize(const BinaryRequest
         return response;
     }
 
+    if (initalized) {
+        // Keep the opened codec context around, applications reinitialize the decoder for every
+        // stream they play. Only the parser, which has no way to be reset, is recreated.
+        avcodec_flush_buffers_dl(av_context.get());
+        parser.reset(av_parser_init_dl(codec->id));
+        if (parser) {
+            return response;
+        }
+        Clear();
+        initalized = false;
+    }
+
     av_packet.reset(av_packet_alloc_dl());
 
     codec = avcodec_find_decoder_dl(AV_CODEC_ID_AAC);
@@ -164,7 +172,7 @@ std::optional<BinaryResponse> FFMPEGDecoder::Impl::Decode(const BinaryRequest& r
     }
     u8* data = memory.GetFCRAMPointer(request.src_addr - Memory::FCRAM_PADDR);
 
-    std::array<std::vector<u8>, 2> out_streams;
+    PcmWriter writer(memory, request);
 
     std::size_t data_size = request.size;
     while (data_size > 0) {
@@ -207,52 +215,22 @@ std::optional<BinaryResponse> FFMPEGDecoder::Impl::Decode(const BinaryRequest& r
                     return {};
                 }
 
-                ASSERT(decoded_frame->channels <= out_streams.size());
-
-                std::size_t size = bytes_per_sample * (decoded_frame->nb_samples);
+                ASSERT(decoded_frame->channels <= 2);
 
                 response.num_channels = decoded_frame->channels;
                 response.num_samples += decoded_frame->nb_samples;
 
-                // FFmpeg converts to 32 signed floating point PCM, we need s16 PCM so we need to
-                // convert it
-                f32 val_float;
-                for (std::size_t current_pos(0); current_pos < size;) {
-                    for (std::size_t channel(0); channel < decoded_frame->channels; channel++) {
-                        std::memcpy(&val_float, decoded_frame->data[channel] + current_pos,
-                                    sizeof(val_float));
-                        val_float = std::clamp(val_float, -1.0f, 1.0f);
-                        s16 val = static_cast<s16>(0x7FFF * val_float);
-                        out_streams[channel].push_back(val & 0xFF);
-                        out_streams[channel].push_back(val >> 8);
-                    }
-                    current_pos += sizeof(val_float);
+                // FFmpeg decodes to planar 32 bit floating point PCM, which the writer converts
+                // to s16 PCM
+                if (!writer.Write(reinterpret_cast<const f32* const*>(decoded_frame->data),
+                                  static_cast<std::size_t>(decoded_frame->channels),
+                                  static_cast<std::size_t>(decoded_frame->nb_samples), 1)) {
+                    return {};
                 }
             }
         }
     }
 
-    if (out_streams[0].size() != 0) {
-        if (request.dst_addr_ch0 < Memory::FCRAM_PADDR ||
-            request.dst_addr_ch0 + out_streams[0].size() >
-                Memory::FCRAM_PADDR + Memory::FCRAM_SIZE) {
-            LOG_ERROR(Audio_DSP, "Got out of bounds dst_addr_ch0 {:08x}", request.dst_addr_ch0);
-            return {};
-        }
-        std::memcpy(memory.GetFCRAMPointer(request.dst_addr_ch0 - Memory::FCRAM_PADDR),
-                    out_streams[0].data(), out_streams[0].size());
-    }
-
-    if (out_streams[1].size() != 0) {
-        if (request.dst_addr_ch1 < Memory::FCRAM_PADDR ||
-            request.dst_addr_ch1 + out_streams[1].size() >
-                Memory::FCRAM_PADDR + Memory::FCRAM_SIZE) {
-            LOG_ERROR(Audio_DSP, "Got out of bounds dst_addr_ch1 {:08x}", request.dst_addr_ch1);
-            return {};
-        }
-        std::memcpy(memory.GetFCRAMPointer(request.dst_addr_ch1 - Memory::FCRAM_PADDR),
-                    out_streams[1].data(), out_streams[1].size());
-    }
     return response;
 }
 
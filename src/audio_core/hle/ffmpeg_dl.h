@@ -40,6 +40,7 @@ extern FuncDL<void(AVFrame**)> av_frame_free_dl;
 extern FuncDL<AVCodecContext*(const AVCodec*)> avcodec_alloc_context3_dl;
 extern FuncDL<void(AVCodecContext**)> avcodec_free_context_dl;
 extern FuncDL<int(AVCodecContext*, const AVCodec*, AVDictionary**)> avcodec_open2_dl;
+extern FuncDL<void(AVCodecContext*)> avcodec_flush_buffers_dl;
 extern FuncDL<AVPacket*(void)> av_packet_alloc_dl;
 extern FuncDL<void(AVPacket**)> av_packet_free_dl;
 extern FuncDL<AVCodec*(AVCodecID)> avcodec_find_decoder_dl;
@@ -63,6 +64,7 @@ const auto av_frame_free_dl = &av_frame_free;
 const auto avcodec_alloc_context3_dl = &avcodec_alloc_context3;
 const auto avcodec_free_context_dl = &avcodec_free_context;
 const auto avcodec_open2_dl = &avcodec_open2;
+const auto avcodec_flush_buffers_dl = &avcodec_flush_buffers;
 const auto av_packet_alloc_dl = &av_packet_alloc;
 const auto av_packet_free_dl = &av_packet_free;
 const auto avcodec_find_decoder_dl = &avcodec_find_decoder;
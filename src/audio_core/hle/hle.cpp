@@ -2,6 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
 #include "audio_core/audio_types.h"
 #ifdef HAVE_MF
 #include "audio_core/hle/wmf_decoder.h"
@@ -23,8 +27,12 @@
 #include "common/common_types.h"
 #include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/movie.h"
+#include "core/perf_metrics.h"
 
 using InterruptType = Service::DSP::DSP_DSP::InterruptType;
 using Service::DSP::DSP_DSP;
@@ -35,7 +43,7 @@ static constexpr u64 audio_frame_ticks = 1310252ull; ///< Units: ARM11 cycles
 
 struct DspHle::Impl final {
 public:
-    explicit Impl(DspHle& parent, Memory::MemorySystem& memory);
+    Impl(DspHle& parent, Memory::MemorySystem& memory, bool multithread);
     ~Impl();
 
     DspState GetDspState() const;
@@ -59,8 +67,14 @@ private:
     HLE::SharedMemory& ReadRegion();
     HLE::SharedMemory& WriteRegion();
 
-    StereoFrame16 GenerateCurrentFrame();
+    StereoFrame16 GenerateCurrentFrame(HLE::SharedMemory& read, HLE::SharedMemory& write);
     bool Tick();
+
+    /// Publishes the frame generated by the worker thread, waiting for it if it isn't done yet
+    void FinishPendingFrame();
+    /// Hands a copy of the current read region to the worker thread to generate the next frame
+    void StartFrame();
+    void WorkerThread();
     void AudioTickCallback(s64 cycles_late);
 
     DspState dsp_state = DspState::Off;
@@ -82,9 +96,29 @@ private:
     std::unique_ptr<HLE::DecoderBase> decoder;
 
     std::weak_ptr<DSP_DSP> dsp_dsp;
+
+    /**
+     * When multithreaded, the sources and mixers are only touched by the worker thread, which
+     * works on copies of the shared memory regions. Its results reach the application one audio
+     * frame later, like the output of a real DSP that runs alongside the ARM11.
+     */
+    const bool multithread;
+    std::thread worker_thread;
+    std::mutex worker_mutex;
+    /// Signaled when a frame is handed to the worker thread or the worker is stopped
+    std::condition_variable frame_started;
+    /// Signaled when the worker thread finished a frame
+    std::condition_variable frame_done;
+    bool frame_pending = false;
+    bool frame_busy = false;
+    bool worker_stop = false;
+    HLE::SharedMemory worker_read;
+    HLE::SharedMemory worker_write;
+    StereoFrame16 worker_output;
 };
 
-DspHle::Impl::Impl(DspHle& parent_, Memory::MemorySystem& memory) : parent(parent_) {
+DspHle::Impl::Impl(DspHle& parent_, Memory::MemorySystem& memory, bool multithread)
+    : parent(parent_), multithread(multithread) {
     dsp_memory.raw_memory.fill(0);
 
     for (auto& source : sources) {
@@ -122,11 +156,24 @@ DspHle::Impl::Impl(DspHle& parent_, Memory::MemorySystem& memory) : parent(paren
             this->AudioTickCallback(cycles_late);
         });
     timing.ScheduleEvent(audio_frame_ticks, tick_event);
+
+    if (multithread) {
+        worker_thread = std::thread(&Impl::WorkerThread, this);
+    }
 }
 
 DspHle::Impl::~Impl() {
     Core::Timing& timing = Core::System::GetInstance().CoreTiming();
     timing.UnscheduleEvent(tick_event, 0);
+
+    if (worker_thread.joinable()) {
+        {
+            std::lock_guard lock{worker_mutex};
+            worker_stop = true;
+        }
+        frame_started.notify_one();
+        worker_thread.join();
+    }
 }
 
 DspState DspHle::Impl::GetDspState() const {
@@ -366,10 +413,8 @@ HLE::SharedMemory& DspHle::Impl::WriteRegion() {
     return CurrentRegionIndex() != 0 ? dsp_memory.region_0 : dsp_memory.region_1;
 }
 
-StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
-    HLE::SharedMemory& read = ReadRegion();
-    HLE::SharedMemory& write = WriteRegion();
-
+StereoFrame16 DspHle::Impl::GenerateCurrentFrame(HLE::SharedMemory& read,
+                                                 HLE::SharedMemory& write) {
     std::array<QuadFrame32, 3> intermediate_mixes = {};
 
     // Generate intermediate mixes
@@ -398,18 +443,94 @@ StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
 }
 
 bool DspHle::Impl::Tick() {
-    StereoFrame16 current_frame = {};
-
     // TODO: Check dsp::DSP semaphore (which indicates emulated application has finished writing to
     // shared memory region)
-    current_frame = GenerateCurrentFrame();
 
-    parent.OutputFrame(current_frame);
+    // Movies need the source statuses to reach the application in the same frame every time
+    const Core::Movie& movie = Core::Movie::GetInstance();
+    if (!multithread || movie.IsPlayingInput() || movie.IsRecordingInput()) {
+        FinishPendingFrame();
+        StereoFrame16 current_frame = GenerateCurrentFrame(ReadRegion(), WriteRegion());
+        parent.OutputFrame(current_frame);
+        return true;
+    }
 
+    FinishPendingFrame();
+    StartFrame();
     return true;
 }
 
+MICROPROFILE_DEFINE(Audio_HLEWait, "Audio", "Wait for DSP HLE frame", MP_RGB(128, 128, 255));
+void DspHle::Impl::FinishPendingFrame() {
+    {
+        std::unique_lock lock{worker_mutex};
+        if (!frame_pending)
+            return;
+        MICROPROFILE_SCOPE(Audio_HLEWait);
+        frame_done.wait(lock, [this] { return !frame_busy; });
+        frame_pending = false;
+    }
+
+    HLE::SharedMemory& write = WriteRegion();
+    write.source_statuses = worker_write.source_statuses;
+    write.dsp_status = worker_write.dsp_status;
+    write.intermediate_mix_samples = worker_write.intermediate_mix_samples;
+    write.final_samples = worker_write.final_samples;
+
+    parent.OutputFrame(worker_output);
+}
+
+void DspHle::Impl::StartFrame() {
+    HLE::SharedMemory& read = ReadRegion();
+    std::memcpy(&worker_read, &read, sizeof(HLE::SharedMemory));
+
+    // The worker consumes the dirty flags of its copy, so clear them here as the DSP would
+    for (auto& config : read.source_configurations.config) {
+        if (config.buffer_queue_dirty) {
+            config.buffers_dirty = 0;
+        }
+        config.dirty_raw = 0;
+    }
+    read.dsp_configuration.dirty_raw = 0;
+
+    {
+        std::lock_guard lock{worker_mutex};
+        frame_pending = true;
+        frame_busy = true;
+    }
+    frame_started.notify_one();
+}
+
+MICROPROFILE_DEFINE(Audio_HLEFrame, "Audio", "DSP HLE frame", MP_RGB(128, 128, 255));
+void DspHle::Impl::WorkerThread() {
+    Common::SetCurrentThreadName("DspHle");
+    MicroProfileOnThreadCreate("DspHle");
+
+    while (true) {
+        {
+            std::unique_lock lock{worker_mutex};
+            frame_started.wait(lock, [this] { return worker_stop || frame_busy; });
+            if (worker_stop)
+                break;
+        }
+
+        {
+            MICROPROFILE_SCOPE(Audio_HLEFrame);
+            worker_output = GenerateCurrentFrame(worker_read, worker_write);
+        }
+
+        {
+            std::lock_guard lock{worker_mutex};
+            frame_busy = false;
+        }
+        frame_done.notify_one();
+    }
+
+    MicroProfileOnThreadExit();
+}
+
 void DspHle::Impl::AudioTickCallback(s64 cycles_late) {
+    Core::Metrics::ScopedTimer metrics_timer{Core::Metrics::Time::DSP};
     if (Tick()) {
         // TODO(merry): Signal all the other interrupts as appropriate.
         if (auto service = dsp_dsp.lock()) {
@@ -424,7 +545,8 @@ void DspHle::Impl::AudioTickCallback(s64 cycles_late) {
     timing.ScheduleEvent(audio_frame_ticks - cycles_late, tick_event);
 }
 
-DspHle::DspHle(Memory::MemorySystem& memory) : impl(std::make_unique<Impl>(*this, memory)) {}
+DspHle::DspHle(Memory::MemorySystem& memory, bool multithread)
+    : impl(std::make_unique<Impl>(*this, memory, multithread)) {}
 DspHle::~DspHle() = default;
 
 u16 DspHle::RecvData(u32 register_number) {
@@ -21,7 +21,7 @@ namespace AudioCore {
 
 class DspHle final : public DspInterface {
 public:
-    explicit DspHle(Memory::MemorySystem& memory);
+    DspHle(Memory::MemorySystem& memory, bool multithread);
     ~DspHle();
 
     u16 RecvData(u32 register_number) override;
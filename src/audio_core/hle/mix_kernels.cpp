@@ -0,0 +1,211 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstddef>
+#include "audio_core/hle/mix_kernels.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace AudioCore::HLE {
+
+// The vector kernels process four samples per iteration
+static_assert(samples_per_frame % 4 == 0, "The frame length must be a multiple of four samples");
+
+// The vector kernels perform the same float operations in the same order as the scalar ones and
+// convert with truncation and saturation as well, so that they produce the same samples.
+
+namespace MixKernelsDetail {
+
+static s16 ClampToS16(s32 value) {
+    return static_cast<s16>(std::clamp(value, -32768, 32767));
+}
+
+static std::array<s16, 2> AddAndClampToS16(const std::array<s16, 2>& a,
+                                           const std::array<s16, 2>& b) {
+    return {ClampToS16(static_cast<s32>(a[0]) + static_cast<s32>(b[0])),
+            ClampToS16(static_cast<s32>(a[1]) + static_cast<s32>(b[1]))};
+}
+
+void MixIntoQuadFrameScalar(QuadFrame32& dest, const StereoFrame16& source,
+                            const std::array<float, 4>& gains) {
+    for (std::size_t samplei = 0; samplei < samples_per_frame; samplei++) {
+        // Conversion from stereo (source) to quadraphonic (dest) occurs here.
+        dest[samplei][0] += static_cast<s32>(gains[0] * source[samplei][0]);
+        dest[samplei][1] += static_cast<s32>(gains[1] * source[samplei][1]);
+        dest[samplei][2] += static_cast<s32>(gains[2] * source[samplei][0]);
+        dest[samplei][3] += static_cast<s32>(gains[3] * source[samplei][1]);
+    }
+}
+
+void DownmixStereoAndAddScalar(StereoFrame16& dest, const QuadFrame32& source, float gain) {
+    std::transform(dest.begin(), dest.end(), source.begin(), dest.begin(),
+                   [gain](const std::array<s16, 2>& accumulator,
+                          const std::array<s32, 4>& sample) -> std::array<s16, 2> {
+                       // Downmix to stereo
+                       s16 left = ClampToS16(static_cast<s32>(gain * sample[0] + gain * sample[2]));
+                       s16 right =
+                           ClampToS16(static_cast<s32>(gain * sample[1] + gain * sample[3]));
+                       // Mix into current frame
+                       return AddAndClampToS16(accumulator, {left, right});
+                   });
+}
+
+void DownmixMonoAndAddScalar(StereoFrame16& dest, const QuadFrame32& source, float gain) {
+    std::transform(
+        dest.begin(), dest.end(), source.begin(), dest.begin(),
+        [gain](const std::array<s16, 2>& accumulator,
+               const std::array<s32, 4>& sample) -> std::array<s16, 2> {
+            // Downmix to mono
+            s16 mono = ClampToS16(static_cast<s32>(
+                (gain * sample[0] + gain * sample[1] + gain * sample[2] + gain * sample[3]) / 2));
+            // Mix into current frame
+            return AddAndClampToS16(accumulator, {mono, mono});
+        });
+}
+
+} // namespace MixKernelsDetail
+
+#if defined(ARCHITECTURE_x86_64)
+
+void MixIntoQuadFrame(QuadFrame32& dest, const StereoFrame16& source,
+                      const std::array<float, 4>& gains) {
+    const __m128 gain = _mm_loadu_ps(gains.data());
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+        // Convert four stereo samples to [L0 R0 L1 R1] and [L2 R2 L3 R3]
+        const __m128i pcm16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source[i]));
+        const __m128 pairs[2] = {
+            _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(pcm16, pcm16), 16)),
+            _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(pcm16, pcm16), 16))};
+        const __m128 lrlr[4] = {
+            _mm_movelh_ps(pairs[0], pairs[0]), _mm_movehl_ps(pairs[0], pairs[0]),
+            _mm_movelh_ps(pairs[1], pairs[1]), _mm_movehl_ps(pairs[1], pairs[1])};
+        for (std::size_t j = 0; j < 4; ++j) {
+            const __m128i scaled = _mm_cvttps_epi32(_mm_mul_ps(gain, lrlr[j]));
+            __m128i* const out = reinterpret_cast<__m128i*>(&dest[i + j]);
+            _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), scaled));
+        }
+    }
+}
+
+void DownmixStereoAndAdd(StereoFrame16& dest, const QuadFrame32& source, float gain) {
+    const __m128 gains = _mm_set1_ps(gain);
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+        __m128 scaled[4];
+        for (std::size_t j = 0; j < 4; ++j) {
+            const __m128i sample =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(source[i + j].data()));
+            scaled[j] = _mm_mul_ps(gains, _mm_cvtepi32_ps(sample));
+        }
+        // Add the back channels to the front ones of two samples at once
+        const __m128 lr01 =
+            _mm_add_ps(_mm_shuffle_ps(scaled[0], scaled[1], _MM_SHUFFLE(1, 0, 1, 0)),
+                       _mm_shuffle_ps(scaled[0], scaled[1], _MM_SHUFFLE(3, 2, 3, 2)));
+        const __m128 lr23 =
+            _mm_add_ps(_mm_shuffle_ps(scaled[2], scaled[3], _MM_SHUFFLE(1, 0, 1, 0)),
+                       _mm_shuffle_ps(scaled[2], scaled[3], _MM_SHUFFLE(3, 2, 3, 2)));
+        const __m128i mixed = _mm_packs_epi32(_mm_cvttps_epi32(lr01), _mm_cvttps_epi32(lr23));
+        __m128i* const out = reinterpret_cast<__m128i*>(&dest[i]);
+        _mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out), mixed));
+    }
+}
+
+void DownmixMonoAndAdd(StereoFrame16& dest, const QuadFrame32& source, float gain) {
+    const __m128 gains = _mm_set1_ps(gain);
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+        __m128 c[4];
+        for (std::size_t j = 0; j < 4; ++j) {
+            const __m128i sample =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(source[i + j].data()));
+            c[j] = _mm_mul_ps(gains, _mm_cvtepi32_ps(sample));
+        }
+        // Each vector now holds one channel of the four samples
+        _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+        const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_add_ps(c[0], c[1]), c[2]), c[3]);
+        const __m128i mono32 = _mm_cvttps_epi32(_mm_mul_ps(sum, half));
+        const __m128i mono16 = _mm_packs_epi32(mono32, mono32);
+        const __m128i mixed = _mm_unpacklo_epi16(mono16, mono16);
+        __m128i* const out = reinterpret_cast<__m128i*>(&dest[i]);
+        _mm_storeu_si128(out, _mm_adds_epi16(_mm_loadu_si128(out), mixed));
+    }
+}
+
+#elif defined(ARCHITECTURE_ARM64)
+
+void MixIntoQuadFrame(QuadFrame32& dest, const StereoFrame16& source,
+                      const std::array<float, 4>& gains) {
+    const float32x4_t gain = vld1q_f32(gains.data());
+    for (std::size_t i = 0; i < samples_per_frame; i += 2) {
+        // Sign extend two stereo samples to [L0 R0 L1 R1]
+        const int32x4_t pair = vmovl_s16(vld1_s16(source[i].data()));
+        const int32x4_t lrlr[2] = {vcombine_s32(vget_low_s32(pair), vget_low_s32(pair)),
+                                   vcombine_s32(vget_high_s32(pair), vget_high_s32(pair))};
+        for (std::size_t j = 0; j < 2; ++j) {
+            const int32x4_t scaled = vcvtq_s32_f32(vmulq_f32(gain, vcvtq_f32_s32(lrlr[j])));
+            s32* const out = dest[i + j].data();
+            vst1q_s32(out, vaddq_s32(vld1q_s32(out), scaled));
+        }
+    }
+}
+
+void DownmixStereoAndAdd(StereoFrame16& dest, const QuadFrame32& source, float gain) {
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+        float32x4_t scaled[4];
+        for (std::size_t j = 0; j < 4; ++j) {
+            scaled[j] = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(source[i + j].data())), gain);
+        }
+        // Add the back channels to the front ones of two samples at once
+        const float32x4_t lr01 =
+            vaddq_f32(vcombine_f32(vget_low_f32(scaled[0]), vget_low_f32(scaled[1])),
+                      vcombine_f32(vget_high_f32(scaled[0]), vget_high_f32(scaled[1])));
+        const float32x4_t lr23 =
+            vaddq_f32(vcombine_f32(vget_low_f32(scaled[2]), vget_low_f32(scaled[3])),
+                      vcombine_f32(vget_high_f32(scaled[2]), vget_high_f32(scaled[3])));
+        const int16x8_t mixed = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(lr01)),
+                                             vqmovn_s32(vcvtq_s32_f32(lr23)));
+        s16* const out = dest[i].data();
+        vst1q_s16(out, vqaddq_s16(vld1q_s16(out), mixed));
+    }
+}
+
+void DownmixMonoAndAdd(StereoFrame16& dest, const QuadFrame32& source, float gain) {
+    for (std::size_t i = 0; i < samples_per_frame; i += 4) {
+        // Each vector holds one channel of the four samples
+        const int32x4x4_t c = vld4q_s32(source[i].data());
+        const float32x4_t sum =
+            vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(vcvtq_f32_s32(c.val[0]), gain),
+                                          vmulq_n_f32(vcvtq_f32_s32(c.val[1]), gain)),
+                                vmulq_n_f32(vcvtq_f32_s32(c.val[2]), gain)),
+                      vmulq_n_f32(vcvtq_f32_s32(c.val[3]), gain));
+        const int16x4_t mono = vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(sum, 0.5f)));
+        const int16x4x2_t both = vzip_s16(mono, mono);
+        const int16x8_t mixed = vcombine_s16(both.val[0], both.val[1]);
+        s16* const out = dest[i].data();
+        vst1q_s16(out, vqaddq_s16(vld1q_s16(out), mixed));
+    }
+}
+
+#else
+
+void MixIntoQuadFrame(QuadFrame32& dest, const StereoFrame16& source,
+                      const std::array<float, 4>& gains) {
+    MixKernelsDetail::MixIntoQuadFrameScalar(dest, source, gains);
+}
+
+void DownmixStereoAndAdd(StereoFrame16& dest, const QuadFrame32& source, float gain) {
+    MixKernelsDetail::DownmixStereoAndAddScalar(dest, source, gain);
+}
+
+void DownmixMonoAndAdd(StereoFrame16& dest, const QuadFrame32& source, float gain) {
+    MixKernelsDetail::DownmixMonoAndAddScalar(dest, source, gain);
+}
+
+#endif
+
+} // namespace AudioCore::HLE
@@ -0,0 +1,35 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "audio_core/audio_types.h"
+
+namespace AudioCore::HLE {
+
+/**
+ * Adds the output frame of a source to a quadraphonic mix. The four gains apply to the left,
+ * right, back left and back right channels, the back channels repeat the front ones.
+ */
+void MixIntoQuadFrame(QuadFrame32& dest, const StereoFrame16& source,
+                      const std::array<float, 4>& gains);
+
+/// Downmixes a quadraphonic frame to stereo with the given gain and adds it to dest, saturated
+void DownmixStereoAndAdd(StereoFrame16& dest, const QuadFrame32& source, float gain);
+
+/// Downmixes a quadraphonic frame to mono with the given gain and adds it to both channels of dest
+void DownmixMonoAndAdd(StereoFrame16& dest, const QuadFrame32& source, float gain);
+
+namespace MixKernelsDetail {
+
+/// Scalar reference implementations of the kernels, used where no vector kernel is available
+void MixIntoQuadFrameScalar(QuadFrame32& dest, const StereoFrame16& source,
+                            const std::array<float, 4>& gains);
+void DownmixStereoAndAddScalar(StereoFrame16& dest, const QuadFrame32& source, float gain);
+void DownmixMonoAndAddScalar(StereoFrame16& dest, const QuadFrame32& source, float gain);
+
+} // namespace MixKernelsDetail
+
+} // namespace AudioCore::HLE
@@ -23,7 +23,7 @@ private:
 
     std::optional<BinaryResponse> Decode(const BinaryRequest& request);
 
-    MFOutputState DecodingLoop(ADTSData adts_header, std::array<std::vector<u8>, 2>& out_streams);
+    MFOutputState DecodingLoop(ADTSData adts_header, PcmWriter& writer);
 
     bool transform_initialized = false;
     bool format_selected = false;
@@ -136,8 +136,7 @@ std::optional<BinaryResponse> WMFDecoder::Impl::Initalize(const BinaryRequest& r
     return response;
 }
 
-MFOutputState WMFDecoder::Impl::DecodingLoop(ADTSData adts_header,
-                                             std::array<std::vector<u8>, 2>& out_streams) {
+MFOutputState WMFDecoder::Impl::DecodingLoop(ADTSData adts_header, PcmWriter& writer) {
     MFOutputState output_status = MFOutputState::OK;
     std::optional<std::vector<f32>> output_buffer;
     unique_mfptr<IMFSample> output;
@@ -149,17 +148,13 @@ MFOutputState WMFDecoder::Impl::DecodingLoop(ADTSData adts_header,
         if (output_status == MFOutputState::OK || output_status == MFOutputState::HaveMoreData) {
             output_buffer = CopySampleToBuffer(output.get());
 
-            // the following was taken from ffmpeg version of the decoder
-            f32 val_f32;
-            for (std::size_t i = 0; i < output_buffer->size();) {
-                for (std::size_t channel = 0; channel < adts_header.channels; channel++) {
-                    val_f32 = std::clamp(output_buffer->at(i), -1.0f, 1.0f);
-                    s16 val = static_cast<s16>(0x7FFF * val_f32);
-                    out_streams[channel].push_back(val & 0xFF);
-                    out_streams[channel].push_back(val >> 8);
-                    // i is incremented on per channel basis
-                    i++;
-                }
+            // The samples are interleaved 32 bit floating point PCM
+            const std::size_t num_channels = adts_header.channels;
+            const f32* const data = output_buffer->data();
+            const std::array<const f32*, 2> channels{data, data + 1};
+            if (!writer.Write(channels.data(), num_channels, output_buffer->size() / num_channels,
+                              num_channels)) {
+                return MFOutputState::FatalError;
             }
         }
 
@@ -208,7 +203,7 @@ std::optional<BinaryResponse> WMFDecoder::Impl::Decode(const BinaryRequest& requ
     }
     u8* data = memory.GetFCRAMPointer(request.src_addr - Memory::FCRAM_PADDR);
 
-    std::array<std::vector<u8>, 2> out_streams;
+    PcmWriter writer(memory, request);
     unique_mfptr<IMFSample> sample;
     MFInputState input_status = MFInputState::OK;
     MFOutputState output_status = MFOutputState::OK;
@@ -239,7 +234,11 @@ std::optional<BinaryResponse> WMFDecoder::Impl::Decode(const BinaryRequest& requ
 
     while (true) {
         input_status = SendSample(transform.get(), in_stream_id, sample.get());
-        output_status = DecodingLoop(adts_meta->ADTSHeader, out_streams);
+        output_status = DecodingLoop(adts_meta->ADTSHeader, writer);
+
+        if (writer.HasFailed()) {
+            return {};
+        }
 
         if (output_status == MFOutputState::FatalError) {
             // if the decode issues are caused by MFT not accepting new samples, try again
@@ -262,28 +261,6 @@ std::optional<BinaryResponse> WMFDecoder::Impl::Decode(const BinaryRequest& requ
         break; // jump out of the loop if at least we don't have obvious issues
     }
 
-    if (out_streams[0].size() != 0) {
-        if (request.dst_addr_ch0 < Memory::FCRAM_PADDR ||
-            request.dst_addr_ch0 + out_streams[0].size() >
-                Memory::FCRAM_PADDR + Memory::FCRAM_SIZE) {
-            LOG_ERROR(Audio_DSP, "Got out of bounds dst_addr_ch0 {:08x}", request.dst_addr_ch0);
-            return {};
-        }
-        std::memcpy(memory.GetFCRAMPointer(request.dst_addr_ch0 - Memory::FCRAM_PADDR),
-                    out_streams[0].data(), out_streams[0].size());
-    }
-
-    if (out_streams[1].size() != 0) {
-        if (request.dst_addr_ch1 < Memory::FCRAM_PADDR ||
-            request.dst_addr_ch1 + out_streams[1].size() >
-                Memory::FCRAM_PADDR + Memory::FCRAM_SIZE) {
-            LOG_ERROR(Audio_DSP, "Got out of bounds dst_addr_ch1 {:08x}", request.dst_addr_ch1);
-            return {};
-        }
-        std::memcpy(memory.GetFCRAMPointer(request.dst_addr_ch1 - Memory::FCRAM_PADDR),
-                    out_streams[1].data(), out_streams[1].size());
-    }
-
     return response;
 }
 
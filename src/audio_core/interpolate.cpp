@@ -20,10 +20,12 @@ static void StepOverSamples(State& state, StereoBuffer16& input, float rate, Ste
                             std::size_t& outputi, Function fn) {
     ASSERT(rate > 0);
 
-    if (input.empty())
+    if (input.IsEmpty())
         return;
 
-    input.insert(input.begin(), {state.xn2, state.xn1});
+    // The history samples are stored in front of the input, which is stepped over in place
+    const StereoBuffer16::Sample* const samples = input.PrependHistory(state.xn2, state.xn1);
+    const std::size_t num_samples = input.Size() + 2;
 
     const u64 step_size = static_cast<u64>(rate * scale_factor);
     u64 fposition = state.fposition;
@@ -32,22 +34,22 @@ static void StepOverSamples(State& state, StereoBuffer16& input, float rate, Ste
     while (outputi < output.size()) {
         inputi = static_cast<std::size_t>(fposition / scale_factor);
 
-        if (inputi + 2 >= input.size()) {
-            inputi = input.size() - 2;
+        if (inputi + 2 >= num_samples) {
+            inputi = num_samples - 2;
             break;
         }
 
         u64 fraction = fposition & scale_mask;
-        output[outputi++] = fn(fraction, input[inputi], input[inputi + 1], input[inputi + 2]);
+        output[outputi++] = fn(fraction, samples[inputi], samples[inputi + 1], samples[inputi + 2]);
 
         fposition += step_size;
     }
 
-    state.xn2 = input[inputi];
-    state.xn1 = input[inputi + 1];
+    state.xn2 = samples[inputi];
+    state.xn1 = samples[inputi + 1];
     state.fposition = fposition - inputi * scale_factor;
 
-    input.erase(input.begin(), std::next(input.begin(), inputi + 2));
+    input.Consume(inputi);
 }
 
 void None(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
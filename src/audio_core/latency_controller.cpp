@@ -0,0 +1,72 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "audio_core/latency_controller.h"
+
+namespace AudioCore {
+
+// Largest deviation of the resampling rate from the input rate
+constexpr double MAX_RATE_DEVIATION = 0.005;
+// Rate deviation per relative error of the FIFO depth
+constexpr double RATE_GAIN = 0.01;
+// Weight of the current depth in the smoothed depth, per sink callback
+constexpr double DEPTH_SMOOTHING = 0.05;
+
+void LatencyController::SetTarget(std::size_t frames) {
+    target = frames;
+    primed = false;
+    phase = 0.0;
+}
+
+std::size_t LatencyController::Process(AudioFifo& fifo, s16* out, std::size_t num_out) {
+    const double depth = static_cast<double>(fifo.Size());
+    if (!primed) {
+        if (depth < static_cast<double>(target))
+            return 0;
+        primed = true;
+        smoothed_depth = depth;
+    }
+
+    smoothed_depth += DEPTH_SMOOTHING * (depth - smoothed_depth);
+    const double error = (smoothed_depth - static_cast<double>(target)) / target;
+    const double ratio =
+        1.0 + std::clamp(error * RATE_GAIN, -MAX_RATE_DEVIATION, MAX_RATE_DEVIATION);
+
+    // Input frame 0 is the last frame of the previous call and output frame i is interpolated at
+    // the input position phase + i * ratio
+    const std::size_t needed = static_cast<std::size_t>(phase + num_out * ratio);
+    input.resize((needed + 1) * 2);
+    input[0] = last_input[0];
+    input[1] = last_input[1];
+    const std::size_t popped = fifo.Pop(input.data() + 2, needed);
+
+    std::size_t written = 0;
+    double position = phase;
+    while (written < num_out) {
+        const std::size_t index = static_cast<std::size_t>(position);
+        if (index >= popped)
+            break;
+        const double fraction = position - index;
+        for (std::size_t channel = 0; channel < 2; ++channel) {
+            const double s0 = input[index * 2 + channel];
+            const double s1 = input[(index + 1) * 2 + channel];
+            out[written * 2 + channel] = static_cast<s16>(s0 + (s1 - s0) * fraction);
+        }
+        ++written;
+        position += ratio;
+    }
+
+    const std::size_t last = std::min(static_cast<std::size_t>(position), popped);
+    last_input = {input[last * 2], input[last * 2 + 1]};
+    phase = position - last;
+
+    if (written < num_out) {
+        // Wait for the FIFO to refill instead of crackling at its bottom
+        primed = false;
+    }
+    return written;
+}
+
+} // namespace AudioCore
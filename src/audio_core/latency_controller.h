@@ -0,0 +1,55 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+#include "common/ring_buffer.h"
+
+namespace AudioCore {
+
+/// Lock-free FIFO of stereo frames between the DSP and the sink callback
+using AudioFifo = Common::RingBuffer<s16, 0x2000, 2>;
+
+/**
+ * Keeps the FIFO between the DSP and the sink near a target depth. The clocks of the emulated DSP
+ * and of the host audio device drift apart, so without correction the FIFO either runs dry or
+ * fills up until frames are dropped. The controller resamples the output at a rate within a
+ * fraction of a percent of the input rate, which is too small a pitch change to be heard, and
+ * steers the rate by how far the smoothed FIFO depth is off the target.
+ */
+class LatencyController {
+public:
+    /// Sets the depth to keep the FIFO at in frames, zero disables the controller
+    void SetTarget(std::size_t frames);
+
+    bool IsEnabled() const {
+        return target != 0;
+    }
+
+    /**
+     * Fills `out` with frames from the FIFO. After the FIFO ran dry, playback only resumes once
+     * it has been refilled to the target depth.
+     * @param fifo     FIFO filled by the DSP
+     * @param out      Output sample buffer
+     * @param num_out  Desired number of output frames in `out`
+     * @returns Actual number of frames written to `out`
+     */
+    std::size_t Process(AudioFifo& fifo, s16* out, std::size_t num_out);
+
+private:
+    std::size_t target = 0;
+    bool primed = false;
+    double smoothed_depth = 0.0;
+    /// Position of the next output frame between the last input frame and the next one
+    double phase = 0.0;
+    /// Last input frame, which the next output frames are interpolated from
+    std::array<s16, 2> last_input{};
+    std::vector<s16> input;
+};
+
+} // namespace AudioCore
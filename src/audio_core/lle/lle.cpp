@@ -15,6 +15,7 @@
 #include "core/core_timing.h"
 #include "core/hle/lock.h"
 #include "core/hle/service/dsp/dsp_dsp.h"
+#include "core/perf_metrics.h"
 
 namespace AudioCore {
 
@@ -145,6 +146,10 @@ struct DspLle::Impl final {
     std::atomic<bool> stop_signal = false;
     std::size_t stop_generation;
 
+    /// Samples are passed on a whole frame at a time instead of locking the FIFO for each one
+    StereoFrame16 output_samples;
+    std::size_t num_output_samples = 0;
+
     static constexpr u32 DspDataOffset = 0x40000;
     static constexpr u32 TeakraSlice = 20000;
 
@@ -178,7 +183,10 @@ struct DspLle::Impl final {
     }
 
     void TeakraSliceEvent(u64 late) {
-        RunTeakraSlice();
+        {
+            Core::Metrics::ScopedTimer metrics_timer{Core::Metrics::Time::DSP};
+            RunTeakraSlice();
+        }
         u64 next = TeakraSlice * 2; // DSP runs at clock rate half of the CPU rate
         if (next < late)
             next = 0;
@@ -372,6 +380,7 @@ struct DspLle::Impl final {
 
         Core::System::GetInstance().CoreTiming().UnscheduleEvent(teakra_slice_event, 0);
         StopTeakraThread();
+        num_output_samples = 0;
     }
 };
 
@@ -483,7 +492,13 @@ DspLle::DspLle(Memory::MemorySystem& memory, bool multithread)
         *memory.GetFCRAMPointer(address - Memory::FCRAM_PADDR) = value;
     };
     impl->teakra.SetAHBMCallback(ahbm);
-    impl->teakra.SetAudioCallback([this](std::array<s16, 2> sample) { OutputSample(sample); });
+    impl->teakra.SetAudioCallback([this](std::array<s16, 2> sample) {
+        impl->output_samples[impl->num_output_samples++] = sample;
+        if (impl->num_output_samples == impl->output_samples.size()) {
+            OutputFrame(impl->output_samples);
+            impl->num_output_samples = 0;
+        }
+    });
 }
 DspLle::~DspLle() = default;
 
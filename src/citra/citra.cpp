@@ -2,11 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <memory>
 #include <regex>
 #include <string>
 #include <thread>
+#include <vector>
 
 // This needs to be included before getopt.h because the latter #defines symbols used by it
 #include "common/microprofile.h"
@@ -37,13 +41,17 @@
 #include "core/frontend/framebuffer_layout.h"
 #include "core/frontend/scope_acquire_context.h"
 #include "core/gdbstub/gdbstub.h"
+#include "core/hw/gpu.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/cfg/cfg.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
+#include "core/perf_stats.h"
+#include "core/replay_verifier.h"
 #include "core/settings.h"
 #include "network/network.h"
 #include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
 
 #undef _UNICODE
 #include <getopt.h>
@@ -68,6 +76,18 @@ static void PrintHelp(const char* argv0) {
                  "-r, --movie-record=[file]  Record a movie (game inputs) to the given file\n"
                  "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file\n"
                  "-d, --dump-video=[file]    Dumps audio and video to the given video file\n"
+                 "-b, --benchmark=FRAMES     Run FRAMES emulated frames headless and unthrottled,\n"
+                 "                           then print the performance statistics as JSON\n"
+                 "-t, --benchmark-time=SECONDS  Like --benchmark, for SECONDS of emulated time\n"
+                 "--replay-hashes=FILE       With --movie-play, replay the movie headless and\n"
+                 "                           unthrottled and write hashes of the state to FILE\n"
+                 "--replay-reference=FILE    With --movie-play, compare the state against the\n"
+                 "                           hashes in FILE and stop at the first divergence\n"
+                 "--replay-interval=FRAMES   Frames between the replay hashes, 60 by default\n"
+                 "--screenshots=PREFIX       Save a screenshot periodically to PREFIX followed\n"
+                 "                           by its number and .png\n"
+                 "--screenshot-interval=MS   Milliseconds between the screenshots, 5000 by\n"
+                 "                           default\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
                  "-h, --help           Display this help and exit\n"
                  "-v, --version        Output version information and exit\n";
@@ -169,6 +189,38 @@ static void OnStatusMessageReceived(const Network::StatusMessageEntry& msg) {
         std::cout << std::endl << "* " << message << std::endl << std::endl;
 }
 
+/// Prints the statistics of a benchmark run as a single line of JSON
+static void PrintBenchmarkResults(Core::System& system, double host_seconds) {
+    std::vector<double> frametimes = system.perf_stats->GetFrametimes();
+    std::sort(frametimes.begin(), frametimes.end());
+    const auto percentile = [&frametimes](double p) {
+        if (frametimes.empty())
+            return 0.0;
+        const auto index = static_cast<std::size_t>(std::ceil(p * frametimes.size())) - 1;
+        return frametimes[std::min(index, frametimes.size() - 1)];
+    };
+    double mean = 0.0;
+    for (double frametime : frametimes) {
+        mean += frametime;
+    }
+    if (!frametimes.empty())
+        mean /= frametimes.size();
+
+    u64 program_id = 0;
+    system.GetAppLoader().ReadProgramId(program_id);
+    const double emulated_seconds = system.CoreTiming().GetGlobalTimeUs().count() / 1'000'000.0;
+
+    std::cout << fmt::format(
+                     "{{\"title_id\":\"{:016X}\",\"frames\":{},\"emulated_seconds\":{:.3f},"
+                     "\"host_seconds\":{:.3f},\"fps\":{:.2f},\"speed\":{:.4f},"
+                     "\"frametime_ms\":{{\"mean\":{:.3f},\"p50\":{:.3f},\"p90\":{:.3f},"
+                     "\"p99\":{:.3f},\"max\":{:.3f}}}}}",
+                     program_id, frametimes.size(), emulated_seconds, host_seconds,
+                     frametimes.size() / host_seconds, emulated_seconds / host_seconds, mean,
+                     percentile(0.5), percentile(0.9), percentile(0.99), percentile(1.0))
+              << std::endl;
+}
+
 static void InitializeLogging() {
     Log::Filter log_filter(Log::Level::Debug);
     log_filter.ParseFilterString(Settings::values.log_filter);
@@ -178,7 +230,11 @@ static void InitializeLogging() {
 
     const std::string& log_dir = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
     FileUtil::CreateFullPath(log_dir);
-    Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+    if (Settings::values.binary_log) {
+        Log::EnableBinaryLog(log_dir + BINARY_LOG_FILE);
+    } else {
+        Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+    }
 #ifdef _WIN32
     Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
 #endif
@@ -194,6 +250,13 @@ int main(int argc, char** argv) {
     std::string movie_record;
     std::string movie_play;
     std::string dump_video;
+    // Emulated time after which a benchmark run ends, zero when not benchmarking
+    std::chrono::microseconds benchmark_time{0};
+    std::string replay_hashes;
+    std::string replay_reference;
+    u32 replay_interval = 60;
+    std::string screenshot_prefix;
+    u32 screenshot_interval = 5000;
 
     InitializeLogging();
 
@@ -220,12 +283,18 @@ int main(int argc, char** argv) {
         {"gdbport", required_argument, 0, 'g'},     {"install", required_argument, 0, 'i'},
         {"multiplayer", required_argument, 0, 'm'}, {"movie-record", required_argument, 0, 'r'},
         {"movie-play", required_argument, 0, 'p'},  {"dump-video", required_argument, 0, 'd'},
+        {"benchmark", required_argument, 0, 'b'},   {"benchmark-time", required_argument, 0, 't'},
         {"fullscreen", no_argument, 0, 'f'},        {"help", no_argument, 0, 'h'},
-        {"version", no_argument, 0, 'v'},           {0, 0, 0, 0},
+        {"version", no_argument, 0, 'v'},           {"replay-hashes", required_argument, 0, 'H'},
+        {"replay-reference", required_argument, 0, 'R'},
+        {"replay-interval", required_argument, 0, 'I'},
+        {"screenshots", required_argument, 0, 'S'},
+        {"screenshot-interval", required_argument, 0, 'T'},
+        {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "g:i:m:r:p:fhv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "g:i:m:r:p:d:b:t:fhv", long_options, &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'g':
@@ -291,6 +360,49 @@ int main(int argc, char** argv) {
             case 'd':
                 dump_video = optarg;
                 break;
+            case 'b':
+            case 't': {
+                errno = 0;
+                const double value = strtod(optarg, &endarg);
+                if (endarg == optarg || value <= 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror(arg == 'b' ? "--benchmark" : "--benchmark-time");
+                    exit(1);
+                }
+                const double seconds = arg == 'b' ? value / GPU::SCREEN_REFRESH_RATE : value;
+                benchmark_time = std::chrono::microseconds(static_cast<s64>(seconds * 1'000'000));
+                break;
+            }
+            case 'H':
+                replay_hashes = optarg;
+                break;
+            case 'R':
+                replay_reference = optarg;
+                break;
+            case 'I':
+                errno = 0;
+                replay_interval = strtoul(optarg, &endarg, 0);
+                if (endarg == optarg || replay_interval == 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--replay-interval");
+                    exit(1);
+                }
+                break;
+            case 'S':
+                screenshot_prefix = optarg;
+                break;
+            case 'T':
+                errno = 0;
+                screenshot_interval = strtoul(optarg, &endarg, 0);
+                if (endarg == optarg || screenshot_interval == 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--screenshot-interval");
+                    exit(1);
+                }
+                break;
             case 'f':
                 fullscreen = true;
                 LOG_INFO(Frontend, "Starting in fullscreen mode...");
@@ -329,6 +441,12 @@ int main(int argc, char** argv) {
         return -1;
     }
 
+    const bool verify_replay = !replay_hashes.empty() || !replay_reference.empty();
+    if (verify_replay && movie_play.empty()) {
+        LOG_CRITICAL(Frontend, "Verifying a replay requires a movie to play");
+        return -1;
+    }
+
     if (!movie_record.empty()) {
         Core::Movie::GetInstance().PrepareForRecording();
     }
@@ -339,6 +457,20 @@ int main(int argc, char** argv) {
     // Apply the command line arguments
     Settings::values.gdbstub_port = gdb_port;
     Settings::values.use_gdbstub = use_gdbstub;
+    const bool benchmark = benchmark_time.count() != 0;
+    const bool headless = benchmark || verify_replay;
+    if (headless) {
+        Settings::values.use_frame_limit = false;
+        Settings::values.use_vsync_new = false;
+    }
+    if (verify_replay) {
+        // The software renderer at native resolution writes the same frames on every host, and
+        // turbo mode skips presenting almost all of them
+        Settings::values.use_hw_renderer = false;
+        Settings::values.resolution_factor = 1;
+        Settings::values.turbo_mode = true;
+        Settings::values.turbo_render_interval = 60;
+    }
     Settings::Apply();
 
     // Register frontend applets
@@ -347,7 +479,8 @@ int main(int argc, char** argv) {
     // Register generic image interface
     Core::System::GetInstance().RegisterImageInterface(std::make_shared<LodePNGImageInterface>());
 
-    std::unique_ptr<EmuWindow_SDL2> emu_window{std::make_unique<EmuWindow_SDL2>(fullscreen)};
+    std::unique_ptr<EmuWindow_SDL2> emu_window{
+        std::make_unique<EmuWindow_SDL2>(fullscreen && !headless, headless)};
     Frontend::ScopeAcquireContext scope(*emu_window);
     Core::System& system{Core::System::GetInstance()};
 
@@ -400,7 +533,13 @@ int main(int argc, char** argv) {
         }
     }
 
-    if (!movie_play.empty()) {
+    bool replay_done = false;
+    if (verify_replay) {
+        system.replay_verifier = std::make_unique<Core::ReplayVerifier>(
+            system, replay_hashes, replay_reference, replay_interval);
+        Core::Movie::GetInstance().StartPlayback(movie_play,
+                                                 [&replay_done] { replay_done = true; });
+    } else if (!movie_play.empty()) {
         Core::Movie::GetInstance().StartPlayback(movie_play);
     }
     if (!movie_record.empty()) {
@@ -411,6 +550,12 @@ int main(int argc, char** argv) {
             Layout::FrameLayoutFromResolutionScale(VideoCore::GetResolutionScaleFactor())};
         system.VideoDumper().StartDumping(dump_video, "webm", layout);
     }
+    if (!screenshot_prefix.empty()) {
+        VideoCore::StartScreenshotBurst(
+            screenshot_prefix,
+            Layout::FrameLayoutFromResolutionScale(VideoCore::GetResolutionScaleFactor()),
+            std::chrono::milliseconds(screenshot_interval));
+    }
 
     std::thread render_thread([&emu_window] { emu_window->Present(); });
 
@@ -421,18 +566,53 @@ int main(int argc, char** argv) {
                       total);
         });
 
+    const auto start_time = std::chrono::steady_clock::now();
     while (emu_window->IsOpen()) {
         system.RunLoop();
+        if (benchmark && system.CoreTiming().GetGlobalTimeUs() >= benchmark_time) {
+            emu_window->Close();
+        }
+        if (verify_replay && (replay_done || system.replay_verifier->GetDivergence())) {
+            emu_window->Close();
+        }
     }
     render_thread.join();
 
+    int exit_code = 0;
+    if (verify_replay) {
+        const Core::ReplayVerifier& verifier = *system.replay_verifier;
+        if (const auto& divergence = verifier.GetDivergence()) {
+            const Core::ReplayVerifier::Checkpoint& reference =
+                verifier.GetReferenceAtDivergence();
+            std::cout << fmt::format(
+                             "Replay diverged at frame {}: fcram {:016x}/{:016x} top {:016x}/"
+                             "{:016x} bottom {:016x}/{:016x} (this run/reference)",
+                             divergence->frame, divergence->fcram_hash, reference.fcram_hash,
+                             divergence->top_screen_hash, reference.top_screen_hash,
+                             divergence->bottom_screen_hash, reference.bottom_screen_hash)
+                      << std::endl;
+            exit_code = 1;
+        } else {
+            std::cout << fmt::format("Replay finished with {} checkpoints",
+                                     verifier.GetNumCheckpoints())
+                      << std::endl;
+        }
+    }
+
+    if (benchmark) {
+        const std::chrono::duration<double> host_time =
+            std::chrono::steady_clock::now() - start_time;
+        PrintBenchmarkResults(system, host_time.count());
+    }
+
     Core::Movie::GetInstance().Shutdown();
     if (system.VideoDumper().IsDumping()) {
         system.VideoDumper().StopDumping();
     }
+    VideoCore::StopScreenshotBurst();
 
     system.Shutdown();
 
     detached_tasks.WaitForAllTasks();
-    return 0;
+    return exit_code;
 }
@@ -0,0 +1,155 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include "citra/config.h"
+#include "citra/emu_window/emu_window_sdl2.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/frontend/scope_acquire_context.h"
+#include "core/settings.h"
+#include "core/tracer/player.h"
+
+#ifdef _WIN32
+extern "C" {
+// tells Nvidia drivers to use the dedicated GPU by default on laptops with switchable graphics
+__declspec(dllexport) unsigned long NvOptimusEnablement = 0x00000001;
+}
+#endif
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <citrace.ctf>\n"
+                 "Replays a CiTrace on the GPU, headless and unthrottled, then prints the frame\n"
+                 "times as JSON. The other settings are read from the configuration of citra.\n"
+                 "-r, --renderer=RENDERER  Replay with the \"hw\" or the \"sw\" renderer\n"
+                 "-l, --loops=COUNT        Replay the trace COUNT times, 1 by default\n"
+                 "-h, --help               Display this help and exit\n";
+}
+
+/// Prints the frame times of the replay as a single line of JSON, like citra --benchmark
+static void PrintResults(std::vector<double> frametimes, double host_seconds) {
+    std::sort(frametimes.begin(), frametimes.end());
+    const auto percentile = [&frametimes](double p) {
+        if (frametimes.empty())
+            return 0.0;
+        const auto index = static_cast<std::size_t>(std::ceil(p * frametimes.size())) - 1;
+        return frametimes[std::min(index, frametimes.size() - 1)];
+    };
+    double mean = 0.0;
+    for (double frametime : frametimes) {
+        mean += frametime;
+    }
+    if (!frametimes.empty())
+        mean /= frametimes.size();
+
+    std::cout << fmt::format("{{\"renderer\":\"{}\",\"frames\":{},\"host_seconds\":{:.3f},"
+                             "\"fps\":{:.2f},\"frametime_ms\":{{\"mean\":{:.3f},\"p50\":{:.3f},"
+                             "\"p90\":{:.3f},\"p99\":{:.3f},\"max\":{:.3f}}}}}",
+                             Settings::values.use_hw_renderer ? "hw" : "sw", frametimes.size(),
+                             host_seconds, frametimes.size() / host_seconds, mean,
+                             percentile(0.5), percentile(0.9), percentile(0.99), percentile(1.0))
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    Config config;
+    std::string filename;
+    u32 loops = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        std::string value;
+        if ((arg == "-r" || arg == "-l") && i + 1 < argc) {
+            value = argv[++i];
+        } else if (arg.rfind("--renderer=", 0) == 0 || arg.rfind("--loops=", 0) == 0) {
+            value = arg.substr(arg.find('=') + 1);
+        }
+
+        if (arg == "-h" || arg == "--help") {
+            PrintHelp(argv[0]);
+            return 0;
+        } else if ((arg == "-r" || arg.rfind("--renderer=", 0) == 0) &&
+                   (value == "hw" || value == "sw")) {
+            Settings::values.use_hw_renderer = value == "hw";
+        } else if ((arg == "-l" || arg.rfind("--loops=", 0) == 0) && !value.empty()) {
+            loops = static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (filename.empty() && arg[0] != '-') {
+            filename = arg;
+        } else {
+            PrintHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    if (filename.empty() || loops == 0) {
+        PrintHelp(argv[0]);
+        return 1;
+    }
+
+    Log::Filter log_filter(Log::Level::Info);
+    log_filter.ParseFilterString(Settings::values.log_filter);
+    // Traces don't set up the GSP shared memory, which would warn about every interrupt
+    log_filter.ParseFilterString("Service.GSP:Error");
+    Log::SetGlobalFilter(log_filter);
+    Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
+
+    // There is no CPU work to overlap the GPU thread with, and no application to cache data for
+    Settings::values.use_gpu_thread = false;
+    Settings::values.use_disk_shader_cache = false;
+    Settings::values.custom_textures = false;
+    Settings::values.preload_textures = false;
+    Settings::values.use_frame_limit = false;
+    Settings::values.use_vsync_new = false;
+    Settings::Apply();
+
+    std::unique_ptr<EmuWindow_SDL2> emu_window{std::make_unique<EmuWindow_SDL2>(false, true)};
+    Frontend::ScopeAcquireContext scope(*emu_window);
+    Core::System& system{Core::System::GetInstance()};
+    if (system.InitWithoutApplication(*emu_window) != Core::System::ResultStatus::Success) {
+        LOG_CRITICAL(Frontend, "Failed to initialize the emulated system");
+        return 1;
+    }
+
+    CiTrace::Player player(system.Memory());
+    if (!player.Load(filename) || player.GetNumFrames() == 0) {
+        std::cerr << filename << " is not a CiTrace with complete frames" << std::endl;
+        system.Shutdown();
+        return 1;
+    }
+
+    std::thread render_thread([&emu_window] { emu_window->Present(); });
+
+    std::vector<double> frametimes;
+    const auto start_time = std::chrono::steady_clock::now();
+    for (u32 loop = 0; loop < loops; ++loop) {
+        player.LoadInitialState();
+        for (std::size_t frame = 0; frame < player.GetNumFrames(); ++frame) {
+            const auto frame_start = std::chrono::steady_clock::now();
+            player.ReplayFrame(frame);
+            const std::chrono::duration<double, std::milli> frametime =
+                std::chrono::steady_clock::now() - frame_start;
+            frametimes.push_back(frametime.count());
+        }
+    }
+    const std::chrono::duration<double> host_time = std::chrono::steady_clock::now() - start_time;
+
+    emu_window->Close();
+    render_thread.join();
+
+    PrintResults(std::move(frametimes), host_time.count());
+
+    system.Shutdown();
+    return 0;
+}
@@ -104,6 +104,15 @@ void Config::ReadValues() {
 
     // Core
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
+    Settings::values.use_multicore_cpu =
+        sdl2_config->GetBoolean("Core", "use_multicore_cpu", false);
+    Settings::values.use_huge_pages = sdl2_config->GetBoolean("Core", "use_huge_pages", false);
+    Settings::values.enable_rewind = sdl2_config->GetBoolean("Core", "enable_rewind", false);
+    Settings::values.rewind_interval =
+        static_cast<u32>(sdl2_config->GetInteger("Core", "rewind_interval", 60));
+    Settings::values.rewind_memory_budget =
+        static_cast<u32>(sdl2_config->GetInteger("Core", "rewind_memory_budget", 1024));
+    Settings::values.use_auto_tuning = sdl2_config->GetBoolean("Core", "use_auto_tuning", false);
 
     // Renderer
     Settings::values.use_gles = sdl2_config->GetBoolean("Renderer", "use_gles", false);
@@ -119,15 +128,44 @@ void Config::ReadValues() {
     Settings::values.shaders_accurate_mul =
         sdl2_config->GetBoolean("Renderer", "shaders_accurate_mul", false);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.parallel_vertex_shading =
+        sdl2_config->GetBoolean("Renderer", "parallel_vertex_shading", false);
     Settings::values.resolution_factor =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "resolution_factor", 1));
+    Settings::values.dynamic_resolution =
+        sdl2_config->GetBoolean("Renderer", "dynamic_resolution", false);
+    Settings::values.dynamic_resolution_min =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "dynamic_resolution_min", 1));
+    Settings::values.surface_cache_budget =
+        static_cast<u32>(sdl2_config->GetInteger("Renderer", "surface_cache_budget", 0));
     Settings::values.use_frame_limit = sdl2_config->GetBoolean("Renderer", "use_frame_limit", true);
     Settings::values.use_disk_shader_cache =
         sdl2_config->GetBoolean("Renderer", "use_disk_shader_cache", true);
     Settings::values.frame_limit =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "frame_limit", 100));
+    Settings::values.turbo_mode = sdl2_config->GetBoolean("Renderer", "turbo_mode", false);
+    Settings::values.turbo_render_interval =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "turbo_render_interval", 8));
+    Settings::values.frame_skip =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "frame_skip", 0));
     Settings::values.use_vsync_new =
         static_cast<u16>(sdl2_config->GetInteger("Renderer", "use_vsync_new", 1));
+    Settings::values.present_queue_depth =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "present_queue_depth", 1));
+    Settings::values.low_latency_presentation =
+        sdl2_config->GetBoolean("Renderer", "low_latency_presentation", false);
+    Settings::values.use_gpu_thread =
+        sdl2_config->GetBoolean("Renderer", "use_gpu_thread", false);
+    Settings::values.async_shader_compilation =
+        sdl2_config->GetBoolean("Renderer", "async_shader_compilation", false);
+    Settings::values.use_uber_shader =
+        sdl2_config->GetBoolean("Renderer", "use_uber_shader", false);
+    Settings::values.gpu_texture_decoding =
+        sdl2_config->GetBoolean("Renderer", "gpu_texture_decoding", true);
+    Settings::values.texture_hash_check =
+        sdl2_config->GetBoolean("Renderer", "texture_hash_check", false);
+    Settings::values.texture_compression = static_cast<Settings::TextureCompression>(
+        sdl2_config->GetInteger("Renderer", "texture_compression", 0));
     Settings::values.texture_filter_name =
         sdl2_config->GetString("Renderer", "texture_filter_name", "none");
     Settings::values.texture_filter_factor =
@@ -179,14 +217,22 @@ void Config::ReadValues() {
     Settings::values.custom_textures = sdl2_config->GetBoolean("Utility", "custom_textures", false);
     Settings::values.preload_textures =
         sdl2_config->GetBoolean("Utility", "preload_textures", false);
+    Settings::values.async_custom_loading =
+        sdl2_config->GetBoolean("Utility", "async_custom_loading", true);
+    Settings::values.use_hw_video_encoder =
+        sdl2_config->GetBoolean("Utility", "use_hw_video_encoder", false);
 
     // Audio
     Settings::values.enable_dsp_lle = sdl2_config->GetBoolean("Audio", "enable_dsp_lle", false);
     Settings::values.enable_dsp_lle_multithread =
         sdl2_config->GetBoolean("Audio", "enable_dsp_lle_multithread", false);
+    Settings::values.enable_dsp_hle_multithread =
+        sdl2_config->GetBoolean("Audio", "enable_dsp_hle_multithread", false);
     Settings::values.sink_id = sdl2_config->GetString("Audio", "output_engine", "auto");
     Settings::values.enable_audio_stretching =
         sdl2_config->GetBoolean("Audio", "enable_audio_stretching", true);
+    Settings::values.audio_target_latency =
+        static_cast<u16>(sdl2_config->GetInteger("Audio", "target_latency", 0));
     Settings::values.audio_device_id = sdl2_config->GetString("Audio", "output_device", "auto");
     Settings::values.volume = static_cast<float>(sdl2_config->GetReal("Audio", "volume", 1));
     Settings::values.mic_input_device =
@@ -197,6 +243,10 @@ void Config::ReadValues() {
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.content_store_dir =
+        sdl2_config->GetString("Data Storage", "content_store_dir", "");
+    Settings::values.share_decrypted_romfs =
+        sdl2_config->GetBoolean("Data Storage", "share_decrypted_romfs", false);
 
     // System
     Settings::values.is_new_3ds = sdl2_config->GetBoolean("System", "is_new_3ds", false);
@@ -248,10 +298,14 @@ void Config::ReadValues() {
 
     // Miscellaneous
     Settings::values.log_filter = sdl2_config->GetString("Miscellaneous", "log_filter", "*:Info");
+    Settings::values.binary_log = sdl2_config->GetBoolean("Miscellaneous", "binary_log", false);
 
     // Debugging
     Settings::values.record_frame_times =
         sdl2_config->GetBoolean("Debugging", "record_frame_times", false);
+    Settings::values.metrics_file = sdl2_config->GetString("Debugging", "metrics_file", "");
+    Settings::values.metrics_port =
+        static_cast<u16>(sdl2_config->GetInteger("Debugging", "metrics_port", 0));
     Settings::values.use_gdbstub = sdl2_config->GetBoolean("Debugging", "use_gdbstub", false);
     Settings::values.gdbstub_port =
         static_cast<u16>(sdl2_config->GetInteger("Debugging", "gdbstub_port", 24689));
@@ -91,6 +91,35 @@ udp_pad_index=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Whether to run each emulated CPU core on its own host thread. Requires the JIT
+# and a build of dynarmic with a global exclusive monitor.
+# Experimental, may cause games to hang or crash.
+# 0 (default): All cores on the emulation thread, 1: One thread per core
+use_multicore_cpu =
+
+# Whether to back the emulated memory with 2MB huge pages, which speeds up memory accesses.
+# Falls back to normal pages if the system doesn't provide huge pages.
+# 0 (default): Normal pages, 1: Huge pages
+use_huge_pages =
+
+# Whether to keep snapshots of the emulated memory for rewinding.
+# Experimental, only the memory is restored so games may misbehave after rewinding.
+# 0 (default): Off, 1: On
+enable_rewind =
+
+# Number of frames between two rewind snapshots. Default: 60
+rewind_interval =
+
+# Memory used by the rewind snapshots in MiB before the oldest ones are merged. Default: 1024
+rewind_memory_budget =
+
+# Whether to pick the performance settings automatically. A short benchmark on the first boot
+# chooses the shader engine and the DSP emulation for the device, and the frame times of each title
+# lower its resolution and texture filter on the next boot while it runs below full speed.
+# Stored in perf_profile.ini in the config directory, the settings here are left unchanged.
+# 0 (default): Off, 1: On
+use_auto_tuning =
+
 [Renderer]
 # Whether to render using GLES or OpenGL
 # 0 (default): OpenGL, 1: GLES
@@ -112,11 +141,56 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Whether to run software vertex shaders of large draws on multiple threads. Faster, but a few
+# shaders that depend on state left over from the previous vertex may break.
+# 0 (default): Off, 1: On
+parallel_vertex_shading =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
 use_vsync_new =
 
+# Number of emulated frames that are queued for presentation. With 1 the newest frame is always
+# presented, higher values present every frame in order, which is smoother but adds latency.
+# 1 (default) - 3
+present_queue_depth =
+
+# Delays the start of each emulated frame so that it finishes just before the display refreshes,
+# which lowers the input latency. Needs VSync and the frame limiter.
+# 0 (default): Off, 1: On
+low_latency_presentation =
+
+# Processes GPU commands on a separate thread, so that it does not stall CPU emulation.
+# 0 (default): Off, 1: On
+use_gpu_thread =
+
+# Builds missing hardware shaders in the background instead of stalling the frame. Until a shader is
+# ready, draws using it fall back to the software vertex shader or the uber shader.
+# Requires separable shader programs. 0 (default): Off, 1: On
+async_shader_compilation =
+
+# Renders with a single fragment shader that interprets the PICA state at runtime, instead of
+# generating a shader for every configuration. Slower on the GPU, but never stalls on compilation.
+# Asynchronous shader compilation uses it while the specialised shaders are being built.
+# 0 (default): Off, 1: On
+use_uber_shader =
+
+# Decodes tiled textures in a fragment shader instead of on the CPU when they are loaded from
+# emulated memory. Disabled automatically while dumping, replacing or filtering textures.
+# 0: Off, 1 (default): On
+gpu_texture_decoding =
+
+# Skips reloading textures whose emulated memory was rewritten with the same data, at the cost of
+# hashing every texture when it is loaded.
+# 0 (default): Off, 1: On
+texture_hash_check =
+
+# Compresses upscaled and custom textures to BC1/BC3 on the GPU to save video memory. Requires
+# OpenGL 4.3 or ARB_copy_image and S3TC support, not available on OpenGL ES.
+# 0 (default): Off, 1: Fast, 2: High quality
+texture_compression =
+
 # Reduce stuttering by storing and loading generated shaders to disk
 # 0: Off, 1 (default. On)
 use_disk_shader_cache =
@@ -126,6 +200,19 @@ use_disk_shader_cache =
 # factor for the 3DS resolution
 resolution_factor =
 
+# Lowers the resolution of new render targets while the GPU can't keep up with the frame rate and
+# raises it back up to resolution_factor once it can. Needs OpenGL timer queries.
+# 0 (default): Off, 1: On
+dynamic_resolution =
+
+# Lowest resolution scale factor the dynamic resolution goes down to
+# 1 (default): Native 3DS screen resolution, Otherwise a scale factor for the 3DS resolution
+dynamic_resolution_min =
+
+# Video memory in MiB the cached surfaces may use before the least recently used ones are evicted.
+# Higher resolution factors need a larger budget. 0 (default): No limit
+surface_cache_budget =
+
 # Texture filter name and scale factor
 texture_filter_name =
 texture_filter_factor =
@@ -138,6 +225,19 @@ use_frame_limit =
 # 1 - 9999: Speed limit as a percentage of target game speed. 100 (default)
 frame_limit =
 
+# Runs the game as fast as possible with the audio muted, rendering only some of the frames
+# 0 (default): Off, 1: On
+turbo_mode =
+
+# One of this many frames is rendered while turbo mode is on
+# 1 - 60: Render interval in frames. 8 (default)
+turbo_render_interval =
+
+# Skips up to this many frames in a row while the game runs slower than the speed limit. Skipped
+# frames aren't drawn unless the game reads back what it renders.
+# 0 (default): Off, 1 - 4: Most consecutive skipped frames
+frame_skip =
+
 # The clear color for the renderer. What shows up on the sides of the bottom screen.
 # Must be in range of 0.0-1.0. Defaults to 0.0 for all.
 bg_red =
@@ -195,7 +295,7 @@ upright_screen =
 # 0 (default): Off, 1: On
 dump_textures =
 
-# Reads PNG files from load/textures/[Title ID]/ and replaces textures.
+# Reads PNG files and .ctp texture packs from load/textures/[Title ID]/ and replaces textures.
 # 0 (default): Off, 1: On
 custom_textures =
 
@@ -203,6 +303,15 @@ custom_textures =
 # 0 (default): Off, 1: On
 preload_textures =
 
+# Decodes custom textures that weren't preloaded in the background, showing the original texture
+# until they are ready.
+# 0: Off, 1 (default): On
+async_custom_loading =
+
+# Encodes dumped videos on the GPU through VAAPI or QSV when available, instead of with libvpx.
+# 0 (default): Off, 1: On
+use_hw_video_encoder =
+
 [Audio]
 # Whether or not to enable DSP LLE
 # 0 (default): No, 1: Yes
@@ -212,6 +321,10 @@ enable_dsp_lle =
 # 0 (default): No, 1: Yes
 enable_dsp_lle_thread =
 
+# Whether or not to generate DSP HLE audio frames on a different thread. The source statuses
+# then reach the application one audio frame later. Not used while a movie is played or recorded.
+# 0 (default): No, 1: Yes
+enable_dsp_hle_multithread =
 
 # Which audio output engine to use.
 # auto (default): Auto-select, null: No audio output, sdl2: SDL2 (if available)
@@ -219,10 +332,17 @@ output_engine =
 
 # Whether or not to enable the audio-stretching post-processing effect.
 # This effect adjusts audio speed to match emulation speed and helps prevent audio stutter,
-# at the cost of increasing audio latency.
+# at the cost of increasing audio latency. It is only applied while emulation runs slower or faster
+# than full speed, at full speed the audio is resampled to hold target_latency instead.
 # 0: No, 1 (default): Yes
 enable_audio_stretching =
 
+# Depth in milliseconds to keep the audio buffer at. The output is resampled by a fraction of a
+# percent to hold it there, which avoids crackle at low latency. With audio stretching enabled a
+# depth of 50 ms is used at full speed unless one is set here.
+# 0 (default): Don't manage the buffer depth, 40: Target 40 ms
+target_latency =
+
 # Which audio device to use.
 # auto (default): Auto-select
 output_device =
@@ -236,6 +356,16 @@ volume =
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Directory that installed title contents are deduplicated into through hard links. Titles
+# installed by several user directories on the same disk then share their contents.
+# Must be on the same file system as the user directory. Empty (default): Disabled
+content_store_dir =
+
+# Whether to decrypt the RomFS of encrypted games once into the cache directory and read it from
+# there. Instances of the same game then share the decrypted data through the OS file cache.
+# 0 (default): No, 1: Yes
+share_decrypted_romfs =
+
 [System]
 # The system model that Citra will try to emulate
 # 0: Old 3DS (default), 1: New 3DS
@@ -281,9 +411,20 @@ camera_inner_flip =
 # Examples: *:Debug Kernel.SVC:Trace Service.*:Critical
 log_filter = *:Info
 
+# Writes the log file in a compact binary format, which keeps verbose logging from slowing down the
+# emulation. It can be converted to text with citra-log-decoder.
+# 0 (default): Text log, 1: Binary log
+binary_log =
+
 [Debugging]
 # Record frame time data, can be found in the log directory. Boolean value
 record_frame_times =
+# Streams per-frame metrics (host time per component, draws, shader compiles, surface cache and
+# texture statistics) as CSV to the given file. Empty (default) to disable
+metrics_file =
+# Serves the cumulative metrics in the Prometheus text format on http://<host>:<port>/metrics.
+# Needs the web service. 0 (default) to disable
+metrics_port =
 # Port for listening to GDB connections.
 use_gdbstub=false
 gdbstub_port=24689
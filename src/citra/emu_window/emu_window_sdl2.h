@@ -29,7 +29,8 @@ private:
 
 class EmuWindow_SDL2 : public Frontend::EmuWindow {
 public:
-    explicit EmuWindow_SDL2(bool fullscreen);
+    /// A headless window is never shown and presents without vsync, for benchmarking
+    explicit EmuWindow_SDL2(bool fullscreen, bool headless = false);
     ~EmuWindow_SDL2();
 
     void Present();
@@ -46,6 +47,9 @@ public:
     /// Whether the window is still open, and a close request hasn't yet been sent
     bool IsOpen() const;
 
+    /// Closes the window as if the user had requested it
+    void Close();
+
     /// Creates a new context that is shared with the current context
     std::unique_ptr<GraphicsContext> CreateSharedContext() const override;
 
@@ -83,6 +87,9 @@ private:
     /// Is the window still open?
     bool is_open = true;
 
+    /// Whether the window is hidden and presents without vsync
+    bool headless;
+
     /// Internal SDL2 render window
     SDL_Window* render_window;
 
@@ -103,6 +103,19 @@ void EmuThread::run() {
 #endif
 }
 
+/// Runs the presentation loop of an OpenGLWindow
+class PresentThread final : public QThread {
+public:
+    explicit PresentThread(OpenGLWindow& window) : window(window) {}
+
+    void run() override {
+        window.PresentLoop();
+    }
+
+private:
+    OpenGLWindow& window;
+};
+
 OpenGLWindow::OpenGLWindow(QWindow* parent, QWidget* event_handler, QOpenGLContext* shared_context)
     : QWindow(parent), event_handler(event_handler),
       context(new QOpenGLContext(shared_context->parent())) {
@@ -124,19 +137,77 @@ OpenGLWindow::OpenGLWindow(QWindow* parent, QWidget* event_handler, QOpenGLConte
 }
 
 OpenGLWindow::~OpenGLWindow() {
+    StopPresenting();
     context->doneCurrent();
 }
 
 void OpenGLWindow::Present() {
-    if (!isExposed())
+    if (present_thread || !isExposed())
         return;
 
+    PresentFrame();
+    QWindow::requestUpdate();
+}
+
+void OpenGLWindow::PresentFrame() {
     context->makeCurrent(this);
     VideoCore::g_renderer->TryPresent(100);
     context->swapBuffers(this);
     auto f = context->versionFunctions<QOpenGLFunctions_3_3_Core>();
     f->glFinish();
-    QWindow::requestUpdate();
+}
+
+void OpenGLWindow::StartPresenting() {
+    if (present_thread || !QOpenGLContext::supportsThreadedOpenGL())
+        return;
+
+    {
+        std::lock_guard lock{present_mutex};
+        exposed = isExposed();
+        stop_presenting = false;
+    }
+    present_thread = std::make_unique<PresentThread>(*this);
+    // The context can only be made current on the thread it belongs to
+    context->doneCurrent();
+    context->moveToThread(present_thread.get());
+    present_thread->start(QThread::HighPriority);
+}
+
+void OpenGLWindow::StopPresenting() {
+    if (!present_thread)
+        return;
+
+    {
+        std::lock_guard lock{present_mutex};
+        stop_presenting = true;
+    }
+    present_cv.notify_one();
+    present_thread->wait();
+    present_thread.reset();
+}
+
+void OpenGLWindow::PresentLoop() {
+    Common::SetCurrentThreadName("PresentThread");
+    MicroProfileOnThreadCreate("PresentThread");
+
+    while (true) {
+        {
+            std::unique_lock lock{present_mutex};
+            present_cv.wait(lock, [this] { return stop_presenting || exposed; });
+            if (stop_presenting)
+                break;
+        }
+        // With vsync the swap paces this loop, otherwise the wait for a new frame in TryPresent
+        PresentFrame();
+    }
+
+    context->doneCurrent();
+    // Hand the context back to the GUI thread, which destroys it
+    context->moveToThread(qApp->thread());
+
+#if MICROPROFILE_ENABLED
+    MicroProfileOnThreadExit();
+#endif
 }
 
 bool OpenGLWindow::event(QEvent* event) {
@@ -182,7 +253,15 @@ bool OpenGLWindow::event(QEvent* event) {
 }
 
 void OpenGLWindow::exposeEvent(QExposeEvent* event) {
-    QWindow::requestUpdate();
+    if (present_thread) {
+        {
+            std::lock_guard lock{present_mutex};
+            exposed = isExposed();
+        }
+        present_cv.notify_one();
+    } else {
+        QWindow::requestUpdate();
+    }
     QWindow::exposeEvent(event);
 }
 
@@ -407,18 +486,16 @@ void GRenderWindow::CaptureScreenshot(u32 res_scale, const QString& screenshot_p
     if (res_scale == 0)
         res_scale = VideoCore::GetResolutionScaleFactor();
     const Layout::FramebufferLayout layout{Layout::FrameLayoutFromResolutionScale(res_scale)};
-    screenshot_image = QImage(QSize(layout.width, layout.height), QImage::Format_RGB32);
-    VideoCore::RequestScreenshot(
-        screenshot_image.bits(),
-        [=] {
-            const std::string std_screenshot_path = screenshot_path.toStdString();
-            if (screenshot_image.mirrored(false, true).save(screenshot_path)) {
+    const std::string std_screenshot_path = screenshot_path.toStdString();
+    // Saved on a worker thread, so that neither the renderer nor the UI waits for it
+    VideoCore::RequestAsyncScreenshot(
+        std_screenshot_path, layout, [std_screenshot_path](bool saved) {
+            if (saved) {
                 LOG_INFO(Frontend, "Screenshot saved to \"{}\"", std_screenshot_path);
             } else {
                 LOG_ERROR(Frontend, "Failed to save screenshot to \"{}\"", std_screenshot_path);
             }
-        },
-        layout);
+        });
 }
 
 void GRenderWindow::OnMinimalClientAreaChangeRequest(std::pair<u32, u32> minimal_size) {
@@ -427,9 +504,16 @@ void GRenderWindow::OnMinimalClientAreaChangeRequest(std::pair<u32, u32> minimal
 
 void GRenderWindow::OnEmulationStarting(EmuThread* emu_thread) {
     this->emu_thread = emu_thread;
+    if (child_window) {
+        child_window->StartPresenting();
+    }
 }
 
 void GRenderWindow::OnEmulationStopping() {
+    // Emitted before the emulation thread shuts the renderer down
+    if (child_window) {
+        child_window->StopPresenting();
+    }
     emu_thread = nullptr;
 }
 
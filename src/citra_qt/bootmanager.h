@@ -6,6 +6,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <QThread>
 #include <QWidget>
@@ -131,15 +132,39 @@ public:
 
     ~OpenGLWindow();
 
+    /// Presents a frame on the GUI thread, used when the platform can't present from another one
     void Present();
 
+    /**
+     * Moves the presentation to a dedicated thread if the platform supports it, so that stalls of
+     * the GUI event loop don't delay the frames. Otherwise frames keep being presented on the GUI
+     * thread whenever Qt delivers an update request.
+     */
+    void StartPresenting();
+
+    /// Stops the present thread, it must not outlive the renderer
+    void StopPresenting();
+
+    /// Body of the present thread, runs until StopPresenting is called
+    void PresentLoop();
+
 protected:
     bool event(QEvent* event) override;
     void exposeEvent(QExposeEvent* event) override;
 
 private:
+    /// Draws the latest frame of the renderer and swaps it to the window
+    void PresentFrame();
+
     QOpenGLContext* context;
     QWidget* event_handler;
+
+    std::unique_ptr<QThread> present_thread;
+    std::mutex present_mutex;
+    std::condition_variable present_cv;
+    /// Both written by the GUI thread and read by the present thread under present_mutex
+    bool exposed = false;
+    bool stop_presenting = false;
 };
 
 class GRenderWindow : public QWidget, public Frontend::EmuWindow {
@@ -212,7 +237,7 @@ private:
     QByteArray geometry;
 
     /// Native window handle that backs this presentation widget
-    QWindow* child_window = nullptr;
+    OpenGLWindow* child_window = nullptr;
 
     /// In order to embed the window into GRenderWindow, you need to use createWindowContainer to
     /// put the child_window into a widget then add it to the layout. This child_widget can be
@@ -221,8 +246,6 @@ private:
 
     EmuThread* emu_thread;
 
-    /// Temporary storage of the screenshot taken
-    QImage screenshot_image;
     bool first_frame = false;
 
 protected:
@@ -171,9 +171,7 @@ static constexpr int V(int r, int g, int b) {
 }
 } // namespace YuvTable
 
-std::vector<u16> Rgb2Yuv(const QImage& source, int width, int height) {
-    auto buffer = std::vector<u16>(width * height);
-    auto dest = buffer.begin();
+void Rgb2Yuv(u16* dest, const QImage& source, int width, int height) {
     bool write = false;
     int py, pu, pv;
     for (int y = 0; y < height; ++y) {
@@ -203,14 +201,14 @@ std::vector<u16> Rgb2Yuv(const QImage& source, int width, int height) {
             write = !write;
         }
     }
-    return buffer;
 }
 
-std::vector<u16> ProcessImage(const QImage& image, int width, int height, bool output_rgb = false,
-                              bool flip_horizontal = false, bool flip_vertical = false) {
-    std::vector<u16> buffer(width * height);
+void ProcessImage(std::vector<u16>& buffer, const QImage& image, int width, int height,
+                  bool output_rgb, bool flip_horizontal, bool flip_vertical) {
+    buffer.resize(width * height);
     if (image.isNull()) {
-        return buffer;
+        std::fill(buffer.begin(), buffer.end(), u16{0});
+        return;
     }
     QImage scaled =
         image.scaled(width, height, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
@@ -221,9 +219,8 @@ std::vector<u16> ProcessImage(const QImage& image, int width, int height, bool o
         QImage converted = transformed.convertToFormat(QImage::Format_RGB16);
         std::memcpy(buffer.data(), converted.bits(), width * height * sizeof(u16));
     } else {
-        return CameraUtil::Rgb2Yuv(transformed, width, height);
+        Rgb2Yuv(buffer.data(), transformed, width, height);
     }
-    return buffer;
 }
 
 } // namespace CameraUtil
@@ -11,11 +11,12 @@ class QImage;
 
 namespace CameraUtil {
 
-/// Converts QImage to a yuv formatted std::vector
-std::vector<u16> Rgb2Yuv(const QImage& source, int width, int height);
+/// Converts QImage to yuv, writing width * height pixels to dest
+void Rgb2Yuv(u16* dest, const QImage& source, int width, int height);
 
-/// Processes the QImage (resizing, flipping ...) and converts it to a std::vector
-std::vector<u16> ProcessImage(const QImage& source, int width, int height, bool output_rgb,
-                              bool flip_horizontal, bool flip_vertical);
+/// Processes the QImage (resizing, flipping ...) and converts it into buffer, which is resized to
+/// width * height pixels
+void ProcessImage(std::vector<u16>& buffer, const QImage& source, int width, int height,
+                  bool output_rgb, bool flip_horizontal, bool flip_vertical);
 
 } // namespace CameraUtil
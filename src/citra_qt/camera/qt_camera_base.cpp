@@ -35,9 +35,9 @@ void QtCameraInterface::SetEffect(Service::CAM::Effect effect) {
     }
 }
 
-std::vector<u16> QtCameraInterface::ReceiveFrame() {
-    return CameraUtil::ProcessImage(QtReceiveFrame(), width, height, output_rgb, flip_horizontal,
-                                    flip_vertical);
+void QtCameraInterface::ReceiveFrame(std::vector<u16>& frame) {
+    CameraUtil::ProcessImage(frame, QtReceiveFrame(), width, height, output_rgb, flip_horizontal,
+                             flip_vertical);
 }
 
 std::unique_ptr<CameraInterface> QtCameraFactory::CreatePreview(const std::string& config,
@@ -57,7 +57,7 @@ const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> Config:
 // This must be in alphabetical order according to action name as it must have the same order as
 // UISetting::values.shortcuts, which is alphabetically ordered.
 // clang-format off
-const std::array<UISettings::Shortcut, 21> default_hotkeys{
+const std::array<UISettings::Shortcut, 22> default_hotkeys{
     {{QStringLiteral("Advance Frame"),            QStringLiteral("Main Window"), {QStringLiteral("\\"), Qt::ApplicationShortcut}},
      {QStringLiteral("Capture Screenshot"),       QStringLiteral("Main Window"), {QStringLiteral("Ctrl+P"), Qt::ApplicationShortcut}},
      {QStringLiteral("Continue/Pause Emulation"), QStringLiteral("Main Window"), {QStringLiteral("F4"), Qt::WindowShortcut}},
@@ -78,7 +78,8 @@ const std::array<UISettings::Shortcut, 21> default_hotkeys{
      {QStringLiteral("Toggle Screen Layout"),     QStringLiteral("Main Window"), {QStringLiteral("F10"), Qt::WindowShortcut}},
      {QStringLiteral("Toggle Speed Limit"),       QStringLiteral("Main Window"), {QStringLiteral("Ctrl+Z"), Qt::ApplicationShortcut}},
      {QStringLiteral("Toggle Status Bar"),        QStringLiteral("Main Window"), {QStringLiteral("Ctrl+S"), Qt::WindowShortcut}},
-     {QStringLiteral("Toggle Texture Dumping"),   QStringLiteral("Main Window"), {QStringLiteral("Ctrl+D"), Qt::ApplicationShortcut}}}};
+     {QStringLiteral("Toggle Texture Dumping"),   QStringLiteral("Main Window"), {QStringLiteral("Ctrl+D"), Qt::ApplicationShortcut}},
+     {QStringLiteral("Toggle Turbo Mode"),        QStringLiteral("Main Window"), {QStringLiteral("Tab"), Qt::ApplicationShortcut}}}};
 // clang-format on
 
 void Config::ReadValues() {
@@ -103,11 +104,15 @@ void Config::ReadAudioValues() {
     Settings::values.enable_dsp_lle = ReadSetting(QStringLiteral("enable_dsp_lle"), false).toBool();
     Settings::values.enable_dsp_lle_multithread =
         ReadSetting(QStringLiteral("enable_dsp_lle_multithread"), false).toBool();
+    Settings::values.enable_dsp_hle_multithread =
+        ReadSetting(QStringLiteral("enable_dsp_hle_multithread"), false).toBool();
     Settings::values.sink_id = ReadSetting(QStringLiteral("output_engine"), QStringLiteral("auto"))
                                    .toString()
                                    .toStdString();
     Settings::values.enable_audio_stretching =
         ReadSetting(QStringLiteral("enable_audio_stretching"), true).toBool();
+    Settings::values.audio_target_latency =
+        static_cast<u16>(ReadSetting(QStringLiteral("target_latency"), 0).toUInt());
     Settings::values.audio_device_id =
         ReadSetting(QStringLiteral("output_device"), QStringLiteral("auto"))
             .toString()
@@ -243,6 +248,10 @@ void Config::ReadUtilityValues() {
         ReadSetting(QStringLiteral("custom_textures"), false).toBool();
     Settings::values.preload_textures =
         ReadSetting(QStringLiteral("preload_textures"), false).toBool();
+    Settings::values.async_custom_loading =
+        ReadSetting(QStringLiteral("async_custom_loading"), true).toBool();
+    Settings::values.use_hw_video_encoder =
+        ReadSetting(QStringLiteral("use_hw_video_encoder"), false).toBool();
     Settings::values.use_disk_shader_cache =
         ReadSetting(QStringLiteral("use_disk_shader_cache"), true).toBool();
 
@@ -253,6 +262,15 @@ void Config::ReadCoreValues() {
     qt_config->beginGroup(QStringLiteral("Core"));
 
     Settings::values.use_cpu_jit = ReadSetting(QStringLiteral("use_cpu_jit"), true).toBool();
+    Settings::values.use_multicore_cpu =
+        ReadSetting(QStringLiteral("use_multicore_cpu"), false).toBool();
+    Settings::values.use_huge_pages = ReadSetting(QStringLiteral("use_huge_pages"), false).toBool();
+    Settings::values.enable_rewind = ReadSetting(QStringLiteral("enable_rewind"), false).toBool();
+    Settings::values.rewind_interval = ReadSetting(QStringLiteral("rewind_interval"), 60).toUInt();
+    Settings::values.rewind_memory_budget =
+        ReadSetting(QStringLiteral("rewind_memory_budget"), 1024).toUInt();
+    Settings::values.use_auto_tuning =
+        ReadSetting(QStringLiteral("use_auto_tuning"), false).toBool();
 
     qt_config->endGroup();
 }
@@ -261,6 +279,10 @@ void Config::ReadDataStorageValues() {
     qt_config->beginGroup(QStringLiteral("Data Storage"));
 
     Settings::values.use_virtual_sd = ReadSetting(QStringLiteral("use_virtual_sd"), true).toBool();
+    Settings::values.content_store_dir =
+        ReadSetting(QStringLiteral("content_store_dir"), QString{}).toString().toStdString();
+    Settings::values.share_decrypted_romfs =
+        ReadSetting(QStringLiteral("share_decrypted_romfs"), false).toBool();
 
     qt_config->endGroup();
 }
@@ -271,6 +293,10 @@ void Config::ReadDebuggingValues() {
     // Intentionally not using the QT default setting as this is intended to be changed in the ini
     Settings::values.record_frame_times =
         qt_config->value(QStringLiteral("record_frame_times"), false).toBool();
+    Settings::values.metrics_file =
+        qt_config->value(QStringLiteral("metrics_file"), QString{}).toString().toStdString();
+    Settings::values.metrics_port =
+        static_cast<u16>(qt_config->value(QStringLiteral("metrics_port"), 0).toInt());
     Settings::values.use_gdbstub = ReadSetting(QStringLiteral("use_gdbstub"), false).toBool();
     Settings::values.gdbstub_port = ReadSetting(QStringLiteral("gdbstub_port"), 24689).toInt();
 
@@ -328,6 +354,7 @@ void Config::ReadMiscellaneousValues() {
         ReadSetting(QStringLiteral("log_filter"), QStringLiteral("*:Info"))
             .toString()
             .toStdString();
+    Settings::values.binary_log = ReadSetting(QStringLiteral("binary_log"), false).toBool();
 
     qt_config->endGroup();
 }
@@ -437,12 +464,41 @@ void Config::ReadRendererValues() {
     Settings::values.shaders_accurate_mul =
         ReadSetting(QStringLiteral("shaders_accurate_mul"), false).toBool();
     Settings::values.use_shader_jit = ReadSetting(QStringLiteral("use_shader_jit"), true).toBool();
+    Settings::values.parallel_vertex_shading =
+        ReadSetting(QStringLiteral("parallel_vertex_shading"), false).toBool();
     Settings::values.use_vsync_new = ReadSetting(QStringLiteral("use_vsync_new"), true).toBool();
+    Settings::values.present_queue_depth =
+        static_cast<u16>(ReadSetting(QStringLiteral("present_queue_depth"), 1).toInt());
+    Settings::values.low_latency_presentation =
+        ReadSetting(QStringLiteral("low_latency_presentation"), false).toBool();
+    Settings::values.use_gpu_thread =
+        ReadSetting(QStringLiteral("use_gpu_thread"), false).toBool();
+    Settings::values.async_shader_compilation =
+        ReadSetting(QStringLiteral("async_shader_compilation"), false).toBool();
+    Settings::values.use_uber_shader =
+        ReadSetting(QStringLiteral("use_uber_shader"), false).toBool();
+    Settings::values.gpu_texture_decoding =
+        ReadSetting(QStringLiteral("gpu_texture_decoding"), true).toBool();
+    Settings::values.texture_hash_check =
+        ReadSetting(QStringLiteral("texture_hash_check"), false).toBool();
+    Settings::values.texture_compression = static_cast<Settings::TextureCompression>(
+        ReadSetting(QStringLiteral("texture_compression"), 0).toInt());
     Settings::values.resolution_factor =
         static_cast<u16>(ReadSetting(QStringLiteral("resolution_factor"), 1).toInt());
+    Settings::values.dynamic_resolution =
+        ReadSetting(QStringLiteral("dynamic_resolution"), false).toBool();
+    Settings::values.dynamic_resolution_min =
+        static_cast<u16>(ReadSetting(QStringLiteral("dynamic_resolution_min"), 1).toInt());
+    Settings::values.surface_cache_budget =
+        ReadSetting(QStringLiteral("surface_cache_budget"), 0).toUInt();
     Settings::values.use_frame_limit =
         ReadSetting(QStringLiteral("use_frame_limit"), true).toBool();
     Settings::values.frame_limit = ReadSetting(QStringLiteral("frame_limit"), 100).toInt();
+    Settings::values.turbo_mode = false;
+    Settings::values.turbo_render_interval =
+        static_cast<u16>(ReadSetting(QStringLiteral("turbo_render_interval"), 8).toInt());
+    Settings::values.frame_skip =
+        static_cast<u16>(ReadSetting(QStringLiteral("frame_skip"), 0).toInt());
 
     Settings::values.bg_red = ReadSetting(QStringLiteral("bg_red"), 0.0).toFloat();
     Settings::values.bg_green = ReadSetting(QStringLiteral("bg_green"), 0.0).toFloat();
@@ -634,10 +690,13 @@ void Config::SaveAudioValues() {
     WriteSetting(QStringLiteral("enable_dsp_lle"), Settings::values.enable_dsp_lle, false);
     WriteSetting(QStringLiteral("enable_dsp_lle_multithread"),
                  Settings::values.enable_dsp_lle_multithread, false);
+    WriteSetting(QStringLiteral("enable_dsp_hle_multithread"),
+                 Settings::values.enable_dsp_hle_multithread, false);
     WriteSetting(QStringLiteral("output_engine"), QString::fromStdString(Settings::values.sink_id),
                  QStringLiteral("auto"));
     WriteSetting(QStringLiteral("enable_audio_stretching"),
                  Settings::values.enable_audio_stretching, true);
+    WriteSetting(QStringLiteral("target_latency"), Settings::values.audio_target_latency, 0);
     WriteSetting(QStringLiteral("output_device"),
                  QString::fromStdString(Settings::values.audio_device_id), QStringLiteral("auto"));
     WriteSetting(QStringLiteral("volume"), Settings::values.volume, 1.0f);
@@ -727,6 +786,10 @@ void Config::SaveUtilityValues() {
     WriteSetting(QStringLiteral("dump_textures"), Settings::values.dump_textures, false);
     WriteSetting(QStringLiteral("custom_textures"), Settings::values.custom_textures, false);
     WriteSetting(QStringLiteral("preload_textures"), Settings::values.preload_textures, false);
+    WriteSetting(QStringLiteral("async_custom_loading"), Settings::values.async_custom_loading,
+                 true);
+    WriteSetting(QStringLiteral("use_hw_video_encoder"), Settings::values.use_hw_video_encoder,
+                 false);
     WriteSetting(QStringLiteral("use_disk_shader_cache"), Settings::values.use_disk_shader_cache,
                  true);
 
@@ -737,6 +800,13 @@ void Config::SaveCoreValues() {
     qt_config->beginGroup(QStringLiteral("Core"));
 
     WriteSetting(QStringLiteral("use_cpu_jit"), Settings::values.use_cpu_jit, true);
+    WriteSetting(QStringLiteral("use_multicore_cpu"), Settings::values.use_multicore_cpu, false);
+    WriteSetting(QStringLiteral("use_huge_pages"), Settings::values.use_huge_pages, false);
+    WriteSetting(QStringLiteral("enable_rewind"), Settings::values.enable_rewind, false);
+    WriteSetting(QStringLiteral("rewind_interval"), Settings::values.rewind_interval, 60);
+    WriteSetting(QStringLiteral("rewind_memory_budget"), Settings::values.rewind_memory_budget,
+                 1024);
+    WriteSetting(QStringLiteral("use_auto_tuning"), Settings::values.use_auto_tuning, false);
 
     qt_config->endGroup();
 }
@@ -745,6 +815,10 @@ void Config::SaveDataStorageValues() {
     qt_config->beginGroup(QStringLiteral("Data Storage"));
 
     WriteSetting(QStringLiteral("use_virtual_sd"), Settings::values.use_virtual_sd, true);
+    WriteSetting(QStringLiteral("content_store_dir"),
+                 QString::fromStdString(Settings::values.content_store_dir), QString{});
+    WriteSetting(QStringLiteral("share_decrypted_romfs"), Settings::values.share_decrypted_romfs,
+                 false);
 
     qt_config->endGroup();
 }
@@ -754,6 +828,9 @@ void Config::SaveDebuggingValues() {
 
     // Intentionally not using the QT default setting as this is intended to be changed in the ini
     qt_config->setValue(QStringLiteral("record_frame_times"), Settings::values.record_frame_times);
+    qt_config->setValue(QStringLiteral("metrics_file"),
+                        QString::fromStdString(Settings::values.metrics_file));
+    qt_config->setValue(QStringLiteral("metrics_port"), Settings::values.metrics_port);
     WriteSetting(QStringLiteral("use_gdbstub"), Settings::values.use_gdbstub, false);
     WriteSetting(QStringLiteral("gdbstub_port"), Settings::values.gdbstub_port, 24689);
 
@@ -799,6 +876,7 @@ void Config::SaveMiscellaneousValues() {
 
     WriteSetting(QStringLiteral("log_filter"), QString::fromStdString(Settings::values.log_filter),
                  QStringLiteral("*:Info"));
+    WriteSetting(QStringLiteral("binary_log"), Settings::values.binary_log, false);
 
     qt_config->endGroup();
 }
@@ -876,10 +954,31 @@ void Config::SaveRendererValues() {
     WriteSetting(QStringLiteral("shaders_accurate_mul"), Settings::values.shaders_accurate_mul,
                  false);
     WriteSetting(QStringLiteral("use_shader_jit"), Settings::values.use_shader_jit, true);
+    WriteSetting(QStringLiteral("parallel_vertex_shading"),
+                 Settings::values.parallel_vertex_shading, false);
     WriteSetting(QStringLiteral("use_vsync_new"), Settings::values.use_vsync_new, true);
+    WriteSetting(QStringLiteral("present_queue_depth"), Settings::values.present_queue_depth, 1);
+    WriteSetting(QStringLiteral("low_latency_presentation"),
+                 Settings::values.low_latency_presentation, false);
+    WriteSetting(QStringLiteral("use_gpu_thread"), Settings::values.use_gpu_thread, false);
+    WriteSetting(QStringLiteral("async_shader_compilation"),
+                 Settings::values.async_shader_compilation, false);
+    WriteSetting(QStringLiteral("use_uber_shader"), Settings::values.use_uber_shader, false);
+    WriteSetting(QStringLiteral("gpu_texture_decoding"), Settings::values.gpu_texture_decoding,
+                 true);
+    WriteSetting(QStringLiteral("texture_hash_check"), Settings::values.texture_hash_check, false);
+    WriteSetting(QStringLiteral("texture_compression"),
+                 static_cast<int>(Settings::values.texture_compression), 0);
     WriteSetting(QStringLiteral("resolution_factor"), Settings::values.resolution_factor, 1);
+    WriteSetting(QStringLiteral("dynamic_resolution"), Settings::values.dynamic_resolution, false);
+    WriteSetting(QStringLiteral("dynamic_resolution_min"), Settings::values.dynamic_resolution_min,
+                 1);
+    WriteSetting(QStringLiteral("surface_cache_budget"), Settings::values.surface_cache_budget, 0);
     WriteSetting(QStringLiteral("use_frame_limit"), Settings::values.use_frame_limit, true);
     WriteSetting(QStringLiteral("frame_limit"), Settings::values.frame_limit, 100);
+    WriteSetting(QStringLiteral("turbo_render_interval"), Settings::values.turbo_render_interval,
+                 8);
+    WriteSetting(QStringLiteral("frame_skip"), Settings::values.frame_skip, 0);
 
     // Cast to double because Qt's written float values are not human-readable
     WriteSetting(QStringLiteral("bg_red"), (double)Settings::values.bg_red, 0.0);
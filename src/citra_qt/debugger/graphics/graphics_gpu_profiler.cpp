@@ -0,0 +1,109 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <iterator>
+#include <QBoxLayout>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include "citra_qt/debugger/graphics/graphics_gpu_profiler.h"
+#include "video_core/renderer_opengl/gl_gpu_profiler.h"
+
+namespace {
+constexpr int UPDATE_INTERVAL_MS = 500;
+
+constexpr const char* PASS_NAMES[] = {
+    QT_TRANSLATE_NOOP("GraphicsGPUProfilerWidget", "Draws"),
+    QT_TRANSLATE_NOOP("GraphicsGPUProfilerWidget", "Texture Uploads"),
+    QT_TRANSLATE_NOOP("GraphicsGPUProfilerWidget", "Texture Downloads"),
+    QT_TRANSLATE_NOOP("GraphicsGPUProfilerWidget", "Texture Filtering"),
+    QT_TRANSLATE_NOOP("GraphicsGPUProfilerWidget", "Presentation"),
+};
+static_assert(std::size(PASS_NAMES) == OpenGL::GPUProfiler::NUM_PASSES);
+
+void AddEntry(QTreeWidgetItem* parent, const QString& name,
+              const OpenGL::GPUProfiler::Entry& entry, u64 frames) {
+    const double total_ms = entry.time / 1000000.0;
+    const double frame_ms = frames != 0 ? total_ms / frames : 0.0;
+    auto* item = new QTreeWidgetItem(parent);
+    item->setText(0, name);
+    item->setText(1, QString::number(total_ms, 'f', 3));
+    item->setText(2, QString::number(frame_ms, 'f', 3));
+    item->setText(3, QString::number(entry.count));
+}
+} // Anonymous namespace
+
+GraphicsGPUProfilerWidget::GraphicsGPUProfilerWidget(QWidget* parent)
+    : QDockWidget(tr("GPU Profiler"), parent) {
+    setObjectName(QStringLiteral("GraphicsGPUProfilerWidget"));
+
+    enable_checkbox = new QCheckBox(tr("Enable"));
+    enable_checkbox->setChecked(OpenGL::GPUProfiler::GetInstance().IsEnabled());
+    connect(enable_checkbox, &QCheckBox::toggled, this,
+            [](bool checked) { OpenGL::GPUProfiler::GetInstance().SetEnabled(checked); });
+
+    auto* reset_button = new QPushButton(tr("Reset"));
+    connect(reset_button, &QPushButton::clicked, this, &GraphicsGPUProfilerWidget::Reset);
+
+    tree = new QTreeWidget;
+    tree->setColumnCount(4);
+    tree->setHeaderLabels({tr("Name"), tr("Total (ms)"), tr("Per Frame (ms)"), tr("Count")});
+
+    auto* main_widget = new QWidget;
+    auto* main_layout = new QVBoxLayout;
+    {
+        auto* sub_layout = new QHBoxLayout;
+        sub_layout->addWidget(enable_checkbox);
+        sub_layout->addStretch();
+        sub_layout->addWidget(reset_button);
+        main_layout->addLayout(sub_layout);
+    }
+    main_layout->addWidget(tree);
+    main_widget->setLayout(main_layout);
+    setWidget(main_widget);
+
+    connect(&update_timer, &QTimer::timeout, this, &GraphicsGPUProfilerWidget::Refresh);
+}
+
+void GraphicsGPUProfilerWidget::showEvent(QShowEvent* ev) {
+    update_timer.start(UPDATE_INTERVAL_MS);
+    Refresh();
+    QDockWidget::showEvent(ev);
+}
+
+void GraphicsGPUProfilerWidget::hideEvent(QHideEvent* ev) {
+    update_timer.stop();
+    QDockWidget::hideEvent(ev);
+}
+
+void GraphicsGPUProfilerWidget::Refresh() {
+    const OpenGL::GPUProfiler::Report report = OpenGL::GPUProfiler::GetInstance().GetReport();
+
+    tree->clear();
+    auto* passes = new QTreeWidgetItem(tree, {tr("Passes")});
+    for (std::size_t i = 0; i < report.passes.size(); ++i) {
+        AddEntry(passes, tr(PASS_NAMES[i]), report.passes[i], report.frames);
+    }
+
+    auto* shaders = new QTreeWidgetItem(tree, {tr("Fragment Shaders")});
+    for (const auto& [hash, entry] : report.shaders) {
+        AddEntry(shaders, QStringLiteral("%1").arg(hash, 16, 16, QLatin1Char('0')), entry,
+                 report.frames);
+    }
+
+    auto* framebuffers = new QTreeWidgetItem(tree, {tr("Framebuffers")});
+    for (const auto& [address, entry] : report.framebuffers) {
+        AddEntry(framebuffers, QStringLiteral("0x%1").arg(address, 8, 16, QLatin1Char('0')),
+                 entry, report.frames);
+    }
+
+    passes->setExpanded(true);
+    shaders->setExpanded(true);
+    framebuffers->setExpanded(true);
+}
+
+void GraphicsGPUProfilerWidget::Reset() {
+    OpenGL::GPUProfiler::GetInstance().ResetReport();
+    Refresh();
+}
@@ -0,0 +1,32 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <QDockWidget>
+#include <QTimer>
+
+class QCheckBox;
+class QTreeWidget;
+
+/// Shows the GPU time of the renderer's passes, fragment shaders and framebuffers
+class GraphicsGPUProfilerWidget : public QDockWidget {
+    Q_OBJECT
+
+public:
+    explicit GraphicsGPUProfilerWidget(QWidget* parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent* ev) override;
+    void hideEvent(QHideEvent* ev) override;
+
+private:
+    void Refresh();
+    void Reset();
+
+    QCheckBox* enable_checkbox;
+    QTreeWidget* tree;
+    /// Refreshes the times periodically, only runs while the widget is visible
+    QTimer update_timer;
+};
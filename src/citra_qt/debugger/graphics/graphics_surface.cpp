@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <vector>
 #include <QBoxLayout>
 #include <QComboBox>
 #include <QDebug>
@@ -12,9 +13,12 @@
 #include <QPushButton>
 #include <QScrollArea>
 #include <QSpinBox>
+#include <QtConcurrent/QtConcurrentRun>
 #include "citra_qt/debugger/graphics/graphics_surface.h"
 #include "citra_qt/util/spinbox.h"
+#include "common/alignment.h"
 #include "common/color.h"
+#include "common/hash.h"
 #include "core/core.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
@@ -24,6 +28,17 @@
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
 
+namespace {
+/// What a surface image is decoded from
+struct SurfaceKey {
+    u32 address;
+    u32 width;
+    u32 height;
+    u32 format;
+    u64 data_hash;
+};
+} // Anonymous namespace
+
 SurfacePicture::SurfacePicture(QWidget* parent, GraphicsSurfaceWidget* surface_widget_)
     : QLabel(parent), surface_widget(surface_widget_) {}
 
@@ -140,6 +155,8 @@ GraphicsSurfaceWidget::GraphicsSurfaceWidget(std::shared_ptr<Pica::DebugContext>
     connect(surface_picker_y_control, qOverload<int>(&QSpinBox::valueChanged), this,
             &GraphicsSurfaceWidget::OnSurfacePickerYChanged);
     connect(save_surface, &QPushButton::clicked, this, &GraphicsSurfaceWidget::SaveSurface);
+    connect(&decode_watcher, &QFutureWatcher<DecodeResult>::finished, this,
+            &GraphicsSurfaceWidget::OnDecodeFinished);
 
     auto main_widget = new QWidget;
     auto main_layout = new QVBoxLayout;
@@ -211,6 +228,10 @@ GraphicsSurfaceWidget::GraphicsSurfaceWidget(std::shared_ptr<Pica::DebugContext>
     }
 }
 
+GraphicsSurfaceWidget::~GraphicsSurfaceWidget() {
+    decode_watcher.waitForFinished();
+}
+
 void GraphicsSurfaceWidget::OnBreakPointHit(Pica::DebugContext::Event event, void* data) {
     emit Update();
     widget()->setEnabled(true);
@@ -418,8 +439,6 @@ void GraphicsSurfaceWidget::Pick(int x, int y) {
 }
 
 void GraphicsSurfaceWidget::OnUpdate() {
-    QPixmap pixmap;
-
     switch (surface_source) {
     case Source::ColorBuffer: {
         // TODO: Store a reference to the registers in the debug context instead of accessing them
@@ -552,12 +571,10 @@ void GraphicsSurfaceWidget::OnUpdate() {
     surface_height_control->setValue(surface_height);
     surface_format_control->setCurrentIndex(static_cast<int>(surface_format));
 
-    // TODO: Implement a good way to visualize alpha components!
-
-    QImage decoded_image(surface_width, surface_height, QImage::Format_ARGB32);
-    u8* buffer = Core::System::GetInstance().Memory().GetPhysicalPointer(surface_address);
+    const u8* buffer = Core::System::GetInstance().Memory().GetPhysicalPointer(surface_address);
 
     if (buffer == nullptr) {
+        decoded_hash = 0;
         surface_picture_label->hide();
         surface_info_label->setText(tr("(invalid surface address)"));
         surface_info_label->setAlignment(Qt::AlignCenter);
@@ -568,6 +585,7 @@ void GraphicsSurfaceWidget::OnUpdate() {
     }
 
     if (surface_format == Format::Unknown) {
+        decoded_hash = 0;
         surface_picture_label->hide();
         surface_info_label->setText(tr("(unknown surface format)"));
         surface_info_label->setAlignment(Qt::AlignCenter);
@@ -579,76 +597,37 @@ void GraphicsSurfaceWidget::OnUpdate() {
 
     surface_picture_label->show();
 
-    if (surface_format <= Format::MaxTextureFormat) {
-        // Generate a virtual texture
-        Pica::Texture::TextureInfo info;
-        info.physical_address = surface_address;
-        info.width = surface_width;
-        info.height = surface_height;
-        info.format = static_cast<Pica::TexturingRegs::TextureFormat>(surface_format);
-        info.SetDefaultStride();
-
-        for (unsigned int y = 0; y < surface_height; ++y) {
-            for (unsigned int x = 0; x < surface_width; ++x) {
-                Common::Vec4<u8> color = Pica::Texture::LookupTexture(buffer, x, y, info, true);
-                decoded_image.setPixel(x, y, qRgba(color.r(), color.g(), color.b(), color.a()));
-            }
-        }
-    } else {
-        // We handle depth formats here because DebugUtils only supports TextureFormats
-
-        // TODO(yuriks): Convert to newer tile-based addressing
-        unsigned nibbles_per_pixel = GraphicsSurfaceWidget::NibblesPerPixel(surface_format);
-        unsigned stride = nibbles_per_pixel * surface_width / 2;
-
-        ASSERT_MSG(nibbles_per_pixel >= 2,
-                   "Depth decoder only supports formats with at least one byte per pixel");
-        unsigned bytes_per_pixel = nibbles_per_pixel / 2;
-
-        for (unsigned int y = 0; y < surface_height; ++y) {
-            for (unsigned int x = 0; x < surface_width; ++x) {
-                const u32 coarse_y = y & ~7;
-                u32 offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * stride;
-                const u8* pixel = buffer + offset;
-                Common::Vec4<u8> color = {0, 0, 0, 0};
-
-                switch (surface_format) {
-                case Format::D16: {
-                    u32 data = Color::DecodeD16(pixel);
-                    color.r() = data & 0xFF;
-                    color.g() = (data >> 8) & 0xFF;
-                    break;
-                }
-                case Format::D24: {
-                    u32 data = Color::DecodeD24(pixel);
-                    color.r() = data & 0xFF;
-                    color.g() = (data >> 8) & 0xFF;
-                    color.b() = (data >> 16) & 0xFF;
-                    break;
-                }
-                case Format::D24X8: {
-                    Common::Vec2<u32> data = Color::DecodeD24S8(pixel);
-                    color.r() = data.x & 0xFF;
-                    color.g() = (data.x >> 8) & 0xFF;
-                    color.b() = (data.x >> 16) & 0xFF;
-                    break;
-                }
-                case Format::X24S8: {
-                    Common::Vec2<u32> data = Color::DecodeD24S8(pixel);
-                    color.r() = color.g() = color.b() = data.y;
-                    break;
-                }
-                default:
-                    qDebug() << "Unknown surface format " << static_cast<int>(surface_format);
-                    break;
-                }
+    // Textures are laid out in 8x8 tiles, partial tiles at the edges are still read in full
+    const std::size_t pixels =
+        std::size_t{Common::AlignUp(surface_width, 8)} * Common::AlignUp(surface_height, 8);
+    const std::size_t size = pixels * NibblesPerPixel(surface_format) / 2;
+    const SurfaceKey key{surface_address, surface_width, surface_height,
+                         static_cast<u32>(surface_format), Common::ComputeFastHash64(buffer, size)};
+    const u64 hash = Common::ComputeStructHash64(key);
+    if (hash == decoded_hash) {
+        // The shown or pending image is still up to date
+        return;
+    }
+    decoded_hash = hash;
+
+    // The decoding works on a copy, since emulation may write to the memory again once it resumes.
+    // The image isn't saved while it is out of date.
+    save_surface->setEnabled(false);
+    decode_watcher.setFuture(QtConcurrent::run(
+        [hash, data = std::vector<u8>(buffer, buffer + size), width = surface_width,
+         height = surface_height, format = surface_format] {
+            return DecodeResult{hash, DecodeSurface(data, width, height, format)};
+        }));
+}
 
-                decoded_image.setPixel(x, y, qRgba(color.r(), color.g(), color.b(), 255));
-            }
-        }
+void GraphicsSurfaceWidget::OnDecodeFinished() {
+    const DecodeResult result = decode_watcher.result();
+    if (result.hash != decoded_hash) {
+        // The surface changed while decoding, a newer image is on its way
+        return;
     }
 
-    pixmap = QPixmap::fromImage(decoded_image);
+    const QPixmap pixmap = QPixmap::fromImage(result.image);
     surface_picture_label->setPixmap(pixmap);
     surface_picture_label->resize(pixmap.size());
 
@@ -661,6 +640,100 @@ void GraphicsSurfaceWidget::OnUpdate() {
     save_surface->setEnabled(true);
 }
 
+QImage GraphicsSurfaceWidget::DecodeSurface(const std::vector<u8>& data, unsigned width,
+                                            unsigned height, Format format) {
+    // TODO: Implement a good way to visualize alpha components!
+
+    QImage decoded_image(width, height, QImage::Format_ARGB32);
+    const u8* buffer = data.data();
+
+    if (format <= Format::MaxTextureFormat) {
+        // Generate a virtual texture
+        Pica::Texture::TextureInfo info;
+        info.physical_address = 0;
+        info.width = width;
+        info.height = height;
+        info.format = static_cast<Pica::TexturingRegs::TextureFormat>(format);
+        info.SetDefaultStride();
+
+        if (width % 8 == 0 && height % 8 == 0) {
+            // Whole tiles are decoded at once instead of finding each texel's tile
+            std::vector<Common::Vec4<u8>> texels(static_cast<std::size_t>(width) * height);
+            Pica::Texture::DecodeTexture(buffer, info, texels.data(), true);
+            for (unsigned int y = 0; y < height; ++y) {
+                QRgb* line = reinterpret_cast<QRgb*>(decoded_image.scanLine(y));
+                const Common::Vec4<u8>* row = texels.data() + y * width;
+                for (unsigned int x = 0; x < width; ++x) {
+                    line[x] = qRgba(row[x].r(), row[x].g(), row[x].b(), row[x].a());
+                }
+            }
+        } else {
+            for (unsigned int y = 0; y < height; ++y) {
+                QRgb* line = reinterpret_cast<QRgb*>(decoded_image.scanLine(y));
+                for (unsigned int x = 0; x < width; ++x) {
+                    Common::Vec4<u8> color = Pica::Texture::LookupTexture(buffer, x, y, info, true);
+                    line[x] = qRgba(color.r(), color.g(), color.b(), color.a());
+                }
+            }
+        }
+        return decoded_image;
+    }
+
+    // We handle depth formats here because DebugUtils only supports TextureFormats
+
+    // TODO(yuriks): Convert to newer tile-based addressing
+    unsigned nibbles_per_pixel = GraphicsSurfaceWidget::NibblesPerPixel(format);
+    unsigned stride = nibbles_per_pixel * width / 2;
+
+    ASSERT_MSG(nibbles_per_pixel >= 2,
+               "Depth decoder only supports formats with at least one byte per pixel");
+    unsigned bytes_per_pixel = nibbles_per_pixel / 2;
+
+    for (unsigned int y = 0; y < height; ++y) {
+        QRgb* line = reinterpret_cast<QRgb*>(decoded_image.scanLine(y));
+        for (unsigned int x = 0; x < width; ++x) {
+            const u32 coarse_y = y & ~7;
+            u32 offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) + coarse_y * stride;
+            const u8* pixel = buffer + offset;
+            Common::Vec4<u8> color = {0, 0, 0, 0};
+
+            switch (format) {
+            case Format::D16: {
+                u32 data = Color::DecodeD16(pixel);
+                color.r() = data & 0xFF;
+                color.g() = (data >> 8) & 0xFF;
+                break;
+            }
+            case Format::D24: {
+                u32 data = Color::DecodeD24(pixel);
+                color.r() = data & 0xFF;
+                color.g() = (data >> 8) & 0xFF;
+                color.b() = (data >> 16) & 0xFF;
+                break;
+            }
+            case Format::D24X8: {
+                Common::Vec2<u32> data = Color::DecodeD24S8(pixel);
+                color.r() = data.x & 0xFF;
+                color.g() = (data.x >> 8) & 0xFF;
+                color.b() = (data.x >> 16) & 0xFF;
+                break;
+            }
+            case Format::X24S8: {
+                Common::Vec2<u32> data = Color::DecodeD24S8(pixel);
+                color.r() = color.g() = color.b() = data.y;
+                break;
+            }
+            default:
+                qDebug() << "Unknown surface format " << static_cast<int>(format);
+                break;
+            }
+
+            line[x] = qRgba(color.r(), color.g(), color.b(), 255);
+        }
+    }
+    return decoded_image;
+}
+
 void GraphicsSurfaceWidget::SaveSurface() {
     const QString png_filter = tr("Portable Network Graphic (*.png)");
     const QString bin_filter = tr("Binary data (*.bin)");
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <vector>
+#include <QFutureWatcher>
+#include <QImage>
 #include <QLabel>
 #include <QPushButton>
 #include "citra_qt/debugger/graphics/graphics_breakpoint_observer.h"
@@ -69,11 +72,22 @@ class GraphicsSurfaceWidget : public BreakPointObserverDock {
         Unknown = 18,
     };
 
+    /// Image decoded on a worker thread, with the hash of what it was decoded from
+    struct DecodeResult {
+        u64 hash;
+        QImage image;
+    };
+
     static unsigned int NibblesPerPixel(Format format);
 
+    /// Converts a copy of the surface memory to an image that can be shown
+    static QImage DecodeSurface(const std::vector<u8>& data, unsigned width, unsigned height,
+                                Format format);
+
 public:
     explicit GraphicsSurfaceWidget(std::shared_ptr<Pica::DebugContext> debug_context,
                                    QWidget* parent = nullptr);
+    ~GraphicsSurfaceWidget() override;
     void Pick(int x, int y);
 
 public slots:
@@ -93,6 +107,7 @@ private:
     void OnBreakPointHit(Pica::DebugContext::Event event, void* data) override;
     void OnResumed() override;
 
+    void OnDecodeFinished();
     void SaveSurface();
 
     QComboBox* surface_source_list;
@@ -114,4 +129,8 @@ private:
     Format surface_format;
     int surface_picker_x = 0;
     int surface_picker_y = 0;
+
+    /// Hash of the surface parameters and memory of the shown or pending image, 0 if there is none
+    u64 decoded_hash = 0;
+    QFutureWatcher<DecodeResult> decode_watcher;
 };
@@ -62,24 +62,31 @@ void GraphicsTracingWidget::StartRecording() {
     if (!context)
         return;
 
-    auto shader_binary = Pica::g_state.vs.program_code;
-    auto swizzle_data = Pica::g_state.vs.swizzle_data;
+    // The trace is written to the file while recording
+    QString filename = QFileDialog::getSaveFileName(
+        this, tr("Save CiTrace"), QStringLiteral("citrace.ctf"), tr("CiTrace File (*.ctf)"));
+
+    if (filename.isEmpty())
+        return;
 
     // Encode floating point numbers to 24-bit values
     // TODO: Drop this explicit conversion once we store float24 values bit-correctly internally.
     std::array<u32, 4 * 16> default_attributes;
     for (unsigned i = 0; i < 16; ++i) {
-        for (unsigned comp = 0; comp < 3; ++comp) {
+        for (unsigned comp = 0; comp < 4; ++comp) {
             default_attributes[4 * i + comp] = nihstro::to_float24(
                 Pica::g_state.input_default_attributes.attr[i][comp].ToFloat32());
         }
     }
 
-    std::array<u32, 4 * 96> vs_float_uniforms;
-    for (unsigned i = 0; i < 96; ++i)
-        for (unsigned comp = 0; comp < 3; ++comp)
-            vs_float_uniforms[4 * i + comp] =
-                nihstro::to_float24(Pica::g_state.vs.uniforms.f[i][comp].ToFloat32());
+    const auto encode_float_uniforms = [](const Pica::Shader::ShaderSetup& setup) {
+        std::array<u32, 4 * 96> float_uniforms;
+        for (unsigned i = 0; i < 96; ++i)
+            for (unsigned comp = 0; comp < 4; ++comp)
+                float_uniforms[4 * i + comp] =
+                    nihstro::to_float24(setup.uniforms.f[i][comp].ToFloat32());
+        return float_uniforms;
+    };
 
     CiTrace::Recorder::InitialState state;
     std::copy_n((u32*)&GPU::g_regs, sizeof(GPU::g_regs) / sizeof(u32),
@@ -89,15 +96,22 @@ void GraphicsTracingWidget::StartRecording() {
     std::copy_n((u32*)&Pica::g_state.regs, sizeof(Pica::g_state.regs) / sizeof(u32),
                 std::back_inserter(state.pica_registers));
     boost::copy(default_attributes, std::back_inserter(state.default_attributes));
-    boost::copy(shader_binary, std::back_inserter(state.vs_program_binary));
-    boost::copy(swizzle_data, std::back_inserter(state.vs_swizzle_data));
-    boost::copy(vs_float_uniforms, std::back_inserter(state.vs_float_uniforms));
-    // boost::copy(TODO: Not implemented, std::back_inserter(state.gs_program_binary));
-    // boost::copy(TODO: Not implemented, std::back_inserter(state.gs_swizzle_data));
-    // boost::copy(TODO: Not implemented, std::back_inserter(state.gs_float_uniforms));
-
-    auto recorder = new CiTrace::Recorder(state);
-    context->recorder = std::shared_ptr<CiTrace::Recorder>(recorder);
+    boost::copy(Pica::g_state.vs.program_code, std::back_inserter(state.vs_program_binary));
+    boost::copy(Pica::g_state.vs.swizzle_data, std::back_inserter(state.vs_swizzle_data));
+    boost::copy(encode_float_uniforms(Pica::g_state.vs),
+                std::back_inserter(state.vs_float_uniforms));
+    boost::copy(Pica::g_state.gs.program_code, std::back_inserter(state.gs_program_binary));
+    boost::copy(Pica::g_state.gs.swizzle_data, std::back_inserter(state.gs_swizzle_data));
+    boost::copy(encode_float_uniforms(Pica::g_state.gs),
+                std::back_inserter(state.gs_float_uniforms));
+
+    auto recorder = std::make_shared<CiTrace::Recorder>(state, filename.toStdString());
+    if (!recorder->IsGood()) {
+        QMessageBox::critical(this, tr("CiTrace Recorder"),
+                              tr("Could not write to %1.").arg(filename));
+        return;
+    }
+    context->recorder = std::move(recorder);
 
     emit SetStartTracingButtonEnabled(false);
     emit SetStopTracingButtonEnabled(true);
@@ -109,15 +123,7 @@ void GraphicsTracingWidget::StopRecording() {
     if (!context)
         return;
 
-    QString filename = QFileDialog::getSaveFileName(
-        this, tr("Save CiTrace"), QStringLiteral("citrace.ctf"), tr("CiTrace File (*.ctf)"));
-
-    if (filename.isEmpty()) {
-        // If the user canceled the dialog, keep recording
-        return;
-    }
-
-    context->recorder->Finish(filename.toStdString());
+    context->recorder->Finish();
     context->recorder = nullptr;
 
     emit SetStopTracingButtonEnabled(false);
@@ -130,6 +136,7 @@ void GraphicsTracingWidget::AbortRecording() {
     if (!context)
         return;
 
+    context->recorder->Abort();
     context->recorder = nullptr;
 
     emit SetStopTracingButtonEnabled(false);
@@ -2,7 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <QFile>
+#include <QFileDialog>
+#include <QMessageBox>
 #include <QString>
+#include <QTextStream>
 #include <QTreeWidgetItem>
 #include <fmt/format.h>
 #include "citra_qt/debugger/ipc/record_dialog.h"
@@ -12,6 +16,7 @@
 #include "core/core.h"
 #include "core/hle/kernel/ipc_debugger/recorder.h"
 #include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/service/sm/sm.h"
 #include "ui_recorder.h"
 
@@ -23,7 +28,12 @@ IPCRecorderWidget::IPCRecorderWidget(QWidget* parent)
 
     connect(ui->enabled, &QCheckBox::stateChanged,
             [this](int new_state) { SetEnabled(new_state == Qt::Checked); });
+    connect(ui->captureEnabled, &QCheckBox::stateChanged,
+            [this](int new_state) { SetCaptureEnabled(new_state == Qt::Checked); });
+    connect(ui->saveCaptureButton, &QPushButton::clicked, this, &IPCRecorderWidget::SaveCapture);
     connect(ui->clearButton, &QPushButton::clicked, this, &IPCRecorderWidget::Clear);
+    connect(ui->objectPoolsButton, &QPushButton::clicked, this,
+            &IPCRecorderWidget::ShowObjectPoolStats);
     connect(ui->filter, &QLineEdit::textChanged, this, &IPCRecorderWidget::ApplyFilterToAll);
     connect(ui->main, &QTreeWidget::itemDoubleClicked, this, &IPCRecorderWidget::OpenRecordDialog);
     connect(this, &IPCRecorderWidget::EntryUpdated, this, &IPCRecorderWidget::OnEntryUpdated);
@@ -37,6 +47,7 @@ void IPCRecorderWidget::OnEmulationStarting() {
 
     // Update the enabled status when the system is powered on.
     SetEnabled(ui->enabled->isChecked());
+    SetCaptureEnabled(ui->captureEnabled->isChecked());
 }
 
 QString IPCRecorderWidget::GetStatusStr(const IPCDebugger::RequestRecord& record) const {
@@ -113,6 +124,62 @@ void IPCRecorderWidget::SetEnabled(bool enabled) {
     }
 }
 
+void IPCRecorderWidget::SetCaptureEnabled(bool enabled) {
+    if (!Core::System::GetInstance().IsPoweredOn()) {
+        return;
+    }
+
+    auto& ipc_recorder = Core::System::GetInstance().Kernel().GetIPCRecorder();
+    if (enabled) {
+        ipc_recorder.StartCapture({});
+    } else {
+        ipc_recorder.StopCapture();
+    }
+}
+
+void IPCRecorderWidget::SaveCapture() {
+    if (!Core::System::GetInstance().IsPoweredOn()) {
+        return;
+    }
+
+    const QString path = QFileDialog::getSaveFileName(this, tr("Save IPC Capture"), QString(),
+                                                      tr("IPC Capture (*.bin)"));
+    if (path.isEmpty()) {
+        return;
+    }
+
+    // The histograms are written next to the capture as CSV, to be read without any tools
+    const auto& ipc_recorder = Core::System::GetInstance().Kernel().GetIPCRecorder();
+    bool success = ipc_recorder.SaveCapture(path.toStdString());
+    QFile csv(path + QStringLiteral(".csv"));
+    if (csv.open(QFile::WriteOnly | QFile::Text)) {
+        QTextStream stream(&csv);
+        stream << "service,function,header,count,total_ns,max_ns";
+        for (std::size_t i = 0; i < IPCDebugger::LatencyHistogram::NUM_BUCKETS; ++i) {
+            stream << ",lt_" << (2u << i) << "us";
+        }
+        stream << '\n';
+        for (const auto& histogram : ipc_recorder.GetLatencyHistograms()) {
+            stream << QString::fromStdString(histogram.service) << ','
+                   << QString::fromStdString(histogram.function) << ','
+                   << QStringLiteral("0x%1").arg(histogram.request_header, 8, 16, QLatin1Char('0'))
+                   << ',' << histogram.count << ',' << histogram.total_ns << ','
+                   << histogram.max_ns;
+            for (u64 bucket : histogram.buckets) {
+                stream << ',' << bucket;
+            }
+            stream << '\n';
+        }
+    } else {
+        success = false;
+    }
+
+    if (!success) {
+        QMessageBox::critical(this, tr("Save IPC Capture"),
+                              tr("Could not write the IPC capture to %1.").arg(path));
+    }
+}
+
 void IPCRecorderWidget::Clear() {
     id_offset += records.size();
 
@@ -181,3 +248,15 @@ void IPCRecorderWidget::OpenRecordDialog(QTreeWidgetItem* item, [[maybe_unused]]
                         item->text(3));
     dialog.exec();
 }
+
+void IPCRecorderWidget::ShowObjectPoolStats() {
+    QString text = tr("Allocated kernel objects (live / peak / capacity):");
+    for (const auto& stats : Kernel::GetObjectPoolStats()) {
+        text += QStringLiteral("\n%1: %2 / %3 / %4")
+                    .arg(QString::fromUtf8(Kernel::GetHandleTypeName(stats.type)))
+                    .arg(stats.live)
+                    .arg(stats.peak)
+                    .arg(stats.capacity);
+    }
+    QMessageBox::information(this, tr("Kernel Objects"), text);
+}
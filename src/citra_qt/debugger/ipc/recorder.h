@@ -32,12 +32,15 @@ private:
     QString GetStatusStr(const IPCDebugger::RequestRecord& record) const;
     void OnEntryUpdated(IPCDebugger::RequestRecord record);
     void SetEnabled(bool enabled);
+    void SetCaptureEnabled(bool enabled);
+    void SaveCapture();
     void Clear();
     void ApplyFilter(int index);
     void ApplyFilterToAll();
     QString GetServiceName(const IPCDebugger::RequestRecord& record) const;
     QString GetFunctionName(const IPCDebugger::RequestRecord& record) const;
     void OpenRecordDialog(QTreeWidgetItem* item, int column);
+    void ShowObjectPoolStats();
 
     std::unique_ptr<Ui::IPCRecorder> ui;
     IPCDebugger::CallbackHandle handle;
@@ -106,11 +106,11 @@ std::unique_ptr<WaitTreeWaitObject> WaitTreeWaitObject::make(const Kernel::WaitO
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeWaitObject::GetChildren() const {
     std::vector<std::unique_ptr<WaitTreeItem>> list;
 
-    const auto& threads = object.GetWaitingThreads();
+    auto threads = object.GetWaitingThreads();
     if (threads.empty()) {
         list.push_back(std::make_unique<WaitTreeText>(tr("waited by no thread")));
     } else {
-        list.push_back(std::make_unique<WaitTreeThreadList>(threads));
+        list.push_back(std::make_unique<WaitTreeThreadList>(std::move(threads)));
     }
     return list;
 }
@@ -128,9 +128,9 @@ QString WaitTreeWaitObject::GetResetTypeQString(Kernel::ResetType reset_type) {
     return {};
 }
 
-WaitTreeObjectList::WaitTreeObjectList(const std::vector<std::shared_ptr<Kernel::WaitObject>>& list,
+WaitTreeObjectList::WaitTreeObjectList(std::vector<std::shared_ptr<Kernel::WaitObject>> list,
                                        bool w_all)
-    : object_list(list), wait_all(w_all) {}
+    : object_list(std::move(list)), wait_all(w_all) {}
 
 QString WaitTreeObjectList::GetText() const {
     if (wait_all)
@@ -252,7 +252,7 @@ std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeThread::GetChildren() const {
     if (thread.status == Kernel::ThreadStatus::WaitSynchAny ||
         thread.status == Kernel::ThreadStatus::WaitSynchAll ||
         thread.status == Kernel::ThreadStatus::WaitHleEvent) {
-        list.push_back(std::make_unique<WaitTreeObjectList>(thread.wait_objects,
+        list.push_back(std::make_unique<WaitTreeObjectList>(thread.GetWaitObjects(),
                                                             thread.IsSleepingOnWaitAll()));
     }
 
@@ -330,8 +330,8 @@ std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeMutexList::GetChildren() cons
     return list;
 }
 
-WaitTreeThreadList::WaitTreeThreadList(const std::vector<std::shared_ptr<Kernel::Thread>>& list)
-    : thread_list(list) {}
+WaitTreeThreadList::WaitTreeThreadList(std::vector<std::shared_ptr<Kernel::Thread>> list)
+    : thread_list(std::move(list)) {}
 
 QString WaitTreeThreadList::GetText() const {
     return tr("waited by thread");
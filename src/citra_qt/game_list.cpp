@@ -20,6 +20,7 @@
 #include <QThreadPool>
 #include <QToolButton>
 #include <QTreeView>
+#include <QtConcurrent/QtConcurrentRun>
 #include <fmt/format.h>
 #include "citra_qt/compatibility_list.h"
 #include "citra_qt/game_list.h"
@@ -183,60 +184,56 @@ void GameList::onItemExpanded(const QModelIndex& item) {
 }
 
 // Event in order to filter the gamelist after editing the searchfield
+// The matching runs on the thread pool over the search keys, only the row visibility is updated
+// on the GUI thread once the result for the latest text is ready
 void GameList::onTextChanged(const QString& new_text) {
-    const int folder_count = tree_view->model()->rowCount();
-    QString edit_filter_text = new_text.toLower();
-    QStandardItem* folder;
-    int children_total = 0;
+    const QString edit_filter_text = new_text.toLower();
+    filter_text = edit_filter_text;
 
     // If the searchfield is empty every item is visible
-    // Otherwise the filter gets applied
     if (edit_filter_text.isEmpty()) {
-        for (int i = 0; i < folder_count; ++i) {
-            folder = item_model->item(i, 0);
-            const QModelIndex folder_index = folder->index();
-            const int children_count = folder->rowCount();
-            for (int j = 0; j < children_count; ++j) {
-                ++children_total;
-                tree_view->setRowHidden(j, folder_index, false);
-            }
+        filter_watcher.setFuture(QFuture<FilterResult>());
+        for (const QPersistentModelIndex& row : filter_rows) {
+            if (row.isValid())
+                tree_view->setRowHidden(row.row(), row.parent(), false);
         }
-        search_field->setFilterResult(children_total, children_total);
-    } else {
-        int result_count = 0;
-        for (int i = 0; i < folder_count; ++i) {
-            folder = item_model->item(i, 0);
-            const QModelIndex folder_index = folder->index();
-            const int children_count = folder->rowCount();
-            for (int j = 0; j < children_count; ++j) {
-                ++children_total;
-                const QStandardItem* child = folder->child(j, 0);
-                const QString file_path =
-                    child->data(GameListItemPath::FullPathRole).toString().toLower();
-                const QString file_title =
-                    child->data(GameListItemPath::LongTitleRole).toString().toLower();
-                const QString file_program_id =
-                    child->data(GameListItemPath::ProgramIdRole).toString().toLower();
-
-                // Only items which filename in combination with its title contains all words
-                // that are in the searchfield will be visible in the gamelist
-                // The search is case insensitive because of toLower()
-                // I decided not to use Qt::CaseInsensitive in containsAllWords to prevent
-                // multiple conversions of edit_filter_text for each game in the gamelist
-                const QString file_name =
-                    file_path.mid(file_path.lastIndexOf(QLatin1Char{'/'}) + 1) + QLatin1Char{' '} +
-                    file_title;
-                if (ContainsAllWords(file_name, edit_filter_text) ||
-                    (file_program_id.count() == 16 && edit_filter_text.contains(file_program_id))) {
-                    tree_view->setRowHidden(j, folder_index, false);
-                    ++result_count;
-                } else {
-                    tree_view->setRowHidden(j, folder_index, true);
-                }
-                search_field->setFilterResult(result_count, children_total);
-            }
+        search_field->setFilterResult(filter_rows.size(), filter_rows.size());
+        return;
+    }
+
+    filter_watcher.setFuture(QtConcurrent::run([keys = filter_keys, edit_filter_text] {
+        FilterResult result{edit_filter_text, QVector<bool>(keys.size())};
+        for (int i = 0; i < keys.size(); ++i) {
+            // Only items which filename in combination with its title contains all words
+            // that are in the searchfield will be visible in the gamelist
+            // The search is case insensitive because the keys and the text are lowercase
+            const FilterKey& key = keys[i];
+            result.visible[i] =
+                ContainsAllWords(key.name, edit_filter_text) ||
+                (key.program_id.count() == 16 && edit_filter_text.contains(key.program_id));
         }
+        return result;
+    }));
+}
+
+void GameList::onFilterFinished() {
+    const FilterResult result = filter_watcher.result();
+    if (result.text != filter_text) {
+        // The text changed while filtering, a newer result is on its way
+        return;
     }
+
+    int result_count = 0;
+    const int count = std::min(result.visible.size(), filter_rows.size());
+    for (int i = 0; i < count; ++i) {
+        const QPersistentModelIndex& row = filter_rows[i];
+        if (!row.isValid())
+            continue;
+        tree_view->setRowHidden(row.row(), row.parent(), !result.visible[i]);
+        if (result.visible[i])
+            ++result_count;
+    }
+    search_field->setFilterResult(result_count, filter_rows.size());
 }
 
 void GameList::onUpdateThemedIcons() {
@@ -308,6 +305,8 @@ GameList::GameList(GMainWindow* parent) : QWidget{parent} {
     connect(tree_view, &QTreeView::customContextMenuRequested, this, &GameList::PopupContextMenu);
     connect(tree_view, &QTreeView::expanded, this, &GameList::onItemExpanded);
     connect(tree_view, &QTreeView::collapsed, this, &GameList::onItemExpanded);
+    connect(&filter_watcher, &QFutureWatcher<FilterResult>::finished, this,
+            &GameList::onFilterFinished);
 
     // We must register all custom types with the Qt Automoc system so that we are able to use
     // it with signals/slots. In this case, QList falls under the umbrells of custom types.
@@ -322,6 +321,7 @@ GameList::GameList(GMainWindow* parent) : QWidget{parent} {
 
 GameList::~GameList() {
     emit ShouldCancelWorker();
+    filter_watcher.waitForFinished();
 }
 
 void GameList::setFilterFocus() {
@@ -357,6 +357,14 @@ void GameList::AddDirEntry(GameListDir* entry_items) {
 
 void GameList::AddEntry(const QList<QStandardItem*>& entry_items, GameListDir* parent) {
     parent->appendRow(entry_items);
+
+    const QStandardItem* item = entry_items.front();
+    const QString file_path = item->data(GameListItemPath::FullPathRole).toString().toLower();
+    const QString file_title = item->data(GameListItemPath::LongTitleRole).toString().toLower();
+    filter_keys.push_back(
+        {file_path.mid(file_path.lastIndexOf(QLatin1Char{'/'}) + 1) + QLatin1Char{' '} + file_title,
+         item->data(GameListItemPath::ProgramIdRole).toString().toLower()});
+    filter_rows.push_back(QPersistentModelIndex(item->index()));
 }
 
 void GameList::ValidateEntry(const QModelIndex& item) {
@@ -470,6 +478,8 @@ void GameList::AddGamePopup(QMenu& context_menu, const QString& path, u64 progra
         context_menu.addAction(tr("Open Custom Texture Location"));
     QAction* open_mods_location = context_menu.addAction(tr("Open Mods Location"));
     QAction* dump_romfs = context_menu.addAction(tr("Dump RomFS"));
+    QAction* export_shader_cache = context_menu.addAction(tr("Export Shader Cache..."));
+    QAction* import_shader_cache = context_menu.addAction(tr("Import Shader Cache..."));
     QAction* navigate_to_gamedb_entry = context_menu.addAction(tr("Navigate to GameDB entry"));
 
     const bool is_application =
@@ -501,6 +511,8 @@ void GameList::AddGamePopup(QMenu& context_menu, const QString& path, u64 progra
     open_texture_load_location->setVisible(is_application);
     open_mods_location->setVisible(is_application);
     dump_romfs->setVisible(is_application);
+    export_shader_cache->setVisible(is_application);
+    import_shader_cache->setVisible(is_application);
 
     navigate_to_gamedb_entry->setVisible(it != compatibility_list.end());
 
@@ -539,6 +551,10 @@ void GameList::AddGamePopup(QMenu& context_menu, const QString& path, u64 progra
     });
     connect(dump_romfs, &QAction::triggered,
             [this, path, program_id] { emit DumpRomFSRequested(path, program_id); });
+    connect(export_shader_cache, &QAction::triggered,
+            [this, program_id] { emit ShaderCacheExportRequested(program_id); });
+    connect(import_shader_cache, &QAction::triggered,
+            [this, program_id] { emit ShaderCacheImportRequested(program_id); });
     connect(navigate_to_gamedb_entry, &QAction::triggered, [this, program_id]() {
         emit NavigateToGamedbEntryRequested(program_id, compatibility_list);
     });
@@ -659,6 +675,8 @@ void GameList::PopulateAsync(QVector<UISettings::GameDir>& game_dirs) {
     tree_view->setEnabled(false);
     // Delete any rows that might already exist if we're repopulating
     item_model->removeRows(0, item_model->rowCount());
+    filter_keys.clear();
+    filter_rows.clear();
     search_field->clear();
 
     emit ShouldCancelWorker();
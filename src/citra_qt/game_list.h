@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <QFutureWatcher>
 #include <QMenu>
+#include <QPersistentModelIndex>
 #include <QString>
 #include <QVector>
 #include <QWidget>
@@ -83,6 +85,8 @@ signals:
     void NavigateToGamedbEntryRequested(u64 program_id,
                                         const CompatibilityList& compatibility_list);
     void DumpRomFSRequested(QString game_path, u64 program_id);
+    void ShaderCacheExportRequested(u64 program_id);
+    void ShaderCacheImportRequested(u64 program_id);
     void OpenDirectory(const QString& directory);
     void AddDirectory();
     void ShowList(bool show);
@@ -91,6 +95,7 @@ signals:
 private slots:
     void onItemExpanded(const QModelIndex& item);
     void onTextChanged(const QString& new_text);
+    void onFilterFinished();
     void onFilterCloseClicked();
     void onUpdateThemedIcons();
 
@@ -107,6 +112,17 @@ private:
 
     QString FindGameByProgramID(QStandardItem* current_item, u64 program_id);
 
+    /// Lowercase search keys of a game, kept apart from the model so filtering can run off-thread
+    struct FilterKey {
+        QString name; ///< File name and long title
+        QString program_id;
+    };
+
+    struct FilterResult {
+        QString text;
+        QVector<bool> visible;
+    };
+
     GameListSearchField* search_field;
     GMainWindow* main_window = nullptr;
     QVBoxLayout* layout = nullptr;
@@ -116,6 +132,12 @@ private:
     QFileSystemWatcher* watcher = nullptr;
     CompatibilityList compatibility_list;
 
+    /// Search keys of every game and the rows they belong to, in the order they were added
+    QVector<FilterKey> filter_keys;
+    QVector<QPersistentModelIndex> filter_rows;
+    QFutureWatcher<FilterResult> filter_watcher;
+    QString filter_text;
+
     friend class GameListSearchField;
 };
 
@@ -0,0 +1,115 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "citra_qt/game_list_cache.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+
+namespace {
+// Version 2 drops the entries of encrypted titles that parallel scans decrypted with wrong keys
+constexpr u64 CACHE_VERSION = 2;
+
+std::string GetCachePath() {
+    return FileUtil::GetUserPath(FileUtil::UserPath::CacheDir) + "game_list" DIR_SEP "index.bin";
+}
+
+template <typename T>
+bool ReadValue(FileUtil::IOFile& file, T& value) {
+    return file.ReadBytes(&value, sizeof(T)) == sizeof(T);
+}
+
+template <typename T>
+bool ReadVector(FileUtil::IOFile& file, std::vector<T>& data) {
+    u64 size;
+    if (!ReadValue(file, size) || size > file.GetSize())
+        return false;
+    data.resize(size);
+    return file.ReadArray(data.data(), data.size()) == data.size();
+}
+
+template <typename T>
+bool WriteVector(FileUtil::IOFile& file, const T& data) {
+    return file.WriteObject(static_cast<u64>(data.size())) == 1 &&
+           file.WriteArray(data.data(), data.size()) == data.size();
+}
+} // Anonymous namespace
+
+void GameListCache::Load() {
+    std::lock_guard lock{mutex};
+    loaded_entries.clear();
+    used_entries.clear();
+
+    FileUtil::IOFile file(GetCachePath(), "rb");
+    if (!file)
+        return;
+
+    u64 version;
+    u64 num_entries;
+    if (!ReadValue(file, version) || version != CACHE_VERSION || !ReadValue(file, num_entries))
+        return;
+
+    std::unordered_map<std::string, Entry> entries;
+    for (u64 i = 0; i < num_entries; ++i) {
+        std::vector<char> path;
+        Entry entry;
+        u8 executable;
+        if (!ReadVector(file, path) || !ReadValue(file, entry.size) ||
+            !ReadValue(file, entry.modification_time) ||
+            !ReadValue(file, entry.update_modification_time) || !ReadValue(file, executable) ||
+            !ReadValue(file, entry.program_id) || !ReadValue(file, entry.extdata_id) ||
+            !ReadValue(file, entry.file_type) || !ReadVector(file, entry.smdh)) {
+            LOG_WARNING(Frontend, "Game list cache is corrupted, ignoring it");
+            return;
+        }
+        entry.executable = executable != 0;
+        entries.emplace(std::string(path.begin(), path.end()), std::move(entry));
+    }
+    loaded_entries = std::move(entries);
+}
+
+void GameListCache::Save() const {
+    std::lock_guard lock{mutex};
+    const std::string path = GetCachePath();
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(Frontend, "Could not create path for the game list cache {}", path);
+        return;
+    }
+
+    FileUtil::IOFile file(path, "wb");
+    bool success = file.IsOpen() && file.WriteObject(CACHE_VERSION) == 1 &&
+                   file.WriteObject(static_cast<u64>(used_entries.size())) == 1;
+    for (const auto& [entry_path, entry] : used_entries) {
+        if (!success)
+            break;
+        success = WriteVector(file, entry_path) && file.WriteObject(entry.size) == 1 &&
+                  file.WriteObject(entry.modification_time) == 1 &&
+                  file.WriteObject(entry.update_modification_time) == 1 &&
+                  file.WriteObject(static_cast<u8>(entry.executable)) == 1 &&
+                  file.WriteObject(entry.program_id) == 1 &&
+                  file.WriteObject(entry.extdata_id) == 1 &&
+                  file.WriteObject(entry.file_type) == 1 && WriteVector(file, entry.smdh);
+    }
+
+    if (!success) {
+        LOG_ERROR(Frontend, "Could not write the game list cache {}", path);
+        file.Close();
+        FileUtil::Delete(path);
+    }
+}
+
+std::optional<GameListCache::Entry> GameListCache::Find(const std::string& path, u64 size,
+                                                        u64 modification_time) const {
+    std::lock_guard lock{mutex};
+    const auto it = loaded_entries.find(path);
+    if (it == loaded_entries.end() || it->second.size != size ||
+        it->second.modification_time != modification_time)
+        return std::nullopt;
+    return it->second;
+}
+
+void GameListCache::Add(const std::string& path, Entry entry) {
+    std::lock_guard lock{mutex};
+    used_entries.insert_or_assign(path, std::move(entry));
+}
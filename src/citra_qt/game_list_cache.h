@@ -0,0 +1,47 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Persistent index of the metadata the game list reads from each ROM, so that unchanged files
+ * don't have to be opened and parsed on every refresh. Entries are invalidated when the size or
+ * the modification time of the file or of its installed update changes. Thread-safe.
+ */
+class GameListCache {
+public:
+    struct Entry {
+        u64 size = 0;
+        u64 modification_time = 0;
+        u64 update_modification_time = 0; ///< 0 if there was no update installed
+        bool executable = false;
+        u64 program_id = 0;
+        u64 extdata_id = 0;
+        u32 file_type = 0; ///< Loader::FileType
+        std::vector<u8> smdh;
+    };
+
+    /// Loads the index from the cache directory, dropping it if it's invalid
+    void Load();
+
+    /// Saves the entries that were looked up or added since Load, so stale files are pruned
+    void Save() const;
+
+    /// Returns the entry for the file if it's still valid for the given file state
+    std::optional<Entry> Find(const std::string& path, u64 size, u64 modification_time) const;
+
+    void Add(const std::string& path, Entry entry);
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> loaded_entries;
+    std::unordered_map<std::string, Entry> used_entries;
+};
@@ -142,7 +142,9 @@ static const std::unordered_map<UISettings::GameListIconSize, int> IconSizes{
  * A specialization of GameListItem for path values.
  * This class ensures that for every full path value it holds, a correct string representation
  * of just the filename (with no extension) will be displayed to the user.
- * If this class receives valid SMDH data, it will also display game icons and titles.
+ * If this class receives valid SMDH data, it will also display game icons and titles. Icons are
+ * only kept as raw pixels and converted the first time the view asks for them, so only rows that
+ * are actually shown pay for the pixmap.
  */
 class GameListItemPath : public GameListItem {
 public:
@@ -160,27 +162,17 @@ public:
         setData(qulonglong(program_id), ProgramIdRole);
         setData(qulonglong(extdata_id), ExtdataIdRole);
 
-        if (UISettings::values.game_list_icon_size == UISettings::GameListIconSize::NoIcon) {
-            // Do not display icons
-            setData(QPixmap(), Qt::DecorationRole);
-        }
-
-        bool large =
-            UISettings::values.game_list_icon_size == UISettings::GameListIconSize::LargeIcon;
-
+        icon_size = UISettings::values.game_list_icon_size;
         if (!Loader::IsValidSMDH(smdh_data)) {
-            // SMDH is not valid, set a default icon
-            if (UISettings::values.game_list_icon_size != UISettings::GameListIconSize::NoIcon)
-                setData(GetDefaultIcon(large), Qt::DecorationRole);
             return;
         }
 
         Loader::SMDH smdh;
         memcpy(&smdh, smdh_data.data(), sizeof(Loader::SMDH));
 
-        // Get icon from SMDH
-        if (UISettings::values.game_list_icon_size != UISettings::GameListIconSize::NoIcon)
-            setData(GetQPixmapFromSMDH(smdh, large), Qt::DecorationRole);
+        // Keep the icon pixels, the pixmap itself is created on demand by the GUI thread
+        if (icon_size != UISettings::GameListIconSize::NoIcon)
+            icon_data = smdh.GetIcon(icon_size == UISettings::GameListIconSize::LargeIcon);
 
         // Get title from SMDH
         setData(GetQStringShortTitleFromSMDH(smdh, Loader::SMDH::TitleLanguage::English),
@@ -196,7 +188,9 @@ public:
     }
 
     QVariant data(int role) const override {
-        if (role == Qt::DisplayRole || role == SortRole) {
+        if (role == Qt::DecorationRole) {
+            return GetIcon();
+        } else if (role == Qt::DisplayRole || role == SortRole) {
             std::string path, filename, extension;
             Common::SplitPath(data(FullPathRole).toString().toStdString(), &path, &filename,
                               &extension);
@@ -230,6 +224,32 @@ public:
             return GameListItem::data(role);
         }
     }
+
+private:
+    QPixmap GetIcon() const {
+        if (icon_size == UISettings::GameListIconSize::NoIcon) {
+            // Do not display icons
+            return QPixmap();
+        }
+        if (icon.isNull()) {
+            const bool large = icon_size == UISettings::GameListIconSize::LargeIcon;
+            if (icon_data.empty()) {
+                // SMDH is not valid, use a default icon
+                icon = GetDefaultIcon(large);
+            } else {
+                const int size = large ? 48 : 24;
+                const QImage image(reinterpret_cast<const uchar*>(icon_data.data()), size, size,
+                                   QImage::Format::Format_RGB16);
+                icon = QPixmap::fromImage(image);
+                icon_data = {};
+            }
+        }
+        return icon;
+    }
+
+    UISettings::GameListIconSize icon_size = UISettings::GameListIconSize::NoIcon;
+    mutable std::vector<u16> icon_data;
+    mutable QPixmap icon;
 };
 
 class GameListItemCompat : public GameListItem {
@@ -2,8 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <QDir>
@@ -17,6 +22,7 @@
 #include "common/file_util.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/fs/archive.h"
+#include "core/hw/aes/key.h"
 #include "core/loader/loader.h"
 
 namespace {
@@ -24,6 +30,19 @@ bool HasSupportedFileExtension(const std::string& file_name) {
     const QFileInfo file = QFileInfo(QString::fromStdString(file_name));
     return GameList::supported_file_extensions.contains(file.suffix(), Qt::CaseInsensitive);
 }
+
+std::string GetUpdatePath(u64 program_id) {
+    return Service::AM::GetTitleContentPath(Service::FS::MediaType::SDMC,
+                                            program_id | 0x0000000E00000000);
+}
+
+/// Returns the modification time of the installed update of the title, 0 if there is none
+u64 GetUpdateModificationTime(u64 program_id) {
+    if (program_id & ~0x00040000FFFFFFFF)
+        return 0;
+    const std::string update_path = GetUpdatePath(program_id);
+    return FileUtil::Exists(update_path) ? FileUtil::GetModificationTime(update_path) : 0;
+}
 } // Anonymous namespace
 
 GameListWorker::GameListWorker(QVector<UISettings::GameDir>& game_dirs,
@@ -32,11 +51,11 @@ GameListWorker::GameListWorker(QVector<UISettings::GameDir>& game_dirs,
 
 GameListWorker::~GameListWorker() = default;
 
-void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
-                                             GameListDir* parent_dir) {
-    const auto callback = [this, recursion, parent_dir](u64* num_entries_out,
-                                                        const std::string& directory,
-                                                        const std::string& virtual_name) -> bool {
+void GameListWorker::ScanDirectory(const std::string& dir_path, unsigned int recursion,
+                                   std::vector<std::string>& files) {
+    const auto callback = [this, recursion, &files](u64* num_entries_out,
+                                                    const std::string& directory,
+                                                    const std::string& virtual_name) -> bool {
         if (stop_processing) {
             // Breaks the callback loop.
             return false;
@@ -45,67 +64,10 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
         const std::string physical_name = directory + DIR_SEP + virtual_name;
         const bool is_dir = FileUtil::IsDirectory(physical_name);
         if (!is_dir && HasSupportedFileExtension(physical_name)) {
-            std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
-            if (!loader)
-                return true;
-
-            bool executable = false;
-            loader->IsExecutable(executable);
-            if (!executable)
-                return true;
-
-            u64 program_id = 0;
-            loader->ReadProgramId(program_id);
-
-            u64 extdata_id = 0;
-            loader->ReadExtdataId(extdata_id);
-
-            std::vector<u8> smdh;
-            // Look for an update icon if available
-            if (!(program_id & ~0x00040000FFFFFFFF)) {
-                std::string update_path = Service::AM::GetTitleContentPath(
-                    Service::FS::MediaType::SDMC, program_id | 0x0000000E00000000);
-                if (FileUtil::Exists(update_path)) {
-                    std::unique_ptr<Loader::AppLoader> update_loader =
-                        Loader::GetLoader(update_path);
-                    if (update_loader) {
-                        update_loader->ReadIcon(smdh);
-                    }
-                }
-            }
-
-            if (!Loader::IsValidSMDH(smdh)) {
-                // Read the original smdh if there is no valid update smdh
-                loader->ReadIcon(smdh);
-            }
-
-            if (!Loader::IsValidSMDH(smdh) && UISettings::values.game_list_hide_no_icon) {
-                // Skip this invalid entry
-                return true;
-            }
-
-            auto it = FindMatchingCompatibilityEntry(compatibility_list, program_id);
-
-            // The game list uses this as compatibility number for untested games
-            QString compatibility(QStringLiteral("99"));
-            if (it != compatibility_list.end())
-                compatibility = it->second.first;
-
-            emit EntryReady(
-                {
-                    new GameListItemPath(QString::fromStdString(physical_name), smdh, program_id,
-                                         extdata_id),
-                    new GameListItemCompat(compatibility),
-                    new GameListItemRegion(smdh),
-                    new GameListItem(
-                        QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()))),
-                    new GameListItemSize(FileUtil::GetSize(physical_name)),
-                },
-                parent_dir);
-
+            files.push_back(physical_name);
         } else if (is_dir && recursion > 0) {
             watch_list.append(QString::fromStdString(physical_name));
-            AddFstEntriesToGameList(physical_name, recursion - 1, parent_dir);
+            ScanDirectory(physical_name, recursion - 1, files);
         }
 
         return true;
@@ -114,8 +76,139 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
     FileUtil::ForeachDirectoryEntry(nullptr, dir_path, callback);
 }
 
+GameListCache::Entry GameListWorker::LoadEntry(const std::string& physical_name) {
+    const u64 size = FileUtil::GetSize(physical_name);
+    const u64 modification_time = FileUtil::GetModificationTime(physical_name);
+    if (std::optional<GameListCache::Entry> cached =
+            cache.Find(physical_name, size, modification_time)) {
+        if (!cached->executable ||
+            cached->update_modification_time == GetUpdateModificationTime(cached->program_id)) {
+            cache.Add(physical_name, *cached);
+            return std::move(*cached);
+        }
+    }
+
+    GameListCache::Entry entry;
+    entry.size = size;
+    entry.modification_time = modification_time;
+
+    std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
+    if (!loader) {
+        // Not cached, the file might just be unreadable right now
+        return entry;
+    }
+
+    loader->IsExecutable(entry.executable);
+    if (entry.executable) {
+        loader->ReadProgramId(entry.program_id);
+        loader->ReadExtdataId(entry.extdata_id);
+        entry.file_type = static_cast<u32>(loader->GetFileType());
+
+        // Look for an update icon if available
+        entry.update_modification_time = GetUpdateModificationTime(entry.program_id);
+        if (entry.update_modification_time != 0) {
+            std::unique_ptr<Loader::AppLoader> update_loader =
+                Loader::GetLoader(GetUpdatePath(entry.program_id));
+            if (update_loader) {
+                update_loader->ReadIcon(entry.smdh);
+            }
+        }
+
+        if (!Loader::IsValidSMDH(entry.smdh)) {
+            // Read the original smdh if there is no valid update smdh
+            loader->ReadIcon(entry.smdh);
+        }
+    }
+
+    cache.Add(physical_name, entry);
+    return entry;
+}
+
+void GameListWorker::AddEntriesToGameList(const std::vector<std::string>& files,
+                                          GameListDir* parent_dir) {
+    if (files.empty())
+        return;
+
+    // Reading the headers is mostly waiting for the disk, which may be on the network, so use
+    // more threads than cores
+    const std::size_t num_threads =
+        std::min<std::size_t>(files.size(), std::max(4u, std::thread::hardware_concurrency()));
+
+    std::mutex mutex;
+    std::condition_variable entry_loaded;
+    std::vector<std::optional<GameListCache::Entry>> entries(files.size());
+    std::atomic<std::size_t> next_file{0};
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&] {
+            std::size_t index;
+            while (!stop_processing && (index = next_file++) < files.size()) {
+                GameListCache::Entry entry = LoadEntry(files[index]);
+                std::lock_guard lock{mutex};
+                entries[index] = std::move(entry);
+                entry_loaded.notify_all();
+            }
+            std::lock_guard lock{mutex};
+            entry_loaded.notify_all();
+        });
+    }
+
+    // Emit the entries in the order of the directory scan, as soon as they are loaded
+    for (std::size_t index = 0; index < files.size(); ++index) {
+        std::unique_lock lock{mutex};
+        entry_loaded.wait(lock, [&] { return stop_processing || entries[index].has_value(); });
+        if (stop_processing)
+            break;
+        const GameListCache::Entry entry = std::move(*entries[index]);
+        lock.unlock();
+
+        if (!entry.executable)
+            continue;
+
+        if (!Loader::IsValidSMDH(entry.smdh) && UISettings::values.game_list_hide_no_icon) {
+            // Skip this invalid entry
+            continue;
+        }
+
+        auto it = FindMatchingCompatibilityEntry(compatibility_list, entry.program_id);
+
+        // The game list uses this as compatibility number for untested games
+        QString compatibility(QStringLiteral("99"));
+        if (it != compatibility_list.end())
+            compatibility = it->second.first;
+
+        const auto file_type = static_cast<Loader::FileType>(entry.file_type);
+        emit EntryReady(
+            {
+                new GameListItemPath(QString::fromStdString(files[index]), entry.smdh,
+                                     entry.program_id, entry.extdata_id),
+                new GameListItemCompat(compatibility),
+                new GameListItemRegion(entry.smdh),
+                new GameListItem(QString::fromStdString(Loader::GetFileTypeString(file_type))),
+                new GameListItemSize(entry.size),
+            },
+            parent_dir);
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
+                                             GameListDir* parent_dir) {
+    std::vector<std::string> files;
+    ScanDirectory(dir_path, recursion, files);
+    AddEntriesToGameList(files, parent_dir);
+}
+
 void GameListWorker::run() {
     stop_processing = false;
+    cache.Load();
+    // Loaders may initialize the keys on first use, which isn't safe from several threads
+    HW::AES::InitKeys();
     for (UISettings::GameDir& game_dir : game_dirs) {
         if (game_dir.path == QStringLiteral("INSTALLED")) {
             QString games_path =
@@ -151,6 +244,8 @@ void GameListWorker::run() {
                                     game_list_dir);
         }
     };
+    if (!stop_processing)
+        cache.Save();
     emit Finished(watch_list);
 }
 
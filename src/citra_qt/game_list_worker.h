@@ -9,12 +9,14 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <QList>
 #include <QObject>
 #include <QRunnable>
 #include <QString>
 #include <QVector>
 #include "citra_qt/compatibility_list.h"
+#include "citra_qt/game_list_cache.h"
 #include "common/common_types.h"
 
 class QStandardItem;
@@ -53,11 +55,22 @@ signals:
     void Finished(QStringList watch_list);
 
 private:
+    /// Collects the files with a supported extension below dir_path
+    void ScanDirectory(const std::string& dir_path, unsigned int recursion,
+                       std::vector<std::string>& files);
+
+    /// Loads the metadata of the files on several threads and emits their entries in order
+    void AddEntriesToGameList(const std::vector<std::string>& files, GameListDir* parent_dir);
+
+    /// Returns the metadata of the file from the cache, reading the file if it changed
+    GameListCache::Entry LoadEntry(const std::string& physical_name);
+
     void AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
                                  GameListDir* parent_dir);
 
     QVector<UISettings::GameDir>& game_dirs;
     const CompatibilityList& compatibility_list;
+    GameListCache cache;
 
     QStringList watch_list;
     std::atomic_bool stop_processing;
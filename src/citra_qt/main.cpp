@@ -36,6 +36,7 @@
 #include "citra_qt/debugger/graphics/graphics.h"
 #include "citra_qt/debugger/graphics/graphics_breakpoints.h"
 #include "citra_qt/debugger/graphics/graphics_cmdlists.h"
+#include "citra_qt/debugger/graphics/graphics_gpu_profiler.h"
 #include "citra_qt/debugger/graphics/graphics_surface.h"
 #include "citra_qt/debugger/graphics/graphics_tracing.h"
 #include "citra_qt/debugger/graphics/graphics_vertex_shader.h"
@@ -132,7 +133,11 @@ static void InitializeLogging() {
 
     const std::string& log_dir = FileUtil::GetUserPath(FileUtil::UserPath::LogDir);
     FileUtil::CreateFullPath(log_dir);
-    Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+    if (Settings::values.binary_log) {
+        Log::EnableBinaryLog(log_dir + BINARY_LOG_FILE);
+    } else {
+        Log::AddBackend(std::make_unique<Log::FileBackend>(log_dir + LOG_FILE));
+    }
 #ifdef _WIN32
     Log::AddBackend(std::make_unique<Log::DebuggerBackend>());
 #endif
@@ -327,6 +332,11 @@ void GMainWindow::InitializeDebugWidgets() {
     graphicsVertexShaderWidget->hide();
     debug_menu->addAction(graphicsVertexShaderWidget->toggleViewAction());
 
+    graphicsGPUProfilerWidget = new GraphicsGPUProfilerWidget(this);
+    addDockWidget(Qt::RightDockWidgetArea, graphicsGPUProfilerWidget);
+    graphicsGPUProfilerWidget->hide();
+    debug_menu->addAction(graphicsGPUProfilerWidget->toggleViewAction());
+
     graphicsTracingWidget = new GraphicsTracingWidget(Pica::g_debug_context, this);
     addDockWidget(Qt::RightDockWidgetArea, graphicsTracingWidget);
     graphicsTracingWidget->hide();
@@ -456,6 +466,11 @@ void GMainWindow::InitializeHotkeys() {
     connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Toggle Texture Dumping"), this),
             &QShortcut::activated, this,
             [&] { Settings::values.dump_textures = !Settings::values.dump_textures; });
+    connect(hotkey_registry.GetHotkey(main_window, QStringLiteral("Toggle Turbo Mode"), this),
+            &QShortcut::activated, this, [&] {
+                Settings::values.turbo_mode = !Settings::values.turbo_mode;
+                UpdateStatusBar();
+            });
     // We use "static" here in order to avoid capturing by lambda due to a MSVC bug, which makes
     // the variable hold a garbage value after this function exits
     static constexpr u16 SPEED_LIMIT_STEP = 5;
@@ -569,6 +584,10 @@ void GMainWindow::ConnectWidgetEvents() {
     connect(game_list, &GameList::NavigateToGamedbEntryRequested, this,
             &GMainWindow::OnGameListNavigateToGamedbEntry);
     connect(game_list, &GameList::DumpRomFSRequested, this, &GMainWindow::OnGameListDumpRomFS);
+    connect(game_list, &GameList::ShaderCacheExportRequested, this,
+            &GMainWindow::OnGameListExportShaderCache);
+    connect(game_list, &GameList::ShaderCacheImportRequested, this,
+            &GMainWindow::OnGameListImportShaderCache);
     connect(game_list, &GameList::AddDirectory, this, &GMainWindow::OnGameListAddDirectory);
     connect(game_list_placeholder, &GameListPlaceholder::AddDirectory, this,
             &GMainWindow::OnGameListAddDirectory);
@@ -1221,6 +1240,47 @@ void GMainWindow::OnGameListDumpRomFS(QString game_path, u64 program_id) {
     future_watcher->setFuture(future);
 }
 
+void GMainWindow::OnGameListExportShaderCache(u64 program_id) {
+    const QString file_filter = tr("Shader Cache Bundle (%1)").arg(QStringLiteral("*.csb"));
+    const QString filename = QFileDialog::getSaveFileName(
+        this, tr("Export Shader Cache"),
+        QStringLiteral("%1.csb").arg(program_id, 16, 16, QLatin1Char{'0'}).toUpper(), file_filter);
+    if (filename.isEmpty())
+        return;
+
+    const auto exported = VideoCore::ExportShaderCacheBundle(program_id, filename.toStdString());
+    if (!exported) {
+        QMessageBox::critical(this, tr("Citra"),
+                              tr("Could not export the shader cache.
+Refer to the log for "
+                                 "details."));
+        return;
+    }
+    QMessageBox::information(this, tr("Citra"),
+                             tr("Exported %n shader(s).", "", static_cast<int>(*exported)));
+}
+
+void GMainWindow::OnGameListImportShaderCache(u64 program_id) {
+    const QString file_filter = tr("Shader Cache Bundle (%1)").arg(QStringLiteral("*.csb"));
+    const QString filename =
+        QFileDialog::getOpenFileName(this, tr("Import Shader Cache"), {}, file_filter);
+    if (filename.isEmpty())
+        return;
+
+    const auto imported = VideoCore::ImportShaderCacheBundle(program_id, filename.toStdString());
+    if (!imported) {
+        QMessageBox::critical(this, tr("Citra"),
+                              tr("Could not import the shader cache. The bundle may be of "
+                                 "another game.
+Refer to the log for details."));
+        return;
+    }
+    QMessageBox::information(
+        this, tr("Citra"),
+        tr("Imported %n new shader(s). They will be built the next time the game is started.", "",
+           static_cast<int>(*imported)));
+}
+
 void GMainWindow::OnGameListOpenDirectory(const QString& directory) {
     QString path;
     if (directory == QStringLiteral("INSTALLED")) {
@@ -1857,7 +1917,10 @@ void GMainWindow::UpdateStatusBar() {
 
     auto results = Core::System::GetInstance().GetAndResetPerfStats();
 
-    if (Settings::values.use_frame_limit) {
+    if (Settings::values.turbo_mode) {
+        emu_speed_label->setText(
+            tr("Speed: %1% (Turbo)").arg(results.emulation_speed * 100.0, 0, 'f', 0));
+    } else if (Settings::values.use_frame_limit) {
         emu_speed_label->setText(tr("Speed: %1% / %2%")
                                      .arg(results.emulation_speed * 100.0, 0, 'f', 0)
                                      .arg(Settings::values.frame_limit));
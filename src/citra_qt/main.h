@@ -27,6 +27,7 @@ class GImageInfo;
 class GPUCommandListWidget;
 class GPUCommandStreamWidget;
 class GraphicsBreakPointsWidget;
+class GraphicsGPUProfilerWidget;
 class GraphicsTracingWidget;
 class GraphicsVertexShaderWidget;
 class GRenderWindow;
@@ -170,6 +171,8 @@ private slots:
     void OnGameListNavigateToGamedbEntry(u64 program_id,
                                          const CompatibilityList& compatibility_list);
     void OnGameListDumpRomFS(QString game_path, u64 program_id);
+    void OnGameListExportShaderCache(u64 program_id);
+    void OnGameListImportShaderCache(u64 program_id);
     void OnGameListOpenDirectory(const QString& directory);
     void OnGameListAddDirectory();
     void OnGameListShowList(bool show);
@@ -266,6 +269,7 @@ private:
     GraphicsBreakPointsWidget* graphicsBreakpointsWidget;
     GraphicsVertexShaderWidget* graphicsVertexShaderWidget;
     GraphicsTracingWidget* graphicsTracingWidget;
+    GraphicsGPUProfilerWidget* graphicsGPUProfilerWidget;
     IPCRecorderWidget* ipcRecorderWidget;
     LLEServiceModulesWidget* lleServiceModulesWidget;
     WaitTreeWidget* waitTreeWidget;
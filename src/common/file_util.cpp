@@ -43,8 +43,13 @@
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <pwd.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/uio.h>
+#endif
 #endif
 
 #if defined(__APPLE__)
@@ -90,9 +95,7 @@ static void StripTailDirSlashes(std::string& fname) {
     fname.resize(i);
 }
 
-bool Exists(const std::string& filename) {
-    struct stat file_info;
-
+static int StatPath(const std::string& filename, struct stat* file_info) {
     std::string copy(filename);
     StripTailDirSlashes(copy);
 
@@ -101,31 +104,20 @@ bool Exists(const std::string& filename) {
     if (copy.size() != 0 && copy.back() == ':')
         copy += DIR_SEP_CHR;
 
-    int result = _wstat64(Common::UTF8ToUTF16W(copy).c_str(), &file_info);
+    return _wstat64(Common::UTF8ToUTF16W(copy).c_str(), file_info);
 #else
-    int result = stat(copy.c_str(), &file_info);
+    return stat(copy.c_str(), file_info);
 #endif
+}
 
-    return (result == 0);
+bool Exists(const std::string& filename) {
+    struct stat file_info;
+    return StatPath(filename, &file_info) == 0;
 }
 
 bool IsDirectory(const std::string& filename) {
     struct stat file_info;
-
-    std::string copy(filename);
-    StripTailDirSlashes(copy);
-
-#ifdef _WIN32
-    // Windows needs a slash to identify a driver root
-    if (copy.size() != 0 && copy.back() == ':')
-        copy += DIR_SEP_CHR;
-
-    int result = _wstat64(Common::UTF8ToUTF16W(copy).c_str(), &file_info);
-#else
-    int result = stat(copy.c_str(), &file_info);
-#endif
-
-    if (result < 0) {
+    if (StatPath(filename, &file_info) < 0) {
         LOG_DEBUG(Common_Filesystem, "stat failed on {}: {}", filename, GetLastErrorMsg());
         return false;
     }
@@ -133,6 +125,13 @@ bool IsDirectory(const std::string& filename) {
     return S_ISDIR(file_info.st_mode);
 }
 
+PathType GetPathType(const std::string& filename) {
+    struct stat file_info;
+    if (StatPath(filename, &file_info) < 0)
+        return PathType::NotFound;
+    return S_ISDIR(file_info.st_mode) ? PathType::Directory : PathType::File;
+}
+
 bool Delete(const std::string& filename) {
     LOG_TRACE(Common_Filesystem, "file {}", filename);
 
@@ -263,6 +262,21 @@ bool Rename(const std::string& srcFilename, const std::string& destFilename) {
     return false;
 }
 
+bool CreateHardLink(const std::string& srcFilename, const std::string& destFilename) {
+    LOG_TRACE(Common_Filesystem, "{} --> {}", srcFilename, destFilename);
+#ifdef _WIN32
+    if (CreateHardLinkW(Common::UTF8ToUTF16W(destFilename).c_str(),
+                        Common::UTF8ToUTF16W(srcFilename).c_str(), nullptr))
+        return true;
+#else
+    if (link(srcFilename.c_str(), destFilename.c_str()) == 0)
+        return true;
+#endif
+    LOG_ERROR(Common_Filesystem, "failed {} --> {}: {}", srcFilename, destFilename,
+              GetLastErrorMsg());
+    return false;
+}
+
 bool Copy(const std::string& srcFilename, const std::string& destFilename) {
     LOG_TRACE(Common_Filesystem, "{} --> {}", srcFilename, destFilename);
 #ifdef _WIN32
@@ -353,6 +367,21 @@ u64 GetSize(const int fd) {
     return buf.st_size;
 }
 
+u64 GetModificationTime(const std::string& filename) {
+    struct stat buf;
+#ifdef _WIN32
+    if (_wstat64(Common::UTF8ToUTF16W(filename).c_str(), &buf) == 0)
+#else
+    if (stat(filename.c_str(), &buf) == 0)
+#endif
+    {
+        return static_cast<u64>(buf.st_mtime);
+    }
+
+    LOG_ERROR(Common_Filesystem, "Stat failed {}: {}", filename, GetLastErrorMsg());
+    return 0;
+}
+
 u64 GetSize(FILE* f) {
     // can't use off_t here because it can be 32-bit
     u64 pos = ftello(f);
@@ -438,6 +467,89 @@ bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
     return true;
 }
 
+struct DirectoryIterator::Impl {
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    /// The entry found by the last call to FindFirstFileW or FindNextFileW
+    WIN32_FIND_DATAW ffd;
+    bool has_entry = false;
+#else
+    DIR* dirp = nullptr;
+#endif
+};
+
+DirectoryIterator::DirectoryIterator(const std::string& directory)
+    : directory(directory), impl(std::make_unique<Impl>()) {
+    LOG_TRACE(Common_Filesystem, "directory {}", directory);
+#ifdef _WIN32
+    impl->handle = FindFirstFileW(Common::UTF8ToUTF16W(directory + "\\*").c_str(), &impl->ffd);
+    impl->has_entry = impl->handle != INVALID_HANDLE_VALUE;
+#else
+    impl->dirp = opendir(directory.c_str());
+#endif
+}
+
+DirectoryIterator::~DirectoryIterator() {
+#ifdef _WIN32
+    if (impl->handle != INVALID_HANDLE_VALUE)
+        FindClose(impl->handle);
+#else
+    if (impl->dirp != nullptr)
+        closedir(impl->dirp);
+#endif
+}
+
+bool DirectoryIterator::IsOpen() const {
+#ifdef _WIN32
+    return impl->handle != INVALID_HANDLE_VALUE;
+#else
+    return impl->dirp != nullptr;
+#endif
+}
+
+bool DirectoryIterator::Next(FSTEntry& entry) {
+    while (true) {
+#ifdef _WIN32
+        if (!impl->has_entry)
+            return false;
+        const WIN32_FIND_DATAW& ffd = impl->ffd;
+        entry.virtualName = Common::UTF16ToUTF8(ffd.cFileName);
+        // The attributes and the size come with the entry, no stat is needed
+        entry.isDirectory = (ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        entry.size = entry.isDirectory
+                         ? 0
+                         : static_cast<u64>(ffd.nFileSizeHigh) << 32 | ffd.nFileSizeLow;
+        impl->has_entry = FindNextFileW(impl->handle, &impl->ffd) != 0;
+#else
+        if (impl->dirp == nullptr)
+            return false;
+        const struct dirent* result = readdir(impl->dirp);
+        if (result == nullptr)
+            return false;
+        entry.virtualName = result->d_name;
+#endif
+
+        if (entry.virtualName == "." || entry.virtualName == "..")
+            continue;
+
+        entry.physicalName = directory + DIR_SEP + entry.virtualName;
+        entry.children.clear();
+#ifndef _WIN32
+        // Directories need no stat when the file system reports the entry type
+        if (result->d_type == DT_DIR) {
+            entry.isDirectory = true;
+            entry.size = 0;
+        } else {
+            struct stat file_info;
+            const bool found = StatPath(entry.physicalName, &file_info) == 0;
+            entry.isDirectory = found && S_ISDIR(file_info.st_mode);
+            entry.size = found && !entry.isDirectory ? static_cast<u64>(file_info.st_size) : 0;
+        }
+#endif
+        return true;
+    }
+}
+
 u64 ScanDirectoryTree(const std::string& directory, FSTEntry& parent_entry,
                       unsigned int recursion) {
     const auto callback = [recursion, &parent_entry](u64* num_entries_out,
@@ -952,6 +1064,105 @@ u64 IOFile::Tell() const {
     return std::numeric_limits<u64>::max();
 }
 
+std::size_t IOFile::ReadAt(u64 offset, void* data, std::size_t length) {
+    if (!IsOpen()) {
+        m_good = false;
+        return 0;
+    }
+
+    auto* const buffer = static_cast<u8*>(data);
+    std::size_t done = 0;
+#ifdef _WIN32
+    // Positioned reads still move the position of synchronous handles, so the stream is put back
+    // to where it was afterwards
+    const s64 position = ftello(m_file);
+    const HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(fileno(m_file)));
+    while (done < length) {
+        const u64 read_offset = offset + done;
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(read_offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(read_offset >> 32);
+        const DWORD chunk = static_cast<DWORD>(
+            std::min<std::size_t>(length - done, std::numeric_limits<DWORD>::max()));
+        DWORD read = 0;
+        if (!ReadFile(handle, buffer + done, chunk, &read, &overlapped) || read == 0)
+            break;
+        done += read;
+    }
+    fseeko(m_file, position, SEEK_SET);
+#else
+    const int fd = fileno(m_file);
+    while (done < length) {
+        const ssize_t result = pread(fd, buffer + done, length - done, offset + done);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            break;
+        done += static_cast<std::size_t>(result);
+    }
+#endif
+
+    if (done != length)
+        m_good = false;
+    return done;
+}
+
+bool IOFile::ReadRanges(const ReadRange* ranges, std::size_t count) {
+#ifdef __linux__
+    if (!IsOpen()) {
+        m_good = false;
+        return false;
+    }
+
+    constexpr std::size_t MAX_RANGES_PER_READ = 64;
+    std::array<iovec, MAX_RANGES_PER_READ> iovecs;
+    std::size_t first = 0;
+    while (first < count) {
+        // Gather the ranges that continue where the previous one ends
+        std::size_t num_ranges = 0;
+        std::size_t total_length = 0;
+        do {
+            const ReadRange& range = ranges[first + num_ranges];
+            iovecs[num_ranges] = {range.data, range.length};
+            total_length += range.length;
+            ++num_ranges;
+        } while (first + num_ranges < count && num_ranges < MAX_RANGES_PER_READ &&
+                 ranges[first + num_ranges].offset == ranges[first + num_ranges - 1].offset +
+                                                          ranges[first + num_ranges - 1].length);
+
+        ssize_t result;
+        do {
+            result = preadv(fileno(m_file), iovecs.data(), static_cast<int>(num_ranges),
+                            static_cast<off_t>(ranges[first].offset));
+        } while (result < 0 && errno == EINTR);
+
+        // Finish the ranges a short read stopped in one by one
+        std::size_t done = result > 0 ? static_cast<std::size_t>(result) : 0;
+        if (done < total_length) {
+            for (std::size_t i = first; i < first + num_ranges; ++i) {
+                const ReadRange& range = ranges[i];
+                if (done >= range.length) {
+                    done -= range.length;
+                    continue;
+                }
+                const std::size_t rest = range.length - done;
+                if (ReadAt(range.offset + done, static_cast<u8*>(range.data) + done, rest) != rest)
+                    return false;
+                done = 0;
+            }
+        }
+        first += num_ranges;
+    }
+    return true;
+#else
+    for (std::size_t i = 0; i < count; ++i) {
+        if (ReadAt(ranges[i].offset, ranges[i].data, ranges[i].length) != ranges[i].length)
+            return false;
+    }
+    return true;
+#endif
+}
+
 bool IOFile::Flush() {
     if (!IsOpen() || 0 != std::fflush(m_file))
         m_good = false;
@@ -975,4 +1186,80 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+MappedFile::MappedFile() = default;
+
+MappedFile::MappedFile(const std::string& filename) {
+    Open(filename);
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Common::UTF8ToUTF16W(filename).c_str(), GENERIC_READ,
+                              FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The mapping keeps the file open, so its handle isn't needed anymore
+    m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (m_mapping == nullptr)
+        return false;
+
+    m_data = static_cast<const u8*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+        return false;
+    }
+    m_size = static_cast<std::size_t>(size.QuadPart);
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat file_info;
+    if (fstat(fd, &file_info) != 0 || file_info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    // The mapping keeps the file open, so the descriptor isn't needed anymore
+    void* const data =
+        mmap(nullptr, static_cast<std::size_t>(file_info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<const u8*>(data);
+    m_size = static_cast<std::size_t>(file_info.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::Close() {
+    if (!IsOpen())
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapping);
+    m_mapping = nullptr;
+#else
+    munmap(const_cast<u8*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
 } // namespace FileUtil
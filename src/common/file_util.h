@@ -6,9 +6,11 @@
 
 #include <array>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -53,6 +55,11 @@ bool Exists(const std::string& filename);
 // Returns true if filename is a directory
 bool IsDirectory(const std::string& filename);
 
+enum class PathType { NotFound, File, Directory };
+
+// Returns what filename is on the host, with a single stat instead of Exists and IsDirectory
+PathType GetPathType(const std::string& filename);
+
 // Returns the size of filename (64bit)
 u64 GetSize(const std::string& filename);
 
@@ -62,6 +69,9 @@ u64 GetSize(const int fd);
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE* f);
 
+// Returns the last modification time of filename in seconds since the epoch, 0 on failure
+u64 GetModificationTime(const std::string& filename);
+
 // Returns true if successful, or path already exists.
 bool CreateDir(const std::string& filename);
 
@@ -78,6 +88,9 @@ bool DeleteDir(const std::string& filename);
 // renames file srcFilename to destFilename, returns true on success
 bool Rename(const std::string& srcFilename, const std::string& destFilename);
 
+// creates a hard link destFilename to the existing file srcFilename, returns true on success
+bool CreateHardLink(const std::string& srcFilename, const std::string& destFilename);
+
 // copies file srcFilename to destFilename, returns true on success
 bool Copy(const std::string& srcFilename, const std::string& destFilename);
 
@@ -106,6 +119,31 @@ using DirectoryEntryCallable = std::function<bool(
 bool ForeachDirectoryEntry(u64* num_entries_out, const std::string& directory,
                            DirectoryEntryCallable callback);
 
+/**
+ * Reads the entries of a directory one at a time as they are requested, unlike
+ * ForeachDirectoryEntry, which reads all of them at once. The "." and ".." entries are skipped.
+ */
+class DirectoryIterator : public NonCopyable {
+public:
+    explicit DirectoryIterator(const std::string& directory);
+    ~DirectoryIterator();
+
+    /// Returns whether the directory could be opened
+    bool IsOpen() const;
+
+    /**
+     * Reads the next entry without its children, the size of a directory is 0.
+     * @return false once all entries have been read
+     */
+    bool Next(FSTEntry& entry);
+
+private:
+    struct Impl;
+
+    std::string directory;
+    std::unique_ptr<Impl> impl;
+};
+
 /**
  * Scans the directory tree, storing the results.
  * @param directory the parent directory to start scanning from
@@ -280,6 +318,28 @@ public:
         return WriteArray(str.data(), str.length());
     }
 
+    /// A range of the file and the buffer it is read into
+    struct ReadRange {
+        u64 offset;
+        void* data;
+        std::size_t length;
+    };
+
+    /**
+     * Reads at the given offset with a positioned read, so neither the file position is moved nor
+     * is the data copied through the stream buffer. Data written through the stream has to be
+     * flushed first.
+     * @returns the number of bytes read
+     */
+    std::size_t ReadAt(u64 offset, void* data, std::size_t length);
+
+    /**
+     * Reads several ranges at once with ReadAt. Ranges that follow each other in the file are
+     * gathered into a single vectored read where the host supports it.
+     * @returns true if all ranges were read completely
+     */
+    bool ReadRanges(const ReadRange* ranges, std::size_t count);
+
     bool IsOpen() const {
         return nullptr != m_file;
     }
@@ -309,6 +369,100 @@ private:
     bool m_good = true;
 };
 
+// Read-only memory mapping of a whole file, so that large files can be read without loading
+// them into memory first
+class MappedFile : public NonCopyable {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const {
+        return m_data != nullptr;
+    }
+
+    const u8* GetData() const {
+        return m_data;
+    }
+
+    std::size_t GetSize() const {
+        return m_size;
+    }
+
+    /// Returns a pointer to the given range of the mapping, or nullptr if it is out of bounds
+    const u8* ReadSpan(std::size_t offset, std::size_t length) const {
+        if (offset > m_size || length > m_size - offset)
+            return nullptr;
+        return m_data + offset;
+    }
+
+private:
+    const u8* m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    void* m_mapping = nullptr;
+#endif
+};
+
+/// Reads a MappedFile from start to end with the interface of IOFile, but without any syscalls
+class MappedFileReader {
+public:
+    explicit MappedFileReader(const MappedFile& file) : m_file(file) {}
+
+    /// Returns the next bytes of the file and advances past them, or nullptr at the end of file
+    const u8* ReadSpan(std::size_t length) {
+        const u8* const span = m_file.ReadSpan(m_offset, length);
+        if (span == nullptr) {
+            m_good = false;
+            return nullptr;
+        }
+        m_offset += length;
+        return span;
+    }
+
+    /// Copies the next items out of the file, reads either all of them or none
+    template <typename T>
+    std::size_t ReadArray(T* data, std::size_t length) {
+        static_assert(std::is_trivially_copyable_v<T>,
+                      "Given array does not consist of trivially copyable objects");
+        if (length > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            m_good = false;
+            return 0;
+        }
+        const u8* const span = ReadSpan(length * sizeof(T));
+        if (span == nullptr)
+            return 0;
+        std::memcpy(data, span, length * sizeof(T));
+        return length;
+    }
+
+    template <typename T>
+    std::size_t ReadBytes(T* data, std::size_t length) {
+        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+        return ReadArray(reinterpret_cast<char*>(data), length);
+    }
+
+    std::size_t Tell() const {
+        return m_offset;
+    }
+
+    std::size_t GetSize() const {
+        return m_file.GetSize();
+    }
+
+    bool IsGood() const {
+        return m_good;
+    }
+
+private:
+    const MappedFile& m_file;
+    std::size_t m_offset = 0;
+    bool m_good = true;
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
@@ -3,13 +3,16 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <regex>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 #ifdef _WIN32
 #include <share.h>   // For _SH_DENYWR
@@ -19,6 +22,7 @@
 #endif
 #include "common/assert.h"
 #include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
 #include "common/string_util.h"
@@ -26,6 +30,48 @@
 
 namespace Log {
 
+// Lets every message through until the backend is created and sets the default filter
+std::array<std::atomic<Level>, static_cast<std::size_t>(Class::Count)> Detail::class_levels;
+
+namespace {
+
+/// Prevents logs from growing over this size, in case something is spamming them
+constexpr std::size_t MAX_BYTES_WRITTEN = 50 * 1024L * 1024L;
+
+/**
+ * The messages of one thread in the binary mode as a ring of records. Only the owning thread
+ * writes to it and only the logging thread reads from it, so neither needs a lock.
+ */
+struct MessageRing {
+    static constexpr std::size_t SIZE = 1024 * 1024;
+
+    std::unique_ptr<u8[]> data = std::make_unique<u8[]>(SIZE);
+    /// Total number of bytes ever written and read
+    std::atomic<u64> written{0};
+    std::atomic<u64> read{0};
+};
+
+/// Header of the records in a MessageRing, followed by the encoded arguments
+struct RingRecord {
+    u32 size; ///< Including the header
+    Class log_class;
+    Level log_level;
+    u8 arg_count;
+    u32 line_num;
+    s64 timestamp;
+    const char* filename;
+    const char* function;
+    const char* format;
+};
+
+/// Used by messages whose arguments had to be formatted when they were logged
+constexpr const char* PREFORMATTED = "{}";
+
+thread_local std::shared_ptr<MessageRing> thread_ring;
+thread_local std::vector<u8> thread_record;
+
+} // Anonymous namespace
+
 /**
  * Static state as a singleton.
  */
@@ -58,12 +104,87 @@ public:
         backends.erase(it, backends.end());
     }
 
-    const Filter& GetGlobalFilter() const {
-        return filter;
+    void EnableBinaryLog(const std::string& filename) {
+        if (binary_thread.joinable())
+            return;
+
+        binary_file = FileUtil::IOFile(filename, "wb", _SH_DENYWR);
+        if (!binary_file.IsOpen())
+            return;
+        const u32 header[] = {Binary::MAGIC, Binary::VERSION};
+        binary_bytes_written = binary_file.WriteBytes(header, sizeof(header));
+
+        binary_thread = std::thread([this] {
+            while (!stop_binary) {
+                {
+                    std::unique_lock lock{wake_mutex};
+                    wake_cv.wait_for(lock, FLUSH_INTERVAL,
+                                     [this] { return wake_pending.load() || stop_binary; });
+                }
+                wake_pending = false;
+                DrainRings();
+            }
+            DrainRings();
+        });
+        binary = true;
+    }
+
+    bool IsBinary() const {
+        return binary.load(std::memory_order_relaxed);
+    }
+
+    void PushBinary(Class log_class, Level log_level, const char* filename, unsigned int line_num,
+                    const char* function, const char* format, const fmt::format_args& args) {
+        std::vector<u8>& record = thread_record;
+        record.resize(sizeof(RingRecord));
+        int arg_count = Binary::EncodeArgs(record, args);
+        if (arg_count < 0 || record.size() > MessageRing::SIZE / 4) {
+            // Custom formatters can only be used right away
+            std::string message = fmt::vformat(format, args);
+            message.resize(std::min(message.size(), Binary::MAX_STRING_SIZE));
+            record.resize(sizeof(RingRecord));
+            arg_count = Binary::EncodeArgs(record, fmt::make_format_args(message));
+            format = PREFORMATTED;
+        }
+
+        RingRecord header;
+        header.size = static_cast<u32>(record.size());
+        header.log_class = log_class;
+        header.log_level = log_level;
+        header.arg_count = static_cast<u8>(arg_count);
+        header.line_num = line_num;
+        header.timestamp = GetTimestamp().count();
+        header.filename = filename;
+        header.function = function;
+        header.format = format;
+        std::memcpy(record.data(), &header, sizeof(header));
+
+        MessageRing& ring = GetThreadRing();
+        const u64 written = ring.written.load(std::memory_order_relaxed);
+        while (written + record.size() - ring.read.load(std::memory_order_acquire) >
+               MessageRing::SIZE) {
+            WakeBinaryThread();
+            std::this_thread::yield();
+        }
+        const std::size_t offset = written % MessageRing::SIZE;
+        const std::size_t first = std::min(record.size(), MessageRing::SIZE - offset);
+        std::memcpy(ring.data.get() + offset, record.data(), first);
+        std::memcpy(ring.data.get(), record.data() + first, record.size() - first);
+        ring.written.store(written + record.size(), std::memory_order_release);
+
+        if (log_level >= Level::Error ||
+            written + record.size() - ring.read.load(std::memory_order_relaxed) >
+                MessageRing::SIZE / 2) {
+            WakeBinaryThread();
+        }
     }
 
     void SetGlobalFilter(const Filter& f) {
         filter = f;
+        for (std::size_t i = 0; i < Detail::class_levels.size(); ++i) {
+            Detail::class_levels[i].store(filter.GetClassLevel(static_cast<Class>(i)),
+                                          std::memory_order_relaxed);
+        }
     }
 
     Backend* GetBackend(std::string_view backend_name) {
@@ -77,6 +198,7 @@ public:
 
 private:
     Impl() {
+        SetGlobalFilter(filter);
         backend_thread = std::thread([&] {
             Entry entry;
             auto write_logs = [&](Entry& e) {
@@ -85,12 +207,21 @@ private:
                     backend->Write(e);
                 }
             };
-            while (true) {
-                entry = message_queue.PopWait();
-                if (entry.final_entry) {
-                    break;
-                }
-                write_logs(entry);
+            // Entries are written in batches, which keeps the producers' slots free while a slow
+            // backend is writing
+            constexpr std::size_t MAX_BATCH_SIZE = 64;
+            bool final_entry = false;
+            while (!final_entry) {
+                message_queue.Wait();
+                message_queue.PopBatch(
+                    [&](Entry& e) {
+                        if (e.final_entry) {
+                            final_entry = true;
+                        } else if (!final_entry) {
+                            write_logs(e);
+                        }
+                    },
+                    MAX_BATCH_SIZE);
             }
 
             // Drain the logging queue. Only writes out up to MAX_LOGS_TO_WRITE to prevent a case
@@ -104,20 +235,30 @@ private:
     }
 
     ~Impl() {
+        if (binary_thread.joinable()) {
+            {
+                std::lock_guard lock{wake_mutex};
+                stop_binary = true;
+            }
+            wake_cv.notify_one();
+            binary_thread.join();
+        }
+
         Entry entry;
         entry.final_entry = true;
         message_queue.Push(entry);
         backend_thread.join();
     }
 
+    std::chrono::microseconds GetTimestamp() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - time_origin);
+    }
+
     Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
                       const char* function, std::string message) const {
-        using std::chrono::duration_cast;
-        using std::chrono::steady_clock;
-
         Entry entry;
-        entry.timestamp =
-            duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+        entry.timestamp = GetTimestamp();
         entry.log_class = log_class;
         entry.log_level = log_level;
         entry.filename = filename;
@@ -128,12 +269,163 @@ private:
         return entry;
     }
 
+    MessageRing& GetThreadRing() {
+        if (!thread_ring) {
+            thread_ring = std::make_shared<MessageRing>();
+            std::lock_guard lock{rings_mutex};
+            rings.push_back(thread_ring);
+        }
+        return *thread_ring;
+    }
+
+    void WakeBinaryThread() {
+        if (!wake_pending.exchange(true)) {
+            std::lock_guard lock{wake_mutex};
+            wake_cv.notify_one();
+        }
+    }
+
+    /// Copies the new records of all threads, ordered by their timestamp, and writes them out
+    void DrainRings() {
+        std::vector<std::shared_ptr<MessageRing>> current_rings;
+        {
+            std::lock_guard lock{rings_mutex};
+            current_rings = rings;
+            // Rings of threads that exited are dropped once they've been drained
+            rings.erase(std::remove_if(rings.begin(), rings.end(),
+                                       [](const auto& ring) {
+                                           return ring.use_count() == 1 &&
+                                                  ring->read == ring->written;
+                                       }),
+                        rings.end());
+        }
+
+        drained.clear();
+        for (const auto& ring : current_rings) {
+            const u64 written = ring->written.load(std::memory_order_acquire);
+            const u64 read = ring->read.load(std::memory_order_relaxed);
+            const std::size_t start = drained.size();
+            const std::size_t size = static_cast<std::size_t>(written - read);
+            const std::size_t offset = read % MessageRing::SIZE;
+            const std::size_t first = std::min(size, MessageRing::SIZE - offset);
+            drained.resize(start + size);
+            std::memcpy(drained.data() + start, ring->data.get() + offset, first);
+            std::memcpy(drained.data() + start + first, ring->data.get(), size - first);
+            ring->read.store(written, std::memory_order_release);
+        }
+
+        records.clear();
+        for (std::size_t offset = 0; offset < drained.size();) {
+            RingRecord header;
+            std::memcpy(&header, drained.data() + offset, sizeof(header));
+            records.emplace_back(header.timestamp, offset);
+            offset += header.size;
+        }
+        // Records of each thread are already in order
+        std::stable_sort(records.begin(), records.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        bool flush = false;
+        for (const auto& [timestamp, offset] : records) {
+            RingRecord header;
+            std::memcpy(&header, drained.data() + offset, sizeof(header));
+            const u8* const args = drained.data() + offset + sizeof(RingRecord);
+            const std::size_t args_size = header.size - sizeof(RingRecord);
+            WriteBinaryRecord(header, args, args_size);
+            flush |= header.log_level >= Level::Error;
+
+            std::lock_guard lock{writing_mutex};
+            if (backends.empty())
+                continue;
+            Entry entry;
+            entry.timestamp = std::chrono::microseconds{header.timestamp};
+            entry.log_class = header.log_class;
+            entry.log_level = header.log_level;
+            entry.filename = header.filename;
+            entry.line_num = header.line_num;
+            entry.function = header.function;
+            entry.message = Binary::FormatEncoded(header.format, args, args_size, header.arg_count);
+            for (const auto& backend : backends) {
+                backend->Write(entry);
+            }
+        }
+
+        if (!file_buffer.empty() && binary_bytes_written <= MAX_BYTES_WRITTEN) {
+            binary_bytes_written += binary_file.WriteBytes(file_buffer.data(), file_buffer.size());
+            if (flush) {
+                binary_file.Flush();
+            }
+        }
+        file_buffer.clear();
+    }
+
+    void WriteBinaryRecord(const RingRecord& header, const u8* args, std::size_t args_size) {
+        const u32 filename_id = GetStringId(header.filename);
+        const u32 function_id = GetStringId(header.function);
+        const u32 format_id = GetStringId(header.format);
+
+        const auto append = [this](const auto& value) {
+            const auto* const bytes = reinterpret_cast<const u8*>(&value);
+            file_buffer.insert(file_buffer.end(), bytes, bytes + sizeof(value));
+        };
+        append(Binary::RecordType::Message);
+        append(header.log_class);
+        append(header.log_level);
+        append(header.arg_count);
+        append(header.line_num);
+        append(header.timestamp);
+        append(filename_id);
+        append(function_id);
+        append(format_id);
+        append(static_cast<u32>(args_size));
+        file_buffer.insert(file_buffer.end(), args, args + args_size);
+    }
+
+    /// Returns the ID of a string, storing it in the file the first time it is used
+    u32 GetStringId(const char* str) {
+        const auto [it, inserted] = string_ids.emplace(str, static_cast<u32>(string_ids.size()));
+        if (inserted) {
+            const u32 length = static_cast<u32>(std::strlen(str));
+            const auto append = [this](const auto& value) {
+                const auto* const bytes = reinterpret_cast<const u8*>(&value);
+                file_buffer.insert(file_buffer.end(), bytes, bytes + sizeof(value));
+            };
+            append(Binary::RecordType::String);
+            append(it->second);
+            append(length);
+            file_buffer.insert(file_buffer.end(), str, str + length);
+        }
+        return it->second;
+    }
+
+    /// Longest time binary messages wait before they are written
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL{20};
+
     std::mutex writing_mutex;
     std::thread backend_thread;
     std::vector<std::unique_ptr<Backend>> backends;
-    Common::MPSCQueue<Log::Entry> message_queue;
+    /// Sized for bursts of verbose logging, producers wait for the backend thread when it's full
+    Common::BoundedMPMCQueue<Log::Entry, 4096> message_queue;
     Filter filter;
     std::chrono::steady_clock::time_point time_origin{std::chrono::steady_clock::now()};
+
+    std::atomic_bool binary{false};
+    std::thread binary_thread;
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    std::atomic_bool wake_pending{false};
+    bool stop_binary = false;
+
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<MessageRing>> rings;
+
+    // Only used by the binary thread
+    FileUtil::IOFile binary_file;
+    std::size_t binary_bytes_written = 0;
+    std::vector<u8> drained;
+    std::vector<std::pair<s64, std::size_t>> records;
+    std::vector<u8> file_buffer;
+    std::unordered_map<const char*, u32> string_ids;
 };
 
 void ConsoleBackend::Write(const Entry& entry) {
@@ -150,9 +442,6 @@ FileBackend::FileBackend(const std::string& filename)
     : file(filename, "w", _SH_DENYWR), bytes_written(0) {}
 
 void FileBackend::Write(const Entry& entry) {
-    // prevent logs from going over the maximum size (in case its spamming and the user doesn't
-    // know)
-    constexpr std::size_t MAX_BYTES_WRITTEN = 50 * 1024L * 1024L;
     if (!file.IsOpen() || bytes_written > MAX_BYTES_WRITTEN) {
         return;
     }
@@ -201,6 +490,7 @@ void DebuggerBackend::Write(const Entry& entry) {
     SUB(Service, PTM)                                                                              \
     SUB(Service, LDR)                                                                              \
     SUB(Service, MIC)                                                                              \
+    SUB(Service, MVD)                                                                              \
     SUB(Service, NDM)                                                                              \
     SUB(Service, NFC)                                                                              \
     SUB(Service, NIM)                                                                              \
@@ -291,14 +581,21 @@ Backend* GetBackend(std::string_view backend_name) {
     return Impl::Instance().GetBackend(backend_name);
 }
 
+void EnableBinaryLog(const std::string& filename) {
+    Impl::Instance().EnableBinaryLog(filename);
+}
+
 void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
                        unsigned int line_num, const char* function, const char* format,
                        const fmt::format_args& args) {
     auto& instance = Impl::Instance();
-    const auto& filter = instance.GetGlobalFilter();
-    if (!filter.CheckMessage(log_class, log_level))
+    if (!IsLogged(log_class, log_level))
         return;
 
+    if (instance.IsBinary()) {
+        instance.PushBinary(log_class, log_level, filename, line_num, function, format, args);
+        return;
+    }
     instance.PushEntry(log_class, log_level, filename, line_num, function,
                        fmt::vformat(format, args));
 }
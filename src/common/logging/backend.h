@@ -125,6 +125,14 @@ void RemoveBackend(std::string_view backend_name);
 
 Backend* GetBackend(std::string_view backend_name);
 
+/**
+ * Writes all following messages to the file in the binary log format (see binary_log.h) instead of
+ * formatting them on the calling thread. The other backends still receive every message, formatted
+ * on the logging thread. The file name, function and format string of the messages must have
+ * static storage, which is the case for all LOG_ macros.
+ */
+void EnableBinaryLog(const std::string& filename);
+
 /**
  * Returns the name of the passed log class as a C-string. Subclasses are separated by periods
  * instead of underscores as in the enumeration.
@@ -0,0 +1,265 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <type_traits>
+// dynamic_format_arg_store moved out of core.h in fmt 7.1
+#if __has_include(<fmt/args.h>)
+#include <fmt/args.h>
+#endif
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+
+namespace Log::Binary {
+
+namespace {
+
+template <typename T>
+void Append(std::vector<u8>& buffer, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const std::size_t offset = buffer.size();
+    buffer.resize(offset + sizeof(T));
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+void AppendString(std::vector<u8>& buffer, const char* data, std::size_t size) {
+    size = std::min(size, MAX_STRING_SIZE);
+    Append(buffer, static_cast<u32>(size));
+    buffer.insert(buffer.end(), data, data + size);
+}
+
+template <typename T>
+bool EncodeValue(std::vector<u8>& buffer, T value) {
+    if constexpr (std::is_same_v<T, bool>) {
+        Append(buffer, ArgType::Bool);
+        Append(buffer, static_cast<u8>(value));
+    } else if constexpr (std::is_same_v<T, char>) {
+        Append(buffer, ArgType::Char);
+        Append(buffer, value);
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) <= sizeof(u64)) {
+        if constexpr (std::is_signed_v<T>) {
+            Append(buffer, ArgType::Signed);
+            Append(buffer, static_cast<s64>(value));
+        } else {
+            Append(buffer, ArgType::Unsigned);
+            Append(buffer, static_cast<u64>(value));
+        }
+    } else if constexpr (std::is_same_v<T, float>) {
+        Append(buffer, ArgType::Float);
+        Append(buffer, value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        Append(buffer, ArgType::Double);
+        Append(buffer, static_cast<double>(value));
+    } else if constexpr (std::is_same_v<T, const char*>) {
+        Append(buffer, ArgType::String);
+        AppendString(buffer, value, std::strlen(value));
+    } else if constexpr (std::is_same_v<T, fmt::string_view>) {
+        Append(buffer, ArgType::String);
+        AppendString(buffer, value.data(), value.size());
+    } else if constexpr (std::is_same_v<T, const void*>) {
+        Append(buffer, ArgType::Pointer);
+        Append(buffer, static_cast<u64>(reinterpret_cast<uintptr_t>(value)));
+    } else {
+        // Custom formatters and 128-bit integers
+        return false;
+    }
+    return true;
+}
+
+/// Reads values from a buffer, failing once the end is reached
+class Reader {
+public:
+    Reader(const u8* data, std::size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        if (size - position < sizeof(T))
+            return false;
+        std::memcpy(&value, data + position, sizeof(T));
+        position += sizeof(T);
+        return true;
+    }
+
+    bool ReadString(std::string& value) {
+        u32 length;
+        if (!Read(length) || size - position < length)
+            return false;
+        value.assign(reinterpret_cast<const char*>(data + position), length);
+        position += length;
+        return true;
+    }
+
+    /// Returns the next bytes of the buffer and skips them
+    const u8* Skip(std::size_t length) {
+        if (size - position < length)
+            return nullptr;
+        const u8* const result = data + position;
+        position += length;
+        return result;
+    }
+
+private:
+    const u8* data;
+    std::size_t size;
+    std::size_t position = 0;
+};
+
+} // Anonymous namespace
+
+int EncodeArgs(std::vector<u8>& buffer, const fmt::format_args& args) {
+    const std::size_t start = buffer.size();
+    int count = 0;
+    for (auto arg = args.get(count); arg; arg = args.get(++count)) {
+        const bool encoded = count < 255 && fmt::visit_format_arg(
+                                                [&buffer](auto value) {
+                                                    return EncodeValue(buffer, value);
+                                                },
+                                                arg);
+        if (!encoded) {
+            buffer.resize(start);
+            return -1;
+        }
+    }
+    return count;
+}
+
+std::string FormatEncoded(const char* format, const u8* args, std::size_t size, u8 count) {
+    fmt::dynamic_format_arg_store<fmt::format_context> store;
+    Reader reader(args, size);
+    for (u8 i = 0; i < count; ++i) {
+        ArgType type;
+        if (!reader.Read(type))
+            return fmt::format("{} (truncated arguments)", format);
+
+        bool valid = false;
+        switch (type) {
+        case ArgType::Signed: {
+            s64 value;
+            valid = reader.Read(value);
+            store.push_back(value);
+            break;
+        }
+        case ArgType::Unsigned: {
+            u64 value;
+            valid = reader.Read(value);
+            store.push_back(value);
+            break;
+        }
+        case ArgType::Bool: {
+            u8 value;
+            valid = reader.Read(value);
+            store.push_back(value != 0);
+            break;
+        }
+        case ArgType::Char: {
+            char value;
+            valid = reader.Read(value);
+            store.push_back(value);
+            break;
+        }
+        case ArgType::Float: {
+            float value;
+            valid = reader.Read(value);
+            store.push_back(value);
+            break;
+        }
+        case ArgType::Double: {
+            double value;
+            valid = reader.Read(value);
+            store.push_back(value);
+            break;
+        }
+        case ArgType::String: {
+            std::string value;
+            valid = reader.ReadString(value);
+            store.push_back(std::move(value));
+            break;
+        }
+        case ArgType::Pointer: {
+            u64 value;
+            valid = reader.Read(value);
+            store.push_back(reinterpret_cast<const void*>(static_cast<uintptr_t>(value)));
+            break;
+        }
+        }
+        if (!valid)
+            return fmt::format("{} (truncated arguments)", format);
+    }
+
+    try {
+        return fmt::vformat(format, store);
+    } catch (const fmt::format_error& error) {
+        return fmt::format("{} (format error: {})", format, error.what());
+    }
+}
+
+bool DecodeFile(const std::string& filename, const std::function<void(const Entry&)>& callback) {
+    FileUtil::IOFile file(filename, "rb");
+    if (!file.IsOpen())
+        return false;
+    std::vector<u8> data(file.GetSize());
+    if (file.ReadBytes(data.data(), data.size()) != data.size())
+        return false;
+
+    Reader reader(data.data(), data.size());
+    u32 magic;
+    u32 version;
+    if (!reader.Read(magic) || !reader.Read(version) || magic != MAGIC || version != VERSION)
+        return false;
+
+    std::vector<std::string> strings;
+    const auto get_string = [&strings](u32 id) -> const std::string& {
+        static const std::string unknown = "?";
+        return id < strings.size() ? strings[id] : unknown;
+    };
+
+    RecordType type;
+    while (reader.Read(type)) {
+        if (type == RecordType::String) {
+            u32 id;
+            std::string value;
+            if (!reader.Read(id) || !reader.ReadString(value))
+                break;
+            if (id >= strings.size())
+                strings.resize(id + 1);
+            strings[id] = std::move(value);
+        } else if (type == RecordType::Message) {
+            u8 log_class;
+            u8 log_level;
+            u8 arg_count;
+            u32 line_num;
+            s64 timestamp;
+            u32 filename_id;
+            u32 function_id;
+            u32 format_id;
+            u32 args_size;
+            if (!reader.Read(log_class) || !reader.Read(log_level) || !reader.Read(arg_count) ||
+                !reader.Read(line_num) || !reader.Read(timestamp) || !reader.Read(filename_id) ||
+                !reader.Read(function_id) || !reader.Read(format_id) || !reader.Read(args_size))
+                break;
+            const u8* const args = reader.Skip(args_size);
+            if (args == nullptr)
+                break;
+
+            Entry entry;
+            entry.timestamp = std::chrono::microseconds{timestamp};
+            entry.log_class = static_cast<Class>(
+                std::min<u8>(log_class, static_cast<u8>(Class::Count) - 1));
+            entry.log_level = static_cast<Level>(
+                std::min<u8>(log_level, static_cast<u8>(Level::Count) - 1));
+            entry.filename = get_string(filename_id).c_str();
+            entry.line_num = line_num;
+            entry.function = get_string(function_id);
+            entry.message =
+                FormatEncoded(get_string(format_id).c_str(), args, args_size, arg_count);
+            callback(entry);
+        } else {
+            break;
+        }
+    }
+    return true;
+}
+
+} // namespace Log::Binary
@@ -0,0 +1,72 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <fmt/format.h>
+#include "common/common_types.h"
+
+namespace Log {
+
+struct Entry;
+
+/**
+ * The binary log format. Messages are stored as the IDs of their format string, file name and
+ * function name along with their raw arguments, each string being stored once the first time it is
+ * used. This keeps formatting off the emulation threads and makes logs several times smaller.
+ *
+ * A file starts with the 32-bit magic and version, followed by records of the following types.
+ * All values are little endian.
+ *  - String: u8 type, u32 id, u32 length, the characters
+ *  - Message: u8 type, u8 class, u8 level, u8 argument count, u32 line, s64 timestamp in us,
+ *             u32 file name id, u32 function id, u32 format id, u32 argument size, the arguments
+ *
+ * Each argument is a u8 type followed by its value, strings being prefixed with their u32 length.
+ */
+namespace Binary {
+
+constexpr u32 MAGIC = 0x474C5443; // "CTLG"
+constexpr u32 VERSION = 1;
+
+enum class RecordType : u8 {
+    String = 1,
+    Message = 2,
+};
+
+enum class ArgType : u8 {
+    Signed,
+    Unsigned,
+    Bool,
+    Char,
+    Float,
+    Double,
+    String,
+    Pointer,
+};
+
+/// Strings longer than this are truncated when they are encoded
+constexpr std::size_t MAX_STRING_SIZE = 0x4000;
+
+/**
+ * Appends the encoded arguments to the buffer and returns their number, or returns -1 if one of
+ * them has a type that can only be formatted directly, in which case the buffer is left as is.
+ */
+int EncodeArgs(std::vector<u8>& buffer, const fmt::format_args& args);
+
+/// Formats a message from its format string and encoded arguments
+std::string FormatEncoded(const char* format, const u8* args, std::size_t size, u8 count);
+
+/**
+ * Decodes a binary log file, calling back for each message in the order they were written.
+ * Returns false if the file couldn't be opened or isn't a binary log, a truncated last record is
+ * silently ignored.
+ */
+bool DecodeFile(const std::string& filename, const std::function<void(const Entry&)>& callback);
+
+} // namespace Binary
+
+} // namespace Log
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <fmt/format.h>
 #include "common/common_types.h"
 
@@ -33,6 +35,18 @@ enum class Level : u8 {
     Count ///< Total number of logging levels
 };
 
+// Messages below LOG_MIN_LEVEL are compiled out. Builds can raise it by defining it to the name of
+// a level, by default it keeps Trace messages in debug builds only.
+#ifndef LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define LOG_MIN_LEVEL Trace
+#else
+#define LOG_MIN_LEVEL Debug
+#endif
+#endif
+
+constexpr Level MIN_LEVEL = Level::LOG_MIN_LEVEL;
+
 typedef u8 ClassType;
 
 /**
@@ -75,6 +89,7 @@ enum class Class : ClassType {
     Service_PTM,       ///< The PTM (Power status & misc.) service
     Service_LDR,       ///< The LDR (3ds dll loader) service
     Service_MIC,       ///< The MIC (Microphone) service
+    Service_MVD,       ///< The MVD (Movie decoder) service
     Service_NDM,       ///< The NDM (Network daemon manager) service
     Service_NFC,       ///< The NFC service
     Service_NIM,       ///< The NIM (Network interface manager) service
@@ -113,6 +128,17 @@ enum class Class : ClassType {
     Count              ///< Total number of logging classes
 };
 
+namespace Detail {
+/// Minimum level of each class in the global filter, kept up to date by SetGlobalFilter
+extern std::array<std::atomic<Level>, static_cast<std::size_t>(Class::Count)> class_levels;
+} // namespace Detail
+
+/// Returns whether the global filter lets the message through, cheap enough to check per message
+inline bool IsLogged(Class log_class, Level log_level) {
+    return log_level >= Detail::class_levels[static_cast<std::size_t>(log_class)].load(
+                            std::memory_order_relaxed);
+}
+
 /// Logs a message to the global logger, using fmt
 void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
                        unsigned int line_num, const char* function, const char* format,
@@ -127,31 +153,28 @@ void FmtLogMessage(Class log_class, Level log_level, const char* filename, unsig
 
 } // namespace Log
 
-// Define the fmt lib macros
+// Define the fmt lib macros. The level is checked before the arguments are evaluated, so that
+// filtered out messages cost no more than a load.
 #define LOG_GENERIC(log_class, log_level, ...)                                                     \
-    ::Log::FmtLogMessage(log_class, log_level, ::Log::TrimSourcePath(__FILE__), __LINE__,          \
-                         __func__, __VA_ARGS__)
+    do {                                                                                           \
+        if ((log_level) >= ::Log::MIN_LEVEL && ::Log::IsLogged(log_class, log_level))              \
+            ::Log::FmtLogMessage(log_class, log_level, ::Log::TrimSourcePath(__FILE__), __LINE__,  \
+                                 __func__, __VA_ARGS__);                                           \
+    } while (0)
 
-#ifdef _DEBUG
-#define LOG_TRACE(log_class, ...)                                                                  \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Trace,                             \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
-#else
-#define LOG_TRACE(log_class, fmt, ...) (void(0))
-#endif
+#define LOG_LEVEL(log_class, log_level, ...)                                                       \
+    do {                                                                                           \
+        if constexpr (::Log::Level::log_level >= ::Log::MIN_LEVEL) {                               \
+            if (::Log::IsLogged(::Log::Class::log_class, ::Log::Level::log_level))                 \
+                ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::log_level,             \
+                                     ::Log::TrimSourcePath(__FILE__), __LINE__, __func__,          \
+                                     __VA_ARGS__);                                                 \
+        }                                                                                          \
+    } while (0)
 
-#define LOG_DEBUG(log_class, ...)                                                                  \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Debug,                             \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
-#define LOG_INFO(log_class, ...)                                                                   \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Info,                              \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
-#define LOG_WARNING(log_class, ...)                                                                \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Warning,                           \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
-#define LOG_ERROR(log_class, ...)                                                                  \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Error,                             \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
-#define LOG_CRITICAL(log_class, ...)                                                               \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Critical,                          \
-                         ::Log::TrimSourcePath(__FILE__), __LINE__, __func__, __VA_ARGS__)
+#define LOG_TRACE(log_class, ...) LOG_LEVEL(log_class, Trace, __VA_ARGS__)
+#define LOG_DEBUG(log_class, ...) LOG_LEVEL(log_class, Debug, __VA_ARGS__)
+#define LOG_INFO(log_class, ...) LOG_LEVEL(log_class, Info, __VA_ARGS__)
+#define LOG_WARNING(log_class, ...) LOG_LEVEL(log_class, Warning, __VA_ARGS__)
+#define LOG_ERROR(log_class, ...) LOG_LEVEL(log_class, Error, __VA_ARGS__)
+#define LOG_CRITICAL(log_class, ...) LOG_LEVEL(log_class, Critical, __VA_ARGS__)
@@ -32,3 +32,32 @@ typedef void* HANDLE;
 #ifdef PAGE_MASK
 #undef PAGE_MASK
 #endif
+
+// Every MicroProfile scope is also recorded by the tracer, which works without MicroProfile too.
+#include "common/tracing.h"
+
+#define CITRA_TRACE_PASTE0(a, b) a##b
+#define CITRA_TRACE_PASTE(a, b) CITRA_TRACE_PASTE0(a, b)
+
+#undef MICROPROFILE_DECLARE
+#undef MICROPROFILE_DEFINE
+#undef MICROPROFILE_SCOPE
+
+#if MICROPROFILE_ENABLED
+#define MICROPROFILE_DECLARE(var)                                                                  \
+    extern MicroProfileToken g_mp_##var;                                                           \
+    extern Common::Tracing::Category g_trace_##var
+#define MICROPROFILE_DEFINE(var, group, name, color)                                               \
+    MicroProfileToken g_mp_##var =                                                                 \
+        MicroProfileGetToken(group, name, color, MicroProfileTokenTypeCpu);                        \
+    Common::Tracing::Category g_trace_##var{group, name}
+#define MICROPROFILE_SCOPE(var)                                                                    \
+    MicroProfileScopeHandler CITRA_TRACE_PASTE(foo, __LINE__)(g_mp_##var);                         \
+    Common::Tracing::Scope CITRA_TRACE_PASTE(trace_scope, __LINE__)(g_trace_##var)
+#else
+#define MICROPROFILE_DECLARE(var) extern Common::Tracing::Category g_trace_##var
+#define MICROPROFILE_DEFINE(var, group, name, color)                                               \
+    Common::Tracing::Category g_trace_##var{group, name}
+#define MICROPROFILE_SCOPE(var)                                                                    \
+    Common::Tracing::Scope CITRA_TRACE_PASTE(trace_scope, __LINE__)(g_trace_##var)
+#endif
@@ -0,0 +1,98 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdint>
+#include <new>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#include "common/alignment.h"
+#include "common/common_funcs.h"
+#include "common/logging/log.h"
+#include "common/page_allocation.h"
+
+namespace Common {
+
+namespace {
+constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+} // Anonymous namespace
+
+PageAllocation::PageAllocation(std::size_t size, bool use_huge_pages) : requested_size(size) {
+#ifdef _WIN32
+    if (use_huge_pages) {
+        // Large pages need the "Lock pages in memory" privilege of the user
+        const std::size_t large_page_size = GetLargePageMinimum();
+        if (large_page_size != 0) {
+            mapped_size = AlignUp(size, large_page_size);
+            base = VirtualAlloc(nullptr, mapped_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                                PAGE_READWRITE);
+        }
+        if (base != nullptr) {
+            huge_pages = true;
+        } else {
+            LOG_WARNING(Common_Memory, "Large pages are unavailable, using normal pages: {}",
+                        GetLastErrorMsg());
+        }
+    }
+    if (base == nullptr) {
+        mapped_size = size;
+        base = VirtualAlloc(nullptr, mapped_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    }
+    if (base == nullptr)
+        throw std::bad_alloc();
+    pointer = static_cast<u8*>(base);
+#else
+#ifdef MAP_HUGETLB
+    if (use_huge_pages) {
+        // Explicit huge pages only exist if the administrator reserved some
+        mapped_size = AlignUp(size, HUGE_PAGE_SIZE);
+        base = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            huge_pages = true;
+            pointer = static_cast<u8*>(base);
+            return;
+        }
+        base = nullptr;
+    }
+#endif
+
+    // Over-allocate so the buffer can start on a huge page boundary, which transparent huge pages
+    // need to back it
+    mapped_size = use_huge_pages ? size + HUGE_PAGE_SIZE : size;
+    base = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        base = nullptr;
+        throw std::bad_alloc();
+    }
+    pointer = static_cast<u8*>(base);
+    if (use_huge_pages) {
+        pointer = reinterpret_cast<u8*>(AlignUp(reinterpret_cast<uintptr_t>(base), HUGE_PAGE_SIZE));
+#ifdef MADV_HUGEPAGE
+        if (madvise(pointer, AlignUp(size, HUGE_PAGE_SIZE), MADV_HUGEPAGE) == 0) {
+            huge_pages = true;
+        } else {
+            LOG_WARNING(Common_Memory, "Huge pages are unavailable, using normal pages: {}",
+                        GetLastErrorMsg());
+        }
+#else
+        LOG_WARNING(Common_Memory, "Huge pages are not supported on this platform");
+#endif
+    }
+#endif
+}
+
+PageAllocation::~PageAllocation() {
+    if (base == nullptr)
+        return;
+#ifdef _WIN32
+    VirtualFree(base, 0, MEM_RELEASE);
+#else
+    munmap(base, mapped_size);
+#endif
+}
+
+} // namespace Common
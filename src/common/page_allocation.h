@@ -0,0 +1,44 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Zero-initialized memory allocated directly from the OS. With huge pages requested the memory is
+ * backed by 2MB pages where the OS allows it, which cuts the TLB misses of random accesses across
+ * large buffers. Otherwise, or if huge pages are unavailable, normal pages are used.
+ */
+class PageAllocation : NonCopyable {
+public:
+    PageAllocation(std::size_t size, bool use_huge_pages);
+    ~PageAllocation();
+
+    u8* data() const {
+        return pointer;
+    }
+
+    std::size_t size() const {
+        return requested_size;
+    }
+
+    /// Returns whether the memory is known to be backed by huge pages
+    bool IsHugePages() const {
+        return huge_pages;
+    }
+
+private:
+    u8* pointer = nullptr;
+    /// The start and the size of the mapping, which can be larger than the requested size
+    void* base = nullptr;
+    std::size_t mapped_size = 0;
+    std::size_t requested_size;
+    bool huge_pages = false;
+};
+
+} // namespace Common
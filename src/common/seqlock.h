@@ -0,0 +1,77 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Publishes a value from a single writer thread to any number of reader threads without locking.
+ * Readers copy the value and retry if it was written in the meantime, which the writer announces
+ * by making the sequence number odd while it writes.
+ * @tparam T Value type, which must be safely memcpy-able
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(std::atomic<u64>::is_always_lock_free);
+
+public:
+    SeqLock() : SeqLock(T{}) {}
+
+    explicit SeqLock(const T& value) {
+        Store(value);
+    }
+
+    /// Publishes a new value, must only be called from one thread at a time
+    void Write(const T& value) {
+        const u64 sequence = sequence_number.load(std::memory_order_relaxed);
+        sequence_number.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        Store(value);
+        sequence_number.store(sequence + 2, std::memory_order_release);
+    }
+
+    /// Returns the last published value
+    T Read() const {
+        std::array<u64, NUM_WORDS> copy;
+        u64 sequence;
+        do {
+            sequence = sequence_number.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < NUM_WORDS; ++i) {
+                copy[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((sequence & 1) != 0 ||
+                 sequence_number.load(std::memory_order_relaxed) != sequence);
+
+        T value;
+        std::memcpy(&value, copy.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr std::size_t NUM_WORDS = (sizeof(T) + sizeof(u64) - 1) / sizeof(u64);
+
+    void Store(const T& value) {
+        std::array<u64, NUM_WORDS> copy{};
+        std::memcpy(copy.data(), &value, sizeof(T));
+        for (std::size_t i = 0; i < NUM_WORDS; ++i) {
+            words[i].store(copy[i], std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<u64> sequence_number{0};
+    // The value is kept in atomic words, so that reading it while it is written isn't a data race
+    std::array<std::atomic<u64>, NUM_WORDS> words{};
+};
+
+} // namespace Common
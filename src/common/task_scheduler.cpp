@@ -0,0 +1,171 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <string>
+#include "common/microprofile.h"
+#include "common/task_scheduler.h"
+#include "common/thread.h"
+
+namespace Common {
+
+namespace {
+constexpr std::size_t NUM_PRIORITIES = static_cast<std::size_t>(TaskPriority::Count);
+
+/// The scheduler and index of the calling worker thread, the scheduler is null on other threads
+thread_local TaskScheduler* current_scheduler = nullptr;
+thread_local std::size_t current_worker = 0;
+} // Anonymous namespace
+
+TaskScheduler& TaskScheduler::GetInstance() {
+    // The emulation thread is always busy, so it doesn't get a worker
+    static TaskScheduler scheduler{std::max(2U, std::thread::hardware_concurrency()) - 1};
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler(std::size_t num_workers) {
+    workers.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        workers[i]->thread = std::thread(&TaskScheduler::WorkerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard lock{sleep_mutex};
+        stop = true;
+    }
+    task_queued.notify_all();
+    for (const auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+void TaskScheduler::Submit(std::function<void()> task, TaskPriority priority,
+                           std::size_t affinity) {
+    std::size_t index;
+    if (affinity != ANY_WORKER) {
+        index = affinity % workers.size();
+    } else if (current_scheduler == this) {
+        // Sub-tasks likely work on the same data as their parent
+        index = current_worker;
+    } else {
+        index = next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    }
+
+    Worker& worker = *workers[index];
+    {
+        std::lock_guard lock{worker.mutex};
+        worker.queues[static_cast<std::size_t>(priority)].push_back(std::move(task));
+    }
+    {
+        std::lock_guard lock{sleep_mutex};
+        queued_tasks.fetch_add(1, std::memory_order_relaxed);
+    }
+    task_queued.notify_one();
+}
+
+bool TaskScheduler::RunPendingTask() {
+    std::function<void()> task;
+    if (!PopTask(current_scheduler == this ? current_worker : 0, task))
+        return false;
+    task();
+    return true;
+}
+
+bool TaskScheduler::PopTask(std::size_t first_worker, std::function<void()>& task) {
+    if (queued_tasks.load(std::memory_order_relaxed) == 0)
+        return false;
+
+    for (std::size_t priority = 0; priority < NUM_PRIORITIES; ++priority) {
+        for (std::size_t i = 0; i < workers.size(); ++i) {
+            const std::size_t index = (first_worker + i) % workers.size();
+            Worker& worker = *workers[index];
+            std::lock_guard lock{worker.mutex};
+            auto& queue = worker.queues[priority];
+            if (queue.empty())
+                continue;
+
+            // Owners take the oldest task, thieves the newest one, which is the least likely to
+            // share data with what the owner runs next
+            if (index == first_worker) {
+                task = std::move(queue.front());
+                queue.pop_front();
+            } else {
+                task = std::move(queue.back());
+                queue.pop_back();
+            }
+            queued_tasks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+MICROPROFILE_DEFINE(TaskScheduler_Task, "Tasks", "Task", MP_RGB(128, 128, 192));
+void TaskScheduler::WorkerLoop(std::size_t index) {
+    const std::string name = "TaskWorker_" + std::to_string(index);
+    SetCurrentThreadName(name.c_str());
+    MicroProfileOnThreadCreate(name.c_str());
+    current_scheduler = this;
+    current_worker = index;
+
+    std::function<void()> task;
+    while (true) {
+        if (PopTask(index, task)) {
+            MICROPROFILE_SCOPE(TaskScheduler_Task);
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock lock{sleep_mutex};
+        task_queued.wait(lock, [this] {
+            return stop || queued_tasks.load(std::memory_order_relaxed) != 0;
+        });
+        if (stop && queued_tasks.load(std::memory_order_relaxed) == 0)
+            break;
+    }
+
+    MicroProfileOnThreadExit();
+}
+
+TaskGroup::TaskGroup(TaskPriority priority, TaskScheduler& scheduler)
+    : scheduler(scheduler), priority(priority) {}
+
+TaskGroup::~TaskGroup() {
+    Wait();
+}
+
+void TaskGroup::Submit(std::function<void()> task, std::size_t affinity) {
+    pending.fetch_add(1, std::memory_order_relaxed);
+    scheduler.Submit(
+        [this, task = std::move(task)] {
+            task();
+            // Under the mutex, so that Wait can't return while the group is still being touched
+            std::lock_guard lock{mutex};
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                done.notify_all();
+        },
+        priority, affinity);
+}
+
+void TaskGroup::Wait() {
+    while (pending.load(std::memory_order_acquire) != 0) {
+        if (scheduler.RunPendingTask())
+            continue;
+
+        // The remaining tasks are running on the workers, new tasks of other groups aren't
+        // picked up until they finish
+        std::unique_lock lock{mutex};
+        done.wait(lock, [this] { return pending.load(std::memory_order_acquire) == 0; });
+    }
+    // Waits for the last task to release the mutex
+    std::lock_guard lock{mutex};
+}
+
+} // namespace Common
@@ -0,0 +1,120 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+enum class TaskPriority : std::size_t {
+    High,   ///< Work something is waiting for, e.g. a frame being converted
+    Normal, ///< Work that should finish soon, but nothing blocks on
+    Low,    ///< Background work like preloading
+    Count,
+};
+
+/**
+ * A pool of worker threads shared by the CPU heavy background work of all subsystems, so that
+ * they don't each start their own threads and oversubscribe the host when they run at once.
+ *
+ * Every worker has its own queue of tasks for each priority. Tasks are queued to the worker given
+ * as affinity hint, to the submitting worker when submitted from a task, or round robin otherwise.
+ * Idle workers steal from the others, always taking the most urgent task first. Tasks must not
+ * throw, use Async to get exceptions back.
+ */
+class TaskScheduler : NonCopyable {
+public:
+    static constexpr std::size_t ANY_WORKER = std::numeric_limits<std::size_t>::max();
+
+    /// Returns the shared scheduler, which has a worker for each host thread but one
+    static TaskScheduler& GetInstance();
+
+    explicit TaskScheduler(std::size_t num_workers);
+    /// Runs the tasks still queued and stops the workers
+    ~TaskScheduler();
+
+    std::size_t NumWorkers() const {
+        return workers.size();
+    }
+
+    /// Queues a task. The affinity is a hint of the worker it should run on, modulo their number.
+    void Submit(std::function<void()> task, TaskPriority priority = TaskPriority::Normal,
+                std::size_t affinity = ANY_WORKER);
+
+    /// Queues a task and returns a future for its result or exception
+    template <typename Func>
+    auto Async(Func&& func, TaskPriority priority = TaskPriority::Normal)
+        -> std::future<std::invoke_result_t<Func>> {
+        using Result = std::invoke_result_t<Func>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        std::future<Result> future = task->get_future();
+        Submit([task] { (*task)(); }, priority);
+        return future;
+    }
+
+    /// Runs one queued task on the calling thread, returns false if there was none
+    bool RunPendingTask();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::array<std::deque<std::function<void()>>, static_cast<std::size_t>(TaskPriority::Count)>
+            queues;
+        std::thread thread;
+    };
+
+    /// Takes the most urgent task, looking at the given worker first
+    bool PopTask(std::size_t first_worker, std::function<void()>& task);
+
+    void WorkerLoop(std::size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic_size_t next_worker{0};
+    std::atomic_size_t queued_tasks{0};
+
+    std::mutex sleep_mutex;
+    std::condition_variable task_queued;
+    bool stop = false;
+};
+
+/**
+ * A set of tasks that can be waited for together. Waiting runs queued tasks on the calling thread
+ * in the meantime, so a task may wait for its own group of sub-tasks without starving the pool.
+ * The destructor waits for the remaining tasks.
+ */
+class TaskGroup : NonCopyable {
+public:
+    explicit TaskGroup(TaskPriority priority = TaskPriority::Normal,
+                       TaskScheduler& scheduler = TaskScheduler::GetInstance());
+    ~TaskGroup();
+
+    void Submit(std::function<void()> task, std::size_t affinity = TaskScheduler::ANY_WORKER);
+
+    /// Returns once all tasks submitted so far have finished
+    void Wait();
+
+private:
+    TaskScheduler& scheduler;
+    const TaskPriority priority;
+
+    std::atomic_size_t pending{0};
+    std::mutex mutex;
+    std::condition_variable done;
+};
+
+} // namespace Common
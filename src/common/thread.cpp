@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "common/thread.h"
+#include "common/tracing.h"
 #ifdef __APPLE__
 #include <mach/mach.h>
 #elif defined(_WIN32)
@@ -47,6 +48,8 @@ void SetCurrentThreadName(const char* name) {
     info.dwThreadID = static_cast<DWORD>(-1);
     info.dwFlags = 0;
 
+    Tracing::SetThreadName(name);
+
     __try {
         RaiseException(MS_VC_EXCEPTION, 0, sizeof(info) / sizeof(ULONG_PTR), (ULONG_PTR*)&info);
     } __except (EXCEPTION_CONTINUE_EXECUTION) {
@@ -58,6 +61,7 @@ void SetCurrentThreadName(const char* name) {
 // MinGW with the POSIX threading model does not support pthread_setname_np
 #if !defined(_WIN32) || defined(_MSC_VER)
 void SetCurrentThreadName(const char* name) {
+    Tracing::SetThreadName(name);
 #ifdef __APPLE__
     pthread_setname_np(name);
 #elif defined(__Bitrig__) || defined(__DragonFly__) || defined(__FreeBSD__) || defined(__OpenBSD__)
@@ -68,6 +72,10 @@ void SetCurrentThreadName(const char* name) {
     pthread_setname_np(pthread_self(), name);
 #endif
 }
+#else
+void SetCurrentThreadName(const char* name) {
+    Tracing::SetThreadName(name);
+}
 #endif
 
 #endif
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
@@ -59,36 +60,64 @@ private:
     std::mutex mutex;
 };
 
+/**
+ * Threads arrive at the barrier with an atomic counter. The mutex is only taken once a thread has
+ * spun for a while without the others arriving and goes to sleep, and by the last thread to
+ * arrive if any thread is asleep.
+ */
 class Barrier {
 public:
     explicit Barrier(std::size_t count_) : count(count_) {}
 
     /// Blocks until all "count" threads have called Sync()
     void Sync() {
-        std::unique_lock lk{mutex};
-        const std::size_t current_generation = generation;
-
-        if (++waiting == count) {
-            generation++;
-            waiting = 0;
+        const std::size_t current_generation = generation.load(std::memory_order_acquire);
+
+        if (waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            // The reset is published by the release of the new generation
+            waiting.store(0, std::memory_order_relaxed);
+            generation.store(current_generation + 1, std::memory_order_release);
+            // Pairs with the fence below: either the sleeper sees the new generation or this sees
+            // it sleeping
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed) == 0)
+                return;
+            {
+                std::lock_guard lk{mutex};
+            }
             condvar.notify_all();
-        } else {
-            condvar.wait(lk,
-                         [this, current_generation] { return current_generation != generation; });
+            return;
+        }
+
+        const auto passed = [this, current_generation] {
+            return generation.load(std::memory_order_acquire) != current_generation;
+        };
+        // The other threads are usually not far behind, spinning saves sleeping and waking up
+        constexpr int SPIN_COUNT = 64;
+        for (int i = 0; i < SPIN_COUNT; ++i) {
+            if (passed())
+                return;
+            std::this_thread::yield();
         }
+
+        std::unique_lock lk{mutex};
+        sleeping.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        condvar.wait(lk, passed);
+        sleeping.fetch_sub(1, std::memory_order_relaxed);
     }
 
     std::size_t Generation() const {
-        std::unique_lock lk(mutex);
-        return generation;
+        return generation.load(std::memory_order_acquire);
     }
 
 private:
     std::condition_variable condvar;
-    mutable std::mutex mutex;
+    std::mutex mutex;
     std::size_t count;
-    std::size_t waiting = 0;
-    std::size_t generation = 0; // Incremented once each time the barrier is used
+    std::atomic<std::size_t> waiting = 0;
+    std::atomic<std::size_t> generation = 0; // Incremented once each time the barrier is used
+    std::atomic<std::size_t> sleeping = 0;
 };
 
 void SetCurrentThreadName(const char* name);
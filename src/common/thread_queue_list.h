@@ -4,158 +4,154 @@
 
 #pragma once
 
-#include <algorithm>
 #include <array>
-#include <deque>
+#include "common/bit_set.h"
+#include "common/common_types.h"
 
 namespace Common {
 
+/// Links of an object in a ThreadQueueList, objects have to inherit from it to be queued
+template <class T>
+struct ThreadQueueListNode {
+    T* prev_in_queue = nullptr;
+    T* next_in_queue = nullptr;
+    unsigned int queue_priority = 0;
+    bool in_queue = false;
+};
+
+/**
+ * Queues of objects for each priority level, which are linked through the objects themselves so
+ * that queueing never allocates. A bitmap of the non-empty levels finds the first object of the
+ * best priority with a single bit scan.
+ */
 template <class T, unsigned int N>
 struct ThreadQueueList {
-    // TODO(yuriks): If performance proves to be a problem, the std::deques can be replaced with
-    //               (dynamically resizable) circular buffers to remove their overhead when
-    //               inserting and popping.
+    static_assert(N <= 64, "The priority bitmap only has 64 bits");
 
     typedef unsigned int Priority;
 
     // Number of priority levels. (Valid levels are [0..NUM_QUEUES).)
     static const Priority NUM_QUEUES = N;
 
-    ThreadQueueList() {
-        first = nullptr;
-    }
-
     // Only for debugging, returns priority level.
-    Priority contains(const T& uid) {
-        for (Priority i = 0; i < NUM_QUEUES; ++i) {
-            Queue& cur = queues[i];
-            if (std::find(cur.data.cbegin(), cur.data.cend(), uid) != cur.data.cend()) {
-                return i;
-            }
-        }
-
-        return -1;
+    Priority contains(const T* thread) const {
+        const ThreadQueueListNode<T>& node = *thread;
+        return node.in_queue ? node.queue_priority : -1;
     }
 
-    T get_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                return cur->data.front();
-            }
-            cur = cur->next_nonempty;
-        }
-
-        return T();
+    T* get_first() const {
+        if (non_empty == 0)
+            return nullptr;
+        return queues[LeastSignificantSetBit(non_empty)].head;
     }
 
-    T pop_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
-
-        return T();
+    T* pop_first() {
+        T* const thread = get_first();
+        if (thread != nullptr)
+            unlink(thread);
+        return thread;
     }
 
-    T pop_first_better(Priority priority) {
-        Queue* cur = first;
-        Queue* stop = &queues[priority];
-        while (cur < stop) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
-
-        return T();
+    T* pop_first_better(Priority priority) {
+        const u64 better = non_empty & ((u64{1} << priority) - 1);
+        if (better == 0)
+            return nullptr;
+        T* const thread = queues[LeastSignificantSetBit(better)].head;
+        unlink(thread);
+        return thread;
     }
 
-    void push_front(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_front(thread_id);
+    void push_front(Priority priority, T* thread) {
+        remove(priority, thread);
+        ThreadQueueListNode<T>& node = *thread;
+        Queue& queue = queues[priority];
+        node.prev_in_queue = nullptr;
+        node.next_in_queue = queue.head;
+        if (queue.head != nullptr) {
+            Node(queue.head).prev_in_queue = thread;
+        } else {
+            queue.tail = thread;
+        }
+        queue.head = thread;
+        link(priority, node);
     }
 
-    void push_back(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_back(thread_id);
+    void push_back(Priority priority, T* thread) {
+        remove(priority, thread);
+        ThreadQueueListNode<T>& node = *thread;
+        Queue& queue = queues[priority];
+        node.prev_in_queue = queue.tail;
+        node.next_in_queue = nullptr;
+        if (queue.tail != nullptr) {
+            Node(queue.tail).next_in_queue = thread;
+        } else {
+            queue.head = thread;
+        }
+        queue.tail = thread;
+        link(priority, node);
     }
 
-    void move(const T& thread_id, Priority old_priority, Priority new_priority) {
-        remove(old_priority, thread_id);
-        prepare(new_priority);
-        push_back(new_priority, thread_id);
+    void move(T* thread, Priority old_priority, Priority new_priority) {
+        remove(old_priority, thread);
+        push_back(new_priority, thread);
     }
 
-    void remove(Priority priority, const T& thread_id) {
-        Queue* const cur = &queues[priority];
-        const auto iter = std::remove(cur->data.begin(), cur->data.end(), thread_id);
-        cur->data.erase(iter, cur->data.end());
+    /// Removes the object from its queue. Objects that aren't queued are left alone.
+    void remove(Priority priority, T* thread) {
+        if (Node(thread).in_queue)
+            unlink(thread);
     }
 
     void rotate(Priority priority) {
-        Queue* cur = &queues[priority];
-
-        if (cur->data.size() > 1) {
-            cur->data.push_back(std::move(cur->data.front()));
-            cur->data.pop_front();
-        }
-    }
-
-    void clear() {
-        queues.fill(Queue());
-        first = nullptr;
+        T* const head = queues[priority].head;
+        if (head != nullptr && head != queues[priority].tail)
+            push_back(priority, head);
     }
 
     bool empty(Priority priority) const {
-        const Queue* cur = &queues[priority];
-        return cur->data.empty();
-    }
-
-    void prepare(Priority priority) {
-        Queue* cur = &queues[priority];
-        if (cur->next_nonempty == UnlinkedTag())
-            link(priority);
+        return queues[priority].head == nullptr;
     }
 
 private:
     struct Queue {
-        // Points to the next active priority, skipping over ones that have never been used.
-        Queue* next_nonempty = UnlinkedTag();
-        // Double-ended queue of threads in this priority level
-        std::deque<T> data;
+        T* head = nullptr;
+        T* tail = nullptr;
     };
 
-    /// Special tag used to mark priority levels that have never been used.
-    static Queue* UnlinkedTag() {
-        return reinterpret_cast<Queue*>(1);
+    static ThreadQueueListNode<T>& Node(T* thread) {
+        return *thread;
     }
 
-    void link(Priority priority) {
-        Queue* cur = &queues[priority];
+    void link(Priority priority, ThreadQueueListNode<T>& node) {
+        node.queue_priority = priority;
+        node.in_queue = true;
+        non_empty |= u64{1} << priority;
+    }
 
-        for (int i = priority - 1; i >= 0; --i) {
-            if (queues[i].next_nonempty != UnlinkedTag()) {
-                cur->next_nonempty = queues[i].next_nonempty;
-                queues[i].next_nonempty = cur;
-                return;
-            }
+    void unlink(T* thread) {
+        ThreadQueueListNode<T>& node = *thread;
+        Queue& queue = queues[node.queue_priority];
+        if (node.prev_in_queue != nullptr) {
+            Node(node.prev_in_queue).next_in_queue = node.next_in_queue;
+        } else {
+            queue.head = node.next_in_queue;
+        }
+        if (node.next_in_queue != nullptr) {
+            Node(node.next_in_queue).prev_in_queue = node.prev_in_queue;
+        } else {
+            queue.tail = node.prev_in_queue;
         }
+        if (queue.head == nullptr)
+            non_empty &= ~(u64{1} << node.queue_priority);
 
-        cur->next_nonempty = first;
-        first = cur;
+        node.prev_in_queue = nullptr;
+        node.next_in_queue = nullptr;
+        node.in_queue = false;
     }
 
-    // The first queue that's ever been used.
-    Queue* first;
-    // The priority level queues of thread ids.
+    // Bit i is set if the queue of priority level i isn't empty.
+    u64 non_empty = 0;
+    // The priority level queues of objects.
     std::array<Queue, NUM_QUEUES> queues;
 };
 
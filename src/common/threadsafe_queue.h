@@ -7,11 +7,16 @@
 // a simple lockless thread-safe,
 // single reader, single writer queue
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <mutex>
+#include <thread>
 #include <utility>
+#include "common/common_types.h"
 
 namespace Common {
 template <typename T>
@@ -145,7 +150,7 @@ public:
     template <typename Arg>
     void Push(Arg&& t) {
         std::lock_guard lock{write_lock};
-        spsc_queue.Push(t);
+        spsc_queue.Push(std::forward<Arg>(t));
     }
 
     void Pop() {
@@ -169,4 +174,280 @@ private:
     SPSCQueue<T> spsc_queue;
     std::mutex write_lock;
 };
+
+/// Indices written by different threads are kept this far apart to avoid false sharing
+constexpr std::size_t QUEUE_CACHE_LINE_SIZE = 64;
+
+/**
+ * Blocks the consumer of a queue until a producer pushes. Producers only take the mutex while the
+ * consumer is actually sleeping, so pushing to a queue with a busy consumer is a single fence and
+ * an atomic load.
+ */
+class QueueWaiter {
+public:
+    /// Wakes the consumer if it is waiting, called after an element was published
+    void Notify() {
+        // Pairs with the fence in Wait: either the consumer sees the new element or this sees it
+        // waiting
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed) == 0)
+            return;
+        {
+            std::lock_guard lock{mutex};
+        }
+        cv.notify_one();
+    }
+
+    /// Returns once the predicate is true, spinning briefly before going to sleep
+    template <typename Pred>
+    void Wait(Pred&& ready) {
+        constexpr int SPIN_COUNT = 16;
+        for (int i = 0; i < SPIN_COUNT; ++i) {
+            if (ready())
+                return;
+            std::this_thread::yield();
+        }
+
+        std::unique_lock lock{mutex};
+        waiting.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cv.wait(lock, ready);
+        waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<u32> waiting{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+/**
+ * A bounded single reader, single writer queue on a ring buffer. Unlike SPSCQueue it never
+ * allocates after construction. Each side caches the index of the other one and only reloads it
+ * when the ring looks full or empty, so the shared cache lines are rarely touched.
+ * Capacity has to be a power of two, and T default constructible.
+ */
+template <typename T, std::size_t Capacity>
+class BoundedSPSCQueue {
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    std::size_t Size() const {
+        return write_index.load(std::memory_order_acquire) -
+               read_index.load(std::memory_order_acquire);
+    }
+
+    bool Empty() const {
+        return Size() == 0;
+    }
+
+    /// Pushes the element unless the queue is full, in which case it is left untouched
+    template <typename Arg>
+    bool TryPush(Arg&& t) {
+        const std::size_t write = write_index.load(std::memory_order_relaxed);
+        if (write - cached_read_index == Capacity) {
+            cached_read_index = read_index.load(std::memory_order_acquire);
+            if (write - cached_read_index == Capacity)
+                return false;
+        }
+        slots[write & MASK] = std::forward<Arg>(t);
+        write_index.store(write + 1, std::memory_order_release);
+        waiter.Notify();
+        return true;
+    }
+
+    /// Pushes the element, yielding while the queue is full
+    template <typename Arg>
+    void Push(Arg&& t) {
+        while (!TryPush(std::forward<Arg>(t))) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool Pop(T& t) {
+        const std::size_t read = read_index.load(std::memory_order_relaxed);
+        if (read == cached_write_index) {
+            cached_write_index = write_index.load(std::memory_order_acquire);
+            if (read == cached_write_index)
+                return false;
+        }
+        T& slot = slots[read & MASK];
+        t = std::move(slot);
+        slot = T{};
+        read_index.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Passes up to max_count elements to func in order and returns how many were popped. The
+     * slots are released to the producer all at once.
+     */
+    template <typename Func>
+    std::size_t PopBatch(Func&& func, std::size_t max_count) {
+        const std::size_t read = read_index.load(std::memory_order_relaxed);
+        cached_write_index = write_index.load(std::memory_order_acquire);
+        const std::size_t count = std::min(cached_write_index - read, max_count);
+        for (std::size_t i = 0; i < count; ++i) {
+            T& slot = slots[(read + i) & MASK];
+            func(slot);
+            slot = T{};
+        }
+        read_index.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+    /// Blocks until the queue isn't empty
+    void Wait() {
+        waiter.Wait([this] { return !Empty(); });
+    }
+
+    T PopWait() {
+        T t;
+        while (!Pop(t)) {
+            Wait();
+        }
+        return t;
+    }
+
+private:
+    static constexpr std::size_t MASK = Capacity - 1;
+
+    // Written by the producer
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic_size_t write_index{0};
+    std::size_t cached_read_index = 0;
+
+    // Written by the consumer
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic_size_t read_index{0};
+    std::size_t cached_write_index = 0;
+
+    alignas(QUEUE_CACHE_LINE_SIZE) std::array<T, Capacity> slots{};
+    QueueWaiter waiter;
+};
+
+/**
+ * A bounded multiple reader, multiple writer queue on a ring buffer that never allocates after
+ * construction. Each slot carries a sequence number telling whether it is free to write or ready
+ * to read in the current lap, so producers and consumers only contend on their own index.
+ * Capacity has to be a power of two, and T default constructible.
+ */
+template <typename T, std::size_t Capacity>
+class BoundedMPMCQueue {
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    BoundedMPMCQueue() {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// Approximate while other threads push or pop
+    std::size_t Size() const {
+        const std::size_t read = dequeue_pos.load(std::memory_order_acquire);
+        const std::size_t write = enqueue_pos.load(std::memory_order_acquire);
+        return write > read ? write - read : 0;
+    }
+
+    /// Returns whether the next element to pop isn't published yet
+    bool Empty() const {
+        const std::size_t pos = dequeue_pos.load(std::memory_order_acquire);
+        return cells[pos & MASK].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    /// Pushes the element unless the queue is full, in which case it is left untouched
+    template <typename Arg>
+    bool TryPush(Arg&& t) {
+        std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & MASK];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff =
+                static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::forward<Arg>(t);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        waiter.Notify();
+        return true;
+    }
+
+    /// Pushes the element, yielding while the queue is full
+    template <typename Arg>
+    void Push(Arg&& t) {
+        while (!TryPush(std::forward<Arg>(t))) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool Pop(T& t) {
+        std::size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & MASK];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff =
+                static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        t = std::move(cell->value);
+        cell->value = T{};
+        cell->sequence.store(pos + Capacity, std::memory_order_release);
+        return true;
+    }
+
+    /// Pops up to max_count elements into func and returns how many were popped
+    template <typename Func>
+    std::size_t PopBatch(Func&& func, std::size_t max_count) {
+        std::size_t count = 0;
+        for (T t; count < max_count && Pop(t); ++count) {
+            func(t);
+        }
+        return count;
+    }
+
+    /// Blocks until the queue isn't empty. Only meant for a single consumer, with several ones
+    /// another consumer may take the element first.
+    void Wait() {
+        waiter.Wait([this] { return !Empty(); });
+    }
+
+    T PopWait() {
+        T t;
+        while (!Pop(t)) {
+            Wait();
+        }
+        return t;
+    }
+
+private:
+    static constexpr std::size_t MASK = Capacity - 1;
+
+    struct Cell {
+        std::atomic_size_t sequence;
+        T value{};
+    };
+
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic_size_t enqueue_pos{0};
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic_size_t dequeue_pos{0};
+    alignas(QUEUE_CACHE_LINE_SIZE) std::array<Cell, Capacity> cells;
+    QueueWaiter waiter;
+};
+
 } // namespace Common
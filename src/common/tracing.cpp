@@ -0,0 +1,251 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/tracing.h"
+
+namespace Common::Tracing {
+
+namespace Detail {
+std::atomic_bool enabled{false};
+} // namespace Detail
+
+namespace {
+using Detail::Clock;
+
+/// Events kept per thread, at 40 bytes per event
+constexpr std::size_t RING_SIZE = 32768;
+
+/// Durations of instant events, which complete events can't have
+constexpr u64 INSTANT = ~u64{0};
+
+/**
+ * A recorded event. The fields are atomics so that the dump can read them while the thread
+ * overwrites the oldest events, the torn ones are detected through the ring head and dropped.
+ */
+struct Event {
+    std::atomic<u64> start{};
+    std::atomic<u64> duration{};
+    std::atomic<const Category*> category{};
+    std::atomic<const char*> detail{};
+    std::atomic<u64> arg{};
+};
+
+struct EventCopy {
+    u64 start;
+    u64 duration;
+    const Category* category;
+    const char* detail;
+    u64 arg;
+};
+
+/// The events of one thread, only the owning thread writes to it
+struct ThreadBuffer {
+    std::array<Event, RING_SIZE> events;
+    /// Number of events ever written, the next event goes to head % RING_SIZE
+    std::atomic<u64> head{0};
+    /// Index of the oldest event that hasn't been cleared
+    std::atomic<u64> tail{0};
+    u32 tid;
+    /// Protected by the registry mutex
+    std::string name;
+};
+
+std::mutex registry_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;
+u32 next_tid = 1;
+
+struct ThreadState {
+    std::shared_ptr<ThreadBuffer> buffer;
+    std::string name;
+};
+thread_local ThreadState thread_state;
+
+const Clock::time_point epoch = Clock::now();
+
+u64 ToNanoseconds(Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - epoch).count();
+}
+
+ThreadBuffer& GetThreadBuffer() {
+    if (!thread_state.buffer) {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard lock{registry_mutex};
+        buffer->tid = next_tid++;
+        buffer->name = thread_state.name;
+        registry.push_back(buffer);
+        thread_state.buffer = std::move(buffer);
+    }
+    return *thread_state.buffer;
+}
+
+void Record(u64 start, u64 duration, const Category& category, const char* detail, u64 arg) {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    const u64 index = buffer.head.load(std::memory_order_relaxed);
+    Event& event = buffer.events[index % RING_SIZE];
+    event.start.store(start, std::memory_order_relaxed);
+    event.duration.store(duration, std::memory_order_relaxed);
+    event.category.store(&category, std::memory_order_relaxed);
+    event.detail.store(detail, std::memory_order_relaxed);
+    event.arg.store(arg, std::memory_order_relaxed);
+    buffer.head.store(index + 1, std::memory_order_release);
+}
+
+/// Copies the intact events of a buffer, oldest first
+std::vector<EventCopy> CopyEvents(const ThreadBuffer& buffer) {
+    const u64 head = buffer.head.load(std::memory_order_acquire);
+    const u64 first = std::max(buffer.tail.load(std::memory_order_relaxed),
+                               head > RING_SIZE ? head - RING_SIZE : 0);
+    std::vector<EventCopy> copies;
+    copies.reserve(head - first);
+    for (u64 index = first; index < head; ++index) {
+        const Event& event = buffer.events[index % RING_SIZE];
+        copies.push_back({event.start.load(std::memory_order_relaxed),
+                          event.duration.load(std::memory_order_relaxed),
+                          event.category.load(std::memory_order_relaxed),
+                          event.detail.load(std::memory_order_relaxed),
+                          event.arg.load(std::memory_order_relaxed)});
+    }
+
+    // Writing the event at index i overwrote the one at i - RING_SIZE while they were copied
+    const u64 new_head = buffer.head.load(std::memory_order_acquire);
+    const u64 torn = new_head > RING_SIZE ? new_head - RING_SIZE : 0;
+    if (torn > first) {
+        copies.erase(copies.begin(),
+                     copies.begin() + static_cast<std::ptrdiff_t>(std::min(torn - first,
+                                                                           u64{copies.size()})));
+    }
+    return copies;
+}
+
+void AppendEscaped(std::string& out, std::string_view str) {
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out += c;
+        }
+    }
+}
+} // Anonymous namespace
+
+namespace Detail {
+void RecordComplete(const Category& category, Clock::time_point start, Clock::time_point end,
+                    const char* detail, u64 arg) {
+    const u64 start_ns = ToNanoseconds(start);
+    Record(start_ns, ToNanoseconds(end) - start_ns, category, detail, arg);
+}
+
+void RecordInstant(const Category& category, const char* detail, u64 arg) {
+    Record(ToNanoseconds(Clock::now()), INSTANT, category, detail, arg);
+}
+} // namespace Detail
+
+void Start() {
+    Detail::enabled = true;
+}
+
+void Stop() {
+    Detail::enabled = false;
+}
+
+void Clear() {
+    std::lock_guard lock{registry_mutex};
+    for (const auto& buffer : registry) {
+        buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
+
+bool WriteChromeTrace(const std::string& path) {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::vector<std::string> names;
+    {
+        std::lock_guard lock{registry_mutex};
+        buffers = registry;
+        for (const auto& buffer : buffers) {
+            names.push_back(buffer->name);
+        }
+    }
+
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first_event = true;
+    const auto begin_event = [&] {
+        if (!first_event)
+            out += ",\n";
+        first_event = false;
+    };
+
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        const ThreadBuffer& buffer = *buffers[i];
+        if (!names[i].empty()) {
+            begin_event();
+            out += fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                               "\"args\":{{\"name\":\"",
+                               buffer.tid);
+            AppendEscaped(out, names[i]);
+            out += "\"}}";
+        }
+
+        for (const EventCopy& event : CopyEvents(buffer)) {
+            if (event.category == nullptr)
+                continue;
+            begin_event();
+            out += "{\"name\":\"";
+            AppendEscaped(out, event.category->name);
+            out += "\",\"cat\":\"";
+            AppendEscaped(out, event.category->group);
+            if (event.duration == INSTANT) {
+                out += fmt::format("\",\"ph\":\"i\",\"s\":\"t\",\"ts\":{:.3f}",
+                                   event.start / 1000.0);
+            } else {
+                out += fmt::format("\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f}",
+                                   event.start / 1000.0, event.duration / 1000.0);
+            }
+            out += fmt::format(",\"pid\":1,\"tid\":{}", buffer.tid);
+            if (event.detail != nullptr || event.arg != 0) {
+                out += ",\"args\":{";
+                if (event.detail != nullptr) {
+                    out += "\"detail\":\"";
+                    AppendEscaped(out, event.detail);
+                    out += event.arg != 0 ? "\"," : "\"";
+                }
+                if (event.arg != 0) {
+                    out += fmt::format("\"arg\":{}", event.arg);
+                }
+                out += '}';
+            }
+            out += '}';
+        }
+    }
+    out += "\n]}\n";
+
+    FileUtil::IOFile file(path, "w");
+    return file.IsOpen() && file.WriteString(out) == out.size();
+}
+
+const char* Intern(const std::string& str) {
+    static std::mutex intern_mutex;
+    static std::set<std::string> interned;
+    std::lock_guard lock{intern_mutex};
+    return interned.insert(str).first->c_str();
+}
+
+void SetThreadName(const char* name) {
+    thread_state.name = name;
+    if (thread_state.buffer) {
+        std::lock_guard lock{registry_mutex};
+        thread_state.buffer->name = name;
+    }
+}
+
+} // namespace Common::Tracing
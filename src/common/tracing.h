@@ -0,0 +1,99 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "common/common_types.h"
+
+/**
+ * A low overhead tracer that records the MicroProfile scopes and a few instant events into a
+ * ring buffer per thread, which can be written out as a Chrome trace (also loaded by Perfetto).
+ * Recording can be started and stopped at any time, and only the newest events of each thread are
+ * kept, so it can stay enabled for a whole session and be dumped when something interesting
+ * happened.
+ */
+namespace Common::Tracing {
+
+/// A kind of traced event, defined once with static storage like the MicroProfile tokens
+struct Category {
+    const char* group;
+    const char* name;
+};
+
+namespace Detail {
+extern std::atomic_bool enabled;
+
+using Clock = std::chrono::steady_clock;
+
+void RecordComplete(const Category& category, Clock::time_point start, Clock::time_point end,
+                    const char* detail, u64 arg);
+void RecordInstant(const Category& category, const char* detail, u64 arg);
+} // namespace Detail
+
+/// Whether events are currently recorded
+inline bool IsEnabled() {
+    return Detail::enabled.load(std::memory_order_relaxed);
+}
+
+/// Starts recording events, keeping the events that are still in the buffers
+void Start();
+
+/// Stops recording events
+void Stop();
+
+/// Drops the recorded events of all threads
+void Clear();
+
+/**
+ * Writes the recorded events of all threads as Chrome trace JSON. Recording may continue while
+ * this runs. Returns false if the file couldn't be written.
+ */
+bool WriteChromeTrace(const std::string& path);
+
+/// Names the calling thread in the written traces
+void SetThreadName(const char* name);
+
+/// Returns a copy of the string that is never freed, for use as event detail
+const char* Intern(const std::string& str);
+
+/**
+ * Records an event without duration. `detail` must point to a string with static storage, it is
+ * shown with `arg` as the arguments of the event.
+ */
+inline void Instant(const Category& category, const char* detail = nullptr, u64 arg = 0) {
+    if (IsEnabled()) {
+        Detail::RecordInstant(category, detail, arg);
+    }
+}
+
+/// Records the time from its construction to its destruction as an event of its category
+class Scope {
+public:
+    explicit Scope(const Category& category, const char* detail = nullptr, u64 arg = 0)
+        : category(IsEnabled() ? &category : nullptr), detail(detail), arg(arg) {
+        if (this->category != nullptr) {
+            start = Detail::Clock::now();
+        }
+    }
+
+    ~Scope() {
+        if (category != nullptr) {
+            Detail::RecordComplete(*category, start, Detail::Clock::now(), detail, arg);
+        }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const Category* category;
+    const char* detail;
+    u64 arg;
+    Detail::Clock::time_point start;
+};
+
+} // namespace Common::Tracing
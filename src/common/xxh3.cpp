@@ -0,0 +1,352 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include "common/swap.h"
+#include "common/xxh3.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(ARCHITECTURE_x86_64) && !defined(_MSC_VER)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace Common {
+
+namespace {
+constexpr u64 PRIME32_1 = 0x9E3779B1;
+constexpr u64 PRIME32_2 = 0x85EBCA77;
+constexpr u64 PRIME32_3 = 0xC2B2AE3D;
+constexpr u64 PRIME64_1 = 0x9E3779B185EBCA87;
+constexpr u64 PRIME64_2 = 0xC2B2AE3D27D4EB4F;
+constexpr u64 PRIME64_3 = 0x165667B19E3779F9;
+constexpr u64 PRIME64_4 = 0x85EBCA77C2B2AE63;
+constexpr u64 PRIME64_5 = 0x27D4EB2F165667C5;
+constexpr u64 PRIME_MX1 = 0x165667919E3779F9;
+constexpr u64 PRIME_MX2 = 0x9FB21C651E98DF25;
+
+constexpr std::size_t STRIPE_LEN = 64;
+constexpr std::size_t SECRET_CONSUME_RATE = 8;
+constexpr std::size_t NUM_ACCS = STRIPE_LEN / sizeof(u64);
+constexpr std::size_t MIDSIZE_MAX = 240;
+
+using Accumulators = std::array<u64, NUM_ACCS>;
+
+alignas(64) constexpr std::array<u8, 192> DEFAULT_SECRET{{
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+}};
+const u8* const secret = DEFAULT_SECRET.data();
+
+// The reference reads all words as little endian, which every supported host is
+u32 Read32(const u8* ptr) {
+    u32 value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+u64 Read64(const u8* ptr) {
+    u64 value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+constexpr u64 RotateLeft(u64 value, int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+/// Multiplies to 128 bits and folds the product by xoring its halves
+u64 Mul128Fold64(u64 lhs, u64 rhs) {
+#if defined(_MSC_VER) && defined(ARCHITECTURE_x86_64)
+    u64 high;
+    const u64 low = _umul128(lhs, rhs, &high);
+    return low ^ high;
+#elif defined(_MSC_VER)
+    return (lhs * rhs) ^ __umulh(lhs, rhs);
+#else
+    const unsigned __int128 product = static_cast<unsigned __int128>(lhs) * rhs;
+    return static_cast<u64>(product) ^ static_cast<u64>(product >> 64);
+#endif
+}
+
+u64 XXH64Avalanche(u64 hash) {
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    return hash ^ (hash >> 32);
+}
+
+u64 Avalanche(u64 hash) {
+    hash ^= hash >> 37;
+    hash *= PRIME_MX1;
+    return hash ^ (hash >> 32);
+}
+
+u64 RRMXMX(u64 hash, std::size_t len) {
+    hash ^= RotateLeft(hash, 49) ^ RotateLeft(hash, 24);
+    hash *= PRIME_MX2;
+    hash ^= (hash >> 35) + len;
+    hash *= PRIME_MX2;
+    return hash ^ (hash >> 28);
+}
+
+u64 Mix16(const u8* input, const u8* key) {
+    return Mul128Fold64(Read64(input) ^ Read64(key), Read64(input + 8) ^ Read64(key + 8));
+}
+
+u64 Hash0To16(const u8* input, std::size_t len) {
+    if (len > 8) {
+        const u64 bitflip_low = Read64(secret + 24) ^ Read64(secret + 32);
+        const u64 bitflip_high = Read64(secret + 40) ^ Read64(secret + 48);
+        const u64 input_low = Read64(input) ^ bitflip_low;
+        const u64 input_high = Read64(input + len - 8) ^ bitflip_high;
+        return Avalanche(len + swap64(input_low) + input_high +
+                         Mul128Fold64(input_low, input_high));
+    }
+    if (len >= 4) {
+        const u64 input64 = Read32(input + len - 4) + (static_cast<u64>(Read32(input)) << 32);
+        return RRMXMX(input64 ^ (Read64(secret + 8) ^ Read64(secret + 16)), len);
+    }
+    if (len > 0) {
+        const u32 combined = (static_cast<u32>(input[0]) << 16) |
+                             (static_cast<u32>(input[len >> 1]) << 24) | input[len - 1] |
+                             static_cast<u32>(len << 8);
+        return XXH64Avalanche(combined ^ (Read32(secret) ^ Read32(secret + 4)));
+    }
+    return XXH64Avalanche(Read64(secret + 56) ^ Read64(secret + 64));
+}
+
+u64 Hash17To128(const u8* input, std::size_t len) {
+    u64 acc = len * PRIME64_1;
+    if (len > 32) {
+        if (len > 64) {
+            if (len > 96) {
+                acc += Mix16(input + 48, secret + 96);
+                acc += Mix16(input + len - 64, secret + 112);
+            }
+            acc += Mix16(input + 32, secret + 64);
+            acc += Mix16(input + len - 48, secret + 80);
+        }
+        acc += Mix16(input + 16, secret + 32);
+        acc += Mix16(input + len - 32, secret + 48);
+    }
+    acc += Mix16(input, secret);
+    acc += Mix16(input + len - 16, secret + 16);
+    return Avalanche(acc);
+}
+
+u64 Hash129To240(const u8* input, std::size_t len) {
+    const std::size_t num_rounds = len / 16;
+    u64 acc = len * PRIME64_1;
+    for (std::size_t i = 0; i < 8; ++i) {
+        acc += Mix16(input + 16 * i, secret + 16 * i);
+    }
+    acc = Avalanche(acc);
+    for (std::size_t i = 8; i < num_rounds; ++i) {
+        acc += Mix16(input + 16 * i, secret + 16 * (i - 8) + 3);
+    }
+    acc += Mix16(input + len - 16, secret + 136 - 17);
+    return Avalanche(acc);
+}
+
+// The long input kernels, each accumulates one stripe of 64 bytes and scrambles the accumulators
+// after every block. They give the same results and only differ in speed.
+
+[[maybe_unused]] void AccumulateGeneric(Accumulators& acc, const u8* input, const u8* key) {
+    for (std::size_t i = 0; i < NUM_ACCS; ++i) {
+        const u64 data = Read64(input + 8 * i);
+        const u64 data_key = data ^ Read64(key + 8 * i);
+        acc[i ^ 1] += data;
+        acc[i] += (data_key & 0xFFFFFFFF) * (data_key >> 32);
+    }
+}
+
+[[maybe_unused]] void ScrambleGeneric(Accumulators& acc, const u8* key) {
+    for (std::size_t i = 0; i < NUM_ACCS; ++i) {
+        u64 value = acc[i];
+        value ^= value >> 47;
+        value ^= Read64(key + 8 * i);
+        acc[i] = value * PRIME32_1;
+    }
+}
+
+#if defined(ARCHITECTURE_x86_64)
+
+void AccumulateSSE2(Accumulators& acc, const u8* input, const u8* key) {
+    auto* const acc_vec = reinterpret_cast<__m128i*>(acc.data());
+    for (std::size_t i = 0; i < NUM_ACCS / 2; ++i) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input) + i);
+        const __m128i key_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key) + i);
+        const __m128i data_key = _mm_xor_si128(data, key_vec);
+        const __m128i data_key_high = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+        const __m128i product = _mm_mul_epu32(data_key, data_key_high);
+        const __m128i data_swap = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        acc_vec[i] = _mm_add_epi64(product, _mm_add_epi64(acc_vec[i], data_swap));
+    }
+}
+
+void ScrambleSSE2(Accumulators& acc, const u8* key) {
+    auto* const acc_vec = reinterpret_cast<__m128i*>(acc.data());
+    const __m128i prime = _mm_set1_epi32(static_cast<int>(PRIME32_1));
+    for (std::size_t i = 0; i < NUM_ACCS / 2; ++i) {
+        const __m128i value = _mm_xor_si128(acc_vec[i], _mm_srli_epi64(acc_vec[i], 47));
+        const __m128i key_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key) + i);
+        const __m128i data_key = _mm_xor_si128(value, key_vec);
+        const __m128i data_key_high = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+        const __m128i product_low = _mm_mul_epu32(data_key, prime);
+        const __m128i product_high = _mm_mul_epu32(data_key_high, prime);
+        acc_vec[i] = _mm_add_epi64(product_low, _mm_slli_epi64(product_high, 32));
+    }
+}
+
+TARGET_AVX2 void AccumulateAVX2(Accumulators& acc, const u8* input, const u8* key) {
+    auto* const acc_vec = reinterpret_cast<__m256i*>(acc.data());
+    for (std::size_t i = 0; i < NUM_ACCS / 4; ++i) {
+        const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input) + i);
+        const __m256i key_vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key) + i);
+        const __m256i data_key = _mm256_xor_si256(data, key_vec);
+        const __m256i data_key_high = _mm256_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+        const __m256i product = _mm256_mul_epu32(data_key, data_key_high);
+        const __m256i data_swap = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        const __m256i sum = _mm256_add_epi64(_mm256_loadu_si256(acc_vec + i), data_swap);
+        _mm256_storeu_si256(acc_vec + i, _mm256_add_epi64(product, sum));
+    }
+}
+
+TARGET_AVX2 void ScrambleAVX2(Accumulators& acc, const u8* key) {
+    auto* const acc_vec = reinterpret_cast<__m256i*>(acc.data());
+    const __m256i prime = _mm256_set1_epi32(static_cast<int>(PRIME32_1));
+    for (std::size_t i = 0; i < NUM_ACCS / 4; ++i) {
+        const __m256i loaded = _mm256_loadu_si256(acc_vec + i);
+        const __m256i value = _mm256_xor_si256(loaded, _mm256_srli_epi64(loaded, 47));
+        const __m256i key_vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key) + i);
+        const __m256i data_key = _mm256_xor_si256(value, key_vec);
+        const __m256i data_key_high = _mm256_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+        const __m256i product_low = _mm256_mul_epu32(data_key, prime);
+        const __m256i product_high = _mm256_mul_epu32(data_key_high, prime);
+        _mm256_storeu_si256(acc_vec + i,
+                            _mm256_add_epi64(product_low, _mm256_slli_epi64(product_high, 32)));
+    }
+}
+
+#elif defined(ARCHITECTURE_ARM64)
+
+void AccumulateNEON(Accumulators& acc, const u8* input, const u8* key) {
+    for (std::size_t i = 0; i < NUM_ACCS / 2; ++i) {
+        const uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(input + 16 * i));
+        const uint64x2_t key_vec = vreinterpretq_u64_u8(vld1q_u8(key + 16 * i));
+        const uint64x2_t data_key = veorq_u64(data, key_vec);
+        const uint64x2_t product = vmull_u32(vmovn_u64(data_key), vshrn_n_u64(data_key, 32));
+        const uint64x2_t data_swap = vextq_u64(data, data, 1);
+        const uint64x2_t sum = vaddq_u64(vld1q_u64(&acc[2 * i]), data_swap);
+        vst1q_u64(&acc[2 * i], vaddq_u64(sum, product));
+    }
+}
+
+void ScrambleNEON(Accumulators& acc, const u8* key) {
+    const uint32x2_t prime = vdup_n_u32(static_cast<u32>(PRIME32_1));
+    for (std::size_t i = 0; i < NUM_ACCS / 2; ++i) {
+        const uint64x2_t loaded = vld1q_u64(&acc[2 * i]);
+        const uint64x2_t value = veorq_u64(loaded, vshrq_n_u64(loaded, 47));
+        const uint64x2_t key_vec = vreinterpretq_u64_u8(vld1q_u8(key + 16 * i));
+        const uint64x2_t data_key = veorq_u64(value, key_vec);
+        const uint64x2_t product_high =
+            vshlq_n_u64(vmull_u32(vshrn_n_u64(data_key, 32), prime), 32);
+        vst1q_u64(&acc[2 * i], vmlal_u32(product_high, vmovn_u64(data_key), prime));
+    }
+}
+
+#endif
+
+using AccumulateFunc = void (*)(Accumulators&, const u8*, const u8*);
+using ScrambleFunc = void (*)(Accumulators&, const u8*);
+
+template <AccumulateFunc Accumulate, ScrambleFunc Scramble>
+u64 HashLong(const u8* input, std::size_t len) {
+    constexpr std::size_t secret_size = DEFAULT_SECRET.size();
+    constexpr std::size_t stripes_per_block = (secret_size - STRIPE_LEN) / SECRET_CONSUME_RATE;
+    constexpr std::size_t block_len = STRIPE_LEN * stripes_per_block;
+
+    alignas(32) Accumulators acc{PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+                                 PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+
+    const std::size_t num_blocks = (len - 1) / block_len;
+    for (std::size_t block = 0; block < num_blocks; ++block) {
+        const u8* const block_input = input + block * block_len;
+        for (std::size_t stripe = 0; stripe < stripes_per_block; ++stripe) {
+            Accumulate(acc, block_input + stripe * STRIPE_LEN,
+                       secret + stripe * SECRET_CONSUME_RATE);
+        }
+        Scramble(acc, secret + secret_size - STRIPE_LEN);
+    }
+
+    // The last partial block, and the last stripe which may overlap it
+    const std::size_t num_stripes = ((len - 1) - block_len * num_blocks) / STRIPE_LEN;
+    const u8* const last_block = input + num_blocks * block_len;
+    for (std::size_t stripe = 0; stripe < num_stripes; ++stripe) {
+        Accumulate(acc, last_block + stripe * STRIPE_LEN, secret + stripe * SECRET_CONSUME_RATE);
+    }
+    Accumulate(acc, input + len - STRIPE_LEN, secret + secret_size - STRIPE_LEN - 7);
+
+    u64 result = len * PRIME64_1;
+    for (std::size_t i = 0; i < NUM_ACCS / 2; ++i) {
+        const u8* const key = secret + 11 + 16 * i;
+        result += Mul128Fold64(acc[2 * i] ^ Read64(key), acc[2 * i + 1] ^ Read64(key + 8));
+    }
+    return Avalanche(result);
+}
+
+using HashLongFunc = u64 (*)(const u8*, std::size_t);
+
+HashLongFunc SelectHashLongFunc() {
+#if defined(ARCHITECTURE_x86_64)
+    if (Common::GetCPUCaps().avx2) {
+        return HashLong<AccumulateAVX2, ScrambleAVX2>;
+    }
+    return HashLong<AccumulateSSE2, ScrambleSSE2>;
+#elif defined(ARCHITECTURE_ARM64)
+    return HashLong<AccumulateNEON, ScrambleNEON>;
+#else
+    return HashLong<AccumulateGeneric, ScrambleGeneric>;
+#endif
+}
+} // Anonymous namespace
+
+u64 XXH3Hash64(const void* data, std::size_t len) {
+    const auto* const input = static_cast<const u8*>(data);
+    if (len <= 16)
+        return Hash0To16(input, len);
+    if (len <= 128)
+        return Hash17To128(input, len);
+    if (len <= MIDSIZE_MAX)
+        return Hash129To240(input, len);
+
+    static const HashLongFunc hash_long = SelectHashLongFunc();
+    return hash_long(input, len);
+}
+
+} // namespace Common
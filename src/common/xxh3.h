@@ -0,0 +1,19 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Computes the 64-bit XXH3 hash (seed 0, default secret) of the data. Inputs longer than 240 bytes
+ * are hashed with SSE2, AVX2 or NEON depending on the host, which is several times faster than
+ * CityHash64 on texture sized blocks. The results match the reference implementation.
+ */
+u64 XXH3Hash64(const void* data, std::size_t len);
+
+} // namespace Common
@@ -2,16 +2,23 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <dynarmic/A32/a32.h>
 #include <dynarmic/A32/context.h>
+#if defined(CITRA_DYNARMIC_GLOBAL_MONITOR) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #include "common/assert.h"
 #include "common/microprofile.h"
+#include "common/scope_exit.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
 #include "core/arm/dyncom/arm_dyncom_interpreter.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/cpu_threads.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/svc.h"
 #include "core/memory.h"
@@ -69,39 +76,158 @@ private:
     u32 fpexc;
 };
 
+// Loops that keep making the same SVC from the same PC this often, with the same registers and no
+// more than this many ticks between the calls, are considered idle loops
+constexpr u32 IDLE_LOOP_THRESHOLD = 16;
+constexpr u64 IDLE_LOOP_MAX_TICKS = 2000;
+
+// SVCs without side effects that guests poll in busy loops
+constexpr u32 SVC_SLEEP_THREAD = 0x0A;
+constexpr u32 SVC_GET_SYSTEM_TICK = 0x28;
+
+#ifdef CITRA_DYNARMIC_GLOBAL_MONITOR
+/// Stores the value if the memory still holds the expected one, as a single atomic operation
+template <typename T>
+bool AtomicCompareAndSwap(u8* pointer, T value, T expected) {
+#ifdef _MSC_VER
+    if constexpr (sizeof(T) == 1) {
+        return _InterlockedCompareExchange8(reinterpret_cast<volatile char*>(pointer),
+                                            static_cast<char>(value),
+                                            static_cast<char>(expected)) ==
+               static_cast<char>(expected);
+    } else if constexpr (sizeof(T) == 2) {
+        return _InterlockedCompareExchange16(reinterpret_cast<volatile short*>(pointer),
+                                             static_cast<short>(value),
+                                             static_cast<short>(expected)) ==
+               static_cast<short>(expected);
+    } else if constexpr (sizeof(T) == 4) {
+        return _InterlockedCompareExchange(reinterpret_cast<volatile long*>(pointer),
+                                           static_cast<long>(value),
+                                           static_cast<long>(expected)) ==
+               static_cast<long>(expected);
+    } else {
+        return _InterlockedCompareExchange64(reinterpret_cast<volatile __int64*>(pointer),
+                                             static_cast<__int64>(value),
+                                             static_cast<__int64>(expected)) ==
+               static_cast<__int64>(expected);
+    }
+#else
+    return __atomic_compare_exchange_n(reinterpret_cast<T*>(pointer), &expected, value, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+#endif
+
 class DynarmicUserCallbacks final : public Dynarmic::A32::UserCallbacks {
 public:
     explicit DynarmicUserCallbacks(ARM_Dynarmic& parent)
         : parent(parent), svc_context(parent.system), memory(parent.memory) {}
     ~DynarmicUserCallbacks() = default;
 
+    /**
+     * Executes the function on the emulation thread, see Core::CPUThreads::HostCall. Whatever
+     * other threads requested from the JIT in the meantime is applied before it continues.
+     */
+    template <typename Func>
+    auto HostCall(Func&& func) -> decltype(func()) {
+        SCOPE_EXIT({ parent.ApplyPendingRequests(); });
+        return Core::CPUThreads::HostCall(std::forward<Func>(func));
+    }
+
+    /**
+     * The JIT calls back for every page that isn't plain memory, which includes all pages the
+     * rasterizer caches. Reads of those don't need the slow path unless the rasterizer holds newer
+     * data, so they are served from the read pointers without a host call.
+     */
+    template <typename T, typename SlowRead>
+    T ReadMemory(VAddr vaddr, SlowRead&& slow_read) {
+        const u8* const page =
+            parent.current_page_table->read_pointers[vaddr >> Memory::PAGE_BITS];
+        if (page != nullptr) {
+            T value;
+            std::memcpy(&value, page + (vaddr & Memory::PAGE_MASK), sizeof(T));
+            return value;
+        }
+        return HostCall(slow_read);
+    }
+
     std::uint8_t MemoryRead8(VAddr vaddr) override {
-        return memory.Read8(vaddr);
+        return ReadMemory<std::uint8_t>(vaddr, [&] { return memory.Read8(vaddr); });
     }
     std::uint16_t MemoryRead16(VAddr vaddr) override {
-        return memory.Read16(vaddr);
+        return ReadMemory<std::uint16_t>(vaddr, [&] { return memory.Read16(vaddr); });
     }
     std::uint32_t MemoryRead32(VAddr vaddr) override {
-        return memory.Read32(vaddr);
+        return ReadMemory<std::uint32_t>(vaddr, [&] { return memory.Read32(vaddr); });
     }
     std::uint64_t MemoryRead64(VAddr vaddr) override {
-        return memory.Read64(vaddr);
+        return ReadMemory<std::uint64_t>(vaddr, [&] { return memory.Read64(vaddr); });
     }
 
     void MemoryWrite8(VAddr vaddr, std::uint8_t value) override {
-        memory.Write8(vaddr, value);
+        HostCall([&] { memory.Write8(vaddr, value); });
     }
     void MemoryWrite16(VAddr vaddr, std::uint16_t value) override {
-        memory.Write16(vaddr, value);
+        HostCall([&] { memory.Write16(vaddr, value); });
     }
     void MemoryWrite32(VAddr vaddr, std::uint32_t value) override {
-        memory.Write32(vaddr, value);
+        HostCall([&] { memory.Write32(vaddr, value); });
     }
     void MemoryWrite64(VAddr vaddr, std::uint64_t value) override {
-        memory.Write64(vaddr, value);
+        HostCall([&] { memory.Write64(vaddr, value); });
+    }
+
+#ifdef CITRA_DYNARMIC_GLOBAL_MONITOR
+    /**
+     * Called by the global exclusive monitor for STREX once the reservation of this core is still
+     * valid. The store only happens if no other core changed the memory since the LDREX, which the
+     * cores on other host threads may do at any time through the page table.
+     */
+    template <typename T, typename SlowRead, typename SlowWrite>
+    bool WriteExclusive(VAddr vaddr, T value, T expected, SlowRead&& slow_read,
+                        SlowWrite&& slow_write) {
+        u8* const page = parent.current_page_table->pointers[vaddr >> Memory::PAGE_BITS];
+        if (page != nullptr) {
+            return AtomicCompareAndSwap<T>(page + (vaddr & Memory::PAGE_MASK), value, expected);
+        }
+        return HostCall([&] {
+            if (slow_read() != expected)
+                return false;
+            slow_write();
+            return true;
+        });
+    }
+
+    bool MemoryWriteExclusive8(VAddr vaddr, std::uint8_t value, std::uint8_t expected) override {
+        return WriteExclusive<std::uint8_t>(
+            vaddr, value, expected, [&] { return memory.Read8(vaddr); },
+            [&] { memory.Write8(vaddr, value); });
     }
+    bool MemoryWriteExclusive16(VAddr vaddr, std::uint16_t value,
+                                std::uint16_t expected) override {
+        return WriteExclusive<std::uint16_t>(
+            vaddr, value, expected, [&] { return memory.Read16(vaddr); },
+            [&] { memory.Write16(vaddr, value); });
+    }
+    bool MemoryWriteExclusive32(VAddr vaddr, std::uint32_t value,
+                                std::uint32_t expected) override {
+        return WriteExclusive<std::uint32_t>(
+            vaddr, value, expected, [&] { return memory.Read32(vaddr); },
+            [&] { memory.Write32(vaddr, value); });
+    }
+    bool MemoryWriteExclusive64(VAddr vaddr, std::uint64_t value,
+                                std::uint64_t expected) override {
+        return WriteExclusive<std::uint64_t>(
+            vaddr, value, expected, [&] { return memory.Read64(vaddr); },
+            [&] { memory.Write64(vaddr, value); });
+    }
+#endif
 
     void InterpreterFallback(VAddr pc, std::size_t num_instructions) override {
+        HostCall([&] { RunInterpreter(pc, num_instructions); });
+    }
+
+    void RunInterpreter(VAddr pc, std::size_t num_instructions) {
         parent.interpreter_state->Reg = parent.jit->Regs();
         parent.interpreter_state->Cpsr = parent.jit->Cpsr();
         parent.interpreter_state->Reg[15] = pc;
@@ -123,10 +249,56 @@ public:
     }
 
     void CallSVC(std::uint32_t swi) override {
-        svc_context.CallSVC(swi);
+        HostCall([&] {
+            const auto& regs = parent.jit->Regs();
+            const bool is_polling = swi == SVC_GET_SYSTEM_TICK ||
+                                    (swi == SVC_SLEEP_THREAD && regs[0] == 0 && regs[1] == 0);
+            svc_context.CallSVC(swi);
+            DetectIdleLoop(swi, is_polling);
+        });
+    }
+
+    /**
+     * Skips ahead to the end of the slice, and thus the next event, when the guest spins on
+     * yielding or on reading the system tick while no other thread of this core is ready. Only
+     * loops that keep every register apart from the SVC results unchanged and take the same number
+     * of ticks per iteration count, which excludes polling loops that do work between the calls.
+     * Nothing such a loop waits for can happen before the next event on this core.
+     */
+    void DetectIdleLoop(std::uint32_t swi, bool is_polling) {
+        if (!is_polling) {
+            idle_loop_count = 0;
+            return;
+        }
+
+        // The PC already points after the SVC instruction, r0 and r1 hold its results
+        const auto& regs = parent.jit->Regs();
+        const u32 pc = regs[15];
+        std::array<u32, 13> loop_regs;
+        std::copy(regs.begin() + 2, regs.begin() + 15, loop_regs.begin());
+        const u64 ticks = parent.GetTimer()->GetTicks();
+        const u64 period = ticks - idle_loop_ticks;
+        if (pc == idle_loop_pc && swi == idle_loop_swi && loop_regs == idle_loop_regs &&
+            period == idle_loop_period && period <= IDLE_LOOP_MAX_TICKS) {
+            if (++idle_loop_count >= IDLE_LOOP_THRESHOLD &&
+                !parent.system.Kernel().GetCurrentThreadManager().HaveReadyThreads()) {
+                parent.GetTimer()->Idle();
+            }
+        } else {
+            idle_loop_count = 0;
+        }
+        idle_loop_pc = pc;
+        idle_loop_swi = swi;
+        idle_loop_regs = loop_regs;
+        idle_loop_period = period;
+        idle_loop_ticks = parent.GetTimer()->GetTicks();
     }
 
     void ExceptionRaised(VAddr pc, Dynarmic::A32::Exception exception) override {
+        HostCall([&] { HandleException(pc, exception); });
+    }
+
+    void HandleException(VAddr pc, Dynarmic::A32::Exception exception) {
         switch (exception) {
         case Dynarmic::A32::Exception::UndefinedInstruction:
         case Dynarmic::A32::Exception::UnpredictableInstruction:
@@ -150,6 +322,7 @@ public:
 
     void AddTicks(std::uint64_t ticks) override {
         parent.GetTimer()->AddTicks(ticks);
+        parent.ApplyPendingRequests();
     }
     std::uint64_t GetTicksRemaining() override {
         s64 ticks = parent.GetTimer()->GetDowncount();
@@ -159,13 +332,22 @@ public:
     ARM_Dynarmic& parent;
     Kernel::SVCContext svc_context;
     Memory::MemorySystem& memory;
+
+    u32 idle_loop_pc = 0;
+    u32 idle_loop_swi = 0;
+    std::array<u32, 13> idle_loop_regs{};
+    u64 idle_loop_ticks = 0;
+    u64 idle_loop_period = 0;
+    u32 idle_loop_count = 0;
 };
 
 ARM_Dynarmic::ARM_Dynarmic(Core::System* system, Memory::MemorySystem& memory,
                            PrivilegeMode initial_mode, u32 id,
-                           std::shared_ptr<Core::Timing::Timer> timer)
+                           std::shared_ptr<Core::Timing::Timer> timer,
+                           std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor)
     : ARM_Interface(id, timer), system(*system), memory(memory),
-      cb(std::make_unique<DynarmicUserCallbacks>(*this)) {
+      cb(std::make_unique<DynarmicUserCallbacks>(*this)),
+      exclusive_monitor(std::move(exclusive_monitor)) {
     interpreter_state = std::make_shared<ARMul_State>(system, memory, initial_mode);
     PageTableChanged();
 }
@@ -178,7 +360,16 @@ void ARM_Dynarmic::Run() {
     ASSERT(memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
 
+    {
+        std::lock_guard lock{pending_mutex};
+        running_thread = std::this_thread::get_id();
+    }
     jit->Run();
+    {
+        std::lock_guard lock{pending_mutex};
+        running_thread = {};
+    }
+    ApplyPendingRequests();
 }
 
 void ARM_Dynarmic::Step() {
@@ -248,28 +439,56 @@ std::unique_ptr<ARM_Interface::ThreadContext> ARM_Dynarmic::NewContext() const {
 }
 
 void ARM_Dynarmic::SaveContext(const std::unique_ptr<ThreadContext>& arg) {
-    DynarmicThreadContext* ctx = dynamic_cast<DynarmicThreadContext*>(arg.get());
-    ASSERT(ctx);
+    auto* ctx = static_cast<DynarmicThreadContext*>(arg.get());
 
     jit->SaveContext(ctx->ctx);
     ctx->fpexc = interpreter_state->VFP[VFP_FPEXC];
 }
 
 void ARM_Dynarmic::LoadContext(const std::unique_ptr<ThreadContext>& arg) {
-    const DynarmicThreadContext* ctx = dynamic_cast<DynarmicThreadContext*>(arg.get());
-    ASSERT(ctx);
+    const auto* ctx = static_cast<const DynarmicThreadContext*>(arg.get());
 
     jit->LoadContext(ctx->ctx);
     interpreter_state->VFP[VFP_FPEXC] = ctx->fpexc;
 }
 
 void ARM_Dynarmic::PrepareReschedule() {
+    std::lock_guard lock{pending_mutex};
+    if (IsRunningOnOtherThread()) {
+        stop_requested = true;
+        requests_pending = true;
+        return;
+    }
     if (jit->IsExecuting()) {
         jit->HaltExecution();
     }
 }
 
 void ARM_Dynarmic::ClearInstructionCache() {
+    std::lock_guard lock{pending_mutex};
+    if (IsRunningOnOtherThread()) {
+        pending_clear = true;
+        requests_pending = true;
+        return;
+    }
+    ClearCaches();
+}
+
+void ARM_Dynarmic::InvalidateCacheRange(u32 start_address, std::size_t length) {
+    std::lock_guard lock{pending_mutex};
+    if (IsRunningOnOtherThread()) {
+        pending_invalidations.emplace_back(start_address, length);
+        requests_pending = true;
+        return;
+    }
+    jit->InvalidateCacheRange(start_address, length);
+}
+
+bool ARM_Dynarmic::IsRunningOnOtherThread() const {
+    return running_thread != std::thread::id{} && running_thread != std::this_thread::get_id();
+}
+
+void ARM_Dynarmic::ClearCaches() {
     // TODO: Clear interpreter cache when appropriate.
     for (const auto& j : jits) {
         j.second->ClearCache();
@@ -277,8 +496,24 @@ void ARM_Dynarmic::ClearInstructionCache() {
     interpreter_state->instruction_cache.clear();
 }
 
-void ARM_Dynarmic::InvalidateCacheRange(u32 start_address, std::size_t length) {
-    jit->InvalidateCacheRange(start_address, length);
+void ARM_Dynarmic::ApplyPendingRequests() {
+    if (!requests_pending.exchange(false))
+        return;
+
+    std::lock_guard lock{pending_mutex};
+    if (pending_clear) {
+        ClearCaches();
+    } else {
+        for (const auto& [start_address, length] : pending_invalidations) {
+            jit->InvalidateCacheRange(start_address, length);
+        }
+    }
+    pending_clear = false;
+    pending_invalidations.clear();
+
+    if (stop_requested.exchange(false) && jit->IsExecuting()) {
+        jit->HaltExecution();
+    }
 }
 
 void ARM_Dynarmic::PageTableChanged() {
@@ -298,8 +533,15 @@ void ARM_Dynarmic::PageTableChanged() {
 std::unique_ptr<Dynarmic::A32::Jit> ARM_Dynarmic::MakeJit() {
     Dynarmic::A32::UserConfig config;
     config.callbacks = cb.get();
-    config.page_table = &current_page_table->pointers;
+    // The pointers are one flat array, only their storage is allocated differently
+    config.page_table = reinterpret_cast<std::array<u8*, Memory::PAGE_TABLE_NUM_ENTRIES>*>(
+        current_page_table->pointers.data());
     config.coprocessors[15] = std::make_shared<DynarmicCP15>(interpreter_state);
     config.define_unpredictable_behaviour = true;
+#ifdef CITRA_DYNARMIC_GLOBAL_MONITOR
+    // The cores may run on parallel host threads, so LDREX/STREX need a monitor shared by all
+    config.processor_id = GetID();
+    config.global_monitor = exclusive_monitor.get();
+#endif
     return std::make_unique<Dynarmic::A32::Jit>(config);
 }
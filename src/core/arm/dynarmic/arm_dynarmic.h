@@ -4,9 +4,21 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <dynarmic/A32/a32.h>
+// Only versions of dynarmic with a global exclusive monitor for A32 have this header, older ones
+// track the exclusive accesses of each Jit on its own
+#if __has_include(<dynarmic/exclusive_monitor.h>)
+#include <dynarmic/exclusive_monitor.h>
+#define CITRA_DYNARMIC_GLOBAL_MONITOR
+#endif
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
 #include "core/arm/skyeye_common/armstate.h"
@@ -20,12 +32,22 @@ namespace Core {
 class System;
 }
 
+namespace Dynarmic {
+class ExclusiveMonitor;
+}
+
 class DynarmicUserCallbacks;
 
+/**
+ * ARM11 core on top of dynarmic. Dynarmic isn't thread-safe, so a JIT that runs on another thread
+ * is neither halted nor are its caches touched directly: the requests are queued and the core
+ * applies them on its own thread when it next calls back, or once it stopped running.
+ */
 class ARM_Dynarmic final : public ARM_Interface {
 public:
     ARM_Dynarmic(Core::System* system, Memory::MemorySystem& memory, PrivilegeMode initial_mode,
-                 u32 id, std::shared_ptr<Core::Timing::Timer> timer);
+                 u32 id, std::shared_ptr<Core::Timing::Timer> timer,
+                 std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor);
     ~ARM_Dynarmic() override;
 
     void Run() override;
@@ -61,8 +83,29 @@ private:
     std::unique_ptr<DynarmicUserCallbacks> cb;
     std::unique_ptr<Dynarmic::A32::Jit> MakeJit();
 
+    /// Returns true if Run is executing on another thread than the calling one, needs pending_mutex
+    bool IsRunningOnOtherThread() const;
+    void ClearCaches();
+    /// Applies the requests queued by other threads, only called on the thread running the JIT
+    void ApplyPendingRequests();
+
     Dynarmic::A32::Jit* jit = nullptr;
     Memory::PageTable* current_page_table = nullptr;
     std::map<Memory::PageTable*, std::unique_ptr<Dynarmic::A32::Jit>> jits;
     std::shared_ptr<ARMul_State> interpreter_state;
+
+    std::mutex pending_mutex;
+    /// The thread executing Run, no thread while the core isn't running
+    std::thread::id running_thread;
+    /// Ranges other threads invalidated while the JIT was running
+    std::vector<std::pair<u32, std::size_t>> pending_invalidations;
+    /// Whether other threads cleared all caches while the JIT was running
+    bool pending_clear = false;
+    /// Set by PrepareReschedule on other threads, the JIT halts itself at its next callback
+    std::atomic<bool> stop_requested{false};
+    /// Set along with the requests above, so callbacks only check them when there are any
+    std::atomic<bool> requests_pending{false};
+    /// Shared by the cores of the system, its index for this core is the core ID. Null if dynarmic
+    /// has no global exclusive monitor.
+    std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor;
 };
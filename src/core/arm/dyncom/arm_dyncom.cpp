@@ -87,8 +87,10 @@ void ARM_DynCom::Step() {
 }
 
 void ARM_DynCom::ClearInstructionCache() {
+    // The buffer is shared by all cores, the others drop their cache on their next dispatch
     state->instruction_cache.clear();
-    trans_cache_buf_top = 0;
+    ResetTransCache();
+    state->instruction_cache_generation = trans_cache_generation;
 }
 
 void ARM_DynCom::InvalidateCacheRange(u32, std::size_t) {
@@ -96,7 +98,13 @@ void ARM_DynCom::InvalidateCacheRange(u32, std::size_t) {
 }
 
 void ARM_DynCom::PageTableChanged() {
-    ClearInstructionCache();
+    // The kernel notifies about the page table on every switch between cores, even when it is
+    // still the same one. Only another process needs the blocks translated again.
+    const Memory::PageTable* page_table = state->memory.GetCurrentPageTable();
+    if (page_table == state->instruction_cache_page_table)
+        return;
+    state->instruction_cache.clear();
+    state->instruction_cache_page_table = page_table;
 }
 
 void ARM_DynCom::SetPC(u32 pc) {
@@ -161,8 +169,7 @@ std::unique_ptr<ARM_Interface::ThreadContext> ARM_DynCom::NewContext() const {
 }
 
 void ARM_DynCom::SaveContext(const std::unique_ptr<ThreadContext>& arg) {
-    DynComThreadContext* ctx = dynamic_cast<DynComThreadContext*>(arg.get());
-    ASSERT(ctx);
+    auto* ctx = static_cast<DynComThreadContext*>(arg.get());
 
     ctx->cpu_registers = state->Reg;
     ctx->cpsr = state->Cpsr;
@@ -172,8 +179,7 @@ void ARM_DynCom::SaveContext(const std::unique_ptr<ThreadContext>& arg) {
 }
 
 void ARM_DynCom::LoadContext(const std::unique_ptr<ThreadContext>& arg) {
-    DynComThreadContext* ctx = dynamic_cast<DynComThreadContext*>(arg.get());
-    ASSERT(ctx);
+    auto* ctx = static_cast<DynComThreadContext*>(arg.get());
 
     state->Reg = ctx->cpu_registers;
     state->Cpsr = ctx->cpsr;
@@ -1640,10 +1640,20 @@ DISPATCH : {
     else
         cpu->Reg[15] &= 0xfffffffc;
 
+    // Translations are dropped once another core resets the buffer they live in
+    if (cpu->instruction_cache_generation != trans_cache_generation) {
+        cpu->instruction_cache.clear();
+        cpu->instruction_cache_generation = trans_cache_generation;
+    }
+
     // Find the cached instruction cream, otherwise translate it...
     auto itr = cpu->instruction_cache.find(cpu->Reg[15]);
     if (itr != cpu->instruction_cache.end()) {
         ptr = itr->second;
+    } else if (trans_cache_buf_top > TRANS_CACHE_SIZE - TRANS_CACHE_BLOCK_MARGIN) {
+        // Start over instead of failing once the buffer fills up
+        ResetTransCache();
+        goto DISPATCH;
     } else if (cpu->NumInstrsToExecute != 1) {
         if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
             goto END;
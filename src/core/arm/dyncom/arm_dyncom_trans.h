@@ -494,5 +494,13 @@ extern const transop_fp_t arm_instruction_trans[];
 extern const std::size_t arm_instruction_trans_len;
 
 #define TRANS_CACHE_SIZE (64 * 1024 * 2000)
+// Space that has to be left in the buffer before translating a block, enough for a page of
+// Thumb instructions
+#define TRANS_CACHE_BLOCK_MARGIN (1024 * 1024)
 extern char trans_cache_buf[TRANS_CACHE_SIZE];
 extern std::size_t trans_cache_buf_top;
+// Bumped whenever the buffer is reset, which invalidates the instruction caches of all cores
+extern u64 trans_cache_generation;
+
+// Throws away all translated instructions
+void ResetTransCache();
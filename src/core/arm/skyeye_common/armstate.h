@@ -29,6 +29,7 @@ class System;
 
 namespace Memory {
 class MemorySystem;
+struct PageTable;
 }
 
 // Signal levels
@@ -255,6 +256,10 @@ public:
     // TODO(bunnei): Move this cache to a better place - it should be per codeset (likely per
     // process for our purposes), not per ARMul_State (which tracks CPU core state).
     std::unordered_map<u32, std::size_t> instruction_cache;
+    /// Page table the cached instructions were translated from
+    const Memory::PageTable* instruction_cache_page_table = nullptr;
+    /// Generation of the translation buffer the cached instructions live in
+    u64 instruction_cache_generation = 0;
 
 private:
     void ResetMPCoreCP15Registers();
@@ -52,6 +52,9 @@
  */
 
 #include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -273,6 +276,93 @@ static u32 vfp_propagate_nan(struct vfp_single* vsd, struct vfp_single* vsn, str
     return tn == VFP_SNAN || tm == VFP_SNAN ? FPSCR_IOC : VFP_NAN_FLAG;
 }
 
+/*
+ * Host FPU fast path.
+ *
+ * In round-to-nearest mode, with normal or zero operands and a result that neither overflows nor
+ * underflows, IEEE arithmetic on the host gives the same result as the emulation, and inexact is
+ * the only exception that can be raised. Computing in double precision and rounding once to
+ * single precision is correctly rounded for add, multiply, divide and square root, and lets the
+ * exactness of the result be checked in double precision. Denormals never reach the host, so the
+ * flush-to-zero setting doesn't matter. Everything else takes the software path.
+ */
+enum class vfp_host_op { add, mul, nmul, div, sqrt };
+
+static bool vfp_single_is_normal_or_zero(s32 val) {
+    const u32 exponent = (static_cast<u32>(val) >> 23) & 0xFF;
+    return (exponent != 0 && exponent != 0xFF) || (val & 0x7FFFFFFF) == 0;
+}
+
+static double vfp_single_to_host(s32 val) {
+    float f;
+    std::memcpy(&f, &val, sizeof(f));
+    return f;
+}
+
+/*
+ * Computes sd = sn op sm on the host FPU, sn is ignored for sqrt. Returns false without writing
+ * sd when the operation has to be emulated.
+ */
+static bool vfp_single_host_op(ARMul_State* state, int sd, s32 n, s32 m, u32 fpscr,
+                               vfp_host_op op, u32* exceptions) {
+    // x87 would round the double precision intermediates to extended precision first
+    if (FLT_EVAL_METHOD != 0 || (fpscr & FPSCR_RMODE_MASK) != FPSCR_ROUND_NEAREST)
+        return false;
+    if (!vfp_single_is_normal_or_zero(m))
+        return false;
+    if (op != vfp_host_op::sqrt && !vfp_single_is_normal_or_zero(n))
+        return false;
+
+    const double a = vfp_single_to_host(n);
+    const double b = vfp_single_to_host(m);
+    double result;
+    bool exact = true;
+    switch (op) {
+    case vfp_host_op::add: {
+        // The sum of two floats isn't always exact in double precision, the error term tells
+        result = a + b;
+        const double b_part = result - a;
+        exact = (a - (result - b_part)) + (b - b_part) == 0.0;
+        break;
+    }
+    case vfp_host_op::mul:
+    case vfp_host_op::nmul:
+        result = a * b;
+        break;
+    case vfp_host_op::div:
+        if (b == 0.0)
+            return false;
+        result = a / b;
+        break;
+    case vfp_host_op::sqrt:
+        if (b <= 0.0)
+            return false;
+        result = std::sqrt(b);
+        break;
+    }
+
+    float rounded = static_cast<float>(result);
+    if (result != 0.0 && !(std::fabs(result) >= FLT_MIN && std::isfinite(rounded)))
+        return false;
+
+    // Products of two floats are exact in double precision
+    if (op == vfp_host_op::div)
+        exact = static_cast<double>(rounded) * b == a;
+    else if (op == vfp_host_op::sqrt)
+        exact = static_cast<double>(rounded) * rounded == b;
+    else
+        exact = exact && static_cast<double>(rounded) == result;
+
+    if (op == vfp_host_op::nmul)
+        rounded = -rounded;
+
+    s32 d;
+    std::memcpy(&d, &rounded, sizeof(d));
+    vfp_put_float(state, d, sd);
+    *exceptions = exact ? 0 : FPSCR_IXC;
+    return true;
+}
+
 /*
  * Extended operations
  */
@@ -334,6 +424,9 @@ static u32 vfp_single_fsqrt(ARMul_State* state, int sd, int unused, s32 m, u32 f
     int ret, tm;
     u32 exceptions = 0;
 
+    if (vfp_single_host_op(state, sd, 0, m, fpscr, vfp_host_op::sqrt, &exceptions))
+        return exceptions;
+
     exceptions |= vfp_single_unpack(&vsm, m, fpscr);
     tm = vfp_single_type(&vsm);
     if (tm & (VFP_NAN | VFP_INFINITY)) {
@@ -996,6 +1089,9 @@ static u32 vfp_single_fmul(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr)
 
     LOG_TRACE(Core_ARM11, "s{} = {:08x}", sn, n);
 
+    if (vfp_single_host_op(state, sd, n, m, fpscr, vfp_host_op::mul, &exceptions))
+        return exceptions;
+
     exceptions |= vfp_single_unpack(&vsn, n, fpscr);
     if (vsn.exponent == 0 && vsn.significand)
         vfp_single_normalise_denormal(&vsn);
@@ -1018,6 +1114,9 @@ static u32 vfp_single_fnmul(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr
 
     LOG_TRACE(Core_ARM11, "s{} = {:08x}", sn, n);
 
+    if (vfp_single_host_op(state, sd, n, m, fpscr, vfp_host_op::nmul, &exceptions))
+        return exceptions;
+
     exceptions |= vfp_single_unpack(&vsn, n, fpscr);
     if (vsn.exponent == 0 && vsn.significand)
         vfp_single_normalise_denormal(&vsn);
@@ -1041,6 +1140,9 @@ static u32 vfp_single_fadd(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr)
 
     LOG_TRACE(Core_ARM11, "s{} = {:08x}", sn, n);
 
+    if (vfp_single_host_op(state, sd, n, m, fpscr, vfp_host_op::add, &exceptions))
+        return exceptions;
+
     /*
      * Unpack and normalise denormals.
      */
@@ -1092,6 +1194,9 @@ static u32 vfp_single_fdiv(ARMul_State* state, int sd, int sn, s32 m, u32 fpscr)
 
     LOG_TRACE(Core_ARM11, "s{} = {:08x}", sn, n);
 
+    if (vfp_single_host_op(state, sd, n, m, fpscr, vfp_host_op::div, &exceptions))
+        return exceptions;
+
     exceptions |= vfp_single_unpack(&vsn, n, fpscr);
     exceptions |= vfp_single_unpack(&vsm, m, fpscr);
 
@@ -3,7 +3,31 @@
 // Refer to the license.txt file included.
 
 #include "core/cheats/cheat_base.h"
+#include "core/core.h"
+#include "core/hle/service/hid/hid.h"
 
 namespace Cheats {
+
+CheatPass::CheatPass(Core::System& system_) : system(system_), invalidation(system_) {}
+
+u32 CheatPass::GetPadState() {
+    if (!pad_state) {
+        pad_state = system.ServiceManager()
+                        .GetService<Service::HID::Module::Interface>("hid:USER")
+                        ->GetModule()
+                        ->GetState()
+                        .hex;
+    }
+    return *pad_state;
+}
+
+void CheatPass::MarkWritten(VAddr address, std::size_t size) {
+    system.InvalidateCacheRange(address, size);
+}
+
+void CheatPass::Finish() {
+    invalidation.Commit();
+}
+
 CheatBase::~CheatBase() = default;
 } // namespace Cheats
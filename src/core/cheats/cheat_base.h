@@ -4,17 +4,50 @@
 
 #pragma once
 
+#include <cstddef>
+#include <optional>
 #include <string>
+#include "common/common_types.h"
+#include "core/invalidation_batch.h"
 
 namespace Core {
 class System;
 }
 
 namespace Cheats {
+
+/**
+ * State shared by all the cheats that are executed in one pass of the cheat engine, so that work
+ * like invalidating the JIT code of the written memory is done once for all of them.
+ */
+class CheatPass {
+public:
+    explicit CheatPass(Core::System& system);
+
+    Core::System& GetSystem() const {
+        return system;
+    }
+
+    /// Returns the state of the pad buttons, which is only looked up once per pass
+    u32 GetPadState();
+
+    /// Records a write of a cheat, whose JIT code is invalidated when the pass is finished
+    void MarkWritten(VAddr address, std::size_t size);
+
+    /// Invalidates the JIT code of all the memory that has been written during the pass
+    void Finish();
+
+private:
+    Core::System& system;
+    std::optional<u32> pad_state;
+    /// Collects the invalidations of the whole pass, including those outside of MarkWritten
+    Core::InvalidationBatch invalidation;
+};
+
 class CheatBase {
 public:
     virtual ~CheatBase();
-    virtual void Execute(Core::System& system) const = 0;
+    virtual void Execute(CheatPass& pass) const = 0;
 
     virtual bool IsEnabled() const = 0;
     virtual void SetEnabled(bool enabled) = 0;
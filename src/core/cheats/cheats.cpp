@@ -6,6 +6,7 @@
 #include <functional>
 #include <fmt/format.h>
 #include "common/file_util.h"
+#include "core/cheats/cheat_base.h"
 #include "core/cheats/cheats.h"
 #include "core/cheats/gateway_cheat.h"
 #include "core/core.h"
@@ -15,12 +16,15 @@
 namespace Cheats {
 
 constexpr u64 run_interval_ticks = BASE_CLOCK_RATE_ARM11 / 60;
+// Cheats may run up to 1 ms late to share a wakeup with other events
+constexpr s64 run_slack_ticks = BASE_CLOCK_RATE_ARM11 / 1000;
 
 CheatEngine::CheatEngine(Core::System& system_) : system(system_) {
     LoadCheatFile();
     event = system.CoreTiming().RegisterEvent(
         "CheatCore::run_event",
-        [this](u64 thread_id, s64 cycle_late) { RunCallback(thread_id, cycle_late); });
+        [this](u64 thread_id, s64 cycle_late) { RunCallback(thread_id, cycle_late); },
+        run_slack_ticks);
     system.CoreTiming().ScheduleEvent(run_interval_ticks, event);
 }
 
@@ -97,12 +101,16 @@ void CheatEngine::LoadCheatFile() {
 
 void CheatEngine::RunCallback([[maybe_unused]] u64 userdata, int cycles_late) {
     {
+        // All the enabled cheats run in one pass, which invalidates the JIT code of the memory
+        // they patched once at the end
+        CheatPass pass{system};
         std::shared_lock<std::shared_mutex> lock(cheats_list_mutex);
         for (auto& cheat : cheats_list) {
             if (cheat->IsEnabled()) {
-                cheat->Execute(system);
+                cheat->Execute(pass);
             }
         }
+        pass.Finish();
     }
     system.CoreTiming().ScheduleEvent(run_interval_ticks - cycles_late, event);
 }
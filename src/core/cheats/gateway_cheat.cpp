@@ -3,7 +3,6 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
-#include <cmath>
 #include <fstream>
 #include <functional>
 #include <string>
@@ -13,7 +12,7 @@
 #include "common/string_util.h"
 #include "core/cheats/gateway_cheat.h"
 #include "core/core.h"
-#include "core/hle/service/hid/hid.h"
+#include "core/hle/kernel/process.h"
 #include "core/memory.h"
 
 namespace Cheats {
@@ -28,18 +27,20 @@ struct State {
     bool loop_flag = false;
 };
 
+using Instruction = GatewayCheat::Instruction;
+
 template <typename T, typename WriteFunction>
-static inline std::enable_if_t<std::is_integral_v<T>> WriteOp(const GatewayCheat::CheatLine& line,
+static inline std::enable_if_t<std::is_integral_v<T>> WriteOp(const Instruction& line,
                                                               const State& state,
                                                               WriteFunction write_func,
-                                                              Core::System& system) {
+                                                              CheatPass& pass) {
     u32 addr = line.address + state.offset;
     write_func(addr, static_cast<T>(line.value));
-    system.InvalidateCacheRange(addr, sizeof(T));
+    pass.MarkWritten(addr, sizeof(T));
 }
 
 template <typename T, typename ReadFunction, typename CompareFunc>
-static inline std::enable_if_t<std::is_integral_v<T>> CompOp(const GatewayCheat::CheatLine& line,
+static inline std::enable_if_t<std::is_integral_v<T>> CompOp(const Instruction& line,
                                                              State& state, ReadFunction read_func,
                                                              CompareFunc comp) {
     u32 addr = line.address + state.offset;
@@ -49,13 +50,13 @@ static inline std::enable_if_t<std::is_integral_v<T>> CompOp(const GatewayCheat:
     }
 }
 
-static inline void LoadOffsetOp(Memory::MemorySystem& memory, const GatewayCheat::CheatLine& line,
+static inline void LoadOffsetOp(Memory::MemorySystem& memory, const Instruction& line,
                                 State& state) {
     u32 addr = line.address + state.offset;
     state.offset = memory.Read32(addr);
 }
 
-static inline void LoopOp(const GatewayCheat::CheatLine& line, State& state) {
+static inline void LoopOp(const Instruction& line, State& state) {
     state.loop_flag = state.loop_count < line.value;
     state.loop_count++;
     state.loop_back_line = state.current_line_nr;
@@ -87,88 +88,57 @@ static inline void FullTerminateOp(State& state) {
     }
 }
 
-static inline void SetOffsetOp(const GatewayCheat::CheatLine& line, State& state) {
+static inline void SetOffsetOp(const Instruction& line, State& state) {
     state.offset = line.value;
 }
 
-static inline void AddValueOp(const GatewayCheat::CheatLine& line, State& state) {
+static inline void AddValueOp(const Instruction& line, State& state) {
     state.reg += line.value;
 }
 
-static inline void SetValueOp(const GatewayCheat::CheatLine& line, State& state) {
+static inline void SetValueOp(const Instruction& line, State& state) {
     state.reg = line.value;
 }
 
 template <typename T, typename WriteFunction>
-static inline std::enable_if_t<std::is_integral_v<T>> IncrementiveWriteOp(
-    const GatewayCheat::CheatLine& line, State& state, WriteFunction write_func,
-    Core::System& system) {
+static inline std::enable_if_t<std::is_integral_v<T>> IncrementiveWriteOp(const Instruction& line,
+                                                                          State& state,
+                                                                          WriteFunction write_func,
+                                                                          CheatPass& pass) {
     u32 addr = line.value + state.offset;
     write_func(addr, static_cast<T>(state.reg));
-    system.InvalidateCacheRange(addr, sizeof(T));
+    pass.MarkWritten(addr, sizeof(T));
     state.offset += sizeof(T);
 }
 
 template <typename T, typename ReadFunction>
-static inline std::enable_if_t<std::is_integral_v<T>> LoadOp(const GatewayCheat::CheatLine& line,
+static inline std::enable_if_t<std::is_integral_v<T>> LoadOp(const Instruction& line,
                                                              State& state, ReadFunction read_func) {
 
     u32 addr = line.value + state.offset;
     state.reg = read_func(addr);
 }
 
-static inline void AddOffsetOp(const GatewayCheat::CheatLine& line, State& state) {
+static inline void AddOffsetOp(const Instruction& line, State& state) {
     state.offset += line.value;
 }
 
-static inline void JokerOp(const GatewayCheat::CheatLine& line, State& state,
-                           const Core::System& system) {
-    u32 pad_state = system.ServiceManager()
-                        .GetService<Service::HID::Module::Interface>("hid:USER")
-                        ->GetModule()
-                        ->GetState()
-                        .hex;
-    bool pressed = (pad_state & line.value) == line.value;
+static inline void JokerOp(const Instruction& line, State& state, CheatPass& pass) {
+    bool pressed = (pass.GetPadState() & line.value) == line.value;
     if (!pressed) {
         state.if_flag++;
     }
 }
 
-static inline void PatchOp(const GatewayCheat::CheatLine& line, State& state, Core::System& system,
-                           const std::vector<GatewayCheat::CheatLine>& cheat_lines) {
-    if (state.if_flag > 0) {
-        // Skip over the additional patch lines
-        state.current_line_nr += static_cast<int>(std::ceil(line.value / 8.0));
+static inline void PatchOp(const Instruction& line, const State& state, CheatPass& pass,
+                           const std::vector<u8>& patch_data) {
+    if (line.value == 0)
         return;
-    }
-    u32 num_bytes = line.value;
     u32 addr = line.address + state.offset;
-    system.InvalidateCacheRange(addr, num_bytes);
-
-    bool first = true;
-    u32 bit_offset = 0;
-    if (num_bytes > 0)
-        state.current_line_nr++; // skip over the current code
-    while (num_bytes >= 4) {
-        u32 tmp = first ? cheat_lines[state.current_line_nr].first
-                        : cheat_lines[state.current_line_nr].value;
-        if (!first && num_bytes > 4) {
-            state.current_line_nr++;
-        }
-        first = !first;
-        system.Memory().Write32(addr, tmp);
-        addr += 4;
-        num_bytes -= 4;
-    }
-    while (num_bytes > 0) {
-        u32 tmp = (first ? cheat_lines[state.current_line_nr].first
-                         : cheat_lines[state.current_line_nr].value) >>
-                  bit_offset;
-        system.Memory().Write8(addr, tmp);
-        addr += 1;
-        num_bytes -= 1;
-        bit_offset += 8;
-    }
+    Core::System& system = pass.GetSystem();
+    system.Memory().WriteBlock(*system.Kernel().GetCurrentProcess(), addr,
+                               patch_data.data() + line.extra, line.value);
+    pass.MarkWritten(addr, line.value);
 }
 
 GatewayCheat::CheatLine::CheatLine(const std::string& line) {
@@ -202,6 +172,7 @@ GatewayCheat::CheatLine::CheatLine(const std::string& line) {
 GatewayCheat::GatewayCheat(std::string name_, std::vector<CheatLine> cheat_lines_,
                            std::string comments_)
     : name(std::move(name_)), cheat_lines(std::move(cheat_lines_)), comments(std::move(comments_)) {
+    Compile();
 }
 
 GatewayCheat::GatewayCheat(std::string name_, std::string code, std::string comments_)
@@ -216,14 +187,62 @@ GatewayCheat::GatewayCheat(std::string name_, std::string code, std::string comm
             temp_cheat_lines.emplace_back(code_lines[i]);
     }
     cheat_lines = std::move(temp_cheat_lines);
+    Compile();
 }
 
 GatewayCheat::~GatewayCheat() = default;
 
-void GatewayCheat::Execute(Core::System& system) const {
+void GatewayCheat::Compile() {
+    program.clear();
+    patch_data.clear();
+    program.reserve(cheat_lines.size());
+
+    for (std::size_t i = 0; i < cheat_lines.size(); ++i) {
+        const CheatLine& line = cheat_lines[i];
+        if (line.type == CheatType::Null)
+            continue;
+
+        Instruction instruction{line.type, line.address, line.value};
+        switch (line.type) {
+        case CheatType::GreaterThan16WithMask:
+        case CheatType::LessThan16WithMask:
+        case CheatType::EqualTo16WithMask:
+        case CheatType::NotEqualTo16WithMask:
+            // ZZZZYYYY - YYYY is compared to half[XXXXXXX] masked with (not ZZZZ)
+            instruction.value = static_cast<u16>(line.value);
+            instruction.extra = static_cast<u16>(~line.value >> 16);
+            break;
+        case CheatType::Patch: {
+            // The YYYYYYYY bytes follow in the next lines, 8 per line in the order the words
+            // would be written to memory. Data missing at the end of the cheat isn't patched.
+            const std::size_t num_lines =
+                std::min<std::size_t>((u64{line.value} + 7) / 8, cheat_lines.size() - i - 1);
+            instruction.value = std::min<u32>(line.value, static_cast<u32>(num_lines * 8));
+            instruction.extra = static_cast<u32>(patch_data.size());
+            for (std::size_t j = i + 1; j <= i + num_lines; ++j) {
+                const CheatLine& data_line = cheat_lines[j];
+                for (const u32 word : {data_line.valid ? data_line.first : 0,
+                                       data_line.valid ? data_line.value : 0}) {
+                    for (u32 shift = 0; shift < 32; shift += 8) {
+                        patch_data.push_back(static_cast<u8>(word >> shift));
+                    }
+                }
+            }
+            patch_data.resize(instruction.extra + instruction.value);
+            i += num_lines;
+            break;
+        }
+        default:
+            break;
+        }
+        program.push_back(instruction);
+    }
+}
+
+void GatewayCheat::Execute(CheatPass& pass) const {
     State state;
 
-    Memory::MemorySystem& memory = system.Memory();
+    Memory::MemorySystem& memory = pass.GetSystem().Memory();
     auto Read8 = [&memory](VAddr addr) { return memory.Read8(addr); };
     auto Read16 = [&memory](VAddr addr) { return memory.Read16(addr); };
     auto Read32 = [&memory](VAddr addr) { return memory.Read32(addr); };
@@ -231,9 +250,9 @@ void GatewayCheat::Execute(Core::System& system) const {
     auto Write16 = [&memory](VAddr addr, u16 value) { memory.Write16(addr, value); };
     auto Write32 = [&memory](VAddr addr, u32 value) { memory.Write32(addr, value); };
 
-    for (state.current_line_nr = 0; state.current_line_nr < cheat_lines.size();
+    for (state.current_line_nr = 0; state.current_line_nr < program.size();
          state.current_line_nr++) {
-        auto line = cheat_lines[state.current_line_nr];
+        const Instruction& line = program[state.current_line_nr];
         if (state.if_flag > 0) {
             switch (line.type) {
             case CheatType::GreaterThan32:
@@ -248,12 +267,6 @@ void GatewayCheat::Execute(Core::System& system) const {
                 // Increment the if_flag to handle the end if correctly
                 state.if_flag++;
                 break;
-            case CheatType::Patch:
-                // EXXXXXXX YYYYYYYY
-                // Copies YYYYYYYY bytes from (current code location + 8) to [XXXXXXXX + offset].
-                // We need to call this here to skip the additional patch lines
-                PatchOp(line, state, system, cheat_lines);
-                break;
             case CheatType::Terminator:
                 // D0000000 00000000 - ENDIF
                 TerminateOp(state);
@@ -273,15 +286,15 @@ void GatewayCheat::Execute(Core::System& system) const {
             break;
         case CheatType::Write32:
             // 0XXXXXXX YYYYYYYY - word[XXXXXXX+offset] = YYYYYYYY
-            WriteOp<u32>(line, state, Write32, system);
+            WriteOp<u32>(line, state, Write32, pass);
             break;
         case CheatType::Write16:
             // 1XXXXXXX 0000YYYY - half[XXXXXXX+offset] = YYYY
-            WriteOp<u16>(line, state, Write16, system);
+            WriteOp<u16>(line, state, Write16, pass);
             break;
         case CheatType::Write8:
             // 2XXXXXXX 000000YY - byte[XXXXXXX+offset] = YY
-            WriteOp<u8>(line, state, Write8, system);
+            WriteOp<u8>(line, state, Write8, pass);
             break;
         case CheatType::GreaterThan32:
             // 3XXXXXXX YYYYYYYY - Execute next block IF YYYYYYYY > word[XXXXXXX]   ;unsigned
@@ -304,30 +317,30 @@ void GatewayCheat::Execute(Core::System& system) const {
         case CheatType::GreaterThan16WithMask:
             // 7XXXXXXX ZZZZYYYY - Execute next block IF YYYY > ((not ZZZZ) AND half[XXXXXXX])
             CompOp<u16>(line, state, Read16, [&line](u16 val) -> bool {
-                return static_cast<u16>(line.value) > (static_cast<u16>(~line.value >> 16) & val);
+                return line.value > (line.extra & val);
             });
             break;
         case CheatType::LessThan16WithMask:
             // 8XXXXXXX ZZZZYYYY - Execute next block IF YYYY < ((not ZZZZ) AND half[XXXXXXX])
             CompOp<u16>(line, state, Read16, [&line](u16 val) -> bool {
-                return static_cast<u16>(line.value) < (static_cast<u16>(~line.value >> 16) & val);
+                return line.value < (line.extra & val);
             });
             break;
         case CheatType::EqualTo16WithMask:
             // 9XXXXXXX ZZZZYYYY - Execute next block IF YYYY = ((not ZZZZ) AND half[XXXXXXX])
             CompOp<u16>(line, state, Read16, [&line](u16 val) -> bool {
-                return static_cast<u16>(line.value) == (static_cast<u16>(~line.value >> 16) & val);
+                return line.value == (line.extra & val);
             });
             break;
         case CheatType::NotEqualTo16WithMask:
             // AXXXXXXX ZZZZYYYY - Execute next block IF YYYY <> ((not ZZZZ) AND half[XXXXXXX])
             CompOp<u16>(line, state, Read16, [&line](u16 val) -> bool {
-                return static_cast<u16>(line.value) != (static_cast<u16>(~line.value >> 16) & val);
+                return line.value != (line.extra & val);
             });
             break;
         case CheatType::LoadOffset:
             // BXXXXXXX 00000000 - offset = word[XXXXXXX+offset]
-            LoadOffsetOp(system.Memory(), line, state);
+            LoadOffsetOp(memory, line, state);
             break;
         case CheatType::Loop: {
             // C0000000 YYYYYYYY - LOOP next block YYYYYYYY times
@@ -367,17 +380,17 @@ void GatewayCheat::Execute(Core::System& system) const {
         }
         case CheatType::IncrementiveWrite32: {
             // D6000000 XXXXXXXX – (32bit) [XXXXXXXX+offset] = reg ; offset += 4
-            IncrementiveWriteOp<u32>(line, state, Write32, system);
+            IncrementiveWriteOp<u32>(line, state, Write32, pass);
             break;
         }
         case CheatType::IncrementiveWrite16: {
             // D7000000 XXXXXXXX – (16bit) [XXXXXXXX+offset] = reg & 0xffff ; offset += 2
-            IncrementiveWriteOp<u16>(line, state, Write16, system);
+            IncrementiveWriteOp<u16>(line, state, Write16, pass);
             break;
         }
         case CheatType::IncrementiveWrite8: {
             // D8000000 XXXXXXXX – (16bit) [XXXXXXXX+offset] = reg & 0xff ; offset++
-            IncrementiveWriteOp<u8>(line, state, Write8, system);
+            IncrementiveWriteOp<u8>(line, state, Write8, pass);
             break;
         }
         case CheatType::Load32: {
@@ -402,13 +415,13 @@ void GatewayCheat::Execute(Core::System& system) const {
         }
         case CheatType::Joker: {
             // DD000000 XXXXXXXX – if KEYPAD has value XXXXXXXX execute next block
-            JokerOp(line, state, system);
+            JokerOp(line, state, pass);
             break;
         }
         case CheatType::Patch: {
             // EXXXXXXX YYYYYYYY
             // Copies YYYYYYYY bytes from (current code location + 8) to [XXXXXXXX + offset].
-            PatchOp(line, state, system, cheat_lines);
+            PatchOp(line, state, pass, patch_data);
             break;
         }
         }
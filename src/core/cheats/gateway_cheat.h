@@ -6,6 +6,8 @@
 
 #include <atomic>
 #include <memory>
+#include <string>
+#include <vector>
 #include "core/cheats/cheat_base.h"
 
 namespace Cheats {
@@ -53,11 +55,20 @@ public:
         bool valid = true;
     };
 
+    /// A cheat line with everything decoded that doesn't depend on the state of the execution
+    struct Instruction {
+        CheatType type;
+        u32 address;
+        u32 value;
+        /// Mask of the 16 bit comparisons, or the start of the data of a patch in patch_data
+        u32 extra = 0;
+    };
+
     GatewayCheat(std::string name, std::vector<CheatLine> cheat_lines, std::string comments);
     GatewayCheat(std::string name, std::string code, std::string comments);
     ~GatewayCheat();
 
-    void Execute(Core::System& system) const override;
+    void Execute(CheatPass& pass) const override;
 
     bool IsEnabled() const override;
     void SetEnabled(bool enabled) override;
@@ -78,9 +89,16 @@ public:
     static std::vector<std::unique_ptr<CheatBase>> LoadFile(const std::string& filepath);
 
 private:
+    /// Translates the cheat lines into the program that Execute runs
+    void Compile();
+
     std::atomic<bool> enabled = false;
     const std::string name;
     std::vector<CheatLine> cheat_lines;
     const std::string comments;
+
+    std::vector<Instruction> program;
+    /// Bytes copied by the patch instructions, which don't need their data lines in the program
+    std::vector<u8> patch_data;
 };
 } // namespace Cheats
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include "audio_core/dsp_interface.h"
@@ -17,12 +18,16 @@
 #include "core/cheats/cheats.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/cpu_threads.h"
 #include "core/dumping/backend.h"
 #ifdef ENABLE_FFMPEG_VIDEO_DUMPER
 #include "core/dumping/ffmpeg_backend.h"
 #endif
 #include "core/custom_tex_cache.h"
 #include "core/gdbstub/gdbstub.h"
+#include "core/guest_profiler.h"
+#include "core/guest_symbols.h"
+#include "core/hle/cost_accounting.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
@@ -31,8 +36,13 @@
 #include "core/hle/service/service.h"
 #include "core/hle/service/sm/sm.h"
 #include "core/hw/hw.h"
+#include "core/init_tasks.h"
 #include "core/loader/loader.h"
+#include "core/memory_snapshots.h"
 #include "core/movie.h"
+#include "core/perf_tuner.h"
+#include "core/replay_verifier.h"
+#include "core/rewind.h"
 #include "core/rpc/rpc_server.h"
 #include "core/settings.h"
 #include "network/network.h"
@@ -91,6 +101,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             current_core_to_execute->GetTimer()->Idle();
             PrepareReschedule();
         } else {
+            Metrics::ScopedTimer timer{Metrics::Time::ARM};
             if (tight_loop) {
                 current_core_to_execute->Run();
             } else {
@@ -99,31 +110,55 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         }
     } else {
         // Now all cores are at the same global time. So we will run them one after the other
-        // with a max slice that is the minimum of all max slices of all cores
-        // TODO: Make special check for idle since we can easily revert the time of idle cores
+        // with a max slice that ends at the next event of any core. A core that runs alone
+        // doesn't have to be interleaved with the others and gets a longer slice, and while all
+        // cores are idle nothing can happen before the next event, so time skips straight to it.
+        const auto num_running =
+            std::count_if(cpu_cores.begin(), cpu_cores.end(), [this](const auto& cpu_core) {
+                return kernel->GetThreadManager(cpu_core->GetID()).GetCurrentThread() != nullptr;
+            });
         s64 max_slice = Timing::MAX_SLICE_LENGTH;
+        if (num_running == 0) {
+            max_slice = Timing::MAX_IDLE_SLICE_LENGTH;
+        } else if (num_running == 1) {
+            max_slice = Timing::MAX_SINGLE_CORE_SLICE_LENGTH;
+        }
+        bool has_event = false;
         for (const auto& cpu_core : cpu_cores) {
-            max_slice = std::min(max_slice, cpu_core->GetTimer()->GetMaxSliceLength());
+            // Pick up the events other threads scheduled, so they aren't skipped
+            cpu_core->GetTimer()->MoveEvents();
+            if (const auto ticks = cpu_core->GetTimer()->GetTicksToNextEvent()) {
+                max_slice = std::min(max_slice, *ticks);
+                has_event = true;
+            }
+        }
+        if (!has_event) {
+            max_slice = std::min<s64>(max_slice, Timing::MAX_SLICE_LENGTH);
         }
         for (auto& cpu_core : cpu_cores) {
             cpu_core->GetTimer()->Advance(max_slice);
         }
-        for (auto& cpu_core : cpu_cores) {
-            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
-                      cpu_core->GetTimer()->GetDowncount());
-            running_core = cpu_core.get();
-            kernel->SetRunningCPU(cpu_core);
-            // If we don't have a currently active thread then don't execute instructions,
-            // instead advance to the next event and try to yield to the next thread
-            if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
-                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
-                cpu_core->GetTimer()->Idle();
-                PrepareReschedule();
-            } else {
-                if (tight_loop) {
-                    cpu_core->Run();
+        // The threads only run the JIT, stepping and the debugger stay on the emulation thread
+        if (cpu_threads == nullptr || !tight_loop || GDBStub::IsServerEnabled() ||
+            !RunSliceOnThreads()) {
+            for (auto& cpu_core : cpu_cores) {
+                LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                          cpu_core->GetTimer()->GetDowncount());
+                running_core = cpu_core.get();
+                kernel->SetRunningCPU(cpu_core);
+                // If we don't have a currently active thread then don't execute instructions,
+                // instead advance to the next event and try to yield to the next thread
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer()->Idle();
+                    PrepareReschedule();
                 } else {
-                    cpu_core->Step();
+                    Metrics::ScopedTimer timer{Metrics::Time::ARM};
+                    if (tight_loop) {
+                        cpu_core->Run();
+                    } else {
+                        cpu_core->Step();
+                    }
                 }
             }
         }
@@ -136,6 +171,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
 
     HW::Update();
     Reschedule();
+    rewind->Update();
 
     if (reset_requested.exchange(false)) {
         Reset();
@@ -174,6 +210,12 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
     }
 
     ASSERT(system_mode.first);
+    if (Settings::values.use_auto_tuning) {
+        // The tuned settings have to be in place before the renderer and the DSP are created
+        u64 tuned_title_id{0};
+        app_loader->ReadProgramId(tuned_title_id);
+        perf_tuner = std::make_unique<PerfTuner>(tuned_title_id);
+    }
     auto n3ds_mode = app_loader->LoadKernelN3dsMode();
     ASSERT(n3ds_mode.first);
     ResultStatus init_result{Init(emu_window, *system_mode.first, *n3ds_mode.first)};
@@ -208,6 +250,9 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
                   static_cast<u32>(load_result));
     }
     perf_stats = std::make_unique<PerfStats>(title_id);
+    if (!Settings::values.metrics_file.empty() || Settings::values.metrics_port != 0) {
+        metrics_exporter = std::make_unique<Metrics::Exporter>(title_id);
+    }
     custom_tex_cache = std::make_unique<Core::CustomTexCache>();
     if (Settings::values.custom_textures) {
         FileUtil::CreateFullPath(fmt::format("{}textures/{:016X}/",
@@ -227,6 +272,75 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
     return status;
 }
 
+System::ResultStatus System::InitWithoutApplication(Frontend::EmuWindow& emu_window) {
+    // Without an application there is no exheader to pick the memory layout from, use the default
+    const ResultStatus init_result = Init(emu_window, 0, 0);
+    if (init_result != ResultStatus::Success) {
+        LOG_CRITICAL(Core, "Failed to initialize system (Error {})!",
+                     static_cast<u32>(init_result));
+        System::Shutdown();
+        return init_result;
+    }
+
+    perf_stats = std::make_unique<PerfStats>(0);
+    custom_tex_cache = std::make_unique<Core::CustomTexCache>();
+    status = ResultStatus::Success;
+    m_emu_window = &emu_window;
+
+    GetAndResetPerfStats();
+    perf_stats->BeginSystemFrame();
+    return status;
+}
+
+bool System::RunSliceOnThreads() {
+    std::vector<std::shared_ptr<ARM_Interface>> active_cores;
+    std::shared_ptr<Kernel::Process> process;
+    for (const auto& cpu_core : cpu_cores) {
+        kernel->SetRunningCPU(cpu_core);
+        if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr)
+            continue;
+        // The slow memory paths of all cores go through the current page table
+        if (process != nullptr && kernel->GetCurrentProcess() != process)
+            return false;
+        process = kernel->GetCurrentProcess();
+        active_cores.push_back(cpu_core);
+    }
+    if (active_cores.size() < 2)
+        return false;
+
+    for (const auto& cpu_core : cpu_cores) {
+        if (std::find(active_cores.begin(), active_cores.end(), cpu_core) != active_cores.end())
+            continue;
+        LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+        running_core = cpu_core.get();
+        kernel->SetRunningCPU(cpu_core);
+        cpu_core->GetTimer()->Idle();
+        PrepareReschedule();
+    }
+
+    // A host call may switch the process of its core, e.g. when the process exits. All cores are
+    // then stopped, so the processes are checked again before the next slice. PrepareReschedule
+    // only sets a flag for the cores running on other threads, which they check themselves.
+    bool process_switched = false;
+    cpu_threads->RunSlice(
+        active_cores,
+        [this](const std::shared_ptr<ARM_Interface>& cpu_core) {
+            running_core = cpu_core.get();
+            kernel->SetRunningCPU(cpu_core);
+        },
+        [&] {
+            if (process_switched || kernel->GetCurrentProcess() == process)
+                return;
+            LOG_DEBUG(Core_ARM11, "Process switched during a parallel slice");
+            process_switched = true;
+            for (const auto& cpu_core : active_cores) {
+                cpu_core->PrepareReschedule();
+            }
+            reschedule_pending = true;
+        });
+    return true;
+}
+
 void System::PrepareReschedule() {
     running_core->PrepareReschedule();
     reschedule_pending = true;
@@ -256,61 +370,106 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window, u32 system_mo
         num_cores = 4;
     }
 
-    memory = std::make_unique<Memory::MemorySystem>();
+    // Everything registering core timing events or kernel objects runs on this thread, only the
+    // setup doing host I/O is moved to other threads
+    InitTasks init_tasks;
+
+    // The archives only create and check host directories
+    init_tasks.RunAsync("archives", [this] {
+        archive_manager = std::make_unique<Service::FS::ArchiveManager>(*this);
+    });
+
+    init_tasks.Run("kernel", [&] {
+        memory = std::make_unique<Memory::MemorySystem>();
 
-    timing = std::make_unique<Timing>(num_cores);
+        timing = std::make_unique<Timing>(num_cores);
 
-    kernel = std::make_unique<Kernel::KernelSystem>(
-        *memory, *timing, [this] { PrepareReschedule(); }, system_mode, num_cores, n3ds_mode);
+        kernel = std::make_unique<Kernel::KernelSystem>(
+            *memory, *timing, [this] { PrepareReschedule(); }, system_mode, num_cores, n3ds_mode);
+    });
 
-    if (Settings::values.use_cpu_jit) {
+    init_tasks.Run("CPU cores", [&] {
+        if (Settings::values.use_cpu_jit) {
 #ifdef ARCHITECTURE_x86_64
-        for (std::size_t i = 0; i < num_cores; ++i) {
-            cpu_cores.push_back(
-                std::make_shared<ARM_Dynarmic>(this, *memory, USER32MODE, i, timing->GetTimer(i)));
-        }
+            std::shared_ptr<Dynarmic::ExclusiveMonitor> exclusive_monitor;
+#ifdef CITRA_DYNARMIC_GLOBAL_MONITOR
+            exclusive_monitor = std::make_shared<Dynarmic::ExclusiveMonitor>(num_cores);
+#endif
+            for (std::size_t i = 0; i < num_cores; ++i) {
+                cpu_cores.push_back(std::make_shared<ARM_Dynarmic>(
+                    this, *memory, USER32MODE, i, timing->GetTimer(i), exclusive_monitor));
+            }
 #else
-        for (std::size_t i = 0; i < num_cores; ++i) {
-            cpu_cores.push_back(
-                std::make_shared<ARM_DynCom>(this, *memory, USER32MODE, i, timing->GetTimer(i)));
+            for (std::size_t i = 0; i < num_cores; ++i) {
+                cpu_cores.push_back(std::make_shared<ARM_DynCom>(this, *memory, USER32MODE, i,
+                                                                 timing->GetTimer(i)));
+            }
+            LOG_WARNING(Core, "CPU JIT requested, but Dynarmic not available");
+#endif
+        } else {
+            for (std::size_t i = 0; i < num_cores; ++i) {
+                cpu_cores.push_back(std::make_shared<ARM_DynCom>(this, *memory, USER32MODE, i,
+                                                                 timing->GetTimer(i)));
+            }
         }
-        LOG_WARNING(Core, "CPU JIT requested, but Dynarmic not available");
+        running_core = cpu_cores[0].get();
+
+#ifdef ARCHITECTURE_x86_64
+        if (Settings::values.use_cpu_jit && Settings::values.use_multicore_cpu) {
+#ifdef CITRA_DYNARMIC_GLOBAL_MONITOR
+            cpu_threads = std::make_unique<CPUThreads>(num_cores);
+#else
+            // Guest spinlocks would break if the cores ran on parallel threads without the monitor
+            LOG_WARNING(Core, "Multicore CPU emulation needs a dynarmic with a global exclusive "
+                              "monitor, running all cores on the emulation thread");
 #endif
-    } else {
-        for (std::size_t i = 0; i < num_cores; ++i) {
-            cpu_cores.push_back(
-                std::make_shared<ARM_DynCom>(this, *memory, USER32MODE, i, timing->GetTimer(i)));
         }
-    }
-    running_core = cpu_cores[0].get();
+#endif
 
-    kernel->SetCPUs(cpu_cores);
-    kernel->SetRunningCPU(cpu_cores[0]);
+        kernel->SetCPUs(cpu_cores);
+        kernel->SetRunningCPU(cpu_cores[0]);
+    });
 
-    if (Settings::values.enable_dsp_lle) {
-        dsp_core = std::make_unique<AudioCore::DspLle>(*memory,
-                                                       Settings::values.enable_dsp_lle_multithread);
-    } else {
-        dsp_core = std::make_unique<AudioCore::DspHle>(*memory);
-    }
+    init_tasks.Run("DSP", [this] {
+        if (Settings::values.enable_dsp_lle) {
+            dsp_core = std::make_unique<AudioCore::DspLle>(
+                *memory, Settings::values.enable_dsp_lle_multithread);
+        } else {
+            dsp_core = std::make_unique<AudioCore::DspHle>(
+                *memory, Settings::values.enable_dsp_hle_multithread);
+        }
 
-    memory->SetDSP(*dsp_core);
+        memory->SetDSP(*dsp_core);
+        memory_snapshots =
+            std::make_unique<Core::MemorySnapshots>(*memory, Settings::values.is_new_3ds);
+        rewind = std::make_unique<Core::Rewind>(*memory_snapshots, Movie::GetInstance());
+    });
 
-    dsp_core->SetSink(Settings::values.sink_id, Settings::values.audio_device_id);
-    dsp_core->EnableStretching(Settings::values.enable_audio_stretching);
+    // Opening the audio device can take a while, nothing else uses the sink until emulation starts
+    init_tasks.RunAsync("audio sink", [this] {
+        dsp_core->SetSink(Settings::values.sink_id, Settings::values.audio_device_id);
+        dsp_core->EnableStretching(Settings::values.enable_audio_stretching);
+    });
 
     telemetry_session = std::make_unique<Core::TelemetrySession>();
 
     rpc_server = std::make_unique<RPC::RPCServer>();
-
-    service_manager = std::make_shared<Service::SM::ServiceManager>(*this);
-    archive_manager = std::make_unique<Service::FS::ArchiveManager>(*this);
-
-    HW::Init(*memory);
-    Service::Init(*this);
-    GDBStub::DeferStart();
-
-    VideoCore::ResultStatus result = VideoCore::Init(emu_window, *memory);
+    guest_profiler = std::make_unique<Core::GuestProfiler>(*this);
+
+    init_tasks.Run(
+        "services",
+        [this] {
+            service_manager = std::make_shared<Service::SM::ServiceManager>(*this);
+
+            HW::Init(*memory);
+            Service::Init(*this);
+            GDBStub::DeferStart();
+        },
+        {"archives"});
+
+    VideoCore::ResultStatus result;
+    init_tasks.Run("video core", [&] { result = VideoCore::Init(emu_window, *memory); });
+    init_tasks.WaitAll();
     if (result != VideoCore::ResultStatus::Success) {
         switch (result) {
         case VideoCore::ResultStatus::ErrorGenericDrivers:
@@ -379,6 +538,10 @@ const Memory::MemorySystem& System::Memory() const {
     return *memory;
 }
 
+RPC::RPCServer& System::RPCServer() {
+    return *rpc_server;
+}
+
 Cheats::CheatEngine& System::CheatEngine() {
     return *cheat_engine;
 }
@@ -395,6 +558,18 @@ const VideoDumper::Backend& System::VideoDumper() const {
     return *video_dumper;
 }
 
+Core::MemorySnapshots& System::MemorySnapshots() {
+    return *memory_snapshots;
+}
+
+Core::Rewind& System::Rewind() {
+    return *rewind;
+}
+
+Core::GuestProfiler& System::GuestProfiler() {
+    return *guest_profiler;
+}
+
 Core::CustomTexCache& System::CustomTexCache() {
     return *custom_tex_cache;
 }
@@ -424,24 +599,44 @@ void System::Shutdown() {
                                 perf_results.game_fps);
     telemetry_session->AddField(Telemetry::FieldType::Performance, "Shutdown_Frametime",
                                 perf_results.frametime * 1000.0);
+    const auto audio_stats = dsp_core->GetBufferStats();
+    telemetry_session->AddField(Telemetry::FieldType::Performance, "Shutdown_AudioUnderruns",
+                                audio_stats.underruns);
+    telemetry_session->AddField(Telemetry::FieldType::Performance, "Shutdown_AudioOverruns",
+                                audio_stats.overruns);
     telemetry_session->AddField(Telemetry::FieldType::Performance, "Mean_Frametime_MS",
                                 perf_stats->GetMeanFrametime());
 
+    LOG_INFO(Core, "HLE hot spots:\n{}", HLE::CostAccounting::FormatReport(10));
+    HLE::CostAccounting::Clear();
+
     // Shutdown emulation session
     GDBStub::Shutdown();
     VideoCore::Shutdown();
     HW::Shutdown();
     telemetry_session.reset();
+    if (perf_tuner && perf_stats) {
+        perf_tuner->RecordSession(perf_stats->GetFrametimes());
+    }
     perf_stats.reset();
+    metrics_exporter.reset();
+    replay_verifier.reset();
     rpc_server.reset();
+    guest_profiler.reset();
+    GuestSymbols::Clear();
     cheat_engine.reset();
     archive_manager.reset();
     service_manager.reset();
+    rewind.reset();
+    memory_snapshots.reset();
     dsp_core.reset();
+    cpu_threads.reset();
     cpu_cores.clear();
     kernel.reset();
     timing.reset();
     app_loader.reset();
+    // Restores the user's settings once nothing uses the tuned ones anymore
+    perf_tuner.reset();
 
     if (video_dumper->IsDumping()) {
         video_dumper->StopDumping();
@@ -11,8 +11,10 @@
 #include "core/frontend/applets/mii_selector.h"
 #include "core/frontend/applets/swkbd.h"
 #include "core/frontend/image_interface.h"
+#include "core/invalidation_batch.h"
 #include "core/loader/loader.h"
 #include "core/memory.h"
+#include "core/perf_metrics.h"
 #include "core/perf_stats.h"
 #include "core/telemetry_session.h"
 
@@ -59,6 +61,12 @@ class RendererBase;
 
 namespace Core {
 
+class CPUThreads;
+class GuestProfiler;
+class MemorySnapshots;
+class PerfTuner;
+class ReplayVerifier;
+class Rewind;
 class Timing;
 
 class System {
@@ -134,6 +142,14 @@ public:
      */
     ResultStatus Load(Frontend::EmuWindow& emu_window, const std::string& filepath);
 
+    /**
+     * Initializes the emulated system without loading an application, for tools that drive the
+     * GPU directly like the CiTrace player. No guest code runs, so RunLoop must not be called.
+     * @param emu_window Reference to the host-system window used for video output.
+     * @returns ResultStatus code, indicating if the operation succeeded.
+     */
+    ResultStatus InitWithoutApplication(Frontend::EmuWindow& emu_window);
+
     /**
      * Indicates if the emulated system is powered on (all subsystems initialized and able to run an
      * application).
@@ -182,7 +198,15 @@ public:
         return cpu_cores.size();
     }
 
+    /**
+     * Invalidates the JIT code of the range on every core, deferred while a batch is active. Cores
+     * running on other host threads apply it themselves after their next host call.
+     */
     void InvalidateCacheRange(u32 start_address, std::size_t length) {
+        if (InvalidationBatch* batch = InvalidationBatch::GetActive()) {
+            batch->Add(start_address, length);
+            return;
+        }
         for (const auto& cpu : cpu_cores) {
             cpu->InvalidateCacheRange(start_address, length);
         }
@@ -234,6 +258,18 @@ public:
     /// Gets a const reference to the memory system
     const Memory::MemorySystem& Memory() const;
 
+    /// Gets a reference to the memory snapshots, used for rewinding and migrating sessions
+    Core::MemorySnapshots& MemorySnapshots();
+
+    /// Gets a reference to the rewind buffer
+    Core::Rewind& Rewind();
+
+    /// Gets a reference to the RPC server
+    RPC::RPCServer& RPCServer();
+
+    /// Gets a reference to the sampling profiler of the guest code
+    Core::GuestProfiler& GuestProfiler();
+
     /// Gets a reference to the cheat engine
     Cheats::CheatEngine& CheatEngine();
 
@@ -257,6 +293,10 @@ public:
 
     std::unique_ptr<PerfStats> perf_stats;
     FrameLimiter frame_limiter;
+    /// Exports the per-frame metrics, nullptr when no metrics output is configured
+    std::unique_ptr<Metrics::Exporter> metrics_exporter;
+    /// Hashes the state while replaying a movie, set by the frontend and nullptr otherwise
+    std::unique_ptr<ReplayVerifier> replay_verifier;
 
     void SetStatus(ResultStatus new_status, const char* details = nullptr) {
         status = new_status;
@@ -308,6 +348,13 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /**
+     * Run the current slice of all cores in parallel on the CPU threads
+     * @returns false if the cores can't run in parallel right now and have to be run one after
+     *          the other instead
+     */
+    bool RunSliceOnThreads();
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
@@ -315,6 +362,9 @@ private:
     std::vector<std::shared_ptr<ARM_Interface>> cpu_cores;
     ARM_Interface* running_core = nullptr;
 
+    /// Host threads running the cores in parallel, null if multicore CPU emulation is disabled
+    std::unique_ptr<CPUThreads> cpu_threads;
+
     /// DSP core
     std::unique_ptr<AudioCore::DspInterface> dsp_core;
 
@@ -331,6 +381,12 @@ private:
     std::shared_ptr<Frontend::MiiSelector> registered_mii_selector;
     std::shared_ptr<Frontend::SoftwareKeyboard> registered_swkbd;
 
+    /// Memory snapshots
+    std::unique_ptr<Core::MemorySnapshots> memory_snapshots;
+
+    /// Rewind buffer
+    std::unique_ptr<Core::Rewind> rewind;
+
     /// Cheats manager
     std::unique_ptr<Cheats::CheatEngine> cheat_engine;
 
@@ -346,6 +402,11 @@ private:
     /// RPC Server for scripting support
     std::unique_ptr<RPC::RPCServer> rpc_server;
 
+    std::unique_ptr<Core::GuestProfiler> guest_profiler;
+
+    /// Chooses the performance settings while auto tuning is enabled, nullptr otherwise
+    std::unique_ptr<PerfTuner> perf_tuner;
+
     std::unique_ptr<Service::FS::ArchiveManager> archive_manager;
 
     std::unique_ptr<Memory::MemorySystem> memory;
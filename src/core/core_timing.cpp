@@ -7,6 +7,7 @@
 #include <tuple>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/tracing.h"
 #include "core/core_timing.h"
 
 namespace Core {
@@ -28,7 +29,8 @@ Timing::Timing(std::size_t num_cores) {
     current_timer = timers[0];
 }
 
-TimingEventType* Timing::RegisterEvent(const std::string& name, TimedCallback callback) {
+TimingEventType* Timing::RegisterEvent(const std::string& name, TimedCallback callback,
+                                       s64 slack) {
     // check for existing type with same name.
     // we want event type names to remain unique so that we can use them for serialization.
     ASSERT_MSG(event_types.find(name) == event_types.end(),
@@ -36,7 +38,8 @@ TimingEventType* Timing::RegisterEvent(const std::string& name, TimedCallback ca
                "during Init to avoid breaking save states.",
                name);
 
-    auto info = event_types.emplace(name, TimingEventType{callback, nullptr});
+    auto info = event_types.emplace(
+        name, TimingEventType{callback, nullptr, Common::Tracing::Intern(name), slack});
     TimingEventType* event_type = &info.first->second;
     event_type->name = &info.first->first;
     return event_type;
@@ -57,44 +60,37 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
     if (current_timer == timer) {
         // If this event needs to be scheduled before the next advance(), force one early
         if (!timer->is_timer_sane)
-            timer->ForceExceptionCheck(cycles_into_future);
+            timer->ForceExceptionCheck(cycles_into_future + event_type->slack);
 
-        timer->event_queue.emplace_back(
-            Event{timeout, timer->event_fifo_id++, userdata, event_type});
-        std::push_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+        // A removal posted earlier must not catch this event
+        timer->MoveEvents();
+        timer->PushEvent(Event{timeout, timer->event_fifo_id++, userdata, event_type});
     } else {
-        timer->ts_queue.Push(Event{static_cast<s64>(timer->GetTicks() + cycles_into_future), 0,
-                                   userdata, event_type});
+        timer->Post({Event{timeout, 0, userdata, event_type}, Timer::InboxEntry::Kind::Schedule});
     }
 }
 
 void Timing::UnscheduleEvent(const TimingEventType* event_type, u64 userdata) {
-    for (auto timer : timers) {
-        auto itr = std::remove_if(
-            timer->event_queue.begin(), timer->event_queue.end(),
-            [&](const Event& e) { return e.type == event_type && e.userdata == userdata; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+    for (const auto& timer : timers) {
+        if (timer == current_timer) {
+            timer->MoveEvents();
+            timer->RemoveEvents(
+                [&](const Event& e) { return e.type == event_type && e.userdata == userdata; });
+        } else {
+            timer->Post({Event{0, 0, userdata, event_type}, Timer::InboxEntry::Kind::Unschedule});
         }
     }
-    // TODO:remove events from ts_queue
 }
 
 void Timing::RemoveEvent(const TimingEventType* event_type) {
-    for (auto timer : timers) {
-        auto itr = std::remove_if(timer->event_queue.begin(), timer->event_queue.end(),
-                                  [&](const Event& e) { return e.type == event_type; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+    for (const auto& timer : timers) {
+        if (timer == current_timer) {
+            timer->MoveEvents();
+            timer->RemoveEvents([&](const Event& e) { return e.type == event_type; });
+        } else {
+            timer->Post({Event{0, 0, 0, event_type}, Timer::InboxEntry::Kind::Remove});
         }
     }
-    // TODO:remove events from ts_queue
 }
 
 void Timing::SetCurrentTimer(std::size_t core_id) {
@@ -146,20 +142,172 @@ void Timing::Timer::ForceExceptionCheck(s64 cycles) {
 }
 
 void Timing::Timer::MoveEvents() {
-    for (Event ev; ts_queue.Pop(ev);) {
-        ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
+    for (InboxEntry entry; inbox.Pop(entry);) {
+        Apply(entry);
+    }
+
+    // The overflow was posted after everything in the inbox, so it is only taken once no post to
+    // the inbox is in flight
+    if (!inbox_overflowed.load(std::memory_order_acquire) || inbox.Size() != 0)
+        return;
+    std::vector<InboxEntry> entries;
+    {
+        std::lock_guard lock{inbox_overflow_mutex};
+        entries.swap(inbox_overflow);
+        inbox_overflowed.store(false, std::memory_order_release);
+    }
+    for (InboxEntry& entry : entries) {
+        Apply(entry);
+    }
+}
+
+void Timing::Timer::Post(InboxEntry&& entry) {
+    // Entries posted after one that overflowed follow it into the overflow to stay in order
+    if (!inbox_overflowed.load(std::memory_order_acquire) && inbox.TryPush(std::move(entry)))
+        return;
+    std::lock_guard lock{inbox_overflow_mutex};
+    inbox_overflow.push_back(std::move(entry));
+    inbox_overflowed.store(true, std::memory_order_release);
+}
+
+void Timing::Timer::Apply(InboxEntry& entry) {
+    const Event& event = entry.event;
+    switch (entry.kind) {
+    case InboxEntry::Kind::Schedule:
+        entry.event.fifo_order = event_fifo_id++;
+        PushEvent(std::move(entry.event));
+        break;
+    case InboxEntry::Kind::Unschedule:
+        RemoveEvents([&](const Event& e) {
+            return e.type == event.type && e.userdata == event.userdata;
+        });
+        break;
+    case InboxEntry::Kind::Remove:
+        RemoveEvents([&](const Event& e) { return e.type == event.type; });
+        break;
+    }
+}
+
+std::size_t Timing::Timer::GetWheelSlot(s64 time) const {
+    // Late events go into the first slot, which holds the earliest events anyway
+    return static_cast<std::size_t>(std::max(time, wheel_base) >> WHEEL_SLOT_BITS) % WHEEL_SIZE;
+}
+
+std::size_t Timing::Timer::FindFirstWheelSlot() const {
+    const std::size_t first_slot = GetWheelSlot(wheel_base);
+    for (std::size_t i = 0; i < WHEEL_SIZE; ++i) {
+        const std::size_t slot = (first_slot + i) % WHEEL_SIZE;
+        if (!wheel[slot].empty())
+            return slot;
+    }
+    UNREACHABLE();
+    return first_slot;
+}
+
+void Timing::Timer::PushEvent(Event&& event) {
+    if (event.time < wheel_base + WHEEL_SPAN) {
+        wheel[GetWheelSlot(event.time)].push_back(std::move(event));
+        ++wheel_events;
+    } else {
+        event_queue.push_back(std::move(event));
         std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
     }
 }
 
-s64 Timing::Timer::GetMaxSliceLength() const {
-    auto next_event = std::find_if(event_queue.begin(), event_queue.end(),
-                                   [&](const Event& e) { return e.time - executed_ticks > 0; });
-    if (next_event != event_queue.end()) {
-        return next_event->time - executed_ticks;
+template <typename Pred>
+void Timing::Timer::RemoveEvents(Pred pred) {
+    if (wheel_events != 0) {
+        for (auto& slot : wheel) {
+            auto itr = std::remove_if(slot.begin(), slot.end(), pred);
+            wheel_events -= static_cast<std::size_t>(std::distance(itr, slot.end()));
+            slot.erase(itr, slot.end());
+        }
+    }
+
+    auto itr = std::remove_if(event_queue.begin(), event_queue.end(), pred);
+    // Removing random items breaks the invariant so we have to re-establish it.
+    if (itr != event_queue.end()) {
+        event_queue.erase(itr, event_queue.end());
+        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    }
+}
+
+const Timing::Event* Timing::Timer::GetEarliestEvent() const {
+    // Events in the event queue are all after the wheel span
+    if (wheel_events != 0) {
+        const auto& slot = wheel[FindFirstWheelSlot()];
+        return &*std::min_element(slot.begin(), slot.end());
+    }
+    return event_queue.empty() ? nullptr : &event_queue.front();
+}
+
+Timing::Event Timing::Timer::PopEarliestEvent() {
+    if (wheel_events != 0) {
+        auto& slot = wheel[FindFirstWheelSlot()];
+        const auto itr = std::min_element(slot.begin(), slot.end());
+        Event event = std::move(*itr);
+        *itr = std::move(slot.back());
+        slot.pop_back();
+        --wheel_events;
+        return event;
+    }
+
+    Event event = std::move(event_queue.front());
+    std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    event_queue.pop_back();
+    return event;
+}
+
+void Timing::Timer::MoveWheel() {
+    // Everything before executed_ticks has been dispatched, so the slots before it are empty
+    const s64 new_base = executed_ticks & ~((s64{1} << WHEEL_SLOT_BITS) - 1);
+    if (new_base == wheel_base)
+        return;
+
+    wheel_base = new_base;
+    while (!event_queue.empty() && event_queue.front().time < wheel_base + WHEEL_SPAN) {
+        Event event = std::move(event_queue.front());
+        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+        event_queue.pop_back();
+        wheel[GetWheelSlot(event.time)].push_back(std::move(event));
+        ++wheel_events;
     }
-    return MAX_SLICE_LENGTH;
+}
+
+std::optional<s64> Timing::Timer::GetNextWakeup(s64 after) const {
+    std::optional<s64> wakeup;
+    const auto add_events = [&](const std::vector<Event>& events) {
+        for (const Event& e : events) {
+            if (e.time > after && (!wakeup || e.time + e.type->slack < *wakeup))
+                wakeup = e.time + e.type->slack;
+        }
+    };
+
+    if (wheel_events != 0) {
+        // The slots after the wakeup found so far only hold later events. Late events are in the
+        // slot of wheel_base.
+        const std::size_t base_slot = GetWheelSlot(wheel_base);
+        for (std::size_t i = 0; i < WHEEL_SIZE; ++i) {
+            if (wakeup && wheel_base + static_cast<s64>(i << WHEEL_SLOT_BITS) > *wakeup)
+                break;
+            add_events(wheel[(base_slot + i) % WHEEL_SIZE]);
+        }
+    }
+    // The event queue is only ordered at its front, it is rarely reached with slack
+    if (!event_queue.empty() && (!wakeup || event_queue.front().time <= *wakeup))
+        add_events(event_queue);
+    return wakeup;
+}
+
+std::optional<s64> Timing::Timer::GetTicksToNextEvent() const {
+    // Events scheduled late in the current slice are already due and skipped
+    if (const auto wakeup = GetNextWakeup(executed_ticks))
+        return *wakeup - executed_ticks;
+    return std::nullopt;
+}
+
+s64 Timing::Timer::GetMaxSliceLength() const {
+    return GetTicksToNextEvent().value_or(MAX_SLICE_LENGTH);
 }
 
 void Timing::Timer::Advance(s64 max_slice_length) {
@@ -172,19 +320,23 @@ void Timing::Timer::Advance(s64 max_slice_length) {
 
     is_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= executed_ticks) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+    static Common::Tracing::Category event_category{"Core Timing", "Event"};
+    while (true) {
+        const Event* next = GetEarliestEvent();
+        if (next == nullptr || next->time > executed_ticks)
+            break;
+        Event evt = PopEarliestEvent();
+        Common::Tracing::Scope trace_scope{event_category, evt.type->trace_name,
+                                           evt.userdata};
         evt.type->callback(evt.userdata, executed_ticks - evt.time);
     }
+    MoveWheel();
 
     is_timer_sane = false;
 
     // Still events left (scheduled in the future)
-    if (!event_queue.empty()) {
-        slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - executed_ticks, max_slice_length));
+    if (const auto wakeup = GetNextWakeup(executed_ticks)) {
+        slice_length = static_cast<int>(std::min<s64>(*wakeup - executed_ticks, max_slice_length));
     }
 
     downcount = slice_length;
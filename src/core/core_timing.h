@@ -17,9 +17,13 @@
  *   ScheduleEvent(periodInCycles - cyclesLate, callback, "whatever")
  */
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <limits>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -130,6 +134,10 @@ using TimedCallback = std::function<void(u64 userdata, int cycles_late)>;
 struct TimingEventType {
     TimedCallback callback;
     const std::string* name;
+    /// The name as traced event detail, which outlives the event type
+    const char* trace_name;
+    /// Ticks an event of this type may fire late, so that it can share a wakeup with other events
+    s64 slack = 0;
 };
 
 class Timing {
@@ -146,12 +154,22 @@ public:
 
     static constexpr int MAX_SLICE_LENGTH = 20000;
 
+    /// Longest slice when only one core has a thread to run, as the others can't be starved then
+    static constexpr int MAX_SINGLE_CORE_SLICE_LENGTH = 5 * MAX_SLICE_LENGTH;
+
+    /// Longest skip ahead to the next event while no core has a thread to run (one second)
+    static constexpr int MAX_IDLE_SLICE_LENGTH = static_cast<int>(BASE_CLOCK_RATE_ARM11);
+
     class Timer {
     public:
         ~Timer();
 
         s64 GetMaxSliceLength() const;
 
+        /// Returns the ticks until the next wakeup for events that aren't due yet, or nullopt if
+        /// there are none. Events with slack may share a wakeup with the ones after them.
+        std::optional<s64> GetTicksToNextEvent() const;
+
         void Advance(s64 max_slice_length = MAX_SLICE_LENGTH);
 
         void Idle();
@@ -165,19 +183,82 @@ public:
 
         void ForceExceptionCheck(s64 cycles);
 
+        /// Applies the changes other threads posted to the timer, only called by its owner
         void MoveEvents();
 
     private:
         friend class Timing;
+
+        /// A change to the event queues, posted by threads other than the owner of the timer
+        struct InboxEntry {
+            enum class Kind : u8 {
+                Schedule,   ///< Adds the event
+                Unschedule, ///< Removes the events matching the type and userdata of the event
+                Remove,     ///< Removes the events matching the type of the event
+            };
+            Event event;
+            Kind kind = Kind::Schedule;
+        };
+
+        static constexpr std::size_t INBOX_SIZE = 256;
+
+        /// Sends a change to the owner of the timer, it takes effect on the next MoveEvents
+        void Post(InboxEntry&& entry);
+
+        void Apply(InboxEntry& entry);
+
+        // Events due within the span of the wheel go into the slot of their time, the others
+        // into the event queue. Most events are scheduled a few thousand ticks ahead, these
+        // never touch the heap.
+        static constexpr std::size_t WHEEL_SLOT_BITS = 10;
+        static constexpr std::size_t WHEEL_SIZE = 64;
+        static constexpr s64 WHEEL_SPAN = static_cast<s64>(WHEEL_SIZE << WHEEL_SLOT_BITS);
+
+        /// Adds the event to the wheel or the event queue, depending on its time
+        void PushEvent(Event&& event);
+
+        /// Removes all events matching the predicate
+        template <typename Pred>
+        void RemoveEvents(Pred pred);
+
+        /// Returns the earliest event, or nullptr if there are no events
+        const Event* GetEarliestEvent() const;
+
+        /// Removes and returns the earliest event, there has to be one
+        Event PopEarliestEvent();
+
+        /// Moves the wheel to the slot of executed_ticks and fills it up from the event queue
+        void MoveWheel();
+
+        /**
+         * Returns the latest time the next wakeup can happen at without making any event after
+         * `after` later than its slack allows, or nullopt if there are no events after `after`.
+         * Every event due by then fires at that wakeup.
+         */
+        std::optional<s64> GetNextWakeup(s64 after) const;
+
+        std::size_t GetWheelSlot(s64 time) const;
+
+        /// Returns the index of the earliest non-empty slot, the wheel must not be empty
+        std::size_t FindFirstWheelSlot() const;
+
+        std::array<std::vector<Event>, WHEEL_SIZE> wheel;
+        std::size_t wheel_events = 0;
+        /// First tick covered by the wheel, always the start of a slot
+        s64 wheel_base = 0;
+
         // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
         // We don't use std::priority_queue because we need to be able to serialize, unserialize and
         // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-        // accomodated by the standard adaptor class.
+        // accomodated by the standard adaptor class. It only holds events after the wheel span.
         std::vector<Event> event_queue;
         u64 event_fifo_id = 0;
-        // the queue for storing the events from other threads threadsafe until they will be added
-        // to the event_queue by the emu thread
-        Common::MPSCQueue<Event> ts_queue;
+        // Changes from other threads, applied in order by the owner. Entries that don't fit go to
+        // the overflow, and so do all following ones until the owner took them.
+        Common::BoundedMPMCQueue<InboxEntry, INBOX_SIZE> inbox;
+        std::atomic_bool inbox_overflowed{false};
+        std::mutex inbox_overflow_mutex;
+        std::vector<InboxEntry> inbox_overflow;
         // Are we in a function that has been called from Advance()
         // If events are sheduled from a function that gets called from Advance(),
         // don't change slice_length and downcount.
@@ -199,8 +280,12 @@ public:
 
     /**
      * Returns the event_type identifier. if name is not unique, it will assert.
+     * @param slack Ticks the events of this type may fire late, so that they share a wakeup with
+     *        other events instead of ending a slice of their own. Periodic events that reschedule
+     *        themselves with their lateness taken into account don't drift because of it.
      */
-    TimingEventType* RegisterEvent(const std::string& name, TimedCallback callback);
+    TimingEventType* RegisterEvent(const std::string& name, TimedCallback callback,
+                                   s64 slack = 0);
 
     void ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_type, u64 userdata = 0,
                        std::size_t core_id = std::numeric_limits<std::size_t>::max());
@@ -0,0 +1,123 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <string>
+#include <fmt/format.h>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/arm/arm_interface.h"
+#include "core/cpu_threads.h"
+#include "core/hle/lock.h"
+#include "core/perf_metrics.h"
+
+namespace Core {
+
+namespace {
+/// The instance and the core of the calling core thread, both null on any other thread
+thread_local CPUThreads* current_threads = nullptr;
+thread_local std::shared_ptr<ARM_Interface> current_core;
+} // Anonymous namespace
+
+CPUThreads::CPUThreads(std::size_t num_cores) : slice_cores(num_cores) {
+    threads.reserve(num_cores);
+    for (std::size_t i = 0; i < num_cores; ++i) {
+        threads.emplace_back(&CPUThreads::ThreadLoop, this, i);
+    }
+}
+
+CPUThreads::~CPUThreads() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    slice_started.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+CPUThreads* CPUThreads::GetCurrent() {
+    return current_threads;
+}
+
+MICROPROFILE_DEFINE(CPU_HostCall, "ARM JIT", "Host Call", MP_RGB(255, 128, 64));
+void CPUThreads::RunSlice(const std::vector<std::shared_ptr<ARM_Interface>>& cores,
+                          const BindCallback& bind, const AfterHostCallCallback& after_host_call) {
+    std::unique_lock lock{mutex};
+    ASSERT(running_cores == 0 && host_calls.empty());
+    std::fill(slice_cores.begin(), slice_cores.end(), nullptr);
+    for (const auto& core : cores) {
+        ASSERT(core->GetID() < slice_cores.size());
+        slice_cores[core->GetID()] = core;
+    }
+    running_cores = cores.size();
+    ++slice_id;
+    slice_started.notify_all();
+
+    while (true) {
+        core_waiting.wait(lock, [this] { return running_cores == 0 || !host_calls.empty(); });
+        if (host_calls.empty())
+            break;
+
+        HostCallRequest* const request = host_calls.front();
+        host_calls.pop_front();
+        lock.unlock();
+        {
+            MICROPROFILE_SCOPE(CPU_HostCall);
+            std::lock_guard hle_lock{HLE::g_hle_lock};
+            bind(request->core);
+            request->callback();
+            after_host_call();
+        }
+        lock.lock();
+        request->done = true;
+        host_call_done.notify_all();
+    }
+}
+
+void CPUThreads::QueueHostCall(std::function<void()> callback) {
+    HostCallRequest request{current_core, std::move(callback)};
+    std::unique_lock lock{mutex};
+    host_calls.push_back(&request);
+    core_waiting.notify_one();
+    host_call_done.wait(lock, [&request] { return request.done; });
+}
+
+void CPUThreads::ThreadLoop(std::size_t index) {
+    const std::string name = fmt::format("CPUCore_{}", index);
+    Common::SetCurrentThreadName(name.c_str());
+    MicroProfileOnThreadCreate(name.c_str());
+    current_threads = this;
+
+    u64 last_slice_id = 0;
+    while (true) {
+        {
+            std::unique_lock lock{mutex};
+            slice_started.wait(lock, [&] { return stop || slice_id != last_slice_id; });
+            if (stop)
+                break;
+            last_slice_id = slice_id;
+            current_core = slice_cores[index];
+        }
+
+        if (current_core == nullptr)
+            continue;
+
+        {
+            Metrics::ScopedTimer timer{Metrics::Time::ARM};
+            current_core->Run();
+        }
+        current_core = nullptr;
+
+        std::lock_guard lock{mutex};
+        --running_cores;
+        core_waiting.notify_one();
+    }
+
+    MicroProfileOnThreadExit();
+}
+
+} // namespace Core
@@ -0,0 +1,103 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "common/common_types.h"
+
+class ARM_Interface;
+
+namespace Core {
+
+/**
+ * Runs the slices of the emulated ARM11 cores in parallel, each on its own host thread. All cores
+ * are advanced by the same slice length through their Timing::Timer before the slice starts and
+ * the emulation thread waits for every core to finish it, so the cores drift apart by at most one
+ * slice.
+ *
+ * Only the JIT code of the cores runs on the core threads. Everything that leaves it (SVCs,
+ * memory accesses that miss the page table, interpreter fallbacks) is handed to the emulation
+ * thread, which executes these host calls one at a time with HLE::g_hle_lock held while it waits
+ * for the slice to end. The kernel, the HLE services and the renderer thus never run on two
+ * threads at once. Exclusive loads and stores of the cores go through a global exclusive monitor,
+ * which keeps guest spinlocks working across the threads. Without one in dynarmic, the core
+ * threads aren't used.
+ */
+class CPUThreads : NonCopyable {
+public:
+    /// Binds the given core as the running core of the system before a host call is executed
+    using BindCallback = std::function<void(const std::shared_ptr<ARM_Interface>&)>;
+    /// Checks the state the host call left behind, and may end the slice of all cores early
+    using AfterHostCallCallback = std::function<void()>;
+
+    explicit CPUThreads(std::size_t num_cores);
+    ~CPUThreads();
+
+    /**
+     * Runs the current slice on each of the given cores in parallel and returns once all of them
+     * have finished, executing their host calls in the meantime.
+     */
+    void RunSlice(const std::vector<std::shared_ptr<ARM_Interface>>& cores,
+                  const BindCallback& bind, const AfterHostCallCallback& after_host_call);
+
+    /**
+     * Executes the function on the emulation thread if called from a core thread, blocking the
+     * core until it is done. Otherwise the function is executed directly.
+     */
+    template <typename Func>
+    static auto HostCall(Func&& func) -> decltype(func()) {
+        CPUThreads* const threads = GetCurrent();
+        if (threads == nullptr)
+            return func();
+
+        if constexpr (std::is_void_v<decltype(func())>) {
+            threads->QueueHostCall(func);
+        } else {
+            decltype(func()) result{};
+            threads->QueueHostCall([&] { result = func(); });
+            return result;
+        }
+    }
+
+private:
+    struct HostCallRequest {
+        std::shared_ptr<ARM_Interface> core;
+        std::function<void()> callback;
+        bool done = false;
+    };
+
+    /// Returns the instance owning the calling thread, or nullptr if it isn't a core thread
+    static CPUThreads* GetCurrent();
+
+    void QueueHostCall(std::function<void()> callback);
+
+    void ThreadLoop(std::size_t index);
+
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    /// Signaled when a slice starts or the threads are stopped
+    std::condition_variable slice_started;
+    /// Signaled when a core finished its slice or queued a host call
+    std::condition_variable core_waiting;
+    /// Signaled when a host call has been executed
+    std::condition_variable host_call_done;
+
+    std::vector<std::shared_ptr<ARM_Interface>> slice_cores;
+    std::deque<HostCallRequest*> host_calls;
+    std::size_t running_cores = 0;
+    u64 slice_id = 0;
+    bool stop = false;
+};
+
+} // namespace Core
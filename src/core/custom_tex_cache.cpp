@@ -2,16 +2,23 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <bitset>
+#include <cstring>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/texture.h"
 #include "core.h"
 #include "core/custom_tex_cache.h"
+#include "core/frontend/image_interface.h"
 
 namespace Core {
 CustomTexCache::CustomTexCache() = default;
 
-CustomTexCache::~CustomTexCache() = default;
+CustomTexCache::~CustomTexCache() {
+    stop_decoding = true;
+    decode_tasks.Wait();
+}
 
 bool CustomTexCache::IsTextureDumped(u64 hash) const {
     return dumped_textures.count(hash);
@@ -58,6 +65,11 @@ void CustomTexCache::FindCustomTextures() {
         for (const auto& file : textures) {
             if (file.isDirectory)
                 continue;
+            const std::string& name = file.virtualName;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".ctp") == 0) {
+                LoadTexturePack(file.physicalName);
+                continue;
+            }
             if (file.virtualName.substr(0, 5) != "tex1_")
                 continue;
 
@@ -74,29 +86,143 @@ void CustomTexCache::FindCustomTextures() {
     }
 }
 
+void CustomTexCache::LoadTexturePack(const std::string& path) {
+    auto pack = std::make_unique<FileUtil::MappedFile>(path);
+    if (!pack->IsOpen()) {
+        LOG_ERROR(Render_OpenGL, "Failed to map texture pack {}", path);
+        return;
+    }
+
+    const u8* const data = pack->GetData();
+    const std::size_t size = pack->GetSize();
+    TexturePackHeader header;
+    if (size < sizeof(header)) {
+        LOG_ERROR(Render_OpenGL, "Texture pack {} is too small", path);
+        return;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != TexturePackHeader::MAGIC || header.version != TexturePackHeader::VERSION) {
+        LOG_ERROR(Render_OpenGL, "Texture pack {} has an unsupported format", path);
+        return;
+    }
+    const u64 entries_end = sizeof(header) + u64{header.num_entries} * sizeof(TexturePackEntry);
+    if (entries_end > size) {
+        LOG_ERROR(Render_OpenGL, "Texture pack {} is truncated", path);
+        return;
+    }
+
+    // Entries only point into the mapping, the data is paged in when a texture gets uploaded
+    std::size_t num_loaded = 0;
+    for (u32 i = 0; i < header.num_entries; ++i) {
+        TexturePackEntry entry;
+        std::memcpy(&entry, data + sizeof(header) + i * sizeof(entry), sizeof(entry));
+
+        const u64 tex_size = u64{entry.width} * entry.height * 4;
+        const std::bitset<32> width_bits(entry.width);
+        const std::bitset<32> height_bits(entry.height);
+        if (width_bits.count() != 1 || height_bits.count() != 1 || entry.size < tex_size ||
+            entry.offset > size || entry.size > size - entry.offset) {
+            LOG_ERROR(Render_OpenGL, "Texture {:016X} in pack {} is invalid", entry.hash, path);
+            continue;
+        }
+        if (custom_textures.count(entry.hash)) {
+            LOG_ERROR(Render_OpenGL, "Texture {:016X} in pack {} conflicts with another texture",
+                      entry.hash, path);
+            continue;
+        }
+
+        CustomTexInfo& tex_info = custom_textures[entry.hash];
+        tex_info.width = entry.width;
+        tex_info.height = entry.height;
+        tex_info.mapped_data = data + entry.offset;
+        ++num_loaded;
+    }
+
+    LOG_INFO(Render_OpenGL, "Mapped {} textures from pack {}", num_loaded, path);
+    texture_packs.push_back(std::move(pack));
+}
+
+bool CustomTexCache::DecodeTexture(const CustomTexPathInfo& path_info,
+                                   CustomTexInfo& tex_info) const {
+    const auto& image_interface = Core::System::GetInstance().GetImageInterface();
+    if (!image_interface->DecodePNG(tex_info.tex, tex_info.width, tex_info.height,
+                                    path_info.path)) {
+        LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
+        return false;
+    }
+
+    // Make sure the texture size is a power of 2
+    std::bitset<32> width_bits(tex_info.width);
+    std::bitset<32> height_bits(tex_info.height);
+    if (width_bits.count() != 1 || height_bits.count() != 1) {
+        LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
+        return false;
+    }
+
+    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
+    Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
+    return true;
+}
+
 void CustomTexCache::PreloadTextures() {
     for (const auto& path : custom_texture_paths) {
-        const auto& image_interface = Core::System::GetInstance().GetImageInterface();
         const auto& path_info = path.second;
+        if (IsTextureCached(path_info.hash))
+            continue;
         Core::CustomTexInfo tex_info;
-        if (image_interface->DecodePNG(tex_info.tex, tex_info.width, tex_info.height,
-                                       path_info.path)) {
-            // Make sure the texture size is a power of 2
-            std::bitset<32> width_bits(tex_info.width);
-            std::bitset<32> height_bits(tex_info.height);
-            if (width_bits.count() == 1 && height_bits.count() == 1) {
-                LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-                Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
-                CacheTexture(path_info.hash, tex_info.tex, tex_info.width, tex_info.height);
-            } else {
-                LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
-            }
-        } else {
-            LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
+        if (DecodeTexture(path_info, tex_info)) {
+            custom_textures[path_info.hash] = std::move(tex_info);
         }
     }
 }
 
+bool CustomTexCache::LoadTexture(u64 hash) {
+    Core::CustomTexInfo tex_info;
+    if (!DecodeTexture(LookupTexturePathInfo(hash), tex_info))
+        return false;
+    custom_textures[hash] = std::move(tex_info);
+    return true;
+}
+
+void CustomTexCache::RequestTexture(u64 hash) {
+    if (!requested_textures.insert(hash).second)
+        return;
+
+    decode_tasks.Submit([this, path_info = LookupTexturePathInfo(hash)] {
+        if (stop_decoding)
+            return;
+
+        // Textures that fail to decode are left requested, so they keep the original texture
+        Core::CustomTexInfo tex_info;
+        if (!DecodeTexture(path_info, tex_info))
+            return;
+
+        std::lock_guard lock{decode_mutex};
+        decoded_textures.emplace_back(path_info.hash, std::move(tex_info));
+        has_decoded_textures.store(true, std::memory_order_release);
+    });
+}
+
+std::vector<u64> CustomTexCache::CollectDecodedTextures() {
+    if (!has_decoded_textures.load(std::memory_order_acquire))
+        return {};
+
+    std::vector<std::pair<u64, CustomTexInfo>> textures;
+    {
+        std::lock_guard lock{decode_mutex};
+        textures.swap(decoded_textures);
+        has_decoded_textures.store(false, std::memory_order_relaxed);
+    }
+
+    std::vector<u64> hashes;
+    hashes.reserve(textures.size());
+    for (auto& [hash, tex_info] : textures) {
+        custom_textures[hash] = std::move(tex_info);
+        hashes.push_back(hash);
+    }
+    return hashes;
+}
+
 bool CustomTexCache::CustomTextureExists(u64 hash) const {
     return custom_texture_paths.count(hash);
 }
@@ -4,17 +4,33 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 #include "common/common_types.h"
+#include "common/swap.h"
+#include "common/task_scheduler.h"
+
+namespace FileUtil {
+class MappedFile;
+}
 
 namespace Core {
 struct CustomTexInfo {
     u32 width;
     u32 height;
     std::vector<u8> tex;
+    /// RGBA8 data in a memory-mapped texture pack, used instead of tex when set
+    const u8* mapped_data = nullptr;
+
+    const u8* GetData() const {
+        return mapped_data != nullptr ? mapped_data : tex.data();
+    }
 };
 
 // This is to avoid parsing the filename multiple times
@@ -23,6 +39,31 @@ struct CustomTexPathInfo {
     u64 hash;
 };
 
+/**
+ * Texture packs (.ctp) bundle already decoded textures so they can be memory-mapped instead of
+ * decoding a PNG per texture. A pack is a header followed by its entries and the texture data.
+ * The data of each entry is RGBA8, bottom row first, as it gets uploaded to OpenGL.
+ */
+struct TexturePackHeader {
+    static constexpr u32 MAGIC = 0x30505443; // "CTP0"
+    static constexpr u32 VERSION = 1;
+
+    u32_le magic;
+    u32_le version;
+    u32_le num_entries;
+    u32_le reserved;
+};
+static_assert(sizeof(TexturePackHeader) == 16, "TexturePackHeader has incorrect size");
+
+struct TexturePackEntry {
+    u64_le hash;
+    u32_le width;
+    u32_le height;
+    u64_le offset; ///< From the start of the pack
+    u64_le size;
+};
+static_assert(sizeof(TexturePackEntry) == 32, "TexturePackEntry has incorrect size");
+
 // TODO: think of a better name for this class...
 class CustomTexCache {
 public:
@@ -43,9 +84,33 @@ public:
     const CustomTexPathInfo& LookupTexturePathInfo(u64 hash) const;
     bool IsTexturePathMapEmpty() const;
 
+    /// Decodes the PNG of a custom texture and caches it, returns false if it failed to load
+    bool LoadTexture(u64 hash);
+
+    /// Queues decoding the PNG of a custom texture on the worker threads
+    void RequestTexture(u64 hash);
+
+    /// Caches the textures decoded by the workers since the last call and returns their hashes
+    std::vector<u64> CollectDecodedTextures();
+
 private:
+    bool DecodeTexture(const CustomTexPathInfo& path_info, CustomTexInfo& tex_info) const;
+    void LoadTexturePack(const std::string& path);
+
     std::unordered_set<u64> dumped_textures;
     std::unordered_map<u64, CustomTexInfo> custom_textures;
     std::unordered_map<u64, CustomTexPathInfo> custom_texture_paths;
+
+    std::vector<std::unique_ptr<FileUtil::MappedFile>> texture_packs;
+
+    /// Textures queued for decoding, so that they are only requested once
+    std::unordered_set<u64> requested_textures;
+    std::mutex decode_mutex;
+    std::vector<std::pair<u64, CustomTexInfo>> decoded_textures;
+    std::atomic_bool has_decoded_textures{false};
+    /// Set on destruction, the decodes that haven't started yet are skipped
+    std::atomic_bool stop_decoding{false};
+    /// Declared last so the pending decodes are waited for before the other members are destroyed
+    Common::TaskGroup decode_tasks{Common::TaskPriority::Low};
 };
 } // namespace Core
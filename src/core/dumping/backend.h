@@ -22,7 +22,7 @@ public:
     u32 stride;
     std::vector<u8> data;
 
-    VideoFrame(std::size_t width_ = 0, std::size_t height_ = 0, u8* data_ = nullptr);
+    VideoFrame(std::size_t width_ = 0, std::size_t height_ = 0, const u8* data_ = nullptr);
 };
 
 class Backend {
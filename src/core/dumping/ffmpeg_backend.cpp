@@ -2,19 +2,42 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include "common/assert.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/task_scheduler.h"
 #include "core/dumping/ffmpeg_backend.h"
+#include "core/settings.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
 extern "C" {
+#include <libavutil/hwcontext.h>
 #include <libavutil/opt.h>
+#include <libavutil/pixdesc.h>
 }
 
 namespace VideoDumper {
 
+namespace {
+/// The VP9 hardware encoders, in order of preference. NVENC and VideoToolbox can't encode VP9.
+struct HardwareEncoder {
+    const char* name;
+    AVHWDeviceType device_type;
+    AVPixelFormat pixel_format;
+};
+constexpr std::array<HardwareEncoder, 2> hardware_encoders{{
+    {"vp9_vaapi", AV_HWDEVICE_TYPE_VAAPI, AV_PIX_FMT_VAAPI},
+    {"vp9_qsv", AV_HWDEVICE_TYPE_QSV, AV_PIX_FMT_QSV},
+}};
+
+/// Bands are at least this high, so small frames aren't split over too many threads
+constexpr int MIN_BAND_HEIGHT = 64;
+constexpr std::size_t MAX_CONVERSION_BANDS = 4;
+} // Anonymous namespace
+
 void InitializeFFmpegLibraries() {
     static bool initialized = false;
 
@@ -102,7 +125,10 @@ bool FFmpegVideoStream::Init(AVFormatContext* format_context, AVOutputFormat* ou
     // Initialize video codec
     // Ensure VP9 codec here, also to avoid patent issues
     constexpr AVCodecID codec_id = AV_CODEC_ID_VP9;
-    const AVCodec* codec = avcodec_find_encoder(codec_id);
+    const AVCodec* codec = Settings::values.use_hw_video_encoder ? InitHardwareEncoder() : nullptr;
+    const bool hw_encoding = codec != nullptr;
+    if (!hw_encoding)
+        codec = avcodec_find_encoder(codec_id);
     codec_context.reset(avcodec_alloc_context3(codec));
     if (!codec || !codec_context) {
         LOG_ERROR(Render, "Could not find video encoder or allocate video codec context");
@@ -121,7 +147,14 @@ bool FFmpegVideoStream::Init(AVFormatContext* format_context, AVOutputFormat* ou
     codec_context->thread_count = 8;
     if (output_format->flags & AVFMT_GLOBALHEADER)
         codec_context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
-    av_opt_set_int(codec_context.get(), "cpu-used", 5, 0);
+    if (hw_encoding) {
+        const auto* frames_context =
+            reinterpret_cast<const AVHWFramesContext*>(hw_frames_context->data);
+        codec_context->pix_fmt = frames_context->format;
+        codec_context->hw_frames_ctx = av_buffer_ref(hw_frames_context.get());
+    } else {
+        av_opt_set_int(codec_context.get(), "cpu-used", 5, 0);
+    }
 
     if (avcodec_open2(codec_context.get(), codec, nullptr) < 0) {
         LOG_ERROR(Render, "Could not open video codec");
@@ -135,33 +168,115 @@ bool FFmpegVideoStream::Init(AVFormatContext* format_context, AVOutputFormat* ou
         return false;
     }
 
-    // Allocate frames
-    current_frame.reset(av_frame_alloc());
+    // Allocate frames. Hardware encoders get the frames uploaded as NV12.
+    const AVPixelFormat sw_pixel_format = hw_encoding ? AV_PIX_FMT_NV12 : codec_context->pix_fmt;
     scaled_frame.reset(av_frame_alloc());
-    scaled_frame->format = codec_context->pix_fmt;
+    scaled_frame->format = sw_pixel_format;
     scaled_frame->width = layout.width;
     scaled_frame->height = layout.height;
     if (av_frame_get_buffer(scaled_frame.get(), 1) < 0) {
         LOG_ERROR(Render, "Could not allocate frame buffer");
         return false;
     }
+    if (hw_encoding)
+        hw_frame.reset(av_frame_alloc());
+
+    return InitConversion(sw_pixel_format);
+}
+
+const AVCodec* FFmpegVideoStream::InitHardwareEncoder() {
+    for (const HardwareEncoder& encoder : hardware_encoders) {
+        const AVCodec* codec = avcodec_find_encoder_by_name(encoder.name);
+        if (!codec)
+            continue;
 
-    // Create SWS Context
-    auto* context = sws_getCachedContext(
-        sws_context.get(), layout.width, layout.height, pixel_format, layout.width, layout.height,
-        codec_context->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr);
-    if (context != sws_context.get())
-        sws_context.reset(context);
+        AVBufferRef* device = nullptr;
+        if (av_hwdevice_ctx_create(&device, encoder.device_type, nullptr, nullptr, 0) < 0)
+            continue;
+        hw_device_context.reset(device);
 
+        AVBufferRef* frames = av_hwframe_ctx_alloc(device);
+        if (!frames) {
+            hw_device_context.reset();
+            continue;
+        }
+        auto* frames_context = reinterpret_cast<AVHWFramesContext*>(frames->data);
+        frames_context->format = encoder.pixel_format;
+        frames_context->sw_format = AV_PIX_FMT_NV12;
+        frames_context->width = layout.width;
+        frames_context->height = layout.height;
+        frames_context->initial_pool_size = 20;
+        hw_frames_context.reset(frames);
+        if (av_hwframe_ctx_init(frames) < 0) {
+            hw_frames_context.reset();
+            hw_device_context.reset();
+            continue;
+        }
+
+        LOG_INFO(Render, "Using hardware video encoder {}", encoder.name);
+        return codec;
+    }
+
+    LOG_WARNING(Render, "No hardware video encoder available, falling back to libvpx");
+    return nullptr;
+}
+
+bool FFmpegVideoStream::InitConversion(AVPixelFormat sw_pixel_format) {
+    const int height = static_cast<int>(layout.height);
+    const std::size_t max_bands = std::min<std::size_t>(
+        Common::TaskScheduler::GetInstance().NumWorkers() + 1, MAX_CONVERSION_BANDS);
+    const std::size_t num_bands =
+        std::clamp<std::size_t>(height / MIN_BAND_HEIGHT, 1, max_bands);
+    // Keep the band boundaries on even rows so they don't split the subsampled chroma rows
+    const int band_height = static_cast<int>((height / num_bands) & ~1u);
+
+    bands.resize(num_bands);
+    for (std::size_t i = 0; i < num_bands; ++i) {
+        ConversionBand& band = bands[i];
+        band.begin = static_cast<int>(i) * band_height;
+        band.end = i + 1 == num_bands ? height : band.begin + band_height;
+        band.sws_context.reset(sws_getContext(layout.width, band.end - band.begin, pixel_format,
+                                              layout.width, band.end - band.begin,
+                                              sw_pixel_format, SWS_BICUBIC, nullptr, nullptr,
+                                              nullptr));
+        if (!band.sws_context) {
+            LOG_ERROR(Render, "Could not create SWS context");
+            return false;
+        }
+    }
     return true;
 }
 
+void FFmpegVideoStream::ConvertBand(const ConversionBand& band) {
+    const auto format = static_cast<AVPixelFormat>(scaled_frame->format);
+    const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get(format);
+    const int num_planes = av_pix_fmt_count_planes(format);
+
+    std::array<const u8*, 1> src_data{converted_frame->data.data() +
+                                      band.begin * converted_frame->stride};
+    std::array<int, 1> src_linesize{static_cast<int>(converted_frame->stride)};
+    std::array<u8*, 4> dst_data{};
+    std::array<int, 4> dst_linesize{};
+    for (int plane = 0; plane < num_planes; ++plane) {
+        // The chroma planes are vertically subsampled
+        const bool is_chroma = plane == 1 || plane == 2;
+        const int row = is_chroma ? band.begin >> descriptor->log2_chroma_h : band.begin;
+        dst_data[plane] = scaled_frame->data[plane] + row * scaled_frame->linesize[plane];
+        dst_linesize[plane] = scaled_frame->linesize[plane];
+    }
+
+    sws_scale(band.sws_context.get(), src_data.data(), src_linesize.data(), 0,
+              band.end - band.begin, dst_data.data(), dst_linesize.data());
+}
+
 void FFmpegVideoStream::Free() {
     FFmpegStream::Free();
 
-    current_frame.reset();
+    bands.clear();
     scaled_frame.reset();
-    sws_context.reset();
+    hw_frame.reset();
+    hw_frames_context.reset();
+    hw_device_context.reset();
 }
 
 void FFmpegVideoStream::ProcessFrame(VideoFrame& frame) {
@@ -169,22 +284,39 @@ void FFmpegVideoStream::ProcessFrame(VideoFrame& frame) {
         LOG_ERROR(Render, "Frame dropped: resolution does not match");
         return;
     }
-    // Prepare frame
-    current_frame->data[0] = frame.data.data();
-    current_frame->linesize[0] = frame.stride;
-    current_frame->format = pixel_format;
-    current_frame->width = layout.width;
-    current_frame->height = layout.height;
 
-    // Scale the frame
-    if (sws_context) {
-        sws_scale(sws_context.get(), current_frame->data, current_frame->linesize, 0, layout.height,
-                  scaled_frame->data, scaled_frame->linesize);
+    // Convert the frame, the other bands in parallel to the first one
+    if (av_frame_make_writable(scaled_frame.get()) < 0) {
+        LOG_ERROR(Render, "Frame dropped: could not make frame writable");
+        return;
+    }
+    converted_frame = &frame;
+    {
+        Common::TaskGroup conversions{Common::TaskPriority::High};
+        for (std::size_t i = 1; i < bands.size(); ++i) {
+            conversions.Submit([this, &band = bands[i]] { ConvertBand(band); });
+        }
+        ConvertBand(bands[0]);
+        conversions.Wait();
+    }
+    converted_frame = nullptr;
+
+    AVFrame* encoded_frame = scaled_frame.get();
+    if (hw_frames_context) {
+        if (av_hwframe_get_buffer(hw_frames_context.get(), hw_frame.get(), 0) < 0 ||
+            av_hwframe_transfer_data(hw_frame.get(), scaled_frame.get(), 0) < 0) {
+            LOG_ERROR(Render, "Frame dropped: could not upload frame to the hardware encoder");
+            av_frame_unref(hw_frame.get());
+            return;
+        }
+        encoded_frame = hw_frame.get();
     }
-    scaled_frame->pts = frame_count++;
+    encoded_frame->pts = frame_count++;
 
     // Encode frame
-    SendFrame(scaled_frame.get());
+    SendFrame(encoded_frame);
+    if (hw_frames_context)
+        av_frame_unref(hw_frame.get());
 }
 
 FFmpegAudioStream::~FFmpegAudioStream() {
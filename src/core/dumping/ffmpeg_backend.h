@@ -64,7 +64,8 @@ protected:
 
 /**
  * A FFmpegStream used for video data.
- * Rescales, encodes and writes a frame.
+ * Rescales, encodes and writes a frame. The frames are converted in horizontal bands on several
+ * threads, and encoded on the GPU if a hardware encoder is enabled and available.
  */
 class FFmpegVideoStream : public FFmpegStream {
 public:
@@ -82,13 +83,36 @@ private:
         }
     };
 
+    struct AVBufferRefDeleter {
+        void operator()(AVBufferRef* buffer) const {
+            av_buffer_unref(&buffer);
+        }
+    };
+
+    /// Rows of the frame that are converted by one thread
+    struct ConversionBand {
+        std::unique_ptr<SwsContext, SwsContextDeleter> sws_context{};
+        int begin{};
+        int end{};
+    };
+
+    /// Returns the hardware encoder to use and sets up its device, or nullptr if there is none
+    const AVCodec* InitHardwareEncoder();
+    bool InitConversion(AVPixelFormat sw_pixel_format);
+    void ConvertBand(const ConversionBand& band);
+
     u64 frame_count{};
 
-    std::unique_ptr<AVFrame, AVFrameDeleter> current_frame{};
     std::unique_ptr<AVFrame, AVFrameDeleter> scaled_frame{};
-    std::unique_ptr<SwsContext, SwsContextDeleter> sws_context{};
+    std::unique_ptr<AVFrame, AVFrameDeleter> hw_frame{};
+    std::unique_ptr<AVBufferRef, AVBufferRefDeleter> hw_device_context{};
+    std::unique_ptr<AVBufferRef, AVBufferRefDeleter> hw_frames_context{};
     Layout::FramebufferLayout layout;
 
+    // The first band is converted by the encoding thread, the others by the task scheduler
+    std::vector<ConversionBand> bands;
+    const VideoFrame* converted_frame{};
+
     /// The pixel format the frames are stored in
     static constexpr AVPixelFormat pixel_format = AVPixelFormat::AV_PIX_FMT_BGRA;
 };
@@ -158,6 +158,14 @@ public:
      */
     virtual u64 GetFreeBytes() const = 0;
 
+    /**
+     * Commits the pending writes of the files opened from this archive to the host
+     * @return Result of the operation
+     */
+    virtual ResultCode Commit() const {
+        return RESULT_SUCCESS;
+    }
+
     u64 GetOpenDelayNs() {
         if (delay_generator != nullptr) {
             return delay_generator->GetOpenDelayNs();
@@ -25,11 +25,13 @@ namespace FileSys {
  * A modified version of DiskFile for fixed-size file used by ExtSaveData
  * The file size can't be changed by SetSize or Write.
  */
-class FixSizeDiskFile : public DiskFile {
+class FixSizeDiskFile : public JournaledDiskFile {
 public:
     FixSizeDiskFile(FileUtil::IOFile&& file, const Mode& mode,
-                    std::unique_ptr<DelayGenerator> delay_generator_)
-        : DiskFile(std::move(file), mode, std::move(delay_generator_)) {
+                    std::unique_ptr<DelayGenerator> delay_generator_, std::string path,
+                    std::shared_ptr<ArchiveJournal> archive_journal)
+        : JournaledDiskFile(std::move(file), mode, std::move(delay_generator_), std::move(path),
+                            std::move(archive_journal)) {
         size = GetSize();
     }
 
@@ -49,7 +51,7 @@ public:
             length = size - offset;
         }
 
-        return DiskFile::Write(offset, length, flush, buffer);
+        return JournaledDiskFile::Write(offset, length, flush, buffer);
     }
 
 private:
@@ -139,6 +141,10 @@ public:
             break; // Expected 'success' case
         }
 
+        // Files opened from the archive must see the pending writes of the others
+        journal->CommitAll();
+        JournaledDiskFile::RecoverJournal(full_path);
+
         FileUtil::IOFile file(full_path, "r+b");
         if (!file.IsOpen()) {
             LOG_CRITICAL(Service_FS, "(unreachable) Unknown error opening {}", full_path);
@@ -150,8 +156,8 @@ public:
         rwmode.read_flag.Assign(1);
         std::unique_ptr<DelayGenerator> delay_generator =
             std::make_unique<ExtSaveDataDelayGenerator>();
-        auto disk_file =
-            std::make_unique<FixSizeDiskFile>(std::move(file), rwmode, std::move(delay_generator));
+        auto disk_file = std::make_unique<FixSizeDiskFile>(
+            std::move(file), rwmode, std::move(delay_generator), full_path, journal);
         return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
     }
 
@@ -0,0 +1,61 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <fmt/format.h>
+#include "common/cityhash.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/file_sys/content_store.h"
+
+namespace FileSys {
+
+bool DeduplicateContent(const std::string& path, const std::string& store_dir) {
+    FileUtil::MappedFile content(path);
+    if (!content.IsOpen() || content.GetSize() == 0)
+        return false;
+
+    std::string store_path = store_dir;
+    if (store_path.back() != '/' && store_path.back() != '\\')
+        store_path += '/';
+    if (!FileUtil::CreateFullPath(store_path))
+        return false;
+
+    const Common::uint128 hash =
+        Common::CityHash128(reinterpret_cast<const char*>(content.GetData()), content.GetSize());
+    store_path += fmt::format("{:016X}{:016X}-{:X}.app", hash.first, hash.second,
+                              content.GetSize());
+
+    if (!FileUtil::Exists(store_path)) {
+        content.Close();
+        return FileUtil::CreateHardLink(path, store_path);
+    }
+
+    // Compare the data anyway, a collision would otherwise corrupt the title silently
+    {
+        FileUtil::MappedFile stored(store_path);
+        if (!stored.IsOpen() || stored.GetSize() != content.GetSize() ||
+            std::memcmp(stored.GetData(), content.GetData(), content.GetSize()) != 0) {
+            LOG_WARNING(Service_FS, "Store file {} doesn't match {}, not deduplicating",
+                        store_path, path);
+            return false;
+        }
+    }
+    content.Close();
+
+    // Link under a temporary name first so that the content is never lost if linking fails
+    const std::string temp_path = path + ".dedup";
+    FileUtil::Delete(temp_path);
+    if (!FileUtil::CreateHardLink(store_path, temp_path))
+        return false;
+    if (!FileUtil::Delete(path) || !FileUtil::Rename(temp_path, path)) {
+        LOG_ERROR(Service_FS, "Failed to replace {} by its store file", path);
+        return false;
+    }
+
+    LOG_DEBUG(Service_FS, "Deduplicated {} to {}", path, store_path);
+    return true;
+}
+
+} // namespace FileSys
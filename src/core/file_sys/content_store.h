@@ -0,0 +1,27 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+namespace FileSys {
+
+/**
+ * Deduplicates an installed title content through a content-addressed store directory. The store
+ * names its files after the CityHash128 and the size of their data. If the store already holds
+ * the same data, the content is replaced by a hard link to it, otherwise the content is linked
+ * into the store for the next installation of the same title.
+ *
+ * Both paths must be on the same file system. The content must never be modified in place
+ * afterwards, writers have to delete it and create a new file instead. Store files whose only
+ * remaining link is the store itself aren't used by any title and may be deleted.
+ *
+ * @param path Path of the installed content
+ * @param store_dir Path of the store directory, created if it doesn't exist
+ * @returns true if the content is shared with the store, false if it was left alone
+ */
+bool DeduplicateContent(const std::string& path, const std::string& store_dir);
+
+} // namespace FileSys
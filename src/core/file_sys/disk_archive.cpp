@@ -4,9 +4,13 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <memory>
+#include <fmt/format.h>
+#include "common/common_paths.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
@@ -53,18 +57,286 @@ bool DiskFile::Close() const {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-DiskDirectory::DiskDirectory(const std::string& path) {
-    unsigned size = FileUtil::ScanDirectoryTree(path, directory);
-    directory.size = size;
-    directory.isDirectory = true;
-    children_iterator = directory.children.begin();
+void ArchiveJournal::Register(JournaledDiskFile* file) {
+    std::lock_guard lock{mutex};
+    files.push_back(file);
 }
 
+void ArchiveJournal::Unregister(JournaledDiskFile* file) {
+    std::lock_guard lock{mutex};
+    files.erase(std::remove(files.begin(), files.end(), file), files.end());
+}
+
+bool ArchiveJournal::CommitAll() {
+    std::lock_guard lock{mutex};
+    bool success = true;
+    for (JournaledDiskFile* file : files) {
+        success &= file->Commit();
+    }
+    return success;
+}
+
+namespace {
+constexpr u32 JOURNAL_MAGIC = 0x4C4E524A; // "JRNL"
+
+struct JournalHeader {
+    u32_le magic;
+    u32_le num_ranges;
+};
+
+struct JournalRange {
+    u64_le offset;
+    u64_le length;
+};
+
+/// Journals live outside of the archive so that the guest never sees them in directory listings
+std::string GetJournalPath(const std::string& path) {
+    return fmt::format("{}journal" DIR_SEP "{:016X}.journal",
+                       FileUtil::GetUserPath(FileUtil::UserPath::UserDir),
+                       Common::ComputeHash64(path.data(), path.size()));
+}
+} // Anonymous namespace
+
+JournaledDiskFile::JournaledDiskFile(FileUtil::IOFile&& file, const Mode& mode,
+                                     std::unique_ptr<DelayGenerator> delay_generator,
+                                     std::string path,
+                                     std::shared_ptr<ArchiveJournal> archive_journal)
+    : DiskFile(std::move(file), mode, std::move(delay_generator)), path(std::move(path)),
+      archive_journal(std::move(archive_journal)) {
+    size = DiskFile::GetSize();
+    this->archive_journal->Register(this);
+}
+
+JournaledDiskFile::~JournaledDiskFile() {
+    archive_journal->Unregister(this);
+    Commit();
+}
+
+ResultVal<std::size_t> JournaledDiskFile::Read(const u64 offset, const std::size_t length,
+                                               u8* buffer) const {
+    if (!mode.read_flag)
+        return ERROR_INVALID_OPEN_FLAGS;
+
+    std::lock_guard lock{mutex};
+    if (offset >= size)
+        return MakeResult<std::size_t>(0);
+    const std::size_t read_length = static_cast<std::size_t>(std::min<u64>(length, size - offset));
+
+    // Read what's on the disk, the rest up to the size can only be a gap before a pending write
+    file->Seek(offset, SEEK_SET);
+    const std::size_t disk_length = file->ReadBytes(buffer, read_length);
+    std::memset(buffer + disk_length, 0, read_length - disk_length);
+
+    const u64 end = offset + read_length;
+    auto it = pending.upper_bound(offset);
+    if (it != pending.begin())
+        --it;
+    for (; it != pending.end() && it->first < end; ++it) {
+        const u64 range_start = std::max(it->first, offset);
+        const u64 range_end = std::min<u64>(it->first + it->second.size(), end);
+        if (range_start >= range_end)
+            continue;
+        std::memcpy(buffer + (range_start - offset), it->second.data() + (range_start - it->first),
+                    range_end - range_start);
+    }
+    return MakeResult<std::size_t>(read_length);
+}
+
+ResultVal<std::size_t> JournaledDiskFile::Write(const u64 offset, const std::size_t length,
+                                                const bool flush, const u8* buffer) {
+    if (!mode.write_flag)
+        return ERROR_INVALID_OPEN_FLAGS;
+
+    // The flush flag is not honored for each write, that's what the batching is for
+    std::lock_guard lock{mutex};
+    AddPendingWrite(offset, buffer, length);
+    size = std::max<u64>(size, offset + length);
+    if (pending_size >= COMMIT_THRESHOLD)
+        CommitLocked();
+    return MakeResult<std::size_t>(length);
+}
+
+void JournaledDiskFile::AddPendingWrite(u64 offset, const u8* data, std::size_t length) {
+    if (length == 0)
+        return;
+
+    const u64 end = offset + length;
+    auto first = pending.upper_bound(offset);
+    if (first != pending.begin()) {
+        const auto previous = std::prev(first);
+        if (previous->first + previous->second.size() >= offset)
+            first = previous;
+    }
+
+    // Fast paths for writes within a pending range and for appending to one, which is what
+    // small sequential writes do
+    if (first != pending.end() && first->first <= offset) {
+        std::vector<u8>& range = first->second;
+        const u64 range_end = first->first + range.size();
+        const auto next = std::next(first);
+        if (end <= range_end) {
+            std::memcpy(range.data() + (offset - first->first), data, length);
+            return;
+        }
+        if (next == pending.end() || next->first > end) {
+            range.resize(end - first->first);
+            std::memcpy(range.data() + (offset - first->first), data, length);
+            pending_size += end - range_end;
+            return;
+        }
+    }
+
+    // Merge all ranges the write overlaps or touches into one
+    u64 start = offset;
+    u64 merged_end = end;
+    auto last = first;
+    for (; last != pending.end() && last->first <= end; ++last) {
+        start = std::min(start, last->first);
+        merged_end = std::max<u64>(merged_end, last->first + last->second.size());
+    }
+
+    std::vector<u8> merged(merged_end - start);
+    for (auto it = first; it != last; ++it) {
+        std::memcpy(merged.data() + (it->first - start), it->second.data(), it->second.size());
+        pending_size -= it->second.size();
+    }
+    std::memcpy(merged.data() + (offset - start), data, length);
+    pending.erase(first, last);
+    pending_size += merged.size();
+    pending.emplace(start, std::move(merged));
+}
+
+u64 JournaledDiskFile::GetSize() const {
+    std::lock_guard lock{mutex};
+    return size;
+}
+
+bool JournaledDiskFile::SetSize(const u64 new_size) const {
+    std::lock_guard lock{mutex};
+    if (!CommitLocked())
+        return false;
+    DiskFile::SetSize(new_size);
+    size = new_size;
+    return true;
+}
+
+bool JournaledDiskFile::Close() const {
+    Commit();
+    return DiskFile::Close();
+}
+
+void JournaledDiskFile::Flush() const {
+    Commit();
+}
+
+bool JournaledDiskFile::Commit() const {
+    std::lock_guard lock{mutex};
+    return CommitLocked();
+}
+
+bool JournaledDiskFile::CommitLocked() const {
+    if (pending.empty() || !file->IsOpen())
+        return true;
+
+    const std::string journal_path = GetJournalPath(path);
+    const std::string temp_path = journal_path + ".tmp";
+    if (!FileUtil::CreateFullPath(journal_path)) {
+        LOG_ERROR(Service_FS, "Could not create the journal path {}", journal_path);
+        return false;
+    }
+
+    {
+        FileUtil::IOFile journal(temp_path, "wb");
+        const JournalHeader header{JOURNAL_MAGIC, static_cast<u32>(pending.size())};
+        bool success = journal.IsOpen() && journal.WriteObject(header) == 1;
+        for (const auto& [offset, data] : pending) {
+            if (!success)
+                break;
+            const JournalRange range{offset, data.size()};
+            success = journal.WriteObject(range) == 1 &&
+                      journal.WriteBytes(data.data(), data.size()) == data.size();
+        }
+        if (!success || !journal.Flush()) {
+            LOG_ERROR(Service_FS, "Could not write the journal of {}", path);
+            journal.Close();
+            FileUtil::Delete(temp_path);
+            return false;
+        }
+    }
+
+    // The journal is only valid once the rename went through
+    if (!FileUtil::Rename(temp_path, journal_path)) {
+        LOG_ERROR(Service_FS, "Could not rename the journal of {}", path);
+        FileUtil::Delete(temp_path);
+        return false;
+    }
+
+    bool success = true;
+    for (const auto& [offset, data] : pending) {
+        success &= file->Seek(offset, SEEK_SET) &&
+                   file->WriteBytes(data.data(), data.size()) == data.size();
+    }
+    success &= file->Flush();
+    if (!success) {
+        // The journal is kept to be replayed on the next open
+        LOG_ERROR(Service_FS, "Could not write back to {}", path);
+        return false;
+    }
+
+    FileUtil::Delete(journal_path);
+    pending.clear();
+    pending_size = 0;
+    return true;
+}
+
+void JournaledDiskFile::RecoverJournal(const std::string& path) {
+    const std::string journal_path = GetJournalPath(path);
+    if (!FileUtil::Exists(journal_path))
+        return;
+
+    FileUtil::IOFile journal(journal_path, "rb");
+    FileUtil::IOFile file(path, "r+b");
+    JournalHeader header;
+    if (!journal.IsOpen() || !file.IsOpen() ||
+        journal.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != JOURNAL_MAGIC) {
+        LOG_ERROR(Service_FS, "Could not replay the journal of {}", path);
+        return;
+    }
+
+    bool success = true;
+    std::vector<u8> data;
+    for (u32 i = 0; i < header.num_ranges && success; ++i) {
+        JournalRange range;
+        success = journal.ReadBytes(&range, sizeof(range)) == sizeof(range) &&
+                  range.length <= journal.GetSize();
+        if (!success)
+            break;
+        data.resize(range.length);
+        success = journal.ReadBytes(data.data(), data.size()) == data.size() &&
+                  file.Seek(range.offset, SEEK_SET) &&
+                  file.WriteBytes(data.data(), data.size()) == data.size();
+    }
+    success &= file.Flush();
+    if (!success) {
+        LOG_ERROR(Service_FS, "Could not replay the journal of {}", path);
+        return;
+    }
+
+    LOG_WARNING(Service_FS, "Replayed the journal of an interrupted write to {}", path);
+    journal.Close();
+    FileUtil::Delete(journal_path);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+DiskDirectory::DiskDirectory(const std::string& path) : iterator(path) {}
+
 u32 DiskDirectory::Read(const u32 count, Entry* entries) {
     u32 entries_read = 0;
 
-    while (entries_read < count && children_iterator != directory.children.cend()) {
-        const FileUtil::FSTEntry& file = *children_iterator;
+    FileUtil::FSTEntry file;
+    while (entries_read < count && iterator.Next(file)) {
         const std::string& filename = file.virtualName;
         Entry& entry = entries[entries_read];
 
@@ -91,7 +363,6 @@ u32 DiskDirectory::Read(const u32 count, Entry* entries) {
         entry.is_archive = !file.isDirectory;
 
         ++entries_read;
-        ++children_iterator;
     }
     return entries_read;
 }
@@ -5,7 +5,9 @@
 #pragma once
 
 #include <cstddef>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "common/common_types.h"
@@ -45,6 +47,74 @@ protected:
     std::unique_ptr<FileUtil::IOFile> file;
 };
 
+class JournaledDiskFile;
+
+/// The journaled files opened from an archive, so that they can be committed together
+class ArchiveJournal {
+public:
+    void Register(JournaledDiskFile* file);
+    void Unregister(JournaledDiskFile* file);
+
+    /// Commits the pending writes of all registered files, returns false if any commit failed
+    bool CommitAll();
+
+private:
+    std::mutex mutex;
+    std::vector<JournaledDiskFile*> files;
+};
+
+/**
+ * A DiskFile that keeps the guest writes in memory, coalescing them, and writes them back in
+ * batches. The pending data is committed on Flush and Close, when the archive is committed and
+ * once enough of it has accumulated.
+ *
+ * A commit first writes the pending ranges to a journal, which is only renamed into place once
+ * complete, then applies them to the file and deletes the journal. The journal of an
+ * interrupted commit is replayed by RecoverJournal before the file is opened again.
+ */
+class JournaledDiskFile : public DiskFile {
+public:
+    JournaledDiskFile(FileUtil::IOFile&& file, const Mode& mode,
+                      std::unique_ptr<DelayGenerator> delay_generator, std::string path,
+                      std::shared_ptr<ArchiveJournal> archive_journal);
+    ~JournaledDiskFile() override;
+
+    ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override;
+    ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
+                                 const u8* buffer) override;
+    u64 GetSize() const override;
+    bool SetSize(u64 size) const override;
+    bool Close() const override;
+    void Flush() const override;
+
+    /// Writes the pending data to the host file, returns false on failure
+    bool Commit() const;
+
+    /// Applies the journal of an interrupted commit to the file at path, if there is one
+    static void RecoverJournal(const std::string& path);
+
+private:
+    /// Pending writes are committed once they exceed this size
+    static constexpr std::size_t COMMIT_THRESHOLD = 1024 * 1024;
+
+    bool CommitLocked() const;
+    void AddPendingWrite(u64 offset, const u8* data, std::size_t length);
+
+    std::string path;
+    std::shared_ptr<ArchiveJournal> archive_journal;
+
+    mutable std::mutex mutex;
+    /// Pending writes by offset, which neither overlap nor touch each other
+    mutable std::map<u64, std::vector<u8>> pending;
+    mutable std::size_t pending_size = 0;
+    /// Size of the file including the pending writes
+    mutable u64 size = 0;
+};
+
+/**
+ * A directory on the host. Its entries are read from the host as the guest reads them, so that
+ * opening a directory with thousands of files doesn't scan all of them up front.
+ */
 class DiskDirectory : public DirectoryBackend {
 public:
     explicit DiskDirectory(const std::string& path);
@@ -60,11 +130,9 @@ public:
     }
 
 protected:
-    FileUtil::FSTEntry directory{};
-
-    // We need to remember the last entry we returned, so a subsequent call to Read will continue
-    // from the next one.  This iterator will always point to the next unread entry.
-    std::vector<FileUtil::FSTEntry>::iterator children_iterator;
+    // The iterator remembers the last entry we returned, so a subsequent call to Read will
+    // continue from the next one
+    FileUtil::DirectoryIterator iterator;
 };
 
 } // namespace FileSys
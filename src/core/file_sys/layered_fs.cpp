@@ -4,10 +4,12 @@
 
 #include <algorithm>
 #include <cstring>
+#include <fmt/format.h>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/string_util.h"
 #include "common/swap.h"
 #include "core/file_sys/layered_fs.h"
@@ -51,6 +53,27 @@ struct FileMetadata {
 };
 static_assert(sizeof(FileMetadata) == 0x20, "Size of FileMetadata is not correct");
 
+constexpr u64 BUILD_CACHE_VERSION = 1;
+
+struct BuildCacheHeader {
+    u64_le version;
+    u64_le fingerprint;
+    u64_le metadata_size;
+    u64_le data_size;
+    u64_le num_files;
+};
+
+// Followed by the path, the replacement file path and the patched data
+struct BuildCacheFile {
+    u64_le data_offset;
+    u64_le type;
+    u64_le original_offset;
+    u64_le size;
+    u64_le path_length;
+    u64_le replace_path_length;
+    u64_le patched_size;
+};
+
 LayeredFS::LayeredFS(std::shared_ptr<RomFSReader> romfs_, std::string patch_path_,
                      std::string patch_ext_path_, bool load_relocations)
     : romfs(std::move(romfs_)), patch_path(std::move(patch_path_)),
@@ -60,6 +83,18 @@ LayeredFS::LayeredFS(std::shared_ptr<RomFSReader> romfs_, std::string patch_path
 
     ASSERT_MSG(header.header_length == sizeof(header), "Header size is incorrect");
 
+    const bool has_mods =
+        load_relocations && (FileUtil::Exists(patch_path) || FileUtil::Exists(patch_ext_path));
+    u64 fingerprint = 0;
+    if (has_mods) {
+        fingerprint = ComputeModFingerprint();
+        if (LoadBuildCache(fingerprint)) {
+            LOG_INFO(Service_FS, "LayeredFS loaded {} files from the build cache",
+                     cached_files.size());
+            return;
+        }
+    }
+
     // TODO: is root always the first directory in table?
     root.parent = &root;
     LoadDirectory(root, 0);
@@ -70,6 +105,10 @@ LayeredFS::LayeredFS(std::shared_ptr<RomFSReader> romfs_, std::string patch_path
     }
 
     RebuildMetadata();
+
+    if (has_mods) {
+        SaveBuildCache(fingerprint);
+    }
 }
 
 LayeredFS::~LayeredFS() = default;
@@ -481,12 +520,209 @@ void LayeredFS::RebuildMetadata() {
                 header.file_metadata_table.length);
 }
 
+namespace {
+/// Appends the relative path, the size and the modification time of every file below root to key
+void AppendTreeState(std::string& key, const std::string& root) {
+    if (!FileUtil::Exists(root)) {
+        return;
+    }
+
+    const FileUtil::DirectoryEntryCallable callback = [&key, &root,
+                                                       &callback](u64* /*num_entries_out*/,
+                                                                  const std::string& directory,
+                                                                  const std::string& virtual_name) {
+        const std::string path = directory + virtual_name;
+        if (FileUtil::IsDirectory(path)) {
+            return FileUtil::ForeachDirectoryEntry(nullptr, path + DIR_SEP, callback);
+        }
+
+        const u64_le state[] = {FileUtil::GetSize(path), FileUtil::GetModificationTime(path)};
+        key.append(path, root.size(), std::string::npos);
+        key.push_back('\0');
+        key.append(reinterpret_cast<const char*>(state), sizeof(state));
+        return true;
+    };
+
+    FileUtil::ForeachDirectoryEntry(nullptr, root, callback);
+}
+} // Anonymous namespace
+
+u64 LayeredFS::ComputeModFingerprint() const {
+    // The metadata of the original RomFS determines the layout of the unmodified files
+    std::string key(header.file_data_offset, '\0');
+    romfs->ReadFile(0, key.size(), reinterpret_cast<u8*>(key.data()));
+
+    const u64_le romfs_size = romfs->GetSize();
+    key.append(reinterpret_cast<const char*>(&romfs_size), sizeof(romfs_size));
+
+    AppendTreeState(key, patch_path);
+    // Separates the two trees, so moving a file from one to the other changes the fingerprint
+    constexpr char separator[] = "\0romfs_ext\0";
+    key.append(separator, sizeof(separator) - 1);
+    std::string ext_path = patch_ext_path;
+    if (!ext_path.empty() && ext_path.back() != '/' && ext_path.back() != '\\') {
+        ext_path += DIR_SEP;
+    }
+    AppendTreeState(key, ext_path);
+
+    return Common::ComputeHash64(key.data(), key.size());
+}
+
+std::string LayeredFS::GetBuildCachePath() const {
+    return fmt::format("{}layered_fs" DIR_SEP "{:016X}.bin",
+                       FileUtil::GetUserPath(FileUtil::UserPath::CacheDir),
+                       Common::ComputeHash64(patch_path.data(), patch_path.size()));
+}
+
+bool LayeredFS::LoadBuildCache(u64 fingerprint) {
+    FileUtil::IOFile file(GetBuildCachePath(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    BuildCacheHeader cache_header;
+    if (file.ReadBytes(&cache_header, sizeof(cache_header)) != sizeof(cache_header) ||
+        cache_header.version != BUILD_CACHE_VERSION || cache_header.fingerprint != fingerprint) {
+        return false;
+    }
+
+    std::vector<u8> cached_metadata(cache_header.metadata_size);
+    if (file.ReadBytes(cached_metadata.data(), cached_metadata.size()) != cached_metadata.size()) {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<File>> files;
+    std::map<u64, File*> offset_map;
+    for (u64 i = 0; i < cache_header.num_files; ++i) {
+        BuildCacheFile entry;
+        if (file.ReadBytes(&entry, sizeof(entry)) != sizeof(entry) || entry.type > 2) {
+            return false;
+        }
+
+        auto cached_file = std::make_unique<File>();
+        cached_file->path.resize(entry.path_length);
+        cached_file->relocation.replace_file_path.resize(entry.replace_path_length);
+        cached_file->relocation.patched_file.resize(entry.patched_size);
+        if (file.ReadBytes(cached_file->path.data(), cached_file->path.size()) !=
+                cached_file->path.size() ||
+            file.ReadBytes(cached_file->relocation.replace_file_path.data(),
+                           cached_file->relocation.replace_file_path.size()) !=
+                cached_file->relocation.replace_file_path.size() ||
+            file.ReadBytes(cached_file->relocation.patched_file.data(),
+                           cached_file->relocation.patched_file.size()) !=
+                cached_file->relocation.patched_file.size()) {
+            return false;
+        }
+        cached_file->relocation.type = static_cast<int>(entry.type);
+        cached_file->relocation.original_offset = entry.original_offset;
+        cached_file->relocation.size = entry.size;
+        cached_file->parent = nullptr;
+
+        offset_map.emplace(entry.data_offset, cached_file.get());
+        files.emplace_back(std::move(cached_file));
+    }
+
+    metadata = std::move(cached_metadata);
+    current_data_offset = cache_header.data_size;
+    cached_files = std::move(files);
+    data_offset_map = std::move(offset_map);
+    return true;
+}
+
+void LayeredFS::SaveBuildCache(u64 fingerprint) const {
+    const std::string path = GetBuildCachePath();
+    if (!FileUtil::CreateFullPath(path)) {
+        LOG_ERROR(Service_FS, "Could not create path for the LayeredFS build cache {}", path);
+        return;
+    }
+
+    FileUtil::IOFile file(path, "wb");
+    if (!file) {
+        LOG_ERROR(Service_FS, "Could not open the LayeredFS build cache {}", path);
+        return;
+    }
+
+    BuildCacheHeader cache_header{};
+    cache_header.version = BUILD_CACHE_VERSION;
+    cache_header.fingerprint = fingerprint;
+    cache_header.metadata_size = metadata.size();
+    cache_header.data_size = current_data_offset;
+    cache_header.num_files = data_offset_map.size();
+    bool success = file.WriteObject(cache_header) == 1 &&
+                   file.WriteBytes(metadata.data(), metadata.size()) == metadata.size();
+
+    for (const auto& [data_offset, cached_file] : data_offset_map) {
+        if (!success) {
+            break;
+        }
+
+        const FileRelocationInfo& relocation = cached_file->relocation;
+        BuildCacheFile entry{};
+        entry.data_offset = data_offset;
+        entry.type = static_cast<u64>(relocation.type);
+        entry.original_offset = relocation.original_offset;
+        entry.size = relocation.size;
+        entry.path_length = cached_file->path.size();
+        entry.replace_path_length = relocation.replace_file_path.size();
+        entry.patched_size = relocation.patched_file.size();
+        success = file.WriteObject(entry) == 1 &&
+                  file.WriteString(cached_file->path) == cached_file->path.size() &&
+                  file.WriteString(relocation.replace_file_path) ==
+                      relocation.replace_file_path.size() &&
+                  file.WriteBytes(relocation.patched_file.data(),
+                                  relocation.patched_file.size()) ==
+                      relocation.patched_file.size();
+    }
+
+    if (!success) {
+        LOG_ERROR(Service_FS, "Could not write the LayeredFS build cache {}", path);
+        file.Close();
+        FileUtil::Delete(path);
+    }
+}
+
 std::size_t LayeredFS::GetSize() const {
     return metadata.size() + current_data_offset;
 }
 
+void LayeredFS::ReadReplacement(const File& file, std::size_t offset, std::size_t length,
+                                u8* buffer) {
+    // Mapping a replacement file once is much cheaper than opening it for every read, so keep the
+    // most recently read ones mapped
+    MappedReplacement* slot = nullptr;
+    for (MappedReplacement& candidate : mapped_replacements) {
+        if (candidate.file == &file) {
+            slot = &candidate;
+            break;
+        }
+        if (slot == nullptr || candidate.last_use < slot->last_use) {
+            slot = &candidate;
+        }
+    }
+    if (slot->file != &file) {
+        slot->file = &file;
+        slot->mapping.Close();
+        slot->mapping.Open(file.relocation.replace_file_path);
+    }
+    slot->last_use = ++mapping_tick;
+
+    if (slot->mapping.IsOpen() && offset + length <= slot->mapping.GetSize()) {
+        std::memcpy(buffer, slot->mapping.GetData() + offset, length);
+        return;
+    }
+
+    FileUtil::IOFile replace_file(file.relocation.replace_file_path, "rb");
+    if (replace_file) {
+        replace_file.Seek(offset, SEEK_SET);
+        replace_file.ReadBytes(buffer, length);
+    } else {
+        LOG_ERROR(Service_FS, "Could not open replacement file for {}", file.path);
+    }
+}
+
 std::size_t LayeredFS::ReadFile(std::size_t offset, std::size_t length, u8* buffer) {
     ASSERT_MSG(offset + length <= GetSize(), "Out of bound");
+    std::lock_guard lock{read_mutex};
 
     std::size_t read_size = 0;
     if (offset < metadata.size()) {
@@ -520,14 +756,7 @@ std::size_t LayeredFS::ReadFile(std::size_t offset, std::size_t length, u8* buff
             romfs->ReadFile(relocation.original_offset + relative_offset, to_read,
                             buffer + read_size);
         } else if (relocation.type == 1) { // replace
-            FileUtil::IOFile replace_file(relocation.replace_file_path, "rb");
-            if (replace_file) {
-                replace_file.Seek(relative_offset, SEEK_SET);
-                replace_file.ReadBytes(buffer + read_size, to_read);
-            } else {
-                LOG_ERROR(Service_FS, "Could not open replacement file for {}",
-                          current->second->path);
-            }
+            ReadReplacement(*current->second, relative_offset, to_read, buffer + read_size);
         } else if (relocation.type == 2) { // patch
             std::memcpy(buffer + read_size, relocation.patched_file.data() + relative_offset,
                         to_read);
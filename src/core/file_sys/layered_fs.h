@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -37,6 +39,10 @@ static_assert(sizeof(RomFSHeader) == 0x28, "Size of RomFSHeader is not correct")
  * patch_ext_path: Path for RomFS extensions. Files present in this path:
  *  - When with an extension of ".stub", remove the corresponding file in the RomFS.
  *  - When with an extension of ".ips" or ".bps", patch the file in the RomFS.
+ *
+ * Building the metadata requires walking both the original RomFS and the mod directories, which
+ * is slow for large mods. The result is therefore cached in the cache directory, keyed on the
+ * original metadata and the sizes and modification times of the mod files.
  */
 class LayeredFS : public RomFSReader {
 public:
@@ -92,6 +98,19 @@ private:
 
     void RebuildMetadata();
 
+    // Hash of everything the rebuilt metadata depends on, used as the key of the build cache
+    u64 ComputeModFingerprint() const;
+
+    std::string GetBuildCachePath() const;
+
+    // Restores the rebuilt metadata and the file relocations from the build cache
+    bool LoadBuildCache(u64 fingerprint);
+
+    void SaveBuildCache(u64 fingerprint) const;
+
+    // Reads a part of a replacement file, through a mapping of the file when possible
+    void ReadReplacement(const File& file, std::size_t offset, std::size_t length, u8* buffer);
+
     std::shared_ptr<RomFSReader> romfs;
     std::string patch_path;
     std::string patch_ext_path;
@@ -118,6 +137,21 @@ private:
     u64 current_file_offset{};           // current file metadata offset
     std::vector<u8> file_metadata_table; // rebuilt file metadata table
     u64 current_data_offset{};           // current assigned data offset
+
+    // Files restored from the build cache, which aren't linked into the directory tree
+    std::vector<std::unique_ptr<File>> cached_files;
+
+    struct MappedReplacement {
+        const File* file = nullptr;
+        FileUtil::MappedFile mapping;
+        u64 last_use = 0;
+    };
+    static constexpr std::size_t NUM_MAPPED_REPLACEMENTS = 32;
+    std::array<MappedReplacement, NUM_MAPPED_REPLACEMENTS> mapped_replacements;
+    u64 mapping_tick = 0;
+
+    // Guards the replacement mappings, reads may come from the FS I/O thread
+    std::mutex read_mutex;
 };
 
 } // namespace FileSys
@@ -2,21 +2,24 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstring>
 #include <memory>
-#include <cryptopp/aes.h>
-#include <cryptopp/modes.h>
+#include <string_view>
 #include <cryptopp/sha.h>
 #include "common/common_types.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/file_sys/layered_fs.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/file_sys/patch.h"
 #include "core/file_sys/seed_db.h"
+#include "core/hw/aes/ctr.h"
 #include "core/hw/aes/key.h"
 #include "core/loader/loader.h"
+#include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
@@ -56,64 +59,112 @@ static u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
  */
 static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
                             u32 decompressed_size) {
+    if (compressed_size < 8 || compressed_size > decompressed_size)
+        return false;
+
     const u8* footer = compressed + compressed_size - 8;
 
     u32 buffer_top_and_bottom;
     std::memcpy(&buffer_top_and_bottom, footer, sizeof(u32));
 
+    const u32 top = (buffer_top_and_bottom >> 24) & 0xFF;
+    const u32 bottom = buffer_top_and_bottom & 0xFFFFFF;
+    if (top > compressed_size || bottom > compressed_size)
+        return false;
+
     u32 out = decompressed_size;
-    u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
-    u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
+    u32 index = compressed_size - top;
+    const u32 stop_index = compressed_size - bottom;
 
-    memset(decompressed, 0, decompressed_size);
-    memcpy(decompressed, compressed, compressed_size);
+    std::memcpy(decompressed, compressed, compressed_size);
+    std::memset(decompressed + compressed_size, 0, decompressed_size - compressed_size);
 
     while (index > stop_index) {
         u8 control = compressed[--index];
 
-        for (unsigned i = 0; i < 8; i++) {
-            if (index <= stop_index)
-                break;
-            if (index <= 0)
-                break;
-            if (out <= 0)
-                break;
-
-            if (control & 0x80) {
-                // Check if compression is out of bounds
-                if (index < 2)
-                    return false;
-                index -= 2;
-
-                u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
-                u32 segment_size = ((segment_offset >> 12) & 15) + 3;
-                segment_offset &= 0x0FFF;
-                segment_offset += 2;
-
-                // Check if compression is out of bounds
-                if (out < segment_size)
-                    return false;
-
-                for (unsigned j = 0; j < segment_size; j++) {
-                    // Check if compression is out of bounds
-                    if (out + segment_offset >= decompressed_size)
-                        return false;
-
-                    u8 data = decompressed[out + segment_offset];
-                    decompressed[--out] = data;
-                }
-            } else {
-                // Check if compression is out of bounds
-                if (out < 1)
-                    return false;
+        for (unsigned i = 0; i < 8 && index > stop_index && out > 0; i++, control <<= 1) {
+            if (!(control & 0x80)) {
                 decompressed[--out] = compressed[--index];
+                continue;
+            }
+
+            // Check if compression is out of bounds
+            if (index < 2)
+                return false;
+            index -= 2;
+
+            u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
+            const u32 segment_size = ((segment_offset >> 12) & 15) + 3;
+            segment_offset = (segment_offset & 0x0FFF) + 2;
+
+            // Check if compression is out of bounds, the first copied byte is the furthest one
+            if (out < segment_size || out + segment_offset >= decompressed_size)
+                return false;
+
+            // The segment is copied backwards byte by byte, so it only repeats bytes it has just
+            // written if the source overlaps the destination
+            out -= segment_size;
+            u8* const dest = decompressed + out;
+            const u8* const source = dest + segment_offset + 1;
+            if (segment_offset + 1 >= segment_size) {
+                std::memcpy(dest, source, segment_size);
+            } else {
+                for (u32 j = segment_size; j-- > 0;) {
+                    dest[j] = source[j];
+                }
             }
-            control <<= 1;
         }
     }
     return true;
 }
 
+constexpr u32 CODE_CACHE_MAGIC = 0x45444F43; // "CODE"
+
+/**
+ * Get the path of the cached decompressed .code section of a title. The hash of the section is part
+ * of the name, so updated or modified titles never hit stale entries.
+ * @return The path, or an empty string if the section has no hash to key the cache with
+ */
+static std::string GetCodeCachePath(u64 program_id, const u8 (&hash)[0x20]) {
+    if (std::all_of(std::begin(hash), std::end(hash), [](u8 byte) { return byte == 0; }))
+        return {};
+
+    std::string name = fmt::format("{:016X}_", program_id);
+    for (std::size_t i = 0; i < 16; ++i) {
+        name += fmt::format("{:02X}", hash[i]);
+    }
+    return fmt::format("{}code/{}.bin", FileUtil::GetUserPath(FileUtil::UserPath::CacheDir),
+                       name);
+}
+
+static bool LoadCachedCode(const std::string& path, std::vector<u8>& buffer) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen())
+        return false;
+
+    std::array<u32, 2> header;
+    if (file.ReadArray(header.data(), header.size()) != header.size() ||
+        header[0] != CODE_CACHE_MAGIC || header[1] != file.GetSize() - sizeof(header))
+        return false;
+
+    buffer.resize(header[1]);
+    return file.ReadBytes(buffer.data(), buffer.size()) == buffer.size();
+}
+
+static void StoreCachedCode(const std::string& path, const std::vector<u8>& buffer) {
+    if (!FileUtil::CreateFullPath(path))
+        return;
+
+    FileUtil::IOFile file(path, "wb");
+    const std::array<u32, 2> header{CODE_CACHE_MAGIC, static_cast<u32>(buffer.size())};
+    if (file.WriteArray(header.data(), header.size()) != header.size() ||
+        file.WriteBytes(buffer.data(), buffer.size()) != buffer.size()) {
+        LOG_WARNING(Service_FS, "Could not write the code cache {}", path);
+        file.Close();
+        FileUtil::Delete(path);
+    }
+}
+
 NCCHContainer::NCCHContainer(const std::string& filepath, u32 ncch_offset)
     : ncch_offset(ncch_offset), filepath(filepath) {
     file = FileUtil::IOFile(filepath, "rb");
@@ -139,18 +190,14 @@ Loader::ResultStatus NCCHContainer::Load() {
         return Loader::ResultStatus::Success;
 
     if (file.IsOpen()) {
-        // Reset read pointer in case this file has been read before.
-        file.Seek(ncch_offset, SEEK_SET);
-
-        if (file.ReadBytes(&ncch_header, sizeof(NCCH_Header)) != sizeof(NCCH_Header))
+        if (file.ReadAt(ncch_offset, &ncch_header, sizeof(NCCH_Header)) != sizeof(NCCH_Header))
             return Loader::ResultStatus::Error;
 
         // Skip NCSD header and load first NCCH (NCSD is just a container of NCCH files)...
         if (Loader::MakeMagic('N', 'C', 'S', 'D') == ncch_header.magic) {
             LOG_DEBUG(Service_FS, "Only loading the first (bootable) NCCH within the NCSD file!");
             ncch_offset += 0x4000;
-            file.Seek(ncch_offset, SEEK_SET);
-            file.ReadBytes(&ncch_header, sizeof(NCCH_Header));
+            file.ReadAt(ncch_offset, &ncch_header, sizeof(NCCH_Header));
         }
 
         // Verify we are loading the correct file type...
@@ -195,12 +242,20 @@ Loader::ResultStatus NCCHContainer::Load() {
                     }
                 }
 
-                SetKeyY(KeySlotID::NCCHSecure1, key_y_primary);
-                if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure1)) {
-                    LOG_ERROR(Service_FS, "Secure1 KeyX missing");
-                    failed_to_decrypt = true;
-                }
-                primary_key = GetNormalKey(KeySlotID::NCCHSecure1);
+                // Derived without going through the key slots, so that titles can be loaded in
+                // parallel, e.g. by the game list
+                const auto derive_key = [&failed_to_decrypt](std::size_t slot_id,
+                                                             const AESKey& key_y,
+                                                             std::string_view name) {
+                    const auto key = DeriveNormalKey(slot_id, key_y);
+                    if (!key) {
+                        LOG_ERROR(Service_FS, "{} KeyX missing", name);
+                        failed_to_decrypt = true;
+                    }
+                    return key.value_or(AESKey{});
+                };
+
+                primary_key = derive_key(KeySlotID::NCCHSecure1, key_y_primary, "Secure1");
 
                 switch (ncch_header.secondary_key_slot) {
                 case 0:
@@ -209,30 +264,15 @@ Loader::ResultStatus NCCHContainer::Load() {
                     break;
                 case 1:
                     LOG_DEBUG(Service_FS, "Secure2 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure2, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure2)) {
-                        LOG_ERROR(Service_FS, "Secure2 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure2);
+                    secondary_key = derive_key(KeySlotID::NCCHSecure2, key_y_secondary, "Secure2");
                     break;
                 case 10:
                     LOG_DEBUG(Service_FS, "Secure3 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure3, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure3)) {
-                        LOG_ERROR(Service_FS, "Secure3 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure3);
+                    secondary_key = derive_key(KeySlotID::NCCHSecure3, key_y_secondary, "Secure3");
                     break;
                 case 11:
                     LOG_DEBUG(Service_FS, "Secure4 crypto");
-                    SetKeyY(KeySlotID::NCCHSecure4, key_y_secondary);
-                    if (!IsNormalKeyAvailable(KeySlotID::NCCHSecure4)) {
-                        LOG_ERROR(Service_FS, "Secure4 KeyX missing");
-                        failed_to_decrypt = true;
-                    }
-                    secondary_key = GetNormalKey(KeySlotID::NCCHSecure4);
+                    secondary_key = derive_key(KeySlotID::NCCHSecure4, key_y_secondary, "Secure4");
                     break;
                 }
             }
@@ -283,12 +323,12 @@ Loader::ResultStatus NCCHContainer::Load() {
 
         // System archives and DLC don't have an extended header but have RomFS
         if (ncch_header.extended_header_size) {
-            auto read_exheader = [this](FileUtil::IOFile& file) {
+            auto read_exheader = [this](FileUtil::IOFile& file, u64 offset) {
                 const std::size_t size = sizeof(exheader_header);
-                return file && file.ReadBytes(&exheader_header, size) == size;
+                return file && file.ReadAt(offset, &exheader_header, size) == size;
             };
 
-            if (!read_exheader(file)) {
+            if (!read_exheader(file, ncch_offset + sizeof(NCCH_Header))) {
                 return Loader::ResultStatus::Error;
             }
 
@@ -305,10 +345,9 @@ Loader::ResultStatus NCCHContainer::Load() {
                         LOG_ERROR(Service_FS, "Failed to decrypt");
                         return Loader::ResultStatus::ErrorEncrypted;
                     }
-                    CryptoPP::byte* data = reinterpret_cast<CryptoPP::byte*>(&exheader_header);
-                    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption(
-                        primary_key.data(), primary_key.size(), exheader_ctr.data())
-                        .ProcessData(data, data, sizeof(exheader_header));
+                    u8* data = reinterpret_cast<u8*>(&exheader_header);
+                    HW::AES::CTRCipher(primary_key, exheader_ctr)
+                        .Process(0, data, data, sizeof(exheader_header));
                 }
             }
 
@@ -323,7 +362,7 @@ Loader::ResultStatus NCCHContainer::Load() {
             bool has_exheader_override = false;
             for (const auto& path : exheader_override_paths) {
                 FileUtil::IOFile exheader_override_file{path, "rb"};
-                if (read_exheader(exheader_override_file)) {
+                if (read_exheader(exheader_override_file, 0)) {
                     has_exheader_override = true;
                     break;
                 }
@@ -372,18 +411,18 @@ Loader::ResultStatus NCCHContainer::Load() {
             LOG_DEBUG(Service_FS, "ExeFS offset:                0x{:08X}", exefs_offset);
             LOG_DEBUG(Service_FS, "ExeFS size:                  0x{:08X}", exefs_size);
 
-            file.Seek(exefs_offset + ncch_offset, SEEK_SET);
-            if (file.ReadBytes(&exefs_header, sizeof(ExeFs_Header)) != sizeof(ExeFs_Header))
+            if (file.ReadAt(exefs_offset + ncch_offset, &exefs_header, sizeof(ExeFs_Header)) !=
+                sizeof(ExeFs_Header))
                 return Loader::ResultStatus::Error;
 
             if (is_encrypted) {
-                CryptoPP::byte* data = reinterpret_cast<CryptoPP::byte*>(&exefs_header);
-                CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption(primary_key.data(),
-                                                              primary_key.size(), exefs_ctr.data())
-                    .ProcessData(data, data, sizeof(exefs_header));
+                u8* data = reinterpret_cast<u8*>(&exefs_header);
+                HW::AES::CTRCipher(primary_key, exefs_ctr)
+                    .Process(0, data, data, sizeof(exefs_header));
             }
 
             exefs_file = FileUtil::IOFile(filepath, "rb");
+            exefs_mapping.Open(filepath);
             has_exefs = true;
         }
 
@@ -414,8 +453,9 @@ Loader::ResultStatus NCCHContainer::LoadOverrides() {
     if (FileUtil::Exists(exefs_override)) {
         exefs_file = FileUtil::IOFile(exefs_override, "rb");
 
-        if (exefs_file.ReadBytes(&exefs_header, sizeof(ExeFs_Header)) == sizeof(ExeFs_Header)) {
+        if (exefs_file.ReadAt(0, &exefs_header, sizeof(ExeFs_Header)) == sizeof(ExeFs_Header)) {
             LOG_DEBUG(Service_FS, "Loading ExeFS section from {}", exefs_override);
+            exefs_mapping.Open(exefs_override);
             exefs_offset = 0;
             is_tainted = true;
             has_exefs = true;
@@ -452,9 +492,7 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             std::size_t logo_size = ncch_header.logo_region_size * kBlockSize;
 
             buffer.resize(logo_size);
-            file.Seek(ncch_offset + logo_offset, SEEK_SET);
-
-            if (file.ReadBytes(buffer.data(), logo_size) != logo_size) {
+            if (file.ReadAt(ncch_offset + logo_offset, buffer.data(), logo_size) != logo_size) {
                 LOG_ERROR(Service_FS, "Could not read NCCH logo");
                 return Loader::ResultStatus::Error;
             }
@@ -478,9 +516,10 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             LOG_DEBUG(Service_FS, "{} - offset: 0x{:08X}, size: 0x{:08X}, name: {}", section_number,
                       section.offset, section.size, section.name);
 
-            s64 section_offset =
+            const u64 section_offset =
                 (section.offset + exefs_offset + sizeof(ExeFs_Header) + ncch_offset);
-            exefs_file.Seek(section_offset, SEEK_SET);
+            // Null if the file couldn't be mapped, the section is read from the file then
+            const u8* const mapped_section = exefs_mapping.ReadSpan(section_offset, section.size);
 
             std::array<u8, 16> key;
             if (strcmp(section.name, "icon") == 0 || strcmp(section.name, "banner") == 0) {
@@ -489,38 +528,67 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
                 key = secondary_key;
             }
 
-            CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption dec(key.data(), key.size(),
-                                                              exefs_ctr.data());
-            dec.Seek(section.offset + sizeof(ExeFs_Header));
+            HW::AES::CTRCipher dec(key, exefs_ctr);
+            const u64 crypto_offset = section.offset + sizeof(ExeFs_Header);
 
             if (strcmp(section.name, ".code") == 0 && is_compressed) {
-                // Section is compressed, read compressed .code section...
-                std::unique_ptr<u8[]> temp_buffer;
-                try {
-                    temp_buffer.reset(new u8[section.size]);
-                } catch (std::bad_alloc&) {
-                    return Loader::ResultStatus::ErrorMemoryAllocationFailed;
+                // The hashes are stored in reverse order of the sections
+                const std::string cache_path = GetCodeCachePath(
+                    ncch_header.program_id, exefs_header.hashes[kMaxSections - 1 - section_number]);
+                if (!cache_path.empty() && LoadCachedCode(cache_path, buffer)) {
+                    LOG_DEBUG(Service_FS, "Loaded .code from the cache {}", cache_path);
+                    return Loader::ResultStatus::Success;
                 }
 
-                if (exefs_file.ReadBytes(&temp_buffer[0], section.size) != section.size)
-                    return Loader::ResultStatus::Error;
+                // Section is compressed, a decrypted .code section is decompressed straight out of
+                // the mapping, otherwise it is read or decrypted into a temporary buffer first
+                const u8* compressed = mapped_section;
+                std::unique_ptr<u8[]> temp_buffer;
+                if (compressed == nullptr || is_encrypted) {
+                    try {
+                        temp_buffer.reset(new u8[section.size]);
+                    } catch (std::bad_alloc&) {
+                        return Loader::ResultStatus::ErrorMemoryAllocationFailed;
+                    }
 
-                if (is_encrypted) {
-                    dec.ProcessData(&temp_buffer[0], &temp_buffer[0], section.size);
+                    if (mapped_section != nullptr) {
+                        dec.Process(crypto_offset, mapped_section, &temp_buffer[0], section.size);
+                    } else {
+                        if (exefs_file.ReadAt(section_offset, &temp_buffer[0], section.size) !=
+                            section.size)
+                            return Loader::ResultStatus::Error;
+                        if (is_encrypted) {
+                            dec.Process(crypto_offset, &temp_buffer[0], &temp_buffer[0],
+                                        section.size);
+                        }
+                    }
+                    compressed = temp_buffer.get();
                 }
 
                 // Decompress .code section...
-                u32 decompressed_size = LZSS_GetDecompressedSize(&temp_buffer[0], section.size);
+                u32 decompressed_size = LZSS_GetDecompressedSize(compressed, section.size);
                 buffer.resize(decompressed_size);
-                if (!LZSS_Decompress(&temp_buffer[0], section.size, &buffer[0], decompressed_size))
+                if (!LZSS_Decompress(compressed, section.size, &buffer[0], decompressed_size))
                     return Loader::ResultStatus::ErrorInvalidFormat;
+
+                if (!cache_path.empty())
+                    StoreCachedCode(cache_path, buffer);
             } else {
                 // Section is uncompressed...
                 buffer.resize(section.size);
-                if (exefs_file.ReadBytes(&buffer[0], section.size) != section.size)
-                    return Loader::ResultStatus::Error;
-                if (is_encrypted) {
-                    dec.ProcessData(&buffer[0], &buffer[0], section.size);
+                if (mapped_section != nullptr) {
+                    if (is_encrypted) {
+                        dec.Process(crypto_offset, mapped_section, &buffer[0], section.size);
+                    } else {
+                        std::memcpy(&buffer[0], mapped_section, section.size);
+                    }
+                } else {
+                    if (exefs_file.ReadAt(section_offset, &buffer[0], section.size) !=
+                        section.size)
+                        return Loader::ResultStatus::Error;
+                    if (is_encrypted) {
+                        dec.Process(crypto_offset, &buffer[0], &buffer[0], section.size);
+                    }
                 }
             }
 
@@ -639,7 +707,7 @@ Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romf
     if (!romfs_file_inner.IsOpen())
         return Loader::ResultStatus::Error;
 
-    std::shared_ptr<RomFSReader> direct_romfs;
+    std::shared_ptr<DirectRomFSReader> direct_romfs;
     if (is_encrypted) {
         direct_romfs =
             std::make_shared<DirectRomFSReader>(std::move(romfs_file_inner), romfs_offset,
@@ -648,6 +716,16 @@ Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romf
         direct_romfs = std::make_shared<DirectRomFSReader>(std::move(romfs_file_inner),
                                                            romfs_offset, romfs_size);
     }
+    direct_romfs->MapFile(filepath);
+    if (is_encrypted && Settings::values.share_decrypted_romfs) {
+        // The super block hash tells apart different versions with the same program ID
+        u64 romfs_hash;
+        std::memcpy(&romfs_hash, ncch_header.romfs_super_block_hash, sizeof(romfs_hash));
+        direct_romfs->UseDecryptedCopy(
+            fmt::format("{}romfs/{:016X}_{:016X}.bin",
+                        FileUtil::GetUserPath(FileUtil::UserPath::CacheDir),
+                        ncch_header.program_id, romfs_hash));
+    }
 
     const auto path =
         fmt::format("{}mods/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::LoadDir),
@@ -687,8 +765,10 @@ Loader::ResultStatus NCCHContainer::ReadOverrideRomFS(std::shared_ptr<RomFSReade
         if (romfs_file_inner.IsOpen()) {
             LOG_WARNING(Service_FS, "File {} overriding built-in RomFS; LayeredFS not enabled",
                         split_filepath);
-            romfs_file = std::make_shared<DirectRomFSReader>(std::move(romfs_file_inner), 0,
-                                                             romfs_file_inner.GetSize());
+            auto direct_romfs = std::make_shared<DirectRomFSReader>(std::move(romfs_file_inner), 0,
+                                                                    romfs_file_inner.GetSize());
+            direct_romfs->MapFile(split_filepath);
+            romfs_file = std::move(direct_romfs);
             return Loader::ResultStatus::Success;
         }
     }
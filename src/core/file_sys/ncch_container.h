@@ -333,6 +333,8 @@ private:
     std::string filepath;
     FileUtil::IOFile file;
     FileUtil::IOFile exefs_file;
+    /// Mapping of exefs_file, the sections are decrypted and decompressed straight out of it
+    FileUtil::MappedFile exefs_mapping;
 };
 
 } // namespace FileSys
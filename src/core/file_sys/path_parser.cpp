@@ -58,6 +58,19 @@ PathParser::PathParser(const Path& path) {
 }
 
 PathParser::HostStatus PathParser::GetHostStatus(const std::string& mount_point) const {
+    // Applications mostly look up paths that exist. Then a single stat of the full path is enough,
+    // because every component before the last one has to be a directory.
+    if (!path_sequence.empty()) {
+        switch (FileUtil::GetPathType(BuildHostPath(mount_point))) {
+        case FileUtil::PathType::File:
+            return FileFound;
+        case FileUtil::PathType::Directory:
+            return DirectoryFound;
+        case FileUtil::PathType::NotFound:
+            break;
+        }
+    }
+
     auto path = mount_point;
     if (!FileUtil::IsDirectory(path))
         return InvalidMountPoint;
@@ -65,24 +78,22 @@ PathParser::HostStatus PathParser::GetHostStatus(const std::string& mount_point)
         return DirectoryFound;
     }
 
+    // Find the component that is missing or not a directory
     for (auto iter = path_sequence.begin(); iter != path_sequence.end() - 1; iter++) {
         if (path.back() != '/')
             path += '/';
         path += *iter;
 
-        if (!FileUtil::Exists(path))
+        switch (FileUtil::GetPathType(path)) {
+        case FileUtil::PathType::NotFound:
             return PathNotFound;
-        if (FileUtil::IsDirectory(path))
-            continue;
-        return FileInPath;
+        case FileUtil::PathType::File:
+            return FileInPath;
+        case FileUtil::PathType::Directory:
+            break;
+        }
     }
-
-    path += "/" + path_sequence.back();
-    if (!FileUtil::Exists(path))
-        return NotFound;
-    if (FileUtil::IsDirectory(path))
-        return DirectoryFound;
-    return FileFound;
+    return NotFound;
 }
 
 std::string PathParser::BuildHostPath(const std::string& mount_point) const {
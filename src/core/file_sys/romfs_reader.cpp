@@ -1,22 +1,204 @@
 #include <algorithm>
-#include <cryptopp/aes.h>
-#include <cryptopp/modes.h>
+#include <cstring>
+#include <random>
+#include <fmt/format.h>
+#include "common/logging/log.h"
 #include "core/file_sys/romfs_reader.h"
 
 namespace FileSys {
 
 std::size_t DirectRomFSReader::ReadFile(std::size_t offset, std::size_t length, u8* buffer) {
-    if (length == 0)
+    if (length == 0 || offset >= data_size)
         return 0; // Crypto++ does not like zero size buffer
-    file.Seek(file_offset + offset, SEEK_SET);
-    std::size_t read_length = std::min(length, data_size - offset);
-    read_length = file.ReadBytes(buffer, read_length);
+    const std::size_t read_length = std::min(length, data_size - offset);
+    std::lock_guard lock{mutex};
+
+    // Unencrypted data can be copied out of the mapping as is
+    if (!is_encrypted && mapping.IsOpen()) {
+        const u8* const src = mapping.ReadSpan(file_offset + offset, read_length);
+        if (src == nullptr)
+            return 0;
+        std::memcpy(buffer, src, read_length);
+        return read_length;
+    }
+
+    // Large reads don't gain anything from the cache, they would only evict the small blocks
+    if (read_length >= CACHE_BLOCK_SIZE)
+        return ReadUncached(offset, read_length, buffer);
+
+    std::size_t done = 0;
+    while (done < read_length) {
+        const std::size_t position = offset + done;
+        const CacheBlock& block = GetBlock(position / CACHE_BLOCK_SIZE);
+        const std::size_t block_offset = position % CACHE_BLOCK_SIZE;
+        if (block_offset >= block.size)
+            break;
+
+        const std::size_t copy_length = std::min(read_length - done, block.size - block_offset);
+        std::memcpy(buffer + done, block.data.data() + block_offset, copy_length);
+        done += copy_length;
+    }
+    return done;
+}
+
+void DirectRomFSReader::MapFile(const std::string& filename) {
+    if (!mapping.Open(filename))
+        return;
+    if (mapping.GetSize() < file_offset + data_size)
+        mapping.Close();
+}
+
+bool DirectRomFSReader::UseDecryptedCopy(const std::string& copy_path) {
+    if (!is_encrypted)
+        return true;
+
+    std::lock_guard lock{mutex};
+    FileUtil::MappedFile copy;
+    if (!copy.Open(copy_path) || copy.GetSize() != data_size) {
+        copy.Close();
+        if (!WriteDecryptedCopy(copy_path) || !copy.Open(copy_path) ||
+            copy.GetSize() != data_size) {
+            LOG_WARNING(Service_FS, "Could not use the decrypted RomFS at {}", copy_path);
+            return false;
+        }
+    }
+    copy.Close();
+
+    // The copy replaces the mapping of the original file, reads fall back to the file if it
+    // can't be mapped again
+    mapping.Close();
+    if (!mapping.Open(copy_path))
+        return false;
+    is_encrypted = false;
+    file_offset = 0;
+    for (CacheBlock& block : cache) {
+        block = {};
+    }
+    return true;
+}
+
+bool DirectRomFSReader::WriteDecryptedCopy(const std::string& copy_path) {
+    if (!FileUtil::CreateFullPath(copy_path))
+        return false;
+
+    // Other processes may be writing the same copy, the rename makes sure none of them ever maps
+    // a partially written one
+    const std::string temp_path = fmt::format("{}.{:08x}.tmp", copy_path, std::random_device{}());
+    {
+        FileUtil::IOFile temp(temp_path, "wb");
+        if (!temp.IsOpen())
+            return false;
+
+        LOG_INFO(Service_FS, "Writing decrypted RomFS to {}", copy_path);
+        std::vector<u8> buffer(CACHE_BLOCK_SIZE * CACHE_NUM_BLOCKS);
+        for (std::size_t offset = 0; offset < data_size; offset += buffer.size()) {
+            const std::size_t length = std::min(buffer.size(), data_size - offset);
+            if (ReadUncached(offset, length, buffer.data()) != length ||
+                temp.WriteBytes(buffer.data(), length) != length) {
+                temp.Close();
+                FileUtil::Delete(temp_path);
+                return false;
+            }
+        }
+    }
+    if (!FileUtil::Rename(temp_path, copy_path)) {
+        // Renaming onto an existing file fails on Windows, another process has written the copy
+        // in that case
+        FileUtil::Delete(temp_path);
+        return FileUtil::Exists(copy_path);
+    }
+    return true;
+}
+
+std::size_t DirectRomFSReader::ReadUncached(std::size_t offset, std::size_t length, u8* buffer) {
+    if (mapping.IsOpen()) {
+        // Decrypt straight out of the mapping instead of copying it first
+        const u8* const src = mapping.ReadSpan(file_offset + offset, length);
+        if (src == nullptr)
+            return 0;
+        if (is_encrypted) {
+            cipher->Process(crypto_offset + offset, src, buffer, length);
+        } else {
+            std::memcpy(buffer, src, length);
+        }
+        return length;
+    }
+
+    const std::size_t read_length = file.ReadAt(file_offset + offset, buffer, length);
     if (is_encrypted) {
-        CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption d(key.data(), key.size(), ctr.data());
-        d.Seek(crypto_offset + offset);
-        d.ProcessData(buffer, buffer, read_length);
+        cipher->Process(crypto_offset + offset, buffer, buffer, read_length);
     }
     return read_length;
 }
 
+const DirectRomFSReader::CacheBlock& DirectRomFSReader::GetBlock(std::size_t index) {
+    const auto allocate = [this](std::size_t block_index) -> CacheBlock& {
+        CacheBlock& block =
+            *std::min_element(cache.begin(), cache.end(), [](const auto& a, const auto& b) {
+                return a.last_use < b.last_use;
+            });
+        block.data.resize(CACHE_BLOCK_SIZE);
+        block.index = block_index;
+        block.size = 0;
+        block.last_use = ++cache_tick;
+        return block;
+    };
+    const auto block_length = [this](std::size_t block_index) {
+        return std::min(CACHE_BLOCK_SIZE, data_size - block_index * CACHE_BLOCK_SIZE);
+    };
+    const auto load = [&](CacheBlock& block) {
+        block.size = ReadUncached(block.index * CACHE_BLOCK_SIZE, block_length(block.index),
+                                  block.data.data());
+    };
+    const auto find = [this](std::size_t block_index) {
+        return std::find_if(cache.begin(), cache.end(), [block_index](const auto& block) {
+            return block.size != 0 && block.index == block_index;
+        });
+    };
+
+    const auto itr = find(index);
+    if (itr != cache.end()) {
+        itr->last_use = ++cache_tick;
+        return *itr;
+    }
+
+    // Streaming reads walk through the blocks in order, so fetch the next one along with this one
+    const std::size_t next = index + 1;
+    const bool prefetch = index == last_loaded_block + 1 && next * CACHE_BLOCK_SIZE < data_size &&
+                          find(next) == cache.end();
+    last_loaded_block = index;
+
+    CacheBlock& block = allocate(index);
+    if (!prefetch) {
+        load(block);
+        return block;
+    }
+
+    CacheBlock& next_block = allocate(next);
+    if (mapping.IsOpen()) {
+        load(block);
+        load(next_block);
+        return block;
+    }
+
+    // Without a mapping both blocks are read from the file at once
+    const std::array<FileUtil::IOFile::ReadRange, 2> ranges{{
+        {file_offset + index * CACHE_BLOCK_SIZE, block.data.data(), block_length(index)},
+        {file_offset + next * CACHE_BLOCK_SIZE, next_block.data.data(), block_length(next)},
+    }};
+    if (!file.ReadRanges(ranges.data(), ranges.size())) {
+        file.Clear();
+        load(block);
+        return block;
+    }
+    for (CacheBlock* const loaded : {&block, &next_block}) {
+        loaded->size = block_length(loaded->index);
+        if (is_encrypted) {
+            cipher->Process(crypto_offset + loaded->index * CACHE_BLOCK_SIZE, loaded->data.data(),
+                            loaded->data.data(), loaded->size);
+        }
+    }
+    return block;
+}
+
 } // namespace FileSys
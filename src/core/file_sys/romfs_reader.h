@@ -1,8 +1,13 @@
 #pragma once
 
 #include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "common/common_types.h"
 #include "common/file_util.h"
+#include "core/hw/aes/ctr.h"
 
 namespace FileSys {
 
@@ -18,7 +23,9 @@ public:
 };
 
 /**
- * A RomFS reader that directly reads the RomFS file.
+ * A RomFS reader that directly reads the RomFS file. Small reads are served from a cache of
+ * decrypted blocks, so that repeated reads of the same data neither hit the disk nor decrypt
+ * again.
  */
 class DirectRomFSReader : public RomFSReader {
 public:
@@ -29,7 +36,8 @@ public:
     DirectRomFSReader(FileUtil::IOFile&& file, std::size_t file_offset, std::size_t data_size,
                       const std::array<u8, 16>& key, const std::array<u8, 16>& ctr,
                       std::size_t crypto_offset)
-        : is_encrypted(true), file(std::move(file)), key(key), ctr(ctr), file_offset(file_offset),
+        : is_encrypted(true), file(std::move(file)),
+          cipher(std::make_unique<HW::AES::CTRCipher>(key, ctr)), file_offset(file_offset),
           crypto_offset(crypto_offset), data_size(data_size) {}
 
     ~DirectRomFSReader() override = default;
@@ -40,14 +48,59 @@ public:
 
     std::size_t ReadFile(std::size_t offset, std::size_t length, u8* buffer) override;
 
+    /**
+     * Maps the file into memory to read it without seeking and reading the file for each access.
+     * The file is kept as a fallback if the mapping fails.
+     * @param filename Path of the file this reader was created with
+     */
+    void MapFile(const std::string& filename);
+
+    /**
+     * Reads the RomFS from a decrypted copy at the given path, which is created if it doesn't
+     * exist yet. Readers of the same RomFS in other processes map the same copy, so its pages are
+     * shared through the OS file cache instead of being decrypted by every process.
+     * @returns false if the copy couldn't be used, the reader keeps decrypting in that case
+     */
+    bool UseDecryptedCopy(const std::string& copy_path);
+
 private:
+    /// Size of the blocks in the cache, reads at least this large bypass it
+    static constexpr std::size_t CACHE_BLOCK_SIZE = 0x10000;
+    /// Number of blocks in the cache
+    static constexpr std::size_t CACHE_NUM_BLOCKS = 32;
+
+    struct CacheBlock {
+        std::size_t index = 0;
+        std::size_t size = 0; ///< Number of valid bytes, 0 if the block is unused
+        u64 last_use = 0;
+        std::vector<u8> data;
+    };
+
+    /// Writes the decrypted RomFS to the given path through a temporary file
+    bool WriteDecryptedCopy(const std::string& copy_path);
+
+    /// Reads and decrypts a range of the RomFS without the cache
+    std::size_t ReadUncached(std::size_t offset, std::size_t length, u8* buffer);
+
+    /// Returns the cached block with the given index, loading it if necessary
+    const CacheBlock& GetBlock(std::size_t index);
+
     bool is_encrypted;
     FileUtil::IOFile file;
-    std::array<u8, 16> key;
-    std::array<u8, 16> ctr;
+    std::unique_ptr<HW::AES::CTRCipher> cipher;
     std::size_t file_offset;
     std::size_t crypto_offset;
     std::size_t data_size;
+
+    FileUtil::MappedFile mapping;
+
+    /// The reader is shared by all files opened from the RomFS, which can be read from the FS I/O
+    /// thread, so the cache and the file position are guarded by this
+    std::mutex mutex;
+    std::array<CacheBlock, CACHE_NUM_BLOCKS> cache;
+    u64 cache_tick = 0;
+    /// Index of the block that was loaded last, to detect sequential reads for prefetching
+    std::size_t last_loaded_block = 0;
 };
 
 } // namespace FileSys
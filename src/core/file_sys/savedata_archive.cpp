@@ -83,6 +83,10 @@ ResultVal<std::unique_ptr<FileBackend>> SaveDataArchive::OpenFile(const Path& pa
         break; // Expected 'success' case
     }
 
+    // Files opened from the archive must see the pending writes of the others
+    journal->CommitAll();
+    JournaledDiskFile::RecoverJournal(full_path);
+
     FileUtil::IOFile file(full_path, mode.write_flag ? "r+b" : "rb");
     if (!file.IsOpen()) {
         LOG_CRITICAL(Service_FS, "(unreachable) Unknown error opening {}", full_path);
@@ -90,10 +94,17 @@ ResultVal<std::unique_ptr<FileBackend>> SaveDataArchive::OpenFile(const Path& pa
     }
 
     std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<SaveDataDelayGenerator>();
-    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, std::move(delay_generator));
+    auto disk_file = std::make_unique<JournaledDiskFile>(
+        std::move(file), mode, std::move(delay_generator), full_path, journal);
     return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
 }
 
+ResultCode SaveDataArchive::Commit() const {
+    if (!journal->CommitAll())
+        return ERROR_INSUFFICIENT_SPACE;
+    return RESULT_SUCCESS;
+}
+
 ResultCode SaveDataArchive::DeleteFile(const Path& path) const {
     const PathParser path_parser(path);
 
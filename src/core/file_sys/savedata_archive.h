@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include "core/file_sys/archive_backend.h"
+#include "core/file_sys/disk_archive.h"
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/result.h"
@@ -35,9 +37,12 @@ public:
     ResultCode RenameDirectory(const Path& src_path, const Path& dest_path) const override;
     ResultVal<std::unique_ptr<DirectoryBackend>> OpenDirectory(const Path& path) const override;
     u64 GetFreeBytes() const override;
+    ResultCode Commit() const override;
 
 protected:
     std::string mount_point;
+    /// Files opened from this archive, which write back in batches
+    std::shared_ptr<ArchiveJournal> journal = std::make_shared<ArchiveJournal>();
 };
 
 } // namespace FileSys
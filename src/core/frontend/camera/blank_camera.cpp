@@ -23,9 +23,9 @@ void BlankCamera::SetFlip(Service::CAM::Flip) {}
 
 void BlankCamera::SetEffect(Service::CAM::Effect) {}
 
-std::vector<u16> BlankCamera::ReceiveFrame() {
+void BlankCamera::ReceiveFrame(std::vector<u16>& frame) {
     // Note: 0x80008000 stands for two black pixels in YUV422
-    return std::vector<u16>(width * height, output_rgb ? 0 : 0x8000);
+    frame.assign(width * height, output_rgb ? 0 : 0x8000);
 }
 
 bool BlankCamera::IsPreviewAvailable() {
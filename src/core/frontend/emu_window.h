@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <tuple>
 #include <utility>
 #include "common/common_types.h"
@@ -13,6 +15,42 @@
 namespace Frontend {
 
 struct Frame;
+
+/// When a frame was rendered
+struct FrameTimestamps {
+    u64 frame_number;                                ///< Guest frames before it, including repeats
+    std::chrono::microseconds emulated_time;         ///< Emulated time when it was rendered
+    std::chrono::steady_clock::time_point host_time; ///< Host time its drawing was submitted
+};
+
+/// A rendered frame shared with a FrameExporter, RGBA8 and bottom-up like any GL framebuffer
+struct ExportedFrame {
+    Frame* frame;               ///< Handed back to TextureMailbox::ReturnExportedFrame
+    u32 renderbuffer;           ///< GL name of the renderbuffer holding the frame
+    u32 width;                  ///< Width of the frame in pixels
+    u32 height;                 ///< Height of the frame in pixels
+    void* fence;                ///< GLsync signaled once it is drawn, deleted by the exporter
+    FrameTimestamps timestamps; ///< When it was rendered
+};
+
+/**
+ * Receives the rendered frames without reading them back, for video encoders and streaming that
+ * import them into their own API: NVENC registers the GL renderbuffer, an EGLImage of it exports a
+ * DMA-BUF or an AHardwareBuffer and WGL_NV_DX_interop shares it with D3D11.
+ *
+ * OnFrame is called on the render thread with the renderer's context current, which is the one
+ * to create the imports in. The frame isn't drawn into again until the exporter returns it to the
+ * mailbox, from any thread, so the exporter can keep it while its encoder reads it. It has to
+ * return every frame before the render window closes. Frames identical to the previous one aren't
+ * rendered, and so not exported, again; the timestamps of the next frame show the gap.
+ */
+class FrameExporter {
+public:
+    virtual ~FrameExporter() = default;
+
+    virtual void OnFrame(const ExportedFrame& frame) = 0;
+};
+
 /**
  * For smooth Vsync rendering, we want to always present the latest frame that the core generates,
  * but also make sure that rendering happens at the pace that the frontend dictates. This is a
@@ -43,6 +81,22 @@ public:
      */
     virtual void ReleaseRenderFrame(Frame* frame) = 0;
 
+    /**
+     * Render thread calls this after draw commands are done, before releasing the frame, to share
+     * it with the frame exporter if there is one. The exporter receives it once it is released.
+     */
+    virtual void ExportRenderFrame(Frame* frame, const FrameTimestamps& timestamps) = 0;
+
+    /**
+     * Sets the exporter that the following frames are shared with, nullptr stops the export
+     */
+    virtual void SetFrameExporter(std::shared_ptr<FrameExporter> exporter) = 0;
+
+    /**
+     * The frame exporter calls this when it no longer reads a frame
+     */
+    virtual void ReturnExportedFrame(Frame* frame) = 0;
+
     /**
      * Presentation thread calls this to get the latest frame available to present. If there is no
      * frame available after timeout, returns the previous frame. If there is no previous frame it
@@ -149,9 +203,11 @@ public:
 
     /**
      * Gets the framebuffer layout (width, height, and screen regions)
-     * @note This method is thread-safe
+     * @note This method is thread-safe, the renderer and the presentation read the layout while the
+     * GUI thread changes it
      */
-    const Layout::FramebufferLayout& GetFramebufferLayout() const {
+    Layout::FramebufferLayout GetFramebufferLayout() const {
+        std::lock_guard lock{layout_mutex};
         return framebuffer_layout;
     }
 
@@ -189,6 +245,7 @@ protected:
      * @note EmuWindow implementations will usually use this in window resize event handlers.
      */
     void NotifyFramebufferLayoutChanged(const Layout::FramebufferLayout& layout) {
+        std::lock_guard lock{layout_mutex};
         framebuffer_layout = layout;
     }
 
@@ -203,6 +260,7 @@ private:
     }
 
     Layout::FramebufferLayout framebuffer_layout; ///< Current framebuffer layout
+    mutable std::mutex layout_mutex;              ///< Guards the writes of the GUI thread
 
     WindowConfig config;        ///< Internal configuration (changes pending for being applied in
                                 /// ProcessConfigurationChanges)
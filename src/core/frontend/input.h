@@ -4,11 +4,13 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include "common/logging/log.h"
 #include "common/param_package.h"
 #include "common/vector_math.h"
@@ -108,6 +110,13 @@ using ButtonDevice = InputDevice<bool>;
  */
 using AnalogDevice = InputDevice<std::tuple<float, float>>;
 
+/// A motion status along with the time the device received it
+struct MotionSample {
+    std::chrono::steady_clock::time_point timestamp;
+    Common::Vec3<float> accel;
+    Common::Vec3<float> gyro;
+};
+
 /**
  * A motion device is an input device that returns a tuple of accelerometer state vector and
  * gyroscope state vector.
@@ -124,7 +133,17 @@ using AnalogDevice = InputDevice<std::tuple<float, float>>;
  *   Orientation is determined by right-hand rule.
  *   Units: deg/sec
  */
-using MotionDevice = InputDevice<std::tuple<Common::Vec3<float>, Common::Vec3<float>>>;
+class MotionDevice : public InputDevice<std::tuple<Common::Vec3<float>, Common::Vec3<float>>> {
+public:
+    /**
+     * Appends the samples received since the previous call to the vector, oldest first.
+     * @returns false if the device doesn't keep a history of samples, GetStatus has to be polled
+     *     instead then
+     */
+    virtual bool PopSamples(std::vector<MotionSample>& samples) {
+        return false;
+    }
+};
 
 /**
  * A touch device is an input device that returns a tuple of two floats and a bool. The floats are
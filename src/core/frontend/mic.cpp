@@ -29,8 +29,8 @@ void NullMic::AdjustSampleRate(u32 sample_rate) {
     parameters.sample_rate = sample_rate;
 }
 
-Samples NullMic::Read() {
-    return {};
+void NullMic::Read(Samples& samples) {
+    samples.clear();
 }
 
 StaticMic::StaticMic()
@@ -53,8 +53,9 @@ void StaticMic::StopSampling() {
 
 void StaticMic::AdjustSampleRate(u32 sample_rate) {}
 
-Samples StaticMic::Read() {
-    return (sample_size == 8) ? CACHE_8_BIT : CACHE_16_BIT;
+void StaticMic::Read(Samples& samples) {
+    const std::vector<u8>& cache = (sample_size == 8) ? CACHE_8_BIT : CACHE_16_BIT;
+    samples.assign(cache.begin(), cache.end());
 }
 
 } // namespace Frontend::Mic
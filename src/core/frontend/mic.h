@@ -45,8 +45,10 @@ public:
      * Called from the actual event timing at a constant period under a given sample rate.
      * When sampling is enabled this function is expected to return a buffer of 16 samples in ideal
      * conditions, but can be lax if the data is coming in from another source like a real mic.
+     * @param samples Buffer whose contents are replaced with the samples. Callers reuse it for
+     *     every read, so implementations should write into it in place rather than replace it.
      */
-    virtual Samples Read() = 0;
+    virtual void Read(Samples& samples) = 0;
 
     /**
      * Adjusts the Parameters. Implementations should update the parameters field in addition to
@@ -94,7 +96,7 @@ public:
 
     void AdjustSampleRate(u32 sample_rate) override;
 
-    Samples Read() override;
+    void Read(Samples& samples) override;
 };
 
 class StaticMic final : public Interface {
@@ -106,7 +108,7 @@ public:
     void StopSampling() override;
     void AdjustSampleRate(u32 sample_rate) override;
 
-    Samples Read() override;
+    void Read(Samples& samples) override;
 
 private:
     u16 sample_rate = 0;
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <bitset>
 #include <climits>
 #include <csignal>
 #include <cstdarg>
@@ -13,6 +14,7 @@
 #include <cstring>
 #include <map>
 #include <numeric>
+#include <string_view>
 #include <fcntl.h>
 #include <fmt/format.h>
 
@@ -68,10 +70,9 @@ constexpr u32 D0_REGISTER = 26;
 constexpr u32 FPSCR_REGISTER = 42;
 
 // For sample XML files see the GDB source /gdb/features
-// GDB also wants the l character at the start
 // This XML defines what the registers are for this specific ARM device
 constexpr char target_xml[] =
-    R"(l<?xml version="1.0"?>
+    R"(<?xml version="1.0"?>
 <!DOCTYPE target SYSTEM "gdb-target.dtd">
 <target version="1.0">
   <feature name="org.gnu.gdb.arm.core">
@@ -126,6 +127,12 @@ bool defer_start = false;
 u8 command_buffer[GDB_BUFFER_SIZE];
 u32 command_length;
 
+/// Data received from the gdb client that hasn't been read yet, so that a whole packet can be
+/// received with one recv call instead of one per byte
+u8 receive_buffer[GDB_BUFFER_SIZE];
+std::size_t receive_position = 0;
+std::size_t receive_size = 0;
+
 u32 latest_signal = 0;
 bool memory_break = false;
 
@@ -158,6 +165,13 @@ using BreakpointMap = std::map<VAddr, Breakpoint>;
 BreakpointMap breakpoints_execute;
 BreakpointMap breakpoints_read;
 BreakpointMap breakpoints_write;
+
+/// One bit for each page that contains breakpoints of the type. The interpreter checks for memory
+/// breakpoints on every access, which rejects the accesses to other pages with a single lookup.
+using BreakpointPages = std::bitset<Memory::PAGE_TABLE_NUM_ENTRIES>;
+BreakpointPages breakpoint_pages_execute;
+BreakpointPages breakpoint_pages_read;
+BreakpointPages breakpoint_pages_write;
 } // Anonymous namespace
 
 static Kernel::Thread* FindThreadById(int id) {
@@ -365,14 +379,19 @@ static u64 GdbHexToLong(const u8* src) {
 
 /// Read a byte from the gdb client.
 static u8 ReadByte() {
-    u8 c;
-    std::size_t received_size = recv(gdbserver_socket, reinterpret_cast<char*>(&c), 1, MSG_WAITALL);
-    if (received_size != 1) {
-        LOG_ERROR(Debug_GDBStub, "recv failed : {}", received_size);
-        Shutdown();
+    if (receive_position == receive_size) {
+        const int received_size = recv(gdbserver_socket, reinterpret_cast<char*>(receive_buffer),
+                                       sizeof(receive_buffer), 0);
+        if (received_size <= 0) {
+            LOG_ERROR(Debug_GDBStub, "recv failed : {}", received_size);
+            Shutdown();
+            return 0;
+        }
+        receive_position = 0;
+        receive_size = static_cast<std::size_t>(received_size);
     }
 
-    return c;
+    return receive_buffer[receive_position++];
 }
 
 /// Calculate the checksum of the current command buffer.
@@ -398,6 +417,40 @@ static BreakpointMap& GetBreakpointMap(BreakpointType type) {
     }
 }
 
+/**
+ * Get the page bitmap of breakpoints for a given breakpoint type.
+ *
+ * @param type Type of breakpoint map.
+ */
+static BreakpointPages& GetBreakpointPages(BreakpointType type) {
+    switch (type) {
+    case BreakpointType::Execute:
+        return breakpoint_pages_execute;
+    case BreakpointType::Read:
+        return breakpoint_pages_read;
+    case BreakpointType::Write:
+        return breakpoint_pages_write;
+    default:
+        return breakpoint_pages_read;
+    }
+}
+
+/**
+ * Update the bit of the page containing the address after a breakpoint of the type was added
+ * or removed there.
+ *
+ * @param type Type of breakpoint.
+ * @param addr Address of breakpoint.
+ */
+static void UpdateBreakpointPage(BreakpointType type, VAddr addr) {
+    const BreakpointMap& p = GetBreakpointMap(type);
+    const VAddr page_start = addr & ~(Memory::PAGE_SIZE - 1);
+    const auto next_breakpoint = p.lower_bound(page_start);
+    GetBreakpointPages(type)[addr >> Memory::PAGE_BITS] =
+        next_breakpoint != p.end() && (next_breakpoint->first >> Memory::PAGE_BITS) ==
+                                          (addr >> Memory::PAGE_BITS);
+}
+
 /**
  * Remove the breakpoint from the given address of the specified type.
  *
@@ -425,6 +478,7 @@ static void RemoveBreakpoint(BreakpointType type, VAddr addr) {
         }
     }
     p.erase(addr);
+    UpdateBreakpointPage(type, addr);
 }
 
 BreakpointAddress GetNextBreakpointFromAddress(VAddr addr, BreakpointType type) {
@@ -444,7 +498,7 @@ BreakpointAddress GetNextBreakpointFromAddress(VAddr addr, BreakpointType type)
 }
 
 bool CheckBreakpoint(VAddr addr, BreakpointType type) {
-    if (!IsConnected()) {
+    if (!IsConnected() || !GetBreakpointPages(type)[addr >> Memory::PAGE_BITS]) {
         return false;
     }
 
@@ -532,6 +586,35 @@ static void SendReply(const char* reply) {
     }
 }
 
+/**
+ * Reply to a qXfer read of an object with the part of it that was requested, which the query
+ * ends with as "offset,length".
+ *
+ * @param object Contents of the object.
+ * @param query Query that requests it.
+ */
+static void SendXferReply(std::string_view object, const char* query) {
+    const char* params = strrchr(query, ':');
+    const char* comma = params != nullptr ? strchr(params, ',') : nullptr;
+    if (comma == nullptr) {
+        return SendReply("E00");
+    }
+
+    const u32 offset = HexToInt(reinterpret_cast<const u8*>(params + 1), comma - params - 1);
+    const u32 length = HexToInt(reinterpret_cast<const u8*>(comma + 1), strlen(comma + 1));
+    if (offset >= object.size()) {
+        return SendReply("l");
+    }
+
+    // The reply starts with 'm' if there is more to read after it, and 'l' for the last part
+    const std::size_t max_length = sizeof(command_buffer) - 5;
+    const std::string_view part =
+        object.substr(offset, std::min<std::size_t>(length, max_length));
+    std::string reply(1, offset + part.size() < object.size() ? 'm' : 'l');
+    reply += part;
+    SendReply(reply.c_str());
+}
+
 /// Handle query command from gdb client.
 static void HandleQuery() {
     LOG_DEBUG(Debug_GDBStub, "gdb: query '{}'\n", command_buffer + 1);
@@ -542,10 +625,10 @@ static void HandleQuery() {
         SendReply("T0");
     } else if (strncmp(query, "Supported", strlen("Supported")) == 0) {
         // PacketSize needs to be large enough for target xml
-        SendReply("PacketSize=2000;qXfer:features:read+;qXfer:threads:read+");
+        SendReply("PacketSize=2000;qXfer:features:read+;qXfer:threads:read+;vContSupported+");
     } else if (strncmp(query, "Xfer:features:read:target.xml:",
                        strlen("Xfer:features:read:target.xml:")) == 0) {
-        SendReply(target_xml);
+        SendXferReply(target_xml, query);
     } else if (strncmp(query, "fThreadInfo", strlen("fThreadInfo")) == 0) {
         std::string val = "m";
         u32 num_cores = Core::GetNumCores();
@@ -562,7 +645,7 @@ static void HandleQuery() {
         SendReply("l");
     } else if (strncmp(query, "Xfer:threads:read", strlen("Xfer:threads:read")) == 0) {
         std::string buffer;
-        buffer += "l<?xml version=\"1.0\"?>";
+        buffer += "<?xml version=\"1.0\"?>";
         buffer += "<threads>";
         u32 num_cores = Core::GetNumCores();
         for (u32 i = 0; i < num_cores; ++i) {
@@ -574,7 +657,7 @@ static void HandleQuery() {
             }
         }
         buffer += "</threads>";
-        SendReply(buffer.c_str());
+        SendXferReply(buffer, query);
     } else {
         SendReply("");
     }
@@ -711,6 +794,10 @@ static bool IsDataAvailable() {
     t.tv_sec = 0;
     t.tv_usec = 0;
 
+    if (receive_position < receive_size) {
+        return true;
+    }
+
     if (select(gdbserver_socket + 1, &fd_socket, nullptr, nullptr, &t) < 0) {
         LOG_ERROR(Debug_GDBStub, "select failed");
         return false;
@@ -846,7 +933,7 @@ static void ReadMemory() {
     LOG_DEBUG(Debug_GDBStub, "gdb: addr: {:08x} len: {:08x}\n", addr, len);
 
     if (len * 2 > sizeof(reply)) {
-        SendReply("E01");
+        return SendReply("E01");
     }
 
     if (!Memory::IsValidVirtualAddress(*Core::System::GetInstance().Kernel().GetCurrentProcess(),
@@ -893,16 +980,21 @@ void Break(bool is_memory_break) {
     memory_break = is_memory_break;
 }
 
-/// Tell the CPU that it should perform a single step.
+/// Tell the CPU that it should perform a single step from the current PC.
+static void StartStep() {
+    step_loop = true;
+    halt_loop = true;
+    send_trap = true;
+    Core::GetRunningCore().ClearInstructionCache();
+}
+
+/// Tell the CPU that it should perform a single step, optionally from the given address.
 static void Step() {
     if (command_length > 1) {
         RegWrite(PC_REGISTER, GdbHexToInt(command_buffer + 1), current_thread);
         Core::GetRunningCore().LoadContext(current_thread->context);
     }
-    step_loop = true;
-    halt_loop = true;
-    send_trap = true;
-    Core::GetRunningCore().ClearInstructionCache();
+    StartStep();
 }
 
 bool IsMemoryBreak() {
@@ -921,6 +1013,29 @@ static void Continue() {
     Core::GetRunningCore().ClearInstructionCache();
 }
 
+/// Handle v command from gdb client, of which only vCont is supported.
+static void HandleVCommand() {
+    const char* command = reinterpret_cast<const char*>(command_buffer);
+    if (strcmp(command, "vCont?") == 0) {
+        SendReply("vCont;c;C;s;S");
+    } else if (strncmp(command, "vCont;", strlen("vCont;")) == 0) {
+        // All threads are resumed and stopped together, so the action of the first thread
+        // applies to every one of them. The stop reply is sent once the CPU halts again.
+        switch (command[strlen("vCont;")]) {
+        case 's':
+        case 'S':
+            return StartStep();
+        case 'c':
+        case 'C':
+            return Continue();
+        default:
+            return SendReply("E01");
+        }
+    } else {
+        SendReply("");
+    }
+}
+
 /**
  * Commit breakpoint to list of breakpoints.
  *
@@ -947,6 +1062,7 @@ static bool CommitBreakpoint(BreakpointType type, VAddr addr, u32 len) {
         Core::GetRunningCore().ClearInstructionCache();
     }
     p.insert({addr, breakpoint});
+    UpdateBreakpointPage(type, addr);
 
     LOG_DEBUG(Debug_GDBStub, "gdb: added {} breakpoint: {:08x} bytes at {:08x}\n",
               static_cast<int>(type), breakpoint.len, breakpoint.addr);
@@ -1109,6 +1225,9 @@ void HandlePacket() {
     case 'T':
         HandleThreadAlive();
         break;
+    case 'v':
+        HandleVCommand();
+        break;
     default:
         SendReply("");
         break;
@@ -1157,6 +1276,9 @@ static void Init(u16 port) {
     breakpoints_execute.clear();
     breakpoints_read.clear();
     breakpoints_write.clear();
+    breakpoint_pages_execute.reset();
+    breakpoint_pages_read.reset();
+    breakpoint_pages_write.reset();
 
     // Start gdb server
     LOG_INFO(Debug_GDBStub, "Starting GDB server on port {}...", port);
@@ -1231,6 +1353,8 @@ void Shutdown() {
         shutdown(gdbserver_socket, SHUT_RDWR);
         gdbserver_socket = -1;
     }
+    receive_position = 0;
+    receive_size = 0;
 
 #ifdef _WIN32
     WSACleanup();
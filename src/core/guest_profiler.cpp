@@ -0,0 +1,132 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <map>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/guest_profiler.h"
+#include "core/guest_symbols.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/thread.h"
+
+namespace Core {
+
+namespace {
+/// Names an address by its symbol, or by the address itself
+std::string GetLocationName(VAddr address) {
+    std::string name = GuestSymbols::Lookup(address);
+    if (name.empty()) {
+        name = fmt::format("{:#010x}", address);
+    }
+    // Semicolons separate the frames of a collapsed stack
+    std::replace(name.begin(), name.end(), ';', ':');
+    return name;
+}
+} // Anonymous namespace
+
+GuestProfiler::GuestProfiler(System& system) : system(system) {
+    sample_event = system.CoreTiming().RegisterEvent(
+        "GuestProfiler::Sample",
+        [this](u64 /*userdata*/, int cycles_late) { Sample(cycles_late); });
+}
+
+GuestProfiler::~GuestProfiler() = default;
+
+void GuestProfiler::Start(u32 samples_per_second) {
+    requested_rate.store(std::max<u32>(samples_per_second, 1), std::memory_order_relaxed);
+}
+
+void GuestProfiler::Stop() {
+    requested_rate.store(0, std::memory_order_relaxed);
+}
+
+bool GuestProfiler::IsRunning() const {
+    return requested_rate.load(std::memory_order_relaxed) != 0;
+}
+
+void GuestProfiler::OnFrame() {
+    rate = requested_rate.load(std::memory_order_relaxed);
+    if (rate != 0 && !event_pending) {
+        event_pending = true;
+        system.CoreTiming().ScheduleEvent(BASE_CLOCK_RATE_ARM11 / rate, sample_event);
+    }
+}
+
+void GuestProfiler::Sample(int cycles_late) {
+    event_pending = false;
+
+    {
+        std::lock_guard lock{mutex};
+        Kernel::KernelSystem& kernel = system.Kernel();
+        for (u32 core_id = 0; core_id < system.GetNumCores(); ++core_id) {
+            const Kernel::Thread* thread = kernel.GetThreadManager(core_id).GetCurrentThread();
+            if (thread == nullptr)
+                continue;
+
+            const Kernel::Process* process = thread->owner_process;
+            const u32 process_id = process ? process->process_id : 0;
+            if (process && process_names.count(process_id) == 0) {
+                process_names.emplace(process_id, process->GetName());
+            }
+            if (thread_names.count(thread->GetThreadId()) == 0) {
+                thread_names.emplace(thread->GetThreadId(), thread->GetName());
+            }
+
+            ARM_Interface& core = system.GetCore(core_id);
+            ++samples[{process_id, thread->GetThreadId(), core.GetPC(), core.GetReg(14)}];
+        }
+    }
+
+    if (rate != 0) {
+        event_pending = true;
+        system.CoreTiming().ScheduleEvent(BASE_CLOCK_RATE_ARM11 / rate - cycles_late,
+                                          sample_event);
+    }
+}
+
+bool GuestProfiler::WriteCollapsedStacks(const std::string& path) const {
+    // Samples of the same functions are merged, std::map also sorts the stacks for flamegraph.pl
+    std::map<std::string, u64> stacks;
+    {
+        std::lock_guard lock{mutex};
+        for (const auto& [key, count] : samples) {
+            const auto process_it = process_names.find(key.process_id);
+            const auto thread_it = thread_names.find(key.thread_id);
+            const std::string stack = fmt::format(
+                "{}({});{}({});{};{}",
+                process_it != process_names.end() ? process_it->second : "kernel", key.process_id,
+                thread_it != thread_names.end() ? thread_it->second : "thread", key.thread_id,
+                GetLocationName(key.lr & ~1u), GetLocationName(key.pc));
+            stacks[stack] += count;
+        }
+    }
+
+    FileUtil::IOFile file(path, "w");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Core, "Could not open profile file {}", path);
+        return false;
+    }
+    for (const auto& [stack, count] : stacks) {
+        const std::string line = fmt::format("{} {}\n", stack, count);
+        if (file.WriteString(line) != line.size()) {
+            LOG_ERROR(Core, "Could not write profile file {}", path);
+            return false;
+        }
+    }
+    return true;
+}
+
+void GuestProfiler::Clear() {
+    std::lock_guard lock{mutex};
+    samples.clear();
+    process_names.clear();
+    thread_names.clear();
+}
+
+} // namespace Core
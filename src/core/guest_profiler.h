@@ -0,0 +1,82 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "common/common_types.h"
+
+namespace Core {
+
+class System;
+struct TimingEventType;
+
+/**
+ * Sampling profiler of the guest code. A timing event records the PC and the LR of every core
+ * together with its current thread at a fixed rate of emulated time. The samples are named with
+ * the guest symbols and written as collapsed stacks, the input format of flame graph tools. Only
+ * the caller in LR is known as the guest code has no frame pointers to unwind the stack with.
+ */
+class GuestProfiler : NonCopyable {
+public:
+    explicit GuestProfiler(System& system);
+    ~GuestProfiler();
+
+    /// Starts or stops sampling at the end of the current frame, may be called from any thread
+    void Start(u32 samples_per_second = 1000);
+    void Stop();
+
+    bool IsRunning() const;
+
+    /// Called by the emulation thread at the end of each frame
+    void OnFrame();
+
+    /// Writes one "process;thread;caller;function count" line per sampled location
+    bool WriteCollapsedStacks(const std::string& path) const;
+
+    void Clear();
+
+private:
+    struct SampleKey {
+        u32 process_id;
+        u32 thread_id;
+        VAddr pc;
+        VAddr lr;
+
+        bool operator==(const SampleKey& other) const {
+            return process_id == other.process_id && thread_id == other.thread_id &&
+                   pc == other.pc && lr == other.lr;
+        }
+    };
+
+    struct SampleKeyHash {
+        std::size_t operator()(const SampleKey& key) const {
+            u64 hash = (u64{key.process_id} << 32 | key.thread_id) * 0x9E3779B97F4A7C15;
+            hash ^= (u64{key.pc} << 32 | key.lr) + 0x7F4A7C159E3779B9 + (hash << 6);
+            return static_cast<std::size_t>(hash);
+        }
+    };
+
+    void Sample(int cycles_late);
+
+    System& system;
+    TimingEventType* sample_event;
+
+    /// Samples per second requested by Start, 0 if stopped
+    std::atomic<u32> requested_rate{0};
+    /// The rate the emulation thread currently samples at
+    u32 rate = 0;
+    bool event_pending = false;
+
+    mutable std::mutex mutex;
+    std::unordered_map<SampleKey, u64, SampleKeyHash> samples;
+    std::unordered_map<u32, std::string> process_names;
+    std::unordered_map<u32, std::string> thread_names;
+};
+
+} // namespace Core
@@ -0,0 +1,66 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <mutex>
+#include <fmt/format.h>
+#include "core/guest_symbols.h"
+
+namespace Core::GuestSymbols {
+
+namespace {
+struct Module {
+    std::string name;
+    VAddr start;
+    VAddr end;
+    /// Sorted by address
+    std::vector<Symbol> symbols;
+};
+
+std::mutex mutex;
+std::vector<Module> modules;
+} // Anonymous namespace
+
+void AddModule(const std::string& module, VAddr start, VAddr end, std::vector<Symbol> symbols) {
+    std::sort(symbols.begin(), symbols.end(),
+              [](const Symbol& a, const Symbol& b) { return a.address < b.address; });
+
+    std::lock_guard lock{mutex};
+    modules.erase(std::remove_if(modules.begin(), modules.end(),
+                                 [&module](const Module& m) { return m.name == module; }),
+                  modules.end());
+    modules.push_back({module, start, end, std::move(symbols)});
+}
+
+void RemoveModule(const std::string& module) {
+    std::lock_guard lock{mutex};
+    modules.erase(std::remove_if(modules.begin(), modules.end(),
+                                 [&module](const Module& m) { return m.name == module; }),
+                  modules.end());
+}
+
+void Clear() {
+    std::lock_guard lock{mutex};
+    modules.clear();
+}
+
+std::string Lookup(VAddr address) {
+    std::lock_guard lock{mutex};
+    for (const Module& module : modules) {
+        if (address < module.start || address >= module.end)
+            continue;
+
+        auto it = std::upper_bound(module.symbols.begin(), module.symbols.end(), address,
+                                   [](VAddr addr, const Symbol& s) { return addr < s.address; });
+        if (it != module.symbols.begin()) {
+            const Symbol& symbol = *std::prev(it);
+            if (symbol.size == 0 || address < symbol.address + symbol.size)
+                return fmt::format("{}!{}", module.name, symbol.name);
+        }
+        return fmt::format("{}+{:#x}", module.name, address - module.start);
+    }
+    return {};
+}
+
+} // namespace Core::GuestSymbols
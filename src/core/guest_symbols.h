@@ -0,0 +1,38 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Symbols of the guest code, registered by the loaders and by LDR:RO for the CROs. Used to name
+ * the functions of profiler samples. The address spaces of the processes aren't told apart, as
+ * only the application is expected to have symbols.
+ */
+namespace Core::GuestSymbols {
+
+struct Symbol {
+    VAddr address;
+    /// Size of the function, 0 if unknown, in which case it ends at the next symbol
+    u32 size;
+    std::string name;
+};
+
+/// Adds the symbols of a module covering [start, end), replacing any module of the same name
+void AddModule(const std::string& module, VAddr start, VAddr end, std::vector<Symbol> symbols);
+
+void RemoveModule(const std::string& module);
+
+void Clear();
+
+/**
+ * Returns "module!symbol" for an address inside a known function, "module+offset" for other
+ * addresses of a module and an empty string for addresses outside of all modules.
+ */
+std::string Lookup(VAddr address);
+
+} // namespace Core::GuestSymbols
@@ -0,0 +1,162 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <fmt/format.h>
+#include "core/hle/cost_accounting.h"
+
+namespace HLE::CostAccounting {
+
+namespace {
+/// Each power of two of the call time is split into this many histogram buckets
+constexpr u32 SUB_BUCKET_BITS = 2;
+constexpr std::size_t NUM_BUCKETS = 64 << SUB_BUCKET_BITS;
+constexpr std::size_t NUM_SVCS = 0x80;
+
+struct Accumulator {
+    std::string name;
+    u64 count = 0;
+    u64 total_ns = 0;
+    u64 max_ns = 0;
+    std::array<u32, NUM_BUCKETS> buckets{};
+
+    void Add(u64 time_ns) {
+        ++count;
+        total_ns += time_ns;
+        max_ns = std::max(max_ns, time_ns);
+        ++buckets[GetBucket(time_ns)];
+    }
+
+    static std::size_t GetBucket(u64 time_ns) {
+        if (time_ns < (1 << SUB_BUCKET_BITS))
+            return static_cast<std::size_t>(time_ns);
+        u32 log2 = 0;
+        for (u64 value = time_ns; value > 1; value >>= 1) {
+            ++log2;
+        }
+        const u64 sub_bucket = (time_ns >> (log2 - SUB_BUCKET_BITS)) & ((1 << SUB_BUCKET_BITS) - 1);
+        return ((log2 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + sub_bucket;
+    }
+
+    /// Returns the upper bound of the times in the bucket
+    static u64 GetBucketLimit(std::size_t bucket) {
+        if (bucket < (1 << SUB_BUCKET_BITS))
+            return bucket;
+        const u32 log2 = static_cast<u32>(bucket >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+        const u64 sub_bucket = bucket & ((1 << SUB_BUCKET_BITS) - 1);
+        return (((1 << SUB_BUCKET_BITS) + sub_bucket + 1) << (log2 - SUB_BUCKET_BITS)) - 1;
+    }
+
+    u64 GetPercentile(u64 percent) const {
+        const u64 target = (count * percent + 99) / 100;
+        u64 seen = 0;
+        for (std::size_t i = 0; i < NUM_BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen >= target)
+                return std::min(GetBucketLimit(i), max_ns);
+        }
+        return max_ns;
+    }
+
+    Entry ToEntry() const {
+        return {name,
+                count,
+                total_ns,
+                GetPercentile(50),
+                GetPercentile(90),
+                GetPercentile(99),
+                max_ns};
+    }
+};
+
+std::mutex mutex;
+std::unordered_map<const void*, Accumulator> service_costs;
+std::array<Accumulator, NUM_SVCS> svc_costs;
+
+std::vector<Entry> SortedEntries(std::vector<Entry> entries) {
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.total_ns > b.total_ns; });
+    return entries;
+}
+
+void FormatEntries(std::string& out, const char* title, const std::vector<Entry>& entries,
+                   std::size_t max_entries) {
+    fmt::format_to(std::back_inserter(out), "{:<48} {:>10} {:>12} {:>10} {:>10} {:>10} {:>10}\n",
+                   title, "calls", "total us", "p50 us", "p90 us", "p99 us", "max us");
+    for (std::size_t i = 0; i < std::min(entries.size(), max_entries); ++i) {
+        const Entry& entry = entries[i];
+        fmt::format_to(std::back_inserter(out),
+                       "{:<48} {:>10} {:>12.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n",
+                       entry.name, entry.count, entry.total_ns / 1000.0, entry.p50_ns / 1000.0,
+                       entry.p90_ns / 1000.0, entry.p99_ns / 1000.0, entry.max_ns / 1000.0);
+    }
+}
+} // Anonymous namespace
+
+void AddServiceCall(const void* function_info, const std::string& service_name,
+                    const char* function_name, u64 time_ns) {
+    std::lock_guard lock{mutex};
+    Accumulator& accumulator = service_costs[function_info];
+    if (accumulator.count == 0) {
+        accumulator.name = fmt::format("{}::{}", service_name, function_name);
+    }
+    accumulator.Add(time_ns);
+}
+
+void AddSVCCall(u32 immediate, const char* name, u64 time_ns) {
+    if (immediate >= NUM_SVCS)
+        return;
+
+    std::lock_guard lock{mutex};
+    Accumulator& accumulator = svc_costs[immediate];
+    if (accumulator.count == 0) {
+        accumulator.name = name;
+    }
+    accumulator.Add(time_ns);
+}
+
+std::vector<Entry> GetServiceCosts() {
+    std::vector<Entry> entries;
+    {
+        std::lock_guard lock{mutex};
+        entries.reserve(service_costs.size());
+        for (const auto& [info, accumulator] : service_costs) {
+            entries.push_back(accumulator.ToEntry());
+        }
+    }
+    return SortedEntries(std::move(entries));
+}
+
+std::vector<Entry> GetSVCCosts() {
+    std::vector<Entry> entries;
+    {
+        std::lock_guard lock{mutex};
+        for (const Accumulator& accumulator : svc_costs) {
+            if (accumulator.count != 0) {
+                entries.push_back(accumulator.ToEntry());
+            }
+        }
+    }
+    return SortedEntries(std::move(entries));
+}
+
+std::string FormatReport(std::size_t max_entries) {
+    std::string out;
+    FormatEntries(out, "Service command", GetServiceCosts(), max_entries);
+    out += '\n';
+    FormatEntries(out, "SVC", GetSVCCosts(), max_entries);
+    return out;
+}
+
+void Clear() {
+    std::lock_guard lock{mutex};
+    service_costs.clear();
+    svc_costs = {};
+}
+
+} // namespace HLE::CostAccounting
@@ -0,0 +1,52 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Accounts the host time spent in the HLE service commands and the SVCs, to find the hot spots of
+ * the HLE. The time of a service command is included in the time of the SVC that sent it.
+ */
+namespace HLE::CostAccounting {
+
+/// Accumulated cost of a service command or an SVC
+struct Entry {
+    std::string name;
+    u64 count = 0;
+    u64 total_ns = 0;
+    /// Percentiles of the host time of a single call, estimated from a logarithmic histogram
+    u64 p50_ns = 0;
+    u64 p90_ns = 0;
+    u64 p99_ns = 0;
+    u64 max_ns = 0;
+};
+
+/**
+ * Adds a call of a service command. The function info is only used to tell the commands apart,
+ * the names are copied on the first call.
+ */
+void AddServiceCall(const void* function_info, const std::string& service_name,
+                    const char* function_name, u64 time_ns);
+
+/// Adds a call of the SVC with the given immediate
+void AddSVCCall(u32 immediate, const char* name, u64 time_ns);
+
+/// Returns the accounted service commands, most expensive first
+std::vector<Entry> GetServiceCosts();
+
+/// Returns the accounted SVCs, most expensive first
+std::vector<Entry> GetSVCCosts();
+
+/// Formats the accounted costs as a text table, which lists at most max_entries of each kind
+std::string FormatReport(std::size_t max_entries = SIZE_MAX);
+
+/// Clears the accounted costs
+void Clear();
+
+} // namespace HLE::CostAccounting
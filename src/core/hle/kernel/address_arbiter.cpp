@@ -19,52 +19,57 @@ namespace Kernel {
 void AddressArbiter::WaitThread(std::shared_ptr<Thread> thread, VAddr wait_address) {
     thread->wait_address = wait_address;
     thread->status = ThreadStatus::WaitArb;
-    waiting_threads.emplace_back(std::move(thread));
+    waiting_threads[wait_address].emplace_back(std::move(thread));
 }
 
 void AddressArbiter::ResumeAllThreads(VAddr address) {
-    // Determine which threads are waiting on this address, those should be woken up.
-    auto itr = std::stable_partition(waiting_threads.begin(), waiting_threads.end(),
-                                     [address](const auto& thread) {
-                                         ASSERT_MSG(thread->status == ThreadStatus::WaitArb,
-                                                    "Inconsistent AddressArbiter state");
-                                         return thread->wait_address != address;
-                                     });
-
-    // Wake up all the found threads
-    std::for_each(itr, waiting_threads.end(), [](auto& thread) { thread->ResumeFromWait(); });
-
-    // Remove the woken up threads from the wait list.
-    waiting_threads.erase(itr, waiting_threads.end());
+    const auto it = waiting_threads.find(address);
+    if (it == waiting_threads.end())
+        return;
+
+    const auto threads = std::move(it->second);
+    waiting_threads.erase(it);
+    for (const auto& thread : threads) {
+        ASSERT_MSG(thread->status == ThreadStatus::WaitArb, "Inconsistent AddressArbiter state");
+        thread->ResumeFromWait();
+    }
 }
 
 std::shared_ptr<Thread> AddressArbiter::ResumeHighestPriorityThread(VAddr address) {
-    // Determine which threads are waiting on this address, those should be considered for wakeup.
-    auto matches_start = std::stable_partition(
-        waiting_threads.begin(), waiting_threads.end(), [address](const auto& thread) {
-            ASSERT_MSG(thread->status == ThreadStatus::WaitArb,
-                       "Inconsistent AddressArbiter state");
-            return thread->wait_address != address;
-        });
+    const auto it = waiting_threads.find(address);
+    if (it == waiting_threads.end())
+        return nullptr;
+    auto& threads = it->second;
 
     // Iterate through threads, find highest priority thread that is waiting to be arbitrated.
     // Note: The real kernel will pick the first thread in the list if more than one have the
-    // same highest priority value. Lower priority values mean higher priority.
-    auto itr = std::min_element(matches_start, waiting_threads.end(),
+    // same highest priority value. Lower priority values mean higher priority. The list isn't
+    // kept sorted since the priority of a waiting thread can still change.
+    auto itr = std::min_element(threads.begin(), threads.end(),
                                 [](const auto& lhs, const auto& rhs) {
                                     return lhs->current_priority < rhs->current_priority;
                                 });
 
-    if (itr == waiting_threads.end())
-        return nullptr;
-
     auto thread = *itr;
+    ASSERT_MSG(thread->status == ThreadStatus::WaitArb, "Inconsistent AddressArbiter state");
     thread->ResumeFromWait();
 
-    waiting_threads.erase(itr);
+    threads.erase(itr);
+    if (threads.empty())
+        waiting_threads.erase(it);
     return thread;
 }
 
+void AddressArbiter::RemoveWaitingThread(const std::shared_ptr<Thread>& thread, VAddr address) {
+    const auto it = waiting_threads.find(address);
+    if (it == waiting_threads.end())
+        return;
+    auto& threads = it->second;
+    threads.erase(std::remove(threads.begin(), threads.end(), thread), threads.end());
+    if (threads.empty())
+        waiting_threads.erase(it);
+}
+
 AddressArbiter::AddressArbiter(KernelSystem& kernel) : Object(kernel), kernel(kernel) {}
 AddressArbiter::~AddressArbiter() {}
 
@@ -79,12 +84,12 @@ std::shared_ptr<AddressArbiter> KernelSystem::CreateAddressArbiter(std::string n
 ResultCode AddressArbiter::ArbitrateAddress(std::shared_ptr<Thread> thread, ArbitrationType type,
                                             VAddr address, s32 value, u64 nanoseconds) {
 
-    auto timeout_callback = [this](ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
-                                   std::shared_ptr<WaitObject> object) {
+    auto timeout_callback = [this, address](ThreadWakeupReason reason,
+                                            std::shared_ptr<Thread> thread,
+                                            std::shared_ptr<WaitObject> object) {
         ASSERT(reason == ThreadWakeupReason::Timeout);
         // Remove the newly-awakened thread from the Arbiter's waiting list.
-        waiting_threads.erase(std::remove(waiting_threads.begin(), waiting_threads.end(), thread),
-                              waiting_threads.end());
+        RemoveWaitingThread(thread, address);
     };
 
     switch (type) {
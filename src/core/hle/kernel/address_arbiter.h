@@ -5,6 +5,7 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
@@ -65,8 +66,12 @@ private:
     /// the resumed thread.
     std::shared_ptr<Thread> ResumeHighestPriorityThread(VAddr address);
 
-    /// Threads waiting for the address arbiter to be signaled.
-    std::vector<std::shared_ptr<Thread>> waiting_threads;
+    /// Removes a thread that timed out from the threads waiting on the address
+    void RemoveWaitingThread(const std::shared_ptr<Thread>& thread, VAddr address);
+
+    /// Threads waiting for the address arbiter to be signaled, by address in the order they
+    /// started waiting. Signals only look at the threads waiting on their address.
+    std::unordered_map<VAddr, std::vector<std::shared_ptr<Thread>>> waiting_threads;
 };
 
 } // namespace Kernel
@@ -30,12 +30,12 @@ enum KernelHandle : Handle {
  *
  * To prevent accidental use of a freed Handle whose slot has already been reused, a global counter
  * is kept and incremented every time a Handle is created. This is the Handle's "generation". The
- * value of the counter is stored into the Handle as well as in the handle table (in the
- * "generations" array). When looking up a handle, the Handle's generation must match with the
+ * value of the counter is stored into the Handle as well as in the handle table (next to the
+ * object in its slot). When looking up a handle, the Handle's generation must match with the
  * value stored on the class, otherwise the Handle is considered invalid.
  *
- * To find free slots when allocating a Handle without needing to scan the entire object array, the
- * generations field of unallocated slots is re-purposed as a linked list of indices to free slots.
+ * To find free slots when allocating a Handle without needing to scan the entire slot array, the
+ * generation field of unallocated slots is re-purposed as a linked list of indices to free slots.
  * When a Handle is created, an index is popped off the list and used for the new Handle. When it
  * is destroyed, it is again pushed onto the list to be re-used by the next allocation. It is
  * likely that this allocation strategy differs from the one used in CTR-OS, but this hasn't been
@@ -87,6 +87,23 @@ public:
         return DynamicObjectCast<T>(GetGeneric(handle));
     }
 
+    /**
+     * Looks up a handle without taking a reference to the object. The pointer is only valid until
+     * the handle is closed, so it must not be stored. Use `GetGeneric()` for that instead.
+     * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid.
+     */
+    Object* GetGenericBorrowed(Handle handle) const;
+
+    /**
+     * Looks up a handle while verifying its type, without taking a reference to the object.
+     * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid or its
+     *         type differs from the requested one.
+     */
+    template <class T>
+    T* GetBorrowed(Handle handle) const {
+        return DynamicObjectCast<T>(GetGenericBorrowed(handle));
+    }
+
     /// Closes all handles held in this table.
     void Clear();
 
@@ -97,14 +114,19 @@ private:
      */
     static const std::size_t MAX_COUNT = 4096;
 
-    /// Stores the Object referenced by the handle or null if the slot is empty.
-    std::array<std::shared_ptr<Object>, MAX_COUNT> objects;
+    struct Slot {
+        /// Stores the Object referenced by the handle or null if the slot is empty.
+        std::shared_ptr<Object> object;
 
-    /**
-     * The value of `next_generation` when the handle was created, used to check for validity. For
-     * empty slots, contains the index of the next free slot in the list.
-     */
-    std::array<u16, MAX_COUNT> generations;
+        /**
+         * The value of `next_generation` when the handle was created, used to check for validity.
+         * For empty slots, contains the index of the next free slot in the list.
+         */
+        u16 generation;
+    };
+
+    /// The slots of the handles, keeping each object next to its generation for the lookups.
+    std::array<Slot, MAX_COUNT> slots;
 
     /**
      * Global counter of the number of created handles. Stored in `generations` when a handle is
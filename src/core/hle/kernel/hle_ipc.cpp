@@ -59,8 +59,7 @@ std::shared_ptr<Event> HLERequestContext::SleepClientThread(const std::string& r
 
     auto event = kernel.CreateEvent(Kernel::ResetType::OneShot, "HLE Pause Event: " + reason);
     thread->status = ThreadStatus::WaitHleEvent;
-    thread->wait_objects = {event};
-    event->AddWaitingThread(SharedFrom(thread));
+    thread->SetWaitObject(event);
 
     if (timeout.count() > 0)
         thread->WakeAfterDelay(timeout.count());
@@ -251,6 +250,9 @@ ResultCode HLERequestContext::WriteToOutgoingCommandBuffer(u32_le* dst_cmdbuf,
         kernel.GetIPCRecorder().SetReplyInfo(SharedFrom(thread), std::move(untranslated_cmdbuf),
                                              std::move(translated_cmdbuf));
     }
+    if (kernel.GetIPCRecorder().IsCapturing()) {
+        kernel.GetIPCRecorder().CaptureReply(*thread, dst_cmdbuf);
+    }
 
     return RESULT_SUCCESS;
 }
@@ -286,4 +288,18 @@ void MappedBuffer::Write(const void* src_buffer, std::size_t offset, std::size_t
     memory->WriteBlock(*process, address + static_cast<VAddr>(offset), src_buffer, size);
 }
 
+const u8* MappedBuffer::GetReadPointer(std::size_t offset, std::size_t size) {
+    ASSERT(perms & IPC::R);
+    ASSERT(offset + size <= this->size);
+    return memory->GetContiguousPointer(*process, address + static_cast<VAddr>(offset), size,
+                                        false);
+}
+
+u8* MappedBuffer::GetWritePointer(std::size_t offset, std::size_t size) {
+    ASSERT(perms & IPC::W);
+    ASSERT(offset + size <= this->size);
+    return memory->GetContiguousPointer(*process, address + static_cast<VAddr>(offset), size,
+                                        true);
+}
+
 } // namespace Kernel
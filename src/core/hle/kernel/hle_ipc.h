@@ -104,6 +104,15 @@ public:
     // interface for service
     void Read(void* dest_buffer, std::size_t offset, std::size_t size);
     void Write(const void* src_buffer, std::size_t offset, std::size_t size);
+
+    /**
+     * Gets a pointer to a range of the buffer if it can be accessed directly in host memory,
+     * letting services read or write it without an intermediate copy. It is only valid for the
+     * duration of the request. Returns nullptr if Read/Write have to be used instead.
+     */
+    const u8* GetReadPointer(std::size_t offset, std::size_t size);
+    u8* GetWritePointer(std::size_t offset, std::size_t size);
+
     std::size_t GetSize() const {
         return size;
     }
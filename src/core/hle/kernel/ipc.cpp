@@ -237,6 +237,9 @@ ResultCode TranslateCommandBuffer(Kernel::KernelSystem& kernel, Memory::MemorySy
                                                    std::move(translated_cmdbuf), dst_thread);
         }
     }
+    if (reply && kernel.GetIPCRecorder().IsCapturing()) {
+        kernel.GetIPCRecorder().CaptureReply(*dst_thread, cmd_buf.data());
+    }
 
     memory.WriteBlock(*dst_process, dst_address, cmd_buf.data(), command_size * sizeof(u32));
 
@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include "common/assert.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/client_session.h"
@@ -37,6 +39,19 @@ ObjectInfo GetObjectInfo(const Kernel::Process* process) {
     }
     return {process->GetTypeName(), process->GetName(), static_cast<int>(process->process_id)};
 }
+/// Identifies capture files, followed by the format version
+constexpr u32 CAPTURE_MAGIC = 0x43504943; // "CIPC"
+constexpr u32 CAPTURE_VERSION = 1;
+
+std::string GetFunctionName(const Kernel::ClientSession& client_session, u32 request_header) {
+    if (client_session.parent->port == nullptr)
+        return {};
+    const auto& handler = client_session.parent->port->GetServerPort()->hle_handler;
+    if (handler == nullptr)
+        return {};
+    return std::dynamic_pointer_cast<Service::ServiceFrameworkBase>(handler)->GetFunctionName(
+        request_header);
+}
 } // namespace
 
 Recorder::Recorder() = default;
@@ -162,4 +177,175 @@ void Recorder::SetEnabled(bool enabled_) {
     enabled.store(enabled_, std::memory_order_relaxed);
 }
 
+void Recorder::StartCapture(CaptureConfig config) {
+    std::lock_guard lock{capture_mutex};
+    capture_config = std::move(config);
+    capture_config.capacity = std::max<std::size_t>(capture_config.capacity, 1);
+    capture_config.sample_interval = std::max<u32>(capture_config.sample_interval, 1);
+    capture_start = Clock::now();
+    capture_request_count = 0;
+    capture_ring.clear();
+    capture_ring.reserve(capture_config.capacity);
+    capture_next = 0;
+    capture_ports.clear();
+    pending_captures.clear();
+    latency_histograms.clear();
+    capturing.store(true, std::memory_order_relaxed);
+}
+
+void Recorder::StopCapture() {
+    std::lock_guard lock{capture_mutex};
+    capturing.store(false, std::memory_order_relaxed);
+    pending_captures.clear();
+}
+
+void Recorder::CaptureRequest(const Kernel::ClientSession& client_session,
+                              const Kernel::Thread& client_thread, u32 request_header) {
+    const Clock::time_point now = Clock::now();
+    const auto& port = client_session.parent->port;
+    const u32 port_id = port ? port->GetObjectId() : 0;
+
+    std::lock_guard lock{capture_mutex};
+    if (!IsCapturing())
+        return;
+
+    // The filter is only evaluated the first time a port is seen
+    auto port_it = capture_ports.find(port_id);
+    if (port_it == capture_ports.end()) {
+        CapturePort info;
+        info.name = port ? port->GetName() : "";
+        info.captured = capture_config.services.empty() ||
+                        capture_config.services.count(info.name) != 0;
+        port_it = capture_ports.emplace(port_id, std::move(info)).first;
+    }
+    if (!port_it->second.captured)
+        return;
+
+    const u64 key = (u64{port_id} << 32) | request_header;
+    if (latency_histograms.count(key) == 0) {
+        LatencyHistogram& histogram = latency_histograms[key];
+        histogram.service = port_it->second.name;
+        histogram.function = GetFunctionName(client_session, request_header);
+        histogram.request_header = request_header;
+    }
+
+    const bool sampled = capture_request_count++ % capture_config.sample_interval == 0;
+    const u32 process_id = client_thread.owner_process ? client_thread.owner_process->process_id
+                                                       : 0;
+    pending_captures.insert_or_assign(client_thread.GetThreadId(),
+                                      PendingCapture{now, request_header, port_id, process_id,
+                                                     sampled});
+}
+
+void Recorder::CaptureReply(const Kernel::Thread& client_thread, const u32* reply_cmdbuf) {
+    const Clock::time_point now = Clock::now();
+
+    std::lock_guard lock{capture_mutex};
+    const auto pending_it = pending_captures.find(client_thread.GetThreadId());
+    if (pending_it == pending_captures.end())
+        return;
+    const PendingCapture pending = pending_it->second;
+    pending_captures.erase(pending_it);
+
+    const u64 latency_ns = static_cast<u64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - pending.start).count());
+
+    LatencyHistogram& histogram =
+        latency_histograms[(u64{pending.port_id} << 32) | pending.request_header];
+    ++histogram.count;
+    histogram.total_ns += latency_ns;
+    histogram.max_ns = std::max(histogram.max_ns, latency_ns);
+    std::size_t bucket = 0;
+    for (u64 latency_us = latency_ns / 1000; latency_us > 1; latency_us >>= 1) {
+        ++bucket;
+    }
+    ++histogram.buckets[std::min(bucket, LatencyHistogram::NUM_BUCKETS - 1)];
+
+    if (!pending.sampled)
+        return;
+
+    const CaptureEntry entry{
+        static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             pending.start - capture_start)
+                             .count()),
+        static_cast<u32>(std::min<u64>(latency_ns, UINT32_MAX)),
+        pending.request_header,
+        reply_cmdbuf[1],
+        pending.port_id,
+        pending.process_id,
+        client_thread.GetThreadId(),
+    };
+    if (capture_ring.size() < capture_config.capacity) {
+        capture_ring.push_back(entry);
+    } else {
+        capture_ring[capture_next] = entry;
+    }
+    capture_next = (capture_next + 1) % capture_config.capacity;
+}
+
+std::vector<CaptureEntry> Recorder::GetCapture() const {
+    std::lock_guard lock{capture_mutex};
+    if (capture_ring.size() < capture_config.capacity)
+        return capture_ring;
+
+    std::vector<CaptureEntry> entries;
+    entries.reserve(capture_ring.size());
+    entries.insert(entries.end(), capture_ring.begin() + capture_next, capture_ring.end());
+    entries.insert(entries.end(), capture_ring.begin(), capture_ring.begin() + capture_next);
+    return entries;
+}
+
+std::unordered_map<u32, std::string> Recorder::GetCapturedPortNames() const {
+    std::lock_guard lock{capture_mutex};
+    std::unordered_map<u32, std::string> names;
+    for (const auto& [port_id, port] : capture_ports) {
+        if (port.captured) {
+            names.emplace(port_id, port.name);
+        }
+    }
+    return names;
+}
+
+std::vector<LatencyHistogram> Recorder::GetLatencyHistograms() const {
+    std::vector<LatencyHistogram> histograms;
+    {
+        std::lock_guard lock{capture_mutex};
+        histograms.reserve(latency_histograms.size());
+        for (const auto& entry : latency_histograms) {
+            histograms.push_back(entry.second);
+        }
+    }
+    std::sort(histograms.begin(), histograms.end(), [](const auto& a, const auto& b) {
+        return a.total_ns > b.total_ns;
+    });
+    return histograms;
+}
+
+bool Recorder::SaveCapture(const std::string& path) const {
+    const auto names = GetCapturedPortNames();
+    const auto entries = GetCapture();
+
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Kernel, "Could not open IPC capture file {}", path);
+        return false;
+    }
+
+    const std::array<u32, 4> header{CAPTURE_MAGIC, CAPTURE_VERSION,
+                                    static_cast<u32>(names.size()),
+                                    static_cast<u32>(entries.size())};
+    bool success = file.WriteArray(header.data(), header.size()) == header.size();
+    for (const auto& [port_id, name] : names) {
+        const std::array<u32, 2> name_header{port_id, static_cast<u32>(name.size())};
+        success = success &&
+                  file.WriteArray(name_header.data(), name_header.size()) == name_header.size() &&
+                  file.WriteBytes(name.data(), name.size()) == name.size();
+    }
+    success = success && file.WriteArray(entries.data(), entries.size()) == entries.size();
+    if (!success) {
+        LOG_ERROR(Kernel, "Could not write IPC capture file {}", path);
+    }
+    return success;
+}
+
 } // namespace IPCDebugger
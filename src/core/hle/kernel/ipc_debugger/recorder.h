@@ -4,12 +4,16 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <shared_mutex>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 #include "common/common_types.h"
@@ -64,6 +68,46 @@ struct RequestRecord {
     std::vector<u32> translated_reply_cmdbuf;
 };
 
+/// Settings of the binary capture mode
+struct CaptureConfig {
+    /// Number of entries kept in the ring buffer, the oldest ones are overwritten
+    std::size_t capacity = 0x10000;
+    /// Only every Nth request of the filtered services is stored in the ring buffer
+    u32 sample_interval = 1;
+    /// Names of the ports of the captured services, all services are captured if empty
+    std::set<std::string> services;
+};
+
+/**
+ * Entry of the binary capture. Requests are identified by the object id of the client port, whose
+ * names are listed by GetCapturedPortNames.
+ */
+struct CaptureEntry {
+    /// Host time the request was sent at in nanoseconds, relative to the start of the capture
+    u64 timestamp_ns;
+    /// Host time until the reply in nanoseconds
+    u32 latency_ns;
+    u32 request_header;
+    u32 reply_result;
+    u32 port_id;
+    u32 client_process_id;
+    u32 client_thread_id;
+};
+static_assert(std::is_trivially_copyable_v<CaptureEntry>);
+
+/// Latencies of one command of a service. Bucket i counts the replies within [2^i, 2^(i+1)) us.
+struct LatencyHistogram {
+    static constexpr std::size_t NUM_BUCKETS = 24;
+
+    std::string service;
+    std::string function; // Only available for HLE services
+    u32 request_header = 0;
+    u64 count = 0;
+    u64 total_ns = 0;
+    u64 max_ns = 0;
+    std::array<u64, NUM_BUCKETS> buckets{};
+};
+
 using CallbackType = std::function<void(const RequestRecord&)>;
 using CallbackHandle = std::shared_ptr<CallbackType>;
 
@@ -111,7 +155,52 @@ public:
     CallbackHandle BindCallback(CallbackType callback);
     void UnbindCallback(const CallbackHandle& handle);
 
+    /**
+     * Starts the binary capture, which only stores fixed-size entries in a ring buffer and
+     * aggregates the latencies per command instead of building a RequestRecord for each request.
+     * It runs independently of the recording enabled by SetEnabled. Clears a previous capture.
+     */
+    void StartCapture(CaptureConfig config);
+    void StopCapture();
+
+    bool IsCapturing() const {
+        return capturing.load(std::memory_order_relaxed);
+    }
+
+    /// Notes the start of a request, called when the client sends it
+    void CaptureRequest(const Kernel::ClientSession& client_session,
+                        const Kernel::Thread& client_thread, u32 request_header);
+
+    /// Completes the entry of the request of the client thread with the reply it received
+    void CaptureReply(const Kernel::Thread& client_thread, const u32* reply_cmdbuf);
+
+    /// Returns the captured entries, oldest first
+    std::vector<CaptureEntry> GetCapture() const;
+
+    /// Returns the names of the ports the captured entries refer to, by object id
+    std::unordered_map<u32, std::string> GetCapturedPortNames() const;
+
+    std::vector<LatencyHistogram> GetLatencyHistograms() const;
+
+    /// Writes the port names and the captured entries to a binary file
+    bool SaveCapture(const std::string& path) const;
+
 private:
+    using Clock = std::chrono::steady_clock;
+
+    struct CapturePort {
+        std::string name;
+        bool captured;
+    };
+
+    struct PendingCapture {
+        Clock::time_point start;
+        u32 request_header;
+        u32 port_id;
+        u32 process_id;
+        bool sampled;
+    };
+
     void InvokeCallbacks(const RequestRecord& request);
 
     std::unordered_map<u32, std::unique_ptr<RequestRecord>> record_map;
@@ -124,6 +213,19 @@ private:
 
     std::set<CallbackHandle> callbacks;
     mutable std::shared_mutex callback_mutex;
+
+    std::atomic_bool capturing{false};
+    mutable std::mutex capture_mutex;
+    CaptureConfig capture_config;
+    Clock::time_point capture_start;
+    u64 capture_request_count = 0;
+    std::vector<CaptureEntry> capture_ring;
+    std::size_t capture_next = 0;
+    std::unordered_map<u32, CapturePort> capture_ports;
+    /// Requests waiting for their reply by client thread id
+    std::unordered_map<u32, PendingCapture> pending_captures;
+    /// Histograms by port id in the upper and request header in the lower half
+    std::unordered_map<u64, LatencyHistogram> latency_histograms;
 };
 
 } // namespace IPCDebugger
@@ -10,6 +10,7 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/mutex.h"
 #include "core/hle/kernel/object.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/thread.h"
 
 namespace Kernel {
@@ -27,7 +28,7 @@ Mutex::Mutex(KernelSystem& kernel) : WaitObject(kernel), kernel(kernel) {}
 Mutex::~Mutex() {}
 
 std::shared_ptr<Mutex> KernelSystem::CreateMutex(bool initial_locked, std::string name) {
-    auto mutex{std::make_shared<Mutex>(*this)};
+    auto mutex{MakePooled<Mutex>(*this)};
 
     mutex->lock_count = 0;
     mutex->name = std::move(name);
@@ -92,14 +93,18 @@ ResultCode Mutex::Release(Thread* thread) {
     return RESULT_SUCCESS;
 }
 
-void Mutex::AddWaitingThread(std::shared_ptr<Thread> thread) {
-    WaitObject::AddWaitingThread(thread);
+void Mutex::AddWaitingThread(WaitNode& node, Thread* thread) {
+    WaitObject::AddWaitingThread(node, thread);
     thread->pending_mutexes.insert(SharedFrom(this));
     UpdatePriority();
 }
 
-void Mutex::RemoveWaitingThread(Thread* thread) {
-    WaitObject::RemoveWaitingThread(thread);
+void Mutex::RemoveWaitingThread(WaitNode& node) {
+    Thread* const thread = node.thread;
+    if (thread == nullptr)
+        return;
+
+    WaitObject::RemoveWaitingThread(node);
     thread->pending_mutexes.erase(SharedFrom(this));
     UpdatePriority();
 }
@@ -109,10 +114,10 @@ void Mutex::UpdatePriority() {
         return;
 
     u32 best_priority = ThreadPrioLowest;
-    for (auto& waiter : GetWaitingThreads()) {
-        if (waiter->current_priority < best_priority)
-            best_priority = waiter->current_priority;
-    }
+    ForEachWaitingThread([&best_priority](const Thread& waiter) {
+        if (waiter.current_priority < best_priority)
+            best_priority = waiter.current_priority;
+    });
 
     if (best_priority != priority) {
         priority = best_priority;
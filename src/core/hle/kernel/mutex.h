@@ -46,8 +46,8 @@ public:
     bool ShouldWait(const Thread* thread) const override;
     void Acquire(Thread* thread) override;
 
-    void AddWaitingThread(std::shared_ptr<Thread> thread) override;
-    void RemoveWaitingThread(Thread* thread) override;
+    void AddWaitingThread(WaitNode& node, Thread* thread) override;
+    void RemoveWaitingThread(WaitNode& node) override;
 
     /**
      * Attempts to release the mutex from the specified thread.
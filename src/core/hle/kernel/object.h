@@ -79,11 +79,20 @@ std::shared_ptr<T> SharedFrom(T* raw) {
  * @return Derived pointer to the object, or `nullptr` if `object` isn't of type T.
  */
 template <typename T>
-inline std::shared_ptr<T> DynamicObjectCast(std::shared_ptr<Object> object) {
+inline std::shared_ptr<T> DynamicObjectCast(const std::shared_ptr<Object>& object) {
     if (object != nullptr && object->GetHandleType() == T::HANDLE_TYPE) {
         return std::static_pointer_cast<T>(object);
     }
     return nullptr;
 }
 
+/// Downcasts a borrowed Object pointer, without touching the reference count of the object.
+template <typename T>
+inline T* DynamicObjectCast(Object* object) {
+    if (object != nullptr && object->GetHandleType() == T::HANDLE_TYPE) {
+        return static_cast<T*>(object);
+    }
+    return nullptr;
+}
+
 } // namespace Kernel
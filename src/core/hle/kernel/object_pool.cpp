@@ -0,0 +1,120 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "core/hle/kernel/object_pool.h"
+
+namespace Kernel {
+
+namespace {
+/// Slabs are at least this large, unless a single block is larger
+constexpr std::size_t SLAB_SIZE = 64 * 1024;
+
+struct PoolRegistry {
+    std::mutex mutex;
+    std::vector<const ObjectPool*> pools;
+};
+
+PoolRegistry& GetRegistry() {
+    // Never destroyed, like the pools themselves
+    static PoolRegistry* const registry = new PoolRegistry;
+    return *registry;
+}
+} // Anonymous namespace
+
+ObjectPool::ObjectPool(HandleType type, std::size_t block_size)
+    : type(type), block_size(Common::AlignUp(std::max(block_size, sizeof(FreeBlock)),
+                                             __STDCPP_DEFAULT_NEW_ALIGNMENT__)),
+      blocks_per_slab(std::max<std::size_t>(SLAB_SIZE / this->block_size, 1)) {
+    PoolRegistry& registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    registry.pools.push_back(this);
+}
+
+ObjectPool::~ObjectPool() {
+    PoolRegistry& registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    registry.pools.erase(std::find(registry.pools.begin(), registry.pools.end(), this));
+}
+
+void* ObjectPool::Allocate() {
+    std::lock_guard lock{mutex};
+    if (free_list == nullptr) {
+        // The slab is linked in reverse so that its blocks are handed out in address order
+        u8* const slab = slabs.emplace_back(new u8[block_size * blocks_per_slab]).get();
+        for (std::size_t i = blocks_per_slab; i-- > 0;) {
+            free_list = new (slab + i * block_size) FreeBlock{free_list};
+        }
+    }
+
+    FreeBlock* const block = free_list;
+    free_list = block->next;
+    peak = std::max(peak, ++live);
+    return block;
+}
+
+void ObjectPool::Free(void* block) {
+    std::lock_guard lock{mutex};
+    ASSERT(live > 0);
+    free_list = new (block) FreeBlock{free_list};
+    --live;
+}
+
+ObjectPoolStats ObjectPool::GetStats() const {
+    std::lock_guard lock{mutex};
+    return {type, live, peak, slabs.size() * blocks_per_slab};
+}
+
+std::vector<ObjectPoolStats> GetObjectPoolStats() {
+    PoolRegistry& registry = GetRegistry();
+    std::lock_guard lock{registry.mutex};
+    std::vector<ObjectPoolStats> stats;
+    stats.reserve(registry.pools.size());
+    for (const ObjectPool* pool : registry.pools) {
+        stats.push_back(pool->GetStats());
+    }
+    std::sort(stats.begin(), stats.end(),
+              [](const auto& a, const auto& b) { return a.type < b.type; });
+    return stats;
+}
+
+const char* GetHandleTypeName(HandleType type) {
+    switch (type) {
+    case HandleType::Event:
+        return "Event";
+    case HandleType::Mutex:
+        return "Mutex";
+    case HandleType::SharedMemory:
+        return "SharedMemory";
+    case HandleType::Thread:
+        return "Thread";
+    case HandleType::Process:
+        return "Process";
+    case HandleType::AddressArbiter:
+        return "AddressArbiter";
+    case HandleType::Semaphore:
+        return "Semaphore";
+    case HandleType::Timer:
+        return "Timer";
+    case HandleType::ResourceLimit:
+        return "ResourceLimit";
+    case HandleType::CodeSet:
+        return "CodeSet";
+    case HandleType::ClientPort:
+        return "ClientPort";
+    case HandleType::ServerPort:
+        return "ServerPort";
+    case HandleType::ClientSession:
+        return "ClientSession";
+    case HandleType::ServerSession:
+        return "ServerSession";
+    case HandleType::Unknown:
+        break;
+    }
+    return "Unknown";
+}
+
+} // namespace Kernel
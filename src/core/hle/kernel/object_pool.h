@@ -0,0 +1,124 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+#include "core/hle/kernel/object.h"
+
+namespace Kernel {
+
+/// Allocation statistics of the pool of one kernel object type
+struct ObjectPoolStats {
+    HandleType type = HandleType::Unknown;
+    /// Number of objects currently allocated from the pool
+    std::size_t live = 0;
+    /// Highest number of objects allocated at once
+    std::size_t peak = 0;
+    /// Number of objects the slabs of the pool can hold
+    std::size_t capacity = 0;
+};
+
+/**
+ * Hands out blocks of a fixed size, carved from larger slabs. Freed blocks are kept on a free list
+ * for the next allocation instead of being returned to the heap, so kernel objects that are
+ * created and destroyed at a high rate don't churn through the heap allocator. Thread-safe.
+ */
+class ObjectPool : NonCopyable {
+public:
+    ObjectPool(HandleType type, std::size_t block_size);
+    ~ObjectPool();
+
+    void* Allocate();
+    void Free(void* block);
+
+    ObjectPoolStats GetStats() const;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    const HandleType type;
+    const std::size_t block_size;
+    const std::size_t blocks_per_slab;
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<u8[]>> slabs;
+    FreeBlock* free_list = nullptr;
+    std::size_t live = 0;
+    std::size_t peak = 0;
+};
+
+/// Returns the statistics of every object pool that has been used
+std::vector<ObjectPoolStats> GetObjectPoolStats();
+
+/// Returns the name of a kernel object type, for display in the debuggers
+const char* GetHandleTypeName(HandleType type);
+
+/**
+ * Allocator for std::allocate_shared that places single objects in an ObjectPool, one pool per
+ * allocated type. The pools are never destroyed, as objects can still be released during the
+ * destruction of static objects.
+ */
+template <typename T, typename ObjectType = T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = PoolAllocator<U, ObjectType>;
+    };
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, ObjectType>&) {}
+
+    T* allocate(std::size_t n) {
+        if (n != 1)
+            return std::allocator<T>{}.allocate(n);
+        return static_cast<T*>(GetPool().Allocate());
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        if (n != 1) {
+            std::allocator<T>{}.deallocate(p, n);
+            return;
+        }
+        GetPool().Free(p);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U, ObjectType>&) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U, ObjectType>&) const {
+        return false;
+    }
+
+private:
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                  "Pooled types can't be over-aligned");
+
+    static ObjectPool& GetPool() {
+        static ObjectPool* const pool = new ObjectPool(ObjectType::HANDLE_TYPE, sizeof(T));
+        return *pool;
+    }
+};
+
+/// Creates a kernel object in the pool of its type
+template <typename T, typename... Args>
+std::shared_ptr<T> MakePooled(Args&&... args) {
+    return std::allocate_shared<T>(PoolAllocator<T>{}, std::forward<Args>(args)...);
+}
+
+} // namespace Kernel
@@ -7,6 +7,7 @@
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/client_session.h"
 #include "core/hle/kernel/hle_ipc.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/server_session.h"
 #include "core/hle/kernel/session.h"
 #include "core/hle/kernel/thread.h"
@@ -30,7 +31,7 @@ ServerSession::~ServerSession() {
 
 ResultVal<std::shared_ptr<ServerSession>> ServerSession::Create(KernelSystem& kernel,
                                                                 std::string name) {
-    auto server_session{std::make_shared<ServerSession>(kernel)};
+    auto server_session{MakePooled<ServerSession>(kernel)};
 
     server_session->name = std::move(name);
     server_session->parent = nullptr;
@@ -68,12 +69,21 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
     // If this ServerSession has an associated HLE handler, forward the request to it.
     if (hle_handler != nullptr) {
         std::array<u32_le, IPC::COMMAND_BUFFER_LENGTH + 2 * IPC::MAX_STATIC_BUFFERS> cmd_buf;
+        constexpr std::size_t cmd_buf_size = cmd_buf.size() * sizeof(u32);
         Kernel::Process* current_process = thread->owner_process;
-        kernel.memory.ReadBlock(*current_process, thread->GetCommandBufferAddress(), cmd_buf.data(),
-                                cmd_buf.size() * sizeof(u32));
+
+        // The command buffer lives in the TLS of the thread, which is normally backed by host
+        // memory, so it is translated in place. Otherwise it is copied in and out.
+        u32_le* guest_cmd_buf = reinterpret_cast<u32_le*>(kernel.memory.GetContiguousPointer(
+            *current_process, thread->GetCommandBufferAddress(), cmd_buf_size, true));
+        u32_le* const cmd_buf_ptr = guest_cmd_buf != nullptr ? guest_cmd_buf : cmd_buf.data();
+        if (guest_cmd_buf == nullptr) {
+            kernel.memory.ReadBlock(*current_process, thread->GetCommandBufferAddress(),
+                                    cmd_buf.data(), cmd_buf_size);
+        }
 
         Kernel::HLERequestContext context(kernel, SharedFrom(this), thread.get());
-        context.PopulateFromIncomingCommandBuffer(cmd_buf.data(), *current_process);
+        context.PopulateFromIncomingCommandBuffer(cmd_buf_ptr, *current_process);
 
         hle_handler->HandleSyncRequest(context);
 
@@ -83,9 +93,11 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
         // put the thread to sleep then the writing of the command buffer will be deferred to the
         // wakeup callback.
         if (thread->status == Kernel::ThreadStatus::Running) {
-            context.WriteToOutgoingCommandBuffer(cmd_buf.data(), *current_process);
-            kernel.memory.WriteBlock(*current_process, thread->GetCommandBufferAddress(),
-                                     cmd_buf.data(), cmd_buf.size() * sizeof(u32));
+            context.WriteToOutgoingCommandBuffer(cmd_buf_ptr, *current_process);
+            if (guest_cmd_buf == nullptr) {
+                kernel.memory.WriteBlock(*current_process, thread->GetCommandBufferAddress(),
+                                         cmd_buf.data(), cmd_buf_size);
+            }
         }
     }
 
@@ -123,7 +135,7 @@ ResultCode ServerSession::HandleSyncRequest(std::shared_ptr<Thread> thread) {
 KernelSystem::SessionPair KernelSystem::CreateSessionPair(const std::string& name,
                                                           std::shared_ptr<ClientPort> port) {
     auto server_session = ServerSession::Create(*this, name + "_Server").Unwrap();
-    auto client_session{std::make_shared<ClientSession>(*this)};
+    auto client_session{MakePooled<ClientSession>(*this)};
     client_session->name = name + "_Client";
 
     std::shared_ptr<Session> parent(new Session);
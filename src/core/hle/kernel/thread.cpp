@@ -10,6 +10,7 @@
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
+#include "common/tracing.h"
 #include "core/arm/arm_interface.h"
 #include "core/arm/skyeye_common/armstate.h"
 #include "core/core.h"
@@ -18,10 +19,12 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/object_pool.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
 #include "core/hle/result.h"
 #include "core/memory.h"
+#include "core/perf_metrics.h"
 
 namespace Kernel {
 
@@ -58,10 +61,7 @@ void Thread::Stop() {
     WakeupAllWaitingThreads();
 
     // Clean up any dangling references in objects that this thread was waiting for
-    for (auto& wait_object : wait_objects) {
-        wait_object->RemoveWaitingThread(this);
-    }
-    wait_objects.clear();
+    ClearWaitObjects();
 
     // Release all the mutexes that this thread holds
     ReleaseThreadMutexes(this);
@@ -78,6 +78,15 @@ void ThreadManager::SwitchContext(Thread* new_thread) {
 
     Core::Timing& timing = kernel.timing;
 
+    // Most reschedules keep the current thread running. Its context is still in the CPU, and
+    // reloading it would make dynarmic drop its return stack buffer.
+    if (new_thread && new_thread == previous_thread &&
+        new_thread->status == ThreadStatus::Running) {
+        new_thread->last_running_ticks = timing.GetGlobalTicks();
+        return;
+    }
+    Core::Metrics::Add(Core::Metrics::Counter::ThreadSwitches);
+
     // Save context for previous thread
     if (previous_thread) {
         previous_thread->last_running_ticks = timing.GetGlobalTicks();
@@ -103,6 +112,9 @@ void ThreadManager::SwitchContext(Thread* new_thread) {
 
         current_thread = SharedFrom(new_thread);
 
+        static Common::Tracing::Category switch_category{"Kernel", "Thread Switch"};
+        Common::Tracing::Instant(switch_category, nullptr, new_thread->thread_id);
+
         ready_queue.remove(new_thread->current_priority, new_thread);
         new_thread->status = ThreadStatus::Running;
 
@@ -167,9 +179,7 @@ void ThreadManager::ThreadWakeupCallback(u64 thread_id, s64 cycles_late) {
             thread->wakeup_callback(ThreadWakeupReason::Timeout, thread, nullptr);
 
         // Remove the thread from each of its waiting objects' waitlists
-        for (auto& object : thread->wait_objects)
-            object->RemoveWaitingThread(thread.get());
-        thread->wait_objects.clear();
+        thread->ClearWaitObjects();
     }
 
     thread->ResumeFromWait();
@@ -305,10 +315,9 @@ ResultVal<std::shared_ptr<Thread>> KernelSystem::CreateThread(std::string name,
                           ErrorSummary::InvalidArgument, ErrorLevel::Permanent);
     }
 
-    auto thread{std::make_shared<Thread>(*this, processor_id)};
+    auto thread{MakePooled<Thread>(*this, processor_id)};
 
     thread_managers[processor_id]->thread_list.push_back(thread);
-    thread_managers[processor_id]->ready_queue.prepare(priority);
 
     thread->thread_id = NewThreadId();
     thread->status = ThreadStatus::Dormant;
@@ -377,8 +386,6 @@ void Thread::SetPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == ThreadStatus::Ready)
         thread_manager.ready_queue.move(this, current_priority, priority);
-    else
-        thread_manager.ready_queue.prepare(priority);
 
     nominal_priority = current_priority = priority;
 }
@@ -396,8 +403,6 @@ void Thread::BoostPriority(u32 priority) {
     // If thread was ready, adjust queues
     if (status == ThreadStatus::Ready)
         thread_manager.ready_queue.move(this, current_priority, priority);
-    else
-        thread_manager.ready_queue.prepare(priority);
     current_priority = priority;
 }
 
@@ -450,10 +455,39 @@ void Thread::SetWaitSynchronizationOutput(s32 output) {
 s32 Thread::GetWaitObjectIndex(const WaitObject* object) const {
     ASSERT_MSG(!wait_objects.empty(), "Thread is not waiting for anything");
     const auto match = std::find_if(wait_objects.rbegin(), wait_objects.rend(),
-                                    [object](const auto& p) { return p.get() == object; });
+                                    [object](const auto& p) { return p.object.get() == object; });
     return static_cast<s32>(std::distance(match, wait_objects.rend()) - 1);
 }
 
+void Thread::SetWaitObject(std::shared_ptr<WaitObject> object) {
+    wait_objects.emplace_back(std::move(object));
+    AddToWaitObjects();
+}
+
+void Thread::AddToWaitObjects() {
+    // The entries must not move once they are linked, so they are only linked after all of them
+    // have been added to the vector
+    for (WaitNode& node : wait_objects) {
+        node.object->AddWaitingThread(node, this);
+    }
+}
+
+void Thread::ClearWaitObjects() {
+    for (WaitNode& node : wait_objects) {
+        node.object->RemoveWaitingThread(node);
+    }
+    wait_objects.clear();
+}
+
+std::vector<std::shared_ptr<WaitObject>> Thread::GetWaitObjects() const {
+    std::vector<std::shared_ptr<WaitObject>> objects;
+    objects.reserve(wait_objects.size());
+    for (const WaitNode& node : wait_objects) {
+        objects.push_back(node.object);
+    }
+    return objects;
+}
+
 VAddr Thread::GetCommandBufferAddress() const {
     // Offset from the start of TLS at which the IPC command buffer begins.
     constexpr u32 command_header_offset = 0x80;
@@ -129,7 +129,7 @@ private:
     ARM_Interface* cpu;
 
     std::shared_ptr<Thread> current_thread;
-    Common::ThreadQueueList<Thread*, ThreadPrioLowest + 1> ready_queue;
+    Common::ThreadQueueList<Thread, ThreadPrioLowest + 1> ready_queue;
     std::unordered_map<u64, Thread*> wakeup_callback_table;
 
     /// Event type for the thread wake up event
@@ -142,7 +142,7 @@ private:
     friend class KernelSystem;
 };
 
-class Thread final : public WaitObject {
+class Thread final : public WaitObject, public Common::ThreadQueueListNode<Thread> {
 public:
     explicit Thread(KernelSystem&, u32 core_id);
     ~Thread() override;
@@ -230,6 +230,28 @@ public:
      */
     s32 GetWaitObjectIndex(const WaitObject* object) const;
 
+    /**
+     * Makes the thread wait for the given objects, moving them into its wait entries and adding
+     * it to the waiting threads lists of the objects.
+     * @param objects Objects to wait for, in the order that they were passed to the SVC
+     */
+    template <typename Container>
+    void SetWaitObjects(Container& objects) {
+        for (auto& object : objects) {
+            wait_objects.emplace_back(std::move(object));
+        }
+        AddToWaitObjects();
+    }
+
+    /// Makes the thread wait for a single object
+    void SetWaitObject(std::shared_ptr<WaitObject> object);
+
+    /// Removes the thread from the waiting threads lists of its wait objects and forgets them
+    void ClearWaitObjects();
+
+    /// Get a copy of the objects that the thread is waiting on for debug use
+    std::vector<std::shared_ptr<WaitObject>> GetWaitObjects() const;
+
     /**
      * Stops a thread, invalidating it from further use
      */
@@ -284,8 +306,9 @@ public:
     Process* owner_process; ///< Process that owns this thread
 
     /// Objects that the thread is waiting on, in the same order as they were
-    // passed to WaitSynchronization1/N.
-    std::vector<std::shared_ptr<WaitObject>> wait_objects;
+    // passed to WaitSynchronization1/N. The entries link the thread into the waiting threads
+    // lists of the objects, the capacity is kept between waits so that waiting doesn't allocate.
+    std::vector<WaitNode> wait_objects;
 
     VAddr wait_address; ///< If waiting on an AddressArbiter, this is the arbitration address
 
@@ -299,6 +322,9 @@ public:
     std::function<WakeupCallback> wakeup_callback;
 
 private:
+    /// Adds the thread to the waiting threads lists of all its wait objects
+    void AddToWaitObjects();
+
     ThreadManager& thread_manager;
 };
 
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <iterator>
 #include "common/assert.h"
+#include "core/core.h"
 #include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/vm_manager.h"
 #include "core/memory.h"
@@ -50,10 +51,9 @@ void VMManager::Reset() {
     initial_vma.size = MAX_ADDRESS;
     vma_map.emplace(initial_vma.base, initial_vma);
 
-    page_table.pointers.fill(nullptr);
-    page_table.attributes.fill(Memory::PageType::Unmapped);
-
-    UpdatePageTableForVMA(initial_vma);
+    // A cleared page table already leaves the single free region unmapped. Unmapping it again
+    // would write every entry, which makes the OS back the whole table with memory.
+    page_table.Clear();
 }
 
 VMManager::VMAHandle VMManager::FindVMA(VAddr target) const {
@@ -155,8 +155,6 @@ ResultCode VMManager::ChangeMemoryState(VAddr target, u32 size, MemoryState expe
 
     vma->second.permissions = new_perms;
     vma->second.meminfo_state = new_state;
-    UpdatePageTableForVMA(vma->second);
-
     MergeAdjacent(vma);
 
     return RESULT_SUCCESS;
@@ -171,8 +169,6 @@ VMManager::VMAIter VMManager::Unmap(VMAIter vma_handle) {
     vma.backing_memory = nullptr;
     vma.paddr = 0;
 
-    UpdatePageTableForVMA(vma);
-
     return MergeAdjacent(vma_handle);
 }
 
@@ -180,6 +176,17 @@ ResultCode VMManager::UnmapRange(VAddr target, u32 size) {
     CASCADE_RESULT(VMAIter vma, CarveVMARange(target, size));
     const VAddr target_end = target + size;
 
+    // Only drop the JIT code of the executable parts, the rest of the range can't hold any
+    VAddr executable_start = target_end;
+    VAddr executable_end = target;
+    for (auto i = vma; i != vma_map.end() && i->second.base < target_end; ++i) {
+        const VirtualMemoryArea& area = i->second;
+        if ((static_cast<u32>(area.permissions) & static_cast<u32>(VMAPermission::Execute)) != 0) {
+            executable_start = std::min(executable_start, area.base);
+            executable_end = std::max(executable_end, area.base + area.size);
+        }
+    }
+
     const VMAIter end = vma_map.end();
     // The comparison against the end of the range must be done using addresses since VMAs can be
     // merged during this process, causing invalidation of the iterators.
@@ -187,6 +194,13 @@ ResultCode VMManager::UnmapRange(VAddr target, u32 size) {
         vma = std::next(Unmap(vma));
     }
 
+    // The whole range is free now, so the page table is updated once instead of once per VMA
+    memory.UnmapRegion(page_table, target, size);
+    if (executable_start < executable_end) {
+        Core::System::GetInstance().InvalidateCacheRange(executable_start,
+                                                         executable_end - executable_start);
+    }
+
     ASSERT(FindVMA(target)->second.size >= size);
     return RESULT_SUCCESS;
 }
@@ -194,10 +208,7 @@ ResultCode VMManager::UnmapRange(VAddr target, u32 size) {
 VMManager::VMAHandle VMManager::Reprotect(VMAHandle vma_handle, VMAPermission new_perms) {
     VMAIter iter = StripIterConstness(vma_handle);
 
-    VirtualMemoryArea& vma = iter->second;
-    vma.permissions = new_perms;
-    UpdatePageTableForVMA(vma);
-
+    iter->second.permissions = new_perms;
     return MergeAdjacent(iter);
 }
 
@@ -363,9 +374,10 @@ ResultVal<std::vector<std::pair<u8*, u32>>> VMManager::GetBackingBlocksForRange(
                                                                                 u32 size) {
     std::vector<std::pair<u8*, u32>> backing_blocks;
     VAddr interval_target = address;
-    while (interval_target != address + size) {
-        auto vma = FindVMA(interval_target);
-        if (vma->second.type != VMAType::BackingMemory) {
+    // The VMAs of the range are adjacent in the map, so only the first one has to be looked up
+    auto vma = FindVMA(interval_target);
+    for (; interval_target != address + size; ++vma) {
+        if (vma == vma_map.end() || vma->second.type != VMAType::BackingMemory) {
             LOG_ERROR(Kernel, "Trying to use already freed memory");
             return ERR_INVALID_ADDRESS_STATE;
         }
@@ -198,7 +198,7 @@ private:
     /// Converts a VMAHandle to a mutable VMAIter.
     VMAIter StripIterConstness(const VMAHandle& iter);
 
-    /// Unmaps the given VMA.
+    /// Marks the given VMA as free, leaving the page table update to the caller.
     VMAIter Unmap(VMAIter vma);
 
     /**
@@ -225,7 +225,11 @@ private:
      */
     VMAIter MergeAdjacent(VMAIter vma);
 
-    /// Updates the pages corresponding to this VMA so they match the VMA's attributes.
+    /**
+     * Updates the pages corresponding to this VMA so they match the VMA's attributes. Only the
+     * type and the backing of a VMA are reflected in the page table, so permission and state
+     * changes don't need to update it.
+     */
     void UpdatePageTableForVMA(const VirtualMemoryArea& vma);
 
     Memory::MemorySystem& memory;
@@ -16,27 +16,46 @@
 
 namespace Kernel {
 
-void WaitObject::AddWaitingThread(std::shared_ptr<Thread> thread) {
-    auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
-    if (itr == waiting_threads.end())
-        waiting_threads.push_back(std::move(thread));
+void WaitObject::AddWaitingThread(WaitNode& node, Thread* thread) {
+    ASSERT_MSG(node.thread == nullptr, "Wait entry is already linked");
+    // If a thread passed multiple handles to the same object, it gets an entry for each of them.
+    // They are all removed together when the thread stops waiting.
+    node.thread = thread;
+    node.prev = last_waiter;
+    node.next = nullptr;
+    if (last_waiter != nullptr) {
+        last_waiter->next = &node;
+    } else {
+        first_waiter = &node;
+    }
+    last_waiter = &node;
 }
 
-void WaitObject::RemoveWaitingThread(Thread* thread) {
-    auto itr = std::find_if(waiting_threads.begin(), waiting_threads.end(),
-                            [thread](const auto& p) { return p.get() == thread; });
-    // If a thread passed multiple handles to the same object,
-    // the kernel might attempt to remove the thread from the object's
-    // waiting threads list multiple times.
-    if (itr != waiting_threads.end())
-        waiting_threads.erase(itr);
+void WaitObject::RemoveWaitingThread(WaitNode& node) {
+    if (node.thread == nullptr)
+        return;
+
+    if (node.prev != nullptr) {
+        node.prev->next = node.next;
+    } else {
+        first_waiter = node.next;
+    }
+    if (node.next != nullptr) {
+        node.next->prev = node.prev;
+    } else {
+        last_waiter = node.prev;
+    }
+    node.thread = nullptr;
+    node.prev = nullptr;
+    node.next = nullptr;
 }
 
-std::shared_ptr<Thread> WaitObject::GetHighestPriorityReadyThread() const {
+Thread* WaitObject::GetHighestPriorityReadyThread() const {
     Thread* candidate = nullptr;
     u32 candidate_priority = ThreadPrioLowest + 1;
 
-    for (const auto& thread : waiting_threads) {
+    for (const WaitNode* node = first_waiter; node != nullptr; node = node->next) {
+        Thread* const thread = node->thread;
         // The list of waiting threads must not contain threads that are not waiting to be awakened.
         ASSERT_MSG(thread->status == ThreadStatus::WaitSynchAny ||
                        thread->status == ThreadStatus::WaitSynchAll ||
@@ -46,7 +65,7 @@ std::shared_ptr<Thread> WaitObject::GetHighestPriorityReadyThread() const {
         if (thread->current_priority >= candidate_priority)
             continue;
 
-        if (ShouldWait(thread.get()))
+        if (ShouldWait(thread))
             continue;
 
         // A thread is ready to run if it's either in ThreadStatus::WaitSynchAny or
@@ -54,38 +73,36 @@ std::shared_ptr<Thread> WaitObject::GetHighestPriorityReadyThread() const {
         bool ready_to_run = true;
         if (thread->status == ThreadStatus::WaitSynchAll) {
             ready_to_run = std::none_of(thread->wait_objects.begin(), thread->wait_objects.end(),
-                                        [&thread](const std::shared_ptr<WaitObject>& object) {
-                                            return object->ShouldWait(thread.get());
+                                        [thread](const WaitNode& wait_node) {
+                                            return wait_node.object->ShouldWait(thread);
                                         });
         }
 
         if (ready_to_run) {
-            candidate = thread.get();
+            candidate = thread;
             candidate_priority = thread->current_priority;
         }
     }
 
-    return SharedFrom(candidate);
+    return candidate;
 }
 
 void WaitObject::WakeupAllWaitingThreads() {
-    while (auto thread = GetHighestPriorityReadyThread()) {
+    while (Thread* thread = GetHighestPriorityReadyThread()) {
         if (!thread->IsSleepingOnWaitAll()) {
-            Acquire(thread.get());
+            Acquire(thread);
         } else {
-            for (auto& object : thread->wait_objects) {
-                object->Acquire(thread.get());
+            for (auto& wait_node : thread->wait_objects) {
+                wait_node.object->Acquire(thread);
             }
         }
 
         // Invoke the wakeup callback before clearing the wait objects
         if (thread->wakeup_callback)
-            thread->wakeup_callback(ThreadWakeupReason::Signal, thread, SharedFrom(this));
-
-        for (auto& object : thread->wait_objects)
-            object->RemoveWaitingThread(thread.get());
-        thread->wait_objects.clear();
+            thread->wakeup_callback(ThreadWakeupReason::Signal, SharedFrom(thread),
+                                    SharedFrom(this));
 
+        thread->ClearWaitObjects();
         thread->ResumeFromWait();
     }
 
@@ -93,8 +110,10 @@ void WaitObject::WakeupAllWaitingThreads() {
         hle_notifier();
 }
 
-const std::vector<std::shared_ptr<Thread>>& WaitObject::GetWaitingThreads() const {
-    return waiting_threads;
+std::vector<std::shared_ptr<Thread>> WaitObject::GetWaitingThreads() const {
+    std::vector<std::shared_ptr<Thread>> threads;
+    ForEachWaitingThread([&threads](Thread& thread) { threads.push_back(SharedFrom(&thread)); });
+    return threads;
 }
 
 void WaitObject::SetHLENotifier(std::function<void()> callback) {
@@ -6,6 +6,7 @@
 
 #include <functional>
 #include <memory>
+#include <utility>
 #include <vector>
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
@@ -13,6 +14,20 @@
 namespace Kernel {
 
 class Thread;
+class WaitObject;
+
+/**
+ * Entry of a thread in the waiter list of one of the objects it waits for. The entries are owned
+ * by the thread and linked into the lists of the objects, so waiting never allocates.
+ */
+struct WaitNode {
+    explicit WaitNode(std::shared_ptr<WaitObject> object) : object(std::move(object)) {}
+
+    std::shared_ptr<WaitObject> object; ///< The object that is waited for
+    Thread* thread = nullptr;           ///< The waiting thread, set while the entry is linked
+    WaitNode* prev = nullptr;
+    WaitNode* next = nullptr;
+};
 
 /// Class that represents a Kernel object that a thread can be waiting on
 class WaitObject : public Object {
@@ -31,15 +46,16 @@ public:
 
     /**
      * Add a thread to wait on this object
+     * @param node Entry of the waiting thread, which must stay in place until it is removed
      * @param thread Pointer to thread to add
      */
-    virtual void AddWaitingThread(std::shared_ptr<Thread> thread);
+    virtual void AddWaitingThread(WaitNode& node, Thread* thread);
 
     /**
      * Removes a thread from waiting on this object (e.g. if it was resumed already)
-     * @param thread Pointer to thread to remove
+     * @param node Entry of the thread that was passed to AddWaitingThread
      */
-    virtual void RemoveWaitingThread(Thread* thread);
+    virtual void RemoveWaitingThread(WaitNode& node);
 
     /**
      * Wake up all threads waiting on this object that can be awoken, in priority order,
@@ -48,17 +64,26 @@ public:
     virtual void WakeupAllWaitingThreads();
 
     /// Obtains the highest priority thread that is ready to run from this object's waiting list.
-    std::shared_ptr<Thread> GetHighestPriorityReadyThread() const;
+    Thread* GetHighestPriorityReadyThread() const;
+
+    /// Calls the function for each thread waiting on this object
+    template <typename Func>
+    void ForEachWaitingThread(Func&& func) const {
+        for (const WaitNode* node = first_waiter; node != nullptr; node = node->next) {
+            func(*node->thread);
+        }
+    }
 
-    /// Get a const reference to the waiting threads list for debug use
-    const std::vector<std::shared_ptr<Thread>>& GetWaitingThreads() const;
+    /// Get a copy of the waiting threads list for debug use
+    std::vector<std::shared_ptr<Thread>> GetWaitingThreads() const;
 
     /// Sets a callback which is called when the object becomes available
     void SetHLENotifier(std::function<void()> callback);
 
 private:
-    /// Threads waiting for this object to become available
-    std::vector<std::shared_ptr<Thread>> waiting_threads;
+    /// Threads waiting for this object to become available, linked through their wait entries
+    WaitNode* first_waiter = nullptr;
+    WaitNode* last_waiter = nullptr;
 
     /// Function to call when this object becomes available
     std::function<void()> hle_notifier;
@@ -66,11 +91,20 @@ private:
 
 // Specialization of DynamicObjectCast for WaitObjects
 template <>
-inline std::shared_ptr<WaitObject> DynamicObjectCast<WaitObject>(std::shared_ptr<Object> object) {
+inline std::shared_ptr<WaitObject> DynamicObjectCast<WaitObject>(
+    const std::shared_ptr<Object>& object) {
     if (object != nullptr && object->IsWaitable()) {
         return std::static_pointer_cast<WaitObject>(object);
     }
     return nullptr;
 }
 
+template <>
+inline WaitObject* DynamicObjectCast<WaitObject>(Object* object) {
+    if (object != nullptr && object->IsWaitable()) {
+        return static_cast<WaitObject*>(object);
+    }
+    return nullptr;
+}
+
 } // namespace Kernel
@@ -3,16 +3,23 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
 #include <cinttypes>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
 #include "core/core.h"
+#include "core/file_sys/content_store.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/file_sys/title_metadata.h"
@@ -32,6 +39,7 @@
 #include "core/hle/service/fs/archive.h"
 #include "core/loader/loader.h"
 #include "core/loader/smdh.h"
+#include "core/settings.h"
 
 namespace Service::AM {
 
@@ -169,8 +177,13 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
             // Since the incoming TMD has already been written, we can use GetTitleContentPath
             // to get the content paths to write to.
             FileSys::TitleMetadata tmd = container.GetTitleMetadata();
-            FileUtil::IOFile file(GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update),
-                                  content_written[i] ? "ab" : "wb");
+            const std::string content_path =
+                GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update);
+            // Deduplicated contents share their data with the content store, so they are
+            // replaced instead of truncated
+            if (!content_written[i])
+                FileUtil::Delete(content_path);
+            FileUtil::IOFile file(content_path, content_written[i] ? "ab" : "wb");
 
             if (!file.IsOpen())
                 return FileSys::ERROR_INSUFFICIENT_SPACE;
@@ -196,6 +209,223 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
     return MakeResult<std::size_t>(length);
 }
 
+namespace {
+// Size of the chunks the contents are installed in and the number of chunks each queue holds
+constexpr std::size_t INSTALL_CHUNK_SIZE = 0x100000;
+constexpr std::size_t INSTALL_QUEUE_DEPTH = 4;
+
+/// Hands chunks from one install stage to the next, blocking the producer while it's full
+class ChunkQueue {
+public:
+    /// Returns false if the queue was aborted
+    bool Push(std::vector<u8> chunk) {
+        std::unique_lock lock{mutex};
+        changed.wait(lock, [this] { return aborted || chunks.size() < INSTALL_QUEUE_DEPTH; });
+        if (aborted)
+            return false;
+        chunks.push_back(std::move(chunk));
+        changed.notify_all();
+        return true;
+    }
+
+    /// Returns false once the queue is closed and empty, or if it was aborted
+    bool Pop(std::vector<u8>& chunk) {
+        std::unique_lock lock{mutex};
+        changed.wait(lock, [this] { return aborted || closed || !chunks.empty(); });
+        if (aborted || chunks.empty())
+            return false;
+        chunk = std::move(chunks.front());
+        chunks.pop_front();
+        changed.notify_all();
+        return true;
+    }
+
+    /// Called by the producer after its last chunk
+    void Close() {
+        std::lock_guard lock{mutex};
+        closed = true;
+        changed.notify_all();
+    }
+
+    /// Drops the queued chunks and makes both sides give up
+    void Abort() {
+        std::lock_guard lock{mutex};
+        aborted = true;
+        chunks.clear();
+        changed.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<u8>> chunks;
+    bool closed = false;
+    bool aborted = false;
+};
+} // Anonymous namespace
+
+ResultCode CIAFile::InstallContentFromFile(u16 index, const std::string& path,
+                                           std::atomic<u64>& progress) {
+    const FileSys::TitleMetadata& tmd = container.GetTitleMetadata();
+    const std::string content_path =
+        GetTitleContentPath(media_type, tmd.GetTitleID(), index, is_update);
+    FileUtil::IOFile source(path, "rb");
+    FileUtil::Delete(content_path);
+    FileUtil::IOFile target(content_path, "wb");
+    if (!source.IsOpen() || !target.IsOpen())
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+    if (!source.Seek(container.GetContentOffset(index), SEEK_SET))
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+
+    const bool encrypted = (tmd.GetContentTypeByIndex(index) &
+                            FileSys::TMDContentTypeFlag::Encrypted) &&
+                           index < decryption_state->content.size();
+    CryptoPP::SHA256 sha;
+
+    // Read (on this thread) -> decrypt -> hash -> write, each stage on its own thread so that
+    // disk access and the crypto overlap
+    ChunkQueue to_decrypt;
+    ChunkQueue to_hash;
+    ChunkQueue to_write;
+    const auto abort_all = [&] {
+        to_decrypt.Abort();
+        to_hash.Abort();
+        to_write.Abort();
+    };
+
+    std::thread decrypt_thread([&] {
+        std::vector<u8> chunk;
+        while (to_decrypt.Pop(chunk)) {
+            if (encrypted) {
+                decryption_state->content[index].ProcessData(chunk.data(), chunk.data(),
+                                                             chunk.size());
+            }
+            if (!to_hash.Push(std::move(chunk)))
+                return;
+        }
+        to_hash.Close();
+    });
+    std::thread hash_thread([&] {
+        std::vector<u8> chunk;
+        while (to_hash.Pop(chunk)) {
+            sha.Update(chunk.data(), chunk.size());
+            if (!to_write.Push(std::move(chunk)))
+                return;
+        }
+        to_write.Close();
+    });
+    bool write_failed = false;
+    std::thread write_thread([&] {
+        std::vector<u8> chunk;
+        while (to_write.Pop(chunk)) {
+            if (target.WriteBytes(chunk.data(), chunk.size()) != chunk.size()) {
+                write_failed = true;
+                abort_all();
+                return;
+            }
+            content_written[index] += chunk.size();
+            progress += chunk.size();
+        }
+    });
+
+    bool read_failed = false;
+    for (u64 remaining = container.GetContentSize(index); remaining > 0;) {
+        std::vector<u8> chunk(std::min<u64>(remaining, INSTALL_CHUNK_SIZE));
+        if (source.ReadBytes(chunk.data(), chunk.size()) != chunk.size()) {
+            read_failed = true;
+            abort_all();
+            break;
+        }
+        remaining -= chunk.size();
+        if (!to_decrypt.Push(std::move(chunk)))
+            break;
+    }
+    to_decrypt.Close();
+
+    decrypt_thread.join();
+    hash_thread.join();
+    write_thread.join();
+
+    // A content that failed keeps the install incomplete, so that Close discards it
+    if (read_failed || write_failed)
+        content_written[index] = 0;
+    if (read_failed) {
+        LOG_ERROR(Service_AM, "Could not read content {} from {}", index, path);
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+    }
+    if (write_failed) {
+        LOG_ERROR(Service_AM, "Could not write content {}", index);
+        return FileSys::ERROR_INSUFFICIENT_SPACE;
+    }
+
+    std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+    sha.Final(hash.data());
+    if (hash != tmd.GetContentHashByIndex(index)) {
+        content_written[index] = 0;
+        LOG_ERROR(Service_AM, "Hash of content {} does not match the TMD", index);
+        return ResultCode(ErrCodes::InvalidCIAHeader, ErrorModule::AM,
+                          ErrorSummary::InvalidArgument, ErrorLevel::Permanent);
+    }
+    return RESULT_SUCCESS;
+}
+
+ResultCode CIAFile::InstallContentsFromFile(
+    const std::string& path, const std::function<ProgressCallback>& update_callback) {
+    ASSERT(install_state == CIAInstallState::TMDLoaded);
+
+    // Each content already keeps four threads busy
+    const u16 content_count = static_cast<u16>(container.GetTitleMetadata().GetContentCount());
+    const u16 num_workers = static_cast<u16>(std::clamp<unsigned>(
+        std::thread::hardware_concurrency() / 4, 1, std::max<u16>(content_count, 1)));
+
+    std::mutex mutex;
+    std::condition_variable worker_done;
+    u16 next_index = 0;
+    u16 running_workers = num_workers;
+    ResultCode result = RESULT_SUCCESS;
+    std::atomic<u64> progress{0};
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_workers);
+    for (u16 i = 0; i < num_workers; ++i) {
+        workers.emplace_back([&] {
+            std::unique_lock lock{mutex};
+            while (next_index < content_count && result.IsSuccess()) {
+                const u16 index = next_index++;
+                lock.unlock();
+                const ResultCode content_result = InstallContentFromFile(index, path, progress);
+                lock.lock();
+                if (content_result.IsError())
+                    result = content_result;
+            }
+            --running_workers;
+            worker_done.notify_all();
+        });
+    }
+
+    // Report the progress from the calling thread only, the frontends expect that
+    const u64 total_size = FileUtil::GetSize(path);
+    const u64 content_offset = container.GetContentOffset();
+    {
+        std::unique_lock lock{mutex};
+        while (!worker_done.wait_for(lock, std::chrono::milliseconds(100),
+                                     [&] { return running_workers == 0; })) {
+            if (update_callback) {
+                lock.unlock();
+                update_callback(content_offset + progress, total_size);
+                lock.lock();
+            }
+        }
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    written = content_offset + progress;
+    install_state = CIAInstallState::ContentWritten;
+    return result;
+}
+
 ResultVal<std::size_t> CIAFile::Write(u64 offset, std::size_t length, bool flush,
                                       const u8* buffer) {
     written += length;
@@ -289,6 +519,12 @@ bool CIAFile::Close() const {
         return true;
     }
 
+    const FileSys::TitleMetadata& tmd = container.GetTitleMetadata();
+    std::vector<std::string> content_paths(tmd.GetContentCount());
+    for (u16 i = 0; i < tmd.GetContentCount(); i++) {
+        content_paths[i] = GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update);
+    }
+
     // Clean up older content data if we installed newer content on top
     std::string old_tmd_path =
         GetTitleMetadataPath(media_type, container.GetTitleMetadata().GetTitleID(), false);
@@ -320,6 +556,12 @@ bool CIAFile::Close() const {
 
         FileUtil::Delete(old_tmd_path);
     }
+
+    if (!Settings::values.content_store_dir.empty()) {
+        for (const std::string& content_path : content_paths) {
+            FileSys::DeduplicateContent(content_path, Settings::values.content_store_dir);
+        }
+    }
     return true;
 }
 
@@ -354,10 +596,14 @@ InstallStatus InstallCIA(const std::string& path,
         if (!file.IsOpen())
             return InstallStatus::ErrorFailedToOpenFile;
 
+        // Only the header, certificates, ticket and TMD go through the CIA file, the contents
+        // are installed straight from the file afterwards
+        const std::size_t content_offset = container.GetContentOffset();
         std::array<u8, 0x10000> buffer;
         std::size_t total_bytes_read = 0;
-        while (total_bytes_read != file.GetSize()) {
-            std::size_t bytes_read = file.ReadBytes(buffer.data(), buffer.size());
+        while (total_bytes_read != content_offset) {
+            std::size_t bytes_read = file.ReadBytes(
+                buffer.data(), std::min(buffer.size(), content_offset - total_bytes_read));
             auto result = installFile.Write(static_cast<u64>(total_bytes_read), bytes_read, true,
                                             static_cast<u8*>(buffer.data()));
 
@@ -368,8 +614,21 @@ InstallStatus InstallCIA(const std::string& path,
                           result.Code().raw);
                 return InstallStatus::ErrorAborted;
             }
+            if (bytes_read == 0) {
+                LOG_ERROR(Service_AM, "CIA file {} is truncated", path);
+                return InstallStatus::ErrorAborted;
+            }
             total_bytes_read += bytes_read;
         }
+
+        const ResultCode result = installFile.InstallContentsFromFile(path, update_callback);
+        if (result.IsError()) {
+            LOG_ERROR(Service_AM, "CIA file installation aborted with error code {:08x}",
+                      result.raw);
+            return InstallStatus::ErrorAborted;
+        }
+        if (update_callback)
+            update_callback(file.GetSize(), file.GetSize());
         installFile.Close();
 
         LOG_INFO(Service_AM, "Installed {} successfully.", path);
@@ -1106,11 +1365,13 @@ public:
         : file(std::move(file)), file_offset(offset), file_size(size) {}
 
     ResultVal<std::size_t> Read(u64 offset, std::size_t length, u8* buffer) const override {
+        std::lock_guard lock{file->backend_mutex};
         return file->backend->Read(offset + file_offset, length, buffer);
     }
 
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override {
+        std::lock_guard lock{file->backend_mutex};
         return file->backend->Write(offset + file_offset, length, flush, buffer);
     }
 
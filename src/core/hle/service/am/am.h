@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
@@ -71,6 +72,16 @@ public:
     ResultCode WriteTicket();
     ResultCode WriteTitleMetadata();
     ResultVal<std::size_t> WriteContentData(u64 offset, std::size_t length, const u8* buffer);
+
+    /**
+     * Installs the contents straight from the CIA file at path once the TMD has been loaded.
+     * Several contents are installed at once, and the reading, decryption, verification and
+     * writing of each content run on separate threads.
+     * @param path file path of the CIA file being installed
+     * @param update_callback callback function called with the progress from the calling thread
+     */
+    ResultCode InstallContentsFromFile(const std::string& path,
+                                       const std::function<ProgressCallback>& update_callback);
     ResultVal<std::size_t> Write(u64 offset, std::size_t length, bool flush,
                                  const u8* buffer) override;
     u64 GetSize() const override;
@@ -79,6 +90,9 @@ public:
     void Flush() const override;
 
 private:
+    ResultCode InstallContentFromFile(u16 index, const std::string& path,
+                                      std::atomic<u64>& progress);
+
     // Whether it's installing an update, and what step of installation it is at
     bool is_update = false;
     CIAInstallState install_state = CIAInstallState::InstallStarted;
@@ -76,7 +76,8 @@ void Module::PortConfig::Clear() {
 void Module::CompletionEventCallBack(u64 port_id, s64) {
     PortConfig& port = ports[port_id];
     const CameraConfig& camera = cameras[port.camera_id];
-    const auto buffer = port.capture_result.get();
+    port.capture_result.get();
+    const std::vector<u16>& buffer = port.frame;
 
     if (port.is_trimming) {
         u32 trim_width;
@@ -168,7 +169,7 @@ void Module::StartReceiving(int port_id) {
             LoadCameraImplementation(camera, port.camera_id);
             camera.impl->StartCapture();
         }
-        return camera.impl->ReceiveFrame();
+        camera.impl->ReceiveFrame(port.frame);
     });
 
     // schedules a completion event according to the frame rate. The event will block on the
@@ -62,6 +62,13 @@ ResultCode ArchiveManager::CloseArchive(ArchiveHandle handle) {
         return RESULT_SUCCESS;
 }
 
+ResultCode ArchiveManager::CommitArchive(ArchiveHandle handle) {
+    ArchiveBackend* archive = GetArchive(handle);
+    if (archive == nullptr)
+        return FileSys::ERR_INVALID_ARCHIVE_HANDLE;
+    return archive->Commit();
+}
+
 // TODO(yuriks): This might be what the fs:REG service is for. See the Register/Unregister calls in
 // http://3dbrew.org/wiki/Filesystem_services#ProgramRegistry_service_.22fs:REG.22
 ResultCode ArchiveManager::RegisterArchiveType(std::unique_ptr<FileSys::ArchiveFactory>&& factory,
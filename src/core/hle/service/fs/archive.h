@@ -14,6 +14,7 @@
 #include "core/hle/result.h"
 #include "core/hle/service/fs/directory.h"
 #include "core/hle/service/fs/file.h"
+#include "core/hle/service/fs/io_thread.h"
 
 /// The unique system identifier hash, also known as ID0
 static constexpr char SYSTEM_ID[]{"00000000000000000000000000000000"};
@@ -72,6 +73,12 @@ public:
      */
     ResultCode CloseArchive(ArchiveHandle handle);
 
+    /**
+     * Commits the pending writes of the files opened from an archive
+     * @param handle Handle to the archive to commit
+     */
+    ResultCode CommitArchive(ArchiveHandle handle);
+
     /**
      * Open a File from an Archive
      * @param archive_handle Handle to an open Archive object
@@ -233,6 +240,11 @@ public:
     /// Registers a new NCCH file with the SelfNCCH archive factory
     void RegisterSelfNCCH(Loader::AppLoader& app_loader);
 
+    /// Returns the thread that performs the I/O of asynchronous file requests
+    IOThread& GetIOThread() {
+        return io_thread;
+    }
+
 private:
     Core::System& system;
 
@@ -260,6 +272,8 @@ private:
      */
     std::unordered_map<ArchiveHandle, std::unique_ptr<ArchiveBackend>> handle_map;
     ArchiveHandle next_handle = 1;
+
+    IOThread io_thread;
 };
 
 } // namespace Service::FS
@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
+#include <future>
+#include <mutex>
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/file_sys/errors.h"
@@ -11,6 +14,7 @@
 #include "core/hle/kernel/client_session.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/server_session.h"
+#include "core/hle/service/fs/archive.h"
 #include "core/hle/service/fs/file.h"
 
 namespace Service::FS {
@@ -50,33 +54,83 @@ void File::Read(Kernel::HLERequestContext& ctx) {
     // This file session might have a specific offset from where to start reading, apply it.
     offset += file->offset;
 
+    std::unique_lock lock{backend_mutex};
     if (offset + length > backend->GetSize()) {
         LOG_ERROR(Service_FS,
                   "Reading from out of bounds offset=0x{:x} length=0x{:08X} file_size=0x{:x}",
                   offset, length, backend->GetSize());
     }
 
+    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
+    if (read_timeout_ns.count() > 0) {
+        lock.unlock();
+        ReadAsync(ctx, offset, length, buffer.GetId(), read_timeout_ns);
+        return;
+    }
+
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
 
-    std::vector<u8> data(length);
-    ResultVal<std::size_t> read = backend->Read(offset, data.size(), data.data());
+    // Read straight into the guest buffer when it's contiguous in host memory
+    std::vector<u8> data;
+    u8* dest = length <= buffer.GetSize() ? buffer.GetWritePointer(0, length) : nullptr;
+    if (dest == nullptr) {
+        data.resize(length);
+        dest = data.data();
+    }
+    ResultVal<std::size_t> read = backend->Read(offset, length, dest);
     if (read.Failed()) {
         rb.Push(read.Code());
         rb.Push<u32>(0);
     } else {
-        buffer.Write(data.data(), 0, *read);
+        if (!data.empty())
+            buffer.Write(data.data(), 0, *read);
         rb.Push(RESULT_SUCCESS);
         rb.Push<u32>(static_cast<u32>(*read));
     }
     rb.PushMappedBuffer(buffer);
+}
 
-    std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
-    ctx.SleepClientThread("file::read", read_timeout_ns,
-                          [](std::shared_ptr<Kernel::Thread> /*thread*/,
-                             Kernel::HLERequestContext& /*ctx*/,
-                             Kernel::ThreadWakeupReason /*reason*/) {
-                              // Nothing to do here
-                          });
+void File::ReadAsync(Kernel::HLERequestContext& ctx, u64 offset, u32 length, u32 buffer_id,
+                     std::chrono::nanoseconds delay) {
+    struct ReadState {
+        std::vector<u8> data;
+        ResultVal<std::size_t> result = ResultCode(-1);
+    };
+    auto state = std::make_shared<ReadState>();
+    state->data.resize(length);
+
+    // The read runs on the I/O thread while the client thread sleeps for the simulated delay, so
+    // that the host disk latency overlaps with emulation
+    auto self = std::static_pointer_cast<File>(shared_from_this());
+    std::shared_future<void> done =
+        system.ArchiveManager()
+            .GetIOThread()
+            .Queue([self, state, offset] {
+                std::lock_guard lock{self->backend_mutex};
+                state->result = self->backend->Read(offset, state->data.size(), state->data.data());
+            })
+            .share();
+
+    ctx.SleepClientThread(
+        "file::read", delay,
+        [state, done, buffer_id](std::shared_ptr<Kernel::Thread> /*thread*/,
+                                 Kernel::HLERequestContext& ctx,
+                                 Kernel::ThreadWakeupReason /*reason*/) {
+            // Only stalls the emulation if the host took longer than the simulated delay
+            done.wait();
+
+            IPC::RequestBuilder rb(ctx, 0x0802, 2, 2);
+            Kernel::MappedBuffer& buffer = ctx.GetMappedBuffer(buffer_id);
+            if (state->result.Failed()) {
+                rb.Push(state->result.Code());
+                rb.Push<u32>(0);
+            } else {
+                buffer.Write(state->data.data(), 0, *state->result);
+                rb.Push(RESULT_SUCCESS);
+                rb.Push<u32>(static_cast<u32>(*state->result));
+            }
+            rb.PushMappedBuffer(buffer);
+        });
 }
 
 void File::Write(Kernel::HLERequestContext& ctx) {
@@ -100,9 +154,15 @@ void File::Write(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    std::vector<u8> data(length);
-    buffer.Read(data.data(), 0, data.size());
-    ResultVal<std::size_t> written = backend->Write(offset, data.size(), flush != 0, data.data());
+    std::vector<u8> data;
+    const u8* src = buffer.GetReadPointer(0, length);
+    if (src == nullptr) {
+        data.resize(length);
+        buffer.Read(data.data(), 0, data.size());
+        src = data.data();
+    }
+    std::lock_guard lock{backend_mutex};
+    ResultVal<std::size_t> written = backend->Write(offset, length, flush != 0, src);
 
     // Update file size
     file->size = backend->GetSize();
@@ -142,6 +202,7 @@ void File::SetSize(Kernel::HLERequestContext& ctx) {
     }
 
     file->size = size;
+    std::lock_guard lock{backend_mutex};
     backend->SetSize(size);
     rb.Push(RESULT_SUCCESS);
 }
@@ -154,7 +215,10 @@ void File::Close(Kernel::HLERequestContext& ctx) {
         LOG_WARNING(Service_FS, "Closing File backend but {} clients still connected",
                     connected_sessions.size());
 
-    backend->Close();
+    {
+        std::lock_guard lock{backend_mutex};
+        backend->Close();
+    }
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
 }
@@ -172,6 +236,7 @@ void File::Flush(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    std::lock_guard lock{backend_mutex};
     backend->Flush();
     rb.Push(RESULT_SUCCESS);
 }
@@ -209,7 +274,10 @@ void File::OpenLinkFile(Kernel::HLERequestContext& ctx) {
 
     slot->priority = original_file->priority;
     slot->offset = 0;
-    slot->size = backend->GetSize();
+    {
+        std::lock_guard lock{backend_mutex};
+        slot->size = backend->GetSize();
+    }
     slot->subfile = false;
 
     rb.Push(RESULT_SUCCESS);
@@ -267,7 +335,10 @@ std::shared_ptr<Kernel::ClientSession> File::Connect() {
     FileSessionSlot* slot = GetSessionData(server);
     slot->priority = 0;
     slot->offset = 0;
-    slot->size = backend->GetSize();
+    {
+        std::lock_guard lock{backend_mutex};
+        slot->size = backend->GetSize();
+    }
     slot->subfile = false;
 
     return client;
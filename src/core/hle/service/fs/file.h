@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include "core/file_sys/archive_backend.h"
 #include "core/hle/service/service.h"
 
@@ -35,6 +37,8 @@ public:
 
     FileSys::Path path;                            ///< Path of the file
     std::unique_ptr<FileSys::FileBackend> backend; ///< File backend interface
+    /// Serializes the accesses to the backend with the reads running on the FS I/O thread
+    std::mutex backend_mutex;
 
     /// Creates a new session to this File and returns the ClientSession part of the connection.
     std::shared_ptr<Kernel::ClientSession> Connect();
@@ -49,6 +53,9 @@ public:
 
 private:
     void Read(Kernel::HLERequestContext& ctx);
+    /// Reads the file on the I/O thread and replies once the client thread wakes up again
+    void ReadAsync(Kernel::HLERequestContext& ctx, u64 offset, u32 length, u32 buffer_id,
+                   std::chrono::nanoseconds delay);
     void Write(Kernel::HLERequestContext& ctx);
     void GetSize(Kernel::HLERequestContext& ctx);
     void SetSize(Kernel::HLERequestContext& ctx);
@@ -343,6 +343,26 @@ void FS_USER::OpenArchive(Kernel::HLERequestContext& ctx) {
     }
 }
 
+void FS_USER::ControlArchive(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x80D, 5, 4);
+    const auto archive_handle = rp.PopRaw<ArchiveHandle>();
+    const auto action = rp.Pop<u32>();
+    rp.Skip(2, false); // Input and output sizes
+    auto& input = rp.PopMappedBuffer();
+    auto& output = rp.PopMappedBuffer();
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 4);
+    if (action == 0) {
+        // Commit the save data
+        rb.Push(archives.CommitArchive(archive_handle));
+    } else {
+        LOG_WARNING(Service_FS, "(STUBBED) action={}", action);
+        rb.Push(RESULT_SUCCESS);
+    }
+    rb.PushMappedBuffer(input);
+    rb.PushMappedBuffer(output);
+}
+
 void FS_USER::CloseArchive(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x80E, 2, 0);
     auto archive_handle = rp.PopRaw<ArchiveHandle>();
@@ -791,7 +811,7 @@ FS_USER::FS_USER(Core::System& system)
         {0x080A0244, &FS_USER::RenameDirectory, "RenameDirectory"},
         {0x080B0102, &FS_USER::OpenDirectory, "OpenDirectory"},
         {0x080C00C2, &FS_USER::OpenArchive, "OpenArchive"},
-        {0x080D0144, nullptr, "ControlArchive"},
+        {0x080D0144, &FS_USER::ControlArchive, "ControlArchive"},
         {0x080E0080, &FS_USER::CloseArchive, "CloseArchive"},
         {0x080F0180, &FS_USER::FormatThisUserSaveData, "FormatThisUserSaveData"},
         {0x08100200, &FS_USER::CreateLegacySystemSaveData, "CreateLegacySystemSaveData"},
@@ -0,0 +1,50 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/thread.h"
+#include "core/hle/service/fs/io_thread.h"
+
+namespace Service::FS {
+
+IOThread::IOThread() : thread(&IOThread::ThreadLoop, this) {}
+
+IOThread::~IOThread() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    queued.notify_one();
+    thread.join();
+}
+
+std::future<void> IOThread::Queue(std::function<void()> operation) {
+    std::packaged_task<void()> task{std::move(operation)};
+    std::future<void> future = task.get_future();
+    {
+        std::lock_guard lock{mutex};
+        operations.push_back(std::move(task));
+    }
+    queued.notify_one();
+    return future;
+}
+
+void IOThread::ThreadLoop() {
+    Common::SetCurrentThreadName("FS IO");
+
+    while (true) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock lock{mutex};
+            // Queued operations are still run when stopping, as their requesters wait for them
+            queued.wait(lock, [this] { return stop || !operations.empty(); });
+            if (operations.empty())
+                return;
+            task = std::move(operations.front());
+            operations.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace Service::FS
@@ -0,0 +1,44 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include "common/common_types.h"
+
+namespace Service::FS {
+
+/**
+ * Host thread that performs the file I/O of FS requests, so that the emulation thread can keep
+ * running while the guest thread that made the request sleeps for its simulated delay. The
+ * operations run one at a time in the order they were queued, like the FS sysmodule handles its
+ * requests.
+ */
+class IOThread : NonCopyable {
+public:
+    IOThread();
+    ~IOThread();
+
+    /**
+     * Queues an operation to run on the I/O thread.
+     * @returns Future that becomes ready once the operation has been run
+     */
+    std::future<void> Queue(std::function<void()> operation);
+
+private:
+    void ThreadLoop();
+
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::deque<std::packaged_task<void()>> operations;
+    bool stop = false;
+    std::thread thread;
+};
+
+} // namespace Service::FS
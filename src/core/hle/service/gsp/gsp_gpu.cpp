@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <utility>
 #include <vector>
 #include "common/bit_field.h"
 #include "common/microprofile.h"
@@ -473,7 +475,46 @@ void GSP_GPU::SignalInterrupt(InterruptId interrupt_id) {
 
 MICROPROFILE_DEFINE(GPU_GSP_DMA, "GPU", "GSP DMA", MP_RGB(100, 0, 255));
 
-/// Executes the next GSP command
+/**
+ * Executes a run of consecutive DMA requests. All sources are flushed from the rasterizer cache
+ * and all destinations invalidated before the copies, merging the regions of the whole run, and a
+ * single DMA interrupt is signaled for it.
+ */
+static void ExecuteDMABatch(const std::vector<Command>& commands) {
+    if (commands.empty())
+        return;
+
+    MICROPROFILE_SCOPE(GPU_GSP_DMA);
+    Memory::MemorySystem& memory = Core::System::GetInstance().Memory();
+
+    // TODO: Consider attempting rasterizer-accelerated surface blit if that usage is ever
+    // possible/likely
+    Memory::RasterizerCacheBatch batch;
+    for (const Command& command : commands) {
+        const auto& request = command.dma_request;
+        batch.Add(request.source_address, request.size, Memory::FlushMode::Flush);
+    }
+    for (const Command& command : commands) {
+        const auto& request = command.dma_request;
+        batch.Add(request.dest_address, request.size, Memory::FlushMode::Invalidate);
+    }
+    batch.Apply();
+
+    for (const Command& command : commands) {
+        // TODO(Subv): These memory accesses should not go through the application's memory
+        // mapping. They should go through the GSP module's memory mapping.
+        memory.CopyBlock(*Core::System::GetInstance().Kernel().GetCurrentProcess(),
+                         command.dma_request.dest_address, command.dma_request.source_address,
+                         command.dma_request.size);
+
+        if (Pica::g_debug_context)
+            Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::GSPCommandProcessed,
+                                           (void*)&command);
+    }
+    SignalInterrupt(InterruptId::DMA);
+}
+
+/// Executes the next GSP command, DMA requests go through ExecuteDMABatch instead
 static void ExecuteCommand(const Command& command, u32 thread_id) {
     // Utility function to convert register ID to address
     static auto WriteGPURegister = [](u32 id, u32 data) {
@@ -483,26 +524,10 @@ static void ExecuteCommand(const Command& command, u32 thread_id) {
     switch (command.id) {
 
     // GX request DMA - typically used for copying memory from GSP heap to VRAM
-    case CommandId::REQUEST_DMA: {
-        MICROPROFILE_SCOPE(GPU_GSP_DMA);
-        Memory::MemorySystem& memory = Core::System::GetInstance().Memory();
-
-        // TODO: Consider attempting rasterizer-accelerated surface blit if that usage is ever
-        // possible/likely
-        Memory::RasterizerFlushVirtualRegion(command.dma_request.source_address,
-                                             command.dma_request.size, Memory::FlushMode::Flush);
-        Memory::RasterizerFlushVirtualRegion(command.dma_request.dest_address,
-                                             command.dma_request.size,
-                                             Memory::FlushMode::Invalidate);
-
-        // TODO(Subv): These memory accesses should not go through the application's memory mapping.
-        // They should go through the GSP module's memory mapping.
-        memory.CopyBlock(*Core::System::GetInstance().Kernel().GetCurrentProcess(),
-                         command.dma_request.dest_address, command.dma_request.source_address,
-                         command.dma_request.size);
-        SignalInterrupt(InterruptId::DMA);
+    case CommandId::REQUEST_DMA:
+        ExecuteDMABatch({command});
         break;
-    }
+
     // TODO: This will need some rework in the future. (why?)
     case CommandId::SUBMIT_GPU_CMDLIST: {
         auto& params = command.submit_gpu_cmdlist;
@@ -627,20 +652,34 @@ void GSP_GPU::SetLcdForceBlack(Kernel::HLERequestContext& ctx) {
 void GSP_GPU::TriggerCmdReqQueue(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0xC, 0, 0);
 
+    std::vector<Command> dma_batch;
+
     // Iterate through each thread's command queue...
     for (unsigned thread_id = 0; thread_id < 0x4; ++thread_id) {
         CommandBuffer* command_buffer = (CommandBuffer*)GetCommandBuffer(shared_memory, thread_id);
 
-        // Iterate through each command...
-        for (unsigned i = 0; i < command_buffer->number_commands; ++i) {
-            g_debugger.GXCommandProcessed((u8*)&command_buffer->commands[i]);
-
-            // Decode and execute command
-            ExecuteCommand(command_buffer->commands[i], thread_id);
+        // Drain the whole queue, starting at the current command index like the real GSP module
+        while (command_buffer->number_commands > 0) {
+            const u32 index = command_buffer->index % std::size(command_buffer->commands);
+            const Command command = command_buffer->commands[index];
+            g_debugger.GXCommandProcessed((u8*)&command_buffer->commands[index]);
 
             // Indicates that command has completed
+            command_buffer->index.Assign((index + 1) % std::size(command_buffer->commands));
             command_buffer->number_commands.Assign(command_buffer->number_commands - 1);
+
+            // Decode and execute command, consecutive DMA requests are executed together
+            if (command.id == CommandId::REQUEST_DMA) {
+                dma_batch.push_back(command);
+                continue;
+            }
+            ExecuteDMABatch(dma_batch);
+            dma_batch.clear();
+            ExecuteCommand(command, thread_id);
         }
+
+        ExecuteDMABatch(dma_batch);
+        dma_batch.clear();
     }
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include "common/logging/log.h"
+#include "common/thread.h"
 #include "core/3ds.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -18,6 +19,7 @@
 #include "core/hle/service/hid/hid_user.h"
 #include "core/hle/service/service.h"
 #include "core/movie.h"
+#include "core/perf_metrics.h"
 #include "video_core/video_core.h"
 
 namespace Service::HID {
@@ -27,6 +29,15 @@ constexpr u64 pad_update_ticks = BASE_CLOCK_RATE_ARM11 / 234;
 constexpr u64 accelerometer_update_ticks = BASE_CLOCK_RATE_ARM11 / 104;
 constexpr u64 gyroscope_update_ticks = BASE_CLOCK_RATE_ARM11 / 101;
 
+// The updates may fire up to 0.1 ms late to share a wakeup with other events
+constexpr s64 update_slack_ticks = BASE_CLOCK_RATE_ARM11 / 10000;
+
+// Number of motion samples kept for averaging, enough for 1000 samples per second
+constexpr std::size_t max_motion_samples = 64;
+
+// Polling the devices faster than the pad is updated keeps the latency of the snapshot low
+constexpr std::chrono::milliseconds input_poll_interval{1};
+
 constexpr float accelerometer_coef = 512.0f; // measured from hw test result
 constexpr float gyroscope_coef = 14.375f; // got from hwtest GetGyroscopeLowRawToDpsCoefficient call
 
@@ -59,7 +70,7 @@ DirectionState GetStickDirectionState(s16 circle_pad_x, s16 circle_pad_y) {
     return state;
 }
 
-void Module::LoadInputDevices() {
+void Module::LoadPadDevices() {
     std::transform(Settings::values.current_input_profile.buttons.begin() +
                        Settings::NativeButton::BUTTON_HID_BEGIN,
                    Settings::values.current_input_profile.buttons.begin() +
@@ -67,40 +78,78 @@ void Module::LoadInputDevices() {
                    buttons.begin(), Input::CreateDevice<Input::ButtonDevice>);
     circle_pad = Input::CreateDevice<Input::AnalogDevice>(
         Settings::values.current_input_profile.analogs[Settings::NativeAnalog::CirclePad]);
-    motion_device = Input::CreateDevice<Input::MotionDevice>(
-        Settings::values.current_input_profile.motion_device);
     touch_device = Input::CreateDevice<Input::TouchDevice>(
         Settings::values.current_input_profile.touch_device);
 }
 
+void Module::InputThreadLoop() {
+    Common::SetCurrentThreadName("HID_Input");
+
+    InputSnapshot last_snapshot{};
+    std::unique_lock lock{input_thread_mutex};
+    while (!stop_input_thread) {
+        lock.unlock();
+
+        if (is_device_reload_pending.exchange(false))
+            LoadPadDevices();
+
+        using namespace Settings::NativeButton;
+        PadState pad{};
+        pad.a.Assign(buttons[A - BUTTON_HID_BEGIN]->GetStatus());
+        pad.b.Assign(buttons[B - BUTTON_HID_BEGIN]->GetStatus());
+        pad.x.Assign(buttons[X - BUTTON_HID_BEGIN]->GetStatus());
+        pad.y.Assign(buttons[Y - BUTTON_HID_BEGIN]->GetStatus());
+        pad.right.Assign(buttons[Right - BUTTON_HID_BEGIN]->GetStatus());
+        pad.left.Assign(buttons[Left - BUTTON_HID_BEGIN]->GetStatus());
+        pad.up.Assign(buttons[Up - BUTTON_HID_BEGIN]->GetStatus());
+        pad.down.Assign(buttons[Down - BUTTON_HID_BEGIN]->GetStatus());
+        pad.l.Assign(buttons[L - BUTTON_HID_BEGIN]->GetStatus());
+        pad.r.Assign(buttons[R - BUTTON_HID_BEGIN]->GetStatus());
+        pad.start.Assign(buttons[Start - BUTTON_HID_BEGIN]->GetStatus());
+        pad.select.Assign(buttons[Select - BUTTON_HID_BEGIN]->GetStatus());
+        pad.debug.Assign(buttons[Debug - BUTTON_HID_BEGIN]->GetStatus());
+        pad.gpio14.Assign(buttons[Gpio14 - BUTTON_HID_BEGIN]->GetStatus());
+
+        InputSnapshot snapshot{};
+        snapshot.buttons = pad.hex;
+        std::tie(snapshot.circle_pad_x, snapshot.circle_pad_y) = circle_pad->GetStatus();
+        std::tie(snapshot.touch_x, snapshot.touch_y, snapshot.touch_pressed) =
+            touch_device->GetStatus();
+        // Only buttons and touch presses are timed, the analog inputs change all the time
+        const bool changed = snapshot.buttons != last_snapshot.buttons ||
+                             snapshot.touch_pressed != last_snapshot.touch_pressed;
+        snapshot.change_time = changed ? std::chrono::steady_clock::now()
+                                       : last_snapshot.change_time;
+        input_snapshot.Write(snapshot);
+        last_snapshot = snapshot;
+
+        lock.lock();
+        input_thread_stop.wait_for(lock, input_poll_interval,
+                                   [this] { return stop_input_thread; });
+    }
+}
+
 void Module::UpdatePadCallback(u64 userdata, s64 cycles_late) {
     SharedMem* mem = reinterpret_cast<SharedMem*>(shared_mem->GetPointer());
 
-    if (is_device_reload_pending.exchange(false))
-        LoadInputDevices();
-
-    using namespace Settings::NativeButton;
-    state.a.Assign(buttons[A - BUTTON_HID_BEGIN]->GetStatus());
-    state.b.Assign(buttons[B - BUTTON_HID_BEGIN]->GetStatus());
-    state.x.Assign(buttons[X - BUTTON_HID_BEGIN]->GetStatus());
-    state.y.Assign(buttons[Y - BUTTON_HID_BEGIN]->GetStatus());
-    state.right.Assign(buttons[Right - BUTTON_HID_BEGIN]->GetStatus());
-    state.left.Assign(buttons[Left - BUTTON_HID_BEGIN]->GetStatus());
-    state.up.Assign(buttons[Up - BUTTON_HID_BEGIN]->GetStatus());
-    state.down.Assign(buttons[Down - BUTTON_HID_BEGIN]->GetStatus());
-    state.l.Assign(buttons[L - BUTTON_HID_BEGIN]->GetStatus());
-    state.r.Assign(buttons[R - BUTTON_HID_BEGIN]->GetStatus());
-    state.start.Assign(buttons[Start - BUTTON_HID_BEGIN]->GetStatus());
-    state.select.Assign(buttons[Select - BUTTON_HID_BEGIN]->GetStatus());
-    state.debug.Assign(buttons[Debug - BUTTON_HID_BEGIN]->GetStatus());
-    state.gpio14.Assign(buttons[Gpio14 - BUTTON_HID_BEGIN]->GetStatus());
+    if (is_motion_device_reload_pending.exchange(false)) {
+        motion_device = Input::CreateDevice<Input::MotionDevice>(
+            Settings::values.current_input_profile.motion_device);
+        motion_samples.clear();
+    }
+
+    const InputSnapshot input = input_snapshot.Read();
+    state.hex = input.buttons;
+    if (input.change_time != last_change_time) {
+        // The frame the guest renders after reading this change times its latency
+        Core::Metrics::MarkInput(input.change_time);
+        last_change_time = input.change_time;
+    }
 
     // Get current circle pad position and update circle pad direction
-    float circle_pad_x_f, circle_pad_y_f;
-    std::tie(circle_pad_x_f, circle_pad_y_f) = circle_pad->GetStatus();
     constexpr int MAX_CIRCLEPAD_POS = 0x9C; // Max value for a circle pad position
-    s16 circle_pad_x = static_cast<s16>(circle_pad_x_f * MAX_CIRCLEPAD_POS);
-    s16 circle_pad_y = static_cast<s16>(circle_pad_y_f * MAX_CIRCLEPAD_POS);
+    s16 circle_pad_x = static_cast<s16>(input.circle_pad_x * MAX_CIRCLEPAD_POS);
+    s16 circle_pad_y = static_cast<s16>(input.circle_pad_y * MAX_CIRCLEPAD_POS);
 
     Core::Movie::GetInstance().HandlePadAndCircleStatus(state, circle_pad_x, circle_pad_y);
 
@@ -142,12 +191,9 @@ void Module::UpdatePadCallback(u64 userdata, s64 cycles_late) {
 
     // Get the current touch entry
     TouchDataEntry& touch_entry = mem->touch.entries[mem->touch.index];
-    bool pressed = false;
-    float x, y;
-    std::tie(x, y, pressed) = touch_device->GetStatus();
-    touch_entry.x = static_cast<u16>(x * Core::kScreenBottomWidth);
-    touch_entry.y = static_cast<u16>(y * Core::kScreenBottomHeight);
-    touch_entry.valid.Assign(pressed ? 1 : 0);
+    touch_entry.x = static_cast<u16>(input.touch_x * Core::kScreenBottomWidth);
+    touch_entry.y = static_cast<u16>(input.touch_y * Core::kScreenBottomHeight);
+    touch_entry.valid.Assign(input.touch_pressed ? 1 : 0);
 
     Core::Movie::GetInstance().HandleTouchStatus(touch_entry);
 
@@ -173,6 +219,35 @@ void Module::UpdatePadCallback(u64 userdata, s64 cycles_late) {
     system.CoreTiming().ScheduleEvent(pad_update_ticks - cycles_late, pad_update_event);
 }
 
+std::tuple<Common::Vec3<float>, Common::Vec3<float>> Module::SampleMotion(
+    std::chrono::steady_clock::time_point& last_sample_time) {
+    if (!motion_device->PopSamples(motion_samples))
+        return motion_device->GetStatus();
+    if (motion_samples.size() > max_motion_samples) {
+        motion_samples.erase(motion_samples.begin(), motion_samples.end() - max_motion_samples);
+    }
+    if (motion_samples.empty())
+        return motion_device->GetStatus();
+
+    Common::Vec3<float> accel{};
+    Common::Vec3<float> gyro{};
+    std::size_t count = 0;
+    for (auto it = motion_samples.rbegin();
+         it != motion_samples.rend() && it->timestamp > last_sample_time; ++it) {
+        accel += it->accel;
+        gyro += it->gyro;
+        ++count;
+    }
+
+    const Input::MotionSample& latest = motion_samples.back();
+    if (count == 0)
+        return {latest.accel, latest.gyro};
+
+    last_sample_time = latest.timestamp;
+    const float scale = 1.0f / count;
+    return {accel * scale, gyro * scale};
+}
+
 void Module::UpdateAccelerometerCallback(u64 userdata, s64 cycles_late) {
     SharedMem* mem = reinterpret_cast<SharedMem*>(shared_mem->GetPointer());
 
@@ -180,7 +255,7 @@ void Module::UpdateAccelerometerCallback(u64 userdata, s64 cycles_late) {
     next_accelerometer_index = (next_accelerometer_index + 1) % mem->accelerometer.entries.size();
 
     Common::Vec3<float> accel;
-    std::tie(accel, std::ignore) = motion_device->GetStatus();
+    std::tie(accel, std::ignore) = SampleMotion(accelerometer_sample_time);
     accel *= accelerometer_coef;
     // TODO(wwylele): do a time stretch like the one in UpdateGyroscopeCallback
     // The time stretch formula should be like
@@ -227,7 +302,7 @@ void Module::UpdateGyroscopeCallback(u64 userdata, s64 cycles_late) {
     GyroscopeDataEntry& gyroscope_entry = mem->gyroscope.entries[mem->gyroscope.index];
 
     Common::Vec3<float> gyro;
-    std::tie(std::ignore, gyro) = motion_device->GetStatus();
+    std::tie(std::ignore, gyro) = SampleMotion(gyroscope_sample_time);
     double stretch = system.perf_stats->GetLastFrameTimeScale();
     gyro *= gyroscope_coef * static_cast<float>(stretch);
     gyroscope_entry.x = static_cast<s16>(gyro.x);
@@ -386,24 +461,38 @@ Module::Module(Core::System& system) : system(system) {
 
     // Register update callbacks
     Core::Timing& timing = system.CoreTiming();
-    pad_update_event =
-        timing.RegisterEvent("HID::UpdatePadCallback", [this](u64 userdata, s64 cycles_late) {
-            UpdatePadCallback(userdata, cycles_late);
-        });
+    pad_update_event = timing.RegisterEvent(
+        "HID::UpdatePadCallback",
+        [this](u64 userdata, s64 cycles_late) { UpdatePadCallback(userdata, cycles_late); },
+        update_slack_ticks);
     accelerometer_update_event = timing.RegisterEvent(
-        "HID::UpdateAccelerometerCallback", [this](u64 userdata, s64 cycles_late) {
+        "HID::UpdateAccelerometerCallback",
+        [this](u64 userdata, s64 cycles_late) {
             UpdateAccelerometerCallback(userdata, cycles_late);
-        });
-    gyroscope_update_event =
-        timing.RegisterEvent("HID::UpdateGyroscopeCallback", [this](u64 userdata, s64 cycles_late) {
-            UpdateGyroscopeCallback(userdata, cycles_late);
-        });
+        },
+        update_slack_ticks);
+    gyroscope_update_event = timing.RegisterEvent(
+        "HID::UpdateGyroscopeCallback",
+        [this](u64 userdata, s64 cycles_late) { UpdateGyroscopeCallback(userdata, cycles_late); },
+        update_slack_ticks);
 
     timing.ScheduleEvent(pad_update_ticks, pad_update_event);
+
+    input_thread = std::thread([this] { InputThreadLoop(); });
+}
+
+Module::~Module() {
+    {
+        std::lock_guard lock{input_thread_mutex};
+        stop_input_thread = true;
+    }
+    input_thread_stop.notify_all();
+    input_thread.join();
 }
 
 void Module::ReloadInputDevices() {
     is_device_reload_pending.store(true);
+    is_motion_device_reload_pending.store(true);
 }
 
 const PadState& Module::GetState() const {
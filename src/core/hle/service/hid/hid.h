@@ -6,11 +6,18 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
 #include "common/bit_field.h"
 #include "common/common_funcs.h"
 #include "common/common_types.h"
+#include "common/seqlock.h"
 #include "core/frontend/input.h"
 #include "core/hle/service/service.h"
 #include "core/settings.h"
@@ -197,6 +204,7 @@ DirectionState GetStickDirectionState(s16 circle_pad_x, s16 circle_pad_y);
 class Module final {
 public:
     explicit Module(Core::System& system);
+    ~Module();
 
     class Interface : public ServiceFramework<Interface> {
     public:
@@ -296,8 +304,28 @@ public:
     const PadState& GetState() const;
 
 private:
-    void LoadInputDevices();
+    /// State of the pad devices as seen by the last poll of the input thread
+    struct InputSnapshot {
+        u32 buttons;
+        float circle_pad_x;
+        float circle_pad_y;
+        float touch_x;
+        float touch_y;
+        bool touch_pressed;
+        /// When the input thread first polled the current buttons and touch press
+        std::chrono::steady_clock::time_point change_time;
+    };
+
+    /// Loads the devices that are polled by the input thread, only called on that thread
+    void LoadPadDevices();
+    void InputThreadLoop();
     void UpdatePadCallback(u64 userdata, s64 cycles_late);
+    /**
+     * Averages the motion samples the device received after the given time point and moves the
+     * time point to the newest of them. Without new samples the latest motion status is returned.
+     */
+    std::tuple<Common::Vec3<float>, Common::Vec3<float>> SampleMotion(
+        std::chrono::steady_clock::time_point& last_sample_time);
     void UpdateAccelerometerCallback(u64 userdata, s64 cycles_late);
     void UpdateGyroscopeCallback(u64 userdata, s64 cycles_late);
 
@@ -330,11 +358,28 @@ private:
     Core::TimingEventType* gyroscope_update_event;
 
     std::atomic<bool> is_device_reload_pending{true};
+    std::atomic<bool> is_motion_device_reload_pending{true};
     std::array<std::unique_ptr<Input::ButtonDevice>, Settings::NativeButton::NUM_BUTTONS_HID>
         buttons;
     std::unique_ptr<Input::AnalogDevice> circle_pad;
     std::unique_ptr<Input::MotionDevice> motion_device;
     std::unique_ptr<Input::TouchDevice> touch_device;
+
+    // Motion devices can deliver samples much faster than the shared memory is updated, so the
+    // samples in between are averaged instead of only using the latest one.
+    std::vector<Input::MotionSample> motion_samples;
+    std::chrono::steady_clock::time_point accelerometer_sample_time;
+    std::chrono::steady_clock::time_point gyroscope_sample_time;
+
+    // The pad devices are polled on their own thread, as frontends like SDL lock on every query.
+    // The pad update only has to read the latest snapshot then.
+    Common::SeqLock<InputSnapshot> input_snapshot;
+    /// Change time of the last snapshot written to the shared memory, only used on that thread
+    std::chrono::steady_clock::time_point last_change_time{};
+    std::thread input_thread;
+    std::mutex input_thread_mutex;
+    std::condition_variable input_thread_stop;
+    bool stop_input_thread = false;
 };
 
 std::shared_ptr<Module> GetModule(Core::System& system);
@@ -2,18 +2,26 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
 #ifdef ENABLE_WEB_SERVICE
 #include <LUrlParser.h>
 #endif
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include <fmt/format.h>
 #include "common/assert.h"
+#include "common/thread.h"
 #include "core/core.h"
 #include "core/file_sys/archive_ncch.h"
 #include "core/file_sys/file_backend.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/ipc.h"
+#include "core/hle/lock.h"
 #include "core/hle/romfs.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/hle/service/http_c.h"
@@ -26,7 +34,9 @@ enum {
     InvalidRequestState = 22,
     TooManyContexts = 26,
     InvalidRequestMethod = 32,
+    DownloadPending = 43,
     ContextNotFound = 100,
+    Timeout = 105,
 
     /// This error is returned in multiple situations: when trying to initialize an
     /// already-initialized session, or when using the wrong context handle in a context-bound
@@ -40,6 +50,18 @@ enum {
 const ResultCode ERROR_STATE_ERROR = // 0xD8A0A066
     ResultCode(ErrCodes::SessionStateError, ErrorModule::HTTP, ErrorSummary::InvalidState,
                ErrorLevel::Permanent);
+const ResultCode ERROR_INVALID_REQUEST_STATE = // 0xD8A0A016
+    ResultCode(ErrCodes::InvalidRequestState, ErrorModule::HTTP, ErrorSummary::InvalidState,
+               ErrorLevel::Permanent);
+const ResultCode ERROR_DOWNLOAD_PENDING = // 0xD840A02B
+    ResultCode(ErrCodes::DownloadPending, ErrorModule::HTTP, ErrorSummary::WouldBlock,
+               ErrorLevel::Permanent);
+const ResultCode ERROR_CONTEXT_NOT_FOUND = // 0xD8A0A064
+    ResultCode(ErrCodes::ContextNotFound, ErrorModule::HTTP, ErrorSummary::InvalidState,
+               ErrorLevel::Permanent);
+const ResultCode ERROR_TIMEOUT = // 0xD820A069
+    ResultCode(ErrCodes::Timeout, ErrorModule::HTTP, ErrorSummary::NothingHappened,
+               ErrorLevel::Permanent);
 const ResultCode ERROR_NOT_IMPLEMENTED = // 0xD960A3F4
     ResultCode(ErrCodes::NotImplemented, ErrorModule::HTTP, ErrorSummary::Internal,
                ErrorLevel::Permanent);
@@ -53,24 +75,129 @@ const ResultCode ERROR_WRONG_CERT_HANDLE = // 0xD8A0A0C9
 const ResultCode ERROR_CERT_ALREADY_SET = // 0xD8A0A03D
     ResultCode(61, ErrorModule::HTTP, ErrorSummary::InvalidState, ErrorLevel::Permanent);
 
-void Context::MakeRequest() {
+/// Keeps the clients of finished requests, so that the next request to the same host doesn't have
+/// to set up a new client and SSL context.
+class ClientPool {
+public:
+#ifdef ENABLE_WEB_SERVICE
+    /// Takes an idle client out of the pool, returns nullptr if there is none for the key
+    std::unique_ptr<httplib::Client> Acquire(const std::string& key) {
+        std::lock_guard lock{mutex};
+        const auto itr = idle_clients.find(key);
+        if (itr == idle_clients.end())
+            return nullptr;
+        std::unique_ptr<httplib::Client> client = std::move(itr->second);
+        idle_clients.erase(itr);
+        return client;
+    }
+
+    void Release(const std::string& key, std::unique_ptr<httplib::Client> client) {
+        std::lock_guard lock{mutex};
+        if (idle_clients.count(key) < MaxIdleClientsPerKey) {
+            idle_clients.emplace(key, std::move(client));
+        }
+    }
+
+private:
+    /// One per worker, as that many requests to a host can be in progress at the same time
+    static constexpr std::size_t MaxIdleClientsPerKey = 3;
+
+    std::mutex mutex;
+    std::unordered_multimap<std::string, std::unique_ptr<httplib::Client>> idle_clients;
+#endif
+};
+
+/// Number of requests that are sent at the same time, the rest waits in the queue
+constexpr std::size_t NUM_REQUEST_WORKERS = 3;
+
+/**
+ * Sends the requests of the HTTP contexts on NUM_REQUEST_WORKERS worker threads in the order they
+ * were begun. On a 3DS BeginRequest and BeginRequestAsync push the request to a worker queue as
+ * well, from which the worker threads of the HTTP module pop the requests and send them.
+ */
+class RequestExecutor {
+public:
+    explicit RequestExecutor(std::size_t num_workers) {
+        workers.reserve(num_workers);
+        for (std::size_t i = 0; i < num_workers; ++i) {
+            workers.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    ~RequestExecutor() {
+        {
+            std::lock_guard lock{mutex};
+            stop = true;
+        }
+        queue_changed.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void Enqueue(std::shared_ptr<Context> context) {
+        {
+            std::lock_guard lock{mutex};
+            queue.push_back(std::move(context));
+        }
+        queue_changed.notify_one();
+    }
+
+private:
+    void WorkerLoop() {
+        Common::SetCurrentThreadName("HTTP_Worker");
+        while (true) {
+            std::shared_ptr<Context> context;
+            {
+                std::unique_lock lock{mutex};
+                queue_changed.wait(lock, [this] { return stop || !queue.empty(); });
+                if (stop)
+                    break;
+                context = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            // Contexts closed while they were queued are dropped, nobody waits for them anymore
+            if (!context->cancelled) {
+                context->MakeRequest(pool);
+            }
+        }
+    }
+
+    ClientPool pool;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable queue_changed;
+    std::deque<std::shared_ptr<Context>> queue;
+    bool stop = false;
+};
+
+void Context::MakeRequest(ClientPool& pool) {
     ASSERT(state == RequestState::NotStarted);
 
 #ifdef ENABLE_WEB_SERVICE
     LUrlParser::clParseURL parsedUrl = LUrlParser::clParseURL::ParseURL(url);
+    const bool is_ssl = parsedUrl.m_Scheme != "http";
     int port;
-    std::unique_ptr<httplib::Client> client;
-    if (parsedUrl.m_Scheme == "http") {
-        if (!parsedUrl.GetPort(&port)) {
-            port = 80;
-        }
+    if (!parsedUrl.GetPort(&port)) {
+        port = is_ssl ? 443 : 80;
+    }
+
+    // Clients can be shared by requests to the same host that send the same client certificate
+    const auto client_cert = ssl_config.client_cert_ctx.lock();
+    const std::string client_key =
+        fmt::format("{}://{}:{}/{}", parsedUrl.m_Scheme, parsedUrl.m_Host, port,
+                    client_cert ? client_cert->handle : 0);
+
+    std::unique_ptr<httplib::Client> client = pool.Acquire(client_key);
+    if (client) {
+        LOG_DEBUG(Service_HTTP, "Reusing the client of {}", client_key);
+    } else if (!is_ssl) {
         // TODO(B3N30): Support for setting timeout
         // Figure out what the default timeout on 3DS is
         client = std::make_unique<httplib::Client>(parsedUrl.m_Host.c_str(), port);
     } else {
-        if (!parsedUrl.GetPort(&port)) {
-            port = 443;
-        }
         // TODO(B3N30): Support for setting timeout
         // Figure out what the default timeout on 3DS is
 
@@ -78,7 +205,7 @@ void Context::MakeRequest() {
         SSL_CTX* ctx = ssl_client->ssl_context();
         client = std::move(ssl_client);
 
-        if (auto client_cert = ssl_config.client_cert_ctx.lock()) {
+        if (client_cert) {
             SSL_CTX_use_certificate_ASN1(ctx, client_cert->certificate.size(),
                                          client_cert->certificate.data());
             SSL_CTX_use_PrivateKey_ASN1(EVP_PKEY_RSA, ctx, client_cert->private_key.data(),
@@ -108,25 +235,61 @@ void Context::MakeRequest() {
         // TODO(B3N30): Is there a state that shows response header are available
         current_download_size_bytes = current;
         total_download_size_bytes = total;
-        return true;
+        return !cancelled;
+    };
+    // The body is handed to ReceiveData while it is downloaded instead of once the request is done
+    request.content_receiver = [this](const char* data, std::size_t length) -> bool {
+        AppendResponseBody(data, length, std::nullopt);
+        return !cancelled;
     };
 
     for (const auto& header : headers) {
         request.headers.emplace(header.name, header.value);
     }
 
+    RequestState final_state;
     if (!client->send(request, response)) {
         LOG_ERROR(Service_HTTP, "Request failed");
-        state = RequestState::TimedOut;
+        final_state = RequestState::TimedOut;
     } else {
         LOG_DEBUG(Service_HTTP, "Request successful");
         // TODO(B3N30): Verify this state on HW
-        state = RequestState::ReadyToDownloadContent;
+        final_state = RequestState::ReadyToDownloadContent;
+        // A client whose request failed is dropped, in case its state is the cause
+        pool.Release(client_key, std::move(client));
     }
 #else
     LOG_ERROR(Service_HTTP, "Tried to make request but WebServices is not enabled in this build");
-    state = RequestState::TimedOut;
+    const RequestState final_state = RequestState::TimedOut;
 #endif
+
+    AppendResponseBody(nullptr, 0, final_state);
+}
+
+void Context::AppendResponseBody(const char* data, std::size_t length,
+                                 std::optional<RequestState> final_state) {
+    const bool finished = final_state.has_value();
+    std::shared_ptr<Kernel::Event> event;
+    {
+        std::lock_guard lock{body_mutex};
+        if (length != 0) {
+            response_body.append(data, length);
+        }
+        if (finished) {
+            state = *final_state;
+        }
+        request_finished = finished;
+        if (data_event != nullptr &&
+            (finished || response_body.size() - current_copied_data >= data_event_size)) {
+            event = std::move(data_event);
+        }
+    }
+
+    if (event != nullptr) {
+        // The body mutex isn't held here, as ReceiveData takes it with the HLE lock held
+        std::lock_guard hle_lock{HLE::g_hle_lock};
+        event->Signal();
+    }
 }
 
 void HTTP_C::Initialize(Kernel::HLERequestContext& ctx) {
@@ -195,7 +358,15 @@ void HTTP_C::InitializeConnectionSession(Kernel::HLERequestContext& ctx) {
 }
 
 void HTTP_C::BeginRequest(Kernel::HLERequestContext& ctx) {
-    IPC::RequestParser rp(ctx, 0x9, 1, 0);
+    BeginRequestImpl(ctx, 0x9);
+}
+
+void HTTP_C::BeginRequestAsync(Kernel::HLERequestContext& ctx) {
+    BeginRequestImpl(ctx, 0xA);
+}
+
+void HTTP_C::BeginRequestImpl(Kernel::HLERequestContext& ctx, u32 command_id) {
+    IPC::RequestParser rp(ctx, command_id, 1, 0);
     const Context::Handle context_handle = rp.Pop<u32>();
 
     LOG_WARNING(Service_HTTP, "(STUBBED) called, context_id={}", context_handle);
@@ -233,71 +404,142 @@ void HTTP_C::BeginRequest(Kernel::HLERequestContext& ctx) {
     auto itr = contexts.find(context_handle);
     ASSERT(itr != contexts.end());
 
-    // On a 3DS BeginRequest and BeginRequestAsync will push the Request to a worker queue.
-    // You can only enqueue 8 requests at the same time.
-    // trying to enqueue any more will either fail (BeginRequestAsync), or block (BeginRequest)
-    // Note that you only can have 8 Contexts at a time. So this difference shouldn't matter
-    // Then there are 3? worker threads that pop the requests from the queue and send them
-    // For now make every request async in it's own thread.
+    if (itr->second->request_begun) {
+        LOG_ERROR(Service_HTTP, "Tried to begin the request of context {} twice", context_handle);
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+        rb.Push(ERROR_INVALID_REQUEST_STATE);
+        return;
+    }
 
-    itr->second.request_future =
-        std::async(std::launch::async, &Context::MakeRequest, std::ref(itr->second));
+    // You can only enqueue 8 requests at the same time on a 3DS, trying to enqueue any more will
+    // either fail (BeginRequestAsync) or block (BeginRequest). Note that you only can have 8
+    // contexts at a time, so the queue here never has to be limited.
+    itr->second->request_begun = true;
+    executor->Enqueue(itr->second);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
 }
 
-void HTTP_C::BeginRequestAsync(Kernel::HLERequestContext& ctx) {
-    IPC::RequestParser rp(ctx, 0xA, 1, 0);
-    const Context::Handle context_handle = rp.Pop<u32>();
+void HTTP_C::ReceiveData(Kernel::HLERequestContext& ctx) {
+    ReceiveDataImpl(ctx, false);
+}
 
-    LOG_WARNING(Service_HTTP, "(STUBBED) called, context_id={}", context_handle);
+void HTTP_C::ReceiveDataTimeout(Kernel::HLERequestContext& ctx) {
+    ReceiveDataImpl(ctx, true);
+}
 
-    auto* session_data = GetSessionData(ctx.Session());
-    ASSERT(session_data);
+void HTTP_C::ReceiveDataImpl(Kernel::HLERequestContext& ctx, bool timeout) {
+    const u32 command_id = timeout ? 0xC : 0xB;
+    IPC::RequestParser rp(ctx, command_id, timeout ? 4 : 2, 2);
+    const Context::Handle context_handle = rp.Pop<u32>();
+    const u32 buffer_size = rp.Pop<u32>();
+    const std::chrono::nanoseconds timeout_ns{timeout ? static_cast<s64>(rp.Pop<u64>()) : -1};
+    // Only positive timeouts are armed when the thread sleeps, a zero one has already expired
+    const bool expired = timeout_ns.count() == 0;
+    Kernel::MappedBuffer& buffer = rp.PopMappedBuffer();
 
-    if (!session_data->initialized) {
-        LOG_ERROR(Service_HTTP, "Tried to make a request on an uninitialized session");
-        IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
-        rb.Push(ERROR_STATE_ERROR);
+    LOG_DEBUG(Service_HTTP, "called, context_id={} buffer_size={} timeout={}", context_handle,
+              buffer_size, timeout_ns.count());
+
+    const auto itr = contexts.find(context_handle);
+    if (itr == contexts.end() || !itr->second->request_begun) {
+        LOG_ERROR(Service_HTTP, "Tried to receive the data of context {} without a request",
+                  context_handle);
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+        rb.Push(itr == contexts.end() ? ERROR_CONTEXT_NOT_FOUND : ERROR_INVALID_REQUEST_STATE);
+        rb.PushMappedBuffer(buffer);
         return;
     }
 
-    // This command can only be called with a bound context
-    if (!session_data->current_http_context) {
-        LOG_ERROR(Service_HTTP, "Tried to make a request without a bound context");
+    // Writes the reply with the body mutex held, copying as much of the unread data as fits
+    auto copy_data = [command_id, buffer_size, buffer](Context& http_context,
+                                                       Kernel::HLERequestContext& ctx) mutable {
+        const std::size_t remaining =
+            http_context.response_body.size() - http_context.current_copied_data;
+        const std::size_t size = std::min<std::size_t>(remaining, buffer_size);
+        buffer.Write(http_context.response_body.data() + http_context.current_copied_data, 0,
+                     size);
+        http_context.current_copied_data += size;
+
+        IPC::RequestBuilder rb(ctx, command_id, 1, 2);
+        if (http_context.state == RequestState::TimedOut) {
+            rb.Push(ERROR_TIMEOUT);
+        } else if (!http_context.request_finished || size != remaining) {
+            rb.Push(ERROR_DOWNLOAD_PENDING);
+        } else {
+            rb.Push(RESULT_SUCCESS);
+        }
+        rb.PushMappedBuffer(buffer);
+    };
 
-        IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
-        rb.Push(ResultCode(ErrorDescription::NotImplemented, ErrorModule::HTTP,
-                           ErrorSummary::Internal, ErrorLevel::Permanent));
+    Context& http_context = *itr->second;
+    std::lock_guard lock{http_context.body_mutex};
+    const std::size_t unread = http_context.response_body.size() - http_context.current_copied_data;
+    if (http_context.request_finished || unread >= buffer_size) {
+        copy_data(http_context, ctx);
         return;
     }
-
-    if (session_data->current_http_context != context_handle) {
-        LOG_ERROR(
-            Service_HTTP,
-            "Tried to make a request on a mismatched session input context={} session context={}",
-            context_handle, *session_data->current_http_context);
-        IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
-        rb.Push(ERROR_STATE_ERROR);
+    if (expired) {
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+        rb.Push(ERROR_TIMEOUT);
+        rb.PushMappedBuffer(buffer);
         return;
     }
 
-    auto itr = contexts.find(context_handle);
-    ASSERT(itr != contexts.end());
+    // Sleep until the worker has received enough of the body, instead of blocking the emulation
+    http_context.data_event_size = buffer_size;
+    http_context.data_event = ctx.SleepClientThread(
+        "http_c::ReceiveData", timeout_ns,
+        [this, context_handle, command_id, buffer,
+         copy_data](std::shared_ptr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
+                    Kernel::ThreadWakeupReason reason) mutable {
+            const auto itr = contexts.find(context_handle);
+            if (itr == contexts.end()) {
+                IPC::RequestBuilder rb(ctx, command_id, 1, 2);
+                rb.Push(ERROR_CONTEXT_NOT_FOUND);
+                rb.PushMappedBuffer(buffer);
+                return;
+            }
+
+            Context& http_context = *itr->second;
+            std::lock_guard lock{http_context.body_mutex};
+            http_context.data_event = nullptr;
+            if (reason == Kernel::ThreadWakeupReason::Timeout) {
+                IPC::RequestBuilder rb(ctx, command_id, 1, 2);
+                rb.Push(ERROR_TIMEOUT);
+                rb.PushMappedBuffer(buffer);
+                return;
+            }
+            copy_data(http_context, ctx);
+        });
+}
 
-    // On a 3DS BeginRequest and BeginRequestAsync will push the Request to a worker queue.
-    // You can only enqueue 8 requests at the same time.
-    // trying to enqueue any more will either fail (BeginRequestAsync), or block (BeginRequest)
-    // Note that you only can have 8 Contexts at a time. So this difference shouldn't matter
-    // Then there are 3? worker threads that pop the requests from the queue and send them
-    // For now make every request async in it's own thread.
+void HTTP_C::GetDownloadSizeState(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x6, 1, 0);
+    const Context::Handle context_handle = rp.Pop<u32>();
 
-    itr->second.request_future =
-        std::async(std::launch::async, &Context::MakeRequest, std::ref(itr->second));
+    LOG_DEBUG(Service_HTTP, "called, context_id={}", context_handle);
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+    const auto itr = contexts.find(context_handle);
+    if (itr == contexts.end()) {
+        IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+        rb.Push(ERROR_CONTEXT_NOT_FOUND);
+        return;
+    }
+
+    // Titles use the downloaded size as the offset to receive the next data at, so it counts the
+    // data that has been copied to the guest rather than the data that has been downloaded
+    u32 copied_size;
+    {
+        std::lock_guard lock{itr->second->body_mutex};
+        copied_size = static_cast<u32>(itr->second->current_copied_data);
+    }
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(3, 0);
     rb.Push(RESULT_SUCCESS);
+    rb.Push<u32>(copied_size);
+    rb.Push<u32>(static_cast<u32>(itr->second->total_download_size_bytes));
 }
 
 void HTTP_C::CreateContext(Kernel::HLERequestContext& ctx) {
@@ -357,14 +599,15 @@ void HTTP_C::CreateContext(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    contexts.try_emplace(++context_counter);
-    contexts[context_counter].url = std::move(url);
-    contexts[context_counter].method = method;
-    contexts[context_counter].state = RequestState::NotStarted;
+    auto context = std::make_shared<Context>();
+    context->url = std::move(url);
+    context->method = method;
+    context->state = RequestState::NotStarted;
     // TODO(Subv): Find a correct default value for this field.
-    contexts[context_counter].socket_buffer_size = 0;
-    contexts[context_counter].handle = context_counter;
-    contexts[context_counter].session_id = session_data->session_id;
+    context->socket_buffer_size = 0;
+    context->handle = ++context_counter;
+    context->session_id = session_data->session_id;
+    contexts.emplace(context_counter, std::move(context));
 
     session_data->num_http_contexts++;
 
@@ -406,7 +649,8 @@ void HTTP_C::CloseContext(Kernel::HLERequestContext& ctx) {
     // TODO(Subv): What happens if you try to close a context that's currently being used?
     // TODO(Subv): Make sure that only the session that created the context can close it.
 
-    // Note that this will block if a request is still in progress
+    // A request that is still in progress is aborted, its worker releases the context afterwards
+    itr->second->cancelled = true;
     contexts.erase(itr);
     session_data->num_http_contexts--;
 
@@ -468,7 +712,7 @@ void HTTP_C::AddRequestHeader(Kernel::HLERequestContext& ctx) {
     auto itr = contexts.find(context_handle);
     ASSERT(itr != contexts.end());
 
-    if (itr->second.state != RequestState::NotStarted) {
+    if (itr->second->request_begun) {
         LOG_ERROR(Service_HTTP,
                   "Tried to add a request header on a context that has already been started.");
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
@@ -478,12 +722,12 @@ void HTTP_C::AddRequestHeader(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    ASSERT(std::find_if(itr->second.headers.begin(), itr->second.headers.end(),
+    ASSERT(std::find_if(itr->second->headers.begin(), itr->second->headers.end(),
                         [&name](const Context::RequestHeader& m) -> bool {
                             return m.name == name;
-                        }) == itr->second.headers.end());
+                        }) == itr->second->headers.end());
 
-    itr->second.headers.emplace_back(name, value);
+    itr->second->headers.emplace_back(name, value);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
     rb.Push(RESULT_SUCCESS);
@@ -544,7 +788,7 @@ void HTTP_C::AddPostDataAscii(Kernel::HLERequestContext& ctx) {
     auto itr = contexts.find(context_handle);
     ASSERT(itr != contexts.end());
 
-    if (itr->second.state != RequestState::NotStarted) {
+    if (itr->second->request_begun) {
         LOG_ERROR(Service_HTTP,
                   "Tried to add post data on a context that has already been started.");
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
@@ -554,11 +798,11 @@ void HTTP_C::AddPostDataAscii(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    ASSERT(std::find_if(itr->second.post_data.begin(), itr->second.post_data.end(),
+    ASSERT(std::find_if(itr->second->post_data.begin(), itr->second->post_data.end(),
                         [&name](const Context::PostData& m) -> bool { return m.name == name; }) ==
-           itr->second.post_data.end());
+           itr->second->post_data.end());
 
-    itr->second.post_data.emplace_back(name, value);
+    itr->second->post_data.emplace_back(name, value);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
     rb.Push(RESULT_SUCCESS);
@@ -613,7 +857,7 @@ void HTTP_C::SetClientCertContext(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    if (http_context_itr->second.ssl_config.client_cert_ctx.lock()) {
+    if (http_context_itr->second->ssl_config.client_cert_ctx.lock()) {
         LOG_ERROR(Service_HTTP,
                   "Tried to set a client cert to a context that already has a client cert");
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
@@ -621,7 +865,7 @@ void HTTP_C::SetClientCertContext(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    if (http_context_itr->second.state != RequestState::NotStarted) {
+    if (http_context_itr->second->request_begun) {
         LOG_ERROR(Service_HTTP,
                   "Tried to set a client cert on a context that has already been started.");
         IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
@@ -630,7 +874,7 @@ void HTTP_C::SetClientCertContext(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    http_context_itr->second.ssl_config.client_cert_ctx = cert_context_itr->second;
+    http_context_itr->second->ssl_config.client_cert_ctx = cert_context_itr->second;
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
 }
@@ -890,13 +1134,13 @@ HTTP_C::HTTP_C() : ServiceFramework("http:C", 32) {
         {0x00030040, &HTTP_C::CloseContext, "CloseContext"},
         {0x00040040, nullptr, "CancelConnection"},
         {0x00050040, nullptr, "GetRequestState"},
-        {0x00060040, nullptr, "GetDownloadSizeState"},
+        {0x00060040, &HTTP_C::GetDownloadSizeState, "GetDownloadSizeState"},
         {0x00070040, nullptr, "GetRequestError"},
         {0x00080042, &HTTP_C::InitializeConnectionSession, "InitializeConnectionSession"},
         {0x00090040, &HTTP_C::BeginRequest, "BeginRequest"},
         {0x000A0040, &HTTP_C::BeginRequestAsync, "BeginRequestAsync"},
-        {0x000B0082, nullptr, "ReceiveData"},
-        {0x000C0102, nullptr, "ReceiveDataTimeout"},
+        {0x000B0082, &HTTP_C::ReceiveData, "ReceiveData"},
+        {0x000C0102, &HTTP_C::ReceiveDataTimeout, "ReceiveDataTimeout"},
         {0x000D0146, nullptr, "SetProxy"},
         {0x000E0040, nullptr, "SetProxyDefault"},
         {0x000F00C4, nullptr, "SetBasicAuthorization"},
@@ -945,6 +1189,15 @@ HTTP_C::HTTP_C() : ServiceFramework("http:C", 32) {
     RegisterHandlers(functions);
 
     DecryptClCertA();
+
+    executor = std::make_unique<RequestExecutor>(NUM_REQUEST_WORKERS);
+}
+
+HTTP_C::~HTTP_C() {
+    // Abort the requests that are still in progress, so that the workers can be joined
+    for (const auto& [handle, context] : contexts) {
+        context->cancelled = true;
+    }
 }
 
 void InstallInterfaces(Core::System& system) {
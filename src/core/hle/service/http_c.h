@@ -4,8 +4,8 @@
 
 #pragma once
 
-#include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -76,6 +76,9 @@ struct RootCertChain {
     std::vector<RootCACert> certificates;
 };
 
+class ClientPool;
+class RequestExecutor;
+
 /// Represents an HTTP context.
 class Context final {
 public:
@@ -85,7 +88,16 @@ public:
     Context(const Context&) = delete;
     Context& operator=(const Context&) = delete;
 
-    void MakeRequest();
+    /// Sends the request, streaming the response body in as it is received. Runs on a worker.
+    void MakeRequest(ClientPool& pool);
+
+    /**
+     * Appends received data to the response body and wakes the guest thread waiting for it in
+     * ReceiveData once there is enough of it, or once the request has finished.
+     * @param final_state State the request ended in, set once it has finished
+     */
+    void AppendResponseBody(const char* data, std::size_t length,
+                            std::optional<RequestState> final_state);
 
     struct Proxy {
         std::string url;
@@ -122,6 +134,7 @@ public:
     u32 session_id;
     std::string url;
     RequestMethod method;
+    /// Set with body_mutex held once the request has ended, along with request_finished
     std::atomic<RequestState> state = RequestState::NotStarted;
     std::optional<Proxy> proxy;
     std::optional<BasicAuth> basic_auth;
@@ -130,12 +143,28 @@ public:
     std::vector<RequestHeader> headers;
     std::vector<PostData> post_data;
 
-    std::future<void> request_future;
+    /// Whether BeginRequest or BeginRequestAsync has been called on the context
+    bool request_begun = false;
+    /// Set when the context is closed, aborts the request if it is still in progress
+    std::atomic<bool> cancelled = false;
+
     std::atomic<u64> current_download_size_bytes;
     std::atomic<u64> total_download_size_bytes;
 #ifdef ENABLE_WEB_SERVICE
     httplib::Response response;
 #endif
+
+    /// Guards the response body, which the worker appends to while ReceiveData consumes it
+    std::mutex body_mutex;
+    std::string response_body;
+    /// Number of bytes of the response body that have been copied to the guest
+    std::size_t current_copied_data = 0;
+    /// Whether the request has ended, successfully or not
+    bool request_finished = false;
+    /// Event of the guest thread sleeping in ReceiveData, signaled once data_event_size unread
+    /// bytes are available or the request has finished
+    std::shared_ptr<Kernel::Event> data_event;
+    std::size_t data_event_size = 0;
 };
 
 struct SessionData : public Kernel::SessionRequestHandler::SessionDataBase {
@@ -158,6 +187,7 @@ struct SessionData : public Kernel::SessionRequestHandler::SessionDataBase {
 class HTTP_C final : public ServiceFramework<HTTP_C, SessionData> {
 public:
     HTTP_C();
+    ~HTTP_C();
 
 private:
     /**
@@ -195,6 +225,17 @@ private:
      */
     void CloseContext(Kernel::HLERequestContext& ctx);
 
+    /**
+     * HTTP_C::GetDownloadSizeState service function
+     *  Inputs:
+     *      1 : Context handle
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : Number of bytes of the response body received by the guest so far
+     *      3 : Total size of the response body, 0 if it isn't known yet
+     */
+    void GetDownloadSizeState(Kernel::HLERequestContext& ctx);
+
     /**
      * HTTP_C::InitializeConnectionSession service function
      *  Inputs:
@@ -224,6 +265,38 @@ private:
      */
     void BeginRequestAsync(Kernel::HLERequestContext& ctx);
 
+    /**
+     * HTTP_C::ReceiveData service function, sleeps until the buffer can be filled or the request
+     * has finished
+     *  Inputs:
+     *      1 : Context handle
+     *      2 : Buffer size
+     *      3 : (BufferSize<<4) | 12
+     *      4 : Buffer data pointer
+     *  Outputs:
+     *      1 : Result of function, 0 once the whole body has been received, 0xD840A02B if there
+     *          is more data to receive
+     */
+    void ReceiveData(Kernel::HLERequestContext& ctx);
+
+    /**
+     * HTTP_C::ReceiveDataTimeout service function
+     *  Inputs:
+     *      1 : Context handle
+     *      2 : Buffer size
+     *      3-4 : u64 timeout in nanoseconds
+     *      5 : (BufferSize<<4) | 12
+     *      6 : Buffer data pointer
+     *  Outputs:
+     *      1 : Result of function, same as ReceiveData or 0xD820A069 on timeout
+     */
+    void ReceiveDataTimeout(Kernel::HLERequestContext& ctx);
+
+    void ReceiveDataImpl(Kernel::HLERequestContext& ctx, bool timeout);
+
+    /// Queues the request of the context on the workers, shared by both BeginRequest variants
+    void BeginRequestImpl(Kernel::HLERequestContext& ctx, u32 command_id);
+
     /**
      * HTTP_C::AddRequestHeader service function
      *  Inputs:
@@ -328,8 +401,11 @@ private:
     /// The next handle number to use when a new ClientCert context is created.
     ClientCertContext::Handle client_certs_counter = 0;
 
-    /// Global list of HTTP contexts currently opened.
-    std::unordered_map<Context::Handle, Context> contexts;
+    /// Global list of HTTP contexts currently opened. The workers keep a reference to the contexts
+    /// whose requests are in progress, as they may be closed at any time.
+    std::unordered_map<Context::Handle, std::shared_ptr<Context>> contexts;
+
+    std::unique_ptr<RequestExecutor> executor;
 
     /// Global list of  ClientCert contexts currently opened.
     std::unordered_map<ClientCertContext::Handle, std::shared_ptr<ClientCertContext>> client_certs;
@@ -33,6 +33,9 @@ struct SharedMem {
 
 static_assert(sizeof(SharedMem) == 0x98, "SharedMem has wrong size!");
 
+// The updates may fire up to 0.1 ms late to share a wakeup with other events
+constexpr s64 update_slack_ticks = BASE_CLOCK_RATE_ARM11 / 10000;
+
 void IR_RST::LoadInputDevices() {
     zl_button = Input::CreateDevice<Input::ButtonDevice>(
         Settings::values.current_input_profile.buttons[Settings::NativeButton::ZL]);
@@ -158,7 +161,8 @@ IR_RST::IR_RST(Core::System& system) : ServiceFramework("ir:rst", 1), system(sys
 
     update_callback_id = system.CoreTiming().RegisterEvent(
         "IRRST:UpdateCallBack",
-        [this](u64 userdata, s64 cycles_late) { UpdateCallback(userdata, cycles_late); });
+        [this](u64 userdata, s64 cycles_late) { UpdateCallback(userdata, cycles_late); },
+        update_slack_ticks);
 
     static const FunctionInfo functions[] = {
         {0x00010000, &IR_RST::GetHandles, "GetHandles"},
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include "common/alignment.h"
 #include "common/logging/log.h"
 #include "common/scope_exit.h"
@@ -48,6 +49,18 @@ const std::array<CROHelper::HeaderField, 4> CROHelper::FIX_BARRIERS{{
     Fix3Barrier,
 }};
 
+VAddr CROHelper::SegmentTagToAddress(SegmentTag segment_tag,
+                                     const std::vector<SegmentEntry>& segments) {
+    if (segment_tag.segment_index >= segments.size())
+        return 0;
+
+    const SegmentEntry& entry = segments[segment_tag.segment_index];
+    if (segment_tag.offset_into_segment >= entry.size)
+        return 0;
+
+    return entry.offset + segment_tag.offset_into_segment;
+}
+
 VAddr CROHelper::SegmentTagToAddress(SegmentTag segment_tag) const {
     u32 segment_num = GetField(SegmentNum);
 
@@ -118,13 +131,14 @@ ResultCode CROHelper::ApplyRelocationBatch(VAddr batch, u32 symbol_address, bool
     if (symbol_address == 0 && !reset)
         return CROFormatError(0x10);
 
+    const std::vector<SegmentEntry> segments = GetSegmentTable();
     VAddr relocation_address = batch;
     while (true) {
         RelocationEntry relocation;
         system.Memory().ReadBlock(process, relocation_address, &relocation,
                                   sizeof(RelocationEntry));
 
-        VAddr relocation_target = SegmentTagToAddress(relocation.target_position);
+        VAddr relocation_target = SegmentTagToAddress(relocation.target_position, segments);
         if (relocation_target == 0) {
             return CROFormatError(0x12);
         }
@@ -482,10 +496,13 @@ ResultCode CROHelper::ResetExternalRelocations() {
         return CROFormatError(0x12);
     }
 
+    const std::vector<SegmentEntry> segments = GetSegmentTable();
+    const std::vector<ExternalRelocationEntry> relocations =
+        GetEntries<ExternalRelocationEntry>(system.Memory(), external_relocation_num);
     bool batch_begin = true;
     for (u32 i = 0; i < external_relocation_num; ++i) {
-        GetEntry(system.Memory(), i, relocation);
-        VAddr relocation_target = SegmentTagToAddress(relocation.target_position);
+        relocation = relocations[i];
+        VAddr relocation_target = SegmentTagToAddress(relocation.target_position, segments);
 
         if (relocation_target == 0) {
             return CROFormatError(0x12);
@@ -515,10 +532,13 @@ ResultCode CROHelper::ClearExternalRelocations() {
     u32 external_relocation_num = GetField(ExternalRelocationNum);
     ExternalRelocationEntry relocation;
 
+    const std::vector<SegmentEntry> segments = GetSegmentTable();
+    const std::vector<ExternalRelocationEntry> relocations =
+        GetEntries<ExternalRelocationEntry>(system.Memory(), external_relocation_num);
     bool batch_begin = true;
     for (u32 i = 0; i < external_relocation_num; ++i) {
-        GetEntry(system.Memory(), i, relocation);
-        VAddr relocation_target = SegmentTagToAddress(relocation.target_position);
+        relocation = relocations[i];
+        VAddr relocation_target = SegmentTagToAddress(relocation.target_position, segments);
 
         if (relocation_target == 0) {
             return CROFormatError(0x12);
@@ -578,17 +598,17 @@ ResultCode CROHelper::ApplyStaticAnonymousSymbolToCRS(VAddr crs_address) {
 ResultCode CROHelper::ApplyInternalRelocations(u32 old_data_segment_address) {
     u32 segment_num = GetField(SegmentNum);
     u32 internal_relocation_num = GetField(InternalRelocationNum);
-    for (u32 i = 0; i < internal_relocation_num; ++i) {
-        InternalRelocationEntry relocation;
-        GetEntry(system.Memory(), i, relocation);
-        VAddr target_addressB = SegmentTagToAddress(relocation.target_position);
+    const std::vector<SegmentEntry> segments = GetSegmentTable();
+    const std::vector<InternalRelocationEntry> relocations =
+        GetEntries<InternalRelocationEntry>(system.Memory(), internal_relocation_num);
+    for (const InternalRelocationEntry& relocation : relocations) {
+        VAddr target_addressB = SegmentTagToAddress(relocation.target_position, segments);
         if (target_addressB == 0) {
             return CROFormatError(0x15);
         }
 
         VAddr target_address;
-        SegmentEntry target_segment;
-        GetEntry(system.Memory(), relocation.target_position.segment_index, target_segment);
+        const SegmentEntry& target_segment = segments[relocation.target_position.segment_index];
 
         if (target_segment.type == SegmentType::Data) {
             // If the relocation is to the .data segment, we need to relocate it in the old buffer
@@ -602,8 +622,7 @@ ResultCode CROHelper::ApplyInternalRelocations(u32 old_data_segment_address) {
             return CROFormatError(0x15);
         }
 
-        SegmentEntry symbol_segment;
-        GetEntry(system.Memory(), relocation.symbol_segment, symbol_segment);
+        const SegmentEntry& symbol_segment = segments[relocation.symbol_segment];
         LOG_TRACE(Service_LDR, "Internally relocates 0x{:08X} with 0x{:08X}", target_address,
                   symbol_segment.offset);
         ResultCode result = ApplyRelocation(target_address, relocation.type, relocation.addend,
@@ -618,10 +637,11 @@ ResultCode CROHelper::ApplyInternalRelocations(u32 old_data_segment_address) {
 
 ResultCode CROHelper::ClearInternalRelocations() {
     u32 internal_relocation_num = GetField(InternalRelocationNum);
-    for (u32 i = 0; i < internal_relocation_num; ++i) {
-        InternalRelocationEntry relocation;
-        GetEntry(system.Memory(), i, relocation);
-        VAddr target_address = SegmentTagToAddress(relocation.target_position);
+    const std::vector<SegmentEntry> segments = GetSegmentTable();
+    const std::vector<InternalRelocationEntry> relocations =
+        GetEntries<InternalRelocationEntry>(system.Memory(), internal_relocation_num);
+    for (const InternalRelocationEntry& relocation : relocations) {
+        VAddr target_address = SegmentTagToAddress(relocation.target_position, segments);
 
         if (target_address == 0) {
             return CROFormatError(0x15);
@@ -1533,4 +1553,21 @@ std::tuple<VAddr, u32> CROHelper::GetExecutablePages() const {
     return std::make_tuple(0, 0);
 }
 
+std::vector<std::pair<VAddr, std::string>> CROHelper::GetExportedSymbols() const {
+    const u32 export_strings_size = GetField(ExportStringsSize);
+    const std::vector<SegmentEntry> segments = GetSegmentTable();
+    std::vector<std::pair<VAddr, std::string>> symbols;
+    for (const ExportNamedSymbolEntry& entry :
+         GetEntries<ExportNamedSymbolEntry>(system.Memory(), GetField(ExportNamedSymbolNum))) {
+        if (entry.name_offset == 0)
+            continue;
+        const VAddr address = SegmentTagToAddress(entry.symbol_position, segments);
+        if (address == 0)
+            continue;
+        symbols.emplace_back(address,
+                             system.Memory().ReadCString(entry.name_offset, export_strings_size));
+    }
+    return symbols;
+}
+
 } // namespace Service::LDR
@@ -5,7 +5,10 @@
 #pragma once
 
 #include <array>
+#include <string>
 #include <tuple>
+#include <utility>
+#include <vector>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/hle/result.h"
@@ -35,6 +38,7 @@ public:
     // TODO (wwylele): pass in the process handle for memory access
     explicit CROHelper(VAddr cro_address, Kernel::Process& process, Core::System& system)
         : module_address(cro_address), process(process), system(system) {}
+    CROHelper(const CROHelper&) = default;
 
     std::string ModuleName() const {
         return system.Memory().ReadCString(GetField(ModuleNameOffset), GetField(ModuleNameSize));
@@ -140,6 +144,9 @@ public:
      */
     std::tuple<VAddr, u32> GetExecutablePages() const;
 
+    /// Gets the addresses and names of the named symbols exported by this module.
+    std::vector<std::pair<VAddr, std::string>> GetExportedSymbols() const;
+
 private:
     const VAddr module_address; ///< the virtual address of this module
     Kernel::Process& process;   ///< the owner process of this module
@@ -436,6 +443,20 @@ private:
                           &data, sizeof(T));
     }
 
+    /**
+     * Reads a number of entries from the start of one of module tables in one go.
+     * @param count the number of entries to read
+     * @note the entry type must have the static member TABLE_OFFSET_FIELD
+     *       indicating which table the entries are in.
+     */
+    template <typename T>
+    std::vector<T> GetEntries(Memory::MemorySystem& memory, std::size_t count) const {
+        std::vector<T> entries(count);
+        memory.ReadBlock(process, GetField(T::TABLE_OFFSET_FIELD), entries.data(),
+                         count * sizeof(T));
+        return entries;
+    }
+
     /**
      * Converts a segment tag to virtual address in this module.
      * @param segment_tag the segment tag to convert
@@ -443,6 +464,15 @@ private:
      */
     VAddr SegmentTagToAddress(SegmentTag segment_tag) const;
 
+    /// Same as above, with the segment table already read by the caller
+    static VAddr SegmentTagToAddress(SegmentTag segment_tag,
+                                     const std::vector<SegmentEntry>& segments);
+
+    /// Reads the whole segment table, for loops converting a segment tag per entry
+    std::vector<SegmentEntry> GetSegmentTable() const {
+        return GetEntries<SegmentEntry>(system.Memory(), GetField(SegmentNum));
+    }
+
     VAddr NextModule() const {
         return GetField(NextCRO);
     }
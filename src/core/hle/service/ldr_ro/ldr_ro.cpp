@@ -7,6 +7,7 @@
 #include "common/logging/log.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
+#include "core/guest_symbols.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/service/ldr_ro/cro_helper.h"
@@ -115,6 +116,8 @@ void RO::Initialize(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    // Relocations write single words, their JIT code is invalidated once for the whole request
+    Core::InvalidationBatch invalidation(system);
     CROHelper crs(crs_address, *process, system);
     crs.InitCRS();
 
@@ -249,6 +252,7 @@ void RO::LoadCRO(Kernel::HLERequestContext& ctx, bool link_on_load_bug_fix) {
         return;
     }
 
+    Core::InvalidationBatch invalidation(system);
     CROHelper cro(cro_address, *process, system);
 
     result = cro.VerifyHash(cro_size, crr_address);
@@ -315,6 +319,15 @@ void RO::LoadCRO(Kernel::HLERequestContext& ctx, bool link_on_load_bug_fix) {
 
     system.InvalidateCacheRange(cro_address, cro_size);
 
+    if (exe_begin) {
+        std::vector<Core::GuestSymbols::Symbol> symbols;
+        for (auto& [address, name] : cro.GetExportedSymbols()) {
+            symbols.push_back({address & ~1u, 0, std::move(name)});
+        }
+        Core::GuestSymbols::AddModule(cro.ModuleName(), exe_begin, exe_begin + exe_size,
+                                      std::move(symbols));
+    }
+
     LOG_INFO(Service_LDR, "CRO \"{}\" loaded at 0x{:08X}, fixed_end=0x{:08X}", cro.ModuleName(),
              cro_address, cro_address + fix_size);
 
@@ -331,6 +344,7 @@ void RO::UnloadCRO(Kernel::HLERequestContext& ctx) {
     LOG_DEBUG(Service_LDR, "called, cro_address=0x{:08X}, zero={}, cro_buffer_ptr=0x{:08X}",
               cro_address, zero, cro_buffer_ptr);
 
+    Core::InvalidationBatch invalidation(system);
     CROHelper cro(cro_address, *process, system);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
@@ -355,6 +369,7 @@ void RO::UnloadCRO(Kernel::HLERequestContext& ctx) {
     }
 
     LOG_INFO(Service_LDR, "Unloading CRO \"{}\"", cro.ModuleName());
+    Core::GuestSymbols::RemoveModule(cro.ModuleName());
 
     u32 fixed_size = cro.GetFixedSize();
 
@@ -398,6 +413,7 @@ void RO::LinkCRO(Kernel::HLERequestContext& ctx) {
 
     LOG_DEBUG(Service_LDR, "called, cro_address=0x{:08X}", cro_address);
 
+    Core::InvalidationBatch invalidation(system);
     CROHelper cro(cro_address, *process, system);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
@@ -438,6 +454,7 @@ void RO::UnlinkCRO(Kernel::HLERequestContext& ctx) {
 
     LOG_DEBUG(Service_LDR, "called, cro_address=0x{:08X}", cro_address);
 
+    Core::InvalidationBatch invalidation(system);
     CROHelper cro(cro_address, *process, system);
 
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
@@ -487,6 +504,7 @@ void RO::Shutdown(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    Core::InvalidationBatch invalidation(system);
     CROHelper crs(slot->loaded_crs, *process, system);
     crs.Unrebase(true);
 
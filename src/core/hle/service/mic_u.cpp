@@ -141,7 +141,7 @@ struct MIC_U::Impl {
             return;
         }
 
-        Frontend::Mic::Samples samples = mic->Read();
+        mic->Read(samples);
         if (!samples.empty()) {
             // write the samples to sharedmem page
             state.WriteSamples(samples);
@@ -361,6 +361,8 @@ struct MIC_U::Impl {
     bool allow_shell_closed = false;
     bool clamp = false;
     std::unique_ptr<Frontend::Mic::Interface> mic;
+    /// Receives the samples of each read, kept to not allocate for every buffer update
+    Frontend::Mic::Samples samples;
     Core::Timing& timing;
     State state{};
 };
@@ -0,0 +1,27 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/logging/log.h"
+#include "core/hle/service/mvd/decoder.h"
+
+namespace Service::MVD {
+
+DecoderBase::~DecoderBase() = default;
+
+NullDecoder::NullDecoder() = default;
+
+NullDecoder::~NullDecoder() = default;
+
+bool NullDecoder::SendNALUnit(const u8*, std::size_t size) {
+    LOG_TRACE(Service_MVD, "Dropped a NAL unit of {} bytes", size);
+    return true;
+}
+
+std::optional<Picture> NullDecoder::ReceivePicture() {
+    return std::nullopt;
+}
+
+void NullDecoder::Reset() {}
+
+} // namespace Service::MVD
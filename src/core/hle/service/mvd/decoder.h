@@ -0,0 +1,59 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Service::MVD {
+
+/// A decoded picture in the YUV 4:2:0 format, the planes are stored without padding between rows
+struct Picture {
+    u32 width;
+    u32 height;
+    /// Luma plane of width * height samples
+    std::vector<u8> y;
+    /// Chroma planes of ceil(width / 2) * ceil(height / 2) samples
+    std::vector<u8> u;
+    std::vector<u8> v;
+};
+
+/// Decodes the H.264 stream the guest sends to the MVD hardware one NAL unit at a time
+class DecoderBase {
+public:
+    virtual ~DecoderBase();
+
+    /**
+     * Decodes a NAL unit, with or without an Annex B start code in front of it.
+     * @returns false if the decoder refused the NAL unit
+     */
+    virtual bool SendNALUnit(const u8* data, std::size_t size) = 0;
+
+    /// Returns the next picture in display order, if one is ready
+    virtual std::optional<Picture> ReceivePicture() = 0;
+
+    /// Drops the pictures and references the decoder holds, for a new stream
+    virtual void Reset() = 0;
+
+    /// Returns true if this decoder can be used. Returns false if the system cannot create it
+    virtual bool IsValid() const = 0;
+};
+
+/// Parses the NAL units without producing any picture, used when no real decoder is available
+class NullDecoder final : public DecoderBase {
+public:
+    NullDecoder();
+    ~NullDecoder() override;
+    bool SendNALUnit(const u8* data, std::size_t size) override;
+    std::optional<Picture> ReceivePicture() override;
+    void Reset() override;
+    bool IsValid() const override {
+        return true;
+    }
+};
+
+} // namespace Service::MVD
@@ -0,0 +1,285 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <deque>
+#include "common/logging/log.h"
+#include "core/hle/service/mvd/ffmpeg_decoder.h"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace Service::MVD {
+
+namespace {
+/// The hardware decoding APIs to try, in order of preference
+constexpr std::array hardware_device_types{
+#if defined(_WIN32)
+    AV_HWDEVICE_TYPE_D3D11VA,
+    AV_HWDEVICE_TYPE_DXVA2,
+    AV_HWDEVICE_TYPE_CUDA,
+#elif defined(__APPLE__)
+    AV_HWDEVICE_TYPE_VIDEOTOOLBOX,
+#else
+    AV_HWDEVICE_TYPE_VAAPI,
+    AV_HWDEVICE_TYPE_CUDA,
+#endif
+};
+
+/// Annex B start code put in front of the NAL units that are sent without one
+constexpr std::array<u8, 4> start_code{{0, 0, 0, 1}};
+
+bool HasStartCode(const u8* data, std::size_t size) {
+    return (size >= 3 && data[0] == 0 && data[1] == 0 && data[2] == 1) ||
+           (size >= 4 && data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 1);
+}
+
+AVPixelFormat GetHardwareFormat(AVCodecContext* context, const AVPixelFormat* formats) {
+    const AVPixelFormat hw_pixel_format = *static_cast<const AVPixelFormat*>(context->opaque);
+    for (const AVPixelFormat* format = formats; *format != AV_PIX_FMT_NONE; ++format) {
+        if (*format == hw_pixel_format) {
+            return *format;
+        }
+    }
+    LOG_WARNING(Service_MVD, "The hardware decoder can't decode the stream, using software");
+    return avcodec_default_get_format(context, formats);
+}
+
+/// Copies the planes of a decoded frame, returns nothing if the frame has an unexpected format
+std::optional<Picture> ToPicture(const AVFrame& frame) {
+    Picture picture;
+    picture.width = static_cast<u32>(frame.width);
+    picture.height = static_cast<u32>(frame.height);
+    const std::size_t width = picture.width;
+    const std::size_t height = picture.height;
+    const std::size_t chroma_width = (width + 1) / 2;
+    const std::size_t chroma_height = (height + 1) / 2;
+    picture.y.resize(width * height);
+    picture.u.resize(chroma_width * chroma_height);
+    picture.v.resize(chroma_width * chroma_height);
+
+    switch (frame.format) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+        for (std::size_t row = 0; row < chroma_height; ++row) {
+            std::memcpy(&picture.u[row * chroma_width], frame.data[1] + row * frame.linesize[1],
+                        chroma_width);
+            std::memcpy(&picture.v[row * chroma_width], frame.data[2] + row * frame.linesize[2],
+                        chroma_width);
+        }
+        break;
+    case AV_PIX_FMT_NV12:
+        // Hardware decoders return the chroma samples interleaved
+        for (std::size_t row = 0; row < chroma_height; ++row) {
+            const u8* uv = frame.data[1] + row * frame.linesize[1];
+            for (std::size_t column = 0; column < chroma_width; ++column) {
+                picture.u[row * chroma_width + column] = uv[column * 2];
+                picture.v[row * chroma_width + column] = uv[column * 2 + 1];
+            }
+        }
+        break;
+    default:
+        LOG_ERROR(Service_MVD, "Unsupported decoded pixel format {}",
+                  av_get_pix_fmt_name(static_cast<AVPixelFormat>(frame.format)));
+        return std::nullopt;
+    }
+
+    for (std::size_t row = 0; row < height; ++row) {
+        std::memcpy(&picture.y[row * width], frame.data[0] + row * frame.linesize[0], width);
+    }
+    return picture;
+}
+} // Anonymous namespace
+
+class FFmpegDecoder::Impl {
+public:
+    Impl() {
+#ifdef __ANDROID__
+        // MediaCodec is only exposed as a separate decoder, not as a hardware device
+        if (Open(avcodec_find_decoder_by_name("h264_mediacodec"), false)) {
+            return;
+        }
+#endif
+        Open(avcodec_find_decoder(AV_CODEC_ID_H264), true);
+    }
+
+    bool SendNALUnit(const u8* data, std::size_t size) {
+        packet_data.clear();
+        if (!HasStartCode(data, size)) {
+            packet_data.insert(packet_data.end(), start_code.begin(), start_code.end());
+        }
+        packet_data.insert(packet_data.end(), data, data + size);
+        const int packet_size = static_cast<int>(packet_data.size());
+        // The decoder reads a few bytes past the end of the packet
+        packet_data.resize(packet_data.size() + AV_INPUT_BUFFER_PADDING_SIZE, 0);
+
+        packet->data = packet_data.data();
+        packet->size = packet_size;
+        const int error = avcodec_send_packet(context.get(), packet.get());
+        av_packet_unref(packet.get());
+        if (error < 0) {
+            LOG_ERROR(Service_MVD, "Could not decode a NAL unit of {} bytes, error {}", size,
+                      error);
+            return false;
+        }
+
+        // The pictures are received right away, so the decoder never refuses new packets
+        while (avcodec_receive_frame(context.get(), frame.get()) == 0) {
+            const AVFrame* picture_frame = frame.get();
+            if (frame->format == hw_pixel_format) {
+                if (av_hwframe_transfer_data(sw_frame.get(), frame.get(), 0) < 0) {
+                    LOG_ERROR(Service_MVD, "Could not download a picture from the decoder");
+                    continue;
+                }
+                picture_frame = sw_frame.get();
+            }
+            if (auto picture = ToPicture(*picture_frame)) {
+                pictures.push_back(std::move(*picture));
+            }
+            av_frame_unref(sw_frame.get());
+        }
+        return true;
+    }
+
+    std::optional<Picture> ReceivePicture() {
+        if (pictures.empty()) {
+            return std::nullopt;
+        }
+        Picture picture = std::move(pictures.front());
+        pictures.pop_front();
+        return picture;
+    }
+
+    void Reset() {
+        avcodec_flush_buffers(context.get());
+        pictures.clear();
+    }
+
+    bool IsValid() const {
+        return opened;
+    }
+
+private:
+    struct AVCodecContextDeleter {
+        void operator()(AVCodecContext* codec_context) const {
+            avcodec_free_context(&codec_context);
+        }
+    };
+
+    struct AVFrameDeleter {
+        void operator()(AVFrame* frame) const {
+            av_frame_free(&frame);
+        }
+    };
+
+    struct AVPacketDeleter {
+        void operator()(AVPacket* packet) const {
+            av_packet_free(&packet);
+        }
+    };
+
+    struct AVBufferRefDeleter {
+        void operator()(AVBufferRef* buffer) const {
+            av_buffer_unref(&buffer);
+        }
+    };
+
+    bool Open(const AVCodec* codec, bool try_hardware_device) {
+        if (!codec) {
+            return false;
+        }
+        context.reset(avcodec_alloc_context3(codec));
+        packet.reset(av_packet_alloc());
+        frame.reset(av_frame_alloc());
+        sw_frame.reset(av_frame_alloc());
+        if (!context || !packet || !frame || !sw_frame) {
+            LOG_ERROR(Service_MVD, "Could not allocate the H.264 decoder");
+            return false;
+        }
+
+        // The guest expects a picture as soon as its last NAL unit is processed, so frame
+        // threading, which delays the output by a frame per thread, is not used
+        context->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        context->thread_type = FF_THREAD_SLICE;
+        context->thread_count = 0;
+        if (try_hardware_device) {
+            InitHardwareDevice(codec);
+        }
+
+        if (avcodec_open2(context.get(), codec, nullptr) < 0) {
+            LOG_ERROR(Service_MVD, "Could not open the H.264 decoder {}", codec->name);
+            hw_device_context.reset();
+            hw_pixel_format = AV_PIX_FMT_NONE;
+            return false;
+        }
+        opened = true;
+        return true;
+    }
+
+    void InitHardwareDevice(const AVCodec* codec) {
+        for (const AVHWDeviceType device_type : hardware_device_types) {
+            const AVCodecHWConfig* config = nullptr;
+            for (int i = 0; (config = avcodec_get_hw_config(codec, i)) != nullptr; ++i) {
+                if ((config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX) != 0 &&
+                    config->device_type == device_type) {
+                    break;
+                }
+            }
+            if (config == nullptr) {
+                continue;
+            }
+
+            AVBufferRef* device = nullptr;
+            if (av_hwdevice_ctx_create(&device, device_type, nullptr, nullptr, 0) < 0) {
+                continue;
+            }
+            hw_device_context.reset(device);
+            hw_pixel_format = config->pix_fmt;
+            context->hw_device_ctx = av_buffer_ref(device);
+            context->opaque = &hw_pixel_format;
+            context->get_format = GetHardwareFormat;
+            LOG_INFO(Service_MVD, "Decoding H.264 with {}", av_hwdevice_get_type_name(device_type));
+            return;
+        }
+        LOG_INFO(Service_MVD, "No hardware decoder available, decoding H.264 in software");
+    }
+
+    std::unique_ptr<AVCodecContext, AVCodecContextDeleter> context;
+    std::unique_ptr<AVPacket, AVPacketDeleter> packet;
+    std::unique_ptr<AVFrame, AVFrameDeleter> frame;
+    /// Pictures of hardware decoders are downloaded to this frame
+    std::unique_ptr<AVFrame, AVFrameDeleter> sw_frame;
+    std::unique_ptr<AVBufferRef, AVBufferRefDeleter> hw_device_context;
+    AVPixelFormat hw_pixel_format = AV_PIX_FMT_NONE;
+    bool opened = false;
+
+    std::vector<u8> packet_data;
+    std::deque<Picture> pictures;
+};
+
+FFmpegDecoder::FFmpegDecoder() : impl(std::make_unique<Impl>()) {}
+
+FFmpegDecoder::~FFmpegDecoder() = default;
+
+bool FFmpegDecoder::SendNALUnit(const u8* data, std::size_t size) {
+    return impl->SendNALUnit(data, size);
+}
+
+std::optional<Picture> FFmpegDecoder::ReceivePicture() {
+    return impl->ReceivePicture();
+}
+
+void FFmpegDecoder::Reset() {
+    impl->Reset();
+}
+
+bool FFmpegDecoder::IsValid() const {
+    return impl->IsValid();
+}
+
+} // namespace Service::MVD
@@ -0,0 +1,30 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include "core/hle/service/mvd/decoder.h"
+
+namespace Service::MVD {
+
+/**
+ * Decodes H.264 with FFmpeg. The decoding runs on a hardware decoder of the host when the platform
+ * has one FFmpeg can open, and falls back to the multithreaded software decoder otherwise.
+ */
+class FFmpegDecoder final : public DecoderBase {
+public:
+    FFmpegDecoder();
+    ~FFmpegDecoder() override;
+    bool SendNALUnit(const u8* data, std::size_t size) override;
+    std::optional<Picture> ReceivePicture() override;
+    void Reset() override;
+    bool IsValid() const override;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace Service::MVD
@@ -2,24 +2,44 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <vector>
+#include "common/alignment.h"
+#include "common/logging/log.h"
+#include "core/core.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/process.h"
 #include "core/hle/service/mvd/mvd_std.h"
+#include "core/hle/service/y2r_u.h"
+#include "core/hw/y2r_kernels.h"
+#include "core/memory.h"
+#ifdef ENABLE_FFMPEG_VIDEO_DECODER
+#include "core/hle/service/mvd/ffmpeg_decoder.h"
+#endif
 
 namespace Service::MVD {
 
-MVD_STD::MVD_STD() : ServiceFramework("mvd:std", 1) {
+// The hardware reports the progress of the decoding with these values in place of a result code
+constexpr ResultCode STATUS_OK(0x17000);
+constexpr ResultCode STATUS_PARAMSET(0x17001);
+constexpr ResultCode STATUS_FRAMEREADY(0x17003);
+
+/// Work buffer size the official SDK requests for streams of the 3DS resolution
+constexpr u32 DEFAULT_WORK_BUFFER_SIZE = 0x9006C8;
+
+MVD_STD::MVD_STD(Core::System& system) : ServiceFramework("mvd:std", 1), system(system) {
     static const FunctionInfo functions[] = {
         // clang-format off
-        {0x00010082, nullptr, "Initialize"},
-        {0x00020000, nullptr, "Shutdown"},
-        {0x00030300, nullptr, "CalculateWorkBufSize"},
-        {0x000400C0, nullptr, "CalculateImageSize"},
-        {0x00080142, nullptr, "ProcessNALUnit"},
-        {0x00090042, nullptr, "ControlFrameRendering"},
+        {0x00010082, &MVD_STD::Initialize, "Initialize"},
+        {0x00020000, &MVD_STD::Shutdown, "Shutdown"},
+        {0x00030300, &MVD_STD::CalculateWorkBufSize, "CalculateWorkBufSize"},
+        {0x000400C0, &MVD_STD::CalculateImageSize, "CalculateImageSize"},
+        {0x00080142, &MVD_STD::ProcessNALUnit, "ProcessNALUnit"},
+        {0x00090042, &MVD_STD::ControlFrameRendering, "ControlFrameRendering"},
         {0x000A0000, nullptr, "GetStatus"},
         {0x000B0000, nullptr, "GetStatusOther"},
-        {0x001D0042, nullptr, "GetConfig"},
-        {0x001E0044, nullptr, "SetConfig"},
+        {0x001D0042, &MVD_STD::GetConfig, "GetConfig"},
+        {0x001E0044, &MVD_STD::SetConfig, "SetConfig"},
         {0x001F0902, nullptr, "SetOutputBuffer"},
         {0x00210100, nullptr, "OverrideOutputBuffers"}
         // clang-format on
@@ -28,4 +48,229 @@ MVD_STD::MVD_STD() : ServiceFramework("mvd:std", 1) {
     RegisterHandlers(functions);
 };
 
+MVD_STD::~MVD_STD() = default;
+
+void MVD_STD::Initialize(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x01, 2, 2);
+    const u32 work_buffer_address = rp.Pop<u32>();
+    const u32 work_buffer_size = rp.Pop<u32>();
+    rp.PopObject<Kernel::Process>();
+
+#ifdef ENABLE_FFMPEG_VIDEO_DECODER
+    decoder = std::make_unique<FFmpegDecoder>();
+    if (!decoder->IsValid()) {
+        LOG_WARNING(Service_MVD, "Unable to load FFmpeg, videos won't be decoded");
+        decoder = std::make_unique<NullDecoder>();
+    }
+#else
+    LOG_WARNING(Service_MVD, "No H.264 decoder found, videos won't be decoded");
+    decoder = std::make_unique<NullDecoder>();
+#endif
+    picture.reset();
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+    rb.Push(RESULT_SUCCESS);
+
+    LOG_DEBUG(Service_MVD, "called, work_buffer_address=0x{:08X}, work_buffer_size=0x{:X}",
+              work_buffer_address, work_buffer_size);
+}
+
+void MVD_STD::Shutdown(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x02, 0, 0);
+    decoder.reset();
+    picture.reset();
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+    rb.Push(RESULT_SUCCESS);
+
+    LOG_DEBUG(Service_MVD, "called");
+}
+
+void MVD_STD::CalculateWorkBufSize(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x03, 12, 0);
+    rp.Skip(12, false);
+
+    // The decoding runs on the host, the work buffer is only handed out to be unused
+    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
+    rb.Push(RESULT_SUCCESS);
+    rb.Push(DEFAULT_WORK_BUFFER_SIZE);
+
+    LOG_DEBUG(Service_MVD, "called");
+}
+
+void MVD_STD::CalculateImageSize(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x04, 3, 0);
+    const u32 format = rp.Pop<u32>();
+    const u32 width = rp.Pop<u32>();
+    const u32 height = rp.Pop<u32>();
+
+    // Both output formats store 16 bits per pixel
+    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
+    rb.Push(RESULT_SUCCESS);
+    rb.Push(width * height * 2);
+
+    LOG_DEBUG(Service_MVD, "called, format=0x{:08X}, width={}, height={}", format, width, height);
+}
+
+void MVD_STD::ProcessNALUnit(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x08, 5, 2);
+    const VAddr address = rp.Pop<u32>();
+    const PAddr physical_address = rp.Pop<u32>();
+    const u32 size = rp.Pop<u32>();
+    const u32 flags = rp.Pop<u32>();
+    rp.Skip(1, false);
+    auto process = rp.PopObject<Kernel::Process>();
+
+    ResultCode status = STATUS_OK;
+    if (decoder && process && size != 0) {
+        std::vector<u8> nal_unit(size);
+        system.Memory().ReadBlock(*process, address, nal_unit.data(), nal_unit.size());
+
+        // Skip the start code to find the NAL unit type, 7 and 8 are the parameter sets
+        std::size_t header = 0;
+        while (header + 1 < nal_unit.size() && nal_unit[header] == 0) {
+            ++header;
+        }
+        if (header > 0 && nal_unit[header] == 1) {
+            ++header;
+        }
+        const u8 nal_unit_type = header < nal_unit.size() ? nal_unit[header] & 0x1F : 0;
+
+        decoder->SendNALUnit(nal_unit.data(), nal_unit.size());
+        // The guest renders after each picture, so only the latest one has to be kept
+        while (auto decoded = decoder->ReceivePicture()) {
+            picture = std::move(decoded);
+            status = STATUS_FRAMEREADY;
+        }
+        if (nal_unit_type == 7 || nal_unit_type == 8) {
+            status = STATUS_PARAMSET;
+        }
+    }
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(4, 0);
+    rb.Push(status);
+    rb.Push<u32>(address + size);
+    rb.Push<u32>(physical_address + size);
+    rb.Push<u32>(0);
+
+    LOG_DEBUG(Service_MVD, "called, address=0x{:08X}, size={}, flags=0x{:X}", address, size,
+              flags);
+}
+
+void MVD_STD::ControlFrameRendering(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x09, 1, 2);
+    const bool render = rp.Pop<u32>() != 0;
+    rp.PopObject<Kernel::Process>();
+
+    if (render && picture) {
+        RenderPicture(*picture);
+        picture.reset();
+    }
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
+    rb.Push(RESULT_SUCCESS);
+
+    LOG_TRACE(Service_MVD, "called, render={}", render);
+}
+
+void MVD_STD::GetConfig(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x1D, 1, 2);
+    const u32 size = rp.Pop<u32>();
+    auto& buffer = rp.PopMappedBuffer();
+
+    buffer.Write(&config, 0, std::min<std::size_t>(size, sizeof(config)));
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+    rb.Push(RESULT_SUCCESS);
+    rb.PushMappedBuffer(buffer);
+
+    LOG_DEBUG(Service_MVD, "called, size=0x{:X}", size);
+}
+
+void MVD_STD::SetConfig(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x1E, 1, 4);
+    const u32 size = rp.Pop<u32>();
+    rp.PopObject<Kernel::Process>();
+    auto& buffer = rp.PopMappedBuffer();
+
+    config = {};
+    buffer.Read(&config, 0, std::min<std::size_t>(size, sizeof(config)));
+    if (config.input_format != InputFormat::H264) {
+        LOG_ERROR(Service_MVD, "Unimplemented input format 0x{:08X}",
+                  static_cast<u32>(config.input_format));
+    }
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 2);
+    rb.Push(RESULT_SUCCESS);
+    rb.PushMappedBuffer(buffer);
+
+    LOG_DEBUG(Service_MVD, "called, output_format=0x{:08X}, output={}x{} at 0x{:08X}",
+              static_cast<u32>(config.output_format), config.output_width, config.output_height,
+              config.output_address);
+}
+
+void MVD_STD::RenderPicture(const Picture& picture) {
+    const u32 output_width = config.output_width;
+    const u32 output_height = config.output_height;
+    const u32 size = output_width * output_height * 2;
+    auto& memory = system.Memory();
+    u8* output = memory.GetPhysicalPointer(config.output_address);
+    if (size == 0 || !output || !memory.GetPhysicalPointer(config.output_address + size - 1)) {
+        LOG_ERROR(Service_MVD, "Invalid output buffer at 0x{:08X} of {}x{}",
+                  static_cast<u32>(config.output_address), output_width, output_height);
+        return;
+    }
+
+    // Pictures of another size than the output are cropped or only fill part of it
+    const u32 width = std::min(picture.width, output_width);
+    const u32 height = std::min(picture.height, output_height);
+    const u32 chroma_width = (picture.width + 1) / 2;
+
+    // The guest may have the output buffer in the rasterizer cache, e.g. to upload it as texture
+    Memory::RasterizerFlushAndInvalidateRegion(config.output_address, size);
+
+    switch (config.output_format) {
+    case OutputFormat::YUYV422:
+        for (u32 row = 0; row < height; ++row) {
+            const u8* y = &picture.y[row * picture.width];
+            const u8* u = &picture.u[row / 2 * chroma_width];
+            const u8* v = &picture.v[row / 2 * chroma_width];
+            u8* dest = output + row * output_width * 2;
+            for (u32 column = 0; column < width; ++column) {
+                dest[column * 2] = y[column];
+                dest[column * 2 + 1] = column % 2 == 0 ? u[column / 2] : v[column / 2];
+            }
+        }
+        break;
+    case OutputFormat::RGB565: {
+        // The conversion uses the kernels of the Y2R unit, which take whole groups of 8 pixels
+        const std::size_t line_width = Common::AlignUp(width, 8);
+        std::vector<s16> line_y(line_width), line_u(line_width), line_v(line_width);
+        std::vector<u32> line_rgb(line_width);
+        const auto& coefficients =
+            Y2R::GetStandardCoefficients(Y2R::StandardCoefficient::ITU_Rec601_Scaling);
+        for (u32 row = 0; row < height; ++row) {
+            const u8* y = &picture.y[row * picture.width];
+            const u8* u = &picture.u[row / 2 * chroma_width];
+            const u8* v = &picture.v[row / 2 * chroma_width];
+            for (std::size_t column = 0; column < line_width; ++column) {
+                const std::size_t x = std::min<std::size_t>(column, width - 1);
+                line_y[column] = y[x];
+                line_u[column] = u[x / 2];
+                line_v[column] = v[x / 2];
+            }
+            HW::Y2R::ConvertYUVToRGB32(line_y.data(), line_u.data(), line_v.data(),
+                                       line_rgb.data(), line_width, coefficients);
+            HW::Y2R::EncodeRGB32(line_rgb.data(), output + row * output_width * 2, width,
+                                 Y2R::OutputFormat::RGB565, 0xFF);
+        }
+        break;
+    }
+    default:
+        LOG_ERROR(Service_MVD, "Unimplemented output format 0x{:08X}",
+                  static_cast<u32>(config.output_format));
+        break;
+    }
+}
+
 } // namespace Service::MVD
@@ -4,14 +4,165 @@
 
 #pragma once
 
+#include <memory>
+#include <optional>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/swap.h"
+#include "core/hle/service/mvd/decoder.h"
 #include "core/hle/service/service.h"
 
+namespace Core {
+class System;
+}
+
 namespace Service::MVD {
 
 class MVD_STD final : public ServiceFramework<MVD_STD> {
 public:
-    MVD_STD();
-    ~MVD_STD() = default;
+    explicit MVD_STD(Core::System& system);
+    ~MVD_STD();
+
+private:
+    enum class InputFormat : u32 {
+        YUYV422 = 0x00010001,
+        H264 = 0x00020001,
+    };
+
+    enum class OutputFormat : u32 {
+        YUYV422 = 0x00010001,
+        RGB565 = 0x00040002,
+    };
+
+    /// Decoding parameters, as set by SetConfig
+    struct Config {
+        enum_le<InputFormat> input_format;
+        INSERT_PADDING_WORDS(2);
+        u32_le input_width;
+        u32_le input_height;
+        /// Physical address of the input when converting YUYV422 instead of decoding H.264
+        u32_le input_address;
+        INSERT_PADDING_WORDS(10);
+        u32_le enable_cropping;
+        u32_le crop_x;
+        u32_le crop_y;
+        u32_le crop_height;
+        u32_le crop_width;
+        INSERT_PADDING_WORDS(1);
+        enum_le<OutputFormat> output_format;
+        u32_le output_width;
+        u32_le output_height;
+        /// Physical address the pictures are written to
+        u32_le output_address;
+        u32_le output_address_extra;
+        INSERT_PADDING_WORDS(38);
+        u32_le use_output_size_override;
+        u32_le output_width_override;
+        u32_le output_height_override;
+        INSERT_PADDING_WORDS(1);
+    };
+    static_assert(sizeof(Config) == 0x114, "Config has wrong size");
+
+    /**
+     * MVD_STD::Initialize service function
+     *  Inputs:
+     *      1 : Physical address of the work buffer
+     *      2 : Size of the work buffer
+     *      3 : Handle descriptor
+     *      4 : Process handle
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     */
+    void Initialize(Kernel::HLERequestContext& ctx);
+
+    /**
+     * MVD_STD::Shutdown service function
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     */
+    void Shutdown(Kernel::HLERequestContext& ctx);
+
+    /**
+     * MVD_STD::CalculateWorkBufSize service function
+     *  Inputs:
+     *      1-12 : Decoding parameters
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : Size of the work buffer
+     */
+    void CalculateWorkBufSize(Kernel::HLERequestContext& ctx);
+
+    /**
+     * MVD_STD::CalculateImageSize service function
+     *  Inputs:
+     *      1 : Output format
+     *      2 : Width
+     *      3 : Height
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     *      2 : Size of an output picture in bytes
+     */
+    void CalculateImageSize(Kernel::HLERequestContext& ctx);
+
+    /**
+     * MVD_STD::ProcessNALUnit service function
+     *  Inputs:
+     *      1 : Virtual address of the NAL unit
+     *      2 : Physical address of the NAL unit
+     *      3 : Size of the NAL unit
+     *      4 : Flags
+     *      5 : Unknown
+     *      6 : Handle descriptor
+     *      7 : Process handle
+     *  Outputs:
+     *      1 : Decoding status, an error code on failure
+     *      2 : Virtual address of the end of the processed data
+     *      3 : Physical address of the end of the processed data
+     *      4 : Number of bytes left to process
+     */
+    void ProcessNALUnit(Kernel::HLERequestContext& ctx);
+
+    /**
+     * MVD_STD::ControlFrameRendering service function
+     *  Inputs:
+     *      1 : Whether to write the decoded picture to the output buffer
+     *      2 : Handle descriptor
+     *      3 : Process handle
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     */
+    void ControlFrameRendering(Kernel::HLERequestContext& ctx);
+
+    /**
+     * MVD_STD::GetConfig service function
+     *  Inputs:
+     *      1 : Size of the configuration
+     *      2-3 : Mapped buffer the configuration is written to
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     */
+    void GetConfig(Kernel::HLERequestContext& ctx);
+
+    /**
+     * MVD_STD::SetConfig service function
+     *  Inputs:
+     *      1 : Size of the configuration
+     *      2 : Handle descriptor
+     *      3 : Process handle
+     *      4-5 : Mapped buffer holding the configuration
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     */
+    void SetConfig(Kernel::HLERequestContext& ctx);
+
+    /// Writes the picture to the output buffer in the configured format
+    void RenderPicture(const Picture& picture);
+
+    Core::System& system;
+    Config config{};
+    std::unique_ptr<DecoderBase> decoder;
+    /// The latest decoded picture, which ControlFrameRendering writes to the output buffer
+    std::optional<Picture> picture;
 };
 
 } // namespace Service::MVD
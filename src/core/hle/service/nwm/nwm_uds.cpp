@@ -34,6 +34,19 @@ enum {
 // TODO(Subv): Find a more accurate value for this limit.
 constexpr std::size_t MaxBeaconFrames = 15;
 
+// Number of beacon intervals after which an unchanged beacon is sent again, about one second.
+constexpr u32 UnchangedBeaconRepeatIntervals = 10;
+
+// Time after which a received beacon is dropped, which has to span several repeated beacons.
+constexpr std::chrono::seconds BeaconExpiryTime{3};
+
+// Interval in milliseconds at which the packets received from the network are handled.
+constexpr int ReceivePollInterval = 1;
+
+// Number of queued packets after which received beacons are dropped, which can pile up while the
+// emulation is paused.
+constexpr std::size_t MaxQueuedPackets = 256;
+
 // Network node id used when a SecureData packet is addressed to every connected node.
 constexpr u16 BroadcastNetworkNodeId = 0xFFFF;
 
@@ -42,20 +55,20 @@ constexpr u16 HostDestNodeId = 1;
 
 std::list<Network::WifiPacket> NWM_UDS::GetReceivedBeacons(const MacAddress& sender) {
     std::lock_guard lock(beacon_mutex);
-    if (sender != Network::BroadcastMac) {
-        std::list<Network::WifiPacket> filtered_list;
-        const auto beacon = std::find_if(received_beacons.begin(), received_beacons.end(),
-                                         [&sender](const Network::WifiPacket& packet) {
-                                             return packet.transmitter_address == sender;
-                                         });
-        if (beacon != received_beacons.end()) {
-            filtered_list.push_back(*beacon);
-            // TODO(B3N30): Check if the complete deque is cleared or just the fetched entries
-            received_beacons.erase(beacon);
+    const auto now = std::chrono::steady_clock::now();
+    received_beacons.remove_if([now](const ReceivedBeacon& beacon) {
+        return now - beacon.received_time > BeaconExpiryTime;
+    });
+
+    // Beacons aren't consumed by a scan, a real console would keep receiving them until the host
+    // stops broadcasting.
+    std::list<Network::WifiPacket> filtered_list;
+    for (const ReceivedBeacon& beacon : received_beacons) {
+        if (sender == Network::BroadcastMac || beacon.packet.transmitter_address == sender) {
+            filtered_list.push_back(beacon.packet);
         }
-        return filtered_list;
     }
-    return std::move(received_beacons);
+    return filtered_list;
 }
 
 /// Sends a WifiPacket to the room we're currently connected to.
@@ -132,15 +145,15 @@ void NWM_UDS::HandleBeaconFrame(const Network::WifiPacket& packet) {
     std::lock_guard lock(beacon_mutex);
     const auto unique_beacon =
         std::find_if(received_beacons.begin(), received_beacons.end(),
-                     [&packet](const Network::WifiPacket& new_packet) {
-                         return new_packet.transmitter_address == packet.transmitter_address;
+                     [&packet](const ReceivedBeacon& beacon) {
+                         return beacon.packet.transmitter_address == packet.transmitter_address;
                      });
     if (unique_beacon != received_beacons.end()) {
         // We already have a beacon from the same mac in the deque, remove the old one;
         received_beacons.erase(unique_beacon);
     }
 
-    received_beacons.emplace_back(packet);
+    received_beacons.push_back({packet, std::chrono::steady_clock::now()});
 
     // Discard old beacons if the buffer is full.
     if (received_beacons.size() > MaxBeaconFrames)
@@ -511,6 +524,27 @@ void NWM_UDS::OnWifiPacketReceived(const Network::WifiPacket& packet) {
     }
 }
 
+void NWM_UDS::QueueReceivedPacket(const Network::WifiPacket& packet) {
+    if (packet.type == Network::WifiPacket::PacketType::Beacon &&
+        received_packets.Size() >= MaxQueuedPackets) {
+        return;
+    }
+    received_packets.Push(packet);
+}
+
+void NWM_UDS::HandleReceivedPackets() {
+    Network::WifiPacket packet;
+    while (received_packets.Pop(packet)) {
+        OnWifiPacketReceived(packet);
+    }
+}
+
+void NWM_UDS::ReceiveCallback(u64 userdata, s64 cycles_late) {
+    HandleReceivedPackets();
+    system.CoreTiming().ScheduleEvent(msToCycles(ReceivePollInterval) - cycles_late,
+                                      receive_event, 0);
+}
+
 boost::optional<Network::MacAddress> NWM_UDS::GetNodeMacAddress(u16 dest_node_id, u8 flags) {
     constexpr u8 BroadcastFlag = 0x2;
     if ((flags & BroadcastFlag) || dest_node_id == BroadcastNetworkNodeId) {
@@ -537,6 +571,11 @@ void NWM_UDS::Shutdown(Kernel::HLERequestContext& ctx) {
     if (auto room_member = Network::GetRoomMember().lock())
         room_member->Unbind(wifi_packet_received);
 
+    system.CoreTiming().UnscheduleEvent(receive_event, 0);
+    Network::WifiPacket packet;
+    while (received_packets.Pop(packet)) {
+    }
+
     for (auto bind_node : channel_data) {
         bind_node.second.event->Signal();
     }
@@ -576,6 +615,7 @@ void NWM_UDS::RecvBeaconBroadcastData(Kernel::HLERequestContext& ctx) {
     std::size_t cur_buffer_size = sizeof(BeaconDataReplyHeader);
 
     // Retrieve all beacon frames that were received from the desired mac address.
+    HandleReceivedPackets();
     auto beacons = GetReceivedBeacons(mac_address);
 
     BeaconDataReplyHeader data_reply_header{};
@@ -627,7 +667,9 @@ ResultVal<std::shared_ptr<Kernel::Event>> NWM_UDS::Initialize(
 
     if (auto room_member = Network::GetRoomMember().lock()) {
         wifi_packet_received = room_member->BindOnWifiPacketReceived(
-            [this](const Network::WifiPacket& packet) { OnWifiPacketReceived(packet); });
+            [this](const Network::WifiPacket& packet) { QueueReceivedPacket(packet); });
+        system.CoreTiming().UnscheduleEvent(receive_event, 0);
+        system.CoreTiming().ScheduleEvent(msToCycles(ReceivePollInterval), receive_event, 0);
     } else {
         LOG_ERROR(Service_NWM, "Network isn't initalized");
     }
@@ -684,6 +726,8 @@ void NWM_UDS::GetConnectionStatus(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0xB, 0, 0);
     IPC::RequestBuilder rb = rp.MakeBuilder(13, 0);
 
+    HandleReceivedPackets();
+
     rb.Push(RESULT_SUCCESS);
     {
         std::lock_guard lock(connection_status_mutex);
@@ -874,6 +918,7 @@ ResultCode NWM_UDS::BeginHostingNetwork(const u8* network_info_buffer,
     connection_status_event->Signal();
 
     // Start broadcasting the network, send a beacon frame every 102.4ms.
+    last_beacon_frame.clear();
     system.CoreTiming().ScheduleEvent(msToCycles(DefaultBeaconInterval * MillisecondsPerTU),
                                       beacon_broadcast_event, 0);
 
@@ -1091,6 +1136,7 @@ void NWM_UDS::PullPacket(Kernel::HLERequestContext& ctx) {
     // This size is hard coded into the uds module. We don't know the meaning yet.
     u32 buff_size = std::min<u32>(max_out_buff_size_aligned, 0x172) << 2;
 
+    HandleReceivedPackets();
     std::lock_guard lock(connection_status_mutex);
     if (connection_status.status != static_cast<u32>(NetworkStatus::ConnectedAsHost) &&
         connection_status.status != static_cast<u32>(NetworkStatus::ConnectedAsClient) &&
@@ -1327,14 +1373,21 @@ void NWM_UDS::BeaconBroadcastCallback(u64 userdata, s64 cycles_late) {
 
     std::vector<u8> frame = GenerateBeaconFrame(network_info, node_info);
 
-    using Network::WifiPacket;
-    WifiPacket packet;
-    packet.type = WifiPacket::PacketType::Beacon;
-    packet.data = std::move(frame);
-    packet.destination_address = Network::BroadcastMac;
-    packet.channel = network_channel;
+    // Only send the beacon if the network changed, or now and then to keep it from expiring
+    if (frame != last_beacon_frame ||
+        ++unchanged_beacon_intervals >= UnchangedBeaconRepeatIntervals) {
+        unchanged_beacon_intervals = 0;
+        last_beacon_frame = frame;
 
-    SendPacket(packet);
+        using Network::WifiPacket;
+        WifiPacket packet;
+        packet.type = WifiPacket::PacketType::Beacon;
+        packet.data = std::move(frame);
+        packet.destination_address = Network::BroadcastMac;
+        packet.channel = network_channel;
+
+        SendPacket(packet);
+    }
 
     // Start broadcasting the network, send a beacon frame every 102.4ms.
     system.CoreTiming().ScheduleEvent(msToCycles(DefaultBeaconInterval * MillisecondsPerTU) -
@@ -1382,6 +1435,9 @@ NWM_UDS::NWM_UDS(Core::System& system) : ServiceFramework("nwm::UDS"), system(sy
     beacon_broadcast_event = system.CoreTiming().RegisterEvent(
         "UDS::BeaconBroadcastCallback",
         [this](u64 userdata, s64 cycles_late) { BeaconBroadcastCallback(userdata, cycles_late); });
+    receive_event = system.CoreTiming().RegisterEvent(
+        "UDS::ReceiveCallback",
+        [this](u64 userdata, s64 cycles_late) { ReceiveCallback(userdata, cycles_late); });
 
     CryptoPP::AutoSeededRandomPool rng;
     auto mac = SharedPage::DefaultMac;
@@ -1403,6 +1459,7 @@ NWM_UDS::~NWM_UDS() {
         room_member->Unbind(wifi_packet_received);
 
     system.CoreTiming().UnscheduleEvent(beacon_broadcast_event, 0);
+    system.CoreTiming().UnscheduleEvent(receive_event, 0);
 }
 
 } // namespace Service::NWM
@@ -6,6 +6,7 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <deque>
 #include <list>
@@ -17,6 +18,7 @@
 #include <boost/optional.hpp>
 #include "common/common_types.h"
 #include "common/swap.h"
+#include "common/threadsafe_queue.h"
 #include "core/hle/service/service.h"
 #include "network/network.h"
 
@@ -429,9 +431,12 @@ private:
 
     void BeaconBroadcastCallback(u64 userdata, s64 cycles_late);
 
+    /// Periodically handles the packets that were received from the network in the meantime.
+    void ReceiveCallback(u64 userdata, s64 cycles_late);
+
     /**
-     * Returns a list of received 802.11 beacon frames from the specified sender since the last
-     * call.
+     * Returns a list of the 802.11 beacon frames from the specified sender that haven't expired
+     * yet.
      */
     std::list<Network::WifiPacket> GetReceivedBeacons(const MacAddress& sender);
 
@@ -474,6 +479,12 @@ private:
     /// Callback to parse and handle a received wifi packet.
     void OnWifiPacketReceived(const Network::WifiPacket& packet);
 
+    /// Queues a packet received by the network thread to be handled on the emulation thread.
+    void QueueReceivedPacket(const Network::WifiPacket& packet);
+
+    /// Handles the queued packets, must be called on the emulation thread.
+    void HandleReceivedPackets();
+
     boost::optional<Network::MacAddress> GetNodeMacAddress(u16 dest_node_id, u8 flags);
 
     // Event that is signaled every time the connection status changes.
@@ -528,6 +539,19 @@ private:
     // Event that will generate and send the 802.11 beacon frames.
     Core::TimingEventType* beacon_broadcast_event;
 
+    // The last beacon frame that was sent and the number of beacon intervals it was unchanged for.
+    // Receivers keep beacons until they expire, so unchanged beacons are only repeated now and
+    // then instead of every interval.
+    std::vector<u8> last_beacon_frame;
+    u32 unchanged_beacon_intervals = 0;
+
+    // Event that handles the packets received from the network.
+    Core::TimingEventType* receive_event;
+
+    // Packets received by the network thread, which are handled on the emulation thread so that
+    // the network thread never has to wait for the HLE lock.
+    Common::SPSCQueue<Network::WifiPacket> received_packets;
+
     // Callback identifier for the OnWifiPacketReceived event.
     Network::RoomMember::CallbackHandle<Network::WifiPacket> wifi_packet_received;
 
@@ -541,8 +565,13 @@ private:
     // the network thread.
     std::mutex beacon_mutex;
 
+    struct ReceivedBeacon {
+        Network::WifiPacket packet;
+        std::chrono::steady_clock::time_point received_time;
+    };
+
     // List of the last <MaxBeaconFrames> beacons received from the network.
-    std::list<Network::WifiPacket> received_beacons;
+    std::list<ReceivedBeacon> received_beacons;
 };
 
 } // namespace Service::NWM
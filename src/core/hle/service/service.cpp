@@ -3,10 +3,13 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
 #include <fmt/format.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/tracing.h"
 #include "core/core.h"
+#include "core/hle/cost_accounting.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/handle_table.h"
@@ -137,12 +140,41 @@ void ServiceFrameworkBase::InstallAsNamedPort(Kernel::KernelSystem& kernel) {
     kernel.AddNamedPort(service_name, std::move(client_port));
 }
 
+// Services with higher command ids fall back to the handlers map instead of the dispatch table
+constexpr u32 MAX_DISPATCH_TABLE_SIZE = 0x2000;
+
 void ServiceFrameworkBase::RegisterHandlersBase(const FunctionInfoBase* functions, std::size_t n) {
     handlers.reserve(handlers.size() + n);
     for (std::size_t i = 0; i < n; ++i) {
         // Usually this array is sorted by id already, so hint to insert at the end
         handlers.emplace_hint(handlers.cend(), functions[i].expected_header, functions[i]);
     }
+
+    // Inserting into the map moved its entries, so the table is rebuilt from scratch
+    dispatch_table.clear();
+    for (const auto& [header, info] : handlers) {
+        const u32 command_id = IPC::Header{header}.command_id;
+        if (command_id >= MAX_DISPATCH_TABLE_SIZE)
+            continue;
+        if (command_id >= dispatch_table.size())
+            dispatch_table.resize(command_id + 1, nullptr);
+        // When two handlers share a command id, the first one is kept in the table
+        if (dispatch_table[command_id] == nullptr)
+            dispatch_table[command_id] = &info;
+    }
+}
+
+const ServiceFrameworkBase::FunctionInfoBase* ServiceFrameworkBase::FindHandler(
+    u32 header_code) const {
+    const u32 command_id = IPC::Header{header_code}.command_id;
+    if (command_id < dispatch_table.size()) {
+        const FunctionInfoBase* info = dispatch_table[command_id];
+        if (info != nullptr && info->expected_header == header_code)
+            return info;
+    }
+
+    const auto itr = handlers.find(header_code);
+    return itr == handlers.end() ? nullptr : &itr->second;
 }
 
 void ServiceFrameworkBase::ReportUnimplementedFunction(u32* cmd_buf, const FunctionInfoBase* info) {
@@ -168,8 +200,7 @@ void ServiceFrameworkBase::ReportUnimplementedFunction(u32* cmd_buf, const Funct
 
 void ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context) {
     u32 header_code = context.CommandBuffer()[0];
-    auto itr = handlers.find(header_code);
-    const FunctionInfoBase* info = itr == handlers.end() ? nullptr : &itr->second;
+    const FunctionInfoBase* info = FindHandler(header_code);
     if (info == nullptr || info->handler_callback == nullptr) {
         context.ReportUnimplemented();
         return ReportUnimplementedFunction(context.CommandBuffer(), info);
@@ -177,15 +208,23 @@ void ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context)
 
     LOG_TRACE(Service, "{}",
               MakeFunctionString(info->name, GetServiceName(), context.CommandBuffer()));
+    static Common::Tracing::Category ipc_category{"Service", "IPC Request"};
+    Common::Tracing::Scope trace_scope{ipc_category, info->name, header_code};
+    const auto start = std::chrono::steady_clock::now();
     handler_invoker(this, info->handler_callback, context);
+    const auto time = std::chrono::steady_clock::now() - start;
+    HLE::CostAccounting::AddServiceCall(
+        info, service_name, info->name,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
 }
 
 std::string ServiceFrameworkBase::GetFunctionName(u32 header) const {
-    if (!handlers.count(header)) {
+    const FunctionInfoBase* info = FindHandler(header);
+    if (info == nullptr) {
         return "";
     }
 
-    return handlers.at(header).name;
+    return info->name;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -9,6 +9,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 #include "common/common_types.h"
 #include "core/hle/kernel/hle_ipc.h"
@@ -91,6 +92,9 @@ private:
     void RegisterHandlersBase(const FunctionInfoBase* functions, std::size_t n);
     void ReportUnimplementedFunction(u32* cmd_buf, const FunctionInfoBase* info);
 
+    /// Finds the handler registered for the header code, or returns nullptr if there is none.
+    const FunctionInfoBase* FindHandler(u32 header_code) const;
+
     /// Identifier string used to connect to the service.
     std::string service_name;
     /// Maximum number of concurrent sessions that this service can handle.
@@ -99,6 +103,11 @@ private:
     /// Function used to safely up-cast pointers to the derived class before invoking a handler.
     InvokerFn* handler_invoker;
     boost::container::flat_map<u32, FunctionInfoBase> handlers;
+    /**
+     * Handlers indexed by the command id of their header, so that a request only takes an indexed
+     * load and a compare. Ids that aren't in the table are looked up in `handlers`.
+     */
+    std::vector<const FunctionInfoBase*> dispatch_table;
 };
 
 /**
@@ -4,6 +4,10 @@
 
 #include <algorithm>
 #include <cstring>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <vector>
 #include "common/assert.h"
 #include "common/bit_field.h"
@@ -11,9 +15,12 @@
 #include "common/logging/log.h"
 #include "common/scope_exit.h"
 #include "common/swap.h"
+#include "common/thread.h"
 #include "core/core.h"
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
+#include "core/hle/lock.h"
 #include "core/hle/result.h"
 #include "core/hle/service/soc_u.h"
 
@@ -350,10 +357,244 @@ struct CTRAddrInfo {
 
 static_assert(sizeof(CTRAddrInfo) == 0x130, "Size of CTRAddrInfo is not correct");
 
+/// Returns whether the last socket operation failed only because the socket wasn't ready yet
+static bool WouldBlock() {
+    const int error = GET_ERRNO;
+    return error == ERRNO(EAGAIN) || error == ERRNO(EWOULDBLOCK) || error == ERRNO(EINPROGRESS);
+}
+
+/// Makes the host socket non-blocking, blocking guest calls wait for it in the SocketReactor
+static void SetHostNonBlocking(u32 socket_handle) {
+#ifdef _WIN32
+    unsigned long nonblocking = 1;
+    ioctlsocket(socket_handle, FIONBIO, &nonblocking);
+#else
+    const int flags = ::fcntl(socket_handle, F_GETFL, 0);
+    if (flags != SOCKET_ERROR_VALUE)
+        ::fcntl(socket_handle, F_SETFL, flags | O_NONBLOCK);
+#endif
+}
+
+/**
+ * Waits for the host sockets of blocking guest calls on its own thread, so that the emulation
+ * thread never blocks in the host socket API. Each wait signals its event once any of its sockets
+ * reports one of the requested events, after which the guest thread retries the operation.
+ */
+class SocketReactor {
+public:
+    SocketReactor() {
+        // A UDP socket connected to itself wakes the thread up when the waits changed
+        wake_socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t addr_len = sizeof(addr);
+        has_wake_socket =
+            static_cast<s32>(wake_socket) != SOCKET_ERROR_VALUE &&
+            ::bind(wake_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+            ::getsockname(wake_socket, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0 &&
+            ::connect(wake_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        if (has_wake_socket) {
+            SetHostNonBlocking(static_cast<u32>(wake_socket));
+        } else {
+            LOG_ERROR(Service_SOC, "Failed to create the wake socket of the socket reactor");
+        }
+
+        thread = std::thread([this] { Loop(); });
+    }
+
+    ~SocketReactor() {
+        {
+            std::lock_guard lock{mutex};
+            stop = true;
+            Wake();
+        }
+        thread.join();
+        if (static_cast<s32>(wake_socket) != SOCKET_ERROR_VALUE)
+            closesocket(wake_socket);
+    }
+
+    /**
+     * Signals the event once one of the sockets is ready and the ready check, if any, passes.
+     * Returns the id to cancel the wait with.
+     */
+    u64 Wait(std::vector<pollfd> fds, std::shared_ptr<Kernel::Event> event,
+             std::function<bool()> ready_check) {
+        std::lock_guard lock{mutex};
+        const u64 id = next_id++;
+        waiters.push_back({id, std::move(fds), std::move(event), std::move(ready_check)});
+        Wake();
+        return id;
+    }
+
+    /// Drops the wait if it is still pending
+    void Cancel(u64 id) {
+        std::lock_guard lock{mutex};
+        waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+                                     [id](const Waiter& waiter) { return waiter.id == id; }),
+                      waiters.end());
+    }
+
+    /// Makes the thread poll the sockets again, e.g. because one of them was closed
+    void Wake() {
+        if (has_wake_socket) {
+            const char byte = 0;
+            ::send(wake_socket, &byte, 1, 0);
+        }
+    }
+
+private:
+    using HostSocket = decltype(pollfd::fd);
+
+    struct Waiter {
+        u64 id;
+        std::vector<pollfd> fds;
+        std::shared_ptr<Kernel::Event> event;
+        std::function<bool()> ready_check;
+    };
+
+    void Loop() {
+        Common::SetCurrentThreadName("SocketReactor");
+
+        // Without the wake socket, new waits are only picked up after a short timeout
+        const std::size_t first_fd = has_wake_socket ? 1 : 0;
+        const int poll_timeout = has_wake_socket ? -1 : 10;
+
+        std::vector<pollfd> fds;
+        std::vector<std::pair<u64, std::size_t>> polled; // Id and number of sockets of each wait
+        std::vector<Waiter> ready;
+        while (true) {
+            fds.clear();
+            polled.clear();
+            if (has_wake_socket) {
+                pollfd wake_fd{};
+                wake_fd.fd = wake_socket;
+                wake_fd.events = POLLIN;
+                fds.push_back(wake_fd);
+            }
+            {
+                std::lock_guard lock{mutex};
+                if (stop)
+                    break;
+                for (const Waiter& waiter : waiters) {
+                    fds.insert(fds.end(), waiter.fds.begin(), waiter.fds.end());
+                    polled.emplace_back(waiter.id, waiter.fds.size());
+                }
+            }
+
+            const s32 result = ::poll(fds.data(), static_cast<u32>(fds.size()), poll_timeout);
+            if (result == SOCKET_ERROR_VALUE)
+                continue;
+
+            if (has_wake_socket && fds[0].revents != 0) {
+                char buffer[64];
+                while (::recv(wake_socket, buffer, sizeof(buffer), 0) > 0) {
+                }
+            }
+
+            {
+                std::lock_guard lock{mutex};
+                std::size_t offset = first_fd;
+                for (const auto& [id, count] : polled) {
+                    const auto begin = fds.begin() + offset;
+                    offset += count;
+                    if (std::none_of(begin, begin + count,
+                                     [](const pollfd& fd) { return fd.revents != 0; })) {
+                        continue;
+                    }
+                    const auto waiter =
+                        std::find_if(waiters.begin(), waiters.end(),
+                                     [id = id](const Waiter& waiter) { return waiter.id == id; });
+                    if (waiter != waiters.end()) {
+                        ready.push_back(std::move(*waiter));
+                        waiters.erase(waiter);
+                    }
+                }
+            }
+
+            if (!ready.empty()) {
+                // The mutex isn't held here, as the emulation thread adds waits with the HLE lock
+                std::lock_guard hle_lock{HLE::g_hle_lock};
+                for (Waiter& waiter : ready) {
+                    if (!waiter.ready_check || waiter.ready_check()) {
+                        waiter.event->Signal();
+                        continue;
+                    }
+                    // Woken up spuriously, the guest keeps waiting
+                    std::lock_guard lock{mutex};
+                    waiters.push_back(std::move(waiter));
+                }
+                ready.clear();
+            }
+        }
+    }
+
+    std::thread thread;
+    HostSocket wake_socket;
+    bool has_wake_socket = false;
+
+    std::mutex mutex;
+    std::vector<Waiter> waiters;
+    u64 next_id = 1;
+    bool stop = false;
+};
+
 void SOC_U::CleanupSockets() {
     for (auto sock : open_sockets)
         closesocket(sock.second.socket_fd);
     open_sockets.clear();
+    if (reactor)
+        reactor->Wake();
+}
+
+bool SOC_U::IsBlocking(u32 socket_handle) const {
+    const auto iter = open_sockets.find(socket_handle);
+    return iter != open_sockets.end() && iter->second.blocking;
+}
+
+void SOC_U::WaitForSockets(Kernel::HLERequestContext& ctx, const char* reason,
+                           std::vector<SocketWait> waits, std::chrono::nanoseconds timeout,
+                           RetryCallback retry, ReadyCheck ready_check) {
+    std::vector<pollfd> fds(waits.size());
+    for (std::size_t i = 0; i < waits.size(); ++i) {
+        fds[i].fd = static_cast<decltype(pollfd::fd)>(waits[i].socket_fd);
+        fds[i].events = waits[i].events;
+    }
+
+    auto wait_id = std::make_shared<u64>(0);
+    auto event = ctx.SleepClientThread(
+        reason, timeout,
+        [this, wait_id, retry = std::move(retry)](std::shared_ptr<Kernel::Thread> thread,
+                                                  Kernel::HLERequestContext& ctx,
+                                                  Kernel::ThreadWakeupReason reason) {
+            reactor->Cancel(*wait_id);
+            retry(ctx, reason == Kernel::ThreadWakeupReason::Timeout);
+        });
+    *wait_id = reactor->Wait(std::move(fds), std::move(event), std::move(ready_check));
+}
+
+template <typename TryOperation, typename Reply>
+void SOC_U::RunSocketOperation(Kernel::HLERequestContext& ctx, const char* reason,
+                               SocketWait wait, TryOperation try_operation, Reply reply) {
+    auto result = try_operation(IsBlocking(wait.socket_fd));
+    if (result) {
+        reply(ctx, *result);
+        return;
+    }
+
+    auto pending = std::make_shared<decltype(result)>();
+    WaitForSockets(
+        ctx, reason, {wait}, std::chrono::nanoseconds(-1),
+        [try_operation, reply, pending](Kernel::HLERequestContext& ctx, bool) mutable {
+            if (!*pending) {
+                *pending = try_operation(false);
+            }
+            reply(ctx, **pending);
+        },
+        [try_operation, pending]() mutable {
+            *pending = try_operation(true);
+            return pending->has_value();
+        });
 }
 
 void SOC_U::Socket(Kernel::HLERequestContext& ctx) {
@@ -386,8 +627,10 @@ void SOC_U::Socket(Kernel::HLERequestContext& ctx) {
 
     u32 ret = static_cast<u32>(::socket(domain, type, protocol));
 
-    if ((s32)ret != SOCKET_ERROR_VALUE)
+    if ((s32)ret != SOCKET_ERROR_VALUE) {
+        SetHostNonBlocking(ret);
         open_sockets[ret] = {ret, true};
+    }
 
     if ((s32)ret == SOCKET_ERROR_VALUE)
         ret = TranslateError(GET_ERRNO);
@@ -432,50 +675,19 @@ void SOC_U::Fcntl(Kernel::HLERequestContext& ctx) {
         rb.Push(posix_ret);
     });
 
+    // Host sockets are always non-blocking, only the mode the guest sees is changed
+    auto iter = open_sockets.find(socket_handle);
+    if (iter == open_sockets.end() && (ctr_cmd == 3 || ctr_cmd == 4)) {
+        posix_ret = TranslateError(ERRNO(EBADF));
+        return;
+    }
+
     if (ctr_cmd == 3) { // F_GETFL
-#ifdef _WIN32
         posix_ret = 0;
-        auto iter = open_sockets.find(socket_handle);
-        if (iter != open_sockets.end() && iter->second.blocking == false)
+        if (!iter->second.blocking)
             posix_ret |= 4; // O_NONBLOCK
-#else
-        int ret = ::fcntl(socket_handle, F_GETFL, 0);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-        posix_ret = 0;
-        if (ret & O_NONBLOCK)
-            posix_ret |= 4; // O_NONBLOCK
-#endif
     } else if (ctr_cmd == 4) { // F_SETFL
-#ifdef _WIN32
-        unsigned long tmp = (ctr_arg & 4 /* O_NONBLOCK */) ? 1 : 0;
-        int ret = ioctlsocket(socket_handle, FIONBIO, &tmp);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-        auto iter = open_sockets.find(socket_handle);
-        if (iter != open_sockets.end())
-            iter->second.blocking = (tmp == 0);
-#else
-        int flags = ::fcntl(socket_handle, F_GETFL, 0);
-        if (flags == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-
-        flags &= ~O_NONBLOCK;
-        if (ctr_arg & 4) // O_NONBLOCK
-            flags |= O_NONBLOCK;
-
-        int ret = ::fcntl(socket_handle, F_SETFL, flags);
-        if (ret == SOCKET_ERROR_VALUE) {
-            posix_ret = TranslateError(GET_ERRNO);
-            return;
-        }
-#endif
+        iter->second.blocking = (ctr_arg & 4 /* O_NONBLOCK */) == 0;
     } else {
         LOG_ERROR(Service_SOC, "Unsupported command ({}) in fcntl call", ctr_cmd);
         posix_ret = TranslateError(EINVAL); // TODO: Find the correct error
@@ -499,33 +711,47 @@ void SOC_U::Listen(Kernel::HLERequestContext& ctx) {
 }
 
 void SOC_U::Accept(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x04, 2, 2);
     u32 socket_handle = rp.Pop<u32>();
     socklen_t max_addr_len = static_cast<socklen_t>(rp.Pop<u32>());
     rp.PopPID();
-    sockaddr addr;
-    socklen_t addr_len = sizeof(addr);
-    u32 ret = static_cast<u32>(::accept(socket_handle, &addr, &addr_len));
 
-    if ((s32)ret != SOCKET_ERROR_VALUE)
-        open_sockets[ret] = {ret, true};
+    struct AcceptResult {
+        u32 ret;
+        std::vector<u8> ctr_addr_buf;
+    };
 
-    CTRSockAddr ctr_addr;
-    std::vector<u8> ctr_addr_buf(sizeof(ctr_addr));
-    if ((s32)ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-    } else {
-        ctr_addr = CTRSockAddr::FromPlatform(addr);
-        std::memcpy(ctr_addr_buf.data(), &ctr_addr, sizeof(ctr_addr));
-    }
+    // Returns nothing if the guest has to wait for a connection
+    const auto try_accept = [this, socket_handle](bool can_wait) -> std::optional<AcceptResult> {
+        sockaddr addr;
+        socklen_t addr_len = sizeof(addr);
+        u32 ret = static_cast<u32>(::accept(socket_handle, &addr, &addr_len));
+        if ((s32)ret == SOCKET_ERROR_VALUE && can_wait && WouldBlock())
+            return std::nullopt;
+
+        if ((s32)ret != SOCKET_ERROR_VALUE) {
+            SetHostNonBlocking(ret);
+            open_sockets[ret] = {ret, true};
+        }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(ctr_addr_buf, 0);
+        CTRSockAddr ctr_addr;
+        std::vector<u8> ctr_addr_buf(sizeof(ctr_addr));
+        if ((s32)ret == SOCKET_ERROR_VALUE) {
+            ret = TranslateError(GET_ERRNO);
+        } else {
+            ctr_addr = CTRSockAddr::FromPlatform(addr);
+            std::memcpy(ctr_addr_buf.data(), &ctr_addr, sizeof(ctr_addr));
+        }
+        return AcceptResult{ret, std::move(ctr_addr_buf)};
+    };
+    const auto write_reply = [](Kernel::HLERequestContext& ctx, const AcceptResult& result) {
+        IPC::RequestBuilder rb(ctx, 0x04, 2, 2);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(result.ret);
+        rb.PushStaticBuffer(result.ctr_addr_buf, 0);
+    };
+
+    RunSocketOperation(ctx, "soc_u::Accept", {socket_handle, POLLIN}, try_accept, write_reply);
 }
 
 void SOC_U::GetHostId(Kernel::HLERequestContext& ctx) {
@@ -560,6 +786,9 @@ void SOC_U::Close(Kernel::HLERequestContext& ctx) {
     if (ret != 0)
         ret = TranslateError(GET_ERRNO);
 
+    // Guest threads waiting for the socket retry and report the error
+    reactor->Wake();
+
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
     rb.Push(RESULT_SUCCESS);
     rb.Push(ret);
@@ -575,24 +804,35 @@ void SOC_U::SendTo(Kernel::HLERequestContext& ctx) {
     auto input_buff = rp.PopStaticBuffer();
     auto dest_addr_buff = rp.PopStaticBuffer();
 
-    s32 ret = -1;
-    if (addr_len > 0) {
-        CTRSockAddr ctr_dest_addr;
-        std::memcpy(&ctr_dest_addr, dest_addr_buff.data(), sizeof(ctr_dest_addr));
-        sockaddr dest_addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
-        ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff.data()), len, flags,
-                       &dest_addr, sizeof(dest_addr));
-    } else {
-        ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff.data()), len, flags,
-                       nullptr, 0);
-    }
+    // Returns nothing if the guest has to wait for buffer space
+    const auto try_send = [socket_handle, len, flags, addr_len, input_buff,
+                           dest_addr_buff](bool can_wait) -> std::optional<s32> {
+        s32 ret = -1;
+        if (addr_len > 0) {
+            CTRSockAddr ctr_dest_addr;
+            std::memcpy(&ctr_dest_addr, dest_addr_buff.data(), sizeof(ctr_dest_addr));
+            sockaddr dest_addr = CTRSockAddr::ToPlatform(ctr_dest_addr);
+            ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff.data()), len,
+                           flags, &dest_addr, sizeof(dest_addr));
+        } else {
+            ret = ::sendto(socket_handle, reinterpret_cast<const char*>(input_buff.data()), len,
+                           flags, nullptr, 0);
+        }
 
-    if (ret == SOCKET_ERROR_VALUE)
-        ret = TranslateError(GET_ERRNO);
+        if (ret == SOCKET_ERROR_VALUE) {
+            if (can_wait && WouldBlock())
+                return std::nullopt;
+            ret = TranslateError(GET_ERRNO);
+        }
+        return ret;
+    };
+    const auto write_reply = [](Kernel::HLERequestContext& ctx, s32 ret) {
+        IPC::RequestBuilder rb(ctx, 0x0A, 2, 0);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+    };
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
+    RunSocketOperation(ctx, "soc_u::SendTo", {socket_handle, POLLOUT}, try_send, write_reply);
 }
 
 void SOC_U::RecvFromOther(Kernel::HLERequestContext& ctx) {
@@ -604,43 +844,59 @@ void SOC_U::RecvFromOther(Kernel::HLERequestContext& ctx) {
     rp.PopPID();
     auto& buffer = rp.PopMappedBuffer();
 
-    CTRSockAddr ctr_src_addr;
-    std::vector<u8> output_buff(len);
-    std::vector<u8> addr_buff(sizeof(ctr_src_addr));
-    sockaddr src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
+    struct ReceiveResult {
+        s32 ret;
+        std::vector<u8> output_buff;
+        std::vector<u8> addr_buff;
+    };
 
-    s32 ret = -1;
-    if (addr_len > 0) {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         &src_addr, &src_addr_len);
-        if (ret >= 0 && src_addr_len > 0) {
-            ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
-            std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+    // Returns nothing if the guest has to wait for data
+    const auto try_receive = [socket_handle, len, flags,
+                              addr_len](bool can_wait) -> std::optional<ReceiveResult> {
+        CTRSockAddr ctr_src_addr;
+        std::vector<u8> output_buff(len);
+        std::vector<u8> addr_buff(sizeof(ctr_src_addr));
+        sockaddr src_addr;
+        socklen_t src_addr_len = sizeof(src_addr);
+
+        s32 ret = -1;
+        if (addr_len > 0) {
+            ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len,
+                             flags, &src_addr, &src_addr_len);
+            if (ret >= 0 && src_addr_len > 0) {
+                ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
+                std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+            }
+        } else {
+            ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len,
+                             flags, NULL, 0);
+            addr_buff.resize(0);
         }
-    } else {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         NULL, 0);
-        addr_buff.resize(0);
-    }
 
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-    } else {
-        buffer.Write(output_buff.data(), 0, ret);
-    }
+        if (ret == SOCKET_ERROR_VALUE) {
+            if (can_wait && WouldBlock())
+                return std::nullopt;
+            ret = TranslateError(GET_ERRNO);
+        }
+        return ReceiveResult{ret, std::move(output_buff), std::move(addr_buff)};
+    };
+    const auto write_reply = [buffer](Kernel::HLERequestContext& ctx,
+                                      const ReceiveResult& result) mutable {
+        if (result.ret >= 0) {
+            buffer.Write(result.output_buff.data(), 0, result.ret);
+        }
+        IPC::RequestBuilder rb(ctx, 0x7, 2, 4);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(result.ret);
+        rb.PushStaticBuffer(result.addr_buff, 0);
+        rb.PushMappedBuffer(buffer);
+    };
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 4);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(addr_buff, 0);
-    rb.PushMappedBuffer(buffer);
+    RunSocketOperation(ctx, "soc_u::RecvFromOther", {socket_handle, POLLIN}, try_receive,
+                       write_reply);
 }
 
 void SOC_U::RecvFrom(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x08, 4, 2);
     u32 socket_handle = rp.Pop<u32>();
     u32 len = rp.Pop<u32>();
@@ -648,42 +904,59 @@ void SOC_U::RecvFrom(Kernel::HLERequestContext& ctx) {
     u32 addr_len = rp.Pop<u32>();
     rp.PopPID();
 
-    CTRSockAddr ctr_src_addr;
-    std::vector<u8> output_buff(len);
-    std::vector<u8> addr_buff(sizeof(ctr_src_addr));
-    sockaddr src_addr;
-    socklen_t src_addr_len = sizeof(src_addr);
+    struct ReceiveResult {
+        s32 ret;
+        s32 total_received;
+        std::vector<u8> output_buff;
+        std::vector<u8> addr_buff;
+    };
 
-    s32 ret = -1;
-    if (addr_len > 0) {
-        // Only get src adr if input adr available
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         &src_addr, &src_addr_len);
-        if (ret >= 0 && src_addr_len > 0) {
-            ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
-            std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+    // Returns nothing if the guest has to wait for data
+    const auto try_receive = [socket_handle, len, flags,
+                              addr_len](bool can_wait) -> std::optional<ReceiveResult> {
+        CTRSockAddr ctr_src_addr;
+        std::vector<u8> output_buff(len);
+        std::vector<u8> addr_buff(sizeof(ctr_src_addr));
+        sockaddr src_addr;
+        socklen_t src_addr_len = sizeof(src_addr);
+
+        s32 ret = -1;
+        if (addr_len > 0) {
+            // Only get src adr if input adr available
+            ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len,
+                             flags, &src_addr, &src_addr_len);
+            if (ret >= 0 && src_addr_len > 0) {
+                ctr_src_addr = CTRSockAddr::FromPlatform(src_addr);
+                std::memcpy(addr_buff.data(), &ctr_src_addr, sizeof(ctr_src_addr));
+            }
+        } else {
+            ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len,
+                             flags, NULL, 0);
+            addr_buff.resize(0);
         }
-    } else {
-        ret = ::recvfrom(socket_handle, reinterpret_cast<char*>(output_buff.data()), len, flags,
-                         NULL, 0);
-        addr_buff.resize(0);
-    }
 
-    s32 total_received = ret;
-    if (ret == SOCKET_ERROR_VALUE) {
-        ret = TranslateError(GET_ERRNO);
-        total_received = 0;
-    }
+        s32 total_received = ret;
+        if (ret == SOCKET_ERROR_VALUE) {
+            if (can_wait && WouldBlock())
+                return std::nullopt;
+            ret = TranslateError(GET_ERRNO);
+            total_received = 0;
+        }
 
-    // Write only the data we received to avoid overwriting parts of the buffer with zeros
-    output_buff.resize(total_received);
+        // Write only the data we received to avoid overwriting parts of the buffer with zeros
+        output_buff.resize(total_received);
+        return ReceiveResult{ret, total_received, std::move(output_buff), std::move(addr_buff)};
+    };
+    const auto write_reply = [](Kernel::HLERequestContext& ctx, const ReceiveResult& result) {
+        IPC::RequestBuilder rb(ctx, 0x08, 3, 4);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(result.ret);
+        rb.Push(result.total_received);
+        rb.PushStaticBuffer(result.output_buff, 0);
+        rb.PushStaticBuffer(result.addr_buff, 1);
+    };
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(3, 4);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.Push(total_received);
-    rb.PushStaticBuffer(output_buff, 0);
-    rb.PushStaticBuffer(addr_buff, 1);
+    RunSocketOperation(ctx, "soc_u::RecvFrom", {socket_handle, POLLIN}, try_receive, write_reply);
 }
 
 void SOC_U::Poll(Kernel::HLERequestContext& ctx) {
@@ -702,22 +975,43 @@ void SOC_U::Poll(Kernel::HLERequestContext& ctx) {
     std::vector<pollfd> platform_pollfd(nfds);
     std::transform(ctr_fds.begin(), ctr_fds.end(), platform_pollfd.begin(), CTRPollFD::ToPlatform);
 
-    s32 ret = ::poll(platform_pollfd.data(), nfds, timeout);
+    // The host is only asked for the current state, the timeout is waited for by the reactor.
+    // Returns false without writing a reply if the guest has to wait for an event.
+    const auto try_poll = [nfds](Kernel::HLERequestContext& ctx, std::vector<pollfd> fds,
+                                 bool can_wait) {
+        s32 ret = ::poll(fds.data(), nfds, 0);
+        if (ret == 0 && can_wait)
+            return false;
 
-    // Now update the output pollfd structure
-    std::transform(platform_pollfd.begin(), platform_pollfd.end(), ctr_fds.begin(),
-                   CTRPollFD::FromPlatform);
+        // Now update the output pollfd structure
+        std::vector<CTRPollFD> ctr_fds(nfds);
+        std::transform(fds.begin(), fds.end(), ctr_fds.begin(), CTRPollFD::FromPlatform);
 
-    std::vector<u8> output_fds(nfds * sizeof(CTRPollFD));
-    std::memcpy(output_fds.data(), ctr_fds.data(), nfds * sizeof(CTRPollFD));
+        std::vector<u8> output_fds(nfds * sizeof(CTRPollFD));
+        std::memcpy(output_fds.data(), ctr_fds.data(), nfds * sizeof(CTRPollFD));
 
-    if (ret == SOCKET_ERROR_VALUE)
-        ret = TranslateError(GET_ERRNO);
+        if (ret == SOCKET_ERROR_VALUE)
+            ret = TranslateError(GET_ERRNO);
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
-    rb.PushStaticBuffer(output_fds, 0);
+        IPC::RequestBuilder rb(ctx, 0x14, 2, 2);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+        rb.PushStaticBuffer(output_fds, 0);
+        return true;
+    };
+
+    if (!try_poll(ctx, platform_pollfd, timeout != 0)) {
+        std::vector<SocketWait> waits;
+        for (const pollfd& fd : platform_pollfd) {
+            waits.push_back({static_cast<u32>(fd.fd), fd.events});
+        }
+        const std::chrono::nanoseconds wait_timeout =
+            timeout < 0 ? std::chrono::nanoseconds(-1) : std::chrono::milliseconds(timeout);
+        WaitForSockets(ctx, "soc_u::Poll", std::move(waits), wait_timeout,
+                       [try_poll, platform_pollfd](Kernel::HLERequestContext& ctx, bool) {
+                           try_poll(ctx, platform_pollfd, false);
+                       });
+    }
 }
 
 void SOC_U::GetSockName(Kernel::HLERequestContext& ctx) {
@@ -782,9 +1076,6 @@ void SOC_U::GetPeerName(Kernel::HLERequestContext& ctx) {
 }
 
 void SOC_U::Connect(Kernel::HLERequestContext& ctx) {
-    // TODO(Subv): Calling this function on a blocking socket will block the emu thread,
-    // preventing graceful shutdown when closing the emulator, this can be fixed by always
-    // performing nonblocking operations and spinlock until the data is available
     IPC::RequestParser rp(ctx, 0x06, 2, 4);
     u32 socket_handle = rp.Pop<u32>();
     u32 input_addr_len = rp.Pop<u32>();
@@ -794,14 +1085,36 @@ void SOC_U::Connect(Kernel::HLERequestContext& ctx) {
     CTRSockAddr ctr_input_addr;
     std::memcpy(&ctr_input_addr, input_addr_buf.data(), sizeof(ctr_input_addr));
 
+    const auto reply = [](Kernel::HLERequestContext& ctx, s32 ret) {
+        IPC::RequestBuilder rb(ctx, 0x06, 2, 0);
+        rb.Push(RESULT_SUCCESS);
+        rb.Push(ret);
+    };
+
     sockaddr input_addr = CTRSockAddr::ToPlatform(ctr_input_addr);
     s32 ret = ::connect(socket_handle, &input_addr, sizeof(input_addr));
-    if (ret != 0)
+    if (ret != 0) {
+        if (IsBlocking(socket_handle) && WouldBlock()) {
+            // The connection is established once the socket becomes writable
+            WaitForSockets(ctx, "soc_u::Connect", {{socket_handle, POLLOUT}},
+                           std::chrono::nanoseconds(-1),
+                           [socket_handle, reply](Kernel::HLERequestContext& ctx, bool) {
+                               int error = 0;
+                               socklen_t error_len = sizeof(error);
+                               s32 ret = 0;
+                               if (::getsockopt(socket_handle, SOL_SOCKET, SO_ERROR,
+                                                reinterpret_cast<char*>(&error), &error_len) != 0) {
+                                   ret = TranslateError(GET_ERRNO);
+                               } else if (error != 0) {
+                                   ret = TranslateError(error);
+                               }
+                               reply(ctx, ret);
+                           });
+            return;
+        }
         ret = TranslateError(GET_ERRNO);
-
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
-    rb.Push(RESULT_SUCCESS);
-    rb.Push(ret);
+    }
+    reply(ctx, ret);
 }
 
 void SOC_U::InitializeSockets(Kernel::HLERequestContext& ctx) {
@@ -1020,10 +1333,13 @@ SOC_U::SOC_U() : ServiceFramework("soc:U") {
     WSADATA data;
     WSAStartup(MAKEWORD(2, 2), &data);
 #endif
+
+    reactor = std::make_unique<SocketReactor>();
 }
 
 SOC_U::~SOC_U() {
     CleanupSockets();
+    reactor.reset();
 #ifdef _WIN32
     WSACleanup();
 #endif
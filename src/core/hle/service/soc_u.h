@@ -4,7 +4,11 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 #include "core/hle/service/service.h"
 
 namespace Core {
@@ -15,10 +19,18 @@ namespace Service::SOC {
 
 /// Holds information about a particular socket
 struct SocketHolder {
-    u32 socket_fd; ///< The socket descriptor
-    bool blocking; ///< Whether the socket is blocking or not, it is only read on Windows.
+    u32 socket_fd; ///< The socket descriptor, which is always non-blocking on the host
+    bool blocking; ///< Whether the socket is blocking for the guest
 };
 
+/// Events to wait for on a socket, see SOC_U::WaitForSockets
+struct SocketWait {
+    u32 socket_fd;
+    s16 events; ///< Host poll events
+};
+
+class SocketReactor;
+
 class SOC_U final : public ServiceFramework<SOC_U> {
 public:
     SOC_U();
@@ -53,8 +65,41 @@ private:
     /// Close all open sockets
     void CleanupSockets();
 
+    /// Returns whether the socket is blocking for the guest
+    bool IsBlocking(u32 socket_handle) const;
+
+    /// Called with the context of the request once the socket is ready, or with timed_out set
+    using RetryCallback = std::function<void(Kernel::HLERequestContext& ctx, bool timed_out)>;
+    /// Tries the operation on the reactor thread, returns false if it still has to wait
+    using ReadyCheck = std::function<bool()>;
+
+    /**
+     * Puts the requesting guest thread to sleep until one of the sockets is ready for the
+     * requested events or the timeout expires, after which the callback has to retry the
+     * operation and write the complete reply. A negative timeout waits indefinitely.
+     * The optional ready check runs with the HLE lock held whenever the sockets became ready, and
+     * keeps the thread asleep while it fails, e.g. when a connection is gone before it could be
+     * accepted.
+     */
+    void WaitForSockets(Kernel::HLERequestContext& ctx, const char* reason,
+                        std::vector<SocketWait> waits, std::chrono::nanoseconds timeout,
+                        RetryCallback retry, ReadyCheck ready_check = nullptr);
+
+    /**
+     * Runs an operation on a socket, which takes whether it may wait and returns nothing if it
+     * would block, and writes the reply with its result. A blocking guest waits for the events
+     * meanwhile, and the operation is retried by the ready check of the wait, so that it never
+     * sees EAGAIN when the socket turns out not to be ready after all.
+     */
+    template <typename TryOperation, typename Reply>
+    void RunSocketOperation(Kernel::HLERequestContext& ctx, const char* reason, SocketWait wait,
+                            TryOperation try_operation, Reply reply);
+
     /// Holds info about the currently open sockets
     std::unordered_map<u32, SocketHolder> open_sockets;
+
+    /// Waits for the sockets of blocking guest calls on a host thread
+    std::unique_ptr<SocketReactor> reactor;
 };
 
 void InstallInterfaces(Core::System& system);
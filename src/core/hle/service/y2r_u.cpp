@@ -21,6 +21,10 @@ static const CoefficientSet standard_coefficients[4] = {
     {{0x12A, 0x1CA, 0x88, 0x36, 0x21C, -0x1F04, 0x99C, -0x2421}},  // ITU_Rec709_Scaling
 };
 
+const CoefficientSet& GetStandardCoefficients(StandardCoefficient standard_coefficient) {
+    return standard_coefficients[static_cast<std::size_t>(standard_coefficient)];
+}
+
 ResultCode ConversionConfiguration::SetInputLineWidth(u16 width) {
     if (width == 0 || width > 1024 || width % 8 != 0) {
         return ResultCode(ErrorDescription::OutOfRange, ErrorModule::CAM,
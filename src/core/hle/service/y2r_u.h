@@ -82,6 +82,9 @@ enum class StandardCoefficient : u8 {
  */
 using CoefficientSet = std::array<s16, 8>;
 
+/// Returns the coefficients of a standard colour space, which must be a valid StandardCoefficient
+const CoefficientSet& GetStandardCoefficients(StandardCoefficient standard_coefficient);
+
 struct ConversionBuffer {
     /// Current reading/writing address of this buffer.
     VAddr address;
@@ -6,7 +6,6 @@
 #include <cryptopp/aes.h>
 #include <cryptopp/ccm.h>
 #include <cryptopp/cryptlib.h>
-#include <cryptopp/filters.h>
 #include "common/alignment.h"
 #include "common/logging/log.h"
 #include "core/hw/aes/ccm.h"
@@ -50,13 +49,13 @@ std::vector<u8> EncryptSignCCM(const std::vector<u8>& pdata, const CCMNonce& non
     const AESKey normal = GetNormalKey(slot_id);
     std::vector<u8> cipher(pdata.size() + CCM_MAC_SIZE);
 
+    // The data is processed in one go instead of through a filter chain, which would copy it
     try {
         CCM_3DSVariant::Encryption e;
         e.SetKeyWithIV(normal.data(), AES_BLOCK_SIZE, nonce.data(), CCM_NONCE_SIZE);
         e.SpecifyDataLengths(0, pdata.size(), 0);
-        CryptoPP::ArraySource as(pdata.data(), pdata.size(), true,
-                                 new CryptoPP::AuthenticatedEncryptionFilter(
-                                     e, new CryptoPP::ArraySink(cipher.data(), cipher.size())));
+        e.ProcessData(cipher.data(), pdata.data(), pdata.size());
+        e.TruncatedFinal(cipher.data() + pdata.size(), CCM_MAC_SIZE);
     } catch (const CryptoPP::Exception& e) {
         LOG_ERROR(HW_AES, "FAILED with: {}", e.what());
     }
@@ -76,10 +75,8 @@ std::vector<u8> DecryptVerifyCCM(const std::vector<u8>& cipher, const CCMNonce&
         CCM_3DSVariant::Decryption d;
         d.SetKeyWithIV(normal.data(), AES_BLOCK_SIZE, nonce.data(), CCM_NONCE_SIZE);
         d.SpecifyDataLengths(0, pdata_size, 0);
-        CryptoPP::AuthenticatedDecryptionFilter df(
-            d, new CryptoPP::ArraySink(pdata.data(), pdata_size));
-        CryptoPP::ArraySource as(cipher.data(), cipher.size(), true, new CryptoPP::Redirector(df));
-        if (!df.GetLastResult()) {
+        d.ProcessData(pdata.data(), cipher.data(), pdata_size);
+        if (!d.TruncatedVerify(cipher.data() + pdata_size, CCM_MAC_SIZE)) {
             LOG_ERROR(HW_AES, "FAILED");
             return {};
         }
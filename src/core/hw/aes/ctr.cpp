@@ -0,0 +1,40 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cryptopp/aes.h>
+#include <cryptopp/cpu.h>
+#include <cryptopp/modes.h>
+#include "core/hw/aes/ctr.h"
+
+namespace HW::AES {
+
+struct CTRCipher::Impl {
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption cipher;
+};
+
+CTRCipher::CTRCipher(const AESKey& key, const AESKey& ctr) : impl(std::make_unique<Impl>()) {
+    impl->cipher.SetKeyWithIV(key.data(), key.size(), ctr.data());
+}
+
+CTRCipher::~CTRCipher() = default;
+
+void CTRCipher::Process(u64 offset, const u8* in, u8* out, std::size_t size) {
+    if (size == 0)
+        return; // Crypto++ does not like zero size buffer
+    impl->cipher.Seek(offset);
+    impl->cipher.ProcessData(out, in, size);
+}
+
+const char* GetAccelerationName() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    if (CryptoPP::HasAESNI())
+        return "AES-NI";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    if (CryptoPP::HasAES())
+        return "ARMv8 crypto extensions";
+#endif
+    return "no AES instructions";
+}
+
+} // namespace HW::AES
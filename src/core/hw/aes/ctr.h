@@ -0,0 +1,41 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "common/common_types.h"
+#include "core/hw/aes/key.h"
+
+namespace HW::AES {
+
+/**
+ * AES-CTR keystream that can be applied at any offset of the stream. The key schedule is only
+ * computed once, which matters for the many small reads of the RomFS. Crypto++ selects AES-NI or
+ * the ARMv8 crypto extensions at runtime when the host supports them.
+ */
+class CTRCipher {
+public:
+    CTRCipher(const AESKey& key, const AESKey& ctr);
+    ~CTRCipher();
+
+    /**
+     * Encrypts or decrypts data located at the given offset of the stream.
+     * @param offset Offset of the data from the start of the stream
+     * @param in Source data
+     * @param out Destination of the processed data, which may be the same as in
+     * @param size Number of bytes to process
+     */
+    void Process(u64 offset, const u8* in, u8* out, std::size_t size);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+/// Returns a description of the AES instructions used on this host, for the log
+const char* GetAccelerationName();
+
+} // namespace HW::AES
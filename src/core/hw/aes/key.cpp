@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <mutex>
 #include <optional>
 #include <sstream>
 #include <cryptopp/aes.h>
@@ -16,6 +17,7 @@
 #include "core/file_sys/archive_ncch.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/hw/aes/arithmetic128.h"
+#include "core/hw/aes/ctr.h"
 #include "core/hw/aes/key.h"
 
 namespace HW::AES {
@@ -51,6 +53,10 @@ AESKey HexToKey(const std::string& hex) {
     return key;
 }
 
+AESKey ScrambleKey(const AESKey& x, const AESKey& y) {
+    return Lrot128(Add128(Xor128(Lrot128(x, 2), y), generator_constant), 87);
+}
+
 struct KeySlot {
     std::optional<AESKey> x;
     std::optional<AESKey> y;
@@ -72,7 +78,7 @@ struct KeySlot {
 
     void GenerateNormalKey() {
         if (x && y) {
-            normal = Lrot128(Add128(Xor128(Lrot128(*x, 2), *y), generator_constant), 87);
+            normal = ScrambleKey(*x, *y);
         } else {
             normal = {};
         }
@@ -440,14 +446,15 @@ void LoadPresetKeys() {
 } // namespace
 
 void InitKeys() {
-    static bool initialized = false;
-    if (initialized)
-        return;
-    LoadBootromKeys();
-    LoadNativeFirmKeysOld3DS();
-    LoadNativeFirmKeysNew3DS();
-    LoadPresetKeys();
-    initialized = true;
+    // Titles are loaded from several threads by the game list
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+        LoadBootromKeys();
+        LoadNativeFirmKeysOld3DS();
+        LoadNativeFirmKeysNew3DS();
+        LoadPresetKeys();
+        LOG_INFO(HW_AES, "Using {} for AES", GetAccelerationName());
+    });
 }
 
 void SetKeyX(std::size_t slot_id, const AESKey& key) {
@@ -470,6 +477,13 @@ AESKey GetNormalKey(std::size_t slot_id) {
     return key_slots.at(slot_id).normal.value_or(AESKey{});
 }
 
+std::optional<AESKey> DeriveNormalKey(std::size_t slot_id, const AESKey& key_y) {
+    const std::optional<AESKey>& x = key_slots.at(slot_id).x;
+    if (!x)
+        return std::nullopt;
+    return ScrambleKey(*x, key_y);
+}
+
 void SelectCommonKeyIndex(u8 index) {
     key_slots[KeySlotID::TicketCommonKey].SetKeyY(common_key_y_slots.at(index));
 }
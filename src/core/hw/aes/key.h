@@ -6,6 +6,7 @@
 
 #include <array>
 #include <cstddef>
+#include <optional>
 #include "common/common_types.h"
 
 namespace HW::AES {
@@ -62,6 +63,12 @@ void SetNormalKey(std::size_t slot_id, const AESKey& key);
 bool IsNormalKeyAvailable(std::size_t slot_id);
 AESKey GetNormalKey(std::size_t slot_id);
 
+/**
+ * Returns the normal key the slot would hold with the given KeyY, without changing the slot. Can
+ * be called from any thread once InitKeys returned. Empty if the slot has no KeyX.
+ */
+std::optional<AESKey> DeriveNormalKey(std::size_t slot_id, const AESKey& key_y);
+
 void SelectCommonKeyIndex(u8 index);
 
 } // namespace HW::AES
@@ -2,7 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <functional>
 #include <numeric>
 #include <type_traits>
 #include "common/alignment.h"
@@ -13,13 +16,20 @@
 #include "common/vector_math.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/dumping/backend.h"
+#include "core/guest_profiler.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
+#include "core/replay_verifier.h"
+#include "core/rewind.h"
+#include "core/rpc/rpc_server.h"
+#include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
@@ -34,6 +44,10 @@ Memory::MemorySystem* g_memory;
 const u64 frame_ticks = static_cast<u64>(BASE_CLOCK_RATE_ARM11 / SCREEN_REFRESH_RATE);
 /// Event id for CoreTiming
 static Core::TimingEventType* vblank_event;
+/// Whether the current frame is skipped, i.e. neither drawn to the screen nor presented
+static bool skip_frame;
+/// Number of frames skipped since the last presented one
+static u32 skipped_frames;
 
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
@@ -49,29 +63,221 @@ inline void Read(T& var, const u32 raw_addr) {
     var = g_regs[addr / 4];
 }
 
-static Common::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
-    switch (input_format) {
-    case Regs::PixelFormat::RGBA8:
-        return Color::DecodeRGBA8(src_pixel);
+namespace {
 
-    case Regs::PixelFormat::RGB8:
-        return Color::DecodeRGB8(src_pixel);
+template <Regs::PixelFormat format>
+constexpr u32 bytes_per_pixel = format == Regs::PixelFormat::RGBA8  ? 4
+                                : format == Regs::PixelFormat::RGB8 ? 3
+                                                                    : 2;
 
-    case Regs::PixelFormat::RGB565:
+template <Regs::PixelFormat format>
+Common::Vec4<u8> DecodePixel(const u8* src_pixel) {
+    if constexpr (format == Regs::PixelFormat::RGBA8) {
+        return Color::DecodeRGBA8(src_pixel);
+    } else if constexpr (format == Regs::PixelFormat::RGB8) {
+        return Color::DecodeRGB8(src_pixel);
+    } else if constexpr (format == Regs::PixelFormat::RGB565) {
         return Color::DecodeRGB565(src_pixel);
-
-    case Regs::PixelFormat::RGB5A1:
+    } else if constexpr (format == Regs::PixelFormat::RGB5A1) {
         return Color::DecodeRGB5A1(src_pixel);
+    } else {
+        return Color::DecodeRGBA4(src_pixel);
+    }
+}
+
+template <Regs::PixelFormat format>
+void EncodePixel(const Common::Vec4<u8>& color, u8* dst_pixel) {
+    if constexpr (format == Regs::PixelFormat::RGBA8) {
+        Color::EncodeRGBA8(color, dst_pixel);
+    } else if constexpr (format == Regs::PixelFormat::RGB8) {
+        Color::EncodeRGB8(color, dst_pixel);
+    } else if constexpr (format == Regs::PixelFormat::RGB565) {
+        Color::EncodeRGB565(color, dst_pixel);
+    } else if constexpr (format == Regs::PixelFormat::RGB5A1) {
+        Color::EncodeRGB5A1(color, dst_pixel);
+    } else {
+        Color::EncodeRGBA4(color, dst_pixel);
+    }
+}
+
+/// Returns the offset of a pixel in an image of the given width, which is either tiled or linear
+template <bool tiled, u32 bytes_per_pixel>
+u32 PixelOffset(u32 x, u32 y, u32 width) {
+    if constexpr (tiled) {
+        return VideoCore::GetMortonOffset(x, y, bytes_per_pixel) +
+               (y & ~7) * width * bytes_per_pixel;
+    } else {
+        return (x + y * width) * bytes_per_pixel;
+    }
+}
+
+/**
+ * Converts the pixels of a display transfer. Every combination of formats, scaling and layouts
+ * gets its own instance, so the loop doesn't branch per pixel. Decoding and encoding a pixel
+ * without scaling is lossless, so copies between the same formats move the raw bytes instead.
+ */
+template <Regs::PixelFormat input_format, Regs::PixelFormat output_format,
+          Regs::DisplayTransferConfig::ScalingMode scaling, bool input_tiled, bool output_tiled>
+void TransferPixels(const u8* src_pointer, u8* dst_pointer, u32 input_width, u32 output_width,
+                    u32 output_height, bool flip_vertically) {
+    constexpr u32 src_bytes_per_pixel = bytes_per_pixel<input_format>;
+    constexpr u32 dst_bytes_per_pixel = bytes_per_pixel<output_format>;
+    constexpr bool raw_copy =
+        input_format == output_format && scaling == Regs::DisplayTransferConfig::NoScale;
+    constexpr u32 horizontal_scale = scaling != Regs::DisplayTransferConfig::NoScale ? 1 : 0;
+    constexpr u32 vertical_scale = scaling == Regs::DisplayTransferConfig::ScaleXY ? 1 : 0;
+
+    for (u32 y = 0; y < output_height; ++y) {
+        const u32 input_y = y << vertical_scale;
+        // Flip the y value of the output data, we do this after calculating the position in the
+        // input image to account for the scaling options.
+        const u32 output_y = flip_vertically ? output_height - y - 1 : y;
+
+        if constexpr (raw_copy && !input_tiled && !output_tiled) {
+            std::memcpy(dst_pointer + output_y * output_width * dst_bytes_per_pixel,
+                        src_pointer + input_y * input_width * src_bytes_per_pixel,
+                        output_width * dst_bytes_per_pixel);
+            continue;
+        }
+
+        for (u32 x = 0; x < output_width; ++x) {
+            const u32 input_x = x << horizontal_scale;
+            const u8* src_pixel = src_pointer + PixelOffset<input_tiled, src_bytes_per_pixel>(
+                                                    input_x, input_y, input_width);
+            u8* dst_pixel = dst_pointer + PixelOffset<output_tiled, dst_bytes_per_pixel>(
+                                              x, output_y, output_width);
+
+            if constexpr (raw_copy) {
+                std::memcpy(dst_pixel, src_pixel, dst_bytes_per_pixel);
+                continue;
+            }
 
+            // Scaling averages the neighbours of the pixel, which follow it in a tiled image
+            Common::Vec4<u8> src_color = DecodePixel<input_format>(src_pixel);
+            if constexpr (scaling == Regs::DisplayTransferConfig::ScaleX) {
+                Common::Vec4<u8> pixel = DecodePixel<input_format>(src_pixel + src_bytes_per_pixel);
+                src_color = ((src_color + pixel) / 2).Cast<u8>();
+            } else if constexpr (scaling == Regs::DisplayTransferConfig::ScaleXY) {
+                Common::Vec4<u8> pixel1 =
+                    DecodePixel<input_format>(src_pixel + 1 * src_bytes_per_pixel);
+                Common::Vec4<u8> pixel2 =
+                    DecodePixel<input_format>(src_pixel + 2 * src_bytes_per_pixel);
+                Common::Vec4<u8> pixel3 =
+                    DecodePixel<input_format>(src_pixel + 3 * src_bytes_per_pixel);
+                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+            }
+            EncodePixel<output_format>(src_color, dst_pixel);
+        }
+    }
+}
+
+using TransferFunction = void (*)(const u8* src_pointer, u8* dst_pointer, u32 input_width,
+                                  u32 output_width, u32 output_height, bool flip_vertically);
+
+template <Regs::PixelFormat input_format, Regs::PixelFormat output_format>
+TransferFunction GetTransferFunction(Regs::DisplayTransferConfig::ScalingMode scaling,
+                                     bool input_tiled, bool output_tiled) {
+    using Config = Regs::DisplayTransferConfig;
+    // Scaling is only implemented on tiled input
+    if (!input_tiled) {
+        return output_tiled ? &TransferPixels<input_format, output_format, Config::NoScale, false,
+                                              true>
+                            : &TransferPixels<input_format, output_format, Config::NoScale, false,
+                                              false>;
+    }
+
+    switch (scaling) {
+    case Config::NoScale:
+        return output_tiled
+                   ? &TransferPixels<input_format, output_format, Config::NoScale, true, true>
+                   : &TransferPixels<input_format, output_format, Config::NoScale, true, false>;
+    case Config::ScaleX:
+        return output_tiled
+                   ? &TransferPixels<input_format, output_format, Config::ScaleX, true, true>
+                   : &TransferPixels<input_format, output_format, Config::ScaleX, true, false>;
+    case Config::ScaleXY:
+        return output_tiled
+                   ? &TransferPixels<input_format, output_format, Config::ScaleXY, true, true>
+                   : &TransferPixels<input_format, output_format, Config::ScaleXY, true, false>;
+    default:
+        return nullptr;
+    }
+}
+
+template <Regs::PixelFormat input_format>
+TransferFunction GetTransferFunction(Regs::PixelFormat output_format,
+                                     Regs::DisplayTransferConfig::ScalingMode scaling,
+                                     bool input_tiled, bool output_tiled) {
+    switch (output_format) {
+    case Regs::PixelFormat::RGBA8:
+        return GetTransferFunction<input_format, Regs::PixelFormat::RGBA8>(scaling, input_tiled,
+                                                                           output_tiled);
+    case Regs::PixelFormat::RGB8:
+        return GetTransferFunction<input_format, Regs::PixelFormat::RGB8>(scaling, input_tiled,
+                                                                          output_tiled);
+    case Regs::PixelFormat::RGB565:
+        return GetTransferFunction<input_format, Regs::PixelFormat::RGB565>(scaling, input_tiled,
+                                                                            output_tiled);
+    case Regs::PixelFormat::RGB5A1:
+        return GetTransferFunction<input_format, Regs::PixelFormat::RGB5A1>(scaling, input_tiled,
+                                                                            output_tiled);
     case Regs::PixelFormat::RGBA4:
-        return Color::DecodeRGBA4(src_pixel);
+        return GetTransferFunction<input_format, Regs::PixelFormat::RGBA4>(scaling, input_tiled,
+                                                                           output_tiled);
+    default:
+        LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
+                  static_cast<u32>(output_format));
+        return nullptr;
+    }
+}
 
+/// Returns the instance of TransferPixels for the configuration, or nullptr if it is invalid
+TransferFunction GetTransferFunction(const Regs::DisplayTransferConfig& config) {
+    const bool input_tiled = !config.input_linear;
+    const bool dont_swizzle = config.dont_swizzle;
+    const bool output_tiled = config.input_linear ? !dont_swizzle : dont_swizzle;
+    const Regs::PixelFormat output_format = config.output_format;
+    const auto scaling = config.scaling.Value();
+
+    switch (config.input_format) {
+    case Regs::PixelFormat::RGBA8:
+        return GetTransferFunction<Regs::PixelFormat::RGBA8>(output_format, scaling, input_tiled,
+                                                             output_tiled);
+    case Regs::PixelFormat::RGB8:
+        return GetTransferFunction<Regs::PixelFormat::RGB8>(output_format, scaling, input_tiled,
+                                                            output_tiled);
+    case Regs::PixelFormat::RGB565:
+        return GetTransferFunction<Regs::PixelFormat::RGB565>(output_format, scaling, input_tiled,
+                                                              output_tiled);
+    case Regs::PixelFormat::RGB5A1:
+        return GetTransferFunction<Regs::PixelFormat::RGB5A1>(output_format, scaling, input_tiled,
+                                                              output_tiled);
+    case Regs::PixelFormat::RGBA4:
+        return GetTransferFunction<Regs::PixelFormat::RGBA4>(output_format, scaling, input_tiled,
+                                                             output_tiled);
     default:
-        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", static_cast<u32>(input_format));
-        return {0, 0, 0, 0};
+        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}",
+                  static_cast<u32>(config.input_format.Value()));
+        return nullptr;
     }
 }
 
+/**
+ * Fills the range with copies of the pattern. The filled part is copied onto the rest of the range
+ * doubling it each time, so that large fills take a few large copies.
+ */
+void FillPattern(u8* start, std::size_t size, const u8* pattern, std::size_t pattern_size) {
+    std::size_t filled = std::min(pattern_size, size);
+    std::memcpy(start, pattern, filled);
+    while (filled < size) {
+        const std::size_t copy_size = std::min(filled, size - filled);
+        std::memcpy(start + filled, start, copy_size);
+        filled += copy_size;
+    }
+}
+
+} // Anonymous namespace
+
 MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
 
@@ -105,26 +311,38 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
     Memory::RasterizerInvalidateRegion(config.GetStartAddress(),
                                        config.GetEndAddress() - config.GetStartAddress());
 
+    // The sizes round up to whole values like the hardware writes them
+    const std::size_t range_size = end - start;
     if (config.fill_24bit) {
         // fill with 24-bit values
-        for (u8* ptr = start; ptr < end; ptr += 3) {
-            ptr[0] = config.value_24bit_r;
-            ptr[1] = config.value_24bit_g;
-            ptr[2] = config.value_24bit_b;
+        const std::array<u8, 3> value{static_cast<u8>(config.value_24bit_r),
+                                      static_cast<u8>(config.value_24bit_g),
+                                      static_cast<u8>(config.value_24bit_b)};
+        const std::size_t size = Common::AlignUp(range_size, 3);
+        if (value[0] == value[1] && value[1] == value[2]) {
+            std::memset(start, value[0], size);
+        } else {
+            FillPattern(start, size, value.data(), value.size());
         }
     } else if (config.fill_32bit) {
         // fill with 32-bit values
-        if (end > start) {
-            u32 value = config.value_32bit;
-            std::size_t len = (end - start) / sizeof(u32);
-            for (std::size_t i = 0; i < len; ++i)
-                memcpy(&start[i * sizeof(u32)], &value, sizeof(u32));
+        const u32 value = config.value_32bit;
+        const std::size_t size = Common::AlignDown(range_size, sizeof(u32));
+        if (value == (value & 0xFF) * 0x01010101) {
+            std::memset(start, static_cast<u8>(value), size);
+        } else {
+            FillPattern(start, size, reinterpret_cast<const u8*>(&value), sizeof(value));
         }
     } else {
         // fill with 16-bit values
-        u16 value_16bit = config.value_16bit.Value();
-        for (u8* ptr = start; ptr < end; ptr += sizeof(u16))
-            memcpy(ptr, &value_16bit, sizeof(u16));
+        const u16 value_16bit = config.value_16bit.Value();
+        const std::size_t size = Common::AlignUp(range_size, sizeof(u16));
+        if (value_16bit >> 8 == (value_16bit & 0xFF)) {
+            std::memset(start, static_cast<u8>(value_16bit), size);
+        } else {
+            FillPattern(start, size, reinterpret_cast<const u8*>(&value_16bit),
+                        sizeof(value_16bit));
+        }
     }
 }
 
@@ -195,113 +413,11 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
-    for (u32 y = 0; y < output_height; ++y) {
-        for (u32 x = 0; x < output_width; ++x) {
-            Common::Vec4<u8> src_color;
-
-            // Calculate the [x,y] position of the input image
-            // based on the current output position and the scale
-            u32 input_x = x << horizontal_scale;
-            u32 input_y = y << vertical_scale;
-
-            u32 output_y;
-            if (config.flip_vertically) {
-                // Flip the y value of the output data,
-                // we do this after calculating the [x,y] position of the input image
-                // to account for the scaling options.
-                output_y = output_height - y - 1;
-            } else {
-                output_y = y;
-            }
-
-            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-            u32 src_offset;
-            u32 dst_offset;
-
-            if (config.input_linear) {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as linear and the output as tiled
-                    u32 coarse_y = output_y & ~7;
-                    u32 stride = output_width * dst_bytes_per_pixel;
-
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 coarse_y * stride;
-                } else {
-                    // Both input and output are linear
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                }
-            } else {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as tiled and the output as linear
-                    u32 coarse_y = input_y & ~7;
-                    u32 stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 coarse_y * stride;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                } else {
-                    // Both input and output are tiled
-                    u32 out_coarse_y = output_y & ~7;
-                    u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                    u32 in_coarse_y = input_y & ~7;
-                    u32 in_stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 in_coarse_y * in_stride;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 out_coarse_y * out_stride;
-                }
-            }
-
-            const u8* src_pixel = src_pointer + src_offset;
-            src_color = DecodePixel(config.input_format, src_pixel);
-            if (config.scaling == config.ScaleX) {
-                Common::Vec4<u8> pixel =
-                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                src_color = ((src_color + pixel) / 2).Cast<u8>();
-            } else if (config.scaling == config.ScaleXY) {
-                Common::Vec4<u8> pixel1 =
-                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel2 =
-                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel3 =
-                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
-            }
-
-            u8* dst_pixel = dst_pointer + dst_offset;
-            switch (config.output_format) {
-            case Regs::PixelFormat::RGBA8:
-                Color::EncodeRGBA8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB8:
-                Color::EncodeRGB8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB565:
-                Color::EncodeRGB565(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB5A1:
-                Color::EncodeRGB5A1(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGBA4:
-                Color::EncodeRGBA4(src_color, dst_pixel);
-                break;
-
-            default:
-                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
-                          static_cast<u32>(config.output_format.Value()));
-                break;
-            }
-        }
-    }
+    const TransferFunction transfer = GetTransferFunction(config);
+    if (transfer == nullptr)
+        return;
+    transfer(src_pointer, dst_pointer, config.input_width, output_width, output_height,
+             config.flip_vertically);
 }
 
 static void TextureCopy(const Regs::DisplayTransferConfig& config) {
@@ -386,6 +502,49 @@ static void TextureCopy(const Regs::DisplayTransferConfig& config) {
     }
 }
 
+/**
+ * Runs GPU work either right away or on the GPU thread, if it is enabled. `on_complete` is always
+ * run on the emulation thread once the work is done.
+ */
+static void ExecuteGPUWork(std::function<void()> work,
+                           std::function<void()> on_complete = nullptr) {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->Execute(std::move(work), std::move(on_complete));
+        return;
+    }
+    work();
+    if (on_complete) {
+        on_complete();
+    }
+}
+
+/// Signals completion of a memory fill to the guest
+static void FinishMemoryFill(const Regs::MemoryFillConfig& config, bool is_second_filler) {
+    // It seems that it won't signal interrupt if "address_start" is zero.
+    // TODO: hwtest this
+    if (config.GetStartAddress() != 0) {
+        if (!is_second_filler) {
+            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
+        } else {
+            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+        }
+    }
+
+    // Set the "finish" flag
+    // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
+    g_regs.memory_fill_config[is_second_filler].finished.Assign(1);
+}
+
+/// Signals an interrupt once all GPU work submitted so far has been processed
+static void SignalInterruptAfterGPUWork(Service::GSP::InterruptId interrupt_id) {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->Execute(
+            [] {}, [interrupt_id] { Service::GSP::SignalInterrupt(interrupt_id); });
+        return;
+    }
+    Service::GSP::SignalInterrupt(interrupt_id);
+}
+
 template <typename T>
 inline void Write(u32 addr, const T data) {
     addr -= HW::VADDR_GPU;
@@ -408,24 +567,17 @@ inline void Write(u32 addr, const T data) {
         auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
             LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
                       config.GetEndAddress());
 
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
-                }
-            }
-
-            // Reset "trigger" flag and set the "finish" flag
-            // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
+            // Reset "trigger" flag right away, the "finish" flag is set once the fill is done
+            const Regs::MemoryFillConfig fill_config = config;
             config.trigger.Assign(0);
-            config.finished.Assign(1);
+
+            ExecuteGPUWork([fill_config] { MemoryFill(fill_config); },
+                           [fill_config, is_second_filler] {
+                               FinishMemoryFill(fill_config, is_second_filler);
+                           });
         }
         break;
     }
@@ -440,8 +592,9 @@ inline void Write(u32 addr, const T data) {
                 Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
                                                nullptr);
 
+            const Regs::DisplayTransferConfig transfer_config = config;
             if (config.is_texture_copy) {
-                TextureCopy(config);
+                ExecuteGPUWork([transfer_config] { TextureCopy(transfer_config); });
                 LOG_TRACE(HW_GPU,
                           "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
                           "{:#010X}({}+{}), flags {:#010X}",
@@ -450,7 +603,7 @@ inline void Write(u32 addr, const T data) {
                           config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
                           config.texture_copy.output_gap * 16, config.flags);
             } else {
-                DisplayTransfer(config);
+                ExecuteGPUWork([transfer_config] { DisplayTransfer(transfer_config); });
                 LOG_TRACE(HW_GPU,
                           "DisplayTransfer: {:#010X}({}x{})-> "
                           "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
@@ -461,7 +614,7 @@ inline void Write(u32 addr, const T data) {
             }
 
             g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+            SignalInterruptAfterGPUWork(Service::GSP::InterruptId::PPF);
         }
         break;
     }
@@ -479,7 +632,15 @@ inline void Write(u32 addr, const T data) {
                                                                 config.GetPhysicalAddress());
             }
 
-            Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            if (VideoCore::g_gpu_thread) {
+                VideoCore::g_gpu_thread->SubmitList(buffer, config.size);
+                // The memory the list reads has to be recorded before the write triggering it
+                if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
+                    VideoCore::g_gpu_thread->WaitIdle();
+                }
+            } else {
+                Pica::CommandProcessor::ProcessCommandList(buffer, config.size);
+            }
 
             g_regs.command_processor_config.trigger = 0;
         }
@@ -511,9 +672,59 @@ template void Write<u32>(u32 addr, const u32 data);
 template void Write<u16>(u32 addr, const u16 data);
 template void Write<u8>(u32 addr, const u8 data);
 
+static bool ShouldSkipNextFrame(Core::System& system) {
+    // Dumping and screenshots need every frame
+    if (system.VideoDumper().IsDumping() || VideoCore::g_renderer_screenshot_requested)
+        return false;
+
+    if (Settings::values.turbo_mode)
+        return skipped_frames + 1 < Settings::values.turbo_render_interval;
+
+    // Adaptive frame skip, which drops frames while the emulation can't keep up
+    return skipped_frames < Settings::values.frame_skip && system.frame_limiter.IsBehind();
+}
+
 /// Update hardware
 static void VBlankCallback(u64 userdata, s64 cycles_late) {
-    VideoCore::g_renderer->SwapBuffers();
+    auto& system = Core::System::GetInstance();
+
+    // Skipping the swap skips copying the framebuffers out of emulated memory and presenting
+    // them, the draws to them were already dropped by the rasterizer
+    if (!skip_frame) {
+        if (VideoCore::g_gpu_thread) {
+            VideoCore::g_gpu_thread->SwapBuffers();
+        } else {
+            VideoCore::g_renderer->SwapBuffers();
+        }
+    }
+
+    system.perf_stats->EndSystemFrame();
+    if (system.metrics_exporter) {
+        system.metrics_exporter->EndFrame();
+    }
+    if (system.replay_verifier) {
+        system.replay_verifier->EndFrame();
+    }
+    system.RPCServer().OnFrame();
+    VideoCore::g_renderer->GetRenderWindow().PollEvents();
+    system.frame_limiter.DoFrameLimiting(system.CoreTiming().GetGlobalTimeUs());
+    system.Rewind().OnFrame();
+    system.GuestProfiler().OnFrame();
+
+    const bool skip_next_frame = ShouldSkipNextFrame(system);
+    skipped_frames = skip_next_frame ? skipped_frames + 1 : 0;
+    if (skip_next_frame != skip_frame) {
+        skip_frame = skip_next_frame;
+        const auto set_skip_frame = [skip_next_frame] {
+            VideoCore::g_renderer->Rasterizer()->SetSkipFrame(skip_next_frame);
+        };
+        if (VideoCore::g_gpu_thread) {
+            VideoCore::g_gpu_thread->Execute(set_skip_frame);
+        } else {
+            set_skip_frame();
+        }
+    }
+    system.perf_stats->BeginSystemFrame();
 
     // Signal to GSP that GPU interrupt has occurred
     // TODO(yuriks): hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
@@ -524,13 +735,15 @@ static void VBlankCallback(u64 userdata, s64 cycles_late) {
     Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PDC1);
 
     // Reschedule recurrent event
-    Core::System::GetInstance().CoreTiming().ScheduleEvent(frame_ticks - cycles_late, vblank_event);
+    system.CoreTiming().ScheduleEvent(frame_ticks - cycles_late, vblank_event);
 }
 
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory) {
     g_memory = &memory;
     memset(&g_regs, 0, sizeof(g_regs));
+    skip_frame = false;
+    skipped_frames = 0;
 
     auto& framebuffer_top = g_regs.framebuffer_config[0];
     auto& framebuffer_sub = g_regs.framebuffer_config[1];
@@ -565,6 +778,13 @@ void Init(Memory::MemorySystem& memory) {
     LOG_DEBUG(HW_GPU, "initialized OK");
 }
 
+/// Update hardware
+void Update() {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->ProcessCompletions();
+    }
+}
+
 /// Shutdown hardware
 void Shutdown() {
     LOG_DEBUG(HW_GPU, "shutdown OK");
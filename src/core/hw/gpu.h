@@ -301,6 +301,9 @@ void Write(u32 addr, const T data);
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory);
 
+/// Delivers the completion of work finished by the GPU thread, e.g. interrupts
+void Update();
+
 /// Shutdown hardware
 void Shutdown();
 
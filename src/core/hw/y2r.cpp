@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include "common/assert.h"
 #include "common/color.h"
@@ -13,6 +14,7 @@
 #include "core/core.h"
 #include "core/hle/service/y2r_u.h"
 #include "core/hw/y2r.h"
+#include "core/hw/y2r_kernels.h"
 #include "core/memory.h"
 
 namespace HW::Y2R {
@@ -23,55 +25,59 @@ static const std::size_t MAX_TILES = 1024 / 8;
 static const std::size_t TILE_SIZE = 8 * 8;
 using ImageTile = std::array<u32, TILE_SIZE>;
 
-/// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
+/// Gathers the components of one line of a strip into separate planes, one entry per pixel.
+static void GatherLine(InputFormat input_format, const u8* input_Y, const u8* input_U,
+                       const u8* input_V, unsigned int width, unsigned int y, s16* out_Y,
+                       s16* out_U, s16* out_V) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        for (unsigned int x = 0; x < width; ++x) {
+            out_Y[x] = input_Y[y * width + x];
+            out_U[x] = input_U[(y * width + x) / 2];
+            out_V[x] = input_V[(y * width + x) / 2];
+        }
+        break;
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV420_Indiv16:
+        for (unsigned int x = 0; x < width; ++x) {
+            out_Y[x] = input_Y[y * width + x];
+            out_U[x] = input_U[((y / 2) * width + x) / 2];
+            out_V[x] = input_V[((y / 2) * width + x) / 2];
+        }
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        for (unsigned int x = 0; x < width; ++x) {
+            out_Y[x] = input_Y[(y * width + x) * 2];
+            out_U[x] = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
+            out_V[x] = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
+        }
+        break;
+    }
+}
+
+/// Converts a image strip from the source YUV format into linear RGB32 lines.
 static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
-                            const u8* input_V, ImageTile output[], unsigned int width,
+                            const u8* input_V, u32* output, unsigned int width,
                             unsigned int height, const CoefficientSet& coefficients) {
+    std::array<s16, MAX_TILES * 8> line_Y;
+    std::array<s16, MAX_TILES * 8> line_U;
+    std::array<s16, MAX_TILES * 8> line_V;
 
     for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
-            s32 Y = 0;
-            s32 U = 0;
-            s32 V = 0;
-            switch (input_format) {
-            case InputFormat::YUV422_Indiv8:
-            case InputFormat::YUV422_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[(y * width + x) / 2];
-                V = input_V[(y * width + x) / 2];
-                break;
-            case InputFormat::YUV420_Indiv8:
-            case InputFormat::YUV420_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[((y / 2) * width + x) / 2];
-                V = input_V[((y / 2) * width + x) / 2];
-                break;
-            case InputFormat::YUYV422_Interleaved:
-                Y = input_Y[(y * width + x) * 2];
-                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
-                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
-                break;
-            }
+        GatherLine(input_format, input_Y, input_U, input_V, width, y, line_Y.data(),
+                   line_U.data(), line_V.data());
+        ConvertYUVToRGB32(line_Y.data(), line_U.data(), line_V.data(), output + y * width, width,
+                          coefficients);
+    }
+}
 
-            // This conversion process is bit-exact with hardware, as far as could be tested.
-            auto& c = coefficients;
-            s32 cY = c[0] * Y;
-
-            s32 r = cY + c[1] * V;
-            s32 g = cY - c[2] * V - c[3] * U;
-            s32 b = cY + c[4] * U;
-
-            const s32 rounding_offset = 0x18;
-            r = (r >> 3) + c[5] + rounding_offset;
-            g = (g >> 3) + c[6] + rounding_offset;
-            b = (b >> 3) + c[7] + rounding_offset;
-
-            unsigned int tile = x / 8;
-            unsigned int tile_x = x % 8;
-            u32* out = &output[tile][y * 8 + tile_x];
-            *out = ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) |
-                   ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
-                   ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
+/// Splits the lines of a converted strip into its 8x8 tiles.
+static void SplitIntoTiles(const u32* input, ImageTile output[], unsigned int width,
+                           unsigned int height) {
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int tile = 0; tile < width / 8; ++tile) {
+            std::copy_n(input + y * width + tile * 8, 8, &output[tile][y * 8]);
         }
     }
 }
@@ -87,8 +93,12 @@ static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuff
     ASSERT(amount_of_data % output_unit == 0);
 
     while (amount_of_data > 0) {
-        for (std::size_t i = 0; i < output_unit; ++i) {
-            output[i] = input[i * N];
+        if constexpr (N == 1) {
+            std::memcpy(output, input, output_unit);
+        } else {
+            for (std::size_t i = 0; i < output_unit; ++i) {
+                output[i] = input[i * N];
+            }
         }
 
         output += output_unit;
@@ -107,6 +117,29 @@ static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionB
 
     u8* output = memory.GetPointer(buf.address);
 
+    std::size_t bytes_per_pixel = 2;
+    if (output_format == OutputFormat::RGBA8) {
+        bytes_per_pixel = 4;
+    } else if (output_format == OutputFormat::RGB8) {
+        bytes_per_pixel = 3;
+    }
+
+    // Encode whole transfer units at once when they hold whole pixels and the strip fills them
+    // evenly, which is the case for any sensible configuration
+    const std::size_t data_size = static_cast<std::size_t>(amount_of_data) * bytes_per_pixel;
+    if (buf.transfer_unit != 0 && buf.transfer_unit % bytes_per_pixel == 0 &&
+        data_size % buf.transfer_unit == 0) {
+        const std::size_t unit_pixels = buf.transfer_unit / bytes_per_pixel;
+        for (std::size_t i = 0; i < data_size / buf.transfer_unit; ++i) {
+            EncodeRGB32(input, output, unit_pixels, output_format, alpha);
+            input += unit_pixels;
+            output += buf.transfer_unit + buf.gap;
+            buf.address += buf.transfer_unit + buf.gap;
+            buf.image_size -= buf.transfer_unit;
+        }
+        return;
+    }
+
     while (amount_of_data > 0) {
         u8* unit_end = output + buf.transfer_unit;
         while (output < unit_end) {
@@ -269,6 +302,8 @@ void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cv
 
     // Buffer used as a CDMA source/target.
     std::unique_ptr<u8[]> data_buffer(new u8[cvt.input_line_width * 8 * 4]);
+    // The converted lines of the current strip, RGB32.
+    std::unique_ptr<u32[]> rgb_buffer(new u32[cvt.input_line_width * 8]);
     // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
     std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
     ImageTile tmp_tile;
@@ -323,11 +358,18 @@ void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cv
             break;
         }
 
-        // Note(yuriks): If additional optimization is required, input_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.get(),
+        ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, rgb_buffer.get(),
                         cvt.input_line_width, row_height, cvt.coefficients);
 
+        // Linear output without rotation is the converted strip itself
+        if (cvt.rotation == Rotation::None && cvt.block_alignment == BlockAlignment::Linear) {
+            SendData(memory, rgb_buffer.get(), cvt.dst, (int)row_data_size, cvt.output_format,
+                     (u8)cvt.alpha);
+            continue;
+        }
+
+        SplitIntoTiles(rgb_buffer.get(), tiles.get(), cvt.input_line_width, row_height);
+
         u32* output_buffer = reinterpret_cast<u32*>(data_buffer.get());
 
         for (std::size_t i = 0; i < num_tiles; ++i) {
@@ -371,8 +413,6 @@ void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration& cv
             }
         }
 
-        // Note(yuriks): If additional optimization is required, output_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
         SendData(memory, reinterpret_cast<u32*>(data_buffer.get()), cvt.dst, (int)row_data_size,
                  cvt.output_format, (u8)cvt.alpha);
     }
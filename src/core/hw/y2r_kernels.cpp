@@ -0,0 +1,336 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/color.h"
+#include "common/vector_math.h"
+#include "core/hw/y2r_kernels.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace HW::Y2R {
+
+using Service::Y2R::CoefficientSet;
+using Service::Y2R::OutputFormat;
+
+// Added to the colour channels before the final shift
+constexpr s32 ROUNDING_OFFSET = 0x18;
+
+// The vector kernels perform the same integer operations as the scalar ones, the products and
+// sums of the colour matrix fit in 32 bits for any coefficients. They convert eight pixels per
+// iteration and store the intermediate format in host byte order like the scalar code.
+
+namespace Y2RKernelsDetail {
+
+void ConvertYUVToRGB32Scalar(const s16* y, const s16* u, const s16* v, u32* out,
+                             std::size_t count, const CoefficientSet& coefficients) {
+    const auto& c = coefficients;
+    for (std::size_t i = 0; i < count; ++i) {
+        const s32 Y = y[i];
+        const s32 U = u[i];
+        const s32 V = v[i];
+
+        // This conversion process is bit-exact with hardware, as far as could be tested.
+        const s32 cY = c[0] * Y;
+
+        s32 r = cY + c[1] * V;
+        s32 g = cY - c[2] * V - c[3] * U;
+        s32 b = cY + c[4] * U;
+
+        r = (r >> 3) + c[5] + ROUNDING_OFFSET;
+        g = (g >> 3) + c[6] + ROUNDING_OFFSET;
+        b = (b >> 3) + c[7] + ROUNDING_OFFSET;
+
+        out[i] = (static_cast<u32>(std::clamp(r >> 5, 0, 0xFF)) << 24) |
+                 (static_cast<u32>(std::clamp(g >> 5, 0, 0xFF)) << 16) |
+                 (static_cast<u32>(std::clamp(b >> 5, 0, 0xFF)) << 8);
+    }
+}
+
+void EncodeRGB32Scalar(const u32* in, u8* out, std::size_t count, OutputFormat format,
+                       u8 alpha) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const u32 color = in[i];
+        const Common::Vec4<u8> col_vec{static_cast<u8>(color >> 24), static_cast<u8>(color >> 16),
+                                       static_cast<u8>(color >> 8), alpha};
+
+        switch (format) {
+        case OutputFormat::RGBA8:
+            Color::EncodeRGBA8(col_vec, out);
+            out += 4;
+            break;
+        case OutputFormat::RGB8:
+            Color::EncodeRGB8(col_vec, out);
+            out += 3;
+            break;
+        case OutputFormat::RGB5A1:
+            Color::EncodeRGB5A1(col_vec, out);
+            out += 2;
+            break;
+        case OutputFormat::RGB565:
+            Color::EncodeRGB565(col_vec, out);
+            out += 2;
+            break;
+        }
+    }
+}
+
+} // namespace Y2RKernelsDetail
+
+namespace {
+
+/// Returns true if the negated coefficients the vector kernels multiply with fit in 16 bits
+bool CanNegateCoefficients(const CoefficientSet& c) {
+    return c[2] != -0x8000 && c[3] != -0x8000;
+}
+
+} // Anonymous namespace
+
+#if defined(ARCHITECTURE_x86_64)
+
+void ConvertYUVToRGB32(const s16* y, const s16* u, const s16* v, u32* out, std::size_t count,
+                       const CoefficientSet& coefficients) {
+    const auto& c = coefficients;
+    if (!CanNegateCoefficients(c)) {
+        Y2RKernelsDetail::ConvertYUVToRGB32Scalar(y, u, v, out, count, coefficients);
+        return;
+    }
+
+    // _mm_madd_epi16 multiplies pairs of 16 bit lanes and adds each pair into a 32 bit lane
+    const auto pair = [](s16 low, s16 high) {
+        return _mm_set1_epi32(static_cast<s32>((static_cast<u32>(static_cast<u16>(high)) << 16) |
+                                               static_cast<u16>(low)));
+    };
+    const __m128i coeff_r = pair(c[0], c[1]);
+    const __m128i coeff_g = pair(c[0], static_cast<s16>(-c[2]));
+    const __m128i coeff_gu = pair(static_cast<s16>(-c[3]), 0);
+    const __m128i coeff_b = pair(c[0], c[4]);
+    const __m128i offset_r = _mm_set1_epi32(c[5] + ROUNDING_OFFSET);
+    const __m128i offset_g = _mm_set1_epi32(c[6] + ROUNDING_OFFSET);
+    const __m128i offset_b = _mm_set1_epi32(c[7] + ROUNDING_OFFSET);
+    const __m128i zero = _mm_setzero_si128();
+
+    const auto finish = [](__m128i low, __m128i high, __m128i offset) {
+        low = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(low, 3), offset), 5);
+        high = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(high, 3), offset), 5);
+        // The saturating packs clamp to [0, 255]
+        const __m128i packed = _mm_packs_epi32(low, high);
+        return _mm_packus_epi16(packed, packed);
+    };
+
+    for (std::size_t i = 0; i < count; i += 8) {
+        const __m128i Y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+        const __m128i U = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + i));
+        const __m128i V = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+
+        const __m128i yv_low = _mm_unpacklo_epi16(Y, V);
+        const __m128i yv_high = _mm_unpackhi_epi16(Y, V);
+        const __m128i yu_low = _mm_unpacklo_epi16(Y, U);
+        const __m128i yu_high = _mm_unpackhi_epi16(Y, U);
+        const __m128i u_low = _mm_unpacklo_epi16(U, zero);
+        const __m128i u_high = _mm_unpackhi_epi16(U, zero);
+
+        const __m128i r = finish(_mm_madd_epi16(yv_low, coeff_r), _mm_madd_epi16(yv_high, coeff_r),
+                                 offset_r);
+        const __m128i g = finish(
+            _mm_add_epi32(_mm_madd_epi16(yv_low, coeff_g), _mm_madd_epi16(u_low, coeff_gu)),
+            _mm_add_epi32(_mm_madd_epi16(yv_high, coeff_g), _mm_madd_epi16(u_high, coeff_gu)),
+            offset_g);
+        const __m128i b = finish(_mm_madd_epi16(yu_low, coeff_b), _mm_madd_epi16(yu_high, coeff_b),
+                                 offset_b);
+
+        // b << 8 in the low and r << 8 | g in the high half of each pixel
+        const __m128i low_halves = _mm_unpacklo_epi8(zero, b);
+        const __m128i high_halves = _mm_unpacklo_epi8(g, r);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_unpacklo_epi16(low_halves, high_halves));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4),
+                         _mm_unpackhi_epi16(low_halves, high_halves));
+    }
+}
+
+void EncodeRGB32(const u32* in, u8* out, std::size_t count, OutputFormat format, u8 alpha) {
+    const std::size_t vector_count = count & ~std::size_t{7};
+    const auto load = [in](std::size_t i) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    };
+    // Packs the low 16 bits of each lane, sign extending first so the signed pack doesn't saturate
+    const auto pack16 = [](__m128i low, __m128i high) {
+        return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(low, 16), 16),
+                               _mm_srai_epi32(_mm_slli_epi32(high, 16), 16));
+    };
+
+    switch (format) {
+    case OutputFormat::RGBA8: {
+        const __m128i alpha_vec = _mm_set1_epi32(alpha);
+        for (std::size_t i = 0; i < vector_count; i += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4),
+                             _mm_or_si128(load(i), alpha_vec));
+        }
+        break;
+    }
+    case OutputFormat::RGB565: {
+        const auto encode = [](__m128i color) {
+            return _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(_mm_srli_epi32(color, 16), _mm_set1_epi32(0xF800)),
+                             _mm_and_si128(_mm_srli_epi32(color, 13), _mm_set1_epi32(0x07E0))),
+                _mm_and_si128(_mm_srli_epi32(color, 11), _mm_set1_epi32(0x001F)));
+        };
+        for (std::size_t i = 0; i < vector_count; i += 8) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2),
+                             pack16(encode(load(i)), encode(load(i + 4))));
+        }
+        break;
+    }
+    case OutputFormat::RGB5A1: {
+        const __m128i alpha_bit = _mm_set1_epi32(Color::Convert8To1(alpha));
+        const auto encode = [alpha_bit](__m128i color) {
+            return _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(_mm_srli_epi32(color, 16), _mm_set1_epi32(0xF800)),
+                             _mm_and_si128(_mm_srli_epi32(color, 13), _mm_set1_epi32(0x07C0))),
+                _mm_or_si128(_mm_and_si128(_mm_srli_epi32(color, 10), _mm_set1_epi32(0x003E)),
+                             alpha_bit));
+        };
+        for (std::size_t i = 0; i < vector_count; i += 8) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2),
+                             pack16(encode(load(i)), encode(load(i + 4))));
+        }
+        break;
+    }
+    case OutputFormat::RGB8:
+        // Three byte pixels need byte shuffles that SSE2 doesn't have
+        Y2RKernelsDetail::EncodeRGB32Scalar(in, out, count, format, alpha);
+        return;
+    }
+
+    const std::size_t bytes_per_pixel = format == OutputFormat::RGBA8 ? 4 : 2;
+    Y2RKernelsDetail::EncodeRGB32Scalar(in + vector_count, out + vector_count * bytes_per_pixel,
+                                        count - vector_count, format, alpha);
+}
+
+#elif defined(ARCHITECTURE_ARM64)
+
+void ConvertYUVToRGB32(const s16* y, const s16* u, const s16* v, u32* out, std::size_t count,
+                       const CoefficientSet& coefficients) {
+    const auto& c = coefficients;
+    const int32x4_t offset_r = vdupq_n_s32(c[5] + ROUNDING_OFFSET);
+    const int32x4_t offset_g = vdupq_n_s32(c[6] + ROUNDING_OFFSET);
+    const int32x4_t offset_b = vdupq_n_s32(c[7] + ROUNDING_OFFSET);
+
+    const auto finish = [](int32x4_t low, int32x4_t high, int32x4_t offset) {
+        low = vshrq_n_s32(vaddq_s32(vshrq_n_s32(low, 3), offset), 5);
+        high = vshrq_n_s32(vaddq_s32(vshrq_n_s32(high, 3), offset), 5);
+        // The saturating narrows clamp to [0, 255]
+        return vqmovun_s16(vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    };
+
+    for (std::size_t i = 0; i < count; i += 8) {
+        const int16x8_t Y = vld1q_s16(y + i);
+        const int16x8_t U = vld1q_s16(u + i);
+        const int16x8_t V = vld1q_s16(v + i);
+
+        const int32x4_t cy_low = vmull_n_s16(vget_low_s16(Y), c[0]);
+        const int32x4_t cy_high = vmull_n_s16(vget_high_s16(Y), c[0]);
+
+        const int32x4_t r_low = vmlal_n_s16(cy_low, vget_low_s16(V), c[1]);
+        const int32x4_t r_high = vmlal_n_s16(cy_high, vget_high_s16(V), c[1]);
+        const int32x4_t g_low =
+            vmlsl_n_s16(vmlsl_n_s16(cy_low, vget_low_s16(V), c[2]), vget_low_s16(U), c[3]);
+        const int32x4_t g_high =
+            vmlsl_n_s16(vmlsl_n_s16(cy_high, vget_high_s16(V), c[2]), vget_high_s16(U), c[3]);
+        const int32x4_t b_low = vmlal_n_s16(cy_low, vget_low_s16(U), c[4]);
+        const int32x4_t b_high = vmlal_n_s16(cy_high, vget_high_s16(U), c[4]);
+
+        // Interleaving 0, b, g, r gives r << 24 | g << 16 | b << 8 on little endian hosts
+        uint8x8x4_t pixels;
+        pixels.val[0] = vdup_n_u8(0);
+        pixels.val[1] = finish(b_low, b_high, offset_b);
+        pixels.val[2] = finish(g_low, g_high, offset_g);
+        pixels.val[3] = finish(r_low, r_high, offset_r);
+        vst4_u8(reinterpret_cast<u8*>(out + i), pixels);
+    }
+}
+
+void EncodeRGB32(const u32* in, u8* out, std::size_t count, OutputFormat format, u8 alpha) {
+    const std::size_t vector_count = count & ~std::size_t{7};
+
+    switch (format) {
+    case OutputFormat::RGBA8: {
+        const uint32x4_t alpha_vec = vdupq_n_u32(alpha);
+        for (std::size_t i = 0; i < vector_count; i += 4) {
+            vst1q_u32(reinterpret_cast<u32*>(out + i * 4), vorrq_u32(vld1q_u32(in + i), alpha_vec));
+        }
+        break;
+    }
+    case OutputFormat::RGB565: {
+        const auto encode = [](uint32x4_t color) {
+            return vmovn_u32(
+                vorrq_u32(vorrq_u32(vandq_u32(vshrq_n_u32(color, 16), vdupq_n_u32(0xF800)),
+                                    vandq_u32(vshrq_n_u32(color, 13), vdupq_n_u32(0x07E0))),
+                          vandq_u32(vshrq_n_u32(color, 11), vdupq_n_u32(0x001F))));
+        };
+        for (std::size_t i = 0; i < vector_count; i += 8) {
+            vst1q_u16(reinterpret_cast<u16*>(out + i * 2),
+                      vcombine_u16(encode(vld1q_u32(in + i)), encode(vld1q_u32(in + i + 4))));
+        }
+        break;
+    }
+    case OutputFormat::RGB5A1: {
+        const uint32x4_t alpha_bit = vdupq_n_u32(Color::Convert8To1(alpha));
+        const auto encode = [alpha_bit](uint32x4_t color) {
+            return vmovn_u32(
+                vorrq_u32(vorrq_u32(vandq_u32(vshrq_n_u32(color, 16), vdupq_n_u32(0xF800)),
+                                    vandq_u32(vshrq_n_u32(color, 13), vdupq_n_u32(0x07C0))),
+                          vorrq_u32(vandq_u32(vshrq_n_u32(color, 10), vdupq_n_u32(0x003E)),
+                                    alpha_bit)));
+        };
+        for (std::size_t i = 0; i < vector_count; i += 8) {
+            vst1q_u16(reinterpret_cast<u16*>(out + i * 2),
+                      vcombine_u16(encode(vld1q_u32(in + i)), encode(vld1q_u32(in + i + 4))));
+        }
+        break;
+    }
+    case OutputFormat::RGB8: {
+        // Deinterleaving drops the unused low byte of every pixel
+        for (std::size_t i = 0; i < vector_count; i += 8) {
+            const uint8x8x4_t pixels = vld4_u8(reinterpret_cast<const u8*>(in + i));
+            uint8x8x3_t rgb;
+            rgb.val[0] = pixels.val[1];
+            rgb.val[1] = pixels.val[2];
+            rgb.val[2] = pixels.val[3];
+            vst3_u8(out + i * 3, rgb);
+        }
+        break;
+    }
+    }
+
+    std::size_t bytes_per_pixel = 2;
+    if (format == OutputFormat::RGBA8) {
+        bytes_per_pixel = 4;
+    } else if (format == OutputFormat::RGB8) {
+        bytes_per_pixel = 3;
+    }
+    Y2RKernelsDetail::EncodeRGB32Scalar(in + vector_count, out + vector_count * bytes_per_pixel,
+                                        count - vector_count, format, alpha);
+}
+
+#else
+
+void ConvertYUVToRGB32(const s16* y, const s16* u, const s16* v, u32* out, std::size_t count,
+                       const CoefficientSet& coefficients) {
+    Y2RKernelsDetail::ConvertYUVToRGB32Scalar(y, u, v, out, count, coefficients);
+}
+
+void EncodeRGB32(const u32* in, u8* out, std::size_t count, OutputFormat format, u8 alpha) {
+    Y2RKernelsDetail::EncodeRGB32Scalar(in, out, count, format, alpha);
+}
+
+#endif
+
+} // namespace HW::Y2R
@@ -0,0 +1,36 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+#include "core/hle/service/y2r_u.h"
+
+namespace HW::Y2R {
+
+/**
+ * Converts pixels from YUV to the intermediate RGB32 format of the Y2R unit, which holds the
+ * colour as r << 24 | g << 16 | b << 8, using its fixed point colour matrix.
+ * @param y, u, v Components of each pixel, in the range [0, 255]
+ * @param count   Number of pixels, a multiple of 8
+ */
+void ConvertYUVToRGB32(const s16* y, const s16* u, const s16* v, u32* out, std::size_t count,
+                       const Service::Y2R::CoefficientSet& coefficients);
+
+/// Encodes pixels from the intermediate RGB32 format to the output format with the given alpha
+void EncodeRGB32(const u32* in, u8* out, std::size_t count, Service::Y2R::OutputFormat format,
+                 u8 alpha);
+
+namespace Y2RKernelsDetail {
+
+/// Scalar reference implementations of the kernels, used where no vector kernel is available
+void ConvertYUVToRGB32Scalar(const s16* y, const s16* u, const s16* v, u32* out,
+                             std::size_t count, const Service::Y2R::CoefficientSet& coefficients);
+void EncodeRGB32Scalar(const u32* in, u8* out, std::size_t count,
+                       Service::Y2R::OutputFormat format, u8 alpha);
+
+} // namespace Y2RKernelsDetail
+
+} // namespace HW::Y2R
@@ -0,0 +1,85 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <utility>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/init_tasks.h"
+
+namespace Core {
+
+namespace {
+void RunTimed(const std::string& name, const std::function<void()>& task) {
+    const auto start = std::chrono::steady_clock::now();
+    task();
+    const auto duration = std::chrono::steady_clock::now() - start;
+    LOG_INFO(Core, "Initialized {} in {} ms", name,
+             std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+}
+} // Anonymous namespace
+
+InitTasks::InitTasks() : start_time(std::chrono::steady_clock::now()) {}
+
+InitTasks::~InitTasks() {
+    // Tasks still running refer to the system, so they have to finish even if a step failed
+    for (auto& [name, task] : tasks) {
+        task.wait();
+    }
+}
+
+void InitTasks::Run(const std::string& name, std::function<void()> task,
+                    const std::vector<std::string>& dependencies) {
+    for (const std::string& dependency : dependencies) {
+        Wait(dependency);
+    }
+
+    std::promise<void> done;
+    RunTimed(name, task);
+    done.set_value();
+    tasks.emplace(name, done.get_future().share());
+}
+
+void InitTasks::RunAsync(const std::string& name, std::function<void()> task,
+                         const std::vector<std::string>& dependencies) {
+    ASSERT_MSG(tasks.count(name) == 0, "Init task {} added twice", name);
+    std::vector<std::shared_future<void>> futures = GetFutures(dependencies);
+    tasks.emplace(name, std::async(std::launch::async,
+                                   [name, task = std::move(task), futures = std::move(futures)] {
+                                       for (const auto& future : futures) {
+                                           future.get();
+                                       }
+                                       RunTimed(name, task);
+                                   })
+                            .share());
+}
+
+void InitTasks::Wait(const std::string& name) {
+    const auto it = tasks.find(name);
+    ASSERT_MSG(it != tasks.end(), "Unknown init task {}", name);
+    it->second.get();
+}
+
+void InitTasks::WaitAll() {
+    for (auto& [name, task] : tasks) {
+        task.get();
+    }
+    const auto duration = std::chrono::steady_clock::now() - start_time;
+    LOG_INFO(Core, "System initialized in {} ms",
+             std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+}
+
+std::vector<std::shared_future<void>> InitTasks::GetFutures(
+    const std::vector<std::string>& names) const {
+    std::vector<std::shared_future<void>> futures;
+    futures.reserve(names.size());
+    for (const std::string& name : names) {
+        const auto it = tasks.find(name);
+        ASSERT_MSG(it != tasks.end(), "Unknown init task {}", name);
+        futures.push_back(it->second);
+    }
+    return futures;
+}
+
+} // namespace Core
@@ -0,0 +1,53 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Runs the steps of the system initialization, each of them named so that later steps can depend
+ * on it. Independent steps doing disk or device I/O run on their own thread, while the steps that
+ * touch the kernel or core timing stay on the calling thread. The time every step took is logged.
+ *
+ * The tasks must only be added and waited for from the thread that owns the instance.
+ */
+class InitTasks : NonCopyable {
+public:
+    InitTasks();
+    ~InitTasks();
+
+    /**
+     * Runs the task on the calling thread, after the given tasks finished.
+     * Their exceptions are rethrown.
+     */
+    void Run(const std::string& name, std::function<void()> task,
+             const std::vector<std::string>& dependencies = {});
+
+    /// Starts the task on a new thread, which waits for the given tasks to finish first
+    void RunAsync(const std::string& name, std::function<void()> task,
+                  const std::vector<std::string>& dependencies = {});
+
+    /// Waits for the task to finish, rethrowing its exception if it threw
+    void Wait(const std::string& name);
+
+    /// Waits for all tasks and logs the total time of the initialization
+    void WaitAll();
+
+private:
+    std::vector<std::shared_future<void>> GetFutures(const std::vector<std::string>& names) const;
+
+    std::unordered_map<std::string, std::shared_future<void>> tasks;
+    std::chrono::steady_clock::time_point start_time;
+};
+
+} // namespace Core
@@ -0,0 +1,68 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/invalidation_batch.h"
+#include "core/memory.h"
+
+namespace Core {
+
+thread_local InvalidationBatch* InvalidationBatch::active = nullptr;
+
+InvalidationBatch::InvalidationBatch(System& system) : system(system) {
+    if (active == nullptr) {
+        active = this;
+    }
+}
+
+InvalidationBatch::~InvalidationBatch() {
+    Commit();
+}
+
+void InvalidationBatch::Add(VAddr address, std::size_t size) {
+    if (size == 0)
+        return;
+
+    const VAddr end = address + static_cast<VAddr>(size);
+    // Writes mostly target ascending addresses, the gaps between them are invalidated too since
+    // tracking every word separately costs more than translating a few extra blocks
+    if (!ranges.empty()) {
+        auto& [range_begin, range_end] = ranges.back();
+        if (address >= range_begin && address <= range_end + Memory::PAGE_SIZE) {
+            range_end = std::max(range_end, end);
+            return;
+        }
+    }
+    ranges.emplace_back(address, end);
+}
+
+void InvalidationBatch::Commit() {
+    if (active != this)
+        return;
+    active = nullptr;
+    if (ranges.empty())
+        return;
+
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<VAddr, VAddr>> merged{ranges.front()};
+    for (const auto& [range_begin, range_end] : ranges) {
+        if (range_begin > merged.back().second + Memory::PAGE_SIZE) {
+            merged.emplace_back(range_begin, range_end);
+        } else {
+            merged.back().second = std::max(merged.back().second, range_end);
+        }
+    }
+    ranges.clear();
+
+    for (u32 i = 0; i < system.GetNumCores(); ++i) {
+        auto& cpu = system.GetCore(i);
+        for (const auto& [range_begin, range_end] : merged) {
+            cpu.InvalidateCacheRange(range_begin, range_end - range_begin);
+        }
+    }
+}
+
+} // namespace Core
@@ -0,0 +1,49 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+class System;
+
+/**
+ * Defers the JIT code invalidations requested through System::InvalidateCacheRange on this thread
+ * while the batch is alive. The ranges are merged and each core invalidates them once when the
+ * batch is committed, instead of once per written word. Batches nest: an inner batch leaves its
+ * ranges to the outermost one, so a whole operation is committed at once.
+ */
+class InvalidationBatch {
+public:
+    explicit InvalidationBatch(System& system);
+    ~InvalidationBatch();
+
+    InvalidationBatch(const InvalidationBatch&) = delete;
+    InvalidationBatch& operator=(const InvalidationBatch&) = delete;
+
+    /// Returns the batch collecting the invalidations of this thread, or nullptr if there is none
+    static InvalidationBatch* GetActive() {
+        return active;
+    }
+
+    /// Records a range whose JIT code is invalidated when the batch is committed
+    void Add(VAddr address, std::size_t size);
+
+    /// Invalidates the recorded ranges on every core, later invalidations are done immediately
+    void Commit();
+
+private:
+    static thread_local InvalidationBatch* active;
+
+    System& system;
+    /// Start and end addresses of the recorded ranges, nearby ranges are merged
+    std::vector<std::pair<VAddr, VAddr>> ranges;
+};
+
+} // namespace Core
@@ -309,8 +309,10 @@ ResultStatus AppLoader_THREEDSX::ReadRomFS(std::shared_ptr<FileSys::RomFSReader>
         if (!romfs_file_inner.IsOpen())
             return ResultStatus::Error;
 
-        romfs_file = std::make_shared<FileSys::DirectRomFSReader>(std::move(romfs_file_inner),
-                                                                  romfs_offset, romfs_size);
+        auto direct_romfs = std::make_shared<FileSys::DirectRomFSReader>(
+            std::move(romfs_file_inner), romfs_offset, romfs_size);
+        direct_romfs->MapFile(filepath);
+        romfs_file = std::move(direct_romfs);
 
         return ResultStatus::Success;
     }
@@ -5,10 +5,12 @@
 #include <cstring>
 #include <memory>
 #include <string>
+#include <vector>
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/core.h"
+#include "core/guest_symbols.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/resource_limit.h"
 #include "core/loader/elf.h"
@@ -245,6 +247,9 @@ public:
     bool DidRelocate() const {
         return relocate;
     }
+
+    /// Returns the function symbols of the symbol tables, after LoadInto
+    std::vector<Core::GuestSymbols::Symbol> GetFunctionSymbols(u32 vaddr) const;
 };
 
 ElfReader::ElfReader(void* ptr) {
@@ -349,6 +354,32 @@ std::shared_ptr<CodeSet> ElfReader::LoadInto(u32 vaddr) {
     return codeset;
 }
 
+std::vector<Core::GuestSymbols::Symbol> ElfReader::GetFunctionSymbols(u32 vaddr) const {
+    constexpr unsigned char STT_FUNC = 2;
+
+    const u32 base_addr = relocate ? vaddr : 0;
+    std::vector<Core::GuestSymbols::Symbol> symbols;
+    for (int i = 0; i < header->e_shnum; ++i) {
+        const Elf32_Shdr& section = sections[i];
+        if (section.sh_type != SHT_SYMTAB || section.sh_link >= header->e_shnum)
+            continue;
+
+        const Elf32_Shdr& strings = sections[section.sh_link];
+        const auto* entries = reinterpret_cast<const Elf32_Sym*>(GetPtr(section.sh_offset));
+        for (u32 j = 0; j < section.sh_size / sizeof(Elf32_Sym); ++j) {
+            const Elf32_Sym& entry = entries[j];
+            if ((entry.st_info & 0xF) != STT_FUNC || entry.st_name >= strings.sh_size)
+                continue;
+
+            // The lowest bit of Thumb functions is set
+            symbols.push_back({(base_addr + entry.st_value) & ~1u, entry.st_size,
+                               reinterpret_cast<const char*>(
+                                   GetPtr(strings.sh_offset + entry.st_name))});
+        }
+    }
+    return symbols;
+}
+
 SectionID ElfReader::GetSectionByName(const char* name, int firstSection) const {
     for (int i = firstSection; i < header->e_shnum; i++) {
         const char* secname = GetSectionName(i);
@@ -394,6 +425,10 @@ ResultStatus AppLoader_ELF::Load(std::shared_ptr<Kernel::Process>& process) {
     ElfReader elf_reader(&buffer[0]);
     std::shared_ptr<CodeSet> codeset = elf_reader.LoadInto(Memory::PROCESS_IMAGE_VADDR);
     codeset->name = filename;
+    Core::GuestSymbols::AddModule(
+        filename, codeset->CodeSegment().addr,
+        codeset->CodeSegment().addr + codeset->CodeSegment().size,
+        elf_reader.GetFunctionSymbols(Memory::PROCESS_IMAGE_VADDR));
 
     process = Core::System::GetInstance().Kernel().CreateProcess(std::move(codeset));
     process->svc_access_mask.set();
@@ -2,12 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <mutex>
 #include "audio_core/dsp_interface.h"
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/page_allocation.h"
 #include "common/swap.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
@@ -15,6 +18,9 @@
 #include "core/hle/kernel/process.h"
 #include "core/hle/lock.h"
 #include "core/memory.h"
+#include "core/perf_metrics.h"
+#include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -56,16 +62,22 @@ private:
 
 class MemorySystem::Impl {
 public:
-    // Visual Studio would try to allocate these on compile time if they are std::array, which would
-    // exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
-    std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
-    std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
+    // Guest memory accesses are spread randomly across these, so they are backed by huge pages
+    // if enabled to reduce TLB misses
+    Common::PageAllocation fcram{Memory::FCRAM_N3DS_SIZE, Settings::values.use_huge_pages};
+    Common::PageAllocation vram{Memory::VRAM_SIZE, Settings::values.use_huge_pages};
+    Common::PageAllocation n3ds_extra_ram{Memory::N3DS_EXTRA_RAM_SIZE,
+                                          Settings::values.use_huge_pages};
 
     PageTable* current_page_table = nullptr;
     RasterizerCacheMarker cache_marker;
+    RasterizerCacheMarker dirty_marker;
     std::vector<PageTable*> page_table_list;
 
+    // Serializes page table updates, since the rasterizer cache may mark regions from the GPU
+    // thread while the emulation thread is mapping memory
+    std::mutex page_table_mutex;
+
     AudioCore::DspInterface* dsp = nullptr;
 };
 
@@ -87,17 +99,27 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, u8* memor
     RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
 
+    std::lock_guard lock{impl->page_table_mutex};
     u32 end = base + size;
     while (base != end) {
         ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", base);
 
+        // Writing the entries of pages that stay unmapped would only make the OS back them
+        if (type == PageType::Unmapped && page_table.attributes[base] == PageType::Unmapped) {
+            base += 1;
+            continue;
+        }
+
         page_table.attributes[base] = type;
         page_table.pointers[base] = memory;
+        page_table.read_pointers[base] = memory;
 
         // If the memory to map is already rasterizer-cached, mark the page
         if (type == PageType::Memory && impl->cache_marker.IsCached(base * PAGE_SIZE)) {
             page_table.attributes[base] = PageType::RasterizerCachedMemory;
             page_table.pointers[base] = nullptr;
+            if (impl->dirty_marker.IsCached(base * PAGE_SIZE))
+                page_table.read_pointers[base] = nullptr;
         }
 
         base += 1;
@@ -129,22 +151,24 @@ void MemorySystem::UnmapRegion(PageTable& page_table, VAddr base, u32 size) {
 
 u8* MemorySystem::GetPointerForRasterizerCache(VAddr addr) {
     if (addr >= LINEAR_HEAP_VADDR && addr < LINEAR_HEAP_VADDR_END) {
-        return impl->fcram.get() + (addr - LINEAR_HEAP_VADDR);
+        return impl->fcram.data() + (addr - LINEAR_HEAP_VADDR);
     }
     if (addr >= NEW_LINEAR_HEAP_VADDR && addr < NEW_LINEAR_HEAP_VADDR_END) {
-        return impl->fcram.get() + (addr - NEW_LINEAR_HEAP_VADDR);
+        return impl->fcram.data() + (addr - NEW_LINEAR_HEAP_VADDR);
     }
     if (addr >= VRAM_VADDR && addr < VRAM_VADDR_END) {
-        return impl->vram.get() + (addr - VRAM_VADDR);
+        return impl->vram.data() + (addr - VRAM_VADDR);
     }
     UNREACHABLE();
 }
 
 void MemorySystem::RegisterPageTable(PageTable* page_table) {
+    std::lock_guard lock{impl->page_table_mutex};
     impl->page_table_list.push_back(page_table);
 }
 
 void MemorySystem::UnregisterPageTable(PageTable* page_table) {
+    std::lock_guard lock{impl->page_table_mutex};
     impl->page_table_list.erase(
         std::find(impl->page_table_list.begin(), impl->page_table_list.end(), page_table));
 }
@@ -167,7 +191,7 @@ T ReadMMIO(MMIORegionPointer mmio_handler, VAddr addr);
 
 template <typename T>
 T MemorySystem::Read(const VAddr vaddr) {
-    const u8* page_pointer = impl->current_page_table->pointers[vaddr >> PAGE_BITS];
+    const u8* page_pointer = impl->current_page_table->read_pointers[vaddr >> PAGE_BITS];
     if (page_pointer) {
         // NOTE: Avoid adding any extra logic to this fast-path block
         T value;
@@ -271,6 +295,28 @@ u8* MemorySystem::GetPointer(const VAddr vaddr) {
     return nullptr;
 }
 
+u8* MemorySystem::GetContiguousPointer(const Kernel::Process& process, const VAddr addr,
+                                       const std::size_t size, const bool for_write) {
+    if (size == 0)
+        return nullptr;
+
+    const auto& page_table = process.vm_manager.page_table;
+    const auto& pointers = for_write ? page_table.pointers : page_table.read_pointers;
+    const std::size_t first_page = addr >> PAGE_BITS;
+    const std::size_t last_page = (addr + size - 1) >> PAGE_BITS;
+    if (last_page >= PAGE_TABLE_NUM_ENTRIES)
+        return nullptr;
+
+    u8* const base = pointers[first_page];
+    if (base == nullptr)
+        return nullptr;
+    for (std::size_t page = first_page + 1; page <= last_page; ++page) {
+        if (pointers[page] != base + (page - first_page) * PAGE_SIZE)
+            return nullptr;
+    }
+    return base + (addr & PAGE_MASK);
+}
+
 std::string MemorySystem::ReadCString(VAddr vaddr, std::size_t max_length) {
     std::string string;
     string.reserve(max_length);
@@ -315,16 +361,16 @@ u8* MemorySystem::GetPhysicalPointer(PAddr address) {
     u8* target_pointer = nullptr;
     switch (area->paddr_base) {
     case VRAM_PADDR:
-        target_pointer = impl->vram.get() + offset_into_region;
+        target_pointer = impl->vram.data() + offset_into_region;
         break;
     case DSP_RAM_PADDR:
         target_pointer = impl->dsp->GetDspMemory().data() + offset_into_region;
         break;
     case FCRAM_PADDR:
-        target_pointer = impl->fcram.get() + offset_into_region;
+        target_pointer = impl->fcram.data() + offset_into_region;
         break;
     case N3DS_EXTRA_RAM_PADDR:
-        target_pointer = impl->n3ds_extra_ram.get() + offset_into_region;
+        target_pointer = impl->n3ds_extra_ram.data() + offset_into_region;
         break;
     default:
         UNREACHABLE();
@@ -357,6 +403,7 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
         return;
     }
 
+    std::lock_guard lock{impl->page_table_mutex};
     u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
     PAddr paddr = start;
 
@@ -376,6 +423,8 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                     case PageType::Memory:
                         page_type = PageType::RasterizerCachedMemory;
                         page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
+                        if (impl->dirty_marker.IsCached(vaddr))
+                            page_table->read_pointers[vaddr >> PAGE_BITS] = nullptr;
                         break;
                     default:
                         UNREACHABLE();
@@ -391,6 +440,8 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
                         page_type = PageType::Memory;
                         page_table->pointers[vaddr >> PAGE_BITS] =
                             GetPointerForRasterizerCache(vaddr & ~PAGE_MASK);
+                        page_table->read_pointers[vaddr >> PAGE_BITS] =
+                            page_table->pointers[vaddr >> PAGE_BITS];
                         break;
                     }
                     default:
@@ -402,39 +453,95 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
     }
 }
 
-void RasterizerFlushRegion(PAddr start, u32 size) {
-    if (VideoCore::g_renderer == nullptr) {
+void MemorySystem::RasterizerMarkRegionDirty(PAddr start, u32 size, bool dirty) {
+    if (start == 0) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
+    std::lock_guard lock{impl->page_table_mutex};
+    u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
+    PAddr paddr = start;
+
+    for (unsigned i = 0; i < num_pages; ++i, paddr += PAGE_SIZE) {
+        for (VAddr vaddr : PhysicalToVirtualAddressForRasterizer(paddr)) {
+            impl->dirty_marker.Mark(vaddr, dirty);
+            for (PageTable* page_table : impl->page_table_list) {
+                // Pages that aren't cached are read from memory anyway, they pick up the dirty
+                // state once they are marked as cached
+                if (page_table->attributes[vaddr >> PAGE_BITS] != PageType::RasterizerCachedMemory)
+                    continue;
+                page_table->read_pointers[vaddr >> PAGE_BITS] =
+                    dirty ? nullptr : GetPointerForRasterizerCache(vaddr & ~PAGE_MASK);
+            }
+        }
+    }
 }
 
-void RasterizerInvalidateRegion(PAddr start, u32 size) {
+/**
+ * Forwards a cache operation to the rasterizer. If the GPU thread is enabled and the caller is not
+ * running on it, the operation has to go through the GPU thread so that it is ordered with the
+ * rest of the submitted GPU work.
+ */
+static void RasterizerCacheOperation(PAddr start, u32 size, FlushMode mode) {
+    auto* gpu_thread = VideoCore::g_gpu_thread.get();
+    if (gpu_thread && !gpu_thread->IsGPUThread()) {
+        switch (mode) {
+        case FlushMode::Flush:
+            gpu_thread->FlushRegion(start, size);
+            break;
+        case FlushMode::Invalidate:
+            gpu_thread->InvalidateRegion(start, size);
+            break;
+        case FlushMode::FlushAndInvalidate:
+            gpu_thread->FlushAndInvalidateRegion(start, size);
+            break;
+        }
+        return;
+    }
+
+    auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+    switch (mode) {
+    case FlushMode::Flush:
+        rasterizer->FlushRegion(start, size);
+        break;
+    case FlushMode::Invalidate:
+        rasterizer->InvalidateRegion(start, size);
+        break;
+    case FlushMode::FlushAndInvalidate:
+        rasterizer->FlushAndInvalidateRegion(start, size);
+        break;
+    }
+}
+
+void RasterizerFlushRegion(PAddr start, u32 size) {
     if (VideoCore::g_renderer == nullptr) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
+    RasterizerCacheOperation(start, size, FlushMode::Flush);
 }
 
-void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
-    // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
-    // null here
+void RasterizerInvalidateRegion(PAddr start, u32 size) {
     if (VideoCore::g_renderer == nullptr) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+    RasterizerCacheOperation(start, size, FlushMode::Invalidate);
 }
 
-void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
+void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
     // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
     // null here
     if (VideoCore::g_renderer == nullptr) {
         return;
     }
 
+    RasterizerCacheOperation(start, size, FlushMode::FlushAndInvalidate);
+}
+
+/// Calls func(paddr, size) for each part of the virtual region that can be held by the rasterizer
+template <typename Func>
+static void ForEachRasterizerRegion(VAddr start, u32 size, Func&& func) {
     VAddr end = start + size;
 
     auto CheckRegion = [&](VAddr region_start, VAddr region_end, PAddr paddr_region_start) {
@@ -448,18 +555,7 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         PAddr physical_start = paddr_region_start + (overlap_start - region_start);
         u32 overlap_size = overlap_end - overlap_start;
 
-        auto* rasterizer = VideoCore::g_renderer->Rasterizer();
-        switch (mode) {
-        case FlushMode::Flush:
-            rasterizer->FlushRegion(physical_start, overlap_size);
-            break;
-        case FlushMode::Invalidate:
-            rasterizer->InvalidateRegion(physical_start, overlap_size);
-            break;
-        case FlushMode::FlushAndInvalidate:
-            rasterizer->FlushAndInvalidateRegion(physical_start, overlap_size);
-            break;
-        }
+        func(physical_start, overlap_size);
     };
 
     CheckRegion(LINEAR_HEAP_VADDR, LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
@@ -467,6 +563,62 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
     CheckRegion(VRAM_VADDR, VRAM_VADDR_END, VRAM_PADDR);
 }
 
+void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
+    // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
+    // null here
+    if (VideoCore::g_renderer == nullptr) {
+        return;
+    }
+
+    ForEachRasterizerRegion(start, size, [mode](PAddr physical_start, u32 physical_size) {
+        RasterizerCacheOperation(physical_start, physical_size, mode);
+    });
+}
+
+RasterizerCacheBatch::~RasterizerCacheBatch() {
+    Apply();
+}
+
+void RasterizerCacheBatch::Add(VAddr start, u32 size, FlushMode new_mode) {
+    if (new_mode != mode) {
+        Apply();
+        mode = new_mode;
+    }
+    ForEachRasterizerRegion(start, size, [this](PAddr physical_start, u32 physical_size) {
+        regions.emplace_back(physical_start, u64{physical_start} + physical_size);
+    });
+}
+
+void RasterizerCacheBatch::Apply() {
+    if (regions.empty())
+        return;
+
+    if (VideoCore::g_renderer == nullptr) {
+        regions.clear();
+        return;
+    }
+
+    std::sort(regions.begin(), regions.end());
+    std::size_t num_operations = 0;
+    u64 start = regions.front().first;
+    u64 end = start;
+    for (const auto& [region_start, region_end] : regions) {
+        if (region_start > end) {
+            RasterizerCacheOperation(static_cast<PAddr>(start), static_cast<u32>(end - start),
+                                     mode);
+            ++num_operations;
+            start = region_start;
+        }
+        end = std::max(end, region_end);
+    }
+    RasterizerCacheOperation(static_cast<PAddr>(start), static_cast<u32>(end - start), mode);
+    ++num_operations;
+
+    Core::Metrics::Add(Core::Metrics::Counter::RasterizerOpsMerged,
+                       regions.size() - num_operations);
+    regions.clear();
+}
+
 u8 MemorySystem::Read8(const VAddr addr) {
     return Read<u8>(addr);
 }
@@ -483,17 +635,51 @@ u64 MemorySystem::Read64(const VAddr addr) {
     return Read<u64_le>(addr);
 }
 
+/**
+ * Returns the number of bytes, at most max_size, that can be accessed from vaddr as one run. A run
+ * covers consecutive pages of the same type: Memory pages have to be backed by contiguous host
+ * memory, and RasterizerCachedMemory pages have to agree on whether the rasterizer holds newer data
+ * for them. Special pages are handled one page at a time, as they can belong to different handlers.
+ */
+static std::size_t GetRunSize(const PageTable& page_table, VAddr vaddr, std::size_t max_size) {
+    std::size_t page_index = vaddr >> PAGE_BITS;
+    std::size_t size = std::min<std::size_t>(PAGE_SIZE - (vaddr & PAGE_MASK), max_size);
+    const PageType type = page_table.attributes[page_index];
+    if (type == PageType::Special) {
+        return size;
+    }
+
+    const u8* const first_pointer = page_table.pointers[page_index];
+    const bool first_read_cached = page_table.read_pointers[page_index] != nullptr;
+    std::size_t pages = 1;
+    while (size < max_size && ++page_index < PAGE_TABLE_NUM_ENTRIES) {
+        if (page_table.attributes[page_index] != type) {
+            break;
+        }
+        if (type == PageType::Memory &&
+            page_table.pointers[page_index] != first_pointer + pages * PAGE_SIZE) {
+            break;
+        }
+        if (type == PageType::RasterizerCachedMemory &&
+            (page_table.read_pointers[page_index] != nullptr) != first_read_cached) {
+            break;
+        }
+        size += std::min<std::size_t>(PAGE_SIZE, max_size - size);
+        ++pages;
+    }
+    return size;
+}
+
 void MemorySystem::ReadBlock(const Kernel::Process& process, const VAddr src_addr,
                              void* dest_buffer, const std::size_t size) {
     auto& page_table = process.vm_manager.page_table;
-
     std::size_t remaining_size = size;
-    std::size_t page_index = src_addr >> PAGE_BITS;
-    std::size_t page_offset = src_addr & PAGE_MASK;
+    VAddr current_vaddr = src_addr;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+        const std::size_t copy_amount = GetRunSize(page_table, current_vaddr, remaining_size);
+        const std::size_t page_index = current_vaddr >> PAGE_BITS;
+        const std::size_t page_offset = current_vaddr & PAGE_MASK;
 
         switch (page_table.attributes[page_index]) {
         case PageType::Unmapped: {
@@ -517,8 +703,11 @@ void MemorySystem::ReadBlock(const Kernel::Process& process, const VAddr src_add
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Flush);
+            // Only pages the rasterizer holds newer data for need to be flushed
+            if (page_table.read_pointers[page_index] == nullptr) {
+                RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+                                             FlushMode::Flush);
+            }
             std::memcpy(dest_buffer, GetPointerForRasterizerCache(current_vaddr), copy_amount);
             break;
         }
@@ -526,8 +715,7 @@ void MemorySystem::ReadBlock(const Kernel::Process& process, const VAddr src_add
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        current_vaddr += static_cast<VAddr>(copy_amount);
         dest_buffer = static_cast<u8*>(dest_buffer) + copy_amount;
         remaining_size -= copy_amount;
     }
@@ -553,12 +741,12 @@ void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_a
                               const void* src_buffer, const std::size_t size) {
     auto& page_table = process.vm_manager.page_table;
     std::size_t remaining_size = size;
-    std::size_t page_index = dest_addr >> PAGE_BITS;
-    std::size_t page_offset = dest_addr & PAGE_MASK;
+    VAddr current_vaddr = dest_addr;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+        const std::size_t copy_amount = GetRunSize(page_table, current_vaddr, remaining_size);
+        const std::size_t page_index = current_vaddr >> PAGE_BITS;
+        const std::size_t page_offset = current_vaddr & PAGE_MASK;
 
         switch (page_table.attributes[page_index]) {
         case PageType::Unmapped: {
@@ -590,8 +778,7 @@ void MemorySystem::WriteBlock(const Kernel::Process& process, const VAddr dest_a
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        current_vaddr += static_cast<VAddr>(copy_amount);
         src_buffer = static_cast<const u8*>(src_buffer) + copy_amount;
         remaining_size -= copy_amount;
     }
@@ -601,14 +788,14 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
                              const std::size_t size) {
     auto& page_table = process.vm_manager.page_table;
     std::size_t remaining_size = size;
-    std::size_t page_index = dest_addr >> PAGE_BITS;
-    std::size_t page_offset = dest_addr & PAGE_MASK;
+    VAddr current_vaddr = dest_addr;
 
     static const std::array<u8, PAGE_SIZE> zeros = {};
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+        const std::size_t copy_amount = GetRunSize(page_table, current_vaddr, remaining_size);
+        const std::size_t page_index = current_vaddr >> PAGE_BITS;
+        const std::size_t page_offset = current_vaddr & PAGE_MASK;
 
         switch (page_table.attributes[page_index]) {
         case PageType::Unmapped: {
@@ -640,8 +827,7 @@ void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_ad
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        current_vaddr += static_cast<VAddr>(copy_amount);
         remaining_size -= copy_amount;
     }
 }
@@ -656,18 +842,19 @@ void MemorySystem::CopyBlock(const Kernel::Process& dest_process,
                              std::size_t size) {
     auto& page_table = src_process.vm_manager.page_table;
     std::size_t remaining_size = size;
-    std::size_t page_index = src_addr >> PAGE_BITS;
-    std::size_t page_offset = src_addr & PAGE_MASK;
+    const VAddr start_addr = src_addr;
 
     while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+        const std::size_t copy_amount = GetRunSize(page_table, src_addr, remaining_size);
+        const VAddr current_vaddr = src_addr;
+        const std::size_t page_index = current_vaddr >> PAGE_BITS;
+        const std::size_t page_offset = current_vaddr & PAGE_MASK;
 
         switch (page_table.attributes[page_index]) {
         case PageType::Unmapped: {
             LOG_ERROR(HW_Memory,
                       "unmapped CopyBlock @ 0x{:08X} (start address = 0x{:08X}, size = {})",
-                      current_vaddr, src_addr, size);
+                      current_vaddr, start_addr, size);
             ZeroBlock(dest_process, dest_addr, copy_amount);
             break;
         }
@@ -686,8 +873,10 @@ void MemorySystem::CopyBlock(const Kernel::Process& dest_process,
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Flush);
+            if (page_table.read_pointers[page_index] == nullptr) {
+                RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+                                             FlushMode::Flush);
+            }
             WriteBlock(dest_process, dest_addr, GetPointerForRasterizerCache(current_vaddr),
                        copy_amount);
             break;
@@ -696,8 +885,6 @@ void MemorySystem::CopyBlock(const Kernel::Process& dest_process,
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
         dest_addr += static_cast<VAddr>(copy_amount);
         src_addr += static_cast<VAddr>(copy_amount);
         remaining_size -= copy_amount;
@@ -745,13 +932,14 @@ void WriteMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr, const u64 data)
 }
 
 u32 MemorySystem::GetFCRAMOffset(u8* pointer) {
-    ASSERT(pointer >= impl->fcram.get() && pointer <= impl->fcram.get() + Memory::FCRAM_N3DS_SIZE);
-    return pointer - impl->fcram.get();
+    ASSERT(pointer >= impl->fcram.data() &&
+           pointer <= impl->fcram.data() + Memory::FCRAM_N3DS_SIZE);
+    return pointer - impl->fcram.data();
 }
 
 u8* MemorySystem::GetFCRAMPointer(u32 offset) {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram.data() + offset;
 }
 
 void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
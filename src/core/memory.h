@@ -4,12 +4,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include "common/common_types.h"
+#include "common/page_allocation.h"
 #include "core/mmio.h"
 
 class ARM_Interface;
@@ -48,6 +51,52 @@ enum class PageType {
     Special,
 };
 
+/**
+ * An array with an entry for every page of the address space. Its memory comes zeroed from the OS,
+ * which only backs the parts of it that get written. A process pays for the entries of the regions
+ * it maps, while the CPU can still index a single flat array.
+ */
+template <typename T>
+class PageArray {
+public:
+    PageArray() {
+        Clear();
+    }
+
+    /// Resets every entry to zero and hands the memory of the written entries back to the OS
+    void Clear() {
+        allocation =
+            std::make_unique<Common::PageAllocation>(PAGE_TABLE_NUM_ENTRIES * sizeof(T), false);
+    }
+
+    void fill(const T& value) {
+        std::fill_n(data(), PAGE_TABLE_NUM_ENTRIES, value);
+    }
+
+    T* data() {
+        return reinterpret_cast<T*>(allocation->data());
+    }
+
+    const T* data() const {
+        return reinterpret_cast<const T*>(allocation->data());
+    }
+
+    T& operator[](std::size_t index) {
+        return data()[index];
+    }
+
+    const T& operator[](std::size_t index) const {
+        return data()[index];
+    }
+
+    constexpr std::size_t size() const {
+        return PAGE_TABLE_NUM_ENTRIES;
+    }
+
+private:
+    std::unique_ptr<Common::PageAllocation> allocation;
+};
+
 struct SpecialRegion {
     VAddr base;
     u32 size;
@@ -63,9 +112,17 @@ struct SpecialRegion {
 struct PageTable {
     /**
      * Array of memory pointers backing each page. An entry can only be non-null if the
-     * corresponding entry in the `attributes` array is of type `Memory`.
+     * corresponding entry in the `attributes` array is of type `Memory`. Writes go through this
+     * array, as does the JIT, which has a single page table for both reads and writes.
+     */
+    PageArray<u8*> pointers;
+
+    /**
+     * Array of memory pointers used for reads. Same as `pointers`, except that pages of type
+     * `RasterizerCachedMemory` only need to be null while the rasterizer holds data for them that
+     * is newer than memory, as reading doesn't invalidate the rasterizer cache.
      */
-    std::array<u8*, PAGE_TABLE_NUM_ENTRIES> pointers;
+    PageArray<u8*> read_pointers;
 
     /**
      * Contains MMIO handlers that back memory regions whose entries in the `attribute` array is of
@@ -77,7 +134,16 @@ struct PageTable {
      * Array of fine grained page attributes. If it is set to any value other than `Memory`, then
      * the corresponding entry in `pointers` MUST be set to null.
      */
-    std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
+    PageArray<PageType> attributes;
+    static_assert(PageType::Unmapped == PageType{}, "The zeroed attributes have to be unmapped");
+
+    /// Unmaps every page
+    void Clear() {
+        pointers.Clear();
+        read_pointers.Clear();
+        attributes.Clear();
+        special_regions.clear();
+    }
 };
 
 /// Physical memory regions as seen from the ARM11
@@ -215,6 +281,29 @@ enum class FlushMode {
  */
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode);
 
+/**
+ * Collects rasterizer cache operations on virtual regions, merging the overlapping and adjacent
+ * regions of consecutive operations with the same mode so that each merged region is forwarded to
+ * the rasterizer once. The operations are only executed by Apply or the destructor, the regions
+ * must not be accessed before that.
+ */
+class RasterizerCacheBatch : NonCopyable {
+public:
+    RasterizerCacheBatch() = default;
+    ~RasterizerCacheBatch();
+
+    /// Queues an operation, applying the queued ones first if they have a different mode
+    void Add(VAddr start, u32 size, FlushMode mode);
+
+    /// Executes the queued operations
+    void Apply();
+
+private:
+    FlushMode mode = FlushMode::Flush;
+    /// Queued physical regions as [start, end) pairs
+    std::vector<std::pair<PAddr, u64>> regions;
+};
+
 class MemorySystem {
 public:
     MemorySystem();
@@ -274,6 +363,17 @@ public:
 
     u8* GetPointer(VAddr vaddr);
 
+    /**
+     * Gets a pointer to a region of the process memory if all of its pages are backed by
+     * contiguous host memory that can be accessed directly, saving the copy through
+     * ReadBlock/WriteBlock.
+     * @param for_write Whether the region is going to be written. Rasterizer cached pages are only
+     *                  returned for reads, writes have to go through WriteBlock to invalidate them.
+     * @returns The pointer, or nullptr if the region has to go through the block functions.
+     */
+    u8* GetContiguousPointer(const Kernel::Process& process, VAddr addr, std::size_t size,
+                             bool for_write);
+
     bool IsValidPhysicalAddress(PAddr paddr);
 
     /// Gets offset in FCRAM from a pointer inside FCRAM range
@@ -287,6 +387,12 @@ public:
      */
     void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached);
 
+    /**
+     * Mark each page touching the region as holding data that the rasterizer has to flush before
+     * it can be read.
+     */
+    void RasterizerMarkRegionDirty(PAddr start, u32 size, bool dirty);
+
     /// Registers page table for rasterizer cache marking
     void RegisterPageTable(PageTable* page_table);
 
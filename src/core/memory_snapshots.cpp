@@ -0,0 +1,370 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/assert.h"
+#include "common/cityhash.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "common/zstd_compression.h"
+#include "core/core.h"
+#include "core/memory.h"
+#include "core/memory_snapshots.h"
+
+namespace Core {
+
+namespace {
+constexpr u32 SNAPSHOT_FILE_MAGIC = 0x504E5343; // "CSNP"
+constexpr u32 SNAPSHOT_FILE_VERSION = 2;
+
+// Snapshots are captured often, so speed matters more than the ratio
+constexpr s32 COMPRESSION_LEVEL = 1;
+
+// Pages are compressed in blocks, so that restoring and merging a few pages only has to touch the
+// blocks holding them
+constexpr std::size_t PAGES_PER_BLOCK = 256;
+constexpr std::size_t BLOCK_SIZE = PAGES_PER_BLOCK * Memory::PAGE_SIZE;
+
+struct SnapshotFileHeader {
+    u32 magic;
+    u32 version;
+    u32 num_pages;
+    u32 num_snapshots;
+};
+static_assert(sizeof(SnapshotFileHeader) == 16, "SnapshotFileHeader has incorrect size");
+} // Anonymous namespace
+
+MemorySnapshots::MemorySnapshots(Memory::MemorySystem& memory, bool n3ds_mode) {
+    const auto add_region = [&](u32 paddr, u32 size) {
+        region_first_page.push_back(num_pages);
+        regions.push_back({paddr, memory.GetPhysicalPointer(paddr), size});
+        num_pages += size / Memory::PAGE_SIZE;
+    };
+    add_region(Memory::FCRAM_PADDR, n3ds_mode ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
+    add_region(Memory::VRAM_PADDR, Memory::VRAM_SIZE);
+    add_region(Memory::DSP_RAM_PADDR, Memory::DSP_RAM_SIZE);
+    if (n3ds_mode)
+        add_region(Memory::N3DS_EXTRA_RAM_PADDR, Memory::N3DS_EXTRA_RAM_SIZE);
+
+    worker = std::thread(&MemorySnapshots::WorkerLoop, this);
+}
+
+MemorySnapshots::~MemorySnapshots() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    work_queued.notify_one();
+    worker.join();
+}
+
+u8* MemorySnapshots::GetPage(u32 page) {
+    const auto it = std::upper_bound(region_first_page.begin(), region_first_page.end(), page);
+    const std::size_t region = std::distance(region_first_page.begin(), it) - 1;
+    return regions[region].data + (page - region_first_page[region]) * Memory::PAGE_SIZE;
+}
+
+void MemorySnapshots::HashPages() {
+    page_hashes.resize(num_pages);
+    for (u32 page = 0; page < num_pages; ++page) {
+        page_hashes[page] =
+            Common::CityHash64(reinterpret_cast<const char*>(GetPage(page)), Memory::PAGE_SIZE);
+    }
+}
+
+void MemorySnapshots::FlushRasterizer(bool invalidate) {
+    for (const Region& region : regions) {
+        if (invalidate) {
+            Memory::RasterizerFlushAndInvalidateRegion(region.paddr, region.size);
+        } else {
+            Memory::RasterizerFlushRegion(region.paddr, region.size);
+        }
+    }
+}
+
+MICROPROFILE_DEFINE(Core_SnapshotCapture, "Core", "Snapshot Capture", MP_RGB(192, 128, 64));
+std::size_t MemorySnapshots::Capture() {
+    MICROPROFILE_SCOPE(Core_SnapshotCapture);
+    FlushRasterizer(false);
+
+    Snapshot snapshot;
+    if (snapshots.empty() || page_hashes.empty()) {
+        HashPages();
+        snapshot.pages.resize(num_pages);
+        for (u32 page = 0; page < num_pages; ++page) {
+            snapshot.pages[page] = page;
+        }
+    } else {
+        for (u32 page = 0; page < num_pages; ++page) {
+            const u64 hash =
+                Common::CityHash64(reinterpret_cast<const char*>(GetPage(page)), Memory::PAGE_SIZE);
+            if (hash != page_hashes[page]) {
+                page_hashes[page] = hash;
+                snapshot.pages.push_back(page);
+            }
+        }
+    }
+
+    // The copy is all that has to happen before emulation may write to the pages again
+    snapshot.data.resize(snapshot.pages.size() * Memory::PAGE_SIZE);
+    for (std::size_t i = 0; i < snapshot.pages.size(); ++i) {
+        std::memcpy(snapshot.data.data() + i * Memory::PAGE_SIZE, GetPage(snapshot.pages[i]),
+                    Memory::PAGE_SIZE);
+    }
+
+    LOG_DEBUG(Core, "Captured snapshot {} with {} changed pages", snapshots.size(),
+              snapshot.pages.size());
+    std::size_t index;
+    {
+        std::lock_guard lock{mutex};
+        index = snapshots.size();
+        memory_usage += snapshot.data.size();
+        snapshots.push_back(std::move(snapshot));
+    }
+    work_queued.notify_one();
+    return index;
+}
+
+MICROPROFILE_DEFINE(Core_SnapshotRestore, "Core", "Snapshot Restore", MP_RGB(192, 128, 64));
+bool MemorySnapshots::Restore(std::size_t index) {
+    if (index >= snapshots.size())
+        return false;
+
+    MICROPROFILE_SCOPE(Core_SnapshotRestore);
+    WaitForWorker();
+    FlushRasterizer(true);
+
+    // Walk back from the requested snapshot, every page comes from the latest snapshot holding it
+    std::vector<bool> restored(num_pages);
+    u32 num_restored = 0;
+    for (std::size_t i = index + 1; i-- > 0 && num_restored < num_pages;) {
+        const Snapshot& snapshot = snapshots[i];
+        for (std::size_t block = 0; block < snapshot.blocks.size(); ++block) {
+            const std::size_t first = block * PAGES_PER_BLOCK;
+            const std::size_t last = std::min(first + PAGES_PER_BLOCK, snapshot.pages.size());
+            if (std::all_of(snapshot.pages.begin() + first, snapshot.pages.begin() + last,
+                            [&restored](u32 page) { return restored[page]; }))
+                continue;
+
+            const std::vector<u8> data =
+                Common::Compression::DecompressDataZSTD(snapshot.blocks[block]);
+            if (data.size() != (last - first) * Memory::PAGE_SIZE) {
+                LOG_ERROR(Core, "Snapshot {} is corrupted", i);
+                return false;
+            }
+            for (std::size_t j = first; j < last; ++j) {
+                const u32 page = snapshot.pages[j];
+                if (restored[page])
+                    continue;
+                std::memcpy(GetPage(page), data.data() + (j - first) * Memory::PAGE_SIZE,
+                            Memory::PAGE_SIZE);
+                restored[page] = true;
+                ++num_restored;
+            }
+        }
+    }
+    ASSERT(num_restored == num_pages);
+
+    // The JIT may have compiled code from the memory that was just overwritten
+    Core::System& system = Core::System::GetInstance();
+    for (u32 core = 0; core < system.GetNumCores(); ++core) {
+        system.GetCore(core).ClearInstructionCache();
+    }
+
+    {
+        std::lock_guard lock{mutex};
+        for (std::size_t i = index + 1; i < snapshots.size(); ++i) {
+            memory_usage -= GetSnapshotSize(snapshots[i]);
+        }
+        snapshots.erase(snapshots.begin() + index + 1, snapshots.end());
+        num_compressed = snapshots.size();
+    }
+    HashPages();
+    return true;
+}
+
+void MemorySnapshots::Clear() {
+    WaitForWorker();
+    std::lock_guard lock{mutex};
+    snapshots.clear();
+    num_compressed = 0;
+    memory_usage = 0;
+}
+
+MICROPROFILE_DEFINE(Core_SnapshotDrop, "Core", "Snapshot Drop", MP_RGB(192, 128, 64));
+void MemorySnapshots::DropOldest() {
+    if (snapshots.size() < 2)
+        return;
+
+    MICROPROFILE_SCOPE(Core_SnapshotDrop);
+    // The worker only touches snapshots after the compressed ones, so these two are ours
+    WaitForWorker(2);
+    Snapshot& base = snapshots[0];
+    const Snapshot& next = snapshots[1];
+
+    std::vector<u8> next_data;
+    next_data.reserve(next.pages.size() * Memory::PAGE_SIZE);
+    for (const std::vector<u8>& block : next.blocks) {
+        const std::vector<u8> data = Common::Compression::DecompressDataZSTD(block);
+        next_data.insert(next_data.end(), data.begin(), data.end());
+    }
+    ASSERT(next_data.size() == next.pages.size() * Memory::PAGE_SIZE);
+
+    // The base snapshot holds every page, so each of its blocks holds a fixed run of pages
+    std::size_t old_size = GetSnapshotSize(base) + GetSnapshotSize(next);
+    std::size_t j = 0;
+    while (j < next.pages.size()) {
+        const std::size_t block = next.pages[j] / PAGES_PER_BLOCK;
+        std::vector<u8> data = Common::Compression::DecompressDataZSTD(base.blocks[block]);
+        for (; j < next.pages.size() && next.pages[j] / PAGES_PER_BLOCK == block; ++j) {
+            std::memcpy(data.data() + (next.pages[j] % PAGES_PER_BLOCK) * Memory::PAGE_SIZE,
+                        next_data.data() + j * Memory::PAGE_SIZE, Memory::PAGE_SIZE);
+        }
+        base.blocks[block] =
+            Common::Compression::CompressDataZSTD(data.data(), data.size(), COMPRESSION_LEVEL);
+    }
+
+    std::lock_guard lock{mutex};
+    memory_usage = memory_usage - old_size + GetSnapshotSize(base);
+    // Erasing in the middle of a deque would move the snapshot the worker may be compressing
+    snapshots[1] = std::move(base);
+    snapshots.pop_front();
+    --num_compressed;
+}
+
+std::size_t MemorySnapshots::MemoryUsage() {
+    std::lock_guard lock{mutex};
+    return memory_usage;
+}
+
+bool MemorySnapshots::SaveToFile(const std::string& path) {
+    WaitForWorker();
+
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Core, "Failed to open snapshot file {}", path);
+        return false;
+    }
+
+    const SnapshotFileHeader header{SNAPSHOT_FILE_MAGIC, SNAPSHOT_FILE_VERSION, num_pages,
+                                    static_cast<u32>(snapshots.size())};
+    bool success = file.WriteObject(header) == 1;
+    for (const Snapshot& snapshot : snapshots) {
+        const u32 page_count = static_cast<u32>(snapshot.pages.size());
+        success = success && file.WriteObject(page_count) == 1 &&
+                  file.WriteArray(snapshot.pages.data(), page_count) == page_count;
+        for (const std::vector<u8>& block : snapshot.blocks) {
+            const u32 block_size = static_cast<u32>(block.size());
+            success = success && file.WriteObject(block_size) == 1 &&
+                      file.WriteBytes(block.data(), block_size) == block_size;
+        }
+    }
+
+    if (!success) {
+        LOG_ERROR(Core, "Failed to write snapshot file {}", path);
+        file.Close();
+        FileUtil::Delete(path);
+    }
+    return success;
+}
+
+bool MemorySnapshots::LoadFromFile(const std::string& path) {
+    FileUtil::IOFile file(path, "rb");
+    SnapshotFileHeader header;
+    if (!file.IsOpen() || file.ReadArray(&header, 1) != 1 || header.magic != SNAPSHOT_FILE_MAGIC ||
+        header.version != SNAPSHOT_FILE_VERSION || header.num_pages != num_pages ||
+        header.num_snapshots == 0) {
+        LOG_ERROR(Core, "Snapshot file {} is invalid or doesn't match the system", path);
+        return false;
+    }
+
+    std::deque<Snapshot> loaded(header.num_snapshots);
+    std::size_t loaded_size = 0;
+    for (Snapshot& snapshot : loaded) {
+        u32 page_count;
+        if (file.ReadArray(&page_count, 1) != 1 || page_count > num_pages) {
+            LOG_ERROR(Core, "Snapshot file {} is corrupted", path);
+            return false;
+        }
+        snapshot.pages.resize(page_count);
+        snapshot.blocks.resize((page_count + PAGES_PER_BLOCK - 1) / PAGES_PER_BLOCK);
+        bool success = file.ReadArray(snapshot.pages.data(), page_count) == page_count;
+        for (std::vector<u8>& block : snapshot.blocks) {
+            u32 block_size;
+            success = success && file.ReadArray(&block_size, 1) == 1;
+            if (success) {
+                block.resize(block_size);
+                success = file.ReadBytes(block.data(), block_size) == block_size;
+            }
+        }
+        if (!success || std::any_of(snapshot.pages.begin(), snapshot.pages.end(),
+                                    [this](u32 page) { return page >= num_pages; })) {
+            LOG_ERROR(Core, "Snapshot file {} is corrupted", path);
+            return false;
+        }
+        loaded_size += GetSnapshotSize(snapshot);
+    }
+    if (loaded.front().pages.size() != num_pages) {
+        LOG_ERROR(Core, "Snapshot file {} doesn't start with a full snapshot", path);
+        return false;
+    }
+
+    WaitForWorker();
+    {
+        std::lock_guard lock{mutex};
+        snapshots = std::move(loaded);
+        num_compressed = snapshots.size();
+        memory_usage = loaded_size;
+    }
+    // Memory no longer matches the latest snapshot, so the next one has to hold every page again
+    page_hashes.clear();
+    return true;
+}
+
+std::size_t MemorySnapshots::GetSnapshotSize(const Snapshot& snapshot) {
+    std::size_t size = snapshot.data.size();
+    for (const std::vector<u8>& block : snapshot.blocks) {
+        size += block.size();
+    }
+    return size;
+}
+
+void MemorySnapshots::WaitForWorker(std::size_t count) {
+    std::unique_lock lock{mutex};
+    work_done.wait(lock, [&] { return num_compressed >= std::min(count, snapshots.size()); });
+}
+
+void MemorySnapshots::WorkerLoop() {
+    Common::SetCurrentThreadName("SnapshotWorker");
+    std::unique_lock lock{mutex};
+    while (true) {
+        work_queued.wait(lock, [this] { return stop || num_compressed < snapshots.size(); });
+        if (stop)
+            break;
+
+        // Elements of a deque stay in place when others are added at its ends, and the emulation
+        // thread waits for the worker before it touches uncompressed snapshots
+        Snapshot& snapshot = snapshots[num_compressed];
+        lock.unlock();
+        std::vector<std::vector<u8>> blocks;
+        std::size_t compressed_size = 0;
+        for (std::size_t offset = 0; offset < snapshot.data.size(); offset += BLOCK_SIZE) {
+            blocks.push_back(Common::Compression::CompressDataZSTD(
+                snapshot.data.data() + offset, std::min(BLOCK_SIZE, snapshot.data.size() - offset),
+                COMPRESSION_LEVEL));
+            compressed_size += blocks.back().size();
+        }
+        lock.lock();
+        memory_usage = memory_usage - snapshot.data.size() + compressed_size;
+        snapshot.blocks = std::move(blocks);
+        snapshot.data = {};
+        ++num_compressed;
+        work_done.notify_all();
+    }
+}
+
+} // namespace Core
@@ -0,0 +1,126 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+namespace Core {
+
+/**
+ * Incremental snapshots of the emulated physical memory: FCRAM, VRAM, DSP RAM and the New 3DS
+ * extra RAM. The first snapshot holds every page, each later one only the pages whose contents
+ * changed since the previous snapshot, which are found by comparing page hashes. Capturing only
+ * copies the changed pages, they are compressed with zstd on a worker thread while emulation
+ * goes on.
+ *
+ * Snapshots only cover memory, the kernel, the CPU cores and the hardware are left alone, apart
+ * from the JIT caches which are cleared when memory is restored. All functions have to be called
+ * from the emulation thread between two slices.
+ */
+class MemorySnapshots : NonCopyable {
+public:
+    MemorySnapshots(Memory::MemorySystem& memory, bool n3ds_mode);
+    ~MemorySnapshots();
+
+    /// Captures the current memory contents and returns the index of the new snapshot
+    std::size_t Capture();
+
+    /**
+     * Restores the memory contents of the given snapshot and discards all snapshots captured
+     * after it, as emulation continues from it.
+     * @returns false if the snapshot doesn't exist
+     */
+    bool Restore(std::size_t index);
+
+    /// Discards all snapshots, the next one captured holds every page again
+    void Clear();
+
+    /**
+     * Merges the second snapshot into the first one and discards it, which frees its memory while
+     * keeping the others. Only the blocks of the first snapshot the second one changes are
+     * recompressed. The indices of the remaining snapshots move down by one.
+     */
+    void DropOldest();
+
+    /// Returns the number of captured snapshots
+    std::size_t Count() const {
+        return snapshots.size();
+    }
+
+    /// Returns the memory used by all snapshots in bytes
+    std::size_t MemoryUsage();
+
+    /// Writes all snapshots to a file
+    bool SaveToFile(const std::string& path);
+
+    /**
+     * Replaces all snapshots by the ones of a file written by SaveToFile. Memory is left alone,
+     * the loaded snapshots are restored like captured ones, e.g. by Rewind at the end of a slice.
+     * The next snapshot captured holds every page again.
+     */
+    bool LoadFromFile(const std::string& path);
+
+private:
+    struct Region {
+        u32 paddr;
+        u8* data;
+        u32 size;
+    };
+
+    struct Snapshot {
+        /// Global indices of the pages held by the snapshot, in ascending order
+        std::vector<u32> pages;
+        /// Contents of the pages until the worker compressed them into blocks
+        std::vector<u8> data;
+        /// The zstd-compressed contents of each run of PAGES_PER_BLOCK pages
+        std::vector<std::vector<u8>> blocks;
+    };
+
+    static std::size_t GetSnapshotSize(const Snapshot& snapshot);
+
+    u8* GetPage(u32 page);
+
+    /// Hashes every page into page_hashes
+    void HashPages();
+
+    /// Flushes the rasterizer cache into memory and also invalidates it if requested
+    void FlushRasterizer(bool invalidate);
+
+    /// Waits until the worker compressed the given number of snapshots, by default all of them
+    void WaitForWorker(std::size_t count = static_cast<std::size_t>(-1));
+
+    void WorkerLoop();
+
+    std::vector<Region> regions;
+    /// First global page index of each region
+    std::vector<u32> region_first_page;
+    u32 num_pages = 0;
+
+    /// Hashes of the pages when the latest snapshot was captured, empty after LoadFromFile
+    std::vector<u64> page_hashes;
+
+    std::mutex mutex;
+    std::condition_variable work_queued;
+    std::condition_variable work_done;
+    std::deque<Snapshot> snapshots;
+    /// Number of snapshots at the front of snapshots which are compressed
+    std::size_t num_compressed = 0;
+    std::size_t memory_usage = 0;
+    bool stop = false;
+    std::thread worker;
+};
+
+} // namespace Core
@@ -2,8 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 #include <boost/optional.hpp>
 #include <cryptopp/hex.h>
@@ -15,6 +21,7 @@
 #include "common/string_util.h"
 #include "common/swap.h"
 #include "common/timer.h"
+#include "common/zstd_compression.h"
 #include "core/core.h"
 #include "core/hle/service/hid/hid.h"
 #include "core/hle/service/ir/extra_hid.h"
@@ -117,12 +124,275 @@ struct CTMHeader {
     u64_le program_id;           /// ID of the ROM being executed. Also called title_id
     std::array<u8, 20> revision; /// Git hash of the revision this movie was created with
     u64_le clock_init_time;      /// The init time of the system clock
+    u32_le version;              /// Layout of the input, see the CTM_VERSION constants
+    u64_le input_size;           /// Size of the input, 0 if the recording was interrupted
+    u64_le index_offset;         /// Offset of the chunk index, 0 if the recording was interrupted
+    u32_le index_entries;        /// Number of entries in the chunk index
 
-    std::array<u8, 216> reserved; /// Make heading 256 bytes so it has consistent size
+    std::array<u8, 192> reserved; /// Make heading 256 bytes so it has consistent size
 };
 static_assert(sizeof(CTMHeader) == 256, "CTMHeader should be 256 bytes");
+
+/// The input follows the header uncompressed, movies recorded before chunks were added have this
+constexpr u32 CTM_VERSION_RAW = 0;
+/// The input is stored in zstd compressed chunks, followed by an index of the chunks
+constexpr u32 CTM_VERSION_CHUNKED = 1;
+
+constexpr std::array<u8, 4> chunk_magic_bytes{{'C', 'T', 'M', 'C'}};
+
+struct CTMChunkHeader {
+    std::array<u8, 4> magic; /// Always "CTMC", to find the chunks of interrupted recordings
+    u64_le input_position;   /// Position in the input of the first byte of the chunk
+    u32_le input_size;       /// Size of the input of the chunk
+    u32_le compressed_size;  /// Size of the compressed input following the header
+};
+static_assert(sizeof(CTMChunkHeader) == 20, "CTMChunkHeader should be 20 bytes");
+
+struct CTMIndexEntry {
+    u64_le input_position; /// Position in the input of the first byte of the chunk
+    u64_le file_offset;    /// Offset of the chunk header in the file
+};
+static_assert(sizeof(CTMIndexEntry) == 16, "CTMIndexEntry should be 16 bytes");
 #pragma pack(pop)
 
+/// Recorded input is written out in chunks of this size, so at most this much is lost on a crash
+constexpr std::size_t CHUNK_INPUT_SIZE = 0x1000 * sizeof(ControllerState);
+constexpr s32 CHUNK_COMPRESSION_LEVEL = 3;
+
+/// Reads the input of a movie file one chunk at a time
+class MovieChunkReader {
+public:
+    /// Opens the movie, returns false if its input can't be found
+    bool Open(const std::string& movie_file, const CTMHeader& header) {
+        if (!file.Open(movie_file, "rb")) {
+            return false;
+        }
+        const u64 file_size = file.GetSize();
+        version = header.version;
+        if (version == CTM_VERSION_RAW) {
+            index.push_back({0, sizeof(CTMHeader)});
+            input_size = file_size - sizeof(CTMHeader);
+            return true;
+        }
+        if (version != CTM_VERSION_CHUNKED) {
+            LOG_ERROR(Movie, "Unknown movie version {}", static_cast<u32>(header.version));
+            return false;
+        }
+
+        if (header.index_offset != 0) {
+            index.resize(header.index_entries);
+            const std::size_t index_size = index.size() * sizeof(CTMIndexEntry);
+            if (file.ReadAt(header.index_offset, index.data(), index_size) == index_size) {
+                input_size = header.input_size;
+                return true;
+            }
+            LOG_WARNING(Movie, "Unable to read the chunk index, searching for the chunks");
+            index.clear();
+        }
+
+        // The recording was interrupted, so the chunks that made it to the file are searched
+        u64 offset = sizeof(CTMHeader);
+        input_size = 0;
+        CTMChunkHeader chunk;
+        while (offset + sizeof(chunk) <= file_size &&
+               file.ReadAt(offset, &chunk, sizeof(chunk)) == sizeof(chunk) &&
+               chunk.magic == chunk_magic_bytes && chunk.input_position == input_size &&
+               offset + sizeof(chunk) + chunk.compressed_size <= file_size) {
+            index.push_back({input_size, offset});
+            input_size += chunk.input_size;
+            offset += sizeof(chunk) + chunk.compressed_size;
+        }
+        LOG_INFO(Movie, "Recovered {} chunks with {} bytes of input", index.size(), input_size);
+        return true;
+    }
+
+    u64 GetInputSize() const {
+        return input_size;
+    }
+
+    /**
+     * Reads the chunk that holds the input position.
+     * @returns the position in the input of the first byte of the chunk, nothing on failure
+     */
+    std::optional<u64> ReadChunk(u64 position, std::vector<u8>& input) {
+        auto it = std::upper_bound(
+            index.begin(), index.end(), position,
+            [](u64 value, const CTMIndexEntry& entry) { return value < entry.input_position; });
+        if (it == index.begin()) {
+            return std::nullopt;
+        }
+        --it;
+
+        if (version == CTM_VERSION_RAW) {
+            input.resize(input_size);
+            if (file.ReadAt(it->file_offset, input.data(), input.size()) != input.size()) {
+                return std::nullopt;
+            }
+            return 0;
+        }
+
+        CTMChunkHeader chunk;
+        if (file.ReadAt(it->file_offset, &chunk, sizeof(chunk)) != sizeof(chunk) ||
+            chunk.magic != chunk_magic_bytes) {
+            return std::nullopt;
+        }
+        std::vector<u8> compressed(chunk.compressed_size);
+        if (file.ReadAt(it->file_offset + sizeof(chunk), compressed.data(), compressed.size()) !=
+            compressed.size()) {
+            return std::nullopt;
+        }
+        input = Common::Compression::DecompressDataZSTD(compressed);
+        if (input.size() != chunk.input_size) {
+            return std::nullopt;
+        }
+        return it->input_position;
+    }
+
+private:
+    FileUtil::IOFile file;
+    std::vector<CTMIndexEntry> index;
+    u64 input_size = 0;
+    u32 version = CTM_VERSION_RAW;
+};
+
+/**
+ * Compresses the chunks of a recording and appends them to the movie file on a background thread,
+ * so that the input doesn't pile up in memory and an interrupted recording can still be played.
+ */
+class MovieChunkWriter {
+public:
+    explicit MovieChunkWriter(FileUtil::IOFile file_) : file(std::move(file_)) {
+        end_offset = file.Tell();
+        thread = std::thread([this] { WriterLoop(); });
+    }
+
+    ~MovieChunkWriter() {
+        {
+            std::lock_guard lock{mutex};
+            stop = true;
+        }
+        work_available.notify_one();
+        thread.join();
+    }
+
+    /// Queues a chunk of input to be written
+    void Write(u64 input_position, std::vector<u8> input) {
+        {
+            std::lock_guard lock{mutex};
+            queue.push_back({input_position, std::move(input)});
+        }
+        work_available.notify_one();
+    }
+
+    /**
+     * Removes the chunks with input from the given position on, e.g. when rewinding.
+     * @param input Set to the input of the chunk holding the position, which is removed too
+     * @returns the position in the input of the first byte of that chunk
+     */
+    u64 Truncate(u64 position, std::vector<u8>& input) {
+        std::unique_lock lock{mutex};
+        idle.wait(lock, [this] { return queue.empty() && !busy; });
+
+        auto it = std::upper_bound(
+            index.begin(), index.end(), position,
+            [](u64 value, const CTMIndexEntry& entry) { return value < entry.input_position; });
+        input.clear();
+        if (it == index.begin()) {
+            return position;
+        }
+        --it;
+
+        CTMChunkHeader chunk;
+        if (file.ReadAt(it->file_offset, &chunk, sizeof(chunk)) == sizeof(chunk)) {
+            std::vector<u8> compressed(chunk.compressed_size);
+            file.ReadAt(it->file_offset + sizeof(chunk), compressed.data(), compressed.size());
+            input = Common::Compression::DecompressDataZSTD(compressed);
+        }
+        const u64 chunk_position = it->input_position;
+        end_offset = it->file_offset;
+        index.erase(it, index.end());
+        file.Resize(end_offset);
+        file.Seek(end_offset, SEEK_SET);
+        return chunk_position;
+    }
+
+    /// Writes the queued chunks and the index, then completes the header at the file start
+    void Finish(CTMHeader header) {
+        std::unique_lock lock{mutex};
+        idle.wait(lock, [this] { return queue.empty() && !busy; });
+
+        header.index_offset = end_offset;
+        header.index_entries = static_cast<u32>(index.size());
+        file.WriteBytes(index.data(), index.size() * sizeof(CTMIndexEntry));
+        file.Seek(0, SEEK_SET);
+        file.WriteBytes(&header, sizeof(header));
+        file.Flush();
+        if (!file.IsGood()) {
+            LOG_ERROR(Movie, "Error saving movie");
+        }
+    }
+
+private:
+    struct Chunk {
+        u64 input_position;
+        std::vector<u8> input;
+    };
+
+    void WriterLoop() {
+        std::unique_lock lock{mutex};
+        while (true) {
+            work_available.wait(lock, [this] { return stop || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            Chunk chunk = std::move(queue.front());
+            queue.pop_front();
+            busy = true;
+            lock.unlock();
+
+            const std::vector<u8> compressed = Common::Compression::CompressDataZSTD(
+                chunk.input.data(), chunk.input.size(), CHUNK_COMPRESSION_LEVEL);
+            CTMChunkHeader header;
+            header.magic = chunk_magic_bytes;
+            header.input_position = chunk.input_position;
+            header.input_size = static_cast<u32>(chunk.input.size());
+            header.compressed_size = static_cast<u32>(compressed.size());
+            file.WriteBytes(&header, sizeof(header));
+            file.WriteBytes(compressed.data(), compressed.size());
+            // Flushed right away, so the chunk survives a crash of the emulator
+            file.Flush();
+            if (!file.IsGood()) {
+                LOG_ERROR(Movie, "Error writing movie chunk at input position {}",
+                          chunk.input_position);
+            }
+
+            lock.lock();
+            index.push_back({chunk.input_position, end_offset});
+            end_offset += sizeof(header) + compressed.size();
+            busy = false;
+            if (queue.empty()) {
+                idle.notify_all();
+            }
+        }
+    }
+
+    FileUtil::IOFile file;
+    std::vector<CTMIndexEntry> index;
+    u64 end_offset = 0;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable idle;
+    std::deque<Chunk> queue;
+    bool busy = false;
+    bool stop = false;
+};
+
+Movie::Movie() = default;
+
+Movie::~Movie() = default;
+
 bool Movie::IsPlayingInput() const {
     return play_mode == PlayMode::Playing;
 }
@@ -130,8 +400,58 @@ bool Movie::IsRecordingInput() const {
     return play_mode == PlayMode::Recording;
 }
 
+std::size_t Movie::GetInputPosition() const {
+    return current_byte;
+}
+
+void Movie::SeekInput(std::size_t position) {
+    if (play_mode == PlayMode::Playing) {
+        if (position > input_size)
+            return;
+
+        current_byte = position;
+        LoadInputChunk();
+        return;
+    }
+    if (play_mode != PlayMode::Recording || position > current_byte)
+        return;
+
+    current_byte = position;
+    if (position < chunk_start) {
+        // The input was already handed to the writer, so it is read back from the file
+        chunk_start = static_cast<std::size_t>(writer->Truncate(position, recorded_input));
+    }
+    recorded_input.resize(position - chunk_start);
+}
+
+bool Movie::LoadInputChunk() {
+    if (current_byte >= chunk_start &&
+        current_byte + sizeof(ControllerState) <= chunk_start + recorded_input.size())
+        return true;
+
+    const auto position = reader->ReadChunk(current_byte, recorded_input);
+    if (!position || current_byte + sizeof(ControllerState) > *position + recorded_input.size()) {
+        // The playback ends here, as if the rest of the input had never been recorded
+        LOG_ERROR(Movie, "Unable to read the movie input at position {}", current_byte);
+        recorded_input.clear();
+        chunk_start = current_byte;
+        input_size = current_byte;
+        CheckInputEnd();
+        return false;
+    }
+    chunk_start = static_cast<std::size_t>(*position);
+    return true;
+}
+
+void Movie::FlushInputChunk() {
+    writer->Write(chunk_start, std::move(recorded_input));
+    chunk_start = current_byte;
+    recorded_input.clear();
+    recorded_input.reserve(CHUNK_INPUT_SIZE);
+}
+
 void Movie::CheckInputEnd() {
-    if (current_byte + sizeof(ControllerState) > recorded_input.size()) {
+    if (current_byte + sizeof(ControllerState) > input_size) {
         LOG_INFO(Movie, "Playback finished");
         play_mode = PlayMode::None;
         init_time = 0;
@@ -141,7 +461,7 @@ void Movie::CheckInputEnd() {
 
 void Movie::Play(Service::HID::PadState& pad_state, s16& circle_pad_x, s16& circle_pad_y) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
+    std::memcpy(&s, &recorded_input[current_byte - chunk_start], sizeof(ControllerState));
     current_byte += sizeof(ControllerState);
 
     if (s.type != ControllerStateType::PadAndCircle) {
@@ -172,7 +492,7 @@ void Movie::Play(Service::HID::PadState& pad_state, s16& circle_pad_x, s16& circ
 
 void Movie::Play(Service::HID::TouchDataEntry& touch_data) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
+    std::memcpy(&s, &recorded_input[current_byte - chunk_start], sizeof(ControllerState));
     current_byte += sizeof(ControllerState);
 
     if (s.type != ControllerStateType::Touch) {
@@ -189,7 +509,7 @@ void Movie::Play(Service::HID::TouchDataEntry& touch_data) {
 
 void Movie::Play(Service::HID::AccelerometerDataEntry& accelerometer_data) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
+    std::memcpy(&s, &recorded_input[current_byte - chunk_start], sizeof(ControllerState));
     current_byte += sizeof(ControllerState);
 
     if (s.type != ControllerStateType::Accelerometer) {
@@ -206,7 +526,7 @@ void Movie::Play(Service::HID::AccelerometerDataEntry& accelerometer_data) {
 
 void Movie::Play(Service::HID::GyroscopeDataEntry& gyroscope_data) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
+    std::memcpy(&s, &recorded_input[current_byte - chunk_start], sizeof(ControllerState));
     current_byte += sizeof(ControllerState);
 
     if (s.type != ControllerStateType::Gyroscope) {
@@ -223,7 +543,7 @@ void Movie::Play(Service::HID::GyroscopeDataEntry& gyroscope_data) {
 
 void Movie::Play(Service::IR::PadState& pad_state, s16& c_stick_x, s16& c_stick_y) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
+    std::memcpy(&s, &recorded_input[current_byte - chunk_start], sizeof(ControllerState));
     current_byte += sizeof(ControllerState);
 
     if (s.type != ControllerStateType::IrRst) {
@@ -241,7 +561,7 @@ void Movie::Play(Service::IR::PadState& pad_state, s16& c_stick_x, s16& c_stick_
 
 void Movie::Play(Service::IR::ExtraHIDResponse& extra_hid_response) {
     ControllerState s;
-    std::memcpy(&s, &recorded_input[current_byte], sizeof(ControllerState));
+    std::memcpy(&s, &recorded_input[current_byte - chunk_start], sizeof(ControllerState));
     current_byte += sizeof(ControllerState);
 
     if (s.type != ControllerStateType::ExtraHidResponse) {
@@ -263,9 +583,13 @@ void Movie::Play(Service::IR::ExtraHIDResponse& extra_hid_response) {
 }
 
 void Movie::Record(const ControllerState& controller_state) {
-    recorded_input.resize(current_byte + sizeof(ControllerState));
-    std::memcpy(&recorded_input[current_byte], &controller_state, sizeof(ControllerState));
+    const std::size_t offset = current_byte - chunk_start;
+    recorded_input.resize(offset + sizeof(ControllerState));
+    std::memcpy(&recorded_input[offset], &controller_state, sizeof(ControllerState));
     current_byte += sizeof(ControllerState);
+
+    if (recorded_input.size() >= CHUNK_INPUT_SIZE)
+        FlushInputChunk();
 }
 
 void Movie::Record(const Service::HID::PadState& pad_state, const s16& circle_pad_x,
@@ -382,18 +706,11 @@ Movie::ValidationResult Movie::ValidateHeader(const CTMHeader& header, u64 progr
     return ValidationResult::OK;
 }
 
-void Movie::SaveMovie() {
-    LOG_INFO(Movie, "Saving recorded movie to '{}'", record_movie_file);
-    FileUtil::IOFile save_record(record_movie_file, "wb");
-
-    if (!save_record.IsGood()) {
-        LOG_ERROR(Movie, "Unable to open file to save movie");
-        return;
-    }
-
+static CTMHeader MakeHeader(u64 init_time) {
     CTMHeader header = {};
     header.filetype = header_magic_bytes;
     header.clock_init_time = init_time;
+    header.version = CTM_VERSION_CHUNKED;
 
     Core::System::GetInstance().GetAppLoader().ReadProgramId(header.program_id);
 
@@ -401,13 +718,21 @@ void Movie::SaveMovie() {
     CryptoPP::StringSource(Common::g_scm_rev, true,
                            new CryptoPP::HexDecoder(new CryptoPP::StringSink(rev_bytes)));
     std::memcpy(header.revision.data(), rev_bytes.data(), sizeof(CTMHeader::revision));
+    return header;
+}
 
-    save_record.WriteBytes(&header, sizeof(CTMHeader));
-    save_record.WriteBytes(recorded_input.data(), recorded_input.size());
-
-    if (!save_record.IsGood()) {
-        LOG_ERROR(Movie, "Error saving movie");
+void Movie::SaveMovie() {
+    LOG_INFO(Movie, "Saving recorded movie to '{}'", record_movie_file);
+    if (!writer) {
+        return;
     }
+
+    if (!recorded_input.empty())
+        FlushInputChunk();
+
+    CTMHeader header = MakeHeader(init_time);
+    header.input_size = current_byte;
+    writer->Finish(header);
 }
 
 void Movie::StartPlayback(const std::string& movie_file,
@@ -419,10 +744,14 @@ void Movie::StartPlayback(const std::string& movie_file,
     if (save_record.IsGood() && size > sizeof(CTMHeader)) {
         CTMHeader header;
         save_record.ReadArray(&header, 1);
-        if (ValidateHeader(header) != ValidationResult::Invalid) {
+        auto new_reader = std::make_unique<MovieChunkReader>();
+        if (ValidateHeader(header) != ValidationResult::Invalid &&
+            new_reader->Open(movie_file, header)) {
             play_mode = PlayMode::Playing;
-            recorded_input.resize(size - sizeof(CTMHeader));
-            save_record.ReadArray(recorded_input.data(), recorded_input.size());
+            reader = std::move(new_reader);
+            input_size = static_cast<std::size_t>(reader->GetInputSize());
+            recorded_input.clear();
+            chunk_start = 0;
             current_byte = 0;
             playback_completion_callback = completion_callback;
         }
@@ -433,8 +762,23 @@ void Movie::StartPlayback(const std::string& movie_file,
 
 void Movie::StartRecording(const std::string& movie_file) {
     LOG_INFO(Movie, "Enabling Movie recording");
+    // The header is completed when the recording is saved, until then the chunks are found by
+    // searching the file
+    FileUtil::IOFile save_record(movie_file, "w+b");
+    const CTMHeader header = MakeHeader(init_time);
+    if (save_record.WriteBytes(&header, sizeof(CTMHeader)) != sizeof(CTMHeader) ||
+        !save_record.Flush()) {
+        LOG_ERROR(Movie, "Unable to open file to save movie");
+        return;
+    }
+
     play_mode = PlayMode::Recording;
     record_movie_file = movie_file;
+    writer = std::make_unique<MovieChunkWriter>(std::move(save_record));
+    recorded_input.clear();
+    recorded_input.reserve(CHUNK_INPUT_SIZE);
+    chunk_start = 0;
+    current_byte = 0;
 }
 
 static boost::optional<CTMHeader> ReadHeader(const std::string& movie_file) {
@@ -492,8 +836,13 @@ void Movie::Shutdown() {
     }
 
     play_mode = PlayMode::None;
-    recorded_input.resize(0);
+    recorded_input.clear();
+    recorded_input.shrink_to_fit();
+    reader.reset();
+    writer.reset();
     record_movie_file.clear();
+    chunk_start = 0;
+    input_size = 0;
     current_byte = 0;
     init_time = 0;
 }
@@ -501,7 +850,8 @@ void Movie::Shutdown() {
 template <typename... Targs>
 void Movie::Handle(Targs&... Fargs) {
     if (IsPlayingInput()) {
-        ASSERT(current_byte + sizeof(ControllerState) <= recorded_input.size());
+        if (!LoadInputChunk())
+            return;
         Play(Fargs...);
         CheckInputEnd();
     } else if (IsRecordingInput()) {
@@ -5,6 +5,9 @@
 #pragma once
 
 #include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 #include "common/common_types.h"
 
 namespace Service {
@@ -23,6 +26,8 @@ union PadState;
 namespace Core {
 struct CTMHeader;
 struct ControllerState;
+class MovieChunkReader;
+class MovieChunkWriter;
 enum class PlayMode;
 
 class Movie {
@@ -41,6 +46,9 @@ public:
         return s_instance;
     }
 
+    Movie();
+    ~Movie();
+
     void StartPlayback(const std::string& movie_file,
                        std::function<void()> completion_callback = [] {});
     void StartRecording(const std::string& movie_file);
@@ -98,11 +106,29 @@ public:
     bool IsPlayingInput() const;
     bool IsRecordingInput() const;
 
+    /// Returns the position in the input being played or recorded
+    std::size_t GetInputPosition() const;
+
+    /**
+     * Moves to another position in the input. When recording, only earlier positions can be
+     * returned to, e.g. when rewinding emulation, and the input recorded after it is dropped.
+     * Playback can continue from any position of the movie, so that it can be resumed together
+     * with a snapshot of the emulated system.
+     */
+    void SeekInput(std::size_t position);
+
 private:
     static Movie s_instance;
 
     void CheckInputEnd();
 
+    /// Loads the chunk of the played movie that holds the current position, ends the playback and
+    /// returns false if it can't be read
+    bool LoadInputChunk();
+
+    /// Hands the chunk being recorded to the writer and starts a new one
+    void FlushInputChunk();
+
     template <typename... Targs>
     void Handle(Targs&... Fargs);
 
@@ -128,7 +154,13 @@ private:
 
     PlayMode play_mode;
     std::string record_movie_file;
+    /// The chunk of input being played or recorded, it starts at chunk_start in the input
     std::vector<u8> recorded_input;
+    std::size_t chunk_start = 0;
+    /// The total size of the input being played
+    std::size_t input_size = 0;
+    std::unique_ptr<MovieChunkReader> reader;
+    std::unique_ptr<MovieChunkWriter> writer;
     u64 init_time;
     std::function<void()> playback_completion_callback;
     std::size_t current_byte = 0;
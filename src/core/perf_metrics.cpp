@@ -0,0 +1,397 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/perf_metrics.h"
+#include "core/settings.h"
+#ifdef ENABLE_WEB_SERVICE
+#include <httplib.h>
+#endif
+
+namespace Core::Metrics {
+
+namespace {
+constexpr std::size_t NUM_TIMES = static_cast<std::size_t>(Time::Count);
+constexpr std::size_t NUM_GPU_TIMES = static_cast<std::size_t>(GPUTime::Count);
+constexpr std::size_t NUM_COUNTERS = static_cast<std::size_t>(Counter::Count);
+constexpr std::size_t NUM_GAUGES = static_cast<std::size_t>(Gauge::Count);
+constexpr std::size_t NUM_LATENCIES = static_cast<std::size_t>(Latency::Count);
+
+/// Latency samples the percentiles are computed from
+constexpr std::size_t LATENCY_WINDOW = 1000;
+constexpr std::array<double, 3> latency_quantiles{0.5, 0.9, 0.99};
+
+constexpr std::array<const char*, NUM_TIMES> time_names{"arm", "hle", "gpu", "dsp"};
+constexpr std::array<const char*, NUM_GPU_TIMES> gpu_time_names{
+    "draw", "upload", "download", "texture_filter", "present",
+};
+constexpr std::array<const char*, NUM_COUNTERS> counter_names{
+    "draw_calls",      "shader_compiles", "surface_cache_hits",    "surface_cache_misses",
+    "texture_uploads", "bytes_flushed",   "rasterizer_ops_merged", "fragment_configs",
+    "thread_switches",
+};
+constexpr std::array<const char*, NUM_GAUGES> gauge_names{"staging_bytes"};
+constexpr std::array<const char*, NUM_LATENCIES> latency_names{"input_to_present"};
+
+/// Whether an exporter is running, the metrics aren't collected otherwise
+std::atomic_bool enabled{false};
+/// Host time in nanoseconds and counters of the current frame
+std::array<std::atomic<u64>, NUM_TIMES> frame_times{};
+std::array<std::atomic<u64>, NUM_GPU_TIMES> frame_gpu_times{};
+std::array<std::atomic<u64>, NUM_COUNTERS> frame_counters{};
+/// Current values of the gauges, always tracked so that the first exported frame is correct, and
+/// their peaks during the current frame
+std::array<std::atomic<u64>, NUM_GAUGES> gauge_values{};
+std::array<std::atomic<u64>, NUM_GAUGES> frame_gauge_peaks{};
+/// Latency samples in nanoseconds recorded during the current frame
+std::mutex latency_mutex;
+std::array<std::vector<u64>, NUM_LATENCIES> frame_latencies;
+/// Host time of the oldest input change no frame reflects yet, 0 if there is none
+std::atomic<std::chrono::steady_clock::rep> pending_input{0};
+
+/// The innermost timer of the calling thread
+thread_local ScopedTimer* current_timer = nullptr;
+} // Anonymous namespace
+
+void Add(Counter counter, u64 value) {
+    if (enabled.load(std::memory_order_relaxed)) {
+        frame_counters[static_cast<std::size_t>(counter)].fetch_add(value,
+                                                                    std::memory_order_relaxed);
+    }
+}
+
+void AddGPUTime(GPUTime category, u64 nanoseconds) {
+    if (enabled.load(std::memory_order_relaxed)) {
+        frame_gpu_times[static_cast<std::size_t>(category)].fetch_add(nanoseconds,
+                                                                      std::memory_order_relaxed);
+    }
+}
+
+void SetGauge(Gauge gauge, u64 value) {
+    const auto index = static_cast<std::size_t>(gauge);
+    gauge_values[index].store(value, std::memory_order_relaxed);
+    if (!enabled.load(std::memory_order_relaxed))
+        return;
+    auto& peak = frame_gauge_peaks[index];
+    u64 current = peak.load(std::memory_order_relaxed);
+    while (current < value &&
+           !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void AddLatency(Latency latency, std::chrono::nanoseconds duration) {
+    if (!enabled.load(std::memory_order_relaxed))
+        return;
+    std::lock_guard lock{latency_mutex};
+    frame_latencies[static_cast<std::size_t>(latency)].push_back(
+        static_cast<u64>(std::max<std::chrono::nanoseconds::rep>(duration.count(), 0)));
+}
+
+void MarkInput(std::chrono::steady_clock::time_point time) {
+    if (!enabled.load(std::memory_order_relaxed))
+        return;
+    std::chrono::steady_clock::rep none = 0;
+    pending_input.compare_exchange_strong(none, time.time_since_epoch().count(),
+                                          std::memory_order_relaxed);
+}
+
+std::optional<std::chrono::steady_clock::time_point> TakeInput() {
+    const auto time = pending_input.exchange(0, std::memory_order_relaxed);
+    if (time == 0)
+        return std::nullopt;
+    return std::chrono::steady_clock::time_point{std::chrono::steady_clock::duration{time}};
+}
+
+bool IsEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+ScopedTimer::ScopedTimer(Time category)
+    : category(category), active(enabled.load(std::memory_order_relaxed)) {
+    if (!active)
+        return;
+
+    start = Clock::now();
+    parent = current_timer;
+    current_timer = this;
+    // The time until now belongs to the parent, it continues when this timer ends
+    if (parent != nullptr && parent->active) {
+        frame_times[static_cast<std::size_t>(parent->category)].fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(start - parent->start).count(),
+            std::memory_order_relaxed);
+    }
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (!active)
+        return;
+
+    const Clock::time_point end = Clock::now();
+    frame_times[static_cast<std::size_t>(category)].fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+        std::memory_order_relaxed);
+    current_timer = parent;
+    if (parent != nullptr)
+        parent->start = end;
+}
+
+struct Exporter::Impl {
+    using Clock = std::chrono::steady_clock;
+
+    explicit Impl(u64 title_id);
+    ~Impl();
+
+    void EndFrame();
+    std::string FormatPrometheus();
+
+    u64 title_id;
+    FileUtil::IOFile file;
+    Clock::time_point frame_start = Clock::now();
+
+    std::mutex totals_mutex;
+    u64 frames = 0;
+    double last_frametime = 0.0;
+    std::array<double, NUM_TIMES> total_times{};
+    std::array<double, NUM_GPU_TIMES> total_gpu_times{};
+    std::array<u64, NUM_COUNTERS> total_counters{};
+    std::array<u64, NUM_GAUGES> max_gauges{};
+    std::array<std::deque<u64>, NUM_LATENCIES> recent_latencies;
+    std::array<u64, NUM_LATENCIES> latency_counts{};
+    std::array<double, NUM_LATENCIES> latency_sums{};
+
+#ifdef ENABLE_WEB_SERVICE
+    httplib::Server server;
+    std::thread server_thread;
+#endif
+};
+
+Exporter::Impl::Impl(u64 title_id) : title_id(title_id) {
+    if (!Settings::values.metrics_file.empty()) {
+        file = FileUtil::IOFile(Settings::values.metrics_file, "w");
+        if (file.IsOpen()) {
+            std::string header = "frame,frametime_ms";
+            for (const char* name : time_names) {
+                header += fmt::format(",{}_ms", name);
+            }
+            for (const char* name : gpu_time_names) {
+                header += fmt::format(",gpu_{}_ms", name);
+            }
+            for (const char* name : counter_names) {
+                header += fmt::format(",{}", name);
+            }
+            for (const char* name : gauge_names) {
+                header += fmt::format(",{}_peak", name);
+            }
+            for (const char* name : latency_names) {
+                header += fmt::format(",{}_max_ms", name);
+            }
+            file.WriteString(header + '\n');
+        } else {
+            LOG_ERROR(Core, "Could not open the metrics file {}", Settings::values.metrics_file);
+        }
+    }
+
+#ifdef ENABLE_WEB_SERVICE
+    if (Settings::values.metrics_port != 0) {
+        server.Get("/metrics", [this](const httplib::Request&, httplib::Response& response) {
+            response.set_content(FormatPrometheus(), "text/plain; version=0.0.4");
+        });
+        // Bind first, so that stopping the server can't race with it starting to listen
+        if (server.bind_to_port("0.0.0.0", Settings::values.metrics_port)) {
+            server_thread = std::thread([this] { server.listen_after_bind(); });
+            LOG_INFO(Core, "Serving metrics on port {}", Settings::values.metrics_port);
+        } else {
+            LOG_ERROR(Core, "Could not listen for metrics on port {}",
+                      Settings::values.metrics_port);
+        }
+    }
+#endif
+
+    for (auto& time : frame_times) {
+        time.store(0, std::memory_order_relaxed);
+    }
+    for (auto& time : frame_gpu_times) {
+        time.store(0, std::memory_order_relaxed);
+    }
+    for (auto& counter : frame_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < NUM_GAUGES; ++i) {
+        frame_gauge_peaks[i].store(gauge_values[i].load(std::memory_order_relaxed),
+                                   std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard lock{latency_mutex};
+        for (auto& latencies : frame_latencies) {
+            latencies.clear();
+        }
+    }
+    pending_input.store(0, std::memory_order_relaxed);
+    enabled = true;
+}
+
+Exporter::Impl::~Impl() {
+    enabled = false;
+#ifdef ENABLE_WEB_SERVICE
+    if (server_thread.joinable()) {
+        server.stop();
+        server_thread.join();
+    }
+#endif
+}
+
+void Exporter::Impl::EndFrame() {
+    const Clock::time_point now = Clock::now();
+    const double frametime = std::chrono::duration<double, std::milli>(now - frame_start).count();
+    frame_start = now;
+
+    std::array<double, NUM_TIMES> times;
+    for (std::size_t i = 0; i < NUM_TIMES; ++i) {
+        times[i] = frame_times[i].exchange(0, std::memory_order_relaxed) / 1'000'000.0;
+    }
+    std::array<double, NUM_GPU_TIMES> gpu_times;
+    for (std::size_t i = 0; i < NUM_GPU_TIMES; ++i) {
+        gpu_times[i] = frame_gpu_times[i].exchange(0, std::memory_order_relaxed) / 1'000'000.0;
+    }
+    std::array<u64, NUM_COUNTERS> counters;
+    for (std::size_t i = 0; i < NUM_COUNTERS; ++i) {
+        counters[i] = frame_counters[i].exchange(0, std::memory_order_relaxed);
+    }
+    // The peak of the next frame starts at the value the gauge is left at
+    std::array<u64, NUM_GAUGES> gauge_peaks;
+    for (std::size_t i = 0; i < NUM_GAUGES; ++i) {
+        gauge_peaks[i] = frame_gauge_peaks[i].exchange(
+            gauge_values[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    std::array<std::vector<u64>, NUM_LATENCIES> latencies;
+    {
+        std::lock_guard lock{latency_mutex};
+        latencies.swap(frame_latencies);
+    }
+
+    u64 frame;
+    {
+        std::lock_guard lock{totals_mutex};
+        frame = frames++;
+        last_frametime = frametime;
+        for (std::size_t i = 0; i < NUM_TIMES; ++i) {
+            total_times[i] += times[i];
+        }
+        for (std::size_t i = 0; i < NUM_GPU_TIMES; ++i) {
+            total_gpu_times[i] += gpu_times[i];
+        }
+        for (std::size_t i = 0; i < NUM_COUNTERS; ++i) {
+            total_counters[i] += counters[i];
+        }
+        for (std::size_t i = 0; i < NUM_GAUGES; ++i) {
+            max_gauges[i] = std::max(max_gauges[i], gauge_peaks[i]);
+        }
+        for (std::size_t i = 0; i < NUM_LATENCIES; ++i) {
+            auto& recent = recent_latencies[i];
+            for (u64 latency : latencies[i]) {
+                recent.push_back(latency);
+                latency_sums[i] += latency / 1'000'000'000.0;
+            }
+            while (recent.size() > LATENCY_WINDOW) {
+                recent.pop_front();
+            }
+            latency_counts[i] += latencies[i].size();
+        }
+    }
+
+    if (!file.IsOpen())
+        return;
+    std::string line = fmt::format("{},{:.3f}", frame, frametime);
+    for (double time : times) {
+        line += fmt::format(",{:.3f}", time);
+    }
+    for (double time : gpu_times) {
+        line += fmt::format(",{:.3f}", time);
+    }
+    for (u64 counter : counters) {
+        line += fmt::format(",{}", counter);
+    }
+    for (u64 peak : gauge_peaks) {
+        line += fmt::format(",{}", peak);
+    }
+    // Empty for the frames without a sample
+    for (const auto& samples : latencies) {
+        if (samples.empty()) {
+            line += ',';
+        } else {
+            line += fmt::format(",{:.3f}",
+                                *std::max_element(samples.begin(), samples.end()) / 1'000'000.0);
+        }
+    }
+    file.WriteString(line + '\n');
+    file.Flush();
+}
+
+std::string Exporter::Impl::FormatPrometheus() {
+    std::lock_guard lock{totals_mutex};
+
+    const std::string labels = fmt::format("title_id=\"{:016X}\"", title_id);
+    std::string out;
+    out += "# TYPE citra_frames_total counter\n";
+    out += fmt::format("citra_frames_total{{{}}} {}\n", labels, frames);
+    out += "# TYPE citra_frametime_seconds gauge\n";
+    out += fmt::format("citra_frametime_seconds{{{}}} {}\n", labels, last_frametime / 1000.0);
+    out += "# TYPE citra_host_time_seconds_total counter\n";
+    for (std::size_t i = 0; i < NUM_TIMES; ++i) {
+        out += fmt::format("citra_host_time_seconds_total{{{},category=\"{}\"}} {}\n", labels,
+                           time_names[i], total_times[i] / 1000.0);
+    }
+    out += "# TYPE citra_gpu_time_seconds_total counter\n";
+    for (std::size_t i = 0; i < NUM_GPU_TIMES; ++i) {
+        out += fmt::format("citra_gpu_time_seconds_total{{{},pass=\"{}\"}} {}\n", labels,
+                           gpu_time_names[i], total_gpu_times[i] / 1000.0);
+    }
+    for (std::size_t i = 0; i < NUM_COUNTERS; ++i) {
+        out += fmt::format("# TYPE citra_{}_total counter\n", counter_names[i]);
+        out += fmt::format("citra_{}_total{{{}}} {}\n", counter_names[i], labels,
+                           total_counters[i]);
+    }
+    for (std::size_t i = 0; i < NUM_GAUGES; ++i) {
+        out += fmt::format("# TYPE citra_{}_peak gauge\n", gauge_names[i]);
+        out += fmt::format("citra_{}_peak{{{}}} {}\n", gauge_names[i], labels, max_gauges[i]);
+    }
+    for (std::size_t i = 0; i < NUM_LATENCIES; ++i) {
+        // The quantiles are those of the most recent samples, as in a client side summary
+        std::vector<u64> sorted(recent_latencies[i].begin(), recent_latencies[i].end());
+        std::sort(sorted.begin(), sorted.end());
+        out += fmt::format("# TYPE citra_{}_seconds summary\n", latency_names[i]);
+        if (!sorted.empty()) {
+            for (double quantile : latency_quantiles) {
+                const auto index = static_cast<std::size_t>(quantile * (sorted.size() - 1));
+                out += fmt::format("citra_{}_seconds{{{},quantile=\"{}\"}} {}\n", latency_names[i],
+                                   labels, quantile, sorted[index] / 1'000'000'000.0);
+            }
+        }
+        out += fmt::format("citra_{}_seconds_sum{{{}}} {}\n", latency_names[i], labels,
+                           latency_sums[i]);
+        out += fmt::format("citra_{}_seconds_count{{{}}} {}\n", latency_names[i], labels,
+                           latency_counts[i]);
+    }
+    return out;
+}
+
+Exporter::Exporter(u64 title_id) : impl(std::make_unique<Impl>(title_id)) {}
+
+Exporter::~Exporter() = default;
+
+void Exporter::EndFrame() {
+    impl->EndFrame();
+}
+
+} // namespace Core::Metrics
@@ -0,0 +1,130 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include "common/common_types.h"
+
+namespace Core::Metrics {
+
+/// Where the host time of a frame is spent
+enum class Time : std::size_t {
+    ARM, ///< Running the emulated CPU cores
+    HLE, ///< Kernel and service calls
+    GPU, ///< Processing PICA commands and presenting
+    DSP, ///< Audio processing
+    Count,
+};
+
+/// Where the GPU time of a frame is spent, as measured by the renderer with timer queries
+enum class GPUTime : std::size_t {
+    Draw,          ///< Emulated draw calls
+    Upload,        ///< Loading surfaces from emulated memory
+    Download,      ///< Writing surfaces back to emulated memory
+    TextureFilter, ///< Scaling textures with the texture filters
+    Present,       ///< Drawing the screens to the window
+    Count,
+};
+
+/// Events counted per frame
+enum class Counter : std::size_t {
+    DrawCalls,
+    ShaderCompiles,
+    SurfaceCacheHits,
+    SurfaceCacheMisses,
+    TextureUploads,
+    BytesFlushed,
+    RasterizerOpsMerged,
+    FragmentConfigs,
+    ThreadSwitches,
+    Count,
+};
+
+/// Sizes that are set whenever they change, the highest value during a frame is exported
+enum class Gauge : std::size_t {
+    StagingBytes, ///< Host memory held by the staging pool of the surfaces
+    Count,
+};
+
+/// Latencies measured on the host, exported as percentiles of the recent samples
+enum class Latency : std::size_t {
+    InputToPresent, ///< From a change of the input to the presentation of the next frame
+    Count,
+};
+
+/// Adds to one of the per-frame counters. Thread-safe, and a no-op while no exporter is running.
+void Add(Counter counter, u64 value = 1);
+
+/**
+ * Adds GPU time in nanoseconds to a category. GPU times are only known a few frames after the
+ * work was submitted, so they are exported with the frame in which they were read back.
+ */
+void AddGPUTime(GPUTime category, u64 nanoseconds);
+
+/// Sets the current value of a gauge. Thread-safe, and only tracks the peak while exporting.
+void SetGauge(Gauge gauge, u64 value);
+
+/// Records a latency sample. Thread-safe, and a no-op while no exporter is running.
+void AddLatency(Latency latency, std::chrono::nanoseconds duration);
+
+/**
+ * Marks the host time at which the input thread saw an input change that HID wrote to the shared
+ * memory. The oldest change that no frame reflects yet is kept.
+ */
+void MarkInput(std::chrono::steady_clock::time_point time);
+
+/**
+ * Takes the time of the oldest input change no frame reflects yet, called when rendering the frame
+ * the guest drew after reading it.
+ */
+std::optional<std::chrono::steady_clock::time_point> TakeInput();
+
+/// Returns whether an exporter is running
+bool IsEnabled();
+
+/**
+ * Measures the host time spent in a category until it is destroyed. The time of a timer nested in
+ * another one on the same thread is only counted to the nested category, so the categories don't
+ * overlap. Timers on different threads run in parallel and are both counted.
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Time category);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    ScopedTimer* parent = nullptr;
+    Time category;
+    Clock::time_point start;
+    bool active;
+};
+
+/**
+ * Collects the metrics at the end of every system frame and exports them, as a CSV line per frame
+ * to the metrics file and as cumulative counters in the Prometheus text format, served over HTTP on
+ * the metrics port when the web service is enabled.
+ */
+class Exporter {
+public:
+    explicit Exporter(u64 title_id);
+    ~Exporter();
+
+    /// Ends the current system frame, called from the emulation thread
+    void EndFrame();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace Core::Metrics
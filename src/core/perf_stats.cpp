@@ -15,6 +15,13 @@
 #include "core/perf_stats.h"
 #include "core/settings.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#endif
+
 using namespace std::chrono_literals;
 using DoubleSecs = std::chrono::duration<double, std::chrono::seconds::period>;
 using std::chrono::duration_cast;
@@ -26,6 +33,55 @@ constexpr std::size_t IgnoreFrames = 5;
 
 namespace Core {
 
+#ifdef _WIN32
+/// A waitable timer that wakes up within a fraction of a millisecond, on Windows 10 1803 and later
+struct HighResolutionTimer {
+    HANDLE handle = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                           TIMER_ALL_ACCESS);
+    ~HighResolutionTimer() {
+        if (handle != nullptr)
+            CloseHandle(handle);
+    }
+};
+#endif
+
+/**
+ * Sleeps until the deadline. Sleeps of the OS overshoot by up to a few milliseconds, so the last
+ * stretch before the deadline is spun on the clock instead.
+ */
+static void SleepUntil(FrameLimiter::Clock::time_point deadline) {
+    using Clock = FrameLimiter::Clock;
+#ifdef _WIN32
+    static thread_local HighResolutionTimer timer;
+    // Without the high resolution timer a sleep only ends on a tick of the scheduler
+    const Clock::duration spin_margin = timer.handle != nullptr ? 1ms : 2ms;
+#else
+    constexpr Clock::duration spin_margin = 1ms;
+#endif
+
+    const Clock::duration sleep_time = deadline - Clock::now() - spin_margin;
+    if (sleep_time > Clock::duration::zero()) {
+#ifdef _WIN32
+        LARGE_INTEGER due_time;
+        // Negative times are relative, in units of 100 nanoseconds
+        due_time.QuadPart = -std::max<LONGLONG>(
+            duration_cast<std::chrono::nanoseconds>(sleep_time).count() / 100, 1);
+        if (timer.handle != nullptr &&
+            SetWaitableTimerEx(timer.handle, &due_time, 0, nullptr, nullptr, nullptr, 0)) {
+            WaitForSingleObject(timer.handle, INFINITE);
+        } else {
+            std::this_thread::sleep_for(sleep_time);
+        }
+#else
+        std::this_thread::sleep_for(sleep_time);
+#endif
+    }
+
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
 PerfStats::PerfStats(u64 title_id) : title_id(title_id) {}
 
 PerfStats::~PerfStats() {
@@ -84,6 +140,15 @@ double PerfStats::GetMeanFrametime() {
     return sum / (current_index - IgnoreFrames);
 }
 
+std::vector<double> PerfStats::GetFrametimes() {
+    std::lock_guard lock{object_mutex};
+
+    if (current_index <= IgnoreFrames) {
+        return {};
+    }
+    return {perf_history.begin() + IgnoreFrames, perf_history.begin() + current_index};
+}
+
 PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_us) {
     std::lock_guard lock(object_mutex);
 
@@ -125,36 +190,91 @@ void FrameLimiter::DoFrameLimiting(microseconds current_system_time_us) {
         return;
     }
 
-    if (!Settings::values.use_frame_limit) {
+    if (!Settings::values.use_frame_limit || Settings::values.turbo_mode) {
         return;
     }
 
     auto now = Clock::now();
+    // Frames are released right before the limiter, so this is what the emulation needed for it
+    const Clock::duration frame_work = now - previous_walltime;
     double sleep_scale = Settings::values.frame_limit / 100.0;
 
     // Max lag caused by slow frames. Shouldn't be more than the length of a frame at the current
     // speed percent or it will clamp too much and prevent this from properly limiting to that
     // percent. High values means it'll take longer after a slow frame to recover and start limiting
-    const microseconds max_lag_time_us = duration_cast<microseconds>(
-        std::chrono::duration<double, std::chrono::microseconds::period>(25ms / sleep_scale));
-    frame_limiting_delta_err += duration_cast<microseconds>(
-        std::chrono::duration<double, std::chrono::microseconds::period>(
+    const Clock::duration max_lag_time = duration_cast<Clock::duration>(
+        std::chrono::duration<double, Clock::period>(25ms / sleep_scale));
+    frame_limiting_delta_err += duration_cast<Clock::duration>(
+        std::chrono::duration<double, Clock::period>(
             (current_system_time_us - previous_system_time_us) / sleep_scale));
-    frame_limiting_delta_err -= duration_cast<microseconds>(now - previous_walltime);
-    frame_limiting_delta_err =
-        std::clamp(frame_limiting_delta_err, -max_lag_time_us, max_lag_time_us);
+    frame_limiting_delta_err -= now - previous_walltime;
+    frame_limiting_delta_err = std::clamp(frame_limiting_delta_err, -max_lag_time, max_lag_time);
 
-    if (frame_limiting_delta_err > microseconds::zero()) {
-        std::this_thread::sleep_for(frame_limiting_delta_err);
+    if (frame_limiting_delta_err > Clock::duration::zero()) {
+        // The deadline is where emulated time catches up with walltime
+        SleepUntil(now + frame_limiting_delta_err);
         auto now_after_sleep = Clock::now();
-        frame_limiting_delta_err -= duration_cast<microseconds>(now_after_sleep - now);
+        frame_limiting_delta_err -= now_after_sleep - now;
         now = now_after_sleep;
     }
 
+    // The extra delay is accounted as walltime of the next frame, which keeps the average speed
+    if (Settings::values.low_latency_presentation) {
+        WaitForPresentDeadline(frame_work, now);
+    }
+
     previous_system_time_us = current_system_time_us;
     previous_walltime = now;
 }
 
+bool FrameLimiter::IsBehind() const {
+    // Keeps the frame skip from kicking in for the jitter of frames that are on time
+    constexpr microseconds BEHIND_THRESHOLD = 2ms;
+    return Settings::values.use_frame_limit && frame_limiting_delta_err < -BEHIND_THRESHOLD;
+}
+
+void FrameLimiter::WaitForPresentDeadline(Clock::duration frame_work, Clock::time_point& now) {
+    frame_work_estimate += (frame_work - frame_work_estimate) / 8;
+
+    const Clock::duration interval{present_interval.load(std::memory_order_relaxed)};
+    const Clock::time_point last_present{Clock::duration{last_present_time.load()}};
+    if (interval == Clock::duration::zero() || now - last_present > 1s) {
+        return;
+    }
+
+    // Leaves room for frames that take longer than the estimate and for the present itself
+    constexpr Clock::duration PRESENT_MARGIN = 2ms;
+    const Clock::duration lead = frame_work_estimate + PRESENT_MARGIN;
+    if (lead >= interval) {
+        return;
+    }
+
+    // Start the frame at the latest point that still makes the first present after it
+    Clock::time_point start = last_present + interval - lead;
+    if (start < now) {
+        start += ((now - start) / interval + 1) * interval;
+    }
+    SleepUntil(start);
+    now = Clock::now();
+}
+
+void FrameLimiter::OnFramePresented() {
+    // Presents that find no new frame also wait for one, so the shortest interval of a window is
+    // taken as the refresh interval. Presents are timed when they start because the graphics APIs
+    // don't expose the vblank timestamps portably.
+    constexpr u32 PRESENT_WINDOW = 64;
+    const Clock::time_point now = Clock::now();
+    shortest_present_interval = std::min(shortest_present_interval, now - previous_present);
+    previous_present = now;
+    last_present_time.store(now.time_since_epoch().count());
+
+    if (++window_presents == PRESENT_WINDOW) {
+        present_interval.store(shortest_present_interval.count(), std::memory_order_relaxed);
+        shortest_present_interval = Clock::duration::max();
+        window_presents = 0;
+    }
+}
+
 void FrameLimiter::SetFrameAdvancing(bool value) {
     const bool was_enabled = frame_advancing_enabled.exchange(value);
     if (was_enabled && !value) {
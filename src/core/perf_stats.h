@@ -9,6 +9,7 @@
 #include <chrono>
 #include <cstddef>
 #include <mutex>
+#include <vector>
 #include "common/common_types.h"
 #include "common/thread.h"
 
@@ -48,6 +49,9 @@ public:
      */
     double GetMeanFrametime();
 
+    /// Returns the frametime values stored in the performance history, in milliseconds
+    std::vector<double> GetFrametimes();
+
     /**
      * Gets the ratio between walltime and the emulated time of the previous system frame. This is
      * useful for scaling inputs or outputs moving between the two time domains.
@@ -99,20 +103,50 @@ public:
     void SetFrameAdvancing(bool value);
     void AdvanceFrame();
 
+    /**
+     * Records that the frontend is about to present a frame. With vsync the presents follow the
+     * refresh of the display, which the low latency presentation aligns the emulated frames to.
+     * Called from the presentation thread.
+     */
+    void OnFramePresented();
+
+    /// Returns whether the emulation has fallen behind the speed limit by more than a few ms
+    bool IsBehind() const;
+
 private:
+    /**
+     * Delays the start of the next frame so that it is released shortly before the next present,
+     * instead of waiting in the mailbox for most of a refresh interval.
+     */
+    void WaitForPresentDeadline(Clock::duration frame_work, Clock::time_point& now);
+
     /// Emulated system time (in microseconds) at the last limiter invocation
     std::chrono::microseconds previous_system_time_us{0};
     /// Walltime at the last limiter invocation
     Clock::time_point previous_walltime = Clock::now();
 
-    /// Accumulated difference between walltime and emulated time
-    std::chrono::microseconds frame_limiting_delta_err{0};
+    /// Accumulated difference between walltime and emulated time, kept at the clock's resolution
+    /// so that rounding doesn't drift over many frames
+    Clock::duration frame_limiting_delta_err{0};
 
     /// Whether to use frame advancing (i.e. frame by frame)
     std::atomic_bool frame_advancing_enabled;
 
     /// Event to advance the frame when frame advancing is enabled
     Common::Event frame_advance_event;
+
+    /// Estimated walltime the emulation needs from the start of a frame until it is released
+    Clock::duration frame_work_estimate = Clock::duration::zero();
+
+    // Only used by the presentation thread
+    Clock::time_point previous_present = Clock::now();
+    Clock::duration shortest_present_interval = Clock::duration::max();
+    u32 window_presents = 0;
+
+    /// Time since the clock epoch of the last present
+    std::atomic<Clock::rep> last_present_time{0};
+    /// Estimated refresh interval of the display, zero until it is known
+    std::atomic<Clock::rep> present_interval{0};
 };
 
 } // namespace Core
@@ -0,0 +1,363 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <fmt/format.h>
+#include <nihstro/inline_assembly.h>
+#include "audio_core/audio_types.h"
+#include "audio_core/codec.h"
+#include "audio_core/hle/mix_kernels.h"
+#include "audio_core/interpolate.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "core/hw/gpu.h"
+#include "core/perf_tuner.h"
+#include "core/settings.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/shader/shader_jit_x64.h"
+#endif
+
+namespace Core {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Section = std::map<std::string, std::string>;
+using Sections = std::map<std::string, Section>;
+
+constexpr const char DEVICE_SECTION[] = "device";
+
+/// Vertex batches shaded per timed run of a shader engine
+constexpr std::size_t SHADER_BATCHES = 64;
+constexpr std::size_t SHADER_BATCH_SIZE = 256;
+/// Timed runs of each workload, the fastest one is kept to filter out preemptions
+constexpr int CALIBRATION_RUNS = 5;
+
+/// Voices an application keeps playing at once, most titles stay below
+constexpr std::size_t DSP_VOICES = 24;
+/**
+ * Highest load of the HLE audio pipeline at which the LLE DSP is recommended. Interpreting the DSP
+ * firmware takes a few hundred times the work of the HLE pipeline, which only leaves enough time
+ * for the rest of the emulation on hosts with fast cores.
+ */
+constexpr double LLE_MAX_HLE_LOAD = 0.002;
+/// Host threads needed for the LLE DSP to get a thread of its own
+constexpr unsigned LLE_MULTITHREAD_MIN_THREADS = 4;
+
+/// Frames a session needs before its frame times are used, about ten seconds
+constexpr std::size_t MIN_SESSION_FRAMES = 600;
+/// Fraction of frames that may miss the frame budget before the title is considered too slow
+constexpr double SLOW_FRAME_PERCENTILE = 0.9;
+/// Share of the frame budget the slow frames stay below for the settings to be raised again
+constexpr double HEADROOM_FRACTION = 0.5;
+
+std::string GetProfilePath() {
+    return FileUtil::GetUserPath(FileUtil::UserPath::ConfigDir) + "perf_profile.ini";
+}
+
+Sections LoadProfiles() {
+    Sections sections;
+    std::string text;
+    if (FileUtil::ReadFileToString(true, GetProfilePath(), text) == 0)
+        return sections;
+
+    std::istringstream stream(text);
+    Section* section = nullptr;
+    std::string line;
+    while (std::getline(stream, line)) {
+        line = Common::StripSpaces(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+        if (line.front() == '[' && line.back() == ']') {
+            section = &sections[line.substr(1, line.size() - 2)];
+            continue;
+        }
+        const std::size_t separator = line.find('=');
+        if (section != nullptr && separator != std::string::npos) {
+            (*section)[Common::StripSpaces(line.substr(0, separator))] =
+                Common::StripSpaces(line.substr(separator + 1));
+        }
+    }
+    return sections;
+}
+
+void SaveProfiles(const Sections& sections) {
+    std::string text = "# Written by the performance tuner, delete this file to recalibrate\n";
+    for (const auto& [name, section] : sections) {
+        text += fmt::format("\n[{}]\n", name);
+        for (const auto& [key, value] : section) {
+            text += fmt::format("{} = {}\n", key, value);
+        }
+    }
+    if (FileUtil::WriteStringToFile(true, GetProfilePath(), text) != text.size())
+        LOG_ERROR(Core, "Could not write the performance profiles to {}", GetProfilePath());
+}
+
+template <typename T>
+void ReadValue(const Section& section, const char* key, T& value) {
+    const auto it = section.find(key);
+    if (it == section.end())
+        return;
+    if constexpr (std::is_same_v<T, std::string>) {
+        value = it->second;
+    } else {
+        value = static_cast<T>(std::strtoul(it->second.c_str(), nullptr, 10));
+    }
+}
+
+std::string GetTitleSection(u64 title_id) {
+    return fmt::format("{:016X}", title_id);
+}
+
+/// Transforms a vertex by a 4x4 matrix and computes a few lighting terms, like common titles do
+std::unique_ptr<Pica::Shader::ShaderSetup> MakeVertexShader() {
+    using nihstro::DestRegister;
+    using nihstro::OpCode;
+    using nihstro::SourceRegister;
+
+    const auto position = SourceRegister::MakeInput(0);
+    const auto normal = SourceRegister::MakeInput(1);
+    const auto temp0 = SourceRegister::MakeTemporary(0);
+    const auto temp1 = SourceRegister::MakeTemporary(1);
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary({
+        // clang-format off
+        {OpCode::Id::DP4, DestRegister::MakeOutput(0), position, SourceRegister::MakeInput(2)},
+        {OpCode::Id::DP4, DestRegister::MakeTemporary(0), position, SourceRegister::MakeInput(3)},
+        {OpCode::Id::DP3, DestRegister::MakeTemporary(1), normal, SourceRegister::MakeInput(4)},
+        {OpCode::Id::MUL, DestRegister::MakeTemporary(0), temp0, temp1},
+        {OpCode::Id::MAX, DestRegister::MakeTemporary(1), temp1, temp0},
+        {OpCode::Id::RSQ, DestRegister::MakeTemporary(0), temp1},
+        {OpCode::Id::ADD, DestRegister::MakeOutput(1), temp0, normal},
+        {OpCode::Id::EX2, DestRegister::MakeOutput(2), temp1},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    auto setup = std::make_unique<Pica::Shader::ShaderSetup>();
+    std::transform(shbin.program.begin(), shbin.program.end(), setup->program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                   setup->swizzle_data.begin(), [](const auto& x) { return x.hex; });
+    return setup;
+}
+
+/// Returns the microseconds the fastest run of the engine took to shade the vertex batches
+double TimeShaderEngine(Pica::Shader::ShaderEngine& engine) {
+    using Pica::float24;
+
+    auto setup = MakeVertexShader();
+    engine.SetupBatch(*setup, 0);
+
+    std::vector<Pica::Shader::UnitState> units(SHADER_BATCH_SIZE);
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        for (std::size_t reg = 0; reg < 5; ++reg) {
+            units[i].registers.input[reg] = Common::MakeVec(
+                float24::FromFloat32(i * 0.25f + reg), float24::FromFloat32(1.5f - reg),
+                float24::FromFloat32(i * -0.125f), float24::FromFloat32(1.0f));
+        }
+    }
+
+    // The first batch compiles the program in the JIT
+    engine.RunBatch(*setup, units.data(), units.size());
+    Clock::duration fastest = Clock::duration::max();
+    for (int run = 0; run < CALIBRATION_RUNS; ++run) {
+        const Clock::time_point start = Clock::now();
+        for (std::size_t batch = 0; batch < SHADER_BATCHES; ++batch) {
+            engine.RunBatch(*setup, units.data(), units.size());
+        }
+        fastest = std::min(fastest, Clock::now() - start);
+    }
+    return std::chrono::duration<double, std::micro>(fastest).count();
+}
+
+/// Returns the share of real time decoding, resampling and mixing the voices takes
+double TimeAudioPipeline() {
+    using namespace AudioCore;
+
+    // An emulated second of audio frames
+    constexpr std::size_t FRAMES = native_sample_rate / samples_per_frame;
+    constexpr std::size_t ADPCM_FRAME_BYTES = (samples_per_frame + 13) / 14 * 8;
+
+    std::vector<u8> adpcm(ADPCM_FRAME_BYTES * DSP_VOICES);
+    u32 seed = 0x12345678;
+    for (u8& byte : adpcm) {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<u8>(seed >> 16);
+    }
+    std::array<s16, 16> coeffs;
+    for (std::size_t i = 0; i < coeffs.size(); ++i) {
+        coeffs[i] = static_cast<s16>(i % 2 == 0 ? 0x800 - i * 64 : -0x400 + i * 32);
+    }
+    const std::array<float, 4> gains{0.75f, 0.5f, 0.25f, 1.0f};
+
+    std::array<Codec::ADPCMState, DSP_VOICES> adpcm_states{};
+    std::array<AudioInterp::State, DSP_VOICES> interp_states{};
+    StereoBuffer16 decoded;
+    StereoFrame16 voice_frame;
+    std::array<QuadFrame32, 3> mixes;
+    StereoFrame16 output;
+
+    Clock::duration fastest = Clock::duration::max();
+    for (int run = 0; run < CALIBRATION_RUNS; ++run) {
+        const Clock::time_point start = Clock::now();
+        for (std::size_t frame = 0; frame < FRAMES; ++frame) {
+            mixes = {};
+            for (std::size_t voice = 0; voice < DSP_VOICES; ++voice) {
+                Codec::DecodeADPCM(&adpcm[voice * ADPCM_FRAME_BYTES], samples_per_frame, coeffs,
+                                   adpcm_states[voice], decoded);
+                std::size_t outputi = 0;
+                AudioInterp::Linear(interp_states[voice], decoded, 1.0f, voice_frame, outputi);
+                for (QuadFrame32& mix : mixes) {
+                    HLE::MixIntoQuadFrame(mix, voice_frame, gains);
+                }
+            }
+            output = {};
+            for (const QuadFrame32& mix : mixes) {
+                HLE::DownmixStereoAndAdd(output, mix, 0.5f);
+            }
+        }
+        fastest = std::min(fastest, Clock::now() - start);
+    }
+    return std::chrono::duration<double>(fastest).count();
+}
+
+} // Anonymous namespace
+
+PerfTuner::PerfTuner(u64 title_id) : title_id(title_id), user_values(GetValues()) {
+    Sections sections = LoadProfiles();
+    Section& device = sections[DEVICE_SECTION];
+    if (device.empty()) {
+        const Calibration calibration = Calibrate();
+        LOG_INFO(Core,
+                 "Calibrated the performance profile: shader interpreter {:.0f} us, JIT {:.0f} us, "
+                 "HLE audio load {:.3f}%",
+                 calibration.shader_interpreter_us, calibration.shader_jit_us,
+                 calibration.dsp_load * 100.0);
+
+        const bool use_jit = calibration.shader_jit_us > 0.0 &&
+                             calibration.shader_jit_us < calibration.shader_interpreter_us;
+        const bool use_lle = calibration.dsp_load < LLE_MAX_HLE_LOAD;
+        device["use_shader_jit"] = use_jit ? "1" : "0";
+        // Loading the shaders from disk is faster than compiling them on every host
+        device["use_disk_shader_cache"] = "1";
+        device["enable_dsp_lle"] = use_lle ? "1" : "0";
+        device["enable_dsp_lle_multithread"] =
+            use_lle && std::thread::hardware_concurrency() >= LLE_MULTITHREAD_MIN_THREADS ? "1"
+                                                                                          : "0";
+        SaveProfiles(sections);
+    }
+
+    TunedValues tuned = user_values;
+    ReadValue(device, "use_shader_jit", tuned.use_shader_jit);
+    ReadValue(device, "use_disk_shader_cache", tuned.use_disk_shader_cache);
+    ReadValue(device, "enable_dsp_lle", tuned.enable_dsp_lle);
+    ReadValue(device, "enable_dsp_lle_multithread", tuned.enable_dsp_lle_multithread);
+
+    const auto title = sections.find(GetTitleSection(title_id));
+    if (title_id != 0 && title != sections.end()) {
+        ReadValue(title->second, "resolution_factor", tuned.resolution_factor);
+        ReadValue(title->second, "texture_filter_name", tuned.texture_filter_name);
+    }
+
+    LOG_INFO(Core,
+             "Tuned settings: shader JIT {}, disk shader cache {}, LLE DSP {}{}, resolution "
+             "factor {}, texture filter {}",
+             tuned.use_shader_jit, tuned.use_disk_shader_cache, tuned.enable_dsp_lle,
+             tuned.enable_dsp_lle_multithread ? " multithreaded" : "", tuned.resolution_factor,
+             tuned.texture_filter_name);
+    applied_values = tuned;
+    SetValues(tuned);
+}
+
+PerfTuner::~PerfTuner() {
+    SetValues(user_values);
+}
+
+void PerfTuner::RecordSession(const std::vector<double>& frametimes) {
+    if (title_id == 0 || frametimes.size() < MIN_SESSION_FRAMES)
+        return;
+
+    std::vector<double> sorted = frametimes;
+    const auto slow_frame = sorted.begin() + static_cast<std::ptrdiff_t>(
+                                                 (sorted.size() - 1) * SLOW_FRAME_PERCENTILE);
+    std::nth_element(sorted.begin(), slow_frame, sorted.end());
+    const double budget_ms = 1000.0 / GPU::SCREEN_REFRESH_RATE;
+
+    u16 resolution_factor = applied_values.resolution_factor;
+    std::string texture_filter_name = applied_values.texture_filter_name;
+    if (*slow_frame > budget_ms) {
+        if (texture_filter_name != "none") {
+            texture_filter_name = "none";
+        } else if (resolution_factor > 1) {
+            --resolution_factor;
+        }
+    } else if (*slow_frame < budget_ms * HEADROOM_FRACTION) {
+        // Raise the settings back towards the user's, the resolution first. A factor of 0 scales
+        // to the window and is never lowered, so it has no steps to take.
+        if (resolution_factor != 0 && resolution_factor < user_values.resolution_factor) {
+            ++resolution_factor;
+        } else if (resolution_factor == user_values.resolution_factor) {
+            texture_filter_name = user_values.texture_filter_name;
+        }
+    }
+    if (resolution_factor == applied_values.resolution_factor &&
+        texture_filter_name == applied_values.texture_filter_name)
+        return;
+
+    LOG_INFO(Core,
+             "{:.1f} ms frame time at the {:.0f}th percentile, using resolution factor {} and "
+             "texture filter {} on the next boot",
+             *slow_frame, SLOW_FRAME_PERCENTILE * 100, resolution_factor, texture_filter_name);
+    Sections sections = LoadProfiles();
+    Section& title = sections[GetTitleSection(title_id)];
+    title["resolution_factor"] = std::to_string(resolution_factor);
+    title["texture_filter_name"] = texture_filter_name;
+    SaveProfiles(sections);
+}
+
+PerfTuner::Calibration PerfTuner::Calibrate() {
+    Calibration calibration{};
+    Pica::Shader::InterpreterEngine interpreter;
+    calibration.shader_interpreter_us = TimeShaderEngine(interpreter);
+#ifdef ARCHITECTURE_x86_64
+    Pica::Shader::JitX64Engine jit;
+    calibration.shader_jit_us = TimeShaderEngine(jit);
+#endif
+    calibration.dsp_load = TimeAudioPipeline();
+    return calibration;
+}
+
+PerfTuner::TunedValues PerfTuner::GetValues() {
+    const auto& values = Settings::values;
+    return {values.use_shader_jit,
+            values.use_disk_shader_cache,
+            values.enable_dsp_lle,
+            values.enable_dsp_lle_multithread,
+            values.resolution_factor,
+            values.texture_filter_name};
+}
+
+void PerfTuner::SetValues(const TunedValues& tuned) {
+    auto& values = Settings::values;
+    values.use_shader_jit = tuned.use_shader_jit;
+    values.use_disk_shader_cache = tuned.use_disk_shader_cache;
+    values.enable_dsp_lle = tuned.enable_dsp_lle;
+    values.enable_dsp_lle_multithread = tuned.enable_dsp_lle_multithread;
+    values.resolution_factor = tuned.resolution_factor;
+    values.texture_filter_name = tuned.texture_filter_name;
+    Settings::Apply();
+}
+
+} // namespace Core
@@ -0,0 +1,64 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Chooses the performance settings for the host while Settings::values.use_auto_tuning is on.
+ *
+ * The first boot on a device runs a short calibration, the vertex shader interpreter against the
+ * JIT and the HLE audio pipeline, which picks the shader engine and whether the DSP is emulated at
+ * a low level for the device. The GPU bound settings depend on the title instead, so the frame
+ * times PerfStats recorded while it ran adjust its resolution and texture filter for the next
+ * boot.
+ *
+ * The profiles are stored in perf_profile.ini in the config directory. The user's settings are
+ * restored when emulation stops, so that the frontends never save the tuned values.
+ */
+class PerfTuner : NonCopyable {
+public:
+    /// Host time the calibration workloads took
+    struct Calibration {
+        double shader_interpreter_us; ///< Shading the vertex batches with the interpreter
+        double shader_jit_us;         ///< The same with the JIT, 0 if the host has none
+        double dsp_load;              ///< Share of real time the HLE audio of 24 voices needs
+    };
+
+    /// Applies the profile of the device, calibrating it first if there is none, and the title's
+    explicit PerfTuner(u64 title_id);
+    /// Restores the user's settings
+    ~PerfTuner();
+
+    /// Adjusts the settings of the title from the frame times of the session, in milliseconds
+    void RecordSession(const std::vector<double>& frametimes);
+
+    /// Runs the calibration workloads, which takes well under a second
+    static Calibration Calibrate();
+
+private:
+    /// The settings the tuner may change
+    struct TunedValues {
+        bool use_shader_jit;
+        bool use_disk_shader_cache;
+        bool enable_dsp_lle;
+        bool enable_dsp_lle_multithread;
+        u16 resolution_factor;
+        std::string texture_filter_name;
+    };
+
+    static TunedValues GetValues();
+    static void SetValues(const TunedValues& tuned);
+
+    u64 title_id;
+    TunedValues user_values;
+    TunedValues applied_values;
+};
+
+} // namespace Core
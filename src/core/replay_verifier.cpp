@@ -0,0 +1,109 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <fstream>
+#include <fmt/format.h>
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/hw/gpu.h"
+#include "core/memory.h"
+#include "core/replay_verifier.h"
+
+namespace Core {
+
+namespace {
+u64 HashScreen(Memory::MemorySystem& memory, const GPU::Regs::FramebufferConfig& framebuffer) {
+    const PAddr address =
+        framebuffer.second_fb_active ? framebuffer.address_left2 : framebuffer.address_left1;
+    const u32 size = framebuffer.stride * framebuffer.height;
+    if (address == 0 || size == 0)
+        return 0;
+
+    // The hardware renderer may still hold the frame
+    Memory::RasterizerFlushRegion(address, size);
+    const u8* const data = memory.GetPhysicalPointer(address);
+    return data != nullptr ? Common::ComputeHash64(data, size) : 0;
+}
+} // Anonymous namespace
+
+bool ReplayVerifier::Checkpoint::operator==(const Checkpoint& other) const {
+    return frame == other.frame && fcram_hash == other.fcram_hash &&
+           top_screen_hash == other.top_screen_hash &&
+           bottom_screen_hash == other.bottom_screen_hash;
+}
+
+ReplayVerifier::ReplayVerifier(System& system, const std::string& output_file,
+                               const std::string& reference_file, u32 interval)
+    : system(system), interval(interval) {
+    if (!output_file.empty()) {
+        output.Open(output_file, "w");
+        if (!output.IsOpen()) {
+            LOG_ERROR(Core, "Could not open the replay hash file {}", output_file);
+        }
+    }
+    if (!reference_file.empty() && !LoadCheckpoints(reference_file, reference)) {
+        LOG_ERROR(Core, "Could not read the reference replay hashes from {}", reference_file);
+    }
+}
+
+ReplayVerifier::~ReplayVerifier() = default;
+
+void ReplayVerifier::EndFrame() {
+    ++frame;
+    if (interval == 0 || frame % interval != 0 || divergence)
+        return;
+
+    const Checkpoint checkpoint = TakeCheckpoint();
+    ++num_checkpoints;
+    if (output.IsOpen()) {
+        output.WriteString(fmt::format("{} {:016x} {:016x} {:016x}\n", checkpoint.frame,
+                                       checkpoint.fcram_hash, checkpoint.top_screen_hash,
+                                       checkpoint.bottom_screen_hash));
+    }
+
+    // The reference run may have used a different interval, only matching frames are compared
+    while (reference_position < reference.size() &&
+           reference[reference_position].frame < checkpoint.frame) {
+        ++reference_position;
+    }
+    if (reference_position < reference.size() &&
+        reference[reference_position].frame == checkpoint.frame) {
+        if (reference[reference_position++] != checkpoint) {
+            divergence = checkpoint;
+            LOG_ERROR(Core, "Replay diverged from the reference at frame {}", checkpoint.frame);
+        }
+    }
+}
+
+bool ReplayVerifier::LoadCheckpoints(const std::string& filename,
+                                     std::vector<Checkpoint>& checkpoints) {
+    std::ifstream file;
+    OpenFStream(file, filename, std::ios_base::in);
+    if (!file)
+        return false;
+
+    Checkpoint checkpoint;
+    while (file >> std::dec >> checkpoint.frame >> std::hex >> checkpoint.fcram_hash >>
+           checkpoint.top_screen_hash >> checkpoint.bottom_screen_hash) {
+        checkpoints.push_back(checkpoint);
+    }
+    return file.eof();
+}
+
+ReplayVerifier::Checkpoint ReplayVerifier::TakeCheckpoint() {
+    Memory::MemorySystem& memory = system.Memory();
+    Checkpoint checkpoint;
+    checkpoint.frame = frame;
+
+    checkpoint.top_screen_hash = HashScreen(memory, GPU::g_regs.framebuffer_config[0]);
+    checkpoint.bottom_screen_hash = HashScreen(memory, GPU::g_regs.framebuffer_config[1]);
+
+    Memory::RasterizerFlushRegion(Memory::FCRAM_PADDR, Memory::FCRAM_N3DS_SIZE);
+    checkpoint.fcram_hash =
+        Common::ComputeHash64(memory.GetFCRAMPointer(0), Memory::FCRAM_N3DS_SIZE);
+    return checkpoint;
+}
+
+} // namespace Core
@@ -0,0 +1,82 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+namespace Core {
+
+class System;
+
+/**
+ * Hashes the emulated state every few frames while a movie is replayed, to check that two builds
+ * replay it identically. The hashes are written to a text file with a line per checkpoint, and can
+ * be compared against the file of a reference run as the replay goes, which finds the first
+ * checkpoint where the runs diverge.
+ */
+class ReplayVerifier {
+public:
+    /// Hashes of the state at the end of a frame
+    struct Checkpoint {
+        u64 frame = 0;
+        u64 fcram_hash = 0;
+        u64 top_screen_hash = 0;
+        u64 bottom_screen_hash = 0;
+
+        bool operator==(const Checkpoint& other) const;
+        bool operator!=(const Checkpoint& other) const {
+            return !(*this == other);
+        }
+    };
+
+    /**
+     * @param output_file File the checkpoints are written to, empty to not write them
+     * @param reference_file Checkpoints of a reference run to compare against, empty for none
+     * @param interval Number of frames between the checkpoints
+     */
+    ReplayVerifier(System& system, const std::string& output_file,
+                   const std::string& reference_file, u32 interval);
+    ~ReplayVerifier();
+
+    /// Ends the current frame, called from the emulation thread
+    void EndFrame();
+
+    /// Returns the first checkpoint that differs from the reference run, if any
+    const std::optional<Checkpoint>& GetDivergence() const {
+        return divergence;
+    }
+
+    /// Returns the checkpoint of the reference run at the divergence
+    const Checkpoint& GetReferenceAtDivergence() const {
+        return reference[reference_position - 1];
+    }
+
+    std::size_t GetNumCheckpoints() const {
+        return num_checkpoints;
+    }
+
+    /// Parses a file written by a previous run, returns false if it can't be read
+    static bool LoadCheckpoints(const std::string& filename, std::vector<Checkpoint>& checkpoints);
+
+private:
+    Checkpoint TakeCheckpoint();
+
+    System& system;
+    u32 interval;
+    u64 frame = 0;
+    std::size_t num_checkpoints = 0;
+
+    FileUtil::IOFile output;
+    std::vector<Checkpoint> reference;
+    std::size_t reference_position = 0;
+    std::optional<Checkpoint> divergence;
+};
+
+} // namespace Core
@@ -0,0 +1,73 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/logging/log.h"
+#include "core/memory_snapshots.h"
+#include "core/movie.h"
+#include "core/rewind.h"
+#include "core/settings.h"
+
+namespace Core {
+
+Rewind::Rewind(MemorySnapshots& snapshots, Movie& movie) : snapshots(snapshots), movie(movie) {}
+
+Rewind::~Rewind() = default;
+
+void Rewind::OnFrame() {
+    // The slice the VBlank event fired in is still running, so the snapshots wait for its end
+    frame_ended = true;
+}
+
+void Rewind::Update() {
+    if (!frame_ended)
+        return;
+    frame_ended = false;
+
+    if (!Settings::values.enable_rewind) {
+        if (snapshots.Count() != 0)
+            snapshots.Clear();
+        requested = false;
+        return;
+    }
+
+    ++frames_since_capture;
+    const u32 interval = std::max(Settings::values.rewind_interval, 1U);
+
+    if (requested.exchange(false) && snapshots.Count() != 0) {
+        if (movie.IsRecordingInput() || movie.IsPlayingInput()) {
+            LOG_WARNING(Core, "Rewinding isn't supported while a movie is recorded or played");
+            return;
+        }
+
+        // A snapshot captured only a moment ago would barely go back, so skip it
+        std::size_t index = snapshots.Count() - 1;
+        if (frames_since_capture < interval / 2 && index > 0)
+            --index;
+
+        if (snapshots.Restore(index)) {
+            frames_since_capture = 0;
+            LOG_INFO(Core, "Rewound to snapshot {}", index);
+        }
+        return;
+    }
+
+    if (frames_since_capture < interval)
+        return;
+
+    frames_since_capture = 0;
+    snapshots.Capture();
+
+    const std::size_t budget = static_cast<std::size_t>(Settings::values.rewind_memory_budget)
+                               << 20;
+    while (snapshots.Count() > 2 && snapshots.MemoryUsage() > budget) {
+        snapshots.DropOldest();
+    }
+}
+
+void Rewind::Request() {
+    requested = true;
+}
+
+} // namespace Core
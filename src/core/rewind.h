@@ -0,0 +1,46 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include "common/common_types.h"
+
+namespace Core {
+
+class MemorySnapshots;
+class Movie;
+
+/**
+ * Rewind buffer on top of the memory snapshots. A snapshot is captured every few frames, and the
+ * oldest ones are merged away once the snapshots exceed the memory budget.
+ *
+ * Only the memory goes back in time, the CPU, the kernel and the hardware stay as they are, so
+ * games may misbehave after rewinding. Rewinding is refused while a movie is recorded or played,
+ * since the movie couldn't reproduce it.
+ */
+class Rewind : NonCopyable {
+public:
+    Rewind(MemorySnapshots& snapshots, Movie& movie);
+    ~Rewind();
+
+    /// Called by the VBlank callback at the end of each frame
+    void OnFrame();
+
+    /// Called by the emulation thread between two slices, captures or rewinds after a frame ended
+    void Update();
+
+    /// Requests rewinding at the end of the current frame, may be called from any thread
+    void Request();
+
+private:
+    MemorySnapshots& snapshots;
+    Movie& movie;
+
+    u32 frames_since_capture = 0;
+    bool frame_ended = false;
+    std::atomic_bool requested{false};
+};
+
+} // namespace Core
@@ -1,15 +1,25 @@
-#include <algorithm>
 #include <cstring>
 
 #include "core/rpc/packet.h"
 
 namespace RPC {
 
-Packet::Packet(const PacketHeader& header, u8* data,
-               std::function<void(Packet&)> send_reply_callback)
-    : header(header), send_reply_callback(std::move(send_reply_callback)) {
+Packet::Packet(const PacketHeader& header, const u8* data, u32 max_data_size,
+               std::function<void(Packet&)> send_reply_callback,
+               std::shared_ptr<std::atomic_bool> connected)
+    : header(header), packet_data(data, data + header.packet_size), max_data_size(max_data_size),
+      send_reply_callback(std::move(send_reply_callback)), connected(std::move(connected)) {}
 
-    std::memcpy(packet_data.data(), data, std::min(header.packet_size, MAX_PACKET_DATA_SIZE));
+std::vector<u8> Packet::Serialize() const {
+    std::vector<u8> buffer(MIN_PACKET_SIZE + packet_data.size());
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    std::memcpy(buffer.data() + MIN_PACKET_SIZE, packet_data.data(), packet_data.size());
+    return buffer;
+}
+
+Packet Packet::MakeNotification(PacketType type, u32 id) const {
+    const PacketHeader notification_header{CURRENT_VERSION, id, type, 0};
+    return Packet(notification_header, nullptr, max_data_size, send_reply_callback, connected);
 }
 
 }; // namespace RPC
@@ -4,8 +4,10 @@
 
 #pragma once
 
-#include <array>
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <vector>
 #include "common/common_types.h"
 
 namespace RPC {
@@ -14,6 +16,25 @@ enum class PacketType {
     Undefined = 0,
     ReadMemory,
     WriteMemory,
+    StartTrace,
+    StopTrace,
+    DumpTrace,
+    ReadMemoryBatch,
+    WriteMemoryBatch,
+    Subscribe,
+    Unsubscribe,
+    SubscriptionData, ///< Sent by the server for each frame of a subscription
+    GetHLECosts,      ///< Replies with the HLE cost report as text
+    DumpHLECosts,     ///< Writes the HLE cost report to the log directory
+    StartProfile,     ///< Starts the guest profiler, optionally at the given samples per second
+    StopProfile,
+    DumpProfile, ///< Writes the guest profile as collapsed stacks to the log directory
+};
+
+/// Address range of the batched requests and subscriptions
+struct MemoryRange {
+    u32 address;
+    u32 size;
 };
 
 struct PacketHeader {
@@ -25,13 +46,26 @@ struct PacketHeader {
 
 constexpr u32 CURRENT_VERSION = 1;
 constexpr u32 MIN_PACKET_SIZE = sizeof(PacketHeader);
+/// Limit of the single ReadMemory and WriteMemory requests, which existing clients rely on
 constexpr u32 MAX_PACKET_DATA_SIZE = 32;
-constexpr u32 MAX_PACKET_SIZE = MIN_PACKET_SIZE + MAX_PACKET_DATA_SIZE;
 constexpr u32 MAX_READ_SIZE = MAX_PACKET_DATA_SIZE;
+/// Largest data of a packet sent over UDP, which still fits into a single datagram
+constexpr u32 MAX_UDP_PACKET_DATA_SIZE = 0xF000;
+/// Largest data of a packet sent over TCP
+constexpr u32 MAX_TCP_PACKET_DATA_SIZE = 0x400000;
+/// Most ranges of a batched request or a subscription
+constexpr u32 MAX_BATCH_RANGES = 1024;
 
 class Packet {
 public:
-    Packet(const PacketHeader& header, u8* data, std::function<void(Packet&)> send_reply_callback);
+    /**
+     * @param data Packet data of header.packet_size bytes
+     * @param max_data_size Largest packet data the transport can send in a reply
+     * @param connected Cleared when the client disconnects, nullptr for connectionless transports
+     */
+    Packet(const PacketHeader& header, const u8* data, u32 max_data_size,
+           std::function<void(Packet&)> send_reply_callback,
+           std::shared_ptr<std::atomic_bool> connected = nullptr);
 
     u32 GetVersion() const {
         return header.version;
@@ -53,26 +87,45 @@ public:
         return header;
     }
 
-    std::array<u8, MAX_PACKET_DATA_SIZE>& GetPacketData() {
+    std::vector<u8>& GetPacketData() {
         return packet_data;
     }
 
+    /// Resizes the packet data, keeping the existing bytes
     void SetPacketDataSize(u32 size) {
         header.packet_size = size;
+        packet_data.resize(size);
+    }
+
+    u32 GetMaxDataSize() const {
+        return max_data_size;
+    }
+
+    /// Whether the client that sent the packet can still receive replies
+    bool IsConnected() const {
+        return !connected || connected->load();
     }
 
     void SendReply() {
         send_reply_callback(*this);
     }
 
-private:
-    void HandleReadMemory(u32 address, u32 data_size);
-    void HandleWriteMemory(u32 address, const u8* data, u32 data_size);
+    /// Returns the header followed by the data, as sent over the wire
+    std::vector<u8> Serialize() const;
 
+    /**
+     * Creates a packet sent to the same client as the replies to this one, for data that is sent
+     * without a request.
+     */
+    Packet MakeNotification(PacketType type, u32 id) const;
+
+private:
     struct PacketHeader header;
-    std::array<u8, MAX_PACKET_DATA_SIZE> packet_data;
+    std::vector<u8> packet_data;
+    u32 max_data_size;
 
     std::function<void(Packet&)> send_reply_callback;
+    std::shared_ptr<std::atomic_bool> connected;
 };
 
 } // namespace RPC
@@ -1,6 +1,17 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include "common/assert.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/tracing.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
+#include "core/guest_profiler.h"
+#include "core/hle/cost_accounting.h"
 #include "core/hle/kernel/process.h"
 #include "core/memory.h"
 #include "core/rpc/packet.h"
@@ -8,6 +19,58 @@
 
 namespace RPC {
 
+namespace {
+/// Most subscriptions that can be active at once, over all clients
+constexpr std::size_t MAX_SUBSCRIPTIONS = 16;
+
+/// Only allow writing to certain memory regions
+bool IsWritableAddress(u32 address) {
+    return (address >= Memory::PROCESS_IMAGE_VADDR && address <= Memory::PROCESS_IMAGE_VADDR_END) ||
+           (address >= Memory::HEAP_VADDR && address <= Memory::HEAP_VADDR_END) ||
+           (address >= Memory::N3DS_EXTRA_RAM_VADDR && address <= Memory::N3DS_EXTRA_RAM_VADDR_END);
+}
+
+/**
+ * Parses a u32 range count at the given offset of the packet data followed by the ranges.
+ * @param max_total_size Largest sum of the range sizes
+ * @param offset Set to the end of the ranges
+ * @returns false if the ranges are malformed or too large
+ */
+bool ParseRanges(const std::vector<u8>& data, std::size_t& offset, u32 max_total_size,
+                 std::vector<MemoryRange>& ranges) {
+    u32 count = 0;
+    if (data.size() < offset + sizeof(count))
+        return false;
+    std::memcpy(&count, data.data() + offset, sizeof(count));
+    offset += sizeof(count);
+    if (count == 0 || count > MAX_BATCH_RANGES ||
+        data.size() < offset + count * sizeof(MemoryRange))
+        return false;
+
+    ranges.resize(count);
+    std::memcpy(ranges.data(), data.data() + offset, count * sizeof(MemoryRange));
+    offset += count * sizeof(MemoryRange);
+
+    u64 total_size = 0;
+    for (const MemoryRange& range : ranges) {
+        if (range.size == 0 || u64{range.address} + range.size > 0x100000000)
+            return false;
+        total_size += range.size;
+    }
+    return total_size <= max_total_size;
+}
+
+/// Reads the ranges into dest back to back
+void ReadRanges(const std::vector<MemoryRange>& ranges, u8* dest) {
+    Core::System& system = Core::System::GetInstance();
+    const Kernel::Process& process = *system.Kernel().GetCurrentProcess();
+    for (const MemoryRange& range : ranges) {
+        system.Memory().ReadBlock(process, range.address, dest, range.size);
+        dest += range.size;
+    }
+}
+} // Anonymous namespace
+
 RPCServer::RPCServer() : server(*this) {
     LOG_INFO(RPC_Server, "Starting RPC server ...");
 
@@ -30,18 +93,15 @@ void RPCServer::HandleReadMemory(Packet& packet, u32 address, u32 data_size) {
     }
 
     // Note: Memory read occurs asynchronously from the state of the emulator
+    packet.SetPacketDataSize(data_size);
     Core::System::GetInstance().Memory().ReadBlock(
         *Core::System::GetInstance().Kernel().GetCurrentProcess(), address,
         packet.GetPacketData().data(), data_size);
-    packet.SetPacketDataSize(data_size);
     packet.SendReply();
 }
 
 void RPCServer::HandleWriteMemory(Packet& packet, u32 address, const u8* data, u32 data_size) {
-    // Only allow writing to certain memory regions
-    if ((address >= Memory::PROCESS_IMAGE_VADDR && address <= Memory::PROCESS_IMAGE_VADDR_END) ||
-        (address >= Memory::HEAP_VADDR && address <= Memory::HEAP_VADDR_END) ||
-        (address >= Memory::N3DS_EXTRA_RAM_VADDR && address <= Memory::N3DS_EXTRA_RAM_VADDR_END)) {
+    if (IsWritableAddress(address)) {
         // Note: Memory write occurs asynchronously from the state of the emulator
         Core::System::GetInstance().Memory().WriteBlock(
             *Core::System::GetInstance().Kernel().GetCurrentProcess(), address, data, data_size);
@@ -54,6 +114,230 @@ void RPCServer::HandleWriteMemory(Packet& packet, u32 address, const u8* data, u
     packet.SendReply();
 }
 
+void RPCServer::HandleTrace(Packet& packet, PacketType type) {
+    u32 success = 1;
+    switch (type) {
+    case PacketType::StartTrace:
+        Common::Tracing::Clear();
+        Common::Tracing::Start();
+        LOG_INFO(RPC_Server, "Started tracing");
+        break;
+    case PacketType::StopTrace:
+        Common::Tracing::Stop();
+        LOG_INFO(RPC_Server, "Stopped tracing");
+        break;
+    case PacketType::DumpTrace: {
+        const std::time_t now =
+            std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        const std::string path =
+            fmt::format("{}trace_{:%Y%m%d_%H%M%S}.json",
+                        FileUtil::GetUserPath(FileUtil::UserPath::LogDir), *std::localtime(&now));
+        if (Common::Tracing::WriteChromeTrace(path)) {
+            LOG_INFO(RPC_Server, "Wrote trace to {}", path);
+        } else {
+            LOG_ERROR(RPC_Server, "Could not write trace to {}", path);
+            success = 0;
+        }
+        break;
+    }
+    default:
+        UNREACHABLE();
+    }
+    packet.SetPacketDataSize(sizeof(success));
+    std::memcpy(packet.GetPacketData().data(), &success, sizeof(success));
+    packet.SendReply();
+}
+
+void RPCServer::HandleHLECosts(Packet& packet, PacketType type) {
+    const std::string report = HLE::CostAccounting::FormatReport();
+    if (type == PacketType::GetHLECosts) {
+        // Long reports are cut off at the largest reply of the transport
+        const std::size_t size = std::min<std::size_t>(report.size(), packet.GetMaxDataSize());
+        packet.SetPacketDataSize(static_cast<u32>(size));
+        std::memcpy(packet.GetPacketData().data(), report.data(), size);
+        packet.SendReply();
+        return;
+    }
+
+    const std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    const std::string path =
+        fmt::format("{}hle_costs_{:%Y%m%d_%H%M%S}.txt",
+                    FileUtil::GetUserPath(FileUtil::UserPath::LogDir), *std::localtime(&now));
+    u32 success = 0;
+    FileUtil::IOFile file(path, "w");
+    if (file.IsOpen() && file.WriteString(report) == report.size()) {
+        LOG_INFO(RPC_Server, "Wrote HLE costs to {}", path);
+        success = 1;
+    } else {
+        LOG_ERROR(RPC_Server, "Could not write HLE costs to {}", path);
+    }
+    packet.SetPacketDataSize(sizeof(success));
+    std::memcpy(packet.GetPacketData().data(), &success, sizeof(success));
+    packet.SendReply();
+}
+
+void RPCServer::HandleProfile(Packet& packet, PacketType type) {
+    Core::GuestProfiler& profiler = Core::System::GetInstance().GuestProfiler();
+    u32 success = 1;
+    switch (type) {
+    case PacketType::StartProfile: {
+        u32 samples_per_second = 1000;
+        if (packet.GetHeader().packet_size >= sizeof(samples_per_second)) {
+            std::memcpy(&samples_per_second, packet.GetPacketData().data(),
+                        sizeof(samples_per_second));
+        }
+        profiler.Clear();
+        profiler.Start(samples_per_second);
+        LOG_INFO(RPC_Server, "Started profiling at {} samples per second", samples_per_second);
+        break;
+    }
+    case PacketType::StopProfile:
+        profiler.Stop();
+        LOG_INFO(RPC_Server, "Stopped profiling");
+        break;
+    case PacketType::DumpProfile: {
+        const std::time_t now =
+            std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        const std::string path =
+            fmt::format("{}profile_{:%Y%m%d_%H%M%S}.folded",
+                        FileUtil::GetUserPath(FileUtil::UserPath::LogDir), *std::localtime(&now));
+        if (profiler.WriteCollapsedStacks(path)) {
+            LOG_INFO(RPC_Server, "Wrote profile to {}", path);
+        } else {
+            success = 0;
+        }
+        break;
+    }
+    default:
+        UNREACHABLE();
+    }
+    packet.SetPacketDataSize(sizeof(success));
+    std::memcpy(packet.GetPacketData().data(), &success, sizeof(success));
+    packet.SendReply();
+}
+
+bool RPCServer::HandleReadMemoryBatch(Packet& packet) {
+    std::size_t offset = 0;
+    std::vector<MemoryRange> ranges;
+    if (!ParseRanges(packet.GetPacketData(), offset, packet.GetMaxDataSize(), ranges))
+        return false;
+
+    u32 total_size = 0;
+    for (const MemoryRange& range : ranges) {
+        total_size += range.size;
+    }
+
+    // Note: Memory read occurs asynchronously from the state of the emulator
+    packet.SetPacketDataSize(total_size);
+    ReadRanges(ranges, packet.GetPacketData().data());
+    packet.SendReply();
+    return true;
+}
+
+bool RPCServer::HandleWriteMemoryBatch(Packet& packet) {
+    std::size_t offset = 0;
+    std::vector<MemoryRange> ranges;
+    if (!ParseRanges(packet.GetPacketData(), offset, MAX_TCP_PACKET_DATA_SIZE, ranges))
+        return false;
+
+    const u8* data = packet.GetPacketData().data() + offset;
+    const u8* const data_end = packet.GetPacketData().data() + packet.GetPacketData().size();
+    Core::System& system = Core::System::GetInstance();
+    Kernel::Process& process = *system.Kernel().GetCurrentProcess();
+    // Each core invalidates the JIT code of all the written ranges at once
+    Core::InvalidationBatch invalidation(system);
+    u32 written = 0;
+    for (const MemoryRange& range : ranges) {
+        if (static_cast<std::size_t>(data_end - data) < range.size)
+            break;
+        if (IsWritableAddress(range.address)) {
+            // Note: Memory write occurs asynchronously from the state of the emulator
+            system.Memory().WriteBlock(process, range.address, data, range.size);
+            system.InvalidateCacheRange(range.address, range.size);
+            ++written;
+        }
+        data += range.size;
+    }
+    invalidation.Commit();
+
+    packet.SetPacketDataSize(sizeof(written));
+    std::memcpy(packet.GetPacketData().data(), &written, sizeof(written));
+    packet.SendReply();
+    return true;
+}
+
+bool RPCServer::HandleSubscribe(Packet& packet) {
+    u32 interval = 0;
+    std::memcpy(&interval, packet.GetPacketData().data(), sizeof(interval));
+    std::size_t offset = sizeof(interval);
+    std::vector<MemoryRange> ranges;
+    if (interval == 0 || !ParseRanges(packet.GetPacketData(), offset,
+                                      packet.GetMaxDataSize() - sizeof(u32), ranges))
+        return false;
+
+    u32 id = 0;
+    {
+        std::lock_guard lock{subscription_mutex};
+        if (subscriptions.size() < MAX_SUBSCRIPTIONS) {
+            id = next_subscription_id++;
+            subscriptions.push_back(Subscription{
+                id, interval, std::move(ranges),
+                std::make_unique<Packet>(
+                    packet.MakeNotification(PacketType::SubscriptionData, id))});
+            LOG_INFO(RPC_Server, "Added subscription {} with {} ranges every {} frames", id,
+                     subscriptions.back().ranges.size(), interval);
+        }
+    }
+
+    packet.SetPacketDataSize(sizeof(id));
+    std::memcpy(packet.GetPacketData().data(), &id, sizeof(id));
+    packet.SendReply();
+    return true;
+}
+
+bool RPCServer::HandleUnsubscribe(Packet& packet) {
+    u32 id = 0;
+    std::memcpy(&id, packet.GetPacketData().data(), sizeof(id));
+    {
+        std::lock_guard lock{subscription_mutex};
+        subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+                                           [id](const Subscription& s) { return s.id == id; }),
+                            subscriptions.end());
+    }
+    packet.SetPacketDataSize(0);
+    packet.SendReply();
+    return true;
+}
+
+void RPCServer::OnFrame() {
+    std::lock_guard lock{subscription_mutex};
+    ++frame_index;
+    if (subscriptions.empty())
+        return;
+
+    subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+                                       [](const Subscription& s) {
+                                           return !s.notification->IsConnected();
+                                       }),
+                        subscriptions.end());
+
+    for (Subscription& subscription : subscriptions) {
+        if (frame_index % subscription.interval != 0)
+            continue;
+
+        u32 total_size = 0;
+        for (const MemoryRange& range : subscription.ranges) {
+            total_size += range.size;
+        }
+        Packet& notification = *subscription.notification;
+        notification.SetPacketDataSize(sizeof(frame_index) + total_size);
+        std::memcpy(notification.GetPacketData().data(), &frame_index, sizeof(frame_index));
+        // Runs on the emulation thread between frames, so the ranges are read consistently
+        ReadRanges(subscription.ranges, notification.GetPacketData().data() + sizeof(frame_index));
+        notification.SendReply();
+    }
+}
+
 bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
     if (packet_header.version <= CURRENT_VERSION) {
         switch (packet_header.packet_type) {
@@ -63,6 +347,23 @@ bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
                 return true;
             }
             break;
+        case PacketType::StartTrace:
+        case PacketType::StopTrace:
+        case PacketType::DumpTrace:
+        case PacketType::GetHLECosts:
+        case PacketType::DumpHLECosts:
+        case PacketType::StartProfile:
+        case PacketType::StopProfile:
+        case PacketType::DumpProfile:
+            return true;
+        case PacketType::ReadMemoryBatch:
+        case PacketType::WriteMemoryBatch:
+        case PacketType::Subscribe:
+        case PacketType::Unsubscribe:
+            if (packet_header.packet_size >= sizeof(u32)) {
+                return true;
+            }
+            break;
         default:
             break;
         }
@@ -73,7 +374,44 @@ bool RPCServer::ValidatePacket(const PacketHeader& packet_header) {
 void RPCServer::HandleSingleRequest(std::unique_ptr<Packet> request_packet) {
     bool success = false;
 
-    if (ValidatePacket(request_packet->GetHeader())) {
+    const PacketType type = request_packet->GetPacketType();
+    if (type == PacketType::StartTrace || type == PacketType::StopTrace ||
+        type == PacketType::DumpTrace) {
+        if (ValidatePacket(request_packet->GetHeader())) {
+            HandleTrace(*request_packet, type);
+            return;
+        }
+    } else if (type == PacketType::GetHLECosts || type == PacketType::DumpHLECosts) {
+        if (ValidatePacket(request_packet->GetHeader())) {
+            HandleHLECosts(*request_packet, type);
+            return;
+        }
+    } else if (type == PacketType::StartProfile || type == PacketType::StopProfile ||
+               type == PacketType::DumpProfile) {
+        if (ValidatePacket(request_packet->GetHeader())) {
+            HandleProfile(*request_packet, type);
+            return;
+        }
+    } else if (type == PacketType::ReadMemoryBatch || type == PacketType::WriteMemoryBatch ||
+               type == PacketType::Subscribe || type == PacketType::Unsubscribe) {
+        // These request types parse their own wire formats
+        if (ValidatePacket(request_packet->GetHeader())) {
+            switch (type) {
+            case PacketType::ReadMemoryBatch:
+                success = HandleReadMemoryBatch(*request_packet);
+                break;
+            case PacketType::WriteMemoryBatch:
+                success = HandleWriteMemoryBatch(*request_packet);
+                break;
+            case PacketType::Subscribe:
+                success = HandleSubscribe(*request_packet);
+                break;
+            default:
+                success = HandleUnsubscribe(*request_packet);
+                break;
+            }
+        }
+    } else if (ValidatePacket(request_packet->GetHeader())) {
         // Currently, all request types use the address/data_size wire format
         u32 address = 0;
         u32 data_size = 0;
@@ -8,13 +8,16 @@
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include "common/threadsafe_queue.h"
 #include "core/rpc/server.h"
 
 namespace RPC {
 
 class Packet;
+struct MemoryRange;
 struct PacketHeader;
+enum class PacketType;
 
 class RPCServer {
 public:
@@ -23,18 +26,41 @@ public:
 
     void QueueRequest(std::unique_ptr<RPC::Packet> request);
 
+    /// Sends the data of the subscriptions that are due, called by the emulation thread per frame
+    void OnFrame();
+
 private:
+    struct Subscription {
+        u32 id;
+        u32 interval;
+        std::vector<MemoryRange> ranges;
+        std::unique_ptr<Packet> notification;
+    };
+
     void Start();
     void Stop();
     void HandleReadMemory(Packet& packet, u32 address, u32 data_size);
     void HandleWriteMemory(Packet& packet, u32 address, const u8* data, u32 data_size);
+    void HandleTrace(Packet& packet, PacketType type);
+    void HandleHLECosts(Packet& packet, PacketType type);
+    void HandleProfile(Packet& packet, PacketType type);
+    bool HandleReadMemoryBatch(Packet& packet);
+    bool HandleWriteMemoryBatch(Packet& packet);
+    bool HandleSubscribe(Packet& packet);
+    bool HandleUnsubscribe(Packet& packet);
     bool ValidatePacket(const PacketHeader& packet_header);
     void HandleSingleRequest(std::unique_ptr<Packet> request);
     void HandleRequestsLoop();
 
     Server server;
-    Common::SPSCQueue<std::unique_ptr<Packet>> request_queue;
+    /// Requests come from both the UDP and the TCP server threads
+    Common::BoundedMPMCQueue<std::unique_ptr<Packet>, 256> request_queue;
     std::thread request_handler_thread;
+
+    std::mutex subscription_mutex;
+    std::vector<Subscription> subscriptions;
+    u32 next_subscription_id = 1;
+    u32 frame_index = 0;
 };
 
 } // namespace RPC
@@ -3,6 +3,7 @@
 #include "core/rpc/packet.h"
 #include "core/rpc/rpc_server.h"
 #include "core/rpc/server.h"
+#include "core/rpc/tcp_server.h"
 #include "core/rpc/udp_server.h"
 
 namespace RPC {
@@ -21,18 +22,26 @@ void Server::Start() {
     } catch (...) {
         LOG_ERROR(RPC_Server, "Error starting UDP server");
     }
+
+    try {
+        tcp_server = std::make_unique<TCPServer>(callback);
+    } catch (...) {
+        LOG_ERROR(RPC_Server, "Error starting TCP server");
+    }
 }
 
 void Server::Stop() {
     udp_server.reset();
+    tcp_server.reset();
     NewRequestCallback(nullptr); // Notify the RPC server to end
 }
 
 void Server::NewRequestCallback(std::unique_ptr<RPC::Packet> new_request) {
     if (new_request) {
-        LOG_INFO(RPC_Server, "Received request version={} id={} type={} size={}",
-                 new_request->GetVersion(), new_request->GetId(),
-                 static_cast<u32>(new_request->GetPacketType()), new_request->GetPacketDataSize());
+        LOG_DEBUG(RPC_Server, "Received request version={} id={} type={} size={}",
+                  new_request->GetVersion(), new_request->GetId(),
+                  static_cast<u32>(new_request->GetPacketType()),
+                  new_request->GetPacketDataSize());
     } else {
         LOG_INFO(RPC_Server, "Received end packet");
     }
@@ -0,0 +1,163 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <deque>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include "common/common_types.h"
+#include "common/logging/log.h"
+#include "core/rpc/packet.h"
+#include "core/rpc/tcp_server.h"
+
+namespace RPC {
+
+namespace {
+/// Replies waiting to be sent to a client after which subscription data is dropped
+constexpr std::size_t MAX_QUEUED_WRITES = 64;
+} // Anonymous namespace
+
+class TCPServer::Impl {
+public:
+    explicit Impl(std::function<void(std::unique_ptr<Packet>)> new_request_callback)
+        // Same port as the UDP server
+        : acceptor(io_context, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), 45987)),
+          new_request_callback(std::move(new_request_callback)) {
+
+        StartAccept();
+        worker_thread = std::thread([this] { io_context.run(); });
+    }
+
+    ~Impl() {
+        io_context.stop();
+        worker_thread.join();
+    }
+
+private:
+    class Connection : public std::enable_shared_from_this<Connection> {
+    public:
+        Connection(boost::asio::ip::tcp::socket socket, Impl& server)
+            : socket(std::move(socket)), server(server) {
+            boost::system::error_code error;
+            this->socket.set_option(boost::asio::ip::tcp::no_delay(true), error);
+        }
+
+        ~Connection() {
+            *connected = false;
+        }
+
+        void Start() {
+            ReadHeader();
+        }
+
+    private:
+        void ReadHeader() {
+            boost::asio::async_read(
+                socket, boost::asio::buffer(&header, sizeof(header)),
+                [self = shared_from_this()](const boost::system::error_code& error, std::size_t) {
+                    if (error)
+                        return self->Close();
+                    if (self->header.packet_size > MAX_TCP_PACKET_DATA_SIZE) {
+                        LOG_WARNING(RPC_Server, "Received message with wrong size: {}",
+                                    self->header.packet_size);
+                        return self->Close();
+                    }
+                    self->data.resize(self->header.packet_size);
+                    self->ReadData();
+                });
+        }
+
+        void ReadData() {
+            boost::asio::async_read(
+                socket, boost::asio::buffer(data),
+                [self = shared_from_this()](const boost::system::error_code& error, std::size_t) {
+                    if (error)
+                        return self->Close();
+
+                    // Replies must not keep the connection alive once the client is gone
+                    std::weak_ptr<Connection> weak_self = self;
+                    auto send_reply_callback = [weak_self](Packet& packet) {
+                        if (auto connection = weak_self.lock()) {
+                            connection->Send(packet);
+                        }
+                    };
+                    self->server.new_request_callback(std::make_unique<Packet>(
+                        self->header, self->data.data(), MAX_TCP_PACKET_DATA_SIZE,
+                        send_reply_callback, self->connected));
+                    self->ReadHeader();
+                });
+        }
+
+        /// Queues a packet to be sent, can be called from any thread
+        void Send(Packet& packet) {
+            boost::asio::post(socket.get_executor(),
+                              [self = shared_from_this(), type = packet.GetPacketType(),
+                               buffer = packet.Serialize()]() mutable {
+                                  if (self->write_queue.size() >= MAX_QUEUED_WRITES &&
+                                      type == PacketType::SubscriptionData) {
+                                      return;
+                                  }
+                                  self->write_queue.push_back(std::move(buffer));
+                                  if (self->write_queue.size() == 1) {
+                                      self->WriteNext();
+                                  }
+                              });
+        }
+
+        void WriteNext() {
+            boost::asio::async_write(
+                socket, boost::asio::buffer(write_queue.front()),
+                [self = shared_from_this()](const boost::system::error_code& error, std::size_t) {
+                    if (error) {
+                        LOG_WARNING(RPC_Server, "Failed to send reply: {}", error.message());
+                        return self->Close();
+                    }
+                    self->write_queue.pop_front();
+                    if (!self->write_queue.empty()) {
+                        self->WriteNext();
+                    }
+                });
+        }
+
+        void Close() {
+            *connected = false;
+            boost::system::error_code error;
+            socket.close(error);
+        }
+
+        boost::asio::ip::tcp::socket socket;
+        Impl& server;
+        std::shared_ptr<std::atomic_bool> connected = std::make_shared<std::atomic_bool>(true);
+
+        PacketHeader header;
+        std::vector<u8> data;
+        std::deque<std::vector<u8>> write_queue;
+    };
+
+    void StartAccept() {
+        acceptor.async_accept([this](const boost::system::error_code& error,
+                                     boost::asio::ip::tcp::socket socket) {
+            if (error) {
+                LOG_WARNING(RPC_Server, "Failed to accept TCP connection: {}", error.message());
+            } else {
+                std::make_shared<Connection>(std::move(socket), *this)->Start();
+            }
+            StartAccept();
+        });
+    }
+
+    std::thread worker_thread;
+
+    boost::asio::io_context io_context;
+    boost::asio::ip::tcp::acceptor acceptor;
+
+    std::function<void(std::unique_ptr<Packet>)> new_request_callback;
+};
+
+TCPServer::TCPServer(std::function<void(std::unique_ptr<Packet>)> new_request_callback)
+    : impl(std::make_unique<Impl>(new_request_callback)) {}
+
+TCPServer::~TCPServer() = default;
+
+} // namespace RPC
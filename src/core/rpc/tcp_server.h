@@ -0,0 +1,28 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+
+namespace RPC {
+
+class Packet;
+
+/**
+ * Receives requests over TCP connections. Packets are sent back to back on the stream with the
+ * same header as over UDP, but may carry up to MAX_TCP_PACKET_DATA_SIZE bytes.
+ */
+class TCPServer {
+public:
+    explicit TCPServer(std::function<void(std::unique_ptr<Packet>)> new_request_callback);
+    ~TCPServer();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+} // namespace RPC
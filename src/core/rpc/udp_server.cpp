@@ -39,15 +39,15 @@ private:
     void HandleReceive(const boost::system::error_code& error, std::size_t size) {
         if (error) {
             LOG_WARNING(RPC_Server, "Failed to receive data on UDP socket: {}", error.message());
-        } else if (size >= MIN_PACKET_SIZE && size <= MAX_PACKET_SIZE) {
+        } else if (size >= MIN_PACKET_SIZE && size <= request_buffer.size()) {
             PacketHeader header;
             std::memcpy(&header, request_buffer.data(), sizeof(header));
             if ((size - MIN_PACKET_SIZE) == header.packet_size) {
                 u8* data = request_buffer.data() + MIN_PACKET_SIZE;
                 std::function<void(Packet&)> send_reply_callback =
                     std::bind(&Impl::SendReply, this, remote_endpoint, std::placeholders::_1);
-                std::unique_ptr<Packet> new_packet =
-                    std::make_unique<Packet>(header, data, send_reply_callback);
+                std::unique_ptr<Packet> new_packet = std::make_unique<Packet>(
+                    header, data, MAX_UDP_PACKET_DATA_SIZE, send_reply_callback);
 
                 // Send the request to the upper layer for handling
                 new_request_callback(std::move(new_packet));
@@ -59,12 +59,7 @@ private:
     }
 
     void SendReply(boost::asio::ip::udp::endpoint endpoint, Packet& reply_packet) {
-        std::vector<u8> reply_buffer(MIN_PACKET_SIZE + reply_packet.GetPacketDataSize());
-        auto reply_header = reply_packet.GetHeader();
-
-        std::memcpy(reply_buffer.data(), &reply_header, sizeof(reply_header));
-        std::memcpy(reply_buffer.data() + (4 * sizeof(u32)), reply_packet.GetPacketData().data(),
-                    reply_packet.GetPacketDataSize());
+        const std::vector<u8> reply_buffer = reply_packet.Serialize();
 
         boost::system::error_code error;
         socket.send_to(boost::asio::buffer(reply_buffer), endpoint, 0, error);
@@ -72,10 +67,10 @@ private:
         if (error) {
             LOG_WARNING(RPC_Server, "Failed to send reply: {}", error.message());
         } else {
-            LOG_INFO(RPC_Server, "Sent reply version({}) id=({}) type=({}) size=({})",
-                     reply_packet.GetVersion(), reply_packet.GetId(),
-                     static_cast<u32>(reply_packet.GetPacketType()),
-                     reply_packet.GetPacketDataSize());
+            LOG_DEBUG(RPC_Server, "Sent reply version({}) id=({}) type=({}) size=({})",
+                      reply_packet.GetVersion(), reply_packet.GetId(),
+                      static_cast<u32>(reply_packet.GetPacketType()),
+                      reply_packet.GetPacketDataSize());
         }
     }
 
@@ -83,7 +78,7 @@ private:
 
     boost::asio::io_context io_context;
     boost::asio::ip::udp::socket socket;
-    std::array<u8, MAX_PACKET_SIZE> request_buffer;
+    std::array<u8, MIN_PACKET_SIZE + MAX_UDP_PACKET_DATA_SIZE> request_buffer;
     boost::asio::ip::udp::endpoint remote_endpoint;
 
     std::function<void(std::unique_ptr<Packet>)> new_request_callback;
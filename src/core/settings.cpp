@@ -77,14 +77,36 @@ void LogSetting(const std::string& name, const T& value) {
 void LogSettings() {
     LOG_INFO(Config, "Citra Configuration:");
     LogSetting("Core_UseCpuJit", Settings::values.use_cpu_jit);
+    LogSetting("Core_UseMulticoreCpu", Settings::values.use_multicore_cpu);
+    LogSetting("Core_UseHugePages", Settings::values.use_huge_pages);
+    LogSetting("Core_EnableRewind", Settings::values.enable_rewind);
+    LogSetting("Core_RewindInterval", Settings::values.rewind_interval);
+    LogSetting("Core_RewindMemoryBudget", Settings::values.rewind_memory_budget);
+    LogSetting("Core_UseAutoTuning", Settings::values.use_auto_tuning);
     LogSetting("Renderer_UseGLES", Settings::values.use_gles);
     LogSetting("Renderer_UseHwRenderer", Settings::values.use_hw_renderer);
     LogSetting("Renderer_UseHwShader", Settings::values.use_hw_shader);
     LogSetting("Renderer_ShadersAccurateMul", Settings::values.shaders_accurate_mul);
     LogSetting("Renderer_UseShaderJit", Settings::values.use_shader_jit);
+    LogSetting("Renderer_ParallelVertexShading", Settings::values.parallel_vertex_shading);
+    LogSetting("Renderer_UseGpuThread", Settings::values.use_gpu_thread);
+    LogSetting("Renderer_AsyncShaderCompilation", Settings::values.async_shader_compilation);
+    LogSetting("Renderer_UseUberShader", Settings::values.use_uber_shader);
+    LogSetting("Renderer_GpuTextureDecoding", Settings::values.gpu_texture_decoding);
+    LogSetting("Renderer_TextureHashCheck", Settings::values.texture_hash_check);
+    LogSetting("Renderer_TextureCompression",
+               static_cast<int>(Settings::values.texture_compression));
     LogSetting("Renderer_UseResolutionFactor", Settings::values.resolution_factor);
+    LogSetting("Renderer_DynamicResolution", Settings::values.dynamic_resolution);
+    LogSetting("Renderer_DynamicResolutionMin", Settings::values.dynamic_resolution_min);
+    LogSetting("Renderer_SurfaceCacheBudget", Settings::values.surface_cache_budget);
     LogSetting("Renderer_UseFrameLimit", Settings::values.use_frame_limit);
+    LogSetting("Renderer_PresentQueueDepth", Settings::values.present_queue_depth);
+    LogSetting("Renderer_LowLatencyPresentation", Settings::values.low_latency_presentation);
     LogSetting("Renderer_FrameLimit", Settings::values.frame_limit);
+    LogSetting("Renderer_TurboMode", Settings::values.turbo_mode);
+    LogSetting("Renderer_TurboRenderInterval", Settings::values.turbo_render_interval);
+    LogSetting("Renderer_FrameSkip", Settings::values.frame_skip);
     LogSetting("Renderer_PostProcessingShader", Settings::values.pp_shader_name);
     LogSetting("Renderer_FilterMode", Settings::values.filter_mode);
     LogSetting("Renderer_TextureFilterFactor", Settings::values.texture_filter_factor);
@@ -96,11 +118,15 @@ void LogSettings() {
     LogSetting("Layout_UprightScreen", Settings::values.upright_screen);
     LogSetting("Utility_DumpTextures", Settings::values.dump_textures);
     LogSetting("Utility_CustomTextures", Settings::values.custom_textures);
+    LogSetting("Utility_AsyncCustomLoading", Settings::values.async_custom_loading);
+    LogSetting("Utility_UseHwVideoEncoder", Settings::values.use_hw_video_encoder);
     LogSetting("Utility_UseDiskShaderCache", Settings::values.use_disk_shader_cache);
     LogSetting("Audio_EnableDspLle", Settings::values.enable_dsp_lle);
     LogSetting("Audio_EnableDspLleMultithread", Settings::values.enable_dsp_lle_multithread);
+    LogSetting("Audio_EnableDspHleMultithread", Settings::values.enable_dsp_hle_multithread);
     LogSetting("Audio_OutputEngine", Settings::values.sink_id);
     LogSetting("Audio_EnableAudioStretching", Settings::values.enable_audio_stretching);
+    LogSetting("Audio_TargetLatency", Settings::values.audio_target_latency);
     LogSetting("Audio_OutputDevice", Settings::values.audio_device_id);
     LogSetting("Audio_InputDeviceType", static_cast<int>(Settings::values.mic_input_type));
     LogSetting("Audio_InputDevice", Settings::values.mic_input_device);
@@ -115,8 +141,12 @@ void LogSettings() {
     LogSetting("Camera_OuterLeftConfig", Settings::values.camera_config[OuterLeftCamera]);
     LogSetting("Camera_OuterLeftFlip", Settings::values.camera_flip[OuterLeftCamera]);
     LogSetting("DataStorage_UseVirtualSd", Settings::values.use_virtual_sd);
+    LogSetting("DataStorage_ContentStoreDir", Settings::values.content_store_dir);
+    LogSetting("DataStorage_ShareDecryptedRomFS", Settings::values.share_decrypted_romfs);
     LogSetting("System_IsNew3ds", Settings::values.is_new_3ds);
     LogSetting("System_RegionValue", Settings::values.region_value);
+    LogSetting("Debugging_MetricsFile", Settings::values.metrics_file);
+    LogSetting("Debugging_MetricsPort", Settings::values.metrics_port);
     LogSetting("Debugging_UseGdbstub", Settings::values.use_gdbstub);
     LogSetting("Debugging_GdbstubPort", Settings::values.gdbstub_port);
 }
@@ -34,6 +34,12 @@ enum class MicInputType {
 
 enum class StereoRenderOption { Off, SideBySide, Anaglyph, Interlaced };
 
+enum class TextureCompression {
+    Off,
+    Fast,
+    HighQuality,
+};
+
 namespace NativeButton {
 enum Values {
     A,
@@ -128,9 +134,18 @@ struct Values {
 
     // Core
     bool use_cpu_jit;
+    bool use_multicore_cpu;
+    bool use_huge_pages;
+    bool enable_rewind;
+    u32 rewind_interval;
+    u32 rewind_memory_budget;
+    /// Overrides the performance settings with the ones measured for the device and the title
+    bool use_auto_tuning;
 
     // Data Storage
     bool use_virtual_sd;
+    std::string content_store_dir;
+    bool share_decrypted_romfs;
 
     // System
     int region_value;
@@ -144,9 +159,20 @@ struct Values {
     bool use_disk_shader_cache;
     bool shaders_accurate_mul;
     bool use_shader_jit;
+    /// Shades the vertices of large draws on all host threads when hardware shaders are off
+    bool parallel_vertex_shading;
     u16 resolution_factor;
+    /// Lowers the scale of new render targets down to dynamic_resolution_min while the GPU is slow
+    bool dynamic_resolution;
+    u16 dynamic_resolution_min;
+    u32 surface_cache_budget; ///< In MiB, 0 for no limit
     bool use_frame_limit;
     u16 frame_limit;
+    /// Runs unthrottled with muted audio, rendering only one of every turbo_render_interval frames
+    bool turbo_mode;
+    u16 turbo_render_interval;
+    /// Most consecutive frames the adaptive frame skip drops while behind, 0 disables it
+    u16 frame_skip;
     u16 texture_filter_factor;
     std::string texture_filter_name;
 
@@ -176,14 +202,26 @@ struct Values {
     bool dump_textures;
     bool custom_textures;
     bool preload_textures;
+    bool async_custom_loading;
+    bool use_hw_video_encoder;
 
     bool use_vsync_new;
+    u16 present_queue_depth;
+    bool low_latency_presentation;
+    bool use_gpu_thread;
+    bool async_shader_compilation;
+    bool use_uber_shader;
+    bool gpu_texture_decoding;
+    bool texture_hash_check;
+    TextureCompression texture_compression;
 
     // Audio
     bool enable_dsp_lle;
     bool enable_dsp_lle_multithread;
+    bool enable_dsp_hle_multithread;
     std::string sink_id;
     bool enable_audio_stretching;
+    u16 audio_target_latency;
     std::string audio_device_id;
     float volume;
     MicInputType mic_input_type;
@@ -196,9 +234,12 @@ struct Values {
 
     // Debugging
     bool record_frame_times;
+    std::string metrics_file;
+    u16 metrics_port;
     bool use_gdbstub;
     u16 gdbstub_port;
     std::string log_filter;
+    bool binary_log;
     std::unordered_map<std::string, bool> lle_modules;
 
     // WebService
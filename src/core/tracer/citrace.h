@@ -17,8 +17,12 @@ struct CTHeader {
         return "CiTr";
     }
 
+    /**
+     * Version 1 traces store the memory contents before the stream. Version 2 traces are written
+     * while recording: each memory region follows the first load of it, compressed with Zstandard.
+     */
     static u32 ExpectedVersion() {
-        return 1;
+        return 2;
     }
 
     char magic[4];
@@ -57,7 +61,7 @@ struct CTHeader {
     } initial_state_offsets;
 
     u32 stream_offset;
-    u32 stream_size;
+    u32 stream_size; ///< Number of stream elements
 };
 
 enum CTStreamElementType : u32 {
@@ -70,7 +74,7 @@ struct CTMemoryLoad {
     u32 file_offset;
     u32 size;
     u32 physical_address;
-    u32 pad;
+    u32 compressed_size; ///< Size of the data in the file, 0 if it is stored uncompressed
 };
 
 struct CTRegisterWrite {
@@ -0,0 +1,233 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/zstd_compression.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/tracer/player.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace CiTrace {
+
+Player::Player(Memory::MemorySystem& memory) : memory(memory) {}
+
+Player::~Player() = default;
+
+bool Player::Load(const std::string& filename) {
+    FileUtil::IOFile file(filename, "rb");
+    CTHeader header;
+    if (!file.IsOpen() || file.ReadAt(0, &header, sizeof(header)) != sizeof(header) ||
+        std::memcmp(header.magic, CTHeader::ExpectedMagicWord(), 4) != 0 ||
+        header.version == 0 || header.version > CTHeader::ExpectedVersion()) {
+        LOG_ERROR(HW_GPU, "{} is not a supported CiTrace file", filename);
+        return false;
+    }
+
+    const auto read_words = [&file](u32 offset, u32 size, std::vector<u32>& words) {
+        words.resize(size);
+        return file.ReadAt(offset, words.data(), size * sizeof(u32)) == size * sizeof(u32);
+    };
+    const auto& offsets = header.initial_state_offsets;
+    auto& state = initial_state;
+    if (!read_words(offsets.gpu_registers, offsets.gpu_registers_size, state.gpu_registers) ||
+        !read_words(offsets.lcd_registers, offsets.lcd_registers_size, state.lcd_registers) ||
+        !read_words(offsets.pica_registers, offsets.pica_registers_size, state.pica_registers) ||
+        !read_words(offsets.default_attributes, offsets.default_attributes_size,
+                    state.default_attributes) ||
+        !read_words(offsets.vs_program_binary, offsets.vs_program_binary_size,
+                    state.vs_program_binary) ||
+        !read_words(offsets.vs_swizzle_data, offsets.vs_swizzle_data_size,
+                    state.vs_swizzle_data) ||
+        !read_words(offsets.vs_float_uniforms, offsets.vs_float_uniforms_size,
+                    state.vs_float_uniforms) ||
+        !read_words(offsets.gs_program_binary, offsets.gs_program_binary_size,
+                    state.gs_program_binary) ||
+        !read_words(offsets.gs_swizzle_data, offsets.gs_swizzle_data_size,
+                    state.gs_swizzle_data) ||
+        !read_words(offsets.gs_float_uniforms, offsets.gs_float_uniforms_size,
+                    state.gs_float_uniforms)) {
+        LOG_ERROR(HW_GPU, "Failed to read the initial state of {}", filename);
+        return false;
+    }
+
+    stream.clear();
+    memory_regions.clear();
+    frame_ends.clear();
+
+    // Version 1 traces store all memory contents before the stream, version 2 traces store new
+    // contents right after the element loading them. Both refer to them by file offset.
+    std::unordered_map<u32 /*file_offset*/, u32 /*index*/> region_indices;
+    u64 offset = header.stream_offset;
+    for (u32 i = 0; i < header.stream_size; ++i) {
+        CTStreamElement element;
+        if (file.ReadAt(offset, &element, sizeof(element)) != sizeof(element)) {
+            LOG_ERROR(HW_GPU, "Failed to read stream element {} of {}", i, filename);
+            return false;
+        }
+        offset += sizeof(element);
+
+        if (element.type == MemoryLoad) {
+            auto& load = element.memory_load;
+            const u32 stored_size = load.compressed_size != 0 ? load.compressed_size : load.size;
+            if (load.file_offset == offset) {
+                offset += stored_size;
+            }
+
+            const auto [it, inserted] = region_indices.emplace(
+                load.file_offset, static_cast<u32>(memory_regions.size()));
+            if (inserted) {
+                std::vector<u8> data(stored_size);
+                if (file.ReadAt(load.file_offset, data.data(), stored_size) != stored_size) {
+                    LOG_ERROR(HW_GPU, "Failed to read memory contents at {:#x} of {}",
+                              load.file_offset, filename);
+                    return false;
+                }
+                if (load.compressed_size != 0) {
+                    data = Common::Compression::DecompressDataZSTD(data);
+                }
+                memory_regions.push_back(std::move(data));
+            }
+            if (memory_regions[it->second].size() != load.size) {
+                LOG_ERROR(HW_GPU, "Invalid memory contents at {:#x} of {}", load.file_offset,
+                          filename);
+                return false;
+            }
+            load.file_offset = it->second;
+        } else if (element.type == FrameMarker) {
+            frame_ends.push_back(stream.size());
+        }
+        stream.push_back(element);
+    }
+
+    LOG_INFO(HW_GPU, "Loaded {} with {} frames and {} stream elements", filename,
+             frame_ends.size(), stream.size());
+    return true;
+}
+
+template <typename T>
+static void LoadWords(const std::vector<u32>& words, T& dest) {
+    std::memcpy(&dest, words.data(), std::min(sizeof(dest), words.size() * sizeof(u32)));
+}
+
+/// Loads float24 values stored in the low bits of the words, four of them per vector
+static void LoadFloat24Vectors(const std::vector<u32>& words, Common::Vec4<Pica::float24>* dest,
+                               std::size_t count) {
+    for (std::size_t i = 0; i < std::min(words.size(), count * 4); ++i) {
+        dest[i / 4][i % 4] = Pica::float24::FromRaw(words[i] & 0xFFFFFF);
+    }
+}
+
+static void LoadShaderSetup(Pica::Shader::ShaderSetup& setup, const Pica::ShaderRegs& regs,
+                            const std::vector<u32>& program, const std::vector<u32>& swizzle,
+                            const std::vector<u32>& float_uniforms) {
+    LoadWords(program, setup.program_code);
+    LoadWords(swizzle, setup.swizzle_data);
+    setup.MarkProgramCodeDirty();
+    setup.MarkSwizzleDataDirty();
+    LoadFloat24Vectors(float_uniforms, setup.uniforms.f, std::size(setup.uniforms.f));
+
+    // The bool and int uniforms are set from the registers when those are written
+    for (std::size_t i = 0; i < setup.uniforms.b.size(); ++i) {
+        setup.uniforms.b[i] = (regs.bool_uniforms.Value() & (1 << i)) != 0;
+    }
+    for (std::size_t i = 0; i < setup.uniforms.i.size(); ++i) {
+        const auto& values = regs.int_uniforms[i];
+        setup.uniforms.i[i] = Common::Vec4<u8>(values.x, values.y, values.z, values.w);
+    }
+}
+
+void Player::LoadInitialState() {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->WaitIdle();
+    }
+
+    LoadWords(initial_state.gpu_registers, GPU::g_regs);
+    LoadWords(initial_state.lcd_registers, LCD::g_regs);
+
+    auto& state = Pica::g_state;
+    LoadWords(initial_state.pica_registers, state.regs);
+    LoadFloat24Vectors(initial_state.default_attributes, state.input_default_attributes.attr,
+                       std::size(state.input_default_attributes.attr));
+    LoadShaderSetup(state.vs, state.regs.vs, initial_state.vs_program_binary,
+                    initial_state.vs_swizzle_data, initial_state.vs_float_uniforms);
+    LoadShaderSetup(state.gs, state.regs.gs, initial_state.gs_program_binary,
+                    initial_state.gs_swizzle_data, initial_state.gs_float_uniforms);
+    state.primitive_assembler.Reconfigure(state.regs.pipeline.triangle_topology);
+
+    // The rasterizer only syncs the registers it is told about
+    for (u32 id = 0; id < Pica::Regs::NUM_REGS; ++id) {
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    }
+}
+
+void Player::ReplayFrame(std::size_t frame) {
+    const std::size_t begin = frame == 0 ? 0 : frame_ends[frame - 1] + 1;
+    for (std::size_t i = begin; i <= frame_ends[frame]; ++i) {
+        Replay(stream[i]);
+    }
+}
+
+void Player::Replay(const CTStreamElement& element) {
+    switch (element.type) {
+    case FrameMarker:
+        if (VideoCore::g_gpu_thread) {
+            VideoCore::g_gpu_thread->SwapBuffers();
+        } else {
+            VideoCore::g_renderer->SwapBuffers();
+        }
+        break;
+
+    case MemoryLoad: {
+        const auto& load = element.memory_load;
+        u8* dest = memory.GetPhysicalPointer(load.physical_address);
+        if (dest == nullptr) {
+            LOG_ERROR(HW_GPU, "Trace loads memory at invalid address {:#010X}",
+                      load.physical_address);
+            break;
+        }
+        // The rasterizer may cache the region, just like when the CPU writes to it
+        Memory::RasterizerFlushAndInvalidateRegion(load.physical_address, load.size);
+        std::memcpy(dest, memory_regions[load.file_offset].data(), load.size);
+        break;
+    }
+
+    case RegisterWrite: {
+        const auto& write = element.register_write;
+        const u32 addr = write.physical_address - Memory::IO_AREA_PADDR + Memory::IO_AREA_VADDR;
+        switch (write.size) {
+        case CTRegisterWrite::SIZE_8:
+            HW::Write<u8>(addr, static_cast<u8>(write.value));
+            break;
+        case CTRegisterWrite::SIZE_16:
+            HW::Write<u16>(addr, static_cast<u16>(write.value));
+            break;
+        case CTRegisterWrite::SIZE_32:
+            HW::Write<u32>(addr, static_cast<u32>(write.value));
+            break;
+        case CTRegisterWrite::SIZE_64:
+            HW::Write<u64>(addr, write.value);
+            break;
+        }
+        break;
+    }
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown stream element type {:#x}", static_cast<u32>(element.type));
+        break;
+    }
+}
+
+} // namespace CiTrace
@@ -0,0 +1,59 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/tracer/citrace.h"
+#include "core/tracer/recorder.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+namespace CiTrace {
+
+/**
+ * Replays a CiTrace on the emulated GPU without running any guest code. The memory loads and
+ * register writes of the trace are applied in the recorded order, which makes the GPU process the
+ * same command lists and display transfers as when recording. The whole trace is read and
+ * decompressed up front, so that replaying a frame only measures the work of the GPU.
+ */
+class Player {
+public:
+    explicit Player(Memory::MemorySystem& memory);
+    ~Player();
+
+    /// Reads the CiTrace file, returns false if it isn't a trace of a supported version
+    bool Load(const std::string& filename);
+
+    /// Returns the number of frames in the trace, the elements after the last frame are dropped
+    std::size_t GetNumFrames() const {
+        return frame_ends.size();
+    }
+
+    /// Resets the GPU, LCD and PICA state to the initial state of the trace
+    void LoadInitialState();
+
+    /// Replays the memory loads and register writes of the frame, then ends the frame
+    void ReplayFrame(std::size_t frame);
+
+private:
+    void Replay(const CTStreamElement& element);
+
+    Memory::MemorySystem& memory;
+
+    Recorder::InitialState initial_state;
+
+    /// Memory loads refer to the memory_regions by index instead of their file offset
+    std::vector<CTStreamElement> stream;
+    std::vector<std::vector<u8>> memory_regions;
+
+    /// Indices of the frame markers in the stream
+    std::vector<std::size_t> frame_ends;
+};
+
+} // namespace CiTrace
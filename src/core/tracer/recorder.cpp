@@ -3,18 +3,16 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
-#include "common/assert.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/zstd_compression.h"
 #include "core/tracer/recorder.h"
 
 namespace CiTrace {
 
-Recorder::Recorder(const InitialState& initial_state) : initial_state(initial_state) {}
-
-void Recorder::Finish(const std::string& filename) {
+Recorder::Recorder(const InitialState& initial_state, const std::string& filename)
+    : filename(filename), file(filename, "wb") {
     // Setup CiTrace header
-    CTHeader header;
     std::memcpy(header.magic, CTHeader::ExpectedMagicWord(), 4);
     header.version = CTHeader::ExpectedVersion();
     header.header_size = sizeof(CTHeader);
@@ -32,12 +30,10 @@ void Recorder::Finish(const std::string& filename) {
     initial.gs_program_binary_size = static_cast<u32>(initial_state.gs_program_binary.size());
     initial.gs_swizzle_data_size = static_cast<u32>(initial_state.gs_swizzle_data.size());
     initial.gs_float_uniforms_size = static_cast<u32>(initial_state.gs_float_uniforms.size());
-    header.stream_size = static_cast<u32>(stream.size());
 
     initial.gpu_registers = sizeof(header);
     initial.lcd_registers = initial.gpu_registers + initial.gpu_registers_size * sizeof(u32);
     initial.pica_registers = initial.lcd_registers + initial.lcd_registers_size * sizeof(u32);
-    ;
     initial.default_attributes = initial.pica_registers + initial.pica_registers_size * sizeof(u32);
     initial.vs_program_binary =
         initial.default_attributes + initial.default_attributes_size * sizeof(u32);
@@ -53,152 +49,118 @@ void Recorder::Finish(const std::string& filename) {
         initial.gs_swizzle_data + initial.gs_swizzle_data_size * sizeof(u32);
     header.stream_offset = initial.gs_float_uniforms + initial.gs_float_uniforms_size * sizeof(u32);
 
-    // Iterate through stream elements, update relevant stream element data
-    for (auto& stream_element : stream) {
-        switch (stream_element.data.type) {
-        case MemoryLoad: {
-            auto& file_offset = memory_regions[stream_element.hash];
-            if (!stream_element.uses_existing_data) {
-                file_offset = header.stream_offset;
-            }
-            stream_element.data.memory_load.file_offset = file_offset;
-            break;
-        }
+    // The stream size is filled in by Finish()
+    Write(&header, sizeof(header));
+    for (const auto* data :
+         {&initial_state.gpu_registers, &initial_state.lcd_registers,
+          &initial_state.pica_registers, &initial_state.default_attributes,
+          &initial_state.vs_program_binary, &initial_state.vs_swizzle_data,
+          &initial_state.vs_float_uniforms, &initial_state.gs_program_binary,
+          &initial_state.gs_swizzle_data, &initial_state.gs_float_uniforms}) {
+        Write(data->data(), data->size() * sizeof(u32));
+    }
 
-        default:
-            // Other commands don't use any extra data
-            DEBUG_ASSERT(stream_element.extra_data.size() == 0);
-            break;
-        }
-        header.stream_offset += static_cast<u32>(stream_element.extra_data.size());
+    if (IsGood() && file.Tell() != header.stream_offset) {
+        LOG_ERROR(HW_GPU, "Writing CiTrace file failed: Failed to write initial state");
+        file.Close();
     }
+}
 
-    try {
-        // Open file and write header
-        FileUtil::IOFile file(filename, "wb");
-        std::size_t written = file.WriteObject(header);
-        if (written != 1 || file.Tell() != initial.gpu_registers)
-            throw "Failed to write header";
-
-        // Write initial state
-        written =
-            file.WriteArray(initial_state.gpu_registers.data(), initial_state.gpu_registers.size());
-        if (written != initial_state.gpu_registers.size() || file.Tell() != initial.lcd_registers)
-            throw "Failed to write GPU registers";
-
-        written =
-            file.WriteArray(initial_state.lcd_registers.data(), initial_state.lcd_registers.size());
-        if (written != initial_state.lcd_registers.size() || file.Tell() != initial.pica_registers)
-            throw "Failed to write LCD registers";
-
-        written = file.WriteArray(initial_state.pica_registers.data(),
-                                  initial_state.pica_registers.size());
-        if (written != initial_state.pica_registers.size() ||
-            file.Tell() != initial.default_attributes)
-            throw "Failed to write Pica registers";
-
-        written = file.WriteArray(initial_state.default_attributes.data(),
-                                  initial_state.default_attributes.size());
-        if (written != initial_state.default_attributes.size() ||
-            file.Tell() != initial.vs_program_binary)
-            throw "Failed to write default vertex attributes";
-
-        written = file.WriteArray(initial_state.vs_program_binary.data(),
-                                  initial_state.vs_program_binary.size());
-        if (written != initial_state.vs_program_binary.size() ||
-            file.Tell() != initial.vs_swizzle_data)
-            throw "Failed to write vertex shader program binary";
-
-        written = file.WriteArray(initial_state.vs_swizzle_data.data(),
-                                  initial_state.vs_swizzle_data.size());
-        if (written != initial_state.vs_swizzle_data.size() ||
-            file.Tell() != initial.vs_float_uniforms)
-            throw "Failed to write vertex shader swizzle data";
-
-        written = file.WriteArray(initial_state.vs_float_uniforms.data(),
-                                  initial_state.vs_float_uniforms.size());
-        if (written != initial_state.vs_float_uniforms.size() ||
-            file.Tell() != initial.gs_program_binary)
-            throw "Failed to write vertex shader float uniforms";
-
-        written = file.WriteArray(initial_state.gs_program_binary.data(),
-                                  initial_state.gs_program_binary.size());
-        if (written != initial_state.gs_program_binary.size() ||
-            file.Tell() != initial.gs_swizzle_data)
-            throw "Failed to write geomtry shader program binary";
-
-        written = file.WriteArray(initial_state.gs_swizzle_data.data(),
-                                  initial_state.gs_swizzle_data.size());
-        if (written != initial_state.gs_swizzle_data.size() ||
-            file.Tell() != initial.gs_float_uniforms)
-            throw "Failed to write geometry shader swizzle data";
-
-        written = file.WriteArray(initial_state.gs_float_uniforms.data(),
-                                  initial_state.gs_float_uniforms.size());
-        if (written != initial_state.gs_float_uniforms.size() ||
-            file.Tell() != initial.gs_float_uniforms + sizeof(u32) * initial.gs_float_uniforms_size)
-            throw "Failed to write geometry shader float uniforms";
-
-        // Iterate through stream elements, write "extra data"
-        for (const auto& stream_element : stream) {
-            if (stream_element.extra_data.size() == 0)
-                continue;
-
-            written =
-                file.WriteBytes(stream_element.extra_data.data(), stream_element.extra_data.size());
-            if (written != stream_element.extra_data.size())
-                throw "Failed to write extra data";
-        }
+Recorder::~Recorder() = default;
+
+bool Recorder::IsGood() const {
+    return file.IsOpen() && file.IsGood();
+}
 
-        if (file.Tell() != header.stream_offset)
-            throw "Unexpected end of extra data";
+void Recorder::Finish() {
+    std::lock_guard lock{mutex};
+    if (!IsGood())
+        return;
 
-        // Write actual stream elements
-        for (const auto& stream_element : stream) {
-            if (1 != file.WriteObject(stream_element.data))
-                throw "Failed to write stream element";
-        }
-    } catch (const char* str) {
-        LOG_ERROR(HW_GPU, "Writing CiTrace file failed: {}", str);
+    if (!file.Seek(0, SEEK_SET) || file.WriteObject(header) != 1) {
+        LOG_ERROR(HW_GPU, "Writing CiTrace file failed: Failed to write header");
     }
+    file.Close();
+}
+
+void Recorder::Abort() {
+    std::lock_guard lock{mutex};
+    file.Close();
+    FileUtil::Delete(filename);
+}
+
+void Recorder::Write(const void* data, std::size_t size) {
+    if (!IsGood() || size == 0)
+        return;
+
+    if (file.WriteArray(static_cast<const u8*>(data), size) != size) {
+        LOG_ERROR(HW_GPU, "Writing CiTrace file failed: Failed to write {} bytes", size);
+        file.Close();
+    }
+}
+
+void Recorder::WriteElement(const CTStreamElement& element) {
+    Write(&element, sizeof(element));
+    ++header.stream_size;
 }
 
 void Recorder::FrameFinished() {
-    stream.push_back({{FrameMarker}});
+    std::lock_guard lock{mutex};
+    WriteElement({FrameMarker});
 }
 
 void Recorder::MemoryAccessed(const u8* data, u32 size, u32 physical_address) {
-    StreamElement element = {{MemoryLoad}};
-    element.data.memory_load.size = size;
-    element.data.memory_load.physical_address = physical_address;
+    CTStreamElement element = {MemoryLoad};
+    element.memory_load.size = size;
+    element.memory_load.physical_address = physical_address;
 
-    // Compute hash over given memory region to check if the contents are already stored internally
+    // Compute hash over given memory region to check if the contents are already stored in the file
     boost::crc_32_type result;
     result.process_bytes(data, size);
-    element.hash = result.checksum();
 
-    element.uses_existing_data = (memory_regions.find(element.hash) != memory_regions.end());
-    if (!element.uses_existing_data) {
-        element.extra_data.resize(size);
-        memcpy(element.extra_data.data(), data, size);
-        memory_regions.insert({element.hash, 0}); // file offset will be initialized in Finish()
+    std::lock_guard lock{mutex};
+    if (!IsGood())
+        return;
+
+    auto& region = memory_regions[result.checksum()];
+    if (region.size != size) {
+        // Compressing at the fastest level keeps up with the GPU, memory loads compress well
+        std::vector<u8> compressed = Common::Compression::CompressDataZSTD(data, size, 1);
+        const bool use_compressed = !compressed.empty() && compressed.size() < size;
+
+        region.file_offset = static_cast<u32>(file.Tell() + sizeof(element));
+        region.size = size;
+        region.compressed_size = use_compressed ? static_cast<u32>(compressed.size()) : 0;
+
+        element.memory_load.file_offset = region.file_offset;
+        element.memory_load.compressed_size = region.compressed_size;
+        WriteElement(element);
+        if (use_compressed) {
+            Write(compressed.data(), compressed.size());
+        } else {
+            Write(data, size);
+        }
+        return;
     }
 
-    stream.push_back(element);
+    element.memory_load.file_offset = region.file_offset;
+    element.memory_load.compressed_size = region.compressed_size;
+    WriteElement(element);
 }
 
 template <typename T>
 void Recorder::RegisterWritten(u32 physical_address, T value) {
-    StreamElement element = {{RegisterWrite}};
-    element.data.register_write.size =
+    CTStreamElement element = {RegisterWrite};
+    element.register_write.size =
         (sizeof(T) == 1) ? CTRegisterWrite::SIZE_8
                          : (sizeof(T) == 2) ? CTRegisterWrite::SIZE_16
                                             : (sizeof(T) == 4) ? CTRegisterWrite::SIZE_32
                                                                : CTRegisterWrite::SIZE_64;
-    element.data.register_write.physical_address = physical_address;
-    element.data.register_write.value = value;
+    element.register_write.physical_address = physical_address;
+    element.register_write.value = value;
 
-    stream.push_back(element);
+    std::lock_guard lock{mutex};
+    WriteElement(element);
 }
 
 template void Recorder::RegisterWritten(u32, u8);
@@ -4,11 +4,13 @@
 
 #pragma once
 
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <boost/crc.hpp>
 #include "common/common_types.h"
+#include "common/file_util.h"
 #include "core/tracer/citrace.h"
 
 namespace CiTrace {
@@ -29,13 +31,22 @@ public:
     };
 
     /**
-     * Recorder constructor
+     * Recorder constructor. The trace is streamed to the file while recording, so that it doesn't
+     * have to be kept in memory.
      * @param initial_state Initial recorder state
+     * @param filename Path of the CiTrace file to write
      */
-    explicit Recorder(const InitialState& initial_state);
+    Recorder(const InitialState& initial_state, const std::string& filename);
+    ~Recorder();
 
-    /// Finish recording of this Citrace and save it using the given filename.
-    void Finish(const std::string& filename);
+    /// Returns false if the CiTrace file couldn't be written
+    bool IsGood() const;
+
+    /// Finish recording of this Citrace, completing the header of the file.
+    void Finish();
+
+    /// Stop recording and delete the incomplete CiTrace file.
+    void Abort();
 
     /// Mark end of a frame
     void FrameFinished();
@@ -55,33 +66,31 @@ public:
     void RegisterWritten(u32 physical_address, T value);
 
 private:
-    // Initial state of recording start
-    InitialState initial_state;
-
-    // Command stream
-    struct StreamElement {
-        CTStreamElement data;
+    /// Memory contents already written to the file
+    struct StoredRegion {
+        u32 file_offset;
+        u32 size;
+        u32 compressed_size;
+    };
 
-        /**
-         * Extra data to store along "core" data.
-         * This is e.g. used for data used in MemoryUpdates.
-         */
-        std::vector<u8> extra_data;
+    /// Appends any data to the file, failing the recording if it can't be written
+    void Write(const void* data, std::size_t size);
 
-        /// Optional CRC hash (e.g. for hashing memory regions)
-        boost::crc_32_type::value_type hash;
+    /// Appends a stream element to the file and counts it in the header
+    void WriteElement(const CTStreamElement& element);
 
-        /// If true, refer to data already written to the output file instead of extra_data
-        bool uses_existing_data;
-    };
+    std::string filename;
+    FileUtil::IOFile file;
+    CTHeader header{};
 
-    std::vector<StreamElement> stream;
+    /// Elements are recorded from both the emulation thread and the GPU thread
+    std::mutex mutex;
 
     /**
-     * Internal cache which maps hashes of memory contents to file offsets at which those memory
-     * contents are stored.
+     * Internal cache which maps hashes of memory contents to the places in the file at which those
+     * memory contents are stored.
      */
-    std::unordered_map<boost::crc_32_type::value_type /*hash*/, u32 /*file_offset*/> memory_regions;
+    std::unordered_map<boost::crc_32_type::value_type /*hash*/, StoredRegion> memory_regions;
 };
 
 } // namespace CiTrace
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
@@ -9,7 +10,9 @@
 #include <regex>
 #include <string>
 #include <thread>
+#include <vector>
 #include <cryptopp/base64.h>
+#include <fmt/format.h>
 #include <glad/glad.h>
 
 #ifdef _WIN32
@@ -30,6 +33,7 @@
 #include "core/announce_multiplayer_session.h"
 #include "core/core.h"
 #include "core/settings.h"
+#include "dedicated_room/metrics_server.h"
 #include "network/network.h"
 #include "network/room.h"
 #include "network/verify_user.h"
@@ -50,6 +54,7 @@ static void PrintHelp(const char* argv0) {
                  "--room-name         The name of the room\n"
                  "--room-description  The room description\n"
                  "--port              The port used for the room\n"
+                 "--rooms             The number of rooms to host on consecutive ports\n"
                  "--max_members       The maximum number of players for this room\n"
                  "--password          The password for the room\n"
                  "--preferred-game    The preferred game for this room\n"
@@ -60,6 +65,9 @@ static void PrintHelp(const char* argv0) {
                  "--ban-list-file     The file for storing the room ban list\n"
                  "--log-file          The file for storing the room log\n"
                  "--enable-citra-mods Allow Citra Community Moderators to moderate on your room\n"
+                 "--metrics-port      Serve traffic metrics over HTTP on this port\n"
+                 "--max-beacons       The maximum number of beacons per second of each member\n"
+                 "--max-bandwidth     The maximum wifi traffic of each member in bytes per second\n"
                  "-h, --help          Display this help and exit\n"
                  "-v, --version       Output version information and exit\n";
 }
@@ -152,6 +160,104 @@ static void SaveBanList(const Network::Room::BanList& ban_list, const std::strin
     file.flush();
 }
 
+/// Merges the ban lists of all hosted rooms, so that a ban in any of them is kept
+static Network::Room::BanList MergeBanLists(
+    const std::vector<std::shared_ptr<Network::Room>>& rooms) {
+    Network::Room::BanList merged;
+    const auto merge = [](std::vector<std::string>& to, const std::vector<std::string>& from) {
+        for (const auto& entry : from) {
+            if (std::find(to.begin(), to.end(), entry) == to.end()) {
+                to.push_back(entry);
+            }
+        }
+    };
+    for (const auto& room : rooms) {
+        const Network::Room::BanList ban_list = room->GetBanList();
+        merge(merged.first, ban_list.first);
+        merge(merged.second, ban_list.second);
+    }
+    return merged;
+}
+
+/// Escapes a Prometheus label value
+static std::string EscapeLabel(const std::string& value) {
+    std::string escaped;
+    for (const char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/// Formats the traffic counters of the rooms in the Prometheus text exposition format
+static std::string FormatMetrics(const std::vector<std::shared_ptr<Network::Room>>& rooms) {
+    struct Counter {
+        const char* name;
+        const char* help;
+        u64 Network::Room::TrafficCounters::*value;
+    };
+    static constexpr Counter counters[] = {
+        {"packets_received_total", "Packets received from the clients",
+         &Network::Room::TrafficCounters::packets_received},
+        {"bytes_received_total", "Bytes received from the clients",
+         &Network::Room::TrafficCounters::bytes_received},
+        {"packets_sent_total", "Wifi packets forwarded to the clients",
+         &Network::Room::TrafficCounters::packets_sent},
+        {"bytes_sent_total", "Bytes of wifi packets forwarded to the clients",
+         &Network::Room::TrafficCounters::bytes_sent},
+        {"packets_dropped_total", "Wifi packets dropped by the traffic limits",
+         &Network::Room::TrafficCounters::packets_dropped},
+    };
+
+    std::vector<std::pair<std::string, Network::Room::TrafficStatistics>> statistics;
+    for (const auto& room : rooms) {
+        statistics.emplace_back(EscapeLabel(room->GetRoomInformation().name),
+                                room->GetTrafficStatistics());
+    }
+
+    std::string out;
+    out += "# HELP citra_room_members Members in the room\n# TYPE citra_room_members gauge\n";
+    for (const auto& [room, room_statistics] : statistics) {
+        out += fmt::format("citra_room_members{{room=\"{}\"}} {}\n", room,
+                           room_statistics.members.size());
+    }
+    for (const Counter& counter : counters) {
+        out += fmt::format("# HELP citra_room_{0} {1}\n# TYPE citra_room_{0} counter\n",
+                           counter.name, counter.help);
+        for (const auto& [room, room_statistics] : statistics) {
+            out += fmt::format("citra_room_{}{{room=\"{}\"}} {}\n", counter.name, room,
+                               room_statistics.room.*counter.value);
+        }
+        out += fmt::format("# HELP citra_room_member_{0} {1}\n"
+                           "# TYPE citra_room_member_{0} counter\n",
+                           counter.name, counter.help);
+        for (const auto& [room, room_statistics] : statistics) {
+            for (const auto& member : room_statistics.members) {
+                out += fmt::format("citra_room_member_{}{{room=\"{}\",member=\"{}\"}} {}\n",
+                                   counter.name, room, EscapeLabel(member.nickname),
+                                   member.counters.*counter.value);
+            }
+        }
+    }
+    out += "# HELP citra_room_member_round_trip_time_milliseconds Mean round trip time\n"
+           "# TYPE citra_room_member_round_trip_time_milliseconds gauge\n";
+    for (const auto& [room, room_statistics] : statistics) {
+        for (const auto& member : room_statistics.members) {
+            out += fmt::format(
+                "citra_room_member_round_trip_time_milliseconds{{room=\"{}\",member=\"{}\"}} "
+                "{}\n",
+                room, EscapeLabel(member.nickname), member.round_trip_time);
+        }
+    }
+    return out;
+}
+
 static void InitializeLogging(const std::string& log_file) {
     Log::AddBackend(std::make_unique<Log::ColorConsoleBackend>());
 
@@ -185,12 +291,18 @@ int main(int argc, char** argv) {
     u64 preferred_game_id = 0;
     u32 port = Network::DefaultRoomPort;
     u32 max_members = 16;
+    u32 num_rooms = 1;
+    u32 metrics_port = 0;
+    Network::Room::TrafficLimits traffic_limits;
+    // Real consoles send about ten beacons per second
+    traffic_limits.max_beacons_per_second = 20;
     bool enable_citra_mods = false;
 
     static struct option long_options[] = {
         {"room-name", required_argument, 0, 'n'},
         {"room-description", required_argument, 0, 'd'},
         {"port", required_argument, 0, 'p'},
+        {"rooms", required_argument, 0, 'r'},
         {"max_members", required_argument, 0, 'm'},
         {"password", required_argument, 0, 'w'},
         {"preferred-game", required_argument, 0, 'g'},
@@ -201,13 +313,17 @@ int main(int argc, char** argv) {
         {"ban-list-file", required_argument, 0, 'b'},
         {"log-file", required_argument, 0, 'l'},
         {"enable-citra-mods", no_argument, 0, 'e'},
+        {"metrics-port", required_argument, 0, 'x'},
+        {"max-beacons", required_argument, 0, 'c'},
+        {"max-bandwidth", required_argument, 0, 'k'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
         {0, 0, 0, 0},
     };
 
     while (optind < argc) {
-        int arg = getopt_long(argc, argv, "n:d:p:m:w:g:u:t:a:i:l:hv", long_options, &option_index);
+        int arg = getopt_long(argc, argv, "n:d:p:r:m:w:g:u:t:a:i:l:x:c:k:hv", long_options,
+                              &option_index);
         if (arg != -1) {
             switch (static_cast<char>(arg)) {
             case 'n':
@@ -219,6 +335,9 @@ int main(int argc, char** argv) {
             case 'p':
                 port = strtoul(optarg, &endarg, 0);
                 break;
+            case 'r':
+                num_rooms = strtoul(optarg, &endarg, 0);
+                break;
             case 'm':
                 max_members = strtoul(optarg, &endarg, 0);
                 break;
@@ -249,6 +368,15 @@ int main(int argc, char** argv) {
             case 'e':
                 enable_citra_mods = true;
                 break;
+            case 'x':
+                metrics_port = strtoul(optarg, &endarg, 0);
+                break;
+            case 'c':
+                traffic_limits.max_beacons_per_second = strtoul(optarg, &endarg, 0);
+                break;
+            case 'k':
+                traffic_limits.max_bytes_per_second = strtoul(optarg, &endarg, 0);
+                break;
             case 'h':
                 PrintHelp(argv[0]);
                 return 0;
@@ -284,6 +412,16 @@ int main(int argc, char** argv) {
         PrintHelp(argv[0]);
         return -1;
     }
+    if (metrics_port > 65535) {
+        std::cout << "metrics-port needs to be in the range 0 - 65535!\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
+    if (num_rooms < 1 || port + num_rooms - 1 > 65535) {
+        std::cout << "rooms needs to be at least 1 and all rooms need a port below 65536!\n\n";
+        PrintHelp(argv[0]);
+        return -1;
+    }
     if (ban_list_file.empty()) {
         std::cout << "Ban list file not set!\nThis should get set to load and save room ban "
                      "list.\nSet with --ban-list-file <file>\n\n";
@@ -324,28 +462,63 @@ int main(int argc, char** argv) {
         ban_list = LoadBanList(ban_list_file);
     }
 
-    std::unique_ptr<Network::VerifyUser::Backend> verify_backend;
+#ifndef ENABLE_WEB_SERVICE
     if (announce) {
-#ifdef ENABLE_WEB_SERVICE
-        verify_backend = std::make_unique<WebService::VerifyUserJWT>(Settings::values.web_api_url);
-#else
         std::cout
             << "Citra Web Services is not available with this build: validation is disabled.\n\n";
-        verify_backend = std::make_unique<Network::VerifyUser::NullBackend>();
-#endif
-    } else {
-        verify_backend = std::make_unique<Network::VerifyUser::NullBackend>();
     }
+#endif
+    const auto make_verify_backend = [announce]() -> std::unique_ptr<Network::VerifyUser::Backend> {
+#ifdef ENABLE_WEB_SERVICE
+        if (announce) {
+            return std::make_unique<WebService::VerifyUserJWT>(Settings::values.web_api_url);
+        }
+#endif
+        return std::make_unique<Network::VerifyUser::NullBackend>();
+    };
 
     Network::Init();
     if (std::shared_ptr<Network::Room> room = Network::GetRoom().lock()) {
         if (!room->Create(room_name, room_description, "", port, password, max_members, username,
-                          preferred_game, preferred_game_id, std::move(verify_backend), ban_list,
+                          preferred_game, preferred_game_id, make_verify_backend(), ban_list,
                           enable_citra_mods)) {
             std::cout << "Failed to create room: \n\n";
             return -1;
         }
-        std::cout << "Room is open. Close with Q+Enter...\n\n";
+
+        // Every room runs its own server thread, so hosting several rooms in one process spreads
+        // their traffic over several cores. Only the first room is announced.
+        std::vector<std::shared_ptr<Network::Room>> rooms{room};
+        for (u32 i = 1; i < num_rooms; ++i) {
+            auto extra_room = std::make_shared<Network::Room>();
+            const std::string extra_name = room_name + " (" + std::to_string(i + 1) + ")";
+            if (!extra_room->Create(extra_name, room_description, "", port + i, password,
+                                    max_members, username, preferred_game, preferred_game_id,
+                                    make_verify_backend(), ban_list, enable_citra_mods)) {
+                std::cout << "Failed to create room on port " << port + i << "\n\n";
+                for (const auto& open_room : rooms) {
+                    open_room->Destroy();
+                }
+                return -1;
+            }
+            rooms.push_back(std::move(extra_room));
+        }
+        for (const auto& open_room : rooms) {
+            open_room->SetTrafficLimits(traffic_limits);
+        }
+
+        std::unique_ptr<MetricsServer> metrics_server;
+        if (metrics_port != 0) {
+            metrics_server = std::make_unique<MetricsServer>(
+                static_cast<u16>(metrics_port), [&rooms] { return FormatMetrics(rooms); });
+        }
+
+        if (num_rooms > 1) {
+            std::cout << num_rooms << " rooms are open on ports " << port << " - "
+                      << port + num_rooms - 1 << ". Close with Q+Enter...\n\n";
+        } else {
+            std::cout << "Room is open. Close with Q+Enter...\n\n";
+        }
         auto announce_session = std::make_unique<Core::AnnounceMultiplayerSession>();
         if (announce) {
             announce_session->Start();
@@ -362,11 +535,14 @@ int main(int argc, char** argv) {
             announce_session->Stop();
         }
         announce_session.reset();
+        metrics_server.reset();
         // Save the ban list
         if (!ban_list_file.empty()) {
-            SaveBanList(room->GetBanList(), ban_list_file);
+            SaveBanList(MergeBanLists(rooms), ban_list_file);
+        }
+        for (const auto& open_room : rooms) {
+            open_room->Destroy();
         }
-        room->Destroy();
     }
     Network::Shutdown();
     detached_tasks.WaitForAllTasks();
@@ -0,0 +1,120 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <thread>
+#include <boost/asio.hpp>
+#include <fmt/format.h>
+#include "common/logging/log.h"
+#include "dedicated_room/metrics_server.h"
+
+namespace {
+/// Requests with a longer header are answered with an error
+constexpr std::size_t MAX_REQUEST_SIZE = 8192;
+} // Anonymous namespace
+
+class MetricsServer::Impl {
+public:
+    Impl(u16 port, Collector collector) : acceptor(io_context), collector(std::move(collector)) {
+        const boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::tcp::v4(), port);
+        boost::system::error_code error;
+        acceptor.open(endpoint.protocol(), error);
+        if (!error)
+            acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true), error);
+        if (!error)
+            acceptor.bind(endpoint, error);
+        if (!error)
+            acceptor.listen(boost::asio::socket_base::max_listen_connections, error);
+        if (error) {
+            LOG_ERROR(Network, "Failed to open the metrics endpoint on port {}: {}", port,
+                      error.message());
+            return;
+        }
+
+        LOG_INFO(Network, "Serving metrics on port {}", port);
+        StartAccept();
+        worker_thread = std::thread([this] { io_context.run(); });
+    }
+
+    ~Impl() {
+        io_context.stop();
+        if (worker_thread.joinable())
+            worker_thread.join();
+    }
+
+private:
+    class Connection : public std::enable_shared_from_this<Connection> {
+    public:
+        Connection(boost::asio::ip::tcp::socket socket, Impl& server)
+            : socket(std::move(socket)), server(server), request(MAX_REQUEST_SIZE) {}
+
+        void Start() {
+            boost::asio::async_read_until(
+                socket, request, "\r\n\r\n",
+                [self = shared_from_this()](const boost::system::error_code& error, std::size_t) {
+                    if (error == boost::asio::error::not_found)
+                        return self->Reply("431 Request Header Fields Too Large", "");
+                    if (error)
+                        return;
+                    self->HandleRequest();
+                });
+        }
+
+    private:
+        void HandleRequest() {
+            std::istream stream(&request);
+            std::string method;
+            std::string target;
+            stream >> method >> target;
+            if (method != "GET")
+                return Reply("405 Method Not Allowed", "");
+            if (target != "/metrics")
+                return Reply("404 Not Found", "");
+            Reply("200 OK", server.collector());
+        }
+
+        void Reply(const char* status, const std::string& body) {
+            response = fmt::format("HTTP/1.1 {}\r\n"
+                                   "Content-Type: text/plain; version=0.0.4\r\n"
+                                   "Content-Length: {}\r\n"
+                                   "Connection: close\r\n\r\n{}",
+                                   status, body.size(), body);
+            boost::asio::async_write(
+                socket, boost::asio::buffer(response),
+                [self = shared_from_this()](const boost::system::error_code&, std::size_t) {
+                    boost::system::error_code error;
+                    self->socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+                    self->socket.close(error);
+                });
+        }
+
+        boost::asio::ip::tcp::socket socket;
+        Impl& server;
+        boost::asio::streambuf request;
+        std::string response;
+    };
+
+    void StartAccept() {
+        acceptor.async_accept([this](const boost::system::error_code& error,
+                                     boost::asio::ip::tcp::socket socket) {
+            if (error) {
+                LOG_WARNING(Network, "Failed to accept metrics connection: {}", error.message());
+            } else {
+                std::make_shared<Connection>(std::move(socket), *this)->Start();
+            }
+            StartAccept();
+        });
+    }
+
+    std::thread worker_thread;
+
+    boost::asio::io_context io_context;
+    boost::asio::ip::tcp::acceptor acceptor;
+
+    Collector collector;
+};
+
+MetricsServer::MetricsServer(u16 port, Collector collector)
+    : impl(std::make_unique<Impl>(port, std::move(collector))) {}
+
+MetricsServer::~MetricsServer() = default;
@@ -0,0 +1,27 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include "common/common_types.h"
+
+/**
+ * Minimal HTTP server answering GET /metrics with the text returned by the collector, which is
+ * meant to be in the Prometheus text exposition format. The collector is called on the thread of
+ * the server.
+ */
+class MetricsServer {
+public:
+    using Collector = std::function<std::string()>;
+
+    MetricsServer(u16 port, Collector collector);
+    ~MetricsServer();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl;
+};
@@ -5,12 +5,14 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <functional>
 #include <thread>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include "common/logging/log.h"
+#include "common/string_util.h"
 #include "input_common/udp/client.h"
 #include "input_common/udp/protocol.h"
 
@@ -28,19 +30,17 @@ class Socket {
 public:
     using clock = std::chrono::system_clock;
 
-    explicit Socket(const std::string& host, u16 port, u8 pad_index, u32 client_id,
-                    SocketCallback callback)
+    explicit Socket(boost::asio::io_service& io_service, const std::string& host, u16 port,
+                    u8 pad_index, u32 client_id, SocketCallback callback)
         : callback(std::move(callback)), timer(io_service),
           socket(io_service, udp::endpoint(udp::v4(), 0)), client_id(client_id),
           pad_index(pad_index),
           send_endpoint(udp::endpoint(boost::asio::ip::make_address_v4(host), port)) {}
 
-    void Stop() {
-        io_service.stop();
-    }
-
-    void Loop() {
-        io_service.run();
+    /// Queues the first receive and send, the io_service the socket was created with runs them
+    void Start() {
+        StartReceive();
+        StartSend(clock::now());
     }
 
     void StartSend(const clock::time_point& from) {
@@ -100,7 +100,6 @@ private:
     }
 
     SocketCallback callback;
-    boost::asio::io_service io_service;
     boost::asio::basic_waitable_timer<clock> timer;
     udp::socket socket;
 
@@ -117,12 +116,15 @@ private:
     udp::endpoint receive_endpoint;
 };
 
-static void SocketLoop(Socket* socket) {
-    socket->StartReceive();
-    socket->StartSend(Socket::clock::now());
-    socket->Loop();
+static void SocketLoop(boost::asio::io_service* io_service) {
+    io_service->run();
 }
 
+struct Client::Connections {
+    boost::asio::io_service io_service;
+    std::vector<std::unique_ptr<Socket>> sockets;
+};
+
 Client::Client(std::shared_ptr<DeviceStatus> status, const std::string& host, u16 port,
                u8 pad_index, u32 client_id)
     : status(std::move(status)) {
@@ -130,13 +132,11 @@ Client::Client(std::shared_ptr<DeviceStatus> status, const std::string& host, u1
 }
 
 Client::~Client() {
-    socket->Stop();
-    thread.join();
+    StopCommunication();
 }
 
 void Client::ReloadSocket(const std::string& host, u16 port, u8 pad_index, u32 client_id) {
-    socket->Stop();
-    thread.join();
+    StopCommunication();
     StartCommunication(host, port, pad_index, client_id);
 }
 
@@ -148,8 +148,9 @@ void Client::OnPortInfo(Response::PortInfo data) {
     LOG_TRACE(Input, "PortInfo packet received: {}", data.model);
 }
 
-void Client::OnPadData(Response::PadData data) {
+void Client::OnPadData(std::size_t server, Response::PadData data) {
     LOG_TRACE(Input, "PadData packet received");
+    u64& packet_sequence = packet_sequences[server];
     if (data.packet_counter <= packet_sequence) {
         LOG_WARNING(
             Input,
@@ -158,6 +159,7 @@ void Client::OnPadData(Response::PadData data) {
         return;
     }
     packet_sequence = data.packet_counter;
+    const auto timestamp = std::chrono::steady_clock::now();
     // Due to differences between the 3ds and cemuhookudp motion directions, we need to invert
     // accel.x and accel.z and also invert pitch and yaw. See
     // https://github.com/citra-emu/citra/pull/4049 for more details on gyro/accel
@@ -167,6 +169,8 @@ void Client::OnPadData(Response::PadData data) {
         std::lock_guard guard(status->update_mutex);
 
         status->motion_status = {accel, gyro};
+        const std::size_t sample_index = status->motion_sample_count++ % MOTION_HISTORY_SIZE;
+        status->motion_history[sample_index] = {timestamp, accel, gyro};
 
         // TODO: add a setting for "click" touch. Click touch refers to a device that differentiates
         // between a simple "tap" and a hard press that causes the touch screen to click.
@@ -192,12 +196,49 @@ void Client::OnPadData(Response::PadData data) {
 }
 
 void Client::StartCommunication(const std::string& host, u16 port, u8 pad_index, u32 client_id) {
-    SocketCallback callback{[this](Response::Version version) { OnVersion(version); },
-                            [this](Response::PortInfo info) { OnPortInfo(info); },
-                            [this](Response::PadData data) { OnPadData(data); }};
-    LOG_INFO(Input, "Starting communication with UDP input server on {}:{}", host, port);
-    socket = std::make_unique<Socket>(host, port, pad_index, client_id, callback);
-    thread = std::thread{SocketLoop, this->socket.get()};
+    connections = std::make_unique<Connections>();
+
+    std::vector<std::string> servers;
+    Common::SplitString(host, ',', servers);
+    for (std::string& server : servers) {
+        server = Common::StripSpaces(server);
+        if (server.empty())
+            continue;
+
+        std::string server_host = server;
+        u16 server_port = port;
+        const std::size_t colon = server.find(':');
+        if (colon != std::string::npos) {
+            server_host = server.substr(0, colon);
+            const std::string port_string = server.substr(colon + 1);
+            char* end;
+            const unsigned long parsed_port = std::strtoul(port_string.c_str(), &end, 10);
+            if (port_string.empty() || *end != '\0' || parsed_port > 0xFFFF) {
+                LOG_ERROR(Input, "Invalid port of UDP input server {}", server);
+                continue;
+            }
+            server_port = static_cast<u16>(parsed_port);
+        }
+
+        const std::size_t index = connections->sockets.size();
+        SocketCallback callback{[this](Response::Version version) { OnVersion(version); },
+                                [this](Response::PortInfo info) { OnPortInfo(info); },
+                                [this, index](Response::PadData data) { OnPadData(index, data); }};
+        LOG_INFO(Input, "Starting communication with UDP input server on {}:{}", server_host,
+                 server_port);
+        connections->sockets.push_back(std::make_unique<Socket>(
+            connections->io_service, server_host, server_port, pad_index, client_id, callback));
+        connections->sockets.back()->Start();
+    }
+
+    packet_sequences.assign(connections->sockets.size(), 0);
+    thread = std::thread{SocketLoop, &connections->io_service};
+}
+
+void Client::StopCommunication() {
+    connections->io_service.stop();
+    thread.join();
+    connections.reset();
 }
 
 void TestCommunication(const std::string& host, u16 port, u8 pad_index, u32 client_id,
@@ -207,10 +248,12 @@ void TestCommunication(const std::string& host, u16 port, u8 pad_index, u32 clie
         Common::Event success_event;
         SocketCallback callback{[](Response::Version version) {}, [](Response::PortInfo info) {},
                                 [&](Response::PadData data) { success_event.Set(); }};
-        Socket socket{host, port, pad_index, client_id, std::move(callback)};
-        std::thread worker_thread{SocketLoop, &socket};
+        boost::asio::io_service io_service;
+        Socket socket{io_service, host, port, pad_index, client_id, std::move(callback)};
+        socket.Start();
+        std::thread worker_thread{SocketLoop, &io_service};
         bool result = success_event.WaitFor(std::chrono::seconds(8));
-        socket.Stop();
+        io_service.stop();
         worker_thread.join();
         if (result)
             success_callback();
@@ -263,10 +306,12 @@ CalibrationConfigurationJob::CalibrationConfigurationJob(
                                         complete_event.Set();
                                     }
                                 }};
-        Socket socket{host, port, pad_index, client_id, std::move(callback)};
-        std::thread worker_thread{SocketLoop, &socket};
+        boost::asio::io_service io_service;
+        Socket socket{io_service, host, port, pad_index, client_id, std::move(callback)};
+        socket.Start();
+        std::thread worker_thread{SocketLoop, &io_service};
         complete_event.Wait();
-        socket.Stop();
+        io_service.stop();
         worker_thread.join();
     })
         .detach();
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -11,15 +12,20 @@
 #include <string>
 #include <thread>
 #include <tuple>
+#include <vector>
 #include "common/common_types.h"
 #include "common/thread.h"
 #include "common/vector_math.h"
+#include "core/frontend/input.h"
 
 namespace InputCommon::CemuhookUDP {
 
 static constexpr u16 DEFAULT_PORT = 26760;
 static constexpr const char* DEFAULT_ADDR = "127.0.0.1";
 
+/// Number of motion samples kept for the motion devices, servers send up to 1000 per second
+static constexpr std::size_t MOTION_HISTORY_SIZE = 64;
+
 class Socket;
 
 namespace Response {
@@ -33,6 +39,10 @@ struct DeviceStatus {
     std::tuple<Common::Vec3<float>, Common::Vec3<float>> motion_status;
     std::tuple<float, float, bool> touch_status;
 
+    /// Ring buffer of the last motion samples, indexed by the running count of samples
+    std::array<Input::MotionSample, MOTION_HISTORY_SIZE> motion_history;
+    u64 motion_sample_count = 0;
+
     // calibration data for scaling the device's touch area to 3ds
     struct CalibrationData {
         u16 min_x;
@@ -43,6 +53,11 @@ struct DeviceStatus {
     std::optional<CalibrationData> touch_calibration;
 };
 
+/**
+ * Receives the pad data of one or more servers. The host can be a comma separated list of servers,
+ * each of them optionally followed by its own port ("host:port"). All sockets are served by a
+ * single thread.
+ */
 class Client {
 public:
     explicit Client(std::shared_ptr<DeviceStatus> status, const std::string& host = DEFAULT_ADDR,
@@ -52,15 +67,18 @@ public:
                       u32 client_id = 24872);
 
 private:
+    struct Connections;
+
     void OnVersion(Response::Version);
     void OnPortInfo(Response::PortInfo);
-    void OnPadData(Response::PadData);
+    void OnPadData(std::size_t server, Response::PadData);
     void StartCommunication(const std::string& host, u16 port, u8 pad_index, u32 client_id);
+    void StopCommunication();
 
-    std::unique_ptr<Socket> socket;
+    std::unique_ptr<Connections> connections;
     std::shared_ptr<DeviceStatus> status;
     std::thread thread;
-    u64 packet_sequence = 0;
+    std::vector<u64> packet_sequences;
 };
 
 /// An async job allowing configuration of the touchpad calibration.
@@ -4,6 +4,7 @@
 
 #include <mutex>
 #include <tuple>
+#include <vector>
 #include "common/param_package.h"
 #include "core/frontend/input.h"
 #include "core/settings.h"
@@ -26,14 +27,30 @@ private:
 
 class UDPMotionDevice final : public Input::MotionDevice {
 public:
-    explicit UDPMotionDevice(std::shared_ptr<DeviceStatus> status_) : status(std::move(status_)) {}
+    explicit UDPMotionDevice(std::shared_ptr<DeviceStatus> status_) : status(std::move(status_)) {
+        std::lock_guard guard(status->update_mutex);
+        next_sample = status->motion_sample_count;
+    }
     std::tuple<Common::Vec3<float>, Common::Vec3<float>> GetStatus() const override {
         std::lock_guard guard(status->update_mutex);
         return status->motion_status;
     }
 
+    bool PopSamples(std::vector<Input::MotionSample>& samples) override {
+        std::lock_guard guard(status->update_mutex);
+        const u64 count = status->motion_sample_count;
+        // Samples that were overwritten since the last call are lost
+        if (count - next_sample > MOTION_HISTORY_SIZE)
+            next_sample = count - MOTION_HISTORY_SIZE;
+        for (; next_sample < count; ++next_sample) {
+            samples.push_back(status->motion_history[next_sample % MOTION_HISTORY_SIZE]);
+        }
+        return true;
+    }
+
 private:
     std::shared_ptr<DeviceStatus> status;
+    u64 next_sample;
 };
 
 class UDPTouchFactory final : public Input::Factory<Input::TouchDevice> {
@@ -0,0 +1,57 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+#include "common/logging/filter.h"
+#include "common/logging/text_formatter.h"
+
+static void PrintHelp(const char* argv0) {
+    std::printf("Usage: %s [options] <citra_log.bin>\n"
+                "Converts a binary log of Citra to text, written to the standard output.\n"
+                "-f, --filter=FILTER  Only print the messages passing the filter, e.g. "
+                "\"*:Info Service.FS:Trace\"\n"
+                "-h, --help           Display this help and exit\n",
+                argv0);
+}
+
+int main(int argc, char** argv) {
+    Log::Filter filter(Log::Level::Trace);
+    std::string filename;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            PrintHelp(argv[0]);
+            return 0;
+        } else if ((arg == "-f" || arg == "--filter") && i + 1 < argc) {
+            filter.ParseFilterString(argv[++i]);
+        } else if (arg.rfind("--filter=", 0) == 0) {
+            filter.ParseFilterString(arg.substr(std::strlen("--filter=")));
+        } else if (filename.empty() && arg[0] != '-') {
+            filename = arg;
+        } else {
+            PrintHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    if (filename.empty()) {
+        PrintHelp(argv[0]);
+        return 1;
+    }
+
+    const bool success = Log::Binary::DecodeFile(filename, [&filter](const Log::Entry& entry) {
+        if (filter.CheckMessage(entry.log_class, entry.log_level)) {
+            std::puts(Log::FormatLogMessage(entry).c_str());
+        }
+    });
+    if (!success) {
+        std::fprintf(stderr, "%s is not a binary log\n", filename.c_str());
+        return 1;
+    }
+    return 0;
+}
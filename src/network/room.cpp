@@ -4,20 +4,70 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <mutex>
 #include <random>
 #include <regex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include "common/logging/log.h"
 #include "enet/enet.h"
 #include "network/packet.h"
 #include "network/room.h"
+#include "network/room_member.h"
 #include "network/verify_user.h"
 
 namespace Network {
 
+namespace {
+/// Packs a MAC address into an integer, used as the key of the routing table
+u64 MacAddressKey(const MacAddress& address) {
+    u64 key = 0;
+    for (const u8 byte : address) {
+        key = (key << 8) | byte;
+    }
+    return key;
+}
+
+/// Reads a u32 the way Packet writes it, in network byte order
+u32 ReadNetworkU32(const u8* data) {
+    return (u32{data[0]} << 24) | (u32{data[1]} << 16) | (u32{data[2]} << 8) | u32{data[3]};
+}
+
+/**
+ * Checks that a batch of wifi packets holds exactly the entries its header announces and that
+ * none of them is a beacon. Members send beacons on their own only, where the beacon limit applies
+ * to them, so a batch carrying beacons is an attempt to get around it.
+ */
+bool IsValidWifiPacketBatch(const ENetPacket* packet) {
+    // Message type, destination and number of packets
+    constexpr std::size_t header_size = sizeof(u8) + sizeof(MacAddress) + sizeof(u32);
+    // Type, channel, transmitter and the size of the data before the data itself
+    constexpr std::size_t entry_header_size = 2 * sizeof(u8) + sizeof(MacAddress) + sizeof(u32);
+    constexpr u8 beacon_type = static_cast<u8>(WifiPacket::PacketType::Beacon);
+
+    const u8* const data = packet->data;
+    const std::size_t size = packet->dataLength;
+    if (size < header_size)
+        return false;
+    const u32 count = ReadNetworkU32(data + header_size - sizeof(u32));
+    std::size_t offset = header_size;
+    for (u32 i = 0; i < count; ++i) {
+        if (size - offset < entry_header_size || data[offset] == beacon_type)
+            return false;
+        const u32 data_size = ReadNetworkU32(data + offset + entry_header_size - sizeof(u32));
+        offset += entry_header_size;
+        if (size - offset < data_size)
+            return false;
+        offset += data_size;
+    }
+    return offset == size;
+}
+} // Anonymous namespace
+
 class Room::RoomImpl {
 public:
     // This MAC address is used to generate a 'Nintendo' like Mac address.
@@ -46,6 +96,29 @@ public:
     using MemberList = std::vector<Member>;
     MemberList members;              ///< Information about the members of this room
     mutable std::mutex member_mutex; ///< Mutex for locking the members list
+    /// The peer of each member by its MAC address, guarded by member_mutex. Looked up for every
+    /// unicast wifi packet.
+    std::unordered_map<u64, ENetPeer*> peers_by_mac;
+
+    using Clock = std::chrono::steady_clock;
+
+    /// Traffic counters and traffic limiter state of a member
+    struct Traffic {
+        TrafficCounters counters;
+        u32 round_trip_time = 0;
+        Clock::time_point beacon_window_start{};
+        u32 beacons_in_window = 0;
+        Clock::time_point last_refill{};
+        double byte_budget = 0.0; ///< Bytes the member may still send, refilled over time
+    };
+    std::unordered_map<const ENetPeer*, Traffic> traffic_by_peer; ///< Guarded by member_mutex
+    TrafficCounters room_traffic;                                 ///< Guarded by member_mutex
+    TrafficLimits traffic_limits;                                 ///< Guarded by member_mutex
+    /// When the round trip times were last copied from the peers, only used by the room thread
+    Clock::time_point last_rtt_sample{};
+    /// Set when the room information changed but hasn't been broadcast yet. Only used by the room
+    /// thread, which broadcasts it once all events that are already queued have been handled.
+    bool room_information_dirty = false;
     /// This should be a std::shared_mutex as soon as C++17 is supported
 
     UsernameBanList username_ban_list; ///< List of banned usernames
@@ -65,6 +138,27 @@ public:
     void ServerLoop();
     void StartLoop();
 
+    /// Dispatches a single event received by the server.
+    void HandleEvent(ENetEvent& event);
+
+    /// Removes a member from the members list and the lookup tables, member_mutex must be held.
+    void EraseMember(MemberList::iterator member);
+
+    /// Adds a packet received from the peer to the traffic counters.
+    void CountReceivedPacket(const ENetPeer* peer, std::size_t size);
+
+    /// Adds a wifi packet forwarded to the peer to the traffic counters, member_mutex must be held.
+    void CountSentPacket(const ENetPeer* peer, std::size_t size);
+
+    /**
+     * Applies the traffic limits to a wifi packet sent by a member, member_mutex must be held.
+     * @returns whether the packet may be forwarded
+     */
+    bool AdmitWifiPacket(Traffic& traffic, const ENetPacket* packet, Clock::time_point now);
+
+    /// Copies the round trip times measured by ENet into the traffic counters once a second.
+    void SampleRoundTripTimes();
+
     /**
      * Parses and answers a room join request from a client.
      * Validates the uniqueness of the username and assigns the MAC address
@@ -216,6 +310,9 @@ public:
      */
     void BroadcastRoomInformation();
 
+    /// Marks the room information as changed, coalescing the broadcasts of a burst of changes.
+    void InvalidateRoomInformation();
+
     /**
      * Generates a free MAC address to assign to a new client.
      * The first 3 bytes are the NintendoOUI 0x00, 0x1F, 0x32
@@ -223,7 +320,9 @@ public:
     MacAddress GenerateMacAddress();
 
     /**
-     * Broadcasts this packet to all members except the sender.
+     * Broadcasts this packet to all members except the sender, or sends it only to the member
+     * with the destination MAC address. The received ENet packet is forwarded as is instead of
+     * being copied, so it must only be destroyed by the caller once nobody references it anymore.
      * @param event The ENet event containing the data
      */
     void HandleWifiPacket(const ENetEvent* event);
@@ -252,50 +351,141 @@ void Room::RoomImpl::ServerLoop() {
     while (state != State::Closed) {
         ENetEvent event;
         if (enet_host_service(server, &event, 50) > 0) {
-            switch (event.type) {
-            case ENET_EVENT_TYPE_RECEIVE:
-                switch (event.packet->data[0]) {
-                case IdJoinRequest:
-                    HandleJoinRequest(&event);
-                    break;
-                case IdSetGameInfo:
-                    HandleGameNamePacket(&event);
-                    break;
-                case IdWifiPacket:
-                    HandleWifiPacket(&event);
-                    break;
-                case IdChatMessage:
-                    HandleChatPacket(&event);
-                    break;
-                // Moderation
-                case IdModKick:
-                    HandleModKickPacket(&event);
-                    break;
-                case IdModBan:
-                    HandleModBanPacket(&event);
-                    break;
-                case IdModUnban:
-                    HandleModUnbanPacket(&event);
-                    break;
-                case IdModGetBanList:
-                    HandleModGetBanListPacket(&event);
-                    break;
-                }
-                enet_packet_destroy(event.packet);
-                break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-                HandleClientDisconnection(event.peer);
-                break;
-            case ENET_EVENT_TYPE_NONE:
-            case ENET_EVENT_TYPE_CONNECT:
-                break;
+            // Handle everything that has arrived in the meantime before sending anything, so that
+            // a busy room sends its outgoing packets and room information once per batch of events
+            // instead of once per event.
+            do {
+                HandleEvent(event);
+            } while (enet_host_check_events(server, &event) > 0);
+
+            if (room_information_dirty) {
+                BroadcastRoomInformation();
             }
+            enet_host_flush(server);
         }
+        SampleRoundTripTimes();
     }
     // Close the connection to all members:
     SendCloseMessage();
 }
 
+void Room::RoomImpl::HandleEvent(ENetEvent& event) {
+    switch (event.type) {
+    case ENET_EVENT_TYPE_RECEIVE:
+        CountReceivedPacket(event.peer, event.packet->dataLength);
+        switch (event.packet->data[0]) {
+        case IdJoinRequest:
+            HandleJoinRequest(&event);
+            break;
+        case IdSetGameInfo:
+            HandleGameNamePacket(&event);
+            break;
+        case IdWifiPacket:
+        case IdWifiPacketBatch:
+            HandleWifiPacket(&event);
+            break;
+        case IdChatMessage:
+            HandleChatPacket(&event);
+            break;
+        // Moderation
+        case IdModKick:
+            HandleModKickPacket(&event);
+            break;
+        case IdModBan:
+            HandleModBanPacket(&event);
+            break;
+        case IdModUnban:
+            HandleModUnbanPacket(&event);
+            break;
+        case IdModGetBanList:
+            HandleModGetBanListPacket(&event);
+            break;
+        }
+        // Forwarded packets are destroyed by ENet once they have been sent to every peer
+        if (event.packet->referenceCount == 0) {
+            enet_packet_destroy(event.packet);
+        }
+        break;
+    case ENET_EVENT_TYPE_DISCONNECT:
+        HandleClientDisconnection(event.peer);
+        break;
+    case ENET_EVENT_TYPE_NONE:
+    case ENET_EVENT_TYPE_CONNECT:
+        break;
+    }
+}
+
+void Room::RoomImpl::EraseMember(MemberList::iterator member) {
+    peers_by_mac.erase(MacAddressKey(member->mac_address));
+    traffic_by_peer.erase(member->peer);
+    members.erase(member);
+}
+
+void Room::RoomImpl::CountReceivedPacket(const ENetPeer* peer, std::size_t size) {
+    std::lock_guard lock(member_mutex);
+    ++room_traffic.packets_received;
+    room_traffic.bytes_received += size;
+    const auto traffic = traffic_by_peer.find(peer);
+    if (traffic != traffic_by_peer.end()) {
+        ++traffic->second.counters.packets_received;
+        traffic->second.counters.bytes_received += size;
+    }
+}
+
+void Room::RoomImpl::CountSentPacket(const ENetPeer* peer, std::size_t size) {
+    ++room_traffic.packets_sent;
+    room_traffic.bytes_sent += size;
+    const auto traffic = traffic_by_peer.find(peer);
+    if (traffic != traffic_by_peer.end()) {
+        ++traffic->second.counters.packets_sent;
+        traffic->second.counters.bytes_sent += size;
+    }
+}
+
+bool Room::RoomImpl::AdmitWifiPacket(Traffic& traffic, const ENetPacket* packet,
+                                     Clock::time_point now) {
+    constexpr u8 beacon_type = static_cast<u8>(WifiPacket::PacketType::Beacon);
+    // Batches carrying beacons are rejected before they get here
+    if (traffic_limits.max_beacons_per_second != 0 && packet->data[0] == IdWifiPacket &&
+        packet->data[1] == beacon_type) {
+        if (now - traffic.beacon_window_start >= std::chrono::seconds(1)) {
+            traffic.beacon_window_start = now;
+            traffic.beacons_in_window = 0;
+        }
+        // Beacons are repeated periodically, so dropping the excess loses no information
+        if (traffic.beacons_in_window >= traffic_limits.max_beacons_per_second)
+            return false;
+        ++traffic.beacons_in_window;
+    }
+
+    if (traffic_limits.max_bytes_per_second != 0) {
+        // Token bucket which holds at most one second worth of data
+        const double rate = traffic_limits.max_bytes_per_second;
+        const std::chrono::duration<double> elapsed = now - traffic.last_refill;
+        traffic.byte_budget = std::min(rate, traffic.byte_budget + elapsed.count() * rate);
+        traffic.last_refill = now;
+        if (traffic.byte_budget < packet->dataLength)
+            return false;
+        traffic.byte_budget -= packet->dataLength;
+    }
+    return true;
+}
+
+void Room::RoomImpl::SampleRoundTripTimes() {
+    const Clock::time_point now = Clock::now();
+    if (now - last_rtt_sample < std::chrono::seconds(1))
+        return;
+    last_rtt_sample = now;
+
+    std::lock_guard lock(member_mutex);
+    for (const auto& member : members) {
+        const auto traffic = traffic_by_peer.find(member.peer);
+        if (traffic != traffic_by_peer.end()) {
+            traffic->second.round_trip_time = member.peer->roundTripTime;
+        }
+    }
+}
+
 void Room::RoomImpl::StartLoop() {
     room_thread = std::make_unique<std::thread>(&Room::RoomImpl::ServerLoop, this);
 }
@@ -402,10 +592,13 @@ void Room::RoomImpl::HandleJoinRequest(const ENetEvent* event) {
 
     {
         std::lock_guard lock(member_mutex);
+        peers_by_mac[MacAddressKey(member.mac_address)] = member.peer;
+        traffic_by_peer[member.peer] = Traffic{};
         members.push_back(std::move(member));
     }
 
-    // Notify everyone that the room information has changed.
+    // Notify everyone that the room information has changed. This can't be deferred, as the
+    // joining client expects to be in the member list once it receives the join success.
     BroadcastRoomInformation();
     if (HasModPermission(event->peer)) {
         SendJoinSuccessAsMod(event->peer, preferred_mac);
@@ -444,12 +637,12 @@ void Room::RoomImpl::HandleModKickPacket(const ENetEvent* event) {
         username = target_member->user_data.username;
 
         enet_peer_disconnect(target_member->peer, 0);
-        members.erase(target_member);
+        EraseMember(target_member);
     }
 
     // Announce the change to all clients.
     SendStatusMessage(IdMemberKicked, nickname, username);
-    BroadcastRoomInformation();
+    InvalidateRoomInformation();
 }
 
 void Room::RoomImpl::HandleModBanPacket(const ENetEvent* event) {
@@ -489,7 +682,7 @@ void Room::RoomImpl::HandleModBanPacket(const ENetEvent* event) {
         ip = ip_raw;
 
         enet_peer_disconnect(target_member->peer, 0);
-        members.erase(target_member);
+        EraseMember(target_member);
     }
 
     {
@@ -512,7 +705,7 @@ void Room::RoomImpl::HandleModBanPacket(const ENetEvent* event) {
 
     // Announce the change to all clients.
     SendStatusMessage(IdMemberBanned, nickname, username);
-    BroadcastRoomInformation();
+    InvalidateRoomInformation();
 }
 
 void Room::RoomImpl::HandleModUnbanPacket(const ENetEvent* event) {
@@ -802,6 +995,8 @@ void Room::RoomImpl::SendStatusMessage(StatusMessageTypes type, const std::strin
 }
 
 void Room::RoomImpl::BroadcastRoomInformation() {
+    room_information_dirty = false;
+
     Packet packet;
     packet << static_cast<u8>(IdRoomInformation);
     packet << room_information.name;
@@ -831,6 +1026,10 @@ void Room::RoomImpl::BroadcastRoomInformation() {
     enet_host_flush(server);
 }
 
+void Room::RoomImpl::InvalidateRoomInformation() {
+    room_information_dirty = true;
+}
+
 MacAddress Room::RoomImpl::GenerateMacAddress() {
     MacAddress result_mac =
         NintendoOUI; // The first three bytes of each MAC address will be the NintendoOUI
@@ -844,51 +1043,60 @@ MacAddress Room::RoomImpl::GenerateMacAddress() {
 }
 
 void Room::RoomImpl::HandleWifiPacket(const ENetEvent* event) {
-    Packet in_packet;
-    in_packet.Append(event->packet->data, event->packet->dataLength);
-    in_packet.IgnoreBytes(sizeof(u8));         // Message type
-    in_packet.IgnoreBytes(sizeof(u8));         // WifiPacket Type
-    in_packet.IgnoreBytes(sizeof(u8));         // WifiPacket Channel
-    in_packet.IgnoreBytes(sizeof(MacAddress)); // WifiPacket Transmitter Address
+    ENetPacket* const enet_packet = event->packet;
+    // A batch starts with the destination after the message type. A single packet has it after
+    // the message type, WifiPacket Type, WifiPacket Channel and WifiPacket Transmitter Address.
+    const std::size_t destination_offset = enet_packet->data[0] == IdWifiPacketBatch
+                                               ? sizeof(u8)
+                                               : 3 * sizeof(u8) + sizeof(MacAddress);
+    if (enet_packet->dataLength < destination_offset + sizeof(MacAddress)) {
+        LOG_ERROR(Network, "Received a truncated wifi packet");
+        return;
+    }
+    if (enet_packet->data[0] == IdWifiPacketBatch && !IsValidWifiPacketBatch(enet_packet)) {
+        LOG_ERROR(Network, "Received a malformed wifi packet batch");
+        return;
+    }
     MacAddress destination_address;
-    in_packet >> destination_address;
+    std::memcpy(destination_address.data(), enet_packet->data + destination_offset,
+                sizeof(MacAddress));
 
-    Packet out_packet;
-    out_packet.Append(event->packet->data, event->packet->dataLength);
-    ENetPacket* enet_packet = enet_packet_create(out_packet.GetData(), out_packet.GetDataSize(),
-                                                 ENET_PACKET_FLAG_RELIABLE);
+    std::lock_guard lock(member_mutex);
+    const auto sender = traffic_by_peer.find(event->peer);
+    if (sender != traffic_by_peer.end() &&
+        !AdmitWifiPacket(sender->second, enet_packet, Clock::now())) {
+        ++sender->second.counters.packets_dropped;
+        ++room_traffic.packets_dropped;
+        return;
+    }
+
+    // The received packet is sent on unchanged, ENet keeps it alive until every peer got it. It
+    // goes out on the channel it came in on, where only the beacons are unreliable.
+    const u8 channel = event->channelID;
+    if (channel == ReliableChannel) {
+        enet_packet->flags |= ENET_PACKET_FLAG_RELIABLE;
+    }
 
     if (destination_address == BroadcastMac) { // Send the data to everyone except the sender
-        std::lock_guard lock(member_mutex);
-        bool sent_packet = false;
         for (const auto& member : members) {
             if (member.peer != event->peer) {
-                sent_packet = true;
-                enet_peer_send(member.peer, 0, enet_packet);
+                enet_peer_send(member.peer, channel, enet_packet);
+                CountSentPacket(member.peer, enet_packet->dataLength);
             }
         }
-
-        if (!sent_packet) {
-            enet_packet_destroy(enet_packet);
-        }
     } else { // Send the data only to the destination client
-        std::lock_guard lock(member_mutex);
-        auto member = std::find_if(members.begin(), members.end(),
-                                   [destination_address](const Member& member) -> bool {
-                                       return member.mac_address == destination_address;
-                                   });
-        if (member != members.end()) {
-            enet_peer_send(member->peer, 0, enet_packet);
+        const auto peer = peers_by_mac.find(MacAddressKey(destination_address));
+        if (peer != peers_by_mac.end()) {
+            enet_peer_send(peer->second, channel, enet_packet);
+            CountSentPacket(peer->second, enet_packet->dataLength);
         } else {
             LOG_ERROR(Network,
                       "Attempting to send to unknown MAC address: "
                       "{:02X}:{:02X}:{:02X}:{:02X}:{:02X}:{:02X}",
                       destination_address[0], destination_address[1], destination_address[2],
                       destination_address[3], destination_address[4], destination_address[5]);
-            enet_packet_destroy(enet_packet);
         }
     }
-    enet_host_flush(server);
 }
 
 void Room::RoomImpl::HandleChatPacket(const ENetEvent* event) {
@@ -971,7 +1179,7 @@ void Room::RoomImpl::HandleGameNamePacket(const ENetEvent* event) {
             }
         }
     }
-    BroadcastRoomInformation();
+    InvalidateRoomInformation();
 }
 
 void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
@@ -985,7 +1193,7 @@ void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
         if (member != members.end()) {
             nickname = member->nickname;
             username = member->user_data.username;
-            members.erase(member);
+            EraseMember(member);
         }
     }
 
@@ -993,7 +1201,7 @@ void Room::RoomImpl::HandleClientDisconnection(ENetPeer* client) {
     enet_peer_disconnect(client, 0);
     if (!nickname.empty())
         SendStatusMessage(IdMemberLeave, nickname, username);
-    BroadcastRoomInformation();
+    InvalidateRoomInformation();
 }
 
 // Room
@@ -1073,6 +1281,30 @@ std::vector<Room::Member> Room::GetRoomMemberList() const {
     return member_list;
 }
 
+Room::TrafficStatistics Room::GetTrafficStatistics() const {
+    TrafficStatistics statistics;
+    std::lock_guard lock(room_impl->member_mutex);
+    statistics.room = room_impl->room_traffic;
+    statistics.members.reserve(room_impl->members.size());
+    for (const auto& member_impl : room_impl->members) {
+        MemberTraffic member;
+        member.nickname = member_impl.nickname;
+        member.mac_address = member_impl.mac_address;
+        const auto traffic = room_impl->traffic_by_peer.find(member_impl.peer);
+        if (traffic != room_impl->traffic_by_peer.end()) {
+            member.counters = traffic->second.counters;
+            member.round_trip_time = traffic->second.round_trip_time;
+        }
+        statistics.members.push_back(std::move(member));
+    }
+    return statistics;
+}
+
+void Room::SetTrafficLimits(const TrafficLimits& limits) {
+    std::lock_guard lock(room_impl->member_mutex);
+    room_impl->traffic_limits = limits;
+}
+
 bool Room::HasPassword() const {
     return !room_impl->password.empty();
 }
@@ -1095,6 +1327,9 @@ void Room::Destroy() {
     {
         std::lock_guard lock(room_impl->member_mutex);
         room_impl->members.clear();
+        room_impl->peers_by_mac.clear();
+        room_impl->traffic_by_peer.clear();
+        room_impl->room_traffic = {};
     }
     room_impl->room_information.member_slots = 0;
     room_impl->room_information.name.clear();
@@ -13,7 +13,7 @@
 
 namespace Network {
 
-constexpr u32 network_version = 4; ///< The version of this Room and RoomMember
+constexpr u32 network_version = 5; ///< The version of this Room and RoomMember
 
 constexpr u16 DefaultRoomPort = 24872;
 
@@ -22,7 +22,13 @@ constexpr u32 MaxMessageSize = 500;
 /// Maximum number of concurrent connections allowed to this room.
 static constexpr u32 MaxConcurrentConnections = 254;
 
-constexpr std::size_t NumChannels = 1; // Number of channels used for the connection
+constexpr std::size_t NumChannels = 2; // Number of channels used for the connection
+
+/// Channel of the messages that are sent reliably and in order
+constexpr u8 ReliableChannel = 0;
+/// Channel of the beacons, which are repeated anyway and thus sent unreliably, but sequenced so
+/// that a late beacon is dropped instead of arriving after a newer one
+constexpr u8 BeaconChannel = 1;
 
 struct RoomInformation {
     std::string name;           ///< Name of the server
@@ -76,6 +82,8 @@ enum RoomMessageTypes : u8 {
     IdModPermissionDenied,
     IdModNoSuchUser,
     IdJoinSuccessAsMod,
+    /// Several wifi packets to the same destination, coalesced by the sender
+    IdWifiPacketBatch,
 };
 
 /// Types of system status messages
@@ -104,6 +112,33 @@ public:
         MacAddress mac_address;   ///< The assigned mac address of the member.
     };
 
+    /// Traffic counters of the whole room or of a single member, which only ever increase.
+    struct TrafficCounters {
+        u64 packets_received = 0; ///< Packets of any kind received from the client(s)
+        u64 bytes_received = 0;   ///< Size of the received packets
+        u64 packets_sent = 0;     ///< Wifi packets forwarded to the client(s)
+        u64 bytes_sent = 0;       ///< Size of the forwarded wifi packets
+        u64 packets_dropped = 0;  ///< Wifi packets of the client(s) dropped by the traffic limits
+    };
+
+    struct MemberTraffic {
+        std::string nickname;   ///< The nickname of the member.
+        MacAddress mac_address; ///< The assigned mac address of the member.
+        TrafficCounters counters;
+        u32 round_trip_time = 0; ///< Mean round trip time to the member in milliseconds
+    };
+
+    struct TrafficStatistics {
+        TrafficCounters room; ///< Totals of the room, including members that have left
+        std::vector<MemberTraffic> members;
+    };
+
+    /// Limits on the wifi packets each member may send, a value of 0 disables the limit.
+    struct TrafficLimits {
+        u32 max_beacons_per_second = 0; ///< Beacons are dropped once a member exceeds this
+        u32 max_bytes_per_second = 0;   ///< Wifi packets are dropped once a member exceeds this
+    };
+
     Room();
     ~Room();
 
@@ -127,6 +162,17 @@ public:
      */
     std::vector<Member> GetRoomMemberList() const;
 
+    /**
+     * Gets the traffic counters of the room and of each of its members.
+     */
+    TrafficStatistics GetTrafficStatistics() const;
+
+    /**
+     * Sets the limits that are applied to the wifi packets of every member before they are
+     * forwarded to the other members.
+     */
+    void SetTrafficLimits(const TrafficLimits& limits);
+
     /**
      * Checks if the room is password protected
      */
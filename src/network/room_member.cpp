@@ -3,11 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <atomic>
-#include <list>
 #include <mutex>
 #include <set>
 #include <thread>
+#include <vector>
 #include "common/assert.h"
+#include "common/threadsafe_queue.h"
 #include "enet/enet.h"
 #include "network/packet.h"
 #include "network/room_member.h"
@@ -16,6 +17,13 @@ namespace Network {
 
 constexpr u32 ConnectionTimeoutMs = 5000;
 
+/// Wifi packets up to this size are coalesced with the others sent to the same destination
+constexpr std::size_t MaxCoalescedWifiSize = 256;
+/// Coalesced packets are kept below a typical path MTU, so that ENet doesn't fragment them
+constexpr std::size_t MaxCoalescedPacketSize = 1200;
+/// Messages that can be queued for the loop thread, senders wait while the queue is full
+constexpr std::size_t SendQueueSize = 1024;
+
 class RoomMember::RoomMemberImpl {
 public:
     ENetHost* client = nullptr; ///< ENet network interface.
@@ -44,8 +52,15 @@ public:
     std::mutex network_mutex; ///< Mutex that controls access to the `client` variable.
     /// Thread that receives and dispatches network packets
     std::unique_ptr<std::thread> loop_thread;
-    std::mutex send_list_mutex;  ///< Mutex that controls access to the `send_list` variable.
-    std::list<Packet> send_list; ///< A list that stores all packets to send the async
+
+    /// A message queued for the loop thread. Wifi packets are kept apart to be coalesced.
+    struct OutgoingMessage {
+        Packet packet; ///< The message, unless it is a wifi packet
+        WifiPacket wifi_packet;
+        bool is_wifi_packet = false;
+    };
+    /// Messages to send, written by any thread and sent by the loop thread after each service
+    Common::BoundedMPMCQueue<OutgoingMessage, SendQueueSize> send_queue;
 
     template <typename T>
     using CallbackSet = std::set<CallbackHandle<T>>;
@@ -77,6 +92,15 @@ public:
      */
     void Send(Packet&& packet);
 
+    /// Queues a wifi packet, which the loop thread may coalesce with others
+    void SendWifiPacket(const WifiPacket& wifi_packet);
+
+    /**
+     * Sends the queued messages. Wifi packets to the same destination are coalesced while they
+     * are small, beacons go on the unreliable channel. Only called from the loop thread.
+     */
+    void FlushSendQueue();
+
     /**
      * Sends a request to the server, asking for permission to join a room with the specified
      * nickname and preferred mac.
@@ -107,6 +131,12 @@ public:
      */
     void HandleWifiPackets(const ENetEvent* event);
 
+    /**
+     * Extracts the WifiPackets of a coalesced batch from a received ENet packet.
+     * @param event The ENet event that was received.
+     */
+    void HandleWifiPacketBatch(const ENetEvent* event);
+
     /**
      * Extracts a chat entry from a received ENet packet and adds it to the chat queue.
      * @param event The ENet event that was received.
@@ -166,6 +196,9 @@ void RoomMember::RoomMemberImpl::MemberLoop() {
                 case IdWifiPacket:
                     HandleWifiPackets(&event);
                     break;
+                case IdWifiPacketBatch:
+                    HandleWifiPacketBatch(&event);
+                    break;
                 case IdChatMessage:
                     HandleChatPacket(&event);
                     break;
@@ -244,16 +277,7 @@ void RoomMember::RoomMemberImpl::MemberLoop() {
                 break;
             }
         }
-        {
-            std::lock_guard lock(send_list_mutex);
-            for (const auto& packet : send_list) {
-                ENetPacket* enetPacket = enet_packet_create(packet.GetData(), packet.GetDataSize(),
-                                                            ENET_PACKET_FLAG_RELIABLE);
-                enet_peer_send(server, 0, enetPacket);
-            }
-            enet_host_flush(client);
-            send_list.clear();
-        }
+        FlushSendQueue();
     }
     Disconnect();
 };
@@ -263,8 +287,97 @@ void RoomMember::RoomMemberImpl::StartLoop() {
 }
 
 void RoomMember::RoomMemberImpl::Send(Packet&& packet) {
-    std::lock_guard lock(send_list_mutex);
-    send_list.push_back(std::move(packet));
+    OutgoingMessage message;
+    message.packet = std::move(packet);
+    send_queue.Push(std::move(message));
+}
+
+void RoomMember::RoomMemberImpl::SendWifiPacket(const WifiPacket& wifi_packet) {
+    OutgoingMessage message;
+    message.wifi_packet = wifi_packet;
+    message.is_wifi_packet = true;
+    send_queue.Push(std::move(message));
+}
+
+static void WriteWifiPacket(Packet& packet, const WifiPacket& wifi_packet) {
+    packet << static_cast<u8>(wifi_packet.type);
+    packet << wifi_packet.channel;
+    packet << wifi_packet.transmitter_address;
+}
+
+void RoomMember::RoomMemberImpl::FlushSendQueue() {
+    const auto send = [this](const Packet& packet, u8 channel) {
+        ENetPacket* enet_packet =
+            enet_packet_create(packet.GetData(), packet.GetDataSize(),
+                               channel == ReliableChannel ? ENET_PACKET_FLAG_RELIABLE : 0);
+        enet_peer_send(server, channel, enet_packet);
+    };
+    const auto send_single = [&send](const WifiPacket& wifi_packet) {
+        Packet packet;
+        packet << static_cast<u8>(IdWifiPacket);
+        WriteWifiPacket(packet, wifi_packet);
+        packet << wifi_packet.destination_address;
+        packet << wifi_packet.data;
+        send(packet, wifi_packet.type == WifiPacket::PacketType::Beacon ? BeaconChannel
+                                                                        : ReliableChannel);
+    };
+
+    // Consecutive small wifi packets to the same destination are held back to share an ENet
+    // packet. Anything else sends them first, so all messages go out in the order they were queued.
+    std::vector<WifiPacket> wifi_packets;
+    const auto flush_wifi_packets = [&send, &send_single, &wifi_packets] {
+        std::size_t begin = 0;
+        while (begin < wifi_packets.size()) {
+            // Header of the batch: message type, destination and number of packets
+            std::size_t size = sizeof(u8) + sizeof(MacAddress) + sizeof(u32);
+            std::size_t end = begin;
+            for (; end < wifi_packets.size(); ++end) {
+                // Type, channel, transmitter and the size of the data before the data itself
+                const std::size_t entry_size = 2 * sizeof(u8) + sizeof(MacAddress) +
+                                               sizeof(u32) + wifi_packets[end].data.size();
+                if (end != begin && size + entry_size > MaxCoalescedPacketSize)
+                    break;
+                size += entry_size;
+            }
+            if (end - begin == 1) {
+                send_single(wifi_packets[begin]);
+            } else {
+                Packet packet;
+                packet << static_cast<u8>(IdWifiPacketBatch);
+                packet << wifi_packets[begin].destination_address;
+                packet << static_cast<u32>(end - begin);
+                for (std::size_t i = begin; i < end; ++i) {
+                    WriteWifiPacket(packet, wifi_packets[i]);
+                    packet << wifi_packets[i].data;
+                }
+                send(packet, ReliableChannel);
+            }
+            begin = end;
+        }
+        wifi_packets.clear();
+    };
+
+    OutgoingMessage message;
+    while (send_queue.Pop(message)) {
+        WifiPacket& wifi_packet = message.wifi_packet;
+        const bool coalesce = message.is_wifi_packet &&
+                              wifi_packet.type != WifiPacket::PacketType::Beacon &&
+                              wifi_packet.data.size() <= MaxCoalescedWifiSize;
+        if (!wifi_packets.empty() &&
+            (!coalesce ||
+             wifi_packets.front().destination_address != wifi_packet.destination_address)) {
+            flush_wifi_packets();
+        }
+        if (coalesce) {
+            wifi_packets.push_back(std::move(wifi_packet));
+        } else if (message.is_wifi_packet) {
+            send_single(wifi_packet);
+        } else {
+            send(message.packet, ReliableChannel);
+        }
+    }
+    flush_wifi_packets();
+    enet_host_flush(client);
 }
 
 void RoomMember::RoomMemberImpl::SendJoinRequest(const std::string& nickname,
@@ -360,6 +473,28 @@ void RoomMember::RoomMemberImpl::HandleWifiPackets(const ENetEvent* event) {
     Invoke<WifiPacket>(wifi_packet);
 }
 
+void RoomMember::RoomMemberImpl::HandleWifiPacketBatch(const ENetEvent* event) {
+    Packet packet;
+    packet.Append(event->packet->data, event->packet->dataLength);
+
+    // Ignore the first byte, which is the message id.
+    packet.IgnoreBytes(sizeof(u8)); // Ignore the message type
+
+    WifiPacket wifi_packet{};
+    u32 count;
+    packet >> wifi_packet.destination_address;
+    packet >> count;
+    for (u32 i = 0; i < count && packet; ++i) {
+        u8 frame_type;
+        packet >> frame_type;
+        wifi_packet.type = static_cast<WifiPacket::PacketType>(frame_type);
+        packet >> wifi_packet.channel;
+        packet >> wifi_packet.transmitter_address;
+        packet >> wifi_packet.data;
+        Invoke<WifiPacket>(wifi_packet);
+    }
+}
+
 void RoomMember::RoomMemberImpl::HandleChatPacket(const ENetEvent* event) {
     Packet packet;
     packet.Append(event->packet->data, event->packet->dataLength);
@@ -576,14 +711,7 @@ bool RoomMember::IsConnected() const {
 }
 
 void RoomMember::SendWifiPacket(const WifiPacket& wifi_packet) {
-    Packet packet;
-    packet << static_cast<u8>(IdWifiPacket);
-    packet << static_cast<u8>(wifi_packet.type);
-    packet << wifi_packet.channel;
-    packet << wifi_packet.transmitter_address;
-    packet << wifi_packet.destination_address;
-    packet << wifi_packet.data;
-    room_member_impl->Send(std::move(packet));
+    room_member_impl->SendWifiPacket(wifi_packet);
 }
 
 void RoomMember::SendChatMessage(const std::string& message) {
@@ -0,0 +1,62 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <catch2/catch.hpp>
+#include "audio_core/audio_types.h"
+#include "audio_core/latency_controller.h"
+
+using namespace AudioCore;
+
+namespace {
+
+constexpr std::size_t TARGET = 1024;
+constexpr std::size_t CALLBACK_FRAMES = 256;
+
+/// Runs the controller with a producer that is `ratio` times as fast as the consumer, returning
+/// the FIFO depth at the end
+std::size_t RunDrift(double ratio, std::size_t num_callbacks) {
+    AudioFifo fifo;
+    LatencyController controller;
+    controller.SetTarget(TARGET);
+
+    const std::array<s16, 2> frame{100, -100};
+    std::array<s16, CALLBACK_FRAMES * 2> out;
+    double produced = 0.0;
+    std::size_t pushed = 0;
+    for (std::size_t i = 0; i < num_callbacks; ++i) {
+        produced += CALLBACK_FRAMES * ratio;
+        while (pushed < produced) {
+            fifo.Push(frame.data(), 1);
+            ++pushed;
+        }
+        controller.Process(fifo, out.data(), CALLBACK_FRAMES);
+    }
+    return fifo.Size();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("LatencyController waits for the target depth", "[audio_core]") {
+    AudioFifo fifo;
+    LatencyController controller;
+    controller.SetTarget(TARGET);
+
+    std::array<s16, CALLBACK_FRAMES * 2> out{};
+    std::array<s16, (TARGET - 1) * 2> in{};
+    fifo.Push(in.data(), TARGET - 1);
+    REQUIRE(controller.Process(fifo, out.data(), CALLBACK_FRAMES) == 0);
+
+    fifo.Push(in.data(), 1);
+    REQUIRE(controller.Process(fifo, out.data(), CALLBACK_FRAMES) == CALLBACK_FRAMES);
+}
+
+TEST_CASE("LatencyController holds the FIFO near the target depth", "[audio_core]") {
+    // Clocks that are 0.2% apart, which is more than real devices drift
+    for (const double ratio : {0.998, 1.0, 1.002}) {
+        const std::size_t depth = RunDrift(ratio, 20000);
+        REQUIRE(depth > TARGET / 2);
+        REQUIRE(depth < TARGET * 3 / 2);
+    }
+}
@@ -0,0 +1,110 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdlib>
+#include <catch2/catch.hpp>
+#include "audio_core/hle/mix_kernels.h"
+
+using namespace AudioCore;
+using namespace AudioCore::HLE;
+
+namespace {
+
+template <typename T>
+T Noise(u32& seed, s32 range) {
+    seed = seed * 1103515245 + 12345;
+    return static_cast<T>(static_cast<s32>(seed >> 8) % range);
+}
+
+StereoFrame16 MakeStereoFrame(u32 seed) {
+    StereoFrame16 frame;
+    for (auto& sample : frame) {
+        sample = {Noise<s16>(seed, 32768), Noise<s16>(seed, 32768)};
+    }
+    return frame;
+}
+
+QuadFrame32 MakeQuadFrame(u32 seed) {
+    // Also large enough to saturate when downmixed
+    QuadFrame32 frame;
+    for (auto& sample : frame) {
+        for (s32& channel : sample) {
+            channel = Noise<s32>(seed, 1 << 17);
+        }
+    }
+    return frame;
+}
+
+/// The scalar kernels may be contracted into fused multiply-adds, which can round differently
+bool NearlyEqual(const StereoFrame16& a, const StereoFrame16& b) {
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        for (std::size_t j = 0; j < 2; ++j) {
+            if (std::abs(a[i][j] - b[i][j]) > 1)
+                return false;
+        }
+    }
+    return true;
+}
+
+template <typename Func>
+double MeasureMicroseconds(Func&& func) {
+    constexpr int ITERATIONS = 100000;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        func();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / ITERATIONS;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("MixIntoQuadFrame matches the scalar kernel", "[audio_core]") {
+    const StereoFrame16 source = MakeStereoFrame(1);
+    for (const std::array<float, 4>& gains : {std::array<float, 4>{1.0f, 1.0f, 0.0f, 0.0f},
+                                              std::array<float, 4>{0.3f, 0.7f, 1.9f, -0.4f}}) {
+        QuadFrame32 expected = MakeQuadFrame(2);
+        QuadFrame32 result = expected;
+        MixKernelsDetail::MixIntoQuadFrameScalar(expected, source, gains);
+        MixIntoQuadFrame(result, source, gains);
+        REQUIRE(result == expected);
+    }
+}
+
+TEST_CASE("Downmix kernels match the scalar kernels", "[audio_core]") {
+    const QuadFrame32 source = MakeQuadFrame(3);
+    for (const float gain : {1.0f, 0.37f, 2.5f}) {
+        StereoFrame16 expected = MakeStereoFrame(4);
+        StereoFrame16 result = expected;
+        MixKernelsDetail::DownmixStereoAndAddScalar(expected, source, gain);
+        DownmixStereoAndAdd(result, source, gain);
+        REQUIRE(NearlyEqual(result, expected));
+
+        expected = MakeStereoFrame(5);
+        result = expected;
+        MixKernelsDetail::DownmixMonoAndAddScalar(expected, source, gain);
+        DownmixMonoAndAdd(result, source, gain);
+        REQUIRE(NearlyEqual(result, expected));
+    }
+}
+
+TEST_CASE("Mix kernel benchmark", "[.][benchmark][audio_core]") {
+    const StereoFrame16 stereo = MakeStereoFrame(6);
+    const std::array<float, 4> gains{0.3f, 0.7f, 1.9f, -0.4f};
+    QuadFrame32 quad = MakeQuadFrame(7);
+    StereoFrame16 output{};
+
+    const double mix_scalar = MeasureMicroseconds(
+        [&] { MixKernelsDetail::MixIntoQuadFrameScalar(quad, stereo, gains); });
+    const double mix_vector = MeasureMicroseconds([&] { MixIntoQuadFrame(quad, stereo, gains); });
+    const double downmix_scalar = MeasureMicroseconds(
+        [&] { MixKernelsDetail::DownmixStereoAndAddScalar(output, quad, 0.5f); });
+    const double downmix_vector =
+        MeasureMicroseconds([&] { DownmixStereoAndAdd(output, quad, 0.5f); });
+
+    WARN("MixIntoQuadFrame: " << mix_scalar << " us scalar, " << mix_vector << " us vector");
+    WARN("DownmixStereoAndAdd: " << downmix_scalar << " us scalar, " << downmix_vector
+                                 << " us vector");
+}
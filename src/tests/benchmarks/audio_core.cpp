@@ -0,0 +1,106 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "audio_core/codec.h"
+#include "audio_core/hle/mix_kernels.h"
+#include "audio_core/interpolate.h"
+#include "tests/benchmarks/benchmark_util.h"
+
+using namespace AudioCore;
+
+namespace {
+
+/// Samples in a typical buffer of a streamed source
+constexpr std::size_t BUFFER_SAMPLES = 4480;
+
+template <typename Frame>
+Frame MakeFrame(u32 seed) {
+    const std::vector<u8> data = Benchmarks::MakeNoise(sizeof(Frame), seed);
+    Frame frame;
+    std::memcpy(&frame, data.data(), sizeof(Frame));
+    return frame;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Codecs", "[benchmark][audio_core]") {
+    StereoBuffer16 output;
+
+    const std::vector<u8> adpcm = Benchmarks::MakeNoise(BUFFER_SAMPLES / 14 * 8);
+    std::array<s16, 16> coeffs;
+    for (std::size_t i = 0; i < coeffs.size(); ++i) {
+        coeffs[i] = static_cast<s16>(i % 2 == 0 ? 0x800 - i * 64 : -0x400 + i * 32);
+    }
+    BENCHMARK("DecodeADPCM 4480 samples") {
+        Codec::ADPCMState state{};
+        Codec::DecodeADPCM(adpcm.data(), BUFFER_SAMPLES, coeffs, state, output);
+        return output.Size();
+    };
+
+    const std::vector<u8> pcm = Benchmarks::MakeNoise(BUFFER_SAMPLES * 2 * sizeof(s16));
+    BENCHMARK("DecodePCM8 mono 4480 samples") {
+        Codec::DecodePCM8(1, pcm.data(), BUFFER_SAMPLES, output);
+        return output.Size();
+    };
+    BENCHMARK("DecodePCM16 mono 4480 samples") {
+        Codec::DecodePCM16(1, pcm.data(), BUFFER_SAMPLES, output);
+        return output.Size();
+    };
+    BENCHMARK("DecodePCM16 stereo 4480 samples") {
+        Codec::DecodePCM16(2, pcm.data(), BUFFER_SAMPLES, output);
+        return output.Size();
+    };
+}
+
+TEST_CASE("Interpolation", "[benchmark][audio_core]") {
+    const std::vector<u8> pcm = Benchmarks::MakeNoise(BUFFER_SAMPLES * 2 * sizeof(s16));
+    StereoBuffer16 input;
+    StereoFrame16 output;
+
+    for (const float rate : {0.5f, 1.0f, 1.5f}) {
+        BENCHMARK("Linear, rate " + std::to_string(rate)) {
+            AudioInterp::State state;
+            Codec::DecodePCM16(2, pcm.data(), BUFFER_SAMPLES, input);
+            std::size_t frames = 0;
+            while (!input.IsEmpty()) {
+                std::size_t outputi = 0;
+                AudioInterp::Linear(state, input, rate, output, outputi);
+                ++frames;
+            }
+            return frames;
+        };
+    }
+}
+
+TEST_CASE("Mixers", "[benchmark][audio_core]") {
+    const StereoFrame16 source = MakeFrame<StereoFrame16>(1);
+    const QuadFrame32 quad = MakeFrame<QuadFrame32>(2);
+    const std::array<float, 4> gains{0.75f, 0.5f, 0.25f, 1.0f};
+    QuadFrame32 quad_dest{};
+    StereoFrame16 stereo_dest{};
+
+    // A frame of 24 sources mixed into the three intermediate mixes
+    BENCHMARK("MixIntoQuadFrame 24 sources") {
+        for (int i = 0; i < 24 * 3; ++i) {
+            HLE::MixIntoQuadFrame(quad_dest, source, gains);
+        }
+        return quad_dest[0][0];
+    };
+    BENCHMARK("DownmixStereoAndAdd 3 mixes") {
+        for (int i = 0; i < 3; ++i) {
+            HLE::DownmixStereoAndAdd(stereo_dest, quad, 0.5f);
+        }
+        return stereo_dest[0][0];
+    };
+    BENCHMARK("DownmixMonoAndAdd 3 mixes") {
+        for (int i = 0; i < 3; ++i) {
+            HLE::DownmixMonoAndAdd(stereo_dest, quad, 0.5f);
+        }
+        return stereo_dest[0][0];
+    };
+}
@@ -0,0 +1,22 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include "common/common_types.h"
+
+namespace Benchmarks {
+
+/// Fills a buffer with the same pseudo random bytes on every run
+inline std::vector<u8> MakeNoise(std::size_t size, u32 seed = 0x12345678) {
+    std::vector<u8> data(size);
+    for (u8& byte : data) {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<u8>(seed >> 16);
+    }
+    return data;
+}
+
+} // namespace Benchmarks
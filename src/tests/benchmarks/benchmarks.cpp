@@ -0,0 +1,10 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+// The benchmarks use fixed inputs, so results of different builds can be compared directly, e.g.
+// with `benchmarks --benchmark-samples 200 --reporter xml --out results.xml` before and after a
+// change. Single groups can be run by their tag, like `benchmarks [video_core]`.
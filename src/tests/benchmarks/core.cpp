@@ -0,0 +1,154 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "core/core_timing.h"
+#include "core/file_sys/romfs_reader.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/vm_manager.h"
+#include "core/memory.h"
+#include "tests/benchmarks/benchmark_util.h"
+
+TEST_CASE("Timing", "[benchmark][core]") {
+    Core::Timing timing(1);
+    Core::TimingEventType* event = timing.RegisterEvent("benchmark", [](u64, s64) {});
+    Core::Timing::Timer& timer = *timing.GetTimer(0);
+    timer.Advance();
+
+    BENCHMARK("ScheduleEvent and Advance 64 events") {
+        for (u64 i = 0; i < 64; ++i) {
+            timing.ScheduleEvent(static_cast<s64>(i * 7919 % 1000 + 1), event, i, 0);
+        }
+        timer.AddTicks(1000);
+        timer.Advance();
+        return timer.GetDowncount();
+    };
+
+    // A full queue with far away events, like the periodic events of a running title
+    for (u64 i = 0; i < 64; ++i) {
+        timing.ScheduleEvent((s64{1} << 40) + static_cast<s64>(i * 7919), event, i, 0);
+    }
+    BENCHMARK("ScheduleEvent and Advance 64 events, 64 pending") {
+        for (u64 i = 0; i < 64; ++i) {
+            timing.ScheduleEvent(static_cast<s64>(i * 7919 % 1000 + 1), event, i, 0);
+        }
+        timer.AddTicks(1000);
+        timer.Advance();
+        return timer.GetDowncount();
+    };
+}
+
+TEST_CASE("MemorySystem", "[benchmark][core]") {
+    constexpr u32 HEAP_SIZE = 0x100000;
+
+    Core::Timing timing(1);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    std::vector<u8> heap = Benchmarks::MakeNoise(HEAP_SIZE);
+    REQUIRE(process->vm_manager
+                .MapBackingMemory(Memory::HEAP_VADDR, heap.data(), HEAP_SIZE,
+                                  Kernel::MemoryState::Private)
+                .Succeeded());
+    memory.SetCurrentPageTable(&process->vm_manager.page_table);
+
+    BENCHMARK("Read32 4096 words") {
+        u32 sum = 0;
+        for (VAddr addr = Memory::HEAP_VADDR; addr < Memory::HEAP_VADDR + 4096 * 4; addr += 4) {
+            sum += memory.Read32(addr);
+        }
+        return sum;
+    };
+    BENCHMARK("Read32 4096 words across pages") {
+        u32 sum = 0;
+        for (u32 i = 0; i < 4096; ++i) {
+            sum += memory.Read32(Memory::HEAP_VADDR + (i * 4099 * 4) % HEAP_SIZE);
+        }
+        return sum;
+    };
+
+    std::vector<u8> buffer(HEAP_SIZE);
+    BENCHMARK("ReadBlock 256 bytes") {
+        memory.ReadBlock(*process, Memory::HEAP_VADDR + 0x1F80, buffer.data(), 256);
+        return buffer[0];
+    };
+    BENCHMARK("ReadBlock 1 MiB") {
+        memory.ReadBlock(*process, Memory::HEAP_VADDR, buffer.data(), HEAP_SIZE);
+        return buffer[0];
+    };
+}
+
+TEST_CASE("HandleTable", "[benchmark][core]") {
+    Core::Timing timing(1);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+    Kernel::HandleTable handle_table(kernel);
+
+    std::vector<Kernel::Handle> handles;
+    for (int i = 0; i < 256; ++i) {
+        handles.push_back(
+            handle_table.Create(kernel.CreateEvent(Kernel::ResetType::OneShot)).Unwrap());
+    }
+
+    BENCHMARK("Get 256 handles") {
+        std::size_t found = 0;
+        for (const Kernel::Handle handle : handles) {
+            found += handle_table.Get<Kernel::Event>(handle) != nullptr;
+        }
+        return found;
+    };
+}
+
+TEST_CASE("DirectRomFSReader", "[benchmark][core]") {
+    constexpr std::size_t ROMFS_SIZE = 16 * 1024 * 1024;
+    const std::string path = "benchmark_romfs.bin";
+    {
+        const std::vector<u8> data = Benchmarks::MakeNoise(ROMFS_SIZE);
+        FileUtil::IOFile file(path, "wb");
+        REQUIRE(file.WriteBytes(data.data(), data.size()) == data.size());
+    }
+
+    std::vector<u8> buffer(1024 * 1024);
+    SECTION("file reads") {
+        FileSys::DirectRomFSReader reader(FileUtil::IOFile(path, "rb"), 0, ROMFS_SIZE);
+        BENCHMARK("ReadFile 4 KiB, sequential") {
+            std::size_t read = 0;
+            for (std::size_t offset = 0; offset < 64 * 4096; offset += 4096) {
+                read += reader.ReadFile(offset, 4096, buffer.data());
+            }
+            return read;
+        };
+        BENCHMARK("ReadFile 4 KiB, scattered") {
+            std::size_t read = 0;
+            for (std::size_t i = 0; i < 64; ++i) {
+                read += reader.ReadFile(i * 0x3F1000 % (ROMFS_SIZE - 4096), 4096, buffer.data());
+            }
+            return read;
+        };
+        BENCHMARK("ReadFile 1 MiB") {
+            return reader.ReadFile(0x200000, buffer.size(), buffer.data());
+        };
+    }
+
+    SECTION("mapped reads") {
+        FileSys::DirectRomFSReader reader(FileUtil::IOFile(path, "rb"), 0, ROMFS_SIZE);
+        reader.MapFile(path);
+        BENCHMARK("ReadFile 4 KiB, scattered, mapped") {
+            std::size_t read = 0;
+            for (std::size_t i = 0; i < 64; ++i) {
+                read += reader.ReadFile(i * 0x3F1000 % (ROMFS_SIZE - 4096), 4096, buffer.data());
+            }
+            return read;
+        };
+    }
+
+    FileUtil::Delete(path);
+}
@@ -0,0 +1,186 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <catch2/catch.hpp>
+#include <nihstro/inline_assembly.h>
+#include "tests/benchmarks/benchmark_util.h"
+#include "video_core/morton_copy.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
+#include "video_core/texture/etc1.h"
+#include "video_core/texture/texture_decode.h"
+#ifdef ARCHITECTURE_x86_64
+#include "video_core/shader/shader_jit_x64.h"
+#endif
+
+using VideoCore::MortonConversion;
+
+namespace {
+
+constexpr u32 SURFACE_SIZE = 256;
+
+template <bool morton_to_linear, u32 bpp, u32 linear_bpp, MortonConversion conversion>
+void MortonCopySurface(std::vector<u8>& tiled, std::vector<u8>& linear) {
+    for (u32 y = 0; y < SURFACE_SIZE; y += 8) {
+        for (u32 x = 0; x < SURFACE_SIZE; x += 8) {
+            u8* const tile = tiled.data() + (y * SURFACE_SIZE + x * 8) * bpp;
+            u8* const linear_origin = linear.data() + (y * SURFACE_SIZE + x) * linear_bpp;
+            VideoCore::MortonCopyTile<morton_to_linear, bpp, linear_bpp, conversion>(
+                SURFACE_SIZE, tile, linear_origin + 7 * SURFACE_SIZE * linear_bpp);
+        }
+    }
+}
+
+Pica::Texture::TextureInfo MakeTextureInfo(Pica::TexturingRegs::TextureFormat format) {
+    Pica::Texture::TextureInfo info{};
+    info.width = SURFACE_SIZE;
+    info.height = SURFACE_SIZE;
+    info.format = format;
+    info.SetDefaultStride();
+    return info;
+}
+
+u32 LookupWholeTexture(const std::vector<u8>& data, const Pica::Texture::TextureInfo& info) {
+    u32 checksum = 0;
+    for (u32 y = 0; y < info.height; ++y) {
+        for (u32 x = 0; x < info.width; ++x) {
+            const auto texel = Pica::Texture::LookupTexture(data.data(), x, y, info);
+            checksum += texel.r() + texel.g() + texel.b() + texel.a();
+        }
+    }
+    return checksum;
+}
+
+/// Transforms a vertex by a 4x4 matrix and computes a few lighting terms, like common titles do
+std::unique_ptr<Pica::Shader::ShaderSetup> MakeVertexShader() {
+    using nihstro::DestRegister;
+    using nihstro::OpCode;
+    using nihstro::SourceRegister;
+
+    const auto position = SourceRegister::MakeInput(0);
+    const auto normal = SourceRegister::MakeInput(1);
+    const auto temp0 = SourceRegister::MakeTemporary(0);
+    const auto temp1 = SourceRegister::MakeTemporary(1);
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary({
+        // clang-format off
+        {OpCode::Id::DP4, DestRegister::MakeOutput(0), position, SourceRegister::MakeInput(2)},
+        {OpCode::Id::DP4, DestRegister::MakeTemporary(0), position, SourceRegister::MakeInput(3)},
+        {OpCode::Id::DP3, DestRegister::MakeTemporary(1), normal, SourceRegister::MakeInput(4)},
+        {OpCode::Id::MUL, DestRegister::MakeTemporary(0), temp0, temp1},
+        {OpCode::Id::MAX, DestRegister::MakeTemporary(1), temp1, temp0},
+        {OpCode::Id::RSQ, DestRegister::MakeTemporary(0), temp1},
+        {OpCode::Id::ADD, DestRegister::MakeOutput(1), temp0, normal},
+        {OpCode::Id::EX2, DestRegister::MakeOutput(2), temp1},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    auto setup = std::make_unique<Pica::Shader::ShaderSetup>();
+    std::transform(shbin.program.begin(), shbin.program.end(), setup->program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                   setup->swizzle_data.begin(), [](const auto& x) { return x.hex; });
+    return setup;
+}
+
+void BenchmarkShaderEngine(Pica::Shader::ShaderEngine& engine, const char* name) {
+    using Pica::float24;
+
+    auto setup = MakeVertexShader();
+    engine.SetupBatch(*setup, 0);
+
+    std::vector<Pica::Shader::UnitState> units(256);
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        for (std::size_t reg = 0; reg < 5; ++reg) {
+            units[i].registers.input[reg] = Common::MakeVec(
+                float24::FromFloat32(i * 0.25f + reg), float24::FromFloat32(1.5f - reg),
+                float24::FromFloat32(i * -0.125f), float24::FromFloat32(1.0f));
+        }
+    }
+
+    BENCHMARK(name) {
+        engine.RunBatch(*setup, units.data(), units.size());
+        return units.back().registers.output[0].x.ToFloat32();
+    };
+}
+
+} // Anonymous namespace
+
+TEST_CASE("MortonCopy", "[benchmark][video_core]") {
+    std::vector<u8> tiled = Benchmarks::MakeNoise(SURFACE_SIZE * SURFACE_SIZE * 4);
+    std::vector<u8> linear(SURFACE_SIZE * SURFACE_SIZE * 4);
+
+    BENCHMARK("RGBA8 256x256 morton to linear") {
+        MortonCopySurface<true, 4, 4, MortonConversion::ByteSwap>(tiled, linear);
+        return linear[0];
+    };
+    BENCHMARK("RGBA8 256x256 linear to morton") {
+        MortonCopySurface<false, 4, 4, MortonConversion::ByteSwap>(tiled, linear);
+        return tiled[0];
+    };
+    BENCHMARK("RGB565 256x256 morton to linear") {
+        MortonCopySurface<true, 2, 2, MortonConversion::None>(tiled, linear);
+        return linear[0];
+    };
+    BENCHMARK("RGB8 256x256 morton to linear") {
+        MortonCopySurface<true, 3, 3, MortonConversion::ByteSwap>(tiled, linear);
+        return linear[0];
+    };
+    BENCHMARK("D24S8 256x256 morton to linear") {
+        MortonCopySurface<true, 4, 4, MortonConversion::RotateD24S8>(tiled, linear);
+        return linear[0];
+    };
+}
+
+TEST_CASE("LookupTexture", "[benchmark][video_core]") {
+    using Format = Pica::TexturingRegs::TextureFormat;
+
+    const std::pair<Format, const char*> formats[] = {
+        {Format::RGBA8, "RGBA8"},
+        {Format::RGB565, "RGB565"},
+        {Format::ETC1, "ETC1"},
+        {Format::ETC1A4, "ETC1A4"},
+    };
+    for (const auto& [format, name] : formats) {
+        const auto info = MakeTextureInfo(format);
+        const std::vector<u8> data = Benchmarks::MakeNoise(info.stride * SURFACE_SIZE / 8);
+        BENCHMARK(std::string("256x256 ") + name) {
+            return LookupWholeTexture(data, info);
+        };
+    }
+}
+
+TEST_CASE("ETC1 decode", "[benchmark][video_core]") {
+    const std::vector<u8> data = Benchmarks::MakeNoise(4096 * sizeof(u64));
+    std::vector<u64> blocks(4096);
+    std::memcpy(blocks.data(), data.data(), data.size());
+
+    BENCHMARK("4096 subtiles") {
+        u32 checksum = 0;
+        for (const u64 block : blocks) {
+            for (u32 y = 0; y < 4; ++y) {
+                for (u32 x = 0; x < 4; ++x) {
+                    const auto texel = Pica::Texture::SampleETC1Subtile(block, x, y);
+                    checksum += texel.r() + texel.g() + texel.b();
+                }
+            }
+        }
+        return checksum;
+    };
+}
+
+TEST_CASE("Shader engines", "[benchmark][video_core]") {
+    Pica::Shader::InterpreterEngine interpreter;
+    BenchmarkShaderEngine(interpreter, "Interpreter 256 vertices");
+#ifdef ARCHITECTURE_x86_64
+    Pica::Shader::JitX64Engine jit;
+    BenchmarkShaderEngine(jit, "JIT x64 256 vertices");
+#endif
+}
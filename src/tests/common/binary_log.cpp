@@ -0,0 +1,77 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/file_util.h"
+#include "common/logging/backend.h"
+#include "common/logging/binary_log.h"
+#include "common/logging/log.h"
+
+namespace {
+
+template <typename... Args>
+std::string RoundTrip(const char* format, const Args&... args) {
+    std::vector<u8> buffer;
+    const int count = Log::Binary::EncodeArgs(buffer, fmt::make_format_args(args...));
+    REQUIRE(count == static_cast<int>(sizeof...(Args)));
+    return Log::Binary::FormatEncoded(format, buffer.data(), buffer.size(),
+                                      static_cast<u8>(count));
+}
+
+struct Custom {};
+
+} // Anonymous namespace
+
+template <>
+struct fmt::formatter<Custom> : fmt::formatter<int> {
+    template <typename FormatContext>
+    auto format(const Custom&, FormatContext& ctx) const {
+        return fmt::formatter<int>::format(42, ctx);
+    }
+};
+
+TEST_CASE("BinaryLog::FormatEncoded matches fmt", "[common]") {
+    const std::string str = "string";
+    const char* c_str = "c string";
+    const u32 hex = 0xDEADBEEF;
+    REQUIRE(RoundTrip("{} {:08X} {}", -5, hex, u64{1} << 40) ==
+            fmt::format("{} {:08X} {}", -5, hex, u64{1} << 40));
+    REQUIRE(RoundTrip("{} {} {}", true, 'c', 0.1f) == fmt::format("{} {} {}", true, 'c', 0.1f));
+    REQUIRE(RoundTrip("{:.3f} {}", 2.5, str) == fmt::format("{:.3f} {}", 2.5, str));
+    REQUIRE(RoundTrip("{}: {:>10}", c_str, std::string_view{"view"}) ==
+            fmt::format("{}: {:>10}", c_str, std::string_view{"view"}));
+    REQUIRE(RoundTrip("no arguments") == "no arguments");
+}
+
+TEST_CASE("BinaryLog::EncodeArgs rejects custom formatters", "[common]") {
+    std::vector<u8> buffer;
+    const Custom custom;
+    REQUIRE(Log::Binary::EncodeArgs(buffer, fmt::make_format_args(custom)) == -1);
+    REQUIRE(buffer.empty());
+}
+
+TEST_CASE("BinaryLog::DecodeFile reads the backend's file", "[common]") {
+    const std::string filename = "citra_binary_log_test.bin";
+    Log::EnableBinaryLog(filename);
+    // Errors are flushed to the file right away by the binary thread
+    LOG_ERROR(Common, "binary log test {} {}", 42, "done");
+
+    bool decoded = false;
+    bool found = false;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (!found && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        decoded = Log::Binary::DecodeFile(filename, [&found](const Log::Entry& entry) {
+            found |= entry.log_level == Log::Level::Error &&
+                     entry.message == "binary log test 42 done";
+        });
+    }
+    REQUIRE(decoded);
+    REQUIRE(found);
+}
+
@@ -0,0 +1,63 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <utility>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/hash.h"
+
+namespace Common {
+
+TEST_CASE("XXH3Hash64: Matches the reference implementation", "[common]") {
+    std::vector<u8> data(5000);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i * 31 + 7);
+    }
+
+    // One length for each of the code paths of the algorithm
+    constexpr std::array<std::pair<std::size_t, u64>, 8> expected{{
+        {0, 0x2D06800538D394C2},
+        {1, 0x4C5CCA45D0F4811F},
+        {6, 0x99B2E675FBA1E0B5},
+        {12, 0x46AAF92C7550AFA4},
+        {100, 0x8C97158042FBF926},
+        {200, 0x12FDB864685F344D},
+        {1024, 0x23BC880EBF0D29C6},
+        {5000, 0x559FFF92C2B7F8EE},
+    }};
+    for (const auto& [len, hash] : expected) {
+        REQUIRE(XXH3Hash64(data.data(), len) == hash);
+    }
+}
+
+TEST_CASE("WordArrayHash: Updates match a full rehash", "[common]") {
+    std::array<u32, 64> words{};
+    WordArrayHash hash;
+    hash.Reset(words);
+    const u64 empty_hash = hash.Get();
+
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        const u32 value = static_cast<u32>(i * 0x9E3779B1);
+        hash.Update(i, words[i], value);
+        words[i] = value;
+    }
+    WordArrayHash rehashed;
+    rehashed.Reset(words);
+    REQUIRE(hash.Get() == rehashed.Get());
+    REQUIRE(hash.Get() != empty_hash);
+
+    // The same word at another index gives another hash
+    std::array<u32, 64> moved{};
+    moved[1] = 1;
+    std::array<u32, 64> original{};
+    original[0] = 1;
+    WordArrayHash moved_hash;
+    moved_hash.Reset(moved);
+    WordArrayHash original_hash;
+    original_hash.Reset(original);
+    REQUIRE(moved_hash.Get() != original_hash.Get());
+}
+
+} // namespace Common
@@ -0,0 +1,61 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <catch2/catch.hpp>
+#include "common/seqlock.h"
+
+namespace Common {
+
+TEST_CASE("SeqLock: Read returns the written value", "[common]") {
+    struct Value {
+        u32 a;
+        float b;
+        bool c;
+    };
+
+    SeqLock<Value> lock;
+    REQUIRE(lock.Read().a == 0);
+
+    lock.Write({42, 1.5f, true});
+    const Value value = lock.Read();
+    REQUIRE(value.a == 42);
+    REQUIRE(value.b == 1.5f);
+    REQUIRE(value.c);
+}
+
+TEST_CASE("SeqLock: Readers never see a partially written value", "[common]") {
+    using Value = std::array<u32, 5>;
+    SeqLock<Value> lock;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&] {
+        for (u32 i = 1; i <= 100000; ++i) {
+            Value value;
+            value.fill(i);
+            lock.Write(value);
+        }
+        done = true;
+    });
+
+    u32 last = 0;
+    bool consistent = true;
+    while (!done) {
+        const Value value = lock.Read();
+        for (const u32 element : value) {
+            consistent &= element == value[0];
+        }
+        // The writer only moves forward
+        consistent &= value[0] >= last;
+        last = value[0];
+    }
+    writer.join();
+
+    REQUIRE(consistent);
+    REQUIRE(lock.Read()[4] == 100000);
+}
+
+} // namespace Common
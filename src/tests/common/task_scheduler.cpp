@@ -0,0 +1,52 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <stdexcept>
+#include <catch2/catch.hpp>
+#include "common/task_scheduler.h"
+
+namespace Common {
+
+TEST_CASE("TaskScheduler: TaskGroup waits for all tasks", "[common]") {
+    TaskScheduler scheduler{3};
+    std::atomic_int count{0};
+
+    TaskGroup group{TaskPriority::Normal, scheduler};
+    for (int i = 0; i < 1000; ++i) {
+        group.Submit([&count] { ++count; });
+    }
+    group.Wait();
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("TaskScheduler: Async returns results and exceptions", "[common]") {
+    TaskScheduler scheduler{2};
+
+    auto value = scheduler.Async([] { return 42; });
+    auto error = scheduler.Async([]() -> int { throw std::runtime_error("task failed"); });
+    REQUIRE(value.get() == 42);
+    REQUIRE_THROWS_AS(error.get(), std::runtime_error);
+}
+
+TEST_CASE("TaskScheduler: Tasks can wait for nested groups", "[common]") {
+    // A single worker only finishes if waiting tasks run the queued sub-tasks themselves
+    TaskScheduler scheduler{1};
+    std::atomic_int count{0};
+
+    TaskGroup outer{TaskPriority::Normal, scheduler};
+    for (int i = 0; i < 8; ++i) {
+        outer.Submit([&] {
+            TaskGroup inner{TaskPriority::High, scheduler};
+            for (int j = 0; j < 8; ++j) {
+                inner.Submit([&count] { ++count; });
+            }
+            inner.Wait();
+        });
+    }
+    outer.Wait();
+    REQUIRE(count == 64);
+}
+
+} // namespace Common
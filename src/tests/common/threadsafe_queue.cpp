@@ -0,0 +1,88 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "common/threadsafe_queue.h"
+
+namespace Common {
+
+TEST_CASE("BoundedSPSCQueue: Pushes fail once the queue is full", "[common]") {
+    BoundedSPSCQueue<std::unique_ptr<int>, 4> queue;
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(queue.TryPush(std::make_unique<int>(i)));
+    }
+    auto rejected = std::make_unique<int>(4);
+    REQUIRE(!queue.TryPush(std::move(rejected)));
+    // A failed push leaves the element with the caller
+    REQUIRE(rejected != nullptr);
+    REQUIRE(queue.Size() == 4);
+
+    std::vector<int> popped;
+    REQUIRE(queue.PopBatch([&](std::unique_ptr<int>& value) { popped.push_back(*value); }, 3) ==
+            3);
+    REQUIRE(popped == std::vector<int>{0, 1, 2});
+    REQUIRE(queue.TryPush(std::move(rejected)));
+
+    std::unique_ptr<int> value;
+    REQUIRE(queue.Pop(value));
+    REQUIRE(*value == 3);
+    REQUIRE(queue.Pop(value));
+    REQUIRE(*value == 4);
+    REQUIRE(!queue.Pop(value));
+    REQUIRE(queue.Empty());
+}
+
+TEST_CASE("BoundedSPSCQueue: Elements arrive in order across threads", "[common]") {
+    constexpr u32 count = 100000;
+    BoundedSPSCQueue<u32, 64> queue;
+
+    std::thread producer([&] {
+        for (u32 i = 1; i <= count; ++i) {
+            queue.Push(i);
+        }
+    });
+
+    bool in_order = true;
+    for (u32 expected = 1; expected <= count; ++expected) {
+        in_order &= queue.PopWait() == expected;
+    }
+    producer.join();
+
+    REQUIRE(in_order);
+    REQUIRE(queue.Empty());
+}
+
+TEST_CASE("BoundedMPMCQueue: Every element is popped exactly once", "[common]") {
+    constexpr u32 num_producers = 4;
+    constexpr u32 per_producer = 25000;
+    BoundedMPMCQueue<u32, 128> queue;
+
+    std::vector<std::thread> producers;
+    for (u32 p = 0; p < num_producers; ++p) {
+        producers.emplace_back([&queue, p] {
+            for (u32 i = 0; i < per_producer; ++i) {
+                queue.Push(p * per_producer + i);
+            }
+        });
+    }
+
+    std::vector<bool> seen(num_producers * per_producer);
+    bool unique = true;
+    for (u32 received = 0; received < seen.size(); ++received) {
+        const u32 value = queue.PopWait();
+        unique &= !seen[value];
+        seen[value] = true;
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    REQUIRE(unique);
+    REQUIRE(queue.Empty());
+}
+
+} // namespace Common
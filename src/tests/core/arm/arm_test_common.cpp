@@ -23,6 +23,7 @@ TestEnvironment::TestEnvironment(bool mutable_memory_)
     page_table = &kernel->GetCurrentProcess()->vm_manager.page_table;
 
     page_table->pointers.fill(nullptr);
+    page_table->read_pointers.fill(nullptr);
     page_table->attributes.fill(Memory::PageType::Unmapped);
 
     memory->MapIoRegion(*page_table, 0x00000000, 0x80000000, test_memory);
@@ -133,6 +133,37 @@ TEST_CASE("CoreTiming[PredictableLateness]", "[core]") {
     AdvanceAndCheck(timing, 1, MAX_SLICE_LENGTH, 50, -50);
 }
 
+TEST_CASE("CoreTiming[FarEvents]", "[core]") {
+    Core::Timing timing(1);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+    Core::TimingEventType* cb_c = timing.RegisterEvent("callbackC", CallbackTemplate<2>);
+
+    // Enter slice 0
+    timing.GetTimer(0)->Advance();
+
+    // B and C start out after the span of the timer wheel
+    timing.ScheduleEvent(5000000, cb_c, CB_IDS[2], 0);
+    timing.ScheduleEvent(100000, cb_b, CB_IDS[1], 0);
+    timing.ScheduleEvent(1000, cb_a, CB_IDS[0], 0);
+    REQUIRE(1000 == timing.GetTimer(0)->GetDowncount());
+
+    AdvanceAndCheck(timing, 0, MAX_SLICE_LENGTH);
+    REQUIRE(timing.GetTimer(0)->GetTicksToNextEvent() == 99000);
+
+    // Skip ahead to B in a single slice, like the run loop does while all cores are idle
+    timing.GetTimer(0)->AddTicks(timing.GetTimer(0)->GetDowncount());
+    timing.GetTimer(0)->Advance(Core::Timing::MAX_IDLE_SLICE_LENGTH);
+    REQUIRE(79000 == timing.GetTimer(0)->GetDowncount());
+
+    AdvanceAndCheck(timing, 1, MAX_SLICE_LENGTH);
+    REQUIRE(timing.GetTimer(0)->GetTicksToNextEvent() == 4900000);
+
+    timing.UnscheduleEvent(cb_c, CB_IDS[2]);
+    REQUIRE(!timing.GetTimer(0)->GetTicksToNextEvent());
+}
+
 namespace ChainSchedulingTest {
 static int reschedules = 0;
 
@@ -186,4 +217,47 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(MAX_SLICE_LENGTH == timing.GetTimer(0)->GetDowncount());
 }
 
-// TODO: Add tests for multiple timers
+TEST_CASE("CoreTiming[CrossCoreUnschedule]", "[core]") {
+    Core::Timing timing(2);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+
+    // Core 0 is current, so these are posted to the timer of core 1
+    timing.ScheduleEvent(100, cb_a, CB_IDS[0], 1);
+    timing.ScheduleEvent(200, cb_b, CB_IDS[1], 1);
+    timing.UnscheduleEvent(cb_a, CB_IDS[0]);
+    // Only the events posted before the removal are removed
+    timing.ScheduleEvent(300, cb_a, CB_IDS[0], 1);
+
+    auto timer = timing.GetTimer(1);
+    timer->Advance();
+    REQUIRE(200 == timer->GetDowncount());
+
+    callbacks_ran_flags = 0;
+    expected_callback = CB_IDS[1];
+    lateness = 0;
+    timer->AddTicks(timer->GetDowncount());
+    timer->Advance();
+    REQUIRE(decltype(callbacks_ran_flags)().set(1) == callbacks_ran_flags);
+    REQUIRE(100 == timer->GetDowncount());
+}
+
+TEST_CASE("CoreTiming[Slack]", "[core]") {
+    Core::Timing timing(1);
+
+    Core::TimingEventType* cb_a = timing.RegisterEvent("callbackA", CallbackTemplate<0>, 500);
+    Core::TimingEventType* cb_b = timing.RegisterEvent("callbackB", CallbackTemplate<1>);
+
+    // Enter slice 0
+    timing.GetTimer(0)->Advance();
+
+    // A may fire as late as 1500, B has to fire right at 2000
+    timing.ScheduleEvent(1000, cb_a, CB_IDS[0], 0);
+    REQUIRE(1500 == timing.GetTimer(0)->GetDowncount());
+    timing.ScheduleEvent(2000, cb_b, CB_IDS[1], 0);
+    REQUIRE(1500 == timing.GetTimer(0)->GetDowncount());
+
+    AdvanceAndCheck(timing, 0, 500, 500);
+    AdvanceAndCheck(timing, 1, MAX_SLICE_LENGTH);
+}
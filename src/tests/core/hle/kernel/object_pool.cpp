@@ -0,0 +1,68 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <set>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/core_timing.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/object_pool.h"
+#include "core/memory.h"
+
+namespace Kernel {
+
+static ObjectPoolStats GetStats(HandleType type) {
+    const auto stats = GetObjectPoolStats();
+    const auto it = std::find_if(stats.begin(), stats.end(),
+                                 [type](const auto& entry) { return entry.type == type; });
+    REQUIRE(it != stats.end());
+    return *it;
+}
+
+TEST_CASE("ObjectPool reuses freed blocks", "[core][kernel]") {
+    ObjectPool pool(HandleType::Unknown, 48);
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 2000; ++i) {
+        blocks.push_back(pool.Allocate());
+    }
+    REQUIRE(std::set<void*>(blocks.begin(), blocks.end()).size() == blocks.size());
+
+    ObjectPoolStats stats = pool.GetStats();
+    REQUIRE(stats.live == 2000);
+    REQUIRE(stats.peak == 2000);
+    REQUIRE(stats.capacity >= 2000);
+
+    void* const freed = blocks.back();
+    blocks.pop_back();
+    pool.Free(freed);
+    REQUIRE(pool.Allocate() == freed);
+    blocks.push_back(freed);
+
+    for (void* block : blocks) {
+        pool.Free(block);
+    }
+    stats = pool.GetStats();
+    REQUIRE(stats.live == 0);
+    REQUIRE(stats.peak == 2000);
+}
+
+TEST_CASE("Kernel objects are allocated from their pool", "[core][kernel]") {
+    Core::Timing timing(1);
+    Memory::MemorySystem memory;
+    KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+
+    // The pool is created by the first allocation
+    kernel.CreateEvent(ResetType::OneShot);
+    const std::size_t live_before = GetStats(HandleType::Event).live;
+    {
+        auto event = kernel.CreateEvent(ResetType::OneShot, "test");
+        REQUIRE(event->GetName() == "test");
+        REQUIRE(GetStats(HandleType::Event).live == live_before + 1);
+    }
+    REQUIRE(GetStats(HandleType::Event).live == live_before);
+}
+
+} // namespace Kernel
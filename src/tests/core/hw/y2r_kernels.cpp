@@ -0,0 +1,73 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <vector>
+#include <catch2/catch.hpp>
+#include "core/hw/y2r_kernels.h"
+
+using namespace HW::Y2R;
+using Service::Y2R::CoefficientSet;
+using Service::Y2R::OutputFormat;
+
+namespace {
+
+constexpr std::size_t NUM_PIXELS = 256;
+
+u32 Noise(u32& seed) {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+std::vector<s16> MakePlane(u32 seed) {
+    std::vector<s16> plane(NUM_PIXELS);
+    for (s16& value : plane) {
+        value = static_cast<s16>(Noise(seed) % 256);
+    }
+    return plane;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ConvertYUVToRGB32 matches the scalar kernel", "[core][y2r]") {
+    const std::vector<s16> y = MakePlane(1);
+    const std::vector<s16> u = MakePlane(2);
+    const std::vector<s16> v = MakePlane(3);
+
+    // The BT.601 coefficients of the Y2R service, ones that saturate in both directions and ones
+    // the vector kernels can't negate
+    for (const CoefficientSet& coefficients :
+         {CoefficientSet{0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B},
+          CoefficientSet{0x7FFF, -0x8000, 0x7FFF, -0x7FFF, -0x8000, 0x7FFF, -0x8000, 0x1234},
+          CoefficientSet{0x100, 0x166, -0x8000, -0x8000, 0x1C5, -0x166F, 0x10EE, -0x1C5B}}) {
+        std::vector<u32> expected(NUM_PIXELS);
+        std::vector<u32> result(NUM_PIXELS);
+        Y2RKernelsDetail::ConvertYUVToRGB32Scalar(y.data(), u.data(), v.data(), expected.data(),
+                                                  NUM_PIXELS, coefficients);
+        ConvertYUVToRGB32(y.data(), u.data(), v.data(), result.data(), NUM_PIXELS, coefficients);
+        REQUIRE(result == expected);
+    }
+}
+
+TEST_CASE("EncodeRGB32 matches the scalar kernel", "[core][y2r]") {
+    u32 seed = 4;
+    std::vector<u32> colors(NUM_PIXELS);
+    for (u32& color : colors) {
+        color = Noise(seed) << 8;
+    }
+
+    for (const OutputFormat format : {OutputFormat::RGBA8, OutputFormat::RGB8,
+                                      OutputFormat::RGB5A1, OutputFormat::RGB565}) {
+        for (const u8 alpha : {u8{0x00}, u8{0x7F}, u8{0xFF}}) {
+            // An odd count exercises the scalar tail of the vector kernels
+            const std::size_t count = NUM_PIXELS - 3;
+            std::vector<u8> expected(NUM_PIXELS * 4);
+            std::vector<u8> result(NUM_PIXELS * 4);
+            Y2RKernelsDetail::EncodeRGB32Scalar(colors.data(), expected.data(), count, format,
+                                                alpha);
+            EncodeRGB32(colors.data(), result.data(), count, format, alpha);
+            REQUIRE(result == expected);
+        }
+    }
+}
@@ -3,6 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <vector>
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/kernel/memory.h"
@@ -54,3 +57,32 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::ReadBlock and WriteBlock across pages", "[core][memory]") {
+    Core::Timing timing(1);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    auto& page_table = process->vm_manager.page_table;
+
+    // The first two pages are backed by contiguous host memory, the third one isn't
+    constexpr VAddr base = Memory::HEAP_VADDR;
+    std::vector<u8> contiguous(2 * Memory::PAGE_SIZE);
+    std::vector<u8> separate(Memory::PAGE_SIZE);
+    memory.MapMemoryRegion(page_table, base, 2 * Memory::PAGE_SIZE, contiguous.data());
+    memory.MapMemoryRegion(page_table, base + 2 * Memory::PAGE_SIZE, Memory::PAGE_SIZE,
+                           separate.data());
+
+    std::vector<u8> data(3 * Memory::PAGE_SIZE - 2);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<u8>(i * 7);
+    }
+    memory.WriteBlock(*process, base + 1, data.data(), data.size());
+    const auto split = data.begin() + (2 * Memory::PAGE_SIZE - 1);
+    CHECK(std::equal(data.begin(), split, contiguous.begin() + 1));
+    CHECK(std::equal(split, data.end(), separate.begin()));
+
+    std::vector<u8> read(data.size());
+    memory.ReadBlock(*process, base + 1, read.data(), read.size());
+    CHECK(read == data);
+}
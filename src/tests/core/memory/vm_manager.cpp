@@ -136,4 +136,37 @@ TEST_CASE("Memory Basics", "[kernel][memory]") {
         code = manager->UnmapRange(Memory::HEAP_VADDR, block->size());
         REQUIRE(code == RESULT_SUCCESS);
     }
+
+    SECTION("ranges spanning several VMAs") {
+        // Because of the PageTable, Kernel::VMManager is too big to be created on the stack.
+        auto manager = std::make_unique<Kernel::VMManager>(memory);
+        std::vector<u8> other_block(Memory::PAGE_SIZE);
+        auto result = manager->MapBackingMemory(Memory::HEAP_VADDR, block->data(), block->size(),
+                                                Kernel::MemoryState::Private);
+        REQUIRE(result.Code() == RESULT_SUCCESS);
+        result = manager->MapBackingMemory(Memory::HEAP_VADDR + Memory::PAGE_SIZE,
+                                           other_block.data(), other_block.size(),
+                                           Kernel::MemoryState::Private);
+        REQUIRE(result.Code() == RESULT_SUCCESS);
+        CHECK(manager->page_table.pointers[Memory::HEAP_VADDR >> Memory::PAGE_BITS] ==
+              block->data());
+
+        auto blocks = manager->GetBackingBlocksForRange(Memory::HEAP_VADDR, 2 * Memory::PAGE_SIZE);
+        REQUIRE(blocks.Succeeded());
+        REQUIRE(blocks->size() == 2);
+        CHECK((*blocks)[0].first == block->data());
+        CHECK((*blocks)[1].first == other_block.data());
+
+        ResultCode code = manager->UnmapRange(Memory::HEAP_VADDR, 2 * Memory::PAGE_SIZE);
+        REQUIRE(code == RESULT_SUCCESS);
+        auto vma = manager->FindVMA(Memory::HEAP_VADDR);
+        CHECK(vma->second.type == Kernel::VMAType::Free);
+        CHECK(vma->second.base + vma->second.size >= Memory::HEAP_VADDR + 2 * Memory::PAGE_SIZE);
+        CHECK(manager->page_table.pointers[Memory::HEAP_VADDR >> Memory::PAGE_BITS] == nullptr);
+        CHECK(manager->page_table.attributes[(Memory::HEAP_VADDR >> Memory::PAGE_BITS) + 1] ==
+              Memory::PageType::Unmapped);
+
+        blocks = manager->GetBackingBlocksForRange(Memory::HEAP_VADDR, Memory::PAGE_SIZE);
+        CHECK(blocks.Code() == Kernel::ERR_INVALID_ADDRESS_STATE);
+    }
 }
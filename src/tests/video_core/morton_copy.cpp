@@ -0,0 +1,49 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <catch2/catch.hpp>
+#include "video_core/morton_copy.h"
+
+using VideoCore::MortonConversion;
+
+namespace {
+
+constexpr u32 STRIDE = 16;
+
+template <u32 bpp, u32 linear_bpp, MortonConversion conversion>
+void TestMortonCopyTile() {
+    std::array<u8, 64 * bpp> tile;
+    for (std::size_t i = 0; i < tile.size(); ++i) {
+        tile[i] = static_cast<u8>(i * 7 + 3);
+    }
+
+    // Both kernels write into the same spot of a larger linear buffer, to check the stride
+    std::array<u8, STRIDE * 8 * linear_bpp> expected{};
+    std::array<u8, STRIDE * 8 * linear_bpp> result{};
+    u8* const expected_origin = expected.data() + 4 * linear_bpp;
+    u8* const result_origin = result.data() + 4 * linear_bpp;
+    VideoCore::MortonDetail::CopyTileScalar<true, bpp, linear_bpp, conversion>(
+        STRIDE, tile.data(), expected_origin);
+    VideoCore::MortonCopyTile<true, bpp, linear_bpp, conversion>(STRIDE, tile.data(),
+                                                                 result_origin);
+    REQUIRE(result == expected);
+
+    std::array<u8, 64 * bpp> roundtrip{};
+    VideoCore::MortonCopyTile<false, bpp, linear_bpp, conversion>(STRIDE, roundtrip.data(),
+                                                                  result_origin);
+    REQUIRE(roundtrip == tile);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("MortonCopyTile matches the scalar kernel", "[video_core]") {
+    TestMortonCopyTile<2, 2, MortonConversion::None>();
+    TestMortonCopyTile<3, 3, MortonConversion::None>();
+    TestMortonCopyTile<3, 3, MortonConversion::ByteSwap>();
+    TestMortonCopyTile<3, 4, MortonConversion::None>();
+    TestMortonCopyTile<4, 4, MortonConversion::None>();
+    TestMortonCopyTile<4, 4, MortonConversion::RotateD24S8>();
+    TestMortonCopyTile<4, 4, MortonConversion::ByteSwap>();
+}
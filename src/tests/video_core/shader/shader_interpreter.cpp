@@ -0,0 +1,161 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <catch2/catch.hpp>
+#include <nihstro/shader_bytecode.h>
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
+
+using float24 = Pica::float24;
+using Registers = Common::Vec4<float24>[16];
+using OpCode = nihstro::OpCode;
+using Pica::Shader::InterpreterEngine;
+using Pica::Shader::ShaderSetup;
+using Pica::Shader::UnitState;
+
+namespace {
+
+// Opcodes whose other bits can be random, nothing but END and the forward flow control below can
+// change the program counter
+constexpr std::array<OpCode::Id, 19> ARITHMETIC_OPCODES{
+    OpCode::Id::ADD,  OpCode::Id::DP3,  OpCode::Id::DP4,  OpCode::Id::DPH, OpCode::Id::EX2,
+    OpCode::Id::LG2,  OpCode::Id::MUL,  OpCode::Id::SGE,  OpCode::Id::SLT, OpCode::Id::FLR,
+    OpCode::Id::MAX,  OpCode::Id::MIN,  OpCode::Id::RCP,  OpCode::Id::RSQ, OpCode::Id::MOVA,
+    OpCode::Id::MOV,  OpCode::Id::DPHI, OpCode::Id::SGEI, OpCode::Id::SLTI,
+};
+
+constexpr std::array<OpCode::Id, 4> FLOW_CONTROL_OPCODES{
+    OpCode::Id::IFU,
+    OpCode::Id::IFC,
+    OpCode::Id::JMPU,
+    OpCode::Id::JMPC,
+};
+
+// Keeps the call stack of the IFs well below its capacity
+constexpr int MAX_FLOW_CONTROL = 8;
+
+constexpr std::size_t PROGRAM_LENGTH = 64;
+
+float24 RandomFloat(std::mt19937& rng) {
+    switch (rng() % 8) {
+    case 0:
+        return float24::Zero();
+    case 1:
+        return float24::FromFloat32(static_cast<float>(rng() % 5) - 2.0f);
+    default:
+        return float24::FromFloat32(std::uniform_real_distribution<float>{-100.0f, 100.0f}(rng));
+    }
+}
+
+/**
+ * Generates a program of random arithmetic instructions with a few forward jumps and IFs in
+ * between, which ends with END. All of it runs in a bounded number of steps.
+ */
+void GenerateProgram(std::mt19937& rng, ShaderSetup& setup) {
+    const std::size_t end = PROGRAM_LENGTH - 1;
+    int num_flow_control = 0;
+    for (std::size_t pc = 0; pc < end; ++pc) {
+        u32 word;
+        if (pc + 2 < end && num_flow_control < MAX_FLOW_CONTROL && rng() % 8 == 0) {
+            ++num_flow_control;
+            const OpCode::Id op = FLOW_CONTROL_OPCODES[rng() % FLOW_CONTROL_OPCODES.size()];
+            const u32 dest_offset = static_cast<u32>(pc + 1 + rng() % (end - pc - 1));
+            const u32 num_instructions = rng() % (end - dest_offset + 1);
+            // The condition, its references or the bool uniform are random
+            word = (static_cast<u32>(op) << 26) | (rng() & 0x03C00000) | (dest_offset << 10) |
+                   num_instructions;
+        } else if (rng() % 4 == 0) {
+            // MAD and MADI only use the top 3 bits of the opcode field
+            const u32 op = static_cast<u32>(rng() % 2 ? OpCode::Id::MAD : OpCode::Id::MADI);
+            word = (op << 26) | (rng() & 0x1FFFFFFF);
+        } else {
+            const OpCode::Id op = ARITHMETIC_OPCODES[rng() % ARITHMETIC_OPCODES.size()];
+            word = (static_cast<u32>(op) << 26) | (rng() & 0x03FFFFFF);
+        }
+        setup.program_code[pc] = word;
+    }
+    setup.program_code[end] = static_cast<u32>(OpCode::Id::END) << 26;
+    setup.MarkProgramCodeDirty();
+
+    for (u32& word : setup.swizzle_data) {
+        word = rng();
+    }
+    setup.MarkSwizzleDataDirty();
+
+    for (auto& uniform : setup.uniforms.f) {
+        uniform = {RandomFloat(rng), RandomFloat(rng), RandomFloat(rng), RandomFloat(rng)};
+    }
+    for (bool& uniform : setup.uniforms.b) {
+        uniform = rng() % 2 != 0;
+    }
+}
+
+void GenerateInput(std::mt19937& rng, UnitState& state) {
+    for (auto& input : state.registers.input) {
+        input = {RandomFloat(rng), RandomFloat(rng), RandomFloat(rng), RandomFloat(rng)};
+    }
+    for (auto& temporary : state.registers.temporary) {
+        temporary = Common::Vec4<float24>::AssignToAll(float24::Zero());
+    }
+    for (auto& output : state.registers.output) {
+        output = Common::Vec4<float24>::AssignToAll(float24::Zero());
+    }
+    for (s32& address_register : state.address_registers) {
+        address_register = static_cast<s32>(rng() % 256) - 128;
+    }
+}
+
+/// Compares the bits of the values, except that all NaNs are equal
+bool IsSame(float24 a, float24 b) {
+    const float a_float = a.ToFloat32();
+    const float b_float = b.ToFloat32();
+    if (std::isnan(a_float) || std::isnan(b_float))
+        return std::isnan(a_float) && std::isnan(b_float);
+    return std::memcmp(&a_float, &b_float, sizeof(float)) == 0;
+}
+
+void CheckSameRegisters(const Registers& a, const Registers& b) {
+    for (std::size_t i = 0; i < 16; ++i) {
+        for (std::size_t component = 0; component < 4; ++component) {
+            INFO("Register " << i << " component " << component);
+            REQUIRE(IsSame(a[i][component], b[i][component]));
+        }
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Decoded interpreter matches the reference interpreter", "[video_core][shader]") {
+    std::mt19937 rng{1234};
+    InterpreterEngine engine;
+    auto setup = std::make_unique<ShaderSetup>();
+
+    for (int program = 0; program < 500; ++program) {
+        GenerateProgram(rng, *setup);
+        engine.SetupBatch(*setup, 0);
+
+        for (int run = 0; run < 4; ++run) {
+            INFO("Program " << program << " run " << run);
+            UnitState reference;
+            GenerateInput(rng, reference);
+            UnitState decoded = reference;
+
+            engine.RunReference(*setup, reference);
+            engine.Run(*setup, decoded);
+
+            CheckSameRegisters(reference.registers.output, decoded.registers.output);
+            CheckSameRegisters(reference.registers.temporary, decoded.registers.temporary);
+            REQUIRE(reference.conditional_code[0] == decoded.conditional_code[0]);
+            REQUIRE(reference.conditional_code[1] == decoded.conditional_code[1]);
+            for (std::size_t i = 0; i < 3; ++i) {
+                REQUIRE(reference.address_registers[i] == decoded.address_registers[i]);
+            }
+        }
+    }
+}
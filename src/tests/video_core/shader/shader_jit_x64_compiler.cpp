@@ -3,7 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <functional>
 #include <memory>
 #include <catch2/catch.hpp>
 #include <nihstro/inline_assembly.h>
@@ -11,24 +13,35 @@
 
 using float24 = Pica::float24;
 using JitShader = Pica::Shader::JitShader;
+using JitSpecialization = Pica::Shader::JitSpecialization;
 
 using DestRegister = nihstro::DestRegister;
 using OpCode = nihstro::OpCode;
 using SourceRegister = nihstro::SourceRegister;
 
-static std::unique_ptr<JitShader> CompileShader(std::initializer_list<nihstro::InlineAsm> code) {
+using ProgramCode = std::array<u32, Pica::Shader::MAX_PROGRAM_CODE_LENGTH>;
+
+static std::unique_ptr<JitShader> CompileShader(
+    std::initializer_list<nihstro::InlineAsm> code,
+    const std::function<void(ProgramCode&)>& modify_program = nullptr,
+    const JitSpecialization* specialization = nullptr) {
     const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
 
-    std::array<u32, Pica::Shader::MAX_PROGRAM_CODE_LENGTH> program_code{};
+    ProgramCode program_code{};
     std::array<u32, Pica::Shader::MAX_SWIZZLE_DATA_LENGTH> swizzle_data{};
 
     std::transform(shbin.program.begin(), shbin.program.end(), program_code.begin(),
                    [](const auto& x) { return x.hex; });
     std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(), swizzle_data.begin(),
                    [](const auto& x) { return x.hex; });
+    if (modify_program) {
+        modify_program(program_code);
+    }
 
-    auto shader = std::make_unique<JitShader>();
-    shader->Compile(&program_code, &swizzle_data);
+    const std::size_t code_size = specialization ? Pica::Shader::MAX_SPECIALIZED_SHADER_SIZE
+                                                 : Pica::Shader::MAX_SHADER_SIZE;
+    auto shader = std::make_unique<JitShader>(code_size);
+    shader->Compile(&program_code, &swizzle_data, specialization);
 
     return shader;
 }
@@ -89,3 +102,97 @@ TEST_CASE("EX2", "[video_core][shader][shader_jit]") {
     REQUIRE(shader.Run(79.7262742773f) == Approx(1.e24f));
     REQUIRE(std::isinf(shader.Run(800.f)));
 }
+
+TEST_CASE("RunBatch", "[video_core][shader][shader_jit]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    auto shader = ShaderTest({
+        // clang-format off
+        {OpCode::Id::EX2, sh_output, sh_input},
+        {OpCode::Id::END},
+        // clang-format on
+    });
+
+    Pica::Shader::ShaderSetup shader_setup;
+    std::array<Pica::Shader::UnitState, 3> shader_units;
+    for (std::size_t i = 0; i < shader_units.size(); ++i) {
+        shader_units[i].registers.input[0].x = float24::FromFloat32(static_cast<float>(i));
+    }
+
+    shader.shader->RunBatch(shader_setup, shader_units.data(), shader_units.size(), 0);
+    REQUIRE(shader_units[0].registers.output[0].x.ToFloat32() == Approx(1.f));
+    REQUIRE(shader_units[1].registers.output[0].x.ToFloat32() == Approx(2.f));
+    REQUIRE(shader_units[2].registers.output[0].x.ToFloat32() == Approx(4.f));
+}
+
+TEST_CASE("RunBatch with relative addressing", "[video_core][shader][shader_jit]") {
+    const auto sh_uniform = SourceRegister::MakeFloat(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    // InlineAsm can't express relative addressing, so the first source of the MOV is made
+    // relative to a0.x here, which is address_register_index (bits 19-20) set to 1
+    const auto shader = CompileShader(
+        {
+            // clang-format off
+            {OpCode::Id::MOV, sh_output, sh_uniform},
+            {OpCode::Id::END},
+            // clang-format on
+        },
+        [](ProgramCode& program_code) { program_code[0] |= 1u << 19; });
+
+    Pica::Shader::ShaderSetup shader_setup;
+    for (std::size_t i = 0; i < 4; ++i) {
+        shader_setup.uniforms.f[i].x = float24::FromFloat32(static_cast<float>(10 * i));
+    }
+
+    // The later unit states keep the address registers of the first one
+    std::array<Pica::Shader::UnitState, 4> shader_units;
+    shader_units[0].address_registers[0] = 2;
+    shader_units[0].address_registers[1] = 0;
+    shader_units[0].address_registers[2] = 0;
+
+    shader->RunBatch(shader_setup, shader_units.data(), shader_units.size(), 0);
+    for (const auto& shader_unit : shader_units) {
+        REQUIRE(shader_unit.registers.output[0].x.ToFloat32() == Approx(20.f));
+        REQUIRE(shader_unit.address_registers[0] == 2);
+    }
+}
+
+TEST_CASE("Specialization keeps dynamic bool uniforms", "[video_core][shader][shader_jit]") {
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    // The geometry pipeline sets b15 after the first invocation without a new SetupBatch
+    Pica::Shader::ShaderSetup shader_setup;
+    shader_setup.dynamic_bool_uniforms = 1 << 15;
+    shader_setup.uniforms.f[0].x = float24::FromFloat32(1.f);
+    shader_setup.uniforms.f[1].x = float24::FromFloat32(2.f);
+    const JitSpecialization specialization = JitSpecialization::FromSetup(shader_setup);
+
+    // The first MOV is replaced by IFU b15, which runs the second MOV if b15 is set and the third
+    // one otherwise
+    const auto shader = CompileShader(
+        {
+            // clang-format off
+            {OpCode::Id::MOV, sh_output, SourceRegister::MakeFloat(0)},
+            {OpCode::Id::MOV, sh_output, SourceRegister::MakeFloat(0)},
+            {OpCode::Id::MOV, sh_output, SourceRegister::MakeFloat(1)},
+            {OpCode::Id::END},
+            // clang-format on
+        },
+        [](ProgramCode& program_code) {
+            program_code[0] = (static_cast<u32>(OpCode::Id::IFU) << 26) | (15u << 22) |
+                              (2u << 10) | 1u;
+        },
+        &specialization);
+
+    Pica::Shader::UnitState first_unit;
+    shader->Run(shader_setup, first_unit, 0);
+    REQUIRE(first_unit.registers.output[0].x.ToFloat32() == Approx(2.f));
+
+    shader_setup.uniforms.b[15] = true;
+    REQUIRE(JitSpecialization::FromSetup(shader_setup) == specialization);
+    Pica::Shader::UnitState later_unit;
+    shader->Run(shader_setup, later_unit, 0);
+    REQUIRE(later_unit.registers.output[0].x.ToFloat32() == Approx(1.f));
+}
@@ -0,0 +1,50 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch.hpp>
+#include "video_core/texture/texture_decode.h"
+
+using Pica::TexturingRegs;
+
+TEST_CASE("DecodeTexture matches LookupTexture", "[video_core]") {
+    constexpr TexturingRegs::TextureFormat formats[] = {
+        TexturingRegs::TextureFormat::RGBA8,  TexturingRegs::TextureFormat::RGB8,
+        TexturingRegs::TextureFormat::RGB5A1, TexturingRegs::TextureFormat::RGB565,
+        TexturingRegs::TextureFormat::RGBA4,  TexturingRegs::TextureFormat::IA8,
+        TexturingRegs::TextureFormat::RG8,    TexturingRegs::TextureFormat::I8,
+        TexturingRegs::TextureFormat::A8,     TexturingRegs::TextureFormat::IA4,
+        TexturingRegs::TextureFormat::I4,     TexturingRegs::TextureFormat::A4,
+        TexturingRegs::TextureFormat::ETC1,   TexturingRegs::TextureFormat::ETC1A4,
+    };
+
+    for (const bool disable_alpha : {false, true}) {
+        for (const auto format : formats) {
+            Pica::Texture::TextureInfo info{};
+            info.width = 32;
+            info.height = 16;
+            info.format = format;
+            info.SetDefaultStride();
+
+            std::vector<u8> source(info.stride * (info.height / 8));
+            for (std::size_t i = 0; i < source.size(); ++i) {
+                source[i] = static_cast<u8>(i * 37 + 11);
+            }
+
+            std::vector<Common::Vec4<u8>> decoded(info.width * info.height);
+            Pica::Texture::DecodeTexture(source.data(), info, decoded.data(), disable_alpha);
+            for (unsigned int y = 0; y < info.height; ++y) {
+                for (unsigned int x = 0; x < info.width; ++x) {
+                    const auto& texel = decoded[y * info.width + x];
+                    const auto expected =
+                        Pica::Texture::LookupTexture(source.data(), x, y, info, disable_alpha);
+                    REQUIRE(texel.r() == expected.r());
+                    REQUIRE(texel.g() == expected.g());
+                    REQUIRE(texel.b() == expected.b());
+                    REQUIRE(texel.a() == expected.a());
+                }
+            }
+        }
+    }
+}
@@ -2,20 +2,26 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <memory>
 #include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/task_scheduler.h"
 #include "common/vector_math.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
 #include "core/memory.h"
+#include "core/perf_metrics.h"
+#include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
 #include "video_core/primitive_assembly.h"
@@ -38,6 +44,129 @@ static const u32 expand_bits_to_bytes[] = {
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+/**
+ * Post-transform cache of indexed draws, holding the shader output of every vertex shaded during
+ * the draw so that each vertex is shaded only once. Entries are tagged with the draw they belong
+ * to, which invalidates the whole cache in constant time.
+ */
+class VertexCache {
+public:
+    /// Invalidates the entries of the previous draw
+    void Reset() {
+        if (++draw == 0) {
+            entry_draws.fill(0);
+            draw = 1;
+        }
+        outputs.clear();
+    }
+
+    /// Returns the cached output of the vertex, or nullptr if it hasn't been shaded yet
+    const Shader::AttributeBuffer* Find(u16 vertex) const {
+        return entry_draws[vertex] == draw ? &outputs[entry_slots[vertex]] : nullptr;
+    }
+
+    void Insert(u16 vertex, const Shader::AttributeBuffer& output) {
+        entry_draws[vertex] = draw;
+        entry_slots[vertex] = static_cast<u32>(outputs.size());
+        outputs.push_back(output);
+    }
+
+    /// Returns the slot of the vertex, allocating an empty one to be written later if it's new
+    u32 Allocate(u16 vertex, bool& allocated) {
+        allocated = entry_draws[vertex] != draw;
+        if (allocated) {
+            Insert(vertex, {});
+        }
+        return entry_slots[vertex];
+    }
+
+    Shader::AttributeBuffer* Outputs() {
+        return outputs.data();
+    }
+
+private:
+    static constexpr std::size_t NUM_ENTRIES = 0x10000;
+
+    u32 draw = 0;
+    std::array<u32, NUM_ENTRIES> entry_draws{};
+    std::array<u32, NUM_ENTRIES> entry_slots;
+    std::vector<Shader::AttributeBuffer> outputs;
+};
+
+static VertexCache vertex_cache;
+
+/**
+ * Whether the triangles of software vertex processing are queued in the rasterizer. Consecutive
+ * draws that don't change the rasterization state between them are rendered together, the queue is
+ * drawn once a register affecting it changes or the command list ends.
+ */
+static bool triangles_pending = false;
+
+static void DrawPendingTriangles() {
+    if (!triangles_pending)
+        return;
+    triangles_pending = false;
+    VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+}
+
+/// Queues the triangles of a finished draw, or draws them right away for the debugger
+static void FinishTriangles() {
+    if (g_debug_context) {
+        VideoCore::g_renderer->Rasterizer()->DrawTriangles();
+        g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
+    } else {
+        triangles_pending = true;
+    }
+}
+
+/// What writing a register involves besides storing the value, for WritePicaReg
+struct RegWriteInfo {
+    bool has_handler;    ///< Writing the register has side effects, run by HandleRegWrite
+    bool always_changes; ///< Writing it changes the state even if the value stays the same
+};
+
+static constexpr std::array<RegWriteInfo, Regs::NUM_REGS> BuildRegWriteTable() {
+    std::array<RegWriteInfo, Regs::NUM_REGS> table{};
+    const auto add_handler = [&table](std::size_t first, std::size_t count, bool always_changes) {
+        for (std::size_t id = first; id < first + count; ++id) {
+            table[id] = {true, always_changes};
+        }
+    };
+
+    add_handler(PICA_REG_INDEX(trigger_irq), 1, true);
+    add_handler(PICA_REG_INDEX(lighting.lut_data[0]), 8, true);
+    add_handler(PICA_REG_INDEX(texturing.fog_lut_data[0]), 8, true);
+    add_handler(PICA_REG_INDEX(texturing.proctex_lut_data[0]), 8, true);
+
+    add_handler(PICA_REG_INDEX(pipeline.triangle_topology), 1, false);
+    add_handler(PICA_REG_INDEX(pipeline.restart_primitive), 1, false);
+    add_handler(PICA_REG_INDEX(pipeline.vs_default_attributes_setup.index), 1, false);
+    add_handler(PICA_REG_INDEX(pipeline.vs_default_attributes_setup.set_value[0]), 3, false);
+    add_handler(PICA_REG_INDEX(pipeline.gpu_mode), 1, false);
+    add_handler(PICA_REG_INDEX(pipeline.command_buffer.trigger[0]), 2, false);
+    add_handler(PICA_REG_INDEX(pipeline.trigger_draw), 1, false);
+    add_handler(PICA_REG_INDEX(pipeline.trigger_draw_indexed), 1, false);
+
+    add_handler(PICA_REG_INDEX(gs.bool_uniforms), 1, false);
+    add_handler(PICA_REG_INDEX(gs.int_uniforms[0]), 4, false);
+    add_handler(PICA_REG_INDEX(gs.uniform_setup.set_value[0]), 8, false);
+    add_handler(PICA_REG_INDEX(gs.program.set_word[0]), 8, false);
+    add_handler(PICA_REG_INDEX(gs.swizzle_patterns.set_word[0]), 8, false);
+
+    add_handler(PICA_REG_INDEX(vs.bool_uniforms), 1, false);
+    add_handler(PICA_REG_INDEX(vs.int_uniforms[0]), 4, false);
+    add_handler(PICA_REG_INDEX(vs.uniform_setup.set_value[0]), 8, false);
+    add_handler(PICA_REG_INDEX(vs.program.set_word[0]), 8, false);
+    add_handler(PICA_REG_INDEX(vs.swizzle_patterns.set_word[0]), 8, false);
+    return table;
+}
+
+/**
+ * Indexed by register ID. Most registers only hold state that is read when drawing, so their
+ * writes are a plain store that skips the switch over the registers with side effects.
+ */
+static constexpr auto reg_write_table = BuildRegWriteTable();
+
 static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
     if (&setup == &g_state.vs) {
         return "vertex shader";
@@ -61,6 +190,38 @@ static void WriteUniformIntReg(Shader::ShaderSetup& setup, unsigned index,
               GetShaderSetupTypeName(setup), index, values.x, values.y, values.z, values.w);
 }
 
+/// Writes a float uniform vector of the packed words, then moves on to the next uniform
+static void WriteUniformFloatVector(ShaderRegs& config, Shader::ShaderSetup& setup,
+                                    const u32* words) {
+    auto& uniform_setup = config.uniform_setup;
+    auto& uniform = setup.uniforms.f[uniform_setup.index];
+
+    if (uniform_setup.index >= 96) {
+        LOG_ERROR(HW_GPU, "Invalid {} float uniform index {}", GetShaderSetupTypeName(setup),
+                  (int)uniform_setup.index);
+    } else {
+
+        // NOTE: The destination component order indeed is "backwards"
+        if (uniform_setup.IsFloat32()) {
+            for (auto i : {0, 1, 2, 3})
+                uniform[3 - i] = float24::FromFloat32(*(const float*)(&words[i]));
+        } else {
+            // TODO: Untested
+            uniform.w = float24::FromRaw(words[0] >> 8);
+            uniform.z = float24::FromRaw(((words[0] & 0xFF) << 16) | ((words[1] >> 16) & 0xFFFF));
+            uniform.y = float24::FromRaw(((words[1] & 0xFFFF) << 8) | ((words[2] >> 24) & 0xFF));
+            uniform.x = float24::FromRaw(words[2] & 0xFFFFFF);
+        }
+
+        LOG_TRACE(HW_GPU, "Set {} float uniform {:x} to ({} {} {} {})",
+                  GetShaderSetupTypeName(setup), (int)uniform_setup.index, uniform.x.ToFloat32(),
+                  uniform.y.ToFloat32(), uniform.z.ToFloat32(), uniform.w.ToFloat32());
+
+        // TODO: Verify that this actually modifies the register!
+        uniform_setup.index.Assign(uniform_setup.index + 1);
+    }
+}
+
 static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
                                  int& float_regs_counter, u32 uniform_write_buffer[4], u32 value) {
     auto& uniform_setup = config.uniform_setup;
@@ -75,70 +236,208 @@ static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
     if ((float_regs_counter >= 4 && uniform_setup.IsFloat32()) ||
         (float_regs_counter >= 3 && !uniform_setup.IsFloat32())) {
         float_regs_counter = 0;
+        WriteUniformFloatVector(config, setup, uniform_write_buffer);
+    }
+}
 
-        auto& uniform = setup.uniforms.f[uniform_setup.index];
+/**
+ * Writes consecutive words to the float uniform registers. Whole vectors are decoded straight from
+ * the command list, only the words of a vector split between commands go through the buffer.
+ */
+static void WriteUniformFloatRegs(ShaderRegs& config, Shader::ShaderSetup& setup,
+                                  int& float_regs_counter, u32 uniform_write_buffer[4],
+                                  const u32* values, std::size_t count) {
+    for (; count > 0 && float_regs_counter != 0; --count) {
+        WriteUniformFloatReg(config, setup, float_regs_counter, uniform_write_buffer, *values++);
+    }
 
-        if (uniform_setup.index >= 96) {
-            LOG_ERROR(HW_GPU, "Invalid {} float uniform index {}", GetShaderSetupTypeName(setup),
-                      (int)uniform_setup.index);
-        } else {
+    const std::size_t vector_size = config.uniform_setup.IsFloat32() ? 4 : 3;
+    for (; count >= vector_size; count -= vector_size, values += vector_size) {
+        WriteUniformFloatVector(config, setup, values);
+    }
 
-            // NOTE: The destination component order indeed is "backwards"
-            if (uniform_setup.IsFloat32()) {
-                for (auto i : {0, 1, 2, 3})
-                    uniform[3 - i] = float24::FromFloat32(*(float*)(&uniform_write_buffer[i]));
-            } else {
-                // TODO: Untested
-                uniform.w = float24::FromRaw(uniform_write_buffer[0] >> 8);
-                uniform.z = float24::FromRaw(((uniform_write_buffer[0] & 0xFF) << 16) |
-                                             ((uniform_write_buffer[1] >> 16) & 0xFFFF));
-                uniform.y = float24::FromRaw(((uniform_write_buffer[1] & 0xFFFF) << 8) |
-                                             ((uniform_write_buffer[2] >> 24) & 0xFF));
-                uniform.x = float24::FromRaw(uniform_write_buffer[2] & 0xFFFFFF);
-            }
+    for (; count > 0; --count) {
+        WriteUniformFloatReg(config, setup, float_regs_counter, uniform_write_buffer, *values++);
+    }
+}
 
-            LOG_TRACE(HW_GPU, "Set {} float uniform {:x} to ({} {} {} {})",
-                      GetShaderSetupTypeName(setup), (int)uniform_setup.index,
-                      uniform.x.ToFloat32(), uniform.y.ToFloat32(), uniform.z.ToFloat32(),
-                      uniform.w.ToFloat32());
+/// Words of program code the vertex shader unit holds, the geometry shader unit has more
+constexpr std::size_t VS_PROGRAM_LENGTH = 512;
 
-            // TODO: Verify that this actually modifies the register!
-            uniform_setup.index.Assign(uniform_setup.index + 1);
+/// Returns the geometry shader setup if writes to the vertex shader code also go to it
+static Shader::ShaderSetup* VSMirror() {
+    return g_state.regs.pipeline.gs_unit_exclusive_configuration ? nullptr : &g_state.gs;
+}
+
+/**
+ * Writes consecutive words of the program code, starting at the offset set in the registers. The
+ * words are copied to the geometry shader as well if `mirror` isn't null.
+ */
+static void WriteProgramWords(Shader::ShaderSetup& setup, Shader::ShaderSetup* mirror, u32& offset,
+                              std::size_t code_length, const u32* values, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i, ++offset) {
+        if (offset >= code_length) {
+            LOG_ERROR(HW_GPU, "Invalid {} program offset {}", GetShaderSetupTypeName(setup),
+                      offset);
+            return;
+        }
+        setup.WriteProgramWord(offset, values[i]);
+        if (mirror) {
+            mirror->WriteProgramWord(offset, values[i]);
         }
     }
 }
 
-static void WritePicaReg(u32 id, u32 value, u32 mask) {
-    auto& regs = g_state.regs;
+/// Writes consecutive words of the swizzle data, like WriteProgramWords
+static void WriteSwizzleWords(Shader::ShaderSetup& setup, Shader::ShaderSetup* mirror, u32& offset,
+                              const u32* values, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i, ++offset) {
+        if (offset >= setup.swizzle_data.size()) {
+            LOG_ERROR(HW_GPU, "Invalid {} swizzle pattern offset {}",
+                      GetShaderSetupTypeName(setup), offset);
+            return;
+        }
+        setup.WriteSwizzleWord(offset, values[i]);
+        if (mirror) {
+            mirror->WriteSwizzleWord(offset, values[i]);
+        }
+    }
+}
 
-    if (id >= Regs::NUM_REGS) {
-        LOG_ERROR(
-            HW_GPU,
-            "Commandlist tried to write to invalid register 0x{:03X} (value: {:08X}, mask: {:X})",
-            id, value, mask);
-        return;
+// Vertices are run through the vertex shader in batches, which saves most of the overhead of
+// invoking the shader per vertex. The shader units of a batch pass their address registers and
+// conditional codes on to each other, just like a single unit would.
+constexpr std::size_t VERTEX_BATCH_SIZE = 16;
+
+/// Draws with fewer vertices are shaded on the GPU thread, which is quicker than waking workers
+constexpr u32 PARALLEL_SHADING_MIN_VERTICES = 1024;
+
+/// Smallest number of vertices shaded by each task of a parallel draw
+constexpr std::size_t PARALLEL_SHADING_CHUNK_SIZE = 16 * VERTEX_BATCH_SIZE;
+
+/**
+ * Runs the vertex shader of a whole draw on the task scheduler, then submits the outputs to the
+ * geometry pipeline in order. Each task starts with fresh shader units, so unlike on hardware the
+ * address registers and conditional codes don't carry over between the chunks of vertices.
+ */
+static void ShadeVerticesParallel(VertexLoader& loader, u32 base_address, bool is_indexed,
+                                  const u8* index_address_8, bool index_u16) {
+    const auto& regs = g_state.regs;
+    const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
+    const u32 num_vertices = regs.pipeline.num_vertices;
+
+    struct ShadedVertex {
+        u32 index;
+        u32 vertex;
+        u32 slot; ///< Output of the vertex
+    };
+    static std::vector<ShadedVertex> shaded_vertices;
+    static std::vector<u32> output_slots;
+    static std::vector<Shader::AttributeBuffer> draw_outputs;
+    shaded_vertices.clear();
+    output_slots.resize(num_vertices);
+
+    // Indexed draws shade each vertex once, repeated indices share the output in the vertex cache
+    for (u32 index = 0; index < num_vertices; ++index) {
+        if (!is_indexed) {
+            shaded_vertices.push_back({index, index + regs.pipeline.vertex_offset, index});
+            output_slots[index] = index;
+            continue;
+        }
+
+        const u32 vertex = index_u16 ? index_address_16[index] : index_address_8[index];
+        bool allocated;
+        output_slots[index] = vertex_cache.Allocate(static_cast<u16>(vertex), allocated);
+        if (allocated) {
+            shaded_vertices.push_back({index, vertex, output_slots[index]});
+        }
     }
 
-    // TODO: Figure out how register masking acts on e.g. vs.uniform_setup.set_value
-    u32 old_value = regs.reg_array[id];
+    Shader::AttributeBuffer* outputs;
+    if (is_indexed) {
+        outputs = vertex_cache.Outputs();
+    } else {
+        draw_outputs.resize(num_vertices);
+        outputs = draw_outputs.data();
+    }
 
-    const u32 write_mask = expand_bits_to_bytes[mask];
+    auto* shader_engine = Shader::GetEngine();
+    const auto ShadeChunk = [&loader, base_address, outputs, shader_engine](std::size_t begin,
+                                                                            std::size_t end) {
+        const auto& regs = g_state.regs;
+        std::array<Shader::UnitState, VERTEX_BATCH_SIZE> shader_units;
+        DebugUtils::MemoryAccessTracker memory_accesses;
 
-    regs.reg_array[id] = (old_value & ~write_mask) | (value & write_mask);
+        for (std::size_t first = begin; first < end; first += VERTEX_BATCH_SIZE) {
+            const std::size_t count = std::min(VERTEX_BATCH_SIZE, end - first);
+            for (std::size_t i = 0; i < count; ++i) {
+                const ShadedVertex& shaded = shaded_vertices[first + i];
+                Shader::AttributeBuffer input;
+                loader.LoadVertex(base_address, shaded.index, shaded.vertex, input,
+                                  memory_accesses);
+                shader_units[i].LoadInput(regs.vs, input);
+            }
 
-    // Double check for is_pica_tracing to avoid call overhead
-    if (DebugUtils::IsPicaTracing()) {
-        DebugUtils::OnPicaRegWrite({(u16)id, (u16)mask, regs.reg_array[id]});
+            shader_engine->RunBatch(g_state.vs, shader_units.data(), count);
+
+            const auto& last_unit = shader_units[count - 1];
+            auto& first_unit = shader_units[0];
+            std::copy(std::begin(last_unit.conditional_code), std::end(last_unit.conditional_code),
+                      first_unit.conditional_code);
+            std::copy(std::begin(last_unit.address_registers),
+                      std::end(last_unit.address_registers), first_unit.address_registers);
+
+            for (std::size_t i = 0; i < count; ++i) {
+                shader_units[i].WriteOutput(regs.vs, outputs[shaded_vertices[first + i].slot]);
+            }
+        }
+    };
+
+    auto& scheduler = Common::TaskScheduler::GetInstance();
+    const std::size_t num_chunks = scheduler.NumWorkers() + 1;
+    const std::size_t num_shaded = shaded_vertices.size();
+    const std::size_t chunk_size =
+        std::max(PARALLEL_SHADING_CHUNK_SIZE, (num_shaded + num_chunks - 1) / num_chunks);
+
+    // The GPU thread shades the last chunk itself, then helps with the queued ones while waiting
+    Common::TaskGroup group{Common::TaskPriority::High, scheduler};
+    std::size_t begin = 0;
+    for (; num_shaded - begin > chunk_size; begin += chunk_size) {
+        group.Submit([&ShadeChunk, begin, chunk_size] { ShadeChunk(begin, begin + chunk_size); });
     }
+    ShadeChunk(begin, num_shaded);
+    group.Wait();
 
-    if (g_debug_context)
-        g_debug_context->OnEvent(DebugContext::Event::PicaCommandLoaded,
-                                 reinterpret_cast<void*>(&id));
+    // Send to geometry pipeline
+    if (!is_indexed) {
+        g_state.geometry_pipeline.SubmitVertices(outputs, num_vertices);
+        return;
+    }
+
+    std::array<Shader::AttributeBuffer, VERTEX_BATCH_SIZE> batch_outputs;
+    for (u32 first = 0; first < num_vertices; first += VERTEX_BATCH_SIZE) {
+        const std::size_t count = std::min<std::size_t>(VERTEX_BATCH_SIZE, num_vertices - first);
+        for (std::size_t i = 0; i < count; ++i) {
+            batch_outputs[i] = outputs[output_slots[first + i]];
+        }
+        g_state.geometry_pipeline.SubmitVertices(batch_outputs.data(), count);
+    }
+}
+
+/// Runs the side effects of writing a register that has a handler in reg_write_table
+static void HandleRegWrite(u32 id, u32 value) {
+    auto& regs = g_state.regs;
 
     switch (id) {
     // Trigger IRQ
     case PICA_REG_INDEX(trigger_irq):
-        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D);
+        if (VideoCore::g_gpu_thread) {
+            // Interrupts have to be signalled from the emulation thread
+            VideoCore::g_gpu_thread->QueueCompletion(
+                [] { Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D); });
+        } else {
+            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::P3D);
+        }
         break;
 
     case PICA_REG_INDEX(pipeline.triangle_topology):
@@ -214,6 +513,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
 
                     auto* shader_engine = Shader::GetEngine();
+                    g_state.vs.output_mask = regs.vs.output_mask;
                     shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
 
                     // Send to vertex shader
@@ -236,14 +536,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
                     g_state.geometry_pipeline.Setup(shader_engine);
                     g_state.geometry_pipeline.SubmitVertex(output);
 
-                    // TODO: If drawing after every immediate mode triangle kills performance,
-                    // change it to flush triangles whenever a drawing config register changes
-                    // See: https://github.com/citra-emu/citra/pull/2866#issuecomment-327011550
-                    VideoCore::g_renderer->Rasterizer()->DrawTriangles();
-                    if (g_debug_context) {
-                        g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch,
-                                                 nullptr);
-                    }
+                    FinishTriangles();
                 }
             }
         }
@@ -269,6 +562,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(pipeline.trigger_draw):
     case PICA_REG_INDEX(pipeline.trigger_draw_indexed): {
         MICROPROFILE_SCOPE(GPU_Drawing);
+        Core::Metrics::Add(Core::Metrics::Counter::DrawCalls);
 
 #if PICA_LOG_TEV
         DebugUtils::DumpTevStageConfig(regs.GetTevStages());
@@ -293,11 +587,22 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             // this, so this is left unimplemented for now. Revisit this when an issue is found in
             // games.
         } else {
-            accelerate_draw = false;
+            // The geometry shader can only be accelerated in the point mode, where each invocation
+            // takes a fixed number of vertices. The draw has to end on a whole invocation.
+            const u32 invocation_vertices = (regs.gs.max_input_attribute_index + 1) /
+                                            (regs.pipeline.vs_outmap_total_minus_1_a + 1);
+            accelerate_draw = accelerate_draw &&
+                              regs.pipeline.gs_config.mode == PipelineRegs::GSMode::Point &&
+                              invocation_vertices != 0 &&
+                              (regs.pipeline.num_vertices % invocation_vertices) == 0;
         }
 
         bool is_indexed = (id == PICA_REG_INDEX(pipeline.trigger_draw_indexed));
 
+        // Accelerated draws are rendered right away, after the queued triangles
+        if (accelerate_draw)
+            DrawPendingTriangles();
+
         if (accelerate_draw &&
             VideoCore::g_renderer->Rasterizer()->AccelerateDrawBatch(is_indexed)) {
             if (g_debug_context) {
@@ -338,19 +643,54 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         DebugUtils::MemoryAccessTracker memory_accesses;
 
-        // Simple circular-replacement vertex cache
-        // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-        const std::size_t VERTEX_CACHE_SIZE = 32;
-        std::array<bool, VERTEX_CACHE_SIZE> vertex_cache_valid{};
-        std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-        std::array<Shader::AttributeBuffer, VERTEX_CACHE_SIZE> vertex_cache;
-        Shader::AttributeBuffer vs_output;
-
-        unsigned int vertex_cache_pos = 0;
+        if (is_indexed)
+            vertex_cache.Reset();
 
         auto* shader_engine = Shader::GetEngine();
-        Shader::UnitState shader_unit;
 
+        constexpr std::size_t NO_SHADER_UNIT = VERTEX_BATCH_SIZE;
+        struct BatchedVertex {
+            unsigned int vertex;
+            std::size_t unit;   ///< Shader unit computing the output, NO_SHADER_UNIT if cached
+            bool computes_unit; ///< Whether the unit was allocated for this vertex
+        };
+        std::array<Shader::UnitState, VERTEX_BATCH_SIZE> shader_units;
+        std::array<BatchedVertex, VERTEX_BATCH_SIZE> batch;
+        std::array<Shader::AttributeBuffer, VERTEX_BATCH_SIZE> batch_outputs;
+        std::size_t batch_size = 0;
+        std::size_t batch_units = 0;
+
+        const auto FlushVertexBatch = [&] {
+            if (batch_units != 0) {
+                shader_engine->RunBatch(g_state.vs, shader_units.data(), batch_units);
+
+                const auto& last_unit = shader_units[batch_units - 1];
+                auto& first_unit = shader_units[0];
+                std::copy(std::begin(last_unit.conditional_code),
+                          std::end(last_unit.conditional_code), first_unit.conditional_code);
+                std::copy(std::begin(last_unit.address_registers),
+                          std::end(last_unit.address_registers), first_unit.address_registers);
+            }
+
+            for (std::size_t i = 0; i < batch_size; ++i) {
+                const BatchedVertex& batched = batch[i];
+                if (batched.unit != NO_SHADER_UNIT) {
+                    shader_units[batched.unit].WriteOutput(regs.vs, batch_outputs[i]);
+                }
+
+                if (is_indexed && batched.computes_unit) {
+                    vertex_cache.Insert(static_cast<u16>(batched.vertex), batch_outputs[i]);
+                }
+            }
+
+            // Send to geometry pipeline
+            g_state.geometry_pipeline.SubmitVertices(batch_outputs.data(), batch_size);
+
+            batch_size = 0;
+            batch_units = 0;
+        };
+
+        g_state.vs.output_mask = regs.vs.output_mask;
         shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
 
         g_state.geometry_pipeline.Reconfigure();
@@ -358,70 +698,76 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
-            // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
+        // Per vertex debug events and recorded memory accesses need the vertices in order
+        const bool shade_parallel = Settings::values.parallel_vertex_shading && !g_debug_context &&
+                                    !g_state.geometry_pipeline.NeedIndexInput() &&
+                                    regs.pipeline.num_vertices >= PARALLEL_SHADING_MIN_VERTICES;
+        if (shade_parallel) {
+            ShadeVerticesParallel(loader, base_address, is_indexed, index_address_8, index_u16);
+        } else {
+            for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+                // Indexed rendering doesn't use the start offset
+                unsigned int vertex =
+                    is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                               : (index + regs.pipeline.vertex_offset);
 
-            bool vertex_cache_hit = false;
+                BatchedVertex& batched = batch[batch_size];
+                batched = {vertex, NO_SHADER_UNIT, false};
+                bool vertex_cache_hit = false;
 
-            if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
-                    continue;
-                }
+                if (is_indexed) {
+                    if (g_state.geometry_pipeline.NeedIndexInput()) {
+                        g_state.geometry_pipeline.SubmitIndex(vertex);
+                        continue;
+                    }
 
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
-                }
+                    if (g_debug_context && Pica::g_debug_context->recorder) {
+                        int size = index_u16 ? 2 : 1;
+                        memory_accesses.AddAccess(base_address + index_info.offset + size * index,
+                                                  size);
+                    }
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
-                        vs_output = vertex_cache[i];
+                    if (const Shader::AttributeBuffer* output = vertex_cache.Find(vertex)) {
+                        batch_outputs[batch_size] = *output;
                         vertex_cache_hit = true;
-                        break;
                     }
-                }
-            }
 
-            if (!vertex_cache_hit) {
-                // Initialize data for the current vertex
-                Shader::AttributeBuffer input;
-                loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+                    // The vertex may also be waiting to be shaded in the current batch
+                    for (std::size_t i = 0; i < batch_size && !vertex_cache_hit; ++i) {
+                        if (batch[i].computes_unit && batch[i].vertex == vertex) {
+                            batched.unit = batch[i].unit;
+                            vertex_cache_hit = true;
+                        }
+                    }
+                }
 
-                // Send to vertex shader
-                if (g_debug_context)
-                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                             (void*)&input);
-                shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
-                shader_unit.WriteOutput(regs.vs, vs_output);
+                if (!vertex_cache_hit) {
+                    // Initialize data for the current vertex
+                    Shader::AttributeBuffer input;
+                    loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
 
-                if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = vs_output;
-                    vertex_cache_valid[vertex_cache_pos] = true;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                    // Send to vertex shader
+                    if (g_debug_context)
+                        g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                                 (void*)&input);
+                    batched.unit = batch_units++;
+                    batched.computes_unit = true;
+                    shader_units[batched.unit].LoadInput(regs.vs, input);
                 }
-            }
 
-            // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
+                if (++batch_size == VERTEX_BATCH_SIZE) {
+                    FlushVertexBatch();
+        }
+            }
         }
+        FlushVertexBatch();
 
         for (auto& range : memory_accesses.ranges) {
             g_debug_context->recorder->MemoryAccessed(
                 VideoCore::g_memory->GetPhysicalPointer(range.first), range.second, range.first);
         }
 
-        VideoCore::g_renderer->Rasterizer()->DrawTriangles();
-        if (g_debug_context) {
-            g_debug_context->OnEvent(DebugContext::Event::FinishedPrimitiveBatch, nullptr);
-        }
-
+        FinishTriangles();
         break;
     }
 
@@ -461,14 +807,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(gs.program.set_word[5]):
     case PICA_REG_INDEX(gs.program.set_word[6]):
     case PICA_REG_INDEX(gs.program.set_word[7]): {
-        u32& offset = g_state.regs.gs.program.offset;
-        if (offset >= 4096) {
-            LOG_ERROR(HW_GPU, "Invalid GS program offset {}", offset);
-        } else {
-            g_state.gs.program_code[offset] = value;
-            g_state.gs.MarkProgramCodeDirty();
-            offset++;
-        }
+        WriteProgramWords(g_state.gs, nullptr, regs.gs.program.offset,
+                          g_state.gs.program_code.size(), &value, 1);
         break;
     }
 
@@ -480,14 +820,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(gs.swizzle_patterns.set_word[5]):
     case PICA_REG_INDEX(gs.swizzle_patterns.set_word[6]):
     case PICA_REG_INDEX(gs.swizzle_patterns.set_word[7]): {
-        u32& offset = g_state.regs.gs.swizzle_patterns.offset;
-        if (offset >= g_state.gs.swizzle_data.size()) {
-            LOG_ERROR(HW_GPU, "Invalid GS swizzle pattern offset {}", offset);
-        } else {
-            g_state.gs.swizzle_data[offset] = value;
-            g_state.gs.MarkSwizzleDataDirty();
-            offset++;
-        }
+        WriteSwizzleWords(g_state.gs, nullptr, regs.gs.swizzle_patterns.offset, &value, 1);
         break;
     }
 
@@ -530,18 +863,8 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(vs.program.set_word[5]):
     case PICA_REG_INDEX(vs.program.set_word[6]):
     case PICA_REG_INDEX(vs.program.set_word[7]): {
-        u32& offset = g_state.regs.vs.program.offset;
-        if (offset >= 512) {
-            LOG_ERROR(HW_GPU, "Invalid VS program offset {}", offset);
-        } else {
-            g_state.vs.program_code[offset] = value;
-            g_state.vs.MarkProgramCodeDirty();
-            if (!g_state.regs.pipeline.gs_unit_exclusive_configuration) {
-                g_state.gs.program_code[offset] = value;
-                g_state.gs.MarkProgramCodeDirty();
-            }
-            offset++;
-        }
+        WriteProgramWords(g_state.vs, VSMirror(), regs.vs.program.offset, VS_PROGRAM_LENGTH,
+                          &value, 1);
         break;
     }
 
@@ -553,18 +876,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(vs.swizzle_patterns.set_word[5]):
     case PICA_REG_INDEX(vs.swizzle_patterns.set_word[6]):
     case PICA_REG_INDEX(vs.swizzle_patterns.set_word[7]): {
-        u32& offset = g_state.regs.vs.swizzle_patterns.offset;
-        if (offset >= g_state.vs.swizzle_data.size()) {
-            LOG_ERROR(HW_GPU, "Invalid VS swizzle pattern offset {}", offset);
-        } else {
-            g_state.vs.swizzle_data[offset] = value;
-            g_state.vs.MarkSwizzleDataDirty();
-            if (!g_state.regs.pipeline.gs_unit_exclusive_configuration) {
-                g_state.gs.swizzle_data[offset] = value;
-                g_state.gs.MarkSwizzleDataDirty();
-            }
-            offset++;
-        }
+        WriteSwizzleWords(g_state.vs, VSMirror(), regs.vs.swizzle_patterns.offset, &value, 1);
         break;
     }
 
@@ -632,15 +944,109 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     default:
         break;
     }
+}
+
+static void WritePicaReg(u32 id, u32 value, u32 mask) {
+    auto& regs = g_state.regs;
+
+    if (id >= Regs::NUM_REGS) {
+        LOG_ERROR(
+            HW_GPU,
+            "Commandlist tried to write to invalid register 0x{:03X} (value: {:08X}, mask: {:X})",
+            id, value, mask);
+        return;
+    }
+
+    // TODO: Figure out how register masking acts on e.g. vs.uniform_setup.set_value
+    u32 old_value = regs.reg_array[id];
+
+    const u32 write_mask = expand_bits_to_bytes[mask];
+    const u32 new_value = (old_value & ~write_mask) | (value & write_mask);
+
+    // The registers after the rasterization ones only configure vertex processing, which the
+    // queued triangles went through already
+    const RegWriteInfo& info = reg_write_table[id];
+    const bool is_rasterizer_reg = id < PICA_REG_INDEX(pipeline);
+    const bool state_changed = !is_rasterizer_reg || info.always_changes || old_value != new_value;
+    if (triangles_pending && is_rasterizer_reg && state_changed)
+        DrawPendingTriangles();
 
-    VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    regs.reg_array[id] = new_value;
+
+    // Double check for is_pica_tracing to avoid call overhead
+    if (DebugUtils::IsPicaTracing()) {
+        DebugUtils::OnPicaRegWrite({(u16)id, (u16)mask, regs.reg_array[id]});
+    }
+
+    if (g_debug_context)
+        g_debug_context->OnEvent(DebugContext::Event::PicaCommandLoaded,
+                                 reinterpret_cast<void*>(&id));
+
+    if (info.has_handler)
+        HandleRegWrite(id, value);
+
+    // Games rewrite most of the state before every draw, syncing it again only wastes time and
+    // marks the uniforms and shaders of the rasterizer dirty
+    if (state_changed)
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
 
     if (g_debug_context)
         g_debug_context->OnEvent(DebugContext::Event::PicaCommandProcessed,
                                  reinterpret_cast<void*>(&id));
 }
 
+/**
+ * Writes the extra words of a command to the float uniform, program or swizzle registers in one
+ * go, which is how games upload shaders and their uniforms. Has the same effect as writing the
+ * words one at a time with WritePicaReg. Returns false if the command writes other registers or
+ * the debugger has to see each write, in which case nothing was written.
+ */
+static bool WriteShaderDataBulk(const CommandHeader& header, const u32* values) {
+    const u32 count = header.extra_data_length;
+    const u32 first_id = header.cmd_id + (header.group_commands ? 1 : 0);
+    const u32 last_id = header.cmd_id + (header.group_commands ? count : 0);
+    if (g_debug_context || DebugUtils::IsPicaTracing())
+        return false;
+
+    // All set_value and set_word registers of a shader unit do the same
+    const auto is_data_port = [first_id, last_id](std::size_t port) {
+        return first_id >= port && last_id < port + 8;
+    };
+
+    auto& regs = g_state.regs;
+    if (is_data_port(PICA_REG_INDEX(vs.uniform_setup.set_value[0]))) {
+        // TODO (wwylele): does regs.pipeline.gs_unit_exclusive_configuration affect this?
+        WriteUniformFloatRegs(regs.vs, g_state.vs, g_state.vs_float_regs_counter,
+                              g_state.vs_uniform_write_buffer, values, count);
+    } else if (is_data_port(PICA_REG_INDEX(vs.program.set_word[0]))) {
+        WriteProgramWords(g_state.vs, VSMirror(), regs.vs.program.offset, VS_PROGRAM_LENGTH,
+                          values, count);
+    } else if (is_data_port(PICA_REG_INDEX(vs.swizzle_patterns.set_word[0]))) {
+        WriteSwizzleWords(g_state.vs, VSMirror(), regs.vs.swizzle_patterns.offset, values, count);
+    } else if (is_data_port(PICA_REG_INDEX(gs.uniform_setup.set_value[0]))) {
+        WriteUniformFloatRegs(regs.gs, g_state.gs, g_state.gs_float_regs_counter,
+                              g_state.gs_uniform_write_buffer, values, count);
+    } else if (is_data_port(PICA_REG_INDEX(gs.program.set_word[0]))) {
+        WriteProgramWords(g_state.gs, nullptr, regs.gs.program.offset,
+                          g_state.gs.program_code.size(), values, count);
+    } else if (is_data_port(PICA_REG_INDEX(gs.swizzle_patterns.set_word[0]))) {
+        WriteSwizzleWords(g_state.gs, nullptr, regs.gs.swizzle_patterns.offset, values, count);
+    } else {
+        return false;
+    }
+
+    // Each register keeps the last word written to it, a masked write only replaces some bytes
+    const u32 write_mask = expand_bits_to_bytes[header.parameter_mask];
+    for (u32 id = first_id; id <= last_id; ++id) {
+        const u32 value = values[header.group_commands ? id - first_id : count - 1];
+        regs.reg_array[id] = (regs.reg_array[id] & ~write_mask) | (value & write_mask);
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    }
+    return true;
+}
+
 void ProcessCommandList(const u32* list, u32 size) {
+    Core::Metrics::ScopedTimer metrics_timer{Core::Metrics::Time::GPU};
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = list;
     g_state.cmd_list.length = size / sizeof(u32);
 
@@ -655,11 +1061,20 @@ void ProcessCommandList(const u32* list, u32 size) {
 
         WritePicaReg(header.cmd_id, value, header.parameter_mask);
 
+        if (header.extra_data_length != 0 &&
+            WriteShaderDataBulk(header, g_state.cmd_list.current_ptr)) {
+            g_state.cmd_list.current_ptr += header.extra_data_length;
+            continue;
+        }
+
         for (unsigned i = 0; i < header.extra_data_length; ++i) {
             u32 cmd = header.cmd_id + (header.group_commands ? i + 1 : 0);
             WritePicaReg(cmd, *g_state.cmd_list.current_ptr++, header.parameter_mask);
         }
     }
+
+    // Other GPU operations and the CPU may access the render targets after the list
+    DrawPendingTriangles();
 }
 
 } // namespace Pica::CommandProcessor
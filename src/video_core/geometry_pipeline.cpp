@@ -2,6 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <optional>
+#include "common/task_scheduler.h"
 #include "video_core/geometry_pipeline.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs.h"
@@ -30,6 +34,32 @@ public:
      * @return if the buffer is full and the geometry shader should be invoked
      */
     virtual bool SubmitVertex(const Shader::AttributeBuffer& input) = 0;
+
+    /// Number of values SaveInvocation stores, 0 if the invocations can't run on other units
+    virtual std::size_t InvocationSize() const {
+        return 0;
+    }
+
+    /// Input registers the invocations are given, the others keep their values
+    virtual u32 LoadedInputMask() const {
+        return 0;
+    }
+
+    /// Whether LoadInvocation writes to the uniforms of the shader setup
+    virtual bool LoadsUniforms() const {
+        return false;
+    }
+
+    /// Stores the inputs of the invocation that the last call to SubmitVertex completed
+    virtual void SaveInvocation(Common::Vec4<float24>* inputs) const {
+        UNREACHABLE();
+    }
+
+    /// Gives saved inputs to a unit and the shader setup it runs with
+    virtual void LoadInvocation(const Common::Vec4<float24>* inputs, Shader::ShaderSetup& setup,
+                                Shader::GSUnitState& unit) const {
+        UNREACHABLE();
+    }
 };
 
 // In the Point mode, vertex attributes are sent to the input registers in the geometry shader unit.
@@ -48,6 +78,9 @@ public:
         ASSERT(gs_input_num % vs_output_num == 0);
         buffer_cur = attribute_buffer.attr;
         buffer_end = attribute_buffer.attr + gs_input_num;
+        for (unsigned attr = 0; attr <= regs.gs.max_input_attribute_index; ++attr) {
+            loaded_input_mask |= 1u << regs.gs.GetRegisterForAttribute(attr);
+        }
     }
 
     bool IsEmpty() const override {
@@ -72,6 +105,23 @@ public:
         return false;
     }
 
+    std::size_t InvocationSize() const override {
+        return std::size(unit.registers.input);
+    }
+
+    u32 LoadedInputMask() const override {
+        return loaded_input_mask;
+    }
+
+    void SaveInvocation(Common::Vec4<float24>* inputs) const override {
+        std::copy(std::begin(unit.registers.input), std::end(unit.registers.input), inputs);
+    }
+
+    void LoadInvocation(const Common::Vec4<float24>* inputs, Shader::ShaderSetup& setup,
+                        Shader::GSUnitState& target) const override {
+        std::copy(inputs, inputs + InvocationSize(), target.registers.input);
+    }
+
 private:
     const Regs& regs;
     Shader::GSUnitState& unit;
@@ -79,6 +129,7 @@ private:
     Common::Vec4<float24>* buffer_cur;
     Common::Vec4<float24>* buffer_end;
     unsigned int vs_output_num;
+    u32 loaded_input_mask = 0;
 };
 
 // In VariablePrimitive mode, vertex attributes are buffered into the uniform registers in the
@@ -183,6 +234,24 @@ public:
         return false;
     }
 
+    std::size_t InvocationSize() const override {
+        return static_cast<std::size_t>(buffer_end - buffer_begin);
+    }
+
+    bool LoadsUniforms() const override {
+        return true;
+    }
+
+    void SaveInvocation(Common::Vec4<float24>* inputs) const override {
+        std::copy(buffer_begin, buffer_end, inputs);
+    }
+
+    void LoadInvocation(const Common::Vec4<float24>* inputs, Shader::ShaderSetup& target,
+                        Shader::GSUnitState& unit) const override {
+        std::copy(inputs, inputs + InvocationSize(),
+                  target.uniforms.f + regs.pipeline.gs_config.start_index);
+    }
+
 private:
     const Regs& regs;
     Shader::ShaderSetup& setup;
@@ -192,12 +261,179 @@ private:
     unsigned int vs_output_num;
 };
 
+// Invocations below this run on the calling thread, as they wouldn't pay for the worker handoff
+constexpr std::size_t MIN_INVOCATIONS_PER_WORKER = 32;
+
+/**
+ * Checks that every invocation of a geometry shader only depends on its own inputs and the
+ * uniforms, so that the invocations can run on separate units. The unit state carries over from
+ * one invocation to the next, so this is only the case when nothing is read before the invocation
+ * wrote it: no temporary or output register, no vertex of the emitter and no input register that
+ * isn't loaded. Programs with flow control or relative addressing aren't checked and are assumed
+ * to depend on the previous invocations. Programs without them also write the same registers in
+ * every invocation, so the state the last one leaves is the state after running all of them.
+ */
+static bool IsInvocationIndependent(const Shader::ShaderSetup& setup, u32 loaded_input_mask,
+                                    u32 output_mask) {
+    using nihstro::Instruction;
+    using nihstro::OpCode;
+    using nihstro::RegisterType;
+    using nihstro::SourceRegister;
+    using nihstro::SwizzlePattern;
+
+    // Components of each register written by the invocation so far
+    std::array<u32, 16> temporaries_written{};
+    std::array<u32, 16> outputs_written{};
+    std::array<bool, 3> vertices_emitted{};
+    bool emit_set = false;
+    unsigned vertex_id = 0;
+    bool prim_emit = false;
+
+    const auto can_read = [&](SourceRegister reg, auto get_selector) {
+        u32 components = 0;
+        for (int i = 0; i < 4; ++i) {
+            components |= 1u << static_cast<int>(get_selector(i));
+        }
+        switch (reg.GetRegisterType()) {
+        case RegisterType::Input:
+            return ((loaded_input_mask >> reg.GetIndex()) & 1) != 0;
+        case RegisterType::Temporary:
+            return (temporaries_written[reg.GetIndex()] & components) == components;
+        default:
+            return true;
+        }
+    };
+    const auto write = [&](auto dest, const SwizzlePattern& swizzle) {
+        u32 components = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (swizzle.DestComponentEnabled(i))
+                components |= 1u << i;
+        }
+        if (dest < 0x10) {
+            outputs_written[dest.GetIndex()] |= components;
+        } else if (dest < 0x20) {
+            temporaries_written[dest.GetIndex()] |= components;
+        }
+    };
+
+    for (u32 offset = setup.engine_data.entry_point; offset < setup.program_code.size(); ++offset) {
+        const Instruction instr = {setup.program_code[offset]};
+        const OpCode::Info info = instr.opcode.Value().GetInfo();
+
+        switch (info.type) {
+        case OpCode::Type::Arithmetic: {
+            const SwizzlePattern swizzle = {setup.swizzle_data[instr.common.operand_desc_id]};
+            const bool is_inverted = (info.subtype & OpCode::Info::SrcInversed) != 0;
+            if (instr.common.address_register_index != 0)
+                return false;
+            if ((info.subtype & OpCode::Info::Src1) &&
+                !can_read(instr.common.GetSrc1(is_inverted),
+                          [&](int i) { return swizzle.GetSelectorSrc1(i); })) {
+                return false;
+            }
+            if ((info.subtype & OpCode::Info::Src2) &&
+                !can_read(instr.common.GetSrc2(is_inverted),
+                          [&](int i) { return swizzle.GetSelectorSrc2(i); })) {
+                return false;
+            }
+            // MOVA and CMP write the address registers and the conditional codes, which are only
+            // read with relative addressing and flow control
+            const OpCode::Id id = instr.opcode.Value().EffectiveOpCode();
+            if (id != OpCode::Id::MOVA && id != OpCode::Id::CMP &&
+                (info.subtype & OpCode::Info::Dest)) {
+                write(instr.common.dest.Value(), swizzle);
+            }
+            break;
+        }
+
+        case OpCode::Type::MultiplyAdd: {
+            const OpCode::Id id = instr.opcode.Value().EffectiveOpCode();
+            if ((id != OpCode::Id::MAD && id != OpCode::Id::MADI) ||
+                instr.mad.address_register_index != 0) {
+                return false;
+            }
+            const SwizzlePattern swizzle = {setup.swizzle_data[instr.mad.operand_desc_id]};
+            const bool is_inverted = id == OpCode::Id::MADI;
+            if (!can_read(instr.mad.GetSrc1(is_inverted),
+                          [&](int i) { return swizzle.GetSelectorSrc1(i); }) ||
+                !can_read(instr.mad.GetSrc2(is_inverted),
+                          [&](int i) { return swizzle.GetSelectorSrc2(i); }) ||
+                !can_read(instr.mad.GetSrc3(is_inverted),
+                          [&](int i) { return swizzle.GetSelectorSrc3(i); })) {
+                return false;
+            }
+            write(instr.mad.dest.Value(), swizzle);
+            break;
+        }
+
+        default:
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::NOP:
+                break;
+            case OpCode::Id::END:
+                return true;
+            case OpCode::Id::SETEMIT:
+                emit_set = true;
+                vertex_id = instr.setemit.vertex_id;
+                prim_emit = instr.setemit.prim_emit != 0;
+                break;
+            case OpCode::Id::EMIT:
+                if (!emit_set || vertex_id >= vertices_emitted.size())
+                    return false;
+                for (u32 reg = 0; reg < outputs_written.size(); ++reg) {
+                    if (((output_mask >> reg) & 1) && outputs_written[reg] != 0xF)
+                        return false;
+                }
+                vertices_emitted[vertex_id] = true;
+                if (prim_emit && !std::all_of(vertices_emitted.begin(), vertices_emitted.end(),
+                                              [](bool emitted) { return emitted; })) {
+                    return false;
+                }
+                break;
+            default:
+                // Flow control
+                return false;
+            }
+            break;
+        }
+    }
+    return false;
+}
+
+/// Copies the parts of a unit state that carry over from one invocation to the next
+static void CopyUnitState(const Shader::GSUnitState& from, Shader::GSUnitState& to) {
+    to.registers = from.registers;
+    std::copy(std::begin(from.conditional_code), std::end(from.conditional_code),
+              to.conditional_code);
+    std::copy(std::begin(from.address_registers), std::end(from.address_registers),
+              to.address_registers);
+    to.emitter.buffer = from.emitter.buffer;
+    to.emitter.vertex_id = from.emitter.vertex_id;
+    to.emitter.prim_emit = from.emitter.prim_emit;
+    to.emitter.winding = from.emitter.winding;
+    to.emitter.output_mask = from.emitter.output_mask;
+}
+
+/// Invocations run by one worker and the primitives they emitted
+struct InvocationRange {
+    std::size_t begin;
+    std::size_t end;
+    Shader::GSUnitState unit;
+    /// Own copy of the shader setup, for backends that give the inputs in the uniforms
+    std::optional<Shader::ShaderSetup> setup;
+    std::vector<Shader::AttributeBuffer> vertices;
+    /// Number of vertices emitted before each winding change
+    std::vector<std::size_t> windings;
+};
+
 GeometryPipeline::GeometryPipeline(State& state) : state(state) {}
 
 GeometryPipeline::~GeometryPipeline() = default;
 
-void GeometryPipeline::SetVertexHandler(Shader::VertexHandler vertex_handler) {
+void GeometryPipeline::SetVertexHandler(Shader::VertexHandler vertex_handler,
+                                        Shader::VertexBatchHandler batch_handler) {
     this->vertex_handler = vertex_handler;
+    this->batch_handler = batch_handler;
 }
 
 void GeometryPipeline::Setup(Shader::ShaderEngine* shader_engine) {
@@ -205,11 +441,20 @@ void GeometryPipeline::Setup(Shader::ShaderEngine* shader_engine) {
         return;
 
     this->shader_engine = shader_engine;
+    state.gs.output_mask = state.regs.gs.output_mask;
+    // b15 is set after the first invocation of the batch, see SubmitVertex
+    state.gs.dynamic_bool_uniforms = 1 << 15;
     shader_engine->SetupBatch(state.gs, state.regs.gs.main_offset);
+
+    independent_invocations = backend->InvocationSize() != 0 &&
+                              Common::TaskScheduler::GetInstance().NumWorkers() != 0 &&
+                              IsInvocationIndependent(state.gs, backend->LoadedInputMask(),
+                                                      state.gs.output_mask);
 }
 
 void GeometryPipeline::Reconfigure() {
     ASSERT(!backend || backend->IsEmpty());
+    independent_invocations = false;
 
     if (state.regs.pipeline.use_gs == PipelineRegs::UseGS::No) {
         backend = nullptr;
@@ -271,4 +516,92 @@ void GeometryPipeline::SubmitVertex(const Shader::AttributeBuffer& input) {
     }
 }
 
+void GeometryPipeline::SubmitVertices(const Shader::AttributeBuffer* inputs, std::size_t count) {
+    if (!backend) {
+        batch_handler(inputs, count);
+        return;
+    }
+
+    if (!independent_invocations) {
+        for (std::size_t i = 0; i < count; ++i) {
+            SubmitVertex(inputs[i]);
+        }
+        return;
+    }
+
+    const std::size_t size = backend->InvocationSize();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (backend->SubmitVertex(inputs[i])) {
+            saved_invocations.resize(saved_invocations.size() + size);
+            backend->SaveInvocation(saved_invocations.data() + saved_invocations.size() - size);
+        }
+    }
+    RunSavedInvocations();
+}
+
+void GeometryPipeline::RunSavedInvocations() {
+    const std::size_t size = backend->InvocationSize();
+    const std::size_t num_invocations = saved_invocations.size() / size;
+    auto& scheduler = Common::TaskScheduler::GetInstance();
+    const std::size_t num_ranges =
+        std::min(scheduler.NumWorkers() + 1, num_invocations / MIN_INVOCATIONS_PER_WORKER);
+
+    if (num_ranges < 2) {
+        for (std::size_t i = 0; i < num_invocations; ++i) {
+            backend->LoadInvocation(saved_invocations.data() + i * size, state.gs, state.gs_unit);
+            shader_engine->Run(state.gs, state.gs_unit);
+            state.gs.uniforms.b[15] = true;
+        }
+        saved_invocations.clear();
+        return;
+    }
+
+    // Every range starts from the current state, which the invocations don't read. The ranges
+    // collect the primitives they emit, which are assembled in order afterwards.
+    std::vector<InvocationRange> ranges(num_ranges);
+    for (std::size_t i = 0; i < num_ranges; ++i) {
+        InvocationRange& range = ranges[i];
+        range.begin = num_invocations * i / num_ranges;
+        range.end = num_invocations * (i + 1) / num_ranges;
+        CopyUnitState(state.gs_unit, range.unit);
+        range.unit.SetVertexHandler(
+            [&range](const Shader::AttributeBuffer& vertex) { range.vertices.push_back(vertex); },
+            [&range] { range.windings.push_back(range.vertices.size()); });
+        if (backend->LoadsUniforms()) {
+            range.setup.emplace(state.gs);
+        }
+    }
+
+    const auto run_range = [this, size](InvocationRange& range) {
+        Shader::ShaderSetup& setup = range.setup ? *range.setup : state.gs;
+        for (std::size_t i = range.begin; i < range.end; ++i) {
+            backend->LoadInvocation(saved_invocations.data() + i * size, setup, range.unit);
+            shader_engine->Run(setup, range.unit);
+        }
+    };
+    {
+        Common::TaskGroup group(Common::TaskPriority::High, scheduler);
+        for (std::size_t i = 1; i < num_ranges; ++i) {
+            group.Submit([&run_range, &range = ranges[i]] { run_range(range); });
+        }
+        run_range(ranges[0]);
+        group.Wait();
+    }
+
+    const auto& handlers = *state.gs_unit.emitter.handlers;
+    for (const InvocationRange& range : ranges) {
+        auto winding = range.windings.begin();
+        for (std::size_t i = 0; i < range.vertices.size(); ++i) {
+            for (; winding != range.windings.end() && *winding == i; ++winding) {
+                handlers.winding_setter();
+            }
+            handlers.vertex_handler(range.vertices[i]);
+        }
+    }
+
+    CopyUnitState(ranges.back().unit, state.gs_unit);
+    state.gs.uniforms.b[15] = true;
+    saved_invocations.clear();
+}
+
 } // namespace Pica
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "video_core/shader/shader.h"
 
 namespace Pica {
@@ -19,8 +20,9 @@ public:
     explicit GeometryPipeline(State& state);
     ~GeometryPipeline();
 
-    /// Sets the handler for receiving vertex outputs from vertex shader
-    void SetVertexHandler(Shader::VertexHandler vertex_handler);
+    /// Sets the handlers for receiving vertex outputs from vertex shader, one by one or in batches
+    void SetVertexHandler(Shader::VertexHandler vertex_handler,
+                          Shader::VertexBatchHandler batch_handler);
 
     /**
      * Setup the geometry shader unit if it is in use
@@ -40,10 +42,21 @@ public:
     /// Submits vertex attributes output from vertex shader
     void SubmitVertex(const Shader::AttributeBuffer& input);
 
+    /// Submits a span of vertex attributes output from vertex shader, in order
+    void SubmitVertices(const Shader::AttributeBuffer* inputs, std::size_t count);
+
 private:
+    /// Runs the invocations saved by SubmitVertices, on the workers if there are enough of them
+    void RunSavedInvocations();
+
     Shader::VertexHandler vertex_handler;
+    Shader::VertexBatchHandler batch_handler;
     Shader::ShaderEngine* shader_engine;
     std::unique_ptr<GeometryPipelineBackend> backend;
+    /// Whether the invocations of the current program don't depend on each other
+    bool independent_invocations = false;
+    /// Inputs of the invocations to run, InvocationSize values each
+    std::vector<Common::Vec4<float24>> saved_invocations;
     State& state;
 };
 } // namespace Pica
@@ -0,0 +1,167 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/command_processor.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace VideoCore {
+
+MICROPROFILE_DEFINE(GPUThread_Wait, "GPU", "Wait for GPU thread", MP_RGB(255, 128, 128));
+
+GPUThread::GPUThread(Frontend::GraphicsContext& context) : context{context} {}
+
+GPUThread::~GPUThread() {
+    if (!is_started) {
+        return;
+    }
+
+    PushCommand(EndProcessingCommand{});
+    thread.join();
+
+    // Give the render context back to the thread that is shutting down the video core, which is
+    // the state it was in before the GPU thread took over
+    context.MakeCurrent();
+}
+
+void GPUThread::SubmitList(const u32* list, u32 size) {
+    PushCommand(SubmitListCommand{list, size});
+}
+
+void GPUThread::SwapBuffers() {
+    // Only allow a single frame in flight, so that the emulation thread can not run away from the
+    // GPU thread
+    WaitForFence(last_swap_fence);
+    last_swap_fence = PushCommand(SwapBuffersCommand{});
+}
+
+void GPUThread::FlushRegion(PAddr addr, u32 size) {
+    if (!is_started) {
+        g_renderer->Rasterizer()->FlushRegion(addr, size);
+        return;
+    }
+    WaitForFence(PushCommand(FlushRegionCommand{addr, size}));
+}
+
+void GPUThread::InvalidateRegion(PAddr addr, u32 size) {
+    if (!is_started) {
+        g_renderer->Rasterizer()->InvalidateRegion(addr, size);
+        return;
+    }
+    PushCommand(InvalidateRegionCommand{addr, size});
+}
+
+void GPUThread::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    if (!is_started) {
+        g_renderer->Rasterizer()->FlushAndInvalidateRegion(addr, size);
+        return;
+    }
+    WaitForFence(PushCommand(FlushAndInvalidateRegionCommand{addr, size}));
+}
+
+void GPUThread::Execute(std::function<void()> work, std::function<void()> on_complete) {
+    PushCommand(ExecuteCommand{std::move(work), std::move(on_complete)});
+}
+
+void GPUThread::QueueCompletion(std::function<void()> callback) {
+    DEBUG_ASSERT(IsGPUThread());
+    completions.Push(std::move(callback));
+}
+
+void GPUThread::ProcessCompletions() {
+    for (std::function<void()> callback; completions.Pop(callback);) {
+        callback();
+    }
+}
+
+void GPUThread::WaitIdle() {
+    WaitForFence(last_fence);
+}
+
+u64 GPUThread::PushCommand(CommandData&& command_data) {
+    if (!is_started) {
+        Start();
+    }
+
+    std::lock_guard lock{push_mutex};
+    const u64 fence = ++last_fence;
+    queue.Push(CommandDataContainer(std::move(command_data), fence));
+    return fence;
+}
+
+void GPUThread::WaitForFence(u64 fence) {
+    if (signaled_fence >= fence) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPUThread_Wait);
+    std::unique_lock lock{signal_mutex};
+    signal_cv.wait(lock, [this, fence] { return signaled_fence >= fence; });
+}
+
+void GPUThread::Start() {
+    // The rasterizer objects live in this context, so the GPU thread has to use the very same
+    // context instead of a shared one
+    context.DoneCurrent();
+
+    Common::Event thread_ready;
+    thread = std::thread([this, &thread_ready] {
+        thread_id = std::this_thread::get_id();
+        context.MakeCurrent();
+        thread_ready.Set();
+        RunThread();
+    });
+    thread_ready.Wait();
+    is_started = true;
+}
+
+void GPUThread::RunThread() {
+    Common::SetCurrentThreadName("GPUThread");
+    MicroProfileOnThreadCreate("GPUThread");
+
+    while (true) {
+        CommandDataContainer next = queue.PopWait();
+        if (std::holds_alternative<EndProcessingCommand>(next.data)) {
+            break;
+        }
+
+        auto* rasterizer = g_renderer->Rasterizer();
+        if (const auto submit_list = std::get_if<SubmitListCommand>(&next.data)) {
+            Pica::CommandProcessor::ProcessCommandList(submit_list->list, submit_list->size);
+        } else if (std::holds_alternative<SwapBuffersCommand>(next.data)) {
+            g_renderer->SwapBuffers();
+        } else if (const auto flush = std::get_if<FlushRegionCommand>(&next.data)) {
+            rasterizer->FlushRegion(flush->addr, flush->size);
+        } else if (const auto invalidate = std::get_if<InvalidateRegionCommand>(&next.data)) {
+            rasterizer->InvalidateRegion(invalidate->addr, invalidate->size);
+        } else if (const auto flush_and_invalidate =
+                       std::get_if<FlushAndInvalidateRegionCommand>(&next.data)) {
+            rasterizer->FlushAndInvalidateRegion(flush_and_invalidate->addr,
+                                                 flush_and_invalidate->size);
+        } else if (const auto execute = std::get_if<ExecuteCommand>(&next.data)) {
+            execute->work();
+            if (execute->on_complete) {
+                completions.Push(std::move(execute->on_complete));
+            }
+        } else {
+            UNREACHABLE();
+        }
+
+        {
+            std::lock_guard lock{signal_mutex};
+            signaled_fence = next.fence;
+        }
+        signal_cv.notify_all();
+    }
+
+    context.DoneCurrent();
+}
+
+} // namespace VideoCore
@@ -0,0 +1,159 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <variant>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+
+namespace Frontend {
+class GraphicsContext;
+}
+
+namespace VideoCore {
+
+/// Processes a PICA command list located at the given host pointer
+struct SubmitListCommand final {
+    const u32* list;
+    u32 size;
+};
+
+/// Finishes the current guest frame and hands it over to the presentation thread
+struct SwapBuffersCommand final {};
+
+/// Writes back any rasterizer cached data in the region to guest memory
+struct FlushRegionCommand final {
+    PAddr addr;
+    u32 size;
+};
+
+/// Drops any rasterizer cached data in the region because guest memory was modified
+struct InvalidateRegionCommand final {
+    PAddr addr;
+    u32 size;
+};
+
+/// Writes back and then drops any rasterizer cached data in the region
+struct FlushAndInvalidateRegionCommand final {
+    PAddr addr;
+    u32 size;
+};
+
+/**
+ * Runs an arbitrary piece of GPU work (e.g. a memory fill or display transfer). Once the work is
+ * done, `on_complete` (if set) is handed back to the emulation thread, which is where interrupts
+ * and register bookkeeping must happen.
+ */
+struct ExecuteCommand final {
+    std::function<void()> work;
+    std::function<void()> on_complete;
+};
+
+/// Stops the GPU thread
+struct EndProcessingCommand final {};
+
+using CommandData =
+    std::variant<EndProcessingCommand, SubmitListCommand, SwapBuffersCommand, FlushRegionCommand,
+                 InvalidateRegionCommand, FlushAndInvalidateRegionCommand, ExecuteCommand>;
+
+struct CommandDataContainer {
+    CommandDataContainer() = default;
+
+    CommandDataContainer(CommandData&& data, u64 next_fence)
+        : data{std::move(data)}, fence{next_fence} {}
+
+    CommandData data;
+    u64 fence{};
+};
+
+/**
+ * Optional dedicated thread that consumes GPU work (command lists, memory fills, display
+ * transfers and frame swaps) from a FIFO, so that the emulation thread does not stall on the
+ * rasterizer for every draw.
+ *
+ * The thread is started lazily on the first submission: at that point the emulation thread is the
+ * one holding the render context, which it then releases so that the GPU thread can take it over.
+ *
+ * Flushes are synchronous, since the CPU is about to read the flushed memory. Invalidations are
+ * ordered in the FIFO after all previously submitted work and do not block.
+ */
+class GPUThread {
+public:
+    explicit GPUThread(Frontend::GraphicsContext& context);
+    ~GPUThread();
+
+    /// Queues a PICA command list for processing
+    void SubmitList(const u32* list, u32 size);
+
+    /// Queues the end of the current frame. Blocks if the previous frame is still in flight.
+    void SwapBuffers();
+
+    /// Writes back cached GPU data for the region to guest memory and waits for it to finish
+    void FlushRegion(PAddr addr, u32 size);
+
+    /// Queues an invalidation of cached GPU data for the region
+    void InvalidateRegion(PAddr addr, u32 size);
+
+    /// Writes back and drops cached GPU data for the region and waits for it to finish
+    void FlushAndInvalidateRegion(PAddr addr, u32 size);
+
+    /// Queues arbitrary GPU work, with an optional completion callback for the emulation thread
+    void Execute(std::function<void()> work, std::function<void()> on_complete = nullptr);
+
+    /**
+     * Hands a callback over to the emulation thread. Must be called from the GPU thread, e.g. when
+     * a command list raises an interrupt.
+     */
+    void QueueCompletion(std::function<void()> callback);
+
+    /// Runs all completion callbacks queued by the GPU thread. Called from the emulation thread.
+    void ProcessCompletions();
+
+    /// Blocks until all work submitted so far has been processed
+    void WaitIdle();
+
+    /// Returns true if the caller is running on the GPU thread
+    bool IsGPUThread() const {
+        return std::this_thread::get_id() == thread_id;
+    }
+
+private:
+    /// Pushes a command into the FIFO and returns its fence
+    u64 PushCommand(CommandData&& command_data);
+
+    /// Blocks until the command with the given fence has been processed
+    void WaitForFence(u64 fence);
+
+    /// Releases the render context from the caller and starts the GPU thread
+    void Start();
+
+    void RunThread();
+
+    Frontend::GraphicsContext& context;
+    std::thread thread;
+    std::thread::id thread_id;
+    std::atomic_bool is_started{false};
+
+    // Fences have to enter the queue in increasing order, so pushing is serialized by a mutex,
+    // which also leaves the queue with a single producer. When the FIFO is full the emulation
+    // thread waits for the GPU thread to catch up.
+    std::mutex push_mutex;
+    Common::BoundedSPSCQueue<CommandDataContainer, 4096> queue;
+    // Unbounded, since the emulation thread may be waiting on a fence while completions pile up
+    Common::SPSCQueue<std::function<void()>> completions;
+
+    std::atomic<u64> last_fence{};
+    std::atomic<u64> signaled_fence{};
+    u64 last_swap_fence{};
+    std::mutex signal_mutex;
+    std::condition_variable signal_cv;
+};
+
+} // namespace VideoCore
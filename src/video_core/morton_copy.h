@@ -0,0 +1,213 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstring>
+#include "common/common_types.h"
+#include "video_core/utils.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+namespace VideoCore {
+
+/// Byte reordering applied to every pixel when converting between morton and linear order
+enum class MortonConversion {
+    None,        ///< Pixels are copied unchanged
+    RotateD24S8, ///< D24S8 in morton order is S8D24 in linear order
+    ByteSwap,    ///< The bytes of each pixel are reversed, for RGBA8 and RGB8 on GLES
+};
+
+namespace MortonDetail {
+
+template <bool morton_to_linear, u32 bytes_per_pixel, MortonConversion conversion>
+inline void ConvertPixel(u8* dst, const u8* src) {
+    if constexpr (conversion == MortonConversion::RotateD24S8) {
+        static_assert(bytes_per_pixel == 4);
+        if constexpr (morton_to_linear) {
+            dst[0] = src[3];
+            std::memcpy(dst + 1, src, 3);
+        } else {
+            std::memcpy(dst, src + 1, 3);
+            dst[3] = src[0];
+        }
+    } else if constexpr (conversion == MortonConversion::ByteSwap) {
+        for (u32 i = 0; i < bytes_per_pixel; ++i) {
+            dst[i] = src[bytes_per_pixel - 1 - i];
+        }
+    } else {
+        std::memcpy(dst, src, bytes_per_pixel);
+    }
+}
+
+template <bool morton_to_linear, u32 bytes_per_pixel, u32 linear_bytes_per_pixel,
+          MortonConversion conversion>
+inline void CopyTileScalar(u32 stride, u8* tile, u8* linear) {
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; ++x) {
+            u8* tile_ptr = tile + MortonInterleave(x, y) * bytes_per_pixel;
+            u8* linear_ptr = linear + ((7 - y) * stride + x) * linear_bytes_per_pixel;
+            if constexpr (morton_to_linear) {
+                ConvertPixel<true, bytes_per_pixel, conversion>(linear_ptr, tile_ptr);
+            } else {
+                ConvertPixel<false, bytes_per_pixel, conversion>(tile_ptr, linear_ptr);
+            }
+        }
+    }
+}
+
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+
+// The vector kernels work on 16 bytes of consecutive morton order at once. For 4 byte pixels
+// those are a 2x2 block, for 2 byte pixels a 4x2 block, so each half of the vector maps to one
+// row in linear order once the 32-bit lanes are in the order {row 0, row 1}.
+
+#if defined(ARCHITECTURE_x86_64)
+using Vector = __m128i;
+
+inline Vector Load(const u8* src) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+}
+
+inline void Store(u8* dst, Vector v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v);
+}
+
+inline Vector LoadRows(const u8* row0, const u8* row1) {
+    return _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row0)),
+                              _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row1)));
+}
+
+inline void StoreRows(u8* row0, u8* row1, Vector v) {
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(row0), v);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(row1), _mm_unpackhi_epi64(v, v));
+}
+
+/// Swaps the two middle 32-bit lanes, which is its own inverse
+inline Vector SwapMiddleLanes(Vector v) {
+    return _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+inline Vector RotateLeft8(Vector v) {
+    return _mm_or_si128(_mm_slli_epi32(v, 8), _mm_srli_epi32(v, 24));
+}
+
+inline Vector RotateRight8(Vector v) {
+    return _mm_or_si128(_mm_srli_epi32(v, 8), _mm_slli_epi32(v, 24));
+}
+
+inline Vector ByteSwap32(Vector v) {
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+#else
+using Vector = uint32x4_t;
+
+inline Vector Load(const u8* src) {
+    return vreinterpretq_u32_u8(vld1q_u8(src));
+}
+
+inline void Store(u8* dst, Vector v) {
+    vst1q_u8(dst, vreinterpretq_u8_u32(v));
+}
+
+inline Vector LoadRows(const u8* row0, const u8* row1) {
+    return vreinterpretq_u32_u8(vcombine_u8(vld1_u8(row0), vld1_u8(row1)));
+}
+
+inline void StoreRows(u8* row0, u8* row1, Vector v) {
+    vst1_u8(row0, vget_low_u8(vreinterpretq_u8_u32(v)));
+    vst1_u8(row1, vget_high_u8(vreinterpretq_u8_u32(v)));
+}
+
+inline Vector SwapMiddleLanes(Vector v) {
+    return vcombine_u32(vget_low_u32(vuzp1q_u32(v, v)), vget_low_u32(vuzp2q_u32(v, v)));
+}
+
+inline Vector RotateLeft8(Vector v) {
+    return vorrq_u32(vshlq_n_u32(v, 8), vshrq_n_u32(v, 24));
+}
+
+inline Vector RotateRight8(Vector v) {
+    return vorrq_u32(vshrq_n_u32(v, 8), vshlq_n_u32(v, 24));
+}
+
+inline Vector ByteSwap32(Vector v) {
+    return vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(v)));
+}
+#endif
+
+template <bool morton_to_linear, MortonConversion conversion>
+inline Vector ConvertPixels(Vector v) {
+    if constexpr (conversion == MortonConversion::RotateD24S8) {
+        return morton_to_linear ? RotateLeft8(v) : RotateRight8(v);
+    } else if constexpr (conversion == MortonConversion::ByteSwap) {
+        return ByteSwap32(v);
+    } else {
+        return v;
+    }
+}
+
+template <bool morton_to_linear, u32 bytes_per_pixel, MortonConversion conversion>
+inline void CopyTileVector(u32 stride, u8* tile, u8* linear) {
+    static_assert(bytes_per_pixel == 2 || bytes_per_pixel == 4);
+    static_assert(bytes_per_pixel == 4 || conversion == MortonConversion::None);
+    constexpr u32 block_width = 16 / bytes_per_pixel / 2;
+
+    for (u32 y = 0; y < 8; y += 2) {
+        u8* row0 = linear + (7 - y) * stride * bytes_per_pixel;
+        u8* row1 = row0 - stride * bytes_per_pixel;
+        for (u32 x = 0; x < 8; x += block_width) {
+            u8* tile_ptr = tile + MortonInterleave(x, y) * bytes_per_pixel;
+            const u32 linear_offset = x * bytes_per_pixel;
+            if constexpr (morton_to_linear) {
+                Vector v = ConvertPixels<true, conversion>(Load(tile_ptr));
+                if constexpr (bytes_per_pixel == 2) {
+                    v = SwapMiddleLanes(v);
+                }
+                StoreRows(row0 + linear_offset, row1 + linear_offset, v);
+            } else {
+                Vector v = LoadRows(row0 + linear_offset, row1 + linear_offset);
+                if constexpr (bytes_per_pixel == 2) {
+                    v = SwapMiddleLanes(v);
+                }
+                Store(tile_ptr, ConvertPixels<false, conversion>(v));
+            }
+        }
+    }
+}
+
+#endif
+
+} // namespace MortonDetail
+
+/**
+ * Converts an 8x8 tile between morton order and linear order. Linear rows are stored bottom to
+ * top, so the first row of the tile ends up last, matching the origin of OpenGL textures.
+ * @param stride Distance between two rows of the linear buffer, in pixels
+ * @param tile Pointer to the tile in morton order
+ * @param linear Pointer to the bottom left pixel of the tile in the linear buffer
+ */
+template <bool morton_to_linear, u32 bytes_per_pixel, u32 linear_bytes_per_pixel,
+          MortonConversion conversion>
+inline void MortonCopyTile(u32 stride, u8* tile, u8* linear) {
+#if defined(ARCHITECTURE_x86_64) || defined(ARCHITECTURE_ARM64)
+    if constexpr (bytes_per_pixel == linear_bytes_per_pixel &&
+                  (bytes_per_pixel == 4 ||
+                   (bytes_per_pixel == 2 && conversion == MortonConversion::None))) {
+        MortonDetail::CopyTileVector<morton_to_linear, bytes_per_pixel, conversion>(stride, tile,
+                                                                                    linear);
+        return;
+    }
+#endif
+    MortonDetail::CopyTileScalar<morton_to_linear, bytes_per_pixel, linear_bytes_per_pixel,
+                                 conversion>(stride, tile, linear);
+}
+
+} // namespace VideoCore
@@ -37,10 +37,24 @@ State::State() : geometry_pipeline(*this) {
             Shader::OutputVertex::FromAttributeBuffer(regs.rasterizer, vertex), AddTriangle);
     };
 
+    // Batches hand all of their triangles to the rasterizer at once
+    auto SubmitVertices = [this](const Shader::AttributeBuffer* vertices, std::size_t count) {
+        assembled_triangles.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            primitive_assembler.SubmitVertex(
+                Shader::OutputVertex::FromAttributeBuffer(regs.rasterizer, vertices[i]),
+                assembled_triangles);
+        }
+        if (!assembled_triangles.empty()) {
+            VideoCore::g_renderer->Rasterizer()->AddTriangles(assembled_triangles.data(),
+                                                              assembled_triangles.size() / 3);
+        }
+    };
+
     auto SetWinding = [this]() { primitive_assembler.SetWinding(); };
 
     g_state.gs_unit.SetVertexHandler(SubmitVertex, SetWinding);
-    g_state.geometry_pipeline.SetVertexHandler(SubmitVertex);
+    g_state.geometry_pipeline.SetVertexHandler(SubmitVertex, SubmitVertices);
 }
 
 void State::Reset() {
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <array>
+#include <vector>
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "common/vector_math.h"
@@ -20,14 +21,56 @@ struct State {
     State();
     void Reset();
 
+    // Every register write and draw reads the registers and the small state after them, so they
+    // come first and start on a cache line. The shader setups, the pipeline and the lookup tables
+    // after them are much larger and only partly touched per draw.
+
     /// Pica registers
-    Regs regs;
+    alignas(64) Regs regs;
+
+    /// Current Pica command list
+    struct {
+        const u32* head_ptr;
+        const u32* current_ptr;
+        u32 length;
+    } cmd_list;
+
+    int vs_float_regs_counter = 0;
+    u32 vs_uniform_write_buffer[4]{};
+
+    int gs_float_regs_counter = 0;
+    u32 gs_uniform_write_buffer[4]{};
+
+    int default_attr_counter = 0;
+    u32 default_attr_write_buffer[3]{};
+
+    /// Struct used to describe immediate mode rendering state
+    struct ImmediateModeState {
+        // Used to buffer partial vertices for immediate-mode rendering.
+        Shader::AttributeBuffer input_vertex;
+        // Index of the next attribute to be loaded into `input_vertex`.
+        u32 current_attribute = 0;
+        // Indicates the immediate mode just started and the geometry pipeline needs to reconfigure
+        bool reset_geometry_pipeline = true;
+    } immediate;
 
     Shader::ShaderSetup vs;
     Shader::ShaderSetup gs;
 
     Shader::AttributeBuffer input_default_attributes;
 
+    // the geometry shader needs to be kept in the global state because some shaders relie on
+    // preserved register value across shader invocation.
+    // TODO: also bring the three vertex shader units here and implement the shader scheduler.
+    Shader::GSUnitState gs_unit;
+
+    GeometryPipeline geometry_pipeline;
+
+    // This is constructed with a dummy triangle topology
+    PrimitiveAssembler<Shader::OutputVertex> primitive_assembler;
+    // Vertices of the triangles assembled from a batch of vertices, reused between batches
+    std::vector<Shader::OutputVertex> assembled_triangles;
+
     struct ProcTex {
         union ValueEntry {
             u32 raw;
@@ -125,42 +168,6 @@ struct State {
 
         std::array<LutEntry, 128> lut;
     } fog;
-
-    /// Current Pica command list
-    struct {
-        const u32* head_ptr;
-        const u32* current_ptr;
-        u32 length;
-    } cmd_list;
-
-    /// Struct used to describe immediate mode rendering state
-    struct ImmediateModeState {
-        // Used to buffer partial vertices for immediate-mode rendering.
-        Shader::AttributeBuffer input_vertex;
-        // Index of the next attribute to be loaded into `input_vertex`.
-        u32 current_attribute = 0;
-        // Indicates the immediate mode just started and the geometry pipeline needs to reconfigure
-        bool reset_geometry_pipeline = true;
-    } immediate;
-
-    // the geometry shader needs to be kept in the global state because some shaders relie on
-    // preserved register value across shader invocation.
-    // TODO: also bring the three vertex shader units here and implement the shader scheduler.
-    Shader::GSUnitState gs_unit;
-
-    GeometryPipeline geometry_pipeline;
-
-    // This is constructed with a dummy triangle topology
-    PrimitiveAssembler<Shader::OutputVertex> primitive_assembler;
-
-    int vs_float_regs_counter = 0;
-    u32 vs_uniform_write_buffer[4]{};
-
-    int gs_float_regs_counter = 0;
-    u32 gs_uniform_write_buffer[4]{};
-
-    int default_attr_counter = 0;
-    u32 default_attr_write_buffer[3]{};
 };
 
 extern State g_state; ///< Current Pica state
@@ -16,6 +16,32 @@ PrimitiveAssembler<VertexType>::PrimitiveAssembler(PipelineRegs::TriangleTopolog
 template <typename VertexType>
 void PrimitiveAssembler<VertexType>::SubmitVertex(const VertexType& vtx,
                                                   TriangleHandler triangle_handler) {
+    AssembleVertex(vtx, triangle_handler);
+}
+
+template <typename VertexType>
+void PrimitiveAssembler<VertexType>::SubmitVertex(const VertexType& vtx,
+                                                  std::vector<VertexType>& triangles) {
+    AssembleVertex(vtx, [&triangles](const VertexType& v0, const VertexType& v1,
+                                     const VertexType& v2) {
+        triangles.push_back(v0);
+        triangles.push_back(v1);
+        triangles.push_back(v2);
+    });
+}
+
+template <typename VertexType>
+void PrimitiveAssembler<VertexType>::SubmitVertices(const VertexType* vertices, std::size_t count,
+                                                    std::vector<VertexType>& triangles) {
+    for (std::size_t i = 0; i < count; ++i) {
+        SubmitVertex(vertices[i], triangles);
+    }
+}
+
+template <typename VertexType>
+template <typename Handler>
+void PrimitiveAssembler<VertexType>::AssembleVertex(const VertexType& vtx,
+                                                    Handler&& triangle_handler) {
     switch (topology) {
     case PipelineRegs::TriangleTopology::List:
     case PipelineRegs::TriangleTopology::Shader:
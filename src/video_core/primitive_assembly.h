@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <functional>
+#include <vector>
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -29,6 +31,16 @@ struct PrimitiveAssembler {
      */
     void SubmitVertex(const VertexType& vtx, TriangleHandler triangle_handler);
 
+    /**
+     * Queues a vertex like the other overload, but appends the vertices of each generated
+     * primitive to the given buffer instead of calling a handler.
+     */
+    void SubmitVertex(const VertexType& vtx, std::vector<VertexType>& triangles);
+
+    /// Queues a span of vertices, appending the vertices of the generated primitives to the buffer
+    void SubmitVertices(const VertexType* vertices, std::size_t count,
+                        std::vector<VertexType>& triangles);
+
     /**
      * Invert the vertex order of the next triangle. Called by geometry shader emitter.
      * This only takes effect for TriangleTopology::Shader.
@@ -56,6 +68,9 @@ struct PrimitiveAssembler {
     PipelineRegs::TriangleTopology GetTopology() const;
 
 private:
+    template <typename Handler>
+    void AssembleVertex(const VertexType& vtx, Handler&& triangle_handler);
+
     PipelineRegs::TriangleTopology topology;
 
     int buffer_index;
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 #include <functional>
 #include "common/common_types.h"
 #include "core/hw/gpu.h"
@@ -36,6 +37,10 @@ public:
                              const Pica::Shader::OutputVertex& v1,
                              const Pica::Shader::OutputVertex& v2) = 0;
 
+    /// Queues the primitives formed by each three consecutive vertices for rendering
+    virtual void AddTriangles(const Pica::Shader::OutputVertex* vertices,
+                              std::size_t num_triangles) = 0;
+
     /// Draw the current batch of triangles
     virtual void DrawTriangles() = 0;
 
@@ -82,6 +87,10 @@ public:
         return false;
     }
 
+    /// Sets whether the current frame won't be shown, so that draws only the screen sees can be
+    /// dropped
+    virtual void SetSkipFrame(bool skip) {}
+
     virtual void LoadDiskResources(const std::atomic_bool& stop_loading,
                                    const DiskResourceLoadCallback& callback) {}
 };
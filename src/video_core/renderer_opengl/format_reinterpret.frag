@@ -0,0 +1,65 @@
+//? #version 330
+// Rebuilds the bits each texel of the source surface has in emulated memory and decodes them in the
+// format of the destination surface, for surfaces of different formats aliasing the same memory
+out vec4 color;
+
+uniform sampler2D source;
+uniform usampler2D source_stencil;
+
+uniform int conversion;
+// Maps the fragments of the destination rectangle to the texels of the source rectangle
+uniform vec2 dst_origin;
+uniform ivec2 src_origin;
+uniform vec2 src_scale;
+
+// Values of FormatReinterpreter::Conversion
+const int D24S8_DEPTH_TO_RGBA8 = 0;
+const int D24S8_STENCIL_TO_RGBA8 = 1;
+const int D16_TO_RG8 = 2;
+const int RG8_TO_D16 = 3;
+const int RGBA4_TO_RGB5A1 = 4;
+const int RGB5A1_TO_RGBA4 = 5;
+
+void main() {
+    ivec2 coord = src_origin + ivec2((gl_FragCoord.xy - dst_origin) * src_scale);
+    color = vec4(0.0);
+
+    // The stencil is only written to the red channel, the other channels are masked
+    if (conversion == D24S8_STENCIL_TO_RGBA8) {
+        color.r = float(texelFetch(source_stencil, coord, 0).r) / 255.0;
+        return;
+    }
+
+    vec4 texel = texelFetch(source, coord, 0);
+    switch (conversion) {
+    case D24S8_DEPTH_TO_RGBA8: {
+        // The depth is in the lower 24 bits, which hold blue, green and alpha
+        uint depth = uint(round(texel.r * 16777215.0));
+        color.gba = vec3(uvec3(depth >> 16, depth >> 8, depth) & 0xFFu) / 255.0;
+        break;
+    }
+    case D16_TO_RG8: {
+        uint depth = uint(round(texel.r * 65535.0));
+        color = vec4(float(depth >> 8), float(depth & 0xFFu), 0.0, 255.0) / 255.0;
+        break;
+    }
+    case RG8_TO_D16: {
+        uvec2 rg = uvec2(round(texel.rg * 255.0));
+        gl_FragDepth = float((rg.r << 8) | rg.g) / 65535.0;
+        break;
+    }
+    case RGBA4_TO_RGB5A1: {
+        uvec4 c = uvec4(round(texel * 15.0));
+        uint bits = (c.r << 12) | (c.g << 8) | (c.b << 4) | c.a;
+        color = vec4(vec3(uvec3(bits >> 11, bits >> 6, bits >> 1) & 0x1Fu) / 31.0,
+                     float(bits & 1u));
+        break;
+    }
+    case RGB5A1_TO_RGBA4: {
+        uvec4 c = uvec4(round(texel * vec4(31.0, 31.0, 31.0, 1.0)));
+        uint bits = (c.r << 11) | (c.g << 6) | (c.b << 1) | c.a;
+        color = vec4(uvec4(bits >> 12, bits >> 8, bits >> 4, bits) & 0xFu) / 15.0;
+        break;
+    }
+    }
+}
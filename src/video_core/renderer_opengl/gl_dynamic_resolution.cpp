@@ -0,0 +1,106 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/logging/log.h"
+#include "core/hw/gpu.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_dynamic_resolution.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+#include "video_core/video_core.h"
+
+namespace OpenGL {
+
+// Fractions of the frame budget the GPU time is kept between
+constexpr double LOWER_THRESHOLD = 0.9;
+constexpr double RAISE_THRESHOLD = 0.75;
+
+void DynamicResolution::BeginFrame() {
+    // Timer queries are an extension on GLES
+    if (!Settings::values.dynamic_resolution || GLES) {
+        if (scale_factor != 0) {
+            scale_factor = 0;
+            VideoCore::SetRenderTargetScaleFactor(0);
+        }
+        return;
+    }
+
+    Query& query = queries[next_query];
+    if (query.pending)
+        return;
+    query.query.Create();
+    glBeginQuery(GL_TIME_ELAPSED, query.query.handle);
+    measuring = true;
+}
+
+void DynamicResolution::EndFrame() {
+    if (measuring) {
+        glEndQuery(GL_TIME_ELAPSED);
+        queries[next_query].pending = true;
+        next_query = (next_query + 1) % NUM_QUERIES;
+        measuring = false;
+    }
+
+    // Read the finished queries from oldest to newest
+    for (std::size_t i = 0; i < NUM_QUERIES; ++i) {
+        Query& query = queries[(next_query + i) % NUM_QUERIES];
+        if (!query.pending)
+            continue;
+
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(query.query.handle, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        GLuint64 time = 0;
+        glGetQueryObjectui64v(query.query.handle, GL_QUERY_RESULT, &time);
+        query.pending = false;
+        AddSample(time);
+    }
+}
+
+void DynamicResolution::AddSample(GLuint64 time) {
+    if (!Settings::values.dynamic_resolution)
+        return;
+
+    window_time += time;
+    if (++window_samples < WINDOW_SIZE)
+        return;
+
+    const double average = static_cast<double>(window_time) / window_samples;
+    window_time = 0;
+    window_samples = 0;
+    if (skip_windows > 0) {
+        --skip_windows;
+        return;
+    }
+
+    const u16 max_scale = VideoCore::GetResolutionScaleFactor();
+    const u16 min_scale = std::clamp<u16>(Settings::values.dynamic_resolution_min, 1, max_scale);
+    const u16 old_scale = scale_factor == 0 ? max_scale : scale_factor;
+    scale_factor = std::clamp(old_scale, min_scale, max_scale);
+
+    const double speed = Settings::values.use_frame_limit && Settings::values.frame_limit != 0
+                             ? Settings::values.frame_limit / 100.0
+                             : 1.0;
+    const double budget = 1e9 / (GPU::SCREEN_REFRESH_RATE * speed);
+    if (average > budget * LOWER_THRESHOLD && scale_factor > min_scale) {
+        --scale_factor;
+    } else if (scale_factor < max_scale) {
+        // The GPU time grows about with the number of pixels rendered
+        const double ratio = static_cast<double>(scale_factor + 1) / scale_factor;
+        if (average * ratio * ratio < budget * RAISE_THRESHOLD) {
+            ++scale_factor;
+        }
+    }
+
+    if (scale_factor != old_scale) {
+        LOG_DEBUG(Render_OpenGL, "Dynamic resolution scale {} at {:.2f} ms per frame",
+                  scale_factor, average / 1e6);
+        skip_windows = 1;
+    }
+    VideoCore::SetRenderTargetScaleFactor(scale_factor);
+}
+
+} // namespace OpenGL
@@ -0,0 +1,54 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Measures the GPU time of each frame with timer queries and lowers the scale factor of new render
+ * targets while the frames don't fit in the frame budget, raising it again once the GPU has time
+ * to spare. The rasterizer cache creates framebuffers at the new scale the next time they are
+ * drawn to and copies the contents of the old surfaces over, so nothing is reloaded at once.
+ */
+class DynamicResolution {
+public:
+    /// Starts measuring the GPU time of the next frame
+    void BeginFrame();
+
+    /// Stops measuring the current frame and adjusts the scale to the measurements that finished
+    void EndFrame();
+
+private:
+    /// Frames averaged before the scale is adjusted
+    static constexpr u32 WINDOW_SIZE = 30;
+    /// Results are read a few frames late so that waiting for them never stalls
+    static constexpr std::size_t NUM_QUERIES = 4;
+
+    struct Query {
+        OGLQuery query;
+        bool pending = false;
+    };
+
+    void AddSample(GLuint64 time);
+
+    std::array<Query, NUM_QUERIES> queries;
+    std::size_t next_query = 0;
+    bool measuring = false;
+
+    /// Scale factor of new render targets, 0 until the first frame
+    u16 scale_factor = 0;
+    GLuint64 window_time = 0;
+    u32 window_samples = 0;
+    /// Windows to ignore after a change, which measure the old scale and the copies to the new
+    u32 skip_windows = 0;
+};
+
+} // namespace OpenGL
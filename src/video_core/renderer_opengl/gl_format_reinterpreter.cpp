@@ -0,0 +1,163 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/scope_exit.h"
+#include "video_core/renderer_opengl/gl_format_reinterpreter.h"
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+
+#include "shaders/format_reinterpret.frag"
+#include "shaders/tex_coord.vert"
+
+namespace OpenGL {
+
+using PixelFormat = SurfaceParams::PixelFormat;
+
+FormatReinterpreter::FormatReinterpreter() {
+    program.Create(tex_coord_vert.data(), format_reinterpret_frag.data());
+    vao.Create();
+
+    OpenGLState state = OpenGLState::GetCurState();
+    GLuint old_program = state.draw.shader_program;
+    state.draw.shader_program = program.handle;
+    state.Apply();
+
+    // The two samplers have different types, so they can't share a texture unit
+    GLint source_u_id = glGetUniformLocation(program.handle, "source");
+    ASSERT(source_u_id != -1);
+    glUniform1i(source_u_id, 0);
+    GLint source_stencil_u_id = glGetUniformLocation(program.handle, "source_stencil");
+    ASSERT(source_stencil_u_id != -1);
+    glUniform1i(source_stencil_u_id, 1);
+
+    state.draw.shader_program = old_program;
+    state.Apply();
+
+    conversion_u_id = glGetUniformLocation(program.handle, "conversion");
+    dst_origin_u_id = glGetUniformLocation(program.handle, "dst_origin");
+    src_origin_u_id = glGetUniformLocation(program.handle, "src_origin");
+    src_scale_u_id = glGetUniformLocation(program.handle, "src_scale");
+
+    supported = true;
+    stencil_supported = GLES ? GLAD_GL_ES_VERSION_3_1 : GLAD_GL_ARB_stencil_texturing;
+}
+
+MICROPROFILE_DEFINE(OpenGL_Reinterpret, "OpenGL", "Format Reinterpret", MP_RGB(128, 192, 64));
+bool FormatReinterpreter::Reinterpret(const CachedSurface& src_surface,
+                                      const Common::Rectangle<u32>& src_rect,
+                                      const CachedSurface& dst_surface,
+                                      const Common::Rectangle<u32>& dst_rect,
+                                      GLuint draw_fb_handle) {
+    if (!supported || src_surface.is_custom || dst_surface.is_custom ||
+        src_surface.is_compressed || dst_surface.is_compressed)
+        return false;
+
+    Conversion conversion;
+    switch (src_surface.pixel_format) {
+    case PixelFormat::D24S8:
+        if (dst_surface.pixel_format != PixelFormat::RGBA8 || !stencil_supported)
+            return false;
+        conversion = Conversion::D24S8DepthToRGBA8;
+        break;
+    case PixelFormat::D16:
+        if (dst_surface.pixel_format != PixelFormat::RG8)
+            return false;
+        conversion = Conversion::D16ToRG8;
+        break;
+    case PixelFormat::RG8:
+        if (dst_surface.pixel_format != PixelFormat::D16)
+            return false;
+        conversion = Conversion::RG8ToD16;
+        break;
+    case PixelFormat::RGBA4:
+        if (dst_surface.pixel_format != PixelFormat::RGB5A1)
+            return false;
+        conversion = Conversion::RGBA4ToRGB5A1;
+        break;
+    case PixelFormat::RGB5A1:
+        if (dst_surface.pixel_format != PixelFormat::RGBA4)
+            return false;
+        conversion = Conversion::RGB5A1ToRGBA4;
+        break;
+    default:
+        return false;
+    }
+
+    MICROPROFILE_SCOPE(OpenGL_Reinterpret);
+
+    OpenGLState prev_state = OpenGLState::GetCurState();
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    OpenGLState state;
+    state.blend.enabled = false;
+    state.draw.draw_framebuffer = draw_fb_handle;
+    state.draw.shader_program = program.handle;
+    state.draw.vertex_array = vao.handle;
+    state.texture_units[0].texture_2d = src_surface.texture.handle;
+    state.viewport.x = static_cast<GLint>(dst_rect.left);
+    state.viewport.y = static_cast<GLint>(dst_rect.bottom);
+    state.viewport.width = static_cast<GLsizei>(dst_rect.GetWidth());
+    state.viewport.height = static_cast<GLsizei>(dst_rect.GetHeight());
+
+    if (conversion == Conversion::RG8ToD16) {
+        // Depth writes only happen with the depth test enabled
+        state.depth.test_enabled = true;
+        state.depth.test_func = GL_ALWAYS;
+        state.depth.write_mask = GL_TRUE;
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+                               dst_surface.texture.handle, 0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    } else {
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               dst_surface.texture.handle, 0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0,
+                               0);
+    }
+    if (conversion == Conversion::D24S8DepthToRGBA8) {
+        state.color_mask.red_enabled = GL_FALSE;
+    }
+    state.Apply();
+
+    glUniform1i(conversion_u_id, static_cast<GLint>(conversion));
+    glUniform2f(dst_origin_u_id, static_cast<GLfloat>(dst_rect.left),
+                static_cast<GLfloat>(dst_rect.bottom));
+    glUniform2i(src_origin_u_id, static_cast<GLint>(src_rect.left),
+                static_cast<GLint>(src_rect.bottom));
+    glUniform2f(src_scale_u_id,
+                static_cast<GLfloat>(src_rect.GetWidth()) /
+                    static_cast<GLfloat>(dst_rect.GetWidth()),
+                static_cast<GLfloat>(src_rect.GetHeight()) /
+                    static_cast<GLfloat>(dst_rect.GetHeight()));
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    if (conversion == Conversion::D24S8DepthToRGBA8) {
+        // Second pass for the stencil, read through the other sampler in stencil mode
+        state.color_mask.red_enabled = GL_TRUE;
+        state.color_mask.green_enabled = GL_FALSE;
+        state.color_mask.blue_enabled = GL_FALSE;
+        state.color_mask.alpha_enabled = GL_FALSE;
+        state.texture_units[0].texture_2d = 0;
+        state.texture_units[1].texture_2d = src_surface.texture.handle;
+        state.Apply();
+
+        glActiveTexture(TextureUnits::PicaTexture(1).Enum());
+        glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_STENCIL_TEXTURE_MODE, GL_STENCIL_INDEX);
+        glUniform1i(conversion_u_id, static_cast<GLint>(Conversion::D24S8StencilToRGBA8));
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_STENCIL_TEXTURE_MODE, GL_DEPTH_COMPONENT);
+    }
+
+    if (conversion == Conversion::RG8ToD16) {
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    } else {
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    }
+    return true;
+}
+
+} // namespace OpenGL
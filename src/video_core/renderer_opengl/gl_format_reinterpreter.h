@@ -0,0 +1,60 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <glad/glad.h>
+#include "common/math_util.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+struct CachedSurface;
+
+/**
+ * Converts between the pixel formats that have the same size on the PICA, for games that use the
+ * memory of a surface as another format, like a depth buffer sampled as a color texture. A
+ * fragment shader rebuilds the bits of each source texel as they are in emulated memory and
+ * decodes them in the destination format, so the data never leaves the GPU.
+ *
+ * Supported are D24S8 to RGBA8, D16 to RG8 and back, and RGBA4 to RGB5A1 and back.
+ */
+class FormatReinterpreter {
+public:
+    FormatReinterpreter();
+
+    /**
+     * Draws the rectangle of the source surface into the rectangle of the destination surface,
+     * reinterpreted as the format of the destination.
+     * @returns false if the formats or the driver aren't supported, nothing was drawn then
+     */
+    bool Reinterpret(const CachedSurface& src_surface, const Common::Rectangle<u32>& src_rect,
+                     const CachedSurface& dst_surface, const Common::Rectangle<u32>& dst_rect,
+                     GLuint draw_fb_handle);
+
+private:
+    /// Values of the conversion uniform of the shader
+    enum class Conversion : GLint {
+        D24S8DepthToRGBA8 = 0,
+        D24S8StencilToRGBA8 = 1,
+        D16ToRG8 = 2,
+        RG8ToD16 = 3,
+        RGBA4ToRGB5A1 = 4,
+        RGB5A1ToRGBA4 = 5,
+    };
+
+    bool supported = false;
+    /// D24S8 needs GL_ARB_stencil_texturing to read the stencil in the shader
+    bool stencil_supported = false;
+
+    OGLProgram program;
+    OGLVertexArray vao;
+
+    GLint conversion_u_id = -1;
+    GLint dst_origin_u_id = -1;
+    GLint src_origin_u_id = -1;
+    GLint src_scale_u_id = -1;
+};
+
+} // namespace OpenGL
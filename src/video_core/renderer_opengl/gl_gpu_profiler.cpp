@@ -0,0 +1,166 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <iterator>
+#include "common/assert.h"
+#include "video_core/renderer_opengl/gl_gpu_profiler.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+
+namespace OpenGL {
+
+GPUProfiler::Scope::Scope(Pass pass, u64 shader_hash, PAddr framebuffer)
+    : pass(pass), shader_hash(shader_hash), framebuffer(framebuffer),
+      active(GetInstance().active) {
+    if (!active)
+        return;
+
+    GPUProfiler& profiler = GetInstance();
+    start = profiler.Timestamp();
+    parent = profiler.current_scope;
+    profiler.current_scope = this;
+    // The time until now belongs to the parent, it continues when this scope ends
+    if (parent != nullptr && parent->active) {
+        profiler.AddSegment(*parent, start, false);
+    }
+}
+
+GPUProfiler::Scope::~Scope() {
+    if (!active)
+        return;
+
+    GPUProfiler& profiler = GetInstance();
+    const std::size_t end = profiler.Timestamp();
+    profiler.AddSegment(*this, end, true);
+    profiler.current_scope = parent;
+    if (parent != nullptr)
+        parent->start = end;
+}
+
+void GPUProfiler::Destroy() {
+    current_frame = {};
+    pending_frames.clear();
+    free_queries.clear();
+}
+
+void GPUProfiler::SetEnabled(bool enabled_) {
+    enabled = enabled_;
+}
+
+bool GPUProfiler::IsEnabled() const {
+    return enabled;
+}
+
+bool GPUProfiler::ShouldProfile() const {
+    return !GLES && (enabled || Core::Metrics::IsEnabled());
+}
+
+GPUProfiler::Report GPUProfiler::GetReport() const {
+    Report report;
+    {
+        std::lock_guard lock{report_mutex};
+        report.frames = frames;
+        report.passes = passes;
+        report.shaders.assign(shaders.begin(), shaders.end());
+        report.framebuffers.assign(framebuffers.begin(), framebuffers.end());
+    }
+
+    const auto by_time = [](const auto& a, const auto& b) { return a.second.time > b.second.time; };
+    std::sort(report.shaders.begin(), report.shaders.end(), by_time);
+    std::sort(report.framebuffers.begin(), report.framebuffers.end(), by_time);
+    return report;
+}
+
+void GPUProfiler::ResetReport() {
+    std::lock_guard lock{report_mutex};
+    frames = 0;
+    passes = {};
+    shaders.clear();
+    framebuffers.clear();
+}
+
+std::size_t GPUProfiler::Timestamp() {
+    OGLQuery query;
+    if (free_queries.empty()) {
+        query.Create();
+    } else {
+        query = std::move(free_queries.back());
+        free_queries.pop_back();
+    }
+    glQueryCounter(query.handle, GL_TIMESTAMP);
+    current_frame.queries.push_back(std::move(query));
+    return current_frame.queries.size() - 1;
+}
+
+void GPUProfiler::AddSegment(const Scope& scope, std::size_t end, bool last) {
+    current_frame.segments.push_back(
+        {scope.start, end, scope.pass, scope.shader_hash, scope.framebuffer, last});
+}
+
+void GPUProfiler::EndFrame() {
+    // A frame always ends outside of the scopes
+    ASSERT(current_scope == nullptr);
+
+    if (!current_frame.queries.empty()) {
+        pending_frames.push_back(std::move(current_frame));
+        current_frame = {};
+    }
+
+    while (!pending_frames.empty()) {
+        Frame& frame = pending_frames.front();
+        if (pending_frames.size() <= MAX_PENDING_FRAMES) {
+            // The queries of a frame finish in order, so the last one finishes after all others
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(frame.queries.back().handle, GL_QUERY_RESULT_AVAILABLE,
+                                &available);
+            if (!available)
+                break;
+        }
+        ReadFrame(frame);
+        pending_frames.pop_front();
+    }
+
+    if (active) {
+        std::lock_guard lock{report_mutex};
+        ++frames;
+    }
+    active = ShouldProfile();
+}
+
+void GPUProfiler::ReadFrame(Frame& frame) {
+    std::vector<GLuint64> timestamps(frame.queries.size());
+    for (std::size_t i = 0; i < frame.queries.size(); ++i) {
+        glGetQueryObjectui64v(frame.queries[i].handle, GL_QUERY_RESULT, &timestamps[i]);
+    }
+
+    std::array<u64, NUM_PASSES> pass_times{};
+    {
+        std::lock_guard lock{report_mutex};
+        for (const Segment& segment : frame.segments) {
+            const u64 time = timestamps[segment.end] - timestamps[segment.start];
+            const auto pass_index = static_cast<std::size_t>(segment.pass);
+            pass_times[pass_index] += time;
+            const u64 count = segment.last ? 1 : 0;
+            passes[pass_index].time += time;
+            passes[pass_index].count += count;
+            if (segment.pass == Pass::Draw) {
+                Entry& shader = shaders[segment.shader_hash];
+                shader.time += time;
+                shader.count += count;
+                Entry& framebuffer = framebuffers[segment.framebuffer];
+                framebuffer.time += time;
+                framebuffer.count += count;
+            }
+        }
+    }
+    for (std::size_t i = 0; i < NUM_PASSES; ++i) {
+        if (pass_times[i] != 0) {
+            Core::Metrics::AddGPUTime(static_cast<Pass>(i), pass_times[i]);
+        }
+    }
+
+    std::move(frame.queries.begin(), frame.queries.end(), std::back_inserter(free_queries));
+}
+
+} // namespace OpenGL
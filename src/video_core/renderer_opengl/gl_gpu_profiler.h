@@ -0,0 +1,148 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "core/perf_metrics.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Measures the GPU time of the renderer's passes with GL_TIMESTAMP queries. The results are read
+ * back a few frames after the work was submitted, once the queries are available, so profiling
+ * never waits for the GPU. Draws are also broken down by the fragment shader config and the color
+ * buffer they render to.
+ *
+ * The profiler runs while it is enabled from the debugger or a metrics exporter is running. It
+ * needs timestamp queries, which aren't available on GLES.
+ */
+class GPUProfiler {
+public:
+    using Pass = Core::Metrics::GPUTime;
+    static constexpr std::size_t NUM_PASSES = static_cast<std::size_t>(Pass::Count);
+
+    struct Entry {
+        u64 time = 0; ///< In nanoseconds
+        u64 count = 0;
+    };
+
+    /// Times collected since the last reset
+    struct Report {
+        u64 frames = 0;
+        std::array<Entry, NUM_PASSES> passes{};
+        /// Draws by the hash of their fragment shader config, the most expensive first
+        std::vector<std::pair<u64, Entry>> shaders;
+        /// Draws by the address of their color buffer, the most expensive first
+        std::vector<std::pair<PAddr, Entry>> framebuffers;
+    };
+
+    /**
+     * Measures the GPU time of the commands submitted until it is destroyed. The time of a scope
+     * nested in another one is only counted to the nested scope. Scopes must be created on the
+     * thread owning the GL context.
+     */
+    class Scope {
+    public:
+        explicit Scope(Pass pass, u64 shader_hash = 0, PAddr framebuffer = 0);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        friend class GPUProfiler;
+
+        Scope* parent = nullptr;
+        Pass pass;
+        u64 shader_hash;
+        PAddr framebuffer;
+        /// Query of the timestamp the current segment of the scope started at
+        std::size_t start = 0;
+        bool active;
+    };
+
+    static GPUProfiler& GetInstance() {
+        static GPUProfiler singleton;
+        return singleton;
+    }
+
+    /// Deletes the queries, called before the GL context is destroyed
+    void Destroy();
+
+    /// Enables profiling independently of the metrics exporter, thread-safe
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const;
+
+    /// Returns whether the current frame is profiled
+    bool IsActive() const {
+        return active;
+    }
+
+    /// Returns the times collected so far, thread-safe
+    Report GetReport() const;
+
+    /// Clears the collected times, thread-safe
+    void ResetReport();
+
+    /// Ends the current frame and reads back the finished frames, called after presenting it
+    void EndFrame();
+
+private:
+    /// A span of GPU time between two timestamps of the same frame
+    struct Segment {
+        std::size_t start;
+        std::size_t end;
+        Pass pass;
+        u64 shader_hash;
+        PAddr framebuffer;
+        /// Whether the scope ended with this segment, scopes are counted once
+        bool last;
+    };
+
+    struct Frame {
+        std::vector<OGLQuery> queries;
+        std::vector<Segment> segments;
+    };
+
+    /// Frames whose results are awaited before waiting for the oldest one
+    static constexpr std::size_t MAX_PENDING_FRAMES = 8;
+
+    /// Returns whether the next frame should be profiled
+    bool ShouldProfile() const;
+
+    /// Writes a timestamp after the commands submitted so far and returns its query
+    std::size_t Timestamp();
+
+    void AddSegment(const Scope& scope, std::size_t end, bool last);
+
+    /// Reads the results of a frame, blocking if they aren't available yet
+    void ReadFrame(Frame& frame);
+
+    std::atomic_bool enabled{false};
+    /// Whether the current frame is profiled, decided at the start of each frame
+    bool active = false;
+    Scope* current_scope = nullptr;
+
+    Frame current_frame;
+    std::deque<Frame> pending_frames;
+    std::vector<OGLQuery> free_queries;
+
+    mutable std::mutex report_mutex;
+    u64 frames = 0;
+    std::array<Entry, NUM_PASSES> passes{};
+    std::unordered_map<u64, Entry> shaders;
+    std::unordered_map<PAddr, Entry> framebuffers;
+};
+
+} // namespace OpenGL
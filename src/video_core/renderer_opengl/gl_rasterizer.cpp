@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -10,6 +11,7 @@
 #include <glad/glad.h>
 #include "common/alignment.h"
 #include "common/assert.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
@@ -20,6 +22,7 @@
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_rasterizer.h"
 #include "video_core/regs_texturing.h"
+#include "video_core/renderer_opengl/gl_gpu_profiler.h"
 #include "video_core/renderer_opengl/gl_rasterizer.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
 #include "video_core/renderer_opengl/gl_vars.h"
@@ -27,6 +30,12 @@
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
 
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
 namespace OpenGL {
 
 using PixelFormat = SurfaceParams::PixelFormat;
@@ -74,15 +83,12 @@ RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
     u8 framebuffer_data[4] = {0, 0, 0, 1};
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, framebuffer_data);
 
-    // Create sampler objects
-    for (std::size_t i = 0; i < texture_samplers.size(); ++i) {
-        texture_samplers[i].Create();
-        state.texture_units[i].sampler = texture_samplers[i].sampler.handle;
+    // Start all units with the sampler of the default texture config
+    const GLuint default_sampler = GetSampler(Pica::TexturingRegs::TextureConfig{});
+    for (auto& unit : state.texture_units) {
+        unit.sampler = default_sampler;
     }
-
-    // Create cubemap texture and sampler objects
-    texture_cube_sampler.Create();
-    state.texture_cube_unit.sampler = texture_cube_sampler.sampler.handle;
+    state.texture_cube_unit.sampler = default_sampler;
 
     // Generate VAO
     sw_vao.Create();
@@ -90,22 +96,15 @@ RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
 
     uniform_block_data.dirty = true;
 
-    uniform_block_data.lighting_lut_dirty.fill(true);
-    uniform_block_data.lighting_lut_dirty_any = true;
-
-    uniform_block_data.fog_lut_dirty = true;
-
-    uniform_block_data.proctex_noise_lut_dirty = true;
-    uniform_block_data.proctex_color_map_dirty = true;
-    uniform_block_data.proctex_alpha_map_dirty = true;
-    uniform_block_data.proctex_lut_dirty = true;
-    uniform_block_data.proctex_diff_lut_dirty = true;
-
     glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_buffer_alignment);
     uniform_size_aligned_vs =
         Common::AlignUp<std::size_t>(sizeof(VSUniformData), uniform_buffer_alignment);
+    uniform_size_aligned_gs =
+        Common::AlignUp<std::size_t>(sizeof(GSUniformData), uniform_buffer_alignment);
     uniform_size_aligned_fs =
         Common::AlignUp<std::size_t>(sizeof(UniformData), uniform_buffer_alignment);
+    uniform_size_aligned_uber =
+        Common::AlignUp<std::size_t>(sizeof(FSUberUniformData), uniform_buffer_alignment);
 
     // Set vertex attributes for software shader path
     state.draw.vertex_array = sw_vao.handle;
@@ -161,8 +160,8 @@ RasterizerOpenGL::RasterizerOpenGL(Frontend::EmuWindow& window)
     state.Apply();
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer.GetHandle());
 
-    shader_program_manager =
-        std::make_unique<ShaderProgramManager>(GLAD_GL_ARB_separate_shader_objects, is_amd);
+    shader_program_manager = std::make_unique<ShaderProgramManager>(
+        emu_window, GLAD_GL_ARB_separate_shader_objects, is_amd);
 
     glEnable(GL_BLEND);
 
@@ -210,10 +209,12 @@ void RasterizerOpenGL::SyncEntireState() {
         SyncLightDistanceAttenuationBias(light_index);
         SyncLightDistanceAttenuationScale(light_index);
     }
+    SyncLightingLUTScales();
 
     SyncFogColor();
     SyncProcTexNoise();
     SyncProcTexBias();
+    SyncProcTexLUTLayout();
     SyncShadowBias();
     SyncShadowTextureBias();
 }
@@ -251,6 +252,13 @@ void RasterizerOpenGL::AddTriangle(const Pica::Shader::OutputVertex& v0,
     vertex_batch.emplace_back(v2, AreQuaternionsOpposite(v0.quat, v2.quat));
 }
 
+void RasterizerOpenGL::AddTriangles(const Pica::Shader::OutputVertex* vertices,
+                                    std::size_t num_triangles) {
+    for (std::size_t i = 0; i < num_triangles; ++i) {
+        RasterizerOpenGL::AddTriangle(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+    }
+}
+
 static constexpr std::array<GLenum, 4> vs_attrib_types{
     GL_BYTE,          // VertexAttributeFormat::BYTE
     GL_UNSIGNED_BYTE, // VertexAttributeFormat::UBYTE
@@ -258,13 +266,102 @@ static constexpr std::array<GLenum, 4> vs_attrib_types{
     GL_FLOAT          // VertexAttributeFormat::FLOAT
 };
 
-struct VertexArrayInfo {
-    u32 vs_input_index_min;
-    u32 vs_input_index_max;
-    u32 vs_input_size;
-};
+/// Copies the indices, returning the smallest and the largest of them found along the way
+template <typename T>
+static std::pair<u32, u32> CopyIndicesGeneric(const T* src, T* dst, std::size_t count) {
+    u32 min = 0xFFFF;
+    u32 max = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        dst[i] = src[i];
+        min = std::min<u32>(min, src[i]);
+        max = std::max<u32>(max, src[i]);
+    }
+    return {min, max};
+}
+
+static std::pair<u32, u32> CopyIndices(const u8* src, u8* dst, std::size_t count) {
+    std::size_t i = 0;
+    u32 min = 0xFFFF;
+    u32 max = 0;
+#if defined(ARCHITECTURE_x86_64)
+    if (count >= 16) {
+        __m128i vec_min = _mm_set1_epi8(-1);
+        __m128i vec_max = _mm_setzero_si128();
+        for (; i + 16 <= count; i += 16) {
+            const __m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), indices);
+            vec_min = _mm_min_epu8(vec_min, indices);
+            vec_max = _mm_max_epu8(vec_max, indices);
+        }
+        alignas(16) std::array<u8, 16> lane_min;
+        alignas(16) std::array<u8, 16> lane_max;
+        _mm_store_si128(reinterpret_cast<__m128i*>(lane_min.data()), vec_min);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lane_max.data()), vec_max);
+        min = *std::min_element(lane_min.begin(), lane_min.end());
+        max = *std::max_element(lane_max.begin(), lane_max.end());
+    }
+#elif defined(ARCHITECTURE_ARM64)
+    if (count >= 16) {
+        uint8x16_t vec_min = vdupq_n_u8(0xFF);
+        uint8x16_t vec_max = vdupq_n_u8(0);
+        for (; i + 16 <= count; i += 16) {
+            const uint8x16_t indices = vld1q_u8(src + i);
+            vst1q_u8(dst + i, indices);
+            vec_min = vminq_u8(vec_min, indices);
+            vec_max = vmaxq_u8(vec_max, indices);
+        }
+        min = vminvq_u8(vec_min);
+        max = vmaxvq_u8(vec_max);
+    }
+#endif
+    const auto [tail_min, tail_max] = CopyIndicesGeneric(src + i, dst + i, count - i);
+    return {std::min(min, tail_min), std::max(max, tail_max)};
+}
+
+static std::pair<u32, u32> CopyIndices(const u16* src, u16* dst, std::size_t count) {
+    std::size_t i = 0;
+    u32 min = 0xFFFF;
+    u32 max = 0;
+#if defined(ARCHITECTURE_x86_64)
+    if (count >= 8) {
+        // SSE2 only compares signed 16-bit values, flipping the sign bit keeps the order
+        const __m128i sign = _mm_set1_epi16(-0x8000);
+        __m128i vec_min = _mm_set1_epi16(0x7FFF);
+        __m128i vec_max = sign;
+        for (; i + 8 <= count; i += 8) {
+            const __m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), indices);
+            const __m128i flipped = _mm_xor_si128(indices, sign);
+            vec_min = _mm_min_epi16(vec_min, flipped);
+            vec_max = _mm_max_epi16(vec_max, flipped);
+        }
+        alignas(16) std::array<u16, 8> lane_min;
+        alignas(16) std::array<u16, 8> lane_max;
+        _mm_store_si128(reinterpret_cast<__m128i*>(lane_min.data()), _mm_xor_si128(vec_min, sign));
+        _mm_store_si128(reinterpret_cast<__m128i*>(lane_max.data()), _mm_xor_si128(vec_max, sign));
+        min = *std::min_element(lane_min.begin(), lane_min.end());
+        max = *std::max_element(lane_max.begin(), lane_max.end());
+    }
+#elif defined(ARCHITECTURE_ARM64)
+    if (count >= 8) {
+        uint16x8_t vec_min = vdupq_n_u16(0xFFFF);
+        uint16x8_t vec_max = vdupq_n_u16(0);
+        for (; i + 8 <= count; i += 8) {
+            const uint16x8_t indices = vld1q_u16(src + i);
+            vst1q_u16(dst + i, indices);
+            vec_min = vminq_u16(vec_min, indices);
+            vec_max = vmaxq_u16(vec_max, indices);
+        }
+        min = vminvq_u16(vec_min);
+        max = vmaxvq_u16(vec_max);
+    }
+#endif
+    const auto [tail_min, tail_max] = CopyIndicesGeneric(src + i, dst + i, count - i);
+    return {std::min(min, tail_min), std::max(max, tail_max)};
+}
 
-RasterizerOpenGL::VertexArrayInfo RasterizerOpenGL::AnalyzeVertexArray(bool is_indexed) {
+RasterizerOpenGL::VertexArrayInfo RasterizerOpenGL::AnalyzeVertexArray(bool is_indexed,
+                                                                       u8* index_dst) {
     const auto& regs = Pica::g_state.regs;
     const auto& vertex_attributes = regs.pipeline.vertex_attributes;
 
@@ -273,18 +370,19 @@ RasterizerOpenGL::VertexArrayInfo RasterizerOpenGL::AnalyzeVertexArray(bool is_i
     if (is_indexed) {
         const auto& index_info = regs.pipeline.index_array;
         PAddr address = vertex_attributes.GetPhysicalBaseAddress() + index_info.offset;
-        const u8* index_address_8 = VideoCore::g_memory->GetPhysicalPointer(address);
-        const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
         bool index_u16 = index_info.format != 0;
 
-        vertex_min = 0xFFFF;
-        vertex_max = 0;
         std::size_t size = regs.pipeline.num_vertices * (index_u16 ? 2 : 1);
         res_cache.FlushRegion(address, size, nullptr);
-        for (u32 index = 0; index < regs.pipeline.num_vertices; ++index) {
-            u32 vertex = index_u16 ? index_address_16[index] : index_address_8[index];
-            vertex_min = std::min(vertex_min, vertex);
-            vertex_max = std::max(vertex_max, vertex);
+        // The indices are uploaded in the same pass that finds their range
+        const u8* index_data = VideoCore::g_memory->GetPhysicalPointer(address);
+        if (index_u16) {
+            std::tie(vertex_min, vertex_max) =
+                CopyIndices(reinterpret_cast<const u16*>(index_data),
+                            reinterpret_cast<u16*>(index_dst), regs.pipeline.num_vertices);
+        } else {
+            std::tie(vertex_min, vertex_max) =
+                CopyIndices(index_data, index_dst, regs.pipeline.num_vertices);
         }
     } else {
         vertex_min = regs.pipeline.vertex_offset;
@@ -353,10 +451,11 @@ void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
         u32 vertex_num = vs_input_index_max - vs_input_index_min + 1;
         u32 data_size = loader.byte_count * vertex_num;
 
-        res_cache.FlushRegion(data_addr, data_size, nullptr);
-        std::memcpy(array_ptr, VideoCore::g_memory->GetPhysicalPointer(data_addr), data_size);
-
-        array_ptr += data_size;
+        if (array_ptr != nullptr) {
+            res_cache.FlushRegion(data_addr, data_size, nullptr);
+            std::memcpy(array_ptr, VideoCore::g_memory->GetPhysicalPointer(data_addr), data_size);
+            array_ptr += data_size;
+        }
         buffer_offset += data_size;
     }
 
@@ -381,6 +480,27 @@ void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset,
     }
 }
 
+u64 RasterizerOpenGL::HashVertexArray(u32 vs_input_index_min, u32 vs_input_index_max) {
+    const auto& vertex_attributes = Pica::g_state.regs.pipeline.vertex_attributes;
+    const PAddr base_address = vertex_attributes.GetPhysicalBaseAddress();
+    const u32 vertex_num = vs_input_index_max - vs_input_index_min + 1;
+
+    u64 hash = 0;
+    for (const auto& loader : vertex_attributes.attribute_loaders) {
+        if (loader.component_count == 0 || loader.byte_count == 0) {
+            continue;
+        }
+        const PAddr data_addr =
+            base_address + loader.data_offset + (vs_input_index_min * loader.byte_count);
+        const u32 data_size = loader.byte_count * vertex_num;
+        res_cache.FlushRegion(data_addr, data_size, nullptr);
+        const u64 loader_hash = Common::ComputeFastHash64(
+            VideoCore::g_memory->GetPhysicalPointer(data_addr), data_size);
+        hash ^= loader_hash + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
 bool RasterizerOpenGL::SetupVertexShader() {
     MICROPROFILE_SCOPE(OpenGL_VS);
     return shader_program_manager->UseProgrammableVertexShader(Pica::g_state.regs,
@@ -393,15 +513,14 @@ bool RasterizerOpenGL::SetupGeometryShader() {
     if (regs.pipeline.use_gs == Pica::PipelineRegs::UseGS::No) {
         shader_program_manager->UseFixedGeometryShader(regs);
         return true;
-    } else {
-        LOG_ERROR(Render_OpenGL, "Accelerate draw doesn't support geometry shader");
     }
+    return shader_program_manager->UseProgrammableGeometryShader(regs, Pica::g_state.gs);
 }
 
 bool RasterizerOpenGL::AccelerateDrawBatch(bool is_indexed) {
     const auto& regs = Pica::g_state.regs;
     if (regs.pipeline.use_gs != Pica::PipelineRegs::UseGS::No) {
-        if (regs.pipeline.gs_config.mode != Pica::PipelineRegs::GSMode::Point) {
+        if (GetGSInputVertexCount(regs) == 0) {
             return false;
         }
         if (regs.pipeline.triangle_topology != Pica::PipelineRegs::TriangleTopology::Shader) {
@@ -420,6 +539,24 @@ bool RasterizerOpenGL::AccelerateDrawBatch(bool is_indexed) {
 
 static GLenum GetCurrentPrimitiveMode() {
     const auto& regs = Pica::g_state.regs;
+    if (regs.pipeline.use_gs != Pica::PipelineRegs::UseGS::No) {
+        // The vertices are grouped into the inputs of the geometry shader invocations
+        switch (GetGSInputVertexCount(regs)) {
+        case 1:
+            return GL_POINTS;
+        case 2:
+            return GL_LINES;
+        case 3:
+            return GL_TRIANGLES;
+        case 4:
+            return GL_LINES_ADJACENCY;
+        case 6:
+            return GL_TRIANGLES_ADJACENCY;
+        default:
+            UNREACHABLE();
+        }
+    }
+
     switch (regs.pipeline.triangle_topology) {
     case Pica::PipelineRegs::TriangleTopology::Shader:
     case Pica::PipelineRegs::TriangleTopology::List:
@@ -437,47 +574,75 @@ bool RasterizerOpenGL::AccelerateDrawBatchInternal(bool is_indexed) {
     const auto& regs = Pica::g_state.regs;
     GLenum primitive_mode = GetCurrentPrimitiveMode();
 
-    auto [vs_input_index_min, vs_input_index_max, vs_input_size] = AnalyzeVertexArray(is_indexed);
+    // The index buffer binding is part of the vertex array object
+    state.draw.vertex_array = hw_vao.handle;
+    state.draw.vertex_buffer = vertex_buffer.GetHandle();
+    state.Apply();
+
+    const bool index_u16 = regs.pipeline.index_array.format != 0;
+    const std::size_t index_buffer_size =
+        is_indexed ? regs.pipeline.num_vertices * (index_u16 ? 2 : 1) : 0;
+    if (index_buffer_size > INDEX_BUFFER_SIZE) {
+        LOG_WARNING(Render_OpenGL, "Too large index input size {}", index_buffer_size);
+        return false;
+    }
+
+    u8* index_ptr = nullptr;
+    GLintptr index_offset = 0;
+    if (is_indexed) {
+        std::tie(index_ptr, index_offset, std::ignore) = index_buffer.Map(index_buffer_size, 4);
+    }
+    const auto [vs_input_index_min, vs_input_index_max, vs_input_size] =
+        AnalyzeVertexArray(is_indexed, index_ptr);
+    if (is_indexed) {
+        index_buffer.Unmap(index_buffer_size);
+    }
 
     if (vs_input_size > VERTEX_BUFFER_SIZE) {
         LOG_WARNING(Render_OpenGL, "Too large vertex input size {}", vs_input_size);
         return false;
     }
 
-    state.draw.vertex_buffer = vertex_buffer.GetHandle();
-    state.Apply();
-
-    u8* buffer_ptr;
-    GLintptr buffer_offset;
-    std::tie(buffer_ptr, buffer_offset, std::ignore) = vertex_buffer.Map(vs_input_size, 4);
-    SetupVertexArray(buffer_ptr, buffer_offset, vs_input_index_min, vs_input_index_max);
-    vertex_buffer.Unmap(vs_input_size);
+    // The parts of a model are often drawn one after the other from the same vertex data. It only
+    // has to be uploaded once, as long as it is unchanged and the stream buffer didn't wrap since.
+    const auto& vertex_attributes = regs.pipeline.vertex_attributes;
+    VertexUpload& upload = last_vertex_upload;
+    const bool same_layout =
+        upload.valid &&
+        std::memcmp(&upload.attributes, &vertex_attributes, sizeof(vertex_attributes)) == 0;
+    if (same_layout && upload.hashed && vs_input_index_min >= upload.index_min &&
+        vs_input_index_max <= upload.index_max &&
+        HashVertexArray(upload.index_min, upload.index_max) == upload.hash) {
+        SetupVertexArray(nullptr, upload.buffer_offset, upload.index_min, upload.index_max);
+    } else {
+        u8* buffer_ptr;
+        GLintptr buffer_offset;
+        std::tie(buffer_ptr, buffer_offset, std::ignore) = vertex_buffer.Map(vs_input_size, 4);
+        SetupVertexArray(buffer_ptr, buffer_offset, vs_input_index_min, vs_input_index_max);
+        vertex_buffer.Unmap(vs_input_size);
+
+        // Only hash the data once the layout repeats, most draws don't share their vertex data
+        upload.valid = true;
+        upload.hashed = same_layout;
+        upload.hash = same_layout ? HashVertexArray(vs_input_index_min, vs_input_index_max) : 0;
+        upload.attributes = vertex_attributes;
+        upload.index_min = vs_input_index_min;
+        upload.index_max = vs_input_index_max;
+        upload.buffer_offset = buffer_offset;
+    }
+    const u32 base_index = upload.index_min;
 
     shader_program_manager->ApplyTo(state);
     state.Apply();
 
     if (is_indexed) {
-        bool index_u16 = regs.pipeline.index_array.format != 0;
-        std::size_t index_buffer_size = regs.pipeline.num_vertices * (index_u16 ? 2 : 1);
-
-        if (index_buffer_size > INDEX_BUFFER_SIZE) {
-            LOG_WARNING(Render_OpenGL, "Too large index input size {}", index_buffer_size);
-            return false;
-        }
-
-        const u8* index_data = VideoCore::g_memory->GetPhysicalPointer(
-            regs.pipeline.vertex_attributes.GetPhysicalBaseAddress() +
-            regs.pipeline.index_array.offset);
-        std::tie(buffer_ptr, buffer_offset, std::ignore) = index_buffer.Map(index_buffer_size, 4);
-        std::memcpy(buffer_ptr, index_data, index_buffer_size);
-        index_buffer.Unmap(index_buffer_size);
-
         glDrawRangeElementsBaseVertex(
             primitive_mode, vs_input_index_min, vs_input_index_max, regs.pipeline.num_vertices,
             index_u16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE,
-            reinterpret_cast<const void*>(buffer_offset), -static_cast<GLint>(vs_input_index_min));
+            reinterpret_cast<const void*>(index_offset), -static_cast<GLint>(base_index));
     } else {
-        glDrawArrays(primitive_mode, 0, regs.pipeline.num_vertices);
+        glDrawArrays(primitive_mode, static_cast<GLint>(vs_input_index_min - base_index),
+                     regs.pipeline.num_vertices);
     }
     return true;
 }
@@ -514,6 +679,15 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
         (write_depth_fb || regs.framebuffer.output_merger.depth_test_enable != 0 ||
          (has_stencil && state.stencil.test_enabled));
 
+    // Nothing but the screen would see these draws, which doesn't show skipped frames
+    if (skip_frame && using_color_fb && !shadow_rendering &&
+        res_cache.IsDisplayOnly(regs.framebuffer.framebuffer.GetColorBufferPhysicalAddress())) {
+        if (!accelerate) {
+            vertex_batch.clear();
+        }
+        return true;
+    }
+
     Common::Rectangle<s32> viewport_rect_unscaled{
         // These registers hold half-width and half-height, so must be multiplied by 2
         regs.rasterizer.viewport_corner.x,  // left
@@ -733,14 +907,14 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
                     state.texture_cube_unit.texture_cube =
                         res_cache.GetTextureCube(config).texture.handle;
 
-                    texture_cube_sampler.SyncWithConfig(texture.config);
+                    state.texture_cube_unit.sampler = GetSampler(texture.config);
                     state.texture_units[texture_index].texture_2d = 0;
                     continue; // Texture unit 0 setup finished. Continue to next unit
                 }
                 state.texture_cube_unit.texture_cube = 0;
             }
 
-            texture_samplers[texture_index].SyncWithConfig(texture.config);
+            state.texture_units[texture_index].sampler = GetSampler(texture.config);
             Surface surface = res_cache.GetTextureSurface(texture);
             if (surface != nullptr) {
                 CheckBarrier(state.texture_units[texture_index].texture_2d =
@@ -760,10 +934,11 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
         }
     }
 
-    // Sync and bind the shader
+    // Sync and bind the shader. If the fragment shader is still being built in the background, the
+    // draw is skipped and the shader is looked up again on the next one.
     if (shader_dirty) {
-        SetShader();
-        shader_dirty = false;
+        shader_dirty = !SetShader();
+        uber_uniforms_dirty = true;
     }
 
     // Sync the LUTs within the texture buffer
@@ -784,8 +959,12 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
     state.Apply();
 
     // Draw the vertex batch
+    GPUProfiler::Scope gpu_scope{GPUProfiler::Pass::Draw, fs_config_hash,
+                                 regs.framebuffer.framebuffer.GetColorBufferPhysicalAddress()};
     bool succeeded = true;
-    if (accelerate) {
+    if (shader_dirty) {
+        // The fragment shader isn't ready, drop the batch
+    } else if (accelerate) {
         succeeded = AccelerateDrawBatchInternal(is_indexed);
     } else {
         state.draw.vertex_array = sw_vao.handle;
@@ -802,8 +981,12 @@ bool RasterizerOpenGL::Draw(bool accelerate, bool is_indexed) {
             std::size_t vertex_size = vertices * sizeof(HardwareVertex);
             u8* vbo;
             GLintptr offset;
-            std::tie(vbo, offset, std::ignore) =
+            bool invalidate;
+            std::tie(vbo, offset, invalidate) =
                 vertex_buffer.Map(vertex_size, sizeof(HardwareVertex));
+            if (invalidate) {
+                last_vertex_upload.valid = false;
+            }
             std::memcpy(vbo, vertex_batch.data() + base_vertex, vertex_size);
             vertex_buffer.Unmap(vertex_size);
             glDrawArrays(GL_TRIANGLES, offset / sizeof(HardwareVertex), (GLsizei)vertices);
@@ -918,16 +1101,22 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.fog_lut_data[5]):
     case PICA_REG_INDEX(texturing.fog_lut_data[6]):
     case PICA_REG_INDEX(texturing.fog_lut_data[7]):
-        uniform_block_data.fog_lut_dirty = true;
+        fog_lut.MarkWritten(regs.texturing.fog_lut_offset);
         break;
 
     // ProcTex state
     case PICA_REG_INDEX(texturing.proctex):
+        SyncProcTexBias();
+        shader_dirty = true;
+        break;
     case PICA_REG_INDEX(texturing.proctex_lut):
-    case PICA_REG_INDEX(texturing.proctex_lut_offset):
         SyncProcTexBias();
+        SyncProcTexLUTLayout();
         shader_dirty = true;
         break;
+    case PICA_REG_INDEX(texturing.proctex_lut_offset):
+        SyncProcTexLUTLayout();
+        break;
 
     case PICA_REG_INDEX(texturing.proctex_noise_u):
     case PICA_REG_INDEX(texturing.proctex_noise_v):
@@ -942,26 +1131,28 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.proctex_lut_data[4]):
     case PICA_REG_INDEX(texturing.proctex_lut_data[5]):
     case PICA_REG_INDEX(texturing.proctex_lut_data[6]):
-    case PICA_REG_INDEX(texturing.proctex_lut_data[7]):
+    case PICA_REG_INDEX(texturing.proctex_lut_data[7]): {
         using Pica::TexturingRegs;
+        const u32 next_index = regs.texturing.proctex_lut_config.index;
         switch (regs.texturing.proctex_lut_config.ref_table.Value()) {
         case TexturingRegs::ProcTexLutTable::Noise:
-            uniform_block_data.proctex_noise_lut_dirty = true;
+            proctex_noise_lut.MarkWritten(next_index);
             break;
         case TexturingRegs::ProcTexLutTable::ColorMap:
-            uniform_block_data.proctex_color_map_dirty = true;
+            proctex_color_map.MarkWritten(next_index);
             break;
         case TexturingRegs::ProcTexLutTable::AlphaMap:
-            uniform_block_data.proctex_alpha_map_dirty = true;
+            proctex_alpha_map.MarkWritten(next_index);
             break;
         case TexturingRegs::ProcTexLutTable::Color:
-            uniform_block_data.proctex_lut_dirty = true;
+            proctex_lut.MarkWritten(next_index);
             break;
         case TexturingRegs::ProcTexLutTable::ColorDiff:
-            uniform_block_data.proctex_diff_lut_dirty = true;
+            proctex_diff_lut.MarkWritten(next_index);
             break;
         }
         break;
+    }
 
     // Alpha test
     case PICA_REG_INDEX(framebuffer.output_merger.alpha_test):
@@ -1084,10 +1275,14 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(lighting.config1):
     case PICA_REG_INDEX(lighting.abs_lut_input):
     case PICA_REG_INDEX(lighting.lut_input):
-    case PICA_REG_INDEX(lighting.lut_scale):
     case PICA_REG_INDEX(lighting.light_enable):
         break;
 
+    // Fragment lighting LUT scales
+    case PICA_REG_INDEX(lighting.lut_scale):
+        SyncLightingLUTScales();
+        break;
+
     // Fragment lighting specular 0 color
     case PICA_REG_INDEX(lighting.light[0].specular_0):
         SyncLightSpecular0(0);
@@ -1339,8 +1534,7 @@ void RasterizerOpenGL::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(lighting.lut_data[6]):
     case PICA_REG_INDEX(lighting.lut_data[7]): {
         auto& lut_config = regs.lighting.lut_config;
-        uniform_block_data.lighting_lut_dirty[lut_config.type] = true;
-        uniform_block_data.lighting_lut_dirty_any = true;
+        lighting_luts[lut_config.type].MarkWritten(lut_config.index);
         break;
     }
     }
@@ -1415,6 +1609,10 @@ bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransfe
         return false;
 
     res_cache.InvalidateRegion(dst_params.addr, dst_params.size, dst_surface);
+
+    // The source of a display transfer is usually a finished frame, which some games read back
+    res_cache.StartReadback(src_surface);
+    res_cache.MarkDisplaySource(src_params, src_surface);
     return true;
 }
 
@@ -1546,87 +1744,74 @@ bool RasterizerOpenGL::AccelerateDisplay(const GPU::Regs::FramebufferConfig& con
         (float)src_rect.top / (float)scaled_height, (float)src_rect.right / (float)scaled_width);
 
     screen_info.display_texture = src_surface->texture.handle;
+    screen_info.display_version = src_surface->modification_tick;
 
     return true;
 }
 
-void RasterizerOpenGL::SamplerInfo::Create() {
+RasterizerOpenGL::SamplerInfo RasterizerOpenGL::SamplerInfo::FromConfig(
+    const TextureConfig& config) {
+    SamplerInfo info;
+    info.mag_filter = config.mag_filter;
+    info.min_filter = config.min_filter;
+    info.mip_filter = config.mip_filter;
+    info.wrap_s = config.wrap_s;
+    info.wrap_t = config.wrap_t;
+    const bool uses_border =
+        info.wrap_s == TextureConfig::ClampToBorder || info.wrap_t == TextureConfig::ClampToBorder;
+    info.border_color = uses_border ? config.border_color.raw : 0;
+    info.lod_min = config.lod.min_level;
+    info.lod_max = config.lod.max_level;
+    info.lod_bias = GLES ? 0 : static_cast<s32>(config.lod.bias);
+    info.supress_mipmap_for_cube = config.type == TextureConfig::TextureCube;
+    return info;
+}
+
+OGLSampler RasterizerOpenGL::SamplerInfo::Create() const {
+    OGLSampler sampler;
     sampler.Create();
-    mag_filter = min_filter = mip_filter = TextureConfig::Linear;
-    wrap_s = wrap_t = TextureConfig::Repeat;
-    border_color = 0;
-    lod_min = lod_max = 0;
-    lod_bias = 0;
-
-    // default is 1000 and -1000
-    // Other attributes have correct defaults
-    glSamplerParameterf(sampler.handle, GL_TEXTURE_MAX_LOD, lod_max);
-    glSamplerParameterf(sampler.handle, GL_TEXTURE_MIN_LOD, lod_min);
-}
-
-void RasterizerOpenGL::SamplerInfo::SyncWithConfig(
-    const Pica::TexturingRegs::TextureConfig& config) {
-
-    GLuint s = sampler.handle;
-
-    if (mag_filter != config.mag_filter) {
-        mag_filter = config.mag_filter;
-        glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, PicaToGL::TextureMagFilterMode(mag_filter));
-    }
-
-    // TODO(wwylele): remove new_supress_mipmap_for_cube logic once mipmap for cube is implemented
-    bool new_supress_mipmap_for_cube =
-        config.type == Pica::TexturingRegs::TextureConfig::TextureCube;
-    if (min_filter != config.min_filter || mip_filter != config.mip_filter ||
-        supress_mipmap_for_cube != new_supress_mipmap_for_cube) {
-        min_filter = config.min_filter;
-        mip_filter = config.mip_filter;
-        supress_mipmap_for_cube = new_supress_mipmap_for_cube;
-        if (new_supress_mipmap_for_cube) {
-            // HACK: use mag filter converter for min filter because they are the same anyway
-            glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER,
-                                PicaToGL::TextureMagFilterMode(min_filter));
-        } else {
-            glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER,
-                                PicaToGL::TextureMinFilterMode(min_filter, mip_filter));
-        }
-    }
+    const GLuint s = sampler.handle;
 
-    if (wrap_s != config.wrap_s) {
-        wrap_s = config.wrap_s;
-        glSamplerParameteri(s, GL_TEXTURE_WRAP_S, PicaToGL::WrapMode(wrap_s));
-    }
-    if (wrap_t != config.wrap_t) {
-        wrap_t = config.wrap_t;
-        glSamplerParameteri(s, GL_TEXTURE_WRAP_T, PicaToGL::WrapMode(wrap_t));
+    glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, PicaToGL::TextureMagFilterMode(mag_filter));
+    // TODO(wwylele): remove supress_mipmap_for_cube logic once mipmap for cube is implemented
+    if (supress_mipmap_for_cube) {
+        // HACK: use mag filter converter for min filter because they are the same anyway
+        glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER, PicaToGL::TextureMagFilterMode(min_filter));
+    } else {
+        glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER,
+                            PicaToGL::TextureMinFilterMode(min_filter, mip_filter));
     }
 
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_S, PicaToGL::WrapMode(wrap_s));
+    glSamplerParameteri(s, GL_TEXTURE_WRAP_T, PicaToGL::WrapMode(wrap_t));
     if (wrap_s == TextureConfig::ClampToBorder || wrap_t == TextureConfig::ClampToBorder) {
-        if (border_color != config.border_color.raw) {
-            border_color = config.border_color.raw;
-            auto gl_color = PicaToGL::ColorRGBA8(border_color);
-            glSamplerParameterfv(s, GL_TEXTURE_BORDER_COLOR, gl_color.data());
-        }
+        auto gl_color = PicaToGL::ColorRGBA8(border_color);
+        glSamplerParameterfv(s, GL_TEXTURE_BORDER_COLOR, gl_color.data());
     }
 
-    if (lod_min != config.lod.min_level) {
-        lod_min = config.lod.min_level;
-        glSamplerParameterf(s, GL_TEXTURE_MIN_LOD, lod_min);
-    }
-
-    if (lod_max != config.lod.max_level) {
-        lod_max = config.lod.max_level;
-        glSamplerParameterf(s, GL_TEXTURE_MAX_LOD, lod_max);
+    // The defaults are -1000 and 1000
+    glSamplerParameterf(s, GL_TEXTURE_MIN_LOD, static_cast<float>(lod_min));
+    glSamplerParameterf(s, GL_TEXTURE_MAX_LOD, static_cast<float>(lod_max));
+    if (!GLES) {
+        glSamplerParameterf(s, GL_TEXTURE_LOD_BIAS, lod_bias / 256.0f);
     }
+    return sampler;
+}
 
-    if (!GLES && lod_bias != config.lod.bias) {
-        lod_bias = config.lod.bias;
-        glSamplerParameterf(s, GL_TEXTURE_LOD_BIAS, lod_bias / 256.0f);
+GLuint RasterizerOpenGL::GetSampler(const Pica::TexturingRegs::TextureConfig& config) {
+    const SamplerInfo info = SamplerInfo::FromConfig(config);
+    auto [it, inserted] = sampler_cache.try_emplace(info);
+    if (inserted) {
+        it->second = info.Create();
     }
+    return it->second.handle;
 }
 
-void RasterizerOpenGL::SetShader() {
-    shader_program_manager->UseFragmentShader(Pica::g_state.regs);
+bool RasterizerOpenGL::SetShader() {
+    if (GPUProfiler::GetInstance().IsActive()) {
+        fs_config_hash = PicaFSConfig::BuildFromRegs(Pica::g_state.regs).Hash();
+    }
+    return shader_program_manager->UseFragmentShader(Pica::g_state.regs);
 }
 
 void RasterizerOpenGL::SyncClipEnabled() {
@@ -1753,6 +1938,22 @@ void RasterizerOpenGL::SyncProcTexBias() {
     uniform_block_data.dirty = true;
 }
 
+void RasterizerOpenGL::SyncProcTexLUTLayout() {
+    const auto& regs = Pica::g_state.regs.texturing;
+    auto& data = uniform_block_data.data;
+    data.proctex_lut_width = regs.proctex_lut.width;
+    data.proctex_lod_min = regs.proctex_lut.lod_min;
+    data.proctex_lod_max = std::min<GLint>(7, regs.proctex_lut.lod_max);
+    data.proctex_lut_level_offsets = {
+        static_cast<GLint>(regs.proctex_lut_offset.level0),
+        static_cast<GLint>(regs.proctex_lut_offset.level1),
+        static_cast<GLint>(regs.proctex_lut_offset.level2),
+        static_cast<GLint>(regs.proctex_lut_offset.level3),
+    };
+
+    uniform_block_data.dirty = true;
+}
+
 void RasterizerOpenGL::SyncAlphaTest() {
     const auto& regs = Pica::g_state.regs;
     if (regs.framebuffer.output_merger.alpha_test.ref != uniform_block_data.data.alphatest_ref) {
@@ -1927,6 +2128,23 @@ void RasterizerOpenGL::SyncLightDistanceAttenuationScale(int light_index) {
     }
 }
 
+void RasterizerOpenGL::SyncLightingLUTScales() {
+    const auto& lut_scale = Pica::g_state.regs.lighting.lut_scale;
+    auto& scales = uniform_block_data.data.lighting_lut_scales;
+    const auto SetScale = [&](UniformData::Lut lut, Pica::LightingRegs::LightingScale scale) {
+        scales[lut / 4][lut % 4] = lut_scale.GetScale(scale);
+    };
+    SetScale(UniformData::LutD0, lut_scale.d0);
+    SetScale(UniformData::LutD1, lut_scale.d1);
+    SetScale(UniformData::LutSP, lut_scale.sp);
+    SetScale(UniformData::LutFR, lut_scale.fr);
+    SetScale(UniformData::LutRR, lut_scale.rr);
+    SetScale(UniformData::LutRG, lut_scale.rg);
+    SetScale(UniformData::LutRB, lut_scale.rb);
+
+    uniform_block_data.dirty = true;
+}
+
 void RasterizerOpenGL::SyncShadowBias() {
     const auto& shadow = Pica::g_state.regs.framebuffer.shadow;
     GLfloat constant = Pica::float16::FromRaw(shadow.constant).ToFloat32();
@@ -1955,11 +2173,12 @@ void RasterizerOpenGL::SyncAndUploadLUTs() {
                                      sizeof(GLvec4) * 256 +     // proctex
                                      sizeof(GLvec4) * 256;      // proctex diff
 
-    if (!uniform_block_data.lighting_lut_dirty_any && !uniform_block_data.fog_lut_dirty &&
-        !uniform_block_data.proctex_noise_lut_dirty &&
-        !uniform_block_data.proctex_color_map_dirty &&
-        !uniform_block_data.proctex_alpha_map_dirty && !uniform_block_data.proctex_lut_dirty &&
-        !uniform_block_data.proctex_diff_lut_dirty) {
+    const bool lighting_luts_dirty =
+        std::any_of(lighting_luts.begin(), lighting_luts.end(),
+                    [](const auto& lut) { return lut.IsDirty(); });
+    if (!lighting_luts_dirty && !fog_lut.IsDirty() && !proctex_noise_lut.IsDirty() &&
+        !proctex_color_map.IsDirty() && !proctex_alpha_map.IsDirty() && !proctex_lut.IsDirty() &&
+        !proctex_diff_lut.IsDirty()) {
         return;
     }
 
@@ -1970,133 +2189,83 @@ void RasterizerOpenGL::SyncAndUploadLUTs() {
     glBindBuffer(GL_TEXTURE_BUFFER, texture_buffer.GetHandle());
     std::tie(buffer, offset, invalidate) = texture_buffer.Map(max_size, sizeof(GLvec4));
 
-    // Sync the lighting luts
-    if (uniform_block_data.lighting_lut_dirty_any || invalidate) {
-        for (unsigned index = 0; index < uniform_block_data.lighting_lut_dirty.size(); index++) {
-            if (uniform_block_data.lighting_lut_dirty[index] || invalidate) {
-                std::array<GLvec2, 256> new_data;
-                const auto& source_lut = Pica::g_state.lighting.luts[index];
-                std::transform(source_lut.begin(), source_lut.end(), new_data.begin(),
-                               [](const auto& entry) {
-                                   return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-                               });
-
-                if (new_data != lighting_lut_data[index] || invalidate) {
-                    lighting_lut_data[index] = new_data;
-                    std::memcpy(buffer + bytes_used, new_data.data(),
-                                new_data.size() * sizeof(GLvec2));
-                    uniform_block_data.data.lighting_lut_offset[index / 4][index % 4] =
-                        (offset + bytes_used) / sizeof(GLvec2);
-                    uniform_block_data.dirty = true;
-                    bytes_used += new_data.size() * sizeof(GLvec2);
-                }
-                uniform_block_data.lighting_lut_dirty[index] = false;
+    // Converts the written entries of the LUT and points the shader to a copy of its contents,
+    // which is only uploaded if none of the last uploads of the LUT matches them
+    auto SyncLUT = [this, buffer, offset, invalidate, &bytes_used](auto& lut, const auto& source,
+                                                                   auto convert,
+                                                                   GLint& lut_offset) {
+        if (!lut.IsDirty() && !invalidate)
+            return;
+
+        bool changed = false;
+        for (std::size_t i = lut.dirty_begin; i < lut.dirty_end; ++i) {
+            const auto value = convert(source[i]);
+            if (value != lut.data[i]) {
+                lut.data[i] = value;
+                changed = true;
             }
         }
-    }
-    uniform_block_data.lighting_lut_dirty_any = false;
-
-    // Sync the fog lut
-    if (uniform_block_data.fog_lut_dirty || invalidate) {
-        std::array<GLvec2, 128> new_data;
-
-        std::transform(Pica::g_state.fog.lut.begin(), Pica::g_state.fog.lut.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-                       });
-
-        if (new_data != fog_lut_data || invalidate) {
-            fog_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec2));
-            uniform_block_data.data.fog_lut_offset = (offset + bytes_used) / sizeof(GLvec2);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec2);
+        lut.dirty_begin = lut.data.size();
+        lut.dirty_end = 0;
+
+        // The previous uploads are overwritten once the buffer wraps
+        if (invalidate) {
+            lut.num_uploads = 0;
+        } else if (!changed) {
+            return;
         }
-        uniform_block_data.fog_lut_dirty = false;
-    }
-
-    // helper function for SyncProcTexNoiseLUT/ColorMap/AlphaMap
-    auto SyncProcTexValueLUT = [this, buffer, offset, invalidate, &bytes_used](
-                                   const std::array<Pica::State::ProcTex::ValueEntry, 128>& lut,
-                                   std::array<GLvec2, 128>& lut_data, GLint& lut_offset) {
-        std::array<GLvec2, 128> new_data;
-        std::transform(lut.begin(), lut.end(), new_data.begin(), [](const auto& entry) {
-            return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
-        });
-
-        if (new_data != lut_data || invalidate) {
-            lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec2));
-            lut_offset = (offset + bytes_used) / sizeof(GLvec2);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec2);
-        }
-    };
-
-    // Sync the proctex noise lut
-    if (uniform_block_data.proctex_noise_lut_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.noise_table, proctex_noise_lut_data,
-                            uniform_block_data.data.proctex_noise_lut_offset);
-        uniform_block_data.proctex_noise_lut_dirty = false;
-    }
 
-    // Sync the proctex color map
-    if (uniform_block_data.proctex_color_map_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.color_map_table, proctex_color_map_data,
-                            uniform_block_data.data.proctex_color_map_offset);
-        uniform_block_data.proctex_color_map_dirty = false;
-    }
+        const u64 hash = Common::ComputeFastHash64(lut.data.data(), sizeof(lut.data));
+        for (std::size_t i = 0; i < lut.num_uploads; ++i) {
+            if (lut.uploads[i].first == hash) {
+                lut_offset = lut.uploads[i].second;
+                uniform_block_data.dirty = true;
+                return;
+            }
+        }
 
-    // Sync the proctex alpha map
-    if (uniform_block_data.proctex_alpha_map_dirty || invalidate) {
-        SyncProcTexValueLUT(Pica::g_state.proctex.alpha_map_table, proctex_alpha_map_data,
-                            uniform_block_data.data.proctex_alpha_map_offset);
-        uniform_block_data.proctex_alpha_map_dirty = false;
-    }
+        using Entry = typename std::decay_t<decltype(lut.data)>::value_type;
+        std::memcpy(buffer + bytes_used, lut.data.data(), sizeof(lut.data));
+        lut_offset = static_cast<GLint>((offset + bytes_used) / sizeof(Entry));
+        uniform_block_data.dirty = true;
+        bytes_used += sizeof(lut.data);
 
-    // Sync the proctex lut
-    if (uniform_block_data.proctex_lut_dirty || invalidate) {
-        std::array<GLvec4, 256> new_data;
+        lut.uploads[lut.next_upload] = {hash, lut_offset};
+        lut.next_upload = (lut.next_upload + 1) % lut.uploads.size();
+        lut.num_uploads = std::min(lut.num_uploads + 1, lut.uploads.size());
+    };
 
-        std::transform(Pica::g_state.proctex.color_table.begin(),
-                       Pica::g_state.proctex.color_table.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           auto rgba = entry.ToVector() / 255.0f;
-                           return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
-                       });
+    const auto ConvertLutEntry = [](const auto& entry) {
+        return GLvec2{entry.ToFloat(), entry.DiffToFloat()};
+    };
+    const auto ConvertColorEntry = [](const auto& entry) {
+        auto rgba = entry.ToVector() / 255.0f;
+        return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
+    };
 
-        if (new_data != proctex_lut_data || invalidate) {
-            proctex_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec4));
-            uniform_block_data.data.proctex_lut_offset = (offset + bytes_used) / sizeof(GLvec4);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec4);
-        }
-        uniform_block_data.proctex_lut_dirty = false;
-    }
-
-    // Sync the proctex difference lut
-    if (uniform_block_data.proctex_diff_lut_dirty || invalidate) {
-        std::array<GLvec4, 256> new_data;
-
-        std::transform(Pica::g_state.proctex.color_diff_table.begin(),
-                       Pica::g_state.proctex.color_diff_table.end(), new_data.begin(),
-                       [](const auto& entry) {
-                           auto rgba = entry.ToVector() / 255.0f;
-                           return GLvec4{rgba.r(), rgba.g(), rgba.b(), rgba.a()};
-                       });
-
-        if (new_data != proctex_diff_lut_data || invalidate) {
-            proctex_diff_lut_data = new_data;
-            std::memcpy(buffer + bytes_used, new_data.data(), new_data.size() * sizeof(GLvec4));
-            uniform_block_data.data.proctex_diff_lut_offset =
-                (offset + bytes_used) / sizeof(GLvec4);
-            uniform_block_data.dirty = true;
-            bytes_used += new_data.size() * sizeof(GLvec4);
-        }
-        uniform_block_data.proctex_diff_lut_dirty = false;
+    // Sync the lighting luts
+    for (std::size_t index = 0; index < lighting_luts.size(); ++index) {
+        SyncLUT(lighting_luts[index], Pica::g_state.lighting.luts[index], ConvertLutEntry,
+                uniform_block_data.data.lighting_lut_offset[index / 4][index % 4]);
     }
 
+    // Sync the fog lut
+    SyncLUT(fog_lut, Pica::g_state.fog.lut, ConvertLutEntry,
+            uniform_block_data.data.fog_lut_offset);
+
+    // Sync the proctex luts
+    const auto& proctex = Pica::g_state.proctex;
+    SyncLUT(proctex_noise_lut, proctex.noise_table, ConvertLutEntry,
+            uniform_block_data.data.proctex_noise_lut_offset);
+    SyncLUT(proctex_color_map, proctex.color_map_table, ConvertLutEntry,
+            uniform_block_data.data.proctex_color_map_offset);
+    SyncLUT(proctex_alpha_map, proctex.alpha_map_table, ConvertLutEntry,
+            uniform_block_data.data.proctex_alpha_map_offset);
+    SyncLUT(proctex_lut, proctex.color_table, ConvertColorEntry,
+            uniform_block_data.data.proctex_lut_offset);
+    SyncLUT(proctex_diff_lut, proctex.color_diff_table, ConvertColorEntry,
+            uniform_block_data.data.proctex_diff_lut_offset);
+
     texture_buffer.Unmap(bytes_used);
 }
 
@@ -2106,13 +2275,33 @@ void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
     state.draw.uniform_buffer = uniform_buffer.GetHandle();
     state.Apply();
 
-    bool sync_vs = accelerate_draw;
+    // The vertex shader uniforms only change between some of the draws, so they are compared with
+    // the uploaded ones instead of being uploaded for every draw
+    VSUniformData vs_uniforms{};
+    bool sync_vs = false;
+    if (accelerate_draw) {
+        vs_uniforms.uniforms.SetFromRegs(Pica::g_state.regs.vs, Pica::g_state.vs);
+        sync_vs = !vs_uniforms_uploaded ||
+                  std::memcmp(&vs_uniforms, &uploaded_vs_uniforms, sizeof(VSUniformData)) != 0;
+    }
+    GSUniformData gs_uniforms{};
+    const bool use_gs =
+        accelerate_draw && Pica::g_state.regs.pipeline.use_gs != Pica::PipelineRegs::UseGS::No;
+    bool sync_gs = false;
+    if (use_gs) {
+        gs_uniforms.uniforms.SetFromRegs(Pica::g_state.regs.gs, Pica::g_state.gs);
+        sync_gs = !gs_uniforms_uploaded ||
+                  std::memcmp(&gs_uniforms, &uploaded_gs_uniforms, sizeof(GSUniformData)) != 0;
+    }
     bool sync_fs = uniform_block_data.dirty;
+    const FSUberUniformData* uber_uniforms = shader_program_manager->GetUberUniformData();
+    bool sync_uber = uber_uniforms && uber_uniforms_dirty;
 
-    if (!sync_vs && !sync_fs)
+    if (!sync_vs && !sync_gs && !sync_fs && !sync_uber)
         return;
 
-    std::size_t uniform_size = uniform_size_aligned_vs + uniform_size_aligned_fs;
+    std::size_t uniform_size = uniform_size_aligned_vs + uniform_size_aligned_gs +
+                               uniform_size_aligned_fs + uniform_size_aligned_uber;
     std::size_t used_bytes = 0;
     u8* uniforms;
     GLintptr offset;
@@ -2120,13 +2309,27 @@ void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
     std::tie(uniforms, offset, invalidate) =
         uniform_buffer.Map(uniform_size, uniform_buffer_alignment);
 
-    if (sync_vs) {
-        VSUniformData vs_uniforms;
-        vs_uniforms.uniforms.SetFromRegs(Pica::g_state.regs.vs, Pica::g_state.vs);
+    if (accelerate_draw && (sync_vs || invalidate)) {
         std::memcpy(uniforms + used_bytes, &vs_uniforms, sizeof(vs_uniforms));
         glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBindings::VS),
                           uniform_buffer.GetHandle(), offset + used_bytes, sizeof(VSUniformData));
+        uploaded_vs_uniforms = vs_uniforms;
+        vs_uniforms_uploaded = true;
         used_bytes += uniform_size_aligned_vs;
+    } else if (invalidate) {
+        // The bound copy gets overwritten
+        vs_uniforms_uploaded = false;
+    }
+
+    if (use_gs && (sync_gs || invalidate)) {
+        std::memcpy(uniforms + used_bytes, &gs_uniforms, sizeof(gs_uniforms));
+        glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBindings::GS),
+                          uniform_buffer.GetHandle(), offset + used_bytes, sizeof(GSUniformData));
+        uploaded_gs_uniforms = gs_uniforms;
+        gs_uniforms_uploaded = true;
+        used_bytes += uniform_size_aligned_gs;
+    } else if (invalidate) {
+        gs_uniforms_uploaded = false;
     }
 
     if (sync_fs || invalidate) {
@@ -2137,6 +2340,15 @@ void RasterizerOpenGL::UploadUniforms(bool accelerate_draw) {
         used_bytes += uniform_size_aligned_fs;
     }
 
+    if (uber_uniforms && (sync_uber || invalidate)) {
+        std::memcpy(uniforms + used_bytes, uber_uniforms, sizeof(FSUberUniformData));
+        glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(UniformBindings::FSUber),
+                          uniform_buffer.GetHandle(), offset + used_bytes,
+                          sizeof(FSUberUniformData));
+        uber_uniforms_dirty = false;
+        used_bytes += uniform_size_aligned_uber;
+    }
+
     uniform_buffer.Unmap(used_bytes);
 }
 
@@ -4,14 +4,18 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
 #include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <glad/glad.h>
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/vector_math.h"
 #include "core/hw/gpu.h"
 #include "video_core/pica_state.h"
@@ -47,6 +51,8 @@ public:
 
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
+    void AddTriangles(const Pica::Shader::OutputVertex* vertices,
+                      std::size_t num_triangles) override;
     void DrawTriangles() override;
     void NotifyPicaRegisterChanged(u32 id) override;
     void FlushAll() override;
@@ -59,20 +65,31 @@ public:
     bool AccelerateDisplay(const GPU::Regs::FramebufferConfig& config, PAddr framebuffer_addr,
                            u32 pixel_stride, ScreenInfo& screen_info) override;
     bool AccelerateDrawBatch(bool is_indexed) override;
+    void SetSkipFrame(bool skip) override {
+        skip_frame = skip;
+    }
 
 private:
+    /// Sampler state of a texture unit, every distinct state gets its own cached sampler object
     struct SamplerInfo {
         using TextureConfig = Pica::TexturingRegs::TextureConfig;
 
-        OGLSampler sampler;
+        /// Extracts the sampler state, leaving out the parts the sampler doesn't use
+        static SamplerInfo FromConfig(const TextureConfig& config);
 
-        /// Creates the sampler object, initializing its state so that it's in sync with the
-        /// SamplerInfo struct.
-        void Create();
-        /// Syncs the sampler object with the config, updating any necessary state.
-        void SyncWithConfig(const TextureConfig& config);
+        /// Creates a sampler object with this state
+        OGLSampler Create() const;
+
+        bool operator==(const SamplerInfo& rhs) const {
+            return std::memcmp(this, &rhs, sizeof(SamplerInfo)) == 0;
+        }
+
+        struct Hash {
+            std::size_t operator()(const SamplerInfo& info) const {
+                return static_cast<std::size_t>(Common::ComputeStructHash64(info));
+            }
+        };
 
-    private:
         TextureConfig::TextureFilter mag_filter;
         TextureConfig::TextureFilter min_filter;
         TextureConfig::TextureFilter mip_filter;
@@ -84,8 +101,9 @@ private:
         s32 lod_bias;
 
         // TODO(wwylele): remove this once mipmap for cube is implemented
-        bool supress_mipmap_for_cube = false;
+        u32 supress_mipmap_for_cube;
     };
+    static_assert(sizeof(SamplerInfo) == 10 * sizeof(u32), "SamplerInfo must not have padding");
 
     /// Structure that the hardware rendered vertices are composed of
     struct HardwareVertex {
@@ -140,8 +158,9 @@ private:
     /// Syncs the clip coefficients to match the PICA register
     void SyncClipCoef();
 
-    /// Sets the OpenGL shader in accordance with the current PICA register state
-    void SetShader();
+    /// Sets the OpenGL shader in accordance with the current PICA register state. Returns false if
+    /// the shader is not ready yet.
+    bool SetShader();
 
     /// Syncs the cull mode to match the PICA register
     void SyncCullMode();
@@ -170,6 +189,9 @@ private:
     /// Sync the procedural texture bias configuration to match the PICA register
     void SyncProcTexBias();
 
+    /// Syncs the procedural texture LUT layout to match the PICA register
+    void SyncProcTexLUTLayout();
+
     /// Syncs the alpha test states to match the PICA register
     void SyncAlphaTest();
 
@@ -224,6 +246,9 @@ private:
     /// Syncs the specified light's distance attenuation scale to match the PICA register
     void SyncLightDistanceAttenuationScale(int light_index);
 
+    /// Syncs the lighting LUT scales to match the PICA register
+    void SyncLightingLUTScales();
+
     /// Syncs the shadow rendering bias to match the PICA register
     void SyncShadowBias();
 
@@ -248,13 +273,17 @@ private:
         u32 vs_input_size;
     };
 
-    /// Retrieve the range and the size of the input vertex
-    VertexArrayInfo AnalyzeVertexArray(bool is_indexed);
+    /// Retrieve the range and the size of the input vertex, copying the indices to index_dst
+    VertexArrayInfo AnalyzeVertexArray(bool is_indexed, u8* index_dst);
 
-    /// Setup vertex array for AccelerateDrawBatch
+    /// Setup vertex array for AccelerateDrawBatch. A null array_ptr reuses the data already
+    /// uploaded at buffer_offset.
     void SetupVertexArray(u8* array_ptr, GLintptr buffer_offset, GLuint vs_input_index_min,
                           GLuint vs_input_index_max);
 
+    /// Hashes the vertex data the attribute loaders read for the range of indices
+    u64 HashVertexArray(u32 vs_input_index_min, u32 vs_input_index_max);
+
     /// Setup vertex shader for AccelerateDrawBatch
     bool SetupVertexShader();
 
@@ -273,20 +302,22 @@ private:
     std::vector<HardwareVertex> vertex_batch;
 
     bool shader_dirty;
+    /// Hash of the fragment shader config for the GPU profiler, only updated while it is active
+    u64 fs_config_hash = 0;
+    bool uber_uniforms_dirty = true;
 
     struct {
         UniformData data;
-        std::array<bool, Pica::LightingRegs::NumLightingSampler> lighting_lut_dirty;
-        bool lighting_lut_dirty_any;
-        bool fog_lut_dirty;
-        bool proctex_noise_lut_dirty;
-        bool proctex_color_map_dirty;
-        bool proctex_alpha_map_dirty;
-        bool proctex_lut_dirty;
-        bool proctex_diff_lut_dirty;
         bool dirty;
     } uniform_block_data = {};
 
+    /// Copy of the vertex shader uniforms the uniform buffer binding points to
+    VSUniformData uploaded_vs_uniforms{};
+    bool vs_uniforms_uploaded = false;
+    /// Copy of the geometry shader uniforms the uniform buffer binding points to
+    GSUniformData uploaded_gs_uniforms{};
+    bool gs_uniforms_uploaded = false;
+
     std::unique_ptr<ShaderProgramManager> shader_program_manager;
 
     // They shall be big enough for about one frame.
@@ -299,7 +330,18 @@ private:
     OGLVertexArray hw_vao; // VAO for hardware shader / accelerate draw
     std::array<bool, 16> hw_vao_enabled_attributes{};
 
-    std::array<SamplerInfo, 3> texture_samplers;
+    /// Vertex data uploaded by the last accelerated draw, dropped when the vertex buffer wraps
+    struct VertexUpload {
+        bool valid = false;
+        /// The hash is only computed once a draw with the same layout follows
+        bool hashed = false;
+        u64 hash = 0;
+        decltype(Pica::PipelineRegs::vertex_attributes) attributes{};
+        u32 index_min = 0;
+        u32 index_max = 0;
+        GLintptr buffer_offset = 0;
+    } last_vertex_upload;
+
     OGLStreamBuffer vertex_buffer;
     OGLStreamBuffer uniform_buffer;
     OGLStreamBuffer index_buffer;
@@ -307,22 +349,58 @@ private:
     OGLFramebuffer framebuffer;
     GLint uniform_buffer_alignment;
     std::size_t uniform_size_aligned_vs;
+    std::size_t uniform_size_aligned_gs;
     std::size_t uniform_size_aligned_fs;
+    std::size_t uniform_size_aligned_uber;
 
-    SamplerInfo texture_cube_sampler;
+    /// Returns the cached sampler object for the sampler state of the config
+    GLuint GetSampler(const Pica::TexturingRegs::TextureConfig& config);
+
+    std::unordered_map<SamplerInfo, OGLSampler, SamplerInfo::Hash> sampler_cache;
 
     OGLTexture texture_buffer_lut_rg;
     OGLTexture texture_buffer_lut_rgba;
 
-    std::array<std::array<GLvec2, 256>, Pica::LightingRegs::NumLightingSampler> lighting_lut_data{};
-    std::array<GLvec2, 128> fog_lut_data{};
-    std::array<GLvec2, 128> proctex_noise_lut_data{};
-    std::array<GLvec2, 128> proctex_color_map_data{};
-    std::array<GLvec2, 128> proctex_alpha_map_data{};
-    std::array<GLvec4, 256> proctex_lut_data{};
-    std::array<GLvec4, 256> proctex_diff_lut_data{};
+    /**
+     * Converted copy of a LUT with the range of entries written since it was last synced. The
+     * offsets of its last few contents in the texture buffer are kept, so LUTs that games switch
+     * between aren't uploaded again.
+     */
+    template <typename T, std::size_t N>
+    struct LUTData {
+        static constexpr std::size_t NUM_UPLOADS = 4;
+
+        /// Marks the entry written before the LUT index register was advanced to next_index
+        void MarkWritten(u32 next_index) {
+            const std::size_t index = (next_index + N - 1) % N;
+            dirty_begin = std::min(dirty_begin, index);
+            dirty_end = std::max(dirty_end, index + 1);
+        }
+
+        bool IsDirty() const {
+            return dirty_begin < dirty_end;
+        }
+
+        std::array<T, N> data{};
+        std::size_t dirty_begin = 0;
+        std::size_t dirty_end = N;
+
+        /// Content hash and offset of the last uploads, they are dropped when the buffer wraps
+        std::array<std::pair<u64, GLint>, NUM_UPLOADS> uploads{};
+        std::size_t num_uploads = 0;
+        std::size_t next_upload = 0;
+    };
+
+    std::array<LUTData<GLvec2, 256>, Pica::LightingRegs::NumLightingSampler> lighting_luts;
+    LUTData<GLvec2, 128> fog_lut;
+    LUTData<GLvec2, 128> proctex_noise_lut;
+    LUTData<GLvec2, 128> proctex_color_map;
+    LUTData<GLvec2, 128> proctex_alpha_map;
+    LUTData<GLvec4, 256> proctex_lut;
+    LUTData<GLvec4, 256> proctex_diff_lut;
 
     bool allow_shadow;
+    bool skip_frame = false;
 };
 
 } // namespace OpenGL
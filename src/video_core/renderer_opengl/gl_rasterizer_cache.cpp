@@ -17,6 +17,7 @@
 #include "common/alignment.h"
 #include "common/bit_field.h"
 #include "common/color.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
@@ -28,9 +29,12 @@
 #include "core/frontend/emu_window.h"
 #include "core/hle/kernel/process.h"
 #include "core/memory.h"
+#include "core/perf_metrics.h"
 #include "core/settings.h"
+#include "video_core/morton_copy.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_opengl/gl_gpu_profiler.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_state.h"
 #include "video_core/renderer_opengl/gl_vars.h"
@@ -43,6 +47,13 @@ namespace OpenGL {
 using SurfaceType = SurfaceParams::SurfaceType;
 using PixelFormat = SurfaceParams::PixelFormat;
 
+// Surfaces the CPU read back at least this often get downloaded before they are flushed
+constexpr u32 READBACK_COUNT_THRESHOLD = 2;
+constexpr u32 READBACK_COUNT_MAX = 8;
+
+// Holds the uploads of a few frames, larger textures are uploaded straight from gl_buffer
+constexpr std::size_t UPLOAD_BUFFER_SIZE = 32 * 1024 * 1024;
+
 static constexpr std::array<FormatTuple, 5> fb_format_tuples = {{
     {GL_RGBA8, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8},     // RGBA8
     {GL_RGB8, GL_BGR, GL_UNSIGNED_BYTE},              // RGB8
@@ -168,37 +179,24 @@ template <bool morton_to_gl, PixelFormat format>
 static void MortonCopyTile(u32 stride, u8* tile_buffer, u8* gl_buffer) {
     constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
     constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
-    for (u32 y = 0; y < 8; ++y) {
-        for (u32 x = 0; x < 8; ++x) {
-            u8* tile_ptr = tile_buffer + VideoCore::MortonInterleave(x, y) * bytes_per_pixel;
-            u8* gl_ptr = gl_buffer + ((7 - y) * stride + x) * gl_bytes_per_pixel;
-            if (morton_to_gl) {
-                if (format == PixelFormat::D24S8) {
-                    gl_ptr[0] = tile_ptr[3];
-                    std::memcpy(gl_ptr + 1, tile_ptr, 3);
-                } else if (format == PixelFormat::RGBA8 && GLES) {
-                    // because GLES does not have ABGR format
-                    // so we will do byteswapping here
-                    gl_ptr[0] = tile_ptr[3];
-                    gl_ptr[1] = tile_ptr[2];
-                    gl_ptr[2] = tile_ptr[1];
-                    gl_ptr[3] = tile_ptr[0];
-                } else if (format == PixelFormat::RGB8 && GLES) {
-                    gl_ptr[0] = tile_ptr[2];
-                    gl_ptr[1] = tile_ptr[1];
-                    gl_ptr[2] = tile_ptr[0];
-                } else {
-                    std::memcpy(gl_ptr, tile_ptr, bytes_per_pixel);
-                }
-            } else {
-                if (format == PixelFormat::D24S8) {
-                    std::memcpy(tile_ptr, gl_ptr + 1, 3);
-                    tile_ptr[3] = gl_ptr[0];
-                } else {
-                    std::memcpy(tile_ptr, gl_ptr, bytes_per_pixel);
-                }
-            }
+    using VideoCore::MortonConversion;
+    if constexpr (format == PixelFormat::D24S8) {
+        VideoCore::MortonCopyTile<morton_to_gl, bytes_per_pixel, gl_bytes_per_pixel,
+                                  MortonConversion::RotateD24S8>(stride, tile_buffer, gl_buffer);
+    } else if constexpr (morton_to_gl &&
+                         (format == PixelFormat::RGBA8 || format == PixelFormat::RGB8)) {
+        // because GLES does not have ABGR format
+        // so we will do byteswapping here
+        if (GLES) {
+            VideoCore::MortonCopyTile<true, bytes_per_pixel, gl_bytes_per_pixel,
+                                      MortonConversion::ByteSwap>(stride, tile_buffer, gl_buffer);
+        } else {
+            VideoCore::MortonCopyTile<true, bytes_per_pixel, gl_bytes_per_pixel,
+                                      MortonConversion::None>(stride, tile_buffer, gl_buffer);
         }
+    } else {
+        VideoCore::MortonCopyTile<morton_to_gl, bytes_per_pixel, gl_bytes_per_pixel,
+                                  MortonConversion::None>(stride, tile_buffer, gl_buffer);
     }
 }
 
@@ -418,6 +416,28 @@ static bool BlitTextures(GLuint src_tex, const Common::Rectangle<u32>& src_rect,
     return true;
 }
 
+/**
+ * Copies a rectangle between surfaces with glCopyImageSubData if both textures have the same
+ * format and the rectangles the same size. Unlike a blit this binds no framebuffers.
+ * @return false if the copy isn't possible this way, in which case nothing was done
+ */
+static bool CopyTextureImage(const CachedSurface& src_surface,
+                             const Common::Rectangle<u32>& src_rect,
+                             const CachedSurface& dst_surface,
+                             const Common::Rectangle<u32>& dst_rect) {
+    if (GLES || !GLAD_GL_ARB_copy_image || src_surface.pixel_format != dst_surface.pixel_format ||
+        src_surface.is_custom || dst_surface.is_custom || src_surface.is_compressed ||
+        dst_surface.is_compressed || src_rect.GetWidth() != dst_rect.GetWidth() ||
+        src_rect.GetHeight() != dst_rect.GetHeight())
+        return false;
+
+    glCopyImageSubData(src_surface.texture.handle, GL_TEXTURE_2D, 0, src_rect.left,
+                       src_rect.bottom, 0, dst_surface.texture.handle, GL_TEXTURE_2D, 0,
+                       dst_rect.left, dst_rect.bottom, 0, src_rect.GetWidth(),
+                       src_rect.GetHeight(), 1);
+    return true;
+}
+
 static bool FillSurface(const Surface& surface, const u8* fill_data,
                         const Common::Rectangle<u32>& fill_rect, GLuint draw_fb_handle) {
     OpenGLState prev_state = OpenGLState::GetCurState();
@@ -720,14 +740,25 @@ void RasterizerCacheOpenGL::CopySurface(const Surface& src_surface, const Surfac
         return;
     }
     if (src_surface->CanSubRect(subrect_params)) {
-        BlitTextures(src_surface->texture.handle, src_surface->GetScaledSubRect(subrect_params),
-                     dst_surface->texture.handle, dst_surface->GetScaledSubRect(subrect_params),
-                     src_surface->type, read_framebuffer.handle, draw_framebuffer.handle);
+        const auto src_rect = src_surface->GetScaledSubRect(subrect_params);
+        const auto dst_rect = dst_surface->GetScaledSubRect(subrect_params);
+        if (!CopyTextureImage(*src_surface, src_rect, *dst_surface, dst_rect)) {
+            BlitTextures(src_surface->texture.handle, src_rect, dst_surface->texture.handle,
+                         dst_rect, src_surface->type, read_framebuffer.handle,
+                         draw_framebuffer.handle);
+        }
         return;
     }
     UNREACHABLE();
 }
 
+void CachedSurface::AcquireGLBuffer(StagingPool& staging_pool) {
+    gl_buffer = staging_pool.Acquire(width * height * GetGLBytesPerPixel(pixel_format));
+    // Dumping and replacing textures hashes the whole buffer, not only the loaded region
+    if (Settings::values.dump_textures || Settings::values.custom_textures)
+        std::memset(gl_buffer.data(), 0, gl_buffer.size());
+}
+
 MICROPROFILE_DEFINE(OpenGL_SurfaceLoad, "OpenGL", "Surface Load", MP_RGB(128, 192, 64));
 void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
     ASSERT(type != SurfaceType::Fill);
@@ -738,9 +769,7 @@ void CachedSurface::LoadGLBuffer(PAddr load_start, PAddr load_end) {
     if (texture_src_data == nullptr)
         return;
 
-    if (gl_buffer.empty()) {
-        gl_buffer.resize(width * height * GetGLBytesPerPixel(pixel_format));
-    }
+    ASSERT(gl_buffer.size() == width * height * GetGLBytesPerPixel(pixel_format));
 
     // TODO: Should probably be done in ::Memory:: and check for other regions too
     if (load_start < Memory::VRAM_VADDR_END && load_end > Memory::VRAM_VADDR_END)
@@ -811,7 +840,8 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
     if (dst_buffer == nullptr)
         return;
 
-    ASSERT(gl_buffer.size() == width * height * GetGLBytesPerPixel(pixel_format));
+    ASSERT(type == SurfaceType::Fill ||
+           gl_buffer.size() == width * height * GetGLBytesPerPixel(pixel_format));
 
     // TODO: Should probably be done in ::Memory:: and check for other regions too
     // same as loadglbuffer()
@@ -822,6 +852,7 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
         flush_start = Memory::VRAM_VADDR;
 
     MICROPROFILE_SCOPE(OpenGL_SurfaceFlush);
+    Core::Metrics::Add(Core::Metrics::Counter::BytesFlushed, flush_end - flush_start);
 
     ASSERT(flush_start >= addr && flush_end <= end);
     const u32 start_offset = flush_start - addr;
@@ -851,42 +882,34 @@ void CachedSurface::FlushGLBuffer(PAddr flush_start, PAddr flush_end) {
 }
 
 bool CachedSurface::LoadCustomTexture(u64 tex_hash, Core::CustomTexInfo& tex_info) {
-    bool result = false;
     auto& custom_tex_cache = Core::System::GetInstance().CustomTexCache();
-    const auto& image_interface = Core::System::GetInstance().GetImageInterface();
 
-    if (custom_tex_cache.IsTextureCached(tex_hash)) {
-        tex_info = custom_tex_cache.LookupTexture(tex_hash);
-        result = true;
-    } else {
-        if (custom_tex_cache.CustomTextureExists(tex_hash)) {
-            const auto& path_info = custom_tex_cache.LookupTexturePathInfo(tex_hash);
-            if (image_interface->DecodePNG(tex_info.tex, tex_info.width, tex_info.height,
-                                           path_info.path)) {
-                std::bitset<32> width_bits(tex_info.width);
-                std::bitset<32> height_bits(tex_info.height);
-                if (width_bits.count() == 1 && height_bits.count() == 1) {
-                    LOG_DEBUG(Render_OpenGL, "Loaded custom texture from {}", path_info.path);
-                    Common::FlipRGBA8Texture(tex_info.tex, tex_info.width, tex_info.height);
-                    custom_tex_cache.CacheTexture(tex_hash, tex_info.tex, tex_info.width,
-                                                  tex_info.height);
-                    result = true;
-                } else {
-                    LOG_ERROR(Render_OpenGL, "Texture {} size is not a power of 2", path_info.path);
-                }
-            } else {
-                LOG_ERROR(Render_OpenGL, "Failed to load custom texture {}", path_info.path);
-            }
+    if (!custom_tex_cache.IsTextureCached(tex_hash)) {
+        if (!custom_tex_cache.CustomTextureExists(tex_hash))
+            return false;
+
+        // Only textures can be reloaded at any time, as they are never rendered to. Until the
+        // replacement is decoded the texture from emulated memory is used.
+        if (Settings::values.async_custom_loading && type == SurfaceType::Texture) {
+            custom_tex_cache.RequestTexture(tex_hash);
+            pending_custom_hash = tex_hash;
+            return false;
         }
+        if (!custom_tex_cache.LoadTexture(tex_hash))
+            return false;
     }
 
-    return result;
+    tex_info = custom_tex_cache.LookupTexture(tex_hash);
+    pending_custom_hash = 0;
+    return true;
 }
 
-void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
+void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash, TextureDumper& texture_dumper) {
     // Dump texture to RGBA8 and encode as PNG
-    const auto& image_interface = Core::System::GetInstance().GetImageInterface();
     auto& custom_tex_cache = Core::System::GetInstance().CustomTexCache();
+    if (custom_tex_cache.IsTextureDumped(tex_hash))
+        return;
+
     std::string dump_path =
         fmt::format("{}textures/{:016X}/", FileUtil::GetUserPath(FileUtil::UserPath::DumpDir),
                     Core::System::GetInstance().Kernel().GetCurrentProcess()->codeset->program_id);
@@ -897,42 +920,21 @@ void CachedSurface::DumpTexture(GLuint target_tex, u64 tex_hash) {
 
     dump_path += fmt::format("tex1_{}x{}_{:016X}_{}.png", width, height, tex_hash,
                              static_cast<u32>(pixel_format));
-    if (!custom_tex_cache.IsTextureDumped(tex_hash) && !FileUtil::Exists(dump_path)) {
-        custom_tex_cache.SetTextureDumped(tex_hash);
-
-        LOG_INFO(Render_OpenGL, "Dumping texture to {}", dump_path);
-        std::vector<u8> decoded_texture;
-        decoded_texture.resize(width * height * 4);
-        glBindTexture(GL_TEXTURE_2D, target_tex);
-        /*
-           GetTexImageOES is used even if not using OpenGL ES to work around a small issue that
-           happens if using custom textures with texture dumping at the same.
-           Let's say there's 2 textures that are both 32x32 and one of them gets replaced with a
-           higher quality 256x256 texture. If the 256x256 texture is displayed first and the 32x32
-           texture gets uploaded to the same underlying OpenGL texture, the 32x32 texture will
-           appear in the corner of the 256x256 texture.
-           If texture dumping is enabled and the 32x32 is undumped, Citra will attempt to dump it.
-           Since the underlying OpenGL texture is still 256x256, Citra crashes because it thinks the
-           texture is only 32x32.
-           GetTexImageOES conveniently only dumps the specified region, and works on both
-           desktop and ES.
-        */
-        GetTexImageOES(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, height, width, 0,
-                       &decoded_texture[0], decoded_texture.size());
-        glBindTexture(GL_TEXTURE_2D, 0);
-        Common::FlipRGBA8Texture(decoded_texture, width, height);
-        if (!image_interface->EncodePNG(dump_path, decoded_texture, width, height))
-            LOG_ERROR(Render_OpenGL, "Failed to save decoded texture");
-    }
+    custom_tex_cache.SetTextureDumped(tex_hash);
+    if (!FileUtil::Exists(dump_path))
+        texture_dumper.Dump(target_tex, width, height, std::move(dump_path));
 }
 
 MICROPROFILE_DEFINE(OpenGL_TextureUL, "OpenGL", "Texture Upload", MP_RGB(128, 192, 64));
 void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_handle,
-                                    GLuint draw_fb_handle) {
+                                    GLuint draw_fb_handle, OGLStreamBuffer& upload_buffer,
+                                    TextureDumper& texture_dumper) {
     if (type == SurfaceType::Fill)
         return;
 
     MICROPROFILE_SCOPE(OpenGL_TextureUL);
+    GPUProfiler::Scope gpu_scope{GPUProfiler::Pass::Upload};
+    Core::Metrics::Add(Core::Metrics::Counter::TextureUploads);
 
     ASSERT(gl_buffer.size() == width * height * GetGLBytesPerPixel(pixel_format));
 
@@ -995,7 +997,7 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_
 
         glActiveTexture(GL_TEXTURE0);
         glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, custom_tex_info.width, custom_tex_info.height,
-                        GL_RGBA, GL_UNSIGNED_BYTE, custom_tex_info.tex.data());
+                        GL_RGBA, GL_UNSIGNED_BYTE, custom_tex_info.GetData());
     } else if (texture_filter) {
         if (res_scale == default_scale) {
             AllocateSurfaceTexture(texture.handle, GetFormatTuple(pixel_format),
@@ -1004,20 +1006,43 @@ void CachedSurface::UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_
             cur_state.texture_units[0].texture_2d = texture.handle;
             cur_state.Apply();
         }
-        texture_filter->scale(*this, {(u32)x0, (u32)y0, rect.GetWidth(), rect.GetHeight()},
-                              buffer_offset);
+        GPUProfiler::Scope filter_scope{GPUProfiler::Pass::TextureFilter};
+        TextureFilterManager::GetInstance().GetCache().Scale(
+            *texture_filter, *this, {(u32)x0, (u32)y0, rect.GetWidth(), rect.GetHeight()},
+            buffer_offset, read_fb_handle, draw_fb_handle);
     } else {
         glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(stride));
 
+        // From a pixel buffer the driver can copy the data to the texture asynchronously, from
+        // gl_buffer it has to copy it before returning and may wait for the texture to be unused
+        const void* pixels = &gl_buffer[buffer_offset];
+        const std::size_t upload_size =
+            rect.GetHeight() == 0 ? 0
+                                  : ((rect.GetHeight() - 1) * stride + rect.GetWidth()) *
+                                        GetGLBytesPerPixel(pixel_format);
+        const bool use_upload_buffer =
+            upload_size > 0 && upload_size <= static_cast<std::size_t>(upload_buffer.GetSize());
+        if (use_upload_buffer) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload_buffer.GetHandle());
+            u8* upload_ptr;
+            GLintptr upload_offset;
+            std::tie(upload_ptr, upload_offset, std::ignore) =
+                upload_buffer.Map(static_cast<GLsizeiptr>(upload_size), 4);
+            std::memcpy(upload_ptr, pixels, upload_size);
+            upload_buffer.Unmap(static_cast<GLsizeiptr>(upload_size));
+            pixels = reinterpret_cast<const void*>(upload_offset);
+        }
+
         glActiveTexture(GL_TEXTURE0);
         glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, static_cast<GLsizei>(rect.GetWidth()),
-                        static_cast<GLsizei>(rect.GetHeight()), tuple.format, tuple.type,
-                        &gl_buffer[buffer_offset]);
+                        static_cast<GLsizei>(rect.GetHeight()), tuple.format, tuple.type, pixels);
+        if (use_upload_buffer)
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     }
 
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     if (Settings::values.dump_textures && !is_custom && !texture_filter)
-        DumpTexture(target_tex, tex_hash);
+        DumpTexture(target_tex, tex_hash, texture_dumper);
 
     cur_state.texture_units[0].texture_2d = old_tex;
     cur_state.Apply();
@@ -1045,11 +1070,18 @@ void CachedSurface::DownloadGLTexture(const Common::Rectangle<u32>& rect, GLuint
         return;
 
     MICROPROFILE_SCOPE(OpenGL_TextureDL);
+    GPUProfiler::Scope gpu_scope{GPUProfiler::Pass::Download};
 
-    if (gl_buffer.empty()) {
-        gl_buffer.resize(width * height * GetGLBytesPerPixel(pixel_format));
-    }
+    ASSERT(gl_buffer.size() == width * height * GetGLBytesPerPixel(pixel_format));
 
+    const std::size_t buffer_offset =
+        (rect.bottom * stride + rect.left) * GetGLBytesPerPixel(pixel_format);
+    ReadGLTexture(rect, read_fb_handle, draw_fb_handle, &gl_buffer[buffer_offset],
+                  gl_buffer.size() - buffer_offset);
+}
+
+void CachedSurface::ReadGLTexture(const Common::Rectangle<u32>& rect, GLuint read_fb_handle,
+                                  GLuint draw_fb_handle, u8* dst, std::size_t dst_size) {
     OpenGLState state = OpenGLState::GetCurState();
     OpenGLState prev_state = state;
     SCOPE_EXIT({ prev_state.Apply(); });
@@ -1059,8 +1091,6 @@ void CachedSurface::DownloadGLTexture(const Common::Rectangle<u32>& rect, GLuint
     // Ensure no bad interactions with GL_PACK_ALIGNMENT
     ASSERT(stride * GetGLBytesPerPixel(pixel_format) % 4 == 0);
     glPixelStorei(GL_PACK_ROW_LENGTH, static_cast<GLint>(stride));
-    std::size_t buffer_offset =
-        (rect.bottom * stride + rect.left) * GetGLBytesPerPixel(pixel_format);
 
     // If not 1x scale, blit scaled texture to a new 1x texture and use that to flush
     if (res_scale != 1) {
@@ -1084,10 +1114,9 @@ void CachedSurface::DownloadGLTexture(const Common::Rectangle<u32>& rect, GLuint
         glActiveTexture(GL_TEXTURE0);
         if (GLES) {
             GetTexImageOES(GL_TEXTURE_2D, 0, tuple.format, tuple.type, rect.GetHeight(),
-                           rect.GetWidth(), 0, &gl_buffer[buffer_offset],
-                           gl_buffer.size() - buffer_offset);
+                           rect.GetWidth(), 0, dst, dst_size);
         } else {
-            glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, &gl_buffer[buffer_offset]);
+            glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, dst);
         }
     } else {
         state.ResetTexture(texture.handle);
@@ -1111,7 +1140,7 @@ void CachedSurface::DownloadGLTexture(const Common::Rectangle<u32>& rect, GLuint
         }
         glReadPixels(static_cast<GLint>(rect.left), static_cast<GLint>(rect.bottom),
                      static_cast<GLsizei>(rect.GetWidth()), static_cast<GLsizei>(rect.GetHeight()),
-                     tuple.format, tuple.type, &gl_buffer[buffer_offset]);
+                     tuple.format, tuple.type, dst);
     }
 
     glPixelStorei(GL_PACK_ROW_LENGTH, 0);
@@ -1133,7 +1162,7 @@ constexpr MatchFlags operator|(MatchFlags lhs, MatchFlags rhs) {
 
 /// Get the best surface match (and its match type) for the given flags
 template <MatchFlags find_flags>
-Surface FindMatch(const SurfaceCache& surface_cache, const SurfaceParams& params,
+Surface FindMatch(const SurfaceIndex& surface_index, const SurfaceParams& params,
                   ScaleMatch match_scale_type,
                   std::optional<SurfaceInterval> validate_interval = {}) {
     Surface match_surface = nullptr;
@@ -1141,86 +1170,93 @@ Surface FindMatch(const SurfaceCache& surface_cache, const SurfaceParams& params
     u32 match_scale = 0;
     SurfaceInterval match_interval{};
 
-    for (auto& pair : RangeFromInterval(surface_cache, params.GetInterval())) {
-        for (auto& surface : pair.second) {
-            bool res_scale_matched = match_scale_type == ScaleMatch::Exact
-                                         ? (params.res_scale == surface->res_scale)
-                                         : (params.res_scale <= surface->res_scale);
-            // validity will be checked in GetCopyableInterval
-            bool is_valid =
-                find_flags & MatchFlags::Copy
-                    ? true
-                    : surface->IsRegionValid(validate_interval.value_or(params.GetInterval()));
-
-            if (!(find_flags & MatchFlags::Invalid) && !is_valid)
-                continue;
+    surface_index.ForEachOverlapping(params.GetInterval(), [&](const Surface& surface) {
+        // Compressed textures can't be attached to framebuffers to blit from or render to them
+        if (surface->is_compressed &&
+            (find_flags & ~(MatchFlags::Exact | MatchFlags::Invalid)) != 0)
+            return;
+
+        bool res_scale_matched = match_scale_type == ScaleMatch::Exact
+                                     ? (params.res_scale == surface->res_scale)
+                                     : (params.res_scale <= surface->res_scale);
+        // validity will be checked in GetCopyableInterval
+        bool is_valid =
+            find_flags & MatchFlags::Copy
+                ? true
+                : surface->IsRegionValid(validate_interval.value_or(params.GetInterval()));
+
+        if (!(find_flags & MatchFlags::Invalid) && !is_valid)
+            return;
+
+        auto IsMatch_Helper = [&](auto check_type, auto match_fn) {
+            if (!(find_flags & check_type))
+                return;
+
+            bool matched;
+            SurfaceInterval surface_interval;
+            std::tie(matched, surface_interval) = match_fn();
+            if (!matched)
+                return;
+
+            if (!res_scale_matched && match_scale_type != ScaleMatch::Ignore &&
+                surface->type != SurfaceType::Fill)
+                return;
+
+            // Found a match, update only if this is better than the previous one
+            auto UpdateMatch = [&] {
+                match_surface = surface;
+                match_valid = is_valid;
+                match_scale = surface->res_scale;
+                match_interval = surface_interval;
+            };
 
-            auto IsMatch_Helper = [&](auto check_type, auto match_fn) {
-                if (!(find_flags & check_type))
-                    return;
-
-                bool matched;
-                SurfaceInterval surface_interval;
-                std::tie(matched, surface_interval) = match_fn();
-                if (!matched)
-                    return;
-
-                if (!res_scale_matched && match_scale_type != ScaleMatch::Ignore &&
-                    surface->type != SurfaceType::Fill)
-                    return;
-
-                // Found a match, update only if this is better than the previous one
-                auto UpdateMatch = [&] {
-                    match_surface = surface;
-                    match_valid = is_valid;
-                    match_scale = surface->res_scale;
-                    match_interval = surface_interval;
-                };
-
-                if (surface->res_scale > match_scale) {
-                    UpdateMatch();
-                    return;
-                } else if (surface->res_scale < match_scale) {
-                    return;
-                }
+            if (surface->res_scale > match_scale) {
+                UpdateMatch();
+                return;
+            } else if (surface->res_scale < match_scale) {
+                return;
+            }
 
-                if (is_valid && !match_valid) {
-                    UpdateMatch();
-                    return;
-                } else if (is_valid != match_valid) {
-                    return;
-                }
+            if (is_valid && !match_valid) {
+                UpdateMatch();
+                return;
+            } else if (is_valid != match_valid) {
+                return;
+            }
 
-                if (boost::icl::length(surface_interval) > boost::icl::length(match_interval)) {
-                    UpdateMatch();
-                }
-            };
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Exact>{}, [&] {
-                return std::make_pair(surface->ExactMatch(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::SubRect>{}, [&] {
-                return std::make_pair(surface->CanSubRect(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Copy>{}, [&] {
-                ASSERT(validate_interval);
-                auto copy_interval =
-                    params.FromInterval(*validate_interval).GetCopyableInterval(surface);
-                bool matched = boost::icl::length(copy_interval & *validate_interval) != 0 &&
-                               surface->CanCopy(params, copy_interval);
-                return std::make_pair(matched, copy_interval);
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Expand>{}, [&] {
-                return std::make_pair(surface->CanExpand(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::TexCopy>{}, [&] {
-                return std::make_pair(surface->CanTexCopy(params), surface->GetInterval());
-            });
-        }
-    }
+            if (boost::icl::length(surface_interval) > boost::icl::length(match_interval)) {
+                UpdateMatch();
+            }
+        };
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Exact>{}, [&] {
+            return std::make_pair(surface->ExactMatch(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::SubRect>{}, [&] {
+            return std::make_pair(surface->CanSubRect(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Copy>{}, [&] {
+            ASSERT(validate_interval);
+            auto copy_interval =
+                params.FromInterval(*validate_interval).GetCopyableInterval(surface);
+            bool matched = boost::icl::length(copy_interval & *validate_interval) != 0 &&
+                           surface->CanCopy(params, copy_interval);
+            return std::make_pair(matched, copy_interval);
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Expand>{}, [&] {
+            return std::make_pair(surface->CanExpand(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::TexCopy>{}, [&] {
+            return std::make_pair(surface->CanTexCopy(params), surface->GetInterval());
+        });
+    });
     return match_surface;
 }
 
-RasterizerCacheOpenGL::RasterizerCacheOpenGL() {
+RasterizerCacheOpenGL::RasterizerCacheOpenGL()
+    : upload_buffer(GL_PIXEL_UNPACK_BUFFER, UPLOAD_BUFFER_SIZE, false) {
+    // Texture uploads from client memory need the unpack buffer to be unbound
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
     read_framebuffer.Create();
     draw_framebuffer.Create();
 
@@ -1272,8 +1308,8 @@ void main() {
 
 RasterizerCacheOpenGL::~RasterizerCacheOpenGL() {
     FlushAll();
-    while (!surface_cache.empty())
-        UnregisterSurface(*surface_cache.begin()->second.begin());
+    for (const auto& surface : surface_index.GetAll())
+        UnregisterSurface(surface);
 }
 
 MICROPROFILE_DEFINE(OpenGL_BlitSurface, "OpenGL", "BlitSurface", MP_RGB(128, 192, 64));
@@ -1288,6 +1324,9 @@ bool RasterizerCacheOpenGL::BlitSurfaces(const Surface& src_surface,
 
     dst_surface->InvalidateAllWatcher();
 
+    if (CopyTextureImage(*src_surface, src_rect, *dst_surface, dst_rect))
+        return true;
+
     return BlitTextures(src_surface->texture.handle, src_rect, dst_surface->texture.handle,
                         dst_rect, src_surface->type, read_framebuffer.handle,
                         draw_framebuffer.handle);
@@ -1363,7 +1402,9 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatc
 
     // Check for an exact match in existing surfaces
     Surface surface =
-        FindMatch<MatchFlags::Exact | MatchFlags::Invalid>(surface_cache, params, match_res_scale);
+        FindMatch<MatchFlags::Exact | MatchFlags::Invalid>(surface_index, params, match_res_scale);
+    Core::Metrics::Add(surface != nullptr ? Core::Metrics::Counter::SurfaceCacheHits
+                                          : Core::Metrics::Counter::SurfaceCacheMisses);
 
     if (surface == nullptr) {
         u16 target_res_scale = params.res_scale;
@@ -1372,7 +1413,7 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatc
             // it to adjust our params
             SurfaceParams find_params = params;
             Surface expandable = FindMatch<MatchFlags::Expand | MatchFlags::Invalid>(
-                surface_cache, find_params, match_res_scale);
+                surface_index, find_params, match_res_scale);
             if (expandable != nullptr && expandable->res_scale > target_res_scale) {
                 target_res_scale = expandable->res_scale;
             }
@@ -1380,7 +1421,7 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatc
             if (params.pixel_format == PixelFormat::RGBA8) {
                 find_params.pixel_format = PixelFormat::D24S8;
                 expandable = FindMatch<MatchFlags::Expand | MatchFlags::Invalid>(
-                    surface_cache, find_params, match_res_scale);
+                    surface_index, find_params, match_res_scale);
                 if (expandable != nullptr && expandable->res_scale > target_res_scale) {
                     target_res_scale = expandable->res_scale;
                 }
@@ -1396,6 +1437,7 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatc
         ValidateSurface(surface, params.addr, params.size);
     }
 
+    surface->last_access_frame = VideoCore::g_renderer->GetCurrentFrame();
     return surface;
 }
 
@@ -1407,15 +1449,17 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
     }
 
     // Attempt to find encompassing surface
-    Surface surface = FindMatch<MatchFlags::SubRect | MatchFlags::Invalid>(surface_cache, params,
+    Surface surface = FindMatch<MatchFlags::SubRect | MatchFlags::Invalid>(surface_index, params,
                                                                            match_res_scale);
+    Core::Metrics::Add(surface != nullptr ? Core::Metrics::Counter::SurfaceCacheHits
+                                          : Core::Metrics::Counter::SurfaceCacheMisses);
 
     // Check if FindMatch failed because of res scaling
     // If that's the case create a new surface with
     // the dimensions of the lower res_scale surface
     // to suggest it should not be used again
     if (surface == nullptr && match_res_scale != ScaleMatch::Ignore) {
-        surface = FindMatch<MatchFlags::SubRect | MatchFlags::Invalid>(surface_cache, params,
+        surface = FindMatch<MatchFlags::SubRect | MatchFlags::Invalid>(surface_index, params,
                                                                        ScaleMatch::Ignore);
         if (surface != nullptr) {
             SurfaceParams new_params = *surface;
@@ -1436,7 +1480,7 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
 
     // Check for a surface we can expand before creating a new one
     if (surface == nullptr) {
-        surface = FindMatch<MatchFlags::Expand | MatchFlags::Invalid>(surface_cache, aligned_params,
+        surface = FindMatch<MatchFlags::Expand | MatchFlags::Invalid>(surface_index, aligned_params,
                                                                       match_res_scale);
         if (surface != nullptr) {
             aligned_params.width = aligned_params.stride;
@@ -1475,6 +1519,7 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
         ValidateSurface(surface, aligned_params.addr, aligned_params.size);
     }
 
+    surface->last_access_frame = VideoCore::g_renderer->GetCurrentFrame();
     return std::make_tuple(surface, surface->GetScaledSubRect(params));
 }
 
@@ -1504,6 +1549,11 @@ Surface RasterizerCacheOpenGL::GetTextureSurface(const Pica::Texture::TextureInf
                            : 1;
     params.UpdateParams();
 
+    for (DisplaySource& source : display_sources) {
+        if (!boost::icl::is_empty(source.interval & params.GetInterval()))
+            source.used_otherwise = true;
+    }
+
     u32 min_width = info.width >> max_level;
     u32 min_height = info.height >> max_level;
     if (min_width % 8 != 0 || min_height % 8 != 0) {
@@ -1530,6 +1580,7 @@ Surface RasterizerCacheOpenGL::GetTextureSurface(const Pica::Texture::TextureInf
             LOG_CRITICAL(Render_OpenGL, "Unsupported mipmap level {}", max_level);
             return nullptr;
         }
+        UncompressSurface(surface);
         OpenGLState prev_state = OpenGLState::GetCurState();
         OpenGLState state;
         SCOPE_EXIT({ prev_state.Apply(); });
@@ -1585,6 +1636,7 @@ Surface RasterizerCacheOpenGL::GetTextureSurface(const Pica::Texture::TextureInf
 
             if (watcher && !watcher->IsValid()) {
                 auto level_surface = watcher->Get();
+                UncompressSurface(level_surface);
                 if (!level_surface->invalid_regions.empty()) {
                     ValidateSurface(level_surface, level_surface->addr, level_surface->size);
                 }
@@ -1670,6 +1722,13 @@ const CachedTextureCube& RasterizerCacheOpenGL::GetTextureCube(const TextureCube
             cube.res_scale * config.width);
     }
 
+    // Usually all faces are still valid, which needs no state changes at all
+    if (std::none_of(faces.begin(), faces.end(), [](const Face& face) {
+            return face.watcher && !face.watcher->IsValid();
+        })) {
+        return cube;
+    }
+
     u32 scaled_size = cube.res_scale * config.width;
 
     OpenGLState prev_state = OpenGLState::GetCurState();
@@ -1680,12 +1739,31 @@ const CachedTextureCube& RasterizerCacheOpenGL::GetTextureCube(const TextureCube
     state.draw.draw_framebuffer = draw_framebuffer.handle;
     state.ResetTexture(cube.texture.handle);
 
-    for (const Face& face : faces) {
+    const bool can_copy_image = !GLES && GLAD_GL_ARB_copy_image;
+    const auto cube_format = CachedSurface::PixelFormatFromTextureFormat(config.format);
+
+    for (std::size_t face_index = 0; face_index < faces.size(); ++face_index) {
+        const Face& face = faces[face_index];
         if (face.watcher && !face.watcher->IsValid()) {
             auto surface = face.watcher->Get();
+            UncompressSurface(surface);
             if (!surface->invalid_regions.empty()) {
                 ValidateSurface(surface, surface->addr, surface->size);
             }
+
+            // Faces of the same size and format are copied directly, which unlike a blit doesn't
+            // need the framebuffers to be set up for every face
+            auto src_rect = surface->GetScaledRect();
+            if (can_copy_image && !surface->is_custom && surface->pixel_format == cube_format &&
+                src_rect.GetWidth() == scaled_size && src_rect.GetHeight() == scaled_size) {
+                glCopyImageSubData(surface->texture.handle, GL_TEXTURE_2D, 0, src_rect.left,
+                                   src_rect.bottom, 0, cube.texture.handle, GL_TEXTURE_CUBE_MAP, 0,
+                                   0, 0, static_cast<GLint>(face_index), scaled_size, scaled_size,
+                                   1);
+                face.watcher->Validate();
+                continue;
+            }
+
             state.ResetTexture(surface->texture.handle);
             state.Apply();
             glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
@@ -1698,7 +1776,6 @@ const CachedTextureCube& RasterizerCacheOpenGL::GetTextureCube(const TextureCube
             glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
                                    0, 0);
 
-            auto src_rect = surface->GetScaledRect();
             glBlitFramebuffer(src_rect.left, src_rect.bottom, src_rect.right, src_rect.top, 0, 0,
                               scaled_size, scaled_size, GL_COLOR_BUFFER_BIT, GL_LINEAR);
             face.watcher->Validate();
@@ -1720,11 +1797,15 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
         TextureFilterManager::GetInstance().Reset();
         resolution_scale_factor = VideoCore::GetResolutionScaleFactor();
         FlushAll();
-        while (!surface_cache.empty())
-            UnregisterSurface(*surface_cache.begin()->second.begin());
+        for (const auto& surface : surface_index.GetAll())
+            UnregisterSurface(surface);
         texture_cube_cache.clear();
     }
 
+    EnforceMemoryBudget();
+    UpdateCustomTextures();
+    texture_dumper.Poll();
+
     Common::Rectangle<u32> viewport_clamped{
         static_cast<u32>(std::clamp(viewport_rect.left, 0, static_cast<s32>(config.GetWidth()))),
         static_cast<u32>(std::clamp(viewport_rect.top, 0, static_cast<s32>(config.GetHeight()))),
@@ -1735,7 +1816,9 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
     // get color and depth surfaces
     SurfaceParams color_params;
     color_params.is_tiled = true;
-    color_params.res_scale = resolution_scale_factor;
+    // The dynamic resolution can lower the scale, existing surfaces are copied to the new scale
+    // when they are drawn to
+    color_params.res_scale = VideoCore::GetRenderTargetScaleFactor();
     color_params.width = config.GetWidth();
     color_params.height = config.GetHeight();
     SurfaceParams depth_params = color_params;
@@ -1751,6 +1834,42 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
     auto color_vp_interval = color_params.GetSubRectInterval(viewport_clamped);
     auto depth_vp_interval = depth_params.GetSubRectInterval(viewport_clamped);
 
+    // Consecutive draws mostly keep the framebuffer, e.g. all draws of one eye in stereo mode. The
+    // surfaces of the last lookup are still the ones it would find if no surface was added or
+    // removed since, and they need no validation as long as nothing else wrote to them.
+    const auto same_framebuffer = [&](const FramebufferLookup& last) {
+        return last.generation == registration_generation &&
+               last.using_color_fb == using_color_fb && last.using_depth_fb == using_depth_fb &&
+               last.color_addr == color_params.addr && last.depth_addr == depth_params.addr &&
+               last.color_format == color_params.pixel_format &&
+               last.depth_format == depth_params.pixel_format &&
+               last.width == color_params.width && last.height == color_params.height &&
+               last.res_scale == color_params.res_scale &&
+               last.viewport.left == viewport_clamped.left &&
+               last.viewport.top == viewport_clamped.top &&
+               last.viewport.right == viewport_clamped.right &&
+               last.viewport.bottom == viewport_clamped.bottom;
+    };
+    if (last_framebuffer && same_framebuffer(*last_framebuffer)) {
+        const auto& [color_surface, depth_surface, fb_rect] = last_framebuffer->result;
+        if ((color_surface == nullptr ||
+             color_surface->IsRegionValid(last_framebuffer->color_interval)) &&
+            (depth_surface == nullptr ||
+             depth_surface->IsRegionValid(last_framebuffer->depth_interval))) {
+            if (color_surface != nullptr)
+                color_surface->InvalidateAllWatcher();
+            if (depth_surface != nullptr)
+                depth_surface->InvalidateAllWatcher();
+            ++stats.framebuffer_reuses;
+            return last_framebuffer->result;
+        }
+    }
+    FramebufferLookup lookup{color_params.addr,         depth_params.addr,
+                             color_params.pixel_format, depth_params.pixel_format,
+                             color_params.width,        color_params.height,
+                             color_params.res_scale,    viewport_clamped,
+                             using_color_fb,            using_depth_fb};
+
     // Make sure that framebuffers don't overlap if both color and depth are being used
     if (using_color_fb && using_depth_fb &&
         boost::icl::length(color_vp_interval & depth_vp_interval)) {
@@ -1798,7 +1917,24 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
         depth_surface->InvalidateAllWatcher();
     }
 
-    return std::make_tuple(color_surface, depth_surface, fb_rect);
+    // Rendering to the previous framebuffer is done once the game switches away from it
+    if (color_surface != last_color_surface) {
+        if (last_color_surface != nullptr)
+            StartReadback(last_color_surface);
+        last_color_surface = color_surface;
+    }
+    if (depth_surface != last_depth_surface) {
+        if (last_depth_surface != nullptr)
+            StartReadback(last_depth_surface);
+        last_depth_surface = depth_surface;
+    }
+
+    lookup.generation = registration_generation;
+    lookup.result = std::make_tuple(color_surface, depth_surface, fb_rect);
+    lookup.color_interval = color_vp_interval;
+    lookup.depth_interval = depth_vp_interval;
+    last_framebuffer = lookup;
+    return lookup.result;
 }
 
 Surface RasterizerCacheOpenGL::GetFillSurface(const GPU::Regs::MemoryFillConfig& config) {
@@ -1827,7 +1963,7 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetTexCopySurface(const SurfaceParams&
     Common::Rectangle<u32> rect{};
 
     Surface match_surface = FindMatch<MatchFlags::TexCopy | MatchFlags::Invalid>(
-        surface_cache, params, ScaleMatch::Ignore);
+        surface_index, params, ScaleMatch::Ignore);
 
     if (match_surface != nullptr) {
         ValidateSurface(match_surface, params.addr, params.size);
@@ -1859,6 +1995,8 @@ void RasterizerCacheOpenGL::DuplicateSurface(const Surface& src_surface,
 
     dest_surface->invalid_regions -= src_surface->GetInterval();
     dest_surface->invalid_regions += src_surface->invalid_regions;
+    dest_surface->pending_readback.reset();
+    dest_surface->upload_hash = 0;
 
     SurfaceRegions regions;
     for (auto& pair : RangeFromInterval(dirty_regions, src_surface->GetInterval())) {
@@ -1871,6 +2009,51 @@ void RasterizerCacheOpenGL::DuplicateSurface(const Surface& src_surface,
     }
 }
 
+/// Video memory used by the uncompressed texture of a surface
+static std::size_t GetSurfaceMemoryUsage(const CachedSurface& surface) {
+    if (surface.type == SurfaceType::Fill)
+        return 0;
+    return static_cast<std::size_t>(surface.GetScaledWidth()) * surface.GetScaledHeight() *
+           CachedSurface::GetGLBytesPerPixel(surface.pixel_format);
+}
+
+/// Hashes the emulated memory of a texture surface, returns 0 if it can't be hashed
+static u64 ComputeTextureHash(const CachedSurface& surface) {
+    if (!Settings::values.texture_hash_check || surface.type != SurfaceType::Texture)
+        return 0;
+
+    // Same boundaries as the clamping in LoadGLBuffer
+    if ((surface.addr < Memory::VRAM_VADDR && surface.end > Memory::VRAM_VADDR) ||
+        (surface.addr < Memory::VRAM_VADDR_END && surface.end > Memory::VRAM_VADDR_END))
+        return 0;
+
+    const u8* const data = VideoCore::g_memory->GetPhysicalPointer(surface.addr);
+    if (data == nullptr)
+        return 0;
+
+    // 0 marks textures without a hash
+    return std::max<u64>(Common::ComputeFastHash64(data, surface.size), 1);
+}
+
+/// Returns the format whose memory layout can be reinterpreted as the given format, if any
+static std::optional<PixelFormat> GetReinterpretSourceFormat(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return PixelFormat::D24S8;
+    case PixelFormat::RG8:
+        return PixelFormat::D16;
+    case PixelFormat::D16:
+        return PixelFormat::RG8;
+    case PixelFormat::RGBA4:
+        return PixelFormat::RGB5A1;
+    case PixelFormat::RGB5A1:
+        return PixelFormat::RGBA4;
+    default:
+        return std::nullopt;
+    }
+}
+
+MICROPROFILE_DEFINE(OpenGL_TextureHash, "OpenGL", "Texture Hash", MP_RGB(128, 192, 64));
 void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, PAddr addr, u32 size) {
     if (size == 0)
         return;
@@ -1889,45 +2072,97 @@ void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, PAddr addr,
             break;
 
         const auto interval = *it & validate_interval;
+        surface->modification_tick = ++modification_counter;
         // Look for a valid surface to copy from
         SurfaceParams params = surface->FromInterval(interval);
 
         Surface copy_surface =
-            FindMatch<MatchFlags::Copy>(surface_cache, params, ScaleMatch::Ignore, interval);
-        if (copy_surface != nullptr) {
+            FindMatch<MatchFlags::Copy>(surface_index, params, ScaleMatch::Ignore, interval);
+        if (copy_surface != nullptr && !surface->is_compressed) {
             SurfaceInterval copy_interval = params.GetCopyableInterval(copy_surface);
             CopySurface(copy_surface, surface, copy_interval);
             surface->invalid_regions.erase(copy_interval);
+            surface->upload_hash = 0;
             continue;
         }
 
-        // D24S8 to RGBA8
-        if (surface->pixel_format == PixelFormat::RGBA8) {
-            params.pixel_format = PixelFormat::D24S8;
+        // Reinterpret a surface of another format with the same memory layout
+        const auto source_format = GetReinterpretSourceFormat(surface->pixel_format);
+        if (source_format && !surface->is_compressed) {
+            params.pixel_format = *source_format;
             Surface reinterpret_surface =
-                FindMatch<MatchFlags::Copy>(surface_cache, params, ScaleMatch::Ignore, interval);
-            if (reinterpret_surface != nullptr) {
-                ASSERT(reinterpret_surface->pixel_format == PixelFormat::D24S8);
-
+                FindMatch<MatchFlags::Copy>(surface_index, params, ScaleMatch::Ignore, interval);
+            if (reinterpret_surface != nullptr &&
+                reinterpret_surface->pixel_format == *source_format) {
                 SurfaceInterval convert_interval = params.GetCopyableInterval(reinterpret_surface);
                 SurfaceParams convert_params = surface->FromInterval(convert_interval);
                 auto src_rect = reinterpret_surface->GetScaledSubRect(convert_params);
                 auto dest_rect = surface->GetScaledSubRect(convert_params);
 
-                ConvertD24S8toABGR(reinterpret_surface->texture.handle, src_rect,
-                                   surface->texture.handle, dest_rect);
+                bool converted = format_reinterpreter.Reinterpret(
+                    *reinterpret_surface, src_rect, *surface, dest_rect, draw_framebuffer.handle);
+                if (!converted && *source_format == PixelFormat::D24S8) {
+                    // Without stencil texturing the stencil is read back through a buffer
+                    ConvertD24S8toABGR(reinterpret_surface->texture.handle, src_rect,
+                                       surface->texture.handle, dest_rect);
+                    converted = true;
+                }
 
-                surface->invalid_regions.erase(convert_interval);
-                continue;
+                if (converted) {
+                    surface->invalid_regions.erase(convert_interval);
+                    surface->upload_hash = 0;
+                    continue;
+                }
             }
         }
 
         // Load data from 3DS memory
+        if (surface->is_compressed) {
+            // Compressed textures can't be partially updated, reload them as a whole
+            params = *surface;
+            OGLTexture texture;
+            texture.Create();
+            AllocateSurfaceTexture(texture.handle, GetFormatTuple(surface->pixel_format),
+                                   surface->GetScaledWidth(), surface->GetScaledHeight());
+            surface->texture = std::move(texture);
+            surface->is_compressed = false;
+            stats.memory_usage -= surface->memory_usage;
+            surface->memory_usage = GetSurfaceMemoryUsage(*surface);
+            stats.memory_usage += surface->memory_usage;
+        }
         FlushRegion(params.addr, params.size);
-        surface->LoadGLBuffer(params.addr, params.end);
-        surface->UploadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
-                                 draw_framebuffer.handle);
+
+        // Games often rewrite their textures with the same data, in which case the texture
+        // still holds it from the last load
+        const bool full_load = params.GetInterval() == surface->GetInterval();
+        u64 hash = 0;
+        if (full_load || surface->upload_hash != 0) {
+            MICROPROFILE_SCOPE(OpenGL_TextureHash);
+            hash = ComputeTextureHash(*surface);
+        }
+        if (hash != 0 && surface->upload_hash != 0) {
+            ++stats.upload_hash_checks;
+            if (hash == surface->upload_hash) {
+                ++stats.upload_hash_hits;
+                surface->invalid_regions.erase(params.GetInterval());
+                continue;
+            }
+        }
+
+        GPUProfiler::Scope gpu_scope{GPUProfiler::Pass::Upload};
+        if (!texture_decoder.Decode(*surface, params, draw_framebuffer.handle)) {
+            surface->AcquireGLBuffer(staging_pool);
+            surface->LoadGLBuffer(params.addr, params.end);
+            surface->UploadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
+                                     draw_framebuffer.handle, upload_buffer, texture_dumper);
+            surface->gl_buffer.Release();
+        }
         surface->invalid_regions.erase(params.GetInterval());
+        // After a partial load the texture no longer matches the hashed data
+        surface->upload_hash = full_load ? hash : 0;
+        if (full_load) {
+            CompressSurface(surface);
+        }
     }
 }
 
@@ -1953,20 +2188,101 @@ void RasterizerCacheOpenGL::FlushRegion(PAddr addr, u32 size, Surface flush_surf
 
         if (surface->type != SurfaceType::Fill) {
             SurfaceParams params = surface->FromInterval(interval);
-            surface->DownloadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
-                                       draw_framebuffer.handle);
+            const Common::Rectangle<u32> rect = surface->GetSubRect(params);
+            surface->AcquireGLBuffer(staging_pool);
+            if (!surface_readback.Finish(*surface, rect)) {
+                surface->DownloadGLTexture(rect, read_framebuffer.handle, draw_framebuffer.handle);
+            }
+            surface->readback_count = std::min(surface->readback_count + 1, READBACK_COUNT_MAX);
         }
         surface->FlushGLBuffer(boost::icl::first(interval), boost::icl::last_next(interval));
+        surface->gl_buffer.Release();
         flushed_intervals += interval;
     }
     // Reset dirty regions
     dirty_regions -= flushed_intervals;
+    for (const auto& interval : flushed_intervals)
+        UnmarkCleanPages(interval);
 }
 
 void RasterizerCacheOpenGL::FlushAll() {
     FlushRegion(0, 0xFFFFFFFF);
 }
 
+void RasterizerCacheOpenGL::UnmarkCleanPages(const SurfaceInterval& interval) {
+    const u32 first_page = boost::icl::first(interval) >> Memory::PAGE_BITS;
+    const u32 last_page = (boost::icl::last_next(interval) - 1) >> Memory::PAGE_BITS;
+
+    // Pages are unmarked in runs of consecutive clean pages
+    u32 run_start = first_page;
+    u32 run_length = 0;
+    const auto flush_run = [&] {
+        if (run_length != 0) {
+            VideoCore::g_memory->RasterizerMarkRegionDirty(run_start << Memory::PAGE_BITS,
+                                                           run_length << Memory::PAGE_BITS, false);
+        }
+        run_length = 0;
+    };
+
+    for (u32 page = first_page; page <= last_page; ++page) {
+        const SurfaceInterval page_interval(page << Memory::PAGE_BITS,
+                                            (page + 1) << Memory::PAGE_BITS);
+        if (dirty_regions.find(page_interval) == dirty_regions.end()) {
+            if (run_length == 0)
+                run_start = page;
+            ++run_length;
+        } else {
+            flush_run();
+        }
+    }
+    flush_run();
+}
+
+void RasterizerCacheOpenGL::MarkDisplaySource(const SurfaceParams& params,
+                                              const Surface& surface) {
+    const SurfaceInterval interval = params.GetInterval();
+    const bool read_back = surface->readback_count != 0;
+    for (DisplaySource& source : display_sources) {
+        if (source.interval == interval) {
+            source.used_otherwise |= read_back;
+            return;
+        }
+    }
+    display_sources[next_display_source] = {interval, read_back};
+    next_display_source = (next_display_source + 1) % display_sources.size();
+}
+
+bool RasterizerCacheOpenGL::IsDisplayOnly(PAddr color_addr) const {
+    return std::any_of(display_sources.begin(), display_sources.end(),
+                       [color_addr](const DisplaySource& source) {
+                           return source.interval.lower() == color_addr && !source.used_otherwise;
+                       });
+}
+
+void RasterizerCacheOpenGL::StartReadback(const Surface& surface) {
+    if (!surface_readback.IsSupported() || surface->type == SurfaceType::Fill ||
+        surface->readback_count < READBACK_COUNT_THRESHOLD || surface->pending_readback)
+        return;
+
+    // Download everything the surface has rendered since it was last flushed in one go
+    const SurfaceInterval surface_interval = surface->GetInterval();
+    PAddr dirty_start = surface->end;
+    PAddr dirty_end = surface->addr;
+    for (auto& pair : RangeFromInterval(dirty_regions, surface_interval)) {
+        if (pair.second != surface)
+            continue;
+        const auto interval = pair.first & surface_interval;
+        dirty_start = std::min(dirty_start, boost::icl::first(interval));
+        dirty_end = std::max(dirty_end, boost::icl::last_next(interval));
+    }
+    if (dirty_start >= dirty_end)
+        return;
+
+    const SurfaceParams params = surface->FromInterval(SurfaceInterval(dirty_start, dirty_end));
+    surface_readback.Start(*surface, surface->GetSubRect(params), read_framebuffer.handle,
+                           draw_framebuffer.handle);
+}
+
 void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface& region_owner) {
     if (size == 0)
         return;
@@ -1979,42 +2295,51 @@ void RasterizerCacheOpenGL::InvalidateRegion(PAddr addr, u32 size, const Surface
         // Surfaces can't have a gap
         ASSERT(region_owner->width == region_owner->stride);
         region_owner->invalid_regions.erase(invalid_interval);
+        region_owner->modification_tick = ++modification_counter;
+
+        // A readback that was started but never used was a bad guess
+        if (region_owner->pending_readback) {
+            region_owner->pending_readback.reset();
+            region_owner->readback_count /= 2;
+        }
     }
 
-    for (auto& pair : RangeFromInterval(surface_cache, invalid_interval)) {
-        for (auto& cached_surface : pair.second) {
-            if (cached_surface == region_owner)
-                continue;
+    surface_index.ForEachOverlapping(invalid_interval, [&](const Surface& cached_surface) {
+        if (cached_surface == region_owner)
+            return;
 
-            // If cpu is invalidating this region we want to remove it
-            // to (likely) mark the memory pages as uncached
-            if (region_owner == nullptr && size <= 8) {
-                FlushRegion(cached_surface->addr, cached_surface->size, cached_surface);
-                remove_surfaces.emplace(cached_surface);
-                continue;
-            }
+        // If cpu is invalidating this region we want to remove it
+        // to (likely) mark the memory pages as uncached
+        if (region_owner == nullptr && size <= 8) {
+            FlushRegion(cached_surface->addr, cached_surface->size, cached_surface);
+            remove_surfaces.emplace(cached_surface);
+            return;
+        }
 
-            const auto interval = cached_surface->GetInterval() & invalid_interval;
-            cached_surface->invalid_regions.insert(interval);
-            cached_surface->InvalidateAllWatcher();
+        const auto interval = cached_surface->GetInterval() & invalid_interval;
+        cached_surface->invalid_regions.insert(interval);
+        cached_surface->InvalidateAllWatcher();
+        cached_surface->pending_readback.reset();
 
-            // Remove only "empty" fill surfaces to avoid destroying and recreating OGL textures
-            if (cached_surface->type == SurfaceType::Fill &&
-                cached_surface->IsSurfaceFullyInvalid()) {
-                remove_surfaces.emplace(cached_surface);
-            }
+        // Remove only "empty" fill surfaces to avoid destroying and recreating OGL textures
+        if (cached_surface->type == SurfaceType::Fill &&
+            cached_surface->IsSurfaceFullyInvalid()) {
+            remove_surfaces.emplace(cached_surface);
         }
-    }
+    });
 
-    if (region_owner != nullptr)
+    if (region_owner != nullptr) {
         dirty_regions.set({invalid_interval, region_owner});
-    else
+        VideoCore::g_memory->RasterizerMarkRegionDirty(addr, size, true);
+    } else {
         dirty_regions.erase(invalid_interval);
+        UnmarkCleanPages(invalid_interval);
+    }
 
     for (auto& remove_surface : remove_surfaces) {
         if (remove_surface == region_owner) {
             Surface expanded_surface = FindMatch<MatchFlags::SubRect | MatchFlags::Invalid>(
-                surface_cache, *region_owner, ScaleMatch::Ignore);
+                surface_index, *region_owner, ScaleMatch::Ignore);
             ASSERT(expanded_surface);
 
             if ((region_owner->invalid_regions - expanded_surface->invalid_regions).empty()) {
@@ -2035,7 +2360,6 @@ Surface RasterizerCacheOpenGL::CreateSurface(const SurfaceParams& params) {
 
     surface->texture.Create();
 
-    surface->gl_buffer.resize(0);
     surface->invalid_regions.insert(surface->GetInterval());
     AllocateSurfaceTexture(surface->texture.handle, GetFormatTuple(surface->pixel_format),
                            surface->GetScaledWidth(), surface->GetScaledHeight());
@@ -2048,8 +2372,10 @@ void RasterizerCacheOpenGL::RegisterSurface(const Surface& surface) {
         return;
     }
     surface->registered = true;
-    surface_cache.add({surface->GetInterval(), SurfaceSet{surface}});
-    UpdatePagesCachedCount(surface->addr, surface->size, 1);
+    ++registration_generation;
+    surface->memory_usage = GetSurfaceMemoryUsage(*surface);
+    stats.memory_usage += surface->memory_usage;
+    surface_index.Add(surface);
 }
 
 void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
@@ -2057,11 +2383,141 @@ void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
         return;
     }
     surface->registered = false;
+    // Also releases the surface if it was part of the last framebuffer
+    last_framebuffer.reset();
+    stats.memory_usage -= surface->memory_usage;
+    surface->pending_readback.reset();
+    if (surface == last_color_surface)
+        last_color_surface = nullptr;
+    if (surface == last_depth_surface)
+        last_depth_surface = nullptr;
+    surface_index.Remove(surface);
+}
+
+void RasterizerCacheOpenGL::CompressSurface(const Surface& surface) {
+    // Only textures are never rendered to, and compression only pays off for large textures
+    if (!texture_compressor.IsEnabled() || surface->compression_blocked ||
+        surface->type != SurfaceType::Texture ||
+        (!surface->is_custom && TextureFilterManager::GetInstance().GetTextureFilter() == nullptr))
+        return;
+
+    const std::size_t compressed_size =
+        texture_compressor.Compress(*surface, draw_framebuffer.handle);
+    if (compressed_size == 0)
+        return;
+
+    stats.memory_usage -= surface->memory_usage;
+    surface->memory_usage = compressed_size;
+    stats.memory_usage += surface->memory_usage;
+}
+
+void RasterizerCacheOpenGL::UncompressSurface(const Surface& surface) {
+    if (!surface->is_compressed)
+        return;
+
+    surface->compression_blocked = true;
+    surface->upload_hash = 0;
+    surface->invalid_regions.insert(surface->GetInterval());
+    ValidateSurface(surface, surface->addr, surface->size);
+}
+
+void RasterizerCacheOpenGL::UpdateCustomTextures() {
+    if (!Settings::values.custom_textures)
+        return;
+
+    const std::vector<u64> decoded =
+        Core::System::GetInstance().CustomTexCache().CollectDecodedTextures();
+    if (decoded.empty())
+        return;
+
+    const std::unordered_set<u64> decoded_set(decoded.begin(), decoded.end());
+    for (const auto& surface : surface_index.GetAll()) {
+        if (surface->pending_custom_hash == 0 || !decoded_set.count(surface->pending_custom_hash))
+            continue;
+
+        // The next validation uploads the texture again, this time with its replacement
+        surface->pending_custom_hash = 0;
+        surface->upload_hash = 0;
+        surface->invalid_regions.insert(surface->GetInterval());
+        surface->InvalidateAllWatcher();
+    }
+}
+
+void RasterizerCacheOpenGL::EnforceMemoryBudget() {
+    const std::size_t budget =
+        static_cast<std::size_t>(Settings::values.surface_cache_budget) * 1024 * 1024;
+    if (budget == 0 || stats.memory_usage <= budget)
+        return;
+
+    // Surfaces used in the current frame may still be bound for drawing
+    const int current_frame = VideoCore::g_renderer->GetCurrentFrame();
+    struct Candidate {
+        Surface surface;
+        bool dirty;
+    };
+    std::vector<Candidate> candidates;
+    for (const auto& surface : surface_index.GetAll()) {
+        if (surface->last_access_frame >= current_frame || surface->memory_usage == 0)
+            continue;
+        bool dirty = false;
+        for (const auto& pair : RangeFromInterval(dirty_regions, surface->GetInterval())) {
+            if (pair.second == surface) {
+                dirty = true;
+                break;
+            }
+        }
+        candidates.push_back({surface, dirty});
+    }
+
+    // Evict clean surfaces before the ones that have to be flushed, oldest first
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return std::tie(a.dirty, a.surface->last_access_frame) <
+               std::tie(b.dirty, b.surface->last_access_frame);
+    });
+
+    u64 evicted = 0;
+    u64 evicted_dirty = 0;
+    for (const auto& candidate : candidates) {
+        if (stats.memory_usage <= budget)
+            break;
+        if (candidate.dirty) {
+            FlushRegion(candidate.surface->addr, candidate.surface->size, candidate.surface);
+            ++evicted_dirty;
+        }
+        UnregisterSurface(candidate.surface);
+        ++evicted;
+    }
+
+    stats.evictions += evicted;
+    stats.dirty_evictions += evicted_dirty;
+    LOG_DEBUG(Render_OpenGL, "Evicted {} surfaces ({} dirty), {} MiB of {} MiB in use", evicted,
+              evicted_dirty, stats.memory_usage / (1024 * 1024), budget / (1024 * 1024));
+}
+
+SurfaceIndex::SurfaceIndex() = default;
+SurfaceIndex::~SurfaceIndex() = default;
+
+#ifdef USE_ICL_SURFACE_CACHE
+
+void SurfaceIndex::Add(const Surface& surface) {
+    surface_cache.add({surface->GetInterval(), SurfaceSet{surface}});
+    UpdatePagesCachedCount(surface->addr, surface->size, 1);
+}
+
+void SurfaceIndex::Remove(const Surface& surface) {
     UpdatePagesCachedCount(surface->addr, surface->size, -1);
     surface_cache.subtract({surface->GetInterval(), SurfaceSet{surface}});
 }
 
-void RasterizerCacheOpenGL::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
+std::vector<Surface> SurfaceIndex::GetAll() const {
+    SurfaceSet surfaces;
+    for (const auto& pair : surface_cache) {
+        surfaces.insert(pair.second.begin(), pair.second.end());
+    }
+    return {surfaces.begin(), surfaces.end()};
+}
+
+void SurfaceIndex::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
     const u32 num_pages =
         ((addr + size - 1) >> Memory::PAGE_BITS) - (addr >> Memory::PAGE_BITS) + 1;
     const u32 page_start = addr >> Memory::PAGE_BITS;
@@ -2095,4 +2551,97 @@ void RasterizerCacheOpenGL::UpdatePagesCachedCount(PAddr addr, u32 size, int del
         cached_pages.add({pages_interval, delta});
 }
 
+#else
+
+void SurfaceIndex::Add(const Surface& surface) {
+    const u32 first_page = surface->addr >> PAGE_BITS;
+    const u32 last_page = (surface->end - 1) >> PAGE_BITS;
+
+    // Pages that get their first surface are marked as cached, in runs of consecutive pages
+    u32 run_start = first_page;
+    u32 run_length = 0;
+    const auto flush_run = [&] {
+        if (run_length != 0) {
+            VideoCore::g_memory->RasterizerMarkRegionCached(run_start << PAGE_BITS,
+                                                            run_length << PAGE_BITS, true);
+        }
+        run_length = 0;
+    };
+
+    for (u32 page = first_page; page <= last_page; ++page) {
+        auto& chunk = chunks[page >> CHUNK_BITS];
+        if (!chunk) {
+            chunk = std::make_unique<Chunk>();
+        }
+        Bucket& bucket = (*chunk)[page & ((1 << CHUNK_BITS) - 1)];
+        if (bucket.empty()) {
+            if (run_length == 0)
+                run_start = page;
+            ++run_length;
+        } else {
+            flush_run();
+        }
+        bucket.push_back(surface);
+    }
+    flush_run();
+    ++num_surfaces;
+}
+
+void SurfaceIndex::Remove(const Surface& surface) {
+    // The bucket may hold the last reference to the surface
+    const Surface keep_alive = surface;
+    const u32 first_page = surface->addr >> PAGE_BITS;
+    const u32 last_page = (surface->end - 1) >> PAGE_BITS;
+
+    u32 run_start = first_page;
+    u32 run_length = 0;
+    const auto flush_run = [&] {
+        if (run_length != 0) {
+            VideoCore::g_memory->RasterizerMarkRegionCached(run_start << PAGE_BITS,
+                                                            run_length << PAGE_BITS, false);
+        }
+        run_length = 0;
+    };
+
+    for (u32 page = first_page; page <= last_page; ++page) {
+        auto& chunk = chunks[page >> CHUNK_BITS];
+        ASSERT(chunk);
+        Bucket& bucket = (*chunk)[page & ((1 << CHUNK_BITS) - 1)];
+        const auto it = std::find(bucket.begin(), bucket.end(), keep_alive);
+        ASSERT(it != bucket.end());
+        *it = std::move(bucket.back());
+        bucket.pop_back();
+        if (bucket.empty()) {
+            if (run_length == 0)
+                run_start = page;
+            ++run_length;
+        } else {
+            flush_run();
+        }
+    }
+    flush_run();
+    --num_surfaces;
+}
+
+std::vector<Surface> SurfaceIndex::GetAll() const {
+    std::vector<Surface> surfaces;
+    surfaces.reserve(num_surfaces);
+    const u64 query = ++generation;
+    for (const auto& chunk : chunks) {
+        if (!chunk)
+            continue;
+        for (const Bucket& bucket : *chunk) {
+            for (const Surface& surface : bucket) {
+                if (surface->index_generation != query) {
+                    surface->index_generation = query;
+                    surfaces.push_back(surface);
+                }
+            }
+        }
+    }
+    return surfaces;
+}
+
+#endif
+
 } // namespace OpenGL
@@ -7,8 +7,10 @@
 #include <array>
 #include <list>
 #include <memory>
+#include <optional>
 #include <set>
 #include <tuple>
+#include <vector>
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-local-typedefs"
@@ -19,7 +21,9 @@
 #pragma GCC diagnostic pop
 #endif
 #include <unordered_map>
+#include <boost/container/small_vector.hpp>
 #include <boost/functional/hash.hpp>
+#include <boost/range/iterator_range.hpp>
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/common_funcs.h"
@@ -29,7 +33,14 @@
 #include "core/hw/gpu.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_texturing.h"
+#include "video_core/renderer_opengl/gl_format_reinterpreter.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_staging_pool.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
+#include "video_core/renderer_opengl/gl_surface_readback.h"
+#include "video_core/renderer_opengl/gl_texture_compressor.h"
+#include "video_core/renderer_opengl/gl_texture_decoder.h"
+#include "video_core/renderer_opengl/gl_texture_dumper.h"
 #include "video_core/texture/texture_decode.h"
 
 namespace OpenGL {
@@ -372,6 +383,13 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
 
     bool is_custom = false;
     Core::CustomTexInfo custom_tex_info;
+    /// Hash of the custom texture being decoded for this surface, 0 if none
+    u64 pending_custom_hash = 0;
+
+    /// The texture was replaced by a compressed copy, which can only be sampled
+    bool is_compressed = false;
+    /// Set once the texture had to be used uncompressed, so it isn't compressed again
+    bool compression_blocked = false;
 
     static constexpr unsigned int GetGLBytesPerPixel(PixelFormat format) {
         // OpenGL needs 4 bpp alignment for D24 since using GL_UNSIGNED_INT as type
@@ -382,7 +400,11 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
                          : SurfaceParams::GetFormatBpp(format) / 8;
     }
 
-    std::vector<u8> gl_buffer;
+    /// Host copy of the texture, only borrowed from the staging pool while loading or flushing
+    StagingPool::Buffer gl_buffer;
+
+    /// Borrows gl_buffer for the whole surface, the cache releases it after the transfer
+    void AcquireGLBuffer(StagingPool& staging_pool);
 
     // Read/Write data in 3DS memory to/from gl_buffer
     void LoadGLBuffer(PAddr load_start, PAddr load_end);
@@ -390,13 +412,35 @@ struct CachedSurface : SurfaceParams, std::enable_shared_from_this<CachedSurface
 
     // Custom texture loading and dumping
     bool LoadCustomTexture(u64 tex_hash, Core::CustomTexInfo& tex_info);
-    void DumpTexture(GLuint target_tex, u64 tex_hash);
+    void DumpTexture(GLuint target_tex, u64 tex_hash, TextureDumper& texture_dumper);
 
     // Upload/Download data in gl_buffer in/to this surface's texture
-    void UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_handle, GLuint draw_fb_handle);
+    void UploadGLTexture(Common::Rectangle<u32> rect, GLuint read_fb_handle, GLuint draw_fb_handle,
+                         OGLStreamBuffer& upload_buffer, TextureDumper& texture_dumper);
     void DownloadGLTexture(const Common::Rectangle<u32>& rect, GLuint read_fb_handle,
                            GLuint draw_fb_handle);
 
+    // Read the region of this surface's texture into dst with the layout of gl_buffer. dst can be
+    // an offset into the bound pixel pack buffer.
+    void ReadGLTexture(const Common::Rectangle<u32>& rect, GLuint read_fb_handle,
+                       GLuint draw_fb_handle, u8* dst, std::size_t dst_size);
+
+    /// Asynchronous download of a dirty region started before the CPU asked for it
+    std::optional<SurfaceReadback::Pending> pending_readback;
+    /// How often the CPU read this surface back after it was rendered to, decays on misses
+    u32 readback_count = 0;
+
+    /// Frame in which the surface was last used, to evict the least recently used ones first
+    int last_access_frame = 0;
+    /// Estimated video memory used by the texture, accounted while the surface is registered
+    std::size_t memory_usage = 0;
+    /// Last SurfaceIndex lookup that visited this surface
+    u64 index_generation = 0;
+    /// Hash of the emulated memory the whole texture was last loaded from, 0 if it changed since
+    u64 upload_hash = 0;
+    /// Value of the cache's modification counter when the texture was last written, 0 if never
+    u64 modification_tick = 0;
+
     std::shared_ptr<SurfaceWatcher> CreateWatcher() {
         auto watcher = std::make_shared<SurfaceWatcher>(weak_from_this());
         watchers.push_front(watcher);
@@ -436,8 +480,106 @@ struct CachedTextureCube {
     std::shared_ptr<SurfaceWatcher> nz;
 };
 
+/**
+ * Index of the registered surfaces by the memory they cover, which also marks the pages touched by
+ * any surface as cached. By default surfaces are kept in buckets of 4KB pages, so lookups walk a
+ * few small vectors instead of a tree and registering a surface doesn't merge any sets. Building
+ * with USE_ICL_SURFACE_CACHE uses boost::icl interval maps instead, to compare the two.
+ */
+class SurfaceIndex : NonCopyable {
+public:
+    SurfaceIndex();
+    ~SurfaceIndex();
+
+    void Add(const Surface& surface);
+    void Remove(const Surface& surface);
+
+    /// Returns all surfaces in the index
+    std::vector<Surface> GetAll() const;
+
+    /// Calls func with the surfaces overlapping the interval. func must not modify the index.
+    template <typename Func>
+    void ForEachOverlapping(const SurfaceInterval& interval, Func&& func) const;
+
+private:
+#ifdef USE_ICL_SURFACE_CACHE
+    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
+
+    SurfaceCache surface_cache;
+    PageMap cached_pages;
+#else
+    static constexpr u32 PAGE_BITS = 12;
+    static constexpr u32 CHUNK_BITS = 10;
+    static constexpr u32 NUM_CHUNKS = 1 << (32 - PAGE_BITS - CHUNK_BITS);
+
+    using Bucket = boost::container::small_vector<Surface, 4>;
+    using Chunk = std::array<Bucket, 1 << CHUNK_BITS>;
+
+    const Bucket* FindBucket(u32 page) const {
+        const auto& chunk = chunks[page >> CHUNK_BITS];
+        return chunk ? &(*chunk)[page & ((1 << CHUNK_BITS) - 1)] : nullptr;
+    }
+
+    /// Chunks of page buckets, allocated when the first surface in their range is added
+    std::array<std::unique_ptr<Chunk>, NUM_CHUNKS> chunks;
+    /// Incremented by every lookup so surfaces covering several pages are only visited once
+    mutable u64 generation = 0;
+    std::size_t num_surfaces = 0;
+#endif
+};
+
+template <typename Func>
+void SurfaceIndex::ForEachOverlapping(const SurfaceInterval& interval, Func&& func) const {
+#ifdef USE_ICL_SURFACE_CACHE
+    for (auto& pair : boost::make_iterator_range(surface_cache.equal_range(interval))) {
+        for (auto& surface : pair.second) {
+            func(surface);
+        }
+    }
+#else
+    const PAddr start = boost::icl::first(interval);
+    const PAddr end = boost::icl::last_next(interval);
+    if (start >= end)
+        return;
+
+    const u64 query = ++generation;
+    const u32 last_page = (end - 1) >> PAGE_BITS;
+    for (u32 page = start >> PAGE_BITS; page <= last_page; ++page) {
+        const Bucket* bucket = FindBucket(page);
+        if (bucket == nullptr) {
+            // Skip the rest of the chunk
+            page |= (1 << CHUNK_BITS) - 1;
+            continue;
+        }
+        for (const Surface& surface : *bucket) {
+            if (surface->index_generation == query)
+                continue;
+            surface->index_generation = query;
+            if (surface->addr < end && surface->end > start) {
+                func(surface);
+            }
+        }
+    }
+#endif
+}
+
 class RasterizerCacheOpenGL : NonCopyable {
 public:
+    struct Stats {
+        std::size_t memory_usage = 0; ///< Bytes of video memory used by registered surfaces
+        u64 evictions = 0;            ///< Surfaces removed to stay within the budget
+        u64 dirty_evictions = 0;      ///< Evicted surfaces that had to be flushed first
+        u64 upload_hash_checks = 0;   ///< Texture loads compared against the last upload hash
+        u64 upload_hash_hits = 0;     ///< Texture loads skipped because the data was unchanged
+        u64 framebuffer_reuses = 0;   ///< Draws that kept the surfaces of the previous draw
+
+        double GetUploadHashHitRate() const {
+            return upload_hash_checks == 0
+                       ? 0.0
+                       : static_cast<double>(upload_hash_hits) / upload_hash_checks;
+        }
+    };
+
     RasterizerCacheOpenGL();
     ~RasterizerCacheOpenGL();
 
@@ -481,12 +623,29 @@ public:
     /// Write any cached resources overlapping the region back to memory (if dirty)
     void FlushRegion(PAddr addr, u32 size, Surface flush_surface = nullptr);
 
+    /// Start downloading the dirty regions of a surface if the CPU is likely to read them
+    void StartReadback(const Surface& surface);
+
+    /// Records that the region was the source of a display transfer, read from the given surface
+    void MarkDisplaySource(const SurfaceParams& params, const Surface& surface);
+
+    /**
+     * Returns whether the color buffer at the address only feeds display transfers, so that draws
+     * to it can be dropped in skipped frames. Buffers that are sampled as textures or read back
+     * by the CPU are never display only.
+     */
+    bool IsDisplayOnly(PAddr color_addr) const;
+
     /// Mark region as being invalidated by region_owner (nullptr if 3DS memory)
     void InvalidateRegion(PAddr addr, u32 size, const Surface& region_owner);
 
     /// Flush all cached resources tracked by this cache manager
     void FlushAll();
 
+    const Stats& GetStats() const {
+        return stats;
+    }
+
 private:
     void DuplicateSurface(const Surface& src_surface, const Surface& dest_surface);
 
@@ -502,11 +661,30 @@ private:
     /// Remove surface from the cache
     void UnregisterSurface(const Surface& surface);
 
-    /// Increase/decrease the number of surface in pages touching the specified region
-    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
+    /// Evict the least recently used surfaces while the cache is over its memory budget
+    void EnforceMemoryBudget();
 
-    SurfaceCache surface_cache;
-    PageMap cached_pages;
+    /// Invalidate the textures whose custom replacement finished decoding in the background
+    void UpdateCustomTextures();
+
+    /// Compress the texture of a surface that was just loaded as a whole, if enabled
+    void CompressSurface(const Surface& surface);
+
+    /// Reload a compressed surface into an uncompressed texture, so that it can be blitted from
+    void UncompressSurface(const Surface& surface);
+
+    /// Let the CPU read the pages touching the interval directly again once none of them is dirty
+    void UnmarkCleanPages(const SurfaceInterval& interval);
+
+    struct DisplaySource {
+        SurfaceInterval interval;
+        bool used_otherwise = false; ///< Sampled as a texture or read back by the CPU
+    };
+
+    /// Declared before the surfaces, which may still return their buffers when destroyed
+    StagingPool staging_pool;
+
+    SurfaceIndex surface_index;
     SurfaceMap dirty_regions;
     SurfaceSet remove_surfaces;
 
@@ -520,6 +698,47 @@ private:
     GLint d24s8_abgr_tbo_size_u_id;
     GLint d24s8_abgr_viewport_u_id;
 
+    TextureDecoder texture_decoder;
+    TextureCompressor texture_compressor;
+    FormatReinterpreter format_reinterpreter;
+
+    SurfaceReadback surface_readback;
+    TextureDumper texture_dumper;
+    /// Ring of pixel unpack buffers the decoded textures are uploaded from
+    OGLStreamBuffer upload_buffer;
+    Surface last_color_surface;
+    Surface last_depth_surface;
+
+    /// The framebuffer configuration of the last GetFramebufferSurfaces call and its result
+    struct FramebufferLookup {
+        PAddr color_addr;
+        PAddr depth_addr;
+        SurfaceParams::PixelFormat color_format;
+        SurfaceParams::PixelFormat depth_format;
+        u32 width;
+        u32 height;
+        u16 res_scale;
+        Common::Rectangle<u32> viewport;
+        bool using_color_fb;
+        bool using_depth_fb;
+        /// Value of registration_generation when the surfaces were looked up
+        u64 generation;
+        SurfaceSurfaceRect_Tuple result;
+        SurfaceInterval color_interval;
+        SurfaceInterval depth_interval;
+    };
+    std::optional<FramebufferLookup> last_framebuffer;
+    /// Incremented whenever a surface is registered, which can change the result of lookups
+    u64 registration_generation = 0;
+    /// Incremented whenever the texture of a surface is written, never reused by another surface
+    u64 modification_counter = 0;
+
+    /// The most recent display transfer sources, games rarely use more than one per screen
+    std::array<DisplaySource, 4> display_sources{};
+    std::size_t next_display_source = 0;
+
+    Stats stats;
+
     std::unordered_map<TextureCubeConfig, CachedTextureCube> texture_cube_cache;
 };
 
@@ -2,12 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
 #include <exception>
 #include <map>
 #include <set>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 #include <nihstro/shader_bytecode.h>
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -15,6 +17,7 @@
 
 namespace OpenGL::ShaderDecompiler {
 
+using nihstro::DestRegister;
 using nihstro::Instruction;
 using nihstro::OpCode;
 using nihstro::RegisterType;
@@ -23,6 +26,12 @@ using nihstro::SwizzlePattern;
 
 constexpr u32 PROGRAM_END = Pica::Shader::MAX_PROGRAM_CODE_LENGTH;
 
+/// Destination components each instruction has to write, one bit for each component from x to w.
+using WriteMasks = std::array<u8, PROGRAM_END>;
+
+/// Number of CALL, IF and LOOP instructions refering to each subroutine, by begin and end.
+using ReferenceCounts = std::map<std::pair<u32, u32>, u32>;
+
 class DecompileFail : public std::runtime_error {
 public:
     using std::runtime_error::runtime_error;
@@ -69,13 +78,36 @@ public:
         return std::move(subroutines);
     }
 
+    ReferenceCounts MoveReferenceCounts() {
+        return std::move(reference_counts);
+    }
+
+    /**
+     * Returns true if every IF and LOOP block ends inside of its enclosing subroutine and every
+     * JMP stays inside of it. The generated code follows the PICA control flow exactly then.
+     */
+    bool IsStructured() const {
+        return structured;
+    }
+
 private:
     const Pica::Shader::ProgramCode& program_code;
     std::set<Subroutine> subroutines;
     std::map<std::pair<u32, u32>, ExitMethod> exit_method_map;
+    ReferenceCounts reference_counts;
+    bool structured = true;
+
+    /// Clears the structured flag if code in [begin, end) continues at the offset.
+    void CheckContinuation(u32 begin, u32 end, u32 offset) {
+        if (offset < begin || (end != PROGRAM_END && offset > end)) {
+            structured = false;
+        }
+    }
 
     /// Adds and analyzes a new subroutine if it is not added yet.
     const Subroutine& AddSubroutine(u32 begin, u32 end) {
+        ++reference_counts[{begin, end}];
+
         auto iter = subroutines.find(Subroutine{begin, end});
         if (iter != subroutines.end())
             return *iter;
@@ -137,6 +169,7 @@ private:
             }
             case OpCode::Id::JMPC:
             case OpCode::Id::JMPU: {
+                CheckContinuation(begin, end, instr.flow_control.dest_offset);
                 labels.insert(instr.flow_control.dest_offset);
                 ExitMethod no_jmp = Scan(offset + 1, end, labels);
                 ExitMethod jmp = Scan(instr.flow_control.dest_offset, end, labels);
@@ -152,6 +185,7 @@ private:
                 return exit_method = SeriesExit(call.exit_method, after_call);
             }
             case OpCode::Id::LOOP: {
+                CheckContinuation(offset + 1, end, instr.flow_control.dest_offset + 1);
                 auto& loop = AddSubroutine(offset + 1, instr.flow_control.dest_offset + 1);
                 if (loop.exit_method == ExitMethod::AlwaysEnd)
                     return exit_method = ExitMethod::AlwaysEnd;
@@ -169,6 +203,10 @@ private:
             }
             case OpCode::Id::IFU:
             case OpCode::Id::IFC: {
+                CheckContinuation(offset + 1, end, instr.flow_control.dest_offset);
+                CheckContinuation(offset + 1, end,
+                                  instr.flow_control.dest_offset +
+                                      instr.flow_control.num_instructions);
                 auto& if_sub = AddSubroutine(offset + 1, instr.flow_control.dest_offset);
                 ExitMethod else_method;
                 if (instr.flow_control.num_instructions != 0) {
@@ -194,6 +232,250 @@ private:
     }
 };
 
+/**
+ * Finds the components of temporary register writes that are read later, and the writes to
+ * output registers that aren't used, so that they can be left out of the generated code. Only
+ * valid for programs that ControlFlowAnalyzer considers structured.
+ */
+class LivenessAnalyzer {
+public:
+    LivenessAnalyzer(const Pica::Shader::ProgramCode& program_code,
+                     const Pica::Shader::SwizzleData& swizzle_data,
+                     const RegGetter& outputreg_getter)
+        : program_code(program_code), swizzle_data(swizzle_data) {
+
+        for (u32 i = 0; i < 16; ++i) {
+            output_used[i] = !outputreg_getter(i).empty();
+        }
+        FindSuccessors();
+        Solve();
+    }
+
+    WriteMasks MoveWriteMasks() {
+        return std::move(write_masks);
+    }
+
+private:
+    /// Four bits for each temporary register, one for each component from x to w.
+    using LiveSet = u64;
+
+    const Pica::Shader::ProgramCode& program_code;
+    const Pica::Shader::SwizzleData& swizzle_data;
+    std::array<bool, 16> output_used;
+    std::vector<std::vector<u32>> successors;
+    WriteMasks write_masks;
+
+    /**
+     * Finds the instructions that may run after each one. Reaching the end of a CALL, IF or LOOP
+     * block may continue after that block, so these edges are added wherever such an end is
+     * reached, whether a block is active there or not.
+     */
+    void FindSuccessors() {
+        std::map<u32, std::vector<u32>> block_exits;
+        for (u32 offset = 0; offset < PROGRAM_END; ++offset) {
+            const Instruction instr = {program_code[offset]};
+            const u32 dest_offset = instr.flow_control.dest_offset;
+            const u32 num_instructions = instr.flow_control.num_instructions;
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::CALL:
+            case OpCode::Id::CALLC:
+            case OpCode::Id::CALLU:
+                block_exits[dest_offset + num_instructions].push_back(offset + 1);
+                break;
+            case OpCode::Id::IFU:
+            case OpCode::Id::IFC:
+                if (num_instructions != 0) {
+                    block_exits[dest_offset].push_back(dest_offset + num_instructions);
+                }
+                break;
+            case OpCode::Id::LOOP:
+                block_exits[dest_offset + 1].push_back(offset + 1);
+                break;
+            default:
+                break;
+            }
+        }
+
+        successors.resize(PROGRAM_END);
+        for (u32 offset = 0; offset < PROGRAM_END; ++offset) {
+            const Instruction instr = {program_code[offset]};
+            std::vector<u32> targets;
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::END:
+                break;
+            case OpCode::Id::CALL:
+                targets = {instr.flow_control.dest_offset};
+                break;
+            case OpCode::Id::CALLC:
+            case OpCode::Id::CALLU:
+            case OpCode::Id::IFU:
+            case OpCode::Id::IFC:
+            case OpCode::Id::JMPC:
+            case OpCode::Id::JMPU:
+                targets = {offset + 1, instr.flow_control.dest_offset};
+                break;
+            default:
+                targets = {offset + 1};
+                break;
+            }
+
+            // Follows block exits transitively, one block may end where another one continues
+            std::set<u32> reachable;
+            while (!targets.empty()) {
+                const u32 target = targets.back();
+                targets.pop_back();
+                if (target >= PROGRAM_END || !reachable.insert(target).second) {
+                    continue;
+                }
+                if (auto iter = block_exits.find(target); iter != block_exits.end()) {
+                    targets.insert(targets.end(), iter->second.begin(), iter->second.end());
+                }
+            }
+            successors[offset].assign(reachable.begin(), reachable.end());
+        }
+    }
+
+    /// Iterates the backward data flow until no live set changes anymore.
+    void Solve() {
+        std::vector<LiveSet> live_in(PROGRAM_END, 0);
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (u32 offset = PROGRAM_END; offset-- > 0;) {
+                LiveSet live_out = 0;
+                for (u32 successor : successors[offset]) {
+                    live_out |= live_in[successor];
+                }
+                const LiveSet live = Transfer(offset, live_out, write_masks[offset]);
+                if (live != live_in[offset]) {
+                    live_in[offset] = live;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    /// Returns the selector positions of a source operand that the instruction reads.
+    static u32 ReadPositions(OpCode::Id opcode, u32 source, u32 needed) {
+        switch (opcode) {
+        case OpCode::Id::DP3:
+            return 0b0111;
+        case OpCode::Id::DP4:
+            return 0b1111;
+        case OpCode::Id::DPH:
+        case OpCode::Id::DPHI:
+            return source == 0 ? 0b0111 : 0b1111;
+        case OpCode::Id::EX2:
+        case OpCode::Id::LG2:
+        case OpCode::Id::RCP:
+        case OpCode::Id::RSQ:
+            return 0b0001;
+        case OpCode::Id::CMP:
+            return 0b0011;
+        default:
+            // Component-wise operations
+            return needed;
+        }
+    }
+
+    /**
+     * Computes the live set before an instruction from the one after it, and the destination
+     * components the instruction has to write.
+     */
+    LiveSet Transfer(u32 offset, LiveSet live_out, u8& write_mask) const {
+        write_mask = 0b1111;
+
+        const Instruction instr = {program_code[offset]};
+        const OpCode::Type type = instr.opcode.Value().GetInfo().type;
+        if (type != OpCode::Type::Arithmetic && type != OpCode::Type::MultiplyAdd) {
+            return live_out;
+        }
+
+        const OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+        const bool is_mad = type == OpCode::Type::MultiplyAdd;
+        const SwizzlePattern swizzle = {
+            swizzle_data[is_mad ? instr.mad.operand_desc_id : instr.common.operand_desc_id]};
+
+        u32 enabled = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (swizzle.DestComponentEnabled(i)) {
+                enabled |= 1 << i;
+            }
+        }
+
+        // Components of the result that have an effect
+        u32 needed = 0;
+        LiveSet live_in = live_out;
+        if (opcode == OpCode::Id::CMP) {
+            needed = 0b0011;
+        } else if (opcode == OpCode::Id::MOVA) {
+            needed = enabled & 0b0011;
+        } else {
+            const DestRegister dest = is_mad ? instr.mad.dest.Value() : instr.common.dest.Value();
+            const u32 index = static_cast<u32>(dest.GetIndex());
+            if (dest.GetRegisterType() == RegisterType::Temporary) {
+                needed = enabled & static_cast<u32>(live_out >> (index * 4)) & 0b1111;
+                live_in &= ~(static_cast<LiveSet>(enabled) << (index * 4));
+            } else if (dest.GetRegisterType() == RegisterType::Output && output_used[index]) {
+                needed = enabled;
+            }
+            write_mask = static_cast<u8>(needed);
+        }
+        if (needed == 0) {
+            return live_in;
+        }
+
+        std::array<SourceRegister, 3> sources;
+        u32 num_sources;
+        if (is_mad) {
+            const bool is_inverted = opcode == OpCode::Id::MADI;
+            sources = {instr.mad.GetSrc1(is_inverted), instr.mad.GetSrc2(is_inverted),
+                       instr.mad.GetSrc3(is_inverted)};
+            num_sources = 3;
+        } else {
+            const bool is_inverted =
+                (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+            sources = {instr.common.GetSrc1(is_inverted), instr.common.GetSrc2(is_inverted)};
+            switch (opcode) {
+            case OpCode::Id::EX2:
+            case OpCode::Id::LG2:
+            case OpCode::Id::FLR:
+            case OpCode::Id::RCP:
+            case OpCode::Id::RSQ:
+            case OpCode::Id::MOVA:
+            case OpCode::Id::MOV:
+                num_sources = 1;
+                break;
+            default:
+                num_sources = 2;
+                break;
+            }
+        }
+
+        for (u32 source = 0; source < num_sources; ++source) {
+            if (sources[source].GetRegisterType() != RegisterType::Temporary) {
+                continue;
+            }
+
+            using SelectorGetter = SwizzlePattern::Selector (SwizzlePattern::*)(int) const;
+            constexpr std::array<SelectorGetter, 3> selector_getters = {
+                &SwizzlePattern::GetSelectorSrc1, &SwizzlePattern::GetSelectorSrc2,
+                &SwizzlePattern::GetSelectorSrc3};
+
+            const u32 positions = ReadPositions(opcode, source, needed);
+            u32 components = 0;
+            for (int i = 0; i < 4; ++i) {
+                if ((positions >> i) & 1) {
+                    const auto selector = (swizzle.*selector_getters[source])(i);
+                    components |= 1 << static_cast<u32>(selector);
+                }
+            }
+            live_in |= static_cast<LiveSet>(components) << (sources[source].GetIndex() * 4);
+        }
+        return live_in;
+    }
+};
+
 class ShaderWriter {
 public:
     void AddLine(const std::string& text) {
@@ -247,13 +529,15 @@ constexpr auto GetSelectorSrc3 = GetSelectorSrc<&SwizzlePattern::GetSelectorSrc3
 class GLSLGenerator {
 public:
     GLSLGenerator(const std::set<Subroutine>& subroutines,
+                  const ReferenceCounts& reference_counts, const WriteMasks& write_masks,
                   const Pica::Shader::ProgramCode& program_code,
                   const Pica::Shader::SwizzleData& swizzle_data, u32 main_offset,
                   const RegGetter& inputreg_getter, const RegGetter& outputreg_getter,
-                  bool sanitize_mul)
-        : subroutines(subroutines), program_code(program_code), swizzle_data(swizzle_data),
-          main_offset(main_offset), inputreg_getter(inputreg_getter),
-          outputreg_getter(outputreg_getter), sanitize_mul(sanitize_mul) {
+                  bool sanitize_mul, bool is_gs)
+        : subroutines(subroutines), reference_counts(reference_counts), write_masks(write_masks),
+          program_code(program_code), swizzle_data(swizzle_data), main_offset(main_offset),
+          inputreg_getter(inputreg_getter), outputreg_getter(outputreg_getter),
+          sanitize_mul(sanitize_mul), is_gs(is_gs) {
 
         Generate();
     }
@@ -346,12 +630,24 @@ private:
         return "uniforms.b[" + std::to_string(index) + "]";
     }
 
+    /**
+     * Returns true if the code of the subroutine is generated at its only caller instead of in a
+     * function. Subroutines with JMP labels need the dispatch loop of a function of their own.
+     */
+    bool IsInlined(const Subroutine& subroutine) const {
+        return subroutine.labels.empty() &&
+               reference_counts.at({subroutine.begin, subroutine.end}) == 1;
+    }
+
     /**
      * Adds code that calls a subroutine.
      * @param subroutine the subroutine to call.
      */
     void CallSubroutine(const Subroutine& subroutine) {
-        if (subroutine.exit_method == ExitMethod::AlwaysEnd) {
+        if (IsInlined(subroutine)) {
+            // An END inside of it returns true from the caller, just like a call would
+            CompileRange(subroutine.begin, subroutine.end);
+        } else if (subroutine.exit_method == ExitMethod::AlwaysEnd) {
             shader.AddLine(subroutine.GetName() + "();");
             shader.AddLine("return true;");
         } else if (subroutine.exit_method == ExitMethod::Conditional) {
@@ -363,19 +659,19 @@ private:
 
     /**
      * Writes code that does an assignment operation.
-     * @param swizzle the swizzle data of the current instruction.
+     * @param dest_mask the destination components to write, one bit for each from x to w.
      * @param reg the destination register code.
      * @param value the code representing the value to assign.
      * @param dest_num_components number of components of the destination register.
      * @param value_num_components number of components of the value to assign.
      */
-    void SetDest(const SwizzlePattern& swizzle, const std::string& reg, const std::string& value,
+    void SetDest(u32 dest_mask, const std::string& reg, const std::string& value,
                  u32 dest_num_components, u32 value_num_components) {
         u32 dest_mask_num_components = 0;
         std::string dest_mask_swizzle = ".";
 
         for (u32 i = 0; i < dest_num_components; ++i) {
-            if (swizzle.DestComponentEnabled(static_cast<int>(i))) {
+            if ((dest_mask >> i) & 1) {
                 dest_mask_swizzle += "xyzw"[i];
                 ++dest_mask_num_components;
             }
@@ -416,6 +712,15 @@ private:
                 : instr.common.operand_desc_id;
         const SwizzlePattern swizzle = {swizzle_data[swizzle_offset]};
 
+        // Leaves out the components that are never read
+        u32 dest_mask = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (swizzle.DestComponentEnabled(i)) {
+                dest_mask |= 1 << i;
+            }
+        }
+        dest_mask &= write_masks[offset];
+
         shader.AddLine("// " + std::to_string(offset) + ": " + instr.opcode.Value().GetInfo().name);
 
         switch (instr.opcode.Value().GetInfo().type) {
@@ -437,31 +742,31 @@ private:
 
             switch (instr.opcode.Value().EffectiveOpCode()) {
             case OpCode::Id::ADD: {
-                SetDest(swizzle, dest_reg, src1 + " + " + src2, 4, 4);
+                SetDest(dest_mask, dest_reg, src1 + " + " + src2, 4, 4);
                 break;
             }
 
             case OpCode::Id::MUL: {
                 if (sanitize_mul) {
-                    SetDest(swizzle, dest_reg, "sanitize_mul(" + src1 + ", " + src2 + ")", 4, 4);
+                    SetDest(dest_mask, dest_reg, "sanitize_mul(" + src1 + ", " + src2 + ")", 4, 4);
                 } else {
-                    SetDest(swizzle, dest_reg, src1 + " * " + src2, 4, 4);
+                    SetDest(dest_mask, dest_reg, src1 + " * " + src2, 4, 4);
                 }
                 break;
             }
 
             case OpCode::Id::FLR: {
-                SetDest(swizzle, dest_reg, "floor(" + src1 + ")", 4, 4);
+                SetDest(dest_mask, dest_reg, "floor(" + src1 + ")", 4, 4);
                 break;
             }
 
             case OpCode::Id::MAX: {
-                SetDest(swizzle, dest_reg, "max(" + src1 + ", " + src2 + ")", 4, 4);
+                SetDest(dest_mask, dest_reg, "max(" + src1 + ", " + src2 + ")", 4, 4);
                 break;
             }
 
             case OpCode::Id::MIN: {
-                SetDest(swizzle, dest_reg, "min(" + src1 + ", " + src2 + ")", 4, 4);
+                SetDest(dest_mask, dest_reg, "min(" + src1 + ", " + src2 + ")", 4, 4);
                 break;
             }
 
@@ -488,40 +793,40 @@ private:
                     }
                 }
 
-                SetDest(swizzle, dest_reg, dot, 4, 1);
+                SetDest(dest_mask, dest_reg, dot, 4, 1);
                 break;
             }
 
             case OpCode::Id::RCP: {
-                SetDest(swizzle, dest_reg, "(1.0 / " + src1 + ".x)", 4, 1);
+                SetDest(dest_mask, dest_reg, "(1.0 / " + src1 + ".x)", 4, 1);
                 break;
             }
 
             case OpCode::Id::RSQ: {
-                SetDest(swizzle, dest_reg, "inversesqrt(" + src1 + ".x)", 4, 1);
+                SetDest(dest_mask, dest_reg, "inversesqrt(" + src1 + ".x)", 4, 1);
                 break;
             }
 
             case OpCode::Id::MOVA: {
-                SetDest(swizzle, "address_registers", "ivec2(" + src1 + ")", 2, 2);
+                SetDest(dest_mask, "address_registers", "ivec2(" + src1 + ")", 2, 2);
                 break;
             }
 
             case OpCode::Id::MOV: {
-                SetDest(swizzle, dest_reg, src1, 4, 4);
+                SetDest(dest_mask, dest_reg, src1, 4, 4);
                 break;
             }
 
             case OpCode::Id::SGE:
             case OpCode::Id::SGEI: {
-                SetDest(swizzle, dest_reg, "vec4(greaterThanEqual(" + src1 + "," + src2 + "))", 4,
+                SetDest(dest_mask, dest_reg, "vec4(greaterThanEqual(" + src1 + "," + src2 + "))", 4,
                         4);
                 break;
             }
 
             case OpCode::Id::SLT:
             case OpCode::Id::SLTI: {
-                SetDest(swizzle, dest_reg, "vec4(lessThan(" + src1 + "," + src2 + "))", 4, 4);
+                SetDest(dest_mask, dest_reg, "vec4(lessThan(" + src1 + "," + src2 + "))", 4, 4);
                 break;
             }
 
@@ -555,12 +860,12 @@ private:
             }
 
             case OpCode::Id::EX2: {
-                SetDest(swizzle, dest_reg, "exp2(" + src1 + ".x)", 4, 1);
+                SetDest(dest_mask, dest_reg, "exp2(" + src1 + ".x)", 4, 1);
                 break;
             }
 
             case OpCode::Id::LG2: {
-                SetDest(swizzle, dest_reg, "log2(" + src1 + ".x)", 4, 1);
+                SetDest(dest_mask, dest_reg, "log2(" + src1 + ".x)", 4, 1);
                 break;
             }
 
@@ -603,10 +908,10 @@ private:
                               : "";
 
                 if (sanitize_mul) {
-                    SetDest(swizzle, dest_reg, "sanitize_mul(" + src1 + ", " + src2 + ") + " + src3,
-                            4, 4);
+                    SetDest(dest_mask, dest_reg,
+                            "sanitize_mul(" + src1 + ", " + src2 + ") + " + src3, 4, 4);
                 } else {
-                    SetDest(swizzle, dest_reg, src1 + " * " + src2 + " + " + src3, 4, 4);
+                    SetDest(dest_mask, dest_reg, src1 + " * " + src2 + " + " + src3, 4, 4);
                 }
             } else {
                 LOG_ERROR(HW_GPU, "Unhandled multiply-add instruction: 0x{:02x} ({}): 0x{:08x}",
@@ -745,10 +1050,26 @@ private:
                 break;
             }
 
-            case OpCode::Id::EMIT:
-            case OpCode::Id::SETEMIT:
-                LOG_ERROR(HW_GPU, "Geometry shader operation detected in vertex shader");
+            case OpCode::Id::EMIT: {
+                if (is_gs) {
+                    shader.AddLine("emit();");
+                } else {
+                    LOG_ERROR(HW_GPU, "Geometry shader operation detected in vertex shader");
+                }
                 break;
+            }
+
+            case OpCode::Id::SETEMIT: {
+                if (is_gs) {
+                    ASSERT(instr.setemit.vertex_id < 3);
+                    shader.AddLine("setemit(" + std::to_string(instr.setemit.vertex_id) + "u, " +
+                                   ((instr.setemit.prim_emit != 0) ? "true" : "false") + ", " +
+                                   ((instr.setemit.winding != 0) ? "true" : "false") + ");");
+                } else {
+                    LOG_ERROR(HW_GPU, "Geometry shader operation detected in vertex shader");
+                }
+                break;
+            }
 
             default: {
                 LOG_ERROR(HW_GPU, "Unhandled instruction: 0x{:02x} ({}): 0x{:08x}",
@@ -800,7 +1121,9 @@ private:
 
         // Add declarations for all subroutines
         for (const auto& subroutine : subroutines) {
-            shader.AddLine("bool " + subroutine.GetName() + "();");
+            if (!IsInlined(subroutine)) {
+                shader.AddLine("bool " + subroutine.GetName() + "();");
+            }
         }
         shader.AddLine("");
 
@@ -813,6 +1136,10 @@ private:
 
         // Add definitions for all subroutines
         for (const auto& subroutine : subroutines) {
+            if (IsInlined(subroutine)) {
+                continue;
+            }
+
             std::set<u32> labels = subroutine.labels;
 
             shader.AddLine("bool " + subroutine.GetName() + "() {");
@@ -866,12 +1193,15 @@ private:
 
 private:
     const std::set<Subroutine>& subroutines;
+    const ReferenceCounts& reference_counts;
+    const WriteMasks& write_masks;
     const Pica::Shader::ProgramCode& program_code;
     const Pica::Shader::SwizzleData& swizzle_data;
     const u32 main_offset;
     const RegGetter& inputreg_getter;
     const RegGetter& outputreg_getter;
     const bool sanitize_mul;
+    const bool is_gs;
 
     ShaderWriter shader;
 };
@@ -893,12 +1223,26 @@ std::optional<ProgramResult> DecompileProgram(const Pica::Shader::ProgramCode& p
                                               const Pica::Shader::SwizzleData& swizzle_data,
                                               u32 main_offset, const RegGetter& inputreg_getter,
                                               const RegGetter& outputreg_getter,
-                                              bool sanitize_mul) {
+                                              bool sanitize_mul, bool is_gs) {
 
     try {
-        auto subroutines = ControlFlowAnalyzer(program_code, main_offset).MoveSubroutines();
-        GLSLGenerator generator(subroutines, program_code, swizzle_data, main_offset,
-                                inputreg_getter, outputreg_getter, sanitize_mul);
+        ControlFlowAnalyzer analyzer(program_code, main_offset);
+        const bool structured = analyzer.IsStructured();
+        const auto subroutines = analyzer.MoveSubroutines();
+        const auto reference_counts = analyzer.MoveReferenceCounts();
+
+        // Without structured control flow the liveness could miss paths of the generated code
+        WriteMasks write_masks;
+        if (structured) {
+            write_masks =
+                LivenessAnalyzer(program_code, swizzle_data, outputreg_getter).MoveWriteMasks();
+        } else {
+            write_masks.fill(0b1111);
+        }
+
+        GLSLGenerator generator(subroutines, reference_counts, write_masks, program_code,
+                                swizzle_data, main_offset, inputreg_getter, outputreg_getter,
+                                sanitize_mul, is_gs);
         return {ProgramResult{generator.MoveShaderCode()}};
     } catch (const DecompileFail& exception) {
         LOG_INFO(HW_GPU, "Shader decompilation failed: {}", exception.what());
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <random>
 #include <fmt/format.h>
 
 #include "common/assert.h"
@@ -31,7 +32,44 @@ enum class PrecompiledEntryKind : u32 {
     Dump,
 };
 
-constexpr u32 NativeVersion = 1;
+constexpr u32 NativeVersion = 2;
+
+/// Usage files are this version followed by pairs of unique identifier and use count
+constexpr u32 UsageVersion = 1;
+
+/// Bundles start with this header, followed by the entries sorted by their use count. Each entry is
+/// the use count followed by the raw shader in the transferable format.
+struct BundleHeader {
+    u32 magic;
+    u32 version;
+    u64 program_id;
+    u32 num_entries;
+    u32 padding;
+};
+static_assert(sizeof(BundleHeader) == 24, "BundleHeader has incorrect size");
+
+constexpr u32 BundleMagic = 0x42435343; // "CSCB"
+constexpr u32 BundleVersion = 1;
+
+/// Precompiled files start with the version hash and this header, followed by the index and the
+/// entries. Each entry is compressed on its own, so that it can be loaded without the others.
+struct PrecompiledHeader {
+    u32 version;
+    u32 num_entries;
+};
+static_assert(sizeof(PrecompiledHeader) == 8, "PrecompiledHeader has incorrect size");
+
+struct PrecompiledIndexEntry {
+    u64 unique_identifier;
+    PrecompiledEntryKind kind;
+    u32 compressed_size;
+    u64 offset;
+    u32 size;
+    u32 padding;
+};
+static_assert(sizeof(PrecompiledIndexEntry) == 32, "PrecompiledIndexEntry has incorrect size");
+
+constexpr u32 PrecompiledVersion = 1;
 
 ShaderCacheVersionHash GetShaderCacheVersionHash() {
     ShaderCacheVersionHash hash{};
@@ -45,7 +83,7 @@ ShaderDiskCacheRaw::ShaderDiskCacheRaw(u64 unique_identifier, ProgramType progra
     : unique_identifier{unique_identifier}, program_type{program_type}, config{config},
       program_code{std::move(program_code)} {}
 
-bool ShaderDiskCacheRaw::Load(FileUtil::IOFile& file) {
+bool ShaderDiskCacheRaw::Load(FileUtil::MappedFileReader& file) {
     if (file.ReadBytes(&unique_identifier, sizeof(u64)) != sizeof(u64) ||
         file.ReadBytes(&program_type, sizeof(u32)) != sizeof(u32)) {
         return false;
@@ -61,7 +99,7 @@ bool ShaderDiskCacheRaw::Load(FileUtil::IOFile& file) {
     }
 
     // Read in type specific configuration
-    if (program_type == ProgramType::VS) {
+    if (program_type == ProgramType::VS || program_type == ProgramType::GS) {
         u64 code_len{};
         if (file.ReadBytes(&code_len, sizeof(u64)) != sizeof(u64)) {
             return false;
@@ -90,7 +128,7 @@ bool ShaderDiskCacheRaw::Save(FileUtil::IOFile& file) const {
         return false;
     }
 
-    if (program_type == ProgramType::VS) {
+    if (program_type == ProgramType::VS || program_type == ProgramType::GS) {
         const std::size_t code_len = program_code.size();
         if (file.WriteObject(static_cast<u64>(code_len)) != 1) {
             return false;
@@ -102,6 +140,98 @@ bool ShaderDiskCacheRaw::Save(FileUtil::IOFile& file) const {
     return true;
 }
 
+/// Loads the entries that follow the version of a transferable file. Returns empty on failure.
+static std::optional<std::vector<ShaderDiskCacheRaw>> LoadTransferableEntries(
+    FileUtil::MappedFileReader& file) {
+    std::vector<ShaderDiskCacheRaw> raws;
+    while (file.Tell() < file.GetSize()) {
+        TransferableEntryKind kind{};
+        if (file.ReadBytes(&kind, sizeof(u32)) != sizeof(u32)) {
+            LOG_ERROR(Render_OpenGL, "Failed to read transferable file - skipping");
+            return {};
+        }
+
+        switch (kind) {
+        case TransferableEntryKind::Raw: {
+            ShaderDiskCacheRaw entry;
+            if (!entry.Load(file)) {
+                LOG_ERROR(Render_OpenGL, "Failed to load transferable raw entry - skipping");
+                return {};
+            }
+            raws.push_back(std::move(entry));
+            break;
+        }
+        default:
+            LOG_ERROR(Render_OpenGL, "Unknown transferable shader cache entry kind={} - skipping",
+                      static_cast<u32>(kind));
+            return {};
+        }
+    }
+
+    return raws;
+}
+
+/// Loads a transferable file of the current version. Returns empty if it is missing or invalid.
+static std::optional<std::vector<ShaderDiskCacheRaw>> LoadTransferableFile(
+    const std::string& path) {
+    FileUtil::MappedFile mapping(path);
+    if (!mapping.IsOpen()) {
+        return {};
+    }
+    FileUtil::MappedFileReader file(mapping);
+
+    u32 version{};
+    if (file.ReadBytes(&version, sizeof(version)) != sizeof(version) || version != NativeVersion) {
+        return {};
+    }
+    return LoadTransferableEntries(file);
+}
+
+/// Loads the usage counts of the shaders of a title. Missing or invalid files have no counts.
+static ShaderUsageMap LoadUsageFile(const std::string& path) {
+    FileUtil::MappedFile mapping(path);
+    if (!mapping.IsOpen()) {
+        return {};
+    }
+    FileUtil::MappedFileReader file(mapping);
+
+    u32 version{};
+    if (file.ReadBytes(&version, sizeof(version)) != sizeof(version) || version != UsageVersion) {
+        return {};
+    }
+
+    ShaderUsageMap usage;
+    std::array<u64, 2> entry{};
+    while (file.ReadArray(entry.data(), entry.size()) == entry.size()) {
+        usage[entry[0]] = entry[1];
+    }
+    return usage;
+}
+
+/// Replaces the usage file of a title. Returns true on success.
+static bool SaveUsageFile(const std::string& path, const ShaderUsageMap& usage) {
+    const auto temp_path{fmt::format("{}.{:08x}.tmp", path, std::random_device{}())};
+    {
+        FileUtil::IOFile file(temp_path, "wb");
+        bool written = file.IsOpen() && file.WriteObject(UsageVersion) == 1;
+        for (auto it = usage.begin(); written && it != usage.end(); ++it) {
+            const std::array<u64, 2> entry{it->first, it->second};
+            written = file.WriteArray(entry.data(), entry.size()) == entry.size();
+        }
+        if (!written) {
+            file.Close();
+            FileUtil::Delete(temp_path);
+            return false;
+        }
+    }
+    if (!FileUtil::Rename(temp_path, path) &&
+        !(FileUtil::Delete(path) && FileUtil::Rename(temp_path, path))) {
+        FileUtil::Delete(temp_path);
+        return false;
+    }
+    return true;
+}
+
 ShaderDiskCache::ShaderDiskCache(bool separable) : separable{separable} {}
 
 std::optional<std::vector<ShaderDiskCacheRaw>> ShaderDiskCache::LoadTransferable() {
@@ -110,12 +240,14 @@ std::optional<std::vector<ShaderDiskCacheRaw>> ShaderDiskCache::LoadTransferable
         return {};
     tried_to_load = true;
 
-    FileUtil::IOFile file(GetTransferablePath(), "rb");
-    if (!file.IsOpen()) {
+    // The entries are parsed straight out of a mapping instead of a read for every field
+    FileUtil::MappedFile mapping(GetTransferablePath());
+    if (!mapping.IsOpen()) {
         LOG_INFO(Render_OpenGL, "No transferable shader cache found for game with title id={}",
                  GetTitleID());
         return {};
     }
+    FileUtil::MappedFileReader file(mapping);
 
     u32 version{};
     if (file.ReadBytes(&version, sizeof(version)) != sizeof(version)) {
@@ -127,7 +259,7 @@ std::optional<std::vector<ShaderDiskCacheRaw>> ShaderDiskCache::LoadTransferable
 
     if (version < NativeVersion) {
         LOG_INFO(Render_OpenGL, "Transferable shader cache is old - removing");
-        file.Close();
+        mapping.Close();
         InvalidateAll();
         return {};
     }
@@ -138,170 +270,143 @@ std::optional<std::vector<ShaderDiskCacheRaw>> ShaderDiskCache::LoadTransferable
     }
 
     // Version is valid, load the shaders
-    std::vector<ShaderDiskCacheRaw> raws;
-    while (file.Tell() < file.GetSize()) {
-        TransferableEntryKind kind{};
-        if (file.ReadBytes(&kind, sizeof(u32)) != sizeof(u32)) {
-            LOG_ERROR(Render_OpenGL, "Failed to read transferable file - skipping");
-            return {};
-        }
-
-        switch (kind) {
-        case TransferableEntryKind::Raw: {
-            ShaderDiskCacheRaw entry;
-            if (!entry.Load(file)) {
-                LOG_ERROR(Render_OpenGL, "Failed to load transferable raw entry - skipping");
-                return {};
-            }
-            transferable.emplace(entry.GetUniqueIdentifier(), ShaderDiskCacheRaw{});
-            raws.push_back(std::move(entry));
-            break;
-        }
-        default:
-            LOG_ERROR(Render_OpenGL, "Unknown transferable shader cache entry kind={} - skipping",
-                      static_cast<u32>(kind));
-            return {};
-        }
+    auto raws = LoadTransferableEntries(file);
+    if (!raws) {
+        return {};
+    }
+    for (const ShaderDiskCacheRaw& raw : *raws) {
+        transferable.emplace(raw.GetUniqueIdentifier(), ShaderDiskCacheRaw{});
     }
+    usage = LoadUsageFile(GetUsagePath(GetProgramID()));
 
-    LOG_INFO(Render_OpenGL, "Found a transferable disk cache with {} entries", raws.size());
-    return {raws};
+    LOG_INFO(Render_OpenGL, "Found a transferable disk cache with {} entries", raws->size());
+    return raws;
 }
 
-std::pair<std::unordered_map<u64, ShaderDiskCacheDecompiled>, ShaderDumpsMap>
-ShaderDiskCache::LoadPrecompiled() {
+void ShaderDiskCache::LoadPrecompiled() {
     if (!IsUsable())
-        return {};
+        return;
 
-    FileUtil::IOFile file(GetPrecompiledPath(), "rb");
-    if (!file.IsOpen()) {
+    if (!precompiled_file.Open(GetPrecompiledPath())) {
         LOG_INFO(Render_OpenGL, "No precompiled shader cache found for game with title id={}",
                  GetTitleID());
-        return {};
+        return;
     }
 
-    const auto result = LoadPrecompiledFile(file);
-    if (!result) {
+    if (!LoadPrecompiledIndex()) {
         LOG_INFO(Render_OpenGL,
                  "Failed to load precompiled cache for game with title id={} - removing",
                  GetTitleID());
-        file.Close();
         InvalidatePrecompiled();
-        return {};
+        return;
     }
-    return *result;
+
+    LOG_INFO(Render_OpenGL,
+             "Found a precompiled disk cache with {} decompiled entries and {} binary entries",
+             precompiled_decompiled.size(), precompiled_dumps.size());
 }
 
-std::optional<std::pair<std::unordered_map<u64, ShaderDiskCacheDecompiled>, ShaderDumpsMap>>
-ShaderDiskCache::LoadPrecompiledFile(FileUtil::IOFile& file) {
-    // Read compressed file from disk and decompress to virtual precompiled cache file
-    std::vector<u8> compressed(file.GetSize());
-    file.ReadBytes(compressed.data(), compressed.size());
-    const std::vector<u8> decompressed = Common::Compression::DecompressDataZSTD(compressed);
-    SaveArrayToPrecompiled(decompressed.data(), decompressed.size());
-    decompressed_precompiled_cache_offset = 0;
+bool ShaderDiskCache::LoadPrecompiledIndex() {
+    FileUtil::MappedFileReader file{precompiled_file};
 
     ShaderCacheVersionHash file_hash{};
-    if (!LoadArrayFromPrecompiled(file_hash.data(), file_hash.size())) {
-        return {};
+    if (file.ReadArray(file_hash.data(), file_hash.size()) != file_hash.size()) {
+        return false;
     }
     if (GetShaderCacheVersionHash() != file_hash) {
         LOG_INFO(Render_OpenGL, "Precompiled cache is from another version of the emulator");
-        return {};
+        return false;
     }
 
-    std::unordered_map<u64, ShaderDiskCacheDecompiled> decompiled;
-    ShaderDumpsMap dumps;
-    while (decompressed_precompiled_cache_offset < decompressed_precompiled_cache.size()) {
-        PrecompiledEntryKind kind{};
-        if (!LoadObjectFromPrecompiled(kind)) {
-            return {};
-        }
+    PrecompiledHeader header{};
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.version != PrecompiledVersion) {
+        return false;
+    }
+    // Corrupted files could otherwise allocate an enormous index
+    if (header.num_entries > file.GetSize() / sizeof(PrecompiledIndexEntry)) {
+        return false;
+    }
 
-        switch (kind) {
-        case PrecompiledEntryKind::Decompiled: {
-            u64 unique_identifier{};
-            if (!LoadObjectFromPrecompiled(unique_identifier)) {
-                return {};
-            }
+    std::vector<PrecompiledIndexEntry> entries(header.num_entries);
+    if (file.ReadArray(entries.data(), entries.size()) != entries.size()) {
+        return false;
+    }
 
-            auto entry = LoadDecompiledEntry();
-            if (!entry) {
-                return {};
-            }
-            decompiled.insert({unique_identifier, std::move(*entry)});
-            break;
+    for (const PrecompiledIndexEntry& entry : entries) {
+        if (entry.offset > precompiled_file.GetSize() ||
+            precompiled_file.ReadSpan(static_cast<std::size_t>(entry.offset),
+                                      entry.compressed_size) == nullptr) {
+            return false;
         }
-        case PrecompiledEntryKind::Dump: {
-            u64 unique_identifier;
-            if (!LoadObjectFromPrecompiled(unique_identifier)) {
-                return {};
-            }
-
-            ShaderDiskCacheDump dump;
-            if (!LoadObjectFromPrecompiled(dump.binary_format)) {
-                return {};
-            }
-
-            u32 binary_length{};
-            if (!LoadObjectFromPrecompiled(binary_length)) {
-                return {};
-            }
 
-            dump.binary.resize(binary_length);
-            if (!LoadArrayFromPrecompiled(dump.binary.data(), dump.binary.size())) {
-                return {};
-            }
-
-            dumps.insert({unique_identifier, dump});
+        PrecompiledEntry location{entry.offset, entry.compressed_size, entry.size, {}};
+        switch (entry.kind) {
+        case PrecompiledEntryKind::Decompiled:
+            precompiled_decompiled.insert_or_assign(entry.unique_identifier, std::move(location));
+            break;
+        case PrecompiledEntryKind::Dump:
+            precompiled_dumps.insert_or_assign(entry.unique_identifier, std::move(location));
             break;
-        }
         default:
-            return {};
+            return false;
         }
     }
-
-    LOG_INFO(Render_OpenGL,
-             "Found a precompiled disk cache with {} decompiled entries and {} binary entries",
-             decompiled.size(), dumps.size());
-    return {{decompiled, dumps}};
+    return true;
 }
 
-std::optional<ShaderDiskCacheDecompiled> ShaderDiskCache::LoadDecompiledEntry() {
-
-    bool sanitize_mul;
-    if (!LoadObjectFromPrecompiled(sanitize_mul)) {
+std::optional<std::vector<u8>> ShaderDiskCache::LoadPrecompiledEntry(
+    const PrecompiledIndex& index, u64 unique_identifier) const {
+    const auto it = index.find(unique_identifier);
+    if (it == index.end()) {
         return {};
     }
 
-    u32 code_size{};
-    if (!LoadObjectFromPrecompiled(code_size)) {
+    const PrecompiledEntry& entry = it->second;
+    if (!entry.data.empty()) {
+        return entry.data;
+    }
+
+    const u8* const compressed = precompiled_file.ReadSpan(
+        static_cast<std::size_t>(entry.offset), entry.compressed_size);
+    std::vector<u8> data =
+        Common::Compression::DecompressDataZSTD(compressed, entry.compressed_size);
+    if (data.size() != entry.size) {
+        LOG_ERROR(Render_OpenGL, "Corrupted precompiled cache entry in shader={:016x}",
+                  unique_identifier);
         return {};
     }
+    return data;
+}
 
-    std::string code(code_size, '\0');
-    if (!LoadArrayFromPrecompiled(code.data(), code.size())) {
+std::optional<ShaderDiskCacheDecompiled> ShaderDiskCache::LoadDecompiled(
+    u64 unique_identifier) const {
+    const auto data = LoadPrecompiledEntry(precompiled_decompiled, unique_identifier);
+    if (!data || data->empty()) {
         return {};
     }
 
+    // Decompiled entries are the sanitize_mul setting followed by the code
     ShaderDiskCacheDecompiled entry;
-    entry.result.code = std::move(code);
-    entry.sanitize_mul = sanitize_mul;
-
+    entry.sanitize_mul = (*data)[0] != 0;
+    entry.result.code.assign(reinterpret_cast<const char*>(data->data()) + 1, data->size() - 1);
     return entry;
 }
 
-bool ShaderDiskCache::SaveDecompiledFile(u64 unique_identifier,
-                                         const ShaderDecompiler::ProgramResult& result,
-                                         bool sanitize_mul) {
-    if (!SaveObjectToPrecompiled(static_cast<u32>(PrecompiledEntryKind::Decompiled)) ||
-        !SaveObjectToPrecompiled(unique_identifier) || !SaveObjectToPrecompiled(sanitize_mul) ||
-        !SaveObjectToPrecompiled(static_cast<u32>(result.code.size())) ||
-        !SaveArrayToPrecompiled(result.code.data(), result.code.size())) {
-        return false;
+std::optional<ShaderDiskCacheDump> ShaderDiskCache::LoadDump(u64 unique_identifier) const {
+    const auto data = LoadPrecompiledEntry(precompiled_dumps, unique_identifier);
+    if (!data || data->size() < sizeof(u32)) {
+        return {};
     }
 
-    return true;
+    // Dump entries are the binary format followed by the binary
+    u32 binary_format;
+    std::memcpy(&binary_format, data->data(), sizeof(u32));
+
+    ShaderDiskCacheDump dump;
+    dump.binary_format = static_cast<GLenum>(binary_format);
+    dump.binary.assign(data->begin() + sizeof(u32), data->end());
+    return dump;
 }
 
 void ShaderDiskCache::InvalidateAll() {
@@ -313,8 +418,9 @@ void ShaderDiskCache::InvalidateAll() {
 }
 
 void ShaderDiskCache::InvalidatePrecompiled() {
-    // Clear virtaul precompiled cache file
-    decompressed_precompiled_cache.resize(0);
+    precompiled_file.Close();
+    precompiled_decompiled.clear();
+    precompiled_dumps.clear();
 
     if (!FileUtil::Delete(GetPrecompiledPath())) {
         LOG_ERROR(Render_OpenGL, "Failed to invalidate precompiled file={}", GetPrecompiledPath());
@@ -331,7 +437,7 @@ void ShaderDiskCache::SaveRaw(const ShaderDiskCacheRaw& entry) {
         return;
     }
 
-    FileUtil::IOFile file = AppendTransferableFile();
+    FileUtil::IOFile file = AppendTransferableFile(GetTransferablePath());
     if (!file.IsOpen())
         return;
     if (file.WriteObject(TransferableEntryKind::Raw) != 1 || !entry.Save(file)) {
@@ -349,15 +455,13 @@ void ShaderDiskCache::SaveDecompiled(u64 unique_identifier,
     if (!IsUsable())
         return;
 
-    if (decompressed_precompiled_cache.size() == 0) {
-        SavePrecompiledHeaderToVirtualPrecompiledCache();
-    }
+    std::vector<u8> data(1 + code.code.size());
+    data[0] = static_cast<u8>(sanitize_mul);
+    std::memcpy(data.data() + 1, code.code.data(), code.code.size());
 
-    if (!SaveDecompiledFile(unique_identifier, code, sanitize_mul)) {
-        LOG_ERROR(Render_OpenGL,
-                  "Failed to save decompiled entry to the precompiled file - removing");
-        InvalidatePrecompiled();
-    }
+    const auto size = static_cast<u32>(data.size());
+    precompiled_decompiled.insert_or_assign(unique_identifier,
+                                            PrecompiledEntry{0, 0, size, std::move(data)});
 }
 
 void ShaderDiskCache::SaveDump(u64 unique_identifier, GLuint program) {
@@ -366,32 +470,32 @@ void ShaderDiskCache::SaveDump(u64 unique_identifier, GLuint program) {
 
     GLint binary_length{};
     glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
-
-    GLenum binary_format{};
-    std::vector<u8> binary(binary_length);
-    glGetProgramBinary(program, binary_length, nullptr, &binary_format, binary.data());
-
-    if (!SaveObjectToPrecompiled(static_cast<u32>(PrecompiledEntryKind::Dump)) ||
-        !SaveObjectToPrecompiled(unique_identifier) ||
-        !SaveObjectToPrecompiled(static_cast<u32>(binary_format)) ||
-        !SaveObjectToPrecompiled(static_cast<u32>(binary_length)) ||
-        !SaveArrayToPrecompiled(binary.data(), binary.size())) {
-        LOG_ERROR(Render_OpenGL, "Failed to save binary program file in shader={:016x} - removing",
+    if (binary_length <= 0) {
+        LOG_ERROR(Render_OpenGL, "Failed to get binary program of shader={:016x}",
                   unique_identifier);
-        InvalidatePrecompiled();
         return;
     }
+
+    GLenum binary_format{};
+    std::vector<u8> data(sizeof(u32) + binary_length);
+    glGetProgramBinary(program, binary_length, nullptr, &binary_format,
+                       data.data() + sizeof(u32));
+    const auto format = static_cast<u32>(binary_format);
+    std::memcpy(data.data(), &format, sizeof(u32));
+
+    const auto size = static_cast<u32>(data.size());
+    precompiled_dumps.insert_or_assign(unique_identifier,
+                                       PrecompiledEntry{0, 0, size, std::move(data)});
 }
 
 bool ShaderDiskCache::IsUsable() const {
     return tried_to_load && Settings::values.use_disk_shader_cache;
 }
 
-FileUtil::IOFile ShaderDiskCache::AppendTransferableFile() {
+FileUtil::IOFile ShaderDiskCache::AppendTransferableFile(const std::string& transferable_path) {
     if (!EnsureDirectories())
         return {};
 
-    const auto transferable_path{GetTransferablePath()};
     const bool existed = FileUtil::Exists(transferable_path);
 
     FileUtil::IOFile file(transferable_path, "ab");
@@ -410,35 +514,226 @@ FileUtil::IOFile ShaderDiskCache::AppendTransferableFile() {
     return file;
 }
 
-void ShaderDiskCache::SavePrecompiledHeaderToVirtualPrecompiledCache() {
-    const auto hash{GetShaderCacheVersionHash()};
-    if (!SaveArrayToPrecompiled(hash.data(), hash.size())) {
-        LOG_ERROR(
-            Render_OpenGL,
-            "Failed to write precompiled cache version hash to virtual precompiled cache file");
-    }
-}
-
 void ShaderDiskCache::SaveVirtualPrecompiledFile() {
-    decompressed_precompiled_cache_offset = 0;
-    const std::vector<u8>& compressed = Common::Compression::CompressDataZSTDDefault(
-        decompressed_precompiled_cache.data(), decompressed_precompiled_cache.size());
+    // Entries loaded from the precompiled file are copied as they are, so only the new ones have to
+    // be compressed
+    const std::size_t num_entries = precompiled_decompiled.size() + precompiled_dumps.size();
+    std::vector<PrecompiledIndexEntry> entries;
+    std::vector<std::pair<PrecompiledEntry*, std::vector<u8>>> blocks;
+    entries.reserve(num_entries);
+    blocks.reserve(num_entries);
+    u64 offset = sizeof(ShaderCacheVersionHash) + sizeof(PrecompiledHeader) +
+                 num_entries * sizeof(PrecompiledIndexEntry);
+    const auto AddEntries = [&](PrecompiledIndex& index, PrecompiledEntryKind kind) {
+        for (auto& [unique_identifier, entry] : index) {
+            std::vector<u8> compressed;
+            u32 compressed_size = entry.compressed_size;
+            if (!entry.data.empty()) {
+                compressed = Common::Compression::CompressDataZSTDDefault(entry.data.data(),
+                                                                          entry.data.size());
+                compressed_size = static_cast<u32>(compressed.size());
+            }
+            entries.push_back({unique_identifier, kind, compressed_size, offset, entry.size, 0});
+            blocks.emplace_back(&entry, std::move(compressed));
+            offset += compressed_size;
+        }
+    };
+    AddEntries(precompiled_decompiled, PrecompiledEntryKind::Decompiled);
+    AddEntries(precompiled_dumps, PrecompiledEntryKind::Dump);
 
+    // Several instances of the same game can share the cache, so the file is written under a
+    // temporary name first and renamed, which never leaves a partially written file for the others
     const auto precompiled_path{GetPrecompiledPath()};
-    FileUtil::IOFile file(precompiled_path, "wb");
+    const auto temp_path{fmt::format("{}.{:08x}.tmp", precompiled_path, std::random_device{}())};
+    {
+        FileUtil::IOFile file(temp_path, "wb");
 
-    if (!file.IsOpen()) {
-        LOG_ERROR(Render_OpenGL, "Failed to open precompiled cache in path={}", precompiled_path);
+        if (!file.IsOpen()) {
+            LOG_ERROR(Render_OpenGL, "Failed to open precompiled cache in path={}", temp_path);
+            return;
+        }
+
+        const auto hash{GetShaderCacheVersionHash()};
+        const PrecompiledHeader header{PrecompiledVersion, static_cast<u32>(entries.size())};
+        bool written = file.WriteArray(hash.data(), hash.size()) == hash.size() &&
+                       file.WriteObject(header) == 1 &&
+                       file.WriteArray(entries.data(), entries.size()) == entries.size();
+        for (std::size_t i = 0; written && i < entries.size(); ++i) {
+            const auto& [entry, compressed] = blocks[i];
+            const u8* const data =
+                compressed.empty()
+                    ? precompiled_file.ReadSpan(static_cast<std::size_t>(entry->offset),
+                                                entry->compressed_size)
+                    : compressed.data();
+            written = file.WriteBytes(data, entries[i].compressed_size) ==
+                      entries[i].compressed_size;
+        }
+        if (!written) {
+            LOG_ERROR(Render_OpenGL, "Failed to write precompiled cache in path={}", temp_path);
+            file.Close();
+            FileUtil::Delete(temp_path);
+            return;
+        }
+    }
+
+    // The old file can't be replaced while it is mapped on Windows
+    precompiled_file.Close();
+    // Renaming onto an existing file fails on Windows
+    if (!FileUtil::Rename(temp_path, precompiled_path) &&
+        !(FileUtil::Delete(precompiled_path) && FileUtil::Rename(temp_path, precompiled_path))) {
+        LOG_ERROR(Render_OpenGL, "Failed to move precompiled cache to path={}", precompiled_path);
+        FileUtil::Delete(temp_path);
+    }
+
+    // Point the entries to the new file, so that their uncompressed data can be dropped
+    if (!precompiled_file.Open(precompiled_path)) {
+        precompiled_decompiled.clear();
+        precompiled_dumps.clear();
         return;
     }
-    if (file.WriteBytes(compressed.data(), compressed.size()) != compressed.size()) {
-        LOG_ERROR(Render_OpenGL, "Failed to write precompiled cache version in path={}",
-                  precompiled_path);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        PrecompiledEntry& entry = *blocks[i].first;
+        entry.offset = entries[i].offset;
+        entry.compressed_size = entries[i].compressed_size;
+        entry.data = {};
+    }
+}
+
+u64 ShaderDiskCache::GetUsage(u64 unique_identifier) const {
+    const auto it = usage.find(unique_identifier);
+    return it != usage.end() ? it->second : 0;
+}
+
+void ShaderDiskCache::SaveUsage() {
+    if (!IsUsable() || !usage_changed)
+        return;
+
+    if (!EnsureDirectories() || !SaveUsageFile(GetUsagePath(GetProgramID()), usage)) {
+        LOG_ERROR(Render_OpenGL, "Failed to save shader usage file for title id={}",
+                  GetTitleID());
         return;
     }
+    usage_changed = false;
+}
+
+std::optional<std::size_t> ShaderDiskCache::ExportBundle(u64 program_id,
+                                                         const std::string& path) {
+    const auto raws = LoadTransferableFile(GetTransferablePath(program_id));
+    if (!raws) {
+        LOG_ERROR(Render_OpenGL, "No valid transferable shader cache for title id={:016X}",
+                  program_id);
+        return {};
+    }
+    const ShaderUsageMap usage = LoadUsageFile(GetUsagePath(program_id));
+
+    std::vector<std::pair<u64, const ShaderDiskCacheRaw*>> entries;
+    entries.reserve(raws->size());
+    for (const ShaderDiskCacheRaw& raw : *raws) {
+        const auto it = usage.find(raw.GetUniqueIdentifier());
+        entries.emplace_back(it != usage.end() ? it->second : 0, &raw);
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    FileUtil::IOFile file(path, "wb");
+    const BundleHeader header{BundleMagic, BundleVersion, program_id,
+                              static_cast<u32>(entries.size()), 0};
+    bool written = file.IsOpen() && file.WriteObject(header) == 1;
+    for (auto it = entries.begin(); written && it != entries.end(); ++it) {
+        written = file.WriteObject(it->first) == 1 && it->second->Save(file);
+    }
+    if (!written) {
+        LOG_ERROR(Render_OpenGL, "Failed to write shader cache bundle in path={}", path);
+        file.Close();
+        FileUtil::Delete(path);
+        return {};
+    }
+
+    LOG_INFO(Render_OpenGL, "Exported {} shaders of title id={:016X} to path={}", entries.size(),
+             program_id, path);
+    return entries.size();
+}
+
+std::optional<std::size_t> ShaderDiskCache::ImportBundle(u64 program_id,
+                                                         const std::string& path) {
+    FileUtil::MappedFile mapping(path);
+    if (!mapping.IsOpen()) {
+        LOG_ERROR(Render_OpenGL, "Failed to open shader cache bundle in path={}", path);
+        return {};
+    }
+    FileUtil::MappedFileReader file(mapping);
+
+    BundleHeader header{};
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != BundleMagic || header.version != BundleVersion) {
+        LOG_ERROR(Render_OpenGL, "Invalid shader cache bundle in path={}", path);
+        return {};
+    }
+    if (header.program_id != program_id) {
+        LOG_ERROR(Render_OpenGL, "Shader cache bundle is for title id={:016X}, not {:016X}",
+                  header.program_id, program_id);
+        return {};
+    }
+    // Corrupted bundles could otherwise allocate an enormous number of entries
+    if (header.num_entries > file.GetSize() / sizeof(u64)) {
+        LOG_ERROR(Render_OpenGL, "Invalid shader cache bundle in path={}", path);
+        return {};
+    }
+
+    std::vector<std::pair<u64, ShaderDiskCacheRaw>> entries(header.num_entries);
+    for (auto& [count, raw] : entries) {
+        if (file.ReadBytes(&count, sizeof(count)) != sizeof(count) || !raw.Load(file)) {
+            LOG_ERROR(Render_OpenGL, "Failed to read shader cache bundle in path={}", path);
+            return {};
+        }
+    }
+
+    // A transferable file that can't be loaded would be removed at boot anyway
+    const auto transferable_path{GetTransferablePath(program_id)};
+    std::unordered_set<u64> existing;
+    if (const auto raws = LoadTransferableFile(transferable_path)) {
+        for (const ShaderDiskCacheRaw& raw : *raws) {
+            existing.insert(raw.GetUniqueIdentifier());
+        }
+    } else {
+        FileUtil::Delete(transferable_path);
+    }
+
+    FileUtil::IOFile transferable_file = AppendTransferableFile(transferable_path);
+    if (!transferable_file.IsOpen()) {
+        return {};
+    }
+    ShaderUsageMap usage = LoadUsageFile(GetUsagePath(program_id));
+    std::size_t num_imported = 0;
+    for (const auto& [count, raw] : entries) {
+        const u64 unique_identifier = raw.GetUniqueIdentifier();
+        // Importing the same bundle twice shouldn't count its uses twice
+        u64& local_count = usage[unique_identifier];
+        local_count = std::max(local_count, count);
+        if (!existing.insert(unique_identifier).second) {
+            continue;
+        }
+        if (transferable_file.WriteObject(TransferableEntryKind::Raw) != 1 ||
+            !raw.Save(transferable_file)) {
+            LOG_ERROR(Render_OpenGL, "Failed to write transferable file in path={}",
+                      transferable_path);
+            return {};
+        }
+        ++num_imported;
+    }
+    transferable_file.Close();
+
+    if (!SaveUsageFile(GetUsagePath(program_id), usage)) {
+        LOG_ERROR(Render_OpenGL, "Failed to save shader usage file for title id={:016X}",
+                  program_id);
+    }
+
+    LOG_INFO(Render_OpenGL, "Imported {} new shaders of title id={:016X} from path={}",
+             num_imported, program_id, path);
+    return num_imported;
 }
 
-bool ShaderDiskCache::EnsureDirectories() const {
+bool ShaderDiskCache::EnsureDirectories() {
     const auto CreateDir = [](const std::string& dir) {
         if (!FileUtil::CreateDir(dir)) {
             LOG_ERROR(Render_OpenGL, "Failed to create directory={}", dir);
@@ -453,22 +748,32 @@ bool ShaderDiskCache::EnsureDirectories() const {
 }
 
 std::string ShaderDiskCache::GetTransferablePath() {
-    return FileUtil::SanitizePath(GetTransferableDir() + DIR_SEP_CHR + GetTitleID() + ".bin");
+    return GetTransferablePath(GetProgramID());
+}
+
+std::string ShaderDiskCache::GetTransferablePath(u64 program_id) {
+    return FileUtil::SanitizePath(
+        fmt::format("{}{}{:016X}.bin", GetTransferableDir(), DIR_SEP_CHR, program_id));
+}
+
+std::string ShaderDiskCache::GetUsagePath(u64 program_id) {
+    return FileUtil::SanitizePath(
+        fmt::format("{}{}{:016X}.usage", GetTransferableDir(), DIR_SEP_CHR, program_id));
 }
 
 std::string ShaderDiskCache::GetPrecompiledPath() {
     return FileUtil::SanitizePath(GetPrecompiledDir() + DIR_SEP_CHR + GetTitleID() + ".bin");
 }
 
-std::string ShaderDiskCache::GetTransferableDir() const {
+std::string ShaderDiskCache::GetTransferableDir() {
     return GetBaseDir() + DIR_SEP "transferable";
 }
 
-std::string ShaderDiskCache::GetPrecompiledDir() const {
+std::string ShaderDiskCache::GetPrecompiledDir() {
     return GetBaseDir() + DIR_SEP "precompiled";
 }
 
-std::string ShaderDiskCache::GetBaseDir() const {
+std::string ShaderDiskCache::GetBaseDir() {
     return FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir) + DIR_SEP "opengl";
 }
 
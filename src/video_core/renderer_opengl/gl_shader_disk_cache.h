@@ -19,6 +19,7 @@
 
 #include "common/assert.h"
 #include "common/common_types.h"
+#include "common/file_util.h"
 #include "video_core/regs.h"
 #include "video_core/renderer_opengl/gl_shader_decompiler.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
@@ -27,19 +28,12 @@ namespace Core {
 class System;
 }
 
-namespace FileUtil {
-class IOFile;
-}
-
 namespace OpenGL {
 
-struct ShaderDiskCacheDecompiled;
-struct ShaderDiskCacheDump;
-
 using RawShaderConfig = Pica::Regs;
 using ProgramCode = std::vector<u32>;
-using ShaderDecompiledMap = std::unordered_map<u64, ShaderDiskCacheDecompiled>;
-using ShaderDumpsMap = std::unordered_map<u64, ShaderDiskCacheDump>;
+/// Number of times each shader was bound, by unique identifier
+using ShaderUsageMap = std::unordered_map<u64, u64>;
 
 /// Describes a shader how it's used by the guest GPU
 class ShaderDiskCacheRaw {
@@ -49,7 +43,7 @@ public:
     ShaderDiskCacheRaw() = default;
     ~ShaderDiskCacheRaw() = default;
 
-    bool Load(FileUtil::IOFile& file);
+    bool Load(FileUtil::MappedFileReader& file);
 
     bool Save(FileUtil::IOFile& file) const;
 
@@ -96,8 +90,16 @@ public:
     /// Loads transferable cache. If file has a old version or on failure, it deletes the file.
     std::optional<std::vector<ShaderDiskCacheRaw>> LoadTransferable();
 
-    /// Loads current game's precompiled cache. Invalidates on failure.
-    std::pair<ShaderDecompiledMap, ShaderDumpsMap> LoadPrecompiled();
+    /// Maps current game's precompiled cache and reads its index. The entries are only decompressed
+    /// when they are loaded. Invalidates on failure.
+    void LoadPrecompiled();
+
+    /// Decompresses the decompiled entry of a shader from the precompiled cache. Can be called from
+    /// several threads at once, as long as no entries are being saved.
+    std::optional<ShaderDiskCacheDecompiled> LoadDecompiled(u64 unique_identifier) const;
+
+    /// Decompresses the dumped binary of a shader from the precompiled cache. Same rules as above.
+    std::optional<ShaderDiskCacheDump> LoadDump(u64 unique_identifier) const;
 
     /// Removes the transferable (and precompiled) cache file.
     void InvalidateAll();
@@ -108,55 +110,90 @@ public:
     /// Saves a raw dump to the transferable file. Checks for collisions.
     void SaveRaw(const ShaderDiskCacheRaw& entry);
 
-    /// Saves a decompiled entry to the precompiled file. Does not check for collisions.
+    /// Saves a decompiled entry to the precompiled file. Replaces the previous entry of the shader.
     void SaveDecompiled(u64 unique_identifier, const ShaderDecompiler::ProgramResult& code,
                         bool sanitize_mul);
 
-    /// Saves a dump entry to the precompiled file. Does not check for collisions.
+    /// Saves a dump entry to the precompiled file. Replaces the previous entry of the shader.
     void SaveDump(u64 unique_identifier, GLuint program);
 
     /// Serializes virtual precompiled shader cache file to real file
     void SaveVirtualPrecompiledFile();
 
-private:
-    /// Loads the transferable cache. Returns empty on failure.
-    std::optional<std::pair<ShaderDecompiledMap, ShaderDumpsMap>> LoadPrecompiledFile(
-        FileUtil::IOFile& file);
+    /// Counts a use of a shader for the usage file
+    void CountUse(u64 unique_identifier) {
+        ++usage[unique_identifier];
+        usage_changed = true;
+    }
 
-    /// Loads a decompiled cache entry from m_precompiled_cache_virtual_file. Returns empty on
-    /// failure.
-    std::optional<ShaderDiskCacheDecompiled> LoadDecompiledEntry();
+    /// Returns how many times a shader has been used, across sessions
+    u64 GetUsage(u64 unique_identifier) const;
 
-    /// Saves a decompiled entry to the passed file. Returns true on success.
-    bool SaveDecompiledFile(u64 unique_identifier, const ShaderDecompiler::ProgramResult& code,
-                            bool sanitize_mul);
+    /// Writes the use counts to current game's usage file
+    void SaveUsage();
+
+    /**
+     * Writes the transferable cache of a title to a bundle, together with the use counts of its
+     * shaders. Unlike the precompiled cache, bundles don't depend on the driver and can be shared.
+     * @returns the number of exported shaders, or empty on failure
+     */
+    static std::optional<std::size_t> ExportBundle(u64 program_id, const std::string& path);
+
+    /**
+     * Adds the shaders of a bundle to the transferable cache of a title and merges their use
+     * counts, so that the most used ones are built first on the next boot.
+     * @returns the number of new shaders, or empty if the bundle is invalid or of another title
+     */
+    static std::optional<std::size_t> ImportBundle(u64 program_id, const std::string& path);
+
+private:
+    /// Location of an entry in the precompiled file
+    struct PrecompiledEntry {
+        /// Offset of the compressed entry from the start of the file
+        u64 offset;
+        u32 compressed_size;
+        u32 size;
+        /// The uncompressed entry while it hasn't been written to the precompiled file
+        std::vector<u8> data;
+    };
+    using PrecompiledIndex = std::unordered_map<u64, PrecompiledEntry>;
+
+    /// Reads the index of the mapped precompiled file. Returns false on failure.
+    bool LoadPrecompiledIndex();
+
+    /// Returns the uncompressed data of an entry, or empty if it is missing or corrupted
+    std::optional<std::vector<u8>> LoadPrecompiledEntry(const PrecompiledIndex& index,
+                                                        u64 unique_identifier) const;
 
     /// Returns if the cache can be used
     bool IsUsable() const;
 
-    /// Opens current game's transferable file and write it's header if it doesn't exist
-    FileUtil::IOFile AppendTransferableFile();
-
-    /// Save precompiled header to precompiled_cache_in_memory
-    void SavePrecompiledHeaderToVirtualPrecompiledCache();
+    /// Opens a transferable file and write it's header if it doesn't exist
+    static FileUtil::IOFile AppendTransferableFile(const std::string& transferable_path);
 
     /// Create shader disk cache directories. Returns true on success.
-    bool EnsureDirectories() const;
+    static bool EnsureDirectories();
 
     /// Gets current game's transferable file path
     std::string GetTransferablePath();
 
+    /// Gets the transferable file path of a title
+    static std::string GetTransferablePath(u64 program_id);
+
+    /// Gets the usage file path of a title, which lives next to its transferable file
+    static std::string GetUsagePath(u64 program_id);
+
     /// Gets current game's precompiled file path
     std::string GetPrecompiledPath();
 
     /// Get user's transferable directory path
-    std::string GetTransferableDir() const;
+    static std::string GetTransferableDir();
 
     /// Get user's precompiled directory path
-    std::string GetPrecompiledDir() const;
+    static std::string GetPrecompiledDir();
 
     /// Get user's shader directory path
-    std::string GetBaseDir() const;
+    static std::string GetBaseDir();
 
     /// Get current game's title id as u64
     u64 GetProgramID();
@@ -164,48 +201,19 @@ private:
     /// Get current game's title id
     std::string GetTitleID();
 
-    template <typename T>
-    bool SaveArrayToPrecompiled(const T* data, std::size_t length) {
-        const u8* data_view = reinterpret_cast<const u8*>(data);
-        decompressed_precompiled_cache.insert(decompressed_precompiled_cache.end(), &data_view[0],
-                                              &data_view[length * sizeof(T)]);
-        decompressed_precompiled_cache_offset += length * sizeof(T);
-        return true;
-    }
-
-    template <typename T>
-    bool LoadArrayFromPrecompiled(T* data, std::size_t length) {
-        u8* data_view = reinterpret_cast<u8*>(data);
-        std::copy_n(decompressed_precompiled_cache.data() + decompressed_precompiled_cache_offset,
-                    length * sizeof(T), data_view);
-        decompressed_precompiled_cache_offset += length * sizeof(T);
-        return true;
-    }
-
-    template <typename T>
-    bool SaveObjectToPrecompiled(const T& object) {
-        return SaveArrayToPrecompiled(&object, 1);
-    }
-
-    bool SaveObjectToPrecompiled(bool object) {
-        const auto value = static_cast<u8>(object);
-        return SaveArrayToPrecompiled(&value, 1);
-    }
-
-    template <typename T>
-    bool LoadObjectFromPrecompiled(T& object) {
-        return LoadArrayFromPrecompiled(&object, 1);
-    }
-
-    // Stores whole precompiled cache which will be read from or saved to the precompiled chache
-    // file
-    std::vector<u8> decompressed_precompiled_cache;
-    // Stores the current offset of the precompiled cache file for IO purposes
-    std::size_t decompressed_precompiled_cache_offset = 0;
+    // Mapping of the precompiled file, which the loaded entries are decompressed from
+    FileUtil::MappedFile precompiled_file;
+    // Decompiled and dumped entries of the precompiled file by unique identifier
+    PrecompiledIndex precompiled_decompiled;
+    PrecompiledIndex precompiled_dumps;
 
     // Stored transferable shaders
     std::unordered_map<u64, ShaderDiskCacheRaw> transferable;
 
+    // Use counts loaded from the usage file plus the ones of this session
+    ShaderUsageMap usage;
+    bool usage_changed = false;
+
     // The cache has been loaded at boot
     bool tried_to_load{};
 
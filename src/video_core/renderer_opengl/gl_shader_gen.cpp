@@ -65,6 +65,9 @@ layout (std140) uniform shader_data {
     int proctex_diff_lut_offset;
     float proctex_bias;
     int shadow_texture_bias;
+    int proctex_lut_width;
+    int proctex_lod_min;
+    int proctex_lod_max;
     ivec4 lighting_lut_offset[NUM_LIGHTING_SAMPLERS / 4];
     vec3 fog_color;
     vec2 proctex_noise_f;
@@ -75,6 +78,8 @@ layout (std140) uniform shader_data {
     vec4 const_color[NUM_TEV_STAGES];
     vec4 tev_combiner_buffer_color;
     vec4 clip_coef;
+    vec4 lighting_lut_scales[2];
+    ivec4 proctex_lut_level_offsets;
 };
 )";
 
@@ -169,38 +174,31 @@ PicaFSConfig PicaFSConfig::BuildFromRegs(const Pica::Regs& regs) {
     state.lighting.lut_d0.enable = regs.lighting.config1.disable_lut_d0 == 0;
     state.lighting.lut_d0.abs_input = regs.lighting.abs_lut_input.disable_d0 == 0;
     state.lighting.lut_d0.type = regs.lighting.lut_input.d0.Value();
-    state.lighting.lut_d0.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.d0);
 
     state.lighting.lut_d1.enable = regs.lighting.config1.disable_lut_d1 == 0;
     state.lighting.lut_d1.abs_input = regs.lighting.abs_lut_input.disable_d1 == 0;
     state.lighting.lut_d1.type = regs.lighting.lut_input.d1.Value();
-    state.lighting.lut_d1.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.d1);
 
     // this is a dummy field due to lack of the corresponding register
     state.lighting.lut_sp.enable = true;
     state.lighting.lut_sp.abs_input = regs.lighting.abs_lut_input.disable_sp == 0;
     state.lighting.lut_sp.type = regs.lighting.lut_input.sp.Value();
-    state.lighting.lut_sp.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.sp);
 
     state.lighting.lut_fr.enable = regs.lighting.config1.disable_lut_fr == 0;
     state.lighting.lut_fr.abs_input = regs.lighting.abs_lut_input.disable_fr == 0;
     state.lighting.lut_fr.type = regs.lighting.lut_input.fr.Value();
-    state.lighting.lut_fr.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.fr);
 
     state.lighting.lut_rr.enable = regs.lighting.config1.disable_lut_rr == 0;
     state.lighting.lut_rr.abs_input = regs.lighting.abs_lut_input.disable_rr == 0;
     state.lighting.lut_rr.type = regs.lighting.lut_input.rr.Value();
-    state.lighting.lut_rr.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rr);
 
     state.lighting.lut_rg.enable = regs.lighting.config1.disable_lut_rg == 0;
     state.lighting.lut_rg.abs_input = regs.lighting.abs_lut_input.disable_rg == 0;
     state.lighting.lut_rg.type = regs.lighting.lut_input.rg.Value();
-    state.lighting.lut_rg.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rg);
 
     state.lighting.lut_rb.enable = regs.lighting.config1.disable_lut_rb == 0;
     state.lighting.lut_rb.abs_input = regs.lighting.abs_lut_input.disable_rb == 0;
     state.lighting.lut_rb.type = regs.lighting.lut_input.rb.Value();
-    state.lighting.lut_rb.scale = regs.lighting.lut_scale.GetScale(regs.lighting.lut_scale.rb);
 
     state.lighting.config = regs.lighting.config0.config;
     state.lighting.enable_primary_alpha = regs.lighting.config0.enable_primary_alpha;
@@ -228,13 +226,6 @@ PicaFSConfig PicaFSConfig::BuildFromRegs(const Pica::Regs& regs) {
         state.proctex.noise_enable = regs.texturing.proctex.noise_enable;
         state.proctex.u_shift = regs.texturing.proctex.u_shift;
         state.proctex.v_shift = regs.texturing.proctex.v_shift;
-        state.proctex.lut_width = regs.texturing.proctex_lut.width;
-        state.proctex.lut_offset0 = regs.texturing.proctex_lut_offset.level0;
-        state.proctex.lut_offset1 = regs.texturing.proctex_lut_offset.level1;
-        state.proctex.lut_offset2 = regs.texturing.proctex_lut_offset.level2;
-        state.proctex.lut_offset3 = regs.texturing.proctex_lut_offset.level3;
-        state.proctex.lod_min = regs.texturing.proctex_lut.lod_min;
-        state.proctex.lod_max = regs.texturing.proctex_lut.lod_max;
         state.proctex.lut_filter = regs.texturing.proctex_lut.filter;
     }
 
@@ -283,6 +274,47 @@ void PicaGSConfigCommonRaw::Init(const Pica::Regs& regs) {
     }
 }
 
+u32 GetGSInputVertexCount(const Pica::Regs& regs) {
+    // Only the point mode feeds the geometry shader a fixed number of vertices, which can be
+    // mapped to one of the GL input primitives
+    if (regs.pipeline.gs_config.mode != Pica::PipelineRegs::GSMode::Point ||
+        regs.pipeline.variable_primitive != 0 || regs.gs.input_to_uniform != 0)
+        return 0;
+
+    const u32 attributes_per_vertex = regs.pipeline.vs_outmap_total_minus_1_a + 1;
+    const u32 num_inputs = regs.gs.max_input_attribute_index + 1;
+    if (num_inputs % attributes_per_vertex != 0)
+        return 0;
+
+    const u32 num_vertices = num_inputs / attributes_per_vertex;
+    switch (num_vertices) {
+    case 1:
+    case 2:
+    case 3:
+    case 4:
+    case 6:
+        return num_vertices;
+    default:
+        return 0;
+    }
+}
+
+void PicaGSConfigRaw::Init(const Pica::Regs& regs, Pica::Shader::ShaderSetup& setup) {
+    PicaShaderConfigCommon::Init(regs.gs, setup);
+    PicaGSConfigCommonRaw::Init(regs);
+
+    num_vertices = GetGSInputVertexCount(regs);
+    attributes_per_vertex = regs.pipeline.vs_outmap_total_minus_1_a + 1;
+
+    // The vertices of the primitive are loaded into the input registers one after the other
+    input_map.fill(16);
+    for (u32 attr = 0; attr <= regs.gs.max_input_attribute_index; ++attr) {
+        input_map[regs.gs.GetRegisterForAttribute(attr)] = attr;
+    }
+
+    gs_output_attributes = num_outputs;
+}
+
 /// Detects if a TEV stage is configured to be skipped (to avoid generating unnecessary code)
 static bool IsPassThroughTevStage(const TevStageConfig& stage) {
     return (stage.color_op == TevStageConfig::Operation::Replace &&
@@ -727,6 +759,12 @@ static void WriteLighting(std::string& out, const PicaFSConfig& config) {
         out += "vec4 shadow = vec4(1.0);\n";
     }
 
+    // The LUT scales are uniforms, so games changing them don't need a new shader
+    auto GetLutScale = [](UniformData::Lut lut) {
+        return "lighting_lut_scales[" + std::to_string(lut / 4) + "][" + std::to_string(lut % 4) +
+               "]";
+    };
+
     // Samples the specified lookup table for specular lighting
     auto GetLutValue = [&lighting](LightingRegs::LightingSampler sampler, unsigned light_num,
                                    LightingRegs::LightingLutInput input, bool abs) {
@@ -821,7 +859,7 @@ static void WriteLighting(std::string& out, const PicaFSConfig& config) {
             std::string value =
                 GetLutValue(LightingRegs::SpotlightAttenuationSampler(light_config.num),
                             light_config.num, lighting.lut_sp.type, lighting.lut_sp.abs_input);
-            spot_atten = "(" + std::to_string(lighting.lut_sp.scale) + " * " + value + ")";
+            spot_atten = "(" + GetLutScale(UniformData::LutSP) + " * " + value + ")";
         }
 
         // If enabled, compute distance attenuation value
@@ -850,7 +888,7 @@ static void WriteLighting(std::string& out, const PicaFSConfig& config) {
             std::string value =
                 GetLutValue(LightingRegs::LightingSampler::Distribution0, light_config.num,
                             lighting.lut_d0.type, lighting.lut_d0.abs_input);
-            d0_lut_value = "(" + std::to_string(lighting.lut_d0.scale) + " * " + value + ")";
+            d0_lut_value = "(" + GetLutScale(UniformData::LutD0) + " * " + value + ")";
         }
         std::string specular_0 = "(" + d0_lut_value + " * " + light_src + ".specular_0)";
         if (light_config.geometric_factor_0) {
@@ -864,7 +902,7 @@ static void WriteLighting(std::string& out, const PicaFSConfig& config) {
             std::string value =
                 GetLutValue(LightingRegs::LightingSampler::ReflectRed, light_config.num,
                             lighting.lut_rr.type, lighting.lut_rr.abs_input);
-            value = "(" + std::to_string(lighting.lut_rr.scale) + " * " + value + ")";
+            value = "(" + GetLutScale(UniformData::LutRR) + " * " + value + ")";
             out += "refl_value.r = " + value + ";\n";
         } else {
             out += "refl_value.r = 1.0;\n";
@@ -877,7 +915,7 @@ static void WriteLighting(std::string& out, const PicaFSConfig& config) {
             std::string value =
                 GetLutValue(LightingRegs::LightingSampler::ReflectGreen, light_config.num,
                             lighting.lut_rg.type, lighting.lut_rg.abs_input);
-            value = "(" + std::to_string(lighting.lut_rg.scale) + " * " + value + ")";
+            value = "(" + GetLutScale(UniformData::LutRG) + " * " + value + ")";
             out += "refl_value.g = " + value + ";\n";
         } else {
             out += "refl_value.g = refl_value.r;\n";
@@ -890,7 +928,7 @@ static void WriteLighting(std::string& out, const PicaFSConfig& config) {
             std::string value =
                 GetLutValue(LightingRegs::LightingSampler::ReflectBlue, light_config.num,
                             lighting.lut_rb.type, lighting.lut_rb.abs_input);
-            value = "(" + std::to_string(lighting.lut_rb.scale) + " * " + value + ")";
+            value = "(" + GetLutScale(UniformData::LutRB) + " * " + value + ")";
             out += "refl_value.b = " + value + ";\n";
         } else {
             out += "refl_value.b = refl_value.r;\n";
@@ -905,7 +943,7 @@ static void WriteLighting(std::string& out, const PicaFSConfig& config) {
             std::string value =
                 GetLutValue(LightingRegs::LightingSampler::Distribution1, light_config.num,
                             lighting.lut_d1.type, lighting.lut_d1.abs_input);
-            d1_lut_value = "(" + std::to_string(lighting.lut_d1.scale) + " * " + value + ")";
+            d1_lut_value = "(" + GetLutScale(UniformData::LutD1) + " * " + value + ")";
         }
         std::string specular_1 =
             "(" + d1_lut_value + " * refl_value * " + light_src + ".specular_1)";
@@ -922,7 +960,7 @@ static void WriteLighting(std::string& out, const PicaFSConfig& config) {
             std::string value =
                 GetLutValue(LightingRegs::LightingSampler::Fresnel, light_config.num,
                             lighting.lut_fr.type, lighting.lut_fr.abs_input);
-            value = "(" + std::to_string(lighting.lut_fr.scale) + " * " + value + ")";
+            value = "(" + GetLutScale(UniformData::LutFR) + " * " + value + ")";
 
             // Enabled for diffuse lighting alpha component
             if (lighting.enable_primary_alpha) {
@@ -1116,14 +1154,10 @@ float ProcTexNoiseCoef(vec2 x) {
     }
 
     out += "vec4 SampleProcTexColor(float lut_coord, int level) {\n";
-    out += "int lut_width = " + std::to_string(config.state.proctex.lut_width) + " >> level;\n";
-    std::string offset0 = std::to_string(config.state.proctex.lut_offset0);
-    std::string offset1 = std::to_string(config.state.proctex.lut_offset1);
-    std::string offset2 = std::to_string(config.state.proctex.lut_offset2);
-    std::string offset3 = std::to_string(config.state.proctex.lut_offset3);
+    out += "int lut_width = proctex_lut_width >> level;\n";
     // Offsets for level 4-7 seem to be hardcoded
-    out += "int lut_offsets[8] = int[](" + offset0 + ", " + offset1 + ", " + offset2 + ", " +
-           offset3 + ", 0xF0, 0xF8, 0xFC, 0xFE);\n";
+    out += "int lut_offsets[8] = int[](proctex_lut_level_offsets.x, proctex_lut_level_offsets.y, "
+           "proctex_lut_level_offsets.z, proctex_lut_level_offsets.w, 0xF0, 0xF8, 0xFC, 0xFE);\n";
     out += "int lut_offset = lut_offsets[level];\n";
     // For the color lut, coord=0.0 is lut[offset] and coord=1.0 is lut[offset+width-1]
     out += "lut_coord *= float(lut_width - 1);\n";
@@ -1164,12 +1198,9 @@ float ProcTexNoiseCoef(vec2 x) {
     // Note: this is different from the one normal 2D textures use.
     out += "vec2 duv = max(abs(dFdx(uv)), abs(dFdy(uv)));\n";
     // unlike normal texture, the bias is inside the log2
-    out += "float lod = log2(abs(float(" + std::to_string(config.state.proctex.lut_width) +
-           ") * proctex_bias) * (duv.x + duv.y));\n";
+    out += "float lod = log2(abs(float(proctex_lut_width) * proctex_bias) * (duv.x + duv.y));\n";
     out += "if (proctex_bias == 0.0) lod = 0.0;\n";
-    out += "lod = clamp(lod, " +
-           std::to_string(std::max<float>(0.0f, config.state.proctex.lod_min)) + ", " +
-           std::to_string(std::min<float>(7.0f, config.state.proctex.lod_max)) + ");\n";
+    out += "lod = clamp(lod, float(proctex_lod_min), float(proctex_lod_max));\n";
     // Get shift offset before noise generation
     out += "float u_shift = ";
     AppendProcTexShiftOffset(out, "uv.y", config.state.proctex.u_shift,
@@ -1231,54 +1262,8 @@ float ProcTexNoiseCoef(vec2 x) {
     }
 }
 
-ShaderDecompiler::ProgramResult GenerateFragmentShader(const PicaFSConfig& config,
-                                                       bool separable_shader) {
-    const auto& state = config.state;
-
-    std::string out = R"(
-#extension GL_ARB_shader_image_load_store : enable
-#extension GL_ARB_shader_image_size : enable
-#define ALLOW_SHADOW (defined(GL_ARB_shader_image_load_store) && defined(GL_ARB_shader_image_size))
-)";
-
-    if (separable_shader) {
-        out += "#extension GL_ARB_separate_shader_objects : enable\n";
-    }
-
-    if (GLES) {
-        out += fragment_shader_precision_OES;
-    }
-
-    out += GetVertexInterfaceDeclaration(false, separable_shader);
-
-    out += R"(
-#ifndef CITRA_GLES
-in vec4 gl_FragCoord;
-#endif // CITRA_GLES
-
-out vec4 color;
-
-uniform sampler2D tex0;
-uniform sampler2D tex1;
-uniform sampler2D tex2;
-uniform samplerCube tex_cube;
-uniform samplerBuffer texture_buffer_lut_rg;
-uniform samplerBuffer texture_buffer_lut_rgba;
-
-#if ALLOW_SHADOW
-layout(r32ui) uniform readonly uimage2D shadow_texture_px;
-layout(r32ui) uniform readonly uimage2D shadow_texture_nx;
-layout(r32ui) uniform readonly uimage2D shadow_texture_py;
-layout(r32ui) uniform readonly uimage2D shadow_texture_ny;
-layout(r32ui) uniform readonly uimage2D shadow_texture_pz;
-layout(r32ui) uniform readonly uimage2D shadow_texture_nz;
-layout(r32ui) uniform uimage2D shadow_buffer;
-#endif
-)";
-
-    out += UniformBlockDef;
-
-    out += R"(
+/// Helper functions shared by the specialised and the uber fragment shaders
+static const std::string FragmentShaderHelpers = R"(
 // Rotate the vector v by the quaternion q
 vec3 quaternion_rotate(vec4 q, vec3 v) {
     return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
@@ -1326,8 +1311,58 @@ float getLod(vec2 coord) {
     vec2 d = max(abs(dFdx(coord)), abs(dFdy(coord)));
     return log2(max(d.x, d.y));
 }
+)";
+
+ShaderDecompiler::ProgramResult GenerateFragmentShader(const PicaFSConfig& config,
+                                                       bool separable_shader) {
+    const auto& state = config.state;
+
+    std::string out = R"(
+#extension GL_ARB_shader_image_load_store : enable
+#extension GL_ARB_shader_image_size : enable
+#define ALLOW_SHADOW (defined(GL_ARB_shader_image_load_store) && defined(GL_ARB_shader_image_size))
+)";
+
+    if (separable_shader) {
+        out += "#extension GL_ARB_separate_shader_objects : enable\n";
+    }
+
+    if (GLES) {
+        out += fragment_shader_precision_OES;
+    }
+
+    out += GetVertexInterfaceDeclaration(false, separable_shader);
+
+    out += R"(
+#ifndef CITRA_GLES
+in vec4 gl_FragCoord;
+#endif // CITRA_GLES
+
+out vec4 color;
+
+uniform sampler2D tex0;
+uniform sampler2D tex1;
+uniform sampler2D tex2;
+uniform samplerCube tex_cube;
+uniform samplerBuffer texture_buffer_lut_rg;
+uniform samplerBuffer texture_buffer_lut_rgba;
 
 #if ALLOW_SHADOW
+layout(r32ui) uniform readonly uimage2D shadow_texture_px;
+layout(r32ui) uniform readonly uimage2D shadow_texture_nx;
+layout(r32ui) uniform readonly uimage2D shadow_texture_py;
+layout(r32ui) uniform readonly uimage2D shadow_texture_ny;
+layout(r32ui) uniform readonly uimage2D shadow_texture_pz;
+layout(r32ui) uniform readonly uimage2D shadow_texture_nz;
+layout(r32ui) uniform uimage2D shadow_buffer;
+#endif
+)";
+
+    out += UniformBlockDef;
+    out += FragmentShaderHelpers;
+
+    out += R"(
+#if ALLOW_SHADOW
 
 uvec2 DecodeShadow(uint pixel) {
     return uvec2(pixel >> 8, pixel & 0xFFu);
@@ -1557,24 +1592,28 @@ uint d = uint(clamp(depth, 0.0, 1.0) * 0xFFFFFF);
 uint s = uint(last_tex_env_out.g * 0xFF);
 ivec2 image_coord = ivec2(gl_FragCoord.xy);
 
+// Most fragments don't change the pixel, only those that do pay for an atomic
 uint old = imageLoad(shadow_buffer, image_coord).x;
-uint new;
-uint old2;
-do {
-    old2 = old;
-
+while (true) {
     uvec2 ref = DecodeShadow(old);
-    if (d < ref.x) {
-        if (s == 0u) {
-            ref.x = d;
-        } else {
-            s = uint(float(s) / (shadow_bias_constant + shadow_bias_linear * float(d) / float(ref.x)));
-            ref.y = min(s, ref.y);
+    if (d >= ref.x) {
+        break;
+    }
+    if (s == 0u) {
+        ref.x = d;
+    } else {
+        uint biased = uint(float(s) / (shadow_bias_constant + shadow_bias_linear * float(d) / float(ref.x)));
+        if (biased >= ref.y) {
+            break;
         }
+        ref.y = biased;
     }
-    new = EncodeShadow(ref);
-
-} while ((old = imageAtomicCompSwap(shadow_buffer, image_coord, old, new)) != old2);
+    uint current = imageAtomicCompSwap(shadow_buffer, image_coord, old, EncodeShadow(ref));
+    if (current == old) {
+        break;
+    }
+    old = current;
+}
 #endif // ALLOW_SHADOW
 )";
     } else {
@@ -1588,6 +1627,558 @@ do {
     return {out};
 }
 
+bool IsUberFragmentShaderCompatible(const PicaFSConfig& config) {
+    const auto& state = config.state;
+    return !state.proctex.enable && !state.shadow_rendering &&
+           state.fog_mode != TexturingRegs::FogMode::Gas &&
+           state.texture0_type != TexturingRegs::TextureConfig::Shadow2D &&
+           state.texture0_type != TexturingRegs::TextureConfig::ShadowCube;
+}
+
+ShaderDecompiler::ProgramResult GenerateUberFragmentShader(bool separable_shader) {
+    std::string out;
+
+    if (separable_shader) {
+        out += "#extension GL_ARB_separate_shader_objects : enable\n";
+    }
+
+    if (GLES) {
+        out += fragment_shader_precision_OES;
+    }
+
+    // The shader switches over the raw PICA enum values, so give them names
+    const auto define = [&out](const char* name, auto value) {
+        out += "#define " + std::string(name) + " " + std::to_string(static_cast<u32>(value));
+        out += '\n';
+    };
+    using Source = TevStageConfig::Source;
+    using ColorModifier = TevStageConfig::ColorModifier;
+    using AlphaModifier = TevStageConfig::AlphaModifier;
+    using Operation = TevStageConfig::Operation;
+    using CompareFunc = FramebufferRegs::CompareFunc;
+    using LutInput = LightingRegs::LightingLutInput;
+    using TextureType = TexturingRegs::TextureConfig::TextureType;
+    define("SOURCE_PRIMARY_COLOR", Source::PrimaryColor);
+    define("SOURCE_PRIMARY_FRAGMENT_COLOR", Source::PrimaryFragmentColor);
+    define("SOURCE_SECONDARY_FRAGMENT_COLOR", Source::SecondaryFragmentColor);
+    define("SOURCE_TEXTURE0", Source::Texture0);
+    define("SOURCE_TEXTURE1", Source::Texture1);
+    define("SOURCE_TEXTURE2", Source::Texture2);
+    define("SOURCE_TEXTURE3", Source::Texture3);
+    define("SOURCE_PREVIOUS_BUFFER", Source::PreviousBuffer);
+    define("SOURCE_CONSTANT", Source::Constant);
+    define("SOURCE_PREVIOUS", Source::Previous);
+    define("COLOR_MODIFIER_SOURCE_COLOR", ColorModifier::SourceColor);
+    define("COLOR_MODIFIER_ONE_MINUS_SOURCE_COLOR", ColorModifier::OneMinusSourceColor);
+    define("COLOR_MODIFIER_SOURCE_ALPHA", ColorModifier::SourceAlpha);
+    define("COLOR_MODIFIER_ONE_MINUS_SOURCE_ALPHA", ColorModifier::OneMinusSourceAlpha);
+    define("COLOR_MODIFIER_SOURCE_RED", ColorModifier::SourceRed);
+    define("COLOR_MODIFIER_ONE_MINUS_SOURCE_RED", ColorModifier::OneMinusSourceRed);
+    define("COLOR_MODIFIER_SOURCE_GREEN", ColorModifier::SourceGreen);
+    define("COLOR_MODIFIER_ONE_MINUS_SOURCE_GREEN", ColorModifier::OneMinusSourceGreen);
+    define("COLOR_MODIFIER_SOURCE_BLUE", ColorModifier::SourceBlue);
+    define("COLOR_MODIFIER_ONE_MINUS_SOURCE_BLUE", ColorModifier::OneMinusSourceBlue);
+    define("ALPHA_MODIFIER_SOURCE_ALPHA", AlphaModifier::SourceAlpha);
+    define("ALPHA_MODIFIER_ONE_MINUS_SOURCE_ALPHA", AlphaModifier::OneMinusSourceAlpha);
+    define("ALPHA_MODIFIER_SOURCE_RED", AlphaModifier::SourceRed);
+    define("ALPHA_MODIFIER_ONE_MINUS_SOURCE_RED", AlphaModifier::OneMinusSourceRed);
+    define("ALPHA_MODIFIER_SOURCE_GREEN", AlphaModifier::SourceGreen);
+    define("ALPHA_MODIFIER_ONE_MINUS_SOURCE_GREEN", AlphaModifier::OneMinusSourceGreen);
+    define("ALPHA_MODIFIER_SOURCE_BLUE", AlphaModifier::SourceBlue);
+    define("ALPHA_MODIFIER_ONE_MINUS_SOURCE_BLUE", AlphaModifier::OneMinusSourceBlue);
+    define("OPERATION_REPLACE", Operation::Replace);
+    define("OPERATION_MODULATE", Operation::Modulate);
+    define("OPERATION_ADD", Operation::Add);
+    define("OPERATION_ADD_SIGNED", Operation::AddSigned);
+    define("OPERATION_LERP", Operation::Lerp);
+    define("OPERATION_SUBTRACT", Operation::Subtract);
+    define("OPERATION_DOT3_RGB", Operation::Dot3_RGB);
+    define("OPERATION_DOT3_RGBA", Operation::Dot3_RGBA);
+    define("OPERATION_MULTIPLY_THEN_ADD", Operation::MultiplyThenAdd);
+    define("OPERATION_ADD_THEN_MULTIPLY", Operation::AddThenMultiply);
+    define("COMPARE_NEVER", CompareFunc::Never);
+    define("COMPARE_ALWAYS", CompareFunc::Always);
+    define("COMPARE_EQUAL", CompareFunc::Equal);
+    define("COMPARE_NOT_EQUAL", CompareFunc::NotEqual);
+    define("COMPARE_LESS_THAN", CompareFunc::LessThan);
+    define("COMPARE_LESS_THAN_OR_EQUAL", CompareFunc::LessThanOrEqual);
+    define("COMPARE_GREATER_THAN", CompareFunc::GreaterThan);
+    define("COMPARE_GREATER_THAN_OR_EQUAL", CompareFunc::GreaterThanOrEqual);
+    define("SCISSOR_DISABLED", RasterizerRegs::ScissorMode::Disabled);
+    define("SCISSOR_INCLUDE", RasterizerRegs::ScissorMode::Include);
+    define("W_BUFFERING", RasterizerRegs::DepthBuffering::WBuffering);
+    define("FOG_MODE_FOG", TexturingRegs::FogMode::Fog);
+    define("TEXTURE_2D", TextureType::Texture2D);
+    define("TEXTURE_PROJECTION_2D", TextureType::Projection2D);
+    define("TEXTURE_CUBE", TextureType::TextureCube);
+    define("LUT_INPUT_NH", LutInput::NH);
+    define("LUT_INPUT_VH", LutInput::VH);
+    define("LUT_INPUT_NV", LutInput::NV);
+    define("LUT_INPUT_LN", LutInput::LN);
+    define("LUT_INPUT_SP", LutInput::SP);
+    define("LUT_INPUT_CP", LutInput::CP);
+    define("LIGHTING_CONFIG7", LightingRegs::LightingConfig::Config7);
+    define("BUMP_MODE_NORMAL_MAP", LightingRegs::LightingBumpMode::NormalMap);
+    define("BUMP_MODE_TANGENT_MAP", LightingRegs::LightingBumpMode::TangentMap);
+    define("DISTANCE_ATTENUATION_SAMPLER", LightingRegs::LightingSampler::DistanceAttenuation);
+    define("LIGHT_DIRECTIONAL", FSUberUniformData::LightDirectional);
+    define("LIGHT_TWO_SIDED_DIFFUSE", FSUberUniformData::LightTwoSidedDiffuse);
+    define("LIGHT_DIST_ATTEN", FSUberUniformData::LightDistAtten);
+    define("LIGHT_SPOT_ATTEN", FSUberUniformData::LightSpotAtten);
+    define("LIGHT_GEOMETRIC_FACTOR_0", FSUberUniformData::LightGeometricFactor0);
+    define("LIGHT_GEOMETRIC_FACTOR_1", FSUberUniformData::LightGeometricFactor1);
+    define("LIGHT_SHADOW", FSUberUniformData::LightShadow);
+    define("LUT_D0", UniformData::LutD0);
+    define("LUT_D1", UniformData::LutD1);
+    define("LUT_SP", UniformData::LutSP);
+    define("LUT_FR", UniformData::LutFR);
+    define("LUT_RR", UniformData::LutRR);
+    define("LUT_RG", UniformData::LutRG);
+    define("LUT_RB", UniformData::LutRB);
+
+    out += GetVertexInterfaceDeclaration(false, separable_shader);
+
+    out += R"(
+#ifndef CITRA_GLES
+in vec4 gl_FragCoord;
+#endif // CITRA_GLES
+
+out vec4 color;
+
+uniform sampler2D tex0;
+uniform sampler2D tex1;
+uniform sampler2D tex2;
+uniform samplerCube tex_cube;
+uniform samplerBuffer texture_buffer_lut_rg;
+uniform samplerBuffer texture_buffer_lut_rgba;
+)";
+
+    out += UniformBlockDef;
+
+    out += R"(
+layout (std140) uniform fs_uber_config {
+    ivec4 tev_color_sources[NUM_TEV_STAGES];   // xyz: sources, w: operation
+    ivec4 tev_alpha_sources[NUM_TEV_STAGES];   // xyz: sources, w: operation
+    ivec4 tev_color_modifiers[NUM_TEV_STAGES]; // xyz: modifiers, w: multiplier
+    ivec4 tev_alpha_modifiers[NUM_TEV_STAGES]; // xyz: modifiers, w: multiplier
+    int combiner_buffer_input;
+    int alpha_test_func;
+    int scissor_test_mode;
+    int texture0_type;
+    int texture2_use_coord1;
+    int depthmap_enable;
+    int fog_mode;
+    int fog_flip;
+    int lighting_enable;
+    int lighting_src_num;
+    int lighting_bump_mode;
+    int lighting_bump_selector;
+    int lighting_bump_renorm;
+    int lighting_clamp_highlights;
+    int lighting_config;
+    int lighting_enable_primary_alpha;
+    int lighting_enable_secondary_alpha;
+    int lighting_enable_shadow;
+    int lighting_shadow_primary;
+    int lighting_shadow_secondary;
+    int lighting_shadow_invert;
+    int lighting_shadow_alpha;
+    int lighting_shadow_selector;
+    ivec4 lighting_lights[NUM_LIGHTS]; // x: light number, y: flags
+    ivec4 lighting_luts[7];            // x: enabled, y: absolute input, z: input, w: sampler
+};
+)";
+
+    out += FragmentShaderHelpers;
+
+    out += R"(
+vec4 rounded_primary_color;
+vec4 primary_fragment_color = vec4(0.0);
+vec4 secondary_fragment_color = vec4(0.0);
+vec4 texture_color[4];
+vec4 combiner_buffer = vec4(0.0);
+vec4 last_tex_env_out = vec4(0.0);
+
+vec3 normal;
+vec3 tangent;
+vec3 light_vector;
+vec3 spot_dir;
+vec3 half_vector;
+
+vec4 SampleTexture0() {
+    if (texture0_type == TEXTURE_2D)
+        return textureLod(tex0, texcoord0, getLod(texcoord0 * vec2(textureSize(tex0, 0))));
+    if (texture0_type == TEXTURE_PROJECTION_2D)
+        return textureProj(tex0, vec3(texcoord0, texcoord0_w));
+    if (texture0_type == TEXTURE_CUBE)
+        return texture(tex_cube, vec3(texcoord0, texcoord0_w));
+    return vec4(0.0);
+}
+
+vec4 SampleTexture2() {
+    vec2 coord = texture2_use_coord1 != 0 ? texcoord1 : texcoord2;
+    return textureLod(tex2, coord, getLod(coord * vec2(textureSize(tex2, 0))));
+}
+
+vec4 GetSource(int source, int stage) {
+    switch (source) {
+    case SOURCE_PRIMARY_COLOR: return rounded_primary_color;
+    case SOURCE_PRIMARY_FRAGMENT_COLOR: return primary_fragment_color;
+    case SOURCE_SECONDARY_FRAGMENT_COLOR: return secondary_fragment_color;
+    case SOURCE_TEXTURE0: return texture_color[0];
+    case SOURCE_TEXTURE1: return texture_color[1];
+    case SOURCE_TEXTURE2: return texture_color[2];
+    case SOURCE_TEXTURE3: return texture_color[3];
+    case SOURCE_PREVIOUS_BUFFER: return combiner_buffer;
+    case SOURCE_CONSTANT: return const_color[stage];
+    case SOURCE_PREVIOUS: return last_tex_env_out;
+    }
+    return vec4(0.0);
+}
+
+vec3 GetColorModifier(int modifier, vec4 value) {
+    switch (modifier) {
+    case COLOR_MODIFIER_SOURCE_COLOR: return value.rgb;
+    case COLOR_MODIFIER_ONE_MINUS_SOURCE_COLOR: return vec3(1.0) - value.rgb;
+    case COLOR_MODIFIER_SOURCE_ALPHA: return value.aaa;
+    case COLOR_MODIFIER_ONE_MINUS_SOURCE_ALPHA: return vec3(1.0) - value.aaa;
+    case COLOR_MODIFIER_SOURCE_RED: return value.rrr;
+    case COLOR_MODIFIER_ONE_MINUS_SOURCE_RED: return vec3(1.0) - value.rrr;
+    case COLOR_MODIFIER_SOURCE_GREEN: return value.ggg;
+    case COLOR_MODIFIER_ONE_MINUS_SOURCE_GREEN: return vec3(1.0) - value.ggg;
+    case COLOR_MODIFIER_SOURCE_BLUE: return value.bbb;
+    case COLOR_MODIFIER_ONE_MINUS_SOURCE_BLUE: return vec3(1.0) - value.bbb;
+    }
+    return vec3(0.0);
+}
+
+float GetAlphaModifier(int modifier, vec4 value) {
+    switch (modifier) {
+    case ALPHA_MODIFIER_SOURCE_ALPHA: return value.a;
+    case ALPHA_MODIFIER_ONE_MINUS_SOURCE_ALPHA: return 1.0 - value.a;
+    case ALPHA_MODIFIER_SOURCE_RED: return value.r;
+    case ALPHA_MODIFIER_ONE_MINUS_SOURCE_RED: return 1.0 - value.r;
+    case ALPHA_MODIFIER_SOURCE_GREEN: return value.g;
+    case ALPHA_MODIFIER_ONE_MINUS_SOURCE_GREEN: return 1.0 - value.g;
+    case ALPHA_MODIFIER_SOURCE_BLUE: return value.b;
+    case ALPHA_MODIFIER_ONE_MINUS_SOURCE_BLUE: return 1.0 - value.b;
+    }
+    return 0.0;
+}
+
+vec3 CombineColor(int operation, vec3 v[3]) {
+    switch (operation) {
+    case OPERATION_REPLACE: return v[0];
+    case OPERATION_MODULATE: return v[0] * v[1];
+    case OPERATION_ADD: return v[0] + v[1];
+    case OPERATION_ADD_SIGNED: return v[0] + v[1] - vec3(0.5);
+    case OPERATION_LERP: return v[0] * v[2] + v[1] * (vec3(1.0) - v[2]);
+    case OPERATION_SUBTRACT: return v[0] - v[1];
+    case OPERATION_MULTIPLY_THEN_ADD: return v[0] * v[1] + v[2];
+    case OPERATION_ADD_THEN_MULTIPLY: return min(v[0] + v[1], vec3(1.0)) * v[2];
+    case OPERATION_DOT3_RGB:
+    case OPERATION_DOT3_RGBA: return vec3(dot(v[0] - vec3(0.5), v[1] - vec3(0.5)) * 4.0);
+    }
+    return vec3(0.0);
+}
+
+float CombineAlpha(int operation, float v[3]) {
+    switch (operation) {
+    case OPERATION_REPLACE: return v[0];
+    case OPERATION_MODULATE: return v[0] * v[1];
+    case OPERATION_ADD: return v[0] + v[1];
+    case OPERATION_ADD_SIGNED: return v[0] + v[1] - 0.5;
+    case OPERATION_LERP: return v[0] * v[2] + v[1] * (1.0 - v[2]);
+    case OPERATION_SUBTRACT: return v[0] - v[1];
+    case OPERATION_MULTIPLY_THEN_ADD: return v[0] * v[1] + v[2];
+    case OPERATION_ADD_THEN_MULTIPLY: return min(v[0] + v[1], 1.0) * v[2];
+    }
+    return 0.0;
+}
+
+bool AlphaTestFails(float alpha) {
+    int value = int(alpha * 255.0);
+    switch (alpha_test_func) {
+    case COMPARE_NEVER: return true;
+    case COMPARE_EQUAL: return value != alphatest_ref;
+    case COMPARE_NOT_EQUAL: return value == alphatest_ref;
+    case COMPARE_LESS_THAN: return value >= alphatest_ref;
+    case COMPARE_LESS_THAN_OR_EQUAL: return value > alphatest_ref;
+    case COMPARE_GREATER_THAN: return value <= alphatest_ref;
+    case COMPARE_GREATER_THAN_OR_EQUAL: return value < alphatest_ref;
+    }
+    return false;
+}
+
+float GetLutValue(int lut, int sampler_index, bool two_sided) {
+    ivec4 lut_config = lighting_luts[lut];
+    float index = 0.0;
+    switch (lut_config.z) {
+    case LUT_INPUT_NH:
+        index = dot(normal, normalize(half_vector));
+        break;
+    case LUT_INPUT_VH:
+        index = dot(normalize(view), normalize(half_vector));
+        break;
+    case LUT_INPUT_NV:
+        index = dot(normal, normalize(view));
+        break;
+    case LUT_INPUT_LN:
+        index = dot(light_vector, normal);
+        break;
+    case LUT_INPUT_SP:
+        index = dot(light_vector, spot_dir);
+        break;
+    case LUT_INPUT_CP:
+        // CP input is only available with configuration 7
+        if (lighting_config == LIGHTING_CONFIG7) {
+            vec3 half_angle_proj = normalize(half_vector) -
+                                   normal * dot(normal, normalize(half_vector));
+            index = dot(half_angle_proj, tangent);
+        }
+        break;
+    }
+
+    float value;
+    if (lut_config.y != 0) {
+        value = LookupLightingLUTUnsigned(sampler_index, two_sided ? abs(index) : max(index, 0.0));
+    } else {
+        value = LookupLightingLUTSigned(sampler_index, index);
+    }
+    return lighting_lut_scales[lut >> 2][lut & 3] * value;
+}
+
+void WriteLighting() {
+    vec4 diffuse_sum = vec4(0.0, 0.0, 0.0, 1.0);
+    vec4 specular_sum = vec4(0.0, 0.0, 0.0, 1.0);
+    vec3 refl_value = vec3(0.0);
+    float clamp_highlights = 1.0;
+    float geo_factor = 1.0;
+
+    // Compute fragment normals and tangents
+    vec3 surface_normal = vec3(0.0, 0.0, 1.0);
+    vec3 surface_tangent = vec3(1.0, 0.0, 0.0);
+    if (lighting_bump_mode == BUMP_MODE_NORMAL_MAP) {
+        surface_normal = 2.0 * texture_color[lighting_bump_selector].rgb - 1.0;
+        if (lighting_bump_renorm != 0) {
+            float val = 1.0 - (surface_normal.x * surface_normal.x +
+                               surface_normal.y * surface_normal.y);
+            surface_normal.z = sqrt(max(val, 0.0));
+        }
+    } else if (lighting_bump_mode == BUMP_MODE_TANGENT_MAP) {
+        surface_tangent = 2.0 * texture_color[lighting_bump_selector].rgb - 1.0;
+    }
+
+    vec4 normalized_normquat = normalize(normquat);
+    normal = quaternion_rotate(normalized_normquat, surface_normal);
+    tangent = quaternion_rotate(normalized_normquat, surface_tangent);
+
+    vec4 shadow = vec4(1.0);
+    if (lighting_enable_shadow != 0) {
+        shadow = texture_color[lighting_shadow_selector];
+        if (lighting_shadow_invert != 0) {
+            shadow = vec4(1.0) - shadow;
+        }
+    }
+
+    for (int i = 0; i < lighting_src_num; ++i) {
+        int num = lighting_lights[i].x;
+        int flags = lighting_lights[i].y;
+        // Like the specialised shader, the LUT input range is picked with the flags of the slot
+        // that matches the light number
+        bool lut_two_sided = (lighting_lights[num].y & LIGHT_TWO_SIDED_DIFFUSE) != 0;
+
+        if ((flags & LIGHT_DIRECTIONAL) != 0)
+            light_vector = normalize(light_src[num].position);
+        else
+            light_vector = normalize(light_src[num].position + view);
+
+        spot_dir = light_src[num].spot_direction;
+        half_vector = normalize(view) + light_vector;
+
+        float dot_product = (flags & LIGHT_TWO_SIDED_DIFFUSE) != 0
+                                ? abs(dot(light_vector, normal))
+                                : max(dot(light_vector, normal), 0.0);
+
+        if (lighting_clamp_highlights != 0) {
+            clamp_highlights = sign(dot_product);
+        }
+
+        float spot_atten = 1.0;
+        if ((flags & LIGHT_SPOT_ATTEN) != 0 && lighting_luts[LUT_SP].x != 0) {
+            spot_atten = GetLutValue(LUT_SP, lighting_luts[LUT_SP].w + num, lut_two_sided);
+        }
+
+        float dist_atten = 1.0;
+        if ((flags & LIGHT_DIST_ATTEN) != 0) {
+            float index = clamp(light_src[num].dist_atten_scale *
+                                    length(-view - light_src[num].position) +
+                                    light_src[num].dist_atten_bias, 0.0, 1.0);
+            dist_atten = LookupLightingLUTUnsigned(DISTANCE_ATTENUATION_SAMPLER + num, index);
+        }
+
+        if ((flags & (LIGHT_GEOMETRIC_FACTOR_0 | LIGHT_GEOMETRIC_FACTOR_1)) != 0) {
+            geo_factor = dot(half_vector, half_vector);
+            geo_factor = geo_factor == 0.0 ? 0.0 : min(dot_product / geo_factor, 1.0);
+        }
+
+        float d0_lut_value = 1.0;
+        if (lighting_luts[LUT_D0].x != 0) {
+            d0_lut_value = GetLutValue(LUT_D0, lighting_luts[LUT_D0].w, lut_two_sided);
+        }
+        vec3 specular_0 = d0_lut_value * light_src[num].specular_0;
+        if ((flags & LIGHT_GEOMETRIC_FACTOR_0) != 0) {
+            specular_0 *= geo_factor;
+        }
+
+        refl_value.r = 1.0;
+        if (lighting_luts[LUT_RR].x != 0) {
+            refl_value.r = GetLutValue(LUT_RR, lighting_luts[LUT_RR].w, lut_two_sided);
+        }
+        refl_value.g = refl_value.r;
+        if (lighting_luts[LUT_RG].x != 0) {
+            refl_value.g = GetLutValue(LUT_RG, lighting_luts[LUT_RG].w, lut_two_sided);
+        }
+        refl_value.b = refl_value.r;
+        if (lighting_luts[LUT_RB].x != 0) {
+            refl_value.b = GetLutValue(LUT_RB, lighting_luts[LUT_RB].w, lut_two_sided);
+        }
+
+        float d1_lut_value = 1.0;
+        if (lighting_luts[LUT_D1].x != 0) {
+            d1_lut_value = GetLutValue(LUT_D1, lighting_luts[LUT_D1].w, lut_two_sided);
+        }
+        vec3 specular_1 = d1_lut_value * refl_value * light_src[num].specular_1;
+        if ((flags & LIGHT_GEOMETRIC_FACTOR_1) != 0) {
+            specular_1 *= geo_factor;
+        }
+
+        // Only the last entry in the light slots applies the Fresnel factor
+        if (i == lighting_src_num - 1 && lighting_luts[LUT_FR].x != 0) {
+            float value = GetLutValue(LUT_FR, lighting_luts[LUT_FR].w, lut_two_sided);
+            if (lighting_enable_primary_alpha != 0) {
+                diffuse_sum.a = value;
+            }
+            if (lighting_enable_secondary_alpha != 0) {
+                specular_sum.a = value;
+            }
+        }
+
+        bool light_shadow = (flags & LIGHT_SHADOW) != 0;
+        vec3 shadow_primary = lighting_shadow_primary != 0 && light_shadow ? shadow.rgb : vec3(1.0);
+        vec3 shadow_secondary =
+            lighting_shadow_secondary != 0 && light_shadow ? shadow.rgb : vec3(1.0);
+
+        diffuse_sum.rgb += ((light_src[num].diffuse * dot_product) + light_src[num].ambient) *
+                           dist_atten * spot_atten * shadow_primary;
+        specular_sum.rgb += (specular_0 + specular_1) * clamp_highlights * dist_atten *
+                            spot_atten * shadow_secondary;
+    }
+
+    if (lighting_shadow_alpha != 0) {
+        if (lighting_enable_primary_alpha != 0) {
+            diffuse_sum.a *= shadow.a;
+        }
+        if (lighting_enable_secondary_alpha != 0) {
+            specular_sum.a *= shadow.a;
+        }
+    }
+
+    diffuse_sum.rgb += lighting_global_ambient;
+    primary_fragment_color = clamp(diffuse_sum, vec4(0.0), vec4(1.0));
+    secondary_fragment_color = clamp(specular_sum, vec4(0.0), vec4(1.0));
+}
+
+void main() {
+    if (alpha_test_func == COMPARE_NEVER) {
+        discard;
+    }
+
+    if (scissor_test_mode != SCISSOR_DISABLED) {
+        bool inside = gl_FragCoord.x >= float(scissor_x1) && gl_FragCoord.y >= float(scissor_y1) &&
+                      gl_FragCoord.x < float(scissor_x2) && gl_FragCoord.y < float(scissor_y2);
+        if (inside != (scissor_test_mode == SCISSOR_INCLUDE)) {
+            discard;
+        }
+    }
+
+    float z_over_w = 2.0 * gl_FragCoord.z - 1.0;
+    float depth = z_over_w * depth_scale + depth_offset;
+    if (depthmap_enable == W_BUFFERING) {
+        depth /= gl_FragCoord.w;
+    }
+
+    rounded_primary_color = byteround(primary_color);
+    texture_color[0] = SampleTexture0();
+    texture_color[1] = textureLod(tex1, texcoord1, getLod(texcoord1 * vec2(textureSize(tex1, 0))));
+    texture_color[2] = SampleTexture2();
+    texture_color[3] = vec4(0.0);
+
+    if (lighting_enable != 0) {
+        WriteLighting();
+    }
+
+    vec4 next_combiner_buffer = tev_combiner_buffer_color;
+    for (int i = 0; i < NUM_TEV_STAGES; ++i) {
+        ivec4 color_sources = tev_color_sources[i];
+        ivec4 color_modifiers = tev_color_modifiers[i];
+        vec3 color_results[3] = vec3[3](
+            GetColorModifier(color_modifiers.x, GetSource(color_sources.x, i)),
+            GetColorModifier(color_modifiers.y, GetSource(color_sources.y, i)),
+            GetColorModifier(color_modifiers.z, GetSource(color_sources.z, i)));
+        vec3 color_output = byteround(
+            clamp(CombineColor(color_sources.w, color_results), vec3(0.0), vec3(1.0)));
+
+        ivec4 alpha_sources = tev_alpha_sources[i];
+        ivec4 alpha_modifiers = tev_alpha_modifiers[i];
+        float alpha_output;
+        if (color_sources.w == OPERATION_DOT3_RGBA) {
+            // Result of the Dot3_RGBA operation is also placed to the alpha component
+            alpha_output = color_output.r;
+        } else {
+            float alpha_results[3] = float[3](
+                GetAlphaModifier(alpha_modifiers.x, GetSource(alpha_sources.x, i)),
+                GetAlphaModifier(alpha_modifiers.y, GetSource(alpha_sources.y, i)),
+                GetAlphaModifier(alpha_modifiers.z, GetSource(alpha_sources.z, i)));
+            alpha_output =
+                byteround(clamp(CombineAlpha(alpha_sources.w, alpha_results), 0.0, 1.0));
+        }
+
+        last_tex_env_out =
+            vec4(clamp(color_output * float(color_modifiers.w), vec3(0.0), vec3(1.0)),
+                 clamp(alpha_output * float(alpha_modifiers.w), 0.0, 1.0));
+
+        combiner_buffer = next_combiner_buffer;
+        // Only the first four stages can update the combiner buffer
+        if (i < 4 && ((combiner_buffer_input >> i) & 1) != 0) {
+            next_combiner_buffer.rgb = last_tex_env_out.rgb;
+        }
+        if (i < 4 && ((combiner_buffer_input >> (i + 4)) & 1) != 0) {
+            next_combiner_buffer.a = last_tex_env_out.a;
+        }
+    }
+
+    if (AlphaTestFails(last_tex_env_out.a)) {
+        discard;
+    }
+
+    if (fog_mode == FOG_MODE_FOG) {
+        float fog_index = (fog_flip != 0 ? 1.0 - depth : depth) * 128.0;
+        float fog_i = clamp(floor(fog_index), 0.0, 127.0);
+        float fog_f = fog_index - fog_i;
+        vec2 fog_lut_entry = texelFetch(texture_buffer_lut_rg, int(fog_i) + fog_lut_offset).rg;
+        float fog_factor = clamp(fog_lut_entry.r + fog_lut_entry.g * fog_f, 0.0, 1.0);
+        last_tex_env_out.rgb = mix(fog_color.rgb, last_tex_env_out.rgb, fog_factor);
+    }
+
+    gl_FragDepth = depth;
+    color = byteround(last_tex_env_out);
+}
+)";
+
+    return {out};
+}
+
 ShaderDecompiler::ProgramResult GenerateTrivialVertexShader(bool separable_shader) {
     std::string out = "";
     if (separable_shader) {
@@ -1660,7 +2251,7 @@ std::optional<ShaderDecompiler::ProgramResult> GenerateVertexShader(
 
     auto program_source_opt = ShaderDecompiler::DecompileProgram(
         setup.program_code, setup.swizzle_data, config.state.main_offset, get_input_reg,
-        get_output_reg, config.state.sanitize_mul);
+        get_output_reg, config.state.sanitize_mul, false);
 
     if (!program_source_opt)
         return {};
@@ -1818,4 +2409,113 @@ void main() {
 
     return {out};
 }
+
+std::optional<ShaderDecompiler::ProgramResult> GenerateGeometryShader(
+    const Pica::Shader::ShaderSetup& setup, const PicaGSConfig& config, bool separable_shader) {
+    const auto& state = config.state;
+    std::string out = "";
+    if (separable_shader) {
+        out += "#extension GL_ARB_separate_shader_objects : enable\n\n";
+    }
+
+    switch (state.num_vertices) {
+    case 1:
+        out += "layout(points) in;\n";
+        break;
+    case 2:
+        out += "layout(lines) in;\n";
+        break;
+    case 3:
+        out += "layout(triangles) in;\n";
+        break;
+    case 4:
+        out += "layout(lines_adjacency) in;\n";
+        break;
+    case 6:
+        out += "layout(triangles_adjacency) in;\n";
+        break;
+    default:
+        LOG_ERROR(Render_OpenGL, "Unsupported geometry shader input vertex count {}",
+                  state.num_vertices);
+        return {};
+    }
+    // Ten triangles keep the output within the minimum GL_MAX_GEOMETRY_TOTAL_OUTPUT_COMPONENTS
+    out += "layout(triangle_strip, max_vertices = 30) out;\n\n";
+
+    out += GetGSCommonSource(state, separable_shader);
+
+    auto get_input_reg = [&](u32 reg) -> std::string {
+        ASSERT(reg < 16);
+        const u32 attr = state.input_map[reg];
+        const u32 vertex = attr / state.attributes_per_vertex;
+        const u32 vertex_attr = attr % state.attributes_per_vertex;
+        if (attr < 16 && vertex_attr < state.vs_output_attributes) {
+            return "vs_out_attr" + std::to_string(vertex_attr) + "[" + std::to_string(vertex) +
+                   "]";
+        }
+        return "vec4(0.0, 0.0, 0.0, 1.0)";
+    };
+
+    auto get_output_reg = [&](u32 reg) -> std::string {
+        ASSERT(reg < 16);
+        if (state.output_map[reg] < state.num_outputs) {
+            return "output_buffer.attributes[" + std::to_string(state.output_map[reg]) + "]";
+        }
+        return "";
+    };
+
+    auto program_source_opt = ShaderDecompiler::DecompileProgram(
+        setup.program_code, setup.swizzle_data, state.main_offset, get_input_reg, get_output_reg,
+        state.sanitize_mul, true);
+
+    if (!program_source_opt)
+        return {};
+
+    std::string& program_source = program_source_opt->code;
+
+    out += R"(
+#define uniforms gs_uniforms
+layout (std140) uniform gs_config {
+    pica_uniforms uniforms;
+};
+
+Vertex output_buffer;
+Vertex prim_buffer[3];
+uint vertex_id = 0u;
+bool prim_emit = false;
+bool winding = false;
+uint emitted_prims = 0u;
+
+void setemit(uint vertex_id_, bool prim_emit_, bool winding_) {
+    vertex_id = vertex_id_;
+    prim_emit = prim_emit_;
+    winding = winding_;
+}
+
+void emit() {
+    prim_buffer[vertex_id] = output_buffer;
+
+    // Emitting more vertices than max_vertices is undefined in GL
+    if (prim_emit && emitted_prims < 10u) {
+        if (winding) {
+            EmitPrim(prim_buffer[1], prim_buffer[0], prim_buffer[2]);
+        } else {
+            EmitPrim(prim_buffer[0], prim_buffer[1], prim_buffer[2]);
+        }
+        ++emitted_prims;
+    }
+}
+
+void main() {
+)";
+    for (u32 i = 0; i < state.num_outputs; ++i) {
+        out += "    output_buffer.attributes[" + std::to_string(i) +
+               "] = vec4(0.0, 0.0, 0.0, 1.0);\n";
+    }
+    out += "\n    exec_shader();\n}\n\n";
+
+    out += program_source;
+
+    return {{out}};
+}
 } // namespace OpenGL
@@ -96,7 +96,6 @@ struct PicaFSConfigState {
             bool enable;
             bool abs_input;
             Pica::LightingRegs::LightingLutInput type;
-            float scale;
         } lut_d0, lut_d1, lut_sp, lut_fr, lut_rr, lut_rg, lut_rb;
     } lighting;
 
@@ -108,13 +107,6 @@ struct PicaFSConfigState {
         bool separate_alpha;
         bool noise_enable;
         Pica::TexturingRegs::ProcTexShift u_shift, v_shift;
-        u32 lut_width;
-        u32 lut_offset0;
-        u32 lut_offset1;
-        u32 lut_offset2;
-        u32 lut_offset3;
-        u32 lod_min;
-        u32 lod_max;
         Pica::TexturingRegs::ProcTexFilter lut_filter;
     } proctex;
 
@@ -129,6 +121,10 @@ struct PicaFSConfigState {
  * directly accessing Pica registers. This should reduce the risk of bugs in shader generation where
  * Pica state is not being captured in the shader cache key, thereby resulting in (what should be)
  * two separate shaders sharing the same key.
+ *
+ * State that only feeds values into the shader, like the TEV constant colors, the lighting LUT
+ * scales or the proctex LUT layout, lives in the uniforms instead, so that it doesn't multiply the
+ * number of generated shaders.
  */
 struct PicaFSConfig : Common::HashableStruct<PicaFSConfigState> {
 
@@ -200,6 +196,32 @@ struct PicaFixedGSConfig : Common::HashableStruct<PicaGSConfigCommonRaw> {
     }
 };
 
+/**
+ * Returns the number of vertices the PICA geometry shader takes per invocation, or 0 if the
+ * geometry shader configuration can't be translated to a GL geometry shader.
+ */
+u32 GetGSInputVertexCount(const Pica::Regs& regs);
+
+struct PicaGSConfigRaw : PicaShaderConfigCommon, PicaGSConfigCommonRaw {
+    void Init(const Pica::Regs& regs, Pica::Shader::ShaderSetup& setup);
+
+    u32 num_vertices;
+    u32 attributes_per_vertex;
+
+    // input_map[input register index] -> attribute index in the vertices of the primitive
+    std::array<u32, 16> input_map;
+};
+
+/**
+ * This struct contains information to identify a GL geometry shader generated from PICA geometry
+ * shader.
+ */
+struct PicaGSConfig : Common::HashableStruct<PicaGSConfigRaw> {
+    explicit PicaGSConfig(const Pica::Regs& regs, Pica::Shader::ShaderSetup& setup) {
+        state.Init(regs, setup);
+    }
+};
+
 /**
  * Generates the GLSL vertex shader program source code that accepts vertices from software shader
  * and directly passes them to the fragment shader.
@@ -222,6 +244,13 @@ std::optional<ShaderDecompiler::ProgramResult> GenerateVertexShader(
 ShaderDecompiler::ProgramResult GenerateFixedGeometryShader(const PicaFixedGSConfig& config,
                                                             bool separable_shader);
 
+/**
+ * Generates the GLSL geometry shader program source code for the given GS program
+ * @returns String of the shader source code; std::nullopt on failure
+ */
+std::optional<ShaderDecompiler::ProgramResult> GenerateGeometryShader(
+    const Pica::Shader::ShaderSetup& setup, const PicaGSConfig& config, bool separable_shader);
+
 /**
  * Generates the GLSL fragment shader program source code for the current Pica state
  * @param config ShaderCacheKey object generated for the current Pica state, used for the shader
@@ -232,6 +261,18 @@ ShaderDecompiler::ProgramResult GenerateFixedGeometryShader(const PicaFixedGSCon
 ShaderDecompiler::ProgramResult GenerateFragmentShader(const PicaFSConfig& config,
                                                        bool separable_shader);
 
+/// Returns true if the uber fragment shader implements every feature used by the configuration
+bool IsUberFragmentShaderCompatible(const PicaFSConfig& config);
+
+/**
+ * Generates a fragment shader that interprets the TEV stages, fragment lighting and fog from the
+ * FSUberUniformData block at runtime, so that a single program can render any compatible
+ * configuration.
+ * @param separable_shader generates shader that can be used for separate shader object
+ * @returns String of the shader source code
+ */
+ShaderDecompiler::ProgramResult GenerateUberFragmentShader(bool separable_shader);
+
 } // namespace OpenGL
 
 namespace std {
@@ -255,4 +296,11 @@ struct hash<OpenGL::PicaFixedGSConfig> {
         return k.Hash();
     }
 };
+
+template <>
+struct hash<OpenGL::PicaGSConfig> {
+    std::size_t operator()(const OpenGL::PicaGSConfig& k) const {
+        return k.Hash();
+    }
+};
 } // namespace std
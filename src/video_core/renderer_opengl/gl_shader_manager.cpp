@@ -3,17 +3,34 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <optional>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <variant>
 #include <boost/functional/hash.hpp>
 #include <boost/variant.hpp>
+#include "common/task_scheduler.h"
+#include "common/thread.h"
+#include "common/threadsafe_queue.h"
 #include "core/core.h"
+#include "core/frontend/emu_window.h"
+#include "core/frontend/scope_acquire_context.h"
+#include "core/perf_metrics.h"
+#include "core/settings.h"
 #include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_shader_manager.h"
 #include "video_core/video_core.h"
 
 namespace OpenGL {
 
+/// Number of precompiled shaders that are decompressed ahead of the ones being loaded
+constexpr std::size_t PRECOMPILED_PREFETCH_BATCH = 64;
+
+/// Share of the recorded shader uses that is built at boot when the others can be built later
+constexpr u64 BOOT_USAGE_PERCENT = 95;
+
 static u64 GetUniqueIdentifier(const Pica::Regs& regs, const ProgramCode& code) {
     std::size_t hash = 0;
     u64 regs_uid = Common::ComputeHash64(regs.reg_array.data(), Pica::Regs::NUM_REGS * sizeof(u32));
@@ -63,8 +80,7 @@ static std::set<GLenum> GetSupportedFormats() {
     return supported_formats;
 }
 
-static std::tuple<PicaVSConfig, Pica::Shader::ShaderSetup> BuildVSConfigFromRaw(
-    const ShaderDiskCacheRaw& raw) {
+static Pica::Shader::ShaderSetup BuildShaderSetupFromRaw(const ShaderDiskCacheRaw& raw) {
     Pica::Shader::ProgramCode program_code{};
     Pica::Shader::SwizzleData swizzle_data{};
     std::copy_n(raw.GetProgramCode().begin(), Pica::Shader::MAX_PROGRAM_CODE_LENGTH,
@@ -74,9 +90,44 @@ static std::tuple<PicaVSConfig, Pica::Shader::ShaderSetup> BuildVSConfigFromRaw(
     Pica::Shader::ShaderSetup setup;
     setup.program_code = program_code;
     setup.swizzle_data = swizzle_data;
+    return setup;
+}
+
+static std::tuple<PicaVSConfig, Pica::Shader::ShaderSetup> BuildVSConfigFromRaw(
+    const ShaderDiskCacheRaw& raw) {
+    Pica::Shader::ShaderSetup setup = BuildShaderSetupFromRaw(raw);
     return {PicaVSConfig{raw.GetRawShaderConfig().vs, setup}, setup};
 }
 
+static std::tuple<PicaGSConfig, Pica::Shader::ShaderSetup> BuildGSConfigFromRaw(
+    const ShaderDiskCacheRaw& raw) {
+    Pica::Shader::ShaderSetup setup = BuildShaderSetupFromRaw(raw);
+    return {PicaGSConfig{raw.GetRawShaderConfig(), setup}, setup};
+}
+
+static ShaderDiskCacheRaw BuildProgrammableRaw(ProgramType type, const Pica::Regs& regs,
+                                               const Pica::Shader::ShaderSetup& setup) {
+    ProgramCode program_code{setup.program_code.begin(), setup.program_code.end()};
+    program_code.insert(program_code.end(), setup.swizzle_data.begin(), setup.swizzle_data.end());
+    const u64 unique_identifier = GetUniqueIdentifier(regs, program_code);
+    return ShaderDiskCacheRaw{unique_identifier, type, regs, program_code};
+}
+
+static ShaderDiskCacheRaw BuildVSRaw(const Pica::Regs& regs,
+                                     const Pica::Shader::ShaderSetup& setup) {
+    return BuildProgrammableRaw(ProgramType::VS, regs, setup);
+}
+
+static ShaderDiskCacheRaw BuildGSRaw(const Pica::Regs& regs,
+                                     const Pica::Shader::ShaderSetup& setup) {
+    return BuildProgrammableRaw(ProgramType::GS, regs, setup);
+}
+
+static ShaderDiskCacheRaw BuildFSRaw(const Pica::Regs& regs) {
+    const u64 unique_identifier = GetUniqueIdentifier(regs, {});
+    return ShaderDiskCacheRaw{unique_identifier, ProgramType::FS, regs, {}};
+}
+
 static void SetShaderUniformBlockBinding(GLuint shader, const char* name, UniformBindings binding,
                                          std::size_t expected_size) {
     const GLuint ub_index = glGetUniformBlockIndex(shader, name);
@@ -94,6 +145,9 @@ static void SetShaderUniformBlockBindings(GLuint shader) {
     SetShaderUniformBlockBinding(shader, "shader_data", UniformBindings::Common,
                                  sizeof(UniformData));
     SetShaderUniformBlockBinding(shader, "vs_config", UniformBindings::VS, sizeof(VSUniformData));
+    SetShaderUniformBlockBinding(shader, "gs_config", UniformBindings::GS, sizeof(GSUniformData));
+    SetShaderUniformBlockBinding(shader, "fs_uber_config", UniformBindings::FSUber,
+                                 sizeof(FSUberUniformData));
 }
 
 static void SetShaderSamplerBinding(GLuint shader, const char* name,
@@ -153,6 +207,89 @@ void PicaUniformsData::SetFromRegs(const Pica::ShaderRegs& regs,
                    });
 }
 
+void FSUberUniformData::SetFromConfig(const PicaFSConfig& config) {
+    using Pica::LightingRegs;
+    const auto& state = config.state;
+
+    for (std::size_t i = 0; i < state.tev_stages.size(); ++i) {
+        const auto stage =
+            static_cast<const Pica::TexturingRegs::TevStageConfig>(state.tev_stages[i]);
+        tev_color_sources[i] = {static_cast<GLint>(stage.color_source1.Value()),
+                                static_cast<GLint>(stage.color_source2.Value()),
+                                static_cast<GLint>(stage.color_source3.Value()),
+                                static_cast<GLint>(stage.color_op.Value())};
+        tev_alpha_sources[i] = {static_cast<GLint>(stage.alpha_source1.Value()),
+                                static_cast<GLint>(stage.alpha_source2.Value()),
+                                static_cast<GLint>(stage.alpha_source3.Value()),
+                                static_cast<GLint>(stage.alpha_op.Value())};
+        tev_color_modifiers[i] = {static_cast<GLint>(stage.color_modifier1.Value()),
+                                  static_cast<GLint>(stage.color_modifier2.Value()),
+                                  static_cast<GLint>(stage.color_modifier3.Value()),
+                                  static_cast<GLint>(stage.GetColorMultiplier())};
+        tev_alpha_modifiers[i] = {static_cast<GLint>(stage.alpha_modifier1.Value()),
+                                  static_cast<GLint>(stage.alpha_modifier2.Value()),
+                                  static_cast<GLint>(stage.alpha_modifier3.Value()),
+                                  static_cast<GLint>(stage.GetAlphaMultiplier())};
+    }
+
+    combiner_buffer_input = state.combiner_buffer_input;
+    alpha_test_func = static_cast<GLint>(state.alpha_test_func);
+    scissor_test_mode = static_cast<GLint>(state.scissor_test_mode);
+    texture0_type = static_cast<GLint>(state.texture0_type);
+    texture2_use_coord1 = state.texture2_use_coord1;
+    depthmap_enable = static_cast<GLint>(state.depthmap_enable);
+    fog_mode = static_cast<GLint>(state.fog_mode);
+    fog_flip = state.fog_flip;
+
+    const auto& lighting = state.lighting;
+    lighting_enable = lighting.enable;
+    lighting_src_num = static_cast<GLint>(lighting.src_num);
+    lighting_bump_mode = static_cast<GLint>(lighting.bump_mode);
+    lighting_bump_selector = static_cast<GLint>(lighting.bump_selector);
+    lighting_bump_renorm = lighting.bump_renorm;
+    lighting_clamp_highlights = lighting.clamp_highlights;
+    lighting_config = static_cast<GLint>(lighting.config);
+    lighting_enable_primary_alpha = lighting.enable_primary_alpha;
+    lighting_enable_secondary_alpha = lighting.enable_secondary_alpha;
+    lighting_enable_shadow = lighting.enable_shadow;
+    lighting_shadow_primary = lighting.shadow_primary;
+    lighting_shadow_secondary = lighting.shadow_secondary;
+    lighting_shadow_invert = lighting.shadow_invert;
+    lighting_shadow_alpha = lighting.shadow_alpha;
+    lighting_shadow_selector = static_cast<GLint>(lighting.shadow_selector);
+
+    for (std::size_t i = 0; i < std::size(lighting.light); ++i) {
+        const auto& light = lighting.light[i];
+        GLint flags = 0;
+        flags |= light.directional ? LightDirectional : 0;
+        flags |= light.two_sided_diffuse ? LightTwoSidedDiffuse : 0;
+        flags |= light.dist_atten_enable ? LightDistAtten : 0;
+        flags |= light.spot_atten_enable ? LightSpotAtten : 0;
+        flags |= light.geometric_factor_0 ? LightGeometricFactor0 : 0;
+        flags |= light.geometric_factor_1 ? LightGeometricFactor1 : 0;
+        flags |= light.shadow_enable ? LightShadow : 0;
+        lighting_lights[i] = {static_cast<GLint>(light.num), flags, 0, 0};
+    }
+
+    // The LUTs unsupported by the lighting configuration are disabled here, so the shader doesn't
+    // have to know about the configurations
+    const auto SetLut = [&](UniformData::Lut index, const auto& lut,
+                            LightingRegs::LightingSampler sampler) {
+        const bool enable =
+            lut.enable && LightingRegs::IsLightingSamplerSupported(lighting.config, sampler);
+        lighting_luts[index] = {enable, lut.abs_input, static_cast<GLint>(lut.type),
+                                static_cast<GLint>(sampler)};
+    };
+    SetLut(UniformData::LutD0, lighting.lut_d0, LightingRegs::LightingSampler::Distribution0);
+    SetLut(UniformData::LutD1, lighting.lut_d1, LightingRegs::LightingSampler::Distribution1);
+    SetLut(UniformData::LutSP, lighting.lut_sp,
+           LightingRegs::LightingSampler::SpotlightAttenuation);
+    SetLut(UniformData::LutFR, lighting.lut_fr, LightingRegs::LightingSampler::Fresnel);
+    SetLut(UniformData::LutRR, lighting.lut_rr, LightingRegs::LightingSampler::ReflectRed);
+    SetLut(UniformData::LutRG, lighting.lut_rg, LightingRegs::LightingSampler::ReflectGreen);
+    SetLut(UniformData::LutRB, lighting.lut_rb, LightingRegs::LightingSampler::ReflectBlue);
+}
+
 /**
  * An object representing a shader program staging. It can be either a shader object or a program
  * object, depending on whether separable program is used.
@@ -211,6 +348,19 @@ private:
     OGLShaderStage program;
 };
 
+class UberFragmentShader {
+public:
+    explicit UberFragmentShader(bool separable) : program(separable) {
+        program.Create(GenerateUberFragmentShader(separable).code.c_str(), GL_FRAGMENT_SHADER);
+    }
+    GLuint Get() const {
+        return program.GetHandle();
+    }
+
+private:
+    OGLShaderStage program;
+};
+
 template <typename KeyConfigType,
           ShaderDecompiler::ProgramResult (*CodeGenerator)(const KeyConfigType&, bool),
           GLenum ShaderType>
@@ -229,10 +379,20 @@ public:
         return {cached_shader.GetHandle(), result};
     }
 
-    void Inject(const KeyConfigType& key, std::string decomp, OGLProgram&& program) {
+    /// Returns the handle of a cached shader without building it on a miss
+    std::optional<GLuint> Find(const KeyConfigType& config) const {
+        const auto iter = shaders.find(config);
+        if (iter == shaders.end()) {
+            return std::nullopt;
+        }
+        return iter->second.GetHandle();
+    }
+
+    /// Inserts an already built program into the cache. Returns false if the key was cached.
+    bool Inject(const KeyConfigType& key, std::string decomp, OGLProgram&& program) {
         OGLShaderStage stage{separable};
         stage.Inject(std::move(program));
-        shaders.emplace(key, std::move(stage));
+        return shaders.emplace(key, std::move(stage)).second;
     }
 
 private:
@@ -281,12 +441,26 @@ public:
         return {map_it->second->GetHandle(), {}};
     }
 
-    void Inject(const KeyConfigType& key, std::string decomp, OGLProgram&& program) {
+    /**
+     * Returns the handle of a cached shader without building it on a miss. A handle of 0 means
+     * that the PICA program could not be translated.
+     */
+    std::optional<GLuint> Find(const KeyConfigType& key) const {
+        const auto map_it = shader_map.find(key);
+        if (map_it == shader_map.end()) {
+            return std::nullopt;
+        }
+        return map_it->second ? map_it->second->GetHandle() : 0;
+    }
+
+    /// Inserts an already built program into the cache. Returns false if the code was cached.
+    bool Inject(const KeyConfigType& key, std::string decomp, OGLProgram&& program) {
         OGLShaderStage stage{separable};
         stage.Inject(std::move(program));
         auto [iter, new_shader] = shader_cache.emplace(decomp, std::move(stage));
         OGLShaderStage& cached_shader = iter->second;
         shader_map[key] = &cached_shader;
+        return new_shader;
     }
 
 private:
@@ -301,14 +475,124 @@ using ProgrammableVertexShaders =
 using FixedGeometryShaders =
     ShaderCache<PicaFixedGSConfig, &GenerateFixedGeometryShader, GL_GEOMETRY_SHADER>;
 
+using ProgrammableGeometryShaders =
+    ShaderDoubleCache<PicaGSConfig, &GenerateGeometryShader, GL_GEOMETRY_SHADER>;
+
 using FragmentShaders = ShaderCache<PicaFSConfig, &GenerateFragmentShader, GL_FRAGMENT_SHADER>;
 
+/// A program built from a transferable cache entry by one of the disk cache workers
+struct BuiltShader {
+    std::size_t index{};
+    OGLProgram program;
+    ShaderDecompiler::ProgramResult result;
+};
+
+/**
+ * Decompiles and links a transferable cache entry on the current context. This only touches GL
+ * objects owned by the returned program, so it is safe to run on a shared context.
+ */
+static BuiltShader BuildShaderFromRaw(std::size_t index, const ShaderDiskCacheRaw& raw,
+                                      bool separable) {
+    BuiltShader built{index};
+    GLenum type;
+    if (raw.GetProgramType() == ProgramType::VS) {
+        auto [conf, setup] = BuildVSConfigFromRaw(raw);
+        auto result = GenerateVertexShader(setup, conf, separable);
+        if (!result) {
+            LOG_ERROR(Frontend, "compilation from raw failed {:x} {:x}",
+                      raw.GetProgramCode().at(0), raw.GetProgramCode().at(1));
+            return built;
+        }
+        built.result = std::move(*result);
+        type = GL_VERTEX_SHADER;
+    } else if (raw.GetProgramType() == ProgramType::GS) {
+        auto [conf, setup] = BuildGSConfigFromRaw(raw);
+        auto result = GenerateGeometryShader(setup, conf, separable);
+        if (!result) {
+            LOG_ERROR(Frontend, "compilation from raw failed {:x} {:x}",
+                      raw.GetProgramCode().at(0), raw.GetProgramCode().at(1));
+            return built;
+        }
+        built.result = std::move(*result);
+        type = GL_GEOMETRY_SHADER;
+    } else if (raw.GetProgramType() == ProgramType::FS) {
+        PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
+        built.result = GenerateFragmentShader(conf, separable);
+        type = GL_FRAGMENT_SHADER;
+    } else {
+        // Unsupported shader type got stored somehow so nuke the cache
+        LOG_ERROR(Frontend, "failed to load raw programtype {}",
+                  static_cast<u32>(raw.GetProgramType()));
+        return built;
+    }
+
+    OGLShader shader;
+    shader.Create(built.result.code.c_str(), type);
+    built.program.Create(true, {shader.handle});
+    return built;
+}
+
+/// A shader cache miss that is built by the AsyncShaderBuilder
+struct AsyncShaderJob {
+    /// Cache key of the shader. A job without a key stops the builder.
+    std::variant<std::monostate, PicaVSConfig, PicaGSConfig, PicaFSConfig> config;
+    ShaderDiskCacheRaw raw;
+    BuiltShader built;
+};
+
+/**
+ * Builds the programs for shader cache misses on a worker thread with its own context shared with
+ * the emulator window, so that the draw which missed doesn't have to wait for the driver.
+ */
+class AsyncShaderBuilder {
+public:
+    explicit AsyncShaderBuilder(std::unique_ptr<Frontend::GraphicsContext> context)
+        : context{std::move(context)}, thread{&AsyncShaderBuilder::RunThread, this} {}
+
+    ~AsyncShaderBuilder() {
+        jobs.Push(AsyncShaderJob{});
+        thread.join();
+    }
+
+    /// Queues a shader to be built
+    void Queue(AsyncShaderJob&& job) {
+        jobs.Push(std::move(job));
+    }
+
+    /// Takes a finished job, returns false if there is none
+    bool Pop(AsyncShaderJob& job) {
+        return results.Pop(job);
+    }
+
+private:
+    void RunThread() {
+        Common::SetCurrentThreadName("ShaderBuilder");
+        Frontend::ScopeAcquireContext scope{*context};
+        while (true) {
+            AsyncShaderJob job = jobs.PopWait();
+            if (std::holds_alternative<std::monostate>(job.config)) {
+                break;
+            }
+            job.built = BuildShaderFromRaw(0, job.raw, true);
+            // Make sure the program is complete before it gets used on the render context
+            glFinish();
+            results.Push(std::move(job));
+        }
+    }
+
+    std::unique_ptr<Frontend::GraphicsContext> context;
+    Common::SPSCQueue<AsyncShaderJob> jobs;
+    Common::SPSCQueue<AsyncShaderJob> results;
+    std::thread thread;
+};
+
 class ShaderProgramManager::Impl {
 public:
     explicit Impl(bool separable, bool is_amd)
         : is_amd(is_amd), separable(separable), programmable_vertex_shaders(separable),
           trivial_vertex_shader(separable), fixed_geometry_shaders(separable),
-          fragment_shaders(separable), disk_cache(separable) {
+          programmable_geometry_shaders(separable), fragment_shaders(separable),
+          disk_cache(separable) {
         if (separable)
             pipeline.Create();
     }
@@ -341,39 +625,185 @@ public:
     bool separable;
 
     ShaderTuple current;
+    /// Stages last attached to the program pipeline
+    ShaderTuple pipeline_stages;
 
     ProgrammableVertexShaders programmable_vertex_shaders;
     TrivialVertexShader trivial_vertex_shader;
 
     FixedGeometryShaders fixed_geometry_shaders;
+    ProgrammableGeometryShaders programmable_geometry_shaders;
 
     FragmentShaders fragment_shaders;
     std::unordered_map<ShaderTuple, OGLProgram, ShaderTuple::Hash> program_cache;
     OGLPipeline pipeline;
     ShaderDiskCache disk_cache;
+
+    /// Moves the programs finished by the async builder into the caches
+    void InjectAsyncShaders() {
+        for (AsyncShaderJob job; async_builder->Pop(job);) {
+            if (job.built.program.handle == 0) {
+                // Leave the shader pending so that it isn't queued again and the draws using it
+                // keep going through the fallback
+                continue;
+            }
+
+            const u64 unique_identifier = job.raw.GetUniqueIdentifier();
+            const GLuint handle = job.built.program.handle;
+            if (const auto vs_config = std::get_if<PicaVSConfig>(&job.config)) {
+                pending_vs.erase(*vs_config);
+                if (programmable_vertex_shaders.Inject(*vs_config, job.built.result.code,
+                                                       std::move(job.built.program))) {
+                    program_uids.emplace(handle, unique_identifier);
+                    disk_cache.SaveRaw(job.raw);
+                }
+            } else if (const auto gs_config = std::get_if<PicaGSConfig>(&job.config)) {
+                pending_gs.erase(*gs_config);
+                if (programmable_geometry_shaders.Inject(*gs_config, job.built.result.code,
+                                                         std::move(job.built.program))) {
+                    program_uids.emplace(handle, unique_identifier);
+                    disk_cache.SaveRaw(job.raw);
+                }
+            } else if (const auto fs_config = std::get_if<PicaFSConfig>(&job.config)) {
+                pending_fs.erase(*fs_config);
+                if (fragment_shaders.Inject(*fs_config, job.built.result.code,
+                                            std::move(job.built.program))) {
+                    program_uids.emplace(handle, unique_identifier);
+                }
+                disk_cache.SaveRaw(job.raw);
+                disk_cache.SaveDecompiled(unique_identifier, job.built.result, false);
+            }
+        }
+    }
+
+    /// Queues a shader of the disk cache to the async builder
+    void QueueFromDiskCache(const ShaderDiskCacheRaw& raw) {
+        if (raw.GetProgramType() == ProgramType::VS) {
+            auto [conf, setup] = BuildVSConfigFromRaw(raw);
+            if (pending_vs.insert(conf).second) {
+                async_builder->Queue({conf, raw});
+            }
+        } else if (raw.GetProgramType() == ProgramType::GS) {
+            auto [conf, setup] = BuildGSConfigFromRaw(raw);
+            if (pending_gs.insert(conf).second) {
+                async_builder->Queue({conf, raw});
+            }
+        } else if (raw.GetProgramType() == ProgramType::FS) {
+            PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
+            if (pending_fs.insert(conf).second) {
+                async_builder->Queue({conf, raw});
+            }
+        }
+    }
+
+    /// Counts a use of the stages that are about to be attached to the program pipeline
+    void CountStageUses() {
+        if (program_uids.empty()) {
+            return;
+        }
+        for (const auto [stage, attached] : {std::pair{current.vs, pipeline_stages.vs},
+                                             std::pair{current.gs, pipeline_stages.gs},
+                                             std::pair{current.fs, pipeline_stages.fs}}) {
+            if (stage == attached) {
+                continue;
+            }
+            if (const auto it = program_uids.find(stage); it != program_uids.end()) {
+                disk_cache.CountUse(it->second);
+            }
+        }
+    }
+
+    /// Selects the uber fragment shader for the configuration if it can render it
+    bool UseUberFragmentShader(const PicaFSConfig& config) {
+        if (!uber_fragment_shader || !IsUberFragmentShaderCompatible(config)) {
+            return false;
+        }
+        uber_uniforms.SetFromConfig(config);
+        current.fs = uber_fragment_shader->Get();
+        using_uber_fragment_shader = true;
+        return true;
+    }
+
+    /// Set when cache misses are built in the background instead of on the draw
+    std::unique_ptr<AsyncShaderBuilder> async_builder;
+    std::unordered_set<PicaVSConfig> pending_vs;
+    std::unordered_set<PicaGSConfig> pending_gs;
+    std::unordered_set<PicaFSConfig> pending_fs;
+
+    /// Unique identifiers of the programs that are in the disk cache, to count their uses
+    std::unordered_map<GLuint, u64> program_uids;
+
+    /// Fragment configs used so far, only collected while the metrics are exported
+    std::unordered_set<PicaFSConfig> seen_fs_configs;
+
+    /// Set when the uber shader is used on its own or while fragment shaders are being built
+    std::unique_ptr<UberFragmentShader> uber_fragment_shader;
+    bool prefer_uber_fragment_shader = false;
+    bool using_uber_fragment_shader = false;
+    FSUberUniformData uber_uniforms{};
 };
 
-ShaderProgramManager::ShaderProgramManager(bool separable, bool is_amd)
-    : impl(std::make_unique<Impl>(separable, is_amd)) {}
+ShaderProgramManager::ShaderProgramManager(Frontend::EmuWindow& emu_window, bool separable,
+                                           bool is_amd)
+    : emu_window{emu_window}, impl(std::make_unique<Impl>(separable, is_amd)) {
+    if (Settings::values.use_uber_shader) {
+        impl->uber_fragment_shader = std::make_unique<UberFragmentShader>(separable);
+        impl->prefer_uber_fragment_shader = true;
+    }
+
+    if (!Settings::values.async_shader_compilation) {
+        return;
+    }
+    if (!separable) {
+        LOG_WARNING(Render_OpenGL,
+                    "Asynchronous shader compilation requires separate shader programs");
+        return;
+    }
+    auto context = emu_window.CreateSharedContext();
+    if (!context) {
+        LOG_WARNING(Render_OpenGL, "Asynchronous shader compilation requires a shared context");
+        return;
+    }
+    // Some frontends make a newly created context current, so take ours back
+    emu_window.MakeCurrent();
+    impl->async_builder = std::make_unique<AsyncShaderBuilder>(std::move(context));
+    if (!impl->uber_fragment_shader) {
+        impl->uber_fragment_shader = std::make_unique<UberFragmentShader>(separable);
+    }
+}
 
-ShaderProgramManager::~ShaderProgramManager() = default;
+ShaderProgramManager::~ShaderProgramManager() {
+    impl->disk_cache.SaveUsage();
+}
 
 bool ShaderProgramManager::UseProgrammableVertexShader(const Pica::Regs& regs,
                                                        Pica::Shader::ShaderSetup& setup) {
     PicaVSConfig config{regs.vs, setup};
+    if (impl->async_builder) {
+        // While the shader is being built, the draw falls back to the software vertex shader
+        impl->InjectAsyncShaders();
+        const auto handle = impl->programmable_vertex_shaders.Find(config);
+        if (!handle) {
+            if (impl->pending_vs.insert(config).second) {
+                impl->async_builder->Queue({config, BuildVSRaw(regs, setup)});
+            }
+            return false;
+        }
+        if (*handle == 0)
+            return false;
+        impl->current.vs = *handle;
+        return true;
+    }
+
     auto [handle, result] = impl->programmable_vertex_shaders.Get(config, setup);
     if (handle == 0)
         return false;
     impl->current.vs = handle;
     // Save VS to the disk cache if its a new shader
     if (result) {
-        auto& disk_cache = impl->disk_cache;
-        ProgramCode program_code{setup.program_code.begin(), setup.program_code.end()};
-        program_code.insert(program_code.end(), setup.swizzle_data.begin(),
-                            setup.swizzle_data.end());
-        u64 unique_identifier = GetUniqueIdentifier(regs, program_code);
-        ShaderDiskCacheRaw raw{unique_identifier, ProgramType::VS, regs, program_code};
-        disk_cache.SaveRaw(raw);
+        const ShaderDiskCacheRaw raw = BuildVSRaw(regs, setup);
+        impl->program_uids.emplace(handle, raw.GetUniqueIdentifier());
+        impl->disk_cache.SaveRaw(raw);
     }
     return true;
 }
@@ -388,38 +818,112 @@ void ShaderProgramManager::UseFixedGeometryShader(const Pica::Regs& regs) {
     impl->current.gs = handle;
 }
 
+bool ShaderProgramManager::UseProgrammableGeometryShader(const Pica::Regs& regs,
+                                                         Pica::Shader::ShaderSetup& setup) {
+    PicaGSConfig config{regs, setup};
+    if (impl->async_builder) {
+        // While the shader is being built, the draw falls back to the software geometry shader
+        impl->InjectAsyncShaders();
+        const auto handle = impl->programmable_geometry_shaders.Find(config);
+        if (!handle) {
+            if (impl->pending_gs.insert(config).second) {
+                impl->async_builder->Queue({config, BuildGSRaw(regs, setup)});
+            }
+            return false;
+        }
+        if (*handle == 0)
+            return false;
+        impl->current.gs = *handle;
+        return true;
+    }
+
+    auto [handle, result] = impl->programmable_geometry_shaders.Get(config, setup);
+    if (handle == 0)
+        return false;
+    impl->current.gs = handle;
+    // Save GS to the disk cache if its a new shader
+    if (result) {
+        const ShaderDiskCacheRaw raw = BuildGSRaw(regs, setup);
+        impl->program_uids.emplace(handle, raw.GetUniqueIdentifier());
+        impl->disk_cache.SaveRaw(raw);
+    }
+    return true;
+}
+
 void ShaderProgramManager::UseTrivialGeometryShader() {
     impl->current.gs = 0;
 }
 
-void ShaderProgramManager::UseFragmentShader(const Pica::Regs& regs) {
+bool ShaderProgramManager::UseFragmentShader(const Pica::Regs& regs) {
     PicaFSConfig config = PicaFSConfig::BuildFromRegs(regs);
+    if (Core::Metrics::IsEnabled() && impl->seen_fs_configs.insert(config).second) {
+        Core::Metrics::Add(Core::Metrics::Counter::FragmentConfigs);
+    }
+    impl->using_uber_fragment_shader = false;
+    if (impl->prefer_uber_fragment_shader && impl->UseUberFragmentShader(config)) {
+        return true;
+    }
+
+    if (impl->async_builder) {
+        impl->InjectAsyncShaders();
+        const auto handle = impl->fragment_shaders.Find(config);
+        if (!handle) {
+            if (impl->pending_fs.insert(config).second) {
+                impl->async_builder->Queue({config, BuildFSRaw(regs)});
+            }
+            // Render through the uber shader until the specialised one is ready
+            return impl->UseUberFragmentShader(config);
+        }
+        impl->current.fs = *handle;
+        return true;
+    }
+
     auto [handle, result] = impl->fragment_shaders.Get(config);
     impl->current.fs = handle;
     // Save FS to the disk cache if its a new shader
     if (result) {
         auto& disk_cache = impl->disk_cache;
-        u64 unique_identifier = GetUniqueIdentifier(regs, {});
-        ShaderDiskCacheRaw raw{unique_identifier, ProgramType::FS, regs, {}};
+        const ShaderDiskCacheRaw raw = BuildFSRaw(regs);
+        impl->program_uids.emplace(handle, raw.GetUniqueIdentifier());
         disk_cache.SaveRaw(raw);
-        disk_cache.SaveDecompiled(unique_identifier, *result, false);
+        disk_cache.SaveDecompiled(raw.GetUniqueIdentifier(), *result, false);
     }
+    return true;
+}
+
+const FSUberUniformData* ShaderProgramManager::GetUberUniformData() const {
+    return impl->using_uber_fragment_shader ? &impl->uber_uniforms : nullptr;
 }
 
 void ShaderProgramManager::ApplyTo(OpenGLState& state) {
     if (impl->separable) {
-        if (impl->is_amd) {
-            // Without this reseting, AMD sometimes freezes when one stage is changed but not
-            // for the others. On the other hand, including this reset seems to introduce memory
-            // leak in Intel Graphics.
-            glUseProgramStages(
-                impl->pipeline.handle,
-                GL_VERTEX_SHADER_BIT | GL_GEOMETRY_SHADER_BIT | GL_FRAGMENT_SHADER_BIT, 0);
-        }
-
-        glUseProgramStages(impl->pipeline.handle, GL_VERTEX_SHADER_BIT, impl->current.vs);
-        glUseProgramStages(impl->pipeline.handle, GL_GEOMETRY_SHADER_BIT, impl->current.gs);
-        glUseProgramStages(impl->pipeline.handle, GL_FRAGMENT_SHADER_BIT, impl->current.fs);
+        // The pipeline keeps its stages, so only touch it when one of them changed. This is hit
+        // on every draw and most draws keep the same shaders.
+        if (impl->current != impl->pipeline_stages) {
+            impl->CountStageUses();
+            if (impl->is_amd) {
+                // Without this reseting, AMD sometimes freezes when one stage is changed but not
+                // for the others. On the other hand, including this reset seems to introduce
+                // memory leak in Intel Graphics.
+                glUseProgramStages(
+                    impl->pipeline.handle,
+                    GL_VERTEX_SHADER_BIT | GL_GEOMETRY_SHADER_BIT | GL_FRAGMENT_SHADER_BIT, 0);
+                impl->pipeline_stages = {};
+            }
+
+            if (impl->current.vs != impl->pipeline_stages.vs) {
+                glUseProgramStages(impl->pipeline.handle, GL_VERTEX_SHADER_BIT, impl->current.vs);
+            }
+            if (impl->current.gs != impl->pipeline_stages.gs) {
+                glUseProgramStages(impl->pipeline.handle, GL_GEOMETRY_SHADER_BIT,
+                                   impl->current.gs);
+            }
+            if (impl->current.fs != impl->pipeline_stages.fs) {
+                glUseProgramStages(impl->pipeline.handle, GL_FRAGMENT_SHADER_BIT,
+                                   impl->current.fs);
+            }
+            impl->pipeline_stages = impl->current;
+        }
         state.draw.shader_program = 0;
         state.draw.program_pipeline = impl->pipeline.handle;
     } else {
@@ -447,7 +951,7 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
     }
     const auto raws = *transferable;
 
-    auto [decompiled, dumps] = disk_cache.LoadPrecompiled();
+    disk_cache.LoadPrecompiled();
 
     if (stop_loading) {
         return;
@@ -462,89 +966,131 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
     std::mutex mutex;
     std::size_t built_shaders = 0; // It doesn't have be atomic since it's used behind a mutex
     std::atomic_bool compilation_failed = false;
+    bool invalid_entry = false;
     if (callback) {
         callback(VideoCore::LoadCallbackStage::Decompile, 0, raws.size());
     }
-    std::vector<std::size_t> load_raws_index;
+    std::vector<bool> injected(raws.size());
+
+    // The precompiled entries are decompressed on the task scheduler one batch ahead of the
+    // worker, so at most two batches of them are held in memory at any time
+    struct PrecompiledShader {
+        std::optional<ShaderDiskCacheDecompiled> decompiled;
+        std::optional<ShaderDiskCacheDump> dump;
+    };
+    std::vector<PrecompiledShader> precompiled(raws.size());
+    std::array<Common::TaskGroup, 2> prefetch_groups;
+    const auto Prefetch = [&](std::size_t batch) {
+        const std::size_t begin = batch * PRECOMPILED_PREFETCH_BATCH;
+        const std::size_t end = std::min(begin + PRECOMPILED_PREFETCH_BATCH, raws.size());
+        for (std::size_t i = begin; i < end; ++i) {
+            prefetch_groups[batch % 2].Submit([&, i] {
+                const u64 unique_identifier{raws[i].GetUniqueIdentifier()};
+                precompiled[i].decompiled = disk_cache.LoadDecompiled(unique_identifier);
+                if (precompiled[i].decompiled) {
+                    precompiled[i].dump = disk_cache.LoadDump(unique_identifier);
+                }
+            });
+        }
+    };
+
     // Loads both decompiled and precompiled shaders from the cache. If either one is missing for
-    const auto LoadPrecompiledWorker =
-        [&](std::size_t begin, std::size_t end, const std::vector<ShaderDiskCacheRaw>& raws,
-            const ShaderDecompiledMap& decompiled, const ShaderDumpsMap& dumps) {
-            for (std::size_t i = 0; i < end; ++i) {
-                if (stop_loading || compilation_failed) {
-                    return;
+    const auto LoadPrecompiledWorker = [&] {
+        Prefetch(0);
+        for (std::size_t i = 0; i < raws.size(); ++i) {
+            if (i % PRECOMPILED_PREFETCH_BATCH == 0) {
+                const std::size_t batch = i / PRECOMPILED_PREFETCH_BATCH;
+                prefetch_groups[batch % 2].Wait();
+                Prefetch(batch + 1);
+            }
+            if (stop_loading || compilation_failed) {
+                return;
+            }
+            const auto& raw{raws[i]};
+            const u64 unique_identifier{raw.GetUniqueIdentifier()};
+
+            const u64 calculated_hash =
+                GetUniqueIdentifier(raw.GetRawShaderConfig(), raw.GetProgramCode());
+            if (unique_identifier != calculated_hash) {
+                LOG_ERROR(Render_OpenGL,
+                          "Invalid hash in entry={:016x} (obtained hash={:016x}) - removing "
+                          "shader cache",
+                          raw.GetUniqueIdentifier(), calculated_hash);
+                invalid_entry = true;
+                return;
+            }
+
+            // Taken out of the vector, so that its memory is released once it has been used
+            const PrecompiledShader entry = std::move(precompiled[i]);
+            precompiled[i] = {};
+
+            OGLProgram shader;
+
+            if (entry.dump && entry.decompiled) {
+                // Only load this shader if its sanitize_mul setting matches
+                if (entry.decompiled->sanitize_mul == VideoCore::g_hw_shader_accurate_mul) {
+                    continue;
                 }
-                const auto& raw{raws[i]};
-                const u64 unique_identifier{raw.GetUniqueIdentifier()};
-
-                const u64 calculated_hash =
-                    GetUniqueIdentifier(raw.GetRawShaderConfig(), raw.GetProgramCode());
-                if (unique_identifier != calculated_hash) {
-                    LOG_ERROR(Render_OpenGL,
-                              "Invalid hash in entry={:016x} (obtained hash={:016x}) - removing "
-                              "shader cache",
-                              raw.GetUniqueIdentifier(), calculated_hash);
-                    disk_cache.InvalidateAll();
+
+                // If the shader is dumped, attempt to load it
+                shader = GeneratePrecompiledProgram(*entry.dump, supported_formats);
+                if (shader.handle == 0) {
+                    // If any shader failed, stop trying to compile, delete the cache, and start
+                    // loading from raws
+                    compilation_failed = true;
                     return;
                 }
+                const GLuint handle = shader.handle;
+                // we have both the binary shader and the decompiled, so inject it into the
+                // cache
+                if (raw.GetProgramType() == ProgramType::VS) {
+                    auto [conf, setup] = BuildVSConfigFromRaw(raw);
+                    std::scoped_lock lock(mutex);
 
-                const auto dump{dumps.find(unique_identifier)};
-                const auto decomp{decompiled.find(unique_identifier)};
-
-                OGLProgram shader;
-
-                if (dump != dumps.end() && decomp != decompiled.end()) {
-                    // Only load this shader if its sanitize_mul setting matches
-                    if (decomp->second.sanitize_mul == VideoCore::g_hw_shader_accurate_mul) {
-                        continue;
-                    }
-
-                    // If the shader is dumped, attempt to load it
-                    shader = GeneratePrecompiledProgram(dump->second, supported_formats);
-                    if (shader.handle == 0) {
-                        // If any shader failed, stop trying to compile, delete the cache, and start
-                        // loading from raws
-                        compilation_failed = true;
-                        return;
-                    }
-                    // we have both the binary shader and the decompiled, so inject it into the
-                    // cache
-                    if (raw.GetProgramType() == ProgramType::VS) {
-                        auto [conf, setup] = BuildVSConfigFromRaw(raw);
-                        std::scoped_lock lock(mutex);
-
-                        impl->programmable_vertex_shaders.Inject(conf, decomp->second.result.code,
-                                                                 std::move(shader));
-                    } else if (raw.GetProgramType() == ProgramType::FS) {
-                        PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
-                        std::scoped_lock lock(mutex);
-                        impl->fragment_shaders.Inject(conf, decomp->second.result.code,
-                                                      std::move(shader));
-                    } else {
-                        // Unsupported shader type got stored somehow so nuke the cache
-
-                        LOG_CRITICAL(Frontend, "failed to load raw programtype {}",
-                                     static_cast<u32>(raw.GetProgramType()));
-                        compilation_failed = true;
-                        return;
-                    }
-                } else {
-                    // Since precompiled didn't have the dump, we'll load them in the next phase
+                    impl->programmable_vertex_shaders.Inject(conf, entry.decompiled->result.code,
+                                                             std::move(shader));
+                    injected[i] = true;
+                } else if (raw.GetProgramType() == ProgramType::GS) {
+                    auto [conf, setup] = BuildGSConfigFromRaw(raw);
                     std::scoped_lock lock(mutex);
-                    load_raws_index.push_back(i);
-                }
-                if (callback) {
-                    callback(VideoCore::LoadCallbackStage::Decompile, i, raws.size());
+                    impl->programmable_geometry_shaders.Inject(
+                        conf, entry.decompiled->result.code, std::move(shader));
+                    injected[i] = true;
+                } else if (raw.GetProgramType() == ProgramType::FS) {
+                    PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
+                    std::scoped_lock lock(mutex);
+                    impl->fragment_shaders.Inject(conf, entry.decompiled->result.code,
+                                                  std::move(shader));
+                    injected[i] = true;
+                } else {
+                    // Unsupported shader type got stored somehow so nuke the cache
+
+                    LOG_CRITICAL(Frontend, "failed to load raw programtype {}",
+                                 static_cast<u32>(raw.GetProgramType()));
+                    compilation_failed = true;
+                    return;
                 }
+                impl->program_uids.emplace(handle, unique_identifier);
             }
-        };
+            if (callback) {
+                callback(VideoCore::LoadCallbackStage::Decompile, i, raws.size());
+            }
+        }
+    };
 
-    LoadPrecompiledWorker(0, raws.size(), raws, decompiled, dumps);
+    LoadPrecompiledWorker();
+    // The prefetched entries must be done with the disk cache before it can be invalidated
+    for (auto& group : prefetch_groups) {
+        group.Wait();
+    }
+
+    if (invalid_entry) {
+        disk_cache.InvalidateAll();
+    }
 
     if (compilation_failed) {
         // Invalidate the precompiled cache if a shader dumped shader was rejected
         disk_cache.InvalidatePrecompiled();
-        dumps.clear();
         precompiled_cache_altered = true;
     }
 
@@ -554,65 +1100,137 @@ void ShaderProgramManager::LoadDiskCache(const std::atomic_bool& stop_loading,
 
     compilation_failed = false;
 
-    const auto LoadTransferable = [&](std::size_t begin, std::size_t end,
-                                      const std::vector<ShaderDiskCacheRaw>& raws) {
-        for (std::size_t i = 0; i < end; ++i) {
-            if (stop_loading || compilation_failed) {
-                return;
-            }
-            const auto& raw{raws[i]};
-            const u64 unique_identifier{raw.GetUniqueIdentifier()};
+    std::vector<std::size_t> pending;
+    for (std::size_t i = 0; i < raws.size(); ++i) {
+        if (!injected[i]) {
+            pending.push_back(i);
+        }
+    }
 
-            bool sanitize_mul = false;
-            GLuint handle{0};
-            std::optional<ShaderDecompiler::ProgramResult> result;
-            // Otherwise decompile and build the shader at boot and save the result to the
-            // precompiled file
-            if (raw.GetProgramType() == ProgramType::VS) {
-                // TODO: This isn't the ideal place to lock, since we really only want to
-                // lock access to the shared cache
-                auto [conf, setup] = BuildVSConfigFromRaw(raw);
-                std::scoped_lock lock(mutex);
-                auto [h, r] = impl->programmable_vertex_shaders.Get(conf, setup);
-                handle = h;
-                result = r;
-                sanitize_mul = conf.state.sanitize_mul;
-            } else if (raw.GetProgramType() == ProgramType::FS) {
-                PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
-                std::scoped_lock lock(mutex);
-                auto [h, r] = impl->fragment_shaders.Get(conf);
-                handle = h;
-                result = r;
-            } else {
-                // Unsupported shader type got stored somehow so nuke the cache
-                LOG_ERROR(Frontend, "failed to load raw programtype {}",
-                          static_cast<u32>(raw.GetProgramType()));
-                compilation_failed = true;
-                return;
-            }
-            if (handle == 0) {
-                LOG_ERROR(Frontend, "compilation from raw failed {:x} {:x}",
-                          raw.GetProgramCode().at(0), raw.GetProgramCode().at(1));
-                compilation_failed = true;
-                return;
-            }
-            // If this is a new shader, add it the precompiled cache
-            if (result) {
-                disk_cache.SaveDecompiled(unique_identifier, *result, sanitize_mul);
-                disk_cache.SaveDump(unique_identifier, handle);
-                precompiled_cache_altered = true;
+    // The shaders that were used the most in the previous sessions, or in the ones of imported
+    // bundles, are built first. With asynchronous compilation the rarely used ones are left to the
+    // background builder, so that they don't delay the boot.
+    std::vector<u64> usage(raws.size());
+    u64 pending_usage = 0;
+    for (const std::size_t index : pending) {
+        usage[index] = disk_cache.GetUsage(raws[index].GetUniqueIdentifier());
+        pending_usage += usage[index];
+    }
+    std::stable_sort(pending.begin(), pending.end(), [&usage](std::size_t lhs, std::size_t rhs) {
+        return usage[lhs] > usage[rhs];
+    });
+    std::vector<std::size_t> deferred;
+    if (impl->async_builder && pending_usage > 0) {
+        std::size_t num_boot = 0;
+        for (u64 covered = 0; covered * 100 < pending_usage * BOOT_USAGE_PERCENT; ++num_boot) {
+            covered += usage[pending[num_boot]];
+        }
+        deferred.assign(pending.begin() + num_boot, pending.end());
+        pending.resize(num_boot);
+    }
+
+    // Decompiling and linking is done by a pool of workers, each one on its own context shared
+    // with the emulator window. The finished programs are streamed back to this thread, which
+    // inserts them into the caches and the precompiled file. If the frontend can't provide shared
+    // contexts, this thread does all the work on its own.
+    std::vector<std::unique_ptr<Frontend::GraphicsContext>> worker_contexts;
+    const std::size_t num_workers =
+        std::min<std::size_t>(std::max(1U, std::thread::hardware_concurrency()), pending.size());
+    if (num_workers > 1) {
+        for (std::size_t i = 0; i < num_workers; ++i) {
+            auto context = emu_window.CreateSharedContext();
+            if (!context) {
+                break;
             }
+            worker_contexts.push_back(std::move(context));
+        }
+        // Some frontends make a newly created context current, so take ours back
+        emu_window.MakeCurrent();
+    }
 
-            if (callback) {
-                callback(VideoCore::LoadCallbackStage::Build, i, raws.size());
+    built_shaders = raws.size() - pending.size();
+    std::atomic<std::size_t> next_pending = 0;
+    Common::MPSCQueue<BuiltShader> built_queue;
+    const auto BuildWorker = [&](Frontend::GraphicsContext* context) {
+        std::optional<Frontend::ScopeAcquireContext> scope;
+        if (context) {
+            scope.emplace(*context);
+        }
+        for (std::size_t i = next_pending++; i < pending.size(); i = next_pending++) {
+            BuiltShader built{pending[i]};
+            if (!stop_loading && !compilation_failed) {
+                built = BuildShaderFromRaw(pending[i], raws[pending[i]], impl->separable);
+                if (built.program.handle == 0) {
+                    compilation_failed = true;
+                }
+            }
+            if (context) {
+                // Make sure the program is complete before it gets used on another context
+                glFinish();
             }
+            built_queue.Push(std::move(built));
         }
     };
 
-    LoadTransferable(0, raws.size(), raws);
+    std::vector<std::thread> workers;
+    for (auto& context : worker_contexts) {
+        workers.emplace_back(BuildWorker, context.get());
+    }
+    if (workers.empty()) {
+        BuildWorker(nullptr);
+    }
+
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        BuiltShader built = built_queue.PopWait();
+        if (built.program.handle == 0) {
+            // Either loading was stopped or a shader failed to build
+            continue;
+        }
+
+        const auto& raw{raws[built.index]};
+        const u64 unique_identifier{raw.GetUniqueIdentifier()};
+        const GLuint handle = built.program.handle;
+        bool new_shader = false;
+        bool sanitize_mul = false;
+        if (raw.GetProgramType() == ProgramType::VS) {
+            auto [conf, setup] = BuildVSConfigFromRaw(raw);
+            sanitize_mul = conf.state.sanitize_mul;
+            new_shader = impl->programmable_vertex_shaders.Inject(conf, built.result.code,
+                                                                  std::move(built.program));
+        } else if (raw.GetProgramType() == ProgramType::GS) {
+            auto [conf, setup] = BuildGSConfigFromRaw(raw);
+            sanitize_mul = conf.state.sanitize_mul;
+            new_shader = impl->programmable_geometry_shaders.Inject(conf, built.result.code,
+                                                                    std::move(built.program));
+        } else {
+            PicaFSConfig conf = PicaFSConfig::BuildFromRegs(raw.GetRawShaderConfig());
+            new_shader = impl->fragment_shaders.Inject(conf, built.result.code,
+                                                       std::move(built.program));
+        }
+
+        // If this is a new shader, add it the precompiled cache
+        if (new_shader) {
+            impl->program_uids.emplace(handle, unique_identifier);
+            disk_cache.SaveDecompiled(unique_identifier, built.result, sanitize_mul);
+            disk_cache.SaveDump(unique_identifier, handle);
+            precompiled_cache_altered = true;
+        }
+
+        if (callback) {
+            callback(VideoCore::LoadCallbackStage::Build, ++built_shaders, raws.size());
+        }
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
 
     if (compilation_failed) {
         disk_cache.InvalidateAll();
+    } else if (!stop_loading) {
+        for (const std::size_t index : deferred) {
+            impl->QueueFromDiskCache(raws[index]);
+        }
     }
 
     if (precompiled_cache_altered) {
@@ -17,9 +17,13 @@ namespace Core {
 class System;
 }
 
+namespace Frontend {
+class EmuWindow;
+}
+
 namespace OpenGL {
 
-enum class UniformBindings : GLuint { Common, VS, GS };
+enum class UniformBindings : GLuint { Common, VS, GS, FSUber };
 
 struct LightSrc {
     alignas(16) GLvec3 specular_0;
@@ -37,6 +41,9 @@ struct LightSrc {
 //       the end of a uniform block is included in UNIFORM_BLOCK_DATA_SIZE or not.
 //       Not following that rule will cause problems on some AMD drivers.
 struct UniformData {
+    /// Indices into lighting_lut_scales and FSUberUniformData::lighting_luts
+    enum Lut : GLint { LutD0, LutD1, LutSP, LutFR, LutRR, LutRG, LutRB, NumLuts };
+
     GLint framebuffer_scale;
     GLint alphatest_ref;
     GLfloat depth_scale;
@@ -55,6 +62,9 @@ struct UniformData {
     GLint proctex_diff_lut_offset;
     GLfloat proctex_bias;
     GLint shadow_texture_bias;
+    GLint proctex_lut_width;
+    GLint proctex_lod_min;
+    GLint proctex_lod_max;
     alignas(16) GLivec4 lighting_lut_offset[Pica::LightingRegs::NumLightingSampler / 4];
     alignas(16) GLvec3 fog_color;
     alignas(8) GLvec2 proctex_noise_f;
@@ -65,10 +75,12 @@ struct UniformData {
     alignas(16) GLvec4 const_color[6]; // A vec4 color for each of the six tev stages
     alignas(16) GLvec4 tev_combiner_buffer_color;
     alignas(16) GLvec4 clip_coef;
+    alignas(16) GLvec4 lighting_lut_scales[2];
+    alignas(16) GLivec4 proctex_lut_level_offsets;
 };
 
 static_assert(
-    sizeof(UniformData) == 0x4F0,
+    sizeof(UniformData) == 0x530,
     "The size of the UniformData structure has changed, update the structure in the shader");
 static_assert(sizeof(UniformData) < 16384,
               "UniformData structure must be less than 16kb as per the OpenGL spec");
@@ -96,10 +108,72 @@ static_assert(
 static_assert(sizeof(VSUniformData) < 16384,
               "VSUniformData structure must be less than 16kb as per the OpenGL spec");
 
+struct GSUniformData {
+    PicaUniformsData uniforms;
+};
+static_assert(
+    sizeof(GSUniformData) == 1856,
+    "The size of the GSUniformData structure has changed, update the structure in the shader");
+static_assert(sizeof(GSUniformData) < 16384,
+              "GSUniformData structure must be less than 16kb as per the OpenGL spec");
+
+/// Uniform struct for the Uniform Buffer Object that encodes a PicaFSConfig for the uber shader.
+// NOTE: the same rule from UniformData also applies here.
+struct FSUberUniformData {
+    void SetFromConfig(const PicaFSConfig& config);
+
+    /// Flags of an entry in lighting_lights
+    enum LightFlags : GLint {
+        LightDirectional = 1 << 0,
+        LightTwoSidedDiffuse = 1 << 1,
+        LightDistAtten = 1 << 2,
+        LightSpotAtten = 1 << 3,
+        LightGeometricFactor0 = 1 << 4,
+        LightGeometricFactor1 = 1 << 5,
+        LightShadow = 1 << 6,
+    };
+
+    alignas(16) GLivec4 tev_color_sources[6];
+    alignas(16) GLivec4 tev_alpha_sources[6];
+    alignas(16) GLivec4 tev_color_modifiers[6];
+    alignas(16) GLivec4 tev_alpha_modifiers[6];
+    GLint combiner_buffer_input;
+    GLint alpha_test_func;
+    GLint scissor_test_mode;
+    GLint texture0_type;
+    GLint texture2_use_coord1;
+    GLint depthmap_enable;
+    GLint fog_mode;
+    GLint fog_flip;
+    GLint lighting_enable;
+    GLint lighting_src_num;
+    GLint lighting_bump_mode;
+    GLint lighting_bump_selector;
+    GLint lighting_bump_renorm;
+    GLint lighting_clamp_highlights;
+    GLint lighting_config;
+    GLint lighting_enable_primary_alpha;
+    GLint lighting_enable_secondary_alpha;
+    GLint lighting_enable_shadow;
+    GLint lighting_shadow_primary;
+    GLint lighting_shadow_secondary;
+    GLint lighting_shadow_invert;
+    GLint lighting_shadow_alpha;
+    GLint lighting_shadow_selector;
+    alignas(16) GLivec4 lighting_lights[8];
+    alignas(16) GLivec4 lighting_luts[UniformData::NumLuts];
+};
+
+static_assert(
+    sizeof(FSUberUniformData) == 0x2D0,
+    "The size of the FSUberUniformData structure has changed, update the structure in the shader");
+static_assert(sizeof(FSUberUniformData) < 16384,
+              "FSUberUniformData structure must be less than 16kb as per the OpenGL spec");
+
 /// A class that manage different shader stages and configures them with given config data.
 class ShaderProgramManager {
 public:
-    ShaderProgramManager(bool separable, bool is_amd);
+    ShaderProgramManager(Frontend::EmuWindow& emu_window, bool separable, bool is_amd);
     ~ShaderProgramManager();
 
     void LoadDiskCache(const std::atomic_bool& stop_loading,
@@ -111,13 +185,24 @@ public:
 
     void UseFixedGeometryShader(const Pica::Regs& regs);
 
+    bool UseProgrammableGeometryShader(const Pica::Regs& regs, Pica::Shader::ShaderSetup& setup);
+
     void UseTrivialGeometryShader();
 
-    void UseFragmentShader(const Pica::Regs& config);
+    /**
+     * Selects the fragment shader for the given configuration. Returns false if the shader is
+     * still being built in the background, in which case the draw should be skipped.
+     */
+    bool UseFragmentShader(const Pica::Regs& config);
+
+    /// Returns the uniforms to upload if the current fragment shader is the uber shader
+    const FSUberUniformData* GetUberUniformData() const;
 
     void ApplyTo(OpenGLState& state);
 
 private:
+    Frontend::EmuWindow& emu_window;
+
     class Impl;
     std::unique_ptr<Impl> impl;
 };
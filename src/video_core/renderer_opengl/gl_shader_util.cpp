@@ -8,6 +8,7 @@
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "core/perf_metrics.h"
 #include "video_core/renderer_opengl/gl_shader_util.h"
 #include "video_core/renderer_opengl/gl_vars.h"
 
@@ -48,6 +49,7 @@ GLuint LoadShader(const char* source, GLenum type) {
     glShaderSource(shader_id, static_cast<GLsizei>(src_arr.size()), src_arr.data(), nullptr);
     LOG_DEBUG(Render_OpenGL, "Compiling {} shader...", debug_type);
     glCompileShader(shader_id);
+    Core::Metrics::Add(Core::Metrics::Counter::ShaderCompiles);
 
     GLint result = GL_FALSE;
     GLint info_log_length;
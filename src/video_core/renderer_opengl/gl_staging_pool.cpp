@@ -0,0 +1,102 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include "common/assert.h"
+#include "core/perf_metrics.h"
+#include "video_core/renderer_opengl/gl_staging_pool.h"
+
+namespace OpenGL {
+
+StagingPool::Buffer::~Buffer() {
+    Release();
+}
+
+StagingPool::Buffer::Buffer(Buffer&& other) noexcept
+    : pool(std::exchange(other.pool, nullptr)), memory(std::move(other.memory)),
+      length(std::exchange(other.length, 0)), size_class(other.size_class) {}
+
+StagingPool::Buffer& StagingPool::Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        Release();
+        pool = std::exchange(other.pool, nullptr);
+        memory = std::move(other.memory);
+        length = std::exchange(other.length, 0);
+        size_class = other.size_class;
+    }
+    return *this;
+}
+
+void StagingPool::Buffer::Release() {
+    if (memory == nullptr)
+        return;
+    pool->Return(*this);
+    pool = nullptr;
+    length = 0;
+}
+
+StagingPool::StagingPool() = default;
+
+StagingPool::~StagingPool() {
+    // The surfaces return their buffers right after each transfer
+    ASSERT(used_size == 0);
+    cached_size = 0;
+    UpdateMetrics();
+}
+
+StagingPool::Buffer StagingPool::Acquire(std::size_t size) {
+    Buffer buffer;
+    if (size == 0)
+        return buffer;
+
+    std::size_t size_class = 0;
+    while (size_class < NUM_CLASSES && GetClassSize(size_class) < size) {
+        ++size_class;
+    }
+
+    buffer.pool = this;
+    buffer.length = size;
+    buffer.size_class = size_class;
+    if (size_class == NUM_CLASSES) {
+        buffer.memory.reset(new u8[size]);
+        used_size += size;
+    } else {
+        auto& free_list = free_lists[size_class];
+        const std::size_t class_size = GetClassSize(size_class);
+        if (free_list.empty()) {
+            // Not make_unique, which would zero the memory
+            buffer.memory.reset(new u8[class_size]);
+        } else {
+            buffer.memory = std::move(free_list.back());
+            free_list.pop_back();
+            cached_size -= class_size;
+        }
+        used_size += class_size;
+    }
+    UpdateMetrics();
+    return buffer;
+}
+
+void StagingPool::Return(Buffer& buffer) {
+    if (buffer.size_class == NUM_CLASSES) {
+        used_size -= buffer.length;
+        buffer.memory.reset();
+    } else {
+        const std::size_t class_size = GetClassSize(buffer.size_class);
+        used_size -= class_size;
+        if (cached_size + class_size <= MAX_CACHED_SIZE) {
+            free_lists[buffer.size_class].push_back(std::move(buffer.memory));
+            cached_size += class_size;
+        } else {
+            buffer.memory.reset();
+        }
+    }
+    UpdateMetrics();
+}
+
+void StagingPool::UpdateMetrics() const {
+    Core::Metrics::SetGauge(Core::Metrics::Gauge::StagingBytes, GetAllocatedSize());
+}
+
+} // namespace OpenGL
@@ -0,0 +1,92 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+
+namespace OpenGL {
+
+/**
+ * Host memory that surfaces decode into and read back into while they are loaded or flushed.
+ * Surfaces only borrow a buffer for the duration of a transfer, so the memory is shared by all
+ * surfaces instead of each of them keeping a copy of its texture around. Buffers are rounded up
+ * to power of two size classes and kept in a free list per class when returned, up to a bound.
+ */
+class StagingPool : NonCopyable {
+public:
+    /// Memory borrowed from the pool, with unspecified contents. Returned to it when released.
+    class Buffer {
+    public:
+        Buffer() = default;
+        ~Buffer();
+
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+
+        /// Returns the memory to the pool, leaving the buffer empty
+        void Release();
+
+        bool empty() const {
+            return memory == nullptr;
+        }
+
+        std::size_t size() const {
+            return length;
+        }
+
+        u8* data() const {
+            return memory.get();
+        }
+
+        u8& operator[](std::size_t index) const {
+            return memory[index];
+        }
+
+    private:
+        friend class StagingPool;
+
+        StagingPool* pool = nullptr;
+        std::unique_ptr<u8[]> memory;
+        std::size_t length = 0;
+        std::size_t size_class = 0;
+    };
+
+    StagingPool();
+    ~StagingPool();
+
+    /// Borrows a buffer of the given size
+    Buffer Acquire(std::size_t size);
+
+    /// Returns the bytes held by the pool, both borrowed and kept in the free lists
+    std::size_t GetAllocatedSize() const {
+        return used_size + cached_size;
+    }
+
+private:
+    static constexpr std::size_t MIN_CLASS_BITS = 12; // 4 KiB
+    static constexpr std::size_t MAX_CLASS_BITS = 24; // 16 MiB, larger buffers aren't kept
+    static constexpr std::size_t NUM_CLASSES = MAX_CLASS_BITS - MIN_CLASS_BITS + 1;
+    /// Free memory kept for reuse, returned buffers beyond it are freed
+    static constexpr std::size_t MAX_CACHED_SIZE = 32 * 1024 * 1024;
+
+    static std::size_t GetClassSize(std::size_t size_class) {
+        return std::size_t{1} << (size_class + MIN_CLASS_BITS);
+    }
+
+    void Return(Buffer& buffer);
+
+    /// Reports the allocated size to the metrics
+    void UpdateMetrics() const;
+
+    std::array<std::vector<std::unique_ptr<u8[]>>, NUM_CLASSES> free_lists;
+    std::size_t used_size = 0;
+    std::size_t cached_size = 0;
+};
+
+} // namespace OpenGL
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
 #include <glad/glad.h>
 #include "common/common_funcs.h"
 #include "common/logging/log.h"
@@ -93,6 +94,76 @@ OpenGLState::OpenGLState() {
     renderbuffer = 0;
 }
 
+void OpenGLState::ApplyTextures(const OpenGLState& cur_state) const {
+    for (unsigned i = 0; i < ARRAY_SIZE(texture_units); ++i) {
+        if (texture_units[i].texture_2d != cur_state.texture_units[i].texture_2d) {
+            glActiveTexture(TextureUnits::PicaTexture(i).Enum());
+            glBindTexture(GL_TEXTURE_2D, texture_units[i].texture_2d);
+        }
+        if (texture_units[i].sampler != cur_state.texture_units[i].sampler) {
+            glBindSampler(i, texture_units[i].sampler);
+        }
+    }
+
+    if (texture_cube_unit.texture_cube != cur_state.texture_cube_unit.texture_cube) {
+        glActiveTexture(TextureUnits::TextureCube.Enum());
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture_cube_unit.texture_cube);
+    }
+    if (texture_cube_unit.sampler != cur_state.texture_cube_unit.sampler) {
+        glBindSampler(TextureUnits::TextureCube.id, texture_cube_unit.sampler);
+    }
+
+    // Texture buffer LUTs
+    if (texture_buffer_lut_rg.texture_buffer != cur_state.texture_buffer_lut_rg.texture_buffer) {
+        glActiveTexture(TextureUnits::TextureBufferLUT_RG.Enum());
+        glBindTexture(GL_TEXTURE_BUFFER, texture_buffer_lut_rg.texture_buffer);
+    }
+
+    // Texture buffer LUTs
+    if (texture_buffer_lut_rgba.texture_buffer !=
+        cur_state.texture_buffer_lut_rgba.texture_buffer) {
+        glActiveTexture(TextureUnits::TextureBufferLUT_RGBA.Enum());
+        glBindTexture(GL_TEXTURE_BUFFER, texture_buffer_lut_rgba.texture_buffer);
+    }
+}
+
+/// Binds the changed range of a contiguous group of units with a single call
+template <std::size_t N, typename Func>
+static void BindChangedRange(const std::array<GLuint, N>& names,
+                             const std::array<GLuint, N>& cur_names, Func&& bind) {
+    std::size_t first = 0;
+    while (first < N && names[first] == cur_names[first])
+        ++first;
+    if (first == N)
+        return;
+    std::size_t last = N - 1;
+    while (names[last] == cur_names[last])
+        --last;
+    bind(static_cast<GLuint>(first), static_cast<GLsizei>(last - first + 1), &names[first]);
+}
+
+void OpenGLState::ApplyTexturesMultiBind(const OpenGLState& cur_state) const {
+    // The units of the PICA textures, the cube map and the LUTs are numbered contiguously, the
+    // target of every unit is taken from its texture
+    static_assert(TextureUnits::TextureCube.id == 3 && TextureUnits::TextureBufferLUT_RG.id == 4 &&
+                  TextureUnits::TextureBufferLUT_RGBA.id == 5);
+    const auto textures_of = [](const OpenGLState& state) {
+        return std::array<GLuint, 6>{state.texture_units[0].texture_2d,
+                                     state.texture_units[1].texture_2d,
+                                     state.texture_units[2].texture_2d,
+                                     state.texture_cube_unit.texture_cube,
+                                     state.texture_buffer_lut_rg.texture_buffer,
+                                     state.texture_buffer_lut_rgba.texture_buffer};
+    };
+    const auto samplers_of = [](const OpenGLState& state) {
+        return std::array<GLuint, 4>{state.texture_units[0].sampler, state.texture_units[1].sampler,
+                                     state.texture_units[2].sampler,
+                                     state.texture_cube_unit.sampler};
+    };
+    BindChangedRange(textures_of(*this), textures_of(cur_state), glBindTextures);
+    BindChangedRange(samplers_of(*this), samplers_of(cur_state), glBindSamplers);
+}
+
 void OpenGLState::Apply() const {
     // Culling
     if (cull.enabled != cur_state.cull.enabled) {
@@ -205,36 +276,10 @@ void OpenGLState::Apply() const {
         LOG_TRACE(Render_OpenGL, "glLogicOps are unimplemented...");
     }
 
-    // Textures
-    for (unsigned i = 0; i < ARRAY_SIZE(texture_units); ++i) {
-        if (texture_units[i].texture_2d != cur_state.texture_units[i].texture_2d) {
-            glActiveTexture(TextureUnits::PicaTexture(i).Enum());
-            glBindTexture(GL_TEXTURE_2D, texture_units[i].texture_2d);
-        }
-        if (texture_units[i].sampler != cur_state.texture_units[i].sampler) {
-            glBindSampler(i, texture_units[i].sampler);
-        }
-    }
-
-    if (texture_cube_unit.texture_cube != cur_state.texture_cube_unit.texture_cube) {
-        glActiveTexture(TextureUnits::TextureCube.Enum());
-        glBindTexture(GL_TEXTURE_CUBE_MAP, texture_cube_unit.texture_cube);
-    }
-    if (texture_cube_unit.sampler != cur_state.texture_cube_unit.sampler) {
-        glBindSampler(TextureUnits::TextureCube.id, texture_cube_unit.sampler);
-    }
-
-    // Texture buffer LUTs
-    if (texture_buffer_lut_rg.texture_buffer != cur_state.texture_buffer_lut_rg.texture_buffer) {
-        glActiveTexture(TextureUnits::TextureBufferLUT_RG.Enum());
-        glBindTexture(GL_TEXTURE_BUFFER, texture_buffer_lut_rg.texture_buffer);
-    }
-
-    // Texture buffer LUTs
-    if (texture_buffer_lut_rgba.texture_buffer !=
-        cur_state.texture_buffer_lut_rgba.texture_buffer) {
-        glActiveTexture(TextureUnits::TextureBufferLUT_RGBA.Enum());
-        glBindTexture(GL_TEXTURE_BUFFER, texture_buffer_lut_rgba.texture_buffer);
+    if (GLAD_GL_ARB_multi_bind) {
+        ApplyTexturesMultiBind(cur_state);
+    } else {
+        ApplyTextures(cur_state);
     }
 
     // Shadow Images
@@ -169,6 +169,11 @@ public:
     OpenGLState& ResetRenderbuffer(GLuint handle);
 
 private:
+    /// Binds the changed textures and samplers one unit at a time
+    void ApplyTextures(const OpenGLState& cur_state) const;
+    /// Binds the changed textures and samplers with ARB_multi_bind, a call for each kind
+    void ApplyTexturesMultiBind(const OpenGLState& cur_state) const;
+
     static OpenGLState cur_state;
 };
 
@@ -2,19 +2,22 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <deque>
-#include <vector>
+#include <algorithm>
 #include "common/alignment.h"
 #include "common/assert.h"
+#include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "video_core/renderer_opengl/gl_state.h"
 #include "video_core/renderer_opengl/gl_stream_buffer.h"
 
 MICROPROFILE_DEFINE(OpenGL_StreamBuffer, "OpenGL", "Stream Buffer Orphaning",
                     MP_RGB(128, 128, 192));
+MICROPROFILE_DEFINE(OpenGL_StreamBufferWait, "OpenGL", "Stream Buffer Wait", MP_RGB(128, 128, 192));
 
 namespace OpenGL {
 
+constexpr GLuint64 FENCE_TIMEOUT = 1000000000; // 1 second in nanoseconds
+
 OGLStreamBuffer::OGLStreamBuffer(GLenum target, GLsizeiptr size, bool array_buffer_for_amd,
                                  bool prefer_coherent)
     : gl_target(target), buffer_size(size) {
@@ -45,6 +48,11 @@ OGLStreamBuffer::OGLStreamBuffer(GLenum target, GLsizeiptr size, bool array_buff
 }
 
 OGLStreamBuffer::~OGLStreamBuffer() {
+    for (GLsync fence : region_fences) {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+    }
+
     if (persistent) {
         glBindBuffer(gl_target, gl_buffer.handle);
         glUnmapBuffer(gl_target);
@@ -75,14 +83,32 @@ std::tuple<u8*, GLintptr, bool> OGLStreamBuffer::Map(GLsizeiptr size, GLintptr a
         invalidate = true;
 
         if (persistent) {
-            glUnmapBuffer(gl_target);
+            // Instead of orphaning the buffer, which makes some drivers synchronize, the chunks
+            // of the last pass are fenced and allocation continues at the oldest region
+            for (std::size_t region = current_region; region < NUM_REGIONS; ++region) {
+                FenceRegion(region);
+            }
+            current_region = 0;
+            WaitRegion(0);
         }
     }
 
-    if (invalidate || !persistent) {
+    if (persistent) {
+        const std::size_t first_region = GetRegion(buffer_pos);
+        const std::size_t last_region = GetRegion(buffer_pos + std::max<GLsizeiptr>(size, 1) - 1);
+        for (std::size_t region = current_region; region < first_region; ++region) {
+            FenceRegion(region);
+        }
+        // Draws issued after the fence must not read the regions left behind, otherwise they
+        // could be overwritten while still in use, so the old chunks are invalidated as well
+        invalidate |= first_region != current_region;
+        for (std::size_t region = current_region + 1; region <= last_region; ++region) {
+            WaitRegion(region);
+        }
+        current_region = first_region;
+    } else {
         MICROPROFILE_SCOPE(OpenGL_StreamBuffer);
-        GLbitfield flags = GL_MAP_WRITE_BIT | (persistent ? GL_MAP_PERSISTENT_BIT : 0) |
-                           (coherent ? GL_MAP_COHERENT_BIT : GL_MAP_FLUSH_EXPLICIT_BIT) |
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT |
                            (invalidate ? GL_MAP_INVALIDATE_BUFFER_BIT : GL_MAP_UNSYNCHRONIZED_BIT);
         mapped_ptr = static_cast<u8*>(
             glMapBufferRange(gl_target, buffer_pos, buffer_size - buffer_pos, flags));
@@ -92,6 +118,34 @@ std::tuple<u8*, GLintptr, bool> OGLStreamBuffer::Map(GLsizeiptr size, GLintptr a
     return std::make_tuple(mapped_ptr + buffer_pos - mapped_offset, buffer_pos, invalidate);
 }
 
+std::size_t OGLStreamBuffer::GetRegion(GLintptr offset) const {
+    const GLsizeiptr region_size = buffer_size / NUM_REGIONS;
+    return std::min(static_cast<std::size_t>(offset / region_size), NUM_REGIONS - 1);
+}
+
+void OGLStreamBuffer::FenceRegion(std::size_t region) {
+    if (region_fences[region] != nullptr)
+        glDeleteSync(region_fences[region]);
+    region_fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void OGLStreamBuffer::WaitRegion(std::size_t region) {
+    GLsync& fence = region_fences[region];
+    if (fence == nullptr)
+        return;
+
+    MICROPROFILE_SCOPE(OpenGL_StreamBufferWait);
+    GLenum result;
+    do {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+    } while (result == GL_TIMEOUT_EXPIRED);
+    if (result == GL_WAIT_FAILED) {
+        LOG_ERROR(Render_OpenGL, "Waiting for a stream buffer region failed");
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
 void OGLStreamBuffer::Unmap(GLsizeiptr size) {
     ASSERT(size <= mapped_size);
 
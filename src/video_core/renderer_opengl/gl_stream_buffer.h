@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <tuple>
 #include <glad/glad.h>
 #include "common/common_types.h"
@@ -23,7 +25,10 @@ public:
     /*
      * Allocates a linear chunk of memory in the GPU buffer with at least "size" bytes
      * and the optional alignment requirement.
-     * If the buffer is full, the whole buffer is reallocated which invalidates old chunks.
+     * If the buffer is full, allocation restarts at its beginning and old chunks are invalidated.
+     * Persistently mapped buffers wait for the GPU to finish reading the reused part, others are
+     * reallocated. Persistently mapped buffers also invalidate the old chunks whenever allocation
+     * moves on to the next region, as the region's fence doesn't cover later draws reading it.
      * The return values are the pointer to the new chunk, the offset within the buffer,
      * and the invalidation flag for previous chunks.
      * The actual used size must be specified on unmapping the chunk.
@@ -33,6 +38,15 @@ public:
     void Unmap(GLsizeiptr size);
 
 private:
+    /// Persistently mapped buffers are split into regions that are fenced separately
+    static constexpr std::size_t NUM_REGIONS = 3;
+
+    std::size_t GetRegion(GLintptr offset) const;
+    /// Marks the point after which the GPU no longer reads the region written so far
+    void FenceRegion(std::size_t region);
+    /// Waits until the GPU no longer reads the region before it gets written again
+    void WaitRegion(std::size_t region);
+
     OGLBuffer gl_buffer;
     GLenum gl_target;
 
@@ -44,6 +58,10 @@ private:
     GLintptr mapped_offset = 0;
     GLsizeiptr mapped_size = 0;
     u8* mapped_ptr = nullptr;
+
+    std::array<GLsync, NUM_REGIONS> region_fences{};
+    /// Region the last chunk started in, all regions before it are fenced when a chunk is mapped
+    std::size_t current_region = 0;
 };
 
 } // namespace OpenGL
@@ -0,0 +1,121 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "video_core/renderer_opengl/gl_gpu_profiler.h"
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+#include "video_core/renderer_opengl/gl_surface_readback.h"
+
+namespace OpenGL {
+
+// Slots are grown in steps of this size so they don't get reallocated for every surface
+constexpr std::size_t SLOT_ALIGNMENT = 1024 * 1024;
+
+constexpr GLuint64 FENCE_TIMEOUT = 1000000000; // 1 second in nanoseconds
+
+SurfaceReadback::SurfaceReadback() : supported(GLAD_GL_ARB_buffer_storage) {}
+
+SurfaceReadback::~SurfaceReadback() {
+    for (Slot& slot : slots) {
+        if (slot.fence != nullptr)
+            glDeleteSync(slot.fence);
+    }
+}
+
+MICROPROFILE_DEFINE(OpenGL_ReadbackStart, "OpenGL", "Readback Start", MP_RGB(128, 192, 64));
+void SurfaceReadback::Start(CachedSurface& surface, const Common::Rectangle<u32>& rect,
+                            GLuint read_fb_handle, GLuint draw_fb_handle) {
+    ASSERT(supported);
+    MICROPROFILE_SCOPE(OpenGL_ReadbackStart);
+    GPUProfiler::Scope gpu_scope{GPUProfiler::Pass::Download};
+
+    const std::size_t slot_index = next_slot;
+    next_slot = (next_slot + 1) % NUM_SLOTS;
+
+    // Reusing the slot drops the download of its previous owner, which is detected by the ticket
+    Slot& slot = slots[slot_index];
+    if (slot.fence != nullptr) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+
+    const GLsizeiptr size = rect.GetHeight() * surface.stride *
+                            CachedSurface::GetGLBytesPerPixel(surface.pixel_format);
+    if (size > slot.size) {
+        constexpr GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        slot.buffer.Release();
+        slot.buffer.Create();
+        slot.size = static_cast<GLsizeiptr>(
+            Common::AlignUp(static_cast<std::size_t>(size), SLOT_ALIGNMENT));
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer.handle);
+        glBufferStorage(GL_PIXEL_PACK_BUFFER, slot.size, nullptr, flags);
+        slot.mapped =
+            static_cast<const u8*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, flags));
+    } else {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer.handle);
+    }
+
+    surface.ReadGLTexture(rect, read_fb_handle, draw_fb_handle, nullptr,
+                          static_cast<std::size_t>(slot.size));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.ticket = next_ticket++;
+    surface.pending_readback = Pending{rect, slot_index, slot.ticket};
+}
+
+MICROPROFILE_DEFINE(OpenGL_ReadbackWait, "OpenGL", "Readback Wait", MP_RGB(128, 192, 64));
+bool SurfaceReadback::Finish(CachedSurface& surface, const Common::Rectangle<u32>& rect) {
+    if (!surface.pending_readback)
+        return false;
+
+    const Pending pending = *surface.pending_readback;
+    Slot& slot = slots[pending.slot];
+    if (slot.ticket != pending.ticket) {
+        surface.pending_readback.reset();
+        return false;
+    }
+
+    const Common::Rectangle<u32>& src_rect = pending.rect;
+    if (rect.left < src_rect.left || rect.right > src_rect.right ||
+        rect.bottom < src_rect.bottom || rect.top > src_rect.top)
+        return false;
+
+    MICROPROFILE_SCOPE(OpenGL_ReadbackWait);
+
+    if (slot.fence != nullptr) {
+        GLenum result;
+        do {
+            result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+
+        if (result == GL_WAIT_FAILED) {
+            LOG_ERROR(Render_OpenGL, "Waiting for a surface readback failed");
+            slot.ticket = 0;
+            surface.pending_readback.reset();
+            return false;
+        }
+    }
+
+    const u32 bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(surface.pixel_format);
+    ASSERT(surface.gl_buffer.size() == surface.width * surface.height * bytes_per_pixel);
+
+    const std::size_t row_size = rect.GetWidth() * bytes_per_pixel;
+    for (u32 y = rect.bottom; y < rect.top; ++y) {
+        const u8* const src = slot.mapped + ((y - src_rect.bottom) * surface.stride +
+                                             (rect.left - src_rect.left)) *
+                                                bytes_per_pixel;
+        std::memcpy(&surface.gl_buffer[(y * surface.stride + rect.left) * bytes_per_pixel], src,
+                    row_size);
+    }
+    return true;
+}
+
+} // namespace OpenGL
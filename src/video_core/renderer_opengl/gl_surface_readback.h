@@ -0,0 +1,68 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/math_util.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+struct CachedSurface;
+
+/**
+ * Ring of persistently mapped pixel pack buffers used to download surfaces ahead of time. A
+ * download is queued on the GPU with a fence when a surface is expected to be read by the CPU,
+ * so that the flush only has to wait for the fence instead of stalling on glReadPixels.
+ */
+class SurfaceReadback : NonCopyable {
+public:
+    /// A download owned by a surface. It is lost once its slot is reused by a newer download.
+    struct Pending {
+        Common::Rectangle<u32> rect;
+        std::size_t slot;
+        u64 ticket;
+    };
+
+    SurfaceReadback();
+    ~SurfaceReadback();
+
+    /// Whether the driver supports persistently mapped buffers, which the ring relies on
+    bool IsSupported() const {
+        return supported;
+    }
+
+    /// Starts downloading the given region of the surface and stores it as its pending readback
+    void Start(CachedSurface& surface, const Common::Rectangle<u32>& rect, GLuint read_fb_handle,
+               GLuint draw_fb_handle);
+
+    /**
+     * Copies the given region into the surface's gl_buffer from its pending readback, waiting for
+     * the GPU to finish the download if needed
+     * @returns false if no pending readback of the surface covers the region
+     */
+    bool Finish(CachedSurface& surface, const Common::Rectangle<u32>& rect);
+
+private:
+    struct Slot {
+        OGLBuffer buffer;
+        GLsizeiptr size = 0;
+        const u8* mapped = nullptr;
+        GLsync fence = nullptr;
+        u64 ticket = 0;
+    };
+
+    static constexpr std::size_t NUM_SLOTS = 4;
+
+    bool supported = false;
+    std::array<Slot, NUM_SLOTS> slots;
+    std::size_t next_slot = 0;
+    u64 next_ticket = 1;
+};
+
+} // namespace OpenGL
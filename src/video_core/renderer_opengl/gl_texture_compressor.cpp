@@ -0,0 +1,153 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/scope_exit.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_texture_compressor.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+
+#include "shaders/tex_coord.vert"
+#include "shaders/texture_compress.frag"
+
+namespace OpenGL {
+
+using PixelFormat = SurfaceParams::PixelFormat;
+
+static bool HasAlpha(const CachedSurface& surface) {
+    // Replacements are always RGBA8
+    if (surface.is_custom)
+        return true;
+
+    switch (surface.pixel_format) {
+    case PixelFormat::RG8:
+    case PixelFormat::I8:
+    case PixelFormat::I4:
+    case PixelFormat::ETC1:
+        return false;
+    default:
+        return true;
+    }
+}
+
+TextureCompressor::TextureCompressor() {
+    if (GLES || !GLAD_GL_ARB_copy_image || !GLAD_GL_ARB_texture_storage ||
+        !GLAD_GL_EXT_texture_compression_s3tc) {
+        if (Settings::values.texture_compression != Settings::TextureCompression::Off) {
+            LOG_WARNING(Render_OpenGL, "Texture compression isn't supported by the driver");
+        }
+        return;
+    }
+
+    program.Create(tex_coord_vert.data(), texture_compress_frag.data());
+    vao.Create();
+
+    OpenGLState state = OpenGLState::GetCurState();
+    GLuint old_program = state.draw.shader_program;
+    state.draw.shader_program = program.handle;
+    state.Apply();
+
+    GLint source_u_id = glGetUniformLocation(program.handle, "source");
+    ASSERT(source_u_id != -1);
+    glUniform1i(source_u_id, 0);
+
+    state.draw.shader_program = old_program;
+    state.Apply();
+
+    has_alpha_u_id = glGetUniformLocation(program.handle, "has_alpha");
+    high_quality_u_id = glGetUniformLocation(program.handle, "high_quality");
+
+    supported = true;
+}
+
+bool TextureCompressor::IsEnabled() const {
+    return supported && Settings::values.texture_compression != Settings::TextureCompression::Off;
+}
+
+MICROPROFILE_DEFINE(OpenGL_TextureCompress, "OpenGL", "Texture Compress", MP_RGB(128, 192, 64));
+std::size_t TextureCompressor::Compress(CachedSurface& surface, GLuint draw_fb_handle) {
+    if (!IsEnabled())
+        return 0;
+
+    MICROPROFILE_SCOPE(OpenGL_TextureCompress);
+
+    OpenGLState prev_state = OpenGLState::GetCurState();
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    // Replacements don't have the size of the surface, ask the texture instead
+    OpenGLState state;
+    state.texture_units[0].texture_2d = surface.texture.handle;
+    state.Apply();
+    glActiveTexture(GL_TEXTURE0);
+    GLint width = 0;
+    GLint height = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+    if (width < 4 || height < 4 || width % 4 != 0 || height % 4 != 0)
+        return 0;
+
+    const bool has_alpha = HasAlpha(surface);
+    const GLsizei blocks_width = width / 4;
+    const GLsizei blocks_height = height / 4;
+
+    OGLTexture blocks;
+    blocks.Create();
+    state.texture_units[0].texture_2d = blocks.handle;
+    state.Apply();
+    glTexImage2D(GL_TEXTURE_2D, 0, has_alpha ? GL_RGBA32UI : GL_RG32UI, blocks_width,
+                 blocks_height, 0, has_alpha ? GL_RGBA_INTEGER : GL_RG_INTEGER, GL_UNSIGNED_INT,
+                 nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    state.texture_units[0].texture_2d = surface.texture.handle;
+    state.draw.draw_framebuffer = draw_fb_handle;
+    state.draw.shader_program = program.handle;
+    state.draw.vertex_array = vao.handle;
+    state.viewport.x = 0;
+    state.viewport.y = 0;
+    state.viewport.width = blocks_width;
+    state.viewport.height = blocks_height;
+    state.Apply();
+
+    glUniform1i(has_alpha_u_id, has_alpha);
+    glUniform1i(high_quality_u_id, Settings::values.texture_compression ==
+                                       Settings::TextureCompression::HighQuality);
+
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blocks.handle,
+                           0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+
+    OGLTexture compressed;
+    compressed.Create();
+    state.texture_units[0].texture_2d = compressed.handle;
+    state.Apply();
+    glTexStorage2D(GL_TEXTURE_2D, 1,
+                   has_alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                   width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Each texel of the block texture has the size of one compressed block
+    glCopyImageSubData(blocks.handle, GL_TEXTURE_2D, 0, 0, 0, 0, compressed.handle, GL_TEXTURE_2D,
+                       0, 0, 0, 0, blocks_width, blocks_height, 1);
+
+    // The previous state may still have the deleted texture bound
+    prev_state.ResetTexture(surface.texture.handle);
+    surface.texture = std::move(compressed);
+    surface.is_compressed = true;
+    surface.InvalidateAllWatcher();
+    return static_cast<std::size_t>(blocks_width) * blocks_height * (has_alpha ? 16 : 8);
+}
+
+} // namespace OpenGL
@@ -0,0 +1,44 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+struct CachedSurface;
+
+/**
+ * Compresses upscaled and custom textures to BC1, or BC3 if they have alpha, on the GPU. A
+ * fragment shader encodes the blocks into an integer texture with one texel per block, which is
+ * then copied into the compressed texture with glCopyImageSubData.
+ */
+class TextureCompressor {
+public:
+    TextureCompressor();
+
+    /// Whether compression is both supported by the driver and enabled in the settings
+    bool IsEnabled() const;
+
+    /**
+     * Replaces the texture of a surface with a compressed copy of it. Compressed textures can
+     * only be sampled, they can't be attached to framebuffers.
+     * @returns the size of the compressed texture in bytes, 0 if the texture wasn't compressed
+     */
+    std::size_t Compress(CachedSurface& surface, GLuint draw_fb_handle);
+
+private:
+    bool supported = false;
+
+    OGLProgram program;
+    OGLVertexArray vao;
+
+    GLint has_alpha_u_id = -1;
+    GLint high_quality_u_id = -1;
+};
+
+} // namespace OpenGL
@@ -0,0 +1,156 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <tuple>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/scope_exit.h"
+#include "core/memory.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_texture_decoder.h"
+#include "video_core/renderer_opengl/gl_vars.h"
+#include "video_core/renderer_opengl/texture_filters/texture_filter_manager.h"
+#include "video_core/video_core.h"
+
+#include "shaders/tex_coord.vert"
+#include "shaders/texture_decode.frag"
+
+namespace OpenGL {
+
+using SurfaceType = SurfaceParams::SurfaceType;
+
+// Large enough for a 1024x1024 texture in any of the texture-only formats
+constexpr GLsizeiptr TILED_BUFFER_SIZE = 4 * 1024 * 1024;
+
+TextureDecoder::TextureDecoder() : tiled_buffer(GL_TEXTURE_BUFFER, TILED_BUFFER_SIZE, false) {
+    // Buffer textures are not available on GLES 3.1 without extensions
+    if (GLES)
+        return;
+
+    GLint max_texels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+    if (static_cast<GLsizeiptr>(max_texels) * 4 < TILED_BUFFER_SIZE) {
+        LOG_WARNING(Render_OpenGL, "Texture buffers are too small for GPU texture decoding");
+        return;
+    }
+
+    tiled_tbo.Create();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, tiled_tbo.handle);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, tiled_buffer.GetHandle());
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    program.Create(tex_coord_vert.data(), texture_decode_frag.data());
+    vao.Create();
+
+    OpenGLState state = OpenGLState::GetCurState();
+    GLuint old_program = state.draw.shader_program;
+    state.draw.shader_program = program.handle;
+    state.Apply();
+
+    GLint tiled_data_u_id = glGetUniformLocation(program.handle, "tiled_data");
+    ASSERT(tiled_data_u_id != -1);
+    glUniform1i(tiled_data_u_id, 0);
+
+    state.draw.shader_program = old_program;
+    state.Apply();
+
+    format_u_id = glGetUniformLocation(program.handle, "format");
+    data_start_u_id = glGetUniformLocation(program.handle, "data_start");
+    tile_size_u_id = glGetUniformLocation(program.handle, "tile_size");
+    line_size_u_id = glGetUniformLocation(program.handle, "line_size");
+    height_u_id = glGetUniformLocation(program.handle, "height");
+    rect_origin_u_id = glGetUniformLocation(program.handle, "rect_origin");
+    viewport_u_id = glGetUniformLocation(program.handle, "viewport");
+    res_scale_u_id = glGetUniformLocation(program.handle, "res_scale");
+
+    supported = true;
+}
+
+bool TextureDecoder::IsSupported(const CachedSurface& surface) const {
+    if (!supported || !Settings::values.gpu_texture_decoding)
+        return false;
+
+    // Dumping, replacing and filtering textures all work on the decoded data in gl_buffer
+    if (Settings::values.dump_textures || Settings::values.custom_textures ||
+        TextureFilterManager::GetInstance().GetTextureFilter() != nullptr)
+        return false;
+
+    return surface.type == SurfaceType::Texture && surface.is_tiled;
+}
+
+MICROPROFILE_DEFINE(OpenGL_TextureDecode, "OpenGL", "Texture Decode", MP_RGB(128, 192, 64));
+bool TextureDecoder::Decode(CachedSurface& surface, const SurfaceParams& params,
+                            GLuint draw_fb_handle) {
+    if (!IsSupported(surface))
+        return false;
+
+    // LoadGLBuffer clamps loads crossing the VRAM boundaries, leave those to it
+    if ((params.addr < Memory::VRAM_VADDR && params.end > Memory::VRAM_VADDR) ||
+        (params.addr < Memory::VRAM_VADDR_END && params.end > Memory::VRAM_VADDR_END))
+        return false;
+
+    const u8* const src_data = VideoCore::g_memory->GetPhysicalPointer(params.addr);
+    if (src_data == nullptr || params.size > TILED_BUFFER_SIZE)
+        return false;
+
+    MICROPROFILE_SCOPE(OpenGL_TextureDecode);
+
+    // Tiled intervals always start and end on whole tiles, which are a multiple of 4 bytes
+    const u32 start_offset = params.addr - surface.addr;
+    ASSERT(start_offset % 4 == 0 && params.size % 4 == 0);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, tiled_buffer.GetHandle());
+    u8* buffer;
+    GLintptr buffer_offset;
+    std::tie(buffer, buffer_offset, std::ignore) = tiled_buffer.Map(params.size, 4);
+    std::memcpy(buffer, src_data, params.size);
+    tiled_buffer.Unmap(params.size);
+
+    OpenGLState prev_state = OpenGLState::GetCurState();
+    SCOPE_EXIT({ prev_state.Apply(); });
+
+    const Common::Rectangle<u32> rect = surface.GetSubRect(params);
+    const Common::Rectangle<u32> scaled_rect = surface.GetScaledSubRect(params);
+
+    OpenGLState state;
+    state.draw.draw_framebuffer = draw_fb_handle;
+    state.draw.shader_program = program.handle;
+    state.draw.vertex_array = vao.handle;
+    state.viewport.x = static_cast<GLint>(scaled_rect.left);
+    state.viewport.y = static_cast<GLint>(scaled_rect.bottom);
+    state.viewport.width = static_cast<GLsizei>(scaled_rect.GetWidth());
+    state.viewport.height = static_cast<GLsizei>(scaled_rect.GetHeight());
+    state.Apply();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, tiled_tbo.handle);
+
+    const GLint tile_size = static_cast<GLint>(surface.GetFormatBpp()) * 8;
+    glUniform1i(format_u_id, static_cast<GLint>(surface.pixel_format));
+    glUniform1i(data_start_u_id, static_cast<GLint>((buffer_offset - start_offset) / 4));
+    glUniform1i(tile_size_u_id, tile_size);
+    glUniform1i(line_size_u_id, tile_size * static_cast<GLint>(surface.width / 8));
+    glUniform1i(height_u_id, static_cast<GLint>(surface.height));
+    glUniform2i(rect_origin_u_id, static_cast<GLint>(rect.left), static_cast<GLint>(rect.bottom));
+    glUniform4f(viewport_u_id, static_cast<GLfloat>(state.viewport.x),
+                static_cast<GLfloat>(state.viewport.y), static_cast<GLfloat>(state.viewport.width),
+                static_cast<GLfloat>(state.viewport.height));
+    glUniform1f(res_scale_u_id, static_cast<GLfloat>(surface.res_scale));
+
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                           surface.texture.handle, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    surface.InvalidateAllWatcher();
+    return true;
+}
+
+} // namespace OpenGL
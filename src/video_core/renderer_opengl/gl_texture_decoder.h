@@ -0,0 +1,52 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <glad/glad.h>
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
+
+namespace OpenGL {
+
+struct CachedSurface;
+struct SurfaceParams;
+
+/**
+ * Decodes the texture-only formats (IA8 to ETC1A4) on the GPU. The tiled data is copied to a
+ * buffer texture unchanged and a fragment shader does the de-tiling and format conversion while
+ * drawing into the surface texture, so the CPU never touches individual texels.
+ */
+class TextureDecoder {
+public:
+    TextureDecoder();
+
+    /**
+     * Loads the given region of the surface from emulated memory into its texture
+     * @returns false if the surface can't be decoded on the GPU, and LoadGLBuffer and
+     *          UploadGLTexture have to be used instead
+     */
+    bool Decode(CachedSurface& surface, const SurfaceParams& params, GLuint draw_fb_handle);
+
+private:
+    bool IsSupported(const CachedSurface& surface) const;
+
+    bool supported = false;
+
+    OGLStreamBuffer tiled_buffer;
+    OGLTexture tiled_tbo;
+    OGLProgram program;
+    OGLVertexArray vao;
+
+    GLint format_u_id = -1;
+    GLint data_start_u_id = -1;
+    GLint tile_size_u_id = -1;
+    GLint line_size_u_id = -1;
+    GLint height_u_id = -1;
+    GLint rect_origin_u_id = -1;
+    GLint viewport_u_id = -1;
+    GLint res_scale_u_id = -1;
+};
+
+} // namespace OpenGL
@@ -0,0 +1,136 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/scope_exit.h"
+#include "common/task_scheduler.h"
+#include "common/texture.h"
+#include "core/core.h"
+#include "core/frontend/image_interface.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_texture_dumper.h"
+
+namespace OpenGL {
+
+// Bounds the memory held by readbacks when a scene dumps a lot of textures at once
+constexpr std::size_t MAX_PENDING = 64;
+
+constexpr GLuint64 FENCE_TIMEOUT = 1000000000; // 1 second in nanoseconds
+
+TextureDumper::TextureDumper() {
+    read_framebuffer.Create();
+}
+
+TextureDumper::~TextureDumper() {
+    while (!pending.empty())
+        FinishOldest();
+}
+
+MICROPROFILE_DEFINE(OpenGL_TextureDump, "OpenGL", "Texture Dump", MP_RGB(128, 192, 64));
+void TextureDumper::Dump(GLuint texture, u32 width, u32 height, std::string path,
+                         std::function<void(bool)> callback) {
+    MICROPROFILE_SCOPE(OpenGL_TextureDump);
+    Poll();
+    if (pending.size() >= MAX_PENDING)
+        FinishOldest();
+
+    Readback& readback = pending.emplace_back();
+    readback.width = width;
+    readback.height = height;
+    readback.path = std::move(path);
+    readback.callback = std::move(callback);
+    readback.buffer.Create();
+
+    OpenGLState state = OpenGLState::GetCurState();
+    OpenGLState prev_state = state;
+    SCOPE_EXIT({ prev_state.Apply(); });
+    state.draw.read_framebuffer = read_framebuffer.handle;
+    state.Apply();
+
+    // Only the requested region is read, the texture may still be larger from a custom texture
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.handle);
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 4, nullptr,
+                 GL_STREAM_READ);
+    glReadPixels(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height), GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void TextureDumper::Poll() {
+    while (!pending.empty()) {
+        Readback& readback = pending.front();
+        const GLenum result = glClientWaitSync(readback.fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+            return;
+
+        glDeleteSync(readback.fence);
+        if (result == GL_WAIT_FAILED) {
+            Fail(readback);
+        } else {
+            Encode(readback);
+        }
+        pending.pop_front();
+    }
+}
+
+void TextureDumper::FinishOldest() {
+    Readback& readback = pending.front();
+    const GLenum result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                           FENCE_TIMEOUT);
+    glDeleteSync(readback.fence);
+    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+        Encode(readback);
+    } else {
+        Fail(readback);
+    }
+    pending.pop_front();
+}
+
+void TextureDumper::Encode(Readback& readback) {
+    const std::size_t size = static_cast<std::size_t>(readback.width) * readback.height * 4;
+    std::vector<u8> pixels(size);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer.handle);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size),
+                                          GL_MAP_READ_BIT);
+    if (mapped == nullptr) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        LOG_ERROR(Render_OpenGL, "Failed to map the readback of {}", readback.path);
+        if (readback.callback)
+            readback.callback(false);
+        return;
+    }
+    std::memcpy(pixels.data(), mapped, size);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    LOG_INFO(Render_OpenGL, "Saving image to {}", readback.path);
+    Common::TaskScheduler::GetInstance().Submit(
+        [image_interface = Core::System::GetInstance().GetImageInterface(),
+         pixels = std::move(pixels), width = readback.width, height = readback.height,
+         path = std::move(readback.path), callback = std::move(readback.callback)]() mutable {
+            Common::FlipRGBA8Texture(pixels, width, height);
+            const bool saved = image_interface->EncodePNG(path, pixels, width, height);
+            if (!saved)
+                LOG_ERROR(Render_OpenGL, "Failed to save image to {}", path);
+            if (callback)
+                callback(saved);
+        },
+        Common::TaskPriority::Low);
+}
+
+void TextureDumper::Fail(Readback& readback) {
+    LOG_ERROR(Render_OpenGL, "Failed to read back {}", readback.path);
+    if (readback.callback)
+        readback.callback(false);
+}
+
+} // namespace OpenGL
@@ -0,0 +1,61 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+/**
+ * Dumps textures without stalling the render thread. A texture is read back into a pixel pack
+ * buffer followed by a fence, and once the GPU has passed the fence the pixels are handed to the
+ * task scheduler, which flips, encodes and writes them to disk on a worker thread. The renderer
+ * saves its screenshots the same way.
+ */
+class TextureDumper : NonCopyable {
+public:
+    TextureDumper();
+    /// Waits for the readbacks still in flight, so that no dump is lost on shutdown
+    ~TextureDumper();
+
+    /**
+     * Starts reading back the top left width x height texels of the texture to write to path.
+     * The callback, if any, is called on a worker thread with whether the file was written.
+     */
+    void Dump(GLuint texture, u32 width, u32 height, std::string path,
+              std::function<void(bool)> callback = nullptr);
+
+    /// Submits the readbacks the GPU has finished for encoding, called regularly by the cache
+    void Poll();
+
+private:
+    struct Readback {
+        OGLBuffer buffer;
+        GLsync fence;
+        u32 width;
+        u32 height;
+        std::string path;
+        std::function<void(bool)> callback;
+    };
+
+    /// Copies the pixels out of the buffer of a finished readback and queues their encoding
+    void Encode(Readback& readback);
+
+    /// Waits for the oldest readback and encodes it
+    void FinishOldest();
+
+    /// Reports a readback the GPU didn't finish
+    void Fail(Readback& readback);
+
+    OGLFramebuffer read_framebuffer;
+    std::deque<Readback> pending;
+};
+
+} // namespace OpenGL
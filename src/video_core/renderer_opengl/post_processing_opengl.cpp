@@ -2,11 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cmath>
+#include <cstdlib>
 #include <sstream>
 #include <string>
 #include <vector>
 #include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/logging/log.h"
 #include "common/string_util.h"
 #include "video_core/renderer_opengl/post_processing_opengl.h"
 
@@ -150,7 +153,16 @@ std::vector<std::string> GetPostProcessingShaderList(bool anaglyph) {
     return shader_names;
 }
 
-std::string GetPostProcessingShaderCode(bool anaglyph, std::string shader) {
+// Starts a new pass in a post-processing shader, optionally followed by the scale of the pass
+constexpr char pass_directive[] = "//! pass";
+constexpr char scale_option[] = "scale=";
+
+// Limits of the pass scale, which keep the intermediate textures at a sane size
+constexpr float min_pass_scale = 1.0f / 16.0f;
+constexpr float max_pass_scale = 16.0f;
+
+// Returns the text of the shader file named "shader", or an empty string if it cannot be loaded
+static std::string LoadPostProcessingShaderText(bool anaglyph, const std::string& shader) {
     std::string shader_dir = FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir);
     std::string shader_path;
 
@@ -192,7 +204,55 @@ std::string GetPostProcessingShaderCode(bool anaglyph, std::string shader) {
     std::stringstream shader_text;
     shader_text << file.rdbuf();
 
-    return dolphin_shader_header + shader_text.str();
+    return shader_text.str();
+}
+
+std::string GetPostProcessingShaderCode(bool anaglyph, std::string shader) {
+    const std::string shader_text = LoadPostProcessingShaderText(anaglyph, shader);
+    if (shader_text.empty()) {
+        return "";
+    }
+    return dolphin_shader_header + shader_text;
+}
+
+std::vector<PostProcessingShaderPass> GetPostProcessingShaderPasses(bool anaglyph,
+                                                                    std::string shader) {
+    const std::string shader_text = LoadPostProcessingShaderText(anaglyph, shader);
+    if (shader_text.empty()) {
+        return {};
+    }
+
+    std::string common_code;
+    std::vector<PostProcessingShaderPass> passes;
+    std::istringstream stream(shader_text);
+    std::string line;
+    while (std::getline(stream, line)) {
+        if (line.compare(0, sizeof(pass_directive) - 1, pass_directive) != 0) {
+            (passes.empty() ? common_code : passes.back().code) += line + '\n';
+            continue;
+        }
+
+        PostProcessingShaderPass& pass = passes.emplace_back();
+        const std::size_t scale_pos = line.find(scale_option);
+        if (scale_pos != std::string::npos) {
+            const float scale =
+                std::strtof(line.c_str() + scale_pos + sizeof(scale_option) - 1, nullptr);
+            if (!std::isfinite(scale) || scale < min_pass_scale || scale > max_pass_scale) {
+                LOG_WARNING(Render_OpenGL, "Invalid scale in pass {} of shader {}", passes.size(),
+                            shader);
+            } else {
+                pass.scale = scale;
+            }
+        }
+    }
+
+    if (passes.empty()) {
+        return {{dolphin_shader_header + common_code, 1.0f}};
+    }
+    for (PostProcessingShaderPass& pass : passes) {
+        pass.code = dolphin_shader_header + common_code + pass.code;
+    }
+    return passes;
 }
 
 } // namespace OpenGL
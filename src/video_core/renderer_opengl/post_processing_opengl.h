@@ -9,6 +9,14 @@
 
 namespace OpenGL {
 
+/// One pass of a post-processing shader
+struct PostProcessingShaderPass {
+    /// Shader code with the appropriate header prepended to it
+    std::string code;
+    /// Size of the pass output relative to its input, ignored for the last pass
+    float scale = 1.0f;
+};
+
 // Returns a vector of the names of the shaders available in the
 // "shaders" directory in citra's data directory
 std::vector<std::string> GetPostProcessingShaderList(bool anaglyph);
@@ -20,4 +28,13 @@ std::vector<std::string> GetPostProcessingShaderList(bool anaglyph);
 // If the shader cannot be loaded, an empty string is returned
 std::string GetPostProcessingShaderCode(bool anaglyph, std::string shader_name);
 
+// Returns the passes of the shader named "shader_name", in the order they are run
+// Each line of the form "//! pass scale=<factor>" starts a new pass, whose output is <factor>
+// times the size of its input (the scale is optional and defaults to 1). The last pass draws to
+// the screen. Code before the first of these lines is shared by all passes, and a shader
+// without them is a single pass
+// If the shader cannot be loaded, an empty vector is returned
+std::vector<PostProcessingShaderPass> GetPostProcessingShaderPasses(bool anaglyph,
+                                                                    std::string shader_name);
+
 } // namespace OpenGL
@@ -7,13 +7,17 @@
 #include <condition_variable>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <glad/glad.h>
 #include <queue>
+#include <utility>
 #include "common/assert.h"
 #include "common/bit_field.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "core/core.h"
@@ -25,10 +29,12 @@
 #include "core/hw/hw.h"
 #include "core/hw/lcd.h"
 #include "core/memory.h"
+#include "core/perf_metrics.h"
 #include "core/settings.h"
 #include "core/tracer/recorder.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_opengl/gl_gpu_profiler.h"
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/post_processing_opengl.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
@@ -46,6 +52,8 @@ struct Frame {
     OpenGL::OGLFramebuffer present{}; /// FBO created on the present thread
     GLsync render_fence{};            /// Fence created on the render thread
     GLsync present_fence{};           /// Fence created on the presentation thread
+    bool exported = false;            /// Held by the frame exporter, which reads it
+    std::optional<std::chrono::steady_clock::time_point> input_time; /// Input change it reflects
 };
 } // namespace Frontend
 
@@ -56,6 +64,15 @@ namespace OpenGL {
 // number but 9 swap textures at 60FPS presentation allows for 800% speed so thats probably fine
 constexpr std::size_t SWAP_CHAIN_SIZE = 9;
 
+// Frames queued for presentation beyond this would only add latency
+constexpr std::size_t MAX_PRESENT_QUEUE_DEPTH = 3;
+
+// Frames the exporter can hold at once, the following ones aren't exported until it returns one
+constexpr std::size_t MAX_EXPORTED_FRAMES = 4;
+
+// The render thread must always find a frame that is neither queued, presented nor exported
+static_assert(SWAP_CHAIN_SIZE > MAX_PRESENT_QUEUE_DEPTH + 1 + MAX_EXPORTED_FRAMES);
+
 class OGLTextureMailbox : public Frontend::TextureMailbox {
 public:
     std::mutex swap_chain_lock;
@@ -65,6 +82,11 @@ public:
     std::queue<Frontend::Frame*> free_queue{};
     std::deque<Frontend::Frame*> present_queue{};
     Frontend::Frame* previous_frame = nullptr;
+    std::shared_ptr<Frontend::FrameExporter> frame_exporter;
+    std::size_t exported_count = 0;
+    /// Exporter and frame to hand to it once the render thread released the frame
+    std::shared_ptr<Frontend::FrameExporter> pending_exporter;
+    Frontend::ExportedFrame pending_export{};
 
     OGLTextureMailbox() {
         for (auto& frame : swap_chain) {
@@ -76,6 +98,7 @@ public:
         // lock the mutex and clear out the present and free_queues and notify any people who are
         // blocked to prevent deadlock on shutdown
         std::scoped_lock lock(swap_chain_lock);
+        frame_exporter.reset();
         std::queue<Frontend::Frame*>().swap(free_queue);
         present_queue.clear();
         present_cv.notify_all();
@@ -140,9 +163,61 @@ public:
     }
 
     void ReleaseRenderFrame(Frontend::Frame* frame) override {
+        {
+            std::unique_lock<std::mutex> lock(swap_chain_lock);
+            present_queue.push_front(frame);
+            // Drop the oldest frames that don't fit in the queue, a depth of 1 presents the newest
+            const std::size_t depth = std::clamp<std::size_t>(
+                Settings::values.present_queue_depth, 1, MAX_PRESENT_QUEUE_DEPTH);
+            while (present_queue.size() > depth) {
+                Recycle(present_queue.back());
+                present_queue.pop_back();
+            }
+            present_cv.notify_one();
+        }
+
+        // Handed over without the lock so that the exporter can return frames from within OnFrame.
+        // The frame is queued by now, so returning it right away doesn't free it twice.
+        if (pending_exporter) {
+            pending_exporter->OnFrame(pending_export);
+            pending_exporter.reset();
+        }
+    }
+
+    void ExportRenderFrame(Frontend::Frame* frame,
+                           const Frontend::FrameTimestamps& timestamps) override {
+        {
+            std::unique_lock<std::mutex> lock(swap_chain_lock);
+            if (!frame_exporter || exported_count == MAX_EXPORTED_FRAMES) {
+                return;
+            }
+            pending_exporter = frame_exporter;
+            frame->exported = true;
+            ++exported_count;
+        }
+
+        const GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        pending_export = {frame,         frame->color.handle, frame->width,
+                          frame->height, fence,               timestamps};
+    }
+
+    void SetFrameExporter(std::shared_ptr<Frontend::FrameExporter> exporter) override {
         std::unique_lock<std::mutex> lock(swap_chain_lock);
-        present_queue.push_front(frame);
-        present_cv.notify_one();
+        frame_exporter = std::move(exporter);
+    }
+
+    void ReturnExportedFrame(Frontend::Frame* frame) override {
+        std::unique_lock<std::mutex> lock(swap_chain_lock);
+        ASSERT(frame->exported);
+        frame->exported = false;
+        --exported_count;
+        // Frames still queued or presented are recycled by the presentation as usual
+        const bool in_use = frame == previous_frame ||
+                            std::find(present_queue.begin(), present_queue.end(), frame) !=
+                                present_queue.end();
+        if (!in_use) {
+            free_queue.push(frame);
+        }
     }
 
     Frontend::Frame* TryGetPresentFrame(int timeout_ms) override {
@@ -157,20 +232,23 @@ public:
 
         // free the previous frame and add it back to the free queue
         if (previous_frame) {
-            free_queue.push(previous_frame);
+            Recycle(previous_frame);
         }
 
-        // the newest entries are pushed to the front of the queue
-        Frontend::Frame* frame = present_queue.front();
-        present_queue.pop_front();
-        // remove all old entries from the present queue and move them back to the free_queue
-        for (auto f : present_queue) {
-            free_queue.push(f);
-        }
-        present_queue.clear();
+        // the newest entries are pushed to the front of the queue, present them in order
+        Frontend::Frame* frame = present_queue.back();
+        present_queue.pop_back();
         previous_frame = frame;
         return frame;
     }
+
+private:
+    /// Adds a frame that left the presentation back to the free queue, unless it is still exported
+    void Recycle(Frontend::Frame* frame) {
+        if (!frame->exported) {
+            free_queue.push(frame);
+        }
+    }
 };
 
 static const char vertex_shader[] = R"(
@@ -303,10 +381,16 @@ MICROPROFILE_DEFINE(OpenGL_WaitPresent, "OpenGL", "Wait For Present", MP_RGB(128
 
 /// Swap buffers (render frame)
 void RendererOpenGL::SwapBuffers() {
+    Core::Metrics::ScopedTimer metrics_timer{Core::Metrics::Time::GPU};
     // Maintain the rasterizer's state as a priority
     OpenGLState prev_state = OpenGLState::GetCurState();
     state.Apply();
 
+    // The settings are applied by whichever draw of the screens comes first
+    const bool settings_changed = VideoCore::g_renderer_bg_color_update_requested ||
+                                  VideoCore::g_renderer_sampler_update_requested ||
+                                  VideoCore::g_renderer_shader_update_requested;
+
     PrepareRendertarget();
 
     RenderScreenshot();
@@ -315,6 +399,31 @@ void RendererOpenGL::SwapBuffers() {
 
     const auto& layout = render_window.GetFramebufferLayout();
 
+    // When no screen changed since the last frame, the mailbox keeps presenting that frame
+    const u64 presentation_hash = settings_changed ? 0 : HashPresentation(layout);
+    if (presentation_hash == 0 || presentation_hash != last_presentation_hash) {
+        RenderFrame(layout);
+    }
+    last_presentation_hash = presentation_hash;
+    m_current_frame++;
+
+    // Drawn after the frame, so that they don't delay its presentation
+    CaptureScreenshots();
+
+    // Each measurement covers the rendering and the presentation of one frame
+    dynamic_resolution.EndFrame();
+    dynamic_resolution.BeginFrame();
+    GPUProfiler::GetInstance().EndFrame();
+
+    prev_state.Apply();
+    RefreshRasterizerSetting();
+
+    if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
+        Pica::g_debug_context->recorder->FrameFinished();
+    }
+}
+
+void RendererOpenGL::RenderFrame(const Layout::FramebufferLayout& layout) {
     Frontend::Frame* frame;
     {
         MICROPROFILE_SCOPE(OpenGL_WaitPresent);
@@ -351,30 +460,18 @@ void RendererOpenGL::SwapBuffers() {
             render_window.mailbox->ReloadRenderFrame(frame, layout.width, layout.height);
         }
 
-        GLuint render_texture = frame->color.handle;
         state.draw.draw_framebuffer = frame->render.handle;
         state.Apply();
         DrawScreens(layout);
+        frame->input_time = Core::Metrics::TakeInput();
         // Create a fence for the frontend to wait on and swap this frame to OffTex
         frame->render_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        render_window.mailbox->ExportRenderFrame(
+            frame, {static_cast<u64>(m_current_frame),
+                    Core::System::GetInstance().CoreTiming().GetGlobalTimeUs(),
+                    std::chrono::steady_clock::now()});
         glFlush();
         render_window.mailbox->ReleaseRenderFrame(frame);
-        m_current_frame++;
-    }
-
-    Core::System::GetInstance().perf_stats->EndSystemFrame();
-
-    render_window.PollEvents();
-
-    Core::System::GetInstance().frame_limiter.DoFrameLimiting(
-        Core::System::GetInstance().CoreTiming().GetGlobalTimeUs());
-    Core::System::GetInstance().perf_stats->BeginSystemFrame();
-
-    prev_state.Apply();
-    RefreshRasterizerSetting();
-
-    if (Pica::g_debug_context && Pica::g_debug_context->recorder) {
-        Pica::g_debug_context->recorder->FrameFinished();
     }
 }
 
@@ -412,6 +509,42 @@ void RendererOpenGL::RenderScreenshot() {
     }
 }
 
+void RendererOpenGL::CaptureScreenshots() {
+    screenshot_dumper->Poll();
+    std::vector<VideoCore::ScreenshotRequest> requests = VideoCore::TakeScreenshotRequests();
+    if (requests.empty())
+        return;
+
+    screenshot_framebuffer.Create();
+    const GLuint old_draw_fb = state.draw.draw_framebuffer;
+    const GLuint old_texture = state.texture_units[0].texture_2d;
+    for (VideoCore::ScreenshotRequest& request : requests) {
+        const Layout::FramebufferLayout& layout = request.layout;
+
+        OGLTexture texture;
+        texture.Create();
+        state.texture_units[0].texture_2d = texture.handle;
+        state.draw.draw_framebuffer = screenshot_framebuffer.handle;
+        state.Apply();
+        glActiveTexture(GL_TEXTURE0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, layout.width, layout.height, 0, GL_RGB,
+                     GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               texture.handle, 0);
+
+        DrawScreens(layout);
+
+        // The readback holds on to the texture until it is done, so it can be deleted right away
+        screenshot_dumper->Dump(texture.handle, layout.width, layout.height,
+                                std::move(request.path), std::move(request.callback));
+    }
+    screenshot_framebuffer.Release();
+    state.draw.draw_framebuffer = old_draw_fb;
+    state.texture_units[0].texture_2d = old_texture;
+    state.Apply();
+}
+
 void RendererOpenGL::PrepareRendertarget() {
     for (int i : {0, 1, 2}) {
         int fb_id = i == 2 ? 1 : 0;
@@ -424,9 +557,19 @@ void RendererOpenGL::PrepareRendertarget() {
         LCD::Regs::ColorFill color_fill = {0};
         LCD::Read(color_fill.raw, lcd_color_addr);
 
+        ScreenInfo& screen_info = screen_infos[i];
         if (color_fill.is_enabled) {
-            LoadColorToActiveGLTexture(color_fill.color_r, color_fill.color_g, color_fill.color_b,
-                                       screen_infos[i].texture);
+            const u64 fill_hash =
+                Common::ComputeFastHash64(&color_fill.raw, sizeof(color_fill.raw));
+            if (fill_hash != screen_info.texture_source_hash) {
+                LoadColorToActiveGLTexture(color_fill.color_r, color_fill.color_g,
+                                           color_fill.color_b, screen_info.texture);
+                screen_info.texture_source_hash = fill_hash;
+                screen_info.texture_version = ++texture_version_counter;
+            }
+            if (screen_info.display_texture == screen_info.texture.resource.handle) {
+                screen_info.display_version = screen_info.texture_version;
+            }
 
             // Resize the texture in case the framebuffer size has changed
             screen_infos[i].texture.width = 1;
@@ -439,6 +582,7 @@ void RendererOpenGL::PrepareRendertarget() {
                 // This is expected to not happen very often and hence should not be a
                 // performance problem.
                 ConfigureFramebufferTexture(screen_infos[i].texture, framebuffer);
+                screen_info.texture_source_hash = 0;
             }
             LoadFBToScreenInfo(framebuffer, screen_infos[i], i == 1);
 
@@ -464,18 +608,50 @@ void RendererOpenGL::RenderVideoDumping() {
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, frame_dumping_framebuffer.handle);
         DrawScreens(layout);
 
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, frame_dumping_pbos[current_pbo].handle);
+        FinishVideoDumpingReadbacks(pending_readbacks == FRAME_DUMPING_RING_SIZE);
+
+        FrameDumpingReadback& readback = frame_dumping_readbacks[next_readback];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo.handle);
         glReadPixels(0, 0, layout.width, layout.height, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, frame_dumping_pbos[next_pbo].handle);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        next_readback = (next_readback + 1) % FRAME_DUMPING_RING_SIZE;
+        ++pending_readbacks;
+    }
+}
 
-        GLubyte* pixels = static_cast<GLubyte*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
-        VideoDumper::VideoFrame frame_data{layout.width, layout.height, pixels};
-        Core::System::GetInstance().VideoDumper().AddVideoFrame(frame_data);
+void RendererOpenGL::FinishVideoDumpingReadbacks(bool wait) {
+    constexpr GLuint64 FENCE_TIMEOUT = 1000000000; // 1 second in nanoseconds
 
-        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    const auto& layout = Core::System::GetInstance().VideoDumper().GetLayout();
+    while (pending_readbacks > 0) {
+        const std::size_t oldest =
+            (next_readback + FRAME_DUMPING_RING_SIZE - pending_readbacks) % FRAME_DUMPING_RING_SIZE;
+        FrameDumpingReadback& readback = frame_dumping_readbacks[oldest];
+
+        GLenum result;
+        do {
+            result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      wait ? FENCE_TIMEOUT : 0);
+        } while (wait && result == GL_TIMEOUT_EXPIRED);
+        if (result == GL_TIMEOUT_EXPIRED)
+            break;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        --pending_readbacks;
+        // Only the oldest readback has to be waited for to make room for the next frame
+        wait = false;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo.handle);
+        const auto* pixels = static_cast<const u8*>(glMapBufferRange(
+            GL_PIXEL_PACK_BUFFER, 0, layout.width * layout.height * 4, GL_MAP_READ_BIT));
+        if (pixels != nullptr && result != GL_WAIT_FAILED) {
+            VideoDumper::VideoFrame frame_data{layout.width, layout.height, pixels};
+            Core::System::GetInstance().VideoDumper().AddVideoFrame(frame_data);
+        }
+        if (pixels != nullptr)
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
         glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-        current_pbo = (current_pbo + 1) % 2;
-        next_pbo = (current_pbo + 1) % 2;
     }
 }
 
@@ -513,10 +689,26 @@ void RendererOpenGL::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& fram
         screen_info.display_texture = screen_info.texture.resource.handle;
         screen_info.display_texcoords = Common::Rectangle<float>(0.f, 0.f, 1.f, 1.f);
 
-        Memory::RasterizerFlushRegion(framebuffer_addr, framebuffer.stride * framebuffer.height);
+        const u32 size = framebuffer.stride * framebuffer.height;
+        Memory::RasterizerFlushRegion(framebuffer_addr, size);
 
         const u8* framebuffer_data = VideoCore::g_memory->GetPhysicalPointer(framebuffer_addr);
 
+        // Guest memory has no write tracking, but hashing it is cheaper than uploading it again.
+        // The bottom screen in particular is often left unchanged for many frames.
+        const u64 source_hash =
+            framebuffer_data != nullptr
+                ? Common::ComputeFastHash64(framebuffer_data, size) ^
+                      (static_cast<u64>(framebuffer.stride) << 32 | framebuffer.width)
+                : 0;
+        if (source_hash != 0 && source_hash == screen_info.texture_source_hash) {
+            screen_info.display_version = screen_info.texture_version;
+            return;
+        }
+        screen_info.texture_source_hash = source_hash;
+        screen_info.texture_version = ++texture_version_counter;
+        screen_info.display_version = screen_info.texture_version;
+
         state.texture_units[0].texture_2d = screen_info.texture.resource.handle;
         state.Apply();
 
@@ -565,14 +757,16 @@ void RendererOpenGL::InitOpenGLObjects() {
     glClearColor(Settings::values.bg_red, Settings::values.bg_green, Settings::values.bg_blue,
                  0.0f);
 
+    screenshot_dumper = std::make_unique<TextureDumper>();
+
     filter_sampler.Create();
     ReloadSampler();
 
-    ReloadShader();
-
-    // Generate VBO handle for drawing
+    // Generate VBO handle for drawing, the intermediate post-processing passes need it
     vertex_buffer.Create();
 
+    ReloadShader();
+
     // Generate VAO
     vertex_array.Create();
 
@@ -621,6 +815,11 @@ void RendererOpenGL::ReloadSampler() {
                         Settings::values.filter_mode ? GL_LINEAR : GL_NEAREST);
     glSamplerParameteri(filter_sampler.handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glSamplerParameteri(filter_sampler.handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // The intermediate post-processing passes sample through it
+    for (PostProcessingScreen& screen : post_processing_screens) {
+        screen.valid = false;
+    }
 }
 
 void RendererOpenGL::ReloadShader() {
@@ -629,46 +828,38 @@ void RendererOpenGL::ReloadShader() {
     if (GLES) {
         shader_data += fragment_shader_precision_OES;
     }
+    std::vector<PostProcessingShaderPass> passes;
     if (Settings::values.render_3d == Settings::StereoRenderOption::Anaglyph) {
-        if (Settings::values.pp_shader_name == "dubois (builtin)") {
+        if (Settings::values.pp_shader_name != "dubois (builtin)") {
+            passes = OpenGL::GetPostProcessingShaderPasses(true, Settings::values.pp_shader_name);
+        }
+        if (passes.empty()) {
+            // Should probably provide some information that the shader couldn't load
             shader_data += fragment_shader_anaglyph;
-        } else {
-            std::string shader_text =
-                OpenGL::GetPostProcessingShaderCode(true, Settings::values.pp_shader_name);
-            if (shader_text.empty()) {
-                // Should probably provide some information that the shader couldn't load
-                shader_data += fragment_shader_anaglyph;
-            } else {
-                shader_data += shader_text;
-            }
         }
     } else if (Settings::values.render_3d == Settings::StereoRenderOption::Interlaced) {
-        if (Settings::values.pp_shader_name == "horizontal (builtin)") {
+        if (Settings::values.pp_shader_name != "horizontal (builtin)") {
+            passes = OpenGL::GetPostProcessingShaderPasses(true, Settings::values.pp_shader_name);
+        }
+        if (passes.empty()) {
+            // Should probably provide some information that the shader couldn't load
             shader_data += fragment_shader_interlaced;
-        } else {
-            std::string shader_text =
-                OpenGL::GetPostProcessingShaderCode(true, Settings::values.pp_shader_name);
-            if (shader_text.empty()) {
-                // Should probably provide some information that the shader couldn't load
-                shader_data += fragment_shader_interlaced;
-            } else {
-                shader_data += shader_text;
-            }
         }
     } else {
-        if (Settings::values.pp_shader_name == "none (builtin)") {
+        if (Settings::values.pp_shader_name != "none (builtin)") {
+            passes = OpenGL::GetPostProcessingShaderPasses(false, Settings::values.pp_shader_name);
+        }
+        if (passes.empty()) {
+            // Should probably provide some information that the shader couldn't load
             shader_data += fragment_shader;
-        } else {
-            std::string shader_text =
-                OpenGL::GetPostProcessingShaderCode(false, Settings::values.pp_shader_name);
-            if (shader_text.empty()) {
-                // Should probably provide some information that the shader couldn't load
-                shader_data += fragment_shader;
-            } else {
-                shader_data += shader_text;
-            }
         }
     }
+    if (!passes.empty()) {
+        shader_data += passes.back().code;
+        passes.pop_back();
+    }
+    LoadIntermediatePasses(passes);
+
     shader.Create(vertex_shader, shader_data.c_str());
     state.draw.shader_program = shader.handle;
     state.Apply();
@@ -685,6 +876,48 @@ void RendererOpenGL::ReloadShader() {
     attrib_tex_coord = glGetAttribLocation(shader.handle, "vert_tex_coord");
 }
 
+void RendererOpenGL::LoadIntermediatePasses(const std::vector<PostProcessingShaderPass>& passes) {
+    intermediate_passes.clear();
+    for (PostProcessingScreen& screen : post_processing_screens) {
+        screen = {};
+    }
+
+    const GLuint old_vertex_array = state.draw.vertex_array;
+    for (const PostProcessingShaderPass& pass : passes) {
+        std::string shader_data;
+        if (GLES) {
+            shader_data += fragment_shader_precision_OES;
+        }
+        shader_data += pass.code;
+
+        IntermediatePass& intermediate = intermediate_passes.emplace_back();
+        intermediate.program.Create(vertex_shader, shader_data.c_str());
+        intermediate.scale = pass.scale;
+        const GLuint handle = intermediate.program.handle;
+        intermediate.uniform_modelview_matrix = glGetUniformLocation(handle, "modelview_matrix");
+        intermediate.uniform_color_texture = glGetUniformLocation(handle, "color_texture");
+        intermediate.uniform_i_resolution = glGetUniformLocation(handle, "i_resolution");
+        intermediate.uniform_o_resolution = glGetUniformLocation(handle, "o_resolution");
+        intermediate.uniform_layer = glGetUniformLocation(handle, "layer");
+
+        // The attribute locations of each program can differ, so every pass has its own VAO
+        const GLint position = glGetAttribLocation(handle, "vert_position");
+        const GLint tex_coord = glGetAttribLocation(handle, "vert_tex_coord");
+        intermediate.vertex_array.Create();
+        state.draw.vertex_array = intermediate.vertex_array.handle;
+        state.draw.vertex_buffer = vertex_buffer.handle;
+        state.Apply();
+        glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, sizeof(ScreenRectVertex),
+                              (GLvoid*)offsetof(ScreenRectVertex, position));
+        glVertexAttribPointer(tex_coord, 2, GL_FLOAT, GL_FALSE, sizeof(ScreenRectVertex),
+                              (GLvoid*)offsetof(ScreenRectVertex, tex_coord));
+        glEnableVertexAttribArray(position);
+        glEnableVertexAttribArray(tex_coord);
+    }
+    state.draw.vertex_array = old_vertex_array;
+    state.Apply();
+}
+
 void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
                                                  const GPU::Regs::FramebufferConfig& framebuffer) {
     GPU::Regs::PixelFormat format = framebuffer.color_format;
@@ -752,7 +985,8 @@ void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
  */
 void RendererOpenGL::DrawSingleScreenRotated(const ScreenInfo& screen_info, float x, float y,
                                              float w, float h) {
-    const auto& texcoords = screen_info.display_texcoords;
+    const ScreenInput input = GetScreenInput(screen_info);
+    const auto& texcoords = input.texcoords;
 
     const std::array<ScreenRectVertex, 4> vertices = {{
         ScreenRectVertex(x, y, texcoords.bottom, texcoords.left),
@@ -764,13 +998,10 @@ void RendererOpenGL::DrawSingleScreenRotated(const ScreenInfo& screen_info, floa
     // As this is the "DrawSingleScreenRotated" function, the output resolution dimensions have been
     // swapped. If a non-rotated draw-screen function were to be added for book-mode games, those
     // should probably be set to the standard (w, h, 1.0 / w, 1.0 / h) ordering.
-    u16 scale_factor = VideoCore::GetResolutionScaleFactor();
-    glUniform4f(uniform_i_resolution, screen_info.texture.width * scale_factor,
-                screen_info.texture.height * scale_factor,
-                1.0 / (screen_info.texture.width * scale_factor),
-                1.0 / (screen_info.texture.height * scale_factor));
+    glUniform4f(uniform_i_resolution, input.width, input.height, 1.0 / input.width,
+                1.0 / input.height);
     glUniform4f(uniform_o_resolution, h, w, 1.0f / h, 1.0f / w);
-    state.texture_units[0].texture_2d = screen_info.display_texture;
+    state.texture_units[0].texture_2d = input.texture;
     state.texture_units[0].sampler = filter_sampler.handle;
     state.Apply();
 
@@ -784,7 +1015,8 @@ void RendererOpenGL::DrawSingleScreenRotated(const ScreenInfo& screen_info, floa
 
 void RendererOpenGL::DrawSingleScreen(const ScreenInfo& screen_info, float x, float y, float w,
                                       float h) {
-    const auto& texcoords = screen_info.display_texcoords;
+    const ScreenInput input = GetScreenInput(screen_info);
+    const auto& texcoords = input.texcoords;
 
     const std::array<ScreenRectVertex, 4> vertices = {{
         ScreenRectVertex(x, y, texcoords.bottom, texcoords.right),
@@ -793,13 +1025,10 @@ void RendererOpenGL::DrawSingleScreen(const ScreenInfo& screen_info, float x, fl
         ScreenRectVertex(x + w, y + h, texcoords.top, texcoords.left),
     }};
 
-    u16 scale_factor = VideoCore::GetResolutionScaleFactor();
-    glUniform4f(uniform_i_resolution, screen_info.texture.width * scale_factor,
-                screen_info.texture.height * scale_factor,
-                1.0 / (screen_info.texture.width * scale_factor),
-                1.0 / (screen_info.texture.height * scale_factor));
+    glUniform4f(uniform_i_resolution, input.width, input.height, 1.0 / input.width,
+                1.0 / input.height);
     glUniform4f(uniform_o_resolution, w, h, 1.0f / w, 1.0f / h);
-    state.texture_units[0].texture_2d = screen_info.display_texture;
+    state.texture_units[0].texture_2d = input.texture;
     state.texture_units[0].sampler = filter_sampler.handle;
     state.Apply();
 
@@ -818,7 +1047,9 @@ void RendererOpenGL::DrawSingleScreen(const ScreenInfo& screen_info, float x, fl
 void RendererOpenGL::DrawSingleScreenStereoRotated(const ScreenInfo& screen_info_l,
                                                    const ScreenInfo& screen_info_r, float x,
                                                    float y, float w, float h) {
-    const auto& texcoords = screen_info_l.display_texcoords;
+    const ScreenInput input = GetScreenInput(screen_info_l);
+    const ScreenInput input_r = GetScreenInput(screen_info_r);
+    const auto& texcoords = input.texcoords;
 
     const std::array<ScreenRectVertex, 4> vertices = {{
         ScreenRectVertex(x, y, texcoords.bottom, texcoords.left),
@@ -827,14 +1058,11 @@ void RendererOpenGL::DrawSingleScreenStereoRotated(const ScreenInfo& screen_info
         ScreenRectVertex(x + w, y + h, texcoords.top, texcoords.right),
     }};
 
-    u16 scale_factor = VideoCore::GetResolutionScaleFactor();
-    glUniform4f(uniform_i_resolution, screen_info_l.texture.width * scale_factor,
-                screen_info_l.texture.height * scale_factor,
-                1.0 / (screen_info_l.texture.width * scale_factor),
-                1.0 / (screen_info_l.texture.height * scale_factor));
+    glUniform4f(uniform_i_resolution, input.width, input.height, 1.0 / input.width,
+                1.0 / input.height);
     glUniform4f(uniform_o_resolution, h, w, 1.0f / h, 1.0f / w);
-    state.texture_units[0].texture_2d = screen_info_l.display_texture;
-    state.texture_units[1].texture_2d = screen_info_r.display_texture;
+    state.texture_units[0].texture_2d = input.texture;
+    state.texture_units[1].texture_2d = input_r.texture;
     state.texture_units[0].sampler = filter_sampler.handle;
     state.texture_units[1].sampler = filter_sampler.handle;
     state.Apply();
@@ -852,7 +1080,9 @@ void RendererOpenGL::DrawSingleScreenStereoRotated(const ScreenInfo& screen_info
 void RendererOpenGL::DrawSingleScreenStereo(const ScreenInfo& screen_info_l,
                                             const ScreenInfo& screen_info_r, float x, float y,
                                             float w, float h) {
-    const auto& texcoords = screen_info_l.display_texcoords;
+    const ScreenInput input = GetScreenInput(screen_info_l);
+    const ScreenInput input_r = GetScreenInput(screen_info_r);
+    const auto& texcoords = input.texcoords;
 
     const std::array<ScreenRectVertex, 4> vertices = {{
         ScreenRectVertex(x, y, texcoords.bottom, texcoords.right),
@@ -861,14 +1091,11 @@ void RendererOpenGL::DrawSingleScreenStereo(const ScreenInfo& screen_info_l,
         ScreenRectVertex(x + w, y + h, texcoords.top, texcoords.left),
     }};
 
-    u16 scale_factor = VideoCore::GetResolutionScaleFactor();
-    glUniform4f(uniform_i_resolution, screen_info_l.texture.width * scale_factor,
-                screen_info_l.texture.height * scale_factor,
-                1.0 / (screen_info_l.texture.width * scale_factor),
-                1.0 / (screen_info_l.texture.height * scale_factor));
+    glUniform4f(uniform_i_resolution, input.width, input.height, 1.0 / input.width,
+                1.0 / input.height);
     glUniform4f(uniform_o_resolution, w, h, 1.0f / w, 1.0f / h);
-    state.texture_units[0].texture_2d = screen_info_l.display_texture;
-    state.texture_units[1].texture_2d = screen_info_r.display_texture;
+    state.texture_units[0].texture_2d = input.texture;
+    state.texture_units[1].texture_2d = input_r.texture;
     state.texture_units[0].sampler = filter_sampler.handle;
     state.texture_units[1].sampler = filter_sampler.handle;
     state.Apply();
@@ -883,10 +1110,172 @@ void RendererOpenGL::DrawSingleScreenStereo(const ScreenInfo& screen_info_l,
     state.Apply();
 }
 
+RendererOpenGL::ScreenInput RendererOpenGL::GetScreenInput(const ScreenInfo& screen_info) const {
+    const PostProcessingScreen& screen =
+        post_processing_screens[static_cast<std::size_t>(&screen_info - screen_infos.data())];
+    if (intermediate_passes.empty() || !screen.valid) {
+        const u16 scale_factor = VideoCore::GetResolutionScaleFactor();
+        return {screen_info.display_texture, screen_info.display_texcoords,
+                static_cast<float>(screen_info.texture.width * scale_factor),
+                static_cast<float>(screen_info.texture.height * scale_factor)};
+    }
+
+    const PostProcessingScreen::Target& target = screen.targets.back();
+    return {target.texture.handle, Common::Rectangle<float>(0.f, 0.f, 1.f, 1.f),
+            static_cast<float>(target.width), static_cast<float>(target.height)};
+}
+
+MICROPROFILE_DEFINE(OpenGL_PostProcessing, "OpenGL", "Post Processing", MP_RGB(128, 128, 64));
+void RendererOpenGL::RunPostProcessingPasses(std::size_t screen_index) {
+    const ScreenInfo& screen_info = screen_infos[screen_index];
+    PostProcessingScreen& screen = post_processing_screens[screen_index];
+    const auto& texcoords = screen_info.display_texcoords;
+    const u16 scale_factor = VideoCore::GetResolutionScaleFactor();
+    const u32 input_width = screen_info.texture.width * scale_factor;
+    const u32 input_height = screen_info.texture.height * scale_factor;
+
+    // Each pass only depends on the output of the previous one, so the targets still hold the
+    // results for the last source if nothing wrote to it since. Static menus and games that
+    // present every frame twice don't run the passes again.
+    if (screen.valid && screen_info.display_version != 0 &&
+        screen.source_version == screen_info.display_version &&
+        screen.source_texture == screen_info.display_texture &&
+        screen.source_texcoords.left == texcoords.left &&
+        screen.source_texcoords.top == texcoords.top &&
+        screen.source_texcoords.right == texcoords.right &&
+        screen.source_texcoords.bottom == texcoords.bottom &&
+        screen.source_width == input_width && screen.source_height == input_height) {
+        return;
+    }
+    MICROPROFILE_SCOPE(OpenGL_PostProcessing);
+
+    screen.targets.resize(intermediate_passes.size());
+    const GLuint old_draw_framebuffer = state.draw.draw_framebuffer;
+    const GLuint old_vertex_array = state.draw.vertex_array;
+    const GLuint old_shader_program = state.draw.shader_program;
+
+    GLuint source = screen_info.display_texture;
+    Common::Rectangle<float> source_texcoords = texcoords;
+    u32 width = input_width;
+    u32 height = input_height;
+    for (std::size_t i = 0; i < intermediate_passes.size(); ++i) {
+        const IntermediatePass& pass = intermediate_passes[i];
+        PostProcessingScreen::Target& target = screen.targets[i];
+        const auto target_width = std::max(static_cast<u32>(width * pass.scale), 1u);
+        const auto target_height = std::max(static_cast<u32>(height * pass.scale), 1u);
+        if (target.texture.handle == 0 || target.width != target_width ||
+            target.height != target_height) {
+            target.width = target_width;
+            target.height = target_height;
+            target.texture.Release();
+            target.texture.Create();
+            state.texture_units[0].texture_2d = target.texture.handle;
+            state.Apply();
+            glActiveTexture(GL_TEXTURE0);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, target_width, target_height, 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+
+            if (target.framebuffer.handle == 0) {
+                target.framebuffer.Create();
+            }
+            state.draw.draw_framebuffer = target.framebuffer.handle;
+            state.Apply();
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                                   target.texture.handle, 0);
+        }
+
+        // The texture coordinates are stored with their axes swapped, see AccelerateDisplay
+        const std::array<ScreenRectVertex, 4> vertices = {{
+            ScreenRectVertex(0.f, 0.f, source_texcoords.top, source_texcoords.right),
+            ScreenRectVertex(target_width, 0.f, source_texcoords.bottom, source_texcoords.right),
+            ScreenRectVertex(0.f, target_height, source_texcoords.top, source_texcoords.left),
+            ScreenRectVertex(target_width, target_height, source_texcoords.bottom,
+                             source_texcoords.left),
+        }};
+
+        state.draw.draw_framebuffer = target.framebuffer.handle;
+        state.draw.vertex_array = pass.vertex_array.handle;
+        state.draw.shader_program = pass.program.handle;
+        state.texture_units[0].texture_2d = source;
+        state.texture_units[0].sampler = filter_sampler.handle;
+        state.Apply();
+
+        glViewport(0, 0, target_width, target_height);
+        const std::array<GLfloat, 3 * 2> ortho_matrix = MakeOrthographicMatrix(
+            static_cast<float>(target_width), static_cast<float>(target_height));
+        glUniformMatrix3x2fv(pass.uniform_modelview_matrix, 1, GL_FALSE, ortho_matrix.data());
+        glUniform1i(pass.uniform_color_texture, 0);
+        glUniform1i(pass.uniform_layer, 0);
+        glUniform4f(pass.uniform_i_resolution, width, height, 1.0f / width, 1.0f / height);
+        glUniform4f(pass.uniform_o_resolution, target_width, target_height, 1.0f / target_width,
+                    1.0f / target_height);
+
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices.data());
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        source = target.texture.handle;
+        source_texcoords = Common::Rectangle<float>(0.f, 0.f, 1.f, 1.f);
+        width = target_width;
+        height = target_height;
+    }
+
+    state.draw.draw_framebuffer = old_draw_framebuffer;
+    state.draw.vertex_array = old_vertex_array;
+    state.draw.shader_program = old_shader_program;
+    state.texture_units[0].texture_2d = 0;
+    state.texture_units[0].sampler = 0;
+    state.Apply();
+
+    screen.source_texture = screen_info.display_texture;
+    screen.source_texcoords = texcoords;
+    screen.source_version = screen_info.display_version;
+    screen.source_width = input_width;
+    screen.source_height = input_height;
+    screen.valid = true;
+}
+
+u64 RendererOpenGL::HashPresentation(const Layout::FramebufferLayout& layout) const {
+    std::array<u64, 3 * 4 + 12> values{};
+    std::size_t count = 0;
+    const auto add_screen = [&](const ScreenInfo& screen_info) {
+        static_assert(sizeof(screen_info.display_texcoords) == 2 * sizeof(u64));
+        values[count++] = screen_info.display_texture;
+        values[count++] = screen_info.display_version;
+        std::memcpy(&values[count], &screen_info.display_texcoords, 2 * sizeof(u64));
+        count += 2;
+        return screen_info.display_version != 0;
+    };
+
+    const bool stereo = Settings::values.render_3d != Settings::StereoRenderOption::Off;
+    if (layout.top_screen_enabled &&
+        (!add_screen(screen_infos[0]) || (stereo && !add_screen(screen_infos[1])))) {
+        return 0;
+    }
+    if (layout.bottom_screen_enabled && !add_screen(screen_infos[2])) {
+        return 0;
+    }
+
+    const auto add_rect = [&](const Common::Rectangle<u32>& rect) {
+        values[count++] = (static_cast<u64>(rect.left) << 32) | rect.top;
+        values[count++] = (static_cast<u64>(rect.right) << 32) | rect.bottom;
+    };
+    values[count++] = (static_cast<u64>(layout.width) << 32) | layout.height;
+    values[count++] = (layout.top_screen_enabled ? 1 : 0) | (layout.bottom_screen_enabled ? 2 : 0) |
+                      (layout.is_rotated ? 4 : 0);
+    add_rect(layout.top_screen);
+    add_rect(layout.bottom_screen);
+    values[count++] = static_cast<u64>(Settings::values.render_3d);
+
+    const u64 hash = Common::ComputeFastHash64(values.data(), count * sizeof(u64));
+    return hash != 0 ? hash : 1;
+}
+
 /**
  * Draws the emulated screens to the emulator window.
  */
 void RendererOpenGL::DrawScreens(const Layout::FramebufferLayout& layout) {
+    GPUProfiler::Scope gpu_scope{GPUProfiler::Pass::Present};
     if (VideoCore::g_renderer_bg_color_update_requested.exchange(false)) {
         // Update background color before drawing
         glClearColor(Settings::values.bg_red, Settings::values.bg_green, Settings::values.bg_blue,
@@ -905,6 +1294,19 @@ void RendererOpenGL::DrawScreens(const Layout::FramebufferLayout& layout) {
         ReloadShader();
     }
 
+    // The intermediate passes draw into their own targets before the window is drawn
+    if (!intermediate_passes.empty()) {
+        if (layout.top_screen_enabled) {
+            RunPostProcessingPasses(0);
+            if (Settings::values.render_3d != Settings::StereoRenderOption::Off) {
+                RunPostProcessingPasses(1);
+            }
+        }
+        if (layout.bottom_screen_enabled) {
+            RunPostProcessingPasses(2);
+        }
+    }
+
     const auto& top_screen = layout.top_screen;
     const auto& bottom_screen = layout.bottom_screen;
 
@@ -1014,6 +1416,14 @@ void RendererOpenGL::DrawScreens(const Layout::FramebufferLayout& layout) {
 }
 
 void RendererOpenGL::TryPresent(int timeout_ms) {
+    // The previous present has been swapped by now, which puts this on the refresh of the display
+    Core::System::GetInstance().frame_limiter.OnFramePresented();
+    if (presented_input_time) {
+        Core::Metrics::AddLatency(Core::Metrics::Latency::InputToPresent,
+                                  std::chrono::steady_clock::now() - *presented_input_time);
+        presented_input_time.reset();
+    }
+
     const auto& layout = render_window.GetFramebufferLayout();
     auto frame = render_window.mailbox->TryGetPresentFrame(timeout_ms);
     if (!frame) {
@@ -1045,6 +1455,9 @@ void RendererOpenGL::TryPresent(int timeout_ms) {
     frame->present_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
     glFlush();
 
+    // Only the first present of a frame shows its input change
+    presented_input_time = std::exchange(frame->input_time, std::nullopt);
+
     glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 }
 
@@ -1071,9 +1484,9 @@ void RendererOpenGL::InitVideoDumpingGLObjects() {
                               frame_dumping_renderbuffer);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-    for (auto& buffer : frame_dumping_pbos) {
-        buffer.Create();
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.handle);
+    for (auto& readback : frame_dumping_readbacks) {
+        readback.pbo.Create();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo.handle);
         glBufferData(GL_PIXEL_PACK_BUFFER, layout.width * layout.height * 4, nullptr,
                      GL_STREAM_READ);
         glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
@@ -1084,9 +1497,16 @@ void RendererOpenGL::ReleaseVideoDumpingGLObjects() {
     frame_dumping_framebuffer.Release();
     glDeleteRenderbuffers(1, &frame_dumping_renderbuffer);
 
-    for (auto& buffer : frame_dumping_pbos) {
-        buffer.Release();
+    // The frames still being read back are dropped, the dumper has already been stopped
+    for (auto& readback : frame_dumping_readbacks) {
+        if (readback.fence != nullptr) {
+            glDeleteSync(readback.fence);
+            readback.fence = nullptr;
+        }
+        readback.pbo.Release();
     }
+    next_readback = 0;
+    pending_readbacks = 0;
 }
 
 static const char* GetSource(GLenum source) {
@@ -1186,7 +1606,10 @@ VideoCore::ResultStatus RendererOpenGL::Init() {
 
 /// Shutdown the renderer
 void RendererOpenGL::ShutDown() {
+    // Saves the screenshots still being read back
+    screenshot_dumper.reset();
     TextureFilterManager::GetInstance().Destroy();
+    GPUProfiler::GetInstance().Destroy();
 }
 
 } // namespace OpenGL
@@ -5,13 +5,20 @@
 #pragma once
 
 #include <array>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <vector>
 #include <glad/glad.h>
 #include "common/common_types.h"
 #include "common/math_util.h"
 #include "core/hw/gpu.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_opengl/gl_dynamic_resolution.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
 #include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_texture_dumper.h"
+#include "video_core/renderer_opengl/post_processing_opengl.h"
 
 namespace Layout {
 struct FramebufferLayout;
@@ -33,7 +40,13 @@ struct TextureInfo {
 struct ScreenInfo {
     GLuint display_texture;
     Common::Rectangle<float> display_texcoords;
+    /// Changes whenever the contents of the display texture change, 0 if they aren't tracked
+    u64 display_version = 0;
     TextureInfo texture;
+    /// Hash of what the permanent texture was last loaded from, 0 if its contents are unknown
+    u64 texture_source_hash = 0;
+    /// Version of the contents of the permanent texture
+    u64 texture_version = 0;
 };
 
 struct PresentationTexture {
@@ -70,12 +83,19 @@ private:
     void InitOpenGLObjects();
     void ReloadSampler();
     void ReloadShader();
+    void LoadIntermediatePasses(const std::vector<PostProcessingShaderPass>& passes);
     void PrepareRendertarget();
     void RenderScreenshot();
+    /// Draws the screenshots that are due and starts reading them back
+    void CaptureScreenshots();
     void RenderVideoDumping();
+    /// Draws the screens to a frame of the mailbox and hands it to the presentation thread
+    void RenderFrame(const Layout::FramebufferLayout& layout);
     void ConfigureFramebufferTexture(TextureInfo& texture,
                                      const GPU::Regs::FramebufferConfig& framebuffer);
     void DrawScreens(const Layout::FramebufferLayout& layout);
+    /// Runs the intermediate post-processing passes on the screen unless its source is unchanged
+    void RunPostProcessingPasses(std::size_t screen_index);
     void DrawSingleScreenRotated(const ScreenInfo& screen_info, float x, float y, float w, float h);
     void DrawSingleScreen(const ScreenInfo& screen_info, float x, float y, float w, float h);
     void DrawSingleScreenStereoRotated(const ScreenInfo& screen_info_l,
@@ -84,6 +104,18 @@ private:
     void DrawSingleScreenStereo(const ScreenInfo& screen_info_l, const ScreenInfo& screen_info_r,
                                 float x, float y, float w, float h);
     void UpdateFramerate();
+    /// Hashes everything the drawn frame depends on, returns 0 if a screen isn't tracked
+    u64 HashPresentation(const Layout::FramebufferLayout& layout) const;
+
+    /// Texture sampled by the final post-processing pass for a screen
+    struct ScreenInput {
+        GLuint texture;
+        Common::Rectangle<float> texcoords;
+        float width;
+        float height;
+    };
+    /// Returns the output of the intermediate passes for the screen, or the screen itself
+    ScreenInput GetScreenInput(const ScreenInfo& screen_info) const;
 
     // Loads framebuffer from emulated memory into the display information structure
     void LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& framebuffer,
@@ -93,8 +125,11 @@ private:
 
     void InitVideoDumpingGLObjects();
     void ReleaseVideoDumpingGLObjects();
+    /// Hands the read back frames to the video dumper, waiting for the oldest if `wait` is set
+    void FinishVideoDumpingReadbacks(bool wait);
 
     OpenGLState state;
+    DynamicResolution dynamic_resolution;
 
     // OpenGL object IDs
     OGLVertexArray vertex_array;
@@ -103,8 +138,17 @@ private:
     OGLFramebuffer screenshot_framebuffer;
     OGLSampler filter_sampler;
 
+    /// Reads back and saves the screenshots of VideoCore::RequestAsyncScreenshot
+    std::unique_ptr<TextureDumper> screenshot_dumper;
+
     /// Display information for top and bottom screens respectively
     std::array<ScreenInfo, 3> screen_infos;
+    /// Source of the versions of the permanent screen textures
+    u64 texture_version_counter = 0;
+    /// Hash of the presentation of the last frame released to the mailbox, 0 if it is unknown
+    u64 last_presentation_hash = 0;
+    /// Input change reflected by the frame presented last, timed once its present was swapped
+    std::optional<std::chrono::steady_clock::time_point> presented_input_time;
 
     // Shader uniform location indices
     GLuint uniform_modelview_matrix;
@@ -120,6 +164,37 @@ private:
     GLuint attrib_position;
     GLuint attrib_tex_coord;
 
+    /// A post-processing pass that runs before the final one in `shader`
+    struct IntermediatePass {
+        OGLProgram program;
+        OGLVertexArray vertex_array;
+        float scale;
+        GLint uniform_modelview_matrix;
+        GLint uniform_color_texture;
+        GLint uniform_i_resolution;
+        GLint uniform_o_resolution;
+        GLint uniform_layer;
+    };
+    std::vector<IntermediatePass> intermediate_passes;
+
+    /// Outputs of the intermediate passes for a screen, reused while its source is unchanged
+    struct PostProcessingScreen {
+        struct Target {
+            OGLTexture texture;
+            OGLFramebuffer framebuffer;
+            u32 width = 0;
+            u32 height = 0;
+        };
+        std::vector<Target> targets;
+        GLuint source_texture = 0;
+        Common::Rectangle<float> source_texcoords;
+        u64 source_version = 0;
+        u32 source_width = 0;
+        u32 source_height = 0;
+        bool valid = false;
+    };
+    std::array<PostProcessingScreen, 3> post_processing_screens;
+
     // Frame dumping
     OGLFramebuffer frame_dumping_framebuffer;
     GLuint frame_dumping_renderbuffer;
@@ -129,10 +204,18 @@ private:
     std::atomic_bool prepare_video_dumping = false;
     std::atomic_bool cleanup_video_dumping = false;
 
-    // PBOs used to dump frames faster
-    std::array<OGLBuffer, 2> frame_dumping_pbos;
-    GLuint current_pbo = 1;
-    GLuint next_pbo = 0;
+    // Frames are read back into a ring of PBOs and only mapped once their fence has signaled,
+    // usually a few frames later, so that dumping doesn't wait for the GPU
+    static constexpr std::size_t FRAME_DUMPING_RING_SIZE = 4;
+    struct FrameDumpingReadback {
+        OGLBuffer pbo;
+        GLsync fence = nullptr;
+    };
+    std::array<FrameDumpingReadback, FRAME_DUMPING_RING_SIZE> frame_dumping_readbacks;
+    /// The readback the next frame is read into
+    std::size_t next_readback = 0;
+    /// Number of readbacks that haven't been handed to the video dumper yet
+    std::size_t pending_readbacks = 0;
 };
 
 } // namespace OpenGL
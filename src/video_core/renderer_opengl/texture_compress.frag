@@ -0,0 +1,164 @@
+//? #version 330
+// Each fragment encodes one 4x4 block of the source texture, BC1 for opaque textures and BC3 for
+// textures with alpha. The blocks are copied into the compressed texture afterwards.
+out uvec4 block;
+
+uniform sampler2D source;
+uniform bool has_alpha;
+uniform bool high_quality;
+
+vec4 texels[16];
+
+uint PackRGB565(vec3 color) {
+    uvec3 c = uvec3(round(clamp(color, 0.0, 1.0) * vec3(31.0, 63.0, 31.0)));
+    return (c.r << 11) | (c.g << 5) | c.b;
+}
+
+vec3 UnpackRGB565(uint color) {
+    return vec3(uvec3(color >> 11, color >> 5, color) & uvec3(31u, 63u, 31u)) /
+           vec3(31.0, 63.0, 31.0);
+}
+
+// Finds the end points of the line the block colors are fitted to
+void FindColorEndpoints(out vec3 color0, out vec3 color1) {
+    vec3 min_color = texels[0].rgb;
+    vec3 max_color = texels[0].rgb;
+    for (int i = 1; i < 16; ++i) {
+        min_color = min(min_color, texels[i].rgb);
+        max_color = max(max_color, texels[i].rgb);
+    }
+
+    if (!high_quality) {
+        color0 = max_color;
+        color1 = min_color;
+        return;
+    }
+
+    // Use the principal axis of the colors instead of the bounding box diagonal, found by power
+    // iteration on their covariance matrix
+    vec3 mean = vec3(0.0);
+    for (int i = 0; i < 16; ++i) {
+        mean += texels[i].rgb;
+    }
+    mean /= 16.0;
+    mat3 covariance = mat3(0.0);
+    for (int i = 0; i < 16; ++i) {
+        vec3 d = texels[i].rgb - mean;
+        covariance += outerProduct(d, d);
+    }
+    vec3 axis = max_color - min_color;
+    for (int i = 0; i < 4; ++i) {
+        axis = covariance * axis;
+        float len = length(axis);
+        if (len < 1e-6) {
+            break;
+        }
+        axis /= len;
+    }
+    if (dot(axis, axis) < 1e-6) {
+        color0 = max_color;
+        color1 = min_color;
+        return;
+    }
+
+    float min_t = dot(texels[0].rgb - mean, axis);
+    float max_t = min_t;
+    for (int i = 1; i < 16; ++i) {
+        float t = dot(texels[i].rgb - mean, axis);
+        min_t = min(min_t, t);
+        max_t = max(max_t, t);
+    }
+    // Inset the end points a little, which lowers the error of the interpolated colors
+    float inset = (max_t - min_t) / 16.0;
+    color0 = mean + axis * (max_t - inset);
+    color1 = mean + axis * (min_t + inset);
+}
+
+uvec2 EncodeColorBlock() {
+    vec3 color0;
+    vec3 color1;
+    FindColorEndpoints(color0, color1);
+
+    uint packed0 = PackRGB565(color0);
+    uint packed1 = PackRGB565(color1);
+    // The four color mode needs the first end point to be the larger one
+    bool swapped = packed0 < packed1;
+    if (swapped) {
+        uint tmp = packed0;
+        packed0 = packed1;
+        packed1 = tmp;
+    }
+
+    vec3 palette[4];
+    palette[0] = UnpackRGB565(packed0);
+    palette[1] = UnpackRGB565(packed1);
+    palette[2] = (2.0 * palette[0] + palette[1]) / 3.0;
+    palette[3] = (palette[0] + 2.0 * palette[1]) / 3.0;
+
+    uint indices = 0u;
+    if (packed0 != packed1) {
+        for (int i = 0; i < 16; ++i) {
+            uint best = 0u;
+            float best_distance = 4.0;
+            for (uint j = 0u; j < 4u; ++j) {
+                vec3 d = texels[i].rgb - palette[j];
+                float distance = dot(d, d);
+                if (distance < best_distance) {
+                    best = j;
+                    best_distance = distance;
+                }
+            }
+            indices |= best << uint(2 * i);
+        }
+    }
+    return uvec2(packed0 | (packed1 << 16), indices);
+}
+
+uvec2 EncodeAlphaBlock() {
+    float min_alpha = texels[0].a;
+    float max_alpha = texels[0].a;
+    for (int i = 1; i < 16; ++i) {
+        min_alpha = min(min_alpha, texels[i].a);
+        max_alpha = max(max_alpha, texels[i].a);
+    }
+
+    uint alpha0 = uint(round(max_alpha * 255.0));
+    uint alpha1 = uint(round(min_alpha * 255.0));
+
+    // 3 bit indices, 0 and 1 are the end points and 2 to 7 interpolate from alpha0 to alpha1
+    uint low = alpha0 | (alpha1 << 8);
+    uint high = 0u;
+    if (alpha0 != alpha1) {
+        float range = float(alpha0 - alpha1);
+        for (int i = 0; i < 16; ++i) {
+            uint step = uint(round((texels[i].a * 255.0 - float(alpha1)) / range * 7.0));
+            uint index = step == 7u ? 0u : (step == 0u ? 1u : 8u - step);
+            int bit = 16 + 3 * i;
+            if (bit < 32) {
+                low |= index << uint(bit);
+                if (bit > 29) {
+                    high |= index >> uint(32 - bit);
+                }
+            } else {
+                high |= index << uint(bit - 32);
+            }
+        }
+    }
+    return uvec2(low, high);
+}
+
+void main() {
+    ivec2 origin = ivec2(gl_FragCoord.xy) * 4;
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            texels[y * 4 + x] = texelFetch(source, origin + ivec2(x, y), 0);
+        }
+    }
+
+    uvec2 color = EncodeColorBlock();
+    if (has_alpha) {
+        block = uvec4(EncodeAlphaBlock(), color);
+    } else {
+        block = uvec4(color, 0u, 0u);
+    }
+}
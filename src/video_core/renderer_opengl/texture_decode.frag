@@ -0,0 +1,145 @@
+//? #version 330
+out vec4 color;
+
+// Raw tiled texture data, one little endian word per texel
+uniform usamplerBuffer tiled_data;
+
+uniform int format;
+// Index of the word holding the first byte of the surface
+uniform int data_start;
+uniform int tile_size;
+uniform int line_size;
+uniform int height;
+uniform ivec2 rect_origin;
+uniform vec4 viewport;
+uniform float res_scale;
+
+// Values of SurfaceParams::PixelFormat
+const int FORMAT_IA8 = 5;
+const int FORMAT_RG8 = 6;
+const int FORMAT_I8 = 7;
+const int FORMAT_A8 = 8;
+const int FORMAT_IA4 = 9;
+const int FORMAT_I4 = 10;
+const int FORMAT_A4 = 11;
+const int FORMAT_ETC1 = 12;
+const int FORMAT_ETC1A4 = 13;
+
+const ivec2 etc1_modifier_table[8] =
+    ivec2[8](ivec2(2, 8), ivec2(5, 17), ivec2(9, 29), ivec2(13, 42), ivec2(18, 60),
+             ivec2(24, 80), ivec2(33, 106), ivec2(47, 183));
+
+uint ReadWord(int offset) {
+    return texelFetch(tiled_data, data_start + (offset >> 2)).r;
+}
+
+uint ReadByte(int offset) {
+    return (ReadWord(offset) >> uint((offset & 3) * 8)) & 0xFFu;
+}
+
+uint ReadNibble(int offset, int nibble) {
+    return (ReadByte(offset) >> uint((nibble & 1) * 4)) & 0xFu;
+}
+
+uint Convert4To8(uint value) {
+    return (value << 4) | value;
+}
+
+uvec3 Convert4To8(uvec3 value) {
+    return (value << 4) | value;
+}
+
+uvec3 Convert5To8(uvec3 value) {
+    return ((value << 3) | (value >> 2)) & 0xFFu;
+}
+
+int MortonInterleave(int x, int y) {
+    return (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) |
+           ((y & 4) << 3);
+}
+
+// Mirrors ETC1Tile::GetRGB in video_core/texture/etc1.cpp
+uvec3 SampleETC1Subtile(uint low, uint high, int x, int y) {
+    int texel = 4 * x + y;
+    if ((high & 1u) != 0u) {
+        int tmp = x;
+        x = y;
+        y = tmp;
+    }
+
+    uvec3 base;
+    if ((high & 2u) != 0u) {
+        ivec3 value = ivec3(uvec3(high >> 27, high >> 19, high >> 11) & 0x1Fu);
+        if (x >= 2) {
+            ivec3 delta = ivec3(uvec3(high >> 24, high >> 16, high >> 8) & 0x7u);
+            value += delta - ((delta & 4) << 1);
+        }
+        base = Convert5To8(uvec3(value) & 0xFFu);
+    } else {
+        uint shift = (x < 2) ? 4u : 0u;
+        base = Convert4To8(uvec3(high >> (24u + shift), high >> (16u + shift),
+                                 high >> (8u + shift)) &
+                           0xFu);
+    }
+
+    uint table_index = (x < 2) ? ((high >> 5) & 0x7u) : ((high >> 2) & 0x7u);
+    int modifier = etc1_modifier_table[table_index][(low >> uint(texel)) & 1u];
+    if (((low >> uint(16 + texel)) & 1u) != 0u) {
+        modifier = -modifier;
+    }
+    return uvec3(clamp(ivec3(base) + modifier, 0, 255));
+}
+
+uvec4 DecodeTexel(int tile, int x, int y) {
+    int morton = MortonInterleave(x, y);
+    switch (format) {
+    case FORMAT_IA8: {
+        uint i = ReadByte(tile + morton * 2 + 1);
+        return uvec4(i, i, i, ReadByte(tile + morton * 2));
+    }
+    case FORMAT_RG8:
+        return uvec4(ReadByte(tile + morton * 2 + 1), ReadByte(tile + morton * 2), 0u, 255u);
+    case FORMAT_I8: {
+        uint i = ReadByte(tile + morton);
+        return uvec4(i, i, i, 255u);
+    }
+    case FORMAT_A8:
+        return uvec4(0u, 0u, 0u, ReadByte(tile + morton));
+    case FORMAT_IA4: {
+        uint i = Convert4To8(ReadNibble(tile + morton, 1));
+        return uvec4(i, i, i, Convert4To8(ReadNibble(tile + morton, 0)));
+    }
+    case FORMAT_I4: {
+        uint i = Convert4To8(ReadNibble(tile + morton / 2, morton));
+        return uvec4(i, i, i, 255u);
+    }
+    case FORMAT_A4:
+        return uvec4(0u, 0u, 0u, Convert4To8(ReadNibble(tile + morton / 2, morton)));
+    case FORMAT_ETC1:
+    case FORMAT_ETC1A4: {
+        bool has_alpha = format == FORMAT_ETC1A4;
+        int subtile = tile + ((x / 4) + 2 * (y / 4)) * (has_alpha ? 16 : 8);
+        x %= 4;
+        y %= 4;
+
+        uint alpha = 255u;
+        if (has_alpha) {
+            int index = x * 4 + y;
+            uint packed_alpha = ReadWord(subtile + (index / 8) * 4);
+            alpha = Convert4To8((packed_alpha >> uint(4 * (index % 8))) & 0xFu);
+            subtile += 8;
+        }
+        return uvec4(SampleETC1Subtile(ReadWord(subtile), ReadWord(subtile + 4), x, y), alpha);
+    }
+    }
+    return uvec4(0u);
+}
+
+void main() {
+    ivec2 coord = ivec2((gl_FragCoord.xy - viewport.xy) / res_scale) + rect_origin;
+    // Surfaces are stored bottom to top, while the tiled data starts with the top row
+    int x = coord.x;
+    int y = height - 1 - coord.y;
+    int tile = (y / 8) * line_size + (x / 8) * tile_size;
+    color = vec4(DecodeTexel(tile, x % 8, y % 8)) / 255.0;
+}
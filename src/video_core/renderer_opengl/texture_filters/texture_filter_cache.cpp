@@ -0,0 +1,133 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/hash.h"
+#include "common/microprofile.h"
+#include "video_core/renderer_opengl/gl_rasterizer_cache.h"
+#include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/texture_filters/texture_filter_cache.h"
+#include "video_core/renderer_opengl/texture_filters/texture_filter_interface.h"
+
+namespace OpenGL {
+
+namespace {
+struct CacheKey {
+    u64 data_hash;
+    u32 width;
+    u32 height;
+    u32 stride;
+    u32 pixel_format;
+    u32 scale_factor;
+};
+} // namespace
+
+/// Copies region of src into dst, both having the same format
+static void CopyRegion(GLuint src_tex, const Viewport& src, GLuint dst_tex, const Viewport& dst,
+                       GLuint read_fb_handle, GLuint draw_fb_handle) {
+    OpenGLState prev_state = OpenGLState::GetCurState();
+    OpenGLState state;
+    state.draw.read_framebuffer = read_fb_handle;
+    state.draw.draw_framebuffer = draw_fb_handle;
+    state.Apply();
+
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, src_tex, 0);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dst_tex, 0);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    glBlitFramebuffer(src.x, src.y, src.x + src.width, src.y + src.height, dst.x, dst.y,
+                      dst.x + dst.width, dst.y + dst.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    prev_state.Apply();
+}
+
+TextureFilterCache::TextureFilterCache() = default;
+
+TextureFilterCache::~TextureFilterCache() = default;
+
+MICROPROFILE_DEFINE(OpenGL_FilterCache, "OpenGL", "Texture Filter Cache", MP_RGB(128, 192, 64));
+void TextureFilterCache::Scale(TextureFilterInterface& filter, CachedSurface& surface,
+                               const Common::Rectangle<u32>& rect, std::size_t buffer_offset,
+                               GLuint read_fb_handle, GLuint draw_fb_handle) {
+    MICROPROFILE_SCOPE(OpenGL_FilterCache);
+
+    const u32 width = rect.GetWidth();
+    const u32 height = rect.GetHeight();
+    const u32 bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(surface.pixel_format);
+
+    // Rows are stride apart, so the gaps between them are hashed too instead of copying the rows
+    const std::size_t data_size =
+        (static_cast<std::size_t>(height - 1) * surface.stride + width) * bytes_per_pixel;
+    Common::HashableStruct<CacheKey> key;
+    key.state.data_hash = Common::ComputeFastHash64(&surface.gl_buffer[buffer_offset], data_size);
+    key.state.width = width;
+    key.state.height = height;
+    key.state.stride = surface.stride;
+    key.state.pixel_format = static_cast<u32>(surface.pixel_format);
+    key.state.scale_factor = filter.scale_factor;
+    const u64 hash = key.Hash();
+
+    // Same region of the bound texture the filter draws to
+    const GLuint target_tex = OpenGLState::GetCurState().texture_units[0].texture_2d;
+    const Viewport target{
+        static_cast<GLint>(rect.left) * filter.scale_factor,
+        static_cast<GLint>(rect.top) * filter.scale_factor,
+        static_cast<GLsizei>(width) * filter.scale_factor,
+        static_cast<GLsizei>(height) * filter.scale_factor,
+    };
+    const Viewport cached{0, 0, target.width, target.height};
+
+    const auto it = entries.find(hash);
+    if (it != entries.end()) {
+        ++hits;
+        lru.splice(lru.begin(), lru, it->second.lru_position);
+        CopyRegion(it->second.texture.handle, cached, target_tex, target, read_fb_handle,
+                   draw_fb_handle);
+        return;
+    }
+
+    ++misses;
+    filter.scale(surface, rect, buffer_offset);
+
+    const std::size_t size =
+        static_cast<std::size_t>(target.width) * target.height * bytes_per_pixel;
+    if (size > MAX_SIZE)
+        return;
+
+    while (total_size + size > MAX_SIZE) {
+        const auto oldest = entries.find(lru.back());
+        total_size -= oldest->second.size;
+        entries.erase(oldest);
+        lru.pop_back();
+    }
+
+    Entry& entry = entries[hash];
+    entry.texture.Create();
+    entry.size = size;
+    lru.push_front(hash);
+    entry.lru_position = lru.begin();
+    total_size += size;
+
+    // Allocate the copy with the same format as the target so that it can be blitted
+    OpenGLState prev_state = OpenGLState::GetCurState();
+    OpenGLState state = prev_state;
+    state.texture_units[0].texture_2d = entry.texture.handle;
+    state.Apply();
+    const FormatTuple& tuple = GetFormatTuple(surface.pixel_format);
+    glActiveTexture(GL_TEXTURE0);
+    glTexImage2D(GL_TEXTURE_2D, 0, tuple.internal_format, target.width, target.height, 0,
+                 tuple.format, tuple.type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    prev_state.Apply();
+
+    CopyRegion(target_tex, target, entry.texture.handle, cached, read_fb_handle, draw_fb_handle);
+}
+
+void TextureFilterCache::Clear() {
+    entries.clear();
+    lru.clear();
+    total_size = 0;
+}
+
+} // namespace OpenGL
@@ -0,0 +1,68 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/math_util.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+namespace OpenGL {
+
+struct CachedSurface;
+class TextureFilterInterface;
+
+/**
+ * Keeps the output of the texture filter for recently uploaded texture data, so that surfaces
+ * that are recreated or reloaded with the same contents copy the filtered texture instead of
+ * running the filter again. The least recently used outputs are released once the cache is
+ * over its size limit.
+ */
+class TextureFilterCache {
+public:
+    TextureFilterCache();
+    ~TextureFilterCache();
+
+    /**
+     * Filters a region of the surface's gl_buffer into the bound texture like
+     * TextureFilterInterface::scale, reusing the cached output if the same data was filtered
+     * before
+     */
+    void Scale(TextureFilterInterface& filter, CachedSurface& surface,
+               const Common::Rectangle<u32>& rect, std::size_t buffer_offset,
+               GLuint read_fb_handle, GLuint draw_fb_handle);
+
+    /// Releases all cached outputs, needed when the filter or its scale factor changes
+    void Clear();
+
+    u64 GetHits() const {
+        return hits;
+    }
+
+    u64 GetMisses() const {
+        return misses;
+    }
+
+private:
+    struct Entry {
+        OGLTexture texture;
+        std::size_t size;
+        std::list<u64>::iterator lru_position;
+    };
+
+    static constexpr std::size_t MAX_SIZE = 128 * 1024 * 1024;
+
+    std::unordered_map<u64, Entry> entries;
+    /// Keys of the entries, most recently used first
+    std::list<u64> lru;
+    std::size_t total_size = 0;
+    u64 hits = 0;
+    u64 misses = 0;
+};
+
+} // namespace OpenGL
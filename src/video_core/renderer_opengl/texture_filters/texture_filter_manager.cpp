@@ -68,6 +68,7 @@ bool TextureFilterManager::IsUpdated() const {
 void TextureFilterManager::Reset() {
     std::lock_guard<std::mutex> lock{mutex};
     updated = false;
+    cache.Clear();
     auto iter = TextureFilterMap().find(name);
     if (iter == TextureFilterMap().end()) {
         LOG_ERROR(Render_OpenGL, "Invalid texture filter: {}", name);
@@ -10,6 +10,7 @@
 #include <mutex>
 #include <string_view>
 #include <tuple>
+#include "video_core/renderer_opengl/texture_filters/texture_filter_cache.h"
 #include "video_core/renderer_opengl/texture_filters/texture_filter_interface.h"
 
 namespace OpenGL {
@@ -35,10 +36,14 @@ public:
     }
 
     void Destroy() {
+        cache.Clear();
         filter.reset();
     }
     void SetTextureFilter(std::string filter_name, u16 new_scale_factor);
     TextureFilterInterface* GetTextureFilter() const;
+    TextureFilterCache& GetCache() {
+        return cache;
+    }
     // returns true if filter has been changed and a cache reset is needed
     bool IsUpdated() const;
     void Reset();
@@ -50,6 +55,7 @@ private:
     u16 scale_factor{1};
 
     std::unique_ptr<TextureFilterInterface> filter;
+    TextureFilterCache cache;
 };
 
 } // namespace OpenGL
@@ -35,6 +35,8 @@ struct AttributeBuffer {
 
 /// Handler type for receiving vertex outputs from vertex shader or geometry shader
 using VertexHandler = std::function<void(const AttributeBuffer&)>;
+/// Handler type for receiving a span of consecutive vertex outputs
+using VertexBatchHandler = std::function<void(const AttributeBuffer* vertices, std::size_t count)>;
 
 /// Handler type for signaling to invert the vertex order of the next triangle
 using WindingSetter = std::function<void()>;
@@ -198,45 +200,85 @@ struct Uniforms {
 struct ShaderSetup {
     Uniforms uniforms;
 
-    ProgramCode program_code;
-    SwizzleData swizzle_data;
+    /// Output registers read after the shader runs, set from the shader registers before each
+    /// SetupBatch. Engines may skip writes to the other output registers.
+    u32 output_mask = 0xFFFF;
+
+    /// One bit for each bool uniform that may change between runs without a new SetupBatch.
+    /// Engines have to test these when the shader runs.
+    u16 dynamic_bool_uniforms = 0;
 
     /// Data private to ShaderEngines
     struct EngineData {
         unsigned int entry_point;
-        /// Used by the JIT, points to a compiled shader object.
+        /// Points to the shader object compiled by the JIT or decoded by the interpreter.
         const void* cached_shader = nullptr;
     } engine_data;
 
+    // The program is only read when (re)compiling a shader. It comes after the fields read by
+    // every draw so that those share cache lines with the uniforms.
+    ProgramCode program_code;
+    SwizzleData swizzle_data;
+
+    /// Writes a word of the program code, updating the hash in constant time
+    void WriteProgramWord(std::size_t offset, u32 value) {
+        if (!program_code_hash_dirty)
+            program_code_hash.Update(offset, program_code[offset], value);
+        program_code[offset] = value;
+    }
+
+    /// Writes a word of the swizzle data, updating the hash in constant time
+    void WriteSwizzleWord(std::size_t offset, u32 value) {
+        if (!swizzle_data_hash_dirty)
+            swizzle_data_hash.Update(offset, swizzle_data[offset], value);
+        swizzle_data[offset] = value;
+    }
+
+    /// Has the hash recomputed after the program code was modified directly
     void MarkProgramCodeDirty() {
         program_code_hash_dirty = true;
     }
 
+    /// Has the hash recomputed after the swizzle data was modified directly
     void MarkSwizzleDataDirty() {
         swizzle_data_hash_dirty = true;
     }
 
     u64 GetProgramCodeHash() {
         if (program_code_hash_dirty) {
-            program_code_hash = Common::ComputeHash64(&program_code, sizeof(program_code));
+            program_code_hash.Reset(program_code);
             program_code_hash_dirty = false;
         }
-        return program_code_hash;
+        return program_code_hash.Get();
     }
 
     u64 GetSwizzleDataHash() {
         if (swizzle_data_hash_dirty) {
-            swizzle_data_hash = Common::ComputeHash64(&swizzle_data, sizeof(swizzle_data));
+            swizzle_data_hash.Reset(swizzle_data);
             swizzle_data_hash_dirty = false;
         }
-        return swizzle_data_hash;
+        return swizzle_data_hash.Get();
+    }
+
+    /// Hashes program code the same way as GetProgramCodeHash, for code outside of a ShaderSetup
+    static u64 ComputeProgramCodeHash(const ProgramCode& code) {
+        Common::WordArrayHash hash;
+        hash.Reset(code);
+        return hash.Get();
+    }
+
+    /// Hashes swizzle data the same way as GetSwizzleDataHash
+    static u64 ComputeSwizzleDataHash(const SwizzleData& data) {
+        Common::WordArrayHash hash;
+        hash.Reset(data);
+        return hash.Get();
     }
 
 private:
     bool program_code_hash_dirty = true;
     bool swizzle_data_hash_dirty = true;
-    u64 program_code_hash = 0xDEADC0DE;
-    u64 swizzle_data_hash = 0xDEADC0DE;
+    Common::WordArrayHash program_code_hash;
+    Common::WordArrayHash swizzle_data_hash;
 };
 
 class ShaderEngine {
@@ -256,6 +298,17 @@ public:
      * @param state Shader unit state, must be setup with input data before each shader invocation.
      */
     virtual void Run(const ShaderSetup& setup, UnitState& state) const = 0;
+
+    /**
+     * Runs the currently setup shader once for each of the given unit states, in order. The
+     * address registers and conditional codes carry over from each state to the next one, exactly
+     * like with consecutive calls to `Run` on the same state.
+     *
+     * @param setup Shader engine state, must be setup with SetupBatch on each shader change.
+     * @param states Shader unit states, must be setup with input data before the invocation.
+     * @param count Number of states in the array, must not be zero.
+     */
+    virtual void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const;
 };
 
 // TODO(yuriks): Remove and make it non-global state somewhere
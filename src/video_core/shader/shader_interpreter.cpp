@@ -18,6 +18,7 @@
 #include "video_core/pica_types.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_interpreter.h"
+#include "video_core/shader/shader_interpreter_program.h"
 
 using nihstro::Instruction;
 using nihstro::OpCode;
@@ -666,17 +667,65 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     }
 }
 
+InterpreterEngine::InterpreterEngine() = default;
+InterpreterEngine::~InterpreterEngine() = default;
+
 void InterpreterEngine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
+
+    const u64 cache_key = setup.GetProgramCodeHash() ^ setup.GetSwizzleDataHash();
+    auto iter = cache.find(cache_key);
+    if (iter != cache.end()) {
+        lru.splice(lru.begin(), lru, iter->second.lru_position);
+        setup.engine_data.cached_shader = iter->second.program.get();
+        return;
+    }
+
+    // Draws set up the vertex shader right before the geometry shader, so the least recently used
+    // program is never one that is still in use
+    if (cache.size() == MAX_CACHED_PROGRAMS) {
+        cache.erase(lru.back());
+        lru.pop_back();
+    }
+    lru.push_front(cache_key);
+    CacheEntry& entry = cache[cache_key];
+    entry.program = std::make_unique<InterpreterProgram>(setup.program_code, setup.swizzle_data);
+    entry.lru_position = lru.begin();
+    setup.engine_data.cached_shader = entry.program.get();
 }
 
 MICROPROFILE_DECLARE(GPU_Shader);
 
 void InterpreterEngine::Run(const ShaderSetup& setup, UnitState& state) const {
 
+    ASSERT(setup.engine_data.cached_shader != nullptr);
+
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+    const auto* program = static_cast<const InterpreterProgram*>(setup.engine_data.cached_shader);
+    program->Run(setup, state, setup.engine_data.entry_point);
+}
+
+void InterpreterEngine::RunBatch(const ShaderSetup& setup, UnitState* states,
+                                 std::size_t count) const {
+
+    ASSERT(setup.engine_data.cached_shader != nullptr);
+
     MICROPROFILE_SCOPE(GPU_Shader);
 
+    const auto* program = static_cast<const InterpreterProgram*>(setup.engine_data.cached_shader);
+    for (std::size_t i = 0; i < count; ++i) {
+        // The conditional codes are reset by every run, so only the address registers carry over
+        if (i != 0) {
+            std::copy(std::begin(states[i - 1].address_registers),
+                      std::end(states[i - 1].address_registers), states[i].address_registers);
+        }
+        program->Run(setup, states[i], setup.engine_data.entry_point);
+    }
+}
+
+void InterpreterEngine::RunReference(const ShaderSetup& setup, UnitState& state) const {
     DebugData<false> dummy_debug_data;
     RunInterpreter(setup, state, dummy_debug_data, setup.engine_data.entry_point);
 }
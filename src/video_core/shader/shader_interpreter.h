@@ -4,15 +4,31 @@
 
 #pragma once
 
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include "common/common_types.h"
 #include "video_core/shader/debug_data.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica::Shader {
 
+class InterpreterProgram;
+
 class InterpreterEngine final : public ShaderEngine {
 public:
+    InterpreterEngine();
+    ~InterpreterEngine() override;
+
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
+    void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const override;
+
+    /**
+     * Runs the set up shader with the reference interpreter, which decodes each instruction as it
+     * goes. The results are the same as with Run, which the decoded programs are tested against.
+     */
+    void RunReference(const ShaderSetup& setup, UnitState& state) const;
 
     /**
      * Produce debug information based on the given shader and input vertex
@@ -23,6 +39,20 @@ public:
      */
     DebugData<true> ProduceDebugInfo(const ShaderSetup& setup, const AttributeBuffer& input,
                                      const ShaderRegs& config) const;
+
+private:
+    struct CacheEntry {
+        std::unique_ptr<InterpreterProgram> program;
+        std::list<u64>::iterator lru_position;
+    };
+
+    /// Each decoded program holds a micro-op for every word of the program code
+    static constexpr std::size_t MAX_CACHED_PROGRAMS = 64;
+
+    /// Decoded programs by the hash of their program code and swizzle data
+    std::unordered_map<u64, CacheEntry> cache;
+    /// Keys of the cached programs, most recently used first
+    std::list<u64> lru;
 };
 
 } // namespace Pica::Shader
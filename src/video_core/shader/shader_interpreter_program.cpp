@@ -0,0 +1,1006 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <boost/container/static_vector.hpp>
+#include <nihstro/shader_bytecode.h>
+#include "common/assert.h"
+#include "common/common_types.h"
+#include "common/logging/log.h"
+#include "video_core/pica_types.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter_program.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::RegisterType;
+using nihstro::SourceRegister;
+using nihstro::SwizzlePattern;
+
+namespace Pica::Shader {
+
+namespace {
+
+static_assert(sizeof(float24) == sizeof(float), "float24 must be stored as a float");
+
+// Four component vector operations, matching the per component float24 operations of the
+// reference interpreter bit for bit.
+#if defined(ARCHITECTURE_x86_64)
+
+using Vec4f = __m128;
+
+Vec4f Load(const float24* v) {
+    return _mm_loadu_ps(reinterpret_cast<const float*>(v));
+}
+
+void Store(float24* v, Vec4f value) {
+    _mm_storeu_ps(reinterpret_cast<float*>(v), value);
+}
+
+Vec4f Set(float x, float y, float z, float w) {
+    return _mm_setr_ps(x, y, z, w);
+}
+
+Vec4f Splat(float value) {
+    return _mm_set1_ps(value);
+}
+
+float First(Vec4f v) {
+    return _mm_cvtss_f32(v);
+}
+
+Vec4f Negate(Vec4f v) {
+    return _mm_xor_ps(v, _mm_set1_ps(-0.0f));
+}
+
+Vec4f Add(Vec4f a, Vec4f b) {
+    return _mm_add_ps(a, b);
+}
+
+/// Multiplies like float24, which gives 0 instead of NaN for inf * 0
+Vec4f Mul(Vec4f a, Vec4f b) {
+    const __m128 result = _mm_mul_ps(a, b);
+    const __m128 inf_times_zero = _mm_and_ps(_mm_cmpunord_ps(result, result), _mm_cmpord_ps(a, b));
+    return _mm_andnot_ps(inf_times_zero, result);
+}
+
+/// (a > b) ? a : b, which is what maxps computes for NaNs as well
+Vec4f Max(Vec4f a, Vec4f b) {
+    return _mm_max_ps(a, b);
+}
+
+/// (a < b) ? a : b, which is what minps computes for NaNs as well
+Vec4f Min(Vec4f a, Vec4f b) {
+    return _mm_min_ps(a, b);
+}
+
+/// 1.0 where a >= b, 0.0 elsewhere
+Vec4f GreaterEqual(Vec4f a, Vec4f b) {
+    return _mm_and_ps(_mm_cmpge_ps(a, b), _mm_set1_ps(1.0f));
+}
+
+/// 1.0 where a < b, 0.0 elsewhere
+Vec4f LessThan(Vec4f a, Vec4f b) {
+    return _mm_and_ps(_mm_cmplt_ps(a, b), _mm_set1_ps(1.0f));
+}
+
+/// Takes the components whose bit is set in the mask from a, the others from b
+Vec4f Select(u32 mask, Vec4f a, Vec4f b) {
+    const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128 lanes = _mm_castsi128_ps(
+        _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(mask)), bits), bits));
+    return _mm_or_ps(_mm_and_ps(lanes, a), _mm_andnot_ps(lanes, b));
+}
+
+#elif defined(ARCHITECTURE_ARM64)
+
+using Vec4f = float32x4_t;
+
+Vec4f Load(const float24* v) {
+    return vld1q_f32(reinterpret_cast<const float*>(v));
+}
+
+void Store(float24* v, Vec4f value) {
+    vst1q_f32(reinterpret_cast<float*>(v), value);
+}
+
+Vec4f Set(float x, float y, float z, float w) {
+    const float values[4] = {x, y, z, w};
+    return vld1q_f32(values);
+}
+
+Vec4f Splat(float value) {
+    return vdupq_n_f32(value);
+}
+
+float First(Vec4f v) {
+    return vgetq_lane_f32(v, 0);
+}
+
+Vec4f Negate(Vec4f v) {
+    return vnegq_f32(v);
+}
+
+Vec4f Add(Vec4f a, Vec4f b) {
+    return vaddq_f32(a, b);
+}
+
+/// Multiplies like float24, which gives 0 instead of NaN for inf * 0
+Vec4f Mul(Vec4f a, Vec4f b) {
+    const float32x4_t result = vmulq_f32(a, b);
+    const uint32x4_t inputs_ordered = vandq_u32(vceqq_f32(a, a), vceqq_f32(b, b));
+    const uint32x4_t result_nan = vmvnq_u32(vceqq_f32(result, result));
+    const uint32x4_t inf_times_zero = vandq_u32(result_nan, inputs_ordered);
+    return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(result), inf_times_zero));
+}
+
+/// (a > b) ? a : b, fmax would return the number for NaNs instead
+Vec4f Max(Vec4f a, Vec4f b) {
+    return vbslq_f32(vcgtq_f32(a, b), a, b);
+}
+
+/// (a < b) ? a : b, fmin would return the number for NaNs instead
+Vec4f Min(Vec4f a, Vec4f b) {
+    return vbslq_f32(vcltq_f32(a, b), a, b);
+}
+
+/// 1.0 where a >= b, 0.0 elsewhere
+Vec4f GreaterEqual(Vec4f a, Vec4f b) {
+    return vreinterpretq_f32_u32(
+        vandq_u32(vcgeq_f32(a, b), vreinterpretq_u32_f32(vdupq_n_f32(1.0f))));
+}
+
+/// 1.0 where a < b, 0.0 elsewhere
+Vec4f LessThan(Vec4f a, Vec4f b) {
+    return vreinterpretq_f32_u32(
+        vandq_u32(vcltq_f32(a, b), vreinterpretq_u32_f32(vdupq_n_f32(1.0f))));
+}
+
+/// Takes the components whose bit is set in the mask from a, the others from b
+Vec4f Select(u32 mask, Vec4f a, Vec4f b) {
+    static constexpr u32 bits[4] = {1, 2, 4, 8};
+    return vbslq_f32(vtstq_u32(vdupq_n_u32(mask), vld1q_u32(bits)), a, b);
+}
+
+#else
+
+using Vec4f = std::array<float, 4>;
+
+Vec4f Load(const float24* v) {
+    return {v[0].ToFloat32(), v[1].ToFloat32(), v[2].ToFloat32(), v[3].ToFloat32()};
+}
+
+void Store(float24* v, Vec4f value) {
+    for (std::size_t i = 0; i < 4; ++i) {
+        v[i] = float24::FromFloat32(value[i]);
+    }
+}
+
+Vec4f Set(float x, float y, float z, float w) {
+    return {x, y, z, w};
+}
+
+Vec4f Splat(float value) {
+    return {value, value, value, value};
+}
+
+float First(Vec4f v) {
+    return v[0];
+}
+
+template <typename Op>
+Vec4f Map(Vec4f a, Vec4f b, Op op) {
+    return {op(a[0], b[0]), op(a[1], b[1]), op(a[2], b[2]), op(a[3], b[3])};
+}
+
+Vec4f Negate(Vec4f v) {
+    return {-v[0], -v[1], -v[2], -v[3]};
+}
+
+Vec4f Add(Vec4f a, Vec4f b) {
+    return Map(a, b, [](float x, float y) { return x + y; });
+}
+
+Vec4f Mul(Vec4f a, Vec4f b) {
+    return Map(a, b, [](float x, float y) {
+        return (float24::FromFloat32(x) * float24::FromFloat32(y)).ToFloat32();
+    });
+}
+
+Vec4f Max(Vec4f a, Vec4f b) {
+    return Map(a, b, [](float x, float y) { return (x > y) ? x : y; });
+}
+
+Vec4f Min(Vec4f a, Vec4f b) {
+    return Map(a, b, [](float x, float y) { return (x < y) ? x : y; });
+}
+
+Vec4f GreaterEqual(Vec4f a, Vec4f b) {
+    return Map(a, b, [](float x, float y) { return (x >= y) ? 1.0f : 0.0f; });
+}
+
+Vec4f LessThan(Vec4f a, Vec4f b) {
+    return Map(a, b, [](float x, float y) { return (x < y) ? 1.0f : 0.0f; });
+}
+
+Vec4f Select(u32 mask, Vec4f a, Vec4f b) {
+    for (std::size_t i = 0; i < 4; ++i) {
+        if ((mask & (1 << i)) == 0)
+            a[i] = b[i];
+    }
+    return a;
+}
+
+#endif
+
+enum class MicroOpKind : u8 {
+    Add,
+    Mul,
+    Flr,
+    Max,
+    Min,
+    Dp3,
+    Dp4,
+    Dph,
+    Rcp,
+    Rsq,
+    Mova,
+    Mov,
+    Sge,
+    Slt,
+    Cmp,
+    Ex2,
+    Lg2,
+    Mad,
+    End,
+    Jmpc,
+    Jmpu,
+    Call,
+    Callu,
+    Callc,
+    Nop,
+    Ifu,
+    Ifc,
+    Loop,
+    Emit,
+    SetEmit,
+    UnhandledArithmetic,
+    UnhandledMultiplyAdd,
+    Unhandled,
+};
+
+/// Register files, in the order of the base pointers set up by Run
+enum class SourceFile : u8 { Input, Temporary, FloatUniform, Dummy };
+enum class DestFile : u8 { Output, Temporary, Dummy };
+
+struct SourceOperand {
+    SourceRegister reg;  ///< Register before adding the address register
+    bool relative;       ///< Whether the address register of the micro-op is added to reg
+    bool negate;
+    SourceFile file;     ///< Register file of reg, if it isn't relative
+    u8 index;            ///< Register index of reg, if it isn't relative
+    std::array<u8, 4> selectors;
+};
+
+struct CallStackElement {
+    u32 final_address;  // Address upon which we jump to return_address
+    u32 return_address; // Where to jump when leaving scope
+    u8 repeat_counter;  // How often to repeat until this call stack element is removed
+    u8 loop_increment;  // Which value to add to the loop counter after an iteration
+    u32 loop_address;   // The address where we'll return to after each loop iteration
+};
+
+/// Final address of an empty call stack, which no program counter reaches
+constexpr u32 NO_FINAL_ADDRESS = 0xFFFFFFFF;
+
+void ResolveSource(const SourceRegister& reg, SourceFile& file, int& index) {
+    switch (reg.GetRegisterType()) {
+    case RegisterType::Input:
+        file = SourceFile::Input;
+        index = reg.GetIndex();
+        break;
+    case RegisterType::Temporary:
+        file = SourceFile::Temporary;
+        index = reg.GetIndex();
+        break;
+    case RegisterType::FloatUniform:
+        file = SourceFile::FloatUniform;
+        index = reg.GetIndex();
+        break;
+    default:
+        file = SourceFile::Dummy;
+        index = 0;
+        break;
+    }
+}
+
+template <typename DestField>
+void ResolveDest(const DestField& dest, DestFile& file, u8& index) {
+    if (dest.Value() < 0x10) {
+        file = DestFile::Output;
+        index = static_cast<u8>(dest.Value().GetIndex());
+    } else if (dest.Value() < 0x20) {
+        file = DestFile::Temporary;
+        index = static_cast<u8>(dest.Value().GetIndex());
+    } else {
+        file = DestFile::Dummy;
+        index = 0;
+    }
+}
+
+} // Anonymous namespace
+
+struct InterpreterProgram::MicroOp {
+    MicroOpKind kind = MicroOpKind::Nop;
+    u8 dest_mask = 0;        ///< Bit i is set if component i of the destination is written
+    u8 address_register = 0; ///< 1 to 3 for a0, a1 and aL, 0 if no source is relative
+    DestFile dest_file = DestFile::Dummy;
+    u8 dest_index = 0;
+    std::array<SourceOperand, 3> src{};
+
+    std::array<Instruction::Common::CompareOpType::Op, 2> compare_ops{};
+
+    // Flow control
+    Instruction::FlowControlType::Op condition{};
+    bool refx = false;
+    bool refy = false;
+    u32 dest_offset = 0;
+    u32 num_instructions = 0;
+    u32 uniform_id = 0; ///< Bool or integer uniform, depending on the instruction
+
+    u32 raw = 0; ///< Instruction word, for SETEMIT and for logging unhandled instructions
+};
+
+InterpreterProgram::InterpreterProgram(const ProgramCode& program_code,
+                                       const SwizzleData& swizzle_data)
+    : ops(MAX_PROGRAM_CODE_LENGTH + 1) {
+    // Programs running off the end stop at the extra micro-op
+    ops.back().kind = MicroOpKind::End;
+
+    const auto DecodeSource = [](SourceOperand& src, SourceRegister reg, bool relative,
+                                 bool negate, std::array<u8, 4> selectors) {
+        src.reg = reg;
+        src.relative = relative;
+        src.negate = negate;
+        src.selectors = selectors;
+
+        int index;
+        ResolveSource(reg, src.file, index);
+        src.index = static_cast<u8>(index);
+    };
+
+    const auto DecodeDestMask = [](const SwizzlePattern& swizzle) {
+        u8 mask = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (swizzle.DestComponentEnabled(i))
+                mask |= 1 << i;
+        }
+        return mask;
+    };
+
+    for (u32 address = 0; address < MAX_PROGRAM_CODE_LENGTH; ++address) {
+        const Instruction instr = {program_code[address]};
+        MicroOp& op = ops[address];
+        op.raw = instr.hex;
+
+        switch (instr.opcode.Value().GetInfo().type) {
+        case OpCode::Type::Arithmetic: {
+            const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+            const bool is_inverted =
+                (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+            const bool has_offset = instr.common.address_register_index != 0;
+
+            op.address_register = static_cast<u8>(instr.common.address_register_index.Value());
+            op.dest_mask = DecodeDestMask(swizzle);
+            ResolveDest(instr.common.dest, op.dest_file, op.dest_index);
+            DecodeSource(op.src[0], instr.common.GetSrc1(is_inverted), has_offset && !is_inverted,
+                         swizzle.negate_src1 != 0,
+                         {static_cast<u8>(swizzle.src1_selector_0.Value()),
+                          static_cast<u8>(swizzle.src1_selector_1.Value()),
+                          static_cast<u8>(swizzle.src1_selector_2.Value()),
+                          static_cast<u8>(swizzle.src1_selector_3.Value())});
+            DecodeSource(op.src[1], instr.common.GetSrc2(is_inverted), has_offset && is_inverted,
+                         swizzle.negate_src2 != 0,
+                         {static_cast<u8>(swizzle.src2_selector_0.Value()),
+                          static_cast<u8>(swizzle.src2_selector_1.Value()),
+                          static_cast<u8>(swizzle.src2_selector_2.Value()),
+                          static_cast<u8>(swizzle.src2_selector_3.Value())});
+            op.compare_ops = {instr.common.compare_op.x.Value(), instr.common.compare_op.y.Value()};
+
+            switch (instr.opcode.Value().EffectiveOpCode()) {
+            case OpCode::Id::ADD:
+                op.kind = MicroOpKind::Add;
+                break;
+            case OpCode::Id::MUL:
+                op.kind = MicroOpKind::Mul;
+                break;
+            case OpCode::Id::FLR:
+                op.kind = MicroOpKind::Flr;
+                break;
+            case OpCode::Id::MAX:
+                op.kind = MicroOpKind::Max;
+                break;
+            case OpCode::Id::MIN:
+                op.kind = MicroOpKind::Min;
+                break;
+            case OpCode::Id::DP3:
+                op.kind = MicroOpKind::Dp3;
+                break;
+            case OpCode::Id::DP4:
+                op.kind = MicroOpKind::Dp4;
+                break;
+            case OpCode::Id::DPH:
+            case OpCode::Id::DPHI:
+                op.kind = MicroOpKind::Dph;
+                break;
+            case OpCode::Id::RCP:
+                op.kind = MicroOpKind::Rcp;
+                break;
+            case OpCode::Id::RSQ:
+                op.kind = MicroOpKind::Rsq;
+                break;
+            case OpCode::Id::MOVA:
+                op.kind = MicroOpKind::Mova;
+                break;
+            case OpCode::Id::MOV:
+                op.kind = MicroOpKind::Mov;
+                break;
+            case OpCode::Id::SGE:
+            case OpCode::Id::SGEI:
+                op.kind = MicroOpKind::Sge;
+                break;
+            case OpCode::Id::SLT:
+            case OpCode::Id::SLTI:
+                op.kind = MicroOpKind::Slt;
+                break;
+            case OpCode::Id::CMP:
+                op.kind = MicroOpKind::Cmp;
+                break;
+            case OpCode::Id::EX2:
+                op.kind = MicroOpKind::Ex2;
+                break;
+            case OpCode::Id::LG2:
+                op.kind = MicroOpKind::Lg2;
+                break;
+            default:
+                op.kind = MicroOpKind::UnhandledArithmetic;
+                break;
+            }
+            break;
+        }
+
+        case OpCode::Type::MultiplyAdd: {
+            if ((instr.opcode.Value().EffectiveOpCode() != OpCode::Id::MAD) &&
+                (instr.opcode.Value().EffectiveOpCode() != OpCode::Id::MADI)) {
+                op.kind = MicroOpKind::UnhandledMultiplyAdd;
+                break;
+            }
+
+            const SwizzlePattern swizzle = {swizzle_data[instr.mad.operand_desc_id]};
+            const bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
+            const bool has_offset = instr.mad.address_register_index != 0;
+
+            op.kind = MicroOpKind::Mad;
+            op.address_register = static_cast<u8>(instr.mad.address_register_index.Value());
+            op.dest_mask = DecodeDestMask(swizzle);
+            ResolveDest(instr.mad.dest, op.dest_file, op.dest_index);
+            DecodeSource(op.src[0], instr.mad.GetSrc1(is_inverted), false,
+                         swizzle.negate_src1 != 0,
+                         {static_cast<u8>(swizzle.src1_selector_0.Value()),
+                          static_cast<u8>(swizzle.src1_selector_1.Value()),
+                          static_cast<u8>(swizzle.src1_selector_2.Value()),
+                          static_cast<u8>(swizzle.src1_selector_3.Value())});
+            DecodeSource(op.src[1], instr.mad.GetSrc2(is_inverted), has_offset && !is_inverted,
+                         swizzle.negate_src2 != 0,
+                         {static_cast<u8>(swizzle.src2_selector_0.Value()),
+                          static_cast<u8>(swizzle.src2_selector_1.Value()),
+                          static_cast<u8>(swizzle.src2_selector_2.Value()),
+                          static_cast<u8>(swizzle.src2_selector_3.Value())});
+            DecodeSource(op.src[2], instr.mad.GetSrc3(is_inverted), has_offset && is_inverted,
+                         swizzle.negate_src3 != 0,
+                         {static_cast<u8>(swizzle.src3_selector_0.Value()),
+                          static_cast<u8>(swizzle.src3_selector_1.Value()),
+                          static_cast<u8>(swizzle.src3_selector_2.Value()),
+                          static_cast<u8>(swizzle.src3_selector_3.Value())});
+            break;
+        }
+
+        default: {
+            op.condition = instr.flow_control.op.Value();
+            op.refx = instr.flow_control.refx.Value() != 0;
+            op.refy = instr.flow_control.refy.Value() != 0;
+            op.dest_offset = instr.flow_control.dest_offset;
+            op.num_instructions = instr.flow_control.num_instructions;
+
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::END:
+                op.kind = MicroOpKind::End;
+                break;
+            case OpCode::Id::JMPC:
+                op.kind = MicroOpKind::Jmpc;
+                break;
+            case OpCode::Id::JMPU:
+                op.kind = MicroOpKind::Jmpu;
+                op.uniform_id = instr.flow_control.bool_uniform_id;
+                break;
+            case OpCode::Id::CALL:
+                op.kind = MicroOpKind::Call;
+                break;
+            case OpCode::Id::CALLU:
+                op.kind = MicroOpKind::Callu;
+                op.uniform_id = instr.flow_control.bool_uniform_id;
+                break;
+            case OpCode::Id::CALLC:
+                op.kind = MicroOpKind::Callc;
+                break;
+            case OpCode::Id::NOP:
+                op.kind = MicroOpKind::Nop;
+                break;
+            case OpCode::Id::IFU:
+                op.kind = MicroOpKind::Ifu;
+                op.uniform_id = instr.flow_control.bool_uniform_id;
+                break;
+            case OpCode::Id::IFC:
+                op.kind = MicroOpKind::Ifc;
+                break;
+            case OpCode::Id::LOOP:
+                op.kind = MicroOpKind::Loop;
+                op.uniform_id = instr.flow_control.int_uniform_id;
+                break;
+            case OpCode::Id::EMIT:
+                op.kind = MicroOpKind::Emit;
+                break;
+            case OpCode::Id::SETEMIT:
+                op.kind = MicroOpKind::SetEmit;
+                break;
+            default:
+                op.kind = MicroOpKind::Unhandled;
+                break;
+            }
+            break;
+        }
+        }
+    }
+}
+
+InterpreterProgram::~InterpreterProgram() = default;
+
+// Handlers are dispatched with computed gotos where the compiler supports them, which gives every
+// handler its own indirect branch that the host can predict. Elsewhere a switch is used instead.
+#if defined(__GNUC__)
+#define SHADER_DISPATCH() goto* handlers[static_cast<std::size_t>(op->kind)]
+#define SHADER_HANDLER(kind) handle_##kind
+#else
+#define SHADER_DISPATCH() goto dispatch
+#define SHADER_HANDLER(kind) case MicroOpKind::kind
+#endif
+
+// Moves on to the next micro-op, leaving the calls and loops that end there first
+#define SHADER_NEXT()                                                                              \
+    do {                                                                                           \
+        if (++program_counter == final_address)                                                    \
+            goto leave_call;                                                                       \
+        op = &ops[program_counter];                                                                \
+        SHADER_DISPATCH();                                                                         \
+    } while (0)
+
+void InterpreterProgram::Run(const ShaderSetup& setup, UnitState& state,
+                             unsigned int entry_point) const {
+    // TODO: Is there a maximal size for this?
+    boost::container::static_vector<CallStackElement, 16> call_stack;
+    u32 program_counter = entry_point;
+    u32 final_address = NO_FINAL_ADDRESS;
+    const MicroOp* op = nullptr;
+
+    state.conditional_code[0] = false;
+    state.conditional_code[1] = false;
+
+    const auto& uniforms = setup.uniforms;
+
+    // Placeholder for invalid registers
+    std::array<float24, 4> dummy{};
+
+    const std::array<const float24*, 4> source_files{
+        &state.registers.input[0].x,
+        &state.registers.temporary[0].x,
+        &uniforms.f[0].x,
+        dummy.data(),
+    };
+    const std::array<float24*, 3> dest_files{
+        &state.registers.output[0].x,
+        &state.registers.temporary[0].x,
+        dummy.data(),
+    };
+
+    const auto call = [&](u32 offset, u32 num_instructions, u32 return_offset, u8 repeat_count,
+                          u8 loop_increment) {
+        // -1 to make sure when incrementing the PC we end up at the correct offset
+        program_counter = offset - 1;
+        ASSERT(call_stack.size() < call_stack.capacity());
+        call_stack.push_back(
+            {offset + num_instructions, return_offset, repeat_count, loop_increment, offset});
+        final_address = offset + num_instructions;
+    };
+
+    const auto evaluate_condition = [&state](const MicroOp& op) {
+        using Op = Instruction::FlowControlType::Op;
+
+        const bool result_x = op.refx == state.conditional_code[0];
+        const bool result_y = op.refy == state.conditional_code[1];
+
+        switch (op.condition) {
+        case Op::Or:
+            return result_x || result_y;
+        case Op::And:
+            return result_x && result_y;
+        case Op::JustX:
+            return result_x;
+        case Op::JustY:
+            return result_y;
+        default:
+            UNREACHABLE();
+            return false;
+        }
+    };
+
+    const auto LoadSource = [&](const MicroOp& op, std::size_t i) {
+        const SourceOperand& src = op.src[i];
+        const float24* reg;
+        if (src.relative) {
+            SourceFile file;
+            int index;
+            ResolveSource(src.reg + state.address_registers[op.address_register - 1], file,
+                          index);
+            reg = source_files[static_cast<std::size_t>(file)] + index * 4;
+        } else {
+            reg = source_files[static_cast<std::size_t>(src.file)] + src.index * 4;
+        }
+
+        const auto& sel = src.selectors;
+        const Vec4f value = Set(reg[sel[0]].ToFloat32(), reg[sel[1]].ToFloat32(),
+                                reg[sel[2]].ToFloat32(), reg[sel[3]].ToFloat32());
+        return src.negate ? Negate(value) : value;
+    };
+
+    const auto WriteDest = [&](const MicroOp& op, Vec4f value) {
+        float24* dest = dest_files[static_cast<std::size_t>(op.dest_file)] + op.dest_index * 4;
+        Store(dest, op.dest_mask == 0xF ? value : Select(op.dest_mask, value, Load(dest)));
+    };
+
+    const auto DotProduct = [](Vec4f a, Vec4f b, std::size_t num_components) {
+        std::array<float24, 4> products;
+        Store(products.data(), Mul(a, b));
+
+        float24 dot = float24::FromFloat32(0.f);
+        for (std::size_t i = 0; i < num_components; ++i) {
+            dot = dot + products[i];
+        }
+        return dot.ToFloat32();
+    };
+
+    const auto LogUnhandled = [](const char* type, u32 raw) {
+        const Instruction instr = {raw};
+        LOG_ERROR(HW_GPU, "Unhandled {}instruction: 0x{:02x} ({}): 0x{:08x}", type,
+                  (int)instr.opcode.Value().EffectiveOpCode(), instr.opcode.Value().GetInfo().name,
+                  instr.hex);
+    };
+
+#if defined(__GNUC__)
+    // In the order of MicroOpKind
+    static const void* const handlers[] = {
+        &&handle_Add,  &&handle_Mul,     &&handle_Flr,
+        &&handle_Max,  &&handle_Min,     &&handle_Dp3,
+        &&handle_Dp4,  &&handle_Dph,     &&handle_Rcp,
+        &&handle_Rsq,  &&handle_Mova,    &&handle_Mov,
+        &&handle_Sge,  &&handle_Slt,     &&handle_Cmp,
+        &&handle_Ex2,  &&handle_Lg2,     &&handle_Mad,
+        &&handle_End,  &&handle_Jmpc,    &&handle_Jmpu,
+        &&handle_Call, &&handle_Callu,   &&handle_Callc,
+        &&handle_Nop,  &&handle_Ifu,     &&handle_Ifc,
+        &&handle_Loop, &&handle_Emit,    &&handle_SetEmit,
+        &&handle_UnhandledArithmetic,    &&handle_UnhandledMultiplyAdd,
+        &&handle_Unhandled,
+    };
+    static_assert(std::size(handlers) == static_cast<std::size_t>(MicroOpKind::Unhandled) + 1);
+#endif
+
+fetch:
+    if (program_counter == final_address)
+        goto leave_call;
+    op = &ops[program_counter];
+    SHADER_DISPATCH();
+
+leave_call : {
+    CallStackElement& top = call_stack.back();
+    state.address_registers[2] += top.loop_increment;
+
+    if (top.repeat_counter-- == 0) {
+        program_counter = top.return_address;
+        call_stack.pop_back();
+        final_address = call_stack.empty() ? NO_FINAL_ADDRESS : call_stack.back().final_address;
+    } else {
+        program_counter = top.loop_address;
+    }
+
+    // TODO: Is "trying again" accurate to hardware?
+    goto fetch;
+}
+
+#if !defined(__GNUC__)
+dispatch:
+    switch (op->kind) {
+#endif
+
+    SHADER_HANDLER(Add) : {
+        WriteDest(*op, Add(LoadSource(*op, 0), LoadSource(*op, 1)));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Mul) : {
+        WriteDest(*op, Mul(LoadSource(*op, 0), LoadSource(*op, 1)));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Flr) : {
+        std::array<float24, 4> src1;
+        Store(src1.data(), LoadSource(*op, 0));
+        WriteDest(*op, Set(std::floor(src1[0].ToFloat32()), std::floor(src1[1].ToFloat32()),
+                           std::floor(src1[2].ToFloat32()), std::floor(src1[3].ToFloat32())));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Max) : {
+        // NOTE: Exact form required to match NaN semantics to hardware:
+        //   max(0, NaN) -> NaN
+        //   max(NaN, 0) -> 0
+        WriteDest(*op, Max(LoadSource(*op, 0), LoadSource(*op, 1)));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Min) : {
+        // NOTE: Exact form required to match NaN semantics to hardware:
+        //   min(0, NaN) -> NaN
+        //   min(NaN, 0) -> 0
+        WriteDest(*op, Min(LoadSource(*op, 0), LoadSource(*op, 1)));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Dp3) : {
+        WriteDest(*op, Splat(DotProduct(LoadSource(*op, 0), LoadSource(*op, 1), 3)));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Dp4) : {
+        WriteDest(*op, Splat(DotProduct(LoadSource(*op, 0), LoadSource(*op, 1), 4)));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Dph) : {
+        const Vec4f src1 = Select(0x7, LoadSource(*op, 0), Splat(1.0f));
+        WriteDest(*op, Splat(DotProduct(src1, LoadSource(*op, 1), 4)));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Rcp) : {
+        WriteDest(*op, Splat(1.0f / First(LoadSource(*op, 0))));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Rsq) : {
+        WriteDest(*op, Splat(1.0f / std::sqrt(First(LoadSource(*op, 0)))));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Mova) : {
+        std::array<float24, 4> src1;
+        Store(src1.data(), LoadSource(*op, 0));
+        for (int i = 0; i < 2; ++i) {
+            if ((op->dest_mask & (1 << i)) == 0)
+                continue;
+
+            // TODO: Figure out how the rounding is done on hardware
+            state.address_registers[i] = static_cast<s32>(src1[i].ToFloat32());
+        }
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Mov) : {
+        WriteDest(*op, LoadSource(*op, 0));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Sge) : {
+        WriteDest(*op, GreaterEqual(LoadSource(*op, 0), LoadSource(*op, 1)));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Slt) : {
+        WriteDest(*op, LessThan(LoadSource(*op, 0), LoadSource(*op, 1)));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Cmp) : {
+        using CompareOp = Instruction::Common::CompareOpType;
+
+        std::array<float24, 4> src1;
+        std::array<float24, 4> src2;
+        Store(src1.data(), LoadSource(*op, 0));
+        Store(src2.data(), LoadSource(*op, 1));
+        for (int i = 0; i < 2; ++i) {
+            switch (op->compare_ops[i]) {
+            case CompareOp::Equal:
+                state.conditional_code[i] = (src1[i] == src2[i]);
+                break;
+
+            case CompareOp::NotEqual:
+                state.conditional_code[i] = (src1[i] != src2[i]);
+                break;
+
+            case CompareOp::LessThan:
+                state.conditional_code[i] = (src1[i] < src2[i]);
+                break;
+
+            case CompareOp::LessEqual:
+                state.conditional_code[i] = (src1[i] <= src2[i]);
+                break;
+
+            case CompareOp::GreaterThan:
+                state.conditional_code[i] = (src1[i] > src2[i]);
+                break;
+
+            case CompareOp::GreaterEqual:
+                state.conditional_code[i] = (src1[i] >= src2[i]);
+                break;
+
+            default:
+                LOG_ERROR(HW_GPU, "Unknown compare mode {:x}",
+                          static_cast<int>(op->compare_ops[i]));
+                break;
+            }
+        }
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Ex2) : {
+        // EX2 only takes first component exp2 and writes it to all dest components
+        WriteDest(*op, Splat(std::exp2(First(LoadSource(*op, 0)))));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Lg2) : {
+        // LG2 only takes the first component log2 and writes it to all dest components
+        WriteDest(*op, Splat(std::log2(First(LoadSource(*op, 0)))));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Mad) : {
+        const Vec4f product = Mul(LoadSource(*op, 0), LoadSource(*op, 1));
+        WriteDest(*op, Add(product, LoadSource(*op, 2)));
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(End) : {
+        return;
+    }
+
+    SHADER_HANDLER(Jmpc) : {
+        if (evaluate_condition(*op)) {
+            program_counter = op->dest_offset - 1;
+        }
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Jmpu) : {
+        if (uniforms.b[op->uniform_id] == !(op->num_instructions & 1)) {
+            program_counter = op->dest_offset - 1;
+        }
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Call) : {
+        call(op->dest_offset, op->num_instructions, program_counter + 1, 0, 0);
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Callu) : {
+        if (uniforms.b[op->uniform_id]) {
+            call(op->dest_offset, op->num_instructions, program_counter + 1, 0, 0);
+        }
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Callc) : {
+        if (evaluate_condition(*op)) {
+            call(op->dest_offset, op->num_instructions, program_counter + 1, 0, 0);
+        }
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Nop) : {
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Ifu) : {
+        if (uniforms.b[op->uniform_id]) {
+            call(program_counter + 1, op->dest_offset - program_counter - 1,
+                 op->dest_offset + op->num_instructions, 0, 0);
+        } else {
+            call(op->dest_offset, op->num_instructions, op->dest_offset + op->num_instructions, 0,
+                 0);
+        }
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Ifc) : {
+        if (evaluate_condition(*op)) {
+            call(program_counter + 1, op->dest_offset - program_counter - 1,
+                 op->dest_offset + op->num_instructions, 0, 0);
+        } else {
+            call(op->dest_offset, op->num_instructions, op->dest_offset + op->num_instructions, 0,
+                 0);
+        }
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Loop) : {
+        const Common::Vec4<u8>& loop_param = uniforms.i[op->uniform_id];
+        state.address_registers[2] = loop_param.y;
+
+        call(program_counter + 1, op->dest_offset - program_counter, op->dest_offset + 1,
+             loop_param.x, loop_param.z);
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Emit) : {
+        GSEmitter* emitter = state.emitter_ptr;
+        ASSERT_MSG(emitter, "Execute EMIT on VS");
+        emitter->Emit(state.registers.output);
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(SetEmit) : {
+        const Instruction instr = {op->raw};
+        GSEmitter* emitter = state.emitter_ptr;
+        ASSERT_MSG(emitter, "Execute SETEMIT on VS");
+        emitter->vertex_id = instr.setemit.vertex_id;
+        emitter->prim_emit = instr.setemit.prim_emit != 0;
+        emitter->winding = instr.setemit.winding != 0;
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(UnhandledArithmetic) : {
+        LogUnhandled("arithmetic ", op->raw);
+        DEBUG_ASSERT(false);
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(UnhandledMultiplyAdd) : {
+        LogUnhandled("multiply-add ", op->raw);
+        SHADER_NEXT();
+    }
+
+    SHADER_HANDLER(Unhandled) : {
+        LogUnhandled("", op->raw);
+        SHADER_NEXT();
+    }
+
+#if !defined(__GNUC__)
+    }
+#endif
+}
+
+#undef SHADER_NEXT
+#undef SHADER_HANDLER
+#undef SHADER_DISPATCH
+
+} // namespace Pica::Shader
@@ -0,0 +1,32 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include "video_core/shader/shader.h"
+
+namespace Pica::Shader {
+
+/**
+ * Shader program decoded for the interpreter. Every instruction is translated once into a micro-op
+ * with its swizzles, write mask and registers resolved, so running the program doesn't look at the
+ * program code or the swizzle data again.
+ */
+class InterpreterProgram {
+public:
+    InterpreterProgram(const ProgramCode& program_code, const SwizzleData& swizzle_data);
+    ~InterpreterProgram();
+
+    /// Runs the program on the unit state, with the same results as the reference interpreter
+    void Run(const ShaderSetup& setup, UnitState& state, unsigned int entry_point) const;
+
+private:
+    struct MicroOp;
+
+    /// One micro-op for each word of the program code, so that addresses stay the same
+    std::vector<MicroOp> ops;
+};
+
+} // namespace Pica::Shader
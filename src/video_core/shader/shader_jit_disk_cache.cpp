@@ -0,0 +1,115 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <fmt/format.h>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/core.h"
+#include "core/loader/loader.h"
+#include "video_core/shader/shader_jit_disk_cache.h"
+
+namespace Pica::Shader {
+
+/// Bumped whenever the file layout changes, files with another version are discarded
+constexpr u32 JIT_DISK_CACHE_VERSION = 1;
+
+/// Number of words up to and including the last non-zero one
+template <std::size_t N>
+static u32 TrimmedLength(const std::array<u32, N>& data) {
+    const auto last = std::find_if(data.rbegin(), data.rend(), [](u32 word) { return word != 0; });
+    return static_cast<u32>(std::distance(last, data.rend()));
+}
+
+void JitDiskCache::Load(const Callback& callback) {
+    const std::string& file_path = GetPath();
+    if (file_path.empty() || !FileUtil::Exists(file_path)) {
+        return;
+    }
+
+    FileUtil::IOFile file(file_path, "rb");
+    u32 version = 0;
+    if (!file.IsOpen() || file.ReadBytes(&version, sizeof(version)) != sizeof(version) ||
+        version != JIT_DISK_CACHE_VERSION) {
+        LOG_INFO(HW_GPU, "Discarding shader JIT cache in path={}", file_path);
+        file.Close();
+        FileUtil::Delete(file_path);
+        return;
+    }
+
+    ProgramCode program_code;
+    SwizzleData swizzle_data;
+    std::size_t num_programs = 0;
+    while (true) {
+        u32 code_length = 0;
+        u32 swizzle_length = 0;
+        if (file.ReadBytes(&code_length, sizeof(code_length)) != sizeof(code_length) ||
+            file.ReadBytes(&swizzle_length, sizeof(swizzle_length)) != sizeof(swizzle_length) ||
+            code_length > program_code.size() || swizzle_length > swizzle_data.size()) {
+            break;
+        }
+
+        program_code.fill(0);
+        swizzle_data.fill(0);
+        if (file.ReadArray(program_code.data(), code_length) != code_length ||
+            file.ReadArray(swizzle_data.data(), swizzle_length) != swizzle_length) {
+            break;
+        }
+
+        callback(program_code, swizzle_data);
+        ++num_programs;
+    }
+
+    LOG_INFO(HW_GPU, "Loaded {} shader programs from the JIT cache", num_programs);
+}
+
+void JitDiskCache::Save(const ProgramCode& program_code, const SwizzleData& swizzle_data) {
+    const std::string& file_path = GetPath();
+    if (file_path.empty()) {
+        return;
+    }
+
+    const bool existed = FileUtil::Exists(file_path);
+    FileUtil::IOFile file(file_path, "ab");
+    if (!file.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Failed to open shader JIT cache in path={}", file_path);
+        return;
+    }
+    if (!existed || file.GetSize() == 0) {
+        file.WriteObject(JIT_DISK_CACHE_VERSION);
+    }
+
+    const u32 code_length = TrimmedLength(program_code);
+    const u32 swizzle_length = TrimmedLength(swizzle_data);
+    file.WriteObject(code_length);
+    file.WriteObject(swizzle_length);
+    file.WriteArray(program_code.data(), code_length);
+    file.WriteArray(swizzle_data.data(), swizzle_length);
+}
+
+const std::string& JitDiskCache::GetPath() {
+    if (path_resolved) {
+        return path;
+    }
+    path_resolved = true;
+
+    u64 program_id = 0;
+    auto& system = Core::System::GetInstance();
+    if (!system.IsPoweredOn() ||
+        system.GetAppLoader().ReadProgramId(program_id) != Loader::ResultStatus::Success ||
+        program_id == 0) {
+        return path;
+    }
+
+    const std::string dir = FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir) + "jit";
+    if (!FileUtil::CreateFullPath(dir + DIR_SEP)) {
+        LOG_ERROR(HW_GPU, "Failed to create directory={}", dir);
+        return path;
+    }
+    path = FileUtil::SanitizePath(fmt::format("{}" DIR_SEP "{:016X}.bin", dir, program_id));
+    return path;
+}
+
+} // namespace Pica::Shader
@@ -0,0 +1,37 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica::Shader {
+
+/**
+ * Stores the shader programs a title has run through the JIT on disk, so that the next session
+ * can compile all of them up front instead of stalling the first time each one is used.
+ * The compiled code itself isn't stored, since it embeds host addresses.
+ */
+class JitDiskCache {
+public:
+    using Callback = std::function<void(const ProgramCode&, const SwizzleData&)>;
+
+    /// Calls the callback for every program stored for the running title
+    void Load(const Callback& callback);
+
+    /// Appends a program to the cache of the running title
+    void Save(const ProgramCode& program_code, const SwizzleData& swizzle_data);
+
+private:
+    /// Returns the path of the cache file of the running title, empty if it has no title ID
+    const std::string& GetPath();
+
+    std::string path;
+    bool path_resolved = false;
+};
+
+} // namespace Pica::Shader
@@ -2,13 +2,43 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <optional>
+#include <vector>
+#include "common/hash.h"
+#include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_jit_x64.h"
 #include "video_core/shader/shader_jit_x64_compiler.h"
+#include "video_core/video_core.h"
 
 namespace Pica::Shader {
 
+/// Variants kept for each program, the least recently used one is replaced first
+constexpr std::size_t MAX_VARIANTS_PER_PROGRAM = 4;
+
+/// Variants compiled for a program before it falls back to the generic code for good
+constexpr u32 MAX_VARIANT_COMPILES = 16;
+
+struct JitX64Engine::CachedProgram {
+    struct Variant {
+        JitSpecialization specialization;
+        std::unique_ptr<JitShader> shader;
+    };
+
+    /// Code that reads the uniforms when it runs, valid for any of them
+    std::unique_ptr<JitShader> generic;
+
+    /// Specialised code, most recently used first
+    std::vector<Variant> variants;
+
+    /// Uniforms of the previous setup, a variant is only compiled when they repeat
+    std::optional<JitSpecialization> last_specialization;
+
+    u32 num_variant_compiles = 0;
+};
+
 JitX64Engine::JitX64Engine() = default;
 JitX64Engine::~JitX64Engine() = default;
 
@@ -16,21 +46,87 @@ void JitX64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
 
+    if (!disk_cache_loaded) {
+        disk_cache_loaded = true;
+        if (VideoCore::g_use_disk_shader_cache) {
+            LoadDiskCache();
+        }
+    }
+
     u64 code_hash = setup.GetProgramCodeHash();
     u64 swizzle_hash = setup.GetSwizzleDataHash();
 
     u64 cache_key = code_hash ^ swizzle_hash;
     auto iter = cache.find(cache_key);
     if (iter != cache.end()) {
-        setup.engine_data.cached_shader = iter->second.get();
+        setup.engine_data.cached_shader = GetShader(*iter->second, setup);
     } else {
-        auto shader = std::make_unique<JitShader>();
-        shader->Compile(&setup.program_code, &setup.swizzle_data);
-        setup.engine_data.cached_shader = shader.get();
-        cache.emplace_hint(iter, cache_key, std::move(shader));
+        auto program = std::make_unique<CachedProgram>();
+        program->generic = std::make_unique<JitShader>();
+        program->generic->Compile(&setup.program_code, &setup.swizzle_data);
+        program->last_specialization = JitSpecialization::FromSetup(setup);
+        setup.engine_data.cached_shader = program->generic.get();
+        cache.emplace_hint(iter, cache_key, std::move(program));
+
+        if (VideoCore::g_use_disk_shader_cache) {
+            disk_cache.Save(setup.program_code, setup.swizzle_data);
+        }
     }
 }
 
+const JitShader* JitX64Engine::GetShader(CachedProgram& program, const ShaderSetup& setup) {
+    if (program.num_variant_compiles > MAX_VARIANT_COMPILES) {
+        return program.generic.get();
+    }
+
+    const JitSpecialization specialization = JitSpecialization::FromSetup(setup);
+    auto& variants = program.variants;
+    const auto iter = std::find_if(variants.begin(), variants.end(), [&](const auto& variant) {
+        return variant.specialization == specialization;
+    });
+    if (iter != variants.end()) {
+        std::rotate(variants.begin(), iter, iter + 1);
+        return variants.front().shader.get();
+    }
+
+    // Uniforms that only last for a single draw aren't worth compiling for
+    const bool repeated = program.last_specialization == specialization;
+    program.last_specialization = specialization;
+    if (!repeated) {
+        return program.generic.get();
+    }
+
+    if (++program.num_variant_compiles > MAX_VARIANT_COMPILES) {
+        LOG_DEBUG(HW_GPU, "Uniforms change too often, using the generic shader code");
+        variants.clear();
+        variants.shrink_to_fit();
+        return program.generic.get();
+    }
+
+    if (variants.size() == MAX_VARIANTS_PER_PROGRAM) {
+        variants.pop_back();
+    }
+    auto shader = std::make_unique<JitShader>(MAX_SPECIALIZED_SHADER_SIZE);
+    shader->Compile(&setup.program_code, &setup.swizzle_data, &specialization);
+    variants.insert(variants.begin(), {specialization, std::move(shader)});
+    return variants.front().shader.get();
+}
+
+void JitX64Engine::LoadDiskCache() {
+    disk_cache.Load([this](const ProgramCode& program_code, const SwizzleData& swizzle_data) {
+        const u64 cache_key = ShaderSetup::ComputeProgramCodeHash(program_code) ^
+                              ShaderSetup::ComputeSwizzleDataHash(swizzle_data);
+        if (cache.count(cache_key) != 0) {
+            return;
+        }
+
+        auto program = std::make_unique<CachedProgram>();
+        program->generic = std::make_unique<JitShader>();
+        program->generic->Compile(&program_code, &swizzle_data);
+        cache.emplace(cache_key, std::move(program));
+    });
+}
+
 MICROPROFILE_DECLARE(GPU_Shader);
 
 void JitX64Engine::Run(const ShaderSetup& setup, UnitState& state) const {
@@ -42,4 +138,13 @@ void JitX64Engine::Run(const ShaderSetup& setup, UnitState& state) const {
     shader->Run(setup, state, setup.engine_data.entry_point);
 }
 
+void JitX64Engine::RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const {
+    ASSERT(setup.engine_data.cached_shader != nullptr);
+
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+    const JitShader* shader = static_cast<const JitShader*>(setup.engine_data.cached_shader);
+    shader->RunBatch(setup, states, count, setup.engine_data.entry_point);
+}
+
 } // namespace Pica::Shader
@@ -8,6 +8,7 @@
 #include <unordered_map>
 #include "common/common_types.h"
 #include "video_core/shader/shader.h"
+#include "video_core/shader/shader_jit_disk_cache.h"
 
 namespace Pica::Shader {
 
@@ -20,9 +21,20 @@ public:
 
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
+    void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count) const override;
 
 private:
-    std::unordered_map<u64, std::unique_ptr<JitShader>> cache;
+    struct CachedProgram;
+
+    /// Compiles all programs the running title used in earlier sessions
+    void LoadDiskCache();
+
+    /// Returns the code to run the program with, specialised for the uniforms of the setup
+    const JitShader* GetShader(CachedProgram& program, const ShaderSetup& setup);
+
+    std::unordered_map<u64, std::unique_ptr<CachedProgram>> cache;
+    JitDiskCache disk_cache;
+    bool disk_cache_loaded = false;
 };
 
 } // namespace Pica::Shader
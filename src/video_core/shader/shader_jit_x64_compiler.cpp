@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <nihstro/shader_bytecode.h>
 #include <smmintrin.h>
 #include <xmmintrin.h>
@@ -356,6 +357,54 @@ void JitShader::Compile_UniformCondition(Instruction instr) {
     cmp(byte[UNIFORMS + offset], 0);
 }
 
+std::optional<bool> JitShader::FoldUniformCondition(Instruction instr) const {
+    const u32 id = instr.flow_control.bool_uniform_id;
+    if (!specialization || ((specialization->dynamic_bool_uniforms >> id) & 1) != 0) {
+        return std::nullopt;
+    }
+    return ((specialization->bool_uniforms >> id) & 1) != 0;
+}
+
+bool JitShader::IsDeadOutputWrite(Instruction instr) const {
+    if (!specialization) {
+        return false;
+    }
+
+    DestRegister dest;
+    switch (instr.opcode.Value().EffectiveOpCode()) {
+    case OpCode::Id::ADD:
+    case OpCode::Id::DP3:
+    case OpCode::Id::DP4:
+    case OpCode::Id::DPH:
+    case OpCode::Id::DPHI:
+    case OpCode::Id::EX2:
+    case OpCode::Id::LG2:
+    case OpCode::Id::MUL:
+    case OpCode::Id::SGE:
+    case OpCode::Id::SGEI:
+    case OpCode::Id::SLT:
+    case OpCode::Id::SLTI:
+    case OpCode::Id::FLR:
+    case OpCode::Id::MAX:
+    case OpCode::Id::MIN:
+    case OpCode::Id::RCP:
+    case OpCode::Id::RSQ:
+    case OpCode::Id::MOV:
+        dest = instr.common.dest.Value();
+        break;
+    case OpCode::Id::MAD:
+    case OpCode::Id::MADI:
+        dest = instr.mad.dest.Value();
+        break;
+    default:
+        // Other instructions have effects besides the destination register, or none at all
+        return false;
+    }
+
+    return dest.GetRegisterType() == RegisterType::Output &&
+           ((specialization->output_mask >> dest.GetIndex()) & 1) == 0;
+}
+
 BitSet32 JitShader::PersistentCallerSavedRegs() {
     return persistent_regs & ABI_ALL_CALLER_SAVED;
 }
@@ -590,7 +639,16 @@ void JitShader::Compile_END(Instruction instr) {
     mov(dword[STATE + offsetof(UnitState, address_registers[1])], ADDROFFS_REG_1.cvt32());
     mov(dword[STATE + offsetof(UnitState, address_registers[2])], LOOPCOUNT_REG);
 
-    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 16);
+    // Continue with the next unit state until the whole batch is done. It keeps the registers,
+    // which are scaled again like the prologue does, before the flags for the jump are set.
+    shl(ADDROFFS_REG_0, 4);
+    shl(ADDROFFS_REG_1, 4);
+    shl(LOOPCOUNT_REG, 4);
+    add(STATE, static_cast<u32>(sizeof(UnitState)));
+    sub(qword[rsp], 1);
+    jnz(next_state_label, T_NEAR);
+
+    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 32);
     ret();
 }
 
@@ -623,6 +681,13 @@ void JitShader::Compile_CALLC(Instruction instr) {
 }
 
 void JitShader::Compile_CALLU(Instruction instr) {
+    if (const std::optional<bool> condition = FoldUniformCondition(instr)) {
+        if (*condition) {
+            Compile_CALL(instr);
+        }
+        return;
+    }
+
     Compile_UniformCondition(instr);
     Label b;
     jz(b);
@@ -695,13 +760,23 @@ void JitShader::Compile_IF(Instruction instr) {
                    "Backwards if-statements not supported");
     Label l_else, l_endif;
 
-    // Evaluate the "IF" condition
-    if (instr.opcode.Value() == OpCode::Id::IFU) {
-        Compile_UniformCondition(instr);
-    } else if (instr.opcode.Value() == OpCode::Id::IFC) {
-        Compile_EvaluateCondition(instr);
+    // Evaluate the "IF" condition. A specialised uniform condition leaves at most a jump over the
+    // code of the other branch, which is still compiled because jumps may lead into it.
+    const std::optional<bool> folded_condition = instr.opcode.Value() == OpCode::Id::IFU
+                                                     ? FoldUniformCondition(instr)
+                                                     : std::nullopt;
+    if (folded_condition) {
+        if (!*folded_condition) {
+            jmp(l_else, T_NEAR);
+        }
+    } else {
+        if (instr.opcode.Value() == OpCode::Id::IFU) {
+            Compile_UniformCondition(instr);
+        } else if (instr.opcode.Value() == OpCode::Id::IFC) {
+            Compile_EvaluateCondition(instr);
+        }
+        jz(l_else, T_NEAR);
     }
-    jz(l_else, T_NEAR);
 
     // Compile the code that corresponds to the condition evaluating as true
     Compile_Block(instr.flow_control.dest_offset);
@@ -727,6 +802,11 @@ void JitShader::Compile_LOOP(Instruction instr) {
                    "Backwards loops not supported");
     Compile_Assert(!looping, "Nested loops not supported");
 
+    if (specialization) {
+        Compile_SpecializedLOOP(instr);
+        return;
+    }
+
     looping = true;
 
     // This decodes the fields from the integer uniform at index instr.flow_control.int_uniform_id.
@@ -758,7 +838,92 @@ void JitShader::Compile_LOOP(Instruction instr) {
     looping = false;
 }
 
+void JitShader::Compile_SpecializedLOOP(Instruction instr) {
+    looping = true;
+
+    // Same fields as in Compile_LOOP, known while compiling
+    const u32 uniform = specialization->int_uniforms[instr.flow_control.int_uniform_id];
+    const u32 iterations = (uniform & 0xFF) + 1;
+    const u32 start = ((uniform >> 8) & 0xFF) << 4;
+    const u32 increment = ((uniform >> 16) & 0xFF) << 4;
+    mov(LOOPCOUNT_REG, start);
+
+    const unsigned body_begin = program_counter;
+    const unsigned body_end = instr.flow_control.dest_offset + 1;
+    const std::size_t body_length = body_end - body_begin;
+
+    // Every copy of the body behaves exactly like an iteration of the loop, as long as nothing
+    // jumps into the middle of it and its if-statements end inside of it
+    const auto first_target =
+        std::lower_bound(branch_targets.begin(), branch_targets.end(), body_begin);
+    bool unrollable = body_begin < body_end &&
+                      (first_target == branch_targets.end() || *first_target >= body_end);
+    for (unsigned offset = body_begin; offset < body_end && unrollable; ++offset) {
+        const Instruction body_instr = {(*program_code)[offset]};
+        switch (body_instr.opcode.Value()) {
+        case OpCode::Id::IFU:
+        case OpCode::Id::IFC:
+            unrollable = body_instr.flow_control.dest_offset +
+                             body_instr.flow_control.num_instructions <=
+                         body_end;
+            break;
+        case OpCode::Id::LOOP:
+            unrollable = false;
+            break;
+        default:
+            break;
+        }
+    }
+    const std::size_t extra_instructions = body_length * (iterations - 1);
+    const bool unroll = unrollable && extra_instructions <= unroll_budget;
+
+    loop_break_label = Xbyak::Label();
+    if (unroll) {
+        unroll_budget -= extra_instructions;
+        for (u32 iteration = 0; iteration < iterations; ++iteration) {
+            program_counter = body_begin;
+            repeating_body = iteration != 0;
+            Compile_Block(body_end);
+            if (increment != 0) {
+                add(LOOPCOUNT_REG, increment);
+            }
+        }
+        repeating_body = false;
+    } else {
+        mov(LOOPCOUNT, iterations);
+
+        Label l_loop_start;
+        L(l_loop_start);
+
+        Compile_Block(body_end);
+
+        if (increment != 0) {
+            add(LOOPCOUNT_REG, increment);
+        }
+        sub(LOOPCOUNT, 1);
+        jnz(l_loop_start);
+    }
+    L(*loop_break_label);
+    loop_break_label.reset();
+
+    looping = false;
+}
+
 void JitShader::Compile_JMP(Instruction instr) {
+    bool inverted_condition =
+        (instr.opcode.Value() == OpCode::Id::JMPU) && (instr.flow_control.num_instructions & 1);
+
+    Label& b = instruction_labels[instr.flow_control.dest_offset];
+
+    if (instr.opcode.Value() == OpCode::Id::JMPU) {
+        if (const std::optional<bool> condition = FoldUniformCondition(instr)) {
+            if (*condition != inverted_condition) {
+                jmp(b, T_NEAR);
+            }
+            return;
+        }
+    }
+
     if (instr.opcode.Value() == OpCode::Id::JMPC)
         Compile_EvaluateCondition(instr);
     else if (instr.opcode.Value() == OpCode::Id::JMPU)
@@ -766,10 +931,6 @@ void JitShader::Compile_JMP(Instruction instr) {
     else
         UNREACHABLE();
 
-    bool inverted_condition =
-        (instr.opcode.Value() == OpCode::Id::JMPU) && (instr.flow_control.num_instructions & 1);
-
-    Label& b = instruction_labels[instr.flow_control.dest_offset];
     if (inverted_condition) {
         jz(b, T_NEAR);
     } else {
@@ -845,14 +1006,19 @@ void JitShader::Compile_NextInstr() {
         Compile_Return();
     }
 
-    L(instruction_labels[program_counter]);
+    // The labels of an unrolled loop body point at its first copy
+    if (!repeating_body) {
+        L(instruction_labels[program_counter]);
+    }
 
     Instruction instr = {(*program_code)[program_counter++]};
 
     OpCode::Id opcode = instr.opcode.Value();
     auto instr_func = instr_table[static_cast<unsigned>(opcode)];
 
-    if (instr_func) {
+    if (IsDeadOutputWrite(instr)) {
+        // Nothing reads the result
+    } else if (instr_func) {
         // JIT the instruction!
         ((*this).*instr_func)(instr);
     } else {
@@ -864,6 +1030,7 @@ void JitShader::Compile_NextInstr() {
 
 void JitShader::FindReturnOffsets() {
     return_offsets.clear();
+    branch_targets.clear();
 
     for (std::size_t offset = 0; offset < program_code->size(); ++offset) {
         Instruction instr = {(*program_code)[offset]};
@@ -874,6 +1041,11 @@ void JitShader::FindReturnOffsets() {
         case OpCode::Id::CALLU:
             return_offsets.push_back(instr.flow_control.dest_offset +
                                      instr.flow_control.num_instructions);
+            branch_targets.push_back(instr.flow_control.dest_offset);
+            break;
+        case OpCode::Id::JMPC:
+        case OpCode::Id::JMPU:
+            branch_targets.push_back(instr.flow_control.dest_offset);
             break;
         default:
             break;
@@ -882,12 +1054,16 @@ void JitShader::FindReturnOffsets() {
 
     // Sort for efficient binary search later
     std::sort(return_offsets.begin(), return_offsets.end());
+    std::sort(branch_targets.begin(), branch_targets.end());
 }
 
 void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
-                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
+                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_,
+                        const JitSpecialization* specialization_) {
     program_code = program_code_;
     swizzle_data = swizzle_data_;
+    specialization = specialization_;
+    unroll_budget = specialization ? MAX_UNROLLED_INSTRUCTIONS : 0;
 
     // Reset flow control state
     program = (CompiledShader*)getCurr();
@@ -899,11 +1075,16 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
     FindReturnOffsets();
 
     // The stack pointer is 8 modulo 16 at the entry of a procedure
-    // We reserve 16 bytes and assign a dummy value to the first 8 bytes, to catch any potential
-    // return checks (see Compile_Return) that happen in shader main routine.
-    ABI_PushRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 16);
+    // We reserve 32 bytes. The first 8 bytes count the unit states left in the batch. The second 8
+    // bytes get a dummy value, to catch any potential return checks (see Compile_Return) that
+    // happen in shader main routine. The third 8 bytes hold the start address of the program.
+    ABI_PushRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 32);
     mov(qword[rsp + 8], 0xFFFFFFFFFFFFFFFFULL);
 
+    // Spill these first, ABI_PARAM4 is the same register as UNIFORMS on Windows
+    mov(qword[rsp + 0], ABI_PARAM4);
+    mov(qword[rsp + 16], ABI_PARAM3);
+
     mov(UNIFORMS, ABI_PARAM1);
     mov(STATE, ABI_PARAM2);
 
@@ -929,25 +1110,47 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
     mov(rax, reinterpret_cast<std::size_t>(&neg));
     movaps(NEGBIT, xword[rax]);
 
-    // Jump to start of the shader program
-    jmp(ABI_PARAM3);
+    // Jump to start of the shader program. The following unit states of a batch keep the address
+    // registers and conditional codes of the previous one, just like consecutive runs on a single
+    // unit state do.
+    L(next_state_label);
+    jmp(qword[rsp + 16]);
 
     // Compile entire program
     Compile_Block(static_cast<unsigned>(program_code->size()));
 
     // Free memory that's no longer needed
+    const std::size_t max_size = specialization ? MAX_SPECIALIZED_SHADER_SIZE : MAX_SHADER_SIZE;
     program_code = nullptr;
     swizzle_data = nullptr;
+    specialization = nullptr;
     return_offsets.clear();
     return_offsets.shrink_to_fit();
+    branch_targets.clear();
+    branch_targets.shrink_to_fit();
 
     ready();
 
-    ASSERT_MSG(getSize() <= MAX_SHADER_SIZE, "Compiled a shader that exceeds the allocated size!");
+    ASSERT_MSG(getSize() <= max_size, "Compiled a shader that exceeds the allocated size!");
     LOG_DEBUG(HW_GPU, "Compiled shader size={}", getSize());
 }
 
-JitShader::JitShader() : Xbyak::CodeGenerator(MAX_SHADER_SIZE) {
+JitSpecialization JitSpecialization::FromSetup(const ShaderSetup& setup) {
+    JitSpecialization result{};
+    for (std::size_t i = 0; i < setup.uniforms.b.size(); ++i) {
+        result.bool_uniforms |= static_cast<u16>(setup.uniforms.b[i] ? 1 << i : 0);
+    }
+    // Their values may differ from the ones at SetupBatch, so they must not tell variants apart
+    result.dynamic_bool_uniforms = setup.dynamic_bool_uniforms;
+    result.bool_uniforms &= static_cast<u16>(~setup.dynamic_bool_uniforms);
+    result.output_mask = static_cast<u16>(setup.output_mask);
+    static_assert(sizeof(setup.uniforms.i) == sizeof(result.int_uniforms),
+                  "Int uniforms don't fit the specialization");
+    std::memcpy(result.int_uniforms.data(), setup.uniforms.i.data(), sizeof(result.int_uniforms));
+    return result;
+}
+
+JitShader::JitShader(std::size_t code_size) : Xbyak::CodeGenerator(code_size) {
     CompilePrelude();
 }
 
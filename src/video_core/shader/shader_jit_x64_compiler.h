@@ -24,20 +24,58 @@ namespace Pica::Shader {
 /// Memory allocated for each compiled shader
 constexpr std::size_t MAX_SHADER_SIZE = MAX_PROGRAM_CODE_LENGTH * 64;
 
+/// Instructions a specialised shader may emit in addition to the program, by unrolling loops
+constexpr std::size_t MAX_UNROLLED_INSTRUCTIONS = 1024;
+
+/// Memory allocated for each shader compiled with a JitSpecialization
+constexpr std::size_t MAX_SPECIALIZED_SHADER_SIZE =
+    MAX_SHADER_SIZE + MAX_UNROLLED_INSTRUCTIONS * 64;
+
+/**
+ * State outside of the program code that a shader can be specialised for. Bool uniform branches
+ * are resolved while compiling, apart from the dynamic ones, loops over int uniforms get a fixed
+ * iteration count and writes to output registers the pipeline doesn't read are dropped.
+ */
+struct JitSpecialization {
+    u16 bool_uniforms;               ///< One bit for each bool uniform, dynamic ones are zero
+    u16 dynamic_bool_uniforms;       ///< Bool uniforms that are tested when the shader runs
+    u16 output_mask;                 ///< Output registers read by the pipeline
+    std::array<u32, 4> int_uniforms; ///< Packed int uniforms, with X in the low byte
+
+    static JitSpecialization FromSetup(const ShaderSetup& setup);
+
+    bool operator==(const JitSpecialization& other) const {
+        return bool_uniforms == other.bool_uniforms &&
+               dynamic_bool_uniforms == other.dynamic_bool_uniforms &&
+               output_mask == other.output_mask && int_uniforms == other.int_uniforms;
+    }
+};
+
 /**
  * This class implements the shader JIT compiler. It recompiles a Pica shader program into x86_64
  * code that can be executed on the host machine directly.
  */
 class JitShader : public Xbyak::CodeGenerator {
 public:
-    JitShader();
+    explicit JitShader(std::size_t code_size = MAX_SHADER_SIZE);
 
     void Run(const ShaderSetup& setup, UnitState& state, unsigned offset) const {
-        program(&setup.uniforms, &state, instruction_labels[offset].getAddress());
+        program(&setup.uniforms, &state, instruction_labels[offset].getAddress(), 1);
+    }
+
+    /// Runs the program for an array of unit states in a single call, see ShaderEngine::RunBatch
+    void RunBatch(const ShaderSetup& setup, UnitState* states, std::size_t count,
+                  unsigned offset) const {
+        program(&setup.uniforms, states, instruction_labels[offset].getAddress(), count);
     }
 
+    /**
+     * Compiles the program. Without a specialization the code reads the bool and int uniforms
+     * when it runs, otherwise it is only valid for uniforms and output masks that match it.
+     */
     void Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code,
-                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data);
+                 const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data,
+                 const JitSpecialization* specialization = nullptr);
 
     void Compile_ADD(Instruction instr);
     void Compile_DP3(Instruction instr);
@@ -86,6 +124,15 @@ private:
     void Compile_EvaluateCondition(Instruction instr);
     void Compile_UniformCondition(Instruction instr);
 
+    /// Returns the value of the bool uniform tested by the instruction, if it is specialised
+    std::optional<bool> FoldUniformCondition(Instruction instr) const;
+
+    /// Returns true if the instruction only writes output registers the pipeline doesn't read
+    bool IsDeadOutputWrite(Instruction instr) const;
+
+    /// Compiles a LOOP whose int uniform is specialised, unrolling it when the body allows it
+    void Compile_SpecializedLOOP(Instruction instr);
+
     /**
      * Emits the code to conditionally return from a subroutine envoked by the `CALL` instruction.
      */
@@ -102,7 +149,8 @@ private:
 
     /**
      * Analyzes the entire shader program for `CALL` instructions before emitting any code,
-     * identifying the locations where a return needs to be inserted.
+     * identifying the locations where a return needs to be inserted. Also collects the targets of
+     * calls and jumps, which keep loops around them from being unrolled.
      */
     void FindReturnOffsets();
 
@@ -126,12 +174,26 @@ private:
     /// Offsets in code where a return needs to be inserted
     std::vector<unsigned> return_offsets;
 
+    /// Offsets in code that calls and jumps can enter at, sorted
+    std::vector<unsigned> branch_targets;
+
+    /// Uniform values the program is being compiled for, null for the generic code
+    const JitSpecialization* specialization = nullptr;
+
+    /// Instructions that loop unrolling may still emit in addition to the program
+    std::size_t unroll_budget = 0;
+
     unsigned program_counter = 0; ///< Offset of the next instruction to decode
     bool looping = false;         ///< True if compiling a loop, used to check for nested loops
+    bool repeating_body = false;  ///< True if compiling another copy of an unrolled loop body
 
-    using CompiledShader = void(const void* setup, void* state, const u8* start_addr);
+    using CompiledShader = void(const void* setup, void* state, const u8* start_addr,
+                                std::size_t count);
     CompiledShader* program = nullptr;
 
+    /// Label at which the program starts over for the next unit state of a batch
+    Xbyak::Label next_state_label;
+
     Xbyak::Label log2_subroutine;
     Xbyak::Label exp2_subroutine;
 };
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstddef>
 #include <boost/container/static_vector.hpp>
 #include "common/bit_field.h"
@@ -15,6 +16,11 @@
 #include "video_core/shader/shader.h"
 #include "video_core/swrasterizer/clipper.h"
 #include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/swrasterizer/tile_binner.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#endif
 
 using Pica::Rasterizer::Vertex;
 
@@ -29,11 +35,11 @@ public:
                                                                     float24::FromFloat32(0)))
         : coeffs(coeffs), bias(bias) {}
 
-    bool IsInside(const Vertex& vertex) const {
+    bool IsInside(const OutputVertex& vertex) const {
         return Common::Dot(vertex.pos + bias, coeffs) >= float24::FromFloat32(0);
     }
 
-    bool IsOutSide(const Vertex& vertex) const {
+    bool IsOutSide(const OutputVertex& vertex) const {
         return !IsInside(vertex);
     }
 
@@ -51,22 +57,104 @@ private:
     Common::Vec4<float24> bias;
 };
 
-static void InitScreenCoordinates(Vertex& vtx) {
-    struct {
-        float24 halfsize_x;
-        float24 offset_x;
-        float24 halfsize_y;
-        float24 offset_y;
-        float24 zscale;
-        float24 offset_z;
-    } viewport;
-
-    const auto& regs = g_state.regs;
-    viewport.halfsize_x = float24::FromRaw(regs.rasterizer.viewport_size_x);
-    viewport.halfsize_y = float24::FromRaw(regs.rasterizer.viewport_size_y);
-    viewport.offset_x = float24::FromFloat32(static_cast<float>(regs.rasterizer.viewport_corner.x));
-    viewport.offset_y = float24::FromFloat32(static_cast<float>(regs.rasterizer.viewport_corner.y));
+// NOTE: We clip against a w=epsilon plane to guarantee that the output has a positive w value.
+// TODO: Not sure if this is a valid approach. Also should probably instead use the smallest
+//       epsilon possible within float24 accuracy.
+static const float24 EPSILON = float24::FromFloat32(0.00001f);
+
+/// Number of fixed clipping planes of the view volume
+constexpr std::size_t NUM_CLIPPING_EDGES = 7;
+
+/// Mask of the clipping edges a vertex is outside of, in the order of the edges in ProcessTriangle
+using Outcode = u32;
+
+/// Bit of the user defined clipping plane in an outcode
+constexpr Outcode CUSTOM_EDGE_BIT = 1 << NUM_CLIPPING_EDGES;
+
+/**
+ * Computes the outcode of the view volume planes. Each plane evaluates to the same value as the
+ * dot product of ClippingEdge, whose zero coefficients drop out. A NaN in any coordinate makes
+ * that dot product NaN, which puts the vertex outside of every plane.
+ */
+[[maybe_unused]] static Outcode ComputeOutcodeGeneric(const Common::Vec4<float24>& pos) {
+    const float x = pos.x.ToFloat32();
+    const float y = pos.y.ToFloat32();
+    const float z = pos.z.ToFloat32();
+    const float w = pos.w.ToFloat32();
+    if (std::isnan(x) || std::isnan(y) || std::isnan(z) || std::isnan(w))
+        return (1 << NUM_CLIPPING_EDGES) - 1;
+
+    const std::array<float, NUM_CLIPPING_EDGES> distances{
+        w - x, w + x, w - y, w + y, -z, w + z, w + EPSILON.ToFloat32(),
+    };
+    Outcode outcode = 0;
+    for (std::size_t i = 0; i < distances.size(); ++i) {
+        if (!(distances[i] >= 0.0f))
+            outcode |= 1 << i;
+    }
+    return outcode;
+}
+
+#if defined(ARCHITECTURE_x86_64)
+
+static Outcode ComputeOutcodeSSE2(const Common::Vec4<float24>& pos) {
+    static_assert(sizeof(pos) == 4 * sizeof(float));
+    const __m128 xyzw = _mm_loadu_ps(reinterpret_cast<const float*>(&pos));
+    if (_mm_movemask_ps(_mm_cmpunord_ps(xyzw, xyzw)) != 0)
+        return (1 << NUM_CLIPPING_EDGES) - 1;
+
+    const __m128 negate_02 = _mm_castsi128_ps(_mm_set_epi32(0, INT32_MIN, 0, INT32_MIN));
+    const __m128 negate_0 = _mm_castsi128_ps(_mm_set_epi32(0, 0, 0, INT32_MIN));
+    const __m128 lane_1 = _mm_castsi128_ps(_mm_set_epi32(0, 0, -1, 0));
+    const __m128 w = _mm_shuffle_ps(xyzw, xyzw, _MM_SHUFFLE(3, 3, 3, 3));
+
+    // (w - x, w + x, w - y, w + y)
+    const __m128 xxyy = _mm_shuffle_ps(xyzw, xyzw, _MM_SHUFFLE(1, 1, 0, 0));
+    const __m128 xy_planes = _mm_add_ps(w, _mm_xor_ps(xxyy, negate_02));
+
+    // (-z, w + z, w + epsilon, unused)
+    const __m128 zzww = _mm_shuffle_ps(xyzw, xyzw, _MM_SHUFFLE(3, 3, 2, 2));
+    const __m128 offsets =
+        _mm_add_ps(_mm_and_ps(w, lane_1), _mm_set_ps(0.0f, EPSILON.ToFloat32(), 0.0f, 0.0f));
+    const __m128 zw_planes = _mm_add_ps(offsets, _mm_xor_ps(zzww, negate_0));
+
+    const __m128 zero = _mm_setzero_ps();
+    const int inside = _mm_movemask_ps(_mm_cmpge_ps(xy_planes, zero)) |
+                       (_mm_movemask_ps(_mm_cmpge_ps(zw_planes, zero)) << 4);
+    return ~static_cast<Outcode>(inside) & ((1 << NUM_CLIPPING_EDGES) - 1);
+}
+
+#endif
+
+static Outcode ComputeOutcode(const Common::Vec4<float24>& pos) {
+#if defined(ARCHITECTURE_x86_64)
+    return ComputeOutcodeSSE2(pos);
+#else
+    return ComputeOutcodeGeneric(pos);
+#endif
+}
+
+/// Viewport transform of the current registers, read once for a whole batch of vertices
+struct Viewport {
+    float24 halfsize_x;
+    float24 offset_x;
+    float24 halfsize_y;
+    float24 offset_y;
+
+    static Viewport FromRegisters() {
+        const auto& regs = g_state.regs;
+        Viewport viewport;
+        viewport.halfsize_x = float24::FromRaw(regs.rasterizer.viewport_size_x);
+        viewport.halfsize_y = float24::FromRaw(regs.rasterizer.viewport_size_y);
+        viewport.offset_x =
+            float24::FromFloat32(static_cast<float>(regs.rasterizer.viewport_corner.x));
+        viewport.offset_y =
+            float24::FromFloat32(static_cast<float>(regs.rasterizer.viewport_corner.y));
+        return viewport;
+    }
+};
 
+static void InitScreenCoordinates(Vertex& vtx, const Viewport& viewport) {
     float24 inv_w = float24::FromFloat32(1.f) / vtx.pos.w;
     vtx.pos.w = inv_w;
     vtx.quat *= inv_w;
@@ -84,7 +172,15 @@ static void InitScreenCoordinates(Vertex& vtx) {
     vtx.screenpos[2] = vtx.pos.z * inv_w;
 }
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+static void FlipQuaternionIfOpposite(Common::Vec4<float24>& a, const Common::Vec4<float24>& b) {
+    if (Common::Dot(a, b) < float24::Zero())
+        a = a * float24::FromFloat32(-1.0f);
+}
+
+/// Clips the triangle against the edges set in the mask and queues the results in the binner
+static void ClipTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                         Outcode edge_mask, const Viewport& viewport,
+                         Rasterizer::TileBinner& binner) {
     using boost::container::static_vector;
 
     // Clipping a planar n-gon against a plane will remove at least 1 vertex and introduces 2 at
@@ -95,11 +191,6 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
     static_vector<Vertex, MAX_VERTICES> buffer_a = {v0, v1, v2};
     static_vector<Vertex, MAX_VERTICES> buffer_b;
 
-    auto FlipQuaternionIfOpposite = [](auto& a, const auto& b) {
-        if (Common::Dot(a, b) < float24::Zero())
-            a = a * float24::FromFloat32(-1.0f);
-    };
-
     // Flip the quaternions if they are opposite to prevent interpolating them over the wrong
     // direction.
     FlipQuaternionIfOpposite(buffer_a[1].quat, buffer_a[0].quat);
@@ -108,13 +199,9 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
     auto* output_list = &buffer_a;
     auto* input_list = &buffer_b;
 
-    // NOTE: We clip against a w=epsilon plane to guarantee that the output has a positive w value.
-    // TODO: Not sure if this is a valid approach. Also should probably instead use the smallest
-    //       epsilon possible within float24 accuracy.
-    static const float24 EPSILON = float24::FromFloat32(0.00001f);
     static const float24 f0 = float24::FromFloat32(0.0);
     static const float24 f1 = float24::FromFloat32(1.0);
-    static const std::array<ClippingEdge, 7> clipping_edges = {{
+    static const std::array<ClippingEdge, NUM_CLIPPING_EDGES> clipping_edges = {{
         {Common::MakeVec(-f1, f0, f0, f1)}, // x = +w
         {Common::MakeVec(f1, f0, f0, f1)},  // x = -w
         {Common::MakeVec(f0, -f1, f0, f1)}, // y = +w
@@ -148,15 +235,19 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
         }
     };
 
-    for (auto edge : clipping_edges) {
-        Clip(edge);
+    // Clipping against an edge that all vertices are inside of doesn't change the polygon
+    for (std::size_t i = 0; i < clipping_edges.size(); ++i) {
+        if ((edge_mask & (1 << i)) == 0)
+            continue;
+
+        Clip(clipping_edges[i]);
 
         // Need to have at least a full triangle to continue...
         if (output_list->size() < 3)
             return;
     }
 
-    if (g_state.regs.rasterizer.clip_enable) {
+    if (edge_mask & CUSTOM_EDGE_BIT) {
         ClippingEdge custom_edge{g_state.regs.rasterizer.GetClipCoef()};
         Clip(custom_edge);
 
@@ -164,15 +255,15 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
             return;
     }
 
-    InitScreenCoordinates((*output_list)[0]);
-    InitScreenCoordinates((*output_list)[1]);
+    InitScreenCoordinates((*output_list)[0], viewport);
+    InitScreenCoordinates((*output_list)[1], viewport);
 
     for (std::size_t i = 0; i < output_list->size() - 2; i++) {
         Vertex& vtx0 = (*output_list)[0];
         Vertex& vtx1 = (*output_list)[i + 1];
         Vertex& vtx2 = (*output_list)[i + 2];
 
-        InitScreenCoordinates(vtx2);
+        InitScreenCoordinates(vtx2, viewport);
 
         LOG_TRACE(
             Render_Software,
@@ -189,7 +280,60 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
             vtx2.screenpos.x.ToFloat32(), vtx2.screenpos.y.ToFloat32(),
             vtx2.screenpos.z.ToFloat32());
 
-        Rasterizer::ProcessTriangle(vtx0, vtx1, vtx2);
+        binner.AddTriangle(vtx0, vtx1, vtx2);
+    }
+}
+
+/// Register state shared by all triangles of a batch
+struct BatchState {
+    Viewport viewport = Viewport::FromRegisters();
+    bool clip_enable = g_state.regs.rasterizer.clip_enable != 0;
+    ClippingEdge custom_edge{g_state.regs.rasterizer.GetClipCoef()};
+};
+
+static void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1,
+                            const OutputVertex& v2, const BatchState& state,
+                            Rasterizer::TileBinner& binner) {
+    const std::array<const OutputVertex*, 3> vertices{&v0, &v1, &v2};
+    std::array<Outcode, 3> outcodes;
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        outcodes[i] = ComputeOutcode(vertices[i]->pos);
+        if (state.clip_enable && state.custom_edge.IsOutSide(*vertices[i]))
+            outcodes[i] |= CUSTOM_EDGE_BIT;
+    }
+
+    // All vertices outside of the same plane, nothing is left after clipping
+    if ((outcodes[0] & outcodes[1] & outcodes[2]) != 0)
+        return;
+
+    const Outcode edge_mask = outcodes[0] | outcodes[1] | outcodes[2];
+    if (edge_mask != 0) {
+        ClipTriangle(v0, v1, v2, edge_mask, state.viewport, binner);
+        return;
+    }
+
+    // Entirely inside, which gives the same triangle as clipping would
+    Vertex vtx0{v0};
+    Vertex vtx1{v1};
+    Vertex vtx2{v2};
+    FlipQuaternionIfOpposite(vtx1.quat, vtx0.quat);
+    FlipQuaternionIfOpposite(vtx2.quat, vtx0.quat);
+    InitScreenCoordinates(vtx0, state.viewport);
+    InitScreenCoordinates(vtx1, state.viewport);
+    InitScreenCoordinates(vtx2, state.viewport);
+    binner.AddTriangle(vtx0, vtx1, vtx2);
+}
+
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     Rasterizer::TileBinner& binner) {
+    ProcessTriangle(v0, v1, v2, BatchState{}, binner);
+}
+
+void ProcessTriangles(const OutputVertex* vertices, std::size_t num_triangles,
+                      Rasterizer::TileBinner& binner) {
+    const BatchState state;
+    for (std::size_t i = 0; i < num_triangles; ++i) {
+        ProcessTriangle(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2], state, binner);
     }
 }
 
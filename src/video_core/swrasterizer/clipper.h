@@ -4,16 +4,32 @@
 
 #pragma once
 
+#include <cstddef>
+
 namespace Pica {
 namespace Shader {
 struct OutputVertex;
 }
 
+namespace Rasterizer {
+class TileBinner;
+}
+
 namespace Clipper {
 
 using Shader::OutputVertex;
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
+/// Clips the triangle against the view volume and queues the resulting triangles in the binner
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     Rasterizer::TileBinner& binner);
+
+/**
+ * Processes a batch of triangles, given as three consecutive vertices each. Triangles entirely
+ * inside the view volume skip clipping, triangles entirely outside one of its planes are dropped,
+ * and the others are only clipped against the planes they cross.
+ */
+void ProcessTriangles(const OutputVertex* vertices, std::size_t num_triangles,
+                      Rasterizer::TileBinner& binner);
 
 } // namespace Clipper
 } // namespace Pica
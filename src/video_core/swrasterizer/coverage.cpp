@@ -0,0 +1,172 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "video_core/swrasterizer/coverage.h"
+
+#if defined(ARCHITECTURE_x86_64)
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#elif defined(ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+#if defined(ARCHITECTURE_x86_64) && !defined(_MSC_VER)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace Pica::Rasterizer {
+
+// All kernels step the edge functions by -dy * 16 per pixel instead of evaluating the products
+// for every pixel. In two's complement this gives the exact same results as the scalar formula.
+
+static int EvaluateEdge(const EdgeFunction& edge, int x, int y) {
+    return edge.bias + (edge.dx * (y - edge.ay) - edge.dy * (x - edge.ax));
+}
+
+static u32 CountMask(u32 count) {
+    return count >= 32 ? 0xFFFFFFFF : (1U << count) - 1;
+}
+
+[[maybe_unused]] static u32 ComputeSpanCoverageGeneric(const std::array<EdgeFunction, 3>& edges,
+                                                       int x, int y, u32 count,
+                                                       SpanWeights& weights) {
+    u32 mask = 0;
+    for (u32 i = 0; i < count; ++i) {
+        const int pixel_x = x + static_cast<int>(i) * 16;
+        const int w0 = weights.w0[i] = EvaluateEdge(edges[0], pixel_x, y);
+        const int w1 = weights.w1[i] = EvaluateEdge(edges[1], pixel_x, y);
+        const int w2 = weights.w2[i] = EvaluateEdge(edges[2], pixel_x, y);
+        if (w0 >= 0 && w1 >= 0 && w2 >= 0) {
+            mask |= 1U << i;
+        }
+    }
+    return mask;
+}
+
+#if defined(ARCHITECTURE_x86_64)
+
+static u32 ComputeSpanCoverageSSE2(const std::array<EdgeFunction, 3>& edges, int x, int y,
+                                   u32 count, SpanWeights& weights) {
+    __m128i w[3];
+    __m128i step[3];
+    for (std::size_t e = 0; e < 3; ++e) {
+        const int base = EvaluateEdge(edges[e], x, y);
+        const int pixel_step = -edges[e].dy * 16;
+        w[e] = _mm_set_epi32(base + 3 * pixel_step, base + 2 * pixel_step, base + pixel_step,
+                             base);
+        step[e] = _mm_set1_epi32(4 * pixel_step);
+    }
+
+    u32 mask = 0;
+    for (u32 i = 0; i < count; i += 4) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(&weights.w0[i]), w[0]);
+        _mm_store_si128(reinterpret_cast<__m128i*>(&weights.w1[i]), w[1]);
+        _mm_store_si128(reinterpret_cast<__m128i*>(&weights.w2[i]), w[2]);
+
+        // A pixel is covered unless the sign bit of any of its weights is set
+        const __m128i outside = _mm_or_si128(_mm_or_si128(w[0], w[1]), w[2]);
+        const u32 outside_mask =
+            static_cast<u32>(_mm_movemask_ps(_mm_castsi128_ps(outside)));
+        mask |= (~outside_mask & 0xF) << i;
+
+        for (std::size_t e = 0; e < 3; ++e) {
+            w[e] = _mm_add_epi32(w[e], step[e]);
+        }
+    }
+    return mask & CountMask(count);
+}
+
+TARGET_AVX2 static u32 ComputeSpanCoverageAVX2(const std::array<EdgeFunction, 3>& edges, int x,
+                                               int y, u32 count, SpanWeights& weights) {
+    const __m256i lane = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    __m256i w[3];
+    __m256i step[3];
+    for (std::size_t e = 0; e < 3; ++e) {
+        const int base = EvaluateEdge(edges[e], x, y);
+        const int pixel_step = -edges[e].dy * 16;
+        w[e] = _mm256_add_epi32(_mm256_set1_epi32(base),
+                                _mm256_mullo_epi32(lane, _mm256_set1_epi32(pixel_step)));
+        step[e] = _mm256_set1_epi32(8 * pixel_step);
+    }
+
+    u32 mask = 0;
+    for (u32 i = 0; i < count; i += 8) {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(&weights.w0[i]), w[0]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(&weights.w1[i]), w[1]);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(&weights.w2[i]), w[2]);
+
+        const __m256i outside = _mm256_or_si256(_mm256_or_si256(w[0], w[1]), w[2]);
+        const u32 outside_mask =
+            static_cast<u32>(_mm256_movemask_ps(_mm256_castsi256_ps(outside)));
+        mask |= (~outside_mask & 0xFF) << i;
+
+        for (std::size_t e = 0; e < 3; ++e) {
+            w[e] = _mm256_add_epi32(w[e], step[e]);
+        }
+    }
+    return mask & CountMask(count);
+}
+
+#elif defined(ARCHITECTURE_ARM64)
+
+static u32 ComputeSpanCoverageNEON(const std::array<EdgeFunction, 3>& edges, int x, int y,
+                                   u32 count, SpanWeights& weights) {
+    static constexpr int32_t lane_values[4] = {0, 1, 2, 3};
+    static constexpr uint32_t lane_bits[4] = {1, 2, 4, 8};
+    const int32x4_t lane = vld1q_s32(lane_values);
+    const uint32x4_t bits = vld1q_u32(lane_bits);
+
+    int32x4_t w[3];
+    int32x4_t step[3];
+    for (std::size_t e = 0; e < 3; ++e) {
+        const int base = EvaluateEdge(edges[e], x, y);
+        const int pixel_step = -edges[e].dy * 16;
+        w[e] = vmlaq_n_s32(vdupq_n_s32(base), lane, pixel_step);
+        step[e] = vdupq_n_s32(4 * pixel_step);
+    }
+
+    u32 mask = 0;
+    for (u32 i = 0; i < count; i += 4) {
+        vst1q_s32(&weights.w0[i], w[0]);
+        vst1q_s32(&weights.w1[i], w[1]);
+        vst1q_s32(&weights.w2[i], w[2]);
+
+        const int32x4_t outside = vorrq_s32(vorrq_s32(w[0], w[1]), w[2]);
+        const uint32x4_t covered = vcgezq_s32(outside);
+        mask |= vaddvq_u32(vandq_u32(covered, bits)) << i;
+
+        for (std::size_t e = 0; e < 3; ++e) {
+            w[e] = vaddq_s32(w[e], step[e]);
+        }
+    }
+    return mask & CountMask(count);
+}
+
+#endif
+
+using SpanCoverageFunc = u32 (*)(const std::array<EdgeFunction, 3>&, int, int, u32,
+                                 SpanWeights&);
+
+static SpanCoverageFunc SelectSpanCoverageFunc() {
+#if defined(ARCHITECTURE_x86_64)
+    if (Common::GetCPUCaps().avx2) {
+        return ComputeSpanCoverageAVX2;
+    }
+    return ComputeSpanCoverageSSE2;
+#elif defined(ARCHITECTURE_ARM64)
+    return ComputeSpanCoverageNEON;
+#else
+    return ComputeSpanCoverageGeneric;
+#endif
+}
+
+u32 ComputeSpanCoverage(const std::array<EdgeFunction, 3>& edges, int x, int y, u32 count,
+                        SpanWeights& weights) {
+    static const SpanCoverageFunc func = SelectSpanCoverageFunc();
+    return func(edges, x, y, count, weights);
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,47 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/common_types.h"
+
+namespace Pica::Rasterizer {
+
+/// Maximum number of pixels in a span that coverage is computed for at once
+constexpr u32 MAX_SPAN_PIXELS = 32;
+
+/**
+ * Edge function of the triangle edge from a to b, as evaluated by the rasterizer:
+ * w(x, y) = bias + dx * (y - ay) - dy * (x - ax), with all coordinates in 12.4 fixed point.
+ */
+struct EdgeFunction {
+    int ax;
+    int ay;
+    int dx;
+    int dy;
+    int bias;
+};
+
+/// Barycentric weights of each pixel in a span
+struct SpanWeights {
+    alignas(32) std::array<int, MAX_SPAN_PIXELS> w0;
+    alignas(32) std::array<int, MAX_SPAN_PIXELS> w1;
+    alignas(32) std::array<int, MAX_SPAN_PIXELS> w2;
+};
+
+/**
+ * Evaluates the three edge functions of a triangle for a horizontal span of pixels, using the
+ * widest SIMD instruction set the host supports.
+ * @param edges Edge functions for the barycentric weights w0, w1 and w2
+ * @param x Subpixel x coordinate of the first pixel center. Consecutive pixels are 16 apart.
+ * @param y Subpixel y coordinate of the pixel centers
+ * @param count Number of pixels in the span, at most MAX_SPAN_PIXELS
+ * @param weights Receives the weights of all pixels in the span
+ * @return Mask with bit i set if pixel i is covered by the triangle
+ */
+u32 ComputeSpanCoverage(const std::array<EdgeFunction, 3>& edges, int x, int y, u32 count,
+                        SpanWeights& weights);
+
+} // namespace Pica::Rasterizer
@@ -18,7 +18,10 @@
 
 namespace Pica::Rasterizer {
 
-void DrawPixel(int x, int y, const Common::Vec4<u8>& color) {
+/// The tile bound to the calling thread, if any
+static thread_local TileFramebuffer* bound_tile = nullptr;
+
+static void WritePixelToMemory(int x, int y, const Common::Vec4<u8>& color) {
     const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
     const PAddr addr = framebuffer.GetColorBufferPhysicalAddress();
 
@@ -61,7 +64,7 @@ void DrawPixel(int x, int y, const Common::Vec4<u8>& color) {
     }
 }
 
-const Common::Vec4<u8> GetPixel(int x, int y) {
+static Common::Vec4<u8> ReadPixelFromMemory(int x, int y) {
     const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
     const PAddr addr = framebuffer.GetColorBufferPhysicalAddress();
 
@@ -99,7 +102,7 @@ const Common::Vec4<u8> GetPixel(int x, int y) {
     return {0, 0, 0, 0};
 }
 
-u32 GetDepth(int x, int y) {
+static u32 ReadDepthFromMemory(int x, int y) {
     const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
     const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
     u8* depth_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
@@ -128,7 +131,7 @@ u32 GetDepth(int x, int y) {
     }
 }
 
-u8 GetStencil(int x, int y) {
+static u8 ReadStencilFromMemory(int x, int y) {
     const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
     const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
     u8* depth_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
@@ -155,7 +158,7 @@ u8 GetStencil(int x, int y) {
     }
 }
 
-void SetDepth(int x, int y, u32 value) {
+static void WriteDepthToMemory(int x, int y, u32 value) {
     const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
     const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
     u8* depth_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
@@ -190,7 +193,7 @@ void SetDepth(int x, int y, u32 value) {
     }
 }
 
-void SetStencil(int x, int y, u8 value) {
+static void WriteStencilToMemory(int x, int y, u8 value) {
     const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
     const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
     u8* depth_buffer = VideoCore::g_memory->GetPhysicalPointer(addr);
@@ -222,6 +225,125 @@ void SetStencil(int x, int y, u8 value) {
     }
 }
 
+void TileFramebuffer::Bind(u32 x0, u32 y0, u32 x1, u32 y1) {
+    DEBUG_ASSERT(bound_tile == nullptr);
+    DEBUG_ASSERT(x1 - x0 <= MAX_SIZE && y1 - y0 <= MAX_SIZE);
+    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
+    this->x0 = x0;
+    this->y0 = y0;
+    width = std::min(x1, framebuffer.GetWidth()) - std::min(x0, framebuffer.GetWidth());
+    height = std::min(y1, framebuffer.GetHeight()) - std::min(y0, framebuffer.GetHeight());
+    color_loaded = color_dirty = false;
+    depth_loaded = depth_dirty = false;
+    bound_tile = this;
+}
+
+void TileFramebuffer::Unbind() {
+    DEBUG_ASSERT(bound_tile == this);
+    bound_tile = nullptr;
+
+    const bool has_stencil = g_state.regs.framebuffer.framebuffer.depth_format ==
+                             FramebufferRegs::DepthFormat::D24S8;
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            const u32 index = y * MAX_SIZE + x;
+            if (color_dirty)
+                WritePixelToMemory(x0 + x, y0 + y, color[index]);
+            if (depth_dirty) {
+                WriteDepthToMemory(x0 + x, y0 + y, depth[index]);
+                if (has_stencil)
+                    WriteStencilToMemory(x0 + x, y0 + y, stencil[index]);
+            }
+        }
+    }
+}
+
+bool TileFramebuffer::Contains(int x, int y) const {
+    return static_cast<u32>(x - x0) < width && static_cast<u32>(y - y0) < height;
+}
+
+void TileFramebuffer::LoadColor() {
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            color[y * MAX_SIZE + x] = ReadPixelFromMemory(x0 + x, y0 + y);
+        }
+    }
+    color_loaded = true;
+}
+
+void TileFramebuffer::LoadDepth() {
+    const bool has_stencil = g_state.regs.framebuffer.framebuffer.depth_format ==
+                             FramebufferRegs::DepthFormat::D24S8;
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            const u32 index = y * MAX_SIZE + x;
+            depth[index] = ReadDepthFromMemory(x0 + x, y0 + y);
+            stencil[index] = has_stencil ? ReadStencilFromMemory(x0 + x, y0 + y) : 0;
+        }
+    }
+    depth_loaded = true;
+}
+
+void DrawPixel(int x, int y, const Common::Vec4<u8>& color) {
+    if (bound_tile != nullptr && bound_tile->Contains(x, y)) {
+        if (!bound_tile->color_loaded)
+            bound_tile->LoadColor();
+        bound_tile->color[bound_tile->Index(x, y)] = color;
+        bound_tile->color_dirty = true;
+        return;
+    }
+    WritePixelToMemory(x, y, color);
+}
+
+const Common::Vec4<u8> GetPixel(int x, int y) {
+    if (bound_tile != nullptr && bound_tile->Contains(x, y)) {
+        if (!bound_tile->color_loaded)
+            bound_tile->LoadColor();
+        return bound_tile->color[bound_tile->Index(x, y)];
+    }
+    return ReadPixelFromMemory(x, y);
+}
+
+u32 GetDepth(int x, int y) {
+    if (bound_tile != nullptr && bound_tile->Contains(x, y)) {
+        if (!bound_tile->depth_loaded)
+            bound_tile->LoadDepth();
+        return bound_tile->depth[bound_tile->Index(x, y)];
+    }
+    return ReadDepthFromMemory(x, y);
+}
+
+u8 GetStencil(int x, int y) {
+    if (bound_tile != nullptr && bound_tile->Contains(x, y)) {
+        if (!bound_tile->depth_loaded)
+            bound_tile->LoadDepth();
+        return bound_tile->stencil[bound_tile->Index(x, y)];
+    }
+    return ReadStencilFromMemory(x, y);
+}
+
+void SetDepth(int x, int y, u32 value) {
+    if (bound_tile != nullptr && bound_tile->Contains(x, y)) {
+        if (!bound_tile->depth_loaded)
+            bound_tile->LoadDepth();
+        bound_tile->depth[bound_tile->Index(x, y)] = value;
+        bound_tile->depth_dirty = true;
+        return;
+    }
+    WriteDepthToMemory(x, y, value);
+}
+
+void SetStencil(int x, int y, u8 value) {
+    if (bound_tile != nullptr && bound_tile->Contains(x, y)) {
+        if (!bound_tile->depth_loaded)
+            bound_tile->LoadDepth();
+        bound_tile->stencil[bound_tile->Index(x, y)] = value;
+        bound_tile->depth_dirty = true;
+        return;
+    }
+    WriteStencilToMemory(x, y, value);
+}
+
 u8 PerformStencilAction(FramebufferRegs::StencilAction action, u8 old_stencil, u8 ref) {
     switch (action) {
     case FramebufferRegs::StencilAction::Keep:
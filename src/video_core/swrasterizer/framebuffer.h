@@ -4,12 +4,61 @@
 
 #pragma once
 
+#include <array>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/regs_framebuffer.h"
 
 namespace Pica::Rasterizer {
 
+/**
+ * Color and depth/stencil of a screen tile, decoded to local buffers so that the fragments of the
+ * tile don't each compute morton offsets into guest memory. While a tile is bound, the functions
+ * below use it for the pixels it contains. The buffers are loaded on first use and the modified
+ * ones are written back when the tile is unbound.
+ */
+class TileFramebuffer {
+public:
+    /// Largest width and height of a tile in pixels
+    static constexpr u32 MAX_SIZE = 32;
+
+    /// Binds the pixels from (x0, y0) to (x1, y1), exclusive, to the calling thread
+    void Bind(u32 x0, u32 y0, u32 x1, u32 y1);
+
+    /// Writes the modified buffers back to guest memory and unbinds the tile
+    void Unbind();
+
+private:
+    friend void DrawPixel(int x, int y, const Common::Vec4<u8>& color);
+    friend const Common::Vec4<u8> GetPixel(int x, int y);
+    friend u32 GetDepth(int x, int y);
+    friend u8 GetStencil(int x, int y);
+    friend void SetDepth(int x, int y, u32 value);
+    friend void SetStencil(int x, int y, u8 value);
+
+    bool Contains(int x, int y) const;
+
+    u32 Index(int x, int y) const {
+        return (y - y0) * MAX_SIZE + (x - x0);
+    }
+
+    void LoadColor();
+    void LoadDepth();
+
+    u32 x0 = 0;
+    u32 y0 = 0;
+    u32 width = 0;
+    u32 height = 0;
+    bool color_loaded = false;
+    bool color_dirty = false;
+    bool depth_loaded = false;
+    bool depth_dirty = false;
+
+    std::array<Common::Vec4<u8>, MAX_SIZE * MAX_SIZE> color;
+    std::array<u32, MAX_SIZE * MAX_SIZE> depth;
+    std::array<u8, MAX_SIZE * MAX_SIZE> stencil;
+};
+
 void DrawPixel(int x, int y, const Common::Vec4<u8>& color);
 const Common::Vec4<u8> GetPixel(int x, int y);
 u32 GetDepth(int x, int y);
@@ -4,6 +4,8 @@
 
 #include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include "common/math_util.h"
 #include "video_core/swrasterizer/proctex.h"
 
@@ -14,14 +16,14 @@ using ProcTexShift = TexturingRegs::ProcTexShift;
 using ProcTexCombiner = TexturingRegs::ProcTexCombiner;
 using ProcTexFilter = TexturingRegs::ProcTexFilter;
 
-static float LookupLUT(const std::array<State::ProcTex::ValueEntry, 128>& lut, float coord) {
+float ProcTexSampler::LookupLUT(const ValueLUT& lut, float coord) {
     // For NoiseLUT/ColorMap/AlphaMap, coord=0.0 is lut[0], coord=127.0/128.0 is lut[127] and
     // coord=1.0 is lut[127]+lut_diff[127]. For other indices, the result is interpolated using
     // value entries and difference entries.
     coord *= 128;
     const int index_int = std::min(static_cast<int>(coord), 127);
     const float frac = coord - index_int;
-    return lut[index_int].ToFloat() + frac * lut[index_int].DiffToFloat();
+    return lut.value[index_int] + frac * lut.difference[index_int];
 }
 
 // These function are used to generate random noise for procedural texture. Their results are
@@ -45,11 +47,7 @@ static float NoiseRand2D(unsigned int x, unsigned int y) {
     return -1.0f + v2 * 2.0f / 15.0f;
 }
 
-static float NoiseCoef(float u, float v, TexturingRegs regs, State::ProcTex state) {
-    const float freq_u = float16::FromRaw(regs.proctex_noise_frequency.u).ToFloat32();
-    const float freq_v = float16::FromRaw(regs.proctex_noise_frequency.v).ToFloat32();
-    const float phase_u = float16::FromRaw(regs.proctex_noise_u.phase).ToFloat32();
-    const float phase_v = float16::FromRaw(regs.proctex_noise_v.phase).ToFloat32();
+float ProcTexSampler::NoiseCoef(float u, float v) const {
     const float x = 9 * freq_u * std::abs(u + phase_u);
     const float y = 9 * freq_v * std::abs(v + phase_v);
     const int x_int = static_cast<int>(x);
@@ -61,8 +59,8 @@ static float NoiseCoef(float u, float v, TexturingRegs regs, State::ProcTex stat
     const float g1 = NoiseRand2D(x_int + 1, y_int) * (x_frac + y_frac - 1);
     const float g2 = NoiseRand2D(x_int, y_int + 1) * (x_frac + y_frac - 1);
     const float g3 = NoiseRand2D(x_int + 1, y_int + 1) * (x_frac + y_frac - 2);
-    const float x_noise = LookupLUT(state.noise_table, x_frac);
-    const float y_noise = LookupLUT(state.noise_table, y_frac);
+    const float x_noise = LookupLUT(noise_table, x_frac);
+    const float y_noise = LookupLUT(noise_table, y_frac);
     return Common::BilinearInterp(g0, g1, g2, g3, x_noise, y_noise);
 }
 
@@ -112,8 +110,8 @@ static void ClampCoord(float& coord, ProcTexClamp mode) {
     }
 }
 
-float CombineAndMap(float u, float v, ProcTexCombiner combiner,
-                    const std::array<State::ProcTex::ValueEntry, 128>& map_table) {
+float ProcTexSampler::CombineAndMap(float u, float v, ProcTexCombiner combiner,
+                                   const ValueLUT& map_table) {
     float f;
     switch (combiner) {
     case ProcTexCombiner::U:
@@ -154,64 +152,108 @@ float CombineAndMap(float u, float v, ProcTexCombiner combiner,
     return LookupLUT(map_table, f);
 }
 
-Common::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex state) {
+void ProcTexSampler::Update(const TexturingRegs& regs, const State::ProcTex& state) {
+    // The registers are consecutive words, compare them as such
+    static_assert(offsetof(TexturingRegs, proctex_lut_offset) - offsetof(TexturingRegs, proctex) ==
+                  (std::tuple_size_v<decltype(raw_regs)> - 1) * sizeof(u32));
+    const u8* const regs_begin = reinterpret_cast<const u8*>(&regs.proctex);
+    if (decoded && std::memcmp(raw_regs.data(), regs_begin, sizeof(raw_regs)) == 0 &&
+        std::memcmp(&raw_state, &state, sizeof(raw_state)) == 0) {
+        return;
+    }
+    std::memcpy(raw_regs.data(), regs_begin, sizeof(raw_regs));
+    std::memcpy(&raw_state, &state, sizeof(raw_state));
+    decoded = true;
+
+    u_clamp = regs.proctex.u_clamp;
+    v_clamp = regs.proctex.v_clamp;
+    color_combiner = regs.proctex.color_combiner;
+    alpha_combiner = regs.proctex.alpha_combiner;
+    u_shift = regs.proctex.u_shift;
+    v_shift = regs.proctex.v_shift;
+    filter = regs.proctex_lut.filter;
+    separate_alpha = regs.proctex.separate_alpha != 0;
+    noise_enable = regs.proctex.noise_enable != 0;
+    freq_u = float16::FromRaw(regs.proctex_noise_frequency.u).ToFloat32();
+    freq_v = float16::FromRaw(regs.proctex_noise_frequency.v).ToFloat32();
+    phase_u = float16::FromRaw(regs.proctex_noise_u.phase).ToFloat32();
+    phase_v = float16::FromRaw(regs.proctex_noise_v.phase).ToFloat32();
+    amplitude_u = static_cast<float>(regs.proctex_noise_u.amplitude);
+    amplitude_v = static_cast<float>(regs.proctex_noise_v.amplitude);
+    lut_offset = regs.proctex_lut_offset.level0;
+    lut_width = regs.proctex_lut.width;
+
+    const auto decode_lut = [](ValueLUT& lut,
+                               const std::array<State::ProcTex::ValueEntry, 128>& entries) {
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            lut.value[i] = entries[i].ToFloat();
+            lut.difference[i] = entries[i].DiffToFloat();
+        }
+    };
+    decode_lut(noise_table, state.noise_table);
+    decode_lut(color_map_table, state.color_map_table);
+    decode_lut(alpha_map_table, state.alpha_map_table);
+    for (std::size_t i = 0; i < color_table.size(); ++i) {
+        color_table[i] = state.color_table[i].ToVector();
+        color_value_table[i] = color_table[i].Cast<float>();
+        color_diff_table[i] = state.color_diff_table[i].ToVector().Cast<float>();
+    }
+}
+
+Common::Vec4<u8> ProcTexSampler::Sample(float u, float v) const {
     u = std::abs(u);
     v = std::abs(v);
 
     // Get shift offset before noise generation
-    const float u_shift = GetShiftOffset(v, regs.proctex.u_shift, regs.proctex.u_clamp);
-    const float v_shift = GetShiftOffset(u, regs.proctex.v_shift, regs.proctex.v_clamp);
+    const float u_shift_offset = GetShiftOffset(v, u_shift, u_clamp);
+    const float v_shift_offset = GetShiftOffset(u, v_shift, v_clamp);
 
     // Generate noise
-    if (regs.proctex.noise_enable) {
-        float noise = NoiseCoef(u, v, regs, state);
-        u += noise * regs.proctex_noise_u.amplitude / 4095.0f;
-        v += noise * regs.proctex_noise_v.amplitude / 4095.0f;
+    if (noise_enable) {
+        float noise = NoiseCoef(u, v);
+        u += noise * amplitude_u / 4095.0f;
+        v += noise * amplitude_v / 4095.0f;
         u = std::abs(u);
         v = std::abs(v);
     }
 
     // Shift
-    u += u_shift;
-    v += v_shift;
+    u += u_shift_offset;
+    v += v_shift_offset;
 
     // Clamp
-    ClampCoord(u, regs.proctex.u_clamp);
-    ClampCoord(v, regs.proctex.v_clamp);
+    ClampCoord(u, u_clamp);
+    ClampCoord(v, v_clamp);
 
     // Combine and map
-    const float lut_coord = CombineAndMap(u, v, regs.proctex.color_combiner, state.color_map_table);
+    const float lut_coord = CombineAndMap(u, v, color_combiner, color_map_table);
 
     // Look up the color
     // For the color lut, coord=0.0 is lut[offset] and coord=1.0 is lut[offset+width-1]
-    const u32 offset = regs.proctex_lut_offset.level0;
-    const u32 width = regs.proctex_lut.width;
-    const float index = offset + (lut_coord * (width - 1));
+    const float index = lut_offset + (lut_coord * (lut_width - 1));
     Common::Vec4<u8> final_color;
     // TODO(wwylele): implement mipmap
-    switch (regs.proctex_lut.filter) {
+    switch (filter) {
     case ProcTexFilter::Linear:
     case ProcTexFilter::LinearMipmapLinear:
     case ProcTexFilter::LinearMipmapNearest: {
         const int index_int = static_cast<int>(index);
         const float frac = index - index_int;
-        const auto color_value = state.color_table[index_int].ToVector().Cast<float>();
-        const auto color_diff = state.color_diff_table[index_int].ToVector().Cast<float>();
-        final_color = (color_value + frac * color_diff).Cast<u8>();
+        final_color =
+            (color_value_table[index_int] + frac * color_diff_table[index_int]).Cast<u8>();
         break;
     }
     case ProcTexFilter::Nearest:
     case ProcTexFilter::NearestMipmapLinear:
     case ProcTexFilter::NearestMipmapNearest:
-        final_color = state.color_table[static_cast<int>(std::round(index))].ToVector();
+        final_color = color_table[static_cast<int>(std::round(index))];
         break;
     }
 
-    if (regs.proctex.separate_alpha) {
+    if (separate_alpha) {
         // Note: in separate alpha mode, the alpha channel skips the color LUT look up stage. It
         // uses the output of CombineAndMap directly instead.
-        const float final_alpha =
-            CombineAndMap(u, v, regs.proctex.alpha_combiner, state.alpha_map_table);
+        const float final_alpha = CombineAndMap(u, v, alpha_combiner, alpha_map_table);
         return Common::MakeVec<u8>(final_color.rgb(), static_cast<u8>(final_alpha * 255));
     } else {
         return final_color;
@@ -2,13 +2,70 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#pragma once
+
+#include <array>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/pica_state.h"
+#include "video_core/regs_texturing.h"
 
 namespace Pica::Rasterizer {
 
-/// Generates procedural texture color for the given coordinates
-Common::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex state);
+/**
+ * Generates the procedural texture from its registers and LUTs decoded to floats. They are decoded
+ * by Update, which only does so again when the configuration changed, instead of for every
+ * fragment.
+ */
+class ProcTexSampler {
+public:
+    /// Decodes the configuration if it differs from the one of the last call
+    void Update(const TexturingRegs& regs, const State::ProcTex& state);
+
+    /// Generates procedural texture color for the given coordinates
+    Common::Vec4<u8> Sample(float u, float v) const;
+
+private:
+    struct ValueLUT {
+        std::array<float, 128> value;
+        std::array<float, 128> difference;
+    };
+
+    static float LookupLUT(const ValueLUT& lut, float coord);
+    float NoiseCoef(float u, float v) const;
+    static float CombineAndMap(float u, float v, TexturingRegs::ProcTexCombiner combiner,
+                               const ValueLUT& map_table);
+
+    /// Raw registers from proctex to proctex_lut_offset the decoded state was built from
+    std::array<u32, 6> raw_regs{};
+    /// LUTs the decoded state was built from
+    State::ProcTex raw_state{};
+    bool decoded = false;
+
+    TexturingRegs::ProcTexClamp u_clamp{};
+    TexturingRegs::ProcTexClamp v_clamp{};
+    TexturingRegs::ProcTexCombiner color_combiner{};
+    TexturingRegs::ProcTexCombiner alpha_combiner{};
+    TexturingRegs::ProcTexShift u_shift{};
+    TexturingRegs::ProcTexShift v_shift{};
+    TexturingRegs::ProcTexFilter filter{};
+    bool separate_alpha = false;
+    bool noise_enable = false;
+    float freq_u = 0.0f;
+    float freq_v = 0.0f;
+    float phase_u = 0.0f;
+    float phase_v = 0.0f;
+    float amplitude_u = 0.0f;
+    float amplitude_v = 0.0f;
+    u32 lut_offset = 0;
+    u32 lut_width = 0;
+
+    ValueLUT noise_table{};
+    ValueLUT color_map_table{};
+    ValueLUT alpha_map_table{};
+    std::array<Common::Vec4<u8>, 256> color_table{};
+    std::array<Common::Vec4<float>, 256> color_value_table{};
+    std::array<Common::Vec4<float>, 256> color_diff_table{};
+};
 
 } // namespace Pica::Rasterizer
@@ -23,10 +23,12 @@
 #include "video_core/regs_rasterizer.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/shader/shader.h"
+#include "video_core/swrasterizer/coverage.h"
 #include "video_core/swrasterizer/framebuffer.h"
 #include "video_core/swrasterizer/lighting.h"
 #include "video_core/swrasterizer/proctex.h"
 #include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/swrasterizer/texture_cache.h"
 #include "video_core/swrasterizer/texturing.h"
 #include "video_core/texture/texture_decode.h"
 #include "video_core/utils.h"
@@ -119,15 +121,52 @@ static std::tuple<float24, float24, float24, PAddr> ConvertCubeCoord(float24 u,
 
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+static bool PassesDepthTest(FramebufferRegs::CompareFunc func, u32 z, u32 ref_z) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Never:
+        return false;
+
+    case FramebufferRegs::CompareFunc::Always:
+        return true;
+
+    case FramebufferRegs::CompareFunc::Equal:
+        return z == ref_z;
+
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return z != ref_z;
+
+    case FramebufferRegs::CompareFunc::LessThan:
+        return z < ref_z;
+
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return z <= ref_z;
+
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return z > ref_z;
+
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return z >= ref_z;
+    }
+    return false;
+}
+
 /**
  * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
  * culling via recursion.
  */
+/// The procedural texture of the triangles rasterized by the calling thread
+static thread_local ProcTexSampler proctex_sampler;
+
 static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                                    const TileRect& tile, TextureCache& texture_cache,
                                     bool reversed = false) {
     const auto& regs = g_state.regs;
     MICROPROFILE_SCOPE(GPU_Rasterization);
 
+    if (regs.texturing.main_config.texture3_enable) {
+        proctex_sampler.Update(regs.texturing, g_state.proctex);
+    }
+
     // vertex positions in rasterizer coordinates
     static auto FloatToFix = [](float24 flt) {
         // TODO: Rounding here is necessary to prevent garbage pixels at
@@ -145,13 +184,13 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     if (regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepAll) {
         // Make sure we always end up with a triangle wound counter-clockwise
         if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, tile, texture_cache, true);
             return;
         }
     } else {
         if (!reversed && regs.rasterizer.cull_mode == RasterizerRegs::CullMode::KeepClockWise) {
             // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, tile, texture_cache, true);
             return;
         }
 
@@ -180,6 +219,11 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
         max_y = std::min(max_y, scissor_y2);
     }
 
+    min_x = std::max(min_x, tile.x0);
+    min_y = std::max(min_y, tile.y0);
+    max_x = std::min(max_x, tile.x1);
+    max_y = std::min(max_y, tile.y1);
+
     min_x &= Fix12P4::IntMask();
     min_y &= Fix12P4::IntMask();
     max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
@@ -210,20 +254,74 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     int bias2 =
         IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
+    auto MakeEdgeFunction = [](const Common::Vec3<Fix12P4>& a, const Common::Vec3<Fix12P4>& b,
+                               int bias) {
+        return EdgeFunction{a.x, a.y, b.x - a.x, b.y - a.y, bias};
+    };
+    const std::array<EdgeFunction, 3> edges{{
+        MakeEdgeFunction(vtxpos[1], vtxpos[2], bias0),
+        MakeEdgeFunction(vtxpos[2], vtxpos[0], bias1),
+        MakeEdgeFunction(vtxpos[0], vtxpos[1], bias2),
+    }};
+    SpanWeights span_weights;
+
     auto w_inverse = Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
 
     auto textures = regs.texturing.GetTextures();
     auto tev_stages = regs.texturing.GetTevStages();
 
+    // Decoded textures sampled by this triangle, so that the cache is only asked once for each.
+    // Unit 0 can sample the six faces of a cube map, the other two units a texture each.
+    std::array<std::shared_ptr<const DecodedTexture>, 8> decoded_textures;
+    std::size_t num_decoded_textures = 0;
+    const auto GetDecodedTexture = [&](const Texture::TextureInfo& info) -> const DecodedTexture* {
+        for (std::size_t i = 0; i < num_decoded_textures; ++i) {
+            if (decoded_textures[i]->Matches(info))
+                return decoded_textures[i].get();
+        }
+        if (num_decoded_textures == decoded_textures.size())
+            return nullptr;
+        auto texture = texture_cache.Get(info);
+        if (texture == nullptr)
+            return nullptr;
+        decoded_textures[num_decoded_textures++] = texture;
+        return texture.get();
+    };
+
     bool stencil_action_enable =
         g_state.regs.framebuffer.output_merger.stencil_test.enable &&
         g_state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
     const auto stencil_test = g_state.regs.framebuffer.output_merger.stencil_test;
 
+    // The depth test can reject fragments before they are shaded when nothing in between can
+    // discard them or has side effects. A triangle covers each pixel once, so the result is the
+    // same as testing after shading.
+    const auto& output_merger = regs.framebuffer.output_merger;
+    const bool early_depth_test =
+        output_merger.depth_test_enable && !stencil_action_enable &&
+        (!output_merger.alpha_test.enable ||
+         output_merger.alpha_test.func == FramebufferRegs::CompareFunc::Always) &&
+        output_merger.fragment_operation_mode == FramebufferRegs::FragmentOperationMode::Default;
+    // Shadow rendering doesn't use the depth buffer, so its format may not be set up
+    const unsigned num_depth_bits =
+        output_merger.fragment_operation_mode == FramebufferRegs::FragmentOperationMode::Shadow
+            ? 24
+            : FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
+
     // Enter rasterization loop, starting at the center of the topleft bounding box corner.
-    // TODO: Not sure if looping through x first might be faster
+    // Coverage is computed with SIMD for a span of pixels at a time.
     for (u16 y = min_y + 8; y < max_y; y += 0x10) {
+        u32 coverage = 0;
         for (u16 x = min_x + 8; x < max_x; x += 0x10) {
+            const u32 pixel = ((x - min_x - 8) >> 4) % MAX_SPAN_PIXELS;
+            if (pixel == 0) {
+                const u32 span_pixels = std::min<u32>(MAX_SPAN_PIXELS, (max_x - x + 0xF) >> 4);
+                coverage = ComputeSpanCoverage(edges, x, y, span_pixels, span_weights);
+            }
+
+            // If current pixel is not covered by the current primitive
+            if ((coverage & (1U << pixel)) == 0)
+                continue;
 
             // Do not process the pixel if it's inside the scissor box and the scissor mode is set
             // to Exclude
@@ -232,16 +330,12 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     continue;
             }
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
+            // The barycentric coordinates w0, w1 and w2
+            int w0 = span_weights.w0[pixel];
+            int w1 = span_weights.w1[pixel];
+            int w2 = span_weights.w2[pixel];
             int wsum = w0 + w1 + w2;
 
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
-                continue;
-
             auto baricentric_coordinates =
                 Common::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
                                 float24::FromFloat32(static_cast<float>(w1)),
@@ -272,6 +366,13 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             // Clamp the result
             depth = std::clamp(depth, 0.0f, 1.0f);
 
+            // Convert float to integer
+            u32 z = (u32)(depth * ((1 << num_depth_bits) - 1));
+
+            if (early_depth_test &&
+                !PassesDepthTest(output_merger.depth_test_func, z, GetDepth(x >> 4, y >> 4)))
+                continue;
+
             // Perspective correct attribute interpolation:
             // Attribute values cannot be calculated by simple linear interpolation since
             // they are not linear in screen space. For example, when interpolating a
@@ -404,13 +505,18 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                     t = texture.config.height - 1 -
                         GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
 
-                    const u8* texture_data =
-                        VideoCore::g_memory->GetPhysicalPointer(texture_address);
                     auto info =
                         Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
+                    info.physical_address = texture_address;
 
                     // TODO: Apply the min and mag filters to the texture
-                    texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                    if (const DecodedTexture* decoded = GetDecodedTexture(info)) {
+                        texture_color[i] = decoded->Lookup(s, t);
+                    } else {
+                        const u8* texture_data =
+                            VideoCore::g_memory->GetPhysicalPointer(texture_address);
+                        texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                    }
                 }
 
                 if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::Shadow2D ||
@@ -433,8 +539,8 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             // sample procedural texture
             if (regs.texturing.main_config.texture3_enable) {
                 const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
-                texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
-                                           g_state.regs.texturing, g_state.proctex);
+                texture_color[3] =
+                    proctex_sampler.Sample(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32());
             }
 
             // Texture environment - consists of 6 stages of color and alpha combining.
@@ -574,8 +680,6 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 }
             }
 
-            const auto& output_merger = regs.framebuffer.output_merger;
-
             if (output_merger.fragment_operation_mode ==
                 FramebufferRegs::FragmentOperationMode::Shadow) {
                 u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
@@ -719,51 +823,9 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 }
             }
 
-            // Convert float to integer
-            unsigned num_bits =
-                FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
-            u32 z = (u32)(depth * ((1 << num_bits) - 1));
-
-            if (output_merger.depth_test_enable) {
-                u32 ref_z = GetDepth(x >> 4, y >> 4);
-
-                bool pass = false;
-
-                switch (output_merger.depth_test_func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = z == ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = z != ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = z < ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = z <= ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = z > ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = z >= ref_z;
-                    break;
-                }
-
-                if (!pass) {
+            if (output_merger.depth_test_enable && !early_depth_test) {
+                if (!PassesDepthTest(output_merger.depth_test_func, z,
+                                     GetDepth(x >> 4, y >> 4))) {
                     if (stencil_action_enable)
                         UpdateStencil(stencil_test.action_depth_fail);
                     continue;
@@ -891,8 +953,14 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
     }
 }
 
-void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     TextureCache& texture_cache) {
+    ProcessTriangleInternal(v0, v1, v2, TileRect{}, texture_cache);
+}
+
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, const TileRect& tile,
+                     TextureCache& texture_cache) {
+    ProcessTriangleInternal(v0, v1, v2, tile, texture_cache);
 }
 
 } // namespace Pica::Rasterizer
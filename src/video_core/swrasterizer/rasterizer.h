@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "common/common_types.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica::Rasterizer {
@@ -39,6 +40,21 @@ struct Vertex : Shader::OutputVertex {
     }
 };
 
-void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+/// Screen area in 12.4 fixed point that a triangle is rasterized in. x1 and y1 are exclusive.
+struct TileRect {
+    u16 x0 = 0;
+    u16 y0 = 0;
+    u16 x1 = 0xFFFF;
+    u16 y1 = 0xFFFF;
+};
+
+class TextureCache;
+
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
+                     TextureCache& texture_cache);
+
+/// Rasterizes only the pixels of the triangle whose centers lie within the given tile
+void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, const TileRect& tile,
+                     TextureCache& texture_cache);
 
 } // namespace Pica::Rasterizer
@@ -2,15 +2,64 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <thread>
+#include "video_core/pica_state.h"
 #include "video_core/swrasterizer/clipper.h"
 #include "video_core/swrasterizer/swrasterizer.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/swrasterizer/tile_binner.h"
 
 namespace VideoCore {
 
+/// Upper bound for the rasterizer threads, past which the per batch overhead outweighs the gain
+constexpr unsigned MAX_RASTERIZER_THREADS = 8;
+
+SWRasterizer::SWRasterizer() {
+    // The emulation thread rasterizes tiles as well, so it counts towards the threads
+    const unsigned num_threads =
+        std::clamp(std::thread::hardware_concurrency(), 1U, MAX_RASTERIZER_THREADS);
+    texture_cache = std::make_unique<Pica::Rasterizer::TextureCache>();
+    binner = std::make_unique<Pica::Rasterizer::TileBinner>(num_threads - 1, *texture_cache);
+}
+
+SWRasterizer::~SWRasterizer() = default;
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    Pica::Clipper::ProcessTriangle(v0, v1, v2, *binner);
+}
+
+void SWRasterizer::AddTriangles(const Pica::Shader::OutputVertex* vertices,
+                                std::size_t num_triangles) {
+    Pica::Clipper::ProcessTriangles(vertices, num_triangles, *binner);
+}
+
+void SWRasterizer::DrawTriangles() {
+    binner->Flush();
+
+    // The framebuffer is written straight to guest memory, drop the textures it overwrote
+    const auto& framebuffer = Pica::g_state.regs.framebuffer.framebuffer;
+    const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+    if (framebuffer.allow_color_write != 0) {
+        texture_cache->InvalidateRegion(
+            framebuffer.GetColorBufferPhysicalAddress(),
+            num_pixels * Pica::FramebufferRegs::BytesPerColorPixel(framebuffer.color_format));
+    }
+    if (framebuffer.allow_depth_stencil_write != 0) {
+        texture_cache->InvalidateRegion(
+            framebuffer.GetDepthBufferPhysicalAddress(),
+            num_pixels * Pica::FramebufferRegs::BytesPerDepthPixel(framebuffer.depth_format));
+    }
+}
+
+void SWRasterizer::InvalidateRegion(PAddr addr, u32 size) {
+    texture_cache->InvalidateRegion(addr, size);
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    texture_cache->InvalidateRegion(addr, size);
 }
 
 } // namespace VideoCore
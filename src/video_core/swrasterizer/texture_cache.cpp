@@ -0,0 +1,126 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/microprofile.h"
+#include "core/memory.h"
+#include "video_core/swrasterizer/texture_cache.h"
+#include "video_core/texture/texture_decode.h"
+#include "video_core/video_core.h"
+
+namespace Pica::Rasterizer {
+
+/// Upper bound for the decoded texels, past which the unused textures are dropped
+constexpr std::size_t MAX_DECODED_SIZE = 64 * 1024 * 1024;
+
+bool DecodedTexture::Matches(const Texture::TextureInfo& info) const {
+    return address == info.physical_address && width == info.width && height == info.height &&
+           format == info.format;
+}
+
+TextureCache::~TextureCache() {
+    InvalidateAll();
+}
+
+MICROPROFILE_DEFINE(GPU_TextureDecode, "GPU", "Texture Decode", MP_RGB(100, 100, 240));
+std::shared_ptr<const DecodedTexture> TextureCache::Get(const Texture::TextureInfo& info) {
+    if (info.width == 0 || info.height == 0 || info.width % 8 != 0 || info.height % 8 != 0)
+        return nullptr;
+
+    std::lock_guard lock{mutex};
+    const auto range = textures.equal_range(info.physical_address);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.texture->Matches(info))
+            return it->second.texture;
+    }
+
+    const u8* source = VideoCore::g_memory->GetPhysicalPointer(info.physical_address);
+    if (source == nullptr)
+        return nullptr;
+
+    MICROPROFILE_SCOPE(GPU_TextureDecode);
+
+    auto texture = std::make_shared<DecodedTexture>();
+    texture->address = info.physical_address;
+    texture->width = info.width;
+    texture->height = info.height;
+    texture->format = info.format;
+    texture->texels.resize(info.width * info.height);
+    Texture::DecodeTexture(source, info, texture->texels.data());
+
+    const std::size_t texels_size = texture->texels.size() * sizeof(Common::Vec4<u8>);
+    if (decoded_size + texels_size > MAX_DECODED_SIZE) {
+        // Textures still in use by other threads are kept alive by their references
+        for (const auto& [address, entry] : textures) {
+            UpdatePagesCachedCount(address, entry.size, -1);
+        }
+        textures.clear();
+        decoded_size = 0;
+    }
+
+    const u32 size = static_cast<u32>(info.stride * (info.height / 8));
+    UpdatePagesCachedCount(info.physical_address, size, 1);
+    textures.emplace(info.physical_address, Entry{texture, size});
+    decoded_size += texels_size;
+    return texture;
+}
+
+void TextureCache::InvalidateRegion(PAddr addr, u32 size) {
+    std::lock_guard lock{mutex};
+    for (auto it = textures.begin(); it != textures.end();) {
+        const PAddr texture_addr = it->first;
+        const u32 texture_size = it->second.size;
+        if (texture_addr < addr + size && addr < texture_addr + texture_size) {
+            UpdatePagesCachedCount(texture_addr, texture_size, -1);
+            decoded_size -= it->second.texture->texels.size() * sizeof(Common::Vec4<u8>);
+            it = textures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TextureCache::InvalidateAll() {
+    std::lock_guard lock{mutex};
+    for (const auto& [address, entry] : textures) {
+        UpdatePagesCachedCount(address, entry.size, -1);
+    }
+    textures.clear();
+    decoded_size = 0;
+}
+
+void TextureCache::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
+    const u32 first_page = addr >> Memory::PAGE_BITS;
+    const u32 last_page = (addr + size - 1) >> Memory::PAGE_BITS;
+
+    // Pages are marked when they get their first texture and unmarked when they lose their last,
+    // in runs of consecutive pages
+    u32 run_start = first_page;
+    u32 run_length = 0;
+    const auto flush_run = [&] {
+        if (run_length != 0) {
+            VideoCore::g_memory->RasterizerMarkRegionCached(
+                run_start << Memory::PAGE_BITS, run_length << Memory::PAGE_BITS, delta > 0);
+        }
+        run_length = 0;
+    };
+
+    for (u32 page = first_page; page <= last_page; ++page) {
+        u32& count = cached_pages[page];
+        const bool transition = delta > 0 ? count == 0 : count == 1;
+        count += delta;
+        if (count == 0)
+            cached_pages.erase(page);
+
+        if (transition) {
+            if (run_length == 0)
+                run_start = page;
+            ++run_length;
+        } else {
+            flush_run();
+        }
+    }
+    flush_run();
+}
+
+} // namespace Pica::Rasterizer
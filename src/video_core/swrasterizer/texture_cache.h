@@ -0,0 +1,72 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/regs_texturing.h"
+
+namespace Pica::Texture {
+struct TextureInfo;
+} // namespace Pica::Texture
+
+namespace Pica::Rasterizer {
+
+/// A texture decoded to RGBA texels, addressed with the coordinates of Texture::LookupTexture
+struct DecodedTexture {
+    PAddr address;
+    u32 width;
+    u32 height;
+    TexturingRegs::TextureFormat format;
+    std::vector<Common::Vec4<u8>> texels;
+
+    bool Matches(const Texture::TextureInfo& info) const;
+
+    Common::Vec4<u8> Lookup(unsigned int x, unsigned int y) const {
+        return texels[y * width + x];
+    }
+};
+
+/**
+ * Keeps the textures sampled by the software rasterizer decoded, so that samples are a plain load
+ * instead of decoding the texel from tiled guest memory every time. The pages of cached textures
+ * are marked as rasterizer cached, which makes writes to them invalidate the textures.
+ */
+class TextureCache {
+public:
+    ~TextureCache();
+
+    /**
+     * Returns the decoded texture, decoding it first if it isn't cached. Safe to call from the
+     * rasterizer threads. Returns null for textures that can't be decoded as a whole.
+     */
+    std::shared_ptr<const DecodedTexture> Get(const Texture::TextureInfo& info);
+
+    /// Drops the textures overlapping the region
+    void InvalidateRegion(PAddr addr, u32 size);
+
+    /// Drops all textures
+    void InvalidateAll();
+
+private:
+    struct Entry {
+        std::shared_ptr<const DecodedTexture> texture;
+        u32 size; ///< Byte size of the texture in guest memory
+    };
+
+    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
+
+    std::mutex mutex;
+    std::unordered_multimap<PAddr, Entry> textures;
+    std::unordered_map<u32, u32> cached_pages; ///< Number of cached textures on each page
+    std::size_t decoded_size = 0;              ///< Byte size of all decoded texels
+};
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,186 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/framebuffer.h"
+#include "video_core/swrasterizer/tile_binner.h"
+
+namespace Pica::Rasterizer {
+
+/// Number of queued triangles after which the batch is flushed early to bound memory usage
+constexpr std::size_t MAX_QUEUED_TRIANGLES = 4096;
+
+static_assert(TileBinner::TILE_SIZE <= TileFramebuffer::MAX_SIZE);
+
+/// The framebuffer of the tile rasterized by the calling thread
+static thread_local TileFramebuffer tile_framebuffer;
+
+MICROPROFILE_DEFINE(GPU_RasterizerBinning, "GPU", "Rasterizer Binning", MP_RGB(50, 100, 240));
+
+TileBinner::TileBinner(std::size_t num_workers, TextureCache& texture_cache)
+    : texture_cache(texture_cache) {
+    workers.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&TileBinner::WorkerLoop, this);
+    }
+}
+
+TileBinner::~TileBinner() {
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void TileBinner::AddTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+    if (workers.empty()) {
+        ProcessTriangle(v0, v1, v2, texture_cache);
+        return;
+    }
+
+    if (triangles.size() >= MAX_QUEUED_TRIANGLES) {
+        Flush();
+    }
+
+    MICROPROFILE_SCOPE(GPU_RasterizerBinning);
+
+    if (triangles.empty()) {
+        // The framebuffer can't change within a batch, so the tile grid is set up once per batch
+        const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
+        tiles_x = std::max<u32>((framebuffer.GetWidth() + TILE_SIZE - 1) / TILE_SIZE, 1);
+        tiles_y = std::max<u32>((framebuffer.GetHeight() + TILE_SIZE - 1) / TILE_SIZE, 1);
+        bins.resize(tiles_x * tiles_y);
+    }
+
+    // Same rounding as the conversion to 12.4 fixed point in the rasterizer, so that the bounding
+    // box covers every pixel center the triangle can touch
+    const auto ToPixel = [](float24 coord) -> u32 {
+        return static_cast<u16>(std::round(coord.ToFloat32() * 16.0f)) >> 4;
+    };
+    const u32 x0 = ToPixel(v0.screenpos.x);
+    const u32 x1 = ToPixel(v1.screenpos.x);
+    const u32 x2 = ToPixel(v2.screenpos.x);
+    const u32 y0 = ToPixel(v0.screenpos.y);
+    const u32 y1 = ToPixel(v1.screenpos.y);
+    const u32 y2 = ToPixel(v2.screenpos.y);
+
+    const u32 min_tile_x = std::min(std::min({x0, x1, x2}) / TILE_SIZE, tiles_x - 1);
+    const u32 max_tile_x = std::min(std::max({x0, x1, x2}) / TILE_SIZE, tiles_x - 1);
+    const u32 min_tile_y = std::min(std::min({y0, y1, y2}) / TILE_SIZE, tiles_y - 1);
+    const u32 max_tile_y = std::min(std::max({y0, y1, y2}) / TILE_SIZE, tiles_y - 1);
+
+    const u32 index = static_cast<u32>(triangles.size());
+    triangles.push_back({v0, v1, v2});
+
+    for (u32 tile_y = min_tile_y; tile_y <= max_tile_y; ++tile_y) {
+        for (u32 tile_x = min_tile_x; tile_x <= max_tile_x; ++tile_x) {
+            const std::size_t tile_index = tile_y * tiles_x + tile_x;
+            auto& bin = bins[tile_index];
+            if (bin.empty()) {
+                used_tiles.push_back(tile_index);
+            }
+            bin.push_back(index);
+        }
+    }
+}
+
+void TileBinner::Flush() {
+    if (triangles.empty()) {
+        return;
+    }
+
+    if (used_tiles.size() == 1) {
+        // Not worth waking up the workers
+        ProcessTile(used_tiles[0]);
+    } else {
+        {
+            std::lock_guard lock{mutex};
+            next_tile = 0;
+            busy_workers = workers.size();
+            ++batch;
+        }
+        work_cv.notify_all();
+
+        // Help out instead of idling while the workers are busy
+        ProcessTiles();
+
+        std::unique_lock lock{mutex};
+        done_cv.wait(lock, [this] { return busy_workers == 0; });
+    }
+
+    for (const std::size_t tile_index : used_tiles) {
+        bins[tile_index].clear();
+    }
+    used_tiles.clear();
+    triangles.clear();
+}
+
+void TileBinner::ProcessTile(std::size_t tile_index) {
+    const u32 tile_x = static_cast<u32>(tile_index % tiles_x);
+    const u32 tile_y = static_cast<u32>(tile_index / tiles_x);
+
+    // The tiles on the edges extend to the end of the coordinate space, so that triangles
+    // reaching outside of the framebuffer are rasterized exactly like without binning
+    TileRect rect;
+    rect.x0 = static_cast<u16>(tile_x * TILE_SIZE * 16);
+    rect.y0 = static_cast<u16>(tile_y * TILE_SIZE * 16);
+    if (tile_x != tiles_x - 1) {
+        rect.x1 = static_cast<u16>((tile_x + 1) * TILE_SIZE * 16);
+    }
+    if (tile_y != tiles_y - 1) {
+        rect.y1 = static_cast<u16>((tile_y + 1) * TILE_SIZE * 16);
+    }
+
+    tile_framebuffer.Bind(tile_x * TILE_SIZE, tile_y * TILE_SIZE, (tile_x + 1) * TILE_SIZE,
+                          (tile_y + 1) * TILE_SIZE);
+    for (const u32 index : bins[tile_index]) {
+        const Triangle& triangle = triangles[index];
+        ProcessTriangle(triangle.v0, triangle.v1, triangle.v2, rect, texture_cache);
+    }
+    tile_framebuffer.Unbind();
+}
+
+void TileBinner::ProcessTiles() {
+    while (true) {
+        const std::size_t index = next_tile.fetch_add(1, std::memory_order_relaxed);
+        if (index >= used_tiles.size()) {
+            return;
+        }
+        ProcessTile(used_tiles[index]);
+    }
+}
+
+void TileBinner::WorkerLoop() {
+    Common::SetCurrentThreadName("SwRasterizer");
+    MicroProfileOnThreadCreate("SwRasterizer");
+
+    u64 last_batch = 0;
+    while (true) {
+        {
+            std::unique_lock lock{mutex};
+            work_cv.wait(lock, [this, last_batch] { return stop || batch != last_batch; });
+            if (stop) {
+                return;
+            }
+            last_batch = batch;
+        }
+
+        ProcessTiles();
+
+        std::lock_guard lock{mutex};
+        if (--busy_workers == 0) {
+            done_cv.notify_one();
+        }
+    }
+}
+
+} // namespace Pica::Rasterizer
@@ -0,0 +1,74 @@
+// Copyright 2020 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/swrasterizer/rasterizer.h"
+
+namespace Pica::Rasterizer {
+
+/**
+ * Sorts the triangles of a batch into screen tiles and rasterizes the tiles in parallel on a pool
+ * of worker threads. Triangles within a tile are rasterized in submission order, so the result is
+ * identical to rasterizing every triangle serially.
+ */
+class TileBinner {
+public:
+    /// Width and height of a tile in pixels
+    static constexpr u32 TILE_SIZE = 32;
+
+    /// Creates a binner with the given number of worker threads. Zero rasterizes immediately.
+    TileBinner(std::size_t num_workers, TextureCache& texture_cache);
+    ~TileBinner();
+
+    /// Queues a triangle in screen coordinates. It is rasterized on the next call to Flush.
+    void AddTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+
+    /**
+     * Rasterizes all queued triangles and waits until they are written to the framebuffer.
+     * Must be called before the PICA registers that the triangles were queued with change.
+     */
+    void Flush();
+
+private:
+    struct Triangle {
+        Vertex v0;
+        Vertex v1;
+        Vertex v2;
+    };
+
+    /// Rasterizes the queued triangles of a single tile
+    void ProcessTile(std::size_t tile_index);
+
+    /// Picks tiles of the current batch until there are none left
+    void ProcessTiles();
+
+    void WorkerLoop();
+
+    TextureCache& texture_cache;
+
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<u32>> bins;  ///< Triangle indices of each tile, in submission order
+    std::vector<std::size_t> used_tiles; ///< Tiles with at least one triangle in this batch
+    u32 tiles_x = 0;
+    u32 tiles_y = 0;
+
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> next_tile{0};
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    u64 batch = 0;                ///< Incremented every time a batch is handed to the workers
+    std::size_t busy_workers = 0; ///< Workers still processing the current batch
+    bool stop = false;
+};
+
+} // namespace Pica::Rasterizer
@@ -211,6 +211,25 @@ Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned in
     }
 }
 
+void DecodeTexture(const u8* source, const TextureInfo& info, Common::Vec4<u8>* dest,
+                   bool disable_alpha) {
+    DEBUG_ASSERT(info.width % 8 == 0 && info.height % 8 == 0);
+
+    const std::size_t tile_size = CalculateTileSize(info.format);
+    for (unsigned int y = 0; y < info.height; y += 8) {
+        const u8* line = source + (y / 8) * info.stride;
+        for (unsigned int x = 0; x < info.width; x += 8) {
+            const u8* tile = line + (x / 8) * tile_size;
+            for (unsigned int fine_y = 0; fine_y < 8; ++fine_y) {
+                Common::Vec4<u8>* row = dest + (y + fine_y) * info.width + x;
+                for (unsigned int fine_x = 0; fine_x < 8; ++fine_x) {
+                    row[fine_x] = LookupTexelInTile(tile, fine_x, fine_y, info, disable_alpha);
+                }
+            }
+        }
+    }
+}
+
 TextureInfo TextureInfo::FromPicaRegister(const TexturingRegs::TextureConfig& config,
                                           const TexturingRegs::TextureFormat& format) {
     TextureInfo info;
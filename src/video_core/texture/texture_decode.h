@@ -55,4 +55,15 @@ Common::Vec4<u8> LookupTexture(const u8* source, unsigned int x, unsigned int y,
 Common::Vec4<u8> LookupTexelInTile(const u8* source, unsigned int x, unsigned int y,
                                    const TextureInfo& info, bool disable_alpha);
 
+/**
+ * Decodes a whole texture to RGBA texels in the coordinates LookupTexture takes, so that
+ * dest[y * info.width + x] is the texel LookupTexture returns for (x, y).
+ * @param source Source pointer to read data from
+ * @param info TextureInfo describing the texture. Width and height must be multiples of 8.
+ * @param dest Destination with room for info.width * info.height texels
+ * @param disable_alpha Used for debugging, as in LookupTexture
+ */
+void DecodeTexture(const u8* source, const TextureInfo& info, Common::Vec4<u8>* dest,
+                   bool disable_alpha = false);
+
 } // namespace Pica::Texture
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <memory>
 #include <boost/range/algorithm/fill.hpp>
 #include "common/alignment.h"
@@ -17,6 +18,32 @@
 
 namespace Pica {
 
+namespace {
+
+template <typename T, unsigned int elements>
+void LoadAttribute(const u8* source, Common::Vec4<float24>& attribute) {
+    // Attributes of a known format and size are converted without branches, which the compiler can
+    // vectorize
+    std::array<T, elements> data;
+    std::memcpy(data.data(), source, sizeof(data));
+    for (unsigned int comp = 0; comp < elements; ++comp) {
+        attribute[comp] = float24::FromFloat32(static_cast<float>(data[comp]));
+    }
+
+    // Default attribute values set if array elements have < 4 components. This
+    // is *not* carried over from the default attribute settings even if they're
+    // enabled for this attribute.
+    for (unsigned int comp = elements; comp < 4; ++comp) {
+        attribute[comp] = comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
+    }
+}
+
+template <typename T>
+constexpr std::array<void (*)(const u8*, Common::Vec4<float24>&), 4> attribute_loaders{
+    &LoadAttribute<T, 1>, &LoadAttribute<T, 2>, &LoadAttribute<T, 3>, &LoadAttribute<T, 4>};
+
+} // Anonymous namespace
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -68,95 +95,77 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
         }
     }
 
-    is_setup = true;
-}
-
-void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
-                              Shader::AttributeBuffer& input,
-                              DebugUtils::MemoryAccessTracker& memory_accesses) {
-    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
-
     for (int i = 0; i < num_total_attributes; ++i) {
         if (vertex_attribute_elements[i] != 0) {
-            // Load per-vertex data from the loader arrays
-            u32 source_addr =
-                base_address + vertex_attribute_sources[i] + vertex_attribute_strides[i] * vertex;
-
-            if (g_debug_context && Pica::g_debug_context->recorder) {
-                memory_accesses.AddAccess(
-                    source_addr,
-                    vertex_attribute_elements[i] *
-                        ((vertex_attribute_formats[i] == PipelineRegs::VertexAttributeFormat::FLOAT)
-                             ? 4
-                             : (vertex_attribute_formats[i] ==
-                                PipelineRegs::VertexAttributeFormat::SHORT)
-                                   ? 2
-                                   : 1));
-            }
-
+            const u32 elements = vertex_attribute_elements[i];
+            ArrayAttribute& attribute = array_attributes[num_array_attributes++];
+            attribute.index = i;
+            attribute.source = vertex_attribute_sources[i];
+            attribute.stride = vertex_attribute_strides[i];
             switch (vertex_attribute_formats[i]) {
-            case PipelineRegs::VertexAttributeFormat::BYTE: {
-                const s8* srcdata = reinterpret_cast<const s8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
+            case PipelineRegs::VertexAttributeFormat::BYTE:
+                attribute.size = elements;
+                attribute.load = attribute_loaders<s8>[elements - 1];
                 break;
-            }
-            case PipelineRegs::VertexAttributeFormat::UBYTE: {
-                const u8* srcdata = reinterpret_cast<const u8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
+            case PipelineRegs::VertexAttributeFormat::UBYTE:
+                attribute.size = elements;
+                attribute.load = attribute_loaders<u8>[elements - 1];
                 break;
-            }
-            case PipelineRegs::VertexAttributeFormat::SHORT: {
-                const s16* srcdata = reinterpret_cast<const s16*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
+            case PipelineRegs::VertexAttributeFormat::SHORT:
+                attribute.size = elements * 2;
+                attribute.load = attribute_loaders<s16>[elements - 1];
                 break;
-            }
-            case PipelineRegs::VertexAttributeFormat::FLOAT: {
-                const float* srcdata = reinterpret_cast<const float*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
+            case PipelineRegs::VertexAttributeFormat::FLOAT:
+                attribute.size = elements * 4;
+                attribute.load = attribute_loaders<float>[elements - 1];
                 break;
             }
-            }
+        } else if (vertex_attribute_is_default[i]) {
+            default_attributes[num_default_attributes++] = i;
+        }
+        // TODO(yuriks): Otherwise no data gets loaded and the vertex remains with the last value
+        // it had. This isn't currently maintained as global state, however, and so won't work in
+        // Citra yet.
+    }
 
-            // Default attribute values set if array elements have < 4 components. This
-            // is *not* carried over from the default attribute settings even if they're
-            // enabled for this attribute.
-            for (unsigned int comp = vertex_attribute_elements[i]; comp < 4; ++comp) {
-                input.attr[i][comp] =
-                    comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
-            }
+    is_setup = true;
+}
 
-            LOG_TRACE(HW_GPU,
-                      "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
-                      "0x{:08x} + 0x{:08x} + 0x{:04x}: {} {} {} {}",
-                      vertex_attribute_elements[i], i, vertex, index, base_address,
-                      vertex_attribute_sources[i], vertex_attribute_strides[i] * vertex,
-                      input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
-        } else if (vertex_attribute_is_default[i]) {
-            // Load the default attribute if we're configured to do so
-            input.attr[i] = g_state.input_default_attributes.attr[i];
-            LOG_TRACE(
-                HW_GPU,
-                "Loaded default attribute {:x} for vertex {:x} (index {:x}): ({}, {}, {}, {})", i,
-                vertex, index, input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
-        } else {
-            // TODO(yuriks): In this case, no data gets loaded and the vertex
-            // remains with the last value it had. This isn't currently maintained
-            // as global state, however, and so won't work in Citra yet.
+void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
+                              Shader::AttributeBuffer& input,
+                              DebugUtils::MemoryAccessTracker& memory_accesses) {
+    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
+
+    const bool record_accesses = g_debug_context && Pica::g_debug_context->recorder;
+
+    for (int i = 0; i < num_array_attributes; ++i) {
+        // Load per-vertex data from the loader arrays
+        const ArrayAttribute& attribute = array_attributes[i];
+        const u32 source_addr = base_address + attribute.source + attribute.stride * vertex;
+        if (record_accesses) {
+            memory_accesses.AddAccess(source_addr, attribute.size);
         }
+
+        auto& attr = input.attr[attribute.index];
+        attribute.load(VideoCore::g_memory->GetPhysicalPointer(source_addr), attr);
+
+        LOG_TRACE(HW_GPU,
+                  "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
+                  "0x{:08x} + 0x{:08x} + 0x{:04x}: {} {} {} {}",
+                  vertex_attribute_elements[attribute.index], attribute.index, vertex, index,
+                  base_address, attribute.source, attribute.stride * vertex, attr[0].ToFloat32(),
+                  attr[1].ToFloat32(), attr[2].ToFloat32(), attr[3].ToFloat32());
+    }
+
+    for (int i = 0; i < num_default_attributes; ++i) {
+        // Load the default attribute if we're configured to do so
+        const int attribute = default_attributes[i];
+        input.attr[attribute] = g_state.input_default_attributes.attr[attribute];
+        LOG_TRACE(HW_GPU,
+                  "Loaded default attribute {:x} for vertex {:x} (index {:x}): ({}, {}, {}, {})",
+                  attribute, vertex, index, input.attr[attribute][0].ToFloat32(),
+                  input.attr[attribute][1].ToFloat32(), input.attr[attribute][2].ToFloat32(),
+                  input.attr[attribute][3].ToFloat32());
     }
 }
 
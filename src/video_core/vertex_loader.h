@@ -2,6 +2,8 @@
 
 #include <array>
 #include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/pica_types.h"
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -30,6 +32,24 @@ public:
     }
 
 private:
+    /// Converts the elements of an attribute to float24, filling up the missing ones
+    using AttributeLoadFunction = void (*)(const u8* source, Common::Vec4<float24>& attribute);
+
+    /// An attribute that is loaded from the vertex arrays
+    struct ArrayAttribute {
+        int index;
+        u32 source;
+        u32 stride;
+        u32 size; ///< Size of the elements in bytes
+        AttributeLoadFunction load;
+    };
+
+    /// The attributes loaded from arrays and the ones set to their default value, in index order
+    std::array<ArrayAttribute, 16> array_attributes;
+    std::array<int, 16> default_attributes;
+    int num_array_attributes = 0;
+    int num_default_attributes = 0;
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
@@ -2,11 +2,16 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <memory>
+#include <mutex>
+#include <fmt/format.h>
 #include "common/logging/log.h"
 #include "core/settings.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/renderer_base.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_vars.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
@@ -17,6 +22,7 @@
 namespace VideoCore {
 
 std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+std::unique_ptr<GPUThread> g_gpu_thread;
 
 std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
@@ -34,6 +40,20 @@ Layout::FramebufferLayout g_screenshot_framebuffer_layout;
 
 Memory::MemorySystem* g_memory;
 
+namespace {
+struct ScreenshotBurst {
+    std::string path_prefix;
+    Layout::FramebufferLayout layout;
+    std::chrono::milliseconds interval;
+    std::chrono::steady_clock::time_point next_time;
+    u32 count;
+};
+
+std::mutex screenshot_mutex;
+std::vector<ScreenshotRequest> screenshot_requests;
+std::optional<ScreenshotBurst> screenshot_burst;
+} // Anonymous namespace
+
 /// Initialize the video core
 ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory) {
     g_memory = &memory;
@@ -48,6 +68,9 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
         LOG_ERROR(Render, "initialization failed !");
     } else {
         LOG_DEBUG(Render, "initialized OK");
+        if (Settings::values.use_gpu_thread) {
+            g_gpu_thread = std::make_unique<GPUThread>(emu_window);
+        }
     }
 
     return result;
@@ -55,6 +78,9 @@ ResultStatus Init(Frontend::EmuWindow& emu_window, Memory::MemorySystem& memory)
 
 /// Shutdown the video core
 void Shutdown() {
+    // Drain and stop the GPU thread first, it may still be using the renderer
+    g_gpu_thread.reset();
+
     Pica::Shutdown();
 
     g_renderer->ShutDown();
@@ -75,6 +101,43 @@ void RequestScreenshot(void* data, std::function<void()> callback,
     g_renderer_screenshot_requested = true;
 }
 
+void RequestAsyncScreenshot(std::string path, const Layout::FramebufferLayout& layout,
+                            std::function<void(bool)> callback) {
+    std::lock_guard lock{screenshot_mutex};
+    screenshot_requests.push_back({std::move(path), layout, std::move(callback)});
+}
+
+void StartScreenshotBurst(std::string path_prefix, const Layout::FramebufferLayout& layout,
+                          std::chrono::milliseconds interval) {
+    std::lock_guard lock{screenshot_mutex};
+    screenshot_burst = ScreenshotBurst{std::move(path_prefix), layout, interval,
+                                       std::chrono::steady_clock::now(), 0};
+}
+
+void StopScreenshotBurst() {
+    std::lock_guard lock{screenshot_mutex};
+    screenshot_burst.reset();
+}
+
+std::vector<ScreenshotRequest> TakeScreenshotRequests() {
+    std::lock_guard lock{screenshot_mutex};
+    std::vector<ScreenshotRequest> requests = std::move(screenshot_requests);
+    screenshot_requests.clear();
+
+    if (screenshot_burst) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= screenshot_burst->next_time) {
+            requests.push_back({fmt::format("{}{:06}.png", screenshot_burst->path_prefix,
+                                            screenshot_burst->count++),
+                                screenshot_burst->layout, nullptr});
+            // A stall longer than the interval doesn't make up for the missed screenshots
+            screenshot_burst->next_time =
+                std::max(screenshot_burst->next_time + screenshot_burst->interval, now);
+        }
+    }
+    return requests;
+}
+
 u16 GetResolutionScaleFactor() {
     if (g_hw_renderer_enabled) {
         return Settings::values.resolution_factor
@@ -86,4 +149,26 @@ u16 GetResolutionScaleFactor() {
     }
 }
 
+// Only used by the thread running the renderer
+static u16 render_target_scale_factor = 0;
+
+u16 GetRenderTargetScaleFactor() {
+    const u16 resolution_scale_factor = GetResolutionScaleFactor();
+    if (render_target_scale_factor == 0)
+        return resolution_scale_factor;
+    return std::min(render_target_scale_factor, resolution_scale_factor);
+}
+
+void SetRenderTargetScaleFactor(u16 scale_factor) {
+    render_target_scale_factor = scale_factor;
+}
+
+std::optional<std::size_t> ExportShaderCacheBundle(u64 program_id, const std::string& path) {
+    return OpenGL::ShaderDiskCache::ExportBundle(program_id, path);
+}
+
+std::optional<std::size_t> ImportShaderCacheBundle(u64 program_id, const std::string& path) {
+    return OpenGL::ShaderDiskCache::ImportBundle(program_id, path);
+}
+
 } // namespace VideoCore
@@ -5,7 +5,12 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 #include "core/frontend/emu_window.h"
 
 namespace Frontend {
@@ -23,7 +28,10 @@ class MemorySystem;
 
 namespace VideoCore {
 
+class GPUThread;
+
 extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+extern std::unique_ptr<GPUThread> g_gpu_thread;  ///< GPU thread, null if GPU work is synchronous
 
 // TODO: Wrap these in a user settings struct along with any other graphics settings (often set from
 // qt ui)
@@ -59,6 +67,46 @@ void Shutdown();
 void RequestScreenshot(void* data, std::function<void()> callback,
                        const Layout::FramebufferLayout& layout);
 
+/// Screenshot that the renderer reads back and saves without waiting for the GPU
+struct ScreenshotRequest {
+    std::string path;
+    Layout::FramebufferLayout layout;
+    /// Called on a worker thread with whether the screenshot was saved, may be empty
+    std::function<void(bool)> callback;
+};
+
+/// Request a screenshot of the next frame, saved as a PNG to path
+void RequestAsyncScreenshot(std::string path, const Layout::FramebufferLayout& layout,
+                            std::function<void(bool)> callback = nullptr);
+
+/**
+ * Saves a screenshot every interval until StopScreenshotBurst is called, each to path_prefix
+ * followed by its number and ".png". Replaces the burst that is running, if any.
+ */
+void StartScreenshotBurst(std::string path_prefix, const Layout::FramebufferLayout& layout,
+                          std::chrono::milliseconds interval);
+
+/// Stops the burst of screenshots
+void StopScreenshotBurst();
+
+/// Returns the screenshots that are due, called by the renderer once per frame
+std::vector<ScreenshotRequest> TakeScreenshotRequests();
+
 u16 GetResolutionScaleFactor();
 
+/// Scale factor of new render targets, below the resolution scale factor while the dynamic
+/// resolution lowers it
+u16 GetRenderTargetScaleFactor();
+
+/// Sets the scale factor of new render targets, 0 uses the resolution scale factor
+void SetRenderTargetScaleFactor(u16 scale_factor);
+
+/// Exports the shader cache of a title to a bundle that can be imported on other machines and
+/// drivers. Returns the number of exported shaders, or empty on failure.
+std::optional<std::size_t> ExportShaderCacheBundle(u64 program_id, const std::string& path);
+
+/// Imports a shader cache bundle of a title. Returns the number of new shaders, or empty on
+/// failure.
+std::optional<std::size_t> ImportShaderCacheBundle(u64 program_id, const std::string& path);
+
 } // namespace VideoCore
@@ -4,7 +4,6 @@
 
 #include <future>
 #include <json.hpp>
-#include "common/detached_tasks.h"
 #include "common/logging/log.h"
 #include "web_service/announce_room_json.h"
 #include "web_service/web_backend.h"
@@ -146,11 +145,9 @@ void RoomJson::Delete() {
         LOG_ERROR(WebService, "Room must be registered to be deleted");
         return;
     }
-    Common::DetachedTasks::AddTask(
-        [host{this->host}, username{this->username}, token{this->token}, room_id{this->room_id}]() {
-            // create a new client here because the this->client might be destroyed.
-            Client{host, username, token}.DeleteJson(fmt::format("/lobby/{}", room_id), "", false);
-        });
+    // The queued request keeps its own copy of the host and credentials, so it is fine if the
+    // client is destroyed before it is sent
+    client.DeleteJsonAsync(fmt::format("/lobby/{}", room_id), "", false);
 }
 
 } // namespace WebService
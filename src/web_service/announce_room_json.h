@@ -18,7 +18,7 @@ namespace WebService {
 class RoomJson : public AnnounceMultiplayerRoom::Backend {
 public:
     RoomJson(const std::string& host, const std::string& username, const std::string& token)
-        : client(host, username, token), host(host), username(username), token(token) {}
+        : client(host, username, token) {}
     ~RoomJson() = default;
     void SetRoomInformation(const std::string& name, const std::string& description, const u16 port,
                             const u32 max_player, const u32 net_version, const bool has_password,
@@ -37,9 +37,6 @@ public:
 private:
     AnnounceMultiplayerRoom::Room room;
     Client client;
-    std::string host;
-    std::string username;
-    std::string token;
     std::string room_id;
 };
 
@@ -2,10 +2,16 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstdlib>
+#include <deque>
+#include <iterator>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include <LUrlParser.h>
 #include <fmt/format.h>
 #if defined(__ANDROID__)
@@ -13,6 +19,7 @@
 #endif
 #include <httplib.h>
 #include "common/common_types.h"
+#include "common/detached_tasks.h"
 #include "common/logging/log.h"
 #include "common/web_result.h"
 #include "web_service/web_backend.h"
@@ -39,24 +46,56 @@ struct Client::Impl {
     Common::WebResult GenericRequest(const std::string& method, const std::string& path,
                                      const std::string& data, bool allow_anonymous,
                                      const std::string& accept) {
+        return GenericRequests({{method, path, data}}, allow_anonymous, accept).front();
+    }
+
+    struct RequestInfo {
+        std::string method;
+        std::string path;
+        std::string data;
+    };
+
+    /**
+     * Sends the requests over shared connections, reusing each one for as many requests as the
+     * server keeps it alive. Returns one result per request, in the same order.
+     */
+    std::vector<Common::WebResult> GenericRequests(const std::vector<RequestInfo>& infos,
+                                                   bool allow_anonymous,
+                                                   const std::string& accept) {
         if (jwt.empty()) {
             UpdateJWT();
         }
 
         if (jwt.empty() && !allow_anonymous) {
             LOG_ERROR(WebService, "Credentials must be provided for authenticated requests");
-            return Common::WebResult{Common::WebResult::Code::CredentialsMissing,
-                                     "Credentials needed"};
+            return std::vector<Common::WebResult>(
+                infos.size(),
+                Common::WebResult{Common::WebResult::Code::CredentialsMissing,
+                                  "Credentials needed"});
         }
 
-        auto result = GenericRequest(method, path, data, accept, jwt);
-        if (result.result_string == "401") {
+        auto results = GenericRequests(infos, accept, jwt);
+
+        std::vector<std::size_t> unauthorized;
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            if (results[i].result_string == "401") {
+                unauthorized.push_back(i);
+            }
+        }
+        if (!unauthorized.empty()) {
             // Try again with new JWT
             UpdateJWT();
-            result = GenericRequest(method, path, data, accept, jwt);
+            std::vector<RequestInfo> retries;
+            for (std::size_t i : unauthorized) {
+                retries.push_back(infos[i]);
+            }
+            auto retry_results = GenericRequests(retries, accept, jwt);
+            for (std::size_t i = 0; i < unauthorized.size(); ++i) {
+                results[unauthorized[i]] = std::move(retry_results[i]);
+            }
         }
 
-        return result;
+        return results;
     }
 
     /**
@@ -65,10 +104,11 @@ struct Client::Impl {
      * username + token is used if jwt is empty but username and token are
      * not empty anonymous if all of jwt, username and token are empty
      */
-    Common::WebResult GenericRequest(const std::string& method, const std::string& path,
-                                     const std::string& data, const std::string& accept,
-                                     const std::string& jwt = "", const std::string& username = "",
-                                     const std::string& token = "") {
+    std::vector<Common::WebResult> GenericRequests(const std::vector<RequestInfo>& infos,
+                                                   const std::string& accept,
+                                                   const std::string& jwt = "",
+                                                   const std::string& username = "",
+                                                   const std::string& token = "") {
         if (cli == nullptr) {
             auto parsedUrl = LUrlParser::clParseURL::ParseURL(host);
             int port;
@@ -86,12 +126,16 @@ struct Client::Impl {
                 cli->set_timeout_sec(TIMEOUT_SECONDS);
             } else {
                 LOG_ERROR(WebService, "Bad URL scheme {}", parsedUrl.m_Scheme);
-                return Common::WebResult{Common::WebResult::Code::InvalidURL, "Bad URL scheme"};
+                return std::vector<Common::WebResult>(
+                    infos.size(),
+                    Common::WebResult{Common::WebResult::Code::InvalidURL, "Bad URL scheme"});
             }
         }
         if (cli == nullptr) {
-            LOG_ERROR(WebService, "Invalid URL {}", host + path);
-            return Common::WebResult{Common::WebResult::Code::InvalidURL, "Invalid URL"};
+            LOG_ERROR(WebService, "Invalid URL {}", host);
+            return std::vector<Common::WebResult>(
+                infos.size(),
+                Common::WebResult{Common::WebResult::Code::InvalidURL, "Invalid URL"});
         }
 
         httplib::Headers params;
@@ -108,23 +152,41 @@ struct Client::Impl {
 
         params.emplace(std::string("api-version"),
                        std::string(API_VERSION.begin(), API_VERSION.end()));
-        if (method != "GET") {
-            params.emplace(std::string("Content-Type"), std::string("application/json"));
-        };
 
-        httplib::Request request;
-        request.method = method;
-        request.path = path;
-        request.headers = params;
-        request.body = data;
-
-        httplib::Response response;
+        std::vector<httplib::Request> requests(infos.size());
+        for (std::size_t i = 0; i < infos.size(); ++i) {
+            httplib::Request& request = requests[i];
+            request.method = infos[i].method;
+            request.path = infos[i].path;
+            request.headers = params;
+            if (request.method != "GET") {
+                request.headers.emplace(std::string("Content-Type"),
+                                        std::string("application/json"));
+            }
+            request.body = infos[i].data;
+        }
 
-        if (!cli->send(request, response)) {
-            LOG_ERROR(WebService, "{} to {} returned null", method, host + path);
-            return Common::WebResult{Common::WebResult::Code::LibError, "Null response"};
+        // The responses stop at the first request that failed to get one
+        std::vector<httplib::Response> responses;
+        cli->send(requests, responses);
+
+        std::vector<Common::WebResult> results;
+        for (std::size_t i = 0; i < infos.size(); ++i) {
+            const std::string& method = infos[i].method;
+            const std::string& path = infos[i].path;
+            if (i >= responses.size()) {
+                LOG_ERROR(WebService, "{} to {} returned null", method, host + path);
+                results.push_back(
+                    Common::WebResult{Common::WebResult::Code::LibError, "Null response"});
+            } else {
+                results.push_back(CheckResponse(method, path, responses[i], accept));
+            }
         }
+        return results;
+    }
 
+    Common::WebResult CheckResponse(const std::string& method, const std::string& path,
+                                    const httplib::Response& response, const std::string& accept) {
         if (response.status >= 400) {
             LOG_ERROR(WebService, "{} to {} returned error status code: {}", method, host + path,
                       response.status);
@@ -153,7 +215,9 @@ struct Client::Impl {
             return;
         }
 
-        auto result = GenericRequest("POST", "/jwt/internal", "", "text/html", "", username, token);
+        auto result =
+            GenericRequests({{"POST", "/jwt/internal", ""}}, "text/html", "", username, token)
+                .front();
         if (result.result_code != Common::WebResult::Code::Success) {
             LOG_ERROR(WebService, "UpdateJWT failed");
         } else {
@@ -179,6 +243,105 @@ struct Client::Impl {
     static inline JWTCache jwt_cache;
 };
 
+/**
+ * Sends requests whose results nobody waits for. A single detached task drains the queue, instead
+ * of a thread for every request, and sends the requests queued for the same host and credentials
+ * together over shared connections. Requests that got no response are retried with a backoff.
+ */
+class SubmissionQueue {
+public:
+    struct Request {
+        std::string host;
+        std::string username;
+        std::string token;
+        Client::Impl::RequestInfo info;
+        bool allow_anonymous;
+        u32 attempts = 0;
+    };
+
+    static SubmissionQueue& GetInstance() {
+        static SubmissionQueue instance;
+        return instance;
+    }
+
+    void Push(Request request) {
+        std::lock_guard lock{mutex};
+        if (pending.size() >= MAX_PENDING) {
+            LOG_ERROR(WebService, "Too many queued requests, dropping {} to {}",
+                      request.info.method, request.host + request.info.path);
+            return;
+        }
+        pending.push_back(std::move(request));
+        if (!draining) {
+            draining = true;
+            Common::DetachedTasks::AddTask([this] { Drain(); });
+        }
+    }
+
+private:
+    static constexpr std::size_t MAX_PENDING = 64;
+    static constexpr u32 MAX_ATTEMPTS = 3;
+    static constexpr std::chrono::milliseconds RETRY_DELAY{500};
+
+    void Drain() {
+        while (true) {
+            std::vector<Request> batch;
+            {
+                std::lock_guard lock{mutex};
+                if (pending.empty()) {
+                    draining = false;
+                    return;
+                }
+                batch.assign(std::make_move_iterator(pending.begin()),
+                             std::make_move_iterator(pending.end()));
+                pending.clear();
+            }
+
+            u32 max_attempts = 0;
+            std::vector<Request> retries;
+            while (!batch.empty()) {
+                const Request& first = batch.front();
+                const auto same_group = [&first](const Request& request) {
+                    return request.host == first.host && request.username == first.username &&
+                           request.token == first.token &&
+                           request.allow_anonymous == first.allow_anonymous;
+                };
+                const auto group_end =
+                    std::stable_partition(batch.begin(), batch.end(), same_group);
+
+                std::vector<Client::Impl::RequestInfo> infos;
+                for (auto it = batch.begin(); it != group_end; ++it) {
+                    infos.push_back(it->info);
+                }
+                Client::Impl impl{first.host, first.username, first.token};
+                const auto results =
+                    impl.GenericRequests(infos, first.allow_anonymous, "application/json");
+
+                for (std::size_t i = 0; i < results.size(); ++i) {
+                    Request& request = batch[i];
+                    if (results[i].result_code == Common::WebResult::Code::LibError &&
+                        ++request.attempts < MAX_ATTEMPTS) {
+                        max_attempts = std::max(max_attempts, request.attempts);
+                        retries.push_back(std::move(request));
+                    }
+                }
+                batch.erase(batch.begin(), group_end);
+            }
+
+            if (!retries.empty()) {
+                std::this_thread::sleep_for(RETRY_DELAY * max_attempts);
+                std::lock_guard lock{mutex};
+                pending.insert(pending.begin(), std::make_move_iterator(retries.begin()),
+                               std::make_move_iterator(retries.end()));
+            }
+        }
+    }
+
+    std::mutex mutex;
+    std::deque<Request> pending;
+    bool draining = false;
+};
+
 Client::Client(std::string host, std::string username, std::string token)
     : impl{std::make_unique<Impl>(std::move(host), std::move(username), std::move(token))} {}
 
@@ -198,6 +361,18 @@ Common::WebResult Client::DeleteJson(const std::string& path, const std::string&
     return impl->GenericRequest("DELETE", path, data, allow_anonymous, "application/json");
 }
 
+void Client::PostJsonAsync(const std::string& path, const std::string& data,
+                           bool allow_anonymous) {
+    SubmissionQueue::GetInstance().Push(
+        {impl->host, impl->username, impl->token, {"POST", path, data}, allow_anonymous});
+}
+
+void Client::DeleteJsonAsync(const std::string& path, const std::string& data,
+                             bool allow_anonymous) {
+    SubmissionQueue::GetInstance().Push(
+        {impl->host, impl->username, impl->token, {"DELETE", path, data}, allow_anonymous});
+}
+
 Common::WebResult Client::GetPlain(const std::string& path, bool allow_anonymous) {
     return impl->GenericRequest("GET", path, "", allow_anonymous, "text/plain");
 }
@@ -13,6 +13,8 @@ struct WebResult;
 
 namespace WebService {
 
+class SubmissionQueue;
+
 class Client {
 public:
     Client(std::string host, std::string username, std::string token);
@@ -46,6 +48,23 @@ public:
     Common::WebResult DeleteJson(const std::string& path, const std::string& data,
                                  bool allow_anonymous);
 
+    /**
+     * Posts JSON to the specified path in the background, the result is only logged.
+     * Requests queued together to the same host are sent over shared connections.
+     * @param path the URL segment after the host address.
+     * @param data String of JSON data to use for the body of the POST request.
+     * @param allow_anonymous If true, allow anonymous unauthenticated requests.
+     */
+    void PostJsonAsync(const std::string& path, const std::string& data, bool allow_anonymous);
+
+    /**
+     * Deletes JSON to the specified path in the background, the result is only logged.
+     * @param path the URL segment after the host address.
+     * @param data String of JSON data to use for the body of the DELETE request.
+     * @param allow_anonymous If true, allow anonymous unauthenticated requests.
+     */
+    void DeleteJsonAsync(const std::string& path, const std::string& data, bool allow_anonymous);
+
     /**
      * Gets a plain string from the specified path.
      * @param path the URL segment after the host address.
@@ -70,6 +89,8 @@ public:
     Common::WebResult GetExternalJWT(const std::string& audience);
 
 private:
+    friend class SubmissionQueue;
+
     struct Impl;
     std::unique_ptr<Impl> impl;
 };